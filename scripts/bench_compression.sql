@@ -0,0 +1,73 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Microbenchmark of the compression algorithms, see
+-- tsl/test/src/bench_compression.c. The benchmark functions are part of the
+-- test code, so this needs a Debug build of the extension; build it against a
+-- PostgreSQL without assertions and with optimizations, e.g. with
+-- -DCMAKE_C_FLAGS_DEBUG="-O2 -g", for meaningful numbers.
+--
+-- Run with: psql -X -f scripts/bench_compression.sql
+--
+-- The number of rows and the iterations can be set with
+-- psql -v ROWS=<rows> -v ITERATIONS=<iterations>.
+
+\if :{?ROWS}
+\else
+\set ROWS 1000000
+\endif
+\if :{?ITERATIONS}
+\else
+\set ITERATIONS 5
+\endif
+
+DROP DATABASE IF EXISTS bench_compression;
+CREATE DATABASE bench_compression;
+\c bench_compression
+SET client_min_messages TO error;
+CREATE EXTENSION timescaledb;
+RESET client_min_messages;
+
+SELECT format('$libdir/timescaledb-tsl-%s', extversion) AS "TSL_MODULE_PATHNAME"
+FROM pg_extension WHERE extname = 'timescaledb' \gset
+
+CREATE FUNCTION ts_bench_compression(algorithm_name TEXT, distribution_name TEXT,
+    num_rows INTEGER, iterations INTEGER, OUT algorithm TEXT, OUT distribution TEXT,
+    OUT rows INTEGER, OUT uncompressed_bytes BIGINT, OUT compressed_bytes BIGINT,
+    OUT ratio FLOAT8, OUT compress_mb_per_s FLOAT8, OUT decompress_mb_per_s FLOAT8)
+AS :'TSL_MODULE_PATHNAME' LANGUAGE C VOLATILE STRICT;
+CREATE FUNCTION ts_bench_compression_values(algorithm_name TEXT, "values" ANYARRAY,
+    iterations INTEGER, OUT algorithm TEXT, OUT distribution TEXT,
+    OUT rows INTEGER, OUT uncompressed_bytes BIGINT, OUT compressed_bytes BIGINT,
+    OUT ratio FLOAT8, OUT compress_mb_per_s FLOAT8, OUT decompress_mb_per_s FLOAT8)
+AS :'TSL_MODULE_PATHNAME' LANGUAGE C VOLATILE STRICT;
+
+-- Synthetic data. Each algorithm runs over the distributions of the types it
+-- supports.
+SELECT b.algorithm, b.distribution, b.rows, round(b.ratio::numeric, 2) AS ratio,
+    round(b.compress_mb_per_s::numeric, 1) AS compress_mb_per_s,
+    round(b.decompress_mb_per_s::numeric, 1) AS decompress_mb_per_s
+FROM (VALUES
+    ('deltadelta', 'constant'), ('deltadelta', 'sequential'), ('deltadelta', 'timestamps'),
+    ('deltadelta', 'small_range'), ('deltadelta', 'random'),
+    ('bitpack', 'constant'), ('bitpack', 'sequential'), ('bitpack', 'small_range'),
+    ('bitpack', 'random'),
+    ('simple8b', 'constant'), ('simple8b', 'sequential'), ('simple8b', 'timestamps'),
+    ('simple8b', 'small_range'), ('simple8b', 'random'),
+    ('gorilla', 'constant'), ('gorilla', 'small_range'), ('gorilla', 'sine'),
+    ('gorilla', 'random_float'),
+    ('dictionary', 'small_range'), ('dictionary', 'sine'), ('dictionary', 'low_cardinality'),
+    ('dictionary', 'unique_text'),
+    ('array', 'random'), ('array', 'random_float'), ('array', 'low_cardinality'),
+    ('array', 'unique_text')) v(a, d),
+    ts_bench_compression(v.a, v.d, :ROWS, :ITERATIONS) b;
+
+-- Recorded data: the benchmark of the values of a column in the order of the
+-- compression, e.g.
+--
+-- SELECT b.* FROM (VALUES ('deltadelta'), ('gorilla')) v(a),
+--     ts_bench_compression_values(v.a, (SELECT array_agg(value ORDER BY time) FROM metrics), 5) b;
+
+\c postgres
+DROP DATABASE bench_compression;
@@ -89,6 +89,21 @@ CREATE OR REPLACE FUNCTION _timescaledb_internal.unfreeze_chunk(
    chunk REGCLASS)
 RETURNS BOOL AS '@MODULE_PATHNAME@', 'ts_chunk_unfreeze_chunk' LANGUAGE C VOLATILE;
 
+-- merges two chunks that are adjacent along the time dimension into the
+-- earlier of the two chunks and returns it
+CREATE OR REPLACE FUNCTION _timescaledb_internal.merge_chunks(
+   chunk REGCLASS,
+   merge_chunk REGCLASS)
+RETURNS REGCLASS AS '@MODULE_PATHNAME@', 'ts_chunk_merge_chunks' LANGUAGE C VOLATILE;
+
+-- moves the rows of chunks that don't match the current space partitioning of
+-- the hypertable to chunks that do, at most max_time_slices time slices per
+-- call, and returns the number of rebalanced chunks
+CREATE OR REPLACE FUNCTION _timescaledb_internal.rebalance_chunks(
+   hypertable REGCLASS,
+   max_time_slices INTEGER = NULL)
+RETURNS INTEGER AS '@MODULE_PATHNAME@', 'ts_chunk_rebalance_chunks' LANGUAGE C VOLATILE;
+
 --wrapper for ts_chunk_drop
 --drops the chunk table and its entry in the chunk catalog
 CREATE OR REPLACE FUNCTION _timescaledb_internal.drop_chunk(
@@ -10,3 +10,9 @@ CREATE OR REPLACE FUNCTION _timescaledb_internal.remote_txn_heal_data_node(forei
 RETURNS INT
 AS '@MODULE_PATHNAME@', 'ts_remote_txn_heal_data_node'
 LANGUAGE C STRICT;
+
+-- Heal several data nodes in parallel
+CREATE OR REPLACE FUNCTION _timescaledb_internal.remote_txn_heal_data_nodes(foreign_server_oids oid[])
+RETURNS INT
+AS '@MODULE_PATHNAME@', 'ts_remote_txn_heal_data_nodes'
+LANGUAGE C STRICT;
@@ -225,3 +225,34 @@ CREATE OR REPLACE FUNCTION @extschema@.alter_data_node(
 	available              BOOLEAN = NULL
 ) RETURNS TABLE(node_name NAME, host TEXT, port INTEGER, database NAME, available BOOLEAN)
 AS '@MODULE_PATHNAME@', 'ts_data_node_alter' LANGUAGE C VOLATILE;
+
+-- Keep the newest row of every key of a hypertable in a table that
+-- last() queries grouped by the key read instead of the hypertable
+CREATE OR REPLACE FUNCTION @extschema@.enable_last_point_cache(
+    hypertable              REGCLASS,
+    key_column              NAME,
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_last_point_cache_enable' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION @extschema@.disable_last_point_cache(
+    hypertable              REGCLASS,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_last_point_cache_disable' LANGUAGE C VOLATILE;
+
+-- Track the range of a column in every chunk of a hypertable so that the
+-- planner can skip compressed chunks that cannot match a filter on it
+CREATE OR REPLACE FUNCTION @extschema@.enable_chunk_skipping(
+    hypertable              REGCLASS,
+    column_name             NAME,
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_chunk_column_stats_enable' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION @extschema@.disable_chunk_skipping(
+    hypertable              REGCLASS,
+    column_name             NAME,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_chunk_column_stats_disable' LANGUAGE C VOLATILE;
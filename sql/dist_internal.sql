@@ -25,5 +25,27 @@ RETURNS TABLE (
     transaction_status  text,
     transaction_depth   int,
     processing          boolean,
-    invalidated         boolean)
+    invalidated         boolean,
+    bytes_sent          bigint,
+    bytes_received      bigint,
+    round_trips         bigint,
+    wait_time           double precision)
 AS '@MODULE_PATHNAME@', 'ts_remote_connection_cache_show' LANGUAGE C VOLATILE STRICT;
+
+-- Aggregate used by the access node to fetch scan results from data nodes
+-- in columnar form. Compresses its input with the default compression
+-- algorithm for the input type.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.compressed_data_agg_transfn(internal, anyelement)
+RETURNS internal
+AS '@MODULE_PATHNAME@', 'ts_compressed_data_agg_transfn' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.compressed_data_agg_finalfn(internal)
+RETURNS _timescaledb_internal.compressed_data
+AS '@MODULE_PATHNAME@', 'ts_compressed_data_agg_finalfn' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE _timescaledb_internal.compressed_data_agg(anyelement) (
+    SFUNC = _timescaledb_internal.compressed_data_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = _timescaledb_internal.compressed_data_agg_finalfn,
+    FINALFUNC_MODIFY = READ_WRITE
+);
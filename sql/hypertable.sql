@@ -13,3 +13,27 @@ AS '@MODULE_PATHNAME@', 'ts_continuous_agg_invalidation_trigger' LANGUAGE C;
 CREATE OR REPLACE FUNCTION @extschema@.set_integer_now_func(hypertable REGCLASS, integer_now_func REGPROC, replace_if_exists BOOL = false) RETURNS VOID
 AS '@MODULE_PATHNAME@', 'ts_hypertable_set_integer_now_func'
 LANGUAGE C VOLATILE STRICT;
+
+-- The ingest statistics of the hypertables in the current database, collected
+-- when timescaledb.ingest_stats_max_hypertables is set
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hypertable_ingest_stats()
+RETURNS TABLE(hypertable_id INTEGER, statements BIGINT, rows BIGINT, insert_time_us BIGINT,
+  insert_state_hits BIGINT, insert_state_misses BIGINT, insert_state_evictions BIGINT,
+  chunk_cache_hits BIGINT, chunk_cache_misses BIGINT, chunks_created BIGINT,
+  chunk_create_time_us BIGINT, copy_flushes_tuples BIGINT, copy_flushes_bytes BIGINT,
+  copy_flushes_buffer_full BIGINT, copy_flushes_buffers BIGINT, copy_flushes_triggers BIGINT,
+  copy_flushes_end BIGINT)
+AS '@MODULE_PATHNAME@', 'ts_hypertable_ingest_stats' LANGUAGE C VOLATILE STRICT;
+
+-- The timings of the planning phases of the last planned query that expanded
+-- a hypertable, collected when timescaledb.enable_planner_timing is set
+CREATE OR REPLACE FUNCTION _timescaledb_internal.planner_timing()
+RETURNS TABLE(phase TEXT, calls BIGINT, chunks BIGINT, total_time FLOAT8)
+AS '@MODULE_PATHNAME@', 'ts_planner_timing' LANGUAGE C VOLATILE STRICT;
+
+-- The number of entries, memory and hit rates of the hypertable cache and the
+-- chunk caches of the cached hypertables in the current backend
+CREATE OR REPLACE FUNCTION _timescaledb_internal.cache_info()
+RETURNS TABLE(cache_name TEXT, entries BIGINT, memory_bytes BIGINT, hits BIGINT, misses BIGINT,
+  evictions BIGINT)
+AS '@MODULE_PATHNAME@', 'ts_hypertable_cache_info' LANGUAGE C VOLATILE STRICT;
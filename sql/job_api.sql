@@ -34,6 +34,16 @@ next_start TIMESTAMPTZ, check_config TEXT)
 AS '@MODULE_PATHNAME@', 'ts_job_alter'
 LANGUAGE C VOLATILE;
 
+-- Put the job in a concurrency class, or take it out of its class if
+-- concurrency_class is NULL. The scheduler starts at most max_concurrency
+-- jobs of a class at a time.
+CREATE OR REPLACE FUNCTION @extschema@.set_job_concurrency_class(
+    job_id INTEGER,
+    concurrency_class NAME,
+    max_concurrency INTEGER = 1
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'ts_job_set_concurrency_class'
+LANGUAGE C VOLATILE;
+
 CREATE OR REPLACE FUNCTION _timescaledb_internal.alter_job_set_hypertable_id(
     job_id INTEGER,
     hypertable REGCLASS )
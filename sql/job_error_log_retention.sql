@@ -2,7 +2,8 @@
 -- Please see the included NOTICE for copyright information and
 -- LICENSE-APACHE for a copy of the license.
 
--- A retention policy is set up for the table _timescaledb_internal.job_errors (Error Log Retention Policy [2])
+-- A retention policy is set up for the tables _timescaledb_internal.job_errors and
+-- _timescaledb_internal.job_history (Error Log Retention Policy [2])
 -- By default, it will run once a month and and drop rows older than a month.
 CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_job_error_retention(job_id integer, config JSONB) RETURNS integer
 LANGUAGE PLPGSQL AS
@@ -18,6 +19,8 @@ BEGIN
         WHERE finish_time < (now() - drop_after) RETURNING *)
         SELECT count(*)
         FROM deleted INTO numrows;
+    DELETE FROM _timescaledb_internal.job_history
+    WHERE finish_time < (now() - drop_after);
     RETURN numrows;
 END;
 $BODY$ SET search_path TO pg_catalog, pg_temp;
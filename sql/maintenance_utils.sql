@@ -42,6 +42,21 @@ CREATE OR REPLACE FUNCTION @extschema@.decompress_chunk(
     if_compressed BOOLEAN = false
 ) RETURNS REGCLASS AS '@MODULE_PATHNAME@', 'ts_decompress_chunk' LANGUAGE C STRICT VOLATILE;
 
+-- Recompress a partially compressed chunk by decompressing and compressing
+-- again only the segments that have new rows in the uncompressed chunk.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.recompress_chunk_segmentwise(
+    uncompressed_chunk REGCLASS,
+    if_not_compressed BOOLEAN = false
+) RETURNS REGCLASS AS '@MODULE_PATHNAME@', 'ts_recompress_chunk_segmentwise' LANGUAGE C STRICT VOLATILE;
+
+-- Check if the bloom filter of a compressed batch can contain the value.
+-- Used by the filters on the timescaledb.compress_bloom columns that are
+-- pushed down to the compressed chunks.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.bloom1_contains(
+    bloom BYTEA,
+    value ANYELEMENT
+) RETURNS BOOLEAN AS '@MODULE_PATHNAME@', 'ts_bloom1_contains' LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 -- Recompress a chunk
 --
 -- Will give an error if the chunk was not already compressed. In this
@@ -85,6 +100,9 @@ BEGIN
         ELSE
             RAISE EXCEPTION 'nothing to recompress in chunk "%"', chunk_name[array_upper(chunk_name,1)];
         END IF;
+    WHEN status = 9 AND current_setting('timescaledb.enable_segmentwise_recompression')::boolean THEN
+        PERFORM _timescaledb_internal.recompress_chunk_segmentwise(chunk, if_not_compressed);
+        RETURN;
     WHEN status = 3 OR status = 9 OR status = 11 THEN
         PERFORM @extschema@.decompress_chunk(chunk);
         COMMIT;
@@ -14,3 +14,11 @@ CREATE OR REPLACE FUNCTION _timescaledb_internal.get_partition_hash(val anyeleme
 CREATE OR REPLACE FUNCTION _timescaledb_internal.get_time_type(hypertable_id INTEGER)
     RETURNS OID
     AS '@MODULE_PATHNAME@', 'ts_hypertable_get_time_type' LANGUAGE C STABLE STRICT;
+
+-- maps equally sized virtual partitions of the hash values onto the
+-- partitions of the first space dimension by the sizes of the partitions in
+-- the latest time slice and returns the number of observed rows
+CREATE OR REPLACE FUNCTION _timescaledb_internal.balance_dimension_partitions(
+    hypertable REGCLASS,
+    virtual_partitions INTEGER = 1024
+) RETURNS BIGINT AS '@MODULE_PATHNAME@', 'ts_dimension_partition_balance' LANGUAGE C VOLATILE;
@@ -43,6 +43,68 @@ CREATE OR REPLACE FUNCTION @extschema@.remove_reorder_policy(hypertable REGCLASS
 AS '@MODULE_PATHNAME@', 'ts_policy_reorder_remove'
 LANGUAGE C VOLATILE STRICT;
 
+/* chunk precreation policy */
+CREATE OR REPLACE FUNCTION @extschema@.add_chunk_precreation_policy(
+    hypertable REGCLASS,
+    chunks_ahead INTEGER = 1,
+    if_not_exists BOOL = false,
+    schedule_interval INTERVAL = NULL,
+    initial_start TIMESTAMPTZ = NULL,
+    timezone TEXT = NULL
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'ts_policy_chunk_precreation_add'
+LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION @extschema@.remove_chunk_precreation_policy(hypertable REGCLASS, if_exists BOOL = false) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_policy_chunk_precreation_remove'
+LANGUAGE C VOLATILE STRICT;
+
+/* distributed statistics policy */
+CREATE OR REPLACE FUNCTION @extschema@.add_distributed_stats_policy(
+    hypertable REGCLASS,
+    if_not_exists BOOL = false,
+    schedule_interval INTERVAL = NULL,
+    initial_start TIMESTAMPTZ = NULL,
+    timezone TEXT = NULL
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'ts_policy_distributed_stats_add'
+LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION @extschema@.remove_distributed_stats_policy(hypertable REGCLASS, if_exists BOOL = false) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_policy_distributed_stats_remove'
+LANGUAGE C VOLATILE STRICT;
+
+/* vacuum policy */
+CREATE OR REPLACE FUNCTION @extschema@.add_vacuum_policy(
+    hypertable REGCLASS,
+    max_chunks INTEGER = 10,
+    if_not_exists BOOL = false,
+    schedule_interval INTERVAL = NULL,
+    initial_start TIMESTAMPTZ = NULL,
+    timezone TEXT = NULL
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'ts_policy_vacuum_add'
+LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION @extschema@.remove_vacuum_policy(hypertable REGCLASS, if_exists BOOL = false) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_policy_vacuum_remove'
+LANGUAGE C VOLATILE STRICT;
+
+/* invalidation log compaction policy */
+CREATE OR REPLACE FUNCTION @extschema@.add_invalidation_log_compaction_policy(
+    hypertable REGCLASS,
+    if_not_exists BOOL = false,
+    schedule_interval INTERVAL = NULL,
+    initial_start TIMESTAMPTZ = NULL,
+    timezone TEXT = NULL
+) RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'ts_policy_invalidation_log_compaction_add'
+LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION @extschema@.remove_invalidation_log_compaction_policy(hypertable REGCLASS, if_exists BOOL = false) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_policy_invalidation_log_compaction_remove'
+LANGUAGE C VOLATILE STRICT;
+
 /* compression policy */
 CREATE OR REPLACE FUNCTION @extschema@.add_compression_policy(
     hypertable REGCLASS, compress_after "any",
@@ -59,6 +121,22 @@ CREATE OR REPLACE FUNCTION @extschema@.remove_compression_policy(hypertable REGC
 AS '@MODULE_PATHNAME@', 'ts_policy_compression_remove'
 LANGUAGE C VOLATILE STRICT;
 
+/* compression batch policy */
+CREATE OR REPLACE FUNCTION @extschema@.add_compression_batch_policy(
+    time_budget INTERVAL,
+    schedule_interval INTERVAL = NULL,
+    if_not_exists BOOL = false,
+    initial_start TIMESTAMPTZ = NULL,
+    timezone TEXT = NULL
+)
+RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'ts_policy_compression_batch_add'
+LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION @extschema@.remove_compression_batch_policy(if_exists BOOL = false) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_policy_compression_batch_remove'
+LANGUAGE C VOLATILE STRICT;
+
 /* continuous aggregates policy */
 CREATE OR REPLACE FUNCTION @extschema@.add_continuous_aggregate_policy(
     continuous_aggregate REGCLASS, start_offset "any",
@@ -18,6 +18,38 @@ CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_reorder_check(config JSO
 RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_reorder_check'
 LANGUAGE C;
 
+CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_chunk_precreation(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_chunk_precreation_proc'
+LANGUAGE C;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_chunk_precreation_check(config JSONB)
+RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_chunk_precreation_check'
+LANGUAGE C;
+
+CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_distributed_stats(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_distributed_stats_proc'
+LANGUAGE C;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_distributed_stats_check(config JSONB)
+RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_distributed_stats_check'
+LANGUAGE C;
+
+CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_vacuum(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_vacuum_proc'
+LANGUAGE C;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_vacuum_check(config JSONB)
+RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_vacuum_check'
+LANGUAGE C;
+
+CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_invalidation_log_compaction(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_invalidation_log_compaction_proc'
+LANGUAGE C;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_invalidation_log_compaction_check(config JSONB)
+RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_invalidation_log_compaction_check'
+LANGUAGE C;
+
 CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_recompression(job_id INTEGER, config JSONB)
 AS '@MODULE_PATHNAME@', 'ts_policy_recompression_proc'
 LANGUAGE C;
@@ -34,6 +66,65 @@ CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_refresh_continuous_aggre
 RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_refresh_cagg_check'
 LANGUAGE C;
 
+CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_refresh_continuous_aggregate_window(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_refresh_cagg_window_proc'
+LANGUAGE C;
+
+-- Compress a chunk that a compression policy found eligible, or recompress
+-- it if it is partially compressed or unordered and recompression is enabled.
+-- Failures are reported as warnings so that the policy moves on to the next
+-- chunk.
+CREATE OR REPLACE FUNCTION
+_timescaledb_internal.policy_compression_process_chunk(
+  chunk_oid           REGCLASS,
+  chunk_status        INTEGER,
+  recompress_enabled  BOOLEAN)
+RETURNS VOID
+AS $$
+DECLARE
+  _message     text;
+  _detail      text;
+  -- chunk status bits:
+  bit_compressed int := 1;
+  bit_compressed_unordered int := 2;
+  bit_compressed_partial int := 8;
+BEGIN
+  IF chunk_status = 0 THEN
+    BEGIN
+      PERFORM @extschema@.compress_chunk( chunk_oid );
+    EXCEPTION WHEN OTHERS THEN
+      GET STACKED DIAGNOSTICS
+          _message = MESSAGE_TEXT,
+          _detail = PG_EXCEPTION_DETAIL;
+      RAISE WARNING 'compressing chunk "%" failed when compression policy is executed', chunk_oid::regclass::text
+          USING DETAIL = format('Message: (%s), Detail: (%s).', _message, _detail),
+                ERRCODE = sqlstate;
+    END;
+  ELSIF
+    (
+      chunk_status & bit_compressed > 0 AND (
+        chunk_status & bit_compressed_unordered > 0 OR
+        chunk_status & bit_compressed_partial > 0
+      )
+    ) AND recompress_enabled IS TRUE THEN
+    BEGIN
+      PERFORM @extschema@.decompress_chunk(chunk_oid, if_compressed => true);
+    EXCEPTION WHEN OTHERS THEN
+      RAISE WARNING 'decompressing chunk "%" failed when compression policy is executed', chunk_oid::regclass::text
+          USING DETAIL = format('Message: (%s), Detail: (%s).', _message, _detail),
+                ERRCODE = sqlstate;
+    END;
+    BEGIN
+      PERFORM @extschema@.compress_chunk(chunk_oid);
+    EXCEPTION WHEN OTHERS THEN
+      RAISE WARNING 'compressing chunk "%" failed when compression policy is executed', chunk_oid::regclass::text
+          USING DETAIL = format('Message: (%s), Detail: (%s).', _message, _detail),
+                ERRCODE = sqlstate;
+    END;
+  END IF;
+END;
+$$ LANGUAGE PLPGSQL SET search_path TO pg_catalog, pg_temp;
+
 CREATE OR REPLACE PROCEDURE
 _timescaledb_internal.policy_compression_execute(
   job_id              INTEGER,
@@ -47,8 +138,6 @@ DECLARE
   htoid       REGCLASS;
   chunk_rec   RECORD;
   numchunks   INTEGER := 1;
-  _message     text;
-  _detail      text;
   -- chunk status bits:
   bit_compressed int := 1;
   bit_compressed_unordered int := 2;
@@ -90,43 +179,9 @@ BEGIN
         )
       )
   LOOP
-    IF chunk_rec.status = 0 THEN
-      BEGIN
-        PERFORM @extschema@.compress_chunk( chunk_rec.oid );
-      EXCEPTION WHEN OTHERS THEN
-        GET STACKED DIAGNOSTICS
-            _message = MESSAGE_TEXT,
-            _detail = PG_EXCEPTION_DETAIL;
-        RAISE WARNING 'compressing chunk "%" failed when compression policy is executed', chunk_rec.oid::regclass::text
-            USING DETAIL = format('Message: (%s), Detail: (%s).', _message, _detail),
-                  ERRCODE = sqlstate;
-      END;
-    ELSIF
-      (
-        chunk_rec.status & bit_compressed > 0 AND (
-          chunk_rec.status & bit_compressed_unordered > 0 OR
-          chunk_rec.status & bit_compressed_partial > 0
-        )
-      ) AND recompress_enabled IS TRUE THEN
-      BEGIN
-        PERFORM @extschema@.decompress_chunk(chunk_rec.oid, if_compressed => true);
-      EXCEPTION WHEN OTHERS THEN
-        RAISE WARNING 'decompressing chunk "%" failed when compression policy is executed', chunk_rec.oid::regclass::text
-            USING DETAIL = format('Message: (%s), Detail: (%s).', _message, _detail),
-                  ERRCODE = sqlstate;
-      END;
-      -- SET LOCAL is only active until end of transaction.
-      -- While we could use SET at the start of the function we do not
-      -- want to bleed out search_path to caller, so we do SET LOCAL
-      -- again after COMMIT
-      BEGIN
-        PERFORM @extschema@.compress_chunk(chunk_rec.oid);
-      EXCEPTION WHEN OTHERS THEN
-        RAISE WARNING 'compressing chunk "%" failed when compression policy is executed', chunk_rec.oid::regclass::text
-            USING DETAIL = format('Message: (%s), Detail: (%s).', _message, _detail),
-                  ERRCODE = sqlstate;
-      END;
-    END IF;
+    PERFORM _timescaledb_internal.policy_compression_process_chunk(
+      chunk_rec.oid, chunk_rec.status, recompress_enabled
+    );
     COMMIT;
     -- SET LOCAL is only active until end of transaction.
     -- While we could use SET at the start of the function we do not
@@ -141,6 +196,10 @@ BEGIN
          EXIT;
     END IF;
   END LOOP;
+
+  -- the compressed chunks are up to date, so this only walks the chunks that
+  -- can still change
+  PERFORM _timescaledb_internal.refresh_chunk_size_stats(htoid);
 END;
 $$ LANGUAGE PLPGSQL;
 
@@ -183,6 +242,14 @@ BEGIN
     RAISE EXCEPTION 'job % config must have compress_after', job_id;
   END IF;
 
+  -- the chunks of a batched policy are compressed by the compression batch policy
+  IF COALESCE(jsonb_object_field_text(config, 'batched')::BOOLEAN, FALSE) THEN
+    IF verbose_log THEN
+      RAISE LOG 'job % skipped, the compression batch policy compresses its chunks', job_id;
+    END IF;
+    RETURN;
+  END IF;
+
   -- find primary dimension type --
   SELECT dim.column_type INTO dimtype
   FROM  _timescaledb_catalog.hypertable ht
@@ -218,3 +285,143 @@ BEGIN
   END CASE;
 END;
 $$ LANGUAGE PLPGSQL;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.policy_compression_batch_check(config JSONB)
+RETURNS void AS '@MODULE_PATHNAME@', 'ts_policy_compression_batch_check'
+LANGUAGE C;
+
+-- Return the chunks that the compression policy with the given config would
+-- compress or recompress, limited to maxchunks_to_compress of the policy
+CREATE OR REPLACE FUNCTION
+_timescaledb_internal.policy_compression_batch_candidates(config JSONB)
+RETURNS TABLE (chunk_id INTEGER, chunk_oid REGCLASS, chunk_status INTEGER)
+AS $$
+DECLARE
+  htid                INTEGER;
+  htoid               REGCLASS;
+  dimtype             REGTYPE;
+  compress_after      TEXT;
+  maxchunks           INTEGER;
+  recompress_enabled  BOOL;
+  chunk_oids          REGCLASS[];
+  -- chunk status bits:
+  bit_compressed int := 1;
+  bit_compressed_unordered int := 2;
+  bit_compressed_partial int := 8;
+BEGIN
+  htid                := jsonb_object_field_text(config, 'hypertable_id')::INTEGER;
+  compress_after      := jsonb_object_field_text(config, 'compress_after');
+  maxchunks           := COALESCE(jsonb_object_field_text(config, 'maxchunks_to_compress')::INTEGER, 0);
+  recompress_enabled  := COALESCE(jsonb_object_field_text(config, 'recompress')::BOOLEAN, TRUE);
+
+  SELECT format('%I.%I', ht.schema_name, ht.table_name), dim.column_type INTO htoid, dimtype
+  FROM _timescaledb_catalog.hypertable ht
+       JOIN _timescaledb_catalog.dimension dim ON ht.id = dim.hypertable_id
+  WHERE ht.id = htid
+  ORDER BY dim.id
+  LIMIT 1;
+
+  IF htoid IS NULL OR compress_after IS NULL THEN
+    RETURN;
+  END IF;
+
+  CASE dimtype
+    WHEN 'TIMESTAMP'::regtype, 'TIMESTAMPTZ'::regtype, 'DATE'::regtype THEN
+      chunk_oids := ARRAY(SELECT @extschema@.show_chunks(htoid, older_than => compress_after::INTERVAL));
+    WHEN 'BIGINT'::regtype THEN
+      chunk_oids := ARRAY(SELECT @extschema@.show_chunks(htoid,
+        older_than => _timescaledb_internal.subtract_integer_from_now(htoid, compress_after::BIGINT)));
+    WHEN 'INTEGER'::regtype THEN
+      chunk_oids := ARRAY(SELECT @extschema@.show_chunks(htoid,
+        older_than => _timescaledb_internal.subtract_integer_from_now(htoid, compress_after::BIGINT)::INTEGER));
+    WHEN 'SMALLINT'::regtype THEN
+      chunk_oids := ARRAY(SELECT @extschema@.show_chunks(htoid,
+        older_than => _timescaledb_internal.subtract_integer_from_now(htoid, compress_after::BIGINT)::SMALLINT));
+  END CASE;
+
+  RETURN QUERY
+    SELECT ch.id, show.oid, ch.status
+    FROM
+      unnest(chunk_oids) AS show(oid)
+      INNER JOIN pg_class pgc ON pgc.oid = show.oid
+      INNER JOIN pg_namespace pgns ON pgc.relnamespace = pgns.oid
+      INNER JOIN _timescaledb_catalog.chunk ch ON ch.table_name = pgc.relname AND ch.schema_name = pgns.nspname AND ch.hypertable_id = htid
+    WHERE
+      ch.dropped IS FALSE
+      AND (
+        ch.status = 0 OR
+        (
+          recompress_enabled AND
+          ch.status & bit_compressed > 0 AND (
+            ch.status & bit_compressed_unordered > 0 OR
+            ch.status & bit_compressed_partial > 0
+          )
+        )
+      )
+    ORDER BY ch.id
+    LIMIT CASE WHEN maxchunks > 0 THEN maxchunks END;
+END;
+$$ LANGUAGE PLPGSQL SET search_path TO pg_catalog, pg_temp;
+
+-- Compress the chunks of all batched compression policies in one job run.
+-- The chunks are processed oldest first, by chunk id, across hypertables,
+-- and no chunk is started once the time budget of the run is used up.
+CREATE OR REPLACE PROCEDURE
+_timescaledb_internal.policy_compression_batch(job_id INTEGER, config JSONB)
+AS $$
+DECLARE
+  time_budget   INTERVAL;
+  deadline      TIMESTAMPTZ;
+  verbose_log   BOOL;
+  chunk_rec     RECORD;
+  numchunks     INTEGER := 0;
+BEGIN
+
+  -- procedures with SET clause cannot execute transaction
+  -- control so we adjust search_path in procedure body
+  SET LOCAL search_path TO pg_catalog, pg_temp;
+
+  IF config IS NULL THEN
+    RAISE EXCEPTION 'job % has null config', job_id;
+  END IF;
+
+  time_budget := jsonb_object_field_text(config, 'time_budget')::INTERVAL;
+  IF time_budget IS NULL THEN
+    RAISE EXCEPTION 'job % config must have time_budget', job_id;
+  END IF;
+
+  verbose_log := COALESCE(jsonb_object_field_text(config, 'verbose_log')::BOOLEAN, FALSE);
+  deadline := clock_timestamp() + time_budget;
+
+  FOR chunk_rec IN
+    SELECT
+      j.id AS policy_job_id, c.chunk_oid, c.chunk_status,
+      COALESCE(jsonb_object_field_text(j.config, 'recompress')::BOOLEAN, TRUE) AS recompress_enabled
+    FROM
+      _timescaledb_config.bgw_job j,
+      LATERAL _timescaledb_internal.policy_compression_batch_candidates(j.config) c
+    WHERE
+      j.proc_schema = '_timescaledb_internal'
+      AND j.proc_name = 'policy_compression'
+      AND COALESCE(jsonb_object_field_text(j.config, 'batched')::BOOLEAN, FALSE)
+    ORDER BY c.chunk_id
+  LOOP
+    EXIT WHEN clock_timestamp() >= deadline;
+
+    PERFORM _timescaledb_internal.policy_compression_process_chunk(
+      chunk_rec.chunk_oid, chunk_rec.chunk_status, chunk_rec.recompress_enabled
+    );
+    COMMIT;
+    -- SET LOCAL is only active until end of transaction.
+    SET LOCAL search_path TO pg_catalog, pg_temp;
+    IF verbose_log THEN
+       RAISE LOG 'job % completed processing chunk % for job %', job_id, chunk_rec.chunk_oid, chunk_rec.policy_job_id;
+    END IF;
+    numchunks := numchunks + 1;
+  END LOOP;
+
+  IF verbose_log THEN
+    RAISE LOG 'job % processed % chunks', job_id, numchunks;
+  END IF;
+END;
+$$ LANGUAGE PLPGSQL;
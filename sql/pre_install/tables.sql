@@ -429,6 +429,33 @@ SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_aggs
 
 CREATE INDEX continuous_aggs_materialization_invalidation_log_idx ON _timescaledb_catalog.continuous_aggs_materialization_invalidation_log (materialization_id, lowest_modified_value ASC);
 
+-- per cagg invalidations restricted to a range of the space partitions of the
+-- raw hypertable, see tsl/src/continuous_aggs/invalidation.c
+CREATE TABLE _timescaledb_catalog.continuous_aggs_partition_invalidation_log (
+  materialization_id integer,
+  lowest_modified_value bigint NOT NULL,
+  greatest_modified_value bigint NOT NULL,
+  partition_range_start bigint NOT NULL,
+  partition_range_end bigint NOT NULL,
+  -- table constraints
+  CONSTRAINT continuous_aggs_partition_invalidation_log_materialization_id_fkey FOREIGN KEY (materialization_id) REFERENCES _timescaledb_catalog.continuous_agg (mat_hypertable_id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_aggs_partition_invalidation_log', '');
+
+CREATE INDEX continuous_aggs_partition_invalidation_log_idx ON _timescaledb_catalog.continuous_aggs_partition_invalidation_log (materialization_id, lowest_modified_value ASC);
+
+-- end of the materialized data of a cagg, updated on every refresh
+CREATE TABLE _timescaledb_catalog.continuous_aggs_watermark (
+  mat_hypertable_id integer NOT NULL,
+  watermark bigint NOT NULL,
+  -- table constraints
+  CONSTRAINT continuous_aggs_watermark_pkey PRIMARY KEY (mat_hypertable_id),
+  CONSTRAINT continuous_aggs_watermark_mat_hypertable_id_fkey FOREIGN KEY (mat_hypertable_id) REFERENCES _timescaledb_catalog.continuous_agg (mat_hypertable_id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_aggs_watermark', '');
+
 
 /* the source of this data is the enum from the source code that lists
  *  the algorithms. This table is NOT dumped.
@@ -479,6 +506,43 @@ CREATE TABLE _timescaledb_catalog.compression_chunk_size (
 
 SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.compression_chunk_size', '');
 
+-- Per-chunk ranges of the columns tracked with enable_chunk_skipping(). The row
+-- with chunk_id 0 marks the column as tracked on the hypertable. The range
+-- values are stored in the binary send format of the column type.
+CREATE TABLE _timescaledb_catalog.chunk_column_stats (
+  hypertable_id integer NOT NULL,
+  chunk_id integer NOT NULL,
+  column_name name NOT NULL,
+  range_start bytea,
+  range_end bytea,
+  has_nulls boolean NOT NULL DEFAULT FALSE,
+  -- table constraints
+  CONSTRAINT chunk_column_stats_pkey PRIMARY KEY (hypertable_id, chunk_id, column_name),
+  CONSTRAINT chunk_column_stats_hypertable_id_fkey FOREIGN KEY (hypertable_id) REFERENCES _timescaledb_catalog.hypertable (id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_column_stats', '');
+
+-- Per-chunk sizes of the chunk relations and of their compressed chunks, used
+-- by the approximate size functions. See src/ts_catalog/chunk_size_stats.c.
+CREATE TABLE _timescaledb_catalog.chunk_size_stats (
+  hypertable_id integer NOT NULL,
+  chunk_id integer NOT NULL,
+  heap_bytes bigint NOT NULL,
+  index_bytes bigint NOT NULL,
+  toast_bytes bigint NOT NULL,
+  compressed_heap_bytes bigint NOT NULL,
+  compressed_index_bytes bigint NOT NULL,
+  compressed_toast_bytes bigint NOT NULL,
+  last_updated timestamptz NOT NULL,
+  -- table constraints
+  CONSTRAINT chunk_size_stats_pkey PRIMARY KEY (hypertable_id, chunk_id),
+  CONSTRAINT chunk_size_stats_hypertable_id_fkey FOREIGN KEY (hypertable_id) REFERENCES _timescaledb_catalog.hypertable (id) ON DELETE CASCADE,
+  CONSTRAINT chunk_size_stats_chunk_id_fkey FOREIGN KEY (chunk_id) REFERENCES _timescaledb_catalog.chunk (id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_size_stats', '');
+
 --This stores commit decisions for 2pc remote txns. Abort decisions are never stored.
 --If a PREPARE TRANSACTION fails for any data node then the entire
 --frontend transaction will be rolled back and no rows will be stored.
@@ -570,6 +634,24 @@ CREATE TABLE _timescaledb_internal.job_errors (
 );
 
 SELECT pg_catalog.pg_extension_config_dump('_timescaledb_internal.job_errors', '');
+
+-- The resource usage of every successful job run, removed by the job
+-- error log retention policy
+CREATE TABLE _timescaledb_internal.job_history (
+  job_id integer not null,
+  pid integer,
+  start_time timestamptz,
+  finish_time timestamptz,
+  rows_processed bigint,
+  chunks_processed bigint,
+  bytes_read bigint,
+  bytes_written bigint,
+  wal_bytes bigint,
+  user_cpu_time interval,
+  system_cpu_time interval
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_internal.job_history', '');
 -- Set table permissions
 -- We need to grant SELECT to PUBLIC for all tables even those not
 -- marked as being dumped because pg_dump will try to access all
@@ -225,6 +225,84 @@ $BODY$
    FROM @extschema@.hypertable_detailed_size(hypertable);
 $BODY$ SET search_path TO pg_catalog, pg_temp;
 
+-- Refresh the size stats of the chunks that could have changed since they
+-- were stored, see src/ts_catalog/chunk_size_stats.c
+--
+-- hypertable - hypertable to refresh the chunk size stats of
+--
+-- Returns:
+-- The number of chunks whose stats were updated
+CREATE OR REPLACE FUNCTION _timescaledb_internal.refresh_chunk_size_stats(
+    hypertable              REGCLASS)
+RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'ts_chunk_size_stats_refresh_hypertable' LANGUAGE C VOLATILE STRICT;
+
+-- Get the approximate relation size of hypertable from the chunk size stats
+-- in the catalog, without accessing the chunks. The stats are updated when
+-- chunks are compressed and by the compression policy, or with
+-- _timescaledb_internal.refresh_chunk_size_stats(). Chunks without stats are
+-- not counted.
+--
+-- hypertable - hypertable to get size of
+--
+-- Returns:
+-- table_bytes        - Disk space used by hypertable (like pg_relation_size(hypertable))
+-- index_bytes        - Disk space used by indexes
+-- toast_bytes        - Disk space of toast tables
+-- total_bytes        - Total disk space used by the specified table, including all indexes and TOAST data
+CREATE OR REPLACE FUNCTION @extschema@.hypertable_approximate_detailed_size(
+    hypertable              REGCLASS)
+RETURNS TABLE (table_bytes BIGINT,
+               index_bytes BIGINT,
+               toast_bytes BIGINT,
+               total_bytes BIGINT)
+LANGUAGE SQL VOLATILE STRICT AS
+$BODY$
+    WITH _hypertable AS (
+        SELECT ht.id
+        FROM pg_class c
+        INNER JOIN pg_namespace n ON (n.OID = c.relnamespace)
+        INNER JOIN _timescaledb_catalog.hypertable ht ON (ht.schema_name = n.nspname AND ht.table_name = c.relname)
+        WHERE c.OID = hypertable
+    ),
+    _sizes AS (
+        /* the root table is empty but has its own indexes */
+        SELECT
+            relsize.heap_size AS heap_bytes,
+            relsize.index_size AS index_bytes,
+            relsize.toast_size AS toast_bytes
+        FROM
+            _hypertable
+            JOIN LATERAL _timescaledb_internal.relation_size(hypertable) AS relsize ON TRUE
+        UNION ALL
+        SELECT
+            s.heap_bytes + s.compressed_heap_bytes,
+            s.index_bytes + s.compressed_index_bytes,
+            s.toast_bytes + s.compressed_toast_bytes
+        FROM
+            _hypertable
+            JOIN _timescaledb_catalog.chunk_size_stats s ON s.hypertable_id = _hypertable.id
+            JOIN _timescaledb_catalog.chunk c ON c.id = s.chunk_id AND c.dropped IS FALSE
+    )
+    SELECT
+        sum(heap_bytes)::bigint,
+        sum(index_bytes)::bigint,
+        sum(toast_bytes)::bigint,
+        sum(heap_bytes + index_bytes + toast_bytes)::bigint
+    FROM _sizes
+    HAVING count(*) > 0;
+$BODY$ SET search_path TO pg_catalog, pg_temp;
+
+--- returns approximate total-bytes for a hypertable (includes table + index)
+CREATE OR REPLACE FUNCTION @extschema@.hypertable_approximate_size(
+    hypertable              REGCLASS)
+RETURNS BIGINT
+LANGUAGE SQL VOLATILE STRICT AS
+$BODY$
+   SELECT total_bytes
+   FROM @extschema@.hypertable_approximate_detailed_size(hypertable);
+$BODY$ SET search_path TO pg_catalog, pg_temp;
+
 CREATE OR REPLACE FUNCTION _timescaledb_internal.chunks_local_size(
     schema_name_in name,
     table_name_in name)
@@ -0,0 +1,88 @@
+INSERT INTO _timescaledb_catalog.compression_algorithm( id, version, name, description) VALUES
+( 5, 1, 'COMPRESSION_ALGORITHM_BITPACK', 'bitpack'),
+( 6, 1, 'COMPRESSION_ALGORITHM_UUID', 'uuid'),
+( 7, 1, 'COMPRESSION_ALGORITHM_JSONB', 'jsonb');
+
+CREATE TABLE _timescaledb_catalog.chunk_column_stats (
+  hypertable_id integer NOT NULL,
+  chunk_id integer NOT NULL,
+  column_name name NOT NULL,
+  range_start bytea,
+  range_end bytea,
+  has_nulls boolean NOT NULL DEFAULT FALSE,
+  -- table constraints
+  CONSTRAINT chunk_column_stats_pkey PRIMARY KEY (hypertable_id, chunk_id, column_name),
+  CONSTRAINT chunk_column_stats_hypertable_id_fkey FOREIGN KEY (hypertable_id) REFERENCES _timescaledb_catalog.hypertable (id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_column_stats', '');
+
+GRANT SELECT ON _timescaledb_catalog.chunk_column_stats TO PUBLIC;
+
+CREATE TABLE _timescaledb_internal.job_history (
+  job_id integer not null,
+  pid integer,
+  start_time timestamptz,
+  finish_time timestamptz,
+  rows_processed bigint,
+  chunks_processed bigint,
+  bytes_read bigint,
+  bytes_written bigint,
+  wal_bytes bigint,
+  user_cpu_time interval,
+  system_cpu_time interval
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_internal.job_history', '');
+
+GRANT SELECT ON _timescaledb_internal.job_history TO PUBLIC;
+
+CREATE TABLE _timescaledb_catalog.continuous_aggs_watermark (
+  mat_hypertable_id integer NOT NULL,
+  watermark bigint NOT NULL,
+  -- table constraints
+  CONSTRAINT continuous_aggs_watermark_pkey PRIMARY KEY (mat_hypertable_id),
+  CONSTRAINT continuous_aggs_watermark_mat_hypertable_id_fkey FOREIGN KEY (mat_hypertable_id) REFERENCES _timescaledb_catalog.continuous_agg (mat_hypertable_id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_aggs_watermark', '');
+
+GRANT SELECT ON _timescaledb_catalog.continuous_aggs_watermark TO PUBLIC;
+
+CREATE TABLE _timescaledb_catalog.chunk_size_stats (
+  hypertable_id integer NOT NULL,
+  chunk_id integer NOT NULL,
+  heap_bytes bigint NOT NULL,
+  index_bytes bigint NOT NULL,
+  toast_bytes bigint NOT NULL,
+  compressed_heap_bytes bigint NOT NULL,
+  compressed_index_bytes bigint NOT NULL,
+  compressed_toast_bytes bigint NOT NULL,
+  last_updated timestamptz NOT NULL,
+  -- table constraints
+  CONSTRAINT chunk_size_stats_pkey PRIMARY KEY (hypertable_id, chunk_id),
+  CONSTRAINT chunk_size_stats_hypertable_id_fkey FOREIGN KEY (hypertable_id) REFERENCES _timescaledb_catalog.hypertable (id) ON DELETE CASCADE,
+  CONSTRAINT chunk_size_stats_chunk_id_fkey FOREIGN KEY (chunk_id) REFERENCES _timescaledb_catalog.chunk (id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_size_stats', '');
+
+GRANT SELECT ON _timescaledb_catalog.chunk_size_stats TO PUBLIC;
+
+DROP FUNCTION IF EXISTS _timescaledb_internal.show_connection_cache();
+
+CREATE TABLE _timescaledb_catalog.continuous_aggs_partition_invalidation_log (
+  materialization_id integer,
+  lowest_modified_value bigint NOT NULL,
+  greatest_modified_value bigint NOT NULL,
+  partition_range_start bigint NOT NULL,
+  partition_range_end bigint NOT NULL,
+  -- table constraints
+  CONSTRAINT continuous_aggs_partition_invalidation_log_materialization_id_fkey FOREIGN KEY (materialization_id) REFERENCES _timescaledb_catalog.continuous_agg (mat_hypertable_id) ON DELETE CASCADE
+);
+
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_aggs_partition_invalidation_log', '');
+
+CREATE INDEX continuous_aggs_partition_invalidation_log_idx ON _timescaledb_catalog.continuous_aggs_partition_invalidation_log (materialization_id, lowest_modified_value ASC);
+
+GRANT SELECT ON _timescaledb_catalog.continuous_aggs_partition_invalidation_log TO PUBLIC;
@@ -0,0 +1,57 @@
+DROP FUNCTION IF EXISTS _timescaledb_internal.bloom1_contains(BYTEA, ANYELEMENT);
+DROP FUNCTION IF EXISTS _timescaledb_internal.recompress_chunk_segmentwise(REGCLASS, BOOLEAN);
+DELETE FROM _timescaledb_catalog.compression_algorithm WHERE id IN (5, 6, 7);
+DROP FUNCTION IF EXISTS @extschema@.add_chunk_precreation_policy(REGCLASS, INTEGER, BOOL, INTERVAL, TIMESTAMPTZ, TEXT);
+DROP FUNCTION IF EXISTS @extschema@.remove_chunk_precreation_policy(REGCLASS, BOOL);
+DROP PROCEDURE IF EXISTS _timescaledb_internal.policy_chunk_precreation(INTEGER, JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.policy_chunk_precreation_check(JSONB);
+DROP FUNCTION IF EXISTS @extschema@.enable_last_point_cache(REGCLASS, NAME, BOOLEAN);
+DROP FUNCTION IF EXISTS @extschema@.disable_last_point_cache(REGCLASS, BOOLEAN);
+DROP PROCEDURE IF EXISTS _timescaledb_internal.policy_refresh_continuous_aggregate_window(INTEGER, JSONB);
+DROP FUNCTION IF EXISTS @extschema@.add_invalidation_log_compaction_policy(REGCLASS, BOOL, INTERVAL, TIMESTAMPTZ, TEXT);
+DROP FUNCTION IF EXISTS @extschema@.remove_invalidation_log_compaction_policy(REGCLASS, BOOL);
+DROP PROCEDURE IF EXISTS _timescaledb_internal.policy_invalidation_log_compaction(INTEGER, JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.policy_invalidation_log_compaction_check(JSONB);
+DROP FUNCTION IF EXISTS @extschema@.set_job_concurrency_class(INTEGER, NAME, INTEGER);
+DROP FUNCTION IF EXISTS @extschema@.add_compression_batch_policy(INTERVAL, INTERVAL, BOOL, TIMESTAMPTZ, TEXT);
+DROP FUNCTION IF EXISTS @extschema@.remove_compression_batch_policy(BOOL);
+DROP PROCEDURE IF EXISTS _timescaledb_internal.policy_compression_batch(INTEGER, JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.policy_compression_batch_check(JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.policy_compression_batch_candidates(JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.policy_compression_process_chunk(REGCLASS, INTEGER, BOOLEAN);
+DROP AGGREGATE IF EXISTS _timescaledb_internal.compressed_data_agg(anyelement);
+DROP FUNCTION IF EXISTS _timescaledb_internal.compressed_data_agg_transfn(internal, anyelement);
+DROP FUNCTION IF EXISTS _timescaledb_internal.compressed_data_agg_finalfn(internal);
+DROP FUNCTION IF EXISTS _timescaledb_internal.merge_chunks(REGCLASS, REGCLASS);
+DROP FUNCTION IF EXISTS @extschema@.enable_chunk_skipping(REGCLASS, NAME, BOOLEAN);
+DROP FUNCTION IF EXISTS @extschema@.disable_chunk_skipping(REGCLASS, NAME, BOOLEAN);
+ALTER EXTENSION timescaledb DROP TABLE _timescaledb_catalog.chunk_column_stats;
+DROP TABLE _timescaledb_catalog.chunk_column_stats;
+DROP VIEW IF EXISTS timescaledb_information.hypertable_ingest_stats;
+DROP FUNCTION IF EXISTS _timescaledb_internal.hypertable_ingest_stats();
+DROP VIEW IF EXISTS timescaledb_information.job_history;
+ALTER EXTENSION timescaledb DROP TABLE _timescaledb_internal.job_history;
+DROP TABLE _timescaledb_internal.job_history;
+DROP FUNCTION IF EXISTS _timescaledb_internal.planner_timing();
+DROP FUNCTION IF EXISTS _timescaledb_internal.cache_info();
+ALTER EXTENSION timescaledb DROP TABLE _timescaledb_catalog.continuous_aggs_watermark;
+DROP TABLE _timescaledb_catalog.continuous_aggs_watermark;
+DROP FUNCTION IF EXISTS @extschema@.hypertable_approximate_size(REGCLASS);
+DROP FUNCTION IF EXISTS @extschema@.hypertable_approximate_detailed_size(REGCLASS);
+DROP FUNCTION IF EXISTS _timescaledb_internal.refresh_chunk_size_stats(REGCLASS);
+ALTER EXTENSION timescaledb DROP TABLE _timescaledb_catalog.chunk_size_stats;
+DROP TABLE _timescaledb_catalog.chunk_size_stats;
+DROP FUNCTION IF EXISTS _timescaledb_internal.rebalance_chunks(REGCLASS, INTEGER);
+DROP FUNCTION IF EXISTS _timescaledb_internal.balance_dimension_partitions(REGCLASS, INTEGER);
+DROP FUNCTION IF EXISTS @extschema@.add_distributed_stats_policy(REGCLASS, BOOL, INTERVAL, TIMESTAMPTZ, TEXT);
+DROP FUNCTION IF EXISTS @extschema@.remove_distributed_stats_policy(REGCLASS, BOOL);
+DROP PROCEDURE IF EXISTS _timescaledb_internal.policy_distributed_stats(INTEGER, JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.policy_distributed_stats_check(JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.remote_txn_heal_data_nodes(OID[]);
+DROP FUNCTION IF EXISTS _timescaledb_internal.show_connection_cache();
+ALTER EXTENSION timescaledb DROP TABLE _timescaledb_catalog.continuous_aggs_partition_invalidation_log;
+DROP TABLE _timescaledb_catalog.continuous_aggs_partition_invalidation_log;
+DROP FUNCTION IF EXISTS @extschema@.add_vacuum_policy(REGCLASS, INTEGER, BOOL, INTERVAL, TIMESTAMPTZ, TEXT);
+DROP FUNCTION IF EXISTS @extschema@.remove_vacuum_policy(REGCLASS, BOOL);
+DROP PROCEDURE IF EXISTS _timescaledb_internal.policy_vacuum(INTEGER, JSONB);
+DROP FUNCTION IF EXISTS _timescaledb_internal.policy_vacuum_check(JSONB);
@@ -328,4 +328,54 @@ SELECT
 FROM
     _timescaledb_internal.job_errors;
 
+-- resource usage of the successful job runs
+CREATE OR REPLACE VIEW timescaledb_information.job_history AS
+SELECT h.job_id,
+  j.application_name,
+  j.proc_schema,
+  j.proc_name,
+  ht.schema_name AS hypertable_schema,
+  ht.table_name AS hypertable_name,
+  h.pid,
+  h.start_time,
+  h.finish_time,
+  h.rows_processed,
+  h.chunks_processed,
+  h.bytes_read,
+  h.bytes_written,
+  h.wal_bytes,
+  h.user_cpu_time,
+  h.system_cpu_time
+FROM _timescaledb_internal.job_history h
+  LEFT JOIN _timescaledb_config.bgw_job j ON j.id = h.job_id
+  LEFT JOIN _timescaledb_catalog.hypertable ht ON ht.id = j.hypertable_id;
+
+-- statistics of the inserts into hypertables, for tuning
+-- timescaledb.max_open_chunks_per_insert and
+-- timescaledb.max_cached_chunks_per_hypertable
+CREATE OR REPLACE VIEW timescaledb_information.hypertable_ingest_stats AS
+SELECT ht.schema_name AS hypertable_schema,
+  ht.table_name AS hypertable_name,
+  s.statements,
+  s.rows,
+  s.insert_time_us * interval '1 microsecond' AS insert_time,
+  CASE WHEN s.insert_time_us > 0 THEN
+    s.rows * 1000000.0 / s.insert_time_us
+  END AS rows_per_second,
+  s.insert_state_hits,
+  s.insert_state_misses,
+  s.insert_state_evictions,
+  s.chunk_cache_hits,
+  s.chunk_cache_misses,
+  s.chunks_created,
+  s.chunk_create_time_us * interval '1 microsecond' AS chunk_create_time,
+  s.copy_flushes_tuples,
+  s.copy_flushes_bytes,
+  s.copy_flushes_buffer_full,
+  s.copy_flushes_buffers,
+  s.copy_flushes_triggers,
+  s.copy_flushes_end
+FROM _timescaledb_internal.hypertable_ingest_stats() s
+  INNER JOIN _timescaledb_catalog.hypertable ht ON ht.id = s.hypertable_id;
+
 GRANT SELECT ON ALL TABLES IN SCHEMA timescaledb_information TO PUBLIC;
@@ -197,43 +197,33 @@ static inline void
 bit_array_append(BitArray *array, uint8 num_bits, uint64 bits)
 {
 	/* Fill bits from LSB to MSB */
-	uint8 bits_remaining_in_last_bucket;
-	uint8 num_bits_for_new_bucket;
-	uint64 bits_for_new_bucket;
+	uint8 bits_used = array->bits_used_in_last_bucket;
 	Assert(num_bits <= 64);
 	if (num_bits == 0)
 		return;
 
-	if (array->buckets.num_elements == 0)
-		bit_array_append_bucket(array, 0, 0);
+	/* num_bits is at least 1, so the mask is a single shift */
+	bits &= PG_UINT64_MAX >> (BITS_PER_BUCKET - num_bits);
 
-	bits &= bit_array_low_bits_mask(num_bits);
-
-	bits_remaining_in_last_bucket = 64 - array->bits_used_in_last_bucket;
-	if (bits_remaining_in_last_bucket >= num_bits)
+	if (array->buckets.num_elements == 0 || bits_used == BITS_PER_BUCKET)
 	{
-		uint64 *bucket = uint64_vec_last(&array->buckets);
-		/* mask out any unused high bits, probably unneeded */
-		*bucket |= bits << array->bits_used_in_last_bucket;
-		array->bits_used_in_last_bucket += num_bits;
+		bit_array_append_bucket(array, num_bits, bits);
 		return;
 	}
 
-	/* When splitting an integer across buckets, the low-order bits go into the first bucket and
-	 * the high-order bits go into the second bucket  */
-	num_bits_for_new_bucket = num_bits - bits_remaining_in_last_bucket;
-	if (bits_remaining_in_last_bucket > 0)
+	/* the unused high bits of the last bucket are always 0 */
+	*uint64_vec_last(&array->buckets) |= bits << bits_used;
+	if (bits_used + num_bits <= BITS_PER_BUCKET)
 	{
-		uint64 bits_for_current_bucket =
-			bits & bit_array_low_bits_mask(bits_remaining_in_last_bucket);
-		uint64 *current_bucket = uint64_vec_last(&array->buckets);
-		*current_bucket |= bits_for_current_bucket << array->bits_used_in_last_bucket;
-		bits >>= bits_remaining_in_last_bucket;
+		array->bits_used_in_last_bucket = bits_used + num_bits;
+		return;
 	}
 
-	/* We zero out the high bits of the new bucket, to ensure that unused bits are always 0 */
-	bits_for_new_bucket = bits & bit_array_low_bits_mask(num_bits_for_new_bucket);
-	bit_array_append_bucket(array, num_bits_for_new_bucket, bits_for_new_bucket);
+	/* When splitting an integer across buckets, the low-order bits go into the first bucket and
+	 * the high-order bits go into the second bucket  */
+	bit_array_append_bucket(array,
+							bits_used + num_bits - BITS_PER_BUCKET,
+							bits >> (BITS_PER_BUCKET - bits_used));
 }
 
 static inline void
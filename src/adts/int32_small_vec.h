@@ -0,0 +1,22 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_ADT_INT32_SMALL_VEC_H
+#define TIMESCALEDB_ADT_INT32_SMALL_VEC_H
+
+/*
+ * A vector of int32, e.g., catalog ids, that keeps up to 16 elements inside of
+ * itself and can be used as a sorted set.
+ */
+#define VEC_PREFIX int32_small
+#define VEC_ELEMENT_TYPE int32
+#define VEC_INLINE_CAPACITY 16
+#define VEC_SORTED_SET 1
+#define VEC_DECLARE 1
+#define VEC_DEFINE 1
+#define VEC_SCOPE static inline
+#include <adts/vec.h>
+
+#endif
@@ -23,6 +23,14 @@
  *	  - VEC_DEFINE - if defined function definitions are generated
  *	  - VEC_SCOPE - in which scope (e.g. extern, static inline) do function
  *		    declarations reside
+ *	  - VEC_INLINE_CAPACITY - optional, if defined the vector has space for
+ *		    this many elements inside of it, so that a small vector needs no
+ *		    allocation. Such a vector points into itself and must not be
+ *		    copied by value.
+ *	  - VEC_SORTED_SET - optional, if defined functions that sort a vector and
+ *		    compute the intersection and union of sorted vectors are
+ *		    generated. The elements are compared with < and >, so this is only
+ *		    for scalar element types.
  */
 
 #define VEC_MAKE_PREFIX(a) CppConcat(a, _)
@@ -49,6 +57,17 @@
 #define VEC_DELETE_RANGE VEC_MAKE_NAME(vec_delete_range)
 #define VEC_RESERVE VEC_MAKE_NAME(vec_reserve)
 #define VEC_FREE VEC_MAKE_NAME(vec_free)
+#define VEC_ELEMENT_CMP VEC_MAKE_NAME(vec_element_cmp)
+#define VEC_SORT_UNIQUE VEC_MAKE_NAME(vec_sort_unique)
+#define VEC_CONTAINS VEC_MAKE_NAME(vec_contains)
+#define VEC_INTERSECT VEC_MAKE_NAME(vec_intersect)
+#define VEC_UNION VEC_MAKE_NAME(vec_union)
+
+#ifdef VEC_INLINE_CAPACITY
+#define VEC_DATA_IS_INLINE(vec) ((vec)->data == (vec)->inline_elements)
+#else
+#define VEC_DATA_IS_INLINE(vec) false
+#endif
 
 /* generate forward declarations necessary to use the vector */
 #ifdef VEC_DECLARE
@@ -66,6 +85,11 @@ typedef struct VEC_TYPE
 
 	/* memory context to use for allocations */
 	MemoryContext ctx;
+
+#ifdef VEC_INLINE_CAPACITY
+	/* the elements of a small vector, data points here until the vector grows */
+	VEC_ELEMENT_TYPE inline_elements[VEC_INLINE_CAPACITY];
+#endif
 } VEC_TYPE;
 
 /* externally visible function prototypes */
@@ -84,6 +108,12 @@ VEC_SCOPE void VEC_DELETE(VEC_TYPE *vec, uint32 index);
 VEC_SCOPE void VEC_DELETE_RANGE(VEC_TYPE *vec, uint32 start, uint32 len);
 VEC_SCOPE void VEC_RESERVE(VEC_TYPE *vec, uint32 additional);
 VEC_SCOPE void VEC_FREE(VEC_TYPE *vec);
+#ifdef VEC_SORTED_SET
+VEC_SCOPE void VEC_SORT_UNIQUE(VEC_TYPE *vec);
+VEC_SCOPE bool VEC_CONTAINS(const VEC_TYPE *vec, VEC_ELEMENT_TYPE element);
+VEC_SCOPE void VEC_INTERSECT(VEC_TYPE *vec, const VEC_TYPE *other);
+VEC_SCOPE void VEC_UNION(VEC_TYPE *vec, const VEC_TYPE *other);
+#endif
 
 #endif /* VEC_DECLARE */
 
@@ -122,6 +152,13 @@ VEC_RESERVE(VEC_TYPE *vec, uint32 additional)
 	num_bytes = vec->max_elements * sizeof(VEC_ELEMENT_TYPE);
 	if (vec->data == NULL)
 		vec->data = MemoryContextAlloc(vec->ctx, num_bytes);
+	else if (VEC_DATA_IS_INLINE(vec))
+	{
+		VEC_ELEMENT_TYPE *data = MemoryContextAlloc(vec->ctx, num_bytes);
+
+		memcpy(data, vec->data, sizeof(VEC_ELEMENT_TYPE) * vec->num_elements);
+		vec->data = data;
+	}
 	else
 		vec->data = repalloc(vec->data, num_bytes);
 }
@@ -136,6 +173,10 @@ VEC_INIT(VEC_TYPE *vec, MemoryContext ctx, uint32 nelements)
 	*vec = (VEC_TYPE){
 		.ctx = ctx,
 	};
+#ifdef VEC_INLINE_CAPACITY
+	vec->data = vec->inline_elements;
+	vec->max_elements = VEC_INLINE_CAPACITY;
+#endif
 	if (nelements > 0)
 		VEC_RESERVE(vec, nelements);
 }
@@ -156,12 +197,16 @@ VEC_CREATE(MemoryContext ctx, uint32 nelements)
 VEC_SCOPE void
 VEC_FREE_DATA(VEC_TYPE *vec)
 {
-	if (vec->data != NULL)
+	if (vec->data != NULL && !VEC_DATA_IS_INLINE(vec))
 		pfree(vec->data);
 	/* zero out all the vec data except the memory context so it can be reused */
 	*vec = (VEC_TYPE){
 		.ctx = vec->ctx,
 	};
+#ifdef VEC_INLINE_CAPACITY
+	vec->data = vec->inline_elements;
+	vec->max_elements = VEC_INLINE_CAPACITY;
+#endif
 }
 
 /* free an allocated vector, and its data */
@@ -257,6 +302,126 @@ VEC_DELETE(VEC_TYPE *vec, uint32 index)
 	VEC_DELETE_RANGE(vec, index, 1);
 }
 
+#ifdef VEC_SORTED_SET
+
+static inline int
+VEC_ELEMENT_CMP(const void *left, const void *right)
+{
+	VEC_ELEMENT_TYPE l = *((const VEC_ELEMENT_TYPE *) left);
+	VEC_ELEMENT_TYPE r = *((const VEC_ELEMENT_TYPE *) right);
+
+	return (l > r) - (l < r);
+}
+
+/* sort the elements and remove the duplicates, which makes the vector a set */
+VEC_SCOPE void
+VEC_SORT_UNIQUE(VEC_TYPE *vec)
+{
+	uint32 num_unique = 0;
+
+	if (vec->num_elements <= 1)
+		return;
+
+	qsort(vec->data, vec->num_elements, sizeof(VEC_ELEMENT_TYPE), VEC_ELEMENT_CMP);
+
+	for (uint32 i = 0; i < vec->num_elements; i++)
+	{
+		if (num_unique == 0 || vec->data[num_unique - 1] != vec->data[i])
+			vec->data[num_unique++] = vec->data[i];
+	}
+
+	vec->num_elements = num_unique;
+}
+
+/* check if a sorted vector contains an element, with a binary search */
+VEC_SCOPE bool
+VEC_CONTAINS(const VEC_TYPE *vec, VEC_ELEMENT_TYPE element)
+{
+	uint32 low = 0;
+	uint32 high = vec->num_elements;
+
+	while (low < high)
+	{
+		uint32 middle = low + (high - low) / 2;
+
+		if (vec->data[middle] < element)
+			low = middle + 1;
+		else if (vec->data[middle] > element)
+			high = middle;
+		else
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Keep only the elements that are also in the other vector. Both vectors must
+ * be sorted and unique.
+ */
+VEC_SCOPE void
+VEC_INTERSECT(VEC_TYPE *vec, const VEC_TYPE *other)
+{
+	uint32 num_result = 0;
+	uint32 j = 0;
+
+	for (uint32 i = 0; i < vec->num_elements && j < other->num_elements;)
+	{
+		if (vec->data[i] < other->data[j])
+			i++;
+		else if (vec->data[i] > other->data[j])
+			j++;
+		else
+		{
+			vec->data[num_result++] = vec->data[i];
+			i++;
+			j++;
+		}
+	}
+
+	vec->num_elements = num_result;
+}
+
+/*
+ * Add the elements of the other vector that are not in the vector yet. Both
+ * vectors must be sorted and unique. The vectors are merged from their ends
+ * into the end of the vector, which never overwrites elements that are still
+ * to be merged, and then moved to its start.
+ */
+VEC_SCOPE void
+VEC_UNION(VEC_TYPE *vec, const VEC_TYPE *other)
+{
+	int64 i = (int64) vec->num_elements - 1;
+	int64 j = (int64) other->num_elements - 1;
+	int64 next;
+
+	if (other->num_elements == 0)
+		return;
+
+	VEC_RESERVE(vec, other->num_elements);
+	next = (int64) vec->num_elements + other->num_elements - 1;
+
+	while (i >= 0 || j >= 0)
+	{
+		if (j < 0 || (i >= 0 && vec->data[i] > other->data[j]))
+			vec->data[next--] = vec->data[i--];
+		else if (i < 0 || vec->data[i] < other->data[j])
+			vec->data[next--] = other->data[j--];
+		else
+		{
+			vec->data[next--] = vec->data[i--];
+			j--;
+		}
+	}
+
+	next++;
+	vec->num_elements = vec->num_elements + other->num_elements - next;
+	if (next > 0)
+		memmove(vec->data, vec->data + next, sizeof(VEC_ELEMENT_TYPE) * vec->num_elements);
+}
+
+#endif /* VEC_SORTED_SET */
+
 #endif
 
 /* undefine external parameters, so next vector can be defined */
@@ -265,6 +430,8 @@ VEC_DELETE(VEC_TYPE *vec, uint32 index)
 #undef VEC_SCOPE
 #undef VEC_DECLARE
 #undef VEC_DEFINE
+#undef VEC_INLINE_CAPACITY
+#undef VEC_SORTED_SET
 
 /* undefine locally declared macros */
 #undef VEC_MAKE_PREFIX
@@ -289,3 +456,9 @@ VEC_DELETE(VEC_TYPE *vec, uint32 index)
 #undef VEC_DELETE_RANGE
 #undef VEC_RESERVE
 #undef VEC_FREE
+#undef VEC_ELEMENT_CMP
+#undef VEC_SORT_UNIQUE
+#undef VEC_CONTAINS
+#undef VEC_INTERSECT
+#undef VEC_UNION
+#undef VEC_DATA_IS_INLINE
@@ -12,9 +12,11 @@
 #include <lib/stringinfo.h>
 #include <nodes/value.h>
 #include <utils/datum.h>
+#include <utils/fmgroids.h>
 #include <utils/lsyscache.h>
 #include <utils/syscache.h>
 
+#include "compat/compat.h"
 #include "export.h"
 
 /* bookend aggregates first and last:
@@ -255,6 +257,25 @@ typeinfocache_polydatumcopy(TypeInfoCache *tic, PolyDatum input, PolyDatum *outp
 		tic->type_oid = input.type_oid;
 		get_typlenbyval(tic->type_oid, &tic->typelen, &tic->typebyval);
 	}
+
+	/*
+	 * A new winner usually replaces the previous one on every row, e.g., for
+	 * last() over rows in time order. Copy a by-reference value into the
+	 * memory of the previous winner instead of freeing it and allocating new
+	 * memory, repalloc keeps the chunk when the new value fits.
+	 */
+	if (!tic->typebyval && !output->is_null && !input.is_null &&
+		!(tic->typelen == -1 && VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(input.datum))))
+	{
+		Size size = datumGetSize(input.datum, tic->typebyval, tic->typelen);
+		Pointer copy = repalloc(DatumGetPointer(output->datum), size);
+
+		memcpy(copy, DatumGetPointer(input.datum), size);
+		*output = input;
+		output->datum = PointerGetDatum(copy);
+		return;
+	}
+
 	if (!tic->typebyval && !output->is_null)
 	{
 		pfree(DatumGetPointer(output->datum));
@@ -274,14 +295,81 @@ typeinfocache_polydatumcopy(TypeInfoCache *tic, PolyDatum input, PolyDatum *outp
 	}
 }
 
+/*
+ * The comparison elements are usually integers or timestamps. For the
+ * built-in comparison operators of these by-value types, we compare the
+ * datums directly instead of calling the operator through fmgr on every row.
+ */
+typedef enum CmpProcKind
+{
+	CMPPROC_FMGR = 0,
+	CMPPROC_INT16,
+	CMPPROC_INT32,
+	CMPPROC_INT64,
+} CmpProcKind;
+
+typedef struct TransCache
+{
+	TypeInfoCache value_type_cache;
+	TypeInfoCache cmp_type_cache;
+	FmgrInfo cmp_proc;
+	Oid cmp_proc_type_oid;
+	CmpProcKind cmp_kind;
+	bool cmp_less;
+} TransCache;
+
+static TransCache *
+transcache_get(FunctionCallInfo fcinfo)
+{
+	TransCache *my_extra = (TransCache *) fcinfo->flinfo->fn_extra;
+
+	if (my_extra == NULL)
+	{
+		fcinfo->flinfo->fn_extra =
+			MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(TransCache));
+		my_extra = (TransCache *) fcinfo->flinfo->fn_extra;
+	}
+	return my_extra;
+}
+
+static CmpProcKind
+cmpproc_kind(Oid cmp_regproc, bool *less)
+{
+	*less = true;
+
+	if (cmp_regproc == F_INT2LT)
+		return CMPPROC_INT16;
+	if (cmp_regproc == F_INT4LT || cmp_regproc == F_DATE_LT)
+		return CMPPROC_INT32;
+	if (cmp_regproc == F_INT8LT || cmp_regproc == F_TIMESTAMP_LT ||
+		cmp_regproc == F_TIMESTAMPTZ_LT)
+		return CMPPROC_INT64;
+
+	*less = false;
+
+	if (cmp_regproc == F_INT2GT)
+		return CMPPROC_INT16;
+	if (cmp_regproc == F_INT4GT || cmp_regproc == F_DATE_GT)
+		return CMPPROC_INT32;
+	if (cmp_regproc == F_INT8GT || cmp_regproc == F_TIMESTAMP_GT ||
+		cmp_regproc == F_TIMESTAMPTZ_GT)
+		return CMPPROC_INT64;
+
+	return CMPPROC_FMGR;
+}
+
 inline static void
-cmpproc_init(FunctionCallInfo fcinfo, FmgrInfo *cmp_proc, Oid type_oid, char *opname)
+cmpproc_init(FunctionCallInfo fcinfo, TransCache *cache, Oid type_oid, char *opname)
 {
 	Oid cmp_op, cmp_regproc;
 
 	if (!OidIsValid(type_oid))
 		elog(ERROR, "could not determine the type of the comparison_element");
 
+	/* a transition function always compares with the same operator */
+	if (cache->cmp_proc_type_oid == type_oid)
+		return;
+
 	cmp_op = OpernameGetOprid(list_make1(makeString(opname)), type_oid, type_oid);
 	if (!OidIsValid(cmp_op))
 		elog(ERROR, "could not find a %s operator for type %d", opname, type_oid);
@@ -291,34 +379,36 @@ cmpproc_init(FunctionCallInfo fcinfo, FmgrInfo *cmp_proc, Oid type_oid, char *op
 			 "could not find the procedure for the %s operator for type %d",
 			 opname,
 			 type_oid);
-	fmgr_info_cxt(cmp_regproc, cmp_proc, fcinfo->flinfo->fn_mcxt);
+	fmgr_info_cxt(cmp_regproc, &cache->cmp_proc, fcinfo->flinfo->fn_mcxt);
+	cache->cmp_kind = cmpproc_kind(cmp_regproc, &cache->cmp_less);
+	cache->cmp_proc_type_oid = type_oid;
 }
 
 inline static bool
-cmpproc_cmp(FmgrInfo *cmp_proc, FunctionCallInfo fcinfo, PolyDatum left, PolyDatum right)
-{
-	return DatumGetBool(FunctionCall2Coll(cmp_proc, fcinfo->fncollation, left.datum, right.datum));
-}
-
-typedef struct TransCache
-{
-	TypeInfoCache value_type_cache;
-	TypeInfoCache cmp_type_cache;
-	FmgrInfo cmp_proc;
-} TransCache;
-
-static TransCache *
-transcache_get(FunctionCallInfo fcinfo)
+cmpproc_cmp(TransCache *cache, FunctionCallInfo fcinfo, PolyDatum left, PolyDatum right)
 {
-	TransCache *my_extra = (TransCache *) fcinfo->flinfo->fn_extra;
+	int64 l, r;
 
-	if (my_extra == NULL)
+	switch (cache->cmp_kind)
 	{
-		fcinfo->flinfo->fn_extra =
-			MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(TransCache));
-		my_extra = (TransCache *) fcinfo->flinfo->fn_extra;
+		case CMPPROC_INT16:
+			l = DatumGetInt16(left.datum);
+			r = DatumGetInt16(right.datum);
+			break;
+		case CMPPROC_INT32:
+			l = DatumGetInt32(left.datum);
+			r = DatumGetInt32(right.datum);
+			break;
+		case CMPPROC_INT64:
+			l = DatumGetInt64(left.datum);
+			r = DatumGetInt64(right.datum);
+			break;
+		default:
+			return DatumGetBool(
+				FunctionCall2Coll(&cache->cmp_proc, fcinfo->fncollation, left.datum, right.datum));
 	}
-	return my_extra;
+
+	return cache->cmp_less ? l < r : l > r;
 }
 
 /*
@@ -336,14 +426,14 @@ bookend_sfunc(MemoryContext aggcontext, InternalCmpAggStore *state, PolyDatum va
 	if (state == NULL)
 	{
 		state = init_store(aggcontext);
-		cmpproc_init(fcinfo, &cache->cmp_proc, cmp.type_oid, opname);
+		cmpproc_init(fcinfo, cache, cmp.type_oid, opname);
 		typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value);
 		typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp);
 	}
 	else
 	{
 		/* only do comparison if cmp is not NULL */
-		if (!cmp.is_null && cmpproc_cmp(&cache->cmp_proc, fcinfo, cmp, state->cmp))
+		if (!cmp.is_null && cmpproc_cmp(cache, fcinfo, cmp, state->cmp))
 		{
 			typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value);
 			typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp);
@@ -397,8 +487,8 @@ bookend_combinefunc(MemoryContext aggcontext, InternalCmpAggStore *state1,
 			PG_RETURN_POINTER(state1);
 	}
 
-	cmpproc_init(fcinfo, &cache->cmp_proc, state1->cmp.type_oid, opname);
-	if (cmpproc_cmp(&cache->cmp_proc, fcinfo, state2->cmp, state1->cmp))
+	cmpproc_init(fcinfo, cache, state1->cmp.type_oid, opname);
+	if (cmpproc_cmp(cache, fcinfo, state2->cmp, state1->cmp))
 	{
 		old_context = MemoryContextSwitchTo(aggcontext);
 		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value);
@@ -8,6 +8,7 @@
 #include <pgstat.h>
 #include <access/xact.h>
 #include <catalog/pg_authid.h>
+#include <commands/discard.h>
 #include <nodes/makefuncs.h>
 #include <parser/parse_func.h>
 #include <parser/parser.h>
@@ -29,6 +30,7 @@
 #include <unistd.h>
 
 #include "job.h"
+#include "job_pool.h"
 #include "config.h"
 #include "scanner.h"
 #include "extension.h"
@@ -75,6 +77,25 @@ ts_bgw_job_start(BgwJob *job, Oid user_oid)
 	return ts_bgw_start_worker(NameStr(job->fd.application_name), &bgw_params);
 }
 
+/*
+ * Start a worker for the job pool. The worker runs the job and then waits in
+ * the pool slot for more jobs of the same user.
+ */
+BackgroundWorkerHandle *
+ts_bgw_job_start_pooled(BgwJob *job, Oid user_oid, dsm_handle pool_handle, int pool_slot)
+{
+	BgwParams bgw_params = {
+		.job_id = Int32GetDatum(job->fd.id),
+		.user_oid = user_oid,
+		.pool_handle = pool_handle,
+		.pool_slot = pool_slot + 1,
+	};
+
+	strlcpy(bgw_params.bgw_main, job_entrypoint_function_name, sizeof(bgw_params.bgw_main));
+
+	return ts_bgw_start_worker(NameStr(job->fd.application_name), &bgw_params);
+}
+
 static void
 job_execute_function(FuncExpr *funcexpr)
 {
@@ -1117,39 +1138,18 @@ ts_job_errors_insert_tuple(const FormData_job_error *job_err)
 	return true;
 }
 
-extern Datum
-ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
+static void
+bgw_job_run(int32 job_id)
 {
-	Oid db_oid = DatumGetObjectId(MyBgworkerEntry->bgw_main_arg);
-	BgwParams params;
 	BgwJob *job;
 	JobResult res = JOB_FAILURE;
 	bool got_lock;
 
-	memcpy(&params, MyBgworkerEntry->bgw_extra, sizeof(BgwParams));
-	Ensure(params.user_oid != 0 && params.job_id != 0,
-		   "job id or user oid was zero - job_id: %d, user_oid: %d",
-		   params.job_id,
-		   params.user_oid);
-
-	BackgroundWorkerBlockSignals();
-	/* Setup any signal handlers here */
-
-	/*
-	 * do not use the default `bgworker_die` sigterm handler because it does
-	 * not respect critical sections
-	 */
-	pqsignal(SIGTERM, die);
-	BackgroundWorkerUnblockSignals();
-
-	BackgroundWorkerInitializeConnectionByOid(db_oid, params.user_oid, 0);
-
-	ts_license_enable_module_loading();
-
 	StartTransactionCommand();
 	/* Grab a session lock on the job row to prevent concurrent deletes. Lock is released
-	 * when the job process exits */
-	job = ts_bgw_job_find_with_lock(params.job_id,
+	 * when the job process exits or, for pooled workers, when the session is reset after
+	 * the job */
+	job = ts_bgw_job_find_with_lock(job_id,
 									TopMemoryContext,
 									RowShareLock,
 									SESSION_LOCK,
@@ -1159,7 +1159,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 	CommitTransactionCommand();
 
 	if (job == NULL)
-		elog(ERROR, "job %d not found when running the background worker", params.job_id);
+		elog(ERROR, "job %d not found when running the background worker", job_id);
 
 	pgstat_report_appname(NameStr(job->fd.application_name));
 	MemoryContext oldcontext = CurrentMemoryContext;
@@ -1206,7 +1206,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		 * removed the session lock. Don't block and only record if the lock was actually
 		 * obtained.
 		 */
-		job = ts_bgw_job_find_with_lock(params.job_id,
+		job = ts_bgw_job_find_with_lock(job_id,
 										TopMemoryContext,
 										RowShareLock,
 										TXN_LOCK,
@@ -1226,7 +1226,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		 * the rethrow will log the error; but also log which job threw the
 		 * error
 		 */
-		elog(LOG, "job %d threw an error", params.job_id);
+		elog(LOG, "job %d threw an error", job_id);
 
 		ErrorData *edata;
 		FormData_job_error jerr = { 0 };
@@ -1234,7 +1234,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		MemoryContextSwitchTo(oldcontext);
 		edata = CopyErrorData();
 
-		BgwJobStat *job_stat = ts_bgw_job_stat_find(params.job_id);
+		BgwJobStat *job_stat = ts_bgw_job_stat_find(job_id);
 		if (job_stat != NULL)
 		{
 			start_time = job_stat->fd.last_start;
@@ -1243,7 +1243,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		/* We include the procname in the error data and expose it in the view
 		 to avoid adding an extra field in the table */
 		jerr.error_data = ts_errdata_to_jsonb(edata, &proc_schema, &proc_name);
-		jerr.job_id = params.job_id;
+		jerr.job_id = job_id;
 		jerr.start_time = start_time;
 		jerr.finish_time = finish_time;
 		jerr.pid = MyProcPid;
@@ -1262,9 +1262,11 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 
 	/*
 	 * Note that the mark_start happens in the scheduler right before the job
-	 * is launched
+	 * is launched. A job can remove itself when it has nothing left to do,
+	 * in which case there are no statistics to update.
 	 */
-	ts_bgw_job_stat_mark_end(job, res);
+	if (ts_bgw_job_stat_find(job_id) != NULL)
+		ts_bgw_job_stat_mark_end(job, res);
 
 	CommitTransactionCommand();
 
@@ -1274,10 +1276,69 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		job = NULL;
 	}
 
-	elog(DEBUG1,
-		 "exiting job %d with %s",
-		 params.job_id,
-		 (res == JOB_SUCCESS ? "success" : "failure"));
+	elog(DEBUG1, "finished job %d with %s", job_id, (res == JOB_SUCCESS ? "success" : "failure"));
+}
+
+/*
+ * Reset the session of a pooled worker before it runs the next job, so that
+ * nothing set by a job leaks into the next one. This also releases the
+ * session lock on the job.
+ */
+static void
+bgw_job_reset_session(void)
+{
+	StartTransactionCommand();
+	DiscardCommand(&(DiscardStmt){ .type = T_DiscardStmt, .target = DISCARD_ALL },
+				   /* isTopLevel */ true);
+	CommitTransactionCommand();
+}
+
+extern Datum
+ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
+{
+	Oid db_oid = DatumGetObjectId(MyBgworkerEntry->bgw_main_arg);
+	BgwParams params;
+	BgwJobPool *pool = NULL;
+	int32 job_id;
+
+	memcpy(&params, MyBgworkerEntry->bgw_extra, sizeof(BgwParams));
+	Ensure(params.user_oid != 0 && params.job_id != 0,
+		   "job id or user oid was zero - job_id: %d, user_oid: %d",
+		   params.job_id,
+		   params.user_oid);
+
+	BackgroundWorkerBlockSignals();
+	/* Setup any signal handlers here */
+
+	/*
+	 * do not use the default `bgworker_die` sigterm handler because it does
+	 * not respect critical sections
+	 */
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	BackgroundWorkerInitializeConnectionByOid(db_oid, params.user_oid, 0);
+
+	ts_license_enable_module_loading();
+
+	/* A worker started for the pool runs jobs until it has been idle for too long */
+	if (params.pool_slot > 0)
+		pool = ts_bgw_job_pool_attach(params.pool_handle);
+
+	job_id = params.job_id;
+
+	while (job_id != 0)
+	{
+		bgw_job_run(job_id);
+
+		if (pool == NULL)
+			break;
+
+		bgw_job_reset_session();
+		job_id = ts_bgw_job_pool_wait_for_job(pool, params.pool_slot - 1);
+	}
+
+	elog(DEBUG1, "exiting job worker");
 
 	PG_RETURN_VOID();
 }
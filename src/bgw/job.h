@@ -9,10 +9,18 @@
 #include <postgres.h>
 #include <storage/lock.h>
 #include <postmaster/bgworker.h>
+#include <storage/dsm.h>
 
 #include "export.h"
 #include "ts_catalog/catalog.h"
 
+/*
+ * Keys of the job config that put the job in a concurrency class. The
+ * scheduler starts at most max_concurrency jobs of a class at a time.
+ */
+#define BGW_JOB_CONFIG_CONCURRENCY_CLASS "concurrency_class"
+#define BGW_JOB_CONFIG_MAX_CONCURRENCY "max_concurrency"
+
 typedef struct BgwJob
 {
 	FormData_bgw_job fd;
@@ -22,6 +30,8 @@ typedef bool job_main_func(void);
 typedef bool (*scheduler_test_hook_type)(BgwJob *job);
 
 extern BackgroundWorkerHandle *ts_bgw_job_start(BgwJob *job, Oid user_oid);
+extern BackgroundWorkerHandle *ts_bgw_job_start_pooled(BgwJob *job, Oid user_oid,
+													   dsm_handle pool_handle, int pool_slot);
 
 extern List *ts_bgw_job_get_all(size_t alloc_size, MemoryContext mctx);
 extern List *ts_bgw_job_get_scheduled(size_t alloc_size, MemoryContext mctx);
@@ -0,0 +1,142 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * The resource usage of the job runs. The usage of the backend is sampled
+ * when a job starts and when it finishes, and the difference is recorded in
+ * the job_history table together with the rows and chunks that the job
+ * processed. The rows and chunks are counted by the code doing the work, e.g.,
+ * compress_chunk() and drop_chunks(), also outside of jobs, but the counters
+ * are only reset and recorded by the jobs.
+ */
+#include <postgres.h>
+#include <miscadmin.h>
+#include <access/htup_details.h>
+#include <access/table.h>
+#include <executor/instrument.h>
+#include <utils/timestamp.h>
+
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+#ifndef HAVE_GETRUSAGE
+#include <rusagestub.h>
+#endif
+
+#include "compat/compat.h"
+#include "job_history.h"
+#include "ts_catalog/catalog.h"
+
+typedef struct JobHistoryState
+{
+	TimestampTz start_time;
+	struct rusage rusage;
+	BufferUsage buffer_usage;
+#if PG13_GE
+	WalUsage wal_usage;
+#endif
+	int64 rows_processed;
+	int64 chunks_processed;
+} JobHistoryState;
+
+static JobHistoryState job_history;
+
+void
+ts_job_history_add_rows(int64 rows)
+{
+	job_history.rows_processed += rows;
+}
+
+void
+ts_job_history_add_chunks(int64 chunks)
+{
+	job_history.chunks_processed += chunks;
+}
+
+void
+ts_job_history_start(void)
+{
+	job_history.start_time = GetCurrentTimestamp();
+	getrusage(RUSAGE_SELF, &job_history.rusage);
+	job_history.buffer_usage = pgBufferUsage;
+#if PG13_GE
+	job_history.wal_usage = pgWalUsage;
+#endif
+	job_history.rows_processed = 0;
+	job_history.chunks_processed = 0;
+}
+
+static Interval *
+timeval_diff_interval(const struct timeval *end, const struct timeval *start)
+{
+	Interval *interval = palloc0(sizeof(Interval));
+
+	interval->time = (int64) (end->tv_sec - start->tv_sec) * USECS_PER_SEC +
+					 (int64) (end->tv_usec - start->tv_usec);
+
+	return interval;
+}
+
+/*
+ * Record the resource usage since ts_job_history_start() in the job_history
+ * table. This is done in the transaction of the job, so only the successful
+ * runs are recorded, the failed ones are recorded in the job_errors table.
+ */
+void
+ts_job_history_finish(int32 job_id)
+{
+	Catalog *catalog = ts_catalog_get();
+	Relation rel = table_open(catalog_get_table_id(catalog, JOB_HISTORY), RowExclusiveLock);
+	TupleDesc desc = RelationGetDescr(rel);
+	Datum values[Natts_job_history];
+	bool nulls[Natts_job_history] = { false };
+	const BufferUsage *start = &job_history.buffer_usage;
+	CatalogSecurityContext sec_ctx;
+	struct rusage rusage;
+	int64 blocks_read;
+	int64 blocks_written;
+
+	getrusage(RUSAGE_SELF, &rusage);
+	blocks_read = (pgBufferUsage.shared_blks_read - start->shared_blks_read) +
+				  (pgBufferUsage.local_blks_read - start->local_blks_read) +
+				  (pgBufferUsage.temp_blks_read - start->temp_blks_read);
+	blocks_written = (pgBufferUsage.shared_blks_written - start->shared_blks_written) +
+					 (pgBufferUsage.local_blks_written - start->local_blks_written) +
+					 (pgBufferUsage.temp_blks_written - start->temp_blks_written);
+
+	values[AttrNumberGetAttrOffset(Anum_job_history_job_id)] = Int32GetDatum(job_id);
+	values[AttrNumberGetAttrOffset(Anum_job_history_pid)] = Int32GetDatum(MyProcPid);
+	values[AttrNumberGetAttrOffset(Anum_job_history_start_time)] =
+		TimestampTzGetDatum(job_history.start_time);
+	values[AttrNumberGetAttrOffset(Anum_job_history_finish_time)] =
+		TimestampTzGetDatum(GetCurrentTimestamp());
+	values[AttrNumberGetAttrOffset(Anum_job_history_rows_processed)] =
+		Int64GetDatum(job_history.rows_processed);
+	values[AttrNumberGetAttrOffset(Anum_job_history_chunks_processed)] =
+		Int64GetDatum(job_history.chunks_processed);
+	values[AttrNumberGetAttrOffset(Anum_job_history_bytes_read)] =
+		Int64GetDatum(blocks_read * BLCKSZ);
+	values[AttrNumberGetAttrOffset(Anum_job_history_bytes_written)] =
+		Int64GetDatum(blocks_written * BLCKSZ);
+#if PG13_GE
+	values[AttrNumberGetAttrOffset(Anum_job_history_wal_bytes)] =
+		Int64GetDatum((int64) (pgWalUsage.wal_bytes - job_history.wal_usage.wal_bytes));
+#else
+	/* The WAL usage is not tracked before PG13 */
+	nulls[AttrNumberGetAttrOffset(Anum_job_history_wal_bytes)] = true;
+#endif
+	values[AttrNumberGetAttrOffset(Anum_job_history_user_cpu_time)] =
+		IntervalPGetDatum(timeval_diff_interval(&rusage.ru_utime, &job_history.rusage.ru_utime));
+	values[AttrNumberGetAttrOffset(Anum_job_history_system_cpu_time)] =
+		IntervalPGetDatum(timeval_diff_interval(&rusage.ru_stime, &job_history.rusage.ru_stime));
+
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_catalog_insert_values(rel, desc, values, nulls);
+	ts_catalog_restore_user(&sec_ctx);
+
+	table_close(rel, RowExclusiveLock);
+}
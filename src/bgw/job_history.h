@@ -0,0 +1,18 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef BGW_JOB_HISTORY_H
+#define BGW_JOB_HISTORY_H
+
+#include <postgres.h>
+
+#include "export.h"
+
+extern TSDLLEXPORT void ts_job_history_start(void);
+extern TSDLLEXPORT void ts_job_history_finish(int32 job_id);
+extern TSDLLEXPORT void ts_job_history_add_rows(int64 rows);
+extern TSDLLEXPORT void ts_job_history_add_chunks(int64 chunks);
+
+#endif /* BGW_JOB_HISTORY_H */
@@ -0,0 +1,332 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <storage/dsm.h>
+#include <storage/latch.h>
+#include <storage/proc.h>
+#include <storage/spin.h>
+#include <utils/timestamp.h>
+
+#include "job_pool.h"
+
+/*
+ * Pool of job workers.
+ *
+ * Starting a background worker for every job run costs a process start,
+ * loading the extension and warming up the caches. With a pool, the worker
+ * of a finished job waits for timescaledb.bgw_job_worker_idle_timeout, and
+ * the scheduler can hand it the next job of the same owner instead of
+ * starting a new worker.
+ *
+ * The pool lives in a dynamic shared memory segment created by the scheduler
+ * of the database, with one slot per worker. The job id of the first job of a
+ * worker is passed in the worker parameters, as for other jobs, and the
+ * following ones through the slot. A slot moves through these states:
+ *
+ * FREE -> RUNNING: the scheduler starts a worker for the slot
+ * RUNNING -> IDLE: the worker finished the job
+ * IDLE -> ASSIGNED: the scheduler picked the worker for a job and marks the
+ *                   job as started
+ * ASSIGNED -> RUNNING: the scheduler hands the job to the worker
+ * ASSIGNED -> IDLE: the scheduler could not start the job
+ * IDLE -> EXITED: the worker waited for the idle timeout and exits, or the
+ *                 scheduler needs the background worker for another job
+ *
+ * A worker that fails a job exits, as without a pool. The scheduler frees
+ * the slot once the worker has stopped.
+ */
+typedef enum BgwJobSlotState
+{
+	SLOT_FREE = 0,
+	SLOT_RUNNING,
+	SLOT_IDLE,
+	SLOT_ASSIGNED,
+	SLOT_EXITED,
+} BgwJobSlotState;
+
+typedef struct BgwJobSlot
+{
+	slock_t mutex;
+	BgwJobSlotState state;
+	int32 job_id;
+	Oid user_oid;
+	Latch *latch; /* Latch of the worker, set when it waits for a job */
+} BgwJobSlot;
+
+struct BgwJobPool
+{
+	Latch *scheduler_latch;
+	int idle_timeout_ms;
+	int num_slots;
+	BgwJobSlot slots[FLEXIBLE_ARRAY_MEMBER];
+};
+
+/* WaitLatch expects a long */
+#define BGW_JOB_POOL_WAIT_INTERVAL 1000L
+
+BgwJobPool *
+ts_bgw_job_pool_create(int num_slots, dsm_handle *handle)
+{
+	Size size = add_size(offsetof(BgwJobPool, slots), mul_size(num_slots, sizeof(BgwJobSlot)));
+	dsm_segment *seg = dsm_create(size, 0);
+	BgwJobPool *pool = dsm_segment_address(seg);
+
+	/* The pool is used for the whole life of the scheduler */
+	dsm_pin_mapping(seg);
+
+	memset(pool, 0, size);
+	pool->scheduler_latch = MyLatch;
+	pool->num_slots = num_slots;
+
+	for (int i = 0; i < num_slots; i++)
+	{
+		SpinLockInit(&pool->slots[i].mutex);
+		pool->slots[i].state = SLOT_FREE;
+	}
+
+	*handle = dsm_segment_handle(seg);
+	return pool;
+}
+
+void
+ts_bgw_job_pool_set_idle_timeout(BgwJobPool *pool, int idle_timeout_ms)
+{
+	pool->idle_timeout_ms = idle_timeout_ms;
+}
+
+/*
+ * Find an idle worker of the job owner and assign the job to it. The worker
+ * keeps waiting until the job is handed to it with
+ * ts_bgw_job_pool_run_assigned(), so that the scheduler can mark the job as
+ * started first. Returns the slot of the worker or -1.
+ */
+int
+ts_bgw_job_pool_assign_idle(BgwJobPool *pool, int32 job_id, Oid user_oid)
+{
+	for (int i = 0; i < pool->num_slots; i++)
+	{
+		BgwJobSlot *slot = &pool->slots[i];
+		bool assigned = false;
+
+		SpinLockAcquire(&slot->mutex);
+		if (slot->state == SLOT_IDLE && slot->user_oid == user_oid)
+		{
+			slot->state = SLOT_ASSIGNED;
+			slot->job_id = job_id;
+			assigned = true;
+		}
+		SpinLockRelease(&slot->mutex);
+
+		if (assigned)
+			return i;
+	}
+
+	return -1;
+}
+
+void
+ts_bgw_job_pool_run_assigned(BgwJobPool *pool, int slot_index)
+{
+	BgwJobSlot *slot = &pool->slots[slot_index];
+	Latch *latch;
+
+	SpinLockAcquire(&slot->mutex);
+	Assert(slot->state == SLOT_ASSIGNED);
+	slot->state = SLOT_RUNNING;
+	latch = slot->latch;
+	SpinLockRelease(&slot->mutex);
+
+	if (latch != NULL)
+		SetLatch(latch);
+}
+
+void
+ts_bgw_job_pool_cancel_assigned(BgwJobPool *pool, int slot_index)
+{
+	BgwJobSlot *slot = &pool->slots[slot_index];
+
+	SpinLockAcquire(&slot->mutex);
+	Assert(slot->state == SLOT_ASSIGNED);
+	slot->state = SLOT_IDLE;
+	SpinLockRelease(&slot->mutex);
+}
+
+/* Take a free slot for a new worker that runs the job. Returns the slot or -1. */
+int
+ts_bgw_job_pool_reserve_free(BgwJobPool *pool, int32 job_id, Oid user_oid)
+{
+	for (int i = 0; i < pool->num_slots; i++)
+	{
+		BgwJobSlot *slot = &pool->slots[i];
+		bool reserved = false;
+
+		SpinLockAcquire(&slot->mutex);
+		if (slot->state == SLOT_FREE)
+		{
+			slot->state = SLOT_RUNNING;
+			slot->job_id = job_id;
+			slot->user_oid = user_oid;
+			slot->latch = NULL;
+			reserved = true;
+		}
+		SpinLockRelease(&slot->mutex);
+
+		if (reserved)
+			return i;
+	}
+
+	return -1;
+}
+
+/* Check if the worker of the slot is done with the job */
+bool
+ts_bgw_job_pool_job_done(BgwJobPool *pool, int slot_index, int32 job_id)
+{
+	BgwJobSlot *slot = &pool->slots[slot_index];
+	bool done;
+
+	SpinLockAcquire(&slot->mutex);
+	done = slot->job_id != job_id || (slot->state != SLOT_RUNNING && slot->state != SLOT_ASSIGNED);
+	SpinLockRelease(&slot->mutex);
+
+	return done;
+}
+
+/*
+ * Take an idle worker out of the pool, so that the scheduler can terminate it
+ * and use the background worker for a job of another user. Returns the slot
+ * of the worker or -1.
+ */
+int
+ts_bgw_job_pool_evict_idle(BgwJobPool *pool)
+{
+	for (int i = 0; i < pool->num_slots; i++)
+	{
+		BgwJobSlot *slot = &pool->slots[i];
+		bool evicted = false;
+
+		SpinLockAcquire(&slot->mutex);
+		if (slot->state == SLOT_IDLE)
+		{
+			slot->state = SLOT_EXITED;
+			evicted = true;
+		}
+		SpinLockRelease(&slot->mutex);
+
+		if (evicted)
+			return i;
+	}
+
+	return -1;
+}
+
+/* Make the workers exit as soon as they are done with their job */
+void
+ts_bgw_job_pool_shutdown(BgwJobPool *pool)
+{
+	pool->idle_timeout_ms = 0;
+
+	for (int i = 0; i < pool->num_slots; i++)
+	{
+		BgwJobSlot *slot = &pool->slots[i];
+		Latch *latch;
+
+		SpinLockAcquire(&slot->mutex);
+		latch = slot->state == SLOT_IDLE ? slot->latch : NULL;
+		SpinLockRelease(&slot->mutex);
+
+		if (latch != NULL)
+			SetLatch(latch);
+	}
+}
+
+/* Free the slot of a worker that has stopped */
+void
+ts_bgw_job_pool_release(BgwJobPool *pool, int slot_index)
+{
+	BgwJobSlot *slot = &pool->slots[slot_index];
+
+	SpinLockAcquire(&slot->mutex);
+	slot->state = SLOT_FREE;
+	slot->job_id = 0;
+	slot->latch = NULL;
+	SpinLockRelease(&slot->mutex);
+}
+
+BgwJobPool *
+ts_bgw_job_pool_attach(dsm_handle handle)
+{
+	dsm_segment *seg = dsm_attach(handle);
+
+	if (seg == NULL)
+		return NULL;
+
+	dsm_pin_mapping(seg);
+	return dsm_segment_address(seg);
+}
+
+/*
+ * Called by a worker when it finished a job. Wait for the scheduler to hand
+ * over the next job and return its id, or return 0 if no job came within the
+ * idle timeout, after which the worker should exit.
+ */
+int32
+ts_bgw_job_pool_wait_for_job(BgwJobPool *pool, int slot_index)
+{
+	BgwJobSlot *slot = &pool->slots[slot_index];
+	TimestampTz idle_start = GetCurrentTimestamp();
+	int32 job_id = 0;
+
+	SpinLockAcquire(&slot->mutex);
+	Assert(slot->state == SLOT_RUNNING);
+	slot->state = SLOT_IDLE;
+	slot->latch = MyLatch;
+	SpinLockRelease(&slot->mutex);
+
+	/* Let the scheduler know that the job is done */
+	SetLatch(pool->scheduler_latch);
+
+	for (;;)
+	{
+		bool timed_out = TimestampDifferenceExceeds(idle_start,
+													GetCurrentTimestamp(),
+													pool->idle_timeout_ms);
+		bool done = false;
+
+		SpinLockAcquire(&slot->mutex);
+		if (slot->state == SLOT_RUNNING)
+		{
+			job_id = slot->job_id;
+			done = true;
+		}
+		else if (slot->state == SLOT_IDLE && timed_out)
+		{
+			/* The scheduler cannot assign a job to the worker anymore */
+			slot->state = SLOT_EXITED;
+			done = true;
+		}
+		else if (slot->state == SLOT_EXITED)
+			done = true;
+		SpinLockRelease(&slot->mutex);
+
+		if (done)
+			break;
+
+		/* An assigned job is handed over shortly, so do not time out meanwhile */
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 timed_out ? BGW_JOB_POOL_WAIT_INTERVAL :
+									 Min(BGW_JOB_POOL_WAIT_INTERVAL, pool->idle_timeout_ms),
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	return job_id;
+}
@@ -0,0 +1,30 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef BGW_JOB_POOL_H
+#define BGW_JOB_POOL_H
+
+#include <postgres.h>
+#include <storage/dsm.h>
+
+typedef struct BgwJobPool BgwJobPool;
+
+/* called by the scheduler */
+extern BgwJobPool *ts_bgw_job_pool_create(int num_slots, dsm_handle *handle);
+extern void ts_bgw_job_pool_set_idle_timeout(BgwJobPool *pool, int idle_timeout_ms);
+extern int ts_bgw_job_pool_assign_idle(BgwJobPool *pool, int32 job_id, Oid user_oid);
+extern void ts_bgw_job_pool_run_assigned(BgwJobPool *pool, int slot);
+extern void ts_bgw_job_pool_cancel_assigned(BgwJobPool *pool, int slot);
+extern int ts_bgw_job_pool_reserve_free(BgwJobPool *pool, int32 job_id, Oid user_oid);
+extern bool ts_bgw_job_pool_job_done(BgwJobPool *pool, int slot, int32 job_id);
+extern int ts_bgw_job_pool_evict_idle(BgwJobPool *pool);
+extern void ts_bgw_job_pool_shutdown(BgwJobPool *pool);
+extern void ts_bgw_job_pool_release(BgwJobPool *pool, int slot);
+
+/* called by the job workers */
+extern BgwJobPool *ts_bgw_job_pool_attach(dsm_handle handle);
+extern int32 ts_bgw_job_pool_wait_for_job(BgwJobPool *pool, int slot);
+
+#endif /* BGW_JOB_POOL_H */
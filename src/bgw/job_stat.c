@@ -5,12 +5,23 @@
  */
 #include <postgres.h>
 #include <access/xact.h>
+#include <miscadmin.h>
+#include <storage/lwlock.h>
 #include <utils/fmgrprotos.h>
 
 #include <stdlib.h>
 #include <math.h>
 
+#include "compat/compat.h"
+#if PG13_GE
+#include <common/hashfn.h>
+#else
+#include <utils/hashutils.h>
+#endif
+
+#include "guc.h"
 #include "job_stat.h"
+#include "loader/bgw_job_stat_pending.h"
 #include "scanner.h"
 #include "timer.h"
 #include "utils.h"
@@ -28,6 +39,136 @@ bgw_job_stat_next_start_was_set(FormData_bgw_job_stat *fd)
 	return fd->next_start != DT_NOBEGIN;
 }
 
+/*
+ * Pending statistics.
+ *
+ * With timescaledb.bgw_job_stat_pending_max_jobs, the end of a successful run
+ * is kept in shared memory instead of being written to the catalog, so that a
+ * run updates the job statistics table once instead of twice. The scheduler
+ * writes the pending statistics of its database in batches, see
+ * ts_bgw_job_stat_flush_pending, and every other write of the statistics of
+ * a job takes its pending statistics along. Starts, failures and crashes are
+ * always written right away. Since a run that is started but never ended
+ * counts as a crash, the runs whose pending end is lost in a server crash
+ * count as crashed, as they do when the scheduler is terminated.
+ */
+static BgwJobStatPendingRendezvous *
+bgw_job_stat_pending_get(void)
+{
+	static BgwJobStatPendingRendezvous *pending = NULL;
+
+	if (pending == NULL)
+		pending = *(BgwJobStatPendingRendezvous **) find_rendezvous_variable(
+			RENDEZVOUS_BGW_JOB_STAT_PENDING);
+
+	return pending;
+}
+
+/* Copy the pending statistics of a job into fd and optionally remove them */
+static bool
+bgw_job_stat_pending_fetch(int32 job_id, FormData_bgw_job_stat *fd, bool remove)
+{
+	BgwJobStatPendingRendezvous *pending = bgw_job_stat_pending_get();
+	BgwJobStatPendingKey key = { .database_id = MyDatabaseId, .job_id = job_id };
+	BgwJobStatPendingEntry *entry;
+
+	if (pending == NULL)
+		return false;
+
+	LWLockAcquire(pending->lock, remove ? LW_EXCLUSIVE : LW_SHARED);
+	entry = hash_search(pending->jobs, &key, HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		memcpy(fd, entry->data, sizeof(FormData_bgw_job_stat));
+		if (remove)
+			hash_search(pending->jobs, &key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(pending->lock);
+
+	return entry != NULL;
+}
+
+/* Returns false if there is no room for the statistics of another job */
+static bool
+bgw_job_stat_pending_store(const FormData_bgw_job_stat *fd)
+{
+	BgwJobStatPendingRendezvous *pending = bgw_job_stat_pending_get();
+	BgwJobStatPendingKey key = { .database_id = MyDatabaseId, .job_id = fd->id };
+	BgwJobStatPendingEntry *entry;
+
+	StaticAssertStmt(sizeof(FormData_bgw_job_stat) <= BGW_JOB_STAT_PENDING_DATA_SIZE,
+					 "job statistics do not fit into the pending statistics");
+
+	if (pending == NULL)
+		return false;
+
+	LWLockAcquire(pending->lock, LW_EXCLUSIVE);
+	entry = hash_search(pending->jobs, &key, HASH_ENTER_NULL, NULL);
+	if (entry != NULL)
+		memcpy(entry->data, fd, sizeof(FormData_bgw_job_stat));
+	LWLockRelease(pending->lock);
+
+	return entry != NULL;
+}
+
+/* Returns the ids of the jobs of this database with pending statistics */
+static List *
+bgw_job_stat_pending_jobs(void)
+{
+	BgwJobStatPendingRendezvous *pending = bgw_job_stat_pending_get();
+	HASH_SEQ_STATUS status;
+	BgwJobStatPendingEntry *entry;
+	List *job_ids = NIL;
+
+	if (pending == NULL)
+		return NIL;
+
+	LWLockAcquire(pending->lock, LW_SHARED);
+	hash_seq_init(&status, pending->jobs);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.database_id == MyDatabaseId)
+			job_ids = lappend_int(job_ids, entry->key.job_id);
+	}
+	LWLockRelease(pending->lock);
+
+	return job_ids;
+}
+
+TSDLLEXPORT bool
+ts_bgw_job_stat_has_pending(void)
+{
+	List *job_ids = bgw_job_stat_pending_jobs();
+	bool has_pending = job_ids != NIL;
+
+	list_free(job_ids);
+	return has_pending;
+}
+
+/*
+ * Copy the tuple of the statistics of a job for an update. The pending
+ * statistics of the job are applied and removed, since the update writes
+ * them.
+ */
+static HeapTuple
+bgw_job_stat_tuple_copy(TupleInfo *ti, bool *had_pending)
+{
+	bool should_free;
+	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+	HeapTuple new_tuple = heap_copytuple(tuple);
+	FormData_bgw_job_stat *fd = (FormData_bgw_job_stat *) GETSTRUCT(new_tuple);
+	bool found;
+
+	if (should_free)
+		heap_freetuple(tuple);
+
+	found = bgw_job_stat_pending_fetch(fd->id, fd, true);
+	if (had_pending != NULL)
+		*had_pending = found;
+
+	return new_tuple;
+}
+
 static ScanTupleResult
 bgw_job_stat_tuple_found(TupleInfo *ti, void *const data)
 {
@@ -94,12 +235,21 @@ ts_bgw_job_stat_find(int32 bgw_job_id)
 							 &job_stat,
 							 AccessShareLock);
 
+	if (job_stat != NULL)
+		bgw_job_stat_pending_fetch(bgw_job_id, &job_stat->fd, false);
+
 	return job_stat;
 }
 
 static ScanTupleResult
 bgw_job_stat_tuple_delete(TupleInfo *ti, void *const data)
 {
+	FormData_bgw_job_stat fd;
+	bool isnull;
+	Datum job_id = slot_getattr(ti->slot, Anum_bgw_job_stat_job_id, &isnull);
+
+	Assert(!isnull);
+	bgw_job_stat_pending_fetch(DatumGetInt32(job_id), &fd, true);
 	ts_catalog_delete_tid(ti->scanrel, ts_scanner_get_tuple_tid(ti));
 
 	return SCAN_CONTINUE;
@@ -125,14 +275,9 @@ ts_bgw_job_stat_delete(int32 bgw_job_id)
 static ScanTupleResult
 bgw_job_stat_tuple_mark_start(TupleInfo *ti, void *const data)
 {
-	bool should_free;
-	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
-	HeapTuple new_tuple = heap_copytuple(tuple);
+	HeapTuple new_tuple = bgw_job_stat_tuple_copy(ti, NULL);
 	FormData_bgw_job_stat *fd = (FormData_bgw_job_stat *) GETSTRUCT(new_tuple);
 
-	if (should_free)
-		heap_freetuple(tuple);
-
 	fd->last_start = ts_timer_get_current_timestamp();
 	fd->last_finish = DT_NOBEGIN;
 	fd->next_start = DT_NOBEGIN;
@@ -228,6 +373,45 @@ get_next_scheduled_execution_slot(BgwJob *job, TimestampTz finish_time)
 	return DatumGetTimestampTz(result);
 }
 
+/*
+ * Schedule spreading.
+ *
+ * Jobs that are created together with the same schedule interval start at
+ * the same time, every interval. With timescaledb.bgw_job_schedule_spread,
+ * the starts of a job are instead placed on a grid of its schedule interval,
+ * shifted by an offset that is derived from the job id. The offset is stable,
+ * so the jobs stay spread over the interval, and the next start can be
+ * recomputed at any time without moving the job.
+ */
+static int64
+job_schedule_period(const BgwJob *job)
+{
+	const Interval *interval = &job->fd.schedule_interval;
+
+	return interval->time +
+		   (interval->day + (int64) interval->month * DAYS_PER_MONTH) * USECS_PER_DAY;
+}
+
+/* Return the first start of the job on its grid at or after ts */
+static TimestampTz
+spread_start_at_or_after(const BgwJob *job, TimestampTz ts)
+{
+	int64 period = job_schedule_period(job);
+	int64 offset;
+	int64 rem;
+
+	if (period <= 0 || TIMESTAMP_NOT_FINITE(ts))
+		return ts;
+
+	offset = DatumGetUInt32(hash_uint32((uint32) job->fd.id)) % period;
+	rem = (ts - offset) % period;
+
+	if (rem < 0)
+		rem += period;
+
+	return rem == 0 ? ts : ts + (period - rem);
+}
+
 static TimestampTz
 calculate_next_start_on_success_fixed(TimestampTz finish_time, BgwJob *job)
 {
@@ -242,6 +426,14 @@ static TimestampTz
 calculate_next_start_on_success_drifting(TimestampTz last_finish, BgwJob *job)
 {
 	TimestampTz ts;
+
+	/*
+	 * Take the grid slot closest to one interval after the finish, so that
+	 * the job still runs once per interval on average
+	 */
+	if (ts_guc_bgw_job_schedule_spread)
+		return spread_start_at_or_after(job, last_finish + job_schedule_period(job) / 2);
+
 	ts = DatumGetTimestampTz(DirectFunctionCall2(timestamptz_pl_interval,
 												 TimestampTzGetDatum(last_finish),
 												 IntervalPGetDatum(&job->fd.schedule_interval)));
@@ -415,19 +607,11 @@ calculate_next_start_on_crash(int consecutive_crashes, BgwJob *job)
 	return failure_calc;
 }
 
-static ScanTupleResult
-bgw_job_stat_tuple_mark_end(TupleInfo *ti, void *const data)
+static void
+bgw_job_stat_apply_mark_end(FormData_bgw_job_stat *fd, JobResultCtx *result_ctx)
 {
-	JobResultCtx *result_ctx = data;
-	bool should_free;
-	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
-	HeapTuple new_tuple = heap_copytuple(tuple);
-	FormData_bgw_job_stat *fd = (FormData_bgw_job_stat *) GETSTRUCT(new_tuple);
 	Interval *duration;
 
-	if (should_free)
-		heap_freetuple(tuple);
-
 	fd->last_finish = ts_timer_get_current_timestamp();
 
 	duration = DatumGetIntervalP(DirectFunctionCall2(timestamp_mi,
@@ -475,24 +659,40 @@ bgw_job_stat_tuple_mark_end(TupleInfo *ti, void *const data)
 															 result_ctx->job,
 															 false);
 	}
+}
 
+static ScanTupleResult
+bgw_job_stat_tuple_mark_end(TupleInfo *ti, void *const data)
+{
+	HeapTuple new_tuple = bgw_job_stat_tuple_copy(ti, NULL);
+	FormData_bgw_job_stat *fd = (FormData_bgw_job_stat *) GETSTRUCT(new_tuple);
+
+	bgw_job_stat_apply_mark_end(fd, data);
 	ts_catalog_update(ti->scanrel, new_tuple);
 	heap_freetuple(new_tuple);
 
 	return SCAN_DONE;
 }
 
+static ScanTupleResult
+bgw_job_stat_tuple_flush_pending(TupleInfo *ti, void *const data)
+{
+	bool had_pending;
+	HeapTuple new_tuple = bgw_job_stat_tuple_copy(ti, &had_pending);
+
+	if (had_pending)
+		ts_catalog_update(ti->scanrel, new_tuple);
+	heap_freetuple(new_tuple);
+
+	return SCAN_DONE;
+}
+
 static ScanTupleResult
 bgw_job_stat_tuple_mark_crash_reported(TupleInfo *ti, void *const data)
 {
-	bool should_free;
-	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
-	HeapTuple new_tuple = heap_copytuple(tuple);
+	HeapTuple new_tuple = bgw_job_stat_tuple_copy(ti, NULL);
 	FormData_bgw_job_stat *fd = (FormData_bgw_job_stat *) GETSTRUCT(new_tuple);
 
-	if (should_free)
-		heap_freetuple(tuple);
-
 	fd->flags = ts_set_flags_32(fd->flags, LAST_CRASH_REPORTED);
 
 	ts_catalog_update(ti->scanrel, new_tuple);
@@ -505,14 +705,9 @@ static ScanTupleResult
 bgw_job_stat_tuple_set_next_start(TupleInfo *ti, void *const data)
 {
 	TimestampTz *next_start = data;
-	bool should_free;
-	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
-	HeapTuple new_tuple = heap_copytuple(tuple);
+	HeapTuple new_tuple = bgw_job_stat_tuple_copy(ti, NULL);
 	FormData_bgw_job_stat *fd = (FormData_bgw_job_stat *) GETSTRUCT(new_tuple);
 
-	if (should_free)
-		heap_freetuple(tuple);
-
 	fd->next_start = *next_start;
 	ts_catalog_update(ti->scanrel, new_tuple);
 	heap_freetuple(new_tuple);
@@ -604,6 +799,32 @@ ts_bgw_job_stat_mark_end(BgwJob *job, JobResult result)
 		.result = result,
 	};
 
+	/*
+	 * Keep the end of a successful run pending. The lock serializes with the
+	 * other writers of the statistics, which take the pending statistics
+	 * along once this transaction is done.
+	 */
+	if (result == JOB_SUCCESS && bgw_job_stat_pending_get() != NULL)
+	{
+		Relation rel = table_open(catalog_get_table_id(ts_catalog_get(), BGW_JOB_STAT),
+								  ShareRowExclusiveLock);
+		BgwJobStat *job_stat = ts_bgw_job_stat_find(job->fd.id);
+		bool stored;
+
+		if (job_stat == NULL)
+			elog(ERROR, "unable to find job statistics for job %d", job->fd.id);
+
+		bgw_job_stat_apply_mark_end(&job_stat->fd, &res);
+		stored = bgw_job_stat_pending_store(&job_stat->fd);
+		table_close(rel, NoLock);
+
+		if (stored)
+		{
+			pgstat_report_activity(STATE_IDLE, NULL);
+			return;
+		}
+	}
+
 	if (!bgw_job_stat_scan_job_id(job->fd.id,
 								  bgw_job_stat_tuple_mark_end,
 								  NULL,
@@ -625,6 +846,39 @@ ts_bgw_job_stat_mark_crash_reported(int32 bgw_job_id)
 	pgstat_report_activity(STATE_IDLE, NULL);
 }
 
+/*
+ * Write the pending statistics of the jobs of this database to the catalog.
+ * The statistics of deleted jobs are dropped.
+ */
+TSDLLEXPORT void
+ts_bgw_job_stat_flush_pending(void)
+{
+	List *job_ids = bgw_job_stat_pending_jobs();
+	Relation rel;
+	ListCell *lc;
+
+	if (job_ids == NIL)
+		return;
+
+	rel = table_open(catalog_get_table_id(ts_catalog_get(), BGW_JOB_STAT), ShareRowExclusiveLock);
+
+	foreach (lc, job_ids)
+	{
+		FormData_bgw_job_stat fd;
+		int32 job_id = lfirst_int(lc);
+
+		if (!bgw_job_stat_scan_job_id(job_id,
+									  bgw_job_stat_tuple_flush_pending,
+									  NULL,
+									  NULL,
+									  RowExclusiveLock))
+			bgw_job_stat_pending_fetch(job_id, &fd, true);
+	}
+
+	table_close(rel, NoLock);
+	list_free(job_ids);
+}
+
 bool
 ts_bgw_job_stat_end_was_marked(BgwJobStat *jobstat)
 {
@@ -703,8 +957,14 @@ ts_bgw_job_stat_next_start(BgwJobStat *jobstat, BgwJob *job, int32 consecutive_f
 	if (consecutive_failed_launches > 0)
 		return calculate_next_start_on_failed_launch(consecutive_failed_launches, job);
 	if (jobstat == NULL)
+	{
+		/* Never previously run - run at the first slot of the job */
+		if (ts_guc_bgw_job_schedule_spread)
+			return spread_start_at_or_after(job, ts_timer_get_current_timestamp());
+
 		/* Never previously run - run right away */
 		return DT_NOBEGIN;
+	}
 
 	if (jobstat->fd.consecutive_crashes > 0)
 	{
@@ -30,6 +30,8 @@ extern void ts_bgw_job_stat_delete(int job_id);
 extern TSDLLEXPORT void ts_bgw_job_stat_mark_start(int32 bgw_job_id);
 extern void ts_bgw_job_stat_mark_end(BgwJob *job, JobResult result);
 extern bool ts_bgw_job_stat_end_was_marked(BgwJobStat *jobstat);
+extern TSDLLEXPORT bool ts_bgw_job_stat_has_pending(void);
+extern TSDLLEXPORT void ts_bgw_job_stat_flush_pending(void);
 
 extern TSDLLEXPORT void ts_bgw_job_stat_set_next_start(int32 job_id, TimestampTz next_start);
 extern TSDLLEXPORT bool ts_bgw_job_stat_update_next_start(int32 job_id, TimestampTz next_start,
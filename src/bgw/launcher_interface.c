@@ -6,10 +6,15 @@
 #include <postgres.h>
 
 #include <fmgr.h>
+#include <miscadmin.h>
+#include <storage/latch.h>
+#include <storage/spin.h>
+#include <utils/timestamp.h>
 
 #include "extension.h"
 #include "launcher_interface.h"
 #include "compat/compat.h"
+#include "loader/bgw_scheduler_wakeup.h"
 
 #define MIN_LOADER_API_VERSION 3
 
@@ -61,3 +66,96 @@ ts_bgw_check_loader_api_version()
 				 errmsg("loader version out-of-date"),
 				 errhint("Please restart the database to upgrade the loader version.")));
 }
+
+/*
+ * The queue of requests to the launcher to start schedulers, only available
+ * when timescaledb.bgw_scheduler_idle_exit_time is set.
+ */
+static BgwSchedulerWakeupRendezvous *
+bgw_scheduler_wakeup_get(void)
+{
+	static BgwSchedulerWakeupRendezvous *wakeup = NULL;
+
+	if (wakeup == NULL)
+		wakeup = *(BgwSchedulerWakeupRendezvous **) find_rendezvous_variable(
+			RENDEZVOUS_BGW_SCHEDULER_WAKEUP);
+
+	return wakeup;
+}
+
+/*
+ * The time in ms without due jobs after which the scheduler exits, or 0 if
+ * the scheduler keeps running.
+ */
+extern int
+ts_bgw_scheduler_idle_exit_time(void)
+{
+	BgwSchedulerWakeupRendezvous *wakeup = bgw_scheduler_wakeup_get();
+
+	return wakeup != NULL ? wakeup->idle_exit_time_ms : 0;
+}
+
+/*
+ * Ask the launcher to start the scheduler of the database at the wakeup time,
+ * either because the scheduler exits or because the jobs of the database
+ * changed. Returns false if the request couldn't be queued.
+ */
+extern bool
+ts_bgw_scheduler_request_wakeup(Oid db_oid, TimestampTz wakeup, bool idle_exit)
+{
+	BgwSchedulerWakeupRendezvous *rendezvous = bgw_scheduler_wakeup_get();
+	BgwSchedulerWakeupQueue *queue;
+	Latch *launcher_latch;
+	bool queued = false;
+
+	if (rendezvous == NULL)
+		return false;
+
+	queue = rendezvous->queue;
+	SpinLockAcquire(&queue->mutex);
+	if (queue->num_requests < rendezvous->max_requests)
+	{
+		BgwSchedulerWakeup *request = &queue->requests[queue->num_requests++];
+
+		request->db_oid = db_oid;
+		request->wakeup = wakeup;
+		request->idle_exit = idle_exit;
+		queued = true;
+	}
+	else if (!idle_exit)
+	{
+		/* The launcher starts all the exited schedulers instead */
+		queue->overflow = true;
+	}
+	launcher_latch = queue->launcher_latch;
+	SpinLockRelease(&queue->mutex);
+
+	if (launcher_latch != NULL)
+		SetLatch(launcher_latch);
+
+	return queued;
+}
+
+/* The current transaction changed the jobs of the database */
+static bool jobs_changed = false;
+
+/*
+ * Remember that the jobs changed, so that the scheduler of the database is
+ * started when the transaction commits, in case it exited because no job was
+ * due.
+ */
+extern void
+ts_bgw_scheduler_jobs_changed(void)
+{
+	if (bgw_scheduler_wakeup_get() != NULL)
+		jobs_changed = true;
+}
+
+extern void
+ts_bgw_scheduler_xact_end(bool commit)
+{
+	if (jobs_changed && commit)
+		(void) ts_bgw_scheduler_request_wakeup(MyDatabaseId, GetCurrentTimestamp(), false);
+
+	jobs_changed = false;
+}
@@ -7,10 +7,15 @@
 #define TIMESCALEDB_BGW_LAUNCHER_INTERFACE_H
 
 #include <postgres.h>
+#include <datatype/timestamp.h>
 
 extern bool ts_bgw_worker_reserve(void);
 extern void ts_bgw_worker_release(void);
 extern int ts_bgw_num_unreserved(void);
 extern int ts_bgw_loader_api_version(void);
 extern void ts_bgw_check_loader_api_version(void);
+extern int ts_bgw_scheduler_idle_exit_time(void);
+extern bool ts_bgw_scheduler_request_wakeup(Oid db_oid, TimestampTz wakeup, bool idle_exit);
+extern void ts_bgw_scheduler_jobs_changed(void);
+extern void ts_bgw_scheduler_xact_end(bool commit);
 #endif /* TIMESCALEDB_BGW_LAUNCHER_INTERFACE_H */
@@ -12,6 +12,7 @@
  */
 #include <postgres.h>
 
+#include <lib/binaryheap.h>
 #include <miscadmin.h>
 #include <postmaster/bgworker.h>
 #include <storage/ipc.h>
@@ -34,7 +35,9 @@
 #include "extension.h"
 #include "guc.h"
 #include "job.h"
+#include "job_pool.h"
 #include "job_stat.h"
+#include "jsonb_utils.h"
 #include "launcher_interface.h"
 #include "scheduler.h"
 #include "timer.h"
@@ -107,12 +110,257 @@ typedef struct ScheduledBgwJob
 	 */
 	bool may_need_mark_end;
 	int32 consecutive_failed_launches;
+
+	/* Sequence numbers of the latest entries in the job queues */
+	uint32 start_seq;
+	uint32 timeout_seq;
+	/* Whether the job is in the list of running jobs */
+	bool running;
+
+	/*
+	 * Whether the job runs in a worker of the job pool, in which case the
+	 * handle and the worker reservation belong to the pool slot
+	 */
+	bool pooled;
+	int pool_slot;
 } ScheduledBgwJob;
 
+/*
+ * Job queues.
+ *
+ * Instead of sorting and scanning all the scheduled jobs on every iteration
+ * of the main loop, the scheduler keeps the jobs to start in a min-heap
+ * ordered on next_start and the started jobs in a min-heap ordered on
+ * timeout_at. A job is added to a queue on the state transition that sets
+ * the deadline, so finding the next job to start or to time out is
+ * O(log n) in the number of jobs.
+ *
+ * Entries are not removed from the middle of a heap. Instead, each entry
+ * records the sequence number of the job at the time it was added, and an
+ * entry is stale, and skipped when it reaches the top, if the job has been
+ * queued again since or is no longer in the state for the queue. When a heap
+ * fills up with stale entries, the queues are rebuilt from the job list.
+ *
+ * The jobs that have a background worker are kept in a separate list so that
+ * checking for stopped workers does not scan all jobs. The queues and the
+ * list are rebuilt whenever the job list is reloaded from the catalog, since
+ * the jobs are copied to a new list then.
+ */
+typedef struct JobQueueEntry
+{
+	ScheduledBgwJob *sjob;
+	TimestampTz deadline;
+	uint32 seq;
+} JobQueueEntry;
+
+static MemoryContext job_queue_mctx;
+static binaryheap *start_queue = NULL;
+static binaryheap *timeout_queue = NULL;
+static List *running_jobs = NIL;
+
+/*
+ * Job pool.
+ *
+ * When timescaledb.bgw_job_worker_idle_timeout is set, the workers of the
+ * jobs wait for the next job of the same owner when they are done, and the
+ * scheduler hands due jobs to them instead of starting a new worker. The
+ * scheduler keeps the handle and the worker reservation of each pool worker
+ * until the worker has stopped. See job_pool.c.
+ */
+typedef struct PoolWorker
+{
+	BackgroundWorkerHandle *handle;
+} PoolWorker;
+
+static BgwJobPool *job_pool = NULL;
+static dsm_handle job_pool_handle;
+static PoolWorker *pool_workers = NULL;
+static int pool_num_slots = 0;
+
 static void on_failure_to_start_job(ScheduledBgwJob *sjob);
+static inline void bgw_scheduler_on_postmaster_death(void);
+static void job_queues_build(void);
 
 static volatile sig_atomic_t got_SIGHUP = false;
 
+/* Order the entries on the earliest deadline first, and then on job id */
+static int
+job_queue_entry_cmp(Datum a, Datum b, void *arg)
+{
+	const JobQueueEntry *left = (const JobQueueEntry *) DatumGetPointer(a);
+	const JobQueueEntry *right = (const JobQueueEntry *) DatumGetPointer(b);
+
+	/* binaryheap keeps the greatest element first */
+	if (left->deadline != right->deadline)
+		return left->deadline < right->deadline ? 1 : -1;
+
+	if (left->sjob->job.fd.id != right->sjob->job.fd.id)
+		return left->sjob->job.fd.id < right->sjob->job.fd.id ? 1 : -1;
+
+	return 0;
+}
+
+static bool
+job_queue_entry_is_valid(const binaryheap *queue, const JobQueueEntry *entry)
+{
+	const ScheduledBgwJob *sjob = entry->sjob;
+
+	if (queue == start_queue)
+		return entry->seq == sjob->start_seq && sjob->state == JOB_STATE_SCHEDULED;
+
+	return entry->seq == sjob->timeout_seq && sjob->state == JOB_STATE_STARTED;
+}
+
+static void
+job_queue_add_entry(binaryheap *queue, ScheduledBgwJob *sjob, TimestampTz deadline, uint32 seq,
+					bool unordered)
+{
+	JobQueueEntry *entry = MemoryContextAlloc(job_queue_mctx, sizeof(JobQueueEntry));
+
+	entry->sjob = sjob;
+	entry->deadline = deadline;
+	entry->seq = seq;
+
+	if (unordered)
+		binaryheap_add_unordered(queue, PointerGetDatum(entry));
+	else
+		binaryheap_add(queue, PointerGetDatum(entry));
+}
+
+/*
+ * Queue a job to be started at next_start or to be terminated at
+ * timeout_at. Jobs without a deadline are not queued. The queues are not
+ * kept outside of the scheduler main loop, e.g., when the job list is
+ * reloaded.
+ */
+static void
+job_queue_push(binaryheap **queue, ScheduledBgwJob *sjob, TimestampTz deadline)
+{
+	uint32 seq;
+
+	if (*queue == NULL || TIMESTAMP_IS_NOEND(deadline))
+		return;
+
+	/* Drop the stale entries, which makes room for all the jobs */
+	if ((*queue)->bh_size >= (*queue)->bh_space)
+		job_queues_build();
+
+	seq = (*queue == start_queue) ? ++sjob->start_seq : ++sjob->timeout_seq;
+	job_queue_add_entry(*queue, sjob, deadline, seq, false);
+}
+
+/* Return the first valid entry of a queue, dropping stale entries on the way */
+static JobQueueEntry *
+job_queue_first(binaryheap *queue)
+{
+	while (queue != NULL && !binaryheap_empty(queue))
+	{
+		JobQueueEntry *entry = (JobQueueEntry *) DatumGetPointer(binaryheap_first(queue));
+
+		if (job_queue_entry_is_valid(queue, entry))
+			return entry;
+
+		(void) binaryheap_remove_first(queue);
+		pfree(entry);
+	}
+
+	return NULL;
+}
+
+static void
+job_set_running(ScheduledBgwJob *sjob, bool running)
+{
+	MemoryContext oldmctx;
+
+	if (job_queue_mctx == NULL || start_queue == NULL || sjob->running == running)
+		return;
+
+	oldmctx = MemoryContextSwitchTo(job_queue_mctx);
+	if (running)
+		running_jobs = lappend(running_jobs, sjob);
+	else
+		running_jobs = list_delete_ptr(running_jobs, sjob);
+	MemoryContextSwitchTo(oldmctx);
+
+	sjob->running = running;
+}
+
+/* Stop maintaining the queues, e.g., while the jobs are copied to a new list */
+static void
+job_queues_reset(void)
+{
+	ListCell *lc;
+
+	if (job_queue_mctx != NULL)
+		MemoryContextReset(job_queue_mctx);
+
+	start_queue = NULL;
+	timeout_queue = NULL;
+	running_jobs = NIL;
+
+	foreach (lc, scheduled_jobs)
+	{
+		ScheduledBgwJob *sjob = lfirst(lc);
+
+		sjob->running = false;
+	}
+}
+
+/* Build the queues and the list of running jobs from the job list */
+static void
+job_queues_build(void)
+{
+	MemoryContext oldmctx;
+	ListCell *lc;
+	int capacity;
+
+	job_queues_reset();
+
+	if (job_queue_mctx == NULL)
+		return;
+
+	/* Leave room for stale entries so that the queues are rarely rebuilt */
+	capacity = 2 * list_length(scheduled_jobs) + 16;
+	oldmctx = MemoryContextSwitchTo(job_queue_mctx);
+	start_queue = binaryheap_allocate(capacity, job_queue_entry_cmp, NULL);
+	timeout_queue = binaryheap_allocate(capacity, job_queue_entry_cmp, NULL);
+	MemoryContextSwitchTo(oldmctx);
+
+	foreach (lc, scheduled_jobs)
+	{
+		ScheduledBgwJob *sjob = lfirst(lc);
+
+		switch (sjob->state)
+		{
+			case JOB_STATE_SCHEDULED:
+				if (!TIMESTAMP_IS_NOEND(sjob->next_start))
+					job_queue_add_entry(start_queue,
+										sjob,
+										sjob->next_start,
+										++sjob->start_seq,
+										true);
+				break;
+			case JOB_STATE_STARTED:
+				if (!TIMESTAMP_IS_NOEND(sjob->timeout_at))
+					job_queue_add_entry(timeout_queue,
+										sjob,
+										sjob->timeout_at,
+										++sjob->timeout_seq,
+										true);
+				job_set_running(sjob, true);
+				break;
+			case JOB_STATE_TERMINATING:
+				job_set_running(sjob, true);
+				break;
+			case JOB_STATE_DISABLED:
+				break;
+		}
+	}
+
+	binaryheap_build(start_queue);
+	binaryheap_build(timeout_queue);
+}
+
 BackgroundWorkerHandle *
 ts_bgw_start_worker(const char *name, const BgwParams *bgw_params)
 {
@@ -143,6 +391,105 @@ ts_bgw_start_worker(const char *name, const BgwParams *bgw_params)
 	return handle;
 }
 
+/* Return the job pool, creating it on first use, or NULL if it is disabled */
+static BgwJobPool *
+job_pool_get(void)
+{
+	if (ts_guc_bgw_job_worker_idle_timeout <= 0)
+		return NULL;
+
+	if (job_pool == NULL)
+	{
+		pool_num_slots = max_worker_processes;
+		job_pool = ts_bgw_job_pool_create(pool_num_slots, &job_pool_handle);
+		pool_workers = MemoryContextAllocZero(scheduler_mctx, sizeof(PoolWorker) * pool_num_slots);
+	}
+
+	ts_bgw_job_pool_set_idle_timeout(job_pool, ts_guc_bgw_job_worker_idle_timeout);
+	return job_pool;
+}
+
+/*
+ * Start a worker for the job. With the job pool enabled, the worker is
+ * started in a free pool slot, which takes over the worker reservation of the
+ * job since the worker outlives the job.
+ */
+static BackgroundWorkerHandle *
+job_start_worker(ScheduledBgwJob *sjob, Oid owner_uid)
+{
+	BgwJobPool *pool = job_pool_get();
+	BackgroundWorkerHandle *handle;
+	int slot = -1;
+
+	if (pool != NULL)
+		slot = ts_bgw_job_pool_reserve_free(pool, sjob->job.fd.id, owner_uid);
+
+	if (slot < 0)
+		return ts_bgw_job_start(&sjob->job, owner_uid);
+
+	handle = ts_bgw_job_start_pooled(&sjob->job, owner_uid, job_pool_handle, slot);
+
+	if (handle == NULL)
+	{
+		ts_bgw_job_pool_release(pool, slot);
+		return NULL;
+	}
+
+	pool_workers[slot].handle = handle;
+	sjob->reserved_worker = false;
+	sjob->pooled = true;
+	sjob->pool_slot = slot;
+	return handle;
+}
+
+/* Free the slots of the pool workers that have stopped */
+static void
+job_pool_reap_stopped_workers(void)
+{
+	for (int i = 0; i < pool_num_slots; i++)
+	{
+		PoolWorker *worker = &pool_workers[i];
+		pid_t pid;
+
+		if (worker->handle == NULL)
+			continue;
+
+		switch (GetBackgroundWorkerPid(worker->handle, &pid))
+		{
+			case BGWH_POSTMASTER_DIED:
+				bgw_scheduler_on_postmaster_death();
+				break;
+			case BGWH_STOPPED:
+				pfree(worker->handle);
+				worker->handle = NULL;
+				ts_bgw_worker_release();
+				ts_bgw_job_pool_release(job_pool, i);
+				break;
+			case BGWH_NOT_YET_STARTED:
+			case BGWH_STARTED:
+				break;
+		}
+	}
+}
+
+/*
+ * Terminate an idle pool worker so that its background worker becomes
+ * available once it has been reaped.
+ */
+static void
+job_pool_evict_idle_worker(void)
+{
+	int slot;
+
+	if (job_pool == NULL)
+		return;
+
+	slot = ts_bgw_job_pool_evict_idle(job_pool);
+
+	if (slot >= 0)
+		TerminateBackgroundWorker(pool_workers[slot].handle);
+}
+
 #ifdef USE_ASSERT_CHECKING
 static void
 assert_that_worker_has_stopped(ScheduledBgwJob *sjob)
@@ -180,7 +527,14 @@ worker_state_cleanup(ScheduledBgwJob *sjob)
 	 * This function needs to be safe wrt failures occurring at any point in
 	 * the job starting process.
 	 */
-	if (sjob->handle != NULL)
+	if (sjob->pooled)
+	{
+		/* The worker stays in the pool, which keeps the handle and the reservation */
+		sjob->handle = NULL;
+		sjob->pooled = false;
+		sjob->pool_slot = 0;
+	}
+	else if (sjob->handle != NULL)
 	{
 #ifdef USE_ASSERT_CHECKING
 		/* Sanity check: worker has stopped (if it was started) */
@@ -252,6 +606,7 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 
 	BgwJobStat *job_stat;
 	Oid owner_uid;
+	int pool_slot = -1;
 
 	switch (new_state)
 	{
@@ -269,6 +624,7 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 			Assert(!sjob->reserved_worker);
 			sjob->next_start =
 				ts_bgw_job_stat_next_start(job_stat, &sjob->job, sjob->consecutive_failed_launches);
+			job_queue_push(&start_queue, sjob, sjob->next_start);
 			break;
 		case JOB_STATE_STARTED:
 			Assert(prev_state == JOB_STATE_SCHEDULED);
@@ -288,14 +644,24 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 				return;
 			}
 
+			owner_uid = get_role_oid(NameStr(sjob->job.fd.owner), false);
+
+			/* An idle worker of the pool needs no new background worker */
+			if (job_pool_get() != NULL)
+				pool_slot = ts_bgw_job_pool_assign_idle(job_pool, sjob->job.fd.id, owner_uid);
+
 			/* If we are unable to reserve a worker go back to the scheduled state */
-			sjob->reserved_worker = ts_bgw_worker_reserve();
-			if (!sjob->reserved_worker)
+			if (pool_slot < 0)
+				sjob->reserved_worker = ts_bgw_worker_reserve();
+
+			if (pool_slot < 0 && !sjob->reserved_worker)
 			{
 				elog(WARNING,
 					 "failed to launch job %d \"%s\": out of background workers",
 					 sjob->job.fd.id,
 					 NameStr(sjob->job.fd.application_name));
+				/* Idle pool workers of other users hold on to background workers */
+				job_pool_evict_idle_worker();
 				sjob->consecutive_failed_launches++;
 				scheduled_bgw_job_transition_state_to(sjob, JOB_STATE_SCHEDULED);
 				CommitTransactionCommand();
@@ -313,8 +679,8 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 					ts_bgw_job_timeout_at(&sjob->job, ts_timer_get_current_timestamp());
 			else
 				sjob->timeout_at = DT_NOEND;
+			job_queue_push(&timeout_queue, sjob, sjob->timeout_at);
 
-			owner_uid = get_role_oid(NameStr(sjob->job.fd.owner), false);
 			CommitTransactionCommand();
 			MemoryContextSwitchTo(scratch_mctx);
 
@@ -323,7 +689,16 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 				 sjob->job.fd.id,
 				 NameStr(sjob->job.fd.application_name));
 
-			sjob->handle = ts_bgw_job_start(&sjob->job, owner_uid);
+			if (pool_slot >= 0)
+			{
+				/* The job is marked as started, so hand it to the worker */
+				sjob->pooled = true;
+				sjob->pool_slot = pool_slot;
+				sjob->handle = pool_workers[pool_slot].handle;
+				ts_bgw_job_pool_run_assigned(job_pool, pool_slot);
+			}
+			else
+				sjob->handle = job_start_worker(sjob, owner_uid);
 			if (sjob->handle == NULL)
 			{
 				elog(WARNING,
@@ -333,16 +708,17 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 				on_failure_to_start_job(sjob);
 				return;
 			}
-			Assert(sjob->reserved_worker);
+			Assert(sjob->reserved_worker || sjob->pooled);
 			break;
 		case JOB_STATE_TERMINATING:
 			Assert(prev_state == JOB_STATE_STARTED);
 			Assert(sjob->handle != NULL);
-			Assert(sjob->reserved_worker);
+			Assert(sjob->reserved_worker || sjob->pooled);
 			TerminateBackgroundWorker(sjob->handle);
 			break;
 	}
 	sjob->state = new_state;
+	job_set_running(sjob, new_state == JOB_STATE_STARTED || new_state == JOB_STATE_TERMINATING);
 }
 
 static void
@@ -543,78 +919,169 @@ ts_populate_scheduled_job_tuple(ScheduledBgwJob *sjob, Datum *values)
 
 static int
 #if PG13_LT
-cmp_next_start(const void *left, const void *right)
+cmp_job_id(const void *left, const void *right)
 {
 	const ListCell *left_cell = *((ListCell **) left);
 	const ListCell *right_cell = *((ListCell **) right);
 #else
-cmp_next_start(const ListCell *left_cell, const ListCell *right_cell)
+cmp_job_id(const ListCell *left_cell, const ListCell *right_cell)
 {
 #endif
 	ScheduledBgwJob *left_sjob = lfirst(left_cell);
 	ScheduledBgwJob *right_sjob = lfirst(right_cell);
 
-	if (left_sjob->next_start < right_sjob->next_start)
+	if (left_sjob->job.fd.id < right_sjob->job.fd.id)
 		return -1;
 
-	if (left_sjob->next_start > right_sjob->next_start)
+	if (left_sjob->job.fd.id > right_sjob->job.fd.id)
 		return 1;
 
 	return 0;
 }
 
+/*
+ * Get the concurrency class of the job and the number of jobs of the class
+ * that may run at a time. Returns NULL if the job is not in a class.
+ */
+static const char *
+job_concurrency_class(const BgwJob *job, int32 *max_concurrency)
+{
+	char *concurrency_class;
+	bool found;
+
+	if (job->fd.config == NULL || !JB_ROOT_IS_OBJECT(job->fd.config))
+		return NULL;
+
+	concurrency_class = ts_jsonb_get_str_field(job->fd.config, BGW_JOB_CONFIG_CONCURRENCY_CLASS);
+
+	if (concurrency_class == NULL)
+		return NULL;
+
+	*max_concurrency =
+		ts_jsonb_get_int32_field(job->fd.config, BGW_JOB_CONFIG_MAX_CONCURRENCY, &found);
+
+	/* Without a valid limit the class does not restrict the job */
+	if (!found || *max_concurrency < 1)
+		return NULL;
+
+	return concurrency_class;
+}
+
+/* Check if the concurrency class of the job has room for one more running job */
+static bool
+job_concurrency_class_has_room(const ScheduledBgwJob *sjob)
+{
+	const char *concurrency_class;
+	int32 max_concurrency;
+	int32 num_running = 0;
+	ListCell *lc;
+
+	concurrency_class = job_concurrency_class(&sjob->job, &max_concurrency);
+
+	if (concurrency_class == NULL)
+		return true;
+
+	foreach (lc, running_jobs)
+	{
+		const ScheduledBgwJob *other = lfirst(lc);
+		const char *other_class;
+		int32 other_max;
+
+		other_class = job_concurrency_class(&other->job, &other_max);
+
+		if (other_class != NULL && strcmp(other_class, concurrency_class) == 0)
+			num_running++;
+	}
+
+	return num_running < max_concurrency;
+}
+
 static void
 start_scheduled_jobs(register_background_worker_callback_type bgw_register)
 {
-	List *ordered_scheduled_jobs;
+	List *due_jobs = NIL;
+	List *deferred_jobs = NIL;
+	JobQueueEntry *entry;
 	ListCell *lc;
 	Assert(CurrentMemoryContext == scratch_mctx);
 
-	/* Order jobs by increasing next_start */
-#if PG13_LT
-	ordered_scheduled_jobs = list_qsort(scheduled_jobs, cmp_next_start);
-#else
-	/* PG13 does in-place sort */
-	ordered_scheduled_jobs = scheduled_jobs;
-	list_sort(ordered_scheduled_jobs, cmp_next_start);
-#endif
+	/*
+	 * Take the jobs to start, by increasing next_start, off the queue before
+	 * starting any of them, since a job that fails to start is queued again
+	 */
+	while ((entry = job_queue_first(start_queue)) != NULL &&
+		   entry->deadline <= ts_timer_get_current_timestamp())
+	{
+		due_jobs = lappend(due_jobs, entry->sjob);
+		(void) binaryheap_remove_first(start_queue);
+		pfree(entry);
+	}
+
+	foreach (lc, due_jobs)
+	{
+		ScheduledBgwJob *sjob = lfirst(lc);
+
+		if (sjob->state != JOB_STATE_SCHEDULED)
+			continue;
+
+		/* Wait for a running job of the concurrency class to finish */
+		if (!job_concurrency_class_has_room(sjob))
+		{
+			elog(DEBUG1,
+				 "deferring job %d \"%s\": concurrency class is full",
+				 sjob->job.fd.id,
+				 NameStr(sjob->job.fd.application_name));
+			deferred_jobs = lappend(deferred_jobs, sjob);
+			continue;
+		}
+
+		scheduled_ts_bgw_job_start(sjob, bgw_register);
+	}
 
-	foreach (lc, ordered_scheduled_jobs)
+	/*
+	 * Queue the deferred jobs again with their original next_start, so that
+	 * they keep their priority and are retried when the scheduler wakes up
+	 */
+	foreach (lc, deferred_jobs)
 	{
 		ScheduledBgwJob *sjob = lfirst(lc);
 
-		if (sjob->state == JOB_STATE_SCHEDULED &&
-			sjob->next_start <= ts_timer_get_current_timestamp())
-			scheduled_ts_bgw_job_start(sjob, bgw_register);
+		if (sjob->state == JOB_STATE_SCHEDULED)
+			job_queue_push(&start_queue, sjob, sjob->next_start);
 	}
 
-#if PG13_LT
-	list_free(ordered_scheduled_jobs);
-#endif
+	list_free(due_jobs);
+	list_free(deferred_jobs);
 }
 
 /* Returns the earliest time the scheduler should start a job that is waiting to be started */
 static TimestampTz
 earliest_wakeup_to_start_next_job()
 {
+	List *retry_entries = NIL;
+	JobQueueEntry *entry;
 	ListCell *lc;
 	TimestampTz earliest = DT_NOEND;
 	TimestampTz now = ts_timer_get_current_timestamp();
 
-	foreach (lc, scheduled_jobs)
+	/* if the start is less than now, this means we tried and failed to start it already, so
+	 * use the retry period */
+	while ((entry = job_queue_first(start_queue)) != NULL && entry->deadline < now)
 	{
-		ScheduledBgwJob *sjob = lfirst(lc);
-
-		if (sjob->state == JOB_STATE_SCHEDULED)
-		{
-			TimestampTz start = sjob->next_start;
-			/* if the start is less than now, this means we tried and failed to start it already, so
-			 * use the retry period */
-			if (start < now)
-				start = TimestampTzPlusMilliseconds(now, START_RETRY_MS);
-			earliest = least_timestamp(earliest, start);
-		}
+		retry_entries = lappend(retry_entries, entry);
+		(void) binaryheap_remove_first(start_queue);
 	}
+
+	if (entry != NULL)
+		earliest = entry->deadline;
+
+	if (retry_entries != NIL)
+		earliest = least_timestamp(earliest, TimestampTzPlusMilliseconds(now, START_RETRY_MS));
+
+	foreach (lc, retry_entries)
+		binaryheap_add(start_queue, PointerGetDatum(lfirst(lc)));
+
+	list_free(retry_entries);
 	return earliest;
 }
 
@@ -622,17 +1089,73 @@ earliest_wakeup_to_start_next_job()
 static TimestampTz
 earliest_job_timeout()
 {
+	JobQueueEntry *entry = job_queue_first(timeout_queue);
+
+	return entry != NULL ? entry->deadline : DT_NOEND;
+}
+
+/*
+ * With timescaledb.bgw_scheduler_idle_exit_time, the scheduler exits when no
+ * job is running and no job is due within that time, after asking the
+ * launcher to start it again when the next job is due. This way the databases
+ * without due jobs don't occupy background workers. The schedulers that the
+ * tests run for a fixed time never exit early.
+ */
+static bool
+scheduler_should_exit_idle(int32 run_for_interval_ms, TimestampTz next_wakeup)
+{
+	int idle_exit_time = ts_bgw_scheduler_idle_exit_time();
+	TimestampTz now = ts_timer_get_current_timestamp();
 	ListCell *lc;
-	TimestampTz earliest = DT_NOEND;
+
+	if (idle_exit_time <= 0 || run_for_interval_ms > 0 || jobs_list_needs_update)
+		return false;
+
+	if (next_wakeup < TimestampTzPlusMilliseconds(now, idle_exit_time))
+		return false;
 
 	foreach (lc, scheduled_jobs)
 	{
 		ScheduledBgwJob *sjob = lfirst(lc);
 
-		if (sjob->state == JOB_STATE_STARTED)
-			earliest = least_timestamp(earliest, sjob->timeout_at);
+		if (sjob->state == JOB_STATE_STARTED || sjob->state == JOB_STATE_TERMINATING)
+			return false;
 	}
-	return earliest;
+
+	return ts_bgw_scheduler_request_wakeup(MyDatabaseId, next_wakeup, true);
+}
+
+/*
+ * Write the pending job statistics of this database to the catalog once the
+ * flush interval has passed since the last write, or right away with force.
+ */
+static TimestampTz last_job_stat_flush = DT_NOBEGIN;
+
+static TimestampTz
+next_job_stat_flush(void)
+{
+	if (!ts_bgw_job_stat_has_pending())
+		return DT_NOEND;
+
+	if (TIMESTAMP_IS_NOBEGIN(last_job_stat_flush))
+		return ts_timer_get_current_timestamp();
+
+	return TimestampTzPlusMilliseconds(last_job_stat_flush, ts_guc_bgw_job_stat_flush_interval);
+}
+
+static void
+flush_pending_job_stats(bool force)
+{
+	TimestampTz now = ts_timer_get_current_timestamp();
+
+	if (!force && next_job_stat_flush() > now)
+		return;
+
+	StartTransactionCommand();
+	ts_bgw_job_stat_flush_pending();
+	CommitTransactionCommand();
+	MemoryContextSwitchTo(scratch_mctx);
+	last_job_stat_flush = now;
 }
 
 /* Special exit function only used in shmem_exit_callback.
@@ -664,6 +1187,16 @@ terminate_all_jobs_and_release_workers()
 			sjob->reserved_worker = false;
 		}
 	}
+
+	for (int i = 0; i < pool_num_slots; i++)
+	{
+		if (pool_workers[i].handle != NULL)
+		{
+			TerminateBackgroundWorker(pool_workers[i].handle);
+			pool_workers[i].handle = NULL;
+			ts_bgw_worker_release();
+		}
+	}
 }
 
 static void
@@ -671,21 +1204,55 @@ wait_for_all_jobs_to_shutdown()
 {
 	ListCell *lc;
 
+	/* Pool workers exit when their job is done instead of waiting for more */
+	if (job_pool != NULL)
+		ts_bgw_job_pool_shutdown(job_pool);
+
 	foreach (lc, scheduled_jobs)
 	{
 		ScheduledBgwJob *sjob = lfirst(lc);
 
-		if (sjob->state == JOB_STATE_STARTED || sjob->state == JOB_STATE_TERMINATING)
+		if ((sjob->state == JOB_STATE_STARTED || sjob->state == JOB_STATE_TERMINATING) &&
+			!sjob->pooled)
 			WaitForBackgroundWorkerShutdown(sjob->handle);
 	}
+
+	for (int i = 0; i < pool_num_slots; i++)
+	{
+		if (pool_workers[i].handle != NULL)
+			WaitForBackgroundWorkerShutdown(pool_workers[i].handle);
+	}
 }
 
 static void
 check_for_stopped_and_timed_out_jobs()
 {
+	List *jobs;
 	ListCell *lc;
 
-	foreach (lc, scheduled_jobs)
+	/*
+	 * Only the jobs with a background worker need to be checked. Check them
+	 * in job order on a copy of the list, since the jobs that stopped are
+	 * removed from it.
+	 */
+	if (start_queue != NULL)
+	{
+		jobs = list_copy(running_jobs);
+#if PG13_LT
+		{
+			List *sorted = list_qsort(jobs, cmp_job_id);
+
+			list_free(jobs);
+			jobs = sorted;
+		}
+#else
+		list_sort(jobs, cmp_job_id);
+#endif
+	}
+	else
+		jobs = scheduled_jobs;
+
+	foreach (lc, jobs)
 	{
 		BgwHandleStatus status;
 		pid_t pid;
@@ -697,6 +1264,11 @@ check_for_stopped_and_timed_out_jobs()
 
 		status = GetBackgroundWorkerPid(sjob->handle, &pid);
 
+		/* A pool worker that is done with the job waits for the next one */
+		if (status == BGWH_STARTED && sjob->pooled &&
+			ts_bgw_job_pool_job_done(job_pool, sjob->pool_slot, sjob->job.fd.id))
+			status = BGWH_STOPPED;
+
 		switch (status)
 		{
 			case BGWH_POSTMASTER_DIED:
@@ -725,6 +1297,9 @@ check_for_stopped_and_timed_out_jobs()
 				break;
 		}
 	}
+
+	if (jobs != scheduled_jobs)
+		list_free(jobs);
 }
 
 /* This is the guts of the scheduler which runs the main loop.
@@ -749,14 +1324,17 @@ ts_bgw_scheduler_process(int32 run_for_interval_ms,
 {
 	TimestampTz start = ts_timer_get_current_timestamp();
 	TimestampTz quit_time = DT_NOEND;
+	bool idle_exit = false;
 
 	pgstat_report_activity(STATE_RUNNING, NULL);
 
 	/* txn to read the list of jobs from the DB */
+	job_queues_reset();
 	StartTransactionCommand();
 	scheduled_jobs = ts_update_scheduled_jobs_list(scheduled_jobs, scheduler_mctx);
 	CommitTransactionCommand();
 	MemoryContextSwitchTo(scratch_mctx);
+	job_queues_build();
 
 	jobs_list_needs_update = false;
 
@@ -780,6 +1358,17 @@ ts_bgw_scheduler_process(int32 run_for_interval_ms,
 		start_scheduled_jobs(bgw_register);
 		next_wakeup = least_timestamp(next_wakeup, earliest_wakeup_to_start_next_job());
 		next_wakeup = least_timestamp(next_wakeup, earliest_job_timeout());
+		next_wakeup = least_timestamp(next_wakeup, next_job_stat_flush());
+
+		if (scheduler_should_exit_idle(run_for_interval_ms, next_wakeup))
+		{
+			ereport(DEBUG1,
+					(errmsg("database scheduler for database %u exiting until %s",
+							MyDatabaseId,
+							timestamptz_to_str(next_wakeup))));
+			idle_exit = true;
+			break;
+		}
 
 		pgstat_report_activity(STATE_IDLE, NULL);
 		ts_timer_wait(next_wakeup);
@@ -791,6 +1380,9 @@ ts_bgw_scheduler_process(int32 run_for_interval_ms,
 		{
 			got_SIGHUP = false;
 			ProcessConfigFile(PGC_SIGHUP);
+
+			if (job_pool != NULL)
+				ts_bgw_job_pool_set_idle_timeout(job_pool, ts_guc_bgw_job_worker_idle_timeout);
 		}
 
 		/*
@@ -801,15 +1393,20 @@ ts_bgw_scheduler_process(int32 run_for_interval_ms,
 
 		if (jobs_list_needs_update)
 		{
+			/* The jobs are copied to a new list, so the queues are rebuilt */
+			job_queues_reset();
 			StartTransactionCommand();
 			Assert(CurrentMemoryContext == CurTransactionContext);
 			scheduled_jobs = ts_update_scheduled_jobs_list(scheduled_jobs, scheduler_mctx);
 			CommitTransactionCommand();
 			MemoryContextSwitchTo(scratch_mctx);
+			job_queues_build();
 			jobs_list_needs_update = false;
 		}
 
 		check_for_stopped_and_timed_out_jobs();
+		job_pool_reap_stopped_workers();
+		flush_pending_job_stats(false);
 
 		MemoryContextReset(scratch_mctx);
 	}
@@ -823,6 +1420,12 @@ ts_bgw_scheduler_process(int32 run_for_interval_ms,
 
 	wait_for_all_jobs_to_shutdown();
 	check_for_stopped_and_timed_out_jobs();
+	job_pool_reap_stopped_workers();
+	flush_pending_job_stats(true);
+
+	/* The jobs are freed with the scheduler memory context */
+	if (idle_exit)
+		scheduled_jobs = NIL;
 }
 
 static void
@@ -846,6 +1449,8 @@ ts_bgw_scheduler_setup_mctx()
 	scheduler_mctx = AllocSetContextCreate(TopMemoryContext, "Scheduler", ALLOCSET_DEFAULT_SIZES);
 	scratch_mctx =
 		AllocSetContextCreate(scheduler_mctx, "SchedulerScratch", ALLOCSET_DEFAULT_SIZES);
+	job_queue_mctx =
+		AllocSetContextCreate(scheduler_mctx, "SchedulerJobQueues", ALLOCSET_DEFAULT_SIZES);
 	MemoryContextSwitchTo(scratch_mctx);
 }
 
@@ -10,6 +10,7 @@
 #include <postgres.h>
 
 #include <postmaster/bgworker.h>
+#include <storage/dsm.h>
 
 /**
  * Parameters to background workers.
@@ -39,6 +40,11 @@ typedef struct BgwParams
 	/** Time to live. Only used in tests. */
 	int32 ttl;
 
+	/** Job pool of the scheduler and the slot of the worker in it, plus one.
+	 * Zero if the worker is not part of a pool. */
+	dsm_handle pool_handle;
+	int32 pool_slot;
+
 	/** Name of function to call when starting the background worker. */
 	char bgw_main[NAMEDATALEN];
 } BgwParams;
@@ -34,6 +34,7 @@ typedef struct CacheStats
 	long numelements;
 	uint64 hits;
 	uint64 misses;
+	uint64 evictions;
 } CacheStats;
 
 typedef struct Cache
@@ -15,9 +15,13 @@
 #include "annotations.h"
 #include "ts_catalog/catalog.h"
 #include "compat/compat.h"
+#include "dimension_slice.h"
+#include "dimension_slice_index.h"
 #include "extension.h"
 #include "hypertable_cache.h"
+#include "planner/planner.h"
 
+#include "bgw/launcher_interface.h"
 #include "bgw/scheduler.h"
 #include "cross_module_fn.h"
 #include "cache_invalidate.h"
@@ -48,6 +52,11 @@
  * (e.g., when replacing a negative hypertable entry with a positive one). Note,
  * also, that INSERTS can taint the cache if the transaction that did the INSERT
  * fails. This is why we also need to invalidate caches on transaction failure.
+ *
+ * The dimension slice index is an exception, since it caches all the slices of
+ * a dimension and therefore needs to know about new slices as well. Instead of
+ * a proxy table, the inserts of slices invalidate the relcache entry of the
+ * dimension_slice catalog table itself, which leaves the other caches alone.
  */
 
 void _cache_invalidate_init(void);
@@ -58,16 +67,21 @@ cache_invalidate_relcache_all(void)
 {
 	ts_hypertable_cache_invalidate_callback();
 	ts_bgw_job_cache_invalidate_callback();
+	ts_dimension_slice_index_invalidate();
+	ts_planner_plain_relations_invalidate(InvalidOid);
 }
 
 static Oid hypertable_proxy_table_oid = InvalidOid;
 static Oid bgw_proxy_table_oid = InvalidOid;
+static Oid dimension_slice_table_oid = InvalidOid;
 
 void
-ts_cache_invalidate_set_proxy_tables(Oid hypertable_proxy_oid, Oid bgw_proxy_oid)
+ts_cache_invalidate_set_proxy_tables(Oid hypertable_proxy_oid, Oid bgw_proxy_oid,
+									 Oid dimension_slice_oid)
 {
 	hypertable_proxy_table_oid = hypertable_proxy_oid;
 	bgw_proxy_table_oid = bgw_proxy_oid;
+	dimension_slice_table_oid = dimension_slice_oid;
 }
 
 /*
@@ -89,16 +103,27 @@ cache_invalidate_relcache_callback(Datum arg, Oid relid)
 	{
 		ts_extension_invalidate();
 		cache_invalidate_relcache_all();
-		ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid);
+		ts_dimension_slice_shared_cache_reset();
+		ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid, InvalidOid);
 	}
 	else if (relid == hypertable_proxy_table_oid)
 	{
 		ts_hypertable_cache_invalidate_callback();
+		ts_dimension_slice_index_invalidate();
+		ts_planner_plain_relations_invalidate(InvalidOid);
 	}
 	else if (relid == bgw_proxy_table_oid)
 	{
 		ts_bgw_job_cache_invalidate_callback();
 	}
+	else if (relid == dimension_slice_table_oid)
+	{
+		ts_dimension_slice_index_invalidate();
+	}
+	else
+	{
+		ts_planner_plain_relations_invalidate(relid);
+	}
 }
 
 /* Registration for given cache ids happens in non-TSL code when the extension
@@ -152,6 +177,11 @@ cache_invalidate_xact_end(XactEvent event, void *arg)
 			 * backends cannot have the invalid state.
 			 */
 			cache_invalidate_relcache_all();
+			ts_bgw_scheduler_xact_end(false);
+			break;
+		case XACT_EVENT_COMMIT:
+			/* Start the scheduler if it exited, now that the new jobs are visible */
+			ts_bgw_scheduler_xact_end(true);
 			break;
 		default:
 			break;
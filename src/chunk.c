@@ -5,11 +5,13 @@
  */
 #include <postgres.h>
 
+#include <access/hash.h>
 #include <access/htup.h>
 #include <access/htup_details.h>
 #include <access/reloptions.h>
 #include <access/tupdesc.h>
 #include <access/xact.h>
+#include <catalog/dependency.h>
 #include <catalog/indexing.h>
 #include <catalog/namespace.h>
 #include <catalog/pg_class.h>
@@ -38,6 +40,8 @@
 
 #include "chunk.h"
 
+#include "adts/int32_small_vec.h"
+#include "bgw/job_history.h"
 #include "bgw_policy/chunk_stats.h"
 #include "cache.h"
 #include "chunk_index.h"
@@ -51,9 +55,11 @@
 #include "errors.h"
 #include "export.h"
 #include "extension.h"
+#include "guc.h"
 #include "hypercube.h"
 #include "hypertable.h"
 #include "hypertable_cache.h"
+#include "last_point.h"
 #include "partitioning.h"
 #include "process_utility.h"
 #include "scan_iterator.h"
@@ -61,7 +67,9 @@
 #include "time_utils.h"
 #include "trigger.h"
 #include "ts_catalog/catalog.h"
+#include "ts_catalog/chunk_column_stats.h"
 #include "ts_catalog/chunk_data_node.h"
+#include "ts_catalog/chunk_size_stats.h"
 #include "ts_catalog/compression_chunk_size.h"
 #include "ts_catalog/continuous_agg.h"
 #include "ts_catalog/hypertable_data_node.h"
@@ -78,9 +86,7 @@ TS_FUNCTION_INFO_V1(ts_chunk_create);
 TS_FUNCTION_INFO_V1(ts_chunk_status);
 
 static bool ts_chunk_add_status(Chunk *chunk, int32 status);
-#if PG14_GE
 static bool ts_chunk_clear_status(Chunk *chunk, int32 status);
-#endif
 
 static const char *
 DatumGetNameString(Datum datum)
@@ -1142,6 +1148,7 @@ ts_chunk_create_only_table(Hypertable *ht, Hypercube *cube, const char *schema_n
 	 * conflicts with itself. The lock needs to be held until transaction end.
 	 */
 	LockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
+	ts_chunk_creation_lock(ht->fd.id, ExclusiveLock);
 
 	ts_hypercube_find_existing_slices(cube, &tuplock);
 
@@ -1340,6 +1347,7 @@ chunk_create_from_point_after_lock(const Hypertable *ht, const Point *p, const c
 {
 	Hyperspace *hs = ht->space;
 	Hypercube *cube;
+	Chunk *chunk;
 	ScanTupLock tuplock = {
 		.lockmode = LockTupleKeyShare,
 		.waitpolicy = LockWaitBlock,
@@ -1364,7 +1372,13 @@ chunk_create_from_point_after_lock(const Hypertable *ht, const Point *p, const c
 	/* Resolve collisions with other chunks by cutting the new hypercube */
 	chunk_collision_resolve(ht, cube, p);
 
-	return chunk_create_from_hypercube_after_lock(ht, cube, schema_name, table_name, prefix);
+	chunk = chunk_create_from_hypercube_after_lock(ht, cube, schema_name, table_name, prefix);
+
+	/* A new chunk is empty, so its min and max can be tracked from inserts */
+	if (ts_guc_enable_adaptive_chunking_insert_stats && hypertable_adaptive_chunking_enabled(ht))
+		ts_chunk_adaptive_stats_init(chunk->table_id);
+
+	return chunk;
 }
 
 Chunk *
@@ -1382,6 +1396,7 @@ ts_chunk_find_or_create_without_cuts(const Hypertable *ht, Hypercube *hc, const
 	{
 		/* Serialize chunk creation around the root hypertable */
 		LockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
+		ts_chunk_creation_lock(ht->fd.id, ExclusiveLock);
 
 		/* Check again after lock */
 		stub = chunk_collides(ht, hc);
@@ -1420,6 +1435,7 @@ ts_chunk_find_or_create_without_cuts(const Hypertable *ht, Hypercube *hc, const
 
 		/* We didn't need the lock, so release it */
 		UnlockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
+		ts_chunk_creation_unlock(ht->fd.id, ExclusiveLock);
 	}
 
 	Assert(NULL != stub);
@@ -1462,6 +1478,115 @@ ts_chunk_find_for_point(const Hypertable *ht, const Point *p)
 	return ts_chunk_get_by_id(chunk_id, /* fail_if_not_found = */ false);
 }
 
+/*
+ * Lock tags for chunk creation. Use pseudo-random field 4 values to avoid
+ * conflicting with user advisory locks and the job locks.
+ */
+#define TS_SET_LOCKTAG_CHUNK_CREATION(tag, hypertable_id)                                          \
+	SET_LOCKTAG_ADVISORY((tag), MyDatabaseId, (hypertable_id), 0, 29750)
+#define TS_SET_LOCKTAG_SLICE_CREATION(tag, dimension_id, range_hash)                               \
+	SET_LOCKTAG_ADVISORY((tag), MyDatabaseId, (dimension_id), (range_hash), 29751)
+
+/*
+ * Lock the chunk creation of a hypertable. Chunk creators using the slice
+ * locking protocol take it in ShareLock mode, all other chunk creators and
+ * operations that change the dimensions of the hypertable (which would change
+ * the slices of new chunks) take it in ExclusiveLock mode.
+ */
+void
+ts_chunk_creation_lock(int32 hypertable_id, LOCKMODE lockmode)
+{
+	LOCKTAG tag;
+
+	TS_SET_LOCKTAG_CHUNK_CREATION(tag, hypertable_id);
+	(void) LockAcquire(&tag, lockmode, false, false);
+}
+
+void
+ts_chunk_creation_unlock(int32 hypertable_id, LOCKMODE lockmode)
+{
+	LOCKTAG tag;
+
+	TS_SET_LOCKTAG_CHUNK_CREATION(tag, hypertable_id);
+	LockRelease(&tag, lockmode, false);
+}
+
+static bool
+chunk_creation_use_slice_locks(const Hypertable *ht)
+{
+	/* Adaptive chunking changes the chunk interval on every chunk creation
+	 * and distributed hypertables create chunks on the data nodes as well,
+	 * so those are serialized on the hypertable */
+	return ts_guc_enable_chunk_creation_slice_locks && !hypertable_adaptive_chunking_enabled(ht) &&
+		   !hypertable_is_distributed(ht) && !hypertable_is_distributed_member(ht);
+}
+
+/*
+ * Lock the creation of the dimension slices that a chunk for the given point
+ * would need and that do not exist yet. Concurrent creators of chunks that
+ * need the same new slices, e.g., because they insert into the same new
+ * chunk, wait for each other, while the creation of chunks in other slices
+ * and operations that take the ShareUpdateExclusiveLock on the hypertable
+ * (e.g., VACUUM, ANALYZE or CREATE INDEX CONCURRENTLY) are not blocked.
+ *
+ * The slices of a dimension either have the same range or do not overlap, as
+ * long as the dimensions do not change, so a slice is identified by its
+ * dimension and range start. The locks need to be held until transaction end
+ * to make the new slices and chunk visible to the waiters.
+ *
+ * Returns the list of acquired lock tags.
+ */
+static List *
+chunk_creation_lock_slices(const Hypertable *ht, const Point *p)
+{
+	const Hyperspace *hs = ht->space;
+	List *locktags = NIL;
+
+	ts_chunk_creation_lock(ht->fd.id, ShareLock);
+
+	/* Lock in dimension order, so that creators wait in a consistent order */
+	for (int i = 0; i < hs->num_dimensions; i++)
+	{
+		const Dimension *dim = &hs->dimensions[i];
+		int64 value = p->coordinates[i];
+		DimensionSlice *slice;
+		LOCKTAG *tag;
+		uint32 range_hash;
+
+		if (NULL != dim->dimension_partitions)
+		{
+			const DimensionPartition *dp =
+				ts_dimension_partition_find(dim->dimension_partitions, value);
+			slice = ts_dimension_slice_create(dp->dimension_id, dp->range_start, dp->range_end);
+		}
+		else
+			slice = ts_dimension_calculate_default_slice(dim, value);
+
+		if (ts_dimension_slice_scan_for_existing(slice, NULL))
+			continue;
+
+		range_hash = DatumGetUInt32(hash_uint32((uint32) slice->fd.range_start)) ^
+					 DatumGetUInt32(hash_uint32((uint32) (slice->fd.range_start >> 32)));
+		tag = palloc(sizeof(LOCKTAG));
+		TS_SET_LOCKTAG_SLICE_CREATION(*tag, dim->fd.id, range_hash);
+		(void) LockAcquire(tag, ExclusiveLock, false, false);
+		locktags = lappend(locktags, tag);
+	}
+
+	return locktags;
+}
+
+static void
+chunk_creation_unlock_slices(const Hypertable *ht, List *locktags)
+{
+	ListCell *lc;
+
+	foreach (lc, locktags)
+		LockRelease(lfirst(lc), ExclusiveLock, false);
+
+	ts_chunk_creation_unlock(ht->fd.id, ShareLock);
+}
+
 /*
  * Create a chunk through insertion of a tuple at a given point.
  */
@@ -1469,14 +1594,26 @@ Chunk *
 ts_chunk_create_for_point(const Hypertable *ht, const Point *p, bool *found, const char *schema,
 						  const char *prefix)
 {
+	bool use_slice_locks = chunk_creation_use_slice_locks(ht);
+	List *slice_locktags = NIL;
+
 	/*
 	 * We're going to have to resurrect or create the chunk.
 	 * Serialize chunk creation around a lock on the "main table" to avoid
 	 * multiple processes trying to create the same chunk. We use a
 	 * ShareUpdateExclusiveLock, which is the weakest lock possible that
 	 * conflicts with itself. The lock needs to be held until transaction end.
+	 *
+	 * With timescaledb.enable_chunk_creation_slice_locks, only the creation
+	 * of the new dimension slices of the chunk is serialized instead.
 	 */
-	LockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
+	if (use_slice_locks)
+		slice_locktags = chunk_creation_lock_slices(ht, p);
+	else
+	{
+		LockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
+		ts_chunk_creation_lock(ht->fd.id, ExclusiveLock);
+	}
 
 	DEBUG_WAITPOINT("chunk_create_for_point");
 
@@ -1496,7 +1633,13 @@ ts_chunk_create_for_point(const Hypertable *ht, const Point *p, bool *found, con
 			 * Chunk was not created by us but by someone else, so we can
 			 * release the lock early.
 			 */
-			UnlockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
+			if (use_slice_locks)
+				chunk_creation_unlock_slices(ht, slice_locktags);
+			else
+			{
+				UnlockRelationOid(ht->main_table_relid, ShareUpdateExclusiveLock);
+				ts_chunk_creation_unlock(ht->fd.id, ExclusiveLock);
+			}
 			if (found)
 				*found = true;
 			return chunk;
@@ -1536,18 +1679,26 @@ ts_chunk_create_for_point(const Hypertable *ht, const Point *p, bool *found, con
  * Find the chunks that belong to the subspace identified by the given dimension
  * vectors. We might be restricting only some dimensions, so this subspace is
  * not a hypercube, but a hyperplane of some order.
- * Returns a list of matching chunk ids.
+ * Returns a sorted list of matching chunk ids.
+ *
+ * The chunks with a matching slice in a dimension form a sorted set of chunk
+ * ids, and the matching chunks are the intersection of the sets of all the
+ * dimensions. The search stops at the first dimension where the intersection
+ * becomes empty.
  */
 List *
 ts_chunk_id_find_in_subspace(Hypertable *ht, List *dimension_vecs)
 {
 	List *chunk_ids = NIL;
-
-	ChunkScanCtx ctx;
-	chunk_scan_ctx_init(&ctx, ht->space, /* point = */ NULL);
+	int32_small_vec result;
+	int32_small_vec dimension_chunk_ids;
+	bool first = true;
 
 	ScanIterator iterator = ts_chunk_constraint_scan_iterator_create(CurrentMemoryContext);
 
+	int32_small_vec_init(&result, CurrentMemoryContext, 0);
+	int32_small_vec_init(&dimension_chunk_ids, CurrentMemoryContext, 0);
+
 	ListCell *lc;
 	foreach (lc, dimension_vecs)
 	{
@@ -1558,6 +1709,9 @@ ts_chunk_id_find_in_subspace(Hypertable *ht, List *dimension_vecs)
 		 * handled earlier by gather_restriction_dimension_vectors().
 		 */
 		Assert(vec->num_slices > 0);
+
+		int32_small_vec_clear(&dimension_chunk_ids);
+
 		for (int i = 0; i < vec->num_slices; i++)
 		{
 			const DimensionSlice *slice = vec->slices[i];
@@ -1574,38 +1728,38 @@ ts_chunk_id_find_in_subspace(Hypertable *ht, List *dimension_vecs)
 				int32 current_chunk_id = DatumGetInt32(datum);
 				Assert(current_chunk_id != 0);
 
-				bool found = false;
-				ChunkScanEntry *entry =
-					hash_search(ctx.htab, &current_chunk_id, HASH_ENTER, &found);
-				if (!found)
-				{
-					entry->stub = NULL;
-					entry->num_dimension_constraints = 0;
-				}
-
 				/*
 				 * We have only the dimension constraints here, because we're searching
 				 * by dimension slice id.
 				 */
 				Assert(!slot_attisnull(ts_scan_iterator_slot(&iterator),
 									   Anum_chunk_constraint_dimension_slice_id));
-				entry->num_dimension_constraints++;
-
-				/*
-				 * A chunk is complete when we've found slices for all required dimensions,
-				 * i.e., a complete subspace.
-				 */
-				if (entry->num_dimension_constraints == list_length(dimension_vecs))
-				{
-					chunk_ids = lappend_int(chunk_ids, entry->chunk_id);
-				}
+				int32_small_vec_append(&dimension_chunk_ids, current_chunk_id);
 			}
 		}
+
+		int32_small_vec_sort_unique(&dimension_chunk_ids);
+
+		if (first)
+			int32_small_vec_append_array(&result,
+										 dimension_chunk_ids.data,
+										 dimension_chunk_ids.num_elements);
+		else
+			int32_small_vec_intersect(&result, &dimension_chunk_ids);
+
+		first = false;
+
+		if (result.num_elements == 0)
+			break;
 	}
 
 	ts_scan_iterator_close(&iterator);
 
-	chunk_scan_ctx_destroy(&ctx);
+	for (uint32 i = 0; i < result.num_elements; i++)
+		chunk_ids = lappend_int(chunk_ids, result.data[i]);
+
+	int32_small_vec_free_data(&dimension_chunk_ids);
+	int32_small_vec_free_data(&result);
 
 	return chunk_ids;
 }
@@ -3018,6 +3172,8 @@ chunk_tuple_delete(TupleInfo *ti, DropBehavior behavior, bool preserve_chunk_cat
 
 	ts_chunk_index_delete_by_chunk_id(form.id, true);
 	ts_compression_chunk_size_delete(form.id);
+	ts_chunk_column_stats_delete_by_chunk_id(form.hypertable_id, form.id);
+	ts_chunk_size_stats_delete_by_chunk_id(form.hypertable_id, form.id);
 	ts_chunk_data_node_delete_by_chunk_id(form.id);
 
 	/* Delete any row in bgw_policy_chunk-stats corresponding to this chunk */
@@ -3258,6 +3414,30 @@ ts_chunk_get_chunk_ids_by_hypertable_id(int32 hypertable_id)
 	return chunkids;
 }
 
+/*
+ * Get the IDs of the chunks of a hypertable whose primary dimension slice
+ * overlaps the range [start, end). This includes chunks that are dropped but
+ * whose catalog entries are kept, since their dimension slices are kept as
+ * well.
+ */
+List *
+ts_chunk_get_chunk_ids_in_time_range(const Hypertable *ht, int64 start, int64 end)
+{
+	const Dimension *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	List *chunkids = NIL;
+	DimensionVec *slices;
+
+	Assert(time_dim != NULL);
+	slices = dimension_slice_collision_scan(time_dim->fd.id, start, end);
+
+	for (int i = 0; i < slices->num_slices; i++)
+		ts_chunk_constraint_scan_by_dimension_slice_to_list(slices->slices[i],
+															&chunkids,
+															CurrentMemoryContext);
+
+	return chunkids;
+}
+
 List *
 ts_chunk_get_all_chunk_ids(LOCKMODE lockmode)
 {
@@ -3549,6 +3729,16 @@ ts_chunk_set_partial(Chunk *chunk)
 	return ts_chunk_add_status(chunk, CHUNK_STATUS_COMPRESSED_PARTIAL);
 }
 
+/* The partial status is cleared when the uncompressed rows are recompressed
+ * into the existing compressed chunk.
+ */
+bool
+ts_chunk_clear_partial(Chunk *chunk)
+{
+	Assert(ts_chunk_is_compressed(chunk));
+	return ts_chunk_clear_status(chunk, CHUNK_STATUS_COMPRESSED_PARTIAL);
+}
+
 /* No inserts, updates, and deletes are permitted on a frozen chunk.
  * Compression policies etc do not run on a frozen chunk.
  * Only valid operation is dropping the chunk
@@ -3586,10 +3776,6 @@ ts_chunk_is_frozen(Chunk *chunk)
 #endif
 }
 
-#if PG14_GE
-/* only caller is ts_chunk_unset_frozen. This code is in PG14 block as we run into
- * defined but unsed error in CI/CD builds for PG < 14.
- */
 static bool
 ts_chunk_clear_status(Chunk *chunk, int32 status)
 {
@@ -3609,7 +3795,6 @@ ts_chunk_clear_status(Chunk *chunk, int32 status)
 	chunk->fd.status = mstatus;
 	return chunk_update_status(&chunk->fd);
 }
-#endif
 
 static bool
 ts_chunk_add_status(Chunk *chunk, int32 status)
@@ -3890,6 +4075,64 @@ lock_referenced_tables(Oid table_relid)
 		LockRelationOid(lfirst_oid(lf), AccessExclusiveLock);
 }
 
+/*
+ * Delete the compressed batches older than the cutoff from the compressed
+ * chunks that span it, so that retention tracks the cutoff more closely than
+ * the chunk interval. The chunks entirely before the cutoff are dropped by
+ * then, so only the chunks that contain the cutoff are left.
+ *
+ * Returns true if any batch was deleted.
+ */
+static bool
+drop_compressed_batches(Hypertable *ht, int64 older_than, int32 log_level, bool has_continuous_aggs)
+{
+	bool deleted = false;
+	ListCell *lc;
+
+	foreach (lc, ts_chunk_get_chunk_ids_in_time_range(ht, older_than, older_than + 1))
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+		int64 deleted_batches;
+
+		if (chunk == NULL || chunk->fd.dropped || !ts_chunk_is_compressed(chunk) ||
+			ts_chunk_primary_dimension_start(chunk) >= older_than)
+			continue;
+
+		/* frozen chunks are skipped, like when dropping them */
+		if (!ts_chunk_validate_chunk_status_for_operation(chunk->table_id,
+														  chunk->fd.status,
+														  CHUNK_DROP,
+														  false /*throw_error */))
+			continue;
+
+		/* no inserts into the deleted region until the invalidation is logged */
+		if (has_continuous_aggs)
+			LockRelationOid(chunk->table_id, ExclusiveLock);
+
+		deleted_batches = ts_cm_functions->compressed_chunk_drop_batches(ht, chunk, older_than);
+
+		if (deleted_batches == 0)
+			continue;
+
+		deleted = true;
+
+		if (log_level >= 0)
+			elog(log_level,
+				 "dropped " INT64_FORMAT " compressed batches from chunk %s.%s",
+				 deleted_batches,
+				 chunk->fd.schema_name.data,
+				 chunk->fd.table_name.data);
+
+		if (has_continuous_aggs)
+			ts_cm_functions->continuous_agg_invalidate_raw_ht(ht,
+															  ts_chunk_primary_dimension_start(
+																  chunk),
+															  older_than);
+	}
+
+	return deleted;
+}
+
 List *
 ts_chunk_do_drop_chunks(Hypertable *ht, int64 older_than, int64 newer_than, int32 log_level,
 						List **affected_data_nodes)
@@ -3989,11 +4232,21 @@ ts_chunk_do_drop_chunks(Hypertable *ht, int64 older_than, int64 newer_than, int3
 		 *
 		 * The invalidation will allow the refresh command on a continuous
 		 * aggregate to see that this region was dropped and and will
-		 * therefore be able to refresh accordingly.*/
-		for (uint64 i = 0; i < num_chunks; i++)
+		 * therefore be able to refresh accordingly.
+		 *
+		 * All chunks are in the dropped time range, so a single invalidation
+		 * covering all of them is enough and avoids adding one log entry
+		 * per chunk. */
+		if (num_chunks > 0)
 		{
-			int64 start = ts_chunk_primary_dimension_start(&chunks[i]);
-			int64 end = ts_chunk_primary_dimension_end(&chunks[i]);
+			int64 start = PG_INT64_MAX;
+			int64 end = PG_INT64_MIN;
+
+			for (uint64 i = 0; i < num_chunks; i++)
+			{
+				start = Min(start, ts_chunk_primary_dimension_start(&chunks[i]));
+				end = Max(end, ts_chunk_primary_dimension_end(&chunks[i]));
+			}
 
 			ts_cm_functions->continuous_agg_invalidate_raw_ht(ht, start, end);
 		}
@@ -4001,8 +4254,17 @@ ts_chunk_do_drop_chunks(Hypertable *ht, int64 older_than, int64 newer_than, int3
 
 	List *data_nodes = NIL;
 	List *dropped_chunk_names = NIL;
+	bool batches_dropped = false;
+	/* The chunk tables are dropped together after removing their catalog
+	 * entries, so that the dependency scan and the relcache invalidations
+	 * happen once for the whole set instead of once per chunk. */
+	ObjectAddresses *objects = new_object_addresses();
 	for (uint64 i = 0; i < num_chunks; i++)
 	{
+		ObjectAddress objaddr = {
+			.classId = RelationRelationId,
+			.objectId = chunks[i].table_id,
+		};
 		char *chunk_name;
 		ListCell *lc;
 
@@ -4021,10 +4283,14 @@ ts_chunk_do_drop_chunks(Hypertable *ht, int64 older_than, int64 newer_than, int3
 		chunk_name = psprintf("%s.%s", schema_name, table_name);
 		dropped_chunk_names = lappend(dropped_chunk_names, chunk_name);
 
-		if (has_continuous_aggs)
-			ts_chunk_drop_preserve_catalog_row(chunks + i, DROP_RESTRICT, log_level);
-		else
-			ts_chunk_drop(chunks + i, DROP_RESTRICT, log_level);
+		if (log_level >= 0)
+			elog(log_level,
+				 "dropping chunk %s.%s",
+				 chunks[i].fd.schema_name.data,
+				 chunks[i].fd.table_name.data);
+
+		ts_chunk_delete_by_relid(chunks[i].table_id, DROP_RESTRICT, has_continuous_aggs);
+		add_exact_object_address(&objaddr, objects);
 
 		/* Collect a list of affected data nodes so that we know which data
 		 * nodes we need to drop chunks on */
@@ -4035,9 +4301,31 @@ ts_chunk_do_drop_chunks(Hypertable *ht, int64 older_than, int64 newer_than, int3
 		}
 	}
 
+	performMultipleDeletions(objects, DROP_RESTRICT, 0);
+	free_object_addresses(objects);
+	ts_job_history_add_chunks(list_length(dropped_chunk_names));
+
+	if (ts_guc_enable_batch_retention && older_than != PG_INT64_MAX &&
+		newer_than == PG_INT64_MIN && TS_HYPERTABLE_HAS_COMPRESSION_ENABLED(ht) &&
+		!hypertable_is_distributed(ht))
+		batches_dropped = drop_compressed_batches(ht, older_than, log_level, has_continuous_aggs);
+
 	if (affected_data_nodes)
 		*affected_data_nodes = data_nodes;
 
+	/* the dropped chunks could have held the newest rows of some keys */
+	if ((dropped_chunk_names != NIL || batches_dropped) && OidIsValid(ht->last_point_relid))
+		ts_last_point_cache_refresh(ht);
+
+	/* the dropped chunks could have held the last materialized buckets */
+	if (dropped_chunk_names != NIL)
+	{
+		ContinuousAgg *cagg = ts_continuous_agg_find_by_mat_hypertable_id(hypertable_id);
+
+		if (cagg != NULL)
+			ts_cagg_watermark_update(cagg);
+	}
+
 	DEBUG_WAITPOINT("drop_chunks_end");
 
 	return dropped_chunk_names;
@@ -4373,6 +4661,89 @@ ts_chunk_get_compression_status(int32 chunk_id)
 	return st;
 }
 
+/*
+ * Get the version of the compressed data of a chunk that the snapshot sees,
+ * identified by the catalog tuples of the chunk and of its compression size.
+ *
+ * Every operation that changes the compressed data of a chunk that is not
+ * partial updates one of those tuples: compression and decompression change
+ * the compressed chunk, inserts and the decompression of batches for DML mark
+ * the chunk partial, and recompression, merges and the deletion of whole
+ * batches update the compression size. So the same tuples mean the same
+ * compressed data. A partial chunk can get compressed batches without either
+ * tuple changing, so it has no version.
+ *
+ * Returns false if the chunk is not compressed or is partial.
+ */
+bool
+ts_chunk_get_compressed_data_version(int32 chunk_id, Snapshot snapshot,
+									 ChunkCompressedDataVersion *version)
+{
+	ScanIterator iterator = ts_scan_iterator_create(CHUNK, AccessShareLock, CurrentMemoryContext);
+	bool found = false;
+
+	memset(version, 0, sizeof(*version));
+	iterator.ctx.snapshot = snapshot;
+	iterator.ctx.index = catalog_get_index(ts_catalog_get(), CHUNK, CHUNK_ID_INDEX);
+	ts_scan_iterator_scan_key_init(&iterator,
+								   Anum_chunk_idx_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(chunk_id));
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool should_free, isnull;
+		HeapTuple tuple;
+		int32 status = DatumGetInt32(slot_getattr(ti->slot, Anum_chunk_status, &isnull));
+
+		if (!ts_flags_are_set_32(status, CHUNK_STATUS_COMPRESSED) ||
+			ts_flags_are_set_32(status, CHUNK_STATUS_COMPRESSED_PARTIAL))
+			continue;
+
+		tuple = ts_scan_iterator_fetch_heap_tuple(&iterator, false, &should_free);
+		version->chunk_tid = tuple->t_self;
+		version->chunk_xmin = HeapTupleHeaderGetRawXmin(tuple->t_data);
+		found = true;
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	ts_scan_iterator_close(&iterator);
+
+	if (!found)
+		return false;
+
+	found = false;
+	iterator =
+		ts_scan_iterator_create(COMPRESSION_CHUNK_SIZE, AccessShareLock, CurrentMemoryContext);
+	iterator.ctx.snapshot = snapshot;
+	iterator.ctx.index =
+		catalog_get_index(ts_catalog_get(), COMPRESSION_CHUNK_SIZE, COMPRESSION_CHUNK_SIZE_PKEY);
+	ts_scan_iterator_scan_key_init(&iterator,
+								   Anum_compression_chunk_size_pkey_chunk_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(chunk_id));
+
+	ts_scanner_foreach(&iterator)
+	{
+		bool should_free;
+		HeapTuple tuple = ts_scan_iterator_fetch_heap_tuple(&iterator, false, &should_free);
+
+		version->size_tid = tuple->t_self;
+		version->size_xmin = HeapTupleHeaderGetRawXmin(tuple->t_data);
+		found = true;
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	ts_scan_iterator_close(&iterator);
+
+	return found;
+}
+
 /* Note that only a compressed chunk can have unordered flag set */
 bool
 ts_chunk_is_unordered(const Chunk *chunk)
@@ -10,6 +10,7 @@
 #include <access/htup.h>
 #include <access/tupdesc.h>
 #include <utils/hsearch.h>
+#include <utils/snapshot.h>
 #include <foreign/foreign.h>
 
 #include "export.h"
@@ -49,6 +50,18 @@ typedef enum ChunkOperation
 	CHUNK_DECOMPRESS,
 } ChunkOperation;
 
+/*
+ * A version of the compressed data of a chunk, see
+ * ts_chunk_get_compressed_data_version().
+ */
+typedef struct ChunkCompressedDataVersion
+{
+	ItemPointerData chunk_tid;
+	TransactionId chunk_xmin;
+	ItemPointerData size_tid;
+	TransactionId size_xmin;
+} ChunkCompressedDataVersion;
+
 typedef struct Hypercube Hypercube;
 typedef struct Point Point;
 typedef struct Hyperspace Hyperspace;
@@ -147,6 +160,8 @@ extern void ts_chunk_formdata_fill(FormData_chunk *fd, const TupleInfo *ti);
 extern Chunk *ts_chunk_find_for_point(const Hypertable *ht, const Point *p);
 extern Chunk *ts_chunk_create_for_point(const Hypertable *ht, const Point *p, bool *found,
 										const char *schema, const char *prefix);
+extern void ts_chunk_creation_lock(int32 hypertable_id, LOCKMODE lockmode);
+extern void ts_chunk_creation_unlock(int32 hypertable_id, LOCKMODE lockmode);
 List *ts_chunk_id_find_in_subspace(Hypertable *ht, List *dimension_vecs);
 
 extern TSDLLEXPORT Chunk *ts_chunk_create_base(int32 id, int16 num_constraints, const char relkind);
@@ -180,7 +195,8 @@ extern void ts_chunk_recreate_all_constraints_for_dimension(Hyperspace *hs, int3
 extern TSDLLEXPORT void ts_chunk_drop_fks(const Chunk *const chunk);
 extern TSDLLEXPORT void ts_chunk_create_fks(const Chunk *const chunk);
 extern int ts_chunk_delete_by_hypertable_id(int32 hypertable_id);
-extern int ts_chunk_delete_by_name(const char *schema, const char *table, DropBehavior behavior);
+extern TSDLLEXPORT int ts_chunk_delete_by_name(const char *schema, const char *table,
+											   DropBehavior behavior);
 extern bool ts_chunk_set_name(Chunk *chunk, const char *newname);
 extern bool ts_chunk_set_schema(Chunk *chunk, const char *newschema);
 extern TSDLLEXPORT List *ts_chunk_get_window(int32 dimension_id, int64 point, int count,
@@ -188,6 +204,7 @@ extern TSDLLEXPORT List *ts_chunk_get_window(int32 dimension_id, int64 point, in
 extern void ts_chunks_rename_schema_name(char *old_schema, char *new_schema);
 
 extern TSDLLEXPORT bool ts_chunk_set_partial(Chunk *chunk);
+extern TSDLLEXPORT bool ts_chunk_clear_partial(Chunk *chunk);
 extern TSDLLEXPORT bool ts_chunk_set_unordered(Chunk *chunk);
 extern TSDLLEXPORT bool ts_chunk_set_frozen(Chunk *chunk);
 extern TSDLLEXPORT bool ts_chunk_unset_frozen(Chunk *chunk);
@@ -206,6 +223,8 @@ extern TSDLLEXPORT Chunk *ts_chunk_get_compressed_chunk_parent(const Chunk *chun
 extern TSDLLEXPORT bool ts_chunk_is_unordered(const Chunk *chunk);
 extern TSDLLEXPORT bool ts_chunk_is_partial(const Chunk *chunk);
 extern TSDLLEXPORT bool ts_chunk_is_compressed(const Chunk *chunk);
+extern TSDLLEXPORT bool ts_chunk_get_compressed_data_version(int32 chunk_id, Snapshot snapshot,
+															  ChunkCompressedDataVersion *version);
 extern TSDLLEXPORT bool ts_chunk_validate_chunk_status_for_operation(Oid chunk_relid,
 																	 int32 chunk_status,
 																	 ChunkOperation cmd,
@@ -215,6 +234,8 @@ extern TSDLLEXPORT bool ts_chunk_contains_compressed_data(const Chunk *chunk);
 extern TSDLLEXPORT ChunkCompressionStatus ts_chunk_get_compression_status(int32 chunk_id);
 extern TSDLLEXPORT Datum ts_chunk_id_from_relid(PG_FUNCTION_ARGS);
 extern TSDLLEXPORT List *ts_chunk_get_chunk_ids_by_hypertable_id(int32 hypertable_id);
+extern TSDLLEXPORT List *ts_chunk_get_chunk_ids_in_time_range(const Hypertable *ht, int64 start,
+															  int64 end);
 extern TSDLLEXPORT List *ts_chunk_get_all_chunk_ids(LOCKMODE lockmode);
 extern TSDLLEXPORT List *ts_chunk_get_data_node_name_list(const Chunk *chunk);
 
@@ -15,6 +15,8 @@
 #include <utils/array.h>
 #include <utils/snapmgr.h>
 #include <utils/typcache.h>
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
 #include <funcapi.h>
 #include <math.h>
 #include <parser/parse_func.h>
@@ -25,6 +27,7 @@
 #include "compat/compat.h"
 #include "chunk_adaptive.h"
 #include "chunk.h"
+#include "guc.h"
 #include "hypercube.h"
 #include "utils.h"
 
@@ -293,6 +296,142 @@ chunk_get_minmax(Oid relid, Oid atttype, AttrNumber attnum, Datum minmax[2])
 	return res == MINMAX_FOUND;
 }
 
+/*
+ * Min and max values of the adaptive dimension for chunks, maintained from
+ * the inserts of this backend when
+ * timescaledb.enable_adaptive_chunking_insert_stats is set. Entries are
+ * created either empty when this backend creates a chunk or from a single
+ * min/max scan of a chunk, and then extended with the values inserted, so
+ * that calculating a new chunk interval does not have to scan the recent
+ * chunks every time. Rows inserted by other backends are not seen, which
+ * only makes the estimate of the data rate somewhat less precise.
+ */
+typedef struct ChunkMinMaxStats
+{
+	Oid chunk_relid; /* hash key */
+	bool found;
+	int64 min;
+	int64 max;
+} ChunkMinMaxStats;
+
+/* The cache is reset when it grows beyond this size, since entries of
+ * dropped chunks are never removed */
+#define CHUNK_MINMAX_STATS_MAX_ENTRIES 1000
+
+static HTAB *chunk_minmax_stats = NULL;
+
+static ChunkMinMaxStats *
+chunk_minmax_stats_lookup(Oid chunk_relid, HASHACTION action)
+{
+	bool found;
+	ChunkMinMaxStats *stats;
+
+	if (chunk_minmax_stats == NULL)
+	{
+		HASHCTL ctl = {
+			.keysize = sizeof(Oid),
+			.entrysize = sizeof(ChunkMinMaxStats),
+			.hcxt = TopMemoryContext,
+		};
+
+		if (action == HASH_FIND)
+			return NULL;
+
+		chunk_minmax_stats = hash_create("chunk min max stats",
+										 32,
+										 &ctl,
+										 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+	else if (action == HASH_ENTER &&
+			 hash_get_num_entries(chunk_minmax_stats) >= CHUNK_MINMAX_STATS_MAX_ENTRIES)
+	{
+		hash_destroy(chunk_minmax_stats);
+		chunk_minmax_stats = NULL;
+		return chunk_minmax_stats_lookup(chunk_relid, action);
+	}
+
+	stats = hash_search(chunk_minmax_stats, &chunk_relid, action, &found);
+
+	if (action == HASH_ENTER && !found)
+		stats->found = false;
+
+	return stats;
+}
+
+/*
+ * Start tracking the min and max values of a chunk created by this backend.
+ */
+void
+ts_chunk_adaptive_stats_init(Oid chunk_relid)
+{
+	chunk_minmax_stats_lookup(chunk_relid, HASH_ENTER);
+}
+
+/*
+ * Extend the tracked min and max values of a chunk with the range of values
+ * inserted into it. Chunks that are not tracked are ignored, since the
+ * values inserted by this backend do not tell the range of the whole chunk.
+ */
+void
+ts_chunk_adaptive_stats_add(Oid chunk_relid, int64 min, int64 max)
+{
+	ChunkMinMaxStats *stats = chunk_minmax_stats_lookup(chunk_relid, HASH_FIND);
+
+	if (stats == NULL)
+		return;
+
+	if (!stats->found)
+	{
+		stats->min = min;
+		stats->max = max;
+		stats->found = true;
+	}
+	else
+	{
+		stats->min = Min(stats->min, min);
+		stats->max = Max(stats->max, max);
+	}
+}
+
+/*
+ * Get the min and max of the dimension column of a chunk as internal time
+ * values, from the tracked stats if possible.
+ */
+static bool
+chunk_get_dimension_minmax(Oid relid, const Dimension *dim, AttrNumber attno, int64 *min,
+						   int64 *max)
+{
+	ChunkMinMaxStats *stats = NULL;
+	Datum minmax[2];
+
+	if (ts_guc_enable_adaptive_chunking_insert_stats && dim->partitioning == NULL)
+	{
+		stats = chunk_minmax_stats_lookup(relid, HASH_FIND);
+
+		if (stats != NULL)
+		{
+			*min = stats->min;
+			*max = stats->max;
+			return stats->found;
+		}
+	}
+
+	if (ts_guc_enable_adaptive_chunking_insert_stats && dim->partitioning == NULL)
+		stats = chunk_minmax_stats_lookup(relid, HASH_ENTER);
+
+	if (!chunk_get_minmax(relid, dim->fd.column_type, attno, minmax))
+		return false;
+
+	*min = ts_time_value_to_internal(minmax[0], dim->fd.column_type);
+	*max = ts_time_value_to_internal(minmax[1], dim->fd.column_type);
+
+	/* Remember the scan result, later inserts extend it */
+	if (stats != NULL)
+		ts_chunk_adaptive_stats_add(relid, *min, *max);
+
+	return true;
+}
+
 static AttrNumber
 chunk_get_attno(Oid hypertable_relid, Oid chunk_relid, AttrNumber hypertable_attnum)
 {
@@ -469,8 +608,7 @@ ts_calculate_chunk_interval(PG_FUNCTION_ARGS)
 		Chunk *chunk = lfirst(lc);
 		const DimensionSlice *slice =
 			ts_hypercube_get_slice_by_dimension_id(chunk->cube, dimension_id);
-		int64 chunk_size, slice_interval;
-		Datum minmax[2];
+		int64 chunk_size, slice_interval, min, max;
 		AttrNumber attno =
 			chunk_get_attno(ht->main_table_relid, chunk->table_id, dim->column_attno);
 
@@ -481,10 +619,8 @@ ts_calculate_chunk_interval(PG_FUNCTION_ARGS)
 
 		slice_interval = slice->fd.range_end - slice->fd.range_start;
 
-		if (chunk_get_minmax(chunk->table_id, dim->fd.column_type, attno, minmax))
+		if (chunk_get_dimension_minmax(chunk->table_id, dim, attno, &min, &max))
 		{
-			int64 min = ts_time_value_to_internal(minmax[0], dim->fd.column_type);
-			int64 max = ts_time_value_to_internal(minmax[1], dim->fd.column_type);
 			double interval_fillfactor, size_fillfactor;
 			int64 extrapolated_chunk_size;
 
@@ -28,5 +28,7 @@ extern void ts_chunk_sizing_func_validate(regproc func, ChunkSizingInfo *info);
 extern TSDLLEXPORT ChunkSizingInfo *ts_chunk_sizing_info_get_default_disabled(Oid table_relid);
 
 extern TSDLLEXPORT int64 ts_chunk_calculate_initial_chunk_target_size(void);
+extern void ts_chunk_adaptive_stats_init(Oid chunk_relid);
+extern void ts_chunk_adaptive_stats_add(Oid chunk_relid, int64 min, int64 max);
 
 #endif /* TIMESCALEDB_CHUNK_ADAPTIVE_H */
@@ -242,10 +242,13 @@ chunk_relation_index_create(Relation htrel, Relation template_indexrel, Relation
 												 index_tablespace);
 }
 
+/*
+ * Create a chunk index in the given tablespace, InvalidOid being the default
+ * tablespace of the database.
+ */
 static Oid
-ts_chunk_index_create_post_adjustment(int32 hypertable_id, Relation template_indexrel,
-									  Relation chunkrel, IndexInfo *indexinfo, bool isconstraint,
-									  Oid index_tablespace)
+chunk_index_build(Relation template_indexrel, Relation chunkrel, IndexInfo *indexinfo,
+				  bool isconstraint, Oid tablespace)
 {
 	Oid chunk_indexrelid = InvalidOid;
 	const char *indexname;
@@ -255,7 +258,6 @@ ts_chunk_index_create_post_adjustment(int32 hypertable_id, Relation template_ind
 	Datum indclass;
 	oidvector *indclassoid;
 	List *colnames = create_index_colnames(template_indexrel);
-	Oid tablespace;
 	bits16 flags = 0;
 
 	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(RelationGetRelid(template_indexrel)));
@@ -277,10 +279,6 @@ ts_chunk_index_create_post_adjustment(int32 hypertable_id, Relation template_ind
 	indexname = chunk_index_choose_name(get_rel_name(RelationGetRelid(chunkrel)),
 										get_rel_name(RelationGetRelid(template_indexrel)),
 										get_rel_namespace(RelationGetRelid(chunkrel)));
-	if (OidIsValid(index_tablespace))
-		tablespace = index_tablespace;
-	else
-		tablespace = ts_chunk_index_get_tablespace(hypertable_id, template_indexrel, chunkrel);
 
 	/* assign flags for index creation and constraint creation */
 	if (isconstraint)
@@ -314,6 +312,21 @@ ts_chunk_index_create_post_adjustment(int32 hypertable_id, Relation template_ind
 	return chunk_indexrelid;
 }
 
+static Oid
+ts_chunk_index_create_post_adjustment(int32 hypertable_id, Relation template_indexrel,
+									  Relation chunkrel, IndexInfo *indexinfo, bool isconstraint,
+									  Oid index_tablespace)
+{
+	Oid tablespace;
+
+	if (OidIsValid(index_tablespace))
+		tablespace = index_tablespace;
+	else
+		tablespace = ts_chunk_index_get_tablespace(hypertable_id, template_indexrel, chunkrel);
+
+	return chunk_index_build(template_indexrel, chunkrel, indexinfo, isconstraint, tablespace);
+}
+
 static bool
 chunk_index_insert_relation(Relation rel, int32 chunk_id, const char *chunk_index,
 							int32 hypertable_id, const char *parent_index)
@@ -381,29 +394,27 @@ ts_chunk_index_create_from_constraint(int32 hypertable_id, Oid hypertable_constr
  */
 static void
 chunk_index_create(Relation hypertable_rel, int32 hypertable_id, Relation hypertable_idxrel,
-				   int32 chunk_id, Relation chunkrel, Oid constraint_oid, Oid index_tblspc)
+				   int32 chunk_id, Relation chunkrel, Relation chunk_index_rel,
+				   bool adjust_attnos, Oid index_tblspc)
 {
+	IndexInfo *indexinfo = BuildIndexInfo(hypertable_idxrel);
 	Oid chunk_indexrelid;
 
-	if (OidIsValid(constraint_oid))
-	{
-		/*
-		 * If there is an associated constraint then that constraint created
-		 * both the index and the catalog entry for the index
-		 */
-		return;
-	}
+	/*
+	 * Convert the IndexInfo's attnos to match the chunk instead of the
+	 * hypertable
+	 */
+	if (adjust_attnos)
+		ts_adjust_indexinfo_attnos(indexinfo, RelationGetRelid(hypertable_rel), chunkrel);
 
-	chunk_indexrelid = chunk_relation_index_create(hypertable_rel,
-												   hypertable_idxrel,
-												   chunkrel,
-												   false,
-												   index_tblspc);
+	chunk_indexrelid =
+		chunk_index_build(hypertable_idxrel, chunkrel, indexinfo, false, index_tblspc);
 
-	chunk_index_insert(chunk_id,
-					   get_rel_name(chunk_indexrelid),
-					   hypertable_id,
-					   get_rel_name(RelationGetRelid(hypertable_idxrel)));
+	chunk_index_insert_relation(chunk_index_rel,
+								chunk_id,
+								get_rel_name(chunk_indexrelid),
+								hypertable_id,
+								get_rel_name(RelationGetRelid(hypertable_idxrel)));
 }
 
 void
@@ -427,15 +438,26 @@ ts_chunk_index_create_from_adjusted_index_info(int32 hypertable_id, Relation hyp
 /*
  * Create all indexes on a chunk, given the indexes that exists on the chunk's
  * hypertable.
+ *
+ * This is done for every new chunk, so the work that is the same for all the
+ * indexes of the chunk is done only once: the chunk index catalog table is
+ * opened once for all the mappings, and the tablespace at an offset from the
+ * chunk's tablespace, which requires a scan of the hypertable's tablespaces,
+ * is only looked up once.
  */
 void
 ts_chunk_index_create_all(int32 hypertable_id, Oid hypertable_relid, int32 chunk_id, Oid chunkrelid,
 						  Oid index_tblspc)
 {
+	Catalog *catalog;
 	Relation htrel;
 	Relation chunkrel;
+	Relation chunk_index_rel;
 	List *indexlist;
 	ListCell *lc;
+	bool adjust_attnos;
+	Oid offset_tblspc = InvalidOid;
+	bool offset_tblspc_valid = false;
 	const char chunk_relkind = get_rel_relkind(chunkrelid);
 
 	/* Foreign table chunks don't support indexes */
@@ -462,22 +484,67 @@ ts_chunk_index_create_all(int32 hypertable_id, Oid hypertable_relid, int32 chunk
 	 */
 	indexlist = RelationGetIndexList(htrel);
 
+	if (indexlist == NIL)
+	{
+		table_close(chunkrel, NoLock);
+		table_close(htrel, AccessShareLock);
+		return;
+	}
+
+	adjust_attnos =
+		chunk_index_need_attnos_adjustment(RelationGetDescr(htrel), RelationGetDescr(chunkrel));
+
+	catalog = ts_catalog_get();
+	chunk_index_rel = table_open(catalog_get_table_id(catalog, CHUNK_INDEX), RowExclusiveLock);
+
 	foreach (lc, indexlist)
 	{
 		Oid hypertable_idxoid = lfirst_oid(lc);
-		Relation hypertable_idxrel = index_open(hypertable_idxoid, AccessShareLock);
+		Relation hypertable_idxrel;
+		Oid tablespace = index_tblspc;
+
+		/*
+		 * If there is an associated constraint then that constraint created
+		 * both the index and the catalog entry for the index
+		 */
+		if (OidIsValid(get_index_constraint(hypertable_idxoid)))
+			continue;
+
+		hypertable_idxrel = index_open(hypertable_idxoid, AccessShareLock);
+
+		/*
+		 * Determine the index's tablespace. Use the main index's tablespace,
+		 * or, if not set, select one at an offset from the chunk's tablespace.
+		 */
+		if (!OidIsValid(tablespace))
+		{
+			if (OidIsValid(hypertable_idxrel->rd_rel->reltablespace))
+				tablespace = hypertable_idxrel->rd_rel->reltablespace;
+			else
+			{
+				if (!offset_tblspc_valid)
+				{
+					offset_tblspc = chunk_index_select_tablespace(hypertable_id, chunkrel);
+					offset_tblspc_valid = true;
+				}
+
+				tablespace = offset_tblspc;
+			}
+		}
 
 		chunk_index_create(htrel,
 						   hypertable_id,
 						   hypertable_idxrel,
 						   chunk_id,
 						   chunkrel,
-						   get_index_constraint(hypertable_idxoid),
-						   index_tblspc);
+						   chunk_index_rel,
+						   adjust_attnos,
+						   tablespace);
 
 		index_close(hypertable_idxrel, AccessShareLock);
 	}
 
+	table_close(chunk_index_rel, RowExclusiveLock);
 	table_close(chunkrel, NoLock);
 	table_close(htrel, AccessShareLock);
 }
@@ -0,0 +1,247 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/genam.h>
+#include <access/parallel.h>
+#include <access/relation.h>
+#include <access/xact.h>
+#include <catalog/pg_class.h>
+#include <miscadmin.h>
+#include <nodes/pg_list.h>
+#include <postmaster/bgworker.h>
+#include <storage/bufmgr.h>
+#include <storage/ipc.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/relcache.h>
+
+#include "bgw/launcher_interface.h"
+#include "chunk_prewarm.h"
+#include "extension.h"
+#include "guc.h"
+
+/*
+ * Chunk prewarming reads the pages of a chunk into shared buffers from a
+ * background worker, so that the first queries on the chunk don't pay for
+ * the reads. Decompression writes the chunk through a bulk-write buffer
+ * ring, which leaves almost none of the decompressed data in shared buffers.
+ *
+ * The chunks are collected during the transaction and a single worker is
+ * started for them when the transaction commits. The chunks are passed to the
+ * worker in bgw_extra, so only the chunks decompressed last are prewarmed if a
+ * transaction decompresses more chunks than fit.
+ *
+ * The worker counts against timescaledb.max_background_workers like the job
+ * workers. It is reserved before the worker is started and released by the
+ * worker when it exits, and the chunks are not prewarmed when all workers
+ * are taken.
+ */
+#define CHUNK_PREWARM_MAX_RELIDS 28
+
+typedef struct ChunkPrewarmArgs
+{
+	Oid database_id;
+	Oid user_id;
+	int32 mode;
+	int32 num_relids;
+	Oid relids[CHUNK_PREWARM_MAX_RELIDS];
+} ChunkPrewarmArgs;
+
+PGDLLEXPORT void ts_chunk_prewarm_worker_main(Datum main_arg);
+
+/* The chunks to prewarm when the current transaction commits */
+static List *prewarm_relids = NIL;
+
+void
+ts_chunk_prewarm_request(Oid relid)
+{
+	MemoryContext oldcxt;
+
+	if (ts_guc_chunk_prewarm == CHUNK_PREWARM_OFF || IsParallelWorker())
+		return;
+
+	if (list_member_oid(prewarm_relids, relid))
+		return;
+
+	oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+	if (list_length(prewarm_relids) == CHUNK_PREWARM_MAX_RELIDS)
+		prewarm_relids = list_delete_first(prewarm_relids);
+	prewarm_relids = lappend_oid(prewarm_relids, relid);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+static void
+chunk_prewarm_start_worker(void)
+{
+	ChunkPrewarmArgs args = {
+		.database_id = MyDatabaseId,
+		.user_id = GetUserId(),
+		.mode = ts_guc_chunk_prewarm,
+	};
+	BackgroundWorker worker = {
+		.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION,
+		.bgw_start_time = BgWorkerStart_RecoveryFinished,
+		.bgw_restart_time = BGW_NEVER_RESTART,
+		.bgw_main_arg = (Datum) 0,
+	};
+	ListCell *lc;
+
+	StaticAssertStmt(sizeof(ChunkPrewarmArgs) <= BGW_EXTRALEN,
+					 "chunk prewarm arguments do not fit in bgw_extra");
+
+	foreach (lc, prewarm_relids)
+		args.relids[args.num_relids++] = lfirst_oid(lc);
+
+	snprintf(worker.bgw_name, BGW_MAXLEN, "TimescaleDB chunk prewarm worker");
+	strlcpy(worker.bgw_library_name, ts_extension_get_so_name(), BGW_MAXLEN);
+	strlcpy(worker.bgw_function_name, "ts_chunk_prewarm_worker_main", BGW_MAXLEN);
+	memcpy(worker.bgw_extra, &args, sizeof(args));
+
+	/*
+	 * Prewarming is only an optimization, so don't fail the commit for it.
+	 * The worker counter is kept by the loader, so there is none without it.
+	 */
+	if (ts_bgw_loader_api_version() == 0 || !ts_bgw_worker_reserve())
+	{
+		elog(DEBUG1, "no background worker available for chunk prewarming");
+		return;
+	}
+
+	if (!RegisterDynamicBackgroundWorker(&worker, NULL))
+	{
+		ts_bgw_worker_release();
+		elog(DEBUG1, "could not start chunk prewarm worker");
+	}
+}
+
+/*
+ * Start the worker just before the commit. All pages of the chunks are
+ * written at this point, and the worker's lock on a chunk doesn't conflict
+ * with the lock decompression holds, so it can start reading right away.
+ */
+static void
+chunk_prewarm_xact_callback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_PRE_COMMIT:
+			if (prewarm_relids != NIL)
+				chunk_prewarm_start_worker();
+			break;
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PARALLEL_COMMIT:
+		case XACT_EVENT_PARALLEL_ABORT:
+			/* the list is freed with the transaction memory */
+			prewarm_relids = NIL;
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Read the main fork of a relation into shared buffers, up to the given
+ * number of blocks. Returns the number of blocks left to read.
+ */
+static int64
+chunk_prewarm_relation(Relation rel, int64 budget)
+{
+	BlockNumber nblocks = RelationGetNumberOfBlocks(rel);
+	BlockNumber blkno;
+
+	for (blkno = 0; blkno < nblocks && budget > 0; blkno++, budget--)
+	{
+		Buffer buf;
+
+		CHECK_FOR_INTERRUPTS();
+		buf = ReadBufferExtended(rel, MAIN_FORKNUM, blkno, RBM_NORMAL, NULL);
+		ReleaseBuffer(buf);
+	}
+
+	return budget;
+}
+
+/*
+ * Prewarm a chunk. The indexes go first since most queries on a chunk
+ * start with an index scan, and they are smaller than the heap.
+ */
+static int64
+chunk_prewarm_chunk(Oid relid, ChunkPrewarmMode mode, int64 budget)
+{
+	Relation rel = try_relation_open(relid, AccessShareLock);
+	List *indexes;
+	ListCell *lc;
+
+	/* The chunk was dropped in the meantime */
+	if (rel == NULL)
+		return budget;
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION)
+	{
+		relation_close(rel, AccessShareLock);
+		return budget;
+	}
+
+	indexes = RelationGetIndexList(rel);
+	foreach (lc, indexes)
+	{
+		Relation indexrel = index_open(lfirst_oid(lc), AccessShareLock);
+
+		budget = chunk_prewarm_relation(indexrel, budget);
+		index_close(indexrel, AccessShareLock);
+	}
+
+	if (mode == CHUNK_PREWARM_ALL)
+		budget = chunk_prewarm_relation(rel, budget);
+
+	relation_close(rel, AccessShareLock);
+	return budget;
+}
+
+/* Release the worker reserved by the backend that started the worker */
+static void
+chunk_prewarm_release_worker(int code, Datum arg)
+{
+	ts_bgw_worker_release();
+}
+
+/*
+ * Entrypoint of the chunk prewarm worker. The worker connects as the user
+ * that decompressed the chunks. Prewarming stops after a quarter of shared
+ * buffers so that it doesn't evict the rest of the working set.
+ */
+void
+ts_chunk_prewarm_worker_main(Datum main_arg)
+{
+	ChunkPrewarmArgs args;
+	int64 budget = NBuffers / 4;
+	int i;
+
+	before_shmem_exit(chunk_prewarm_release_worker, (Datum) 0);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	memcpy(&args, MyBgworkerEntry->bgw_extra, sizeof(args));
+	BackgroundWorkerInitializeConnectionByOid(args.database_id, args.user_id, 0);
+
+	StartTransactionCommand();
+	for (i = 0; i < args.num_relids && budget > 0; i++)
+		budget = chunk_prewarm_chunk(args.relids[i], args.mode, budget);
+	CommitTransactionCommand();
+}
+
+void
+_chunk_prewarm_init(void)
+{
+	RegisterXactCallback(chunk_prewarm_xact_callback, NULL);
+}
+
+void
+_chunk_prewarm_fini(void)
+{
+	UnregisterXactCallback(chunk_prewarm_xact_callback, NULL);
+}
@@ -0,0 +1,15 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_CHUNK_PREWARM_H
+#define TIMESCALEDB_CHUNK_PREWARM_H
+
+#include <postgres.h>
+
+#include "export.h"
+
+extern TSDLLEXPORT void ts_chunk_prewarm_request(Oid relid);
+
+#endif /* TIMESCALEDB_CHUNK_PREWARM_H */
@@ -8,6 +8,7 @@
 #include <storage/lmgr.h>
 #include <utils/syscache.h>
 #include <utils/builtins.h>
+#include <utils/hsearch.h>
 
 #include "debug_point.h"
 #include "dimension_vector.h"
@@ -20,6 +21,13 @@
 #include "chunk_constraint.h"
 #include "ts_catalog/chunk_data_node.h"
 
+/* Entry of the slices shared by the hypercubes of the scanned chunks */
+typedef struct ChunkScanSliceEntry
+{
+	int32 slice_id;
+	DimensionSlice *slice;
+} ChunkScanSliceEntry;
+
 /*
  * Scan for chunks matching a query.
  *
@@ -36,6 +44,12 @@
  * For performance, try not to interleave scans of different metadata tables
  * in order to maintain data locality while scanning. Also, keep scanned
  * tables and indexes open until all the metadata is scanned for all chunks.
+ *
+ * The chunks are only read by the planner, so keep the per-chunk allocations
+ * down: the Chunk structs are allocated in a single array, and every
+ * dimension slice is allocated once and shared by the hypercubes of all the
+ * chunks that reference it. With a space dimension, or many chunks in the same
+ * time range, a slice is typically shared by many chunks.
  */
 Chunk **
 ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned int *num_chunks)
@@ -58,49 +72,54 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 	/*
 	 * For each matching chunk, fill in the metadata from the "chunk" table.
 	 * Make sure to filter out "dropped" chunks.
+	 *
+	 * All the chunks are looked up in a single index scan with an array of
+	 * chunk IDs, so the chunks come back in chunk ID order. The caller sorts
+	 * the IDs, so this is also the order of the input.
 	 */
+	int32 *ids = palloc(sizeof(int32) * Max(list_length(chunk_ids), 1));
+	int num_ids = 0;
+	foreach (lc, chunk_ids)
+		ids[num_ids++] = lfirst_int(lc);
+
 	ScanIterator chunk_it = ts_chunk_scan_iterator_create(orig_mcxt);
+	Chunk *chunk_array = MemoryContextAllocZero(orig_mcxt, sizeof(Chunk) * Max(num_ids, 1));
 	unlocked_chunks = MemoryContextAlloc(work_mcxt, sizeof(Chunk *) * list_length(chunk_ids));
-	foreach (lc, chunk_ids)
+	ts_scan_iterator_set_index(&chunk_it, CHUNK, CHUNK_ID_INDEX);
+	ts_scan_iterator_scan_key_init_int4_array(&chunk_it, Anum_chunk_idx_id, ids, num_ids);
+	ts_scan_iterator_start_scan(&chunk_it);
+
+	while (ts_scan_iterator_next(&chunk_it) != NULL)
 	{
-		int chunk_id = lfirst_int(lc);
-		TupleInfo *ti;
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&chunk_it);
+		bool isnull;
+		Datum datum = slot_getattr(ti->slot, Anum_chunk_dropped, &isnull);
+		bool is_dropped = isnull ? false : DatumGetBool(datum);
 
 		Assert(CurrentMemoryContext == work_mcxt);
+		MemoryContextSwitchTo(per_tuple_mcxt);
+		MemoryContextReset(per_tuple_mcxt);
 
-		ts_chunk_scan_iterator_set_chunk_id(&chunk_it, chunk_id);
-		ts_scan_iterator_start_or_restart_scan(&chunk_it);
-		ti = ts_scan_iterator_next(&chunk_it);
-
-		if (ti)
+		if (!is_dropped)
 		{
-			bool isnull;
-			Datum datum = slot_getattr(ti->slot, Anum_chunk_dropped, &isnull);
-			bool is_dropped = isnull ? false : DatumGetBool(datum);
+			Chunk *chunk = &chunk_array[unlocked_chunk_count];
 
-			MemoryContextSwitchTo(per_tuple_mcxt);
-			MemoryContextReset(per_tuple_mcxt);
+			MemoryContext old_mcxt = MemoryContextSwitchTo(ti->mctx);
+			ts_chunk_formdata_fill(&chunk->fd, ti);
+			MemoryContextSwitchTo(old_mcxt);
 
-			if (!is_dropped)
-			{
-				Chunk *chunk = MemoryContextAllocZero(orig_mcxt, sizeof(Chunk));
-
-				MemoryContext old_mcxt = MemoryContextSwitchTo(ti->mctx);
-				ts_chunk_formdata_fill(&chunk->fd, ti);
-				MemoryContextSwitchTo(old_mcxt);
-
-				chunk->constraints = NULL;
-				chunk->cube = NULL;
-				chunk->hypertable_relid = hs->main_table_relid;
+			chunk->constraints = NULL;
+			chunk->cube = NULL;
+			chunk->hypertable_relid = hs->main_table_relid;
 
-				unlocked_chunks[unlocked_chunk_count] = chunk;
-				unlocked_chunk_count++;
-			}
-
-			MemoryContextSwitchTo(work_mcxt);
-			/* Only one chunk should match */
-			Assert(ts_scan_iterator_next(&chunk_it) == NULL);
+			/* Only one chunk should match every ID */
+			Assert(unlocked_chunk_count == 0 ||
+				   unlocked_chunks[unlocked_chunk_count - 1]->fd.id < chunk->fd.id);
+			unlocked_chunks[unlocked_chunk_count] = chunk;
+			unlocked_chunk_count++;
 		}
+
+		MemoryContextSwitchTo(work_mcxt);
 	}
 
 	ts_scan_iterator_close(&chunk_it);
@@ -163,23 +182,47 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 	}
 
 	/*
-	 * Fetch the chunk constraints.
+	 * Fetch the chunk constraints of all the chunks in a single index scan.
+	 * The constraints come back ordered by chunk ID, like the chunks, so
+	 * attribute them to the chunks by walking both in step.
 	 */
 	ScanIterator constr_it = ts_chunk_constraint_scan_iterator_create(orig_mcxt);
 
 	for (int i = 0; i < locked_chunk_count; i++)
 	{
-		Chunk *chunk = locked_chunks[i];
-		chunk->constraints = ts_chunk_constraints_alloc(/* size_hint = */ 0, orig_mcxt);
+		locked_chunks[i]->constraints = ts_chunk_constraints_alloc(/* size_hint = */ 0, orig_mcxt);
+		ids[i] = locked_chunks[i]->fd.id;
+	}
 
-		ts_chunk_constraint_scan_iterator_set_chunk_id(&constr_it, chunk->fd.id);
-		ts_scan_iterator_start_or_restart_scan(&constr_it);
+	if (locked_chunk_count > 0)
+	{
+		int chunk_index = 0;
+
+		ts_scan_iterator_set_index(&constr_it,
+								   CHUNK_CONSTRAINT,
+								   CHUNK_CONSTRAINT_CHUNK_ID_CONSTRAINT_NAME_IDX);
+		ts_scan_iterator_scan_key_init_int4_array(
+			&constr_it,
+			Anum_chunk_constraint_chunk_id_constraint_name_idx_chunk_id,
+			ids,
+			locked_chunk_count);
+		ts_scan_iterator_start_scan(&constr_it);
 
 		while (ts_scan_iterator_next(&constr_it) != NULL)
 		{
 			TupleInfo *constr_ti = ts_scan_iterator_tuple_info(&constr_it);
+			bool isnull;
+			int32 chunk_id = DatumGetInt32(
+				slot_getattr(constr_ti->slot, Anum_chunk_constraint_chunk_id, &isnull));
+
+			Assert(!isnull);
+			while (locked_chunks[chunk_index]->fd.id < chunk_id)
+				chunk_index++;
+			Assert(chunk_index < locked_chunk_count &&
+				   locked_chunks[chunk_index]->fd.id == chunk_id);
+
 			MemoryContextSwitchTo(per_tuple_mcxt);
-			ts_chunk_constraints_add_from_tuple(chunk->constraints, constr_ti);
+			ts_chunk_constraints_add_from_tuple(locked_chunks[chunk_index]->constraints, constr_ti);
 			MemoryContextSwitchTo(work_mcxt);
 		}
 	}
@@ -187,8 +230,17 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 
 	/*
 	 * Build hypercubes for the chunks by finding and combining the dimension
-	 * slices that match the chunk constraints.
+	 * slices that match the chunk constraints. Each slice is looked up once.
 	 */
+	HASHCTL slice_hashctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(ChunkScanSliceEntry),
+		.hcxt = work_mcxt,
+	};
+	HTAB *slices = hash_create("chunk-scan-slices",
+							   Max(locked_chunk_count, 16),
+							   &slice_hashctl,
+							   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 	ScanIterator slice_iterator = ts_dimension_slice_scan_iterator_create(NULL, orig_mcxt);
 	for (int chunk_index = 0; chunk_index < locked_chunk_count; chunk_index++)
 	{
@@ -206,27 +258,28 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 				continue;
 			}
 
-			/*
-			 * Find the slice by id. Don't have to lock it because the chunk is
-			 * locked.
-			 */
-			const int slice_id = constraint->fd.dimension_slice_id;
-			DimensionSlice *slice_ptr =
-				ts_dimension_slice_scan_iterator_get_by_id(&slice_iterator,
-														   slice_id,
-														   /* tuplock = */ NULL);
-			if (slice_ptr == NULL)
+			const int32 slice_id = constraint->fd.dimension_slice_id;
+			bool found;
+			ChunkScanSliceEntry *entry = hash_search(slices, &slice_id, HASH_ENTER, &found);
+
+			if (!found)
 			{
-				elog(ERROR, "dimension slice %d is not found", slice_id);
+				/*
+				 * Find the slice by id. Don't have to lock it because the
+				 * chunk is locked. The slice is allocated on the result
+				 * memory context of the iterator.
+				 */
+				entry->slice = ts_dimension_slice_scan_iterator_get_by_id(&slice_iterator,
+																		  slice_id,
+																		  /* tuplock = */ NULL);
+				if (entry->slice == NULL)
+				{
+					elog(ERROR, "dimension slice %d is not found", slice_id);
+				}
 			}
-			MemoryContextSwitchTo(orig_mcxt);
-			DimensionSlice *slice_copy = ts_dimension_slice_create(slice_ptr->fd.dimension_id,
-																   slice_ptr->fd.range_start,
-																   slice_ptr->fd.range_end);
-			slice_copy->fd.id = slice_ptr->fd.id;
-			MemoryContextSwitchTo(work_mcxt);
+
 			Assert(cube->capacity > cube->num_slices);
-			cube->slices[cube->num_slices++] = slice_copy;
+			cube->slices[cube->num_slices++] = entry->slice;
 		}
 		ts_hypercube_slice_sort(cube);
 		chunk->cube = cube;
@@ -244,46 +297,60 @@ ts_chunk_scan_by_chunk_ids(const Hyperspace *hs, const List *chunk_ids, unsigned
 	if (remote_chunk_count > 0)
 	{
 		ScanIterator data_node_it = ts_chunk_data_nodes_scan_iterator_create(orig_mcxt);
+		int num_remote = 0;
+		int chunk_index = 0;
 
 		for (int i = 0; i < locked_chunk_count; i++)
 		{
-			Chunk *chunk = locked_chunks[i];
+			if (locked_chunks[i]->relkind == RELKIND_FOREIGN_TABLE)
+				ids[num_remote++] = locked_chunks[i]->fd.id;
+		}
 
-			if (chunk->relkind == RELKIND_FOREIGN_TABLE)
-			{
-				/* Must start or restart the scan on the longer-lived context */
-				ts_chunk_data_nodes_scan_iterator_set_chunk_id(&data_node_it, chunk->fd.id);
-				ts_scan_iterator_start_or_restart_scan(&data_node_it);
+		/* Like the constraints, the data nodes come back ordered by chunk ID */
+		ts_scan_iterator_set_index(&data_node_it,
+								   CHUNK_DATA_NODE,
+								   CHUNK_DATA_NODE_CHUNK_ID_NODE_NAME_IDX);
+		ts_scan_iterator_scan_key_init_int4_array(
+			&data_node_it,
+			Anum_chunk_data_node_chunk_id_node_name_idx_chunk_id,
+			ids,
+			num_remote);
+		ts_scan_iterator_start_scan(&data_node_it);
+
+		while (ts_scan_iterator_next(&data_node_it) != NULL)
+		{
+			bool should_free;
+			TupleInfo *ti = ts_scan_iterator_tuple_info(&data_node_it);
+			ChunkDataNode *chunk_data_node;
+			Form_chunk_data_node form;
+			MemoryContext old_mcxt;
+			HeapTuple tuple;
+			Chunk *chunk;
 
-				while (ts_scan_iterator_next(&data_node_it) != NULL)
-				{
-					bool should_free;
-					TupleInfo *ti = ts_scan_iterator_tuple_info(&data_node_it);
-					ChunkDataNode *chunk_data_node;
-					Form_chunk_data_node form;
-					MemoryContext old_mcxt;
-					HeapTuple tuple;
-
-					MemoryContextSwitchTo(per_tuple_mcxt);
-					MemoryContextReset(per_tuple_mcxt);
-
-					tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
-					form = (Form_chunk_data_node) GETSTRUCT(tuple);
-					old_mcxt = MemoryContextSwitchTo(ti->mctx);
-					chunk_data_node = palloc(sizeof(ChunkDataNode));
-					memcpy(&chunk_data_node->fd, form, sizeof(FormData_chunk_data_node));
-					chunk_data_node->foreign_server_oid =
-						get_foreign_server_oid(NameStr(form->node_name),
-											   /* missing_ok = */ false);
-					chunk->data_nodes = lappend(chunk->data_nodes, chunk_data_node);
-					MemoryContextSwitchTo(old_mcxt);
-
-					if (should_free)
-						heap_freetuple(tuple);
-
-					MemoryContextSwitchTo(work_mcxt);
-				}
-			}
+			MemoryContextSwitchTo(per_tuple_mcxt);
+			MemoryContextReset(per_tuple_mcxt);
+
+			tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+			form = (Form_chunk_data_node) GETSTRUCT(tuple);
+
+			while (locked_chunks[chunk_index]->fd.id < form->chunk_id)
+				chunk_index++;
+			chunk = locked_chunks[chunk_index];
+			Assert(chunk->fd.id == form->chunk_id && chunk->relkind == RELKIND_FOREIGN_TABLE);
+
+			old_mcxt = MemoryContextSwitchTo(ti->mctx);
+			chunk_data_node = palloc(sizeof(ChunkDataNode));
+			memcpy(&chunk_data_node->fd, form, sizeof(FormData_chunk_data_node));
+			chunk_data_node->foreign_server_oid =
+				get_foreign_server_oid(NameStr(form->node_name),
+									   /* missing_ok = */ false);
+			chunk->data_nodes = lappend(chunk->data_nodes, chunk_data_node);
+			MemoryContextSwitchTo(old_mcxt);
+
+			if (should_free)
+				heap_freetuple(tuple);
+
+			MemoryContextSwitchTo(work_mcxt);
 		}
 
 		ts_scan_iterator_close(&data_node_it);
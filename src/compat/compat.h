@@ -789,4 +789,33 @@ RelationGetSmgr(Relation rel)
 #endif
 #endif
 
+
+/*
+ * MemoryContextMemAllocated was added in PG13, sum the memory reported by the
+ * stats method of the contexts on PG12.
+ */
+#if PG13_LT
+#include <utils/memutils.h>
+
+static inline Size
+MemoryContextMemAllocated(MemoryContext context, bool recurse)
+{
+	MemoryContextCounters counters = { 0 };
+	Size total;
+
+	context->methods->stats(context, NULL, NULL, &counters);
+	total = counters.totalspace;
+
+	if (recurse)
+	{
+		MemoryContext child;
+
+		for (child = context->firstchild; child != NULL; child = child->nextchild)
+			total += MemoryContextMemAllocated(child, true);
+	}
+
+	return total;
+}
+#endif
+
 #endif /* TIMESCALEDB_COMPAT_H */
@@ -39,6 +39,14 @@ static const WithClauseDefinition compress_hypertable_with_clause_def[] = {
 			 .arg_name = "compress_chunk_time_interval",
 			 .type_id = INTERVALOID,
 		},
+		[CompressMinMax] = {
+			 .arg_name = "compress_minmax",
+			 .type_id = TEXTOID,
+		},
+		[CompressBloom] = {
+			 .arg_name = "compress_bloom",
+			 .type_id = TEXTOID,
+		},
 };
 
 WithClauseResult *
@@ -59,6 +67,26 @@ throw_segment_by_error(char *segment_by)
 					 " be a set of columns separated by commas.")));
 }
 
+static inline void
+throw_minmax_error(char *minmax)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_SYNTAX_ERROR),
+			 errmsg("unable to parse min/max option \"%s\"", minmax),
+			 errhint("The option timescaledb.compress_minmax must"
+					 " be a set of columns separated by commas.")));
+}
+
+static inline void
+throw_bloom_error(char *bloom)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_SYNTAX_ERROR),
+			 errmsg("unable to parse bloom filter option \"%s\"", bloom),
+			 errhint("The option timescaledb.compress_bloom must"
+					 " be a set of columns separated by commas.")));
+}
+
 static bool
 select_stmt_as_expected(SelectStmt *stmt)
 {
@@ -73,8 +101,12 @@ select_stmt_as_expected(SelectStmt *stmt)
 	return true;
 }
 
+/*
+ * Parse a comma-separated list of column names, like the one used by the
+ * compress_segmentby and compress_minmax options.
+ */
 static List *
-parse_segment_collist(char *inpstr, Hypertable *hypertable)
+parse_collist(char *inpstr, Hypertable *hypertable, void (*throw_error)(char *))
 {
 	StringInfoData buf;
 	List *parsed;
@@ -87,7 +119,7 @@ parse_segment_collist(char *inpstr, Hypertable *hypertable)
 
 	initStringInfo(&buf);
 
-	/* parse the segment by list exactly how you would a group by */
+	/* parse the column list exactly how you would a group by */
 	appendStringInfo(&buf,
 					 "SELECT FROM %s.%s GROUP BY %s",
 					 quote_identifier(hypertable->fd.schema_name.data),
@@ -100,26 +132,26 @@ parse_segment_collist(char *inpstr, Hypertable *hypertable)
 	}
 	PG_CATCH();
 	{
-		throw_segment_by_error(inpstr);
+		throw_error(inpstr);
 		PG_RE_THROW();
 	}
 	PG_END_TRY();
 
 	if (list_length(parsed) != 1)
-		throw_segment_by_error(inpstr);
+		throw_error(inpstr);
 	if (!IsA(linitial(parsed), RawStmt))
-		throw_segment_by_error(inpstr);
+		throw_error(inpstr);
 	raw = linitial(parsed);
 
 	if (!IsA(raw->stmt, SelectStmt))
-		throw_segment_by_error(inpstr);
+		throw_error(inpstr);
 	select = (SelectStmt *) raw->stmt;
 
 	if (!select_stmt_as_expected(select))
-		throw_segment_by_error(inpstr);
+		throw_error(inpstr);
 
 	if (select->sortClause != NIL)
-		throw_segment_by_error(inpstr);
+		throw_error(inpstr);
 
 	List *collist = NIL;
 	short index = 0;
@@ -129,13 +161,13 @@ parse_segment_collist(char *inpstr, Hypertable *hypertable)
 		CompressedParsedCol *col = (CompressedParsedCol *) palloc(sizeof(*col));
 
 		if (!IsA(lfirst(lc), ColumnRef))
-			throw_segment_by_error(inpstr);
+			throw_error(inpstr);
 		cf = lfirst(lc);
 		if (list_length(cf->fields) != 1)
-			throw_segment_by_error(inpstr);
+			throw_error(inpstr);
 
 		if (!IsA(linitial(cf->fields), String))
-			throw_segment_by_error(inpstr);
+			throw_error(inpstr);
 
 		col->index = index;
 		index++;
@@ -261,7 +293,7 @@ ts_compress_hypertable_parse_segment_by(WithClauseResult *parsed_options, Hypert
 	if (parsed_options[CompressSegmentBy].is_default == false)
 	{
 		Datum textarg = parsed_options[CompressSegmentBy].parsed;
-		return parse_segment_collist(TextDatumGetCString(textarg), hypertable);
+		return parse_collist(TextDatumGetCString(textarg), hypertable, throw_segment_by_error);
 	}
 	else
 		return NIL;
@@ -282,6 +314,36 @@ ts_compress_hypertable_parse_order_by(WithClauseResult *parsed_options, Hypertab
 		return NIL;
 }
 
+/* returns List of CompressedParsedCol
+ * compress_minmax = `col1,col2,col3`
+ */
+List *
+ts_compress_hypertable_parse_minmax(WithClauseResult *parsed_options, Hypertable *hypertable)
+{
+	if (parsed_options[CompressMinMax].is_default == false)
+	{
+		Datum textarg = parsed_options[CompressMinMax].parsed;
+		return parse_collist(TextDatumGetCString(textarg), hypertable, throw_minmax_error);
+	}
+	else
+		return NIL;
+}
+
+/* returns List of CompressedParsedCol
+ * compress_bloom = `col1,col2,col3`
+ */
+List *
+ts_compress_hypertable_parse_bloom(WithClauseResult *parsed_options, Hypertable *hypertable)
+{
+	if (parsed_options[CompressBloom].is_default == false)
+	{
+		Datum textarg = parsed_options[CompressBloom].parsed;
+		return parse_collist(TextDatumGetCString(textarg), hypertable, throw_bloom_error);
+	}
+	else
+		return NIL;
+}
+
 /* returns List of CompressedParsedCol
  * E.g. timescaledb.compress_orderby = 'col1 asc nulls first,col2 desc,col3'
  */
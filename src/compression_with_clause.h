@@ -19,6 +19,8 @@ typedef enum CompressHypertableOption
 	CompressSegmentBy,
 	CompressOrderBy,
 	CompressChunkTimeInterval,
+	CompressMinMax,
+	CompressBloom,
 } CompressHypertableOption;
 
 typedef struct
@@ -34,6 +36,10 @@ extern TSDLLEXPORT List *ts_compress_hypertable_parse_segment_by(WithClauseResul
 																 Hypertable *hypertable);
 extern TSDLLEXPORT List *ts_compress_hypertable_parse_order_by(WithClauseResult *parsed_options,
 															   Hypertable *hypertable);
+extern TSDLLEXPORT List *ts_compress_hypertable_parse_minmax(WithClauseResult *parsed_options,
+															 Hypertable *hypertable);
+extern TSDLLEXPORT List *ts_compress_hypertable_parse_bloom(WithClauseResult *parsed_options,
+															Hypertable *hypertable);
 extern TSDLLEXPORT Interval *
 ts_compress_hypertable_parse_chunk_time_interval(WithClauseResult *parsed_options,
 												 Hypertable *hypertable);
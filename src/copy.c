@@ -34,6 +34,7 @@
 #include <access/xact.h>
 #include <catalog/pg_trigger_d.h>
 #include <commands/copy.h>
+#include <commands/defrem.h>
 #include <commands/tablecmds.h>
 #include <commands/trigger.h>
 #include <executor/executor.h>
@@ -52,13 +53,16 @@
 #include <utils/guc.h>
 #include <utils/hsearch.h>
 #include <utils/lsyscache.h>
+#include <utils/portal.h>
 #include <utils/rel.h>
 #include <utils/rls.h>
+#include <utils/snapmgr.h>
 
 #include "compat/compat.h"
 #include "copy.h"
 #include "cross_module_fn.h"
 #include "dimension.h"
+#include "guc.h"
 #include "hypertable.h"
 #include "nodes/chunk_dispatch.h"
 #include "nodes/chunk_insert_state.h"
@@ -88,6 +92,22 @@
 /* Trim the list of buffers back down to this number after flushing */
 #define MAX_PARTITION_BUFFERS 32
 
+/*
+ * Why the buffered tuples were written out to the chunks. The number of
+ * flushes per reason is reported at the end of the copy.
+ */
+typedef enum TSCopyFlushReason
+{
+	TS_COPY_FLUSH_NONE = -1,
+	TS_COPY_FLUSH_TUPLES,	   /* MAX_BUFFERED_TUPLES tuples are buffered */
+	TS_COPY_FLUSH_BYTES,	   /* the buffered tuples exceed the size limit */
+	TS_COPY_FLUSH_BUFFER_FULL, /* a chunk has buffered its share of the memory budget */
+	TS_COPY_FLUSH_BUFFERS,	   /* too many chunks have a buffer */
+	TS_COPY_FLUSH_TRIGGERS,	   /* a chunk with row triggers needs to see the tuples */
+	TS_COPY_FLUSH_END,		   /* the copy is finished */
+	_TS_COPY_FLUSH_MAX,
+} TSCopyFlushReason;
+
 /* Stores multi-insert data related to a single relation in CopyFrom. */
 typedef struct TSCopyMultiInsertBuffer
 {
@@ -99,8 +119,10 @@ typedef struct TSCopyMultiInsertBuffer
 	TupleDesc tupdesc;
 	TupleTableSlot *slots[MAX_BUFFERED_TUPLES]; /* Array to store tuples */
 	Point *point;								/* The point in space of this buffer */
+	int32 chunk_id;								/* The chunk of this buffer */
 	BulkInsertState bistate;					/* BulkInsertState for this buffer */
 	int nused;									/* number of 'slots' containing tuples */
+	int64 bytes;								/* number of bytes of the buffered tuples */
 	uint64 linenos[MAX_BUFFERED_TUPLES];		/* Line # of tuple in copy
 												 * stream */
 } TSCopyMultiInsertBuffer;
@@ -116,18 +138,32 @@ typedef struct TSCopyMultiInsertBuffer
  * Chunks can be closed (e.g., due to timescaledb.max_open_chunks_per_insert).
  * When ts_chunk_dispatch_get_chunk_insert_state is called again for a closed
  * chunk, a new ChunkInsertState is returned.
+ *
+ * With a memory budget (timescaledb.copy_buffer_memory), the buffers are not
+ * limited to MAX_BUFFERED_TUPLES tuples and MAX_BUFFERED_BYTES bytes in total.
+ * Each chunk that has tuples buffered gets an equal share of the budget, which
+ * is turned into a number of tuples using the average width of the tuples
+ * copied so far, and only the buffer that reaches its share is flushed. The
+ * number of buffers kept around is limited by the budget as well.
  */
 typedef struct TSCopyMultiInsertInfo
 {
 	HTAB *multiInsertBuffers; /* Maps the chunk ids to the buffers (chunkid ->
 								 TSCopyMultiInsertBuffer) */
+	TSCopyMultiInsertBuffer *lastBuffer; /* The buffer returned by the last lookup */
 	int bufferedTuples;		  /* number of tuples buffered over all buffers */
-	int bufferedBytes;		  /* number of bytes from all buffered tuples */
-	CopyChunkState *ccstate;  /* Copy chunk state for this TSCopyMultiInsertInfo */
-	EState *estate;			  /* Executor state used for COPY */
-	CommandId mycid;		  /* Command Id used for COPY */
-	int ti_options;			  /* table insert options */
-	Hypertable *ht;			  /* The hypertable for the inserts */
+	int64 bufferedBytes;	  /* number of bytes from all buffered tuples */
+	int activeBuffers;		  /* number of buffers with buffered tuples */
+	int64 memoryBudget;		  /* memory budget of the buffers in bytes, or 0 */
+	int64 totalTuples;		  /* number of tuples buffered during the copy */
+	int64 totalBytes;		  /* number of bytes of the tuples buffered during the copy */
+	int64 batches;			  /* number of table_multi_insert calls */
+	int flushes[_TS_COPY_FLUSH_MAX]; /* number of flushes per reason */
+	CopyChunkState *ccstate;		 /* Copy chunk state for this TSCopyMultiInsertInfo */
+	EState *estate;					 /* Executor state used for COPY */
+	CommandId mycid;				 /* Command Id used for COPY */
+	int ti_options;					 /* table insert options */
+	Hypertable *ht;					 /* The hypertable for the inserts */
 } TSCopyMultiInsertInfo;
 
 /*
@@ -179,6 +215,7 @@ copy_chunk_state_create(Hypertable *ht, Relation rel, CopyFromFunc from_func, Co
 	ccstate->scandesc = scandesc;
 	ccstate->next_copy_from = from_func;
 	ccstate->where_clause = NULL;
+	ccstate->freeze = false;
 
 	return ccstate;
 }
@@ -196,6 +233,8 @@ TSCopyMultiInsertBufferInit(ChunkInsertState *cis, Point *point)
 	memset(buffer->slots, 0, sizeof(TupleTableSlot *) * MAX_BUFFERED_TUPLES);
 	buffer->bistate = GetBulkInsertState();
 	buffer->nused = 0;
+	buffer->bytes = 0;
+	buffer->chunk_id = cis->chunk_id;
 
 	buffer->point = palloc(POINT_SIZE(point->num_coords));
 	memcpy(buffer->point, point, POINT_SIZE(point->num_coords));
@@ -229,6 +268,14 @@ TSCopyMultiInsertInfoGetOrSetupBuffer(TSCopyMultiInsertInfo *miinfo, ChunkInsert
 	Assert(point != NULL);
 
 	chunk_id = cis->chunk_id;
+
+	/*
+	 * Consecutive tuples mostly go into the same chunk, so check the buffer of
+	 * the previous tuple before doing a hash lookup for every tuple.
+	 */
+	if (miinfo->lastBuffer != NULL && miinfo->lastBuffer->chunk_id == chunk_id)
+		return miinfo->lastBuffer;
+
 	MultiInsertBufferEntry *entry =
 		hash_search(miinfo->multiInsertBuffers, &chunk_id, HASH_ENTER, &found);
 
@@ -238,6 +285,7 @@ TSCopyMultiInsertInfoGetOrSetupBuffer(TSCopyMultiInsertInfo *miinfo, ChunkInsert
 		entry->buffer = TSCopyMultiInsertBufferInit(cis, point);
 	}
 
+	miinfo->lastBuffer = entry->buffer;
 	return entry->buffer;
 }
 
@@ -265,8 +313,15 @@ TSCopyMultiInsertInfoInit(TSCopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
 						  Hypertable *ht)
 {
 	miinfo->multiInsertBuffers = TSCopyCreateNewInsertBufferHashMap();
+	miinfo->lastBuffer = NULL;
 	miinfo->bufferedTuples = 0;
 	miinfo->bufferedBytes = 0;
+	miinfo->activeBuffers = 0;
+	miinfo->memoryBudget = (int64) ts_guc_copy_buffer_memory * 1024;
+	miinfo->totalTuples = 0;
+	miinfo->totalBytes = 0;
+	miinfo->batches = 0;
+	memset(miinfo->flushes, 0, sizeof(miinfo->flushes));
 	miinfo->ccstate = ccstate;
 	miinfo->estate = estate;
 	miinfo->mycid = mycid;
@@ -275,21 +330,86 @@ TSCopyMultiInsertInfoInit(TSCopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
 }
 
 /*
- * Returns true if the buffers are full.
+ * The number of tuples a chunk can buffer with its share of the memory budget.
  */
-static inline bool
-TSCopyMultiInsertInfoIsFull(TSCopyMultiInsertInfo *miinfo)
+static inline int
+TSCopyMultiInsertInfoBufferTarget(TSCopyMultiInsertInfo *miinfo)
 {
-	if (miinfo->bufferedTuples >= MAX_BUFFERED_TUPLES ||
-		miinfo->bufferedBytes >= MAX_BUFFERED_BYTES)
-		return true;
+	int64 width = Max(miinfo->totalBytes / Max(miinfo->totalTuples, 1), 1);
+	int64 target = miinfo->memoryBudget / (width * Max(miinfo->activeBuffers, 1));
 
-	return false;
+	return (int) Min(Max(target, 1), MAX_BUFFERED_TUPLES);
+}
+
+/*
+ * The number of buffers that are kept after flushing. Every buffer takes
+ * memory even when it is empty, so with a memory budget, the budget decides
+ * how many chunks can keep their buffer.
+ */
+static inline int
+TSCopyMultiInsertInfoMaxBuffers(TSCopyMultiInsertInfo *miinfo)
+{
+	if (miinfo->memoryBudget == 0)
+		return MAX_PARTITION_BUFFERS;
+
+	return (int) Min(Max(miinfo->memoryBudget / (int64) sizeof(TSCopyMultiInsertBuffer),
+						 MAX_PARTITION_BUFFERS),
+					 INT_MAX);
+}
+
+/*
+ * Returns why the buffers need to be flushed after a tuple was added to
+ * 'buffer', or TS_COPY_FLUSH_NONE if they don't.
+ */
+static inline TSCopyFlushReason
+TSCopyMultiInsertInfoFlushReason(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuffer *buffer)
+{
+	if (miinfo->memoryBudget == 0)
+	{
+		if (miinfo->bufferedTuples >= MAX_BUFFERED_TUPLES)
+			return TS_COPY_FLUSH_TUPLES;
+		if (miinfo->bufferedBytes >= MAX_BUFFERED_BYTES)
+			return TS_COPY_FLUSH_BYTES;
+		return TS_COPY_FLUSH_NONE;
+	}
+
+	if (miinfo->bufferedBytes >= miinfo->memoryBudget)
+		return TS_COPY_FLUSH_BYTES;
+	if (buffer->nused >= TSCopyMultiInsertInfoBufferTarget(miinfo))
+		return TS_COPY_FLUSH_BUFFER_FULL;
+	if (hash_get_num_entries(miinfo->multiInsertBuffers) > TSCopyMultiInsertInfoMaxBuffers(miinfo))
+		return TS_COPY_FLUSH_BUFFERS;
+
+	return TS_COPY_FLUSH_NONE;
 }
 
 /*
  * Write the tuples stored in 'buffer' out to the table.
  */
+/*
+ * Get the insert options for a chunk. A chunk created or truncated in the
+ * current subtransaction holds no tuples visible to anyone else, so with COPY
+ * FREEZE its tuples can be written frozen, which also marks the pages filled by
+ * multi-inserts all-visible. Chunks that existed before are loaded as usual,
+ * rather than failing the whole COPY like PostgreSQL does for a plain table.
+ * With timescaledb.enable_append_only_inserts, the tuples go to the end of
+ * every chunk without looking up the free space map.
+ */
+static int
+copy_chunk_insert_options(const CopyChunkState *ccstate, Relation chunk_rel, int ti_options)
+{
+	SubTransactionId subid = GetCurrentSubTransactionId();
+
+	if (ccstate->freeze &&
+		(chunk_rel->rd_createSubid == subid || chunk_rel->rd_newRelfilenodeSubid == subid))
+		ti_options |= HEAP_INSERT_SKIP_FSM | HEAP_INSERT_FROZEN;
+
+	if (ts_guc_enable_append_only_inserts && chunk_rel->rd_rel->relkind == RELKIND_RELATION)
+		ti_options |= HEAP_INSERT_SKIP_FSM;
+
+	return ti_options;
+}
+
 static inline int
 TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuffer *buffer)
 {
@@ -305,6 +425,8 @@ TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuf
 	int nused = buffer->nused;
 	TupleTableSlot **slots = buffer->slots;
 
+	Assert(nused > 0);
+
 	/*
 	 * table_multi_insert and reinitialization of the chunk insert state may
 	 * leak memory, so switch to short-lived memory context before calling it.
@@ -329,6 +451,9 @@ TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuf
 
 	ResultRelInfo *resultRelInfo = cis->result_relation_info;
 
+	ti_options =
+		copy_chunk_insert_options(miinfo->ccstate, resultRelInfo->ri_RelationDesc, ti_options);
+
 	/*
 	 * Add context information to the copy state, which is used to display
 	 * error messages with additional details. Providing this information is
@@ -413,7 +538,12 @@ TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuf
 	}
 
 	/* Mark that all slots are free */
+	miinfo->bufferedTuples -= nused;
+	miinfo->bufferedBytes -= buffer->bytes;
+	miinfo->activeBuffers--;
+	miinfo->batches++;
 	buffer->nused = 0;
+	buffer->bytes = 0;
 
 	/* Chunk could be closed on a subsequent call of ts_chunk_dispatch_get_chunk_insert_state
 	 * (e.g., due to timescaledb.max_open_chunks_per_insert). So, ensure the bulk insert is
@@ -489,11 +619,12 @@ TSCmpBuffersByUsage(const ListCell *a, const ListCell *b)
 
 /*
  * Flush all buffers by writing the tuples to the chunks. In addition, trim down the
- * amount of multi-insert buffers to MAX_PARTITION_BUFFERS by deleting the least used
- * buffers (the buffers that store least tuples).
+ * amount of multi-insert buffers to TSCopyMultiInsertInfoMaxBuffers by deleting the least
+ * used buffers (the buffers that store least tuples).
  */
 static inline void
-TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_cis)
+TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_cis,
+						   TSCopyFlushReason reason)
 {
 	HASH_SEQ_STATUS status;
 	MultiInsertBufferEntry *entry;
@@ -504,6 +635,7 @@ TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_
 	List *buffer_list = NIL;
 	ListCell *lc;
 
+	miinfo->flushes[reason]++;
 	current_multi_insert_buffers = hash_get_num_entries(miinfo->multiInsertBuffers);
 
 	/* Create a list of buffers that can be sorted by usage */
@@ -513,7 +645,8 @@ TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_
 		buffer_list = lappend(buffer_list, entry->buffer);
 	}
 
-	buffers_to_delete = Max(current_multi_insert_buffers - MAX_PARTITION_BUFFERS, 0);
+	buffers_to_delete =
+		Max(current_multi_insert_buffers - TSCopyMultiInsertInfoMaxBuffers(miinfo), 0);
 
 	/* Sorting is only needed if we want to remove the least used buffers */
 	if (buffers_to_delete > 0)
@@ -523,7 +656,11 @@ TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_
 	foreach (lc, buffer_list)
 	{
 		TSCopyMultiInsertBuffer *buffer = (TSCopyMultiInsertBuffer *) lfirst(lc);
-		flushed_chunk_id = TSCopyMultiInsertBufferFlush(miinfo, buffer);
+
+		/* Nothing to write for the chunks that got no tuples since the last flush */
+		if (buffer->nused > 0)
+			TSCopyMultiInsertBufferFlush(miinfo, buffer);
+		flushed_chunk_id = buffer->chunk_id;
 
 		if (buffers_to_delete > 0)
 		{
@@ -533,6 +670,8 @@ TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_
 			 */
 			if (cur_cis == NULL || flushed_chunk_id != cur_cis->chunk_id)
 			{
+				if (buffer == miinfo->lastBuffer)
+					miinfo->lastBuffer = NULL;
 				TSCopyMultiInsertBufferCleanup(miinfo, buffer);
 				hash_search(miinfo->multiInsertBuffers, &flushed_chunk_id, HASH_REMOVE, &found);
 				Assert(found);
@@ -544,8 +683,20 @@ TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_
 	list_free(buffer_list);
 
 	/* All buffers have been flushed */
-	miinfo->bufferedTuples = 0;
-	miinfo->bufferedBytes = 0;
+	Assert(miinfo->bufferedTuples == 0);
+	Assert(miinfo->bufferedBytes == 0);
+	Assert(miinfo->activeBuffers == 0);
+}
+
+/*
+ * Flush only the given buffer, which has buffered its share of the memory
+ * budget. The buffers of the other chunks keep filling up.
+ */
+static inline void
+TSCopyMultiInsertInfoFlushBuffer(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuffer *buffer)
+{
+	miinfo->flushes[TS_COPY_FLUSH_BUFFER_FULL]++;
+	TSCopyMultiInsertBufferFlush(miinfo, buffer);
 }
 
 /*
@@ -556,7 +707,7 @@ TSCopyMultiInsertInfoFlush(TSCopyMultiInsertInfo *miinfo, ChunkInsertState *cur_
 static inline void
 TSCopyMultiInsertInfoFlushAndCleanup(TSCopyMultiInsertInfo *miinfo)
 {
-	TSCopyMultiInsertInfoFlush(miinfo, NULL);
+	TSCopyMultiInsertInfoFlush(miinfo, NULL, TS_COPY_FLUSH_END);
 
 	HASH_SEQ_STATUS status;
 	MultiInsertBufferEntry *entry;
@@ -570,6 +721,26 @@ TSCopyMultiInsertInfoFlushAndCleanup(TSCopyMultiInsertInfo *miinfo)
 	}
 
 	hash_destroy(miinfo->multiInsertBuffers);
+	miinfo->lastBuffer = NULL;
+
+	ereport(DEBUG2,
+			(errmsg("copy inserted " INT64_FORMAT " tuples in " INT64_FORMAT " batches",
+					miinfo->totalTuples,
+					miinfo->batches),
+			 errdetail("Flushes: %d for tuples, %d for bytes, %d for full buffers, %d for the "
+					   "number of buffers, %d for triggers, %d at the end.",
+					   miinfo->flushes[TS_COPY_FLUSH_TUPLES],
+					   miinfo->flushes[TS_COPY_FLUSH_BYTES],
+					   miinfo->flushes[TS_COPY_FLUSH_BUFFER_FULL],
+					   miinfo->flushes[TS_COPY_FLUSH_BUFFERS],
+					   miinfo->flushes[TS_COPY_FLUSH_TRIGGERS],
+					   miinfo->flushes[TS_COPY_FLUSH_END])));
+
+	/* The flushes are also counted in the ingest statistics of the hypertable */
+	StaticAssertStmt(_TS_COPY_FLUSH_MAX == INGEST_STATS_COPY_FLUSH_REASONS,
+					 "the ingest statistics must count every flush reason");
+	for (int reason = 0; reason < _TS_COPY_FLUSH_MAX; reason++)
+		miinfo->ccstate->dispatch->stats.copy_flushes[reason] += miinfo->flushes[reason];
 }
 
 /*
@@ -624,23 +795,36 @@ TSCopyMultiInsertInfoStore(TSCopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
 	buffer->linenos[buffer->nused] = lineno;
 
 	/* Record this slot as being used */
+	if (buffer->nused == 0)
+		miinfo->activeBuffers++;
 	buffer->nused++;
 
 	/* Update how many tuples are stored and their size */
 	miinfo->bufferedTuples++;
+	miinfo->totalTuples++;
 
 	/*
 	 * Note: There is no reliable way to determine the in-memory size of a virtual
 	 * tuple. So, we perform flushing in PG < 14 only based on the number of buffered
 	 * tuples and not based on the size.
+	 *
+	 * The buffer sizes derived from the memory budget need the width of the tuples
+	 * in all versions. The buffered slots of heap chunks are materialized, so the
+	 * size of their heap tuple is used, which is also closer to the memory they take.
 	 */
+	int64 tuplen = 0;
+
 #if PG14_GE
 	if (cstate != NULL)
-	{
-		int tuplen = cstate->line_buf.len;
-		miinfo->bufferedBytes += tuplen;
-	}
+		tuplen = cstate->line_buf.len;
 #endif
+
+	if (miinfo->memoryBudget > 0 && TTS_IS_BUFFERTUPLE(slot))
+		tuplen = ((BufferHeapTupleTableSlot *) slot)->base.tuple->t_len;
+
+	buffer->bytes += tuplen;
+	miinfo->bufferedBytes += tuplen;
+	miinfo->totalBytes += tuplen;
 }
 
 static void
@@ -762,6 +946,21 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, MemoryConte
 							RelationGetRelationName(ccstate->rel))));
 	}
 
+	/*
+	 * COPY FREEZE makes the new tuples visible to all snapshots, so, like
+	 * PostgreSQL, refuse it if there are snapshots or cursors in this
+	 * transaction that should not see them. The catalog snapshot does not
+	 * count; ongoing catalog scans register their own snapshot.
+	 */
+	if (ccstate->freeze)
+	{
+		InvalidateCatalogSnapshot();
+		if (!ThereAreNoPriorRegisteredSnapshots() || !ThereAreNoReadyPortals())
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_TRANSACTION_STATE),
+					 errmsg("cannot perform COPY FREEZE because of prior transaction activity")));
+	}
+
 	/*----------
 	 * Check to see if we can avoid writing WAL
 	 *
@@ -974,11 +1173,15 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, MemoryConte
 			 * batching, so rows are visible to triggers etc.
 			 */
 			if (insertMethod == CIM_MULTI_CONDITIONAL)
-				TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis);
+				TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis, TS_COPY_FLUSH_TRIGGERS);
 
 			currentTupleInsertMethod = CIM_SINGLE;
 		}
 
+		/* The rows going into a compressed chunk are buffered by the chunk insert state */
+		if (cis->compress_state != NULL)
+			currentTupleInsertMethod = CIM_SINGLE;
+
 		/* Convert the tuple to match the chunk's rowtype */
 		if (currentTupleInsertMethod == CIM_SINGLE)
 		{
@@ -1025,6 +1228,10 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, MemoryConte
 				continue;
 		}
 
+		/* Move the compressed rows that could conflict with the row to the chunk */
+		if (cis->decompress_for_insert)
+			ts_cm_functions->decompress_batches_for_insert(cis, myslot);
+
 		/*
 		 * Set the result relation in the executor state to the target chunk.
 		 * This makes sure that the tuple gets inserted into the correct
@@ -1069,13 +1276,22 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, MemoryConte
 				ExecConstraints(resultRelInfo, myslot, estate);
 			}
 
-			if (currentTupleInsertMethod == CIM_SINGLE)
+			ts_chunk_insert_state_last_point_store(cis, myslot);
+
+			if (currentTupleInsertMethod == CIM_SINGLE && cis->compress_state != NULL)
+			{
+				/* buffer the tuple to compress it into a batch of the compressed chunk */
+				ts_cm_functions->compress_row_exec(cis->compress_state, myslot);
+			}
+			else if (currentTupleInsertMethod == CIM_SINGLE)
 			{
 				/* OK, store the tuple and create index entries for it */
 				table_tuple_insert(resultRelInfo->ri_RelationDesc,
 								   myslot,
 								   mycid,
-								   ti_options,
+								   copy_chunk_insert_options(ccstate,
+															 resultRelInfo->ri_RelationDesc,
+															 ti_options),
 								   bistate);
 
 				if (resultRelInfo->ri_NumIndices > 0)
@@ -1110,16 +1326,24 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, MemoryConte
 
 				/*
 				 * If enough inserts have queued up, then flush all
-				 * buffers out to their tables.
+				 * buffers out to their tables. When the chunk has only
+				 * filled its share of the memory budget, flush just its
+				 * buffer.
 				 */
-				if (TSCopyMultiInsertInfoIsFull(&multiInsertInfo))
+				TSCopyFlushReason reason =
+					TSCopyMultiInsertInfoFlushReason(&multiInsertInfo, buffer);
+
+				if (reason == TS_COPY_FLUSH_BUFFER_FULL)
+					TSCopyMultiInsertInfoFlushBuffer(&multiInsertInfo, buffer);
+				else if (reason != TS_COPY_FLUSH_NONE)
 				{
 					ereport(DEBUG2,
-							(errmsg("flush called with %d bytes and %d buffered tuples",
+							(errmsg("flush called with " INT64_FORMAT
+									" bytes and %d buffered tuples",
 									multiInsertInfo.bufferedBytes,
 									multiInsertInfo.bufferedTuples)));
 
-					TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis);
+					TSCopyMultiInsertInfoFlush(&multiInsertInfo, cis, reason);
 				}
 			}
 
@@ -1332,6 +1556,7 @@ timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *proces
 	Node *where_clause = NULL;
 	ParseState *pstate;
 	MemoryContext copycontext = NULL;
+	ListCell *lc;
 
 	/* Disallow COPY to/from file or program except to superusers. */
 	if (!pipe && !superuser())
@@ -1401,6 +1626,15 @@ timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *proces
 	ccstate = copy_chunk_state_create(ht, rel, next_copy_from, cstate, NULL);
 	ccstate->where_clause = where_clause;
 
+	/* The options were already validated by BeginCopyFrom() */
+	foreach (lc, stmt->options)
+	{
+		DefElem *defel = lfirst_node(DefElem, lc);
+
+		if (strcmp(defel->defname, "freeze") == 0)
+			ccstate->freeze = defGetBoolean(defel);
+	}
+
 	if (hypertable_is_distributed(ht))
 		*processed = ts_cm_functions->distributed_copy(stmt, ccstate, attnums);
 	else
@@ -30,6 +30,7 @@ typedef struct CopyChunkState
 	CopyFromState cstate;
 	TableScanDesc scandesc;
 	Node *where_clause;
+	bool freeze; /* COPY FREEZE, for chunks new in this subtransaction */
 } CopyChunkState;
 
 extern void timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *processed,
@@ -29,24 +29,45 @@ CROSSMODULE_WRAPPER(policy_compression_add);
 CROSSMODULE_WRAPPER(policy_compression_remove);
 CROSSMODULE_WRAPPER(policy_recompression_proc);
 CROSSMODULE_WRAPPER(policy_compression_check);
+CROSSMODULE_WRAPPER(policy_compression_batch_add);
+CROSSMODULE_WRAPPER(policy_compression_batch_remove);
+CROSSMODULE_WRAPPER(policy_compression_batch_check);
 CROSSMODULE_WRAPPER(policy_refresh_cagg_add);
 CROSSMODULE_WRAPPER(policy_refresh_cagg_proc);
+CROSSMODULE_WRAPPER(policy_refresh_cagg_window_proc);
 CROSSMODULE_WRAPPER(policy_refresh_cagg_check);
 CROSSMODULE_WRAPPER(policy_refresh_cagg_remove);
 CROSSMODULE_WRAPPER(policy_reorder_add);
 CROSSMODULE_WRAPPER(policy_reorder_proc);
 CROSSMODULE_WRAPPER(policy_reorder_check);
 CROSSMODULE_WRAPPER(policy_reorder_remove);
+CROSSMODULE_WRAPPER(policy_chunk_precreation_add);
+CROSSMODULE_WRAPPER(policy_chunk_precreation_proc);
+CROSSMODULE_WRAPPER(policy_chunk_precreation_check);
+CROSSMODULE_WRAPPER(policy_chunk_precreation_remove);
+CROSSMODULE_WRAPPER(policy_distributed_stats_add);
+CROSSMODULE_WRAPPER(policy_distributed_stats_proc);
+CROSSMODULE_WRAPPER(policy_distributed_stats_check);
+CROSSMODULE_WRAPPER(policy_distributed_stats_remove);
+CROSSMODULE_WRAPPER(policy_invalidation_log_compaction_add);
+CROSSMODULE_WRAPPER(policy_invalidation_log_compaction_proc);
+CROSSMODULE_WRAPPER(policy_invalidation_log_compaction_check);
+CROSSMODULE_WRAPPER(policy_invalidation_log_compaction_remove);
 CROSSMODULE_WRAPPER(policy_retention_add);
 CROSSMODULE_WRAPPER(policy_retention_proc);
 CROSSMODULE_WRAPPER(policy_retention_check);
 CROSSMODULE_WRAPPER(policy_retention_remove);
+CROSSMODULE_WRAPPER(policy_vacuum_add);
+CROSSMODULE_WRAPPER(policy_vacuum_proc);
+CROSSMODULE_WRAPPER(policy_vacuum_check);
+CROSSMODULE_WRAPPER(policy_vacuum_remove);
 
 CROSSMODULE_WRAPPER(job_add);
 CROSSMODULE_WRAPPER(job_delete);
 CROSSMODULE_WRAPPER(job_run);
 CROSSMODULE_WRAPPER(job_alter);
 CROSSMODULE_WRAPPER(job_alter_set_hypertable_id);
+CROSSMODULE_WRAPPER(job_set_concurrency_class);
 
 CROSSMODULE_WRAPPER(reorder_chunk);
 CROSSMODULE_WRAPPER(move_chunk);
@@ -73,6 +94,8 @@ CROSSMODULE_WRAPPER(compressed_data_send);
 CROSSMODULE_WRAPPER(compressed_data_recv);
 CROSSMODULE_WRAPPER(compressed_data_in);
 CROSSMODULE_WRAPPER(compressed_data_out);
+CROSSMODULE_WRAPPER(compressed_data_agg_transfn);
+CROSSMODULE_WRAPPER(compressed_data_agg_finalfn);
 CROSSMODULE_WRAPPER(deltadelta_compressor_append);
 CROSSMODULE_WRAPPER(deltadelta_compressor_finish);
 CROSSMODULE_WRAPPER(gorilla_compressor_append);
@@ -84,6 +107,8 @@ CROSSMODULE_WRAPPER(array_compressor_finish);
 CROSSMODULE_WRAPPER(create_compressed_chunk);
 CROSSMODULE_WRAPPER(compress_chunk);
 CROSSMODULE_WRAPPER(decompress_chunk);
+CROSSMODULE_WRAPPER(recompress_chunk_segmentwise);
+CROSSMODULE_WRAPPER(bloom1_contains);
 
 /* continuous aggregate */
 CROSSMODULE_WRAPPER(continuous_agg_invalidation_trigger);
@@ -106,6 +131,8 @@ CROSSMODULE_WRAPPER(data_node_alter);
 CROSSMODULE_WRAPPER(chunk_drop_replica);
 CROSSMODULE_WRAPPER(chunk_freeze_chunk);
 CROSSMODULE_WRAPPER(chunk_unfreeze_chunk);
+CROSSMODULE_WRAPPER(chunk_merge_chunks);
+CROSSMODULE_WRAPPER(chunk_rebalance_chunks);
 CROSSMODULE_WRAPPER(chunks_drop_stale);
 
 CROSSMODULE_WRAPPER(chunk_set_default_data_node);
@@ -119,6 +146,7 @@ CROSSMODULE_WRAPPER(timescaledb_fdw_validator);
 CROSSMODULE_WRAPPER(remote_txn_id_in);
 CROSSMODULE_WRAPPER(remote_txn_id_out);
 CROSSMODULE_WRAPPER(remote_txn_heal_data_node);
+CROSSMODULE_WRAPPER(remote_txn_heal_data_nodes);
 CROSSMODULE_WRAPPER(remote_connection_cache_show);
 CROSSMODULE_WRAPPER(dist_remote_hypertable_info);
 CROSSMODULE_WRAPPER(dist_remote_chunk_info);
@@ -331,6 +359,17 @@ continuous_agg_call_invalidation_trigger_default(int32 hypertable_id, Relation c
 	pg_unreachable();
 }
 
+static void
+continuous_agg_add_invalidation_range_default(int32 hypertable_id,
+											  bool is_distributed_hypertable_trigger,
+											  int32 parent_hypertable_id, Oid chunk_relid,
+											  int64 lowest_modified_value,
+											  int64 greatest_modified_value)
+{
+	error_no_default_fn_community();
+	pg_unreachable();
+}
+
 static Datum
 empty_fn(PG_FUNCTION_ARGS)
 {
@@ -387,6 +426,13 @@ update_compressed_chunk_relstats_default(Oid uncompressed_relid, Oid compressed_
 	error_no_default_fn_community();
 }
 
+static int64
+compressed_chunk_drop_batches_default(const Hypertable *ht, const Chunk *chunk, int64 older_than)
+{
+	error_no_default_fn_community();
+	pg_unreachable();
+}
+
 static void
 dist_update_stale_chunk_metadata_default(Chunk *new_chunk, List *chunk_data_nodes)
 {
@@ -436,22 +482,43 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.policy_compression_remove = error_no_default_fn_pg_community,
 	.policy_recompression_proc = error_no_default_fn_pg_community,
 	.policy_compression_check = error_no_default_fn_pg_community,
+	.policy_compression_batch_add = error_no_default_fn_pg_community,
+	.policy_compression_batch_remove = error_no_default_fn_pg_community,
+	.policy_compression_batch_check = error_no_default_fn_pg_community,
 	.policy_refresh_cagg_add = error_no_default_fn_pg_community,
 	.policy_refresh_cagg_proc = error_no_default_fn_pg_community,
+	.policy_refresh_cagg_window_proc = error_no_default_fn_pg_community,
 	.policy_refresh_cagg_check = error_no_default_fn_pg_community,
 	.policy_refresh_cagg_remove = error_no_default_fn_pg_community,
 	.policy_reorder_add = error_no_default_fn_pg_community,
 	.policy_reorder_proc = error_no_default_fn_pg_community,
 	.policy_reorder_check = error_no_default_fn_pg_community,
 	.policy_reorder_remove = error_no_default_fn_pg_community,
+	.policy_chunk_precreation_add = error_no_default_fn_pg_community,
+	.policy_chunk_precreation_proc = error_no_default_fn_pg_community,
+	.policy_chunk_precreation_check = error_no_default_fn_pg_community,
+	.policy_chunk_precreation_remove = error_no_default_fn_pg_community,
+	.policy_distributed_stats_add = error_no_default_fn_pg_community,
+	.policy_distributed_stats_proc = error_no_default_fn_pg_community,
+	.policy_distributed_stats_check = error_no_default_fn_pg_community,
+	.policy_distributed_stats_remove = error_no_default_fn_pg_community,
+	.policy_invalidation_log_compaction_add = error_no_default_fn_pg_community,
+	.policy_invalidation_log_compaction_proc = error_no_default_fn_pg_community,
+	.policy_invalidation_log_compaction_check = error_no_default_fn_pg_community,
+	.policy_invalidation_log_compaction_remove = error_no_default_fn_pg_community,
 	.policy_retention_add = error_no_default_fn_pg_community,
 	.policy_retention_proc = error_no_default_fn_pg_community,
 	.policy_retention_check = error_no_default_fn_pg_community,
 	.policy_retention_remove = error_no_default_fn_pg_community,
+	.policy_vacuum_add = error_no_default_fn_pg_community,
+	.policy_vacuum_proc = error_no_default_fn_pg_community,
+	.policy_vacuum_check = error_no_default_fn_pg_community,
+	.policy_vacuum_remove = error_no_default_fn_pg_community,
 
 	.job_add = error_no_default_fn_pg_community,
 	.job_alter = error_no_default_fn_pg_community,
 	.job_alter_set_hypertable_id = error_no_default_fn_pg_community,
+	.job_set_concurrency_class = error_no_default_fn_pg_community,
 	.job_delete = error_no_default_fn_pg_community,
 	.job_run = error_no_default_fn_pg_community,
 	.job_execute = job_execute_default_fn,
@@ -475,6 +542,7 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.process_cagg_viewstmt = process_cagg_viewstmt_default,
 	.continuous_agg_invalidation_trigger = error_no_default_fn_pg_community,
 	.continuous_agg_call_invalidation_trigger = continuous_agg_call_invalidation_trigger_default,
+	.continuous_agg_add_invalidation_range = continuous_agg_add_invalidation_range_default,
 	.continuous_agg_refresh = error_no_default_fn_pg_community,
 	.continuous_agg_invalidate_raw_ht = continuous_agg_invalidate_raw_ht_all_default,
 	.continuous_agg_invalidate_mat_ht = continuous_agg_invalidate_mat_ht_all_default,
@@ -493,10 +561,14 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.compressed_data_recv = error_no_default_fn_pg_community,
 	.compressed_data_in = process_compressed_data_in,
 	.compressed_data_out = process_compressed_data_out,
+	.compressed_data_agg_transfn = error_no_default_fn_pg_community,
+	.compressed_data_agg_finalfn = error_no_default_fn_pg_community,
 	.process_compress_table = process_compress_table_default,
 	.create_compressed_chunk = error_no_default_fn_pg_community,
 	.compress_chunk = error_no_default_fn_pg_community,
 	.decompress_chunk = error_no_default_fn_pg_community,
+	.recompress_chunk_segmentwise = error_no_default_fn_pg_community,
+	.bloom1_contains = error_no_default_fn_pg_community,
 	.compressed_data_decompress_forward = error_no_default_fn_pg_community,
 	.compressed_data_decompress_reverse = error_no_default_fn_pg_community,
 	.deltadelta_compressor_append = error_no_default_fn_pg_community,
@@ -511,6 +583,7 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.compress_row_exec = NULL,
 	.compress_row_end = NULL,
 	.compress_row_destroy = NULL,
+	.decompress_batches_for_insert = NULL,
 	.data_node_add = error_no_default_fn_pg_community,
 	.data_node_delete = error_no_default_fn_pg_community,
 	.data_node_attach = error_no_default_fn_pg_community,
@@ -528,6 +601,8 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.chunk_drop_replica = error_no_default_fn_pg_community,
 	.chunk_freeze_chunk = error_no_default_fn_pg_community,
 	.chunk_unfreeze_chunk = error_no_default_fn_pg_community,
+	.chunk_merge_chunks = error_no_default_fn_pg_community,
+	.chunk_rebalance_chunks = error_no_default_fn_pg_community,
 	.chunks_drop_stale = error_no_default_fn_pg_community,
 	.hypertable_make_distributed = hypertable_make_distributed_default_fn,
 	.get_and_validate_data_node_list = get_and_validate_data_node_list_default_fn,
@@ -537,6 +612,7 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.remote_txn_id_in = error_no_default_fn_pg_community,
 	.remote_txn_id_out = error_no_default_fn_pg_community,
 	.remote_txn_heal_data_node = error_no_default_fn_pg_community,
+	.remote_txn_heal_data_nodes = error_no_default_fn_pg_community,
 	.remote_connection_cache_show = error_no_default_fn_pg_community,
 	.distributed_insert_path_create = distributed_insert_path_create_default,
 	.distributed_copy = distributed_copy_default,
@@ -557,6 +633,7 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.chunk_create_replica_table = error_no_default_fn_pg_community,
 	.hypertable_distributed_set_replication_factor = error_no_default_fn_pg_community,
 	.update_compressed_chunk_relstats = update_compressed_chunk_relstats_default,
+	.compressed_chunk_drop_batches = compressed_chunk_drop_batches_default,
 	.health_check = error_no_default_fn_pg_community,
 };
 
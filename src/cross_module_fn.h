@@ -35,6 +35,10 @@ typedef struct Hypertable Hypertable;
 typedef struct Chunk Chunk;
 typedef struct CopyChunkState CopyChunkState;
 typedef struct CompressSingleRowState CompressSingleRowState;
+struct ChunkInsertState;
+
+/* Inserts a buffered row that didn't fill a compressed batch into the uncompressed chunk */
+typedef void (*CompressRowInsertFunc)(TupleTableSlot *slot, void *data);
 
 typedef struct CrossModuleFunctions
 {
@@ -44,18 +48,38 @@ typedef struct CrossModuleFunctions
 	PGFunction policy_compression_remove;
 	PGFunction policy_recompression_proc;
 	PGFunction policy_compression_check;
+	PGFunction policy_compression_batch_add;
+	PGFunction policy_compression_batch_remove;
+	PGFunction policy_compression_batch_check;
 	PGFunction policy_refresh_cagg_add;
 	PGFunction policy_refresh_cagg_proc;
+	PGFunction policy_refresh_cagg_window_proc;
 	PGFunction policy_refresh_cagg_check;
 	PGFunction policy_refresh_cagg_remove;
 	PGFunction policy_reorder_add;
 	PGFunction policy_reorder_proc;
 	PGFunction policy_reorder_check;
 	PGFunction policy_reorder_remove;
+	PGFunction policy_chunk_precreation_add;
+	PGFunction policy_chunk_precreation_proc;
+	PGFunction policy_chunk_precreation_check;
+	PGFunction policy_chunk_precreation_remove;
+	PGFunction policy_distributed_stats_add;
+	PGFunction policy_distributed_stats_proc;
+	PGFunction policy_distributed_stats_check;
+	PGFunction policy_distributed_stats_remove;
+	PGFunction policy_invalidation_log_compaction_add;
+	PGFunction policy_invalidation_log_compaction_proc;
+	PGFunction policy_invalidation_log_compaction_check;
+	PGFunction policy_invalidation_log_compaction_remove;
 	PGFunction policy_retention_add;
 	PGFunction policy_retention_proc;
 	PGFunction policy_retention_check;
 	PGFunction policy_retention_remove;
+	PGFunction policy_vacuum_add;
+	PGFunction policy_vacuum_proc;
+	PGFunction policy_vacuum_check;
+	PGFunction policy_vacuum_remove;
 
 	PGFunction policies_add;
 	PGFunction policies_remove;
@@ -66,6 +90,7 @@ typedef struct CrossModuleFunctions
 	PGFunction job_add;
 	PGFunction job_alter;
 	PGFunction job_alter_set_hypertable_id;
+	PGFunction job_set_concurrency_class;
 	PGFunction job_delete;
 	PGFunction job_run;
 
@@ -110,6 +135,11 @@ typedef struct CrossModuleFunctions
 													 HeapTuple chunk_newtuple, bool update,
 													 bool is_distributed_hypertable_trigger,
 													 int32 parent_hypertable_id);
+	void (*continuous_agg_add_invalidation_range)(int32 hypertable_id,
+												  bool is_distributed_hypertable_trigger,
+												  int32 parent_hypertable_id, Oid chunk_relid,
+												  int64 lowest_modified_value,
+												  int64 greatest_modified_value);
 	PGFunction continuous_agg_refresh;
 	void (*continuous_agg_invalidate_raw_ht)(const Hypertable *raw_ht, int64 start, int64 end);
 	void (*continuous_agg_invalidate_mat_ht)(const Hypertable *raw_ht, const Hypertable *mat_ht,
@@ -130,6 +160,8 @@ typedef struct CrossModuleFunctions
 	PGFunction compressed_data_recv;
 	PGFunction compressed_data_in;
 	PGFunction compressed_data_out;
+	PGFunction compressed_data_agg_transfn;
+	PGFunction compressed_data_agg_finalfn;
 	bool (*process_compress_table)(AlterTableCmd *cmd, Hypertable *ht,
 								   WithClauseResult *with_clause_options);
 	void (*process_altertable_cmd)(Hypertable *ht, const AlterTableCmd *cmd);
@@ -137,6 +169,8 @@ typedef struct CrossModuleFunctions
 	PGFunction create_compressed_chunk;
 	PGFunction compress_chunk;
 	PGFunction decompress_chunk;
+	PGFunction recompress_chunk_segmentwise;
+	PGFunction bloom1_contains;
 	/* The compression functions below are not installed in SQL as part of create extension;
 	 *  They are installed and tested during testing scripts. They are exposed in cross-module
 	 *  functions because they may be very useful for debugging customer problems if the sql
@@ -174,6 +208,7 @@ typedef struct CrossModuleFunctions
 	PGFunction remote_txn_id_in;
 	PGFunction remote_txn_id_out;
 	PGFunction remote_txn_heal_data_node;
+	PGFunction remote_txn_heal_data_nodes;
 	PGFunction remote_connection_cache_show;
 	void (*create_chunk_on_data_nodes)(const Chunk *chunk, const Hypertable *ht,
 									   const char *remote_chunk_name, List *data_nodes);
@@ -201,12 +236,19 @@ typedef struct CrossModuleFunctions
 	PGFunction chunk_drop_replica;
 	PGFunction chunk_freeze_chunk;
 	PGFunction chunk_unfreeze_chunk;
+	PGFunction chunk_merge_chunks;
+	PGFunction chunk_rebalance_chunks;
 	PGFunction chunks_drop_stale;
 	void (*update_compressed_chunk_relstats)(Oid uncompressed_relid, Oid compressed_relid);
-	CompressSingleRowState *(*compress_row_init)(int srcht_id, Relation in_rel, Relation out_rel);
-	TupleTableSlot *(*compress_row_exec)(CompressSingleRowState *cr, TupleTableSlot *slot);
+	int64 (*compressed_chunk_drop_batches)(const Hypertable *ht, const Chunk *chunk,
+										   int64 older_than);
+	CompressSingleRowState *(*compress_row_init)(int srcht_id, Relation in_rel, Relation out_rel,
+												 bool compress_partial_batches,
+												 CompressRowInsertFunc insert_row, void *data);
+	void (*compress_row_exec)(CompressSingleRowState *cr, TupleTableSlot *slot);
 	void (*compress_row_end)(CompressSingleRowState *cr);
 	void (*compress_row_destroy)(CompressSingleRowState *cr);
+	void (*decompress_batches_for_insert)(struct ChunkInsertState *cis, TupleTableSlot *slot);
 	PGFunction health_check;
 } CrossModuleFunctions;
 
@@ -18,6 +18,7 @@
 #include <storage/lmgr.h>
 
 #include "ts_catalog/catalog.h"
+#include "chunk.h"
 #include "compat/compat.h"
 #include "cross_module_fn.h"
 #include "dimension.h"
@@ -379,6 +380,28 @@ ts_dimension_calculate_default_slice(const Dimension *dim, int64 value)
 	return calculate_closed_range_default(dim, value);
 }
 
+/*
+ * Calculate the slice that a new chunk gets in a closed dimension for the
+ * value, i.e., the slice of the current partitioning of the dimension. Unlike
+ * ts_dimension_calculate_default_slice(), this follows the dimension
+ * partitions when the dimension has them.
+ */
+TSDLLEXPORT DimensionSlice *
+ts_dimension_calculate_closed_slice(const Dimension *dim, int64 value)
+{
+	Assert(IS_CLOSED_DIMENSION(dim));
+
+	if (NULL != dim->dimension_partitions)
+	{
+		const DimensionPartition *dp =
+			ts_dimension_partition_find(dim->dimension_partitions, value);
+
+		return ts_dimension_slice_create(dp->dimension_id, dp->range_start, dp->range_end);
+	}
+
+	return calculate_closed_range_default(dim, value);
+}
+
 /*
  * Get the ordinal value of a slice in an open dimension.
  *
@@ -957,6 +980,40 @@ ts_point_create(int16 num_dimensions)
 	return p;
 }
 
+/*
+ * Convert the time value of a tuple to internal time. This is done for every
+ * inserted tuple, so the finite values of the common time types are converted
+ * inline. The other values, including the out-of-range timestamps, go through
+ * ts_time_value_to_internal().
+ */
+static inline int64
+point_time_value_to_internal(Datum time_val, Oid dimtype)
+{
+	switch (dimtype)
+	{
+		case INT8OID:
+			return DatumGetInt64(time_val);
+		case INT4OID:
+			return (int64) DatumGetInt32(time_val);
+		case INT2OID:
+			return (int64) DatumGetInt16(time_val);
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		{
+			/* See ts_pg_timestamp_to_unix_microseconds() */
+			TimestampTz timestamp = DatumGetTimestampTz(time_val);
+
+			if (timestamp >= TS_TIMESTAMP_MIN && timestamp < TS_TIMESTAMP_END)
+				return timestamp + TS_EPOCH_DIFF_MICROSECONDS;
+			break;
+		}
+		default:
+			break;
+	}
+
+	return ts_time_value_to_internal(time_val, dimtype);
+}
+
 TSDLLEXPORT Point *
 ts_hyperspace_calculate_point(const Hyperspace *hs, TupleTableSlot *slot)
 {
@@ -987,7 +1044,7 @@ ts_hyperspace_calculate_point(const Hyperspace *hs, TupleTableSlot *slot)
 									NameStr(d->fd.column_name)),
 							 errhint("Columns used for time partitioning cannot be NULL.")));
 
-				p->coordinates[p->num_coords++] = ts_time_value_to_internal(datum, dimtype);
+				p->coordinates[p->num_coords++] = point_time_value_to_internal(datum, dimtype);
 				break;
 			case DIMENSION_TYPE_CLOSED:
 				p->coordinates[p->num_coords++] = (int64) DatumGetInt32(datum);
@@ -1139,6 +1196,9 @@ ts_dimension_update(const Hypertable *ht, const NameData *dimname, DimensionType
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("invalid dimension type")));
 
+	/* The slices of new chunks change, so wait for concurrent chunk creators */
+	ts_chunk_creation_lock(ht->fd.id, ExclusiveLock);
+
 	if (NULL == dimname)
 	{
 		if (hyperspace_get_num_dimensions_by_type(ht->space, dimtype) > 1)
@@ -1560,6 +1620,7 @@ ts_dimension_add(PG_FUNCTION_ARGS)
 	DEBUG_WAITPOINT("add_dimension_ht_lock");
 
 	info.ht = ts_hypertable_cache_get_cache_and_entry(info.table_relid, CACHE_FLAG_NONE, &hcache);
+	ts_chunk_creation_lock(info.ht->fd.id, ExclusiveLock);
 
 	if (info.num_slices_is_set && OidIsValid(info.interval_type))
 		ereport(ERROR,
@@ -108,6 +108,8 @@ typedef struct DimensionInfo
 extern Hyperspace *ts_dimension_scan(int32 hypertable_id, Oid main_table_relid, int16 num_dimension,
 									 MemoryContext mctx);
 extern DimensionSlice *ts_dimension_calculate_default_slice(const Dimension *dim, int64 value);
+extern TSDLLEXPORT DimensionSlice *ts_dimension_calculate_closed_slice(const Dimension *dim,
+																	   int64 value);
 extern TSDLLEXPORT Point *ts_hyperspace_calculate_point(const Hyperspace *h, TupleTableSlot *slot);
 extern int ts_dimension_get_slice_ordinal(const Dimension *dim, const DimensionSlice *slice);
 extern const Dimension *ts_hyperspace_get_dimension_by_id(const Hyperspace *hs, int32 id);
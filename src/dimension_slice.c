@@ -13,6 +13,7 @@
 #include <utils/lsyscache.h>
 #include <catalog/pg_opfamily.h>
 #include <catalog/pg_type.h>
+#include <miscadmin.h>
 
 #include "bgw_policy/chunk_stats.h"
 #include "ts_catalog/catalog.h"
@@ -22,6 +23,7 @@
 #include "dimension_slice.h"
 #include "dimension_vector.h"
 #include "hypertable.h"
+#include "loader/slice_cache.h"
 #include "scanner.h"
 
 #include "compat/compat.h"
@@ -349,6 +351,65 @@ ts_dimension_slice_scan_list(int32 dimension_id, int64 coordinate, List **matchi
 										CurrentMemoryContext);
 }
 
+/*
+ * range_end is stored as exclusive, so add 1 to the value being searched for
+ * in range_end. Also avoid overflow.
+ */
+static inline int64
+range_end_search_value(int64 end_value)
+{
+	/*
+	 * The point with INT64_MAX gets mapped to INT64_MAX-1 so incrementing that
+	 * gets you to INT_64MAX
+	 */
+	if (end_value == PG_INT64_MAX)
+		return PG_INT64_MAX;
+
+	/*
+	 * If getting as input INT64_MAX-1, need to remap the incremented value back
+	 * to INT64_MAX-1
+	 */
+	return REMAP_LAST_COORDINATE(end_value + 1);
+}
+
+static inline bool
+range_value_matches(int64 value, StrategyNumber strategy, int64 arg)
+{
+	switch (strategy)
+	{
+		case InvalidStrategy:
+			return true;
+		case BTLessStrategyNumber:
+			return value < arg;
+		case BTLessEqualStrategyNumber:
+			return value <= arg;
+		case BTEqualStrategyNumber:
+			return value == arg;
+		case BTGreaterEqualStrategyNumber:
+			return value >= arg;
+		case BTGreaterStrategyNumber:
+			return value > arg;
+		default:
+			elog(ERROR, "invalid strategy number %d", strategy);
+			pg_unreachable();
+	}
+}
+
+/*
+ * Check if a slice matches a range given the same way as to
+ * ts_dimension_slice_scan_iterator_set_range(), that is, without scanning the
+ * catalog table.
+ */
+bool
+ts_dimension_slice_range_matches(const FormData_dimension_slice *fd,
+								 StrategyNumber start_strategy, int64 start_value,
+								 StrategyNumber end_strategy, int64 end_value)
+{
+	return range_value_matches(fd->range_start, start_strategy, start_value) &&
+		   (end_strategy == InvalidStrategy ||
+			range_value_matches(fd->range_end, end_strategy, range_end_search_value(end_value)));
+}
+
 int
 ts_dimension_slice_scan_iterator_set_range(ScanIterator *it, int32 dimension_id,
 										   StrategyNumber start_strategy, int64 start_value,
@@ -392,35 +453,12 @@ ts_dimension_slice_scan_iterator_set_range(ScanIterator *it, int32 dimension_id,
 
 		Assert(OidIsValid(proc));
 
-		/*
-		 * range_end is stored as exclusive, so add 1 to the value being
-		 * searched. Also avoid overflow
-		 */
-		if (end_value != PG_INT64_MAX)
-		{
-			end_value++;
-
-			/*
-			 * If getting as input INT64_MAX-1, need to remap the incremented
-			 * value back to INT64_MAX-1
-			 */
-			end_value = REMAP_LAST_COORDINATE(end_value);
-		}
-		else
-		{
-			/*
-			 * The point with INT64_MAX gets mapped to INT64_MAX-1 so
-			 * incrementing that gets you to INT_64MAX
-			 */
-			end_value = PG_INT64_MAX;
-		}
-
 		ts_scan_iterator_scan_key_init(
 			it,
 			Anum_dimension_slice_dimension_id_range_start_range_end_idx_range_end,
 			end_strategy,
 			proc,
-			Int64GetDatum(end_value));
+			Int64GetDatum(range_end_search_value(end_value)));
 	}
 
 	return it->ctx.nkeys;
@@ -590,6 +628,137 @@ ts_dimension_slice_scan_by_dimension_before_point(int32 dimension_id, int64 poin
 	return ts_dimension_vec_sort(&slices);
 }
 
+/*
+ * The shared slice cache is allocated by the loader when
+ * timescaledb.shared_slice_cache_size is set, so it is only available when
+ * the loader is preloaded.
+ */
+static SliceCacheRendezvous *
+slice_cache_get(void)
+{
+	static SliceCacheRendezvous *slice_cache = NULL;
+
+	if (slice_cache == NULL)
+		slice_cache = *(SliceCacheRendezvous **) find_rendezvous_variable(RENDEZVOUS_SLICE_CACHE);
+
+	return slice_cache;
+}
+
+/*
+ * Get a slice from the shared slice cache. The entry of a slice cached for an
+ * earlier incarnation of the extension, which can have a slice with the same
+ * id, doesn't match the extension of the catalog and is ignored.
+ */
+static bool
+slice_cache_lookup(int32 slice_id, FormData_dimension_slice *fd)
+{
+	SliceCacheRendezvous *slice_cache = slice_cache_get();
+	SliceCacheKey key = { .database_id = MyDatabaseId, .slice_id = slice_id };
+	SliceCacheEntry *entry;
+	const Catalog *catalog;
+	bool found = false;
+
+	if (slice_cache == NULL)
+		return false;
+
+	catalog = ts_catalog_get();
+
+	LWLockAcquire(slice_cache->lock, LW_SHARED);
+	entry = hash_search(slice_cache->slices, &key, HASH_FIND, NULL);
+	if (entry != NULL && entry->extension_id == catalog->extension_id &&
+		entry->extension_xmin == catalog->extension_xmin)
+	{
+		fd->id = slice_id;
+		fd->dimension_id = entry->dimension_id;
+		fd->range_start = entry->range_start;
+		fd->range_end = entry->range_end;
+		found = true;
+	}
+	LWLockRelease(slice_cache->lock);
+
+	return found;
+}
+
+static void
+slice_cache_add(const FormData_dimension_slice *fd)
+{
+	SliceCacheRendezvous *slice_cache = slice_cache_get();
+	SliceCacheKey key = { .database_id = MyDatabaseId, .slice_id = fd->id };
+	SliceCacheEntry *entry;
+	const Catalog *catalog;
+	bool found;
+
+	if (slice_cache == NULL)
+		return;
+
+	catalog = ts_catalog_get();
+	if (!TransactionIdIsValid(catalog->extension_xmin))
+		return;
+
+	LWLockAcquire(slice_cache->lock, LW_EXCLUSIVE);
+
+	/* When the cache is full, the slice is just not cached */
+	entry = hash_search(slice_cache->slices, &key, HASH_FIND, NULL);
+	if (entry == NULL && hash_get_num_entries(slice_cache->slices) < slice_cache->max_entries)
+		entry = hash_search(slice_cache->slices, &key, HASH_ENTER_NULL, &found);
+
+	if (entry != NULL)
+	{
+		entry->extension_id = catalog->extension_id;
+		entry->extension_xmin = catalog->extension_xmin;
+		entry->dimension_id = fd->dimension_id;
+		entry->range_start = fd->range_start;
+		entry->range_end = fd->range_end;
+	}
+
+	LWLockRelease(slice_cache->lock);
+}
+
+static void
+slice_cache_remove(int32 slice_id)
+{
+	SliceCacheRendezvous *slice_cache = slice_cache_get();
+	SliceCacheKey key = { .database_id = MyDatabaseId, .slice_id = slice_id };
+
+	if (slice_cache == NULL)
+		return;
+
+	LWLockAcquire(slice_cache->lock, LW_EXCLUSIVE);
+	hash_search(slice_cache->slices, &key, HASH_REMOVE, NULL);
+	LWLockRelease(slice_cache->lock);
+}
+
+/*
+ * Remove the slices of the current database from the shared slice cache.
+ *
+ * This is called when the extension state changes, to free the room taken by
+ * the slices of a dropped extension. The slices of an earlier incarnation of
+ * the extension are never returned by a lookup even when they stay in the
+ * cache, for example when another backend drops and creates the extension.
+ * It does not access the catalog, so it can be called from an invalidation
+ * callback.
+ */
+void
+ts_dimension_slice_shared_cache_reset(void)
+{
+	SliceCacheRendezvous *slice_cache = slice_cache_get();
+	HASH_SEQ_STATUS status;
+	SliceCacheEntry *entry;
+
+	if (slice_cache == NULL)
+		return;
+
+	LWLockAcquire(slice_cache->lock, LW_EXCLUSIVE);
+	hash_seq_init(&status, slice_cache->slices);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		/* Removing the entry just returned by hash_seq_search is allowed */
+		if (entry->key.database_id == MyDatabaseId)
+			hash_search(slice_cache->slices, &entry->key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(slice_cache->lock);
+}
+
 static ScanTupleResult
 dimension_slice_tuple_delete(TupleInfo *ti, void *data)
 {
@@ -599,6 +768,7 @@ dimension_slice_tuple_delete(TupleInfo *ti, void *data)
 	CatalogSecurityContext sec_ctx;
 
 	Assert(!isnull);
+	slice_cache_remove(DatumGetInt32(dimension_slice_id));
 
 	/* delete chunk constraints */
 	if (NULL != delete_constraints && *delete_constraints)
@@ -805,18 +975,48 @@ ts_dimension_slice_scan_iterator_set_slice_id(ScanIterator *it, int32 slice_id,
 	it->ctx.tuplock = tuplock;
 }
 
+/*
+ * Get the slice with the given id.
+ *
+ * When the slice need not be locked, it is taken from the shared slice cache
+ * if it is there, and added to it otherwise.
+ */
 DimensionSlice *
 ts_dimension_slice_scan_iterator_get_by_id(ScanIterator *it, int32 slice_id,
 										   const ScanTupLock *tuplock)
 {
 	TupleInfo *ti;
+	DimensionSlice *slice;
+
+	if (tuplock == NULL)
+	{
+		FormData_dimension_slice fd;
+
+		if (slice_cache_lookup(slice_id, &fd))
+		{
+			MemoryContext old = CurrentMemoryContext;
+
+			/* Allocate the slice like the scanner would, see ts_dimension_slice_from_tuple */
+			if (it->ctx.result_mctx != NULL)
+				MemoryContextSwitchTo(it->ctx.result_mctx);
+			slice = dimension_slice_from_form_data(&fd);
+			MemoryContextSwitchTo(old);
+			return slice;
+		}
+	}
 
 	ts_dimension_slice_scan_iterator_set_slice_id(it, slice_id, tuplock);
 	ts_scan_iterator_start_or_restart_scan(it);
 	ti = ts_scan_iterator_next(it);
 	Assert(ti);
 	Assert(ts_scan_iterator_next(it) == NULL); /* This is a heavy call, consider removing it */
-	return ti ? ts_dimension_slice_from_tuple(ti) : NULL;
+
+	if (ti == NULL)
+		return NULL;
+
+	slice = ts_dimension_slice_from_tuple(ti);
+	slice_cache_add(&slice->fd);
+	return slice;
 }
 
 DimensionSlice *
@@ -66,6 +66,7 @@ extern DimensionVec *ts_dimension_slice_scan_by_dimension_before_point(int32 dim
 																	   MemoryContext mctx);
 extern int ts_dimension_slice_delete_by_dimension_id(int32 dimension_id, bool delete_constraints);
 extern int ts_dimension_slice_delete_by_id(int32 dimension_slice_id, bool delete_constraints);
+extern void ts_dimension_slice_shared_cache_reset(void);
 extern TSDLLEXPORT DimensionSlice *ts_dimension_slice_create(int dimension_id, int64 range_start,
 															 int64 range_end);
 extern TSDLLEXPORT DimensionSlice *ts_dimension_slice_copy(const DimensionSlice *original);
@@ -100,6 +101,9 @@ extern int ts_dimension_slice_scan_iterator_set_range(ScanIterator *it, int32 di
 													  StrategyNumber start_strategy,
 													  int64 start_value,
 													  StrategyNumber end_strategy, int64 end_value);
+extern bool ts_dimension_slice_range_matches(const FormData_dimension_slice *fd,
+											 StrategyNumber start_strategy, int64 start_value,
+											 StrategyNumber end_strategy, int64 end_value);
 
 #define dimension_slice_insert(slice) ts_dimension_slice_insert_multi(&(slice), 1)
 
@@ -0,0 +1,215 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <utils/hsearch.h>
+#include <utils/inval.h>
+#include <utils/memutils.h>
+
+#include "dimension_slice.h"
+#include "dimension_slice_index.h"
+
+/*
+ * The dimension slice index keeps all the slices of a dimension in a
+ * backend-local array sorted by the start of their range, so that chunk
+ * exclusion at planning time can find the slices that match the restrictions
+ * of a query with a binary search instead of a scan of the dimension_slice
+ * catalog table.
+ *
+ * A lookup does a binary search for the slices that start early enough to
+ * match the restriction on range_start and, using the widest slice of the
+ * dimension, for the first slice that can still end late enough to match the
+ * restriction on range_end. Only the slices in between are checked against
+ * the restriction. For the usual dimension, where all slices have the same
+ * interval, these are only the matching slices and the ones next to them.
+ *
+ * The index is built lazily per dimension and is reset on every invalidation
+ * of the hypertable cache and on relcache invalidations of the dimension_slice
+ * catalog table, which are signaled when slices are added (see
+ * ts_catalog_invalidate_cache()). Since an invalidation can arrive while a
+ * dimension is being indexed, for instance when opening the catalog table, it
+ * only marks the index as stale and the reset happens on the next lookup.
+ */
+
+typedef struct SliceIndexEntry
+{
+	int32 dimension_id;
+	int num_slices;
+	/* sorted by (range_start, range_end) */
+	FormData_dimension_slice *slices;
+	/* widest range of the slices */
+	uint64 max_span;
+} SliceIndexEntry;
+
+static HTAB *slice_index = NULL;
+static MemoryContext slice_index_mcxt = NULL;
+static bool slice_index_valid = false;
+
+void
+ts_dimension_slice_index_invalidate(void)
+{
+	slice_index_valid = false;
+}
+
+static void
+slice_index_reset(void)
+{
+	HASHCTL ctl = {
+		.keysize = sizeof(int32),
+		.entrysize = sizeof(SliceIndexEntry),
+	};
+
+	if (slice_index_mcxt == NULL)
+		slice_index_mcxt = AllocSetContextCreate(CacheMemoryContext,
+												 "Dimension slice index",
+												 ALLOCSET_DEFAULT_SIZES);
+	else
+		MemoryContextReset(slice_index_mcxt);
+
+	ctl.hcxt = slice_index_mcxt;
+	slice_index = hash_create("Dimension slice index",
+							  32,
+							  &ctl,
+							  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	slice_index_valid = true;
+}
+
+static SliceIndexEntry *
+slice_index_get_entry(int32 dimension_id)
+{
+	SliceIndexEntry *entry;
+	DimensionVec *vec;
+	FormData_dimension_slice *slices;
+	uint64 max_span = 0;
+	bool found;
+
+	/* Make sure that we know about the slices added by other backends */
+	AcceptInvalidationMessages();
+
+	if (!slice_index_valid)
+		slice_index_reset();
+
+	entry = hash_search(slice_index, &dimension_id, HASH_FIND, &found);
+
+	if (found)
+		return entry;
+
+	/* The scan returns the slices sorted by (range_start, range_end) */
+	vec = ts_dimension_slice_scan_by_dimension(dimension_id, 0);
+	slices = MemoryContextAlloc(slice_index_mcxt,
+								sizeof(FormData_dimension_slice) * Max(vec->num_slices, 1));
+
+	for (int i = 0; i < vec->num_slices; i++)
+	{
+		slices[i] = vec->slices[i]->fd;
+		/* The unsigned difference cannot overflow, even for unbounded slices */
+		max_span = Max(max_span, (uint64) slices[i].range_end - (uint64) slices[i].range_start);
+	}
+
+	entry = hash_search(slice_index, &dimension_id, HASH_ENTER, &found);
+	Assert(!found);
+	entry->num_slices = vec->num_slices;
+	entry->slices = slices;
+	entry->max_span = max_span;
+
+	return entry;
+}
+
+/*
+ * Returns the number of slices that start before the value, or at the value
+ * when inclusive is set.
+ */
+static int
+slice_index_upper_bound(const SliceIndexEntry *entry, int64 value, bool inclusive)
+{
+	int low = 0;
+	int high = entry->num_slices;
+
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (entry->slices[mid].range_start < value ||
+			(inclusive && entry->slices[mid].range_start == value))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/*
+ * Append the slices of a dimension that match a range to the dimension
+ * vector. The range is given the same way as to
+ * ts_dimension_slice_scan_iterator_set_range().
+ */
+DimensionVec *
+ts_dimension_slice_index_find(int32 dimension_id, StrategyNumber start_strategy,
+							  int64 start_value, StrategyNumber end_strategy, int64 end_value,
+							  DimensionVec **dv, bool unique)
+{
+	const SliceIndexEntry *entry = slice_index_get_entry(dimension_id);
+	int first = 0;
+	int last = entry->num_slices;
+
+	switch (start_strategy)
+	{
+		case BTLessStrategyNumber:
+			last = slice_index_upper_bound(entry, start_value, false);
+			break;
+		case BTLessEqualStrategyNumber:
+		case BTEqualStrategyNumber:
+			last = slice_index_upper_bound(entry, start_value, true);
+			break;
+		case BTGreaterEqualStrategyNumber:
+			first = slice_index_upper_bound(entry, start_value, false);
+			break;
+		case BTGreaterStrategyNumber:
+			first = slice_index_upper_bound(entry, start_value, true);
+			break;
+		default:
+			break;
+	}
+
+	/*
+	 * A slice that ends at or after the value starts at most max_span before
+	 * it, so the slices that start earlier than that cannot match.
+	 */
+	if (end_strategy == BTGreaterStrategyNumber || end_strategy == BTGreaterEqualStrategyNumber ||
+		end_strategy == BTEqualStrategyNumber)
+	{
+		if ((uint64) end_value - (uint64) DIMENSION_SLICE_MINVALUE > entry->max_span)
+		{
+			int64 min_start = (int64) ((uint64) end_value - entry->max_span);
+
+			first = Max(first, slice_index_upper_bound(entry, min_start, false));
+		}
+	}
+
+	for (int i = first; i < last; i++)
+	{
+		const FormData_dimension_slice *fd = &entry->slices[i];
+
+		if (ts_dimension_slice_range_matches(fd,
+											 start_strategy,
+											 start_value,
+											 end_strategy,
+											 end_value))
+		{
+			DimensionSlice *slice =
+				ts_dimension_slice_create(fd->dimension_id, fd->range_start, fd->range_end);
+
+			slice->fd.id = fd->id;
+
+			if (unique)
+				*dv = ts_dimension_vec_add_unique_slice(dv, slice);
+			else
+				*dv = ts_dimension_vec_add_slice(dv, slice);
+		}
+	}
+
+	return *dv;
+}
@@ -6,7 +6,9 @@
 #include <postgres.h>
 #include <utils/guc.h>
 #include <miscadmin.h>
+#include <postmaster/bgworker.h>
 
+#include "compat/compat.h"
 #include "guc.h"
 #include "license_guc.h"
 #include "config.h"
@@ -45,6 +47,7 @@ static const struct config_enum_entry remote_data_fetchers[] = {
 	{ "copy", CopyFetcherType, false },
 	{ "cursor", CursorFetcherType, false },
 	{ "auto", AutoFetcherType, false },
+	{ "columnar", ColumnarFetcherType, false },
 	{ NULL, 0, false }
 };
 
@@ -62,27 +65,110 @@ static const struct config_enum_entry dist_copy_transfer_formats[] = {
 	{ NULL, 0, false }
 };
 
+/* PostgreSQL supports a TOAST compression method per column only from PG14 */
+static const struct config_enum_entry compress_toast_compressions[] = {
+	{ "default", COMPRESS_TOAST_COMPRESSION_DEFAULT, false },
+#if PG14_GE
+	{ "pglz", COMPRESS_TOAST_COMPRESSION_PGLZ, false },
+#ifdef USE_LZ4
+	{ "lz4", COMPRESS_TOAST_COMPRESSION_LZ4, false },
+#endif
+#endif
+	{ NULL, 0, false }
+};
+
+static const struct config_enum_entry chunk_tablespace_selections[] = {
+	{ "round_robin", CHUNK_TABLESPACE_ROUND_ROBIN, false },
+	{ "least_used", CHUNK_TABLESPACE_LEAST_USED, false },
+	{ NULL, 0, false }
+};
+
+static const struct config_enum_entry chunk_prewarm_modes[] = {
+	{ "off", CHUNK_PREWARM_OFF, false },
+	{ "indexes", CHUNK_PREWARM_INDEXES, false },
+	{ "all", CHUNK_PREWARM_ALL, false },
+	{ NULL, 0, false }
+};
+
 bool ts_guc_enable_optimizations = true;
 bool ts_guc_restoring = false;
 bool ts_guc_enable_constraint_aware_append = true;
 bool ts_guc_enable_ordered_append = true;
+bool ts_guc_enable_ordered_append_group_by = false;
 bool ts_guc_enable_chunk_append = true;
+bool ts_guc_enable_lazy_chunk_expansion = false;
 bool ts_guc_enable_parallel_chunk_append = true;
+bool ts_guc_enable_chunk_append_merge = false;
 bool ts_guc_enable_runtime_exclusion = true;
 bool ts_guc_enable_constraint_exclusion = true;
+bool ts_guc_enable_slice_index = true;
 bool ts_guc_enable_qual_propagation = true;
 bool ts_guc_enable_cagg_reorder_groupby = true;
 bool ts_guc_enable_now_constify = true;
 bool ts_guc_enable_osm_reads = true;
+bool ts_guc_enable_insert_batching = false;
 TSDLLEXPORT bool ts_guc_enable_transparent_decompression = true;
 bool ts_guc_enable_per_data_node_queries = true;
+bool ts_guc_enable_dist_partial_agg = false;
 bool ts_guc_enable_async_append = true;
+TSDLLEXPORT int ts_guc_async_append_max_fanout = 0;
 TSDLLEXPORT bool ts_guc_enable_compression_indexscan = true;
+TSDLLEXPORT bool ts_guc_enable_bulk_decompression = true;
+TSDLLEXPORT bool ts_guc_enable_vectorized_aggregation = false;
+TSDLLEXPORT bool ts_guc_enable_decompression_sorted_merge = false;
+TSDLLEXPORT bool ts_guc_enable_parallel_batch_decompression = false;
+TSDLLEXPORT int ts_guc_compress_parallel_workers = 0;
+TSDLLEXPORT int ts_guc_decompress_parallel_workers = 0;
+TSDLLEXPORT int ts_guc_compress_batch_size = 1000;
+TSDLLEXPORT CompressToastCompression ts_guc_compress_toast_compression =
+	COMPRESS_TOAST_COMPRESSION_DEFAULT;
+TSDLLEXPORT int ts_guc_decompress_prefetch_batches = 0;
+TSDLLEXPORT int ts_guc_decompress_cache_size = 0;
+TSDLLEXPORT int ts_guc_vector_agg_cache_size = 0;
+TSDLLEXPORT bool ts_guc_enable_decompression_stats = false;
+bool ts_guc_enable_planner_timing = false;
+TSDLLEXPORT bool ts_guc_enable_segmentwise_recompression = false;
+TSDLLEXPORT bool ts_guc_enable_bitpack_compression = false;
+TSDLLEXPORT bool ts_guc_enable_uuid_compression = false;
+TSDLLEXPORT bool ts_guc_enable_jsonb_compression = false;
+TSDLLEXPORT bool ts_guc_enable_compression_sampling = false;
+TSDLLEXPORT bool ts_guc_enable_compression_radix_sort = true;
+TSDLLEXPORT bool ts_guc_enable_compression_hash_grouping = false;
+TSDLLEXPORT bool ts_guc_enable_compression_sample_stats = false;
+bool ts_guc_enable_merged_hypertable_stats = false;
+TSDLLEXPORT bool ts_guc_enable_compressed_insert_buffering = false;
+TSDLLEXPORT bool ts_guc_enable_direct_compression = false;
+TSDLLEXPORT bool ts_guc_enable_append_only_inserts = false;
+TSDLLEXPORT bool ts_guc_enable_dml_decompression = false;
 TSDLLEXPORT bool ts_guc_enable_skip_scan = true;
+TSDLLEXPORT bool ts_guc_enable_compressed_skip_scan = false;
+TSDLLEXPORT bool ts_guc_enable_compression_cost_stats = false;
+TSDLLEXPORT bool ts_guc_enable_last_point_cache = true;
+bool ts_guc_enable_grouped_first_last = false;
+bool ts_guc_enable_chunk_skipping = true;
+bool ts_guc_enable_batch_retention = false;
+bool ts_guc_enable_delete_truncation = false;
+TSDLLEXPORT bool ts_guc_enable_gapfill_hash_groups = false;
+bool ts_guc_enable_space_partitionwise_agg = false;
+bool ts_guc_enable_chunkwise_join = false;
+bool ts_guc_enable_cagg_invalidation_tracking = false;
+bool ts_guc_enable_adaptive_chunking_insert_stats = false;
+bool ts_guc_enable_chunk_creation_slice_locks = false;
+TSDLLEXPORT bool ts_guc_enable_cagg_diff_materialization = false;
+TSDLLEXPORT bool ts_guc_enable_cagg_incremental_refresh = false;
+TSDLLEXPORT bool ts_guc_enable_cagg_nested_materialized_source = false;
+TSDLLEXPORT bool ts_guc_enable_cagg_compressed_refresh = false;
+TSDLLEXPORT bool ts_guc_enable_cagg_remote_refresh = false;
+TSDLLEXPORT bool ts_guc_enable_cagg_partition_invalidation = false;
 int ts_guc_max_open_chunks_per_insert = 10;
 int ts_guc_max_cached_chunks_per_hypertable = 10;
+int ts_guc_max_hypertable_cache_memory = 0;
+int ts_guc_copy_buffer_memory = 0;
+ChunkTablespaceSelection ts_guc_chunk_tablespace_selection = CHUNK_TABLESPACE_ROUND_ROBIN;
+TSDLLEXPORT ChunkPrewarmMode ts_guc_chunk_prewarm = CHUNK_PREWARM_OFF;
 #ifdef USE_TELEMETRY
 TelemetryLevel ts_guc_telemetry_level = TELEMETRY_DEFAULT;
+int ts_guc_telemetry_function_sample_interval = 1;
 char *ts_telemetry_cloud = NULL;
 #endif
 
@@ -90,14 +176,32 @@ TSDLLEXPORT char *ts_guc_license = TS_LICENSE_DEFAULT;
 char *ts_last_tune_time = NULL;
 char *ts_last_tune_version = NULL;
 TSDLLEXPORT bool ts_guc_enable_2pc;
+TSDLLEXPORT bool ts_guc_enable_async_commit_prepared = false;
+TSDLLEXPORT bool ts_guc_enable_replica_load_balancing = false;
+TSDLLEXPORT int ts_guc_data_node_response_timeout = 0;
+TSDLLEXPORT bool ts_guc_enable_colocated_join = false;
+TSDLLEXPORT bool ts_guc_enable_streaming_chunk_copy = false;
+TSDLLEXPORT bool ts_guc_enable_prepared_stmt_cache = false;
 TSDLLEXPORT int ts_guc_max_insert_batch_size = 1000;
+TSDLLEXPORT int ts_guc_max_insert_pipeline_depth = 1;
+TSDLLEXPORT bool ts_guc_enable_async_insert_flush = false;
+TSDLLEXPORT int ts_guc_cagg_max_invalidation_ranges = 1;
+TSDLLEXPORT int ts_guc_cagg_refresh_parallel_jobs = 0;
+TSDLLEXPORT int ts_guc_bgw_job_worker_idle_timeout = 0;
+TSDLLEXPORT bool ts_guc_bgw_job_schedule_spread = false;
+TSDLLEXPORT int ts_guc_bgw_job_stat_flush_interval = 10000;
+TSDLLEXPORT bool ts_guc_enable_concurrent_reorder = false;
 TSDLLEXPORT bool ts_guc_enable_connection_binary_data;
 TSDLLEXPORT DistCopyTransferFormat ts_guc_dist_copy_transfer_format;
+TSDLLEXPORT int ts_guc_dist_copy_connections_per_data_node = 1;
 TSDLLEXPORT bool ts_guc_enable_client_ddl_on_data_nodes = false;
 TSDLLEXPORT char *ts_guc_ssl_dir = NULL;
 TSDLLEXPORT char *ts_guc_passfile = NULL;
 TSDLLEXPORT bool ts_guc_enable_remote_explain = false;
 TSDLLEXPORT DataFetcherType ts_guc_remote_data_fetcher = AutoFetcherType;
+TSDLLEXPORT int ts_guc_remote_fetch_memory = 0;
+TSDLLEXPORT bool ts_guc_enable_cursor_prefetch = false;
+TSDLLEXPORT bool ts_guc_enable_parallel_connect = false;
 TSDLLEXPORT HypertableDistType ts_guc_hypertable_distributed_default = HYPERTABLE_DIST_AUTO;
 TSDLLEXPORT int ts_guc_hypertable_replication_factor_default = 1;
 
@@ -172,6 +276,18 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_ordered_append_group_by",
+							 "Enable ordered append scans for GROUP BY",
+							 "Enable ordered append optimization for queries that are grouped by "
+							 "the time dimension or a bucket of it",
+							 &ts_guc_enable_ordered_append_group_by,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_chunk_append",
 							 "Enable chunk append node",
 							 "Enable using chunk append node",
@@ -183,6 +299,18 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_lazy_chunk_expansion",
+							 "Enable lazy chunk expansion",
+							 "Resolve the chunks of a hypertable at execution time in the "
+							 "ChunkAppend node when they can only be excluded at execution time",
+							 &ts_guc_enable_lazy_chunk_expansion,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_parallel_chunk_append",
 							 "Enable parallel chunk append node",
 							 "Enable using parallel aware chunk append node",
@@ -194,6 +322,18 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_chunk_append_merge",
+							 "Enable merging in the chunk append node",
+							 "Merge the space partitions of a time slice in ordered appends in the "
+							 "chunk append node instead of a MergeAppend node per time slice",
+							 &ts_guc_enable_chunk_append_merge,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_runtime_exclusion",
 							 "Enable runtime chunk exclusion",
 							 "Enable runtime chunk exclusion in ChunkAppend node",
@@ -216,6 +356,19 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_slice_index",
+							 "Enable the dimension slice index",
+							 "Find the dimension slices matching the restrictions of a query in a "
+							 "backend-local index instead of scanning the dimension_slice catalog "
+							 "table at planning time",
+							 &ts_guc_enable_slice_index,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_qual_propagation",
 							 "Enable qualifier propagation",
 							 "Enable propagation of qualifiers in JOINs",
@@ -249,6 +402,301 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_compressed_skipscan",
+							 "Enable SkipScan over compressed chunks",
+							 "Enable SkipScan over the segmentby index of compressed chunks",
+							 &ts_guc_enable_compressed_skip_scan,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compression_cost_stats",
+							 "Cost decompression with the compression statistics",
+							 "Estimate the rows and the decompression cost of compressed chunks "
+							 "from their batch sizes and compression algorithms",
+							 &ts_guc_enable_compression_cost_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_last_point_cache",
+							 "Enable the last point cache",
+							 "Answer last() queries grouped by the key from the last point cache",
+							 &ts_guc_enable_last_point_cache,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_grouped_first_last",
+							 "Enable DISTINCT ON planning of grouped first() and last()",
+							 "Plan first() and last() queries grouped by columns that lead an "
+							 "index followed by the time column as DISTINCT ON queries, which "
+							 "can use a SkipScan over the index",
+							 &ts_guc_enable_grouped_first_last,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_chunk_skipping",
+							 "Enable chunk skipping",
+							 "Exclude compressed chunks at planning time using the ranges of "
+							 "the columns enabled with enable_chunk_skipping()",
+							 &ts_guc_enable_chunk_skipping,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_space_partitionwise_aggregate",
+							 "Enable aggregation per space partition",
+							 "Aggregate every space partition on its own when the GROUP BY "
+							 "includes the space-partitioning column",
+							 &ts_guc_enable_space_partitionwise_agg,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_chunkwise_join",
+							 "Enable chunk-wise joins",
+							 "Join hypertables with the same time partitioning chunk by chunk "
+							 "when they are joined on the time column",
+							 &ts_guc_enable_chunkwise_join,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cagg_invalidation_tracking",
+							 "Enable continuous aggregate invalidation tracking on insert",
+							 "Track the range of time values inserted into each chunk for "
+							 "continuous aggregate invalidation instead of calling the "
+							 "invalidation trigger for every row",
+							 &ts_guc_enable_cagg_invalidation_tracking,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_adaptive_chunking_insert_stats",
+							 "Enable insert statistics for adaptive chunking",
+							 "Track the range of time values inserted into each chunk and use "
+							 "it for adaptive chunk sizing instead of scanning recent chunks "
+							 "for their min and max values",
+							 &ts_guc_enable_adaptive_chunking_insert_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_chunk_creation_slice_locks",
+							 "Enable locking new dimension slices on chunk creation",
+							 "Serialize only the creators of chunks that need the same new "
+							 "dimension slices instead of all chunk creators of a hypertable",
+							 &ts_guc_enable_chunk_creation_slice_locks,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.cagg_max_invalidation_ranges",
+							"Maximum continuous aggregate invalidation ranges",
+							"Maximum number of disjoint ranges of modified time values kept "
+							"per hypertable and transaction for continuous aggregate "
+							"invalidation. Setting this to 1 logs a single range from the "
+							"lowest to the greatest modified value",
+							&ts_guc_cagg_max_invalidation_ranges,
+							1,
+							1,
+							1024,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cagg_diff_materialization",
+							 "Enable differential continuous aggregate materialization",
+							 "Only rewrite the materialized rows that changed when refreshing a "
+							 "continuous aggregate, instead of deleting and inserting all rows "
+							 "of the refreshed range",
+							 &ts_guc_enable_cagg_diff_materialization,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cagg_incremental_refresh",
+							 "Enable incremental continuous aggregate refresh",
+							 "Only recompute the partials of the chunks that overlap an "
+							 "invalidated range when refreshing a continuous aggregate that "
+							 "stores partials, instead of recomputing the whole buckets",
+							 &ts_guc_enable_cagg_incremental_refresh,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cagg_nested_materialized_source",
+							 "Enable reading nested continuous aggregate sources from their "
+							 "materialization",
+							 "Make continuous aggregates created on top of another continuous "
+							 "aggregate refresh from the materialized data of that aggregate, "
+							 "never from the real-time part of its view",
+							 &ts_guc_enable_cagg_nested_materialized_source,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cagg_compressed_refresh",
+							 "Enable refreshing compressed continuous aggregate regions",
+							 "Decompress only the batches of compressed materialization chunks "
+							 "that overlap the refreshed range when refreshing a continuous "
+							 "aggregate, instead of failing to modify compressed chunks",
+							 &ts_guc_enable_cagg_compressed_refresh,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cagg_remote_refresh",
+							 "Enable aggregating on the data nodes when refreshing",
+							 "Compute the aggregates of finalized continuous aggregates on "
+							 "distributed hypertables on the data nodes when refreshing, and only "
+							 "fetch the partial aggregate states, instead of fetching the raw rows",
+							 &ts_guc_enable_cagg_remote_refresh,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cagg_partition_invalidation",
+							 "Enable continuous aggregate invalidations per space partition",
+							 "Track the space partitions modified on hypertables with a space "
+							 "dimension, so that refreshing a continuous aggregate that groups "
+							 "by the space column only recomputes the groups of the modified "
+							 "partitions",
+							 &ts_guc_enable_cagg_partition_invalidation,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.cagg_refresh_parallel_jobs",
+							"Number of jobs to refresh continuous aggregates in",
+							"Hand the materialization of the invalidated windows of a continuous "
+							"aggregate refresh over to up to this number of background jobs that "
+							"run in parallel. Setting this to 0 materializes them in the "
+							"refreshing session",
+							&ts_guc_cagg_refresh_parallel_jobs,
+							0,
+							0,
+							1024,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.bgw_job_worker_idle_timeout",
+							"Time a job worker waits for another job",
+							"Keep the background worker of a finished job around for this long "
+							"so that the scheduler can run another job of the same owner in it "
+							"instead of starting a new background worker. Setting this to 0 "
+							"starts a new background worker for every job run",
+							&ts_guc_bgw_job_worker_idle_timeout,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.bgw_job_schedule_spread",
+							 "Spread job starts over the schedule interval",
+							 "Start each job at an offset into its schedule interval that is "
+							 "derived from the job id, so that jobs with the same schedule "
+							 "interval do not all start at the same time. Applies to the first "
+							 "run of a job and to jobs without a fixed schedule",
+							 &ts_guc_bgw_job_schedule_spread,
+							 false,
+							 PGC_SIGHUP,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.bgw_job_stat_flush_interval",
+							"Interval between the writes of pending job statistics",
+							"The scheduler writes the job statistics that are kept in shared "
+							"memory, see timescaledb.bgw_job_stat_pending_max_jobs, to the job "
+							"statistics table at this interval and when it exits",
+							&ts_guc_bgw_job_stat_flush_interval,
+							10000,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_concurrent_reorder",
+							 "Reorder chunks without blocking writers during the copy",
+							 "Copy the chunk in index order under a lock that allows "
+							 "concurrent writes, apply the rows written during the copy "
+							 "afterwards, and block writers only for that last step and "
+							 "readers only for the final swap. Like TRUNCATE, this is not "
+							 "MVCC-safe: transactions with an older snapshot see the chunk "
+							 "empty afterwards. Chunks with more rows than can be tracked in "
+							 "maintenance_work_mem are reordered while blocking writers",
+							 &ts_guc_enable_concurrent_reorder,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_cagg_reorder_groupby",
 							 "Enable group by reordering",
 							 "Enable group by clause reordering for continuous aggregates",
@@ -282,6 +730,20 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_async_commit_prepared",
+							 "Enable asynchronous commit of prepared transactions",
+							 "Do not wait for the second phase of two-phase commit to finish on "
+							 "the data nodes. The result is collected before the next command "
+							 "on the same connection, so read-your-writes only holds within the "
+							 "session",
+							 &ts_guc_enable_async_commit_prepared,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_per_data_node_queries",
 							 "Enable the per data node query optimization for hypertables",
 							 "Enable the optimization that combines different chunks belonging to "
@@ -294,6 +756,19 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_distributed_partial_aggregation",
+							 "Enable partial aggregation on data nodes",
+							 "Plan queries on distributed hypertables with partitionwise "
+							 "aggregation, so that aggregates are computed, at least partially, "
+							 "on the data nodes even when enable_partitionwise_aggregate is off",
+							 &ts_guc_enable_dist_partial_agg,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_tiered_reads",
 							 "Enable tiered data reads",
 							 "Enable reading of tiered data by including a foreign table "
@@ -323,6 +798,36 @@ _guc_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("timescaledb.max_insert_pipeline_depth",
+							"The max number of batches in flight per data node",
+							"When acting as an access node, TimescaleDB can send several "
+							"batches of inserted tuples to a data node in libpq pipeline mode "
+							"before waiting for the responses. Setting this to 1 disables "
+							"pipelining. Only used for inserts without a RETURNING clause",
+							&ts_guc_max_insert_pipeline_depth,
+							1,
+							1,
+							1024,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_async_insert_flush",
+							 "Enable asynchronous flushing of insert batches",
+							 "When acting as an access node, send each batch of inserted tuples "
+							 "to a data node without waiting for the response, and keep filling "
+							 "the next batch while it is in flight. Only used for inserts "
+							 "without a RETURNING clause that are not pipelined",
+							 &ts_guc_enable_async_insert_flush,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_connection_binary_data",
 							 "Enable binary format for connection",
 							 "Enable binary format for data exchanged between nodes in the cluster",
@@ -335,11 +840,11 @@ _guc_init(void)
 							 NULL);
 
 	/*
-	 * The default is 'auto', so that the dist COPY could use text transfer
-	 * format for text input. It has a passthrough optimization for this case,
-	 * which greatly reduces the CPU usage. Ideally we would implement the same
-	 * optimization for binary, but the Postgres COPY code doesn't provide
-	 * enough APIs for that.
+	 * The default is 'auto', so that the dist COPY uses the same transfer
+	 * format as the input. Both formats have a passthrough optimization that
+	 * greatly reduces the CPU usage: text rows are forwarded after splitting
+	 * them into fields, and binary values of non-partitioning columns are
+	 * forwarded without decoding them (PG >= 14).
 	 */
 	DefineCustomEnumVariable("timescaledb.dist_copy_transfer_format",
 							 "Data format used by distributed COPY to send data to data nodes",
@@ -353,6 +858,21 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomIntVariable("timescaledb.dist_copy_connections_per_data_node",
+							"Number of connections per data node used by distributed COPY",
+							"Distributed COPY shards rows across this many connections per "
+							"data node by chunk, so that each data node ingests with several "
+							"backends. Only used outside of transaction blocks",
+							&ts_guc_dist_copy_connections_per_data_node,
+							1,
+							1,
+							64,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_client_ddl_on_data_nodes",
 							 "Enable DDL operations on data nodes by a client",
 							 "Do not restrict execution of DDL operations only by access node",
@@ -376,6 +896,22 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomIntVariable("timescaledb.async_append_max_fanout",
+							"Max number of data node requests started up front",
+							"The maximum number of data node scans that AsyncAppend starts "
+							"concurrently before reading any results. The remaining scans start "
+							"when they are first read from. Setting this to 0 starts all scans "
+							"up front",
+							&ts_guc_async_append_max_fanout,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_remote_explain",
 							 "Show explain from remote nodes when using VERBOSE flag",
 							 "Enable getting and showing EXPLAIN output from remote nodes",
@@ -398,32 +934,537 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
-	DefineCustomEnumVariable("timescaledb.remote_data_fetcher",
-							 "Set remote data fetcher type",
-							 "Pick data fetcher type based on type of queries you plan to run "
-							 "(copy or cursor)",
-							 (int *) &ts_guc_remote_data_fetcher,
-							 AutoFetcherType,
-							 remote_data_fetchers,
+	DefineCustomBoolVariable("timescaledb.enable_bulk_decompression",
+							 "Enable decompression of entire batches",
+							 "Decompress whole compressed batches at once into flat arrays instead "
+							 "of decompressing one value at a time",
+							 &ts_guc_enable_bulk_decompression,
+							 true,
 							 PGC_USERSET,
 							 0,
 							 NULL,
 							 NULL,
 							 NULL);
 
-	DefineCustomStringVariable("timescaledb.ssl_dir",
-							   "TimescaleDB user certificate directory",
-							   "Determines a path which is used to search user certificates and "
-							   "private keys",
-							   &ts_guc_ssl_dir,
-							   NULL,
-							   PGC_SIGHUP,
-							   0,
-							   NULL,
-							   NULL,
-							   NULL);
-
-	DefineCustomStringVariable("timescaledb.passfile",
+	DefineCustomBoolVariable("timescaledb.enable_vectorized_aggregation",
+							 "Enable vectorized aggregation",
+							 "Compute partial aggregates directly from the decompressed batches "
+							 "of compressed chunks",
+							 &ts_guc_enable_vectorized_aggregation,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_decompression_sorted_merge",
+							 "Enable batch sorted merge of compressed chunks",
+							 "Merge the sorted compressed batches of different segments instead "
+							 "of sorting the decompressed rows by the orderby columns",
+							 &ts_guc_enable_decompression_sorted_merge,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_parallel_batch_decompression",
+							 "Enable handing out compressed batches to parallel workers",
+							 "Let the parallel workers decompressing a chunk claim its compressed "
+							 "batches one at a time instead of scanning block ranges of the "
+							 "compressed chunk",
+							 &ts_guc_enable_parallel_batch_decompression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.compress_parallel_workers",
+							"Maximum parallel workers per chunk compression",
+							"Compress the segments of a chunk in this many parallel workers. "
+							"Setting this to 0 compresses the chunk in the calling process",
+							&ts_guc_compress_parallel_workers,
+							0,
+							0,
+							MAX_PARALLEL_WORKER_LIMIT,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.decompress_parallel_workers",
+							"Maximum parallel workers per chunk decompression",
+							"Decompress the batches of a chunk in this many parallel workers. "
+							"Setting this to 0 decompresses the chunk in the calling process",
+							&ts_guc_decompress_parallel_workers,
+							0,
+							0,
+							MAX_PARALLEL_WORKER_LIMIT,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.compress_batch_size",
+							"Maximum number of rows per compressed batch",
+							"Compress at most this many rows of a segment into one batch of "
+							"the compressed chunk. Larger batches compress dense series better, "
+							"smaller batches decompress less data for point lookups. Only "
+							"affects chunks compressed afterwards",
+							&ts_guc_compress_batch_size,
+							1000,
+							1,
+							10000,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomEnumVariable("timescaledb.compress_toast_compression",
+							 "TOAST compression method of the compressed columns",
+							 "The compression method for the TOAST data of the array and "
+							 "dictionary compressed columns, set on the compressed table when "
+							 "compression is enabled or a column is added. The default uses "
+							 "default_toast_compression when the data is written",
+							 (int *) &ts_guc_compress_toast_compression,
+							 COMPRESS_TOAST_COMPRESSION_DEFAULT,
+							 compress_toast_compressions,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.decompress_prefetch_batches",
+							"Number of compressed batches to prefetch",
+							"Read the compressed tuples of this many batches ahead of the "
+							"batch being decompressed and prefetch their TOAST chunks. Only "
+							"effective on platforms that support prefetching. Setting this to "
+							"0 disables prefetching",
+							&ts_guc_decompress_prefetch_batches,
+							0,
+							0,
+							64,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.decompress_cache_size",
+							"Size of the cache of decompressed columns",
+							"Keep the bulk decompressed columns of recently scanned compressed "
+							"batches in a backend-local cache of this size, so that repeated "
+							"queries over the same batches don't decompress them again. Setting "
+							"this to 0 disables the cache",
+							&ts_guc_decompress_cache_size,
+							0,
+							0,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("timescaledb.vector_agg_cache_size",
+							"Size of the cache of partial aggregates of compressed chunks",
+							"Keep the partial aggregates that the vectorized aggregation computes "
+							"over compressed chunks in a backend-local cache of this size, so "
+							"that repeated queries over the same unchanged chunks don't aggregate "
+							"them again. Setting this to 0 disables the cache",
+							&ts_guc_vector_agg_cache_size,
+							0,
+							0,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_decompression_stats",
+							 "Show decompression statistics in EXPLAIN ANALYZE",
+							 "Collect the counts of decompressed and filtered batches, the "
+							 "detoasted bytes and the decompression time per compression "
+							 "algorithm in DecompressChunk, and show them in EXPLAIN ANALYZE",
+							 &ts_guc_enable_decompression_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_planner_timing",
+							 "Time the phases of the hypertable planning",
+							 "Time the chunk lookup, the loading of the chunk catalog data, the "
+							 "chunk exclusion and the expansion of the hypertables into chunks "
+							 "during planning, see _timescaledb_internal.planner_timing()",
+							 &ts_guc_enable_planner_timing,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_segmentwise_recompression",
+							 "Enable recompression of only the changed segments",
+							 "Recompress a partially compressed chunk by rewriting only the "
+							 "compressed batches of the segments that received new rows",
+							 &ts_guc_enable_segmentwise_recompression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_batch_retention",
+							 "Enable dropping compressed batches older than the retention cutoff",
+							 "Make drop_chunks and the retention policy also delete the "
+							 "compressed batches whose newest time value is older than the "
+							 "cutoff from the compressed chunks that span the cutoff",
+							 &ts_guc_enable_batch_retention,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_delete_truncation",
+							 "Enable truncating the chunks covered by a DELETE",
+							 "Truncate the chunks whose whole time range matches the predicate "
+							 "of a DELETE on a hypertable instead of deleting their rows one by "
+							 "one. Like TRUNCATE this is not MVCC-safe",
+							 &ts_guc_enable_delete_truncation,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_gapfill_hash_groups",
+							 "Enable hash grouped gapfill",
+							 "Fill the gaps of all the groups of a gapfill query bucket by bucket "
+							 "from input sorted only by time, instead of sorting the input by "
+							 "the group columns and time",
+							 &ts_guc_enable_gapfill_hash_groups,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_bitpack_compression",
+							 "Enable bit-packing compression of integers",
+							 "Compress the batches of integer columns with frame-of-reference "
+							 "bit-packing when it is smaller than the delta-delta encoding",
+							 &ts_guc_enable_bitpack_compression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_uuid_compression",
+							 "Enable the compression algorithm for UUIDs",
+							 "Compress the uuid columns with the algorithm that stores repeated "
+							 "and time-ordered UUIDs compactly, instead of the dictionary one",
+							 &ts_guc_enable_uuid_compression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_jsonb_compression",
+							 "Enable the compression algorithm for JSONB",
+							 "Compress the jsonb columns with the algorithm that stores the "
+							 "objects of a batch column-wise per key, instead of the dictionary "
+							 "one",
+							 &ts_guc_enable_jsonb_compression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compression_sampling",
+							 "Enable choosing the compression algorithms by sampling",
+							 "Choose the compression algorithm of each column by compressing "
+							 "the first batches of a chunk with all the suitable algorithms",
+							 &ts_guc_enable_compression_sampling,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compression_radix_sort",
+							 "Enable sorting the rows to compress by a radix sort",
+							 "Sort the rows of a chunk for compression with a radix sort of "
+							 "the keys when all the segmentby and orderby columns are integers "
+							 "or timestamps and the rows fit in maintenance_work_mem",
+							 &ts_guc_enable_compression_radix_sort,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compression_hash_grouping",
+							 "Enable compressing chunks without sorting them",
+							 "Group the rows of a chunk by the segmentby columns in a single scan "
+							 "and compress them without sorting when every segment is already "
+							 "in the orderby order, falling back to sorting when it is not",
+							 &ts_guc_enable_compression_hash_grouping,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compression_sample_stats",
+							 "Enable building the chunk statistics while compressing",
+							 "Build the column statistics of a chunk from a sample of its rows "
+							 "taken while compressing it, instead of running ANALYZE on the chunk",
+							 &ts_guc_enable_compression_sample_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_merged_hypertable_stats",
+							 "Enable merging the chunk statistics on ANALYZE of a hypertable",
+							 "Build the statistics of a hypertable from the statistics of its "
+							 "chunks, analyzing only the chunks changed since their last ANALYZE, "
+							 "instead of sampling the rows of all the chunks",
+							 &ts_guc_enable_merged_hypertable_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compressed_insert_buffering",
+							 "Enable buffering the inserts into compressed chunks",
+							 "Buffer the rows inserted into compressed chunks per segment and "
+							 "compress them into new batches when they fill up",
+							 &ts_guc_enable_compressed_insert_buffering,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_direct_compression",
+							 "Enable compressing the chunks created by inserts right away",
+							 "Compress the chunks of hypertables with compression enabled when "
+							 "an insert creates them, and compress the inserted rows into "
+							 "batches directly instead of writing them to the chunk first",
+							 &ts_guc_enable_direct_compression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_append_only_inserts",
+							 "Enable append-only inserts into chunks",
+							 "Insert the rows of INSERT and COPY at the end of the chunks, "
+							 "without looking up free space in the free space map, and keep "
+							 "the page being filled pinned between the rows of a chunk",
+							 &ts_guc_enable_append_only_inserts,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_dml_decompression",
+							 "Enable UPDATE, DELETE and unique checks on compressed chunks",
+							 "Decompress the compressed batches that can contain rows modified "
+							 "by UPDATE or DELETE, or rows conflicting with inserted rows on a "
+							 "unique index, instead of raising an error",
+							 &ts_guc_enable_dml_decompression,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_insert_batching",
+							 "Enable batching the inserts into chunks",
+							 "Buffer the rows of INSERTs per chunk and insert them in batches "
+							 "like COPY does",
+							 &ts_guc_enable_insert_batching,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomEnumVariable("timescaledb.remote_data_fetcher",
+							 "Set remote data fetcher type",
+							 "Pick data fetcher type based on type of queries you plan to run "
+							 "(copy, cursor or columnar)",
+							 (int *) &ts_guc_remote_data_fetcher,
+							 AutoFetcherType,
+							 remote_data_fetchers,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.remote_fetch_memory",
+							"Memory budget of a remote data fetcher batch",
+							"Adapt the fetch size of the cursor and COPY fetchers to the size of "
+							"the fetched rows, growing it while the scan keeps consuming batches "
+							"as long as a batch fits in this budget. Setting this to 0 uses the "
+							"fixed fetch_size of the foreign server",
+							&ts_guc_remote_fetch_memory,
+							0,
+							0,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_cursor_prefetch",
+							 "Enable prefetching in the cursor fetcher",
+							 "Request the next batch of a remote cursor as soon as the current "
+							 "batch has arrived, overlapping remote execution and local processing",
+							 &ts_guc_enable_cursor_prefetch,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_parallel_connect",
+							 "Enable opening data node connections in parallel",
+							 "Open the connections to all data nodes accessed by a distributed "
+							 "query concurrently instead of one at a time",
+							 &ts_guc_enable_parallel_connect,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_replica_load_balancing",
+							 "Enable load balancing of reads across chunk replicas",
+							 "Scan each replicated chunk on the data node with the least "
+							 "expected work, based on the chunks already assigned to each data "
+							 "node and their observed response times",
+							 &ts_guc_enable_replica_load_balancing,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.data_node_response_timeout",
+							"Time to wait for a data node to respond to a query",
+							"Fail a distributed query when a data node does not start responding "
+							"within this time instead of waiting for the statement timeout. The "
+							"data node is then avoided for replicated chunks for a while. Setting "
+							"this to 0 disables the timeout",
+							&ts_guc_data_node_response_timeout,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_colocated_join",
+							 "Enable co-located joins of distributed hypertables",
+							 "Push down joins of distributed hypertables that are partitioned "
+							 "the same way on the join key to the data nodes, when the matching "
+							 "chunks are on the same data nodes. Also needs "
+							 "enable_partitionwise_join",
+							 &ts_guc_enable_colocated_join,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_streaming_chunk_copy",
+							 "Enable streaming chunk copy between data nodes",
+							 "Copy and move chunks by streaming their data, including any "
+							 "compressed data, with binary COPY through the access node instead "
+							 "of setting up logical replication for each chunk",
+							 &ts_guc_enable_streaming_chunk_copy,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_prepared_stmt_cache",
+							 "Enable caching of prepared statements on data nodes",
+							 "Keep the statements prepared for inserts, updates and deletes on "
+							 "data nodes and reuse them in later queries and transactions on the "
+							 "same connection",
+							 &ts_guc_enable_prepared_stmt_cache,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomStringVariable("timescaledb.ssl_dir",
+							   "TimescaleDB user certificate directory",
+							   "Determines a path which is used to search user certificates and "
+							   "private keys",
+							   &ts_guc_ssl_dir,
+							   NULL,
+							   PGC_SIGHUP,
+							   0,
+							   NULL,
+							   NULL,
+							   NULL);
+
+	DefineCustomStringVariable("timescaledb.passfile",
 							   "TimescaleDB password file path",
 							   "Specifies the name of the file used to store passwords used for "
 							   "data node connections",
@@ -455,6 +1496,22 @@ _guc_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("timescaledb.copy_buffer_memory",
+							"Memory budget of the COPY buffers",
+							"Memory the COPY buffers of all chunks may use together. The buffers "
+							"are sized from the width of the copied tuples and the number of "
+							"chunks copied into within this budget. Setting this to 0 uses "
+							"buffers of a fixed size",
+							&ts_guc_copy_buffer_memory,
+							0,
+							0,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomIntVariable("timescaledb.max_cached_chunks_per_hypertable",
 							"Maximum cached chunks",
 							"Maximum number of chunks stored in the cache",
@@ -467,6 +1524,53 @@ _guc_init(void)
 							NULL,
 							assign_max_cached_chunks_per_hypertable_hook,
 							NULL);
+
+	DefineCustomIntVariable("timescaledb.max_hypertable_cache_memory",
+							"Maximum memory of the hypertable cache",
+							"Memory the hypertable cache of a backend may use, including the "
+							"cached chunks. The least recently used hypertables are evicted "
+							"from the cache when it grows larger. Setting this to 0 does not "
+							"limit the memory",
+							&ts_guc_max_hypertable_cache_memory,
+							0,
+							0,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomEnumVariable("timescaledb.chunk_tablespace_selection",
+							 "Tablespace selection for new chunks",
+							 "How new chunks are placed in the tablespaces attached to the "
+							 "hypertable. With round_robin, the chunks of a space partition "
+							 "stay in the same tablespace. With least_used, a chunk is placed "
+							 "in the tablespace with the fewest chunks of its time slice and "
+							 "then with the least data (round_robin or least_used)",
+							 (int *) &ts_guc_chunk_tablespace_selection,
+							 CHUNK_TABLESPACE_ROUND_ROBIN,
+							 chunk_tablespace_selections,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomEnumVariable("timescaledb.chunk_prewarm",
+							 "Prewarm decompressed chunks",
+							 "Read the chunks decompressed by a transaction into shared buffers "
+							 "from a background worker after the transaction commits. With "
+							 "indexes, only the chunk indexes are read. With all, the indexes "
+							 "and then the table are read (off, indexes or all)",
+							 (int *) &ts_guc_chunk_prewarm,
+							 CHUNK_PREWARM_OFF,
+							 chunk_prewarm_modes,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
 #ifdef USE_TELEMETRY
 	DefineCustomEnumVariable("timescaledb.telemetry_level",
 							 "Telemetry settings level",
@@ -479,6 +1583,20 @@ _guc_init(void)
 							 NULL,
 							 NULL,
 							 NULL);
+
+	DefineCustomIntVariable("timescaledb.telemetry_function_sample_interval",
+							"Sample interval of the function telemetry",
+							"On average, only one in this many queries is searched for the "
+							"functions it calls, and its counts are scaled up accordingly",
+							&ts_guc_telemetry_function_sample_interval,
+							1,
+							1,
+							10000,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
 #endif
 
 	DefineCustomStringVariable(/* name= */ "timescaledb.license",
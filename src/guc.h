@@ -18,21 +18,66 @@ extern bool ts_function_telemetry_on(void);
 extern bool ts_guc_enable_optimizations;
 extern bool ts_guc_enable_constraint_aware_append;
 extern bool ts_guc_enable_ordered_append;
+extern bool ts_guc_enable_ordered_append_group_by;
 extern bool ts_guc_enable_chunk_append;
+extern bool ts_guc_enable_lazy_chunk_expansion;
 extern bool ts_guc_enable_parallel_chunk_append;
+extern bool ts_guc_enable_chunk_append_merge;
 extern bool ts_guc_enable_qual_propagation;
 extern bool ts_guc_enable_runtime_exclusion;
 extern bool ts_guc_enable_constraint_exclusion;
+extern bool ts_guc_enable_slice_index;
 extern bool ts_guc_enable_cagg_reorder_groupby;
 extern bool ts_guc_enable_now_constify;
 extern bool ts_guc_enable_osm_reads;
+extern bool ts_guc_enable_insert_batching;
 extern TSDLLEXPORT bool ts_guc_enable_transparent_decompression;
 extern TSDLLEXPORT bool ts_guc_enable_per_data_node_queries;
+extern bool ts_guc_enable_dist_partial_agg;
 extern TSDLLEXPORT bool ts_guc_enable_async_append;
+extern TSDLLEXPORT int ts_guc_async_append_max_fanout;
 extern TSDLLEXPORT bool ts_guc_enable_skip_scan;
+extern TSDLLEXPORT bool ts_guc_enable_compressed_skip_scan;
+extern TSDLLEXPORT bool ts_guc_enable_compression_cost_stats;
+extern TSDLLEXPORT bool ts_guc_enable_last_point_cache;
+extern bool ts_guc_enable_grouped_first_last;
+extern bool ts_guc_enable_chunk_skipping;
+extern bool ts_guc_enable_batch_retention;
+extern bool ts_guc_enable_delete_truncation;
+extern TSDLLEXPORT bool ts_guc_enable_gapfill_hash_groups;
+extern bool ts_guc_enable_space_partitionwise_agg;
+extern bool ts_guc_enable_chunkwise_join;
+extern bool ts_guc_enable_cagg_invalidation_tracking;
+extern bool ts_guc_enable_adaptive_chunking_insert_stats;
+extern bool ts_guc_enable_chunk_creation_slice_locks;
+extern TSDLLEXPORT bool ts_guc_enable_cagg_diff_materialization;
+extern TSDLLEXPORT bool ts_guc_enable_cagg_incremental_refresh;
+extern TSDLLEXPORT bool ts_guc_enable_cagg_nested_materialized_source;
+extern TSDLLEXPORT bool ts_guc_enable_cagg_compressed_refresh;
+extern TSDLLEXPORT bool ts_guc_enable_cagg_remote_refresh;
+extern TSDLLEXPORT bool ts_guc_enable_cagg_partition_invalidation;
 extern bool ts_guc_restoring;
 extern int ts_guc_max_open_chunks_per_insert;
 extern int ts_guc_max_cached_chunks_per_hypertable;
+extern int ts_guc_max_hypertable_cache_memory;
+extern int ts_guc_copy_buffer_memory;
+
+typedef enum ChunkTablespaceSelection
+{
+	CHUNK_TABLESPACE_ROUND_ROBIN,
+	CHUNK_TABLESPACE_LEAST_USED,
+} ChunkTablespaceSelection;
+
+extern ChunkTablespaceSelection ts_guc_chunk_tablespace_selection;
+
+typedef enum ChunkPrewarmMode
+{
+	CHUNK_PREWARM_OFF,
+	CHUNK_PREWARM_INDEXES,
+	CHUNK_PREWARM_ALL,
+} ChunkPrewarmMode;
+
+extern TSDLLEXPORT ChunkPrewarmMode ts_guc_chunk_prewarm;
 
 #ifdef USE_TELEMETRY
 typedef enum TelemetryLevel
@@ -43,6 +88,7 @@ typedef enum TelemetryLevel
 } TelemetryLevel;
 
 extern TelemetryLevel ts_guc_telemetry_level;
+extern int ts_guc_telemetry_function_sample_interval;
 extern char *ts_telemetry_cloud;
 #endif
 
@@ -50,22 +96,74 @@ extern TSDLLEXPORT char *ts_guc_license;
 extern char *ts_last_tune_time;
 extern char *ts_last_tune_version;
 extern TSDLLEXPORT bool ts_guc_enable_2pc;
+extern TSDLLEXPORT bool ts_guc_enable_async_commit_prepared;
+extern TSDLLEXPORT bool ts_guc_enable_replica_load_balancing;
+extern TSDLLEXPORT int ts_guc_data_node_response_timeout;
+extern TSDLLEXPORT bool ts_guc_enable_colocated_join;
+extern TSDLLEXPORT bool ts_guc_enable_streaming_chunk_copy;
+extern TSDLLEXPORT bool ts_guc_enable_prepared_stmt_cache;
 extern TSDLLEXPORT int ts_guc_max_insert_batch_size;
+extern TSDLLEXPORT int ts_guc_max_insert_pipeline_depth;
+extern TSDLLEXPORT bool ts_guc_enable_async_insert_flush;
+extern TSDLLEXPORT int ts_guc_cagg_max_invalidation_ranges;
+extern TSDLLEXPORT int ts_guc_cagg_refresh_parallel_jobs;
+extern TSDLLEXPORT int ts_guc_bgw_job_worker_idle_timeout;
+extern TSDLLEXPORT bool ts_guc_bgw_job_schedule_spread;
+extern TSDLLEXPORT int ts_guc_bgw_job_stat_flush_interval;
+extern TSDLLEXPORT bool ts_guc_enable_concurrent_reorder;
 extern TSDLLEXPORT bool ts_guc_enable_connection_binary_data;
 extern TSDLLEXPORT bool ts_guc_enable_client_ddl_on_data_nodes;
 extern TSDLLEXPORT char *ts_guc_ssl_dir;
 extern TSDLLEXPORT char *ts_guc_passfile;
 extern TSDLLEXPORT bool ts_guc_enable_remote_explain;
 extern TSDLLEXPORT bool ts_guc_enable_compression_indexscan;
+extern TSDLLEXPORT bool ts_guc_enable_bulk_decompression;
+extern TSDLLEXPORT bool ts_guc_enable_vectorized_aggregation;
+extern TSDLLEXPORT bool ts_guc_enable_decompression_sorted_merge;
+extern TSDLLEXPORT bool ts_guc_enable_parallel_batch_decompression;
+extern TSDLLEXPORT int ts_guc_compress_parallel_workers;
+extern TSDLLEXPORT int ts_guc_decompress_parallel_workers;
+extern TSDLLEXPORT int ts_guc_compress_batch_size;
+
+typedef enum CompressToastCompression
+{
+	COMPRESS_TOAST_COMPRESSION_DEFAULT,
+	COMPRESS_TOAST_COMPRESSION_PGLZ,
+	COMPRESS_TOAST_COMPRESSION_LZ4,
+} CompressToastCompression;
+
+extern TSDLLEXPORT CompressToastCompression ts_guc_compress_toast_compression;
+extern TSDLLEXPORT int ts_guc_decompress_prefetch_batches;
+extern TSDLLEXPORT int ts_guc_decompress_cache_size;
+extern TSDLLEXPORT int ts_guc_vector_agg_cache_size;
+extern TSDLLEXPORT bool ts_guc_enable_decompression_stats;
+extern bool ts_guc_enable_planner_timing;
+extern TSDLLEXPORT bool ts_guc_enable_segmentwise_recompression;
+extern TSDLLEXPORT bool ts_guc_enable_bitpack_compression;
+extern TSDLLEXPORT bool ts_guc_enable_uuid_compression;
+extern TSDLLEXPORT bool ts_guc_enable_jsonb_compression;
+extern TSDLLEXPORT bool ts_guc_enable_compression_sampling;
+extern TSDLLEXPORT bool ts_guc_enable_compression_radix_sort;
+extern TSDLLEXPORT bool ts_guc_enable_compression_hash_grouping;
+extern TSDLLEXPORT bool ts_guc_enable_compression_sample_stats;
+extern bool ts_guc_enable_merged_hypertable_stats;
+extern TSDLLEXPORT bool ts_guc_enable_compressed_insert_buffering;
+extern TSDLLEXPORT bool ts_guc_enable_direct_compression;
+extern TSDLLEXPORT bool ts_guc_enable_append_only_inserts;
+extern TSDLLEXPORT bool ts_guc_enable_dml_decompression;
 
 typedef enum DataFetcherType
 {
 	CursorFetcherType,
 	CopyFetcherType,
 	AutoFetcherType,
+	ColumnarFetcherType,
 } DataFetcherType;
 
 extern TSDLLEXPORT DataFetcherType ts_guc_remote_data_fetcher;
+extern TSDLLEXPORT int ts_guc_remote_fetch_memory;
+extern TSDLLEXPORT bool ts_guc_enable_cursor_prefetch;
+extern TSDLLEXPORT bool ts_guc_enable_parallel_connect;
 
 typedef enum HypertableDistType
 {
@@ -85,6 +183,7 @@ typedef enum DistCopyTransferFormat
 } DistCopyTransferFormat;
 
 extern TSDLLEXPORT DistCopyTransferFormat ts_guc_dist_copy_transfer_format;
+extern TSDLLEXPORT int ts_guc_dist_copy_connections_per_data_node;
 
 /* Hook for plugins to allow additional SSL options */
 typedef void (*set_ssl_options_hook_type)(const char *user_name);
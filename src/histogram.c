@@ -13,6 +13,7 @@
 #include <libpq/pqformat.h>
 
 #include "compat/compat.h"
+#include "histogram.h"
 #include "utils.h"
 
 /* aggregate histogram:
@@ -37,24 +38,84 @@ TS_FUNCTION_INFO_V1(ts_hist_finalfunc);
 
 #define HISTOGRAM_SIZE(state, nbuckets) (sizeof(*(state)) + (nbuckets) * sizeof(*(state)->buckets))
 
+/*
+ * The state has a fixed size for the number of buckets, the counts are kept
+ * as int32 so that the buckets of a large histogram stay dense in memory.
+ */
 typedef struct Histogram
 {
 	int32 nbuckets;
-	Datum buckets[FLEXIBLE_ARRAY_MEMBER];
+	int32 buckets[FLEXIBLE_ARRAY_MEMBER];
 } Histogram;
 
+/*
+ * Check the arguments the same way width_bucket() does, so that the bucket
+ * can be computed inline with ts_histogram_bucket().
+ */
+void
+ts_histogram_check_args(float8 min, float8 max, int32 nbuckets)
+{
+	if (min > max)
+	{
+		/* cannot generate a histogram with incompatible bounds */
+		elog(ERROR, "lower bound cannot exceed upper bound");
+	}
+
+	if (nbuckets <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("count must be greater than zero")));
+
+	if (nbuckets > PG_INT32_MAX - 2)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE), errmsg("integer out of range")));
+
+	if (isnan(min) || isnan(max))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("operand, lower bound, and upper bound cannot be NaN")));
+
+	if (isinf(min) || isinf(max))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("lower and upper bounds must be finite")));
+
+	if (min == max)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("lower bound cannot equal upper bound")));
+}
+
+/*
+ * Serialize the bucket counts, nbuckets includes the two buckets for the
+ * values outside of the range. Also used by the vectorized aggregation to
+ * produce the partial histogram.
+ */
+bytea *
+ts_histogram_serialize_counts(const int32 *counts, int32 nbuckets)
+{
+	StringInfoData buf;
+
+	pq_begintypsend(&buf);
+	pq_sendint32(&buf, nbuckets);
+
+	for (int32 i = 0; i < nbuckets; i++)
+		pq_sendint32(&buf, counts[i]);
+
+	return pq_endtypsend(&buf);
+}
+
 /* histogram(state, val, min, max, nbuckets) */
 Datum
 ts_hist_sfunc(PG_FUNCTION_ARGS)
 {
 	MemoryContext aggcontext;
 	Histogram *state = (Histogram *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
-	Datum val_datum = PG_GETARG_DATUM(1);
-	Datum min_datum = PG_GETARG_DATUM(2);
-	Datum max_datum = PG_GETARG_DATUM(3);
-	double min = DatumGetFloat8(min_datum);
-	double max = DatumGetFloat8(max_datum);
-	int nbuckets;
+	float8 val = PG_GETARG_FLOAT8(1);
+	float8 min = PG_GETARG_FLOAT8(2);
+	float8 max = PG_GETARG_FLOAT8(3);
+	int32 nbuckets = PG_GETARG_INT32(4);
+	int32 bucket;
 
 	if (!AggCheckCallContext(fcinfo, &aggcontext))
 	{
@@ -62,40 +123,30 @@ ts_hist_sfunc(PG_FUNCTION_ARGS)
 		elog(ERROR, "ts_hist_sfunc called in non-aggregate context");
 	}
 
-	if (min > max)
-	{
-		/* cannot generate a histogram with incompatible bounds */
-		elog(ERROR, "lower bound cannot exceed upper bound");
-	}
+	ts_histogram_check_args(min, max, nbuckets);
 
 	if (state == NULL)
 	{
-		nbuckets = PG_GETARG_INT32(4) + 2;
 		/* Allocate memory to a new histogram state array */
-		state = MemoryContextAllocZero(aggcontext, HISTOGRAM_SIZE(state, nbuckets));
-		state->nbuckets = nbuckets;
+		state = MemoryContextAllocZero(aggcontext, HISTOGRAM_SIZE(state, nbuckets + 2));
+		state->nbuckets = nbuckets + 2;
 	}
 
 	/* Since the number of buckets is an argument to the calls it might differ
 	 * from the number we initialized with so we need to make sure we check
 	 * against what we actually have.
 	 */
-	nbuckets = state->nbuckets - 2;
-	if (nbuckets != PG_GETARG_INT32(4))
+	if (state->nbuckets - 2 != nbuckets)
 		elog(ERROR, "number of buckets must not change between calls");
 
-	int32 bucket = DatumGetInt32(DirectFunctionCall4(width_bucket_float8,
-													 val_datum,
-													 min_datum,
-													 max_datum,
-													 Int32GetDatum(nbuckets)));
+	bucket = ts_histogram_bucket(val, min, max, nbuckets);
 
 	/* Increment the proper histogram bucket */
 	Assert(bucket < state->nbuckets);
-	if (DatumGetInt32(state->buckets[bucket]) >= PG_INT32_MAX - 1)
+	if (state->buckets[bucket] >= PG_INT32_MAX - 1)
 		elog(ERROR, "overflow in histogram");
 
-	state->buckets[bucket] = Int32GetDatum(DatumGetInt32(state->buckets[bucket]) + 1);
+	state->buckets[bucket]++;
 
 	PG_RETURN_POINTER(state);
 }
@@ -122,7 +173,6 @@ ts_hist_combinefunc(PG_FUNCTION_ARGS)
 
 	Histogram *state1 = (Histogram *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
 	Histogram *state2 = (Histogram *) (PG_ARGISNULL(1) ? NULL : PG_GETARG_POINTER(1));
-	Histogram *result;
 
 	if (!AggCheckCallContext(fcinfo, &aggcontext))
 	{
@@ -130,41 +180,35 @@ ts_hist_combinefunc(PG_FUNCTION_ARGS)
 		elog(ERROR, "ts_hist_combinefunc called in non-aggregate context");
 	}
 
-	if (state1 == NULL && state2 == NULL)
-	{
-		PG_RETURN_NULL();
-	}
-	else if (state2 == NULL)
-	{
-		result = copy_state(aggcontext, state1);
-	}
-	else if (state1 == NULL)
+	if (state2 == NULL)
 	{
-		result = copy_state(aggcontext, state2);
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state1);
 	}
-	else
+
+	if (state1 == NULL)
+		PG_RETURN_POINTER(copy_state(aggcontext, state2));
+
+	/* Since number of buckets is part of the aggregation call the initialization
+	 * might be different in the partials so we error out if they are not identical. */
+	if (state1->nbuckets != state2->nbuckets)
+		elog(ERROR, "number of buckets must not change between calls");
+
+	/* The transition state belongs to the aggregate, so add state2 into it in place */
+	for (int32 i = 0; i < state1->nbuckets; i++)
 	{
-		/* Since number of buckets is part of the aggregation call the initialization
-		 * might be different in the partials so we error out if they are not identical. */
-		if (state1->nbuckets != state2->nbuckets)
-			elog(ERROR, "number of buckets must not change between calls");
-
-		result = copy_state(aggcontext, state1);
-
-		/* Combine values from state1 and state2 when both states are non-null */
-		for (int32 i = 0; i < state1->nbuckets; i++)
-		{
-			/* Perform addition using int64 to check for overflow */
-			int64 val = (int64) DatumGetInt32(result->buckets[i]);
-			int64 other = (int64) DatumGetInt32(state2->buckets[i]);
-			if (val + other >= PG_INT32_MAX)
-				elog(ERROR, "overflow in histogram combine");
-
-			result->buckets[i] = Int32GetDatum((int32) (val + other));
-		}
+		/* Perform addition using int64 to check for overflow */
+		int64 val = (int64) state1->buckets[i];
+		int64 other = (int64) state2->buckets[i];
+		if (val + other >= PG_INT32_MAX)
+			elog(ERROR, "overflow in histogram combine");
+
+		state1->buckets[i] = (int32) (val + other);
 	}
 
-	PG_RETURN_POINTER(result);
+	PG_RETURN_POINTER(state1);
 }
 
 /* ts_hist_serializefunc(internal) => bytea */
@@ -172,18 +216,11 @@ Datum
 ts_hist_serializefunc(PG_FUNCTION_ARGS)
 {
 	Histogram *state;
-	StringInfoData buf;
 
 	Assert(!PG_ARGISNULL(0));
 	state = (Histogram *) PG_GETARG_POINTER(0);
 
-	pq_begintypsend(&buf);
-	pq_sendint32(&buf, state->nbuckets);
-
-	for (int32 i = 0; i < state->nbuckets; i++)
-		pq_sendint32(&buf, DatumGetInt32(state->buckets[i]));
-
-	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+	PG_RETURN_BYTEA_P(ts_histogram_serialize_counts(state->buckets, state->nbuckets));
 }
 
 /* ts_hist_deserializefunc(bytea *, internal) => internal */
@@ -214,7 +251,7 @@ ts_hist_deserializefunc(PG_FUNCTION_ARGS)
 	state->nbuckets = nbuckets;
 
 	for (i = 0; i < state->nbuckets; i++)
-		state->buckets[i] = Int32GetDatum(pq_getmsgint(&buf, 4));
+		state->buckets[i] = pq_getmsgint(&buf, 4);
 
 	PG_RETURN_POINTER(state);
 }
@@ -224,6 +261,7 @@ Datum
 ts_hist_finalfunc(PG_FUNCTION_ARGS)
 {
 	Histogram *state;
+	Datum *values;
 	int dims[1];
 	int lbs[1];
 
@@ -238,9 +276,12 @@ ts_hist_finalfunc(PG_FUNCTION_ARGS)
 	if (state == NULL)
 		PG_RETURN_NULL();
 
+	values = palloc(sizeof(Datum) * state->nbuckets);
+	for (int32 i = 0; i < state->nbuckets; i++)
+		values[i] = Int32GetDatum(state->buckets[i]);
+
 	dims[0] = state->nbuckets;
 	lbs[0] = 1;
 
-	PG_RETURN_ARRAYTYPE_P(
-		construct_md_array(state->buckets, NULL, 1, dims, lbs, INT4OID, 4, true, 'i'));
+	PG_RETURN_ARRAYTYPE_P(construct_md_array(values, NULL, 1, dims, lbs, INT4OID, 4, true, 'i'));
 }
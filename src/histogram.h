@@ -0,0 +1,40 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_HISTOGRAM_H
+#define TIMESCALEDB_HISTOGRAM_H
+
+#include <postgres.h>
+#include <math.h>
+
+#include "export.h"
+
+extern TSDLLEXPORT void ts_histogram_check_args(float8 min, float8 max, int32 nbuckets);
+extern TSDLLEXPORT bytea *ts_histogram_serialize_counts(const int32 *counts, int32 nbuckets);
+
+/*
+ * The histogram bucket of the value, the same as width_bucket(value, min, max,
+ * nbuckets) for the arguments validated with ts_histogram_check_args(). The
+ * values below min go into bucket 0, the values at or above max into bucket
+ * nbuckets + 1.
+ */
+static inline int32
+ts_histogram_bucket(float8 value, float8 min, float8 max, int32 nbuckets)
+{
+	if (unlikely(isnan(value)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("operand, lower bound, and upper bound cannot be NaN")));
+
+	if (value < min)
+		return 0;
+
+	if (value >= max)
+		return nbuckets + 1;
+
+	return (int32) ((float8) nbuckets * (value - min) / (max - min)) + 1;
+}
+
+#endif /* TIMESCALEDB_HISTOGRAM_H */
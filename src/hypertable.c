@@ -44,6 +44,7 @@
 #include "chunk.h"
 #include "chunk_adaptive.h"
 #include "ts_catalog/hypertable_compression.h"
+#include "ts_catalog/chunk_column_stats.h"
 #include "subspace_store.h"
 #include "hypertable_cache.h"
 #include "trigger.h"
@@ -63,6 +64,7 @@
 #include "cross_module_fn.h"
 #include "scan_iterator.h"
 #include "debug_assert.h"
+#include "last_point.h"
 
 Oid
 ts_rel_get_owner(Oid relid)
@@ -249,10 +251,14 @@ ts_hypertable_from_tupleinfo(const TupleInfo *ti)
 	namespace_oid = get_namespace_oid(NameStr(h->fd.schema_name), false);
 	h->main_table_relid = get_relname_relid(NameStr(h->fd.table_name), namespace_oid);
 	h->space = ts_dimension_scan(h->fd.id, h->main_table_relid, h->fd.num_dimensions, ti->mctx);
+	/* A separate context, so that the memory of the cached chunks can be accounted */
 	h->chunk_cache =
-		ts_subspace_store_init(h->space, ti->mctx, ts_guc_max_cached_chunks_per_hypertable);
+		ts_subspace_store_init(h->space,
+							   AllocSetContextCreate(ti->mctx, "Chunk cache", ALLOCSET_SMALL_SIZES),
+							   ts_guc_max_cached_chunks_per_hypertable);
 	h->chunk_sizing_func = get_chunk_sizing_func_oid(&h->fd);
 	h->data_nodes = ts_hypertable_data_node_scan(h->fd.id, ti->mctx);
+	h->last_point_relid = ts_last_point_cache_get_relid(h->fd.id);
 
 	return h;
 }
@@ -616,6 +622,7 @@ hypertable_tuple_delete(TupleInfo *ti, void *data)
 
 	/* remove any associated compression definitions */
 	ts_hypertable_compression_delete_by_hypertable_id(hypertable_id);
+	ts_chunk_column_stats_delete_by_hypertable_id(hypertable_id);
 
 	if (!compressed_hypertable_id_isnull)
 	{
@@ -1151,6 +1158,92 @@ hypertable_get_chunk_round_robin_index(const Hypertable *ht, const Hypercube *hc
 	return ts_dimension_get_slice_ordinal(dim, slice) + offset;
 }
 
+/*
+ * Select the tablespace with the fewest chunks in the time slice of the new
+ * chunk, so that the chunks that are written at the same time are spread over
+ * the tablespaces, and among those the tablespace with the least data, so that
+ * the tablespaces fill evenly.
+ *
+ * The size of a tablespace is only looked at when there is more than one
+ * candidate, since it is calculated from the files in the tablespace, and if
+ * the user may read it.
+ */
+static Tablespace *
+hypertable_select_least_used_tablespace(const Hypertable *ht, const Chunk *chunk,
+										Tablespaces *tspcs)
+{
+	const Dimension *dim = hyperspace_get_open_dimension(ht->space, 0);
+	const DimensionSlice *slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+	int *num_chunks = palloc0(sizeof(int) * tspcs->num_tablespaces);
+	Tablespace *selected = NULL;
+	int64 selected_size = 0;
+	int min_chunks = PG_INT32_MAX;
+	int num_candidates = 0;
+	int i, j;
+
+	if (slice != NULL && slice->fd.id > 0)
+	{
+		ChunkConstraints *ccs = ts_chunk_constraints_alloc(1, CurrentMemoryContext);
+
+		ts_chunk_constraint_scan_by_dimension_slice_id(slice->fd.id, ccs, CurrentMemoryContext);
+
+		for (j = 0; j < ccs->num_constraints; j++)
+		{
+			Oid relid = ts_chunk_get_relid(ccs->constraints[j].fd.chunk_id, true);
+			Oid tspc_oid;
+
+			/* The new chunk, or a dropped chunk */
+			if (!OidIsValid(relid))
+				continue;
+
+			tspc_oid = get_rel_tablespace(relid);
+
+			for (i = 0; i < tspcs->num_tablespaces; i++)
+				if (tspcs->tablespaces[i].tablespace_oid == tspc_oid)
+					num_chunks[i]++;
+		}
+	}
+
+	for (i = 0; i < tspcs->num_tablespaces; i++)
+	{
+		if (num_chunks[i] < min_chunks)
+		{
+			min_chunks = num_chunks[i];
+			num_candidates = 0;
+		}
+
+		if (num_chunks[i] == min_chunks)
+			num_candidates++;
+	}
+
+	for (i = 0; i < tspcs->num_tablespaces; i++)
+	{
+		Tablespace *tspc = &tspcs->tablespaces[i];
+		int64 size = 0;
+
+		if (num_chunks[i] != min_chunks)
+			continue;
+
+		if (num_candidates > 1 &&
+			pg_tablespace_aclcheck(tspc->tablespace_oid, GetUserId(), ACL_CREATE) == ACLCHECK_OK)
+		{
+			Datum tspc_oid = ObjectIdGetDatum(tspc->tablespace_oid);
+
+			size = DatumGetInt64(DirectFunctionCall1(pg_tablespace_size_oid, tspc_oid));
+		}
+
+		if (selected == NULL || size < selected_size)
+		{
+			selected = tspc;
+			selected_size = size;
+		}
+	}
+
+	pfree(num_chunks);
+
+	return selected;
+}
+
 /*
  * Select a tablespace to use for a given chunk.
  *
@@ -1160,6 +1253,9 @@ hypertable_get_chunk_round_robin_index(const Hypertable *ht, const Hypercube *hc
  * We try to do "sticky" selection to consistently pick the same tablespace for
  * chunks in the same closed (space) dimension. This ensures chunks in the same
  * "space" partition will live on the same disk.
+ *
+ * Alternatively, the least used tablespace is selected, see
+ * timescaledb.chunk_tablespace_selection.
  */
 Tablespace *
 ts_hypertable_select_tablespace(const Hypertable *ht, const Chunk *chunk)
@@ -1170,6 +1266,10 @@ ts_hypertable_select_tablespace(const Hypertable *ht, const Chunk *chunk)
 	if (NULL == tspcs || tspcs->num_tablespaces == 0)
 		return NULL;
 
+	if (ts_guc_chunk_tablespace_selection == CHUNK_TABLESPACE_LEAST_USED &&
+		tspcs->num_tablespaces > 1)
+		return hypertable_select_least_used_tablespace(ht, chunk, tspcs);
+
 	i = hypertable_get_chunk_round_robin_index(ht, chunk->cube);
 
 	/* Use the index of the slice to find the tablespace */
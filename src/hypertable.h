@@ -58,6 +58,8 @@ typedef struct Hypertable
 	 * use all available data nodes.
 	 */
 	List *data_nodes;
+	/* The table with the newest row of every key, see last_point.c */
+	Oid last_point_relid;
 } Hypertable;
 
 /* create_hypertable record attribute numbers */
@@ -5,11 +5,15 @@
  */
 #include <postgres.h>
 #include <catalog/namespace.h>
+#include <funcapi.h>
+#include <lib/ilist.h>
 #include <utils/catcache.h>
 #include <utils/lsyscache.h>
 #include <utils/builtins.h>
 
+#include "compat/compat.h"
 #include "errors.h"
+#include "guc.h"
 #include "hypertable_cache.h"
 #include "hypertable.h"
 #include "ts_catalog/catalog.h"
@@ -17,6 +21,7 @@
 #include "scanner.h"
 #include "dimension.h"
 #include "ts_catalog/tablespace.h"
+#include "subspace_store.h"
 
 static void *hypertable_cache_create_entry(Cache *cache, CacheQuery *query);
 static void hypertable_cache_missing_error(const Cache *cache, const CacheQuery *query);
@@ -39,8 +44,36 @@ typedef struct
 {
 	Oid relid;
 	Hypertable *hypertable;
+	/* Memory of the hypertable and its cached chunks, NULL for negative entries */
+	MemoryContext mcxt;
+	dlist_node lru_node;
 } HypertableCacheEntry;
 
+/*
+ * The hypertable cache keeps its entries in the order of their last use, so
+ * that the least recently used ones can be evicted when the cache is larger
+ * than timescaledb.max_hypertable_cache_memory.
+ */
+typedef struct HypertableCache
+{
+	Cache cache;
+	dlist_head lru;
+} HypertableCache;
+
+/* Statistics of the destroyed caches and the removed entries of this backend */
+static CacheStats hypertable_cache_stats_removed;
+static SubspaceStoreStats chunk_cache_stats_removed;
+
+static void
+chunk_cache_stats_add(SubspaceStoreStats *total, const Hypertable *ht)
+{
+	const SubspaceStoreStats *stats = ts_subspace_store_stats(ht->chunk_cache);
+
+	total->hits += stats->hits;
+	total->misses += stats->misses;
+	total->evictions += stats->evictions;
+}
+
 static bool
 hypertable_cache_valid_result(const void *result)
 {
@@ -49,13 +82,57 @@ hypertable_cache_valid_result(const void *result)
 	return ((HypertableCacheEntry *) result)->hypertable != NULL;
 }
 
+static void *
+hypertable_cache_update_entry(Cache *cache, CacheQuery *query)
+{
+	HypertableCache *hcache = (HypertableCache *) cache;
+	HypertableCacheEntry *entry = query->result;
+
+	dlist_move_head(&hcache->lru, &entry->lru_node);
+	return entry;
+}
+
+static void
+hypertable_cache_remove_entry(void *entry)
+{
+	HypertableCacheEntry *cache_entry = entry;
+
+	if (cache_entry->hypertable != NULL)
+		chunk_cache_stats_add(&chunk_cache_stats_removed, cache_entry->hypertable);
+
+	dlist_delete(&cache_entry->lru_node);
+
+	if (cache_entry->mcxt != NULL)
+		MemoryContextDelete(cache_entry->mcxt);
+}
+
+static void
+hypertable_cache_pre_destroy(Cache *cache)
+{
+	HypertableCache *hcache = (HypertableCache *) cache;
+	dlist_iter iter;
+
+	hypertable_cache_stats_removed.hits += cache->stats.hits;
+	hypertable_cache_stats_removed.misses += cache->stats.misses;
+	hypertable_cache_stats_removed.evictions += cache->stats.evictions;
+
+	dlist_foreach (iter, &hcache->lru)
+	{
+		HypertableCacheEntry *entry = dlist_container(HypertableCacheEntry, lru_node, iter.cur);
+
+		if (entry->hypertable != NULL)
+			chunk_cache_stats_add(&chunk_cache_stats_removed, entry->hypertable);
+	}
+}
+
 static Cache *
 hypertable_cache_create()
 {
 	MemoryContext ctx =
 		AllocSetContextCreate(CacheMemoryContext, "Hypertable cache", ALLOCSET_DEFAULT_SIZES);
 
-	Cache *cache = MemoryContextAlloc(ctx, sizeof(Cache));
+	HypertableCache *hcache = MemoryContextAlloc(ctx, sizeof(HypertableCache));
+	Cache *cache = &hcache->cache;
 	Cache		template =
 	{
 		.hctl =
@@ -69,11 +146,15 @@ hypertable_cache_create()
 		.flags = HASH_ELEM | HASH_CONTEXT | HASH_BLOBS,
 		.get_key = hypertable_cache_get_key,
 		.create_entry = hypertable_cache_create_entry,
+		.update_entry = hypertable_cache_update_entry,
 		.missing_error = hypertable_cache_missing_error,
 		.valid_result = hypertable_cache_valid_result,
+		.remove_entry = hypertable_cache_remove_entry,
+		.pre_destroy_hook = hypertable_cache_pre_destroy,
 	};
 
 	*cache = template;
+	dlist_init(&hcache->lru);
 
 	ts_cache_init(cache);
 
@@ -98,6 +179,17 @@ hypertable_cache_create_entry(Cache *cache, CacheQuery *query)
 	HypertableCacheEntry *cache_entry = query->result;
 	int number_found;
 
+	/*
+	 * Every hypertable gets its own memory context, so that it can be freed
+	 * when it is evicted. Link the entry first so that it can always be
+	 * removed.
+	 */
+	cache_entry->hypertable = NULL;
+	cache_entry->mcxt = AllocSetContextCreate(ts_cache_memory_ctx(cache),
+											  "Hypertable cache entry",
+											  ALLOCSET_SMALL_SIZES);
+	dlist_push_head(&((HypertableCache *) cache)->lru, &cache_entry->lru_node);
+
 	if (NULL == hq->schema)
 		hq->schema = get_namespace_name(get_rel_namespace(hq->relid));
 
@@ -110,13 +202,15 @@ hypertable_cache_create_entry(Cache *cache, CacheQuery *query)
 														  query->result,
 														  AccessShareLock,
 														  false,
-														  ts_cache_memory_ctx(cache));
+														  cache_entry->mcxt);
 
 	switch (number_found)
 	{
 		case 0:
 			/* Negative cache entry: table is not a hypertable */
 			cache_entry->hypertable = NULL;
+			MemoryContextDelete(cache_entry->mcxt);
+			cache_entry->mcxt = NULL;
 			break;
 		case 1:
 			Assert(strncmp(cache_entry->hypertable->fd.schema_name.data, hq->schema, NAMEDATALEN) ==
@@ -209,12 +303,134 @@ ts_hypertable_cache_get_entry_with_table(Cache *cache, const Oid relid, const ch
 	return entry == NULL ? NULL : entry->hypertable;
 }
 
+/*
+ * Evict the least recently used entries until the memory of the cache is
+ * within the limit. The entries can only be freed while the cache is not
+ * pinned, since the pins hold on to the hypertables returned from the cache.
+ */
+static void
+hypertable_cache_evict(HypertableCache *hcache)
+{
+	Size limit = (Size) ts_guc_max_hypertable_cache_memory * 1024;
+	Size used;
+
+	if (limit == 0 || hcache->cache.refcount > 1)
+		return;
+
+	used = MemoryContextMemAllocated(ts_cache_memory_ctx(&hcache->cache), true);
+
+	while (used > limit && !dlist_is_empty(&hcache->lru))
+	{
+		HypertableCacheEntry *entry =
+			dlist_tail_element(HypertableCacheEntry, lru_node, &hcache->lru);
+		Oid relid = entry->relid;
+
+		if (entry->mcxt != NULL)
+			used -= MemoryContextMemAllocated(entry->mcxt, true);
+
+		ts_cache_remove(&hcache->cache, &relid);
+		hcache->cache.stats.evictions++;
+	}
+}
+
 extern TSDLLEXPORT Cache *
 ts_hypertable_cache_pin()
 {
+	hypertable_cache_evict((HypertableCache *) hypertable_cache_current);
 	return ts_cache_pin(hypertable_cache_current);
 }
 
+#define CACHE_INFO_NATTS 6
+
+/*
+ * Statistics of the hypertable cache and of the chunk caches of the cached
+ * hypertables in this backend. The memory of the hypertable cache includes
+ * the chunk caches, the hits, misses and evictions are counted since the
+ * start of the backend.
+ */
+TS_FUNCTION_INFO_V1(ts_hypertable_cache_info);
+
+Datum
+ts_hypertable_cache_info(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("function returning record called in context "
+							"that cannot accept type record")));
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->max_calls = 2;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		HypertableCache *hcache = (HypertableCache *) hypertable_cache_current;
+		const CacheStats *stats = &hcache->cache.stats;
+		Datum values[CACHE_INFO_NATTS];
+		bool nulls[CACHE_INFO_NATTS] = { false };
+		HeapTuple tuple;
+
+		if (funcctx->call_cntr == 0)
+		{
+			values[0] = CStringGetTextDatum("hypertable_cache");
+			values[1] = Int64GetDatum(stats->numelements);
+			values[2] = Int64GetDatum(
+				MemoryContextMemAllocated(ts_cache_memory_ctx(&hcache->cache), true));
+			values[3] = Int64GetDatum(hypertable_cache_stats_removed.hits + stats->hits);
+			values[4] = Int64GetDatum(hypertable_cache_stats_removed.misses + stats->misses);
+			values[5] =
+				Int64GetDatum(hypertable_cache_stats_removed.evictions + stats->evictions);
+		}
+		else
+		{
+			SubspaceStoreStats chunk_stats = chunk_cache_stats_removed;
+			int64 entries = 0;
+			Size bytes = 0;
+			dlist_iter iter;
+
+			dlist_foreach (iter, &hcache->lru)
+			{
+				HypertableCacheEntry *entry =
+					dlist_container(HypertableCacheEntry, lru_node, iter.cur);
+				SubspaceStore *chunk_cache;
+
+				if (entry->hypertable == NULL)
+					continue;
+
+				chunk_cache = entry->hypertable->chunk_cache;
+				entries += ts_subspace_store_num_entries(chunk_cache);
+				bytes += MemoryContextMemAllocated(ts_subspace_store_mcxt(chunk_cache), true);
+				chunk_cache_stats_add(&chunk_stats, entry->hypertable);
+			}
+
+			values[0] = CStringGetTextDatum("chunk_cache");
+			values[1] = Int64GetDatum(entries);
+			values[2] = Int64GetDatum(bytes);
+			values[3] = Int64GetDatum(chunk_stats.hits);
+			values[4] = Int64GetDatum(chunk_stats.misses);
+			values[5] = Int64GetDatum(chunk_stats.evictions);
+		}
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
 void
 _hypertable_cache_init(void)
 {
@@ -6,6 +6,7 @@
 #include <postgres.h>
 
 #include <catalog/pg_inherits.h>
+#include <fmgr.h>
 #include <optimizer/optimizer.h>
 #include <parser/parsetree.h>
 #include <utils/array.h>
@@ -17,13 +18,17 @@
 
 #include "chunk.h"
 #include "chunk_scan.h"
+#include "compat/compat.h"
 #include "dimension.h"
 #include "dimension_slice.h"
+#include "dimension_slice_index.h"
 #include "dimension_vector.h"
 #include "guc.h"
 #include "hypercube.h"
 #include "partitioning.h"
+#include "planner/planner_timing.h"
 #include "scan_iterator.h"
+#include "time_utils.h"
 #include "utils.h"
 
 #include <inttypes.h>
@@ -524,7 +529,8 @@ scan_and_append_slices(ScanIterator *it, int old_nkeys, DimensionVec **dv, bool
 	return *dv;
 }
 
-/* search dimension_slice catalog table for slices that meet hri restriction
+/* search dimension_slice catalog table, or the dimension slice index when it
+ * is enabled, for slices that meet hri restriction
  */
 static List *
 gather_restriction_dimension_vectors(const HypertableRestrictInfo *hri)
@@ -549,6 +555,18 @@ gather_restriction_dimension_vectors(const HypertableRestrictInfo *hri)
 			{
 				const DimensionRestrictInfoOpen *open = (const DimensionRestrictInfoOpen *) dri;
 
+				if (ts_guc_enable_slice_index)
+				{
+					dv = ts_dimension_slice_index_find(open->base.dimension->fd.id,
+													   open->upper_strategy,
+													   open->upper_bound,
+													   open->lower_strategy,
+													   open->lower_bound,
+													   &dv,
+													   false);
+					break;
+				}
+
 				ts_dimension_slice_scan_iterator_set_range(&it,
 														   open->base.dimension->fd.id,
 														   open->upper_strategy,
@@ -591,6 +609,18 @@ gather_restriction_dimension_vectors(const HypertableRestrictInfo *hri)
 				{
 					int32 partition = lfirst_int(cell);
 
+					if (ts_guc_enable_slice_index)
+					{
+						dv = ts_dimension_slice_index_find(dri->dimension->fd.id,
+														   BTLessEqualStrategyNumber,
+														   partition,
+														   BTGreaterEqualStrategyNumber,
+														   partition,
+														   &dv,
+														   true);
+						continue;
+					}
+
 					/*
 					 * slice_end >= value && slice_start <= value.
 					 * See the comment about scan direction above.
@@ -636,10 +666,73 @@ gather_restriction_dimension_vectors(const HypertableRestrictInfo *hri)
 	return dimension_vecs;
 }
 
+#if PG14_GE
+/*
+ * Hook for OSM to start fetching the tiered data of a query ahead of the
+ * scan, e.g., into a local cache. The range is the restriction on the first
+ * (time) dimension in PostgreSQL time format, PG_INT64_MIN and PG_INT64_MAX
+ * mean unbounded.
+ */
+#define OSM_CHUNK_SCAN_PREFETCH_HOOK "osm_chunk_scan_prefetch_hook"
+typedef void (*ts_osm_chunk_scan_prefetch_hook_type)(Oid ht_oid, int64 range_start,
+													 int64 range_end);
+
+static ts_osm_chunk_scan_prefetch_hook_type
+get_osm_chunk_scan_prefetch_hook()
+{
+	ts_osm_chunk_scan_prefetch_hook_type *func_ptr =
+		(ts_osm_chunk_scan_prefetch_hook_type *) find_rendezvous_variable(
+			OSM_CHUNK_SCAN_PREFETCH_HOOK);
+	return *func_ptr;
+}
+#endif
+
+/*
+ * Tell OSM which range of the tiered data a query reads once the OSM chunk
+ * survived the chunk exclusion. If the caller has not looked up the OSM
+ * chunk yet, check that the hypertable has one.
+ */
+static void
+osm_chunk_scan_prefetch(const HypertableRestrictInfo *hri, const Hypertable *ht,
+						bool check_osm_chunk)
+{
+#if PG14_GE
+	ts_osm_chunk_scan_prefetch_hook_type prefetch_func_ptr = get_osm_chunk_scan_prefetch_hook();
+	const Dimension *dim = &ht->space->dimensions[0];
+	int64 range_start = PG_INT64_MIN;
+	int64 range_end = PG_INT64_MAX;
+
+	if (prefetch_func_ptr == NULL ||
+		(check_osm_chunk && ts_chunk_get_osm_chunk_id(ht->fd.id) == INVALID_CHUNK_ID))
+		return;
+
+	for (int i = 0; i < hri->num_dimensions; i++)
+	{
+		const DimensionRestrictInfoOpen *dri =
+			(const DimensionRestrictInfoOpen *) hri->dimension_restriction[i];
+
+		if (dri->base.dimension->fd.id != dim->fd.id)
+			continue;
+
+		if (dri->lower_strategy != InvalidStrategy)
+			range_start = ts_internal_to_time_int64(dri->lower_bound, dim->fd.column_type);
+		if (dri->upper_strategy != InvalidStrategy)
+			range_end = ts_internal_to_time_int64(dri->upper_bound, dim->fd.column_type);
+	}
+
+	prefetch_func_ptr(ht->main_table_relid, range_start, range_end);
+#endif
+}
+
 Chunk **
 ts_hypertable_restrict_info_get_chunks(HypertableRestrictInfo *hri, Hypertable *ht,
 									   unsigned int *num_chunks)
 {
+	instr_time start;
+	Chunk **chunks;
+
+	ts_planner_timing_start(&start);
+
 	/*
 	 * Remove the dimensions for which we don't have a restriction, that is,
 	 * the entire range of the dimension matches. Such dimensions do not
@@ -677,6 +770,8 @@ ts_hypertable_restrict_info_get_chunks(HypertableRestrictInfo *hri, Hypertable *
 
 			chunk_ids = list_delete_int(chunk_ids, osm_chunk_id);
 		}
+		else
+			osm_chunk_scan_prefetch(hri, ht, true);
 	}
 	else
 	{
@@ -717,6 +812,7 @@ ts_hypertable_restrict_info_get_chunks(HypertableRestrictInfo *hri, Hypertable *
 			else
 			{
 				chunk_ids = list_append_unique_int(chunk_ids, osm_chunk_id);
+				osm_chunk_scan_prefetch(hri, ht, false);
 			}
 		}
 	}
@@ -729,7 +825,14 @@ ts_hypertable_restrict_info_get_chunks(HypertableRestrictInfo *hri, Hypertable *
 	 */
 	chunk_ids = list_sort_compat(chunk_ids, list_int_cmp_compat);
 
-	return ts_chunk_scan_by_chunk_ids(ht->space, chunk_ids, num_chunks);
+	ts_planner_timing_stop(PLANNER_TIMING_CHUNK_LOOKUP, &start, list_length(chunk_ids));
+	ts_planner_timing_start(&start);
+
+	chunks = ts_chunk_scan_by_chunk_ids(ht->space, chunk_ids, num_chunks);
+
+	ts_planner_timing_stop(PLANNER_TIMING_CHUNK_LOAD, &start, *num_chunks);
+
+	return chunks;
 }
 
 /*
@@ -0,0 +1,472 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/table.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_inherits.h>
+#include <catalog/pg_statistic.h>
+#include <commands/vacuum.h>
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/sortsupport.h>
+#include <utils/syscache.h>
+#include <utils/typcache.h>
+
+#include "hypertable_stats.h"
+#include "hypertable.h"
+#include "import/analyze.h"
+
+/*
+ * The inherited statistics of a hypertable, i.e., the ones the planner uses
+ * for the hypertable as a whole, are normally built by ANALYZE from a sample
+ * of the rows of all the chunks. On large hypertables this reads random
+ * blocks of every chunk, even though the chunks have statistics of their own.
+ *
+ * Instead, the statistics of the chunks are merged here:
+ *
+ * - The null fraction and the average width are weighted by the rows of
+ *   every chunk.
+ * - The number of distinct values is the sum over the chunks for the open
+ *   dimension, whose values do not repeat across chunks, and the largest one
+ *   for the other columns, which usually have the same values, e.g., the
+ *   devices, in every chunk. When all the chunks estimate it as a fraction of
+ *   their rows, it stays a fraction.
+ * - The most common values are the values of the lists of all the chunks
+ *   with the highest frequencies in the hypertable.
+ * - The histogram bounds are picked from the bounds of all the chunks, each
+ *   weighted by the rows its chunk has per histogram bucket.
+ *
+ * The correlation and the other statistics kinds are not merged.
+ */
+
+typedef struct ChunkRows
+{
+	Oid relid;
+	double rows;
+} ChunkRows;
+
+typedef struct WeightedValue
+{
+	Datum value;
+	double weight;
+	int order;
+} WeightedValue;
+
+typedef struct WeightedValues
+{
+	WeightedValue *values;
+	int num_values;
+	int max_values;
+	/* The most entries of a single chunk */
+	int max_chunk_values;
+	Oid op;
+	Oid collation;
+} WeightedValues;
+
+/*
+ * Check if the statistics of a chunk are up to date, i.e., the chunk was
+ * analyzed and was not modified since. Without the table statistics, e.g.,
+ * with track_counts disabled, the chunk is assumed to have changed.
+ */
+bool
+ts_hypertable_stats_chunk_is_current(Oid chunk_relid)
+{
+	PgStat_StatTabEntry *tabentry = pgstat_fetch_stat_tabentry(chunk_relid);
+
+	if (tabentry == NULL)
+		return false;
+
+	return (tabentry->analyze_count + tabentry->autovac_analyze_count) > 0 &&
+		   tabentry->changes_since_analyze == 0;
+}
+
+static void
+weighted_values_add(WeightedValues *wv, Datum value, double weight, Form_pg_attribute attr)
+{
+	if (wv->num_values == wv->max_values)
+	{
+		wv->max_values = Max(64, wv->max_values * 2);
+		if (wv->values == NULL)
+			wv->values = palloc(sizeof(WeightedValue) * wv->max_values);
+		else
+			wv->values = repalloc(wv->values, sizeof(WeightedValue) * wv->max_values);
+	}
+
+	wv->values[wv->num_values].value = datumCopy(value, attr->attbyval, attr->attlen);
+	wv->values[wv->num_values].weight = weight;
+	wv->values[wv->num_values].order = wv->num_values;
+	wv->num_values++;
+}
+
+static int
+weighted_value_cmp(const void *a, const void *b, void *arg)
+{
+	const WeightedValue *wa = (const WeightedValue *) a;
+	const WeightedValue *wb = (const WeightedValue *) b;
+	int cmp = ApplySortComparator(wa->value, false, wb->value, false, (SortSupport) arg);
+
+	if (cmp != 0)
+		return cmp;
+
+	return (wa->order > wb->order) - (wa->order < wb->order);
+}
+
+/* Highest weight first, in the order the values were added on ties */
+static int
+weighted_value_weight_cmp(const void *a, const void *b)
+{
+	const WeightedValue *wa = (const WeightedValue *) a;
+	const WeightedValue *wb = (const WeightedValue *) b;
+
+	if (wa->weight != wb->weight)
+		return wa->weight < wb->weight ? 1 : -1;
+
+	return (wa->order > wb->order) - (wa->order < wb->order);
+}
+
+/*
+ * Sort the values with the "<" operator, and with combine, sum up the weights
+ * of the equal values.
+ */
+static void
+weighted_values_sort(WeightedValues *wv, Oid lt_opr, bool combine)
+{
+	SortSupportData ssup = { 0 };
+
+	ssup.ssup_cxt = CurrentMemoryContext;
+	ssup.ssup_collation = wv->collation;
+	ssup.ssup_nulls_first = false;
+	PrepareSortSupportFromOrderingOp(lt_opr, &ssup);
+
+	qsort_arg(wv->values, wv->num_values, sizeof(WeightedValue), weighted_value_cmp, &ssup);
+
+	/* The equal values are next to each other now */
+	if (combine)
+	{
+		int last = 0;
+
+		for (int i = 1; i < wv->num_values; i++)
+		{
+			if (ApplySortComparator(wv->values[last].value,
+									false,
+									wv->values[i].value,
+									false,
+									&ssup) == 0)
+			{
+				wv->values[last].weight += wv->values[i].weight;
+				wv->values[last].order = Min(wv->values[last].order, wv->values[i].order);
+			}
+			else
+				wv->values[++last] = wv->values[i];
+		}
+		wv->num_values = Min(wv->num_values, last + 1);
+	}
+}
+
+static void
+add_stats_slot(VacAttrStats *stats, int slot, int16 kind, const WeightedValues *wv, int num_values)
+{
+	stats->stakind[slot] = kind;
+	stats->staop[slot] = wv->op;
+	stats->stacoll[slot] = wv->collation;
+	stats->numvalues[slot] = num_values;
+	stats->stavalues[slot] = palloc(sizeof(Datum) * num_values);
+}
+
+/*
+ * Merge the statistics of a column of all the chunks. Returns NULL if no
+ * chunk has statistics for the column.
+ */
+static VacAttrStats *
+merge_column_stats(Relation rel, int attnum, List *chunks, bool disjoint)
+{
+	VacAttrStats *stats = ts_examine_attribute(rel, attnum, CurrentMemoryContext);
+	Form_pg_attribute attr;
+	WeightedValues mcv = { 0 };
+	WeightedValues hist = { 0 };
+	double total_rows = 0, null_rows = 0, nonnull_rows = 0, width_sum = 0;
+	double distinct_sum = 0, distinct_max = 0;
+	bool all_fractions = true;
+	int slot = 0;
+	ListCell *lc;
+
+	if (stats == NULL)
+		return NULL;
+
+	attr = TupleDescAttr(RelationGetDescr(rel), attnum - 1);
+
+	foreach (lc, chunks)
+	{
+		ChunkRows *chunk = lfirst(lc);
+		AttrNumber chunk_attnum = get_attnum(chunk->relid, NameStr(attr->attname));
+		Form_pg_statistic statsform;
+		AttStatsSlot sslot;
+		HeapTuple tuple;
+		double mcv_fraction = 0;
+		double distinct;
+
+		if (chunk_attnum == InvalidAttrNumber)
+			continue;
+
+		tuple = SearchSysCache3(STATRELATTINH,
+								ObjectIdGetDatum(chunk->relid),
+								Int16GetDatum(chunk_attnum),
+								BoolGetDatum(false));
+
+		if (!HeapTupleIsValid(tuple))
+			continue;
+
+		statsform = (Form_pg_statistic) GETSTRUCT(tuple);
+		total_rows += chunk->rows;
+		null_rows += chunk->rows * statsform->stanullfrac;
+		nonnull_rows += chunk->rows * (1.0 - statsform->stanullfrac);
+		width_sum += chunk->rows * (1.0 - statsform->stanullfrac) * statsform->stawidth;
+
+		/* A negative number of distinct values is a fraction of the rows */
+		if (statsform->stadistinct < 0)
+			distinct = -statsform->stadistinct * chunk->rows;
+		else
+		{
+			distinct = statsform->stadistinct;
+			all_fractions = false;
+		}
+		distinct_sum += distinct;
+		distinct_max = Max(distinct_max, distinct);
+
+		if (get_attstatsslot(&sslot,
+							 tuple,
+							 STATISTIC_KIND_MCV,
+							 InvalidOid,
+							 ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+		{
+			if (sslot.valuetype == stats->attrtypid && sslot.nvalues == sslot.nnumbers)
+			{
+				for (int i = 0; i < sslot.nvalues; i++)
+				{
+					weighted_values_add(&mcv,
+										sslot.values[i],
+										sslot.numbers[i] * chunk->rows,
+										attr);
+					mcv_fraction += sslot.numbers[i];
+				}
+				mcv.max_chunk_values = Max(mcv.max_chunk_values, sslot.nvalues);
+				mcv.op = sslot.staop;
+				mcv.collation = sslot.stacoll;
+			}
+			free_attstatsslot(&sslot);
+		}
+
+		if (get_attstatsslot(&sslot,
+							 tuple,
+							 STATISTIC_KIND_HISTOGRAM,
+							 InvalidOid,
+							 ATTSTATSSLOT_VALUES))
+		{
+			if (sslot.valuetype == stats->attrtypid && sslot.nvalues >= 2)
+			{
+				/* The rows in the histogram are the ones not in the most common values */
+				double hist_rows =
+					Max(0.0, chunk->rows * (1.0 - statsform->stanullfrac - mcv_fraction));
+
+				for (int i = 0; i < sslot.nvalues; i++)
+					weighted_values_add(&hist, sslot.values[i], hist_rows / sslot.nvalues, attr);
+				hist.max_chunk_values = Max(hist.max_chunk_values, sslot.nvalues);
+				hist.op = sslot.staop;
+				hist.collation = sslot.stacoll;
+			}
+			free_attstatsslot(&sslot);
+		}
+
+		ReleaseSysCache(tuple);
+	}
+
+	if (total_rows <= 0)
+		return NULL;
+
+	stats->stats_valid = true;
+	stats->stanullfrac = null_rows / total_rows;
+	stats->stawidth = nonnull_rows > 0 ? rint(width_sum / nonnull_rows) : 0;
+
+	if (all_fractions)
+		stats->stadistinct = -Min(1.0, distinct_sum / total_rows);
+	else
+	{
+		double distinct = disjoint ? distinct_sum : distinct_max;
+
+		/* Same as ANALYZE, the values are assumed to scale with the rows above 10% */
+		if (distinct > 0.1 * total_rows)
+			stats->stadistinct = -Min(1.0, distinct / total_rows);
+		else
+			stats->stadistinct = distinct;
+	}
+
+	if (mcv.num_values > 0)
+	{
+		TypeCacheEntry *type = lookup_type_cache(stats->attrtypid, TYPECACHE_LT_OPR);
+
+		if (OidIsValid(type->lt_opr))
+		{
+			int num_values;
+
+			weighted_values_sort(&mcv, type->lt_opr, true);
+			qsort(mcv.values, mcv.num_values, sizeof(WeightedValue), weighted_value_weight_cmp);
+			num_values = Min(mcv.num_values, mcv.max_chunk_values);
+
+			add_stats_slot(stats, slot, STATISTIC_KIND_MCV, &mcv, num_values);
+			stats->numnumbers[slot] = num_values;
+			stats->stanumbers[slot] = palloc(sizeof(float4) * num_values);
+			for (int i = 0; i < num_values; i++)
+			{
+				stats->stavalues[slot][i] = mcv.values[i].value;
+				stats->stanumbers[slot][i] = mcv.values[i].weight / total_rows;
+			}
+			slot++;
+		}
+	}
+
+	if (hist.num_values > 0)
+	{
+		double total_weight = 0, weight = 0;
+		int num_values = hist.max_chunk_values;
+		int pos = 0;
+
+		weighted_values_sort(&hist, hist.op, false);
+		for (int i = 0; i < hist.num_values; i++)
+			total_weight += hist.values[i].weight;
+
+		if (total_weight > 0)
+		{
+			/*
+			 * Keep the smallest and the largest bound and pick the ones in
+			 * between at equal distances of the summed up weights.
+			 */
+			add_stats_slot(stats, slot, STATISTIC_KIND_HISTOGRAM, &hist, num_values);
+			stats->stavalues[slot][0] = hist.values[0].value;
+			for (int i = 1; i < num_values - 1; i++)
+			{
+				double target = total_weight * i / (num_values - 1);
+
+				while (pos < hist.num_values - 1 && weight + hist.values[pos].weight < target)
+					weight += hist.values[pos++].weight;
+
+				stats->stavalues[slot][i] = hist.values[pos].value;
+			}
+			stats->stavalues[slot][num_values - 1] = hist.values[hist.num_values - 1].value;
+			slot++;
+		}
+	}
+
+	return stats;
+}
+
+/*
+ * Build the inherited statistics of a hypertable from the statistics of its
+ * chunks, without sampling the chunks.
+ *
+ * va_cols - The names of the columns to build the statistics for, or NIL for
+ *           all the columns
+ * open_dim_column - The column of the open dimension, whose values are
+ *                   disjoint across the chunks
+ *
+ * Returns the number of columns the statistics were built for.
+ */
+int
+ts_hypertable_stats_merge(Oid hypertable_relid, List *va_cols, const char *open_dim_column)
+{
+	MemoryContext merge_context =
+		AllocSetContextCreate(CurrentMemoryContext, "Merge Chunk Stats", ALLOCSET_DEFAULT_SIZES);
+	MemoryContext old = MemoryContextSwitchTo(merge_context);
+	VacAttrStats **vacattrstats;
+	List *chunk_relids;
+	List *chunks = NIL;
+	List *attnums = NIL;
+	Relation rel;
+	ListCell *lc;
+	int nstats = 0;
+
+	rel = table_open(hypertable_relid, ShareUpdateExclusiveLock);
+
+	if (!ts_hypertable_has_privs_of(hypertable_relid, GetUserId()))
+	{
+		ereport(WARNING,
+				(errmsg("skipping \"%s\" --- only table or database owner can analyze it",
+						RelationGetRelationName(rel))));
+		table_close(rel, ShareUpdateExclusiveLock);
+		MemoryContextSwitchTo(old);
+		MemoryContextDelete(merge_context);
+		return 0;
+	}
+
+	chunk_relids = find_inheritance_children(hypertable_relid, AccessShareLock);
+	foreach (lc, chunk_relids)
+	{
+		Oid chunk_relid = lfirst_oid(lc);
+		HeapTuple tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(chunk_relid));
+		ChunkRows *chunk;
+
+		if (!HeapTupleIsValid(tuple))
+			continue;
+
+		/* Skip the empty chunks and the ones never analyzed */
+		if (((Form_pg_class) GETSTRUCT(tuple))->reltuples > 0)
+		{
+			chunk = palloc(sizeof(ChunkRows));
+			chunk->relid = chunk_relid;
+			chunk->rows = ((Form_pg_class) GETSTRUCT(tuple))->reltuples;
+			chunks = lappend(chunks, chunk);
+		}
+		ReleaseSysCache(tuple);
+	}
+
+	if (va_cols == NIL)
+	{
+		for (int i = 1; i <= RelationGetNumberOfAttributes(rel); i++)
+			attnums = lappend_int(attnums, i);
+	}
+	else
+	{
+		foreach (lc, va_cols)
+		{
+			char *col = strVal(lfirst(lc));
+			AttrNumber attnum = get_attnum(hypertable_relid, col);
+
+			if (attnum == InvalidAttrNumber)
+				ereport(ERROR,
+						(errcode(ERRCODE_UNDEFINED_COLUMN),
+						 errmsg("column \"%s\" of relation \"%s\" does not exist",
+								col,
+								RelationGetRelationName(rel))));
+			attnums = lappend_int(attnums, attnum);
+		}
+	}
+
+	vacattrstats = palloc(sizeof(VacAttrStats *) * list_length(attnums));
+	foreach (lc, attnums)
+	{
+		int attnum = lfirst_int(lc);
+		Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), attnum - 1);
+		bool disjoint =
+			open_dim_column != NULL && strcmp(NameStr(attr->attname), open_dim_column) == 0;
+		VacAttrStats *stats = merge_column_stats(rel, attnum, chunks, disjoint);
+
+		if (stats != NULL)
+			vacattrstats[nstats++] = stats;
+	}
+
+	if (nstats > 0)
+		ts_update_attstats(hypertable_relid, true, nstats, vacattrstats);
+
+	table_close(rel, NoLock);
+	MemoryContextSwitchTo(old);
+	MemoryContextDelete(merge_context);
+
+	return nstats;
+}
@@ -0,0 +1,16 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_HYPERTABLE_STATS_H
+#define TIMESCALEDB_HYPERTABLE_STATS_H
+
+#include <postgres.h>
+#include <nodes/pg_list.h>
+
+extern bool ts_hypertable_stats_chunk_is_current(Oid chunk_relid);
+extern int ts_hypertable_stats_merge(Oid hypertable_relid, List *va_cols,
+									 const char *open_dim_column);
+
+#endif /* TIMESCALEDB_HYPERTABLE_STATS_H */
@@ -34,6 +34,7 @@
 
 #include "allpaths.h"
 #include "compat/compat.h"
+#include "planner/planner_timing.h"
 
 static void set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntry *rte);
 
@@ -529,9 +530,13 @@ ts_set_append_rel_size(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEn
 	 * If this is a partitioned baserel, set the consider_partitionwise_join
 	 * flag; currently, we only consider partitionwise joins with the baserel
 	 * if its targetlist doesn't contain a whole-row Var.
+	 *
+	 * Hypertables that are planned as range partitioned tables for chunk-wise
+	 * joins are treated like partitioned tables here.
 	 */
 	if (enable_partitionwise_join && rel->reloptkind == RELOPT_BASEREL &&
-		rte->relkind == RELKIND_PARTITIONED_TABLE &&
+		(rte->relkind == RELKIND_PARTITIONED_TABLE ||
+		 (rel->part_scheme != NULL && rel->part_scheme->strategy == PARTITION_STRATEGY_RANGE)) &&
 		rel->attr_needed[InvalidAttrNumber - rel->min_attr] == NULL)
 		rel->consider_partitionwise_join = true;
 
@@ -563,6 +568,8 @@ ts_set_append_rel_size(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEn
 		RelOptInfo *childrel;
 		ListCell *parentvars;
 		ListCell *childvars;
+		instr_time start;
+		bool excluded;
 
 		/* append_rel_list contains all append rels; ignore others */
 		if (appinfo->parent_relid != (Index) parentRTindex)
@@ -589,7 +596,11 @@ ts_set_append_rel_size(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEn
 		 * child RelOptInfo was built.  So we don't need any additional setup
 		 * before applying constraint exclusion.
 		 */
-		if (relation_excluded_by_constraints(root, childrel, childRTE))
+		ts_planner_timing_start(&start);
+		excluded = relation_excluded_by_constraints(root, childrel, childRTE);
+		ts_planner_timing_stop(PLANNER_TIMING_CHUNK_EXCLUSION, &start, excluded ? 1 : 0);
+
+		if (excluded)
 		{
 			/*
 			 * This child need not be scanned, so we can omit it from the
@@ -0,0 +1,32 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * This file contains source code that was copied and/or modified from
+ * the PostgreSQL database, which is licensed under the open-source
+ * PostgreSQL License. Please see the NOTICE at the top level
+ * directory for a copy of the PostgreSQL License.
+ *
+ * These function were copied from the PostgreSQL core ANALYZE, since
+ * they were declared static in the core, but we need them to build the
+ * statistics of a chunk from the rows we sample while compressing it.
+ */
+#ifndef TIMESCALEDB_ANALYZE_IMPORT_H
+#define TIMESCALEDB_ANALYZE_IMPORT_H
+
+#include <postgres.h>
+#include <commands/vacuum.h>
+#include <utils/rel.h>
+
+#include "export.h"
+
+extern TSDLLEXPORT VacAttrStats *ts_examine_attribute(Relation onerel, int attnum,
+													 MemoryContext anl_context);
+extern TSDLLEXPORT Datum ts_std_fetch_func(VacAttrStatsP stats, int rownum, bool *isNull);
+extern TSDLLEXPORT void ts_update_attstats(Oid relid, bool inh, int natts,
+										   VacAttrStats **vacattrstats);
+
+#endif /* TIMESCALEDB_ANALYZE_IMPORT_H */
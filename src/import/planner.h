@@ -27,8 +27,8 @@
 extern TSDLLEXPORT void ts_make_inh_translation_list(Relation oldrelation, Relation newrelation,
 													 Index newvarno, List **translated_vars);
 
-extern struct PathTarget *ts_make_partial_grouping_target(struct PlannerInfo *root,
-														  PathTarget *grouping_target);
+extern TSDLLEXPORT struct PathTarget *ts_make_partial_grouping_target(struct PlannerInfo *root,
+																	  PathTarget *grouping_target);
 
 extern bool ts_get_variable_range(PlannerInfo *root, VariableStatData *vardata, Oid sortop,
 								  Datum *min, Datum *max);
@@ -0,0 +1,160 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * Statistics of the inserts into hypertables. The counters are kept in
+ * shared memory allocated by the loader when
+ * timescaledb.ingest_stats_max_hypertables is set, so they are only
+ * collected when the loader is preloaded.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <miscadmin.h>
+#include <access/htup_details.h>
+#include <nodes/pg_list.h>
+
+#include "export.h"
+#include "ingest_stats.h"
+
+#define INGEST_STATS_NATTS (11 + INGEST_STATS_COPY_FLUSH_REASONS)
+
+static IngestStatsRendezvous *
+ingest_stats_get(void)
+{
+	static IngestStatsRendezvous *ingest_stats = NULL;
+
+	if (ingest_stats == NULL)
+		ingest_stats = *(IngestStatsRendezvous **) find_rendezvous_variable(RENDEZVOUS_INGEST_STATS);
+
+	return ingest_stats;
+}
+
+/*
+ * Add the counters of a statement to the shared counters of the hypertable.
+ * The statistics of the hypertables that do not fit into the shared hash
+ * table are dropped.
+ */
+void
+ts_ingest_stats_report(int32 hypertable_id, const IngestStatsCounters *counters)
+{
+	IngestStatsRendezvous *ingest_stats = ingest_stats_get();
+	IngestStatsKey key = { .database_id = MyDatabaseId, .hypertable_id = hypertable_id };
+	IngestStatsEntry *entry;
+	bool found;
+
+	if (ingest_stats == NULL || counters->rows == 0)
+		return;
+
+	LWLockAcquire(ingest_stats->lock, LW_EXCLUSIVE);
+	entry = hash_search(ingest_stats->hypertables, &key, HASH_ENTER_NULL, &found);
+	if (entry != NULL)
+	{
+		if (!found)
+			memset(&entry->counters, 0, sizeof(entry->counters));
+
+		entry->counters.statements += counters->statements;
+		entry->counters.rows += counters->rows;
+		entry->counters.insert_time_us += counters->insert_time_us;
+		entry->counters.insert_state_hits += counters->insert_state_hits;
+		entry->counters.insert_state_misses += counters->insert_state_misses;
+		entry->counters.insert_state_evictions += counters->insert_state_evictions;
+		entry->counters.chunk_cache_hits += counters->chunk_cache_hits;
+		entry->counters.chunk_cache_misses += counters->chunk_cache_misses;
+		entry->counters.chunks_created += counters->chunks_created;
+		entry->counters.chunk_create_time_us += counters->chunk_create_time_us;
+		for (int i = 0; i < INGEST_STATS_COPY_FLUSH_REASONS; i++)
+			entry->counters.copy_flushes[i] += counters->copy_flushes[i];
+	}
+	LWLockRelease(ingest_stats->lock);
+}
+
+/*
+ * The ingest statistics of the hypertables in the current database. The
+ * entries are copied under the lock on the first call.
+ */
+TS_FUNCTION_INFO_V1(ts_hypertable_ingest_stats);
+
+Datum
+ts_hypertable_ingest_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	List *entries;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		IngestStatsRendezvous *ingest_stats = ingest_stats_get();
+		MemoryContext oldcontext;
+		TupleDesc tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("function returning record called in context "
+							"that cannot accept type record")));
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		entries = NIL;
+		if (ingest_stats != NULL)
+		{
+			HASH_SEQ_STATUS status;
+			IngestStatsEntry *entry;
+
+			LWLockAcquire(ingest_stats->lock, LW_SHARED);
+			hash_seq_init(&status, ingest_stats->hypertables);
+			while ((entry = hash_seq_search(&status)) != NULL)
+			{
+				if (entry->key.database_id == MyDatabaseId)
+				{
+					IngestStatsEntry *copy = palloc(sizeof(IngestStatsEntry));
+
+					*copy = *entry;
+					entries = lappend(entries, copy);
+				}
+			}
+			LWLockRelease(ingest_stats->lock);
+		}
+
+		funcctx->user_fctx = entries;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	entries = funcctx->user_fctx;
+
+	if (funcctx->call_cntr < (uint64) list_length(entries))
+	{
+		IngestStatsEntry *entry = list_nth(entries, funcctx->call_cntr);
+		const IngestStatsCounters *counters = &entry->counters;
+		Datum values[INGEST_STATS_NATTS];
+		bool nulls[INGEST_STATS_NATTS] = { false };
+		HeapTuple tuple;
+		int i = 0;
+
+		values[i++] = Int32GetDatum(entry->key.hypertable_id);
+		values[i++] = Int64GetDatum(counters->statements);
+		values[i++] = Int64GetDatum(counters->rows);
+		values[i++] = Int64GetDatum(counters->insert_time_us);
+		values[i++] = Int64GetDatum(counters->insert_state_hits);
+		values[i++] = Int64GetDatum(counters->insert_state_misses);
+		values[i++] = Int64GetDatum(counters->insert_state_evictions);
+		values[i++] = Int64GetDatum(counters->chunk_cache_hits);
+		values[i++] = Int64GetDatum(counters->chunk_cache_misses);
+		values[i++] = Int64GetDatum(counters->chunks_created);
+		values[i++] = Int64GetDatum(counters->chunk_create_time_us);
+		for (int reason = 0; reason < INGEST_STATS_COPY_FLUSH_REASONS; reason++)
+			values[i++] = Int64GetDatum(counters->copy_flushes[reason]);
+
+		Assert(i == INGEST_STATS_NATTS);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
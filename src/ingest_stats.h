@@ -0,0 +1,15 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_INGEST_STATS_H
+#define TIMESCALEDB_INGEST_STATS_H
+
+#include <postgres.h>
+
+#include "loader/ingest_stats.h"
+
+extern void ts_ingest_stats_report(int32 hypertable_id, const IngestStatsCounters *counters);
+
+#endif /* TIMESCALEDB_INGEST_STATS_H */
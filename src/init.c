@@ -45,6 +45,9 @@ extern void _process_utility_fini(void);
 extern void _event_trigger_init(void);
 extern void _event_trigger_fini(void);
 
+extern void _chunk_prewarm_init(void);
+extern void _chunk_prewarm_fini(void);
+
 extern void _conn_plain_init();
 extern void _conn_plain_fini();
 
@@ -80,6 +83,7 @@ cleanup_on_pg_proc_exit(int code, Datum arg)
 #endif
 	_conn_plain_fini();
 	_guc_fini();
+	_chunk_prewarm_fini();
 	_process_utility_fini();
 	_event_trigger_fini();
 	_planner_fini();
@@ -107,6 +111,7 @@ _PG_init(void)
 	_chunk_append_init();
 	_event_trigger_init();
 	_process_utility_init();
+	_chunk_prewarm_init();
 	_guc_init();
 	_conn_plain_init();
 #ifdef TS_USE_OPENSSL
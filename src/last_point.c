@@ -0,0 +1,721 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/genam.h>
+#include <access/htup_details.h>
+#include <access/table.h>
+#include <catalog/dependency.h>
+#include <catalog/indexing.h>
+#include <catalog/namespace.h>
+#include <catalog/objectaddress.h>
+#include <catalog/pg_class.h>
+#include <commands/tablecmds.h>
+#include <executor/spi.h>
+#include <fmgr.h>
+#include <miscadmin.h>
+#include <storage/lmgr.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/hsearch.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/typcache.h>
+
+#include "compat/compat.h"
+#include "debug_assert.h"
+#include "dimension.h"
+#include "extension_constants.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "last_point.h"
+#include "ts_catalog/catalog.h"
+#include "utils.h"
+
+/*
+ * The last point cache of a hypertable is a table in the internal schema
+ * that holds the newest row, by the time column, of every value of a key
+ * column, e.g., the latest reading of every device. It is the same as
+ *
+ *     SELECT DISTINCT ON (key) * FROM hypertable ORDER BY key, time DESC
+ *
+ * but it is kept up to date by the INSERTs and COPYs into the hypertable, so
+ * the queries for the latest values of all the keys read one row per key
+ * instead of searching the chunks for them. The planner answers the queries
+ * of the form
+ *
+ *     SELECT key, last(value, time), max(time) FROM hypertable GROUP BY key
+ *
+ * from the cache (see agg_bookend.c).
+ *
+ * The rows inserted into the chunks are collected per statement, keeping the
+ * newest row of every key, and the cache is updated with them at the end of
+ * the statement with an upsert that only replaces the cached rows that are
+ * older. This way the cost of the cache is one update per key and statement,
+ * whatever the number of rows, and concurrent inserts update the rows of the
+ * cache in any order.
+ *
+ * An UPDATE or DELETE on the hypertable, and dropping its chunks, can remove
+ * the cached rows, so the cache is then rebuilt from the hypertable. With an
+ * index on (key, time DESC) this is one index descent per key.
+ *
+ * The cache has the columns that the hypertable had when it was created.
+ * Queries reading columns added later are not answered from it.
+ */
+
+#define LAST_POINT_TABLE_NAME_FORMAT "_hyper_%d_last_point"
+
+/* The buffered rows of the keys with the same hash value */
+typedef struct LastPointEntry
+{
+	uint32 hash;
+	List *tuples;
+} LastPointEntry;
+
+struct LastPointState
+{
+	Oid cache_relid;
+	Oid owner;
+	TupleDesc tupdesc;
+	AttrNumber key_attno;
+	AttrNumber time_attno;
+	Oid key_collation;
+	Oid time_collation;
+	FmgrInfo key_hash;
+	FmgrInfo key_eq;
+	FmgrInfo time_cmp;
+	char *upsert_command;
+	Datum *values;
+	bool *nulls;
+	HTAB *rows;
+	int num_rows;
+	MemoryContext mcxt;
+};
+
+static void
+last_point_table_name(int32 hypertable_id, char *name)
+{
+	snprintf(name, NAMEDATALEN, LAST_POINT_TABLE_NAME_FORMAT, hypertable_id);
+}
+
+/*
+ * Get the cache table of a hypertable, or InvalidOid if the hypertable has no
+ * last point cache.
+ */
+Oid
+ts_last_point_cache_get_relid(int32 hypertable_id)
+{
+	char name[NAMEDATALEN];
+	Oid namespace_oid = get_namespace_oid(INTERNAL_SCHEMA_NAME, true);
+
+	if (!OidIsValid(namespace_oid))
+		return InvalidOid;
+
+	last_point_table_name(hypertable_id, name);
+
+	return get_relname_relid(name, namespace_oid);
+}
+
+/*
+ * The key of the cache is the column of its unique index.
+ */
+AttrNumber
+ts_last_point_cache_get_key_attno(Oid cache_relid)
+{
+	Relation rel = table_open(cache_relid, AccessShareLock);
+	List *indexes = RelationGetIndexList(rel);
+	AttrNumber attno = InvalidAttrNumber;
+
+	if (list_length(indexes) == 1)
+	{
+		Relation index = index_open(linitial_oid(indexes), AccessShareLock);
+
+		if (index->rd_index->indnatts == 1)
+			attno = index->rd_index->indkey.values[0];
+		index_close(index, AccessShareLock);
+	}
+
+	list_free(indexes);
+	table_close(rel, AccessShareLock);
+
+	if (attno == InvalidAttrNumber)
+		elog(ERROR, "invalid last point cache \"%s\"", get_rel_name(cache_relid));
+
+	return attno;
+}
+
+static void
+last_point_execute(const char *command, int nargs, Oid *argtypes, Datum *values, int expected)
+{
+	int res;
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "could not connect to SPI");
+
+	res = SPI_execute_with_args(command, nargs, argtypes, values, NULL, false, 0);
+
+	if (res != expected)
+		elog(ERROR, "could not update the last point cache: %s", SPI_result_code_string(res));
+
+	if ((res = SPI_finish()) != SPI_OK_FINISH)
+		elog(ERROR, "SPI_finish failed: %s", SPI_result_code_string(res));
+}
+
+/*
+ * The columns of the cache that still exist in the hypertable, as a
+ * comma-separated list.
+ */
+static char *
+last_point_column_list(Relation cache_rel, Oid ht_relid)
+{
+	TupleDesc tupdesc = RelationGetDescr(cache_rel);
+	StringInfoData columns;
+
+	initStringInfo(&columns);
+
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		if (attr->attisdropped || get_attnum(ht_relid, NameStr(attr->attname)) == InvalidAttrNumber)
+			continue;
+
+		appendStringInfo(&columns,
+						 "%s%s",
+						 columns.len > 0 ? ", " : "",
+						 quote_identifier(NameStr(attr->attname)));
+	}
+
+	return columns.data;
+}
+
+/*
+ * Rebuild the cache from the rows of the hypertable.
+ */
+void
+ts_last_point_cache_refresh(const Hypertable *ht)
+{
+	const Dimension *dim = hyperspace_get_open_dimension(ht->space, 0);
+	Relation cache_rel;
+	StringInfoData command;
+	const char *cache_name;
+	const char *key_name;
+	char *columns;
+	Oid saved_uid;
+	int sec_ctx;
+
+	if (!OidIsValid(ht->last_point_relid))
+		return;
+
+	cache_rel = table_open(ht->last_point_relid, ExclusiveLock);
+	cache_name =
+		quote_qualified_identifier(INTERNAL_SCHEMA_NAME, RelationGetRelationName(cache_rel));
+	key_name = get_attname(ht->last_point_relid,
+						   ts_last_point_cache_get_key_attno(ht->last_point_relid),
+						   false);
+	columns = last_point_column_list(cache_rel, ht->main_table_relid);
+
+	/* The cache is maintained by its owner */
+	GetUserIdAndSecContext(&saved_uid, &sec_ctx);
+	SetUserIdAndSecContext(cache_rel->rd_rel->relowner, sec_ctx | SECURITY_LOCAL_USERID_CHANGE);
+
+	initStringInfo(&command);
+	appendStringInfo(&command, "DELETE FROM %s", cache_name);
+	last_point_execute(command.data, 0, NULL, NULL, SPI_OK_DELETE);
+
+	resetStringInfo(&command);
+	appendStringInfo(&command,
+					 "INSERT INTO %s (%s) SELECT DISTINCT ON (%s) %s FROM %s ORDER BY %s, %s DESC",
+					 cache_name,
+					 columns,
+					 quote_identifier(key_name),
+					 columns,
+					 quote_qualified_identifier(NameStr(ht->fd.schema_name),
+												NameStr(ht->fd.table_name)),
+					 quote_identifier(key_name),
+					 quote_identifier(NameStr(dim->fd.column_name)));
+	last_point_execute(command.data, 0, NULL, NULL, SPI_OK_INSERT);
+
+	SetUserIdAndSecContext(saved_uid, sec_ctx);
+	table_close(cache_rel, NoLock);
+}
+
+/*
+ * Create the state that collects the newest inserted row of every key in a
+ * statement. Returns NULL if the hypertable has no last point cache.
+ */
+LastPointState *
+ts_last_point_state_create(const Hypertable *ht, MemoryContext mcxt)
+{
+	const Dimension *dim = hyperspace_get_open_dimension(ht->space, 0);
+	LastPointState *state;
+	MemoryContext old;
+	Relation rel;
+	TupleDesc tupdesc;
+	TypeCacheEntry *key_type;
+	TypeCacheEntry *time_type;
+	StringInfoData command;
+	const char *cache_name;
+	bool first = true;
+
+	if (!OidIsValid(ht->last_point_relid))
+		return NULL;
+
+	old = MemoryContextSwitchTo(mcxt);
+	state = palloc0(sizeof(LastPointState));
+	state->mcxt = AllocSetContextCreate(mcxt, "Last point state", ALLOCSET_DEFAULT_SIZES);
+	state->cache_relid = ht->last_point_relid;
+
+	rel = table_open(state->cache_relid, AccessShareLock);
+	tupdesc = state->tupdesc = CreateTupleDescCopy(RelationGetDescr(rel));
+	state->owner = rel->rd_rel->relowner;
+	state->key_attno = ts_last_point_cache_get_key_attno(state->cache_relid);
+	state->time_attno = get_attnum(state->cache_relid, NameStr(dim->fd.column_name));
+
+	if (state->time_attno == InvalidAttrNumber)
+		elog(ERROR, "invalid last point cache \"%s\"", RelationGetRelationName(rel));
+
+	state->key_collation = TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(state->key_attno))
+							   ->attcollation;
+	state->time_collation = TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(state->time_attno))
+								->attcollation;
+
+	key_type = lookup_type_cache(TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(state->key_attno))
+									 ->atttypid,
+								 TYPECACHE_HASH_PROC_FINFO | TYPECACHE_EQ_OPR_FINFO);
+	time_type =
+		lookup_type_cache(TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(state->time_attno))
+							  ->atttypid,
+						  TYPECACHE_CMP_PROC_FINFO);
+
+	if (!OidIsValid(key_type->hash_proc_finfo.fn_oid) ||
+		!OidIsValid(key_type->eq_opr_finfo.fn_oid) ||
+		!OidIsValid(time_type->cmp_proc_finfo.fn_oid))
+		elog(ERROR, "invalid last point cache \"%s\"", RelationGetRelationName(rel));
+
+	fmgr_info_copy(&state->key_hash, &key_type->hash_proc_finfo, mcxt);
+	fmgr_info_copy(&state->key_eq, &key_type->eq_opr_finfo, mcxt);
+	fmgr_info_copy(&state->time_cmp, &time_type->cmp_proc_finfo, mcxt);
+
+	/*
+	 * The rows are upserted in one statement. They have different keys, so
+	 * no row of the cache is updated twice.
+	 */
+	cache_name = quote_qualified_identifier(INTERNAL_SCHEMA_NAME, RelationGetRelationName(rel));
+	initStringInfo(&command);
+	appendStringInfo(&command,
+					 "INSERT INTO %s AS c SELECT * FROM unnest($1) ON CONFLICT (%s) DO UPDATE SET ",
+					 cache_name,
+					 quote_identifier(get_attname(state->cache_relid, state->key_attno, false)));
+
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		if (attr->attisdropped)
+			continue;
+
+		appendStringInfo(&command,
+						 "%s%s = EXCLUDED.%s",
+						 first ? "" : ", ",
+						 quote_identifier(NameStr(attr->attname)),
+						 quote_identifier(NameStr(attr->attname)));
+		first = false;
+	}
+
+	appendStringInfo(&command,
+					 " WHERE c.%s < EXCLUDED.%s",
+					 quote_identifier(NameStr(dim->fd.column_name)),
+					 quote_identifier(NameStr(dim->fd.column_name)));
+	state->upsert_command = command.data;
+	state->values = palloc(sizeof(Datum) * tupdesc->natts);
+	state->nulls = palloc(sizeof(bool) * tupdesc->natts);
+
+	table_close(rel, AccessShareLock);
+	MemoryContextSwitchTo(old);
+
+	return state;
+}
+
+/*
+ * Map the columns of the cache to the columns of a relation with the rows of
+ * the hypertable, i.e., a chunk. The columns that no longer exist in the
+ * relation, or have another type, are mapped to InvalidAttrNumber and set to
+ * NULL in the cache.
+ */
+AttrNumber *
+ts_last_point_state_get_attmap(const LastPointState *state, Relation rel)
+{
+	TupleDesc indesc = RelationGetDescr(rel);
+	AttrNumber *attmap = palloc0(sizeof(AttrNumber) * state->tupdesc->natts);
+
+	for (int i = 0; i < state->tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(state->tupdesc, i);
+		AttrNumber attno;
+
+		if (attr->attisdropped)
+			continue;
+
+		attno = get_attnum(RelationGetRelid(rel), NameStr(attr->attname));
+
+		if (attno != InvalidAttrNumber &&
+			TupleDescAttr(indesc, AttrNumberGetAttrOffset(attno))->atttypid == attr->atttypid)
+			attmap[i] = attno;
+	}
+
+	return attmap;
+}
+
+/*
+ * Keep the row if it is the newest one of its key in the statement.
+ */
+void
+ts_last_point_state_store(LastPointState *state, TupleTableSlot *slot, const AttrNumber *attmap)
+{
+	AttrNumber key_attno = attmap[AttrNumberGetAttrOffset(state->key_attno)];
+	AttrNumber time_attno = attmap[AttrNumberGetAttrOffset(state->time_attno)];
+	MemoryContext old;
+	LastPointEntry *entry;
+	HeapTuple tuple;
+	Datum key, time;
+	bool isnull;
+	uint32 hash;
+	bool found;
+	ListCell *lc;
+
+	if (key_attno == InvalidAttrNumber || time_attno == InvalidAttrNumber)
+		return;
+
+	key = slot_getattr(slot, key_attno, &isnull);
+	if (isnull)
+		return;
+
+	time = slot_getattr(slot, time_attno, &isnull);
+	if (isnull)
+		return;
+
+	if (state->rows == NULL)
+	{
+		HASHCTL ctl = {
+			.keysize = sizeof(uint32),
+			.entrysize = sizeof(LastPointEntry),
+			.hcxt = state->mcxt,
+		};
+
+		state->rows =
+			hash_create("Last point rows", 128, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	hash = DatumGetUInt32(FunctionCall1Coll(&state->key_hash, state->key_collation, key));
+	entry = hash_search(state->rows, &hash, HASH_ENTER, &found);
+
+	if (!found)
+		entry->tuples = NIL;
+
+	foreach (lc, entry->tuples)
+	{
+		HeapTuple prev = lfirst(lc);
+		Datum prev_key = heap_getattr(prev, state->key_attno, state->tupdesc, &isnull);
+		Datum prev_time;
+
+		if (!DatumGetBool(FunctionCall2Coll(&state->key_eq, state->key_collation, prev_key, key)))
+			continue;
+
+		prev_time = heap_getattr(prev, state->time_attno, state->tupdesc, &isnull);
+
+		if (DatumGetInt32(
+				FunctionCall2Coll(&state->time_cmp, state->time_collation, prev_time, time)) >= 0)
+			return;
+
+		break;
+	}
+
+	slot_getallattrs(slot);
+
+	for (int i = 0; i < state->tupdesc->natts; i++)
+	{
+		if (attmap[i] == InvalidAttrNumber)
+		{
+			state->values[i] = (Datum) 0;
+			state->nulls[i] = true;
+		}
+		else
+		{
+			state->values[i] = slot->tts_values[AttrNumberGetAttrOffset(attmap[i])];
+			state->nulls[i] = slot->tts_isnull[AttrNumberGetAttrOffset(attmap[i])];
+		}
+	}
+
+	old = MemoryContextSwitchTo(state->mcxt);
+	tuple = heap_form_tuple(state->tupdesc, state->values, state->nulls);
+
+	if (lc != NULL)
+	{
+		heap_freetuple(lfirst(lc));
+		lfirst(lc) = tuple;
+	}
+	else
+	{
+		entry->tuples = lappend(entry->tuples, tuple);
+		state->num_rows++;
+	}
+
+	MemoryContextSwitchTo(old);
+}
+
+/*
+ * Update the cache with the collected rows.
+ */
+void
+ts_last_point_state_flush(LastPointState *state)
+{
+	HASH_SEQ_STATUS status;
+	LastPointEntry *entry;
+	MemoryContext old;
+	Datum *rows;
+	Datum array;
+	Oid argtype;
+	Oid saved_uid;
+	int sec_ctx;
+	int i = 0;
+
+	if (state == NULL || state->num_rows == 0)
+		return;
+
+	old = MemoryContextSwitchTo(state->mcxt);
+	rows = palloc(sizeof(Datum) * state->num_rows);
+	hash_seq_init(&status, state->rows);
+
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		ListCell *lc;
+
+		foreach (lc, entry->tuples)
+			rows[i++] = heap_copy_tuple_as_datum(lfirst(lc), state->tupdesc);
+	}
+
+	Assert(i == state->num_rows);
+	array = PointerGetDatum(
+		construct_array(rows, state->num_rows, state->tupdesc->tdtypeid, -1, false, 'd'));
+	argtype = get_array_type(state->tupdesc->tdtypeid);
+	MemoryContextSwitchTo(old);
+
+	/*
+	 * The cache is maintained by its owner, the rows were inserted with the
+	 * permissions on the hypertable.
+	 */
+	GetUserIdAndSecContext(&saved_uid, &sec_ctx);
+	SetUserIdAndSecContext(state->owner, sec_ctx | SECURITY_LOCAL_USERID_CHANGE);
+	last_point_execute(state->upsert_command, 1, &argtype, &array, SPI_OK_INSERT);
+	SetUserIdAndSecContext(saved_uid, sec_ctx);
+
+	MemoryContextReset(state->mcxt);
+	state->rows = NULL;
+	state->num_rows = 0;
+}
+
+static void
+last_point_cache_invalidate(void)
+{
+	Catalog *catalog = ts_catalog_get();
+
+	ts_catalog_invalidate_cache(catalog_get_table_id(catalog, HYPERTABLE), CMD_UPDATE);
+}
+
+static Oid
+last_point_cache_create(const Hypertable *ht, const char *key_column)
+{
+	char table_name[NAMEDATALEN];
+	CatalogSecurityContext sec_ctx;
+	StringInfoData command;
+	ObjectAddress cache_addr, ht_addr;
+	Oid owner = ts_rel_get_owner(ht->main_table_relid);
+	Oid relid;
+
+	last_point_table_name(ht->fd.id, table_name);
+	initStringInfo(&command);
+	appendStringInfo(&command,
+					 "CREATE TABLE %s (LIKE %s)",
+					 quote_qualified_identifier(INTERNAL_SCHEMA_NAME, table_name),
+					 quote_qualified_identifier(NameStr(ht->fd.schema_name),
+												NameStr(ht->fd.table_name)));
+
+	/* Like the chunks, the cache is created in the internal schema by the catalog owner */
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	last_point_execute(command.data, 0, NULL, NULL, SPI_OK_UTILITY);
+
+	resetStringInfo(&command);
+	appendStringInfo(&command,
+					 "CREATE UNIQUE INDEX ON %s (%s)",
+					 quote_qualified_identifier(INTERNAL_SCHEMA_NAME, table_name),
+					 quote_identifier(key_column));
+	last_point_execute(command.data, 0, NULL, NULL, SPI_OK_UTILITY);
+	ts_catalog_restore_user(&sec_ctx);
+
+	CommandCounterIncrement();
+	relid = get_relname_relid(table_name, get_namespace_oid(INTERNAL_SCHEMA_NAME, false));
+	Ensure(OidIsValid(relid), "last point cache \"%s\" not created", table_name);
+
+	/* The cache has the owner and permissions of the hypertable */
+	ATExecChangeOwner(relid, owner, false, AccessExclusiveLock);
+	ts_copy_relation_acl(ht->main_table_relid, relid, owner);
+
+	/* ... and is dropped with it */
+	ObjectAddressSet(cache_addr, RelationRelationId, relid);
+	ObjectAddressSet(ht_addr, RelationRelationId, ht->main_table_relid);
+	recordDependencyOn(&cache_addr, &ht_addr, DEPENDENCY_AUTO);
+	CommandCounterIncrement();
+
+	return relid;
+}
+
+TS_FUNCTION_INFO_V1(ts_last_point_cache_enable);
+
+/*
+ * Enable the last point cache of a hypertable.
+ *
+ * hypertable - The hypertable
+ * key_column - The column with the keys, e.g., the device ids
+ * if_not_exists - Do not fail if the cache is enabled already
+ */
+Datum
+ts_last_point_cache_enable(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name key_column = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool if_not_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	const Dimension *dim;
+	Form_pg_attribute attr;
+	TypeCacheEntry *typentry;
+	Relation rel;
+	Hypertable *ht;
+	Cache *hcache;
+	AttrNumber attno;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("hypertable cannot be NULL")));
+
+	if (key_column == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("key column cannot be NULL")));
+
+	ts_hypertable_permissions_check(relid, GetUserId());
+
+	/*
+	 * Block the inserts while the cache is filled, since the statements that
+	 * started before would not update it, like CREATE INDEX.
+	 */
+	LockRelationOid(relid, ShareLock);
+	ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+
+	if (hypertable_is_distributed(ht) || TS_HYPERTABLE_IS_INTERNAL_COMPRESSION_TABLE(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("last point cache is not supported on hypertable \"%s\"",
+						get_rel_name(relid))));
+
+	if (OidIsValid(ht->last_point_relid))
+	{
+		ereport(if_not_exists ? NOTICE : ERROR,
+				(errcode(ERRCODE_DUPLICATE_OBJECT),
+				 errmsg("last point cache already enabled for hypertable \"%s\"%s",
+						get_rel_name(relid),
+						if_not_exists ? ", skipping" : "")));
+		ts_cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	attno = get_attnum(relid, NameStr(*key_column));
+
+	if (attno == InvalidAttrNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("column \"%s\" does not exist", NameStr(*key_column))));
+
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (attno == dim->column_attno)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot use the time column as the key of the last point cache")));
+
+	rel = table_open(relid, NoLock);
+	attr = TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(attno));
+
+	/* NULL keys would not be a single group in the cache */
+	if (!attr->attnotnull)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("key column \"%s\" must be NOT NULL", NameStr(*key_column))));
+
+	typentry = lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC | TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(typentry->hash_proc) || !OidIsValid(typentry->btree_opf))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),
+				 errmsg("cannot use column \"%s\" as the key of the last point cache",
+						NameStr(*key_column)),
+				 errdetail("The key type %s needs default btree and hash operator classes.",
+						   format_type_be(attr->atttypid))));
+
+	table_close(rel, NoLock);
+
+	ht->last_point_relid = last_point_cache_create(ht, NameStr(*key_column));
+	ts_last_point_cache_refresh(ht);
+	last_point_cache_invalidate();
+	ts_cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(ts_last_point_cache_disable);
+
+/*
+ * Disable the last point cache of a hypertable and drop the cache.
+ *
+ * hypertable - The hypertable
+ * if_exists - Do not fail if the cache is not enabled
+ */
+Datum
+ts_last_point_cache_disable(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	bool if_exists = PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1);
+	ObjectAddress cache_addr;
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("hypertable cannot be NULL")));
+
+	ts_hypertable_permissions_check(relid, GetUserId());
+	ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+
+	if (!OidIsValid(ht->last_point_relid))
+	{
+		ereport(if_exists ? NOTICE : ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("last point cache not enabled for hypertable \"%s\"%s",
+						get_rel_name(relid),
+						if_exists ? ", skipping" : "")));
+		ts_cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	ObjectAddressSet(cache_addr, RelationRelationId, ht->last_point_relid);
+	performDeletion(&cache_addr, DROP_RESTRICT, 0);
+	last_point_cache_invalidate();
+	ts_cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,27 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_LAST_POINT_H
+#define TIMESCALEDB_LAST_POINT_H
+
+#include <postgres.h>
+#include <executor/tuptable.h>
+#include <utils/relcache.h>
+
+#include "hypertable.h"
+
+typedef struct LastPointState LastPointState;
+
+extern Oid ts_last_point_cache_get_relid(int32 hypertable_id);
+extern AttrNumber ts_last_point_cache_get_key_attno(Oid cache_relid);
+extern void ts_last_point_cache_refresh(const Hypertable *ht);
+
+extern LastPointState *ts_last_point_state_create(const Hypertable *ht, MemoryContext mcxt);
+extern AttrNumber *ts_last_point_state_get_attmap(const LastPointState *state, Relation rel);
+extern void ts_last_point_state_store(LastPointState *state, TupleTableSlot *slot,
+									  const AttrNumber *attmap);
+extern void ts_last_point_state_flush(LastPointState *state);
+
+#endif /* TIMESCALEDB_LAST_POINT_H */
@@ -0,0 +1,112 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#include <postgres.h>
+
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "loader/bgw_job_stat_pending.h"
+
+/* Number of jobs whose statistics can be pending, 0 writes them right away */
+static int ts_guc_bgw_job_stat_pending_max_jobs = 0;
+
+static BgwJobStatPendingRendezvous rendezvous;
+
+void
+ts_bgw_job_stat_pending_setup_gucs(void)
+{
+	DefineCustomIntVariable("timescaledb.bgw_job_stat_pending_max_jobs",
+							"Number of jobs with pending statistics",
+							"Keep the statistics of successful job runs in shared memory and "
+							"write them to the job statistics table in batches, see "
+							"timescaledb.bgw_job_stat_flush_interval. The statistics of further "
+							"jobs are written right away. Set to 0 to write all statistics right "
+							"away",
+							&ts_guc_bgw_job_stat_pending_max_jobs,
+							0,
+							0,
+							PG_INT32_MAX / 2,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+}
+
+void
+ts_bgw_job_stat_pending_shmem_startup(void)
+{
+	BgwJobStatPendingRendezvous **rendezvous_ptr;
+	HASHCTL hash_info;
+	HTAB *jobs;
+	LWLock **lock;
+	bool found;
+
+	if (ts_guc_bgw_job_stat_pending_max_jobs == 0)
+		return;
+
+	hash_info.keysize = sizeof(BgwJobStatPendingKey);
+	hash_info.entrysize = sizeof(BgwJobStatPendingEntry);
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	/*
+	 * GetNamedLWLockTranche must only be run once on windows, see
+	 * ts_function_telemetry_shmem_startup.
+	 */
+	lock = ShmemInitStruct("ts_bgw_job_stat_pending_detect_first_run", sizeof(LWLock *), &found);
+	if (!found)
+		*lock = &(GetNamedLWLockTranche(BGW_JOB_STAT_PENDING_LWLOCK_TRANCHE_NAME))->lock;
+
+	jobs = ShmemInitHash("timescaledb pending job statistics",
+						 ts_guc_bgw_job_stat_pending_max_jobs,
+						 ts_guc_bgw_job_stat_pending_max_jobs,
+						 &hash_info,
+						 HASH_ELEM | HASH_BLOBS);
+	LWLockRelease(AddinShmemInitLock);
+
+	rendezvous.lock = *lock;
+	rendezvous.jobs = jobs;
+	rendezvous.max_entries = ts_guc_bgw_job_stat_pending_max_jobs;
+
+	rendezvous_ptr =
+		(BgwJobStatPendingRendezvous **) find_rendezvous_variable(RENDEZVOUS_BGW_JOB_STAT_PENDING);
+	*rendezvous_ptr = &rendezvous;
+}
+
+void
+ts_bgw_job_stat_pending_shmem_alloc(void)
+{
+	Size size;
+
+	if (ts_guc_bgw_job_stat_pending_max_jobs == 0)
+		return;
+
+	size = hash_estimate_size(ts_guc_bgw_job_stat_pending_max_jobs, sizeof(BgwJobStatPendingEntry));
+	RequestAddinShmemSpace(add_size(size, sizeof(LWLock *)));
+	RequestNamedLWLockTranche(BGW_JOB_STAT_PENDING_LWLOCK_TRANCHE_NAME, 1);
+}
+
+void
+ts_bgw_job_stat_pending_remove_database(Oid database_id)
+{
+	HASH_SEQ_STATUS status;
+	BgwJobStatPendingEntry *entry;
+
+	if (rendezvous.jobs == NULL)
+		return;
+
+	LWLockAcquire(rendezvous.lock, LW_EXCLUSIVE);
+	hash_seq_init(&status, rendezvous.jobs);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.database_id == database_id)
+			hash_search(rendezvous.jobs, &entry->key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(rendezvous.lock);
+}
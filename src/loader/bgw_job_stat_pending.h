@@ -0,0 +1,49 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_LOADER_BGW_JOB_STAT_PENDING_H
+#define TIMESCALEDB_LOADER_BGW_JOB_STAT_PENDING_H
+
+#include <postgres.h>
+#include <storage/lwlock.h>
+#include <utils/hsearch.h>
+
+#define RENDEZVOUS_BGW_JOB_STAT_PENDING "ts_bgw_job_stat_pending"
+#define BGW_JOB_STAT_PENDING_LWLOCK_TRANCHE_NAME "ts_bgw_job_stat_pending_lwlock_tranche"
+
+/*
+ * Room for the image of a row of _timescaledb_internal.bgw_job_stat. The
+ * loader does not interpret the image, the versioned extension checks that
+ * its row fits.
+ */
+#define BGW_JOB_STAT_PENDING_DATA_SIZE 256
+
+typedef struct BgwJobStatPendingRendezvous
+{
+	LWLock *lock;
+	HTAB *jobs;
+	int max_entries;
+} BgwJobStatPendingRendezvous;
+
+typedef struct BgwJobStatPendingKey
+{
+	Oid database_id;
+	int32 job_id;
+} BgwJobStatPendingKey;
+
+/* The statistics of a job that are not yet written to the catalog */
+typedef struct BgwJobStatPendingEntry
+{
+	BgwJobStatPendingKey key;
+	char data[BGW_JOB_STAT_PENDING_DATA_SIZE];
+} BgwJobStatPendingEntry;
+
+extern void ts_bgw_job_stat_pending_setup_gucs(void);
+extern void ts_bgw_job_stat_pending_shmem_alloc(void);
+extern void ts_bgw_job_stat_pending_shmem_startup(void);
+extern void ts_bgw_job_stat_pending_remove_database(Oid database_id);
+
+#endif /* TIMESCALEDB_LOADER_BGW_JOB_STAT_PENDING_H */
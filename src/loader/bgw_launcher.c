@@ -18,6 +18,9 @@
 /* for setting our wait event during waitlatch*/
 #include <pgstat.h>
 
+/* for the wakeup times of the schedulers */
+#include <utils/timestamp.h>
+
 /* needed for getting database list*/
 #include <access/heapam.h>
 #include <access/htup_details.h>
@@ -49,6 +52,7 @@
 #include "bgw_counter.h"
 #include "bgw_message_queue.h"
 #include "bgw_launcher.h"
+#include "bgw_scheduler_wakeup.h"
 
 #define BGW_DB_SCHEDULER_FUNCNAME "ts_bgw_scheduler_main"
 #define BGW_ENTRYPOINT_FUNCNAME "ts_bgw_db_scheduler_entrypoint"
@@ -69,6 +73,12 @@ typedef enum SchedulerState
 	/* Scheduler has been started */
 	STARTED,
 
+	/*
+	 * Scheduler exited because no job was due and is started again at its
+	 * wakeup time, see bgw_scheduler_wakeup.h
+	 */
+	SLEEPING,
+
 	/*
 	 * Scheduler is stopped and should not be started automatically. START and
 	 * RESTART messages can re-enable the scheduler.
@@ -121,6 +131,8 @@ typedef struct DbHashEntry
 	SchedulerState state;
 	VirtualTransactionId vxid;
 	int state_transition_failures;
+	TimestampTz wakeup; /* when a SLEEPING scheduler is started again */
+	bool idle_exit;		/* the STARTED scheduler exits because no job is due */
 } DbHashEntry;
 
 static void scheduler_state_trans_enabled_to_allocated(DbHashEntry *entry);
@@ -318,6 +330,8 @@ db_hash_entry_create_if_not_exists(HTAB *db_htab, Oid db_oid)
 		db_he->state = ENABLED;
 		SetInvalidVirtualTransactionId(db_he->vxid);
 		db_he->state_transition_failures = 0;
+		db_he->wakeup = DT_NOEND;
+		db_he->idle_exit = false;
 
 		/*
 		 * Try to allocate a spot right away to give schedulers priority over
@@ -437,6 +451,8 @@ scheduler_state_trans_allocated_to_started(DbHashEntry *entry)
 	}
 	wait_for_background_worker_startup(entry->db_scheduler_handle, &worker_pid);
 	SetInvalidVirtualTransactionId(entry->vxid);
+	entry->wakeup = DT_NOEND;
+	entry->idle_exit = false;
 	scheduler_modify_state(entry, STARTED);
 }
 
@@ -473,6 +489,41 @@ scheduler_state_trans_started_to_disabled(DbHashEntry *entry)
 	scheduler_modify_state(entry, DISABLED);
 }
 
+static void
+scheduler_state_trans_started_to_sleeping(DbHashEntry *entry)
+{
+	Assert(entry->state == STARTED);
+	Assert(get_background_worker_pid(entry->db_scheduler_handle, NULL) == BGWH_STOPPED);
+
+	/* Release the slot, so that other schedulers and jobs can use it */
+	ts_bgw_total_workers_decrement();
+	if (entry->db_scheduler_handle != NULL)
+	{
+		pfree(entry->db_scheduler_handle);
+		entry->db_scheduler_handle = NULL;
+	}
+	entry->idle_exit = false;
+	scheduler_modify_state(entry, SLEEPING);
+}
+
+static void
+scheduler_state_trans_sleeping_to_enabled(DbHashEntry *entry)
+{
+	Assert(entry->state == SLEEPING);
+	Assert(entry->db_scheduler_handle == NULL);
+	entry->wakeup = DT_NOEND;
+	scheduler_modify_state(entry, ENABLED);
+}
+
+static void
+scheduler_state_trans_sleeping_to_disabled(DbHashEntry *entry)
+{
+	Assert(entry->state == SLEEPING);
+	Assert(entry->db_scheduler_handle == NULL);
+	entry->wakeup = DT_NOEND;
+	scheduler_modify_state(entry, DISABLED);
+}
+
 static void
 scheduler_state_trans_automatic(DbHashEntry *entry)
 {
@@ -487,9 +538,21 @@ scheduler_state_trans_automatic(DbHashEntry *entry)
 			scheduler_state_trans_allocated_to_started(entry);
 			break;
 		case STARTED:
-			if (get_background_worker_pid(entry->db_scheduler_handle, NULL) == BGWH_STOPPED)
+			if (get_background_worker_pid(entry->db_scheduler_handle, NULL) != BGWH_STOPPED)
+				break;
+			if (entry->idle_exit)
+				scheduler_state_trans_started_to_sleeping(entry);
+			else
 				scheduler_state_trans_started_to_disabled(entry);
 			break;
+		case SLEEPING:
+			if (entry->wakeup > GetCurrentTimestamp())
+				break;
+			scheduler_state_trans_sleeping_to_enabled(entry);
+			scheduler_state_trans_enabled_to_allocated(entry);
+			if (entry->state == ALLOCATED)
+				scheduler_state_trans_allocated_to_started(entry);
+			break;
 		case DISABLED:
 			break;
 	}
@@ -535,6 +598,8 @@ launcher_pre_shmem_cleanup(int code, Datum arg)
 		hash_destroy(db_htab);
 	}
 
+	ts_bgw_scheduler_wakeup_set_launcher(NULL);
+
 	/*
 	 * Reset our pid in the queue so that others know we've died and don't
 	 * wait forever
@@ -566,6 +631,8 @@ message_start_action(HTAB *db_htab, BgwMessage *message)
 
 	if (entry->state == DISABLED)
 		scheduler_state_trans_disabled_to_enabled(entry);
+	else if (entry->state == SLEEPING)
+		scheduler_state_trans_sleeping_to_enabled(entry);
 
 	scheduler_state_trans_automatic(entry);
 
@@ -598,6 +665,9 @@ message_stop_action(HTAB *db_htab, BgwMessage *message)
 			wait_for_background_worker_shutdown(entry->db_scheduler_handle);
 			scheduler_state_trans_started_to_disabled(entry);
 			break;
+		case SLEEPING:
+			scheduler_state_trans_sleeping_to_disabled(entry);
+			break;
 		case DISABLED:
 			break;
 	}
@@ -637,6 +707,9 @@ message_restart_action(HTAB *db_htab, BgwMessage *message, VirtualTransactionId
 			wait_for_background_worker_shutdown(entry->db_scheduler_handle);
 			scheduler_state_trans_started_to_allocated(entry);
 			break;
+		case SLEEPING:
+			scheduler_state_trans_sleeping_to_enabled(entry);
+			break;
 		case DISABLED:
 			scheduler_state_trans_disabled_to_enabled(entry);
 	}
@@ -687,6 +760,77 @@ launcher_handle_message(HTAB *db_htab)
 	return true;
 }
 
+/*
+ * Apply the requests of the schedulers that exit because no job is due and of
+ * the backends that changed the jobs of a database, see
+ * bgw_scheduler_wakeup.h.
+ */
+static void
+launcher_handle_wakeup_requests(HTAB *db_htab, BgwSchedulerWakeup *requests)
+{
+	bool overflow;
+	int num_requests = ts_bgw_scheduler_wakeup_consume(requests, &overflow);
+
+	for (int i = 0; i < num_requests; i++)
+	{
+		DbHashEntry *entry = hash_search(db_htab, &requests[i].db_oid, HASH_FIND, NULL);
+
+		/* A new database gets its scheduler started anyway */
+		if (entry == NULL)
+			continue;
+
+		if (requests[i].idle_exit && entry->state == STARTED)
+			entry->idle_exit = true;
+
+		/*
+		 * The jobs can change while the scheduler exits, so the wakeup times
+		 * are also collected for a STARTED scheduler
+		 */
+		entry->wakeup = Min(entry->wakeup, requests[i].wakeup);
+	}
+
+	if (overflow)
+	{
+		HASH_SEQ_STATUS hash_seq;
+		DbHashEntry *entry;
+		TimestampTz now = GetCurrentTimestamp();
+
+		hash_seq_init(&hash_seq, db_htab);
+		while ((entry = hash_seq_search(&hash_seq)) != NULL)
+			entry->wakeup = Min(entry->wakeup, now);
+	}
+}
+
+/*
+ * Wait for the poll time, or until the first SLEEPING scheduler is due.
+ */
+static long
+launcher_wait_time(HTAB *db_htab)
+{
+	long wait_time = ts_guc_bgw_launcher_poll_time;
+	TimestampTz earliest = DT_NOEND;
+	HASH_SEQ_STATUS hash_seq;
+	DbHashEntry *entry;
+	long secs;
+	int usecs;
+
+	hash_seq_init(&hash_seq, db_htab);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		if (entry->state == SLEEPING)
+			earliest = Min(earliest, entry->wakeup);
+	}
+
+	if (earliest == DT_NOEND)
+		return wait_time;
+
+	TimestampDifference(GetCurrentTimestamp(), earliest, &secs, &usecs);
+	if (secs < wait_time / 1000)
+		wait_time = Min(wait_time, secs * 1000 + (usecs + 999) / 1000);
+
+	return wait_time;
+}
+
 /*
  * The default, `bgworker_die()`, can't be used due to the fact that it
  * handles signals synchronously, rather than waiting for a
@@ -709,6 +853,7 @@ ts_bgw_cluster_launcher_main(PG_FUNCTION_ARGS)
 	HTAB **htab_storage;
 
 	HTAB *db_htab;
+	BgwSchedulerWakeup *wakeup_requests = NULL;
 
 	pqsignal(SIGINT, StatementCancelHandler);
 	pqsignal(SIGTERM, die);
@@ -753,6 +898,13 @@ ts_bgw_cluster_launcher_main(PG_FUNCTION_ARGS)
 	before_shmem_exit(launcher_pre_shmem_cleanup, PointerGetDatum(htab_storage));
 
 	ts_bgw_message_queue_set_reader();
+	if (ts_bgw_scheduler_wakeup_enabled())
+	{
+		wakeup_requests = MemoryContextAlloc(TopMemoryContext,
+											 sizeof(BgwSchedulerWakeup) *
+												 ts_guc_max_background_workers);
+		ts_bgw_scheduler_wakeup_set_launcher(MyLatch);
+	}
 
 	db_htab = init_database_htab();
 	*htab_storage = db_htab;
@@ -767,13 +919,15 @@ ts_bgw_cluster_launcher_main(PG_FUNCTION_ARGS)
 		CHECK_FOR_INTERRUPTS();
 		populate_database_htab(db_htab);
 		handled_msgs = launcher_handle_message(db_htab);
+		if (wakeup_requests != NULL)
+			launcher_handle_wakeup_requests(db_htab, wakeup_requests);
 		scheduler_state_trans_automatic_all(db_htab);
 		if (handled_msgs)
 			continue;
 
 		wl_rc = WaitLatch(MyLatch,
 						  WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_TIMEOUT,
-						  (long) ts_guc_bgw_launcher_poll_time,
+						  launcher_wait_time(db_htab),
 						  PG_WAIT_EXTENSION);
 		ResetLatch(MyLatch);
 		if (wl_rc & WL_POSTMASTER_DEATH)
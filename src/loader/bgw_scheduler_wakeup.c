@@ -0,0 +1,129 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#include <postgres.h>
+
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "loader/bgw_counter.h"
+#include "loader/bgw_scheduler_wakeup.h"
+
+/* Time in ms without due jobs after which a scheduler exits, 0 keeps them running */
+static int ts_guc_bgw_scheduler_idle_exit_time = 0;
+
+static BgwSchedulerWakeupRendezvous rendezvous;
+
+void
+ts_bgw_scheduler_wakeup_setup_gucs(void)
+{
+	DefineCustomIntVariable("timescaledb.bgw_scheduler_idle_exit_time",
+							"Time without due jobs after which a database scheduler exits",
+							"Let the scheduler of a database exit when no job is running and no "
+							"job is due within this time. The launcher starts it again when the "
+							"next job is due or the jobs change, so that idle databases don't "
+							"occupy background workers. Set to 0 to keep the schedulers running",
+							&ts_guc_bgw_scheduler_idle_exit_time,
+							0,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+}
+
+static Size
+bgw_scheduler_wakeup_queue_size(void)
+{
+	return add_size(offsetof(BgwSchedulerWakeupQueue, requests),
+					mul_size(ts_guc_max_background_workers, sizeof(BgwSchedulerWakeup)));
+}
+
+void
+ts_bgw_scheduler_wakeup_shmem_startup(void)
+{
+	BgwSchedulerWakeupRendezvous **rendezvous_ptr;
+	BgwSchedulerWakeupQueue *queue;
+	bool found;
+
+	if (ts_guc_bgw_scheduler_idle_exit_time == 0 || ts_guc_max_background_workers == 0)
+		return;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+	queue = ShmemInitStruct("ts_bgw_scheduler_wakeup", bgw_scheduler_wakeup_queue_size(), &found);
+	if (!found)
+	{
+		memset(queue, 0, bgw_scheduler_wakeup_queue_size());
+		SpinLockInit(&queue->mutex);
+	}
+	LWLockRelease(AddinShmemInitLock);
+
+	rendezvous.queue = queue;
+	rendezvous.max_requests = ts_guc_max_background_workers;
+	rendezvous.idle_exit_time_ms = ts_guc_bgw_scheduler_idle_exit_time;
+
+	rendezvous_ptr =
+		(BgwSchedulerWakeupRendezvous **) find_rendezvous_variable(RENDEZVOUS_BGW_SCHEDULER_WAKEUP);
+	*rendezvous_ptr = &rendezvous;
+}
+
+void
+ts_bgw_scheduler_wakeup_shmem_alloc(void)
+{
+	if (ts_guc_bgw_scheduler_idle_exit_time == 0 || ts_guc_max_background_workers == 0)
+		return;
+
+	RequestAddinShmemSpace(bgw_scheduler_wakeup_queue_size());
+}
+
+bool
+ts_bgw_scheduler_wakeup_enabled(void)
+{
+	return rendezvous.queue != NULL;
+}
+
+/*
+ * Register the latch of the launcher, which is set on every new request.
+ */
+void
+ts_bgw_scheduler_wakeup_set_launcher(Latch *latch)
+{
+	if (rendezvous.queue == NULL)
+		return;
+
+	SpinLockAcquire(&rendezvous.queue->mutex);
+	rendezvous.queue->launcher_latch = latch;
+	SpinLockRelease(&rendezvous.queue->mutex);
+}
+
+/*
+ * Move the queued requests to the given array, which has room for
+ * timescaledb.max_background_workers requests, and return their number.
+ * Overflow is set when some requests to start a scheduler were lost.
+ */
+int
+ts_bgw_scheduler_wakeup_consume(BgwSchedulerWakeup *requests, bool *overflow)
+{
+	int num_requests;
+
+	*overflow = false;
+
+	if (rendezvous.queue == NULL)
+		return 0;
+
+	SpinLockAcquire(&rendezvous.queue->mutex);
+	num_requests = rendezvous.queue->num_requests;
+	memcpy(requests, rendezvous.queue->requests, sizeof(BgwSchedulerWakeup) * num_requests);
+	*overflow = rendezvous.queue->overflow;
+	rendezvous.queue->num_requests = 0;
+	rendezvous.queue->overflow = false;
+	SpinLockRelease(&rendezvous.queue->mutex);
+
+	return num_requests;
+}
@@ -0,0 +1,61 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_LOADER_BGW_SCHEDULER_WAKEUP_H
+#define TIMESCALEDB_LOADER_BGW_SCHEDULER_WAKEUP_H
+
+#include <postgres.h>
+#include <datatype/timestamp.h>
+#include <storage/latch.h>
+#include <storage/spin.h>
+
+#define RENDEZVOUS_BGW_SCHEDULER_WAKEUP "ts_bgw_scheduler_wakeup"
+
+/*
+ * With timescaledb.bgw_scheduler_idle_exit_time, the scheduler of a database
+ * exits when no job is running and no job is due within that time, so that
+ * the databases without due jobs don't occupy background workers. Before it
+ * exits, the scheduler records when its next job is due and the launcher
+ * starts it again at that time. When the jobs of a database change, the
+ * committing backend asks the launcher to start the scheduler right away, so
+ * that it picks up the new schedule.
+ *
+ * The requests are queued here until the launcher consumes them. A scheduler
+ * that finds the queue full keeps running, and if a request to start a
+ * scheduler doesn't fit, the launcher starts all the exited schedulers.
+ */
+typedef struct BgwSchedulerWakeup
+{
+	Oid db_oid;
+	TimestampTz wakeup;
+	/* the scheduler exits, otherwise a backend asks to start it */
+	bool idle_exit;
+} BgwSchedulerWakeup;
+
+typedef struct BgwSchedulerWakeupQueue
+{
+	slock_t mutex;
+	Latch *launcher_latch;
+	bool overflow;
+	int num_requests;
+	BgwSchedulerWakeup requests[FLEXIBLE_ARRAY_MEMBER];
+} BgwSchedulerWakeupQueue;
+
+typedef struct BgwSchedulerWakeupRendezvous
+{
+	BgwSchedulerWakeupQueue *queue;
+	int max_requests;
+	int idle_exit_time_ms;
+} BgwSchedulerWakeupRendezvous;
+
+extern void ts_bgw_scheduler_wakeup_setup_gucs(void);
+extern void ts_bgw_scheduler_wakeup_shmem_alloc(void);
+extern void ts_bgw_scheduler_wakeup_shmem_startup(void);
+extern bool ts_bgw_scheduler_wakeup_enabled(void);
+extern void ts_bgw_scheduler_wakeup_set_launcher(Latch *latch);
+extern int ts_bgw_scheduler_wakeup_consume(BgwSchedulerWakeup *requests, bool *overflow);
+
+#endif /* TIMESCALEDB_LOADER_BGW_SCHEDULER_WAKEUP_H */
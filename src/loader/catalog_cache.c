@@ -0,0 +1,101 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#include <postgres.h>
+
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "loader/catalog_cache.h"
+
+/* Number of databases in the shared catalog cache, 0 disables the cache */
+static int ts_guc_shared_catalog_cache_size = 0;
+
+static CatalogCacheRendezvous rendezvous;
+
+void
+ts_catalog_cache_setup_gucs(void)
+{
+	DefineCustomIntVariable("timescaledb.shared_catalog_cache_size",
+							"Number of databases whose catalog OIDs are cached in shared memory",
+							"Cache the OIDs of the catalog tables, indexes and functions in "
+							"shared memory, so that new backends don't have to look them up "
+							"before their first query. Set to 0 to disable the cache",
+							&ts_guc_shared_catalog_cache_size,
+							0,
+							0,
+							10000,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+}
+
+void
+ts_catalog_cache_shmem_startup(void)
+{
+	CatalogCacheRendezvous **rendezvous_ptr;
+	HASHCTL hash_info;
+	HTAB *databases;
+	LWLock **lock;
+	bool found;
+
+	if (ts_guc_shared_catalog_cache_size == 0)
+		return;
+
+	hash_info.keysize = sizeof(Oid);
+	hash_info.entrysize = sizeof(CatalogCacheEntry);
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	/*
+	 * GetNamedLWLockTranche must only be run once on windows, see
+	 * ts_function_telemetry_shmem_startup.
+	 */
+	lock = ShmemInitStruct("ts_catalog_cache_detect_first_run", sizeof(LWLock *), &found);
+	if (!found)
+		*lock = &(GetNamedLWLockTranche(CATALOG_CACHE_LWLOCK_TRANCHE_NAME))->lock;
+
+	databases = ShmemInitHash("timescaledb catalog cache",
+							  ts_guc_shared_catalog_cache_size,
+							  ts_guc_shared_catalog_cache_size,
+							  &hash_info,
+							  HASH_ELEM | HASH_BLOBS);
+	LWLockRelease(AddinShmemInitLock);
+
+	rendezvous.lock = *lock;
+	rendezvous.databases = databases;
+	rendezvous.max_entries = ts_guc_shared_catalog_cache_size;
+
+	rendezvous_ptr = (CatalogCacheRendezvous **) find_rendezvous_variable(RENDEZVOUS_CATALOG_CACHE);
+	*rendezvous_ptr = &rendezvous;
+}
+
+void
+ts_catalog_cache_shmem_alloc(void)
+{
+	Size size;
+
+	if (ts_guc_shared_catalog_cache_size == 0)
+		return;
+
+	size = hash_estimate_size(ts_guc_shared_catalog_cache_size, sizeof(CatalogCacheEntry));
+	RequestAddinShmemSpace(add_size(size, sizeof(LWLock *)));
+	RequestNamedLWLockTranche(CATALOG_CACHE_LWLOCK_TRANCHE_NAME, 1);
+}
+
+void
+ts_catalog_cache_remove_database(Oid database_id)
+{
+	if (rendezvous.databases == NULL)
+		return;
+
+	LWLockAcquire(rendezvous.lock, LW_EXCLUSIVE);
+	hash_search(rendezvous.databases, &database_id, HASH_REMOVE, NULL);
+	LWLockRelease(rendezvous.lock);
+}
@@ -0,0 +1,51 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_LOADER_CATALOG_CACHE_H
+#define TIMESCALEDB_LOADER_CATALOG_CACHE_H
+
+#include <postgres.h>
+#include <storage/lwlock.h>
+#include <utils/hsearch.h>
+
+#define RENDEZVOUS_CATALOG_CACHE "ts_catalog_cache"
+#define CATALOG_CACHE_LWLOCK_TRANCHE_NAME "ts_catalog_cache_lwlock_tranche"
+
+/* Room for the catalog OIDs of any extension version */
+#define CATALOG_CACHE_MAX_OIDS 512
+
+/*
+ * The OIDs of the catalog tables, indexes, sequences and functions of the
+ * extension in every database, so that new backends don't have to look them
+ * up one by one. The OIDs only change when the extension is created or
+ * updated, which changes the extension's row in pg_extension, so an entry is
+ * valid as long as the extension OID and the xmin of that row match.
+ *
+ * The loader only reserves the space; the OIDs are stored and interpreted by
+ * the versioned extension, which checks the number of OIDs as well.
+ */
+typedef struct CatalogCacheRendezvous
+{
+	LWLock *lock;
+	HTAB *databases;
+	int max_entries;
+} CatalogCacheRendezvous;
+
+typedef struct CatalogCacheEntry
+{
+	Oid database_id; /* hash key */
+	Oid extension_id;
+	TransactionId extension_xmin;
+	int num_oids;
+	Oid oids[CATALOG_CACHE_MAX_OIDS];
+} CatalogCacheEntry;
+
+extern void ts_catalog_cache_setup_gucs(void);
+extern void ts_catalog_cache_shmem_alloc(void);
+extern void ts_catalog_cache_shmem_startup(void);
+extern void ts_catalog_cache_remove_database(Oid database_id);
+
+#endif /* TIMESCALEDB_LOADER_CATALOG_CACHE_H */
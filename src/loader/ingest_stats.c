@@ -0,0 +1,110 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#include <postgres.h>
+
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "loader/ingest_stats.h"
+
+/* Number of hypertables with ingest statistics, 0 disables the statistics */
+static int ts_guc_ingest_stats_max_hypertables = 0;
+
+static IngestStatsRendezvous rendezvous;
+
+void
+ts_ingest_stats_setup_gucs(void)
+{
+	DefineCustomIntVariable("timescaledb.ingest_stats_max_hypertables",
+							"Number of hypertables with ingest statistics",
+							"Collect the statistics of the inserts into hypertables in shared "
+							"memory, see timescaledb_information.hypertable_ingest_stats. The "
+							"inserts into further hypertables are not counted. Set to 0 to "
+							"disable the statistics",
+							&ts_guc_ingest_stats_max_hypertables,
+							0,
+							0,
+							PG_INT32_MAX / 2,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+}
+
+void
+ts_ingest_stats_shmem_startup(void)
+{
+	IngestStatsRendezvous **rendezvous_ptr;
+	HASHCTL hash_info;
+	HTAB *hypertables;
+	LWLock **lock;
+	bool found;
+
+	if (ts_guc_ingest_stats_max_hypertables == 0)
+		return;
+
+	hash_info.keysize = sizeof(IngestStatsKey);
+	hash_info.entrysize = sizeof(IngestStatsEntry);
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	/*
+	 * GetNamedLWLockTranche must only be run once on windows, see
+	 * ts_function_telemetry_shmem_startup.
+	 */
+	lock = ShmemInitStruct("ts_ingest_stats_detect_first_run", sizeof(LWLock *), &found);
+	if (!found)
+		*lock = &(GetNamedLWLockTranche(INGEST_STATS_LWLOCK_TRANCHE_NAME))->lock;
+
+	hypertables = ShmemInitHash("timescaledb ingest statistics",
+								ts_guc_ingest_stats_max_hypertables,
+								ts_guc_ingest_stats_max_hypertables,
+								&hash_info,
+								HASH_ELEM | HASH_BLOBS);
+	LWLockRelease(AddinShmemInitLock);
+
+	rendezvous.lock = *lock;
+	rendezvous.hypertables = hypertables;
+	rendezvous.max_entries = ts_guc_ingest_stats_max_hypertables;
+
+	rendezvous_ptr = (IngestStatsRendezvous **) find_rendezvous_variable(RENDEZVOUS_INGEST_STATS);
+	*rendezvous_ptr = &rendezvous;
+}
+
+void
+ts_ingest_stats_shmem_alloc(void)
+{
+	Size size;
+
+	if (ts_guc_ingest_stats_max_hypertables == 0)
+		return;
+
+	size = hash_estimate_size(ts_guc_ingest_stats_max_hypertables, sizeof(IngestStatsEntry));
+	RequestAddinShmemSpace(add_size(size, sizeof(LWLock *)));
+	RequestNamedLWLockTranche(INGEST_STATS_LWLOCK_TRANCHE_NAME, 1);
+}
+
+void
+ts_ingest_stats_remove_database(Oid database_id)
+{
+	HASH_SEQ_STATUS status;
+	IngestStatsEntry *entry;
+
+	if (rendezvous.hypertables == NULL)
+		return;
+
+	LWLockAcquire(rendezvous.lock, LW_EXCLUSIVE);
+	hash_seq_init(&status, rendezvous.hypertables);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.database_id == database_id)
+			hash_search(rendezvous.hypertables, &entry->key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(rendezvous.lock);
+}
@@ -0,0 +1,66 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_LOADER_INGEST_STATS_H
+#define TIMESCALEDB_LOADER_INGEST_STATS_H
+
+#include <postgres.h>
+#include <storage/lwlock.h>
+#include <utils/hsearch.h>
+
+#define RENDEZVOUS_INGEST_STATS "ts_ingest_stats"
+#define INGEST_STATS_LWLOCK_TRANCHE_NAME "ts_ingest_stats_lwlock_tranche"
+
+/* The reasons for flushing the COPY multi-insert buffers, see copy.c */
+#define INGEST_STATS_COPY_FLUSH_REASONS 6
+
+/*
+ * The counters of the inserts into a hypertable. A backend counts the
+ * inserts of a statement locally and adds them to the shared counters when
+ * the statement is finished.
+ */
+typedef struct IngestStatsCounters
+{
+	int64 statements;
+	int64 rows;
+	int64 insert_time_us;
+	/* chunk insert states cached per statement, see max_open_chunks_per_insert */
+	int64 insert_state_hits;
+	int64 insert_state_misses;
+	int64 insert_state_evictions;
+	/* chunks cached per hypertable, see max_cached_chunks_per_hypertable */
+	int64 chunk_cache_hits;
+	int64 chunk_cache_misses;
+	int64 chunks_created;
+	int64 chunk_create_time_us;
+	int64 copy_flushes[INGEST_STATS_COPY_FLUSH_REASONS];
+} IngestStatsCounters;
+
+typedef struct IngestStatsRendezvous
+{
+	LWLock *lock;
+	HTAB *hypertables;
+	int max_entries;
+} IngestStatsRendezvous;
+
+typedef struct IngestStatsKey
+{
+	Oid database_id;
+	int32 hypertable_id;
+} IngestStatsKey;
+
+typedef struct IngestStatsEntry
+{
+	IngestStatsKey key;
+	IngestStatsCounters counters;
+} IngestStatsEntry;
+
+extern void ts_ingest_stats_setup_gucs(void);
+extern void ts_ingest_stats_shmem_alloc(void);
+extern void ts_ingest_stats_shmem_startup(void);
+extern void ts_ingest_stats_remove_database(Oid database_id);
+
+#endif /* TIMESCALEDB_LOADER_INGEST_STATS_H */
@@ -35,8 +35,13 @@
 #include "loader/bgw_interface.h"
 #include "loader/bgw_launcher.h"
 #include "loader/bgw_message_queue.h"
+#include "loader/bgw_job_stat_pending.h"
+#include "loader/bgw_scheduler_wakeup.h"
 #include "loader/lwlocks.h"
 #include "loader/seclabel.h"
+#include "loader/catalog_cache.h"
+#include "loader/ingest_stats.h"
+#include "loader/slice_cache.h"
 
 /*
  * Loading process:
@@ -543,6 +548,7 @@ loader_process_utility_hook(PlannedStmt *pstmt, const char *query_string,
 {
 	bool is_distributed_database = false;
 	char *dist_uuid = NULL;
+	Oid dropped_database_oid = InvalidOid;
 	ProcessUtility_hook_type process_utility;
 
 	/* Check if we are dropping a distributed database and get its uuid */
@@ -555,6 +561,7 @@ loader_process_utility_hook(PlannedStmt *pstmt, const char *query_string,
 
 			if (OidIsValid(dboid))
 				is_distributed_database = ts_seclabel_get_dist_uuid(dboid, &dist_uuid);
+			dropped_database_oid = dboid;
 			break;
 		}
 		case T_SecLabelStmt:
@@ -591,6 +598,15 @@ loader_process_utility_hook(PlannedStmt *pstmt, const char *query_string,
 					dest,
 					completion_tag);
 
+	/* The cached slices, statistics and catalog OIDs of a dropped database are never used again */
+	if (OidIsValid(dropped_database_oid))
+	{
+		ts_slice_cache_remove_database(dropped_database_oid);
+		ts_ingest_stats_remove_database(dropped_database_oid);
+		ts_catalog_cache_remove_database(dropped_database_oid);
+		ts_bgw_job_stat_pending_remove_database(dropped_database_oid);
+	}
+
 	/*
 	 * Show a NOTICE warning message in case of dropping a
 	 * distributed database
@@ -611,6 +627,11 @@ timescaledb_shmem_startup_hook(void)
 	ts_bgw_message_queue_shmem_startup();
 	ts_lwlocks_shmem_startup();
 	ts_function_telemetry_shmem_startup();
+	ts_slice_cache_shmem_startup();
+	ts_ingest_stats_shmem_startup();
+	ts_catalog_cache_shmem_startup();
+	ts_bgw_scheduler_wakeup_shmem_startup();
+	ts_bgw_job_stat_pending_shmem_startup();
 }
 
 /*
@@ -630,6 +651,11 @@ timescaledb_shmem_request_hook(void)
 	ts_bgw_message_queue_alloc();
 	ts_lwlocks_shmem_alloc();
 	ts_function_telemetry_shmem_alloc();
+	ts_slice_cache_shmem_alloc();
+	ts_ingest_stats_shmem_alloc();
+	ts_catalog_cache_shmem_alloc();
+	ts_bgw_scheduler_wakeup_shmem_alloc();
+	ts_bgw_job_stat_pending_shmem_alloc();
 }
 
 static void
@@ -651,12 +677,19 @@ _PG_init(void)
 
 	elog(INFO, "timescaledb loaded");
 
+	/* The sizes of the shared structures are needed for the shared memory request */
+	ts_slice_cache_setup_gucs();
+	ts_ingest_stats_setup_gucs();
+	ts_catalog_cache_setup_gucs();
+	ts_bgw_counter_setup_gucs();
+	ts_bgw_scheduler_wakeup_setup_gucs();
+	ts_bgw_job_stat_pending_setup_gucs();
+
 #if PG15_LT
 	timescaledb_shmem_request_hook();
 #endif
 
 	ts_bgw_cluster_launcher_register();
-	ts_bgw_counter_setup_gucs();
 	ts_bgw_interface_register_api_version();
 	ts_seclabel_init();
 
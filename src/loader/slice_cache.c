@@ -0,0 +1,109 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#include <postgres.h>
+
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "loader/slice_cache.h"
+
+/* Number of slices in the shared cache, 0 disables the cache */
+static int ts_guc_shared_slice_cache_size = 0;
+
+static SliceCacheRendezvous rendezvous;
+
+void
+ts_slice_cache_setup_gucs(void)
+{
+	DefineCustomIntVariable("timescaledb.shared_slice_cache_size",
+							"Number of dimension slices cached in shared memory",
+							"Cache the dimension slices of the chunks in shared memory, so that "
+							"new backends can build the hypercubes of the chunks without "
+							"scanning the catalog. Set to 0 to disable the cache",
+							&ts_guc_shared_slice_cache_size,
+							0,
+							0,
+							PG_INT32_MAX / 2,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+}
+
+void
+ts_slice_cache_shmem_startup(void)
+{
+	SliceCacheRendezvous **rendezvous_ptr;
+	HASHCTL hash_info;
+	HTAB *slices;
+	LWLock **lock;
+	bool found;
+
+	if (ts_guc_shared_slice_cache_size == 0)
+		return;
+
+	hash_info.keysize = sizeof(SliceCacheKey);
+	hash_info.entrysize = sizeof(SliceCacheEntry);
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	/*
+	 * GetNamedLWLockTranche must only be run once on windows, see
+	 * ts_function_telemetry_shmem_startup.
+	 */
+	lock = ShmemInitStruct("ts_slice_cache_detect_first_run", sizeof(LWLock *), &found);
+	if (!found)
+		*lock = &(GetNamedLWLockTranche(SLICE_CACHE_LWLOCK_TRANCHE_NAME))->lock;
+
+	slices = ShmemInitHash("timescaledb dimension slice cache",
+						   ts_guc_shared_slice_cache_size,
+						   ts_guc_shared_slice_cache_size,
+						   &hash_info,
+						   HASH_ELEM | HASH_BLOBS);
+	LWLockRelease(AddinShmemInitLock);
+
+	rendezvous.lock = *lock;
+	rendezvous.slices = slices;
+	rendezvous.max_entries = ts_guc_shared_slice_cache_size;
+
+	rendezvous_ptr = (SliceCacheRendezvous **) find_rendezvous_variable(RENDEZVOUS_SLICE_CACHE);
+	*rendezvous_ptr = &rendezvous;
+}
+
+void
+ts_slice_cache_shmem_alloc(void)
+{
+	Size size;
+
+	if (ts_guc_shared_slice_cache_size == 0)
+		return;
+
+	size = hash_estimate_size(ts_guc_shared_slice_cache_size, sizeof(SliceCacheEntry));
+	RequestAddinShmemSpace(add_size(size, sizeof(LWLock *)));
+	RequestNamedLWLockTranche(SLICE_CACHE_LWLOCK_TRANCHE_NAME, 1);
+}
+
+void
+ts_slice_cache_remove_database(Oid database_id)
+{
+	HASH_SEQ_STATUS status;
+	SliceCacheEntry *entry;
+
+	if (rendezvous.slices == NULL)
+		return;
+
+	LWLockAcquire(rendezvous.lock, LW_EXCLUSIVE);
+	hash_seq_init(&status, rendezvous.slices);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.database_id == database_id)
+			hash_search(rendezvous.slices, &entry->key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(rendezvous.lock);
+}
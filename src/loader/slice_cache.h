@@ -0,0 +1,52 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_LOADER_SLICE_CACHE_H
+#define TIMESCALEDB_LOADER_SLICE_CACHE_H
+
+#include <postgres.h>
+#include <storage/lwlock.h>
+#include <utils/hsearch.h>
+
+#define RENDEZVOUS_SLICE_CACHE "ts_slice_cache"
+#define SLICE_CACHE_LWLOCK_TRANCHE_NAME "ts_slice_cache_lwlock_tranche"
+
+/*
+ * The dimension slices shared by all backends. Slices are never updated, so
+ * an entry stays valid until the slice is deleted. The ids start over when
+ * the extension is dropped and created again, which changes the extension's
+ * row in pg_extension, so an entry is only valid as long as the extension
+ * OID and the xmin of that row match, like in the shared catalog cache.
+ */
+typedef struct SliceCacheRendezvous
+{
+	LWLock *lock;
+	HTAB *slices;
+	int max_entries;
+} SliceCacheRendezvous;
+
+typedef struct SliceCacheKey
+{
+	Oid database_id;
+	int32 slice_id;
+} SliceCacheKey;
+
+typedef struct SliceCacheEntry
+{
+	SliceCacheKey key;
+	Oid extension_id;
+	TransactionId extension_xmin;
+	int32 dimension_id;
+	int64 range_start;
+	int64 range_end;
+} SliceCacheEntry;
+
+extern void ts_slice_cache_setup_gucs(void);
+extern void ts_slice_cache_shmem_alloc(void);
+extern void ts_slice_cache_shmem_startup(void);
+extern void ts_slice_cache_remove_database(Oid database_id);
+
+#endif /* TIMESCALEDB_LOADER_SLICE_CACHE_H */
@@ -5,6 +5,7 @@
  */
 #include <postgres.h>
 #include <nodes/nodeFuncs.h>
+#include <optimizer/cost.h>
 #include <optimizer/optimizer.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
@@ -12,6 +13,8 @@
 #include <utils/builtins.h>
 #include <utils/typcache.h>
 
+#include <math.h>
+
 #include "planner/planner.h"
 #include "nodes/chunk_append/chunk_append.h"
 #include "func_cache.h"
@@ -25,6 +28,11 @@ static CustomPathMethods chunk_append_path_methods = {
 	.PlanCustomPath = ts_chunk_append_plan_create,
 };
 
+static CustomPathMethods chunk_append_lazy_path_methods = {
+	.CustomName = "ChunkAppend",
+	.PlanCustomPath = ts_chunk_append_lazy_plan_create,
+};
+
 bool
 ts_is_chunk_append_path(Path *path)
 {
@@ -38,6 +46,41 @@ has_joins(FromExpr *jointree)
 	return list_length(jointree->fromlist) != 1 || !IsA(linitial(jointree->fromlist), RangeTblRef);
 }
 
+/*
+ * Create a ChunkAppend path for a hypertable whose chunks have not been
+ * expanded, see should_expand_lazily(). Instead of having a child path per
+ * chunk, the path scans the hypertable itself and the executor node finds the
+ * chunks matching the restrictions and scans them sequentially.
+ *
+ * The cost is that of a sequential scan of all the chunks, since it is not
+ * known at planning time which of them will be excluded.
+ */
+Path *
+ts_chunk_append_lazy_path_create(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht)
+{
+	CustomPath *path = (CustomPath *) newNode(sizeof(CustomPath), T_CustomPath);
+
+	Assert(ts_get_private_reloptinfo(rel)->expand_lazily);
+
+	path->path.pathtype = T_CustomScan;
+	path->path.parent = rel;
+	path->path.pathtarget = rel->reltarget;
+	path->path.param_info = NULL;
+	path->path.pathkeys = NIL;
+
+	/* The chunks are opened by the executor node, which workers cannot share */
+	path->path.parallel_aware = false;
+	path->path.parallel_safe = false;
+	path->path.parallel_workers = 0;
+
+	path->flags = 0;
+	path->methods = &chunk_append_lazy_path_methods;
+
+	cost_seqscan(&path->path, root, rel, NULL);
+
+	return &path->path;
+}
+
 Path *
 ts_chunk_append_path_create(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht, Path *subpath,
 							bool parallel_aware, bool ordered, List *nested_oids)
@@ -223,6 +266,7 @@ ts_chunk_append_path_create(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 		ListCell *flat = list_head(children);
 		List *nested_children = NIL;
 		bool has_scan_childs = false;
+		int group = 0;
 
 		foreach (lc, nested_oids)
 		{
@@ -251,7 +295,23 @@ ts_chunk_append_path_create(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 				}
 			}
 
-			if (list_length(merge_childs) > 1)
+			if (ts_guc_enable_chunk_append_merge && merge_childs != NIL)
+			{
+				/*
+				 * ChunkAppend merges the children of the time slice itself,
+				 * so they stay scans that can be excluded.
+				 */
+				ListCell *lc_child;
+
+				foreach (lc_child, merge_childs)
+				{
+					nested_children = lappend(nested_children, lfirst(lc_child));
+					path->merge_groups = lappend_int(path->merge_groups, group);
+				}
+				has_scan_childs = true;
+				group++;
+			}
+			else if (list_length(merge_childs) > 1)
 			{
 				append = create_merge_append_path_compat(root,
 														 rel,
@@ -285,20 +345,65 @@ ts_chunk_append_path_create(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 		path->cpath.custom_paths = nested_children;
 	}
 
-	foreach (lc, path->cpath.custom_paths)
+	if (path->merge_groups == NIL)
+	{
+		foreach (lc, path->cpath.custom_paths)
+		{
+			Path *child = lfirst(lc);
+
+			/*
+			 * If there is a LIMIT clause we only include as many chunks as
+			 * planner thinks are needed to satisfy LIMIT clause.
+			 * We do this to prevent planner choosing parallel plan which might
+			 * otherwise look preferable cost wise.
+			 */
+			if (!path->pushdown_limit || path->limit_tuples == -1 || rows < path->limit_tuples)
+			{
+				total_cost += child->total_cost;
+				rows += child->rows;
+			}
+		}
+	}
+	else
 	{
-		Path *child = lfirst(lc);
+		ListCell *lc_group;
+		ListCell *lc_start = list_head(path->cpath.custom_paths);
+		ListCell *lc_group_start = list_head(path->merge_groups);
 
 		/*
-		 * If there is a LIMIT clause we only include as many chunks as
-		 * planner thinks are needed to satisfy LIMIT clause.
-		 * We do this to prevent planner choosing parallel plan which might
-		 * otherwise look preferable cost wise.
+		 * The children of a merged time slice are all needed for its first
+		 * tuple, so the LIMIT includes whole time slices, and the merge is
+		 * costed like a MergeAppend of the time slice.
 		 */
-		if (!path->pushdown_limit || path->limit_tuples == -1 || rows < path->limit_tuples)
+		while (lc_start != NULL)
 		{
-			total_cost += child->total_cost;
-			rows += child->rows;
+			int current_group = lfirst_int(lc_group_start);
+			bool include =
+				!path->pushdown_limit || path->limit_tuples == -1 || rows < path->limit_tuples;
+			double group_rows = 0.0;
+			int group_size = 0;
+
+			for (lc = lc_start, lc_group = lc_group_start;
+				 lc != NULL && lfirst_int(lc_group) == current_group;
+				 lc = lnext_compat(path->cpath.custom_paths, lc),
+				lc_group = lnext_compat(path->merge_groups, lc_group))
+			{
+				Path *child = lfirst(lc);
+
+				if (include)
+				{
+					total_cost += child->total_cost;
+					group_rows += child->rows;
+				}
+				group_size++;
+			}
+
+			if (include && group_size > 1)
+				total_cost += 2.0 * cpu_operator_cost * group_rows * log2(group_size);
+
+			rows += group_rows;
+			lc_start = lc;
+			lc_group_start = lc_group;
 		}
 	}
 
@@ -318,8 +423,10 @@ bool
 ts_ordered_append_should_optimize(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 								  List *join_conditions, int *order_attno, bool *reverse)
 {
-	SortGroupClause *sort = linitial(root->parse->sortClause);
-	TargetEntry *tle = get_sortgroupref_tle(sort->tleSortGroupRef, root->parse->targetList);
+	Query *parse = root->parse;
+	List *clauses = parse->sortClause;
+	SortGroupClause *sort;
+	TargetEntry *tle;
 	RangeTblEntry *rte = root->simple_rte_array[rel->relid];
 	TypeCacheEntry *tce;
 	char *column;
@@ -333,17 +440,30 @@ ts_ordered_append_should_optimize(PlannerInfo *root, RelOptInfo *rel, Hypertable
 		   ts_guc_enable_chunk_append);
 
 	/*
-	 * only do this optimization for queries with an ORDER BY clause,
-	 * caller checked this, so only asserting
+	 * Without an ORDER BY clause a sorted GROUP BY still wants its input in
+	 * the order of the grouping columns, which the planner then uses as the
+	 * query pathkeys. Producing that order with an Ordered Append lets a
+	 * GroupAggregate stream over the chunks instead of hashing all groups or
+	 * merging all chunks.
 	 */
-	Assert(root->parse->sortClause != NIL);
+	if (clauses == NIL)
+	{
+		if (!ts_guc_enable_ordered_append_group_by || parse->groupClause == NIL ||
+			parse->groupingSets != NIL || !grouping_is_sortable(parse->groupClause))
+			return false;
+
+		clauses = parse->groupClause;
+	}
+
+	sort = linitial(clauses);
+	tle = get_sortgroupref_tle(sort->tleSortGroupRef, parse->targetList);
 
 	if (IsA(tle->expr, Var))
 	{
 		/* direct column reference */
 		sort_var = castNode(Var, tle->expr);
 	}
-	else if (IsA(tle->expr, FuncExpr) && list_length(root->parse->sortClause) == 1)
+	else if (IsA(tle->expr, FuncExpr) && list_length(clauses) == 1)
 	{
 		/*
 		 * check for bucketing functions
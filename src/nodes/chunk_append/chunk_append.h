@@ -20,14 +20,22 @@ typedef struct ChunkAppendPath
 	bool pushdown_limit;
 	int limit_tuples;
 	int first_partial_path;
+	/* time slice of each child if the children of a time slice are merged */
+	List *merge_groups;
 } ChunkAppendPath;
 
 extern Path *ts_chunk_append_path_create(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 										 Path *subpath, bool parallel_aware, bool ordered,
 										 List *nested_oids);
+extern Path *ts_chunk_append_lazy_path_create(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht);
 extern Plan *ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path,
 										 List *tlist, List *clauses, List *custom_plans);
+extern Plan *ts_chunk_append_lazy_plan_create(PlannerInfo *root, RelOptInfo *rel,
+											  CustomPath *path, List *tlist, List *clauses,
+											  List *custom_plans);
 extern Node *ts_chunk_append_state_create(CustomScan *cscan);
+extern CustomScan *ts_chunk_append_startup_exclude(CustomScan *cscan, EState *estate,
+												   Bitmapset **excluded_relids);
 
 extern bool ts_ordered_append_should_optimize(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 											  List *join_conditions, int *order_attno,
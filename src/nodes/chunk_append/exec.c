@@ -6,9 +6,17 @@
 #include <postgres.h>
 #include <fmgr.h>
 #include <miscadmin.h>
+#include <access/stratnum.h>
+#include <access/table.h>
+#include <access/tableam.h>
+#include <access/tupconvert.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_class.h>
 #include <catalog/pg_collation.h>
+#include <commands/defrem.h>
 #include <executor/executor.h>
 #include <executor/nodeSubplan.h>
+#include <lib/binaryheap.h>
 #include <nodes/bitmapset.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
@@ -20,14 +28,22 @@
 #include <parser/parsetree.h>
 #include <rewrite/rewriteManip.h>
 #include <utils/builtins.h>
+#include <utils/lsyscache.h>
 #include <utils/memutils.h>
 #include <utils/ruleutils.h>
+#include <utils/sortsupport.h>
 #include <utils/typcache.h>
 
 #include <math.h>
 
 #include "nodes/chunk_append/chunk_append.h"
+#include "chunk.h"
+#include "compat/compat.h"
+#include "hypertable_cache.h"
+#include "hypertable_restrict_info.h"
 #include "loader/lwlocks.h"
+#include "planner/planner.h"
+#include "time_utils.h"
 
 #define INVALID_SUBPLAN_INDEX (-1)
 #define NO_MATCHING_SUBPLANS (-2)
@@ -38,6 +54,22 @@ typedef struct ParallelChunkAppendState
 	bool finished[FLEXIBLE_ARRAY_MEMBER];
 } ParallelChunkAppendState;
 
+/* restriction on a column that is checked against the ranges of the subplans */
+typedef struct ChunkAppendRangeRestriction
+{
+	StrategyNumber strategy;
+	Expr *value;
+	Oid value_type;
+} ChunkAppendRangeRestriction;
+
+/* inclusive range of the values a subplan can have in the restricted column */
+typedef struct ChunkAppendRange
+{
+	int64 start;
+	int64 end;
+	int subplan;
+} ChunkAppendRange;
+
 typedef struct ChunkAppendState
 {
 	CustomScanState csstate;
@@ -56,6 +88,10 @@ typedef struct ChunkAppendState
 	bool runtime_exclusion_children;
 	bool runtime_initialized;
 	uint32 limit;
+	/* startup exclusion was done before the node was initialized, see
+	 * ts_chunk_append_startup_exclude() */
+	bool excluded_before_begin;
+	int num_excluded_before_begin;
 
 	/* list of subplans after planning */
 	List *initial_subplans;
@@ -77,9 +113,28 @@ typedef struct ChunkAppendState
 	Bitmapset *valid_subplans;
 	Bitmapset *params;
 
-	/* sort options if this append is ordered, only used for EXPLAIN */
+	/* restrictions and subplan ranges sorted by start for runtime exclusion by range */
+	ChunkAppendRangeRestriction *range_restrictions;
+	int num_range_restrictions;
+	ChunkAppendRange *ranges;
+	uint64 range_max_span;
+
+	/* sort options if this append is ordered, only used for EXPLAIN and merging */
 	List *sort_options;
 
+	/* time slice of each subplan if the subplans of a time slice are merged */
+	List *initial_merge_groups;
+	List *filtered_merge_groups;
+	int *merge_groups;
+	int num_merge_groups;
+	/* state of the merge of the current time slice */
+	int merge_nkeys;
+	SortSupport merge_sortkeys;
+	TupleTableSlot **merge_slots;
+	binaryheap *merge_heap;
+	int merge_last_plan;
+	bool merge_started;
+
 	/* number of loops and exclusions for EXPLAIN */
 	int runtime_number_loops;
 	int runtime_number_exclusions_parent;
@@ -88,6 +143,9 @@ typedef struct ChunkAppendState
 	LWLock *lock;
 	ParallelContext *pcxt;
 	ParallelChunkAppendState *pstate;
+	/* order in which workers pick up subplans and the position of each subplan in it */
+	int *worker_order;
+	int *worker_positions;
 	void (*choose_next_subplan)(struct ChunkAppendState *);
 } ChunkAppendState;
 
@@ -117,6 +175,9 @@ static CustomExecMethods chunk_append_state_methods = {
 
 static void choose_next_subplan_non_parallel(ChunkAppendState *state);
 static void choose_next_subplan_for_worker(ChunkAppendState *state);
+static void initialize_worker_order(ChunkAppendState *state);
+static void initialize_merge(ChunkAppendState *state);
+static TupleTableSlot *chunk_append_exec_merge(ChunkAppendState *state);
 
 static List *constify_restrictinfos(PlannerInfo *root, List *restrictinfos);
 static bool can_exclude_chunk(List *constraints, List *baserestrictinfo);
@@ -125,17 +186,27 @@ static Node *constify_param_mutator(Node *node, void *context);
 static List *constify_restrictinfo_params(PlannerInfo *root, EState *state, List *restrictinfos);
 
 static void initialize_constraints(ChunkAppendState *state, List *initial_rt_indexes);
+static void initialize_range_exclusion(ChunkAppendState *state);
+static bool do_range_exclusion(ChunkAppendState *state, PlannerInfo *root);
 static LWLock *chunk_append_get_lock_pointer(void);
 
 static void show_sort_group_keys(ChunkAppendState *planstate, List *ancestors, ExplainState *es);
 static void show_sortorder_options(StringInfo buf, Node *sortexpr, Oid sortOperator, Oid collation,
 								   bool nullsFirst);
 
+static Node *chunk_append_lazy_state_create(CustomScan *cscan);
+
 Node *
 ts_chunk_append_state_create(CustomScan *cscan)
 {
 	ChunkAppendState *state;
-	List *settings = linitial(cscan->custom_private);
+	List *settings;
+
+	/* lazily expanded hypertables have no settings, see ts_chunk_append_lazy_plan_create() */
+	if (cscan->custom_private == NIL)
+		return chunk_append_lazy_state_create(cscan);
+
+	settings = linitial(cscan->custom_private);
 
 	state = (ChunkAppendState *) newNode(sizeof(ChunkAppendState), T_CustomScanState);
 
@@ -145,6 +216,15 @@ ts_chunk_append_state_create(CustomScan *cscan)
 	state->initial_ri_clauses = lsecond(cscan->custom_private);
 	state->sort_options = lfourth(cscan->custom_private);
 	state->initial_parent_clauses = lfirst(list_nth_cell(cscan->custom_private, 4));
+	state->initial_merge_groups = lfirst(list_nth_cell(cscan->custom_private, 5));
+	if (list_length(cscan->custom_private) > 6)
+	{
+		state->excluded_before_begin = true;
+		state->num_excluded_before_begin =
+			linitial_int(lfirst(list_nth_cell(cscan->custom_private, 6)));
+		state->initial_constraints = lfirst(list_nth_cell(cscan->custom_private, 7));
+		state->filtered_constraints = state->initial_constraints;
+	}
 
 	state->startup_exclusion = (bool) linitial_int(settings);
 	state->runtime_exclusion_parent = (bool) lsecond_int(settings);
@@ -154,6 +234,7 @@ ts_chunk_append_state_create(CustomScan *cscan)
 
 	state->filtered_subplans = state->initial_subplans;
 	state->filtered_ri_clauses = state->initial_ri_clauses;
+	state->filtered_merge_groups = state->initial_merge_groups;
 	state->filtered_first_partial_plan = state->first_partial_plan;
 
 	state->current = INVALID_SUBPLAN_INDEX;
@@ -172,6 +253,7 @@ do_startup_exclusion(ChunkAppendState *state)
 	List *filtered_children = NIL;
 	List *filtered_ri_clauses = NIL;
 	List *filtered_constraints = NIL;
+	List *filtered_merge_groups = NIL;
 	ListCell *lc_plan;
 	ListCell *lc_clauses;
 	ListCell *lc_constraints;
@@ -249,14 +331,96 @@ do_startup_exclusion(ChunkAppendState *state)
 		filtered_children = lappend(filtered_children, lfirst(lc_plan));
 		filtered_ri_clauses = lappend(filtered_ri_clauses, ri_clauses);
 		filtered_constraints = lappend(filtered_constraints, lfirst(lc_constraints));
+		if (state->initial_merge_groups != NIL)
+			filtered_merge_groups =
+				lappend_int(filtered_merge_groups, list_nth_int(state->initial_merge_groups, i));
 	}
 
 	state->filtered_subplans = filtered_children;
 	state->filtered_ri_clauses = filtered_ri_clauses;
 	state->filtered_constraints = filtered_constraints;
+	state->filtered_merge_groups = filtered_merge_groups;
 	state->filtered_first_partial_plan = filtered_first_partial_plan;
 }
 
+/*
+ * Do the startup exclusion of a ChunkAppend plan before the node is
+ * initialized.
+ *
+ * The ModifyTable of an UPDATE or DELETE opens all its result relations
+ * before it initializes the ChunkAppend that scans them. To open only the
+ * chunks that survive startup exclusion, HypertableModify does the exclusion
+ * up front with this function. The range table indexes of the excluded chunks
+ * are added to excluded_relids and a copy of the plan with only the remaining
+ * subplans is returned. The copy carries the result of the exclusion and the
+ * chunk constraints, so the executor node does not repeat the work. The plan
+ * itself is returned if it does no startup exclusion.
+ */
+CustomScan *
+ts_chunk_append_startup_exclude(CustomScan *cscan, EState *estate, Bitmapset **excluded_relids)
+{
+	ChunkAppendState *state;
+	CustomScan *filtered;
+	List *settings;
+	List *rt_indexes = NIL;
+	List *custom_private;
+	ListCell *lc_filtered;
+	ListCell *lc_plan;
+	ListCell *lc_relid;
+
+	if (cscan->custom_private == NIL || !linitial_int(linitial(cscan->custom_private)))
+		return cscan;
+
+	state = (ChunkAppendState *) ts_chunk_append_state_create(cscan);
+	state->csstate.ss.ps.state = estate;
+	initialize_constraints(state, lthird(cscan->custom_private));
+	do_startup_exclusion(state);
+	MemoryContextDelete(state->exclusion_ctx);
+
+	/* The filtered subplans keep the order of the initial ones */
+	lc_filtered = list_head(state->filtered_subplans);
+	forboth (lc_plan, state->initial_subplans, lc_relid, lthird(cscan->custom_private))
+	{
+		Scan *scan = ts_chunk_append_get_scan_plan(lfirst(lc_plan));
+
+		if (lc_filtered != NULL && lfirst(lc_filtered) == lfirst(lc_plan))
+		{
+			/* The clauses already refer to the final range table index */
+			rt_indexes = lappend_oid(rt_indexes,
+									 scan != NULL && scan->scanrelid > 0 ? scan->scanrelid :
+																		   lfirst_oid(lc_relid));
+			lc_filtered = lnext_compat(state->filtered_subplans, lc_filtered);
+		}
+		else
+		{
+			Assert(scan != NULL && scan->scanrelid > 0);
+			*excluded_relids = bms_add_member(*excluded_relids, scan->scanrelid);
+		}
+	}
+
+	settings = list_copy(linitial(cscan->custom_private));
+	lfirst_int(list_nth_cell(settings, 4)) = state->filtered_first_partial_plan;
+
+	custom_private = list_make1(settings);
+	custom_private = lappend(custom_private, state->filtered_ri_clauses);
+	custom_private = lappend(custom_private, rt_indexes);
+	custom_private = lappend(custom_private, state->sort_options);
+	custom_private = lappend(custom_private, state->initial_parent_clauses);
+	custom_private = lappend(custom_private, state->filtered_merge_groups);
+	custom_private = lappend(custom_private,
+							 list_make1_int(state->num_excluded_before_begin +
+											list_length(state->initial_subplans) -
+											list_length(state->filtered_subplans)));
+	custom_private = lappend(custom_private, state->filtered_constraints);
+
+	filtered = makeNode(CustomScan);
+	memcpy(filtered, cscan, sizeof(CustomScan));
+	filtered->custom_plans = state->filtered_subplans;
+	filtered->custom_private = custom_private;
+
+	return filtered;
+}
+
 /*
  * Complete initialization of the supplied CustomScanState.
  * Standard fields have been initialized by ExecInitCustomScan,
@@ -291,10 +455,13 @@ chunk_append_begin(CustomScanState *node, EState *estate, int eflags)
 	node->ss.ps.resultopsfixed = false;
 	ExecAssignScanProjectionInfoWithVarno(&node->ss, INDEX_VAR);
 
-	initialize_constraints(state, lthird(cscan->custom_private));
+	if (!state->excluded_before_begin)
+	{
+		initialize_constraints(state, lthird(cscan->custom_private));
 
-	if (state->startup_exclusion)
-		do_startup_exclusion(state);
+		if (state->startup_exclusion)
+			do_startup_exclusion(state);
+	}
 
 	state->num_subplans = list_length(state->filtered_subplans);
 
@@ -325,6 +492,12 @@ chunk_append_begin(CustomScanState *node, EState *estate, int eflags)
 		i++;
 	}
 
+	if (state->runtime_exclusion_children)
+		initialize_range_exclusion(state);
+
+	if (state->filtered_merge_groups != NIL)
+		initialize_merge(state);
+
 	if (state->runtime_exclusion_parent || state->runtime_exclusion_children)
 	{
 		state->params = state->subplanstates[0]->plan->allParam;
@@ -411,6 +584,9 @@ initialize_runtime_exclusion(ChunkAppendState *state)
 		return;
 	}
 
+	if (state->num_range_restrictions > 0 && do_range_exclusion(state, &root))
+		return;
+
 	Assert(state->num_subplans == list_length(state->filtered_ri_clauses));
 
 	lc_clauses = list_head(state->filtered_ri_clauses);
@@ -447,6 +623,368 @@ initialize_runtime_exclusion(ChunkAppendState *state)
 	}
 }
 
+/*
+ * Runtime exclusion by range
+ *
+ * Refuting the constraints of every chunk with predicate_refuted_by() on every
+ * rescan is expensive, for instance when a nested loop join drives the
+ * ChunkAppend node with a new parameter for every outer row. When all the
+ * clauses that can change at runtime are comparisons of the same column of an
+ * integer or time type, the subplans are excluded by comparing the range the
+ * clauses allow with the ranges the chunk constraints allow for the column.
+ * The ranges of the subplans are kept sorted by their start, so the matching
+ * subplans are found with a binary search.
+ *
+ * The ranges are kept as int64 keys, which for these types have the same
+ * order as the values. Exclusive bounds are turned into inclusive ones, which
+ * can only make a range wider and thus never excludes a subplan that has
+ * matching rows.
+ */
+
+static int64
+range_key(Datum value, Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return DatumGetInt16(value);
+		case INT4OID:
+		case DATEOID:
+			return DatumGetInt32(value);
+		default:
+			return DatumGetInt64(value);
+	}
+}
+
+static void
+range_restrict(int64 *start, int64 *end, StrategyNumber strategy, int64 key)
+{
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			*end = Min(*end, key == PG_INT64_MIN ? key : key - 1);
+			break;
+		case BTLessEqualStrategyNumber:
+			*end = Min(*end, key);
+			break;
+		case BTEqualStrategyNumber:
+			*start = Max(*start, key);
+			*end = Min(*end, key);
+			break;
+		case BTGreaterEqualStrategyNumber:
+			*start = Max(*start, key);
+			break;
+		case BTGreaterStrategyNumber:
+			*start = Max(*start, key == PG_INT64_MAX ? key : key + 1);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Split a comparison of a column of the relation with an expression of the
+ * same type, or of another integer type for integer columns, into the column,
+ * the btree strategy with the column on the left and the expression.
+ */
+static bool
+range_split_comparison(Expr *clause, Index varno, Var **var, StrategyNumber *strategy,
+					   Expr **value)
+{
+	OpExpr *op;
+	Expr *left, *right;
+	Oid opclass;
+	bool commuted;
+
+	if (!IsA(clause, OpExpr) || list_length(castNode(OpExpr, clause)->args) != 2)
+		return false;
+
+	op = castNode(OpExpr, clause);
+	left = linitial(op->args);
+	right = lsecond(op->args);
+
+	if (IsA(left, Var) && castNode(Var, left)->varno == varno)
+	{
+		*var = castNode(Var, left);
+		*value = right;
+		commuted = false;
+	}
+	else if (IsA(right, Var) && castNode(Var, right)->varno == varno)
+	{
+		*var = castNode(Var, right);
+		*value = left;
+		commuted = true;
+	}
+	else
+		return false;
+
+	if ((*var)->varlevelsup != 0 || !IS_VALID_TIME_TYPE((*var)->vartype))
+		return false;
+
+	if (exprType((Node *) *value) != (*var)->vartype &&
+		!(IS_INTEGER_TYPE((*var)->vartype) && IS_INTEGER_TYPE(exprType((Node *) *value))))
+		return false;
+
+	opclass = GetDefaultOpClass((*var)->vartype, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+		return false;
+
+	*strategy = get_op_opfamily_strategy(op->opno, get_opclass_family(opclass));
+
+	if (commuted)
+	{
+		switch (*strategy)
+		{
+			case BTLessStrategyNumber:
+				*strategy = BTGreaterStrategyNumber;
+				break;
+			case BTLessEqualStrategyNumber:
+				*strategy = BTGreaterEqualStrategyNumber;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				*strategy = BTLessEqualStrategyNumber;
+				break;
+			case BTGreaterStrategyNumber:
+				*strategy = BTLessStrategyNumber;
+				break;
+			default:
+				break;
+		}
+	}
+
+	return *strategy != InvalidStrategy;
+}
+
+static int
+range_cmp_start(const void *a, const void *b)
+{
+	const ChunkAppendRange *ra = a;
+	const ChunkAppendRange *rb = b;
+
+	if (ra->start == rb->start)
+		return 0;
+
+	return ra->start < rb->start ? -1 : 1;
+}
+
+/*
+ * Returns the number of ranges that start before the key, or at the key when
+ * inclusive is set.
+ */
+static int
+range_upper_bound(ChunkAppendState *state, int64 key, bool inclusive)
+{
+	int low = 0;
+	int high = state->num_subplans;
+
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (state->ranges[mid].start < key || (inclusive && state->ranges[mid].start == key))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/*
+ * Collect the restrictions and the subplan ranges for runtime exclusion by
+ * range. Leaves num_range_restrictions at zero if the clauses or the subplans
+ * are not suitable.
+ */
+static void
+initialize_range_exclusion(ChunkAppendState *state)
+{
+	EState *estate = state->csstate.ss.ps.state;
+	Scan *scan = ts_chunk_append_get_scan_plan(state->subplanstates[0]->plan);
+	List *clauses = linitial(state->filtered_ri_clauses);
+	ChunkAppendRangeRestriction *restrictions;
+	ChunkAppendRange *ranges;
+	int num_restrictions = 0;
+	AttrNumber attno = InvalidAttrNumber;
+	Oid type = InvalidOid;
+	uint64 max_span = 0;
+	char *attname;
+	ListCell *lc, *lc_constraints;
+	int i;
+
+	if (scan == NULL || scan->scanrelid == 0 ||
+		list_length(state->filtered_constraints) != state->num_subplans)
+		return;
+
+	/*
+	 * The clauses of all subplans are translations of the clauses of the
+	 * hypertable, so the ones of the first subplan apply to all of them. The
+	 * clauses without parameters or mutable functions were already used for
+	 * exclusion at planning time and can be ignored.
+	 */
+	restrictions = palloc(sizeof(ChunkAppendRangeRestriction) * Max(list_length(clauses), 1));
+
+	foreach (lc, clauses)
+	{
+		Expr *clause = lfirst(lc);
+		StrategyNumber strategy;
+		Expr *value;
+		Var *var;
+
+		if (!ts_contain_param((Node *) clause) && !contain_mutable_functions((Node *) clause))
+			continue;
+
+		if (!range_split_comparison(clause, scan->scanrelid, &var, &strategy, &value) ||
+			contain_var_clause((Node *) value) || contain_volatile_functions((Node *) value) ||
+			(attno != InvalidAttrNumber && var->varattno != attno))
+			return;
+
+		attno = var->varattno;
+		type = var->vartype;
+		restrictions[num_restrictions].strategy = strategy;
+		restrictions[num_restrictions].value = value;
+		restrictions[num_restrictions].value_type = exprType((Node *) value);
+		num_restrictions++;
+	}
+
+	if (num_restrictions == 0)
+		return;
+
+	attname = get_attname(rt_fetch(scan->scanrelid, estate->es_range_table)->relid, attno, false);
+	ranges = palloc(sizeof(ChunkAppendRange) * state->num_subplans);
+
+	i = 0;
+	foreach (lc_constraints, state->filtered_constraints)
+	{
+		Scan *child_scan = ts_chunk_append_get_scan_plan(state->subplanstates[i]->plan);
+		ChunkAppendRange *range = &ranges[i];
+		AttrNumber child_attno;
+
+		if (child_scan == NULL || child_scan->scanrelid == 0)
+			return;
+
+		/* the column can have a different attno in the chunk */
+		child_attno =
+			get_attnum(rt_fetch(child_scan->scanrelid, estate->es_range_table)->relid, attname);
+
+		if (child_attno == InvalidAttrNumber)
+			return;
+
+		range->start = PG_INT64_MIN;
+		range->end = PG_INT64_MAX;
+		range->subplan = i;
+
+		foreach (lc, lfirst(lc_constraints))
+		{
+			StrategyNumber strategy;
+			Expr *value;
+			Var *var;
+
+			if (range_split_comparison(lfirst(lc),
+									   child_scan->scanrelid,
+									   &var,
+									   &strategy,
+									   &value) &&
+				var->varattno == child_attno && var->vartype == type && IsA(value, Const) &&
+				!castNode(Const, value)->constisnull)
+				range_restrict(&range->start,
+							   &range->end,
+							   strategy,
+							   range_key(castNode(Const, value)->constvalue,
+										 castNode(Const, value)->consttype));
+		}
+
+		/* the unsigned difference cannot overflow, even for unbounded ranges */
+		if (range->start <= range->end)
+			max_span = Max(max_span, (uint64) range->end - (uint64) range->start);
+
+		i++;
+	}
+
+	qsort(ranges, state->num_subplans, sizeof(ChunkAppendRange), range_cmp_start);
+
+	state->range_restrictions = restrictions;
+	state->num_range_restrictions = num_restrictions;
+	state->ranges = ranges;
+	state->range_max_span = max_span;
+}
+
+/*
+ * Mark the subplans whose range overlaps the range allowed by the
+ * restrictions as valid. Returns false if a restriction cannot be evaluated,
+ * in which case the constraints of the subplans have to be refuted instead.
+ */
+static bool
+do_range_exclusion(ChunkAppendState *state, PlannerInfo *root)
+{
+	EState *estate = state->csstate.ss.ps.state;
+	MemoryContext old = MemoryContextSwitchTo(state->exclusion_ctx);
+	int64 start = PG_INT64_MIN;
+	int64 end = PG_INT64_MAX;
+	bool is_null = false;
+	int num_valid = 0;
+
+	for (int i = 0; i < state->num_range_restrictions; i++)
+	{
+		ChunkAppendRangeRestriction *restriction = &state->range_restrictions[i];
+		Node *value = constify_param_mutator((Node *) restriction->value, estate);
+
+		value = estimate_expression_value(root, value);
+
+		if (!IsA(value, Const))
+		{
+			MemoryContextReset(state->exclusion_ctx);
+			MemoryContextSwitchTo(old);
+			return false;
+		}
+
+		/* the comparison operators are strict, so nothing matches NULL */
+		if (castNode(Const, value)->constisnull)
+		{
+			is_null = true;
+			break;
+		}
+
+		range_restrict(&start,
+					   &end,
+					   restriction->strategy,
+					   range_key(castNode(Const, value)->constvalue, restriction->value_type));
+	}
+
+	MemoryContextReset(state->exclusion_ctx);
+	MemoryContextSwitchTo(old);
+
+	if (!is_null && start <= end)
+	{
+		int first = 0;
+		int last = range_upper_bound(state, end, true);
+
+		/*
+		 * A range that ends at or after the start of the restriction starts
+		 * at most range_max_span before it.
+		 */
+		if ((uint64) start - (uint64) PG_INT64_MIN > state->range_max_span)
+		{
+			int64 min_start = (int64) ((uint64) start - state->range_max_span);
+
+			first = range_upper_bound(state, min_start, false);
+		}
+
+		for (int i = first; i < last; i++)
+		{
+			if (state->ranges[i].end >= start)
+			{
+				state->valid_subplans =
+					bms_add_member(state->valid_subplans, state->ranges[i].subplan);
+				num_valid++;
+			}
+		}
+	}
+
+	state->runtime_number_exclusions_children += state->num_subplans - num_valid;
+
+	return true;
+}
+
 /*
  * Fetch the next scan tuple.
  *
@@ -462,6 +1000,19 @@ chunk_append_exec(CustomScanState *node)
 	ProjectionInfo *projinfo = node->ss.ps.ps_ProjInfo;
 	TupleTableSlot *subslot;
 
+	if (state->merge_groups != NULL)
+	{
+		subslot = chunk_append_exec_merge(state);
+
+		if (TupIsNull(subslot) || projinfo == NULL)
+			return subslot;
+
+		ResetExprContext(econtext);
+		econtext->ecxt_scantuple = subslot;
+
+		return ExecProject(projinfo);
+	}
+
 	if (state->current == INVALID_SUBPLAN_INDEX)
 		state->choose_next_subplan(state);
 
@@ -537,6 +1088,83 @@ choose_next_subplan_non_parallel(ChunkAppendState *state)
 	state->current = get_next_subplan(state, state->current);
 }
 
+/*
+ * Order in which workers pick up subplans. The non-partial subplans come first
+ * in the order of the plan, which puts the most expensive ones first. The
+ * partial subplans follow with the most expensive ones first as well, so
+ * that the big chunks are started early and the workers that finish the
+ * small ones later on join the big ones that are still running, sharing
+ * their remaining blocks, instead of all waiting for the worker that started
+ * a big chunk last.
+ */
+static int
+worker_order_cmp(const void *a, const void *b, void *arg)
+{
+	ChunkAppendState *state = (ChunkAppendState *) arg;
+	int plan_a = *(const int *) a;
+	int plan_b = *(const int *) b;
+	Cost cost_a = state->subplanstates[plan_a]->plan->total_cost;
+	Cost cost_b = state->subplanstates[plan_b]->plan->total_cost;
+
+	if (cost_a != cost_b)
+		return cost_a > cost_b ? -1 : 1;
+
+	return plan_a < plan_b ? -1 : (plan_a > plan_b ? 1 : 0);
+}
+
+static void
+initialize_worker_order(ChunkAppendState *state)
+{
+	int first_partial_plan = Min(state->filtered_first_partial_plan, state->num_subplans);
+	int i;
+
+	state->worker_order = palloc(sizeof(int) * Max(state->num_subplans, 1));
+	state->worker_positions = palloc(sizeof(int) * Max(state->num_subplans, 1));
+
+	for (i = 0; i < state->num_subplans; i++)
+		state->worker_order[i] = i;
+
+	if (state->num_subplans - first_partial_plan > 1)
+		qsort_arg(state->worker_order + first_partial_plan,
+				  state->num_subplans - first_partial_plan,
+				  sizeof(int),
+				  worker_order_cmp,
+				  state);
+
+	for (i = 0; i < state->num_subplans; i++)
+		state->worker_positions[state->worker_order[i]] = i;
+}
+
+/*
+ * Get the next valid subplan after last_plan in the order in which workers
+ * pick up subplans. Like get_next_subplan(), this returns
+ * NO_MATCHING_SUBPLANS when the end of the subplans is reached.
+ */
+static int
+get_next_worker_subplan(ChunkAppendState *state, int last_plan)
+{
+	bool runtime_exclusion = state->runtime_exclusion_parent || state->runtime_exclusion_children;
+	int pos;
+
+	if (last_plan == NO_MATCHING_SUBPLANS)
+		return NO_MATCHING_SUBPLANS;
+
+	if (runtime_exclusion && !state->runtime_initialized)
+		initialize_runtime_exclusion(state);
+
+	pos = last_plan < 0 ? 0 : state->worker_positions[last_plan] + 1;
+
+	for (; pos < state->num_subplans; pos++)
+	{
+		int next_plan = state->worker_order[pos];
+
+		if (!runtime_exclusion || bms_is_member(next_plan, state->valid_subplans))
+			return next_plan;
+	}
+
+	return NO_MATCHING_SUBPLANS;
+}
+
 static void
 choose_next_subplan_for_worker(ChunkAppendState *state)
 {
@@ -551,7 +1179,7 @@ choose_next_subplan_for_worker(ChunkAppendState *state)
 		pstate->finished[state->current] = true;
 
 	if (pstate->next_plan == INVALID_SUBPLAN_INDEX)
-		next_plan = get_next_subplan(state, INVALID_SUBPLAN_INDEX);
+		next_plan = get_next_worker_subplan(state, INVALID_SUBPLAN_INDEX);
 	else
 		next_plan = pstate->next_plan;
 
@@ -569,11 +1197,11 @@ choose_next_subplan_for_worker(ChunkAppendState *state)
 	/* skip finished subplans */
 	while (pstate->finished[next_plan])
 	{
-		next_plan = get_next_subplan(state, next_plan);
+		next_plan = get_next_worker_subplan(state, next_plan);
 
 		/* wrap around if we reach end of subplan list */
 		if (next_plan < 0)
-			next_plan = get_next_subplan(state, INVALID_SUBPLAN_INDEX);
+			next_plan = get_next_worker_subplan(state, INVALID_SUBPLAN_INDEX);
 
 		if (next_plan == start || next_plan < 0)
 		{
@@ -605,7 +1233,7 @@ choose_next_subplan_for_worker(ChunkAppendState *state)
 		pstate->finished[next_plan] = true;
 
 	/* advance next_plan for next worker */
-	pstate->next_plan = get_next_subplan(state, state->current);
+	pstate->next_plan = get_next_worker_subplan(state, state->current);
 	/*
 	 * if we reach the end of the list of subplans we set next_plan
 	 * to INVALID_SUBPLAN_INDEX to allow rechecking unfinished subplans
@@ -617,6 +1245,149 @@ choose_next_subplan_for_worker(ChunkAppendState *state)
 	LWLockRelease(state->lock);
 }
 
+/*
+ * Merging of space partitions
+ *
+ * For ordered appends over space partitioned hypertables, the chunks of a
+ * time slice overlap in time and their output has to be merged. Instead of a
+ * MergeAppend node per time slice, the chunks can be direct subplans that
+ * ChunkAppend merges itself, one time slice after the other. This keeps the
+ * chunks subject to startup and runtime exclusion and starts only the chunks
+ * of the time slices that are actually read, like a MergeAppend node
+ * (see nodeMergeAppend.c) does within a single time slice.
+ */
+static int32
+merge_compare_slots(Datum a, Datum b, void *arg)
+{
+	ChunkAppendState *state = (ChunkAppendState *) arg;
+	TupleTableSlot *s1 = state->merge_slots[DatumGetInt32(a)];
+	TupleTableSlot *s2 = state->merge_slots[DatumGetInt32(b)];
+
+	for (int nkey = 0; nkey < state->merge_nkeys; nkey++)
+	{
+		SortSupport sortKey = state->merge_sortkeys + nkey;
+		AttrNumber attno = sortKey->ssup_attno;
+		Datum datum1, datum2;
+		bool isNull1, isNull2;
+		int compare;
+
+		datum1 = slot_getattr(s1, attno, &isNull1);
+		datum2 = slot_getattr(s2, attno, &isNull2);
+
+		compare = ApplySortComparator(datum1, isNull1, datum2, isNull2, sortKey);
+
+		/* the binary heap is a max-heap, so invert the result to get the smallest first */
+		if (compare != 0)
+		{
+			INVERT_COMPARE_RESULT(compare);
+			return compare;
+		}
+	}
+
+	return 0;
+}
+
+static void
+initialize_merge(ChunkAppendState *state)
+{
+	List *sort_indexes = linitial(state->sort_options);
+	List *sort_ops = lsecond(state->sort_options);
+	List *sort_collations = lthird(state->sort_options);
+	List *sort_nulls = lfourth(state->sort_options);
+	ListCell *lc;
+	int i;
+
+	Assert(list_length(state->filtered_merge_groups) == state->num_subplans);
+
+	state->merge_groups = palloc(sizeof(int) * Max(state->num_subplans, 1));
+	i = 0;
+	foreach (lc, state->filtered_merge_groups)
+		state->merge_groups[i++] = lfirst_int(lc);
+
+	state->merge_nkeys = list_length(sort_indexes);
+	state->merge_sortkeys = palloc0(sizeof(SortSupportData) * state->merge_nkeys);
+
+	for (i = 0; i < state->merge_nkeys; i++)
+	{
+		SortSupport sortKey = state->merge_sortkeys + i;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = list_nth_oid(sort_collations, i);
+		sortKey->ssup_nulls_first = (bool) list_nth_oid(sort_nulls, i);
+		sortKey->ssup_attno = (AttrNumber) list_nth_oid(sort_indexes, i);
+		sortKey->abbreviate = false;
+
+		PrepareSortSupportFromOrderingOp(list_nth_oid(sort_ops, i), sortKey);
+	}
+
+	state->merge_slots = palloc0(sizeof(TupleTableSlot *) * Max(state->num_subplans, 1));
+	state->merge_heap =
+		binaryheap_allocate(Max(state->num_subplans, 1), merge_compare_slots, state);
+}
+
+/*
+ * Return the next tuple of the merge of the current time slice, moving on to
+ * the next time slice when it is exhausted.
+ */
+static TupleTableSlot *
+chunk_append_exec_merge(ChunkAppendState *state)
+{
+	if (state->current == INVALID_SUBPLAN_INDEX)
+		state->choose_next_subplan(state);
+
+	while (true)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (state->current == NO_MATCHING_SUBPLANS)
+			return ExecClearTuple(state->csstate.ss.ps.ps_ResultTupleSlot);
+
+		if (!state->merge_started)
+		{
+			/*
+			 * Start the merge of the time slice with the first tuple of each
+			 * of its valid subplans.
+			 */
+			int group = state->merge_groups[state->current];
+			int plan = state->current;
+
+			while (plan >= 0 && state->merge_groups[plan] == group)
+			{
+				TupleTableSlot *slot = ExecProcNode(state->subplanstates[plan]);
+
+				state->merge_slots[plan] = slot;
+				if (!TupIsNull(slot))
+					binaryheap_add_unordered(state->merge_heap, Int32GetDatum(plan));
+
+				state->merge_last_plan = plan;
+				plan = get_next_subplan(state, plan);
+			}
+
+			binaryheap_build(state->merge_heap);
+			state->merge_started = true;
+		}
+		else if (!binaryheap_empty(state->merge_heap))
+		{
+			/* advance the subplan whose tuple was returned last */
+			int plan = DatumGetInt32(binaryheap_first(state->merge_heap));
+			TupleTableSlot *slot = ExecProcNode(state->subplanstates[plan]);
+
+			state->merge_slots[plan] = slot;
+			if (!TupIsNull(slot))
+				binaryheap_replace_first(state->merge_heap, Int32GetDatum(plan));
+			else
+				(void) binaryheap_remove_first(state->merge_heap);
+		}
+
+		if (!binaryheap_empty(state->merge_heap))
+			return state->merge_slots[DatumGetInt32(binaryheap_first(state->merge_heap))];
+
+		/* the time slice is exhausted, continue with the next one */
+		state->current = get_next_subplan(state, state->merge_last_plan);
+		state->merge_started = false;
+	}
+}
+
 /*
  * Clean up any private data associated with the CustomScanState.
  *
@@ -653,6 +1424,12 @@ chunk_append_rescan(CustomScanState *node)
 	}
 	state->current = INVALID_SUBPLAN_INDEX;
 
+	if (state->merge_heap != NULL)
+	{
+		binaryheap_reset(state->merge_heap);
+		state->merge_started = false;
+	}
+
 	/*
 	 * detect changed params and reset runtime exclusion state
 	 */
@@ -709,6 +1486,7 @@ chunk_append_initialize_dsm(CustomScanState *node, ParallelContext *pcxt, void *
 	state->current = INVALID_SUBPLAN_INDEX;
 	state->pcxt = pcxt;
 	state->pstate = pstate;
+	initialize_worker_order(state);
 }
 
 /*
@@ -748,6 +1526,7 @@ chunk_append_initialize_worker(CustomScanState *node, shm_toc *toc, void *coordi
 	state->choose_next_subplan = choose_next_subplan_for_worker;
 	state->current = INVALID_SUBPLAN_INDEX;
 	state->pstate = pstate;
+	initialize_worker_order(state);
 }
 
 /*
@@ -1058,6 +1837,12 @@ chunk_append_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 	if (state->sort_options != NIL)
 		show_sort_group_keys(state, ancestors, es);
 
+	if (state->initial_merge_groups != NIL)
+		ExplainPropertyInteger("Merged time slices",
+							   NULL,
+							   llast_int(state->initial_merge_groups) + 1,
+							   es);
+
 	if (es->verbose || es->format != EXPLAIN_FORMAT_TEXT)
 		ExplainPropertyBool("Startup Exclusion", state->startup_exclusion, es);
 
@@ -1069,7 +1854,9 @@ chunk_append_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 	if (state->startup_exclusion)
 		ExplainPropertyInteger("Chunks excluded during startup",
 							   NULL,
-							   list_length(state->initial_subplans) - list_length(node->custom_ps),
+							   state->num_excluded_before_begin +
+								   list_length(state->initial_subplans) -
+								   list_length(node->custom_ps),
 							   es);
 
 	if (state->runtime_exclusion_parent && state->runtime_number_loops > 0)
@@ -1198,3 +1985,297 @@ show_sortorder_options(StringInfo buf, Node *sortexpr, Oid sortOperator, Oid col
 		appendStringInfoString(buf, " NULLS LAST");
 	}
 }
+
+/*
+ * Lazily expanded hypertables
+ *
+ * When the chunks of a hypertable are not expanded at planning time (see
+ * should_expand_lazily()), the ChunkAppend node has no child plans and scans
+ * the hypertable itself. On the first call, and again on rescans with changed
+ * parameters, the quals are constified with the current parameter values and
+ * used to look up the matching chunks in the catalog. The chunks are then
+ * scanned one after another, with their tuples converted to the rowtype of
+ * the hypertable where needed, so that the quals and the projection of the
+ * node apply to them.
+ *
+ * Since the plan references only the hypertable, a cached generic plan stays
+ * valid when chunks are dropped. Creating a chunk still invalidates it, since
+ * PostgreSQL invalidates the relcache entry of the parent whenever a child
+ * table is attached to it.
+ */
+typedef struct ChunkAppendLazyState
+{
+	CustomScanState csstate;
+	MemoryContext exclusion_ctx;
+
+	/* chunks matching the quals, only valid if chunks_resolved is set */
+	bool chunks_resolved;
+	Oid *chunk_relids;
+	int num_chunks;
+	int current;
+
+	/* scan of the current chunk */
+	Relation chunk_rel;
+	TableScanDesc chunk_scan;
+	TupleTableSlot *chunk_slot;
+	TupleConversionMap *chunk_map;
+
+	/* number of loops and chunks found for EXPLAIN */
+	int runtime_number_loops;
+	int runtime_number_chunks;
+} ChunkAppendLazyState;
+
+static void chunk_append_lazy_begin(CustomScanState *node, EState *estate, int eflags);
+static TupleTableSlot *chunk_append_lazy_exec(CustomScanState *node);
+static void chunk_append_lazy_end(CustomScanState *node);
+static void chunk_append_lazy_rescan(CustomScanState *node);
+static void chunk_append_lazy_explain(CustomScanState *node, List *ancestors, ExplainState *es);
+
+static CustomExecMethods chunk_append_lazy_state_methods = {
+	.BeginCustomScan = chunk_append_lazy_begin,
+	.ExecCustomScan = chunk_append_lazy_exec,
+	.EndCustomScan = chunk_append_lazy_end,
+	.ReScanCustomScan = chunk_append_lazy_rescan,
+	.ExplainCustomScan = chunk_append_lazy_explain,
+};
+
+static Node *
+chunk_append_lazy_state_create(CustomScan *cscan)
+{
+	ChunkAppendLazyState *state;
+
+	state = (ChunkAppendLazyState *) newNode(sizeof(ChunkAppendLazyState), T_CustomScanState);
+
+	state->csstate.methods = &chunk_append_lazy_state_methods;
+	state->current = INVALID_SUBPLAN_INDEX;
+	state->exclusion_ctx = AllocSetContextCreate(CurrentMemoryContext,
+												 "ChunkApppend exclusion",
+												 ALLOCSET_DEFAULT_SIZES);
+
+	return (Node *) state;
+}
+
+static void
+chunk_append_lazy_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	CustomScan *cscan = castNode(CustomScan, node->ss.ps.plan);
+
+	/*
+	 * The scanned tuples come from the chunks, so their slot type is not
+	 * known in advance and the quals and the projection need to be
+	 * initialized accordingly.
+	 */
+	node->ss.ps.scanopsfixed = false;
+	node->ss.ps.resultopsfixed = false;
+	ExecAssignScanProjectionInfoWithVarno(&node->ss, cscan->scan.scanrelid);
+	node->ss.ps.qual = ExecInitQual(cscan->scan.plan.qual, &node->ss.ps);
+}
+
+/*
+ * Find the chunks matching the quals with the current parameter values.
+ */
+static void
+chunk_append_lazy_resolve_chunks(ChunkAppendLazyState *state)
+{
+	ScanState *ss = &state->csstate.ss;
+	EState *estate = ss->ps.state;
+
+	/*
+	 * create skeleton plannerinfo for estimate_expression_value and the
+	 * restriction info of the hypertable
+	 */
+	Query parse = {
+		.type = T_Query,
+		.rtable = estate->es_range_table,
+	};
+	PlannerGlobal glob = {
+		.boundParams = estate->es_param_list_info,
+	};
+	PlannerInfo root = {
+		.glob = &glob,
+		.parse = &parse,
+	};
+	List *restrictinfos = NIL;
+	HypertableRestrictInfo *hri;
+	Hypertable *ht;
+	Cache *hcache;
+	Chunk **chunks;
+	unsigned int num_chunks = 0;
+	MemoryContext old;
+	ListCell *lc;
+
+	old = MemoryContextSwitchTo(state->exclusion_ctx);
+
+	foreach (lc, ss->ps.plan->qual)
+	{
+		RestrictInfo *ri = makeNode(RestrictInfo);
+		ri->clause = lfirst(lc);
+		restrictinfos = lappend(restrictinfos, ri);
+	}
+	restrictinfos = constify_restrictinfo_params(&root, estate, restrictinfos);
+
+	hcache = ts_hypertable_cache_pin();
+	ht = ts_hypertable_cache_get_entry(hcache,
+									   RelationGetRelid(ss->ss_currentRelation),
+									   CACHE_FLAG_NONE);
+	hri = ts_hypertable_restrict_info_create(NULL, ht);
+	ts_hypertable_restrict_info_add(hri, &root, restrictinfos);
+
+	/* this also locks the chunks */
+	chunks = ts_hypertable_restrict_info_get_chunks(hri, ht, &num_chunks);
+
+	if (state->chunk_relids != NULL)
+		pfree(state->chunk_relids);
+	state->chunk_relids =
+		MemoryContextAlloc(estate->es_query_cxt, sizeof(Oid) * Max(num_chunks, 1));
+
+	for (unsigned int i = 0; i < num_chunks; i++)
+	{
+		if (chunks[i]->relkind != RELKIND_RELATION ||
+			chunks[i]->fd.compressed_chunk_id != INVALID_CHUNK_ID)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot scan chunk \"%s\" of a lazily expanded hypertable",
+							get_rel_name(chunks[i]->table_id)),
+					 errhint("Set timescaledb.enable_lazy_chunk_expansion to off and run the "
+							 "query again.")));
+
+		state->chunk_relids[i] = chunks[i]->table_id;
+	}
+
+	ts_cache_release(hcache);
+	MemoryContextSwitchTo(old);
+	MemoryContextReset(state->exclusion_ctx);
+
+	state->num_chunks = num_chunks;
+	state->chunks_resolved = true;
+	state->runtime_number_loops++;
+	state->runtime_number_chunks += num_chunks;
+}
+
+static void
+chunk_append_lazy_end_chunk(ChunkAppendLazyState *state)
+{
+	/* the scan slot can reference the values of the chunk slot */
+	ExecClearTuple(state->csstate.ss.ss_ScanTupleSlot);
+
+	if (state->chunk_scan != NULL)
+		table_endscan(state->chunk_scan);
+	if (state->chunk_slot != NULL)
+		ExecDropSingleTupleTableSlot(state->chunk_slot);
+	if (state->chunk_map != NULL)
+		free_conversion_map(state->chunk_map);
+	if (state->chunk_rel != NULL)
+		table_close(state->chunk_rel, NoLock);
+
+	state->chunk_scan = NULL;
+	state->chunk_slot = NULL;
+	state->chunk_map = NULL;
+	state->chunk_rel = NULL;
+}
+
+/*
+ * Start the scan of the next chunk. Returns false if all chunks have been
+ * scanned.
+ */
+static bool
+chunk_append_lazy_next_chunk(ChunkAppendLazyState *state)
+{
+	ScanState *ss = &state->csstate.ss;
+
+	chunk_append_lazy_end_chunk(state);
+
+	if (state->current + 1 >= state->num_chunks)
+		return false;
+
+	state->current++;
+
+	/* the chunks were locked when they were resolved */
+	state->chunk_rel = table_open(state->chunk_relids[state->current], NoLock);
+	state->chunk_slot = table_slot_create(state->chunk_rel, NULL);
+	state->chunk_map = convert_tuples_by_name_compat(RelationGetDescr(state->chunk_rel),
+													 RelationGetDescr(ss->ss_currentRelation),
+													 gettext_noop("could not convert row type"));
+	state->chunk_scan =
+		table_beginscan(state->chunk_rel, ss->ps.state->es_snapshot, 0, NULL);
+
+	return true;
+}
+
+static TupleTableSlot *
+chunk_append_lazy_next(ScanState *ss)
+{
+	ChunkAppendLazyState *state = (ChunkAppendLazyState *) ss;
+
+	if (!state->chunks_resolved)
+	{
+		chunk_append_lazy_resolve_chunks(state);
+		state->current = INVALID_SUBPLAN_INDEX;
+	}
+
+	for (;;)
+	{
+		if (state->chunk_scan != NULL &&
+			table_scan_getnextslot(state->chunk_scan, ForwardScanDirection, state->chunk_slot))
+		{
+			if (state->chunk_map == NULL)
+				return state->chunk_slot;
+
+			return execute_attr_map_slot(state->chunk_map->attrMap,
+										 state->chunk_slot,
+										 ss->ss_ScanTupleSlot);
+		}
+
+		if (!chunk_append_lazy_next_chunk(state))
+			return ExecClearTuple(ss->ss_ScanTupleSlot);
+	}
+}
+
+static bool
+chunk_append_lazy_recheck(ScanState *ss, TupleTableSlot *slot)
+{
+	/* there are no access method conditions to recheck */
+	return true;
+}
+
+static TupleTableSlot *
+chunk_append_lazy_exec(CustomScanState *node)
+{
+	return ExecScan(&node->ss, chunk_append_lazy_next, chunk_append_lazy_recheck);
+}
+
+static void
+chunk_append_lazy_end(CustomScanState *node)
+{
+	chunk_append_lazy_end_chunk((ChunkAppendLazyState *) node);
+}
+
+static void
+chunk_append_lazy_rescan(CustomScanState *node)
+{
+	ChunkAppendLazyState *state = (ChunkAppendLazyState *) node;
+
+	chunk_append_lazy_end_chunk(state);
+	state->current = INVALID_SUBPLAN_INDEX;
+
+	/* the matching chunks can change with the parameters of the quals */
+	if (node->ss.ps.chgParam != NULL)
+		state->chunks_resolved = false;
+
+	ExecScanReScan(&node->ss);
+}
+
+static void
+chunk_append_lazy_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	ChunkAppendLazyState *state = (ChunkAppendLazyState *) node;
+
+	if (es->verbose || es->format != EXPLAIN_FORMAT_TEXT)
+		ExplainPropertyBool("Lazy Expansion", true, es);
+
+	if (state->runtime_number_loops > 0)
+		ExplainPropertyInteger("Chunks found during runtime",
+							   NULL,
+							   state->runtime_number_chunks / state->runtime_number_loops,
+							   es);
+}
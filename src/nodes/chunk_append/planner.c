@@ -10,12 +10,14 @@
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
 #include <optimizer/appendinfo.h>
+#include <optimizer/cost.h>
 #include <optimizer/optimizer.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
 #include <optimizer/placeholder.h>
 #include <optimizer/planmain.h>
 #include <optimizer/prep.h>
+#include <optimizer/restrictinfo.h>
 #include <optimizer/subselect.h>
 #include <optimizer/tlist.h>
 #include <parser/parsetree.h>
@@ -28,6 +30,11 @@
 
 static Sort *make_sort(Plan *lefttree, int numCols, AttrNumber *sortColIdx, Oid *sortOperators,
 					   Oid *collations, bool *nullsFirst);
+#if PG13_GE
+static IncrementalSort *make_incremental_sort(Plan *lefttree, int numCols, int nPresortedCols,
+											  AttrNumber *sortColIdx, Oid *sortOperators,
+											  Oid *collations, bool *nullsFirst);
+#endif
 static Plan *adjust_childscan(PlannerInfo *root, Plan *plan, Path *path, List *pathkeys,
 							  List *tlist, AttrNumber *sortColIdx);
 
@@ -71,6 +78,9 @@ adjust_childscan(PlannerInfo *root, Plan *plan, Path *path, List *pathkeys, List
 	Oid *collations;
 	bool *nullsFirst;
 	AttrNumber *childColIdx;
+#if PG13_GE
+	int presorted_keys;
+#endif
 
 	/* push down targetlist to children */
 	plan->targetlist = castNode(List, adjust_appendrel_attrs(root, (Node *) tlist, 1, &appinfo));
@@ -88,12 +98,29 @@ adjust_childscan(PlannerInfo *root, Plan *plan, Path *path, List *pathkeys, List
 										 &nullsFirst);
 
 	/* inject sort node if child sort order does not match desired order */
-	if (!pathkeys_contained_in(pathkeys, path->pathkeys))
-	{
-		plan = (Plan *)
-			make_sort(plan, childSortCols, childColIdx, sortOperators, collations, nullsFirst);
-	}
-	return plan;
+#if PG13_GE
+	if (pathkeys_count_contained_in(pathkeys, path->pathkeys, &presorted_keys))
+		return plan;
+
+	/*
+	 * If the child is already sorted by a prefix of the pathkeys, e.g. by an
+	 * index on the time column, an incremental sort only has to sort each
+	 * group of tuples with equal prefix keys instead of the whole chunk.
+	 */
+	if (enable_incremental_sort && presorted_keys > 0)
+		return (Plan *) make_incremental_sort(plan,
+											  childSortCols,
+											  presorted_keys,
+											  childColIdx,
+											  sortOperators,
+											  collations,
+											  nullsFirst);
+#else
+	if (pathkeys_contained_in(pathkeys, path->pathkeys))
+		return plan;
+#endif
+
+	return (Plan *) make_sort(plan, childSortCols, childColIdx, sortOperators, collations, nullsFirst);
 }
 
 Plan *
@@ -312,12 +339,40 @@ ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path
 	custom_private = lappend(custom_private, chunk_rt_indexes);
 	custom_private = lappend(custom_private, sort_options);
 	custom_private = lappend(custom_private, parent_clauses);
+	custom_private = lappend(custom_private, capath->merge_groups);
 
 	cscan->custom_private = custom_private;
 
 	return &cscan->scan.plan;
 }
 
+/*
+ * Create the plan of a lazily expanded hypertable. It is a ChunkAppend that
+ * scans the hypertable without any child plans, which the executor node
+ * recognizes by the missing custom_private settings. The restrictions of the
+ * quals are used by the executor both to find the chunks and to filter the
+ * tuples.
+ */
+Plan *
+ts_chunk_append_lazy_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path,
+								 List *tlist, List *clauses, List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+
+	Assert(custom_plans == NIL);
+
+	cscan->flags = path->flags;
+	cscan->methods = &chunk_append_plan_methods;
+	cscan->scan.scanrelid = rel->relid;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = extract_actual_clauses(clauses, false);
+	cscan->custom_plans = NIL;
+	cscan->custom_private = NIL;
+	cscan->custom_scan_tlist = NIL;
+
+	return &cscan->scan.plan;
+}
+
 /*
  * make_sort --- basic routine to build a Sort plan node
  *
@@ -344,11 +399,44 @@ make_sort(Plan *lefttree, int numCols, AttrNumber *sortColIdx, Oid *sortOperator
 	return node;
 }
 
+#if PG13_GE
+/*
+ * make_incremental_sort --- basic routine to build an IncrementalSort plan node
+ *
+ * The first nPresortedCols sort columns are the ones the input is already
+ * sorted by.
+ */
+static IncrementalSort *
+make_incremental_sort(Plan *lefttree, int numCols, int nPresortedCols, AttrNumber *sortColIdx,
+					  Oid *sortOperators, Oid *collations, bool *nullsFirst)
+{
+	IncrementalSort *node = makeNode(IncrementalSort);
+	Plan *plan = &node->sort.plan;
+
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+	node->nPresortedCols = nPresortedCols;
+	node->sort.numCols = numCols;
+	node->sort.sortColIdx = sortColIdx;
+	node->sort.sortOperators = sortOperators;
+	node->sort.collations = collations;
+	node->sort.nullsFirst = nullsFirst;
+
+	return node;
+}
+#endif
+
 Scan *
 ts_chunk_append_get_scan_plan(Plan *plan)
 {
 	if (plan != NULL && (IsA(plan, Sort) || IsA(plan, Result)))
 		plan = plan->lefttree;
+#if PG13_GE
+	else if (plan != NULL && IsA(plan, IncrementalSort))
+		plan = plan->lefttree;
+#endif
 
 	if (plan == NULL)
 		return NULL;
@@ -4,6 +4,7 @@
  * LICENSE-APACHE for a copy of the license.
  */
 #include <postgres.h>
+#include <access/table.h>
 #include <nodes/nodes.h>
 #include <nodes/extensible.h>
 #include <nodes/makefuncs.h>
@@ -18,6 +19,7 @@
 #include "subspace_store.h"
 #include "dimension.h"
 #include "guc.h"
+#include "indexing.h"
 #include "ts_catalog/chunk_data_node.h"
 
 ChunkDispatch *
@@ -33,6 +35,14 @@ ts_chunk_dispatch_create(Hypertable *ht, EState *estate, int eflags)
 		ts_subspace_store_init(ht->space, estate->es_query_cxt, ts_guc_max_open_chunks_per_insert);
 	cd->prev_cis = NULL;
 	cd->prev_cis_oid = InvalidOid;
+	cd->multi_insert_states = NIL;
+	cd->multi_insert_buffered = 0;
+	cd->chunk_layouts = NIL;
+	cd->direct_compressed_chunks = NIL;
+	cd->on_conflict_cache = NULL;
+	cd->last_point = ts_last_point_state_create(ht, estate->es_query_cxt);
+	cd->stats.statements = 1;
+	INSTR_TIME_SET_CURRENT(cd->start_time);
 
 	return cd;
 }
@@ -96,10 +106,83 @@ ts_chunk_dispatch_get_cmd_type(const ChunkDispatch *dispatch)
 											  dispatch->dispatch_state->mtstate->operation;
 }
 
+/*
+ * Insert the rows buffered for batch inserts into all the chunks.
+ */
+void
+ts_chunk_dispatch_multi_insert_flush(ChunkDispatch *dispatch)
+{
+	ListCell *lc;
+
+	foreach (lc, dispatch->multi_insert_states)
+		ts_chunk_insert_state_multi_insert_flush(lfirst(lc));
+
+	list_free(dispatch->multi_insert_states);
+	dispatch->multi_insert_states = NIL;
+	Assert(dispatch->multi_insert_buffered == 0);
+}
+
 void
 ts_chunk_dispatch_destroy(ChunkDispatch *chunk_dispatch)
 {
+	instr_time duration;
+
+	/* The statement is done, so update the last point cache with its rows */
+	ts_last_point_state_flush(chunk_dispatch->last_point);
 	ts_subspace_store_free(chunk_dispatch->cache);
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, chunk_dispatch->start_time);
+	chunk_dispatch->stats.insert_time_us = INSTR_TIME_GET_MICROSEC(duration);
+	ts_ingest_stats_report(chunk_dispatch->hypertable->fd.id, &chunk_dispatch->stats);
+}
+
+/*
+ * Compress a chunk that an insert just created, so that the rows of the
+ * insert are compressed into batches directly, see
+ * timescaledb.enable_direct_compression, instead of being written to the
+ * chunk and compressed again later. This is only done when the chunk insert
+ * state can buffer the rows for compression, so not with ON CONFLICT,
+ * RETURNING, unique indexes or row triggers, and when the chunk is not
+ * merged into another one on compression.
+ */
+static void
+chunk_dispatch_compress_new_chunk(ChunkDispatch *dispatch, Chunk *chunk)
+{
+	const Hypertable *ht = dispatch->hypertable;
+	const Dimension *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Chunk *compressed_chunk;
+	MemoryContext old_mcxt;
+	Relation rel;
+	bool can_buffer;
+
+	if (!TS_HYPERTABLE_HAS_COMPRESSION_ENABLED(ht) || chunk->relkind != RELKIND_RELATION ||
+		time_dim == NULL || time_dim->fd.compress_interval_length != 0 ||
+		ts_chunk_dispatch_get_on_conflict_action(dispatch) != ONCONFLICT_NONE ||
+		ts_chunk_dispatch_has_returning(dispatch))
+		return;
+
+	rel = table_open(chunk->table_id, AccessShareLock);
+	can_buffer = ts_chunk_insert_state_can_buffer_compressed(dispatch, chunk, rel);
+	table_close(rel, NoLock);
+
+	if (!can_buffer)
+		return;
+
+	DirectFunctionCall2(ts_cm_functions->compress_chunk,
+						ObjectIdGetDatum(chunk->table_id),
+						BoolGetDatum(false));
+
+	/* The chunk is owned by the chunk cache of the hypertable, update it there */
+	compressed_chunk = ts_chunk_get_by_id(chunk->fd.id, true);
+	chunk->fd.compressed_chunk_id = compressed_chunk->fd.compressed_chunk_id;
+	chunk->fd.status = compressed_chunk->fd.status;
+
+	/* The chunk insert state compresses all rows of the chunk into batches */
+	old_mcxt = MemoryContextSwitchTo(dispatch->estate->es_query_cxt);
+	dispatch->direct_compressed_chunks =
+		lappend_int(dispatch->direct_compressed_chunks, chunk->fd.id);
+	MemoryContextSwitchTo(old_mcxt);
 }
 
 static void
@@ -108,6 +191,27 @@ destroy_chunk_insert_state(void *cis)
 	ts_chunk_insert_state_destroy((ChunkInsertState *) cis);
 }
 
+/*
+ * Check if the point falls into the hypercube of the chunk insert state. The
+ * slices of the cube are in the same order as the coordinates of the point.
+ */
+static inline bool
+chunk_insert_state_contains_point(const ChunkInsertState *cis, const Point *point)
+{
+	const Hypercube *cube = cis->cube;
+
+	if (cube->num_slices != point->num_coords)
+		return false;
+
+	for (int i = 0; i < cube->num_slices; i++)
+	{
+		if (ts_dimension_slice_cmp_coordinate(cube->slices[i], point->coordinates[i]) != 0)
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * Get the chunk insert state for the chunk that matches the given point in the
  * partitioned hyperspace.
@@ -127,7 +231,19 @@ ts_chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *point,
 	if (dispatch->hypertable->fd.compression_state == HypertableInternalCompressionTable)
 		elog(ERROR, "direct insert into internal compressed hypertable is not supported");
 
-	cis = ts_subspace_store_get(dispatch->cache, point);
+	/*
+	 * Consecutive tuples mostly go into the same chunk, e.g., when the data
+	 * arrives in time order, so check the chunk of the previous tuple before
+	 * walking the subspace store. The previous chunk insert state is always
+	 * still in the store here, since states are only evicted when adding a
+	 * new one below, which then becomes the previous one.
+	 */
+	if (dispatch->prev_cis != NULL && chunk_insert_state_contains_point(dispatch->prev_cis, point))
+		cis = dispatch->prev_cis;
+	else
+		cis = ts_subspace_store_get(dispatch->cache, point);
+
+	dispatch->stats.rows++;
 
 	if (NULL == cis)
 	{
@@ -147,7 +263,19 @@ ts_chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *point,
 		 * where the chunk already exists.
 		 */
 		bool found;
-		Chunk *new_chunk = ts_hypertable_find_chunk_for_point(dispatch->hypertable, point);
+		Chunk *new_chunk;
+		const SubspaceStoreStats *chunk_cache_stats =
+			ts_subspace_store_stats(dispatch->hypertable->chunk_cache);
+		uint64 chunk_cache_hits = chunk_cache_stats->hits;
+
+		dispatch->stats.insert_state_misses++;
+
+		/* The lookup goes through the chunk cache of the hypertable first */
+		new_chunk = ts_hypertable_find_chunk_for_point(dispatch->hypertable, point);
+		if (chunk_cache_stats->hits > chunk_cache_hits)
+			dispatch->stats.chunk_cache_hits++;
+		else
+			dispatch->stats.chunk_cache_misses++;
 
 #if PG14_GE
 		/*
@@ -161,7 +289,23 @@ ts_chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *point,
 
 		if (new_chunk == NULL)
 		{
+			instr_time start_time;
+			instr_time duration;
+
+			INSTR_TIME_SET_CURRENT(start_time);
 			new_chunk = ts_hypertable_create_chunk_for_point(dispatch->hypertable, point, &found);
+			INSTR_TIME_SET_CURRENT(duration);
+			INSTR_TIME_SUBTRACT(duration, start_time);
+
+			/* Includes waiting for the concurrent creation of the same chunk */
+			dispatch->stats.chunk_create_time_us += INSTR_TIME_GET_MICROSEC(duration);
+			if (!found)
+			{
+				dispatch->stats.chunks_created++;
+
+				if (ts_guc_enable_direct_compression)
+					chunk_dispatch_compress_new_chunk(dispatch, new_chunk);
+			}
 		}
 		else
 			found = true;
@@ -188,20 +332,26 @@ ts_chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *point,
 			elog(ERROR, "no chunk found or created");
 
 		cis = ts_chunk_insert_state_create(new_chunk, dispatch);
-		ts_subspace_store_add(dispatch->cache, new_chunk->cube, cis, destroy_chunk_insert_state);
+		if (ts_subspace_store_add(dispatch->cache, new_chunk->cube, cis, destroy_chunk_insert_state))
+			dispatch->stats.insert_state_evictions++;
 
 		MemoryContextSwitchTo(old_context);
 	}
-	else if (cis->rel->rd_id == dispatch->prev_cis_oid && cis == dispatch->prev_cis)
+	else
 	{
+		dispatch->stats.insert_state_hits++;
+
 		/* got the same item from cache as before */
-		cis_changed = false;
+		if (cis->rel->rd_id == dispatch->prev_cis_oid && cis == dispatch->prev_cis)
+			cis_changed = false;
 	}
 
 	if (cis_changed && on_chunk_changed)
 		on_chunk_changed(cis, data);
 
 	Assert(cis != NULL);
+	ts_chunk_insert_state_track_invalidation(cis, point);
+	ts_chunk_insert_state_track_adaptive_stats(cis, point);
 	dispatch->prev_cis = cis;
 	dispatch->prev_cis_oid = cis->rel->rd_id;
 	return cis;
@@ -10,12 +10,15 @@
 #include <nodes/parsenodes.h>
 #include <nodes/execnodes.h>
 #include <executor/tuptable.h>
+#include <portability/instr_time.h>
 
 #include "hypertable_cache.h"
 #include "cache.h"
 #include "subspace_store.h"
 #include "chunk_dispatch_state.h"
 #include "chunk_insert_state.h"
+#include "ingest_stats.h"
+#include "last_point.h"
 
 /*
  * ChunkDispatch keeps cached state needed to dispatch tuples to chunks. It is
@@ -38,6 +41,21 @@ typedef struct ChunkDispatch
 	ResultRelInfo *hypertable_result_rel_info;
 	ChunkInsertState *prev_cis;
 	Oid prev_cis_oid;
+	/* The chunk insert states with rows buffered for a batch insert */
+	List *multi_insert_states;
+	int multi_insert_buffered;
+	/* The tuple conversion maps of the chunk layouts, see chunk_insert_state.c */
+	List *chunk_layouts;
+	/* The ids of the chunks created and compressed by the statement, see
+	 * timescaledb.enable_direct_compression */
+	List *direct_compressed_chunks;
+	/* The ON CONFLICT state of the chunks, see chunk_insert_state.c */
+	HTAB *on_conflict_cache;
+	/* The newest inserted row of every key, for the last point cache */
+	LastPointState *last_point;
+	/* The ingest statistics of the statement, reported when it is done */
+	IngestStatsCounters stats;
+	instr_time start_time;
 } ChunkDispatch;
 
 typedef struct Point Point;
@@ -55,5 +73,6 @@ extern List *ts_chunk_dispatch_get_arbiter_indexes(const ChunkDispatch *dispatch
 extern OnConflictAction ts_chunk_dispatch_get_on_conflict_action(const ChunkDispatch *dispatch);
 extern List *ts_chunk_dispatch_get_on_conflict_set(const ChunkDispatch *dispatch);
 extern CmdType ts_chunk_dispatch_get_cmd_type(const ChunkDispatch *dispatch);
+extern void ts_chunk_dispatch_multi_insert_flush(ChunkDispatch *dispatch);
 
 #endif /* TIMESCALEDB_CHUNK_DISPATCH_H */
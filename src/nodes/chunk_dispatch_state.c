@@ -124,6 +124,21 @@ chunk_dispatch_exec(CustomScanState *node)
 	if (cis->hyper_to_chunk_map != NULL)
 		slot = execute_attr_map_slot(cis->hyper_to_chunk_map->attrMap, slot, cis->slot);
 
+	/*
+	 * Move the compressed rows that could conflict with the row on a unique
+	 * index to the uncompressed chunk before the row is inserted.
+	 */
+	if (cis->decompress_for_insert)
+		ts_cm_functions->decompress_batches_for_insert(cis, slot);
+
+#if PG14_LT
+	/*
+	 * The PostgreSQL ModifyTable node inserts the row, so collect it for the
+	 * last point cache here. Changes made by BEFORE ROW triggers are not seen.
+	 */
+	ts_chunk_insert_state_last_point_store(cis, slot);
+#endif
+
 	return slot;
 }
 
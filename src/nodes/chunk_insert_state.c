@@ -5,8 +5,11 @@
  */
 #include <postgres.h>
 #include <access/attnum.h>
+#include <access/tableam.h>
 #include <access/xact.h>
+#include <catalog/pg_trigger_d.h>
 #include <catalog/pg_type.h>
+#include <commands/trigger.h>
 #include <executor/tuptable.h>
 #include <foreign/fdwapi.h>
 #include <miscadmin.h>
@@ -19,19 +22,29 @@
 #include <rewrite/rewriteManip.h>
 #include <utils/builtins.h>
 #include <utils/guc.h>
+#include <utils/hsearch.h>
 #include <utils/lsyscache.h>
 #include <utils/memutils.h>
 #include <utils/rel.h>
 #include <utils/rls.h>
 
 #include "compat/compat.h"
+#if PG13_GE
+#include <common/hashfn.h>
+#else
+#include <utils/hashutils.h>
+#endif
 #include "errors.h"
 #include "chunk_insert_state.h"
 #include "chunk_dispatch.h"
+#include "ts_catalog/chunk_column_stats.h"
 #include "ts_catalog/chunk_data_node.h"
 #include "ts_catalog/continuous_agg.h"
+#include "chunk_adaptive.h"
 #include "chunk_dispatch_state.h"
 #include "chunk_index.h"
+#include "dimension.h"
+#include "guc.h"
 #include "indexing.h"
 
 /* Just like ExecPrepareExpr except that it doesn't switch to the query memory context */
@@ -277,6 +290,212 @@ adjust_chunk_colnos(List *colnos, ResultRelInfo *chunk_rri)
 }
 #endif
 
+/*
+ * The tuple conversion maps between the hypertable and the chunks with the
+ * same physical layout, i.e., the same attributes in the same order. Chunks
+ * only differ from the hypertable after columns were dropped, and all the
+ * chunks created after that have the same layout again, so the maps are
+ * built once per layout and shared by the chunk insert states of the
+ * statement. Every chunk insert state gets its own copy of the
+ * TupleConversionMap struct that points to the tuple descriptor of its chunk,
+ * but the attribute map is shared. The layouts are allocated on the query
+ * memory context.
+ */
+typedef struct ChunkLayout
+{
+	uint32 fingerprint;
+	TupleDesc tupdesc;
+	/* NULL if the layout is the layout of the hypertable */
+	TupleConversionMap *hyper_to_chunk_map;
+	bool chunk_to_hyper_map_valid;
+	TupleConversionMap *chunk_to_hyper_map;
+} ChunkLayout;
+
+static uint32
+tupdesc_layout_fingerprint(TupleDesc tupdesc)
+{
+	uint32 hash = murmurhash32((uint32) tupdesc->natts);
+
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		if (attr->attisdropped)
+		{
+			hash = hash_combine(hash, 0);
+			continue;
+		}
+
+		hash = hash_combine(hash,
+							DatumGetUInt32(hash_any((const unsigned char *) NameStr(attr->attname),
+													strlen(NameStr(attr->attname)))));
+		hash = hash_combine(hash, murmurhash32(attr->atttypid));
+		hash = hash_combine(hash, murmurhash32((uint32) attr->atttypmod));
+	}
+
+	return hash;
+}
+
+/* Check that the tuple descriptors map to the hypertable in the same way */
+static bool
+tupdesc_layout_equal(TupleDesc desc1, TupleDesc desc2)
+{
+	if (desc1->natts != desc2->natts)
+		return false;
+
+	for (int i = 0; i < desc1->natts; i++)
+	{
+		Form_pg_attribute attr1 = TupleDescAttr(desc1, i);
+		Form_pg_attribute attr2 = TupleDescAttr(desc2, i);
+
+		if (attr1->attisdropped != attr2->attisdropped)
+			return false;
+
+		if (attr1->attisdropped)
+			continue;
+
+		if (namestrcmp(&attr1->attname, NameStr(attr2->attname)) != 0 ||
+			attr1->atttypid != attr2->atttypid || attr1->atttypmod != attr2->atttypmod ||
+			attr1->attcollation != attr2->attcollation)
+			return false;
+	}
+
+	return true;
+}
+
+static ChunkLayout *
+chunk_layout_get(ChunkDispatch *dispatch, Relation hyper_rel, Relation chunk_rel)
+{
+	TupleDesc chunk_desc = RelationGetDescr(chunk_rel);
+	uint32 fingerprint = tupdesc_layout_fingerprint(chunk_desc);
+	ChunkLayout *layout;
+	MemoryContext old_mcxt;
+	ListCell *lc;
+
+	foreach (lc, dispatch->chunk_layouts)
+	{
+		layout = lfirst(lc);
+
+		if (layout->fingerprint == fingerprint && tupdesc_layout_equal(layout->tupdesc, chunk_desc))
+			return layout;
+	}
+
+	old_mcxt = MemoryContextSwitchTo(dispatch->estate->es_query_cxt);
+	layout = palloc0(sizeof(ChunkLayout));
+	layout->fingerprint = fingerprint;
+	layout->tupdesc = CreateTupleDescCopy(chunk_desc);
+	layout->hyper_to_chunk_map =
+		convert_tuples_by_name_compat(RelationGetDescr(hyper_rel),
+									  layout->tupdesc,
+									  gettext_noop("could not convert row type"));
+	dispatch->chunk_layouts = lappend(dispatch->chunk_layouts, layout);
+	MemoryContextSwitchTo(old_mcxt);
+
+	return layout;
+}
+
+/*
+ * Make a conversion map for the chunk from a shared map. Only the tuple
+ * descriptors are chunk specific.
+ */
+static TupleConversionMap *
+chunk_conversion_map_create(const TupleConversionMap *shared_map, TupleDesc indesc,
+							TupleDesc outdesc)
+{
+	TupleConversionMap *map;
+
+	if (shared_map == NULL)
+		return NULL;
+
+	map = palloc(sizeof(TupleConversionMap));
+	memcpy(map, shared_map, sizeof(TupleConversionMap));
+	map->indesc = indesc;
+	map->outdesc = outdesc;
+
+	return map;
+}
+
+static TupleConversionMap *
+chunk_layout_get_chunk_to_hyper_map(ChunkDispatch *dispatch, ChunkLayout *layout,
+									Relation hyper_rel, Relation chunk_rel)
+{
+	if (!layout->chunk_to_hyper_map_valid)
+	{
+		MemoryContext old_mcxt = MemoryContextSwitchTo(dispatch->estate->es_query_cxt);
+
+		layout->chunk_to_hyper_map =
+			convert_tuples_by_name_compat(layout->tupdesc,
+										  RelationGetDescr(hyper_rel),
+										  gettext_noop("could not convert row type"));
+		layout->chunk_to_hyper_map_valid = true;
+		MemoryContextSwitchTo(old_mcxt);
+	}
+
+	return chunk_conversion_map_create(layout->chunk_to_hyper_map,
+									   RelationGetDescr(chunk_rel),
+									   RelationGetDescr(hyper_rel));
+}
+
+/*
+ * The ON CONFLICT state of a chunk that does not depend on the executor state
+ * of the chunk insert state: the arbiter indexes of the chunk and the ON
+ * CONFLICT expressions translated to the attribute numbers of the chunk.
+ *
+ * The chunk insert states are destroyed and created again when a statement
+ * inserts into more chunks than fit in the subspace store, so this state is
+ * kept in the chunk dispatch for the whole statement. It is allocated on the
+ * query memory context.
+ *
+ * Chunks with the tuple descriptor of the hypertable already share the ON
+ * CONFLICT state of the hypertable. The translated expressions of the other
+ * chunks reference the row type of the chunk, so they are cached per chunk.
+ */
+typedef struct OnConflictCacheEntry
+{
+	Oid chunk_relid; /* hash key */
+	bool arbiters_valid;
+	List *arbiter_indexes;
+	bool translated;
+	List *onconflict_set;
+	List *onconflict_cols;
+	List *onconflict_where;
+} OnConflictCacheEntry;
+
+static OnConflictCacheEntry *
+on_conflict_cache_get_entry(ChunkDispatch *dispatch, Oid chunk_relid)
+{
+	OnConflictCacheEntry *entry;
+	bool found;
+
+	if (dispatch->on_conflict_cache == NULL)
+	{
+		HASHCTL ctl = {
+			.keysize = sizeof(Oid),
+			.entrysize = sizeof(OnConflictCacheEntry),
+			.hcxt = dispatch->estate->es_query_cxt,
+		};
+
+		dispatch->on_conflict_cache = hash_create("chunk ON CONFLICT cache",
+												  32,
+												  &ctl,
+												  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = hash_search(dispatch->on_conflict_cache, &chunk_relid, HASH_ENTER, &found);
+
+	if (!found)
+	{
+		entry->arbiters_valid = false;
+		entry->arbiter_indexes = NIL;
+		entry->translated = false;
+		entry->onconflict_set = NIL;
+		entry->onconflict_cols = NIL;
+		entry->onconflict_where = NIL;
+	}
+
+	return entry;
+}
+
 /*
  * Setup ON CONFLICT state for a chunk.
  *
@@ -340,46 +559,65 @@ setup_on_conflict_state(ChunkInsertState *state, ChunkDispatch *dispatch,
 	}
 	else
 	{
-		List *onconflset;
-#if PG14_GE
-		List *onconflcols;
-#endif
-
-		/*
-		 * Translate expressions in onConflictSet to account for
-		 * different attribute numbers.  For that, map partition
-		 * varattnos twice: first to catch the EXCLUDED
-		 * pseudo-relation (INNER_VAR), and second to handle the main
-		 * target relation (firstVarno).
-		 */
-		onconflset = copyObject(mt->onConflictSet);
+		OnConflictCacheEntry *entry =
+			on_conflict_cache_get_entry(dispatch, RelationGetRelid(chunk_rel));
 
 		Assert(map->outdesc == RelationGetDescr(chunk_rel));
 
-		if (!chunk_map)
-			chunk_map = convert_tuples_by_name_compat(RelationGetDescr(chunk_rel),
-													  RelationGetDescr(hyper_rel),
-													  gettext_noop("could not convert row type"));
+		/* The chunk map is set up with the layout, see adjust_projections() */
+		Assert(chunk_map != NULL);
 
-		onconflset = translate_clause(onconflset,
-									  chunk_map,
-									  hyper_rri->ri_RangeTableIndex,
-									  hyper_rel,
-									  chunk_rel);
+#if PG14_GE
+		chunk_rri->ri_ChildToRootMap = chunk_map;
+		chunk_rri->ri_ChildToRootMapValid = true;
+#endif
+
+		if (!entry->translated)
+		{
+			MemoryContext old_mcxt = MemoryContextSwitchTo(dispatch->estate->es_query_cxt);
+			List *onconflset;
+			Node *onconflict_where = mt->onConflictWhere;
+
+			/*
+			 * Translate expressions in onConflictSet to account for
+			 * different attribute numbers.  For that, map partition
+			 * varattnos twice: first to catch the EXCLUDED
+			 * pseudo-relation (INNER_VAR), and second to handle the main
+			 * target relation (firstVarno).
+			 */
+			onconflset = copyObject(mt->onConflictSet);
+			onconflset = translate_clause(onconflset,
+										  chunk_map,
+										  hyper_rri->ri_RangeTableIndex,
+										  hyper_rel,
+										  chunk_rel);
 
 #if PG14_LT
-		onconflset = adjust_hypertable_tlist(onconflset, state->hyper_to_chunk_map);
+			entry->onconflict_set = adjust_hypertable_tlist(onconflset, state->hyper_to_chunk_map);
 #else
-		chunk_rri->ri_ChildToRootMap = chunk_map;
-		chunk_rri->ri_ChildToRootMapValid = true;
+			entry->onconflict_set = onconflset;
 
-		/* Finally, adjust the target colnos to match the chunk. */
-		if (chunk_map)
-			onconflcols = adjust_chunk_colnos(mt->onConflictCols, chunk_rri);
-		else
-			onconflcols = mt->onConflictCols;
+			/* Finally, adjust the target colnos to match the chunk. */
+			if (chunk_map)
+				entry->onconflict_cols = adjust_chunk_colnos(mt->onConflictCols, chunk_rri);
+			else
+				entry->onconflict_cols = mt->onConflictCols;
 #endif
 
+			/*
+			 * Map attribute numbers in the WHERE clause, if it exists.
+			 */
+			if (onconflict_where && chunk_map)
+				entry->onconflict_where = translate_clause(castNode(List, onconflict_where),
+														   chunk_map,
+														   hyper_rri->ri_RangeTableIndex,
+														   hyper_rel,
+														   chunk_rel);
+
+			entry->translated = true;
+			MemoryContextSwitchTo(old_mcxt);
+		}
+
 		/* create the tuple slot for the UPDATE SET projection */
 		onconfl->oc_ProjSlot = table_slot_create(chunk_rel, NULL);
 		state->conflproj_slot = onconfl->oc_ProjSlot;
@@ -387,36 +625,23 @@ setup_on_conflict_state(ChunkInsertState *state, ChunkDispatch *dispatch,
 		/* build UPDATE SET projection state */
 #if PG14_LT
 		ExprContext *econtext = hyper_rri->ri_onConflict->oc_ProjInfo->pi_exprContext;
-		onconfl->oc_ProjInfo = ExecBuildProjectionInfo(onconflset,
+		onconfl->oc_ProjInfo = ExecBuildProjectionInfo(entry->onconflict_set,
 													   econtext,
 													   state->conflproj_slot,
 													   NULL,
 													   RelationGetDescr(chunk_rel));
 #else
-		onconfl->oc_ProjInfo = ExecBuildUpdateProjection(onconflset,
+		onconfl->oc_ProjInfo = ExecBuildUpdateProjection(entry->onconflict_set,
 														 true,
-														 onconflcols,
+														 entry->onconflict_cols,
 														 RelationGetDescr(chunk_rel),
 														 mtstate->ps.ps_ExprContext,
 														 onconfl->oc_ProjSlot,
 														 &mtstate->ps);
 #endif
 
-		Node *onconflict_where = mt->onConflictWhere;
-
-		/*
-		 * Map attribute numbers in the WHERE clause, if it exists.
-		 */
-		if (onconflict_where && chunk_map)
-		{
-			List *clause = translate_clause(castNode(List, onconflict_where),
-											chunk_map,
-											hyper_rri->ri_RangeTableIndex,
-											hyper_rel,
-											chunk_rel);
-
-			chunk_rri->ri_onConflict->oc_WhereClause = ExecInitQual(clause, NULL);
-		}
+		if (entry->onconflict_where != NIL)
+			chunk_rri->ri_onConflict->oc_WhereClause = ExecInitQual(entry->onconflict_where, NULL);
 	}
 }
 
@@ -435,48 +660,65 @@ destroy_on_conflict_state(ChunkInsertState *state)
 		ExecDropSingleTupleTableSlot(state->conflproj_slot);
 }
 
-/* Translate hypertable indexes to chunk indexes in the arbiter clause */
+/*
+ * Translate hypertable indexes to chunk indexes in the arbiter clause. The
+ * chunk indexes are looked up once per statement, see OnConflictCacheEntry.
+ */
 static void
 set_arbiter_indexes(ChunkInsertState *state, ChunkDispatch *dispatch)
 {
-	List *arbiter_indexes = ts_chunk_dispatch_get_arbiter_indexes(dispatch);
-	ListCell *lc;
+	OnConflictCacheEntry *entry =
+		on_conflict_cache_get_entry(dispatch, RelationGetRelid(state->rel));
 
-	state->arbiter_indexes = NIL;
-
-	foreach (lc, arbiter_indexes)
+	if (!entry->arbiters_valid)
 	{
-		Oid hypertable_index = lfirst_oid(lc);
-		Chunk *chunk = ts_chunk_get_by_relid(RelationGetRelid(state->rel), true);
-		ChunkIndexMapping cim;
+		List *arbiter_indexes = ts_chunk_dispatch_get_arbiter_indexes(dispatch);
+		Chunk *chunk = NULL;
+		ListCell *lc;
+
+		if (arbiter_indexes != NIL)
+			chunk = ts_chunk_get_by_relid(RelationGetRelid(state->rel), true);
 
-		if (ts_chunk_index_get_by_hypertable_indexrelid(chunk, hypertable_index, &cim) < 1)
+		foreach (lc, arbiter_indexes)
 		{
-			/*
-			 * In case of distributed hypertables, we don't have information about the
-			 * arbiter index on the remote side, so error out with a helpful hint
-			 */
-			ereport(ERROR,
-					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-					 errmsg("could not find arbiter index for hypertable index \"%s\" on chunk "
-							"\"%s\"",
-							get_rel_name(hypertable_index),
-							get_rel_name(RelationGetRelid(state->rel))),
-					 hypertable_is_distributed(dispatch->hypertable) ?
-						 errhint(
-							 "Omit the index inference specification for the distributed hypertable"
-							 " in the ON CONFLICT clause.") :
-						 0));
+			Oid hypertable_index = lfirst_oid(lc);
+			ChunkIndexMapping cim;
+			MemoryContext old_mcxt;
+
+			if (ts_chunk_index_get_by_hypertable_indexrelid(chunk, hypertable_index, &cim) < 1)
+			{
+				/*
+				 * In case of distributed hypertables, we don't have information about the
+				 * arbiter index on the remote side, so error out with a helpful hint
+				 */
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("could not find arbiter index for hypertable index \"%s\" on "
+								"chunk \"%s\"",
+								get_rel_name(hypertable_index),
+								get_rel_name(RelationGetRelid(state->rel))),
+						 hypertable_is_distributed(dispatch->hypertable) ?
+							 errhint("Omit the index inference specification for the "
+									 "distributed hypertable in the ON CONFLICT clause.") :
+							 0));
+			}
+
+			old_mcxt = MemoryContextSwitchTo(dispatch->estate->es_query_cxt);
+			entry->arbiter_indexes = lappend_oid(entry->arbiter_indexes, cim.indexoid);
+			MemoryContextSwitchTo(old_mcxt);
 		}
 
-		state->arbiter_indexes = lappend_oid(state->arbiter_indexes, cim.indexoid);
+		entry->arbiters_valid = true;
 	}
+
+	state->arbiter_indexes = entry->arbiter_indexes;
 	state->result_relation_info->ri_onConflictArbiterIndexes = state->arbiter_indexes;
 }
 
 /* Change the projections to work with chunks instead of hypertables */
 static void
-adjust_projections(ChunkInsertState *cis, ChunkDispatch *dispatch, Oid rowtype)
+adjust_projections(ChunkInsertState *cis, ChunkDispatch *dispatch, ChunkLayout *layout,
+				   Oid rowtype)
 {
 	ResultRelInfo *chunk_rri = cis->result_relation_info;
 	Relation hyper_rel = dispatch->hypertable_result_rel_info->ri_RelationDesc;
@@ -484,17 +726,19 @@ adjust_projections(ChunkInsertState *cis, ChunkDispatch *dispatch, Oid rowtype)
 	TupleConversionMap *chunk_map = NULL;
 	OnConflictAction onconflict_action = ts_chunk_dispatch_get_on_conflict_action(dispatch);
 
+	/*
+	 * We need the opposite map from cis->hyper_to_chunk_map for RETURNING and
+	 * for ON CONFLICT DO UPDATE on chunks with a different layout. The map
+	 * needs to have the hypertable_desc in the out spot for
+	 * map_variable_attnos to work correctly in mapping hypertable
+	 * attnos->chunk attnos.
+	 */
+	if (ts_chunk_dispatch_has_returning(dispatch) ||
+		(onconflict_action == ONCONFLICT_UPDATE && cis->hyper_to_chunk_map != NULL))
+		chunk_map = chunk_layout_get_chunk_to_hyper_map(dispatch, layout, hyper_rel, chunk_rel);
+
 	if (ts_chunk_dispatch_has_returning(dispatch))
 	{
-		/*
-		 * We need the opposite map from cis->hyper_to_chunk_map. The map needs
-		 * to have the hypertable_desc in the out spot for map_variable_attnos
-		 * to work correctly in mapping hypertable attnos->chunk attnos.
-		 */
-		chunk_map = convert_tuples_by_name_compat(RelationGetDescr(chunk_rel),
-												  RelationGetDescr(hyper_rel),
-												  gettext_noop("could not convert row type"));
-
 		chunk_rri->ri_projectReturning =
 			get_adjusted_projection_info_returning(chunk_rri->ri_projectReturning,
 												   ts_chunk_dispatch_get_returning_clauses(
@@ -516,6 +760,340 @@ adjust_projections(ChunkInsertState *cis, ChunkDispatch *dispatch, Oid rowtype)
 	}
 }
 
+/* Insert the index entries of a row inserted into the chunk outside of the executor */
+static void
+chunk_insert_state_insert_index_tuples(ChunkInsertState *state, TupleTableSlot *slot)
+{
+	ResultRelInfo *rri = state->result_relation_info;
+
+	if (rri->ri_NumIndices > 0)
+	{
+#if PG14_LT
+		ResultRelInfo *saved_rri = state->estate->es_result_relation_info;
+
+		state->estate->es_result_relation_info = rri;
+#endif
+		list_free(
+			ExecInsertIndexTuplesCompat(rri, slot, state->estate, false, false, NULL, NIL));
+#if PG14_LT
+		state->estate->es_result_relation_info = saved_rri;
+#endif
+	}
+}
+
+/*
+ * Insert a buffered row of a compressed chunk that didn't fill a batch into
+ * the uncompressed chunk.
+ */
+static void
+chunk_insert_state_insert_buffered_row(TupleTableSlot *slot, void *data)
+{
+	ChunkInsertState *state = data;
+
+	table_tuple_insert(state->rel,
+					   slot,
+					   GetCurrentCommandId(true),
+					   state->insert_options,
+					   state->insert_bistate);
+	chunk_insert_state_insert_index_tuples(state, slot);
+}
+
+/*
+ * The rows of INSERTs are buffered per chunk and inserted with
+ * table_multi_insert() like COPY does, when nothing needs to see the rows as
+ * they are inserted. The buffers of all the chunks are flushed when the
+ * dispatch has MAX_MULTI_INSERT_TUPLES rows buffered and when the INSERT
+ * ends.
+ */
+#define MAX_MULTI_INSERT_TUPLES 1000
+
+void
+ts_chunk_insert_state_multi_insert_store(ChunkInsertState *state, TupleTableSlot *slot)
+{
+	ChunkDispatch *dispatch = state->dispatch;
+	MemoryContext old_mcxt = MemoryContextSwitchTo(state->mctx);
+
+	if (state->multi_insert_slots == NULL)
+	{
+		state->multi_insert_slots = palloc0(sizeof(TupleTableSlot *) * MAX_MULTI_INSERT_TUPLES);
+		state->multi_insert_bistate = GetBulkInsertState();
+		/* Like in COPY, don't reference count the tuple descriptor of the slots */
+		state->multi_insert_tupdesc = CreateTupleDescCopyConstr(RelationGetDescr(state->rel));
+	}
+
+	if (state->multi_insert_slots[state->multi_insert_nused] == NULL)
+		state->multi_insert_slots[state->multi_insert_nused] =
+			MakeSingleTupleTableSlot(state->multi_insert_tupdesc,
+									 table_slot_callbacks(state->rel));
+	MemoryContextSwitchTo(old_mcxt);
+
+	if (state->multi_insert_nused == 0)
+	{
+		old_mcxt = MemoryContextSwitchTo(state->estate->es_query_cxt);
+		dispatch->multi_insert_states = lappend(dispatch->multi_insert_states, state);
+		MemoryContextSwitchTo(old_mcxt);
+	}
+
+	ExecCopySlot(state->multi_insert_slots[state->multi_insert_nused], slot);
+	state->multi_insert_nused++;
+	dispatch->multi_insert_buffered++;
+
+	if (state->multi_insert_nused == MAX_MULTI_INSERT_TUPLES ||
+		dispatch->multi_insert_buffered >= MAX_MULTI_INSERT_TUPLES)
+		ts_chunk_dispatch_multi_insert_flush(dispatch);
+}
+
+/*
+ * Insert the buffered rows into the chunk. The caller removes the chunk
+ * insert state from the buffered states of the dispatch.
+ */
+void
+ts_chunk_insert_state_multi_insert_flush(ChunkInsertState *state)
+{
+	MemoryContext old_mcxt;
+	int nused = state->multi_insert_nused;
+
+	if (nused == 0)
+		return;
+
+	/* table_multi_insert() may leak memory */
+	old_mcxt = MemoryContextSwitchTo(GetPerTupleMemoryContext(state->estate));
+	table_multi_insert(state->rel,
+					   state->multi_insert_slots,
+					   nused,
+					   GetCurrentCommandId(true),
+					   state->insert_options,
+					   state->multi_insert_bistate);
+	MemoryContextSwitchTo(old_mcxt);
+
+	for (int i = 0; i < nused; i++)
+	{
+		chunk_insert_state_insert_index_tuples(state, state->multi_insert_slots[i]);
+		ExecClearTuple(state->multi_insert_slots[i]);
+	}
+
+	state->multi_insert_nused = 0;
+	state->dispatch->multi_insert_buffered -= nused;
+}
+
+/*
+ * Collect a row inserted into the chunk for the last point cache of the
+ * hypertable. The slot has the chunk's rowtype.
+ */
+void
+ts_chunk_insert_state_last_point_store(ChunkInsertState *state, TupleTableSlot *slot)
+{
+	if (state->last_point_attmap != NULL)
+		ts_last_point_state_store(state->dispatch->last_point, slot, state->last_point_attmap);
+}
+
+/*
+ * Check if the statement can insert more than one row. A Result node without
+ * an input, like the plan of an INSERT of a single VALUES row, returns at
+ * most one row. COPY has no dispatch state and inserts any number of rows.
+ */
+static bool
+chunk_dispatch_is_multi_row(const ChunkDispatch *dispatch)
+{
+	const Plan *subplan;
+
+	if (dispatch->dispatch_state == NULL)
+		return true;
+
+	subplan = dispatch->dispatch_state->subplan;
+	return !(IsA(subplan, Result) && outerPlan(subplan) == NULL);
+}
+
+/*
+ * Find the continuous aggregate invalidation trigger of the chunk if the
+ * chunk insert state can take it over, see below. Returns the index of the
+ * trigger in the trigger descriptor, or -1 if it can't be taken over.
+ *
+ * This is only done when nothing else can see or change the rows between
+ * the dispatch and the insert: a BEFORE ROW trigger could change the time
+ * value, and ON CONFLICT DO UPDATE fires the UPDATE triggers of the chunk.
+ */
+static int
+chunk_insert_state_find_cagg_trigger(const TriggerDesc *tg, const Chunk *chunk,
+									 const ChunkDispatch *dispatch,
+									 OnConflictAction onconflict_action)
+{
+	const Dimension *dim = hyperspace_get_open_dimension(dispatch->hypertable->space, 0);
+	int i;
+
+	if (!ts_guc_enable_cagg_invalidation_tracking || tg == NULL ||
+		chunk->relkind != RELKIND_RELATION || onconflict_action == ONCONFLICT_UPDATE ||
+		tg->trig_insert_before_row || SessionReplicationRole == SESSION_REPLICATION_ROLE_REPLICA ||
+		dim == NULL || dim->partitioning != NULL)
+		return -1;
+
+	for (i = 0; i < tg->numtriggers; i++)
+	{
+		const Trigger *trigger = &tg->triggers[i];
+
+		if (strcmp(trigger->tgname, CAGGINVAL_TRIGGER_NAME) != 0)
+			continue;
+
+		if (trigger->tgenabled != TRIGGER_FIRES_ON_ORIGIN || trigger->tgnargs < 1)
+			return -1;
+
+		return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Take over the continuous aggregate invalidation trigger of the chunk, so
+ * that the range of inserted time values is tracked by the chunk insert state
+ * instead of by calling the trigger for every row.
+ */
+static void
+chunk_insert_state_take_over_cagg_trigger(ChunkInsertState *state, const Chunk *chunk,
+										  ChunkDispatch *dispatch,
+										  OnConflictAction onconflict_action)
+{
+	ResultRelInfo *relinfo = state->result_relation_info;
+	TriggerDesc *tg = relinfo->ri_TrigDesc;
+	const Hyperspace *hs = dispatch->hypertable->space;
+	const Dimension *dim = hyperspace_get_open_dimension(hs, 0);
+	Trigger *trigger;
+	int i;
+
+	state->cagg_inval_dim = -1;
+
+	i = chunk_insert_state_find_cagg_trigger(tg, chunk, dispatch, onconflict_action);
+	if (i < 0)
+		return;
+
+	trigger = &tg->triggers[i];
+
+	/* Same arguments as continuous_agg_trigfn() */
+	state->cagg_hypertable_id = atol(trigger->tgargs[0]);
+	state->cagg_is_distributed = trigger->tgnargs > 1;
+	state->cagg_parent_hypertable_id =
+		state->cagg_is_distributed ? atol(trigger->tgargs[1]) : state->cagg_hypertable_id;
+	state->cagg_inval_dim = dim - hs->dimensions;
+
+	if (tg->numtriggers == 1)
+	{
+		relinfo->ri_TrigDesc = NULL;
+		return;
+	}
+
+	/* The trigger descriptor is a copy owned by the result relation info */
+	tg->numtriggers--;
+	memmove(trigger, trigger + 1, sizeof(Trigger) * (tg->numtriggers - i));
+
+	tg->trig_insert_after_row = false;
+	tg->trig_update_after_row = false;
+	tg->trig_delete_after_row = false;
+
+	for (i = 0; i < tg->numtriggers; i++)
+	{
+		int16 tgtype = tg->triggers[i].tgtype;
+
+		tg->trig_insert_after_row |=
+			TRIGGER_TYPE_MATCHES(tgtype, TRIGGER_TYPE_ROW, TRIGGER_TYPE_AFTER, TRIGGER_TYPE_INSERT);
+		tg->trig_update_after_row |=
+			TRIGGER_TYPE_MATCHES(tgtype, TRIGGER_TYPE_ROW, TRIGGER_TYPE_AFTER, TRIGGER_TYPE_UPDATE);
+		tg->trig_delete_after_row |=
+			TRIGGER_TYPE_MATCHES(tgtype, TRIGGER_TYPE_ROW, TRIGGER_TYPE_AFTER, TRIGGER_TYPE_DELETE);
+	}
+}
+
+/*
+ * Check if the rows inserted into a compressed chunk can be buffered and
+ * compressed directly into new batches. Nothing may need to see the rows in
+ * the chunk as they are inserted, so the chunk can't have unique indexes or
+ * row triggers, except for the continuous aggregate invalidation trigger when
+ * the chunk insert state takes it over. Before PG14 the INSERTs are done by
+ * the PostgreSQL executor, so only COPY can buffer them.
+ *
+ * This also decides if a chunk created by an insert is compressed right
+ * away, see timescaledb.enable_direct_compression, so that the rows of such
+ * a chunk are always buffered.
+ */
+bool
+ts_chunk_insert_state_can_buffer_compressed(const ChunkDispatch *dispatch, const Chunk *chunk,
+											Relation rel)
+{
+	const TriggerDesc *tg = rel->trigdesc;
+
+	if (!(ts_guc_enable_compressed_insert_buffering || ts_guc_enable_direct_compression) ||
+		chunk->relkind != RELKIND_RELATION || (PG14_LT && dispatch->dispatch_state != NULL) ||
+		ts_cm_functions->compress_row_init == NULL)
+		return false;
+
+	if (tg != NULL)
+	{
+		OnConflictAction onconflict_action = ts_chunk_dispatch_get_on_conflict_action(dispatch);
+
+		if (tg->numtriggers > 1 ||
+			chunk_insert_state_find_cagg_trigger(tg, chunk, dispatch, onconflict_action) < 0)
+			return false;
+	}
+
+	return !ts_indexing_relation_has_primary_or_unique_index(rel);
+}
+
+/*
+ * Track the time value of a point dispatched to the chunk for continuous
+ * aggregate invalidation. The range is added to the invalidations of the
+ * transaction when the chunk insert state is destroyed.
+ */
+void
+ts_chunk_insert_state_track_invalidation(ChunkInsertState *state, const Point *point)
+{
+	int64 value;
+
+	if (state->cagg_inval_dim < 0)
+		return;
+
+	value = point->coordinates[state->cagg_inval_dim];
+
+	if (!state->cagg_inval_set)
+	{
+		state->cagg_inval_lowest = value;
+		state->cagg_inval_greatest = value;
+		state->cagg_inval_set = true;
+	}
+	else if (value < state->cagg_inval_lowest)
+		state->cagg_inval_lowest = value;
+	else if (value > state->cagg_inval_greatest)
+		state->cagg_inval_greatest = value;
+}
+
+void
+ts_chunk_insert_state_track_adaptive_stats(ChunkInsertState *state, const Point *point)
+{
+	int64 value;
+
+	if (state->adaptive_dim < 0)
+		return;
+
+	value = point->coordinates[state->adaptive_dim];
+
+	if (state->adaptive_set && value >= state->adaptive_lowest &&
+		value <= state->adaptive_greatest)
+		return;
+
+	/* Publish the extended range right away, since the next chunk interval
+	 * can be calculated while this insert state is still open */
+	ts_chunk_adaptive_stats_add(RelationGetRelid(state->rel), value, value);
+
+	if (!state->adaptive_set)
+	{
+		state->adaptive_lowest = value;
+		state->adaptive_greatest = value;
+		state->adaptive_set = true;
+	}
+	else if (value < state->adaptive_lowest)
+		state->adaptive_lowest = value;
+	else
+		state->adaptive_greatest = value;
+}
+
 /*
  * Create new insert chunk state.
  *
@@ -527,12 +1105,17 @@ ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch)
 {
 	ChunkInsertState *state;
 	Relation rel, parent_rel;
+	ChunkLayout *layout;
 	MemoryContext cis_context = AllocSetContextCreate(dispatch->estate->es_query_cxt,
 													  "chunk insert state memory context",
 													  ALLOCSET_DEFAULT_SIZES);
 	OnConflictAction onconflict_action = ts_chunk_dispatch_get_on_conflict_action(dispatch);
 	ResultRelInfo *relinfo;
 	bool has_compressed_chunk = (chunk->fd.compressed_chunk_id != 0);
+	/* rows can be checked against the compressed rows on unique indexes */
+	bool can_decompress_for_insert = ts_guc_enable_dml_decompression &&
+									 ts_cm_functions->decompress_batches_for_insert != NULL;
+	bool decompress_for_insert = false;
 
 	/* permissions NOT checked here; were checked at hypertable level */
 	if (check_enable_rls(chunk->table_id, InvalidOid, false) == RLS_ENABLED)
@@ -546,7 +1129,8 @@ ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch)
 												 CHUNK_INSERT,
 												 true);
 	if (has_compressed_chunk &&
-		(onconflict_action != ONCONFLICT_NONE || ts_chunk_dispatch_has_returning(dispatch)))
+		((onconflict_action != ONCONFLICT_NONE && !can_decompress_for_insert) ||
+		 ts_chunk_dispatch_has_returning(dispatch)))
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("insert with ON CONFLICT or RETURNING clause is not supported on "
@@ -554,6 +1138,9 @@ ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch)
 
 	rel = table_open(chunk->table_id, RowExclusiveLock);
 	if (has_compressed_chunk && ts_indexing_relation_has_primary_or_unique_index(rel))
+		decompress_for_insert = true;
+
+	if (decompress_for_insert && !can_decompress_for_insert)
 	{
 		table_close(rel, RowExclusiveLock);
 		ereport(ERROR,
@@ -571,7 +1158,24 @@ ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch)
 	state->rel = rel;
 	state->result_relation_info = relinfo;
 	state->estate = dispatch->estate;
+	state->dispatch = dispatch;
 
+	/*
+	 * Chunks are mostly appended to, so with append-only inserts the rows go
+	 * to the end of the chunk without searching the free space map for room
+	 * left by deleted rows. When the statement inserts several rows, the bulk
+	 * insert state keeps the last page pinned so that the next rows go to the
+	 * same page without looking it up again. A single row has no next row, so
+	 * it would only pay for setting up the state and its buffer ring.
+	 */
+	if (ts_guc_enable_append_only_inserts && chunk->relkind == RELKIND_RELATION)
+	{
+		state->insert_options = TABLE_INSERT_SKIP_FSM;
+		if (chunk_dispatch_is_multi_row(dispatch))
+			state->insert_bistate = GetBulkInsertState();
+	}
+
+	state->decompress_for_insert = decompress_for_insert;
 	state->chunk_compressed = ts_chunk_is_compressed(chunk);
 	if (state->chunk_compressed)
 		state->chunk_partial = ts_chunk_is_partial(chunk);
@@ -579,6 +1183,19 @@ ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch)
 	if (relinfo->ri_RelationDesc->rd_rel->relhasindex && relinfo->ri_IndexRelationDescs == NULL)
 		ExecOpenIndices(relinfo, onconflict_action != ONCONFLICT_NONE);
 
+	chunk_insert_state_take_over_cagg_trigger(state, chunk, dispatch, onconflict_action);
+
+	state->adaptive_dim = -1;
+	if (ts_guc_enable_adaptive_chunking_insert_stats && chunk->relkind == RELKIND_RELATION &&
+		hypertable_adaptive_chunking_enabled(dispatch->hypertable))
+	{
+		const Hyperspace *hs = dispatch->hypertable->space;
+		const Dimension *dim = hyperspace_get_open_dimension(hs, 0);
+
+		if (dim != NULL && dim->partitioning == NULL)
+			state->adaptive_dim = dim - hs->dimensions;
+	}
+
 	if (relinfo->ri_TrigDesc != NULL)
 	{
 		TriggerDesc *tg = relinfo->ri_TrigDesc;
@@ -599,18 +1216,55 @@ ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch)
 			elog(ERROR, "statement trigger on chunk table not supported");
 	}
 
+	/*
+	 * The rows of the chunks compressed on creation are all compressed into
+	 * batches, the others only when they fill a batch.
+	 */
+	if (state->chunk_compressed && !state->decompress_for_insert &&
+		ts_chunk_insert_state_can_buffer_compressed(dispatch, chunk, rel))
+	{
+		Chunk *compressed_chunk = ts_chunk_get_by_id(chunk->fd.compressed_chunk_id, true);
+		bool compress_partial_batches =
+			list_member_int(dispatch->direct_compressed_chunks, chunk->fd.id);
+
+		state->compress_rel = table_open(compressed_chunk->table_id, RowExclusiveLock);
+		state->compress_state =
+			ts_cm_functions->compress_row_init(chunk->fd.hypertable_id,
+											   rel,
+											   state->compress_rel,
+											   compress_partial_batches,
+											   chunk_insert_state_insert_buffered_row,
+											   state);
+		if (state->compress_state == NULL)
+		{
+			table_close(state->compress_rel, RowExclusiveLock);
+			state->compress_rel = NULL;
+		}
+		else
+		{
+			state->compress_partial_batches = compress_partial_batches;
+
+			/*
+			 * The batches compressed here do not go through the uncompressed
+			 * chunk, so a recompression could not widen the column ranges of
+			 * the chunk with them. Remove the ranges instead.
+			 */
+			ts_chunk_column_stats_delete_by_chunk_id(chunk->fd.hypertable_id, chunk->fd.id);
+		}
+	}
+
 	parent_rel = table_open(dispatch->hypertable->main_table_relid, AccessShareLock);
+	layout = chunk_layout_get(dispatch, parent_rel, rel);
 
 	/* Set tuple conversion map, if tuple needs conversion. We don't want to
 	 * convert tuples going into foreign tables since these are actually sent to
 	 * data nodes for insert on that node's local hypertable. */
 	if (chunk->relkind != RELKIND_FOREIGN_TABLE)
-		state->hyper_to_chunk_map =
-			convert_tuples_by_name_compat(RelationGetDescr(parent_rel),
-										  RelationGetDescr(rel),
-										  gettext_noop("could not convert row type"));
+		state->hyper_to_chunk_map = chunk_conversion_map_create(layout->hyper_to_chunk_map,
+																RelationGetDescr(parent_rel),
+																RelationGetDescr(rel));
 
-	adjust_projections(state, dispatch, RelationGetForm(rel)->reltype);
+	adjust_projections(state, dispatch, layout, RelationGetForm(rel)->reltype);
 
 	/* Need a tuple table slot to store tuples going into this chunk. We don't
 	 * want this slot tied to the executor's tuple table, since that would tie
@@ -624,6 +1278,10 @@ ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch)
 	table_close(parent_rel, AccessShareLock);
 
 	state->chunk_id = chunk->fd.id;
+	state->cube = ts_hypercube_copy(chunk->cube);
+
+	if (dispatch->last_point != NULL)
+		state->last_point_attmap = ts_last_point_state_get_attmap(dispatch->last_point, rel);
 
 	if (chunk->relkind == RELKIND_FOREIGN_TABLE)
 	{
@@ -686,7 +1344,41 @@ ts_chunk_insert_state_destroy(ChunkInsertState *state)
 {
 	ResultRelInfo *rri = state->result_relation_info;
 
-	if (state->chunk_compressed && !state->chunk_partial)
+	if (state->compress_state != NULL)
+	{
+		ts_cm_functions->compress_row_end(state->compress_state);
+		ts_cm_functions->compress_row_destroy(state->compress_state);
+		table_close(state->compress_rel, NoLock);
+	}
+
+	if (state->multi_insert_slots != NULL)
+	{
+		if (state->multi_insert_nused > 0)
+		{
+			ts_chunk_insert_state_multi_insert_flush(state);
+			state->dispatch->multi_insert_states =
+				list_delete_ptr(state->dispatch->multi_insert_states, state);
+		}
+
+		for (int i = 0; i < MAX_MULTI_INSERT_TUPLES && state->multi_insert_slots[i] != NULL; i++)
+			ExecDropSingleTupleTableSlot(state->multi_insert_slots[i]);
+		FreeBulkInsertState(state->multi_insert_bistate);
+		table_finish_bulk_insert(state->rel, state->insert_options);
+	}
+
+	if (state->insert_bistate != NULL)
+		FreeBulkInsertState(state->insert_bistate);
+
+	if (state->cagg_inval_set)
+		ts_cm_functions->continuous_agg_add_invalidation_range(state->cagg_hypertable_id,
+															   state->cagg_is_distributed,
+															   state->cagg_parent_hypertable_id,
+															   RelationGetRelid(state->rel),
+															   state->cagg_inval_lowest,
+															   state->cagg_inval_greatest);
+
+	/* No rows went into the uncompressed chunk if they were all compressed */
+	if (state->chunk_compressed && !state->chunk_partial && !state->compress_partial_batches)
 	{
 		Oid chunk_relid = RelationGetRelid(state->result_relation_info->ri_RelationDesc);
 		Chunk *chunk = ts_chunk_get_by_relid(chunk_relid, true);
@@ -9,6 +9,7 @@
 #include <nodes/execnodes.h>
 #include <postgres.h>
 #include <funcapi.h>
+#include <access/heapam.h>
 #include <access/tupconvert.h>
 
 #include "chunk.h"
@@ -16,6 +17,7 @@
 #include "cross_module_fn.h"
 
 typedef struct TSCopyMultiInsertBuffer TSCopyMultiInsertBuffer;
+typedef struct ChunkDispatch ChunkDispatch;
 
 typedef struct ChunkInsertState
 {
@@ -55,16 +57,77 @@ typedef struct ChunkInsertState
 	EState *estate;
 	List *chunk_data_nodes; /* List of data nodes for the chunk (ChunkDataNode objects) */
 	int32 chunk_id;
+	/* The chunk's hypercube, to check if a point falls into this chunk */
+	Hypercube *cube;
 	Oid user_id;
 
 	/* for tracking compressed chunks */
 	bool chunk_compressed;
 	bool chunk_partial;
-} ChunkInsertState;
 
-typedef struct ChunkDispatch ChunkDispatch;
+	/* Buffers the rows going into a compressed chunk to compress them into
+	 * new batches, see timescaledb.enable_compressed_insert_buffering */
+	CompressSingleRowState *compress_state;
+	Relation compress_rel;
+	/* All buffered rows are compressed, also those that don't fill a batch,
+	 * see timescaledb.enable_direct_compression */
+	bool compress_partial_batches;
+
+	/* Decompresses the compressed batches that could conflict with inserted
+	 * rows on a unique index, see timescaledb.enable_dml_decompression. The
+	 * state is owned by the TSL module. */
+	bool decompress_for_insert;
+	void *decompress_for_insert_state;
+
+	/* Buffers the rows of INSERTs to insert them in batches, see
+	 * timescaledb.enable_insert_batching */
+	ChunkDispatch *dispatch;
+	TupleDesc multi_insert_tupdesc;
+	TupleTableSlot **multi_insert_slots;
+	int multi_insert_nused;
+	BulkInsertState multi_insert_bistate;
+
+	/* The options and bulk insert state of the rows inserted one at a time,
+	 * see timescaledb.enable_append_only_inserts. There is no bulk insert
+	 * state for statements that insert a single row. */
+	int insert_options;
+	BulkInsertState insert_bistate;
+
+	/* Maps the columns of the last point cache to the chunk's, if the
+	 * hypertable has the cache */
+	AttrNumber *last_point_attmap;
+
+	/* Tracks the range of time values inserted into the chunk for continuous
+	 * aggregate invalidation in place of the invalidation trigger, see
+	 * timescaledb.enable_cagg_invalidation_tracking. The index of the open
+	 * dimension in the dispatched points is -1 when not tracking. */
+	int cagg_inval_dim;
+	int32 cagg_hypertable_id;
+	int32 cagg_parent_hypertable_id;
+	bool cagg_is_distributed;
+	bool cagg_inval_set;
+	int64 cagg_inval_lowest;
+	int64 cagg_inval_greatest;
+
+	/* Tracks the range of time values inserted into the chunk for adaptive
+	 * chunking, see timescaledb.enable_adaptive_chunking_insert_stats. The
+	 * index of the open dimension is -1 when not tracking. */
+	int adaptive_dim;
+	bool adaptive_set;
+	int64 adaptive_lowest;
+	int64 adaptive_greatest;
+} ChunkInsertState;
 
 extern ChunkInsertState *ts_chunk_insert_state_create(const Chunk *chunk, ChunkDispatch *dispatch);
 extern void ts_chunk_insert_state_destroy(ChunkInsertState *state);
+extern bool ts_chunk_insert_state_can_buffer_compressed(const ChunkDispatch *dispatch,
+														const Chunk *chunk, Relation rel);
+extern void ts_chunk_insert_state_multi_insert_store(ChunkInsertState *state,
+													 TupleTableSlot *slot);
+extern void ts_chunk_insert_state_multi_insert_flush(ChunkInsertState *state);
+extern void ts_chunk_insert_state_last_point_store(ChunkInsertState *state, TupleTableSlot *slot);
+extern void ts_chunk_insert_state_track_invalidation(ChunkInsertState *state, const Point *point);
+extern void ts_chunk_insert_state_track_adaptive_stats(ChunkInsertState *state,
+														const Point *point);
 
 #endif /* TIMESCALEDB_CHUNK_INSERT_STATE_H */
@@ -4,6 +4,9 @@
  * LICENSE-APACHE for a copy of the license.
  */
 #include <postgres.h>
+#include <access/tableam.h>
+#include <catalog/heap.h>
+#include <catalog/index.h>
 #include <catalog/pg_type.h>
 #include <executor/execPartition.h>
 #include <executor/nodeModifyTable.h>
@@ -16,20 +19,25 @@
 #include <optimizer/optimizer.h>
 #include <optimizer/plancat.h>
 #include <parser/parsetree.h>
+#include <pgstat.h>
 #include <storage/lmgr.h>
+#include <storage/predicate.h>
 #include <utils/builtins.h>
 #include <utils/lsyscache.h>
 #include <utils/rel.h>
 #include <utils/snapmgr.h>
 
 #include "compat/compat.h"
+#include "chunk.h"
 #include "chunk_dispatch_plan.h"
 #include "chunk_dispatch_state.h"
 #include "cross_module_fn.h"
 #include "guc.h"
 #include "hypertable_cache.h"
 #include "hypertable_modify.h"
+#include "last_point.h"
 #include "nodes/chunk_append/chunk_append.h"
+#include "planner/planner.h"
 #include "ts_catalog/hypertable_data_node.h"
 
 #if PG14_GE
@@ -43,8 +51,8 @@ static void ExecInitUpdateProjection(ModifyTableState *mtstate, ResultRelInfo *r
 static void ExecCheckPlanOutput(Relation resultRel, List *targetList);
 static TupleTableSlot *ExecGetInsertNewTuple(ResultRelInfo *relinfo, TupleTableSlot *planSlot);
 static TupleTableSlot *ExecInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo,
-								  TupleTableSlot *slot, TupleTableSlot *planSlot, EState *estate,
-								  bool canSetTag);
+								  ChunkInsertState *cis, TupleTableSlot *slot,
+								  TupleTableSlot *planSlot, EState *estate, bool canSetTag);
 static void ExecBatchInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo,
 							TupleTableSlot **slots, TupleTableSlot **planSlots, int numSlots,
 							EState *estate, bool canSetTag);
@@ -101,6 +109,113 @@ get_chunk_dispatch_states(PlanState *substate)
 	return NIL;
 }
 
+#if PG14_GE
+/*
+ * Remove the chunks that the ChunkAppend below an UPDATE or DELETE excludes
+ * during startup from the result relations of the ModifyTable, so that they
+ * are not opened and initialized. The plan is not modified, instead a copy
+ * with the remaining result relations is returned.
+ */
+static ModifyTable *
+hypertable_modify_startup_exclusion(ModifyTable *mt, EState *estate)
+{
+	Plan *subplan = outerPlan(mt);
+	Result *result = NULL;
+	CustomScan *cscan;
+	ModifyTable *filtered;
+	Bitmapset *excluded_relids = NULL;
+	bool keep_first = true;
+	ListCell *lc;
+	int i = 0;
+
+	/* UPDATE projects the new values of the columns in a Result node */
+	if (IsA(subplan, Result) && outerPlan(subplan) != NULL &&
+		ts_is_chunk_append_plan(outerPlan(subplan)))
+	{
+		result = castNode(Result, subplan);
+		subplan = outerPlan(subplan);
+	}
+
+	if (!ts_is_chunk_append_plan(subplan))
+		return mt;
+
+	cscan =
+		ts_chunk_append_startup_exclude(castNode(CustomScan, subplan), estate, &excluded_relids);
+
+	if (&cscan->scan.plan == subplan)
+		return mt;
+
+	filtered = makeNode(ModifyTable);
+	memcpy(filtered, mt, sizeof(ModifyTable));
+	filtered->resultRelations = NIL;
+	filtered->updateColnosLists = NIL;
+	filtered->withCheckOptionLists = NIL;
+	filtered->returningLists = NIL;
+	filtered->fdwPrivLists = NIL;
+	filtered->fdwDirectModifyPlans = NULL;
+#if PG15_GE
+	filtered->mergeActionLists = NIL;
+#endif
+
+	if (result != NULL)
+	{
+		Result *filtered_result = makeNode(Result);
+
+		memcpy(filtered_result, result, sizeof(Result));
+		outerPlan(filtered_result) = &cscan->scan.plan;
+		outerPlan(filtered) = &filtered_result->plan;
+	}
+	else
+		outerPlan(filtered) = &cscan->scan.plan;
+
+	/* ModifyTable needs a result relation even if all chunks are excluded */
+	foreach (lc, mt->resultRelations)
+	{
+		if (!bms_is_member(lfirst_int(lc), excluded_relids))
+		{
+			keep_first = false;
+			break;
+		}
+	}
+
+	foreach (lc, mt->resultRelations)
+	{
+		if (bms_is_member(lfirst_int(lc), excluded_relids) && !(keep_first && i == 0))
+		{
+			i++;
+			continue;
+		}
+
+		if (bms_is_member(i, mt->fdwDirectModifyPlans))
+			filtered->fdwDirectModifyPlans =
+				bms_add_member(filtered->fdwDirectModifyPlans,
+							   list_length(filtered->resultRelations));
+
+		filtered->resultRelations = lappend_int(filtered->resultRelations, lfirst_int(lc));
+
+		if (mt->updateColnosLists != NIL)
+			filtered->updateColnosLists =
+				lappend(filtered->updateColnosLists, list_nth(mt->updateColnosLists, i));
+		if (mt->withCheckOptionLists != NIL)
+			filtered->withCheckOptionLists =
+				lappend(filtered->withCheckOptionLists, list_nth(mt->withCheckOptionLists, i));
+		if (mt->returningLists != NIL)
+			filtered->returningLists =
+				lappend(filtered->returningLists, list_nth(mt->returningLists, i));
+		if (mt->fdwPrivLists != NIL)
+			filtered->fdwPrivLists = lappend(filtered->fdwPrivLists, list_nth(mt->fdwPrivLists, i));
+#if PG15_GE
+		if (mt->mergeActionLists != NIL)
+			filtered->mergeActionLists =
+				lappend(filtered->mergeActionLists, list_nth(mt->mergeActionLists, i));
+#endif
+		i++;
+	}
+
+	return filtered;
+}
+#endif
+
 /*
  * HypertableInsert (with corresponding executor node) is a plan node that
  * implements INSERTs for hypertables. It is mostly a wrapper around the
@@ -122,6 +237,19 @@ hypertable_modify_begin(CustomScanState *node, EState *estate, int eflags)
 	ListCell *lc;
 
 	ModifyTable *mt = castNode(ModifyTable, &state->mt->plan);
+
+#if PG14_GE
+	/*
+	 * Open only the chunks of an UPDATE or DELETE that are not excluded
+	 * during startup.
+	 */
+	if (mt->operation == CMD_DELETE || mt->operation == CMD_UPDATE)
+	{
+		mt = hypertable_modify_startup_exclusion(mt, estate);
+		state->mt = mt;
+	}
+#endif
+
 	/*
 	 * To make statement trigger defined on the hypertable work
 	 * we need to set the hypertable as the rootRelation otherwise
@@ -171,15 +299,153 @@ hypertable_modify_begin(CustomScanState *node, EState *estate, int eflags)
 	}
 }
 
+/*
+ * Rebuild the last point cache of the hypertable after an UPDATE or DELETE,
+ * since the changed rows could have been the newest of their key.
+ */
+static void
+hypertable_modify_refresh_last_point(HypertableModifyState *state, EState *estate)
+{
+	RangeTblEntry *rte = rt_fetch(state->mt->nominalRelation, estate->es_range_table);
+	Cache *hcache;
+	Hypertable *ht;
+
+	state->last_point_refreshed = true;
+
+	if (state->mt->operation != CMD_UPDATE && state->mt->operation != CMD_DELETE)
+		return;
+
+	ht = ts_hypertable_cache_get_cache_and_entry(rte->relid, CACHE_FLAG_MISSING_OK, &hcache);
+
+	if (ht != NULL && OidIsValid(ht->last_point_relid))
+		ts_last_point_cache_refresh(ht);
+
+	ts_cache_release(hcache);
+}
+
+#if PG14_GE
+/*
+ * Truncate a chunk that a DELETE removes all rows from and return the number
+ * of rows removed.
+ *
+ * The chunk was picked during planning, but transactions that committed after
+ * the statement snapshot was taken could have added or removed rows since. A
+ * row by row DELETE would not see those changes, so the chunk is only
+ * truncated if the rows visible now are the rows visible to the statement.
+ */
+static uint64
+hypertable_modify_truncate_chunk(Oid chunk_relid, EState *estate)
+{
+	Relation rel = try_relation_open(chunk_relid, AccessExclusiveLock);
+	Chunk *chunk;
+	Snapshot snapshot;
+	TableScanDesc scan;
+	TupleTableSlot *slot;
+	bool unchanged = true;
+	uint64 nrows = 0;
+	Oid toast_relid;
+	ReindexParams params = { 0 };
+
+	/* The chunk was dropped, so there is nothing left to delete */
+	if (rel == NULL)
+		return 0;
+
+	chunk = ts_chunk_get_by_relid(chunk_relid, false);
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = table_beginscan(rel, SnapshotAny, 0, NULL);
+	slot = table_slot_create(rel, NULL);
+
+	while (unchanged && table_scan_getnextslot(scan, ForwardScanDirection, slot))
+	{
+		bool visible = table_tuple_satisfies_snapshot(rel, slot, estate->es_snapshot);
+
+		CHECK_FOR_INTERRUPTS();
+
+		unchanged = visible == table_tuple_satisfies_snapshot(rel, slot, snapshot);
+
+		if (visible)
+			nrows++;
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+	table_endscan(scan);
+	UnregisterSnapshot(snapshot);
+
+	if (!unchanged || chunk == NULL || chunk->fd.compressed_chunk_id != INVALID_CHUNK_ID)
+		ereport(ERROR,
+				(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
+				 errmsg("could not truncate chunk \"%s\" due to concurrent update",
+						get_rel_name(chunk_relid)),
+				 errhint("Retry the DELETE or disable timescaledb.enable_delete_truncation.")));
+
+	/* Chunks should never have fks into them, but double check */
+	if (heap_truncate_find_FKs(list_make1_oid(chunk_relid)) != NIL)
+		elog(ERROR, "found a FK into a chunk while truncating");
+
+	CheckTableForSerializableConflictIn(rel);
+	RelationSetNewRelfilenode(rel, rel->rd_rel->relpersistence);
+	toast_relid = rel->rd_rel->reltoastrelid;
+
+	if (OidIsValid(toast_relid))
+	{
+		Relation toast_rel = table_open(toast_relid, AccessExclusiveLock);
+
+		RelationSetNewRelfilenode(toast_rel, toast_rel->rd_rel->relpersistence);
+		table_close(toast_rel, NoLock);
+	}
+
+	reindex_relation(chunk_relid, REINDEX_REL_PROCESS_TOAST, &params);
+	pgstat_count_truncate(rel);
+	table_close(rel, NoLock);
+	CommandCounterIncrement();
+
+	return nrows;
+}
+
+static void
+hypertable_modify_truncate_chunks(HypertableModifyState *state, ModifyTableState *mtstate)
+{
+	EState *estate = mtstate->ps.state;
+	uint64 nrows = 0;
+	ListCell *lc;
+
+	/* The statement triggers have to fire before any row is deleted */
+	if (mtstate->fireBSTriggers)
+	{
+		fireBSTriggers(mtstate);
+		mtstate->fireBSTriggers = false;
+	}
+
+	foreach (lc, state->truncated_chunk_oids)
+		nrows += hypertable_modify_truncate_chunk(lfirst_oid(lc), estate);
+
+	if (mtstate->canSetTag)
+		estate->es_processed += nrows;
+
+	state->chunks_truncated = true;
+}
+#endif
+
 static TupleTableSlot *
 hypertable_modify_exec(CustomScanState *node)
 {
+	HypertableModifyState *state = (HypertableModifyState *) node;
+	TupleTableSlot *slot;
 #if PG14_LT
-	return ExecProcNode(linitial(node->custom_ps));
+	slot = ExecProcNode(linitial(node->custom_ps));
 #else
 	ModifyTableState *mtstate = linitial_node(ModifyTableState, node->custom_ps);
-	return ExecModifyTable(&mtstate->ps);
+
+	if (state->truncated_chunk_oids != NIL && !state->chunks_truncated)
+		hypertable_modify_truncate_chunks(state, mtstate);
+
+	slot = ExecModifyTable(&mtstate->ps);
 #endif
+
+	if (TupIsNull(slot) && !state->last_point_refreshed)
+		hypertable_modify_refresh_last_point(state, node->ss.ps.state);
+
+	return slot;
 }
 
 static void
@@ -224,6 +490,12 @@ hypertable_modify_explain(CustomScanState *node, List *ancestors, ExplainState *
 	 * be missing so we set it to instrumentation of HypertableModify node.
 	 */
 	mtstate->ps.instrument = node->ss.ps.instrument;
+
+	if (state->truncated_chunk_oids != NIL)
+		ExplainPropertyInteger("Chunks truncated",
+							   NULL,
+							   list_length(state->truncated_chunk_oids),
+							   es);
 #endif
 
 	if (NULL != state->fdwroutine)
@@ -288,6 +560,7 @@ hypertable_modify_state_create(CustomScan *cscan)
 	 * Get the list of data nodes to insert on.
 	 */
 	state->serveroids = lsecond(cscan->custom_private);
+	state->truncated_chunk_oids = lthird(cscan->custom_private);
 
 	/*
 	 * Get the FDW routine for the first data node. It should be the same for
@@ -569,9 +842,11 @@ hypertable_modify_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *be
 	 * we still need the original list in case that plan
 	 * gets reused.
 	 *
-	 * We also pass on the data nodes to insert on.
+	 * We also pass on the data nodes to insert on and the chunks to
+	 * truncate.
 	 */
-	cscan->custom_private = list_make2(mt->arbiterIndexes, hmpath->serveroids);
+	cscan->custom_private =
+		list_make3(mt->arbiterIndexes, hmpath->serveroids, hmpath->truncated_chunk_oids);
 
 	return &cscan->scan.plan;
 }
@@ -641,6 +916,13 @@ ts_hypertable_modify_path_create(PlannerInfo *root, ModifyTablePath *mtpath, Hyp
 	hmpath->cpath.methods = &hypertable_modify_path_methods;
 	hmpath->distributed_insert_plans = distributed_insert_plans;
 	hmpath->serveroids = ts_hypertable_get_available_data_node_server_oids(ht);
+#if PG14_GE
+	/* The planner records the chunks a DELETE can truncate on the hypertable */
+	if (mtpath->operation == CMD_DELETE && root->simple_rel_array[rti] != NULL &&
+		root->simple_rel_array[rti]->fdw_private != NULL)
+		hmpath->truncated_chunk_oids =
+			ts_get_private_reloptinfo(root->simple_rel_array[rti])->truncated_chunk_oids;
+#endif
 	path = &hmpath->cpath.path;
 #if PG14_LT
 	mtpath->subpaths = list_make1(subpath);
@@ -888,7 +1170,13 @@ ExecModifyTable(PlanState *pstate)
 				if (unlikely(!resultRelInfo->ri_projectNewInfoValid))
 					ExecInitInsertProjection(node, resultRelInfo);
 				slot = ExecGetInsertNewTuple(resultRelInfo, planSlot);
-				slot = ExecInsert(node, cds->rri, slot, planSlot, estate, node->canSetTag);
+				slot = ExecInsert(node,
+								  cds->rri,
+								  cds->dispatch->prev_cis,
+								  slot,
+								  planSlot,
+								  estate,
+								  node->canSetTag);
 				break;
 			case CMD_UPDATE:
 				/* Initialize projection info if first time for this table */
@@ -957,6 +1245,9 @@ ExecModifyTable(PlanState *pstate)
 	/*
 	 * Insert remaining tuples for batch insert.
 	 */
+	if (cds != NULL)
+		ts_chunk_dispatch_multi_insert_flush(cds->dispatch);
+
 	relinfos = estate->es_opened_result_relations;
 
 	foreach (lc, relinfos)
@@ -1323,6 +1614,22 @@ ExecGetInsertNewTuple(ResultRelInfo *relinfo, TupleTableSlot *planSlot)
 	return ExecProject(newProj);
 }
 
+/*
+ * The rows can be buffered and inserted in batches when nothing needs to see
+ * them in the chunk as they are inserted: no row triggers, no RETURNING, no
+ * WITH CHECK OPTIONs and no ON CONFLICT.
+ */
+static bool
+can_use_multi_insert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo)
+{
+	ModifyTable *node = (ModifyTable *) mtstate->ps.plan;
+
+	return ts_guc_enable_insert_batching && mtstate->operation == CMD_INSERT &&
+		   node->onConflictAction == ONCONFLICT_NONE && resultRelInfo->ri_TrigDesc == NULL &&
+		   resultRelInfo->ri_projectReturning == NULL &&
+		   resultRelInfo->ri_WithCheckOptions == NIL && mtstate->mt_transition_capture == NULL;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInsert
  *
@@ -1344,8 +1651,8 @@ ExecGetInsertNewTuple(ResultRelInfo *relinfo, TupleTableSlot *planSlot)
  * copied and modified version of ExecInsert from executor/nodeModifyTable.c
  */
 static TupleTableSlot *
-ExecInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo, TupleTableSlot *slot,
-		   TupleTableSlot *planSlot, EState *estate, bool canSetTag)
+ExecInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo, ChunkInsertState *cis,
+		   TupleTableSlot *slot, TupleTableSlot *planSlot, EState *estate, bool canSetTag)
 {
 	Relation resultRelationDesc;
 	List *recheckIndexes = NIL;
@@ -1578,7 +1885,9 @@ ExecInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo, TupleTableSl
 					 * tuple.
 					 */
 					TupleTableSlot *returning = NULL;
+					TupleTableSlot *updated = resultRelInfo->ri_onConflict->oc_ProjSlot;
 
+					ExecClearTuple(updated);
 					if (ExecOnConflictUpdate(mtstate,
 											 resultRelInfo,
 											 &conflictTid,
@@ -1588,6 +1897,9 @@ ExecInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo, TupleTableSl
 											 canSetTag,
 											 &returning))
 					{
+						/* the slot is empty when the WHERE clause skipped the update */
+						if (cis != NULL && !TupIsNull(updated))
+							ts_chunk_insert_state_last_point_store(cis, updated);
 						InstrCountTuples2(&mtstate->ps, 1);
 						return returning;
 					}
@@ -1667,16 +1979,33 @@ ExecInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo, TupleTableSl
 
 			/* Since there was no insertion conflict, we're done */
 		}
+		else if (cis != NULL && cis->compress_state != NULL)
+		{
+			/* buffer the tuple to compress it into a batch of the compressed chunk */
+			ts_cm_functions->compress_row_exec(cis->compress_state, slot);
+		}
+		else if (cis != NULL && can_use_multi_insert(mtstate, resultRelInfo))
+		{
+			/* buffer the tuple to insert it into the chunk with the other rows */
+			ts_chunk_insert_state_multi_insert_store(cis, slot);
+		}
 		else
 		{
 			/* insert the tuple normally */
-			table_tuple_insert(resultRelationDesc, slot, estate->es_output_cid, 0, NULL);
+			table_tuple_insert(resultRelationDesc,
+							   slot,
+							   estate->es_output_cid,
+							   cis != NULL ? cis->insert_options : 0,
+							   cis != NULL ? cis->insert_bistate : NULL);
 
 			/* insert index entries for tuple */
 			if (resultRelInfo->ri_NumIndices > 0)
 				recheckIndexes =
 					ExecInsertIndexTuples(resultRelInfo, slot, estate, false, false, NULL, NIL);
 		}
+
+		if (cis != NULL)
+			ts_chunk_insert_state_last_point_store(cis, slot);
 	}
 
 	if (canSetTag)
@@ -19,6 +19,8 @@ typedef struct HypertableModifyPath
 	Bitmapset *distributed_insert_plans;
 	/* List of server oids for the hypertable's data nodes */
 	List *serveroids;
+	/* Chunks a DELETE removes all rows from and that are truncated instead */
+	List *truncated_chunk_oids;
 } HypertableModifyPath;
 
 typedef struct HypertableModifyState
@@ -27,6 +29,9 @@ typedef struct HypertableModifyState
 	ModifyTable *mt;
 	List *serveroids;
 	FdwRoutine *fdwroutine;
+	bool last_point_refreshed;
+	List *truncated_chunk_oids;
+	bool chunks_truncated;
 } HypertableModifyState;
 
 extern void ts_hypertable_modify_fixup_tlist(Plan *plan);
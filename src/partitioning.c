@@ -17,6 +17,7 @@
 #include <utils/cash.h>
 #include <utils/catcache.h>
 #include <utils/date.h>
+#include <utils/fmgroids.h>
 #include <utils/inet.h>
 #include <utils/jsonb.h>
 #include <utils/lsyscache.h>
@@ -169,6 +170,53 @@ find_text_coercion_func(Oid type)
 
 #define TYPECACHE_HASH_FLAGS (TYPECACHE_HASH_PROC | TYPECACHE_HASH_PROC_FINFO)
 
+/*
+ * Use the inline hash of the column type if the partitioning function is the
+ * default one and it would call the standard hash function of the type.
+ */
+static void
+partitioning_info_set_hashtype(PartitioningInfo *pinfo, Oid relid, Oid columntype)
+{
+	TypeCacheEntry *tce;
+	Oid typid;
+	int32 typmod;
+	Oid collid;
+
+	pinfo->hashtype = PARTITIONING_HASH_GENERIC;
+	pinfo->hashcollation = InvalidOid;
+
+	if (pinfo->dimtype != DIMENSION_TYPE_CLOSED ||
+		!ts_partitioning_func_is_closed_default(pinfo->partfunc.schema, pinfo->partfunc.name))
+		return;
+
+	tce = lookup_type_cache(columntype, TYPECACHE_HASH_PROC);
+
+	switch (tce->hash_proc)
+	{
+		case F_HASHINT2:
+			pinfo->hashtype = PARTITIONING_HASH_INT2;
+			break;
+		case F_HASHINT4:
+			pinfo->hashtype = PARTITIONING_HASH_INT4;
+			break;
+		case F_HASHINT8:
+			pinfo->hashtype = PARTITIONING_HASH_INT8;
+			break;
+		case F_HASHTEXT:
+			/* Values of nondeterministic collations are hashed by their sort key */
+			get_atttypetypmodcoll(relid, pinfo->column_attnum, &typid, &typmod, &collid);
+
+			if (OidIsValid(collid) && get_collation_isdeterministic(collid))
+			{
+				pinfo->hashtype = PARTITIONING_HASH_TEXT;
+				pinfo->hashcollation = collid;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
 PartitioningInfo *
 ts_partitioning_info_create(const char *schema, const char *partfunc, const char *partcol,
 							DimensionType dimtype, Oid relid)
@@ -207,6 +255,7 @@ ts_partitioning_info_create(const char *schema, const char *partfunc, const char
 	}
 
 	partitioning_func_set_func_fmgr(&pinfo->partfunc, columntype, dimtype);
+	partitioning_info_set_hashtype(pinfo, relid, columntype);
 
 	/*
 	 * Prepare a function expression for this function. The partition hash
@@ -235,12 +284,71 @@ ts_partitioning_info_create(const char *schema, const char *partfunc, const char
  * We need to avoid FunctionCall1(), because we'd like to customize the error
  * message in case of NULL return values.
  */
+/*
+ * Compute the default partitioning function inline, the same way as
+ * ts_get_partition_hash() does with the standard hash function of the type.
+ */
+static inline bool
+partitioning_hash_inline(const PartitioningInfo *pinfo, Oid collation, Datum value, Datum *result)
+{
+	uint32 hash;
+
+	switch (pinfo->hashtype)
+	{
+		case PARTITIONING_HASH_INT2:
+			hash = DatumGetUInt32(hash_uint32((int32) DatumGetInt16(value)));
+			break;
+		case PARTITIONING_HASH_INT4:
+			hash = DatumGetUInt32(hash_uint32((int32) DatumGetInt32(value)));
+			break;
+		case PARTITIONING_HASH_INT8:
+		{
+			/* See hashint8() */
+			int64 val = DatumGetInt64(value);
+			uint32 lohalf = (uint32) val;
+			uint32 hihalf = (uint32) (val >> 32);
+
+			lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+			hash = DatumGetUInt32(hash_uint32(lohalf));
+			break;
+		}
+		case PARTITIONING_HASH_TEXT:
+		{
+			text *data;
+
+			/* The partition hash uses the default collation of the type without one */
+			if ((OidIsValid(collation) ? collation : DEFAULT_COLLATION_OID) !=
+				pinfo->hashcollation)
+				return false;
+
+			data = DatumGetTextPP(value);
+			hash = DatumGetUInt32(
+				hash_any((unsigned char *) VARDATA_ANY(data), VARSIZE_ANY_EXHDR(data)));
+
+			if ((Pointer) data != DatumGetPointer(value))
+				pfree(data);
+			break;
+		}
+		case PARTITIONING_HASH_GENERIC:
+		default:
+			return false;
+	}
+
+	/* Only positive numbers */
+	*result = Int32GetDatum((int32) (hash & 0x7fffffff));
+
+	return true;
+}
+
 TSDLLEXPORT Datum
 ts_partitioning_func_apply(PartitioningInfo *pinfo, Oid collation, Datum value)
 {
 	LOCAL_FCINFO(fcinfo, 1);
 	Datum result;
 
+	if (partitioning_hash_inline(pinfo, collation, value, &result))
+		return result;
+
 	InitFunctionCallInfoData(*fcinfo, &pinfo->partfunc.func_fmgr, 1, collation, NULL, NULL);
 
 	FC_SET_ARG(fcinfo, 0, value);
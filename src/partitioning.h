@@ -36,12 +36,28 @@ typedef struct PartitioningFunc
 	FmgrInfo func_fmgr;
 } PartitioningFunc;
 
+/*
+ * Column types for which the default partitioning function is computed inline
+ * instead of through the function manager.
+ */
+typedef enum PartitioningHashType
+{
+	PARTITIONING_HASH_GENERIC = 0,
+	PARTITIONING_HASH_INT2,
+	PARTITIONING_HASH_INT4,
+	PARTITIONING_HASH_INT8,
+	PARTITIONING_HASH_TEXT,
+} PartitioningHashType;
+
 typedef struct PartitioningInfo
 {
 	char column[NAMEDATALEN];
 	AttrNumber column_attnum;
 	DimensionType dimtype;
 	PartitioningFunc partfunc;
+	PartitioningHashType hashtype;
+	/* Deterministic collation that text values are hashed inline for */
+	Oid hashcollation;
 } PartitioningInfo;
 
 extern Oid ts_partitioning_func_get_closed_default(void);
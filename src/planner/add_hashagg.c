@@ -7,6 +7,7 @@
 #include <catalog/namespace.h>
 #include <miscadmin.h>
 #include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
 #include <nodes/plannodes.h>
 #include <optimizer/clauses.h>
 #include <optimizer/pathnode.h>
@@ -14,6 +15,9 @@
 #include <optimizer/prep.h>
 #include <optimizer/tlist.h>
 #include <parser/parsetree.h>
+#include <utils/lsyscache.h>
+#include <utils/selfuncs.h>
+#include <utils/typcache.h>
 
 #include "compat/compat-msvc-enter.h"
 #include <optimizer/cost.h>
@@ -25,6 +29,10 @@
 #include "utils.h"
 #include "guc.h"
 #include "estimate.h"
+#include "chunk.h"
+#include "dimension.h"
+#include "hypercube.h"
+#include "partitioning.h"
 
 /* This optimization adds a HashAggregate plan to many group by queries.
  * In plain postgres, many time-series queries will not use a hash aggregate
@@ -237,3 +245,258 @@ ts_plan_add_hashagg(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output
 									  &agg_costs,
 									  d_num_groups));
 }
+
+/*
+ * Rows with equal values of a space-partitioning column are always hashed to
+ * the same space slice. When the GROUP BY includes such a column, chunks whose
+ * slices don't overlap can therefore never contribute rows to the same group
+ * and every set of overlapping chunks can be aggregated on its own. The
+ * results of these full aggregations are simply appended, there is no combine
+ * step and no hash table spanning all the groups.
+ *
+ * Returns the closed dimension whose column is grouped on, or NULL if there
+ * is none we can use. Only the default partitioning function is known to hash
+ * equal values the same way the grouping compares them.
+ */
+static const Dimension *
+get_grouped_space_dimension(PlannerInfo *root, RelOptInfo *input_rel, const Hypertable *ht)
+{
+	Query *parse = root->parse;
+	int i;
+
+	for (i = 0; i < ht->space->num_dimensions; i++)
+	{
+		const Dimension *dim = &ht->space->dimensions[i];
+		ListCell *lc;
+
+		if (!IS_CLOSED_DIMENSION(dim) || dim->partitioning == NULL ||
+			strncmp(NameStr(dim->fd.partitioning_func_schema),
+					DEFAULT_PARTITIONING_FUNC_SCHEMA,
+					NAMEDATALEN) != 0 ||
+			strncmp(NameStr(dim->fd.partitioning_func),
+					DEFAULT_PARTITIONING_FUNC_NAME,
+					NAMEDATALEN) != 0)
+			continue;
+
+		foreach (lc, parse->groupClause)
+		{
+			SortGroupClause *sgc = lfirst_node(SortGroupClause, lc);
+			Node *expr = get_sortgroupclause_expr(sgc, parse->targetList);
+			TypeCacheEntry *tce;
+			Var *var;
+
+			if (!IsA(expr, Var))
+				continue;
+
+			var = castNode(Var, expr);
+			if ((Index) var->varno != input_rel->relid || var->varlevelsup != 0 ||
+				var->varattno != dim->column_attno)
+				continue;
+
+			tce = lookup_type_cache(var->vartype, TYPECACHE_EQ_OPR);
+			if (sgc->eqop != tce->eq_opr ||
+				(OidIsValid(var->varcollid) && !get_collation_isdeterministic(var->varcollid)))
+				continue;
+
+			return dim;
+		}
+	}
+
+	return NULL;
+}
+
+typedef struct SpacePartitionChild
+{
+	int64 range_start;
+	int64 range_end;
+	Path *path;
+} SpacePartitionChild;
+
+static int
+space_partition_child_cmp(const void *left, const void *right)
+{
+	const SpacePartitionChild *l = left;
+	const SpacePartitionChild *r = right;
+
+	if (l->range_start < r->range_start)
+		return -1;
+	if (l->range_start > r->range_start)
+		return 1;
+	return 0;
+}
+
+static Path *
+create_space_partition_agg_path(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel,
+								List *subpaths, double input_rows, double num_groups,
+								const AggClauseCosts *agg_costs)
+{
+	Query *parse = root->parse;
+	PathTarget *target = root->upper_targets[UPPERREL_GROUP_AGG];
+	Path *subpath = linitial(subpaths);
+	double rows = 0;
+	ListCell *lc;
+
+	if (list_length(subpaths) > 1)
+		subpath = (Path *) create_append_path_compat(root,
+													 input_rel,
+													 subpaths,
+													 NIL,
+													 NIL,
+													 NULL,
+													 0,
+													 false,
+													 NIL,
+													 -1);
+
+	foreach (lc, subpaths)
+		rows += ((Path *) lfirst(lc))->rows;
+
+	/* the groups are spread over the partitions in proportion to their rows */
+	if (input_rows > 0)
+		num_groups = clamp_row_est(num_groups * rows / input_rows);
+
+	return (Path *) create_agg_path(root,
+									output_rel,
+									subpath,
+									target,
+									AGG_HASHED,
+									AGGSPLIT_SIMPLE,
+									parse->groupClause,
+									(List *) parse->havingQual,
+									agg_costs,
+									num_groups);
+}
+
+/*
+ * Add an Append of full HashAggregates, one per group of chunks with
+ * overlapping slices of a grouped space dimension.
+ */
+void
+ts_plan_add_space_partitionwise_agg(PlannerInfo *root, RelOptInfo *input_rel,
+									RelOptInfo *output_rel, const Hypertable *ht)
+{
+	Query *parse = root->parse;
+	PathTarget *target = root->upper_targets[UPPERREL_GROUP_AGG];
+	const Dimension *dim;
+	AppendPath *append;
+	AggClauseCosts agg_costs;
+	SpacePartitionChild *children;
+	List *group_exprs;
+	List *group_subpaths = NIL;
+	List *agg_subpaths = NIL;
+	double num_groups;
+	int64 group_end = 0;
+	int nchildren = 0;
+	int i;
+	ListCell *lc;
+
+	if (!ts_guc_enable_space_partitionwise_agg || ht == NULL || hypertable_is_distributed(ht) ||
+		parse->groupingSets || parse->groupClause == NIL ||
+		!grouping_is_hashable(parse->groupClause))
+		return;
+
+	if (output_rel->pathlist != NIL && is_gapfill_path(linitial(output_rel->pathlist)))
+		return;
+
+	if (!IsA(input_rel->cheapest_total_path, AppendPath))
+		return;
+
+	append = castNode(AppendPath, input_rel->cheapest_total_path);
+	if (append->path.parallel_aware || append->path.param_info != NULL ||
+		list_length(append->subpaths) < 2)
+		return;
+
+	dim = get_grouped_space_dimension(root, input_rel, ht);
+	if (dim == NULL)
+		return;
+
+	MemSet(&agg_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs_compat(root, (Node *) root->processed_tlist, AGGSPLIT_SIMPLE, &agg_costs);
+	get_agg_clause_costs_compat(root, parse->havingQual, AGGSPLIT_SIMPLE, &agg_costs);
+
+#if PG14_LT
+	if (agg_costs.numOrderedAggs > 0)
+#else
+	if (root->numOrderedAggs > 0)
+#endif
+		return;
+
+	children = palloc(sizeof(SpacePartitionChild) * list_length(append->subpaths));
+
+	foreach (lc, append->subpaths)
+	{
+		Path *subpath = lfirst(lc);
+		RelOptInfo *child_rel = subpath->parent;
+		TimescaleDBPrivate *priv = child_rel->fdw_private;
+		const DimensionSlice *slice;
+
+		if (child_rel->reloptkind != RELOPT_OTHER_MEMBER_REL || priv == NULL ||
+			priv->chunk == NULL || priv->chunk->cube == NULL)
+			return;
+
+		slice = ts_hypercube_get_slice_by_dimension_id(priv->chunk->cube, dim->fd.id);
+		if (slice == NULL)
+			return;
+
+		children[nchildren].range_start = slice->fd.range_start;
+		children[nchildren].range_end = slice->fd.range_end;
+		children[nchildren].path = subpath;
+		nchildren++;
+	}
+
+	qsort(children, nchildren, sizeof(SpacePartitionChild), space_partition_child_cmp);
+
+	group_exprs = get_sortgrouplist_exprs(parse->groupClause, make_tlist_from_pathtarget(target));
+	num_groups = estimate_num_groups_compat(root,
+											group_exprs,
+											input_rel->cheapest_total_path->rows,
+											NULL,
+											NULL);
+
+	/* Chunks with overlapping slices, e.g. after the number of partitions was
+	 * changed, must be aggregated together */
+	for (i = 0; i < nchildren; i++)
+	{
+		if (group_subpaths != NIL && children[i].range_start >= group_end)
+		{
+			agg_subpaths = lappend(agg_subpaths,
+								   create_space_partition_agg_path(root,
+																   input_rel,
+																   output_rel,
+																   group_subpaths,
+																   append->path.rows,
+																   num_groups,
+																   &agg_costs));
+			group_subpaths = NIL;
+		}
+
+		if (group_subpaths == NIL || children[i].range_end > group_end)
+			group_end = children[i].range_end;
+		group_subpaths = lappend(group_subpaths, children[i].path);
+	}
+
+	/* all chunks overlap, nothing to gain */
+	if (agg_subpaths == NIL)
+		return;
+
+	agg_subpaths = lappend(agg_subpaths,
+						   create_space_partition_agg_path(root,
+														   input_rel,
+														   output_rel,
+														   group_subpaths,
+														   append->path.rows,
+														   num_groups,
+														   &agg_costs));
+
+	add_path(output_rel,
+			 (Path *) create_append_path_compat(root,
+												output_rel,
+												agg_subpaths,
+												NIL,
+												NIL,
+												NULL,
+												0,
+												false,
+												NIL,
+												-1));
+}
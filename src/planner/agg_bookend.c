@@ -35,10 +35,15 @@
 
 #include <postgres.h>
 
+#include <access/genam.h>
 #include <access/htup_details.h>
 #include <access/stratnum.h>
+#include <access/table.h>
 #include <catalog/namespace.h>
+#include <catalog/pg_am.h>
 #include <catalog/pg_aggregate.h>
+#include <catalog/pg_index.h>
+#include <catalog/pg_namespace.h>
 #include <catalog/pg_proc.h>
 #include <catalog/pg_type.h>
 #include <nodes/makefuncs.h>
@@ -53,16 +58,24 @@
 #include <parser/parsetree.h>
 #include <parser/parse_clause.h>
 #include <parser/parse_func.h>
+#include <miscadmin.h>
 #include <rewrite/rewriteManip.h>
+#include <storage/lmgr.h>
+#include <utils/acl.h>
 #include <utils/builtins.h>
 #include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/relcache.h>
 #include <utils/regproc.h>
+#include <utils/rls.h>
 #include <utils/syscache.h>
 #include <utils/typcache.h>
 
+#include "compat/compat.h"
 #include "planner.h"
 #include "utils.h"
 #include "extension.h"
+#include "last_point.h"
 
 typedef struct FirstLastAggInfo
 {
@@ -781,3 +794,571 @@ first_last_qp_callback(PlannerInfo *root, void *extra)
 
 	root->query_pathkeys = root->sort_pathkeys;
 }
+
+typedef struct LastPointRewriteContext
+{
+	Index rti;
+	Oid ht_relid;
+	Oid cache_relid;
+	AttrNumber key_attno;  /* in the hypertable */
+	AttrNumber time_attno; /* in the hypertable */
+	bool in_aggregate;
+	bool failed;
+} LastPointRewriteContext;
+
+static bool
+is_time_var(Node *node, LastPointRewriteContext *context)
+{
+	Var *var = (Var *) node;
+
+	return IsA(node, Var) && var->varno == context->rti && var->varlevelsup == 0 &&
+		   var->varattno == context->time_attno;
+}
+
+static bool
+is_max_aggregate(Oid aggfnoid)
+{
+	return get_func_namespace(aggfnoid) == PG_CATALOG_NAMESPACE &&
+		   strcmp(get_func_name(aggfnoid), "max") == 0;
+}
+
+/*
+ * Point a Var on the hypertable to the column of the same name in the cache.
+ */
+static Node *
+last_point_remap_var(Var *var, LastPointRewriteContext *context)
+{
+	char *attname = get_attname(context->ht_relid, var->varattno, false);
+	AttrNumber attno = get_attnum(context->cache_relid, attname);
+	Oid type, collation;
+	int32 typmod;
+
+	if (attno == InvalidAttrNumber)
+	{
+		context->failed = true;
+		return (Node *) var;
+	}
+
+	get_atttypetypmodcoll(context->cache_relid, attno, &type, &typmod, &collation);
+
+	if (type != var->vartype || typmod != var->vartypmod || collation != var->varcollid)
+	{
+		context->failed = true;
+		return (Node *) var;
+	}
+
+	var = copyObject(var);
+	var->varattno = attno;
+#if PG13_GE
+	var->varattnosyn = attno;
+#else
+	var->varoattno = attno;
+#endif
+
+	return (Node *) var;
+}
+
+/*
+ * Replace last(value, time) and max(time) by the columns of the newest row of
+ * the group. Only the key can be referenced outside of these aggregates.
+ */
+static Node *
+last_point_rewrite_mutator(Node *node, LastPointRewriteContext *context)
+{
+	if (node == NULL || context->failed)
+		return node;
+
+	if (IsA(node, Var))
+	{
+		Var *var = castNode(Var, node);
+
+		if (var->varno != context->rti || var->varlevelsup != 0 || var->varattno <= 0 ||
+			(!context->in_aggregate && var->varattno != context->key_attno))
+		{
+			context->failed = true;
+			return node;
+		}
+
+		return last_point_remap_var(var, context);
+	}
+
+	if (IsA(node, Aggref))
+	{
+		Aggref *aggref = castNode(Aggref, node);
+		FuncStrategy *func_strategy = get_func_strategy(aggref->aggfnoid);
+		Node *result;
+
+		if (context->in_aggregate || aggref->agglevelsup != 0 || aggref->aggfilter != NULL ||
+			aggref->aggorder != NIL || aggref->aggdistinct != NIL)
+		{
+			context->failed = true;
+			return node;
+		}
+
+		if (func_strategy == &last_func_strategy && list_length(aggref->args) == 2 &&
+			is_time_var((Node *) lsecond_node(TargetEntry, aggref->args)->expr, context))
+			result = (Node *) linitial_node(TargetEntry, aggref->args)->expr;
+		else if (list_length(aggref->args) == 1 && is_max_aggregate(aggref->aggfnoid) &&
+				 is_time_var((Node *) linitial_node(TargetEntry, aggref->args)->expr, context))
+			result = (Node *) linitial_node(TargetEntry, aggref->args)->expr;
+		else
+		{
+			context->failed = true;
+			return node;
+		}
+
+		context->in_aggregate = true;
+		result = last_point_rewrite_mutator(result, context);
+		context->in_aggregate = false;
+
+		return result;
+	}
+
+	if (IsA(node, SubLink) || IsA(node, WindowFunc) || IsA(node, GroupingFunc))
+	{
+		context->failed = true;
+		return node;
+	}
+
+	return expression_tree_mutator(node, last_point_rewrite_mutator, context);
+}
+
+/*
+ * Answer a query for the newest row of every key of a hypertable from its
+ * last point cache, e.g.,
+ *
+ *	 SELECT device, last(temp, time), max(time) FROM ht GROUP BY device
+ *
+ * is turned into a scan of the cache, which holds exactly these rows:
+ *
+ *	 SELECT device, temp, time FROM _hyper_1_last_point
+ *
+ * Quals can only reference the key, since they would otherwise filter the
+ * rows before finding the newest one. Returns true if the query was
+ * rewritten.
+ */
+bool
+ts_last_point_rewrite_query(Query *query, Hypertable *ht)
+{
+	RangeTblEntry *rte;
+	TargetEntry *group_tle;
+	Var *group_var;
+	const Dimension *dim;
+	LastPointRewriteContext context = {
+		.rti = 1,
+		.ht_relid = ht->main_table_relid,
+		.cache_relid = ht->last_point_relid,
+	};
+	List *target_list;
+	Node *quals;
+	Relation cache_rel;
+	Oid userid;
+
+	if (!OidIsValid(ht->last_point_relid) || !ts_guc_enable_optimizations ||
+		!ts_guc_enable_last_point_cache)
+		return false;
+
+	if (query->commandType != CMD_SELECT || !query->hasAggs || query->hasWindowFuncs ||
+		query->hasTargetSRFs || query->hasSubLinks || query->hasRecursive ||
+		query->groupingSets != NIL || query->havingQual != NULL || query->distinctClause != NIL ||
+		query->setOperations != NULL || query->rowMarks != NIL || query->cteList != NIL ||
+		list_length(query->rtable) != 1 || list_length(query->groupClause) != 1 ||
+		list_length(query->jointree->fromlist) != 1 ||
+		!IsA(linitial(query->jointree->fromlist), RangeTblRef) ||
+		linitial_node(RangeTblRef, query->jointree->fromlist)->rtindex != context.rti)
+		return false;
+
+	rte = linitial_node(RangeTblEntry, query->rtable);
+
+	if (rte->rtekind != RTE_RELATION || rte->relid != ht->main_table_relid || !rte->inh ||
+		rte->tablesample != NULL || rte->securityQuals != NIL ||
+		(rte->alias != NULL && rte->alias->colnames != NIL))
+		return false;
+
+	group_tle = get_sortgroupclause_tle(linitial_node(SortGroupClause, query->groupClause),
+										query->targetList);
+	group_var = (Var *) group_tle->expr;
+	context.key_attno =
+		get_attnum(ht->main_table_relid,
+				   get_attname(ht->last_point_relid,
+							   ts_last_point_cache_get_key_attno(ht->last_point_relid),
+							   false));
+
+	if (!IsA(group_var, Var) || group_var->varno != context.rti ||
+		group_var->varlevelsup != 0 || group_var->varattno != context.key_attno)
+		return false;
+
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+	context.time_attno = dim->column_attno;
+
+	/*
+	 * The cache has the permissions of the hypertable, but the query must not
+	 * bypass row level security or column privileges on the hypertable.
+	 */
+	userid = OidIsValid(rte->checkAsUser) ? rte->checkAsUser : GetUserId();
+
+	if (pg_class_aclcheck(ht->main_table_relid, userid, ACL_SELECT) != ACLCHECK_OK ||
+		pg_class_aclcheck(ht->last_point_relid, userid, ACL_SELECT) != ACLCHECK_OK ||
+		check_enable_rls(ht->main_table_relid, rte->checkAsUser, true) == RLS_ENABLED)
+		return false;
+
+	if (contain_volatile_functions((Node *) query))
+		return false;
+
+	target_list = (List *) last_point_rewrite_mutator((Node *) query->targetList, &context);
+	quals = last_point_rewrite_mutator(query->jointree->quals, &context);
+
+	if (context.failed)
+		return false;
+
+	LockRelationOid(ht->last_point_relid, AccessShareLock);
+	cache_rel = table_open(ht->last_point_relid, NoLock);
+
+	query->targetList = target_list;
+	query->jointree->quals = quals;
+	query->groupClause = NIL;
+	query->hasAggs = false;
+
+	rte->relid = ht->last_point_relid;
+	rte->inh = false;
+	rte->selectedCols = NULL;
+	pull_varattnos((Node *) target_list, context.rti, &rte->selectedCols);
+	pull_varattnos(quals, context.rti, &rte->selectedCols);
+	rte->eref->colnames = NIL;
+
+	for (int i = 0; i < RelationGetNumberOfAttributes(cache_rel); i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(cache_rel), i);
+
+		rte->eref->colnames = lappend(rte->eref->colnames,
+									  makeString(pstrdup(attr->attisdropped ?
+															 "" :
+															 NameStr(attr->attname))));
+	}
+
+	table_close(cache_rel, NoLock);
+
+	return true;
+}
+
+typedef struct FirstLastDistinctContext
+{
+	Index rti;
+	AttrNumber time_attno;
+	Bitmapset *group_attnos;
+	FuncStrategy *strategy; /* first or last, the same for all aggregates */
+	bool in_aggregate;
+	bool failed;
+} FirstLastDistinctContext;
+
+static bool
+is_min_aggregate(Oid aggfnoid)
+{
+	return get_func_namespace(aggfnoid) == PG_CATALOG_NAMESPACE &&
+		   strcmp(get_func_name(aggfnoid), "min") == 0;
+}
+
+static bool
+first_last_distinct_is_time_var(Node *node, FirstLastDistinctContext *context)
+{
+	Var *var = (Var *) node;
+
+	return IsA(node, Var) && var->varno == context->rti && var->varlevelsup == 0 &&
+		   var->varattno == context->time_attno;
+}
+
+/*
+ * Replace first(value, time) or last(value, time) by the value of the row
+ * the DISTINCT ON keeps, and min(time) or max(time) by its time. Outside of
+ * these aggregates only the group columns can be referenced.
+ */
+static Node *
+first_last_distinct_mutator(Node *node, FirstLastDistinctContext *context)
+{
+	if (node == NULL || context->failed)
+		return node;
+
+	if (IsA(node, Var))
+	{
+		Var *var = castNode(Var, node);
+
+		if (var->varno != context->rti || var->varlevelsup != 0 ||
+			(!context->in_aggregate && !bms_is_member(var->varattno, context->group_attnos)))
+			context->failed = true;
+
+		return node;
+	}
+
+	if (IsA(node, Aggref))
+	{
+		Aggref *aggref = castNode(Aggref, node);
+		FuncStrategy *func_strategy = get_func_strategy(aggref->aggfnoid);
+		Node *result = NULL;
+		Node *last_arg;
+
+		if (context->in_aggregate || aggref->agglevelsup != 0 || aggref->aggfilter != NULL ||
+			aggref->aggorder != NIL || aggref->aggdistinct != NIL || aggref->args == NIL)
+		{
+			context->failed = true;
+			return node;
+		}
+
+		last_arg = (Node *) llast_node(TargetEntry, aggref->args)->expr;
+
+		if (!first_last_distinct_is_time_var(last_arg, context))
+			func_strategy = NULL;
+		else if (func_strategy != NULL && list_length(aggref->args) == 2)
+			result = (Node *) linitial_node(TargetEntry, aggref->args)->expr;
+		else if (list_length(aggref->args) == 1 && is_min_aggregate(aggref->aggfnoid))
+			func_strategy = &first_func_strategy;
+		else if (list_length(aggref->args) == 1 && is_max_aggregate(aggref->aggfnoid))
+			func_strategy = &last_func_strategy;
+		else
+			func_strategy = NULL;
+
+		/* min(time) or max(time) */
+		if (result == NULL)
+			result = last_arg;
+
+		if (func_strategy == NULL ||
+			(context->strategy != NULL && context->strategy != func_strategy))
+		{
+			context->failed = true;
+			return node;
+		}
+
+		context->strategy = func_strategy;
+		context->in_aggregate = true;
+		result = first_last_distinct_mutator(result, context);
+		context->in_aggregate = false;
+
+		return result;
+	}
+
+	if (IsA(node, SubLink) || IsA(node, WindowFunc) || IsA(node, GroupingFunc))
+	{
+		context->failed = true;
+		return node;
+	}
+
+	return expression_tree_mutator(node, first_last_distinct_mutator, context);
+}
+
+/*
+ * Find a btree index of the hypertable with the group columns followed by the
+ * time column as its leading keys. Returns the key columns and their options.
+ */
+static bool
+first_last_distinct_find_index(Hypertable *ht, FirstLastDistinctContext *context,
+							   AttrNumber *attnos, int16 *options)
+{
+	int ngroups = bms_num_members(context->group_attnos);
+	Relation rel = table_open(ht->main_table_relid, AccessShareLock);
+	List *indexes = RelationGetIndexList(rel);
+	ListCell *lc;
+	bool found = false;
+
+	table_close(rel, NoLock);
+
+	foreach (lc, indexes)
+	{
+		Relation index = index_open(lfirst_oid(lc), AccessShareLock);
+		Bitmapset *keys = NULL;
+		int i;
+
+		if (index->rd_rel->relam == BTREE_AM_OID &&
+			index->rd_index->indnkeyatts > ngroups &&
+			index->rd_index->indkey.values[ngroups] == context->time_attno &&
+			heap_attisnull(index->rd_indextuple, Anum_pg_index_indexprs, NULL) &&
+			heap_attisnull(index->rd_indextuple, Anum_pg_index_indpred, NULL))
+		{
+			for (i = 0; i < ngroups; i++)
+				keys = bms_add_member(keys, index->rd_index->indkey.values[i]);
+
+			if (bms_equal(keys, context->group_attnos))
+			{
+				for (i = 0; i <= ngroups; i++)
+				{
+					attnos[i] = index->rd_index->indkey.values[i];
+					options[i] = index->rd_indoption[i];
+				}
+				found = true;
+			}
+		}
+
+		index_close(index, AccessShareLock);
+
+		if (found)
+			break;
+	}
+
+	list_free(indexes);
+
+	return found;
+}
+
+static SortGroupClause *
+first_last_distinct_sort_clause(TargetEntry *tle, int16 option, bool backward)
+{
+	int flags = TYPECACHE_LT_OPR | TYPECACHE_GT_OPR | TYPECACHE_EQ_OPR | TYPECACHE_HASH_PROC;
+	TypeCacheEntry *tce = lookup_type_cache(exprType((Node *) tle->expr), flags);
+	SortGroupClause *clause = makeNode(SortGroupClause);
+	bool desc = ((option & INDOPTION_DESC) != 0) != backward;
+
+	clause->tleSortGroupRef = tle->ressortgroupref;
+	clause->eqop = tce->eq_opr;
+	clause->sortop = desc ? tce->gt_opr : tce->lt_opr;
+	clause->nulls_first = ((option & INDOPTION_NULLS_FIRST) != 0) != backward;
+	clause->hashable = OidIsValid(tce->hash_proc);
+
+	return clause;
+}
+
+/*
+ * Answer a grouped first/last query with DISTINCT ON when the hypertable has
+ * an index on the group columns and time, e.g.,
+ *
+ *	 SELECT device, last(temp, time), max(time) FROM ht GROUP BY device
+ *
+ * is turned into
+ *
+ *	 SELECT DISTINCT ON (device) device, temp, time FROM ht
+ *	 ORDER BY device, time DESC
+ *
+ * which is planned as a SkipScan over the index, reading only the newest row
+ * of every device instead of aggregating all rows. The time column of the
+ * hypertable is NOT NULL, so the row DISTINCT ON keeps is the one the
+ * aggregates would pick. Returns true if the query was rewritten.
+ */
+bool
+ts_first_last_distinct_rewrite_query(Query *query, Hypertable *ht)
+{
+	FirstLastDistinctContext context = { .rti = 1 };
+	RangeTblEntry *rte;
+	AttrNumber attnos[INDEX_MAX_KEYS];
+	int16 options[INDEX_MAX_KEYS];
+	List *target_list;
+	List *distinct_clause = NIL;
+	List *sort_clause = NIL;
+	const Dimension *dim;
+	TargetEntry *time_tle = NULL;
+	ListCell *lc, *lc_distinct;
+	bool backward;
+	int ngroups;
+	int i;
+
+	if (!ts_guc_enable_optimizations || !ts_guc_enable_grouped_first_last)
+		return false;
+
+	if (query->commandType != CMD_SELECT || !query->hasAggs || query->hasWindowFuncs ||
+		query->hasTargetSRFs || query->hasSubLinks || query->hasRecursive ||
+		query->groupingSets != NIL || query->havingQual != NULL || query->distinctClause != NIL ||
+		query->setOperations != NULL || query->rowMarks != NIL || query->cteList != NIL ||
+		query->groupClause == NIL || list_length(query->rtable) != 1 ||
+		list_length(query->jointree->fromlist) != 1 ||
+		!IsA(linitial(query->jointree->fromlist), RangeTblRef) ||
+		linitial_node(RangeTblRef, query->jointree->fromlist)->rtindex != context.rti)
+		return false;
+
+	rte = linitial_node(RangeTblEntry, query->rtable);
+
+	if (rte->rtekind != RTE_RELATION || rte->relid != ht->main_table_relid ||
+		rte->tablesample != NULL)
+		return false;
+
+	foreach (lc, query->groupClause)
+	{
+		TargetEntry *tle =
+			get_sortgroupclause_tle(lfirst_node(SortGroupClause, lc), query->targetList);
+		Var *var = (Var *) tle->expr;
+
+		if (!IsA(var, Var) || var->varno != context.rti || var->varlevelsup != 0 ||
+			var->varattno <= 0 || bms_is_member(var->varattno, context.group_attnos))
+			return false;
+
+		context.group_attnos = bms_add_member(context.group_attnos, var->varattno);
+	}
+
+	ngroups = bms_num_members(context.group_attnos);
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+	context.time_attno = dim->column_attno;
+
+	if (bms_is_member(context.time_attno, context.group_attnos) ||
+		contain_volatile_functions((Node *) query))
+		return false;
+
+	target_list = (List *) first_last_distinct_mutator((Node *) query->targetList, &context);
+
+	if (context.failed || context.strategy == NULL ||
+		!first_last_distinct_find_index(ht, &context, attnos, options))
+		return false;
+
+	/*
+	 * Scan the index backward if its time order is the opposite of the one
+	 * the aggregates need.
+	 */
+	backward = ((options[ngroups] & INDOPTION_DESC) != 0) !=
+			   (context.strategy == &last_func_strategy);
+
+	for (i = 0; i < ngroups; i++)
+	{
+		foreach (lc, query->groupClause)
+		{
+			SortGroupClause *group = lfirst_node(SortGroupClause, lc);
+			TargetEntry *tle = get_sortgroupclause_tle(group, target_list);
+
+			if (castNode(Var, tle->expr)->varattno == attnos[i])
+			{
+				distinct_clause =
+					lappend(distinct_clause,
+							first_last_distinct_sort_clause(tle, options[i], backward));
+				break;
+			}
+		}
+	}
+
+	/* an ORDER BY of the query has to be a prefix of the DISTINCT ON order */
+	if (list_length(query->sortClause) > ngroups)
+		return false;
+
+	forboth (lc, query->sortClause, lc_distinct, distinct_clause)
+	{
+		SortGroupClause *sort = lfirst_node(SortGroupClause, lc);
+		SortGroupClause *distinct = lfirst_node(SortGroupClause, lc_distinct);
+
+		if (sort->tleSortGroupRef != distinct->tleSortGroupRef ||
+			sort->sortop != distinct->sortop || sort->nulls_first != distinct->nulls_first)
+			return false;
+	}
+
+	foreach (lc, target_list)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+
+		if (first_last_distinct_is_time_var((Node *) tle->expr, &context))
+		{
+			time_tle = tle;
+			break;
+		}
+	}
+
+	if (time_tle == NULL)
+	{
+		Var *var = makeVar(context.rti, context.time_attno, dim->fd.column_type, -1, InvalidOid, 0);
+
+		time_tle = makeTargetEntry((Expr *) var, list_length(target_list) + 1, NULL, true);
+		target_list = lappend(target_list, time_tle);
+	}
+	assignSortGroupRef(time_tle, target_list);
+
+	query->targetList = target_list;
+	query->distinctClause = distinct_clause;
+	query->hasDistinctOn = true;
+	query->sortClause =
+		lappend(copyObject(distinct_clause),
+				first_last_distinct_sort_clause(time_tle, options[ngroups], backward));
+	query->groupClause = NIL;
+	query->hasAggs = false;
+
+	return true;
+}
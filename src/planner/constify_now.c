@@ -80,9 +80,16 @@ is_valid_now_expr(OpExpr *op, List *rtable)
 	/*
 	 * If this query on a view we might have a subquery here
 	 * and need to peek into the subquery range table to check
-	 * if the constraints are on a hypertable.
+	 * if the constraints are on a hypertable. Views can be
+	 * nested, and the output columns of a UNION ALL, e.g. of
+	 * a real-time continuous aggregate, reference its first
+	 * branch, so we follow the column down until we reach a
+	 * relation. The qual is pushed down into all branches of
+	 * the union by the planner, and the constified version
+	 * then allows plan time chunk exclusion in all of them,
+	 * on time_bucket() expressions of the raw hypertable too.
 	 */
-	if (rte->rtekind == RTE_SUBQUERY)
+	while (rte->rtekind == RTE_SUBQUERY)
 	{
 		/*
 		 * Unfortunately the mechanism used to warm up the
@@ -92,15 +99,21 @@ is_valid_now_expr(OpExpr *op, List *rtable)
 		 * CACHE_FLAG_NOCREATE flag.
 		 */
 		flags = CACHE_FLAG_MISSING_OK;
+		if (var->varattno <= 0 || var->varattno > list_length(rte->subquery->targetList))
+			return false;
 		TargetEntry *tle = list_nth(rte->subquery->targetList, var->varattno - 1);
 		if (!IsA(tle->expr, Var))
 			return false;
+		Query *subquery = rte->subquery;
 		var = castNode(Var, tle->expr);
-		if (var->varlevelsup != 0)
+		if (var->varlevelsup != 0 || var->varno > (Index) list_length(subquery->rtable))
 			return false;
-		rte = list_nth(rte->subquery->rtable, var->varno - 1);
+		rte = list_nth(subquery->rtable, var->varno - 1);
 	}
 
+	if (rte->rtekind != RTE_RELATION)
+		return false;
+
 	const Dimension *dim = get_hypertable_dimension(rte->relid, flags);
 	if (!dim || dim->fd.column_type != TIMESTAMPTZOID || dim->column_attno != var->varattno)
 		return false;
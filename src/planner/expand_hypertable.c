@@ -21,31 +21,43 @@
  * */
 
 #include <postgres.h>
+#include <access/nbtree.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_class.h>
 #include <catalog/pg_constraint.h>
 #include <catalog/pg_inherits.h>
 #include <catalog/pg_namespace.h>
+#include <catalog/pg_operator.h>
 #include <catalog/pg_type.h>
+#include <commands/defrem.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
 #include <nodes/plannodes.h>
 #include <optimizer/cost.h>
 #include <optimizer/optimizer.h>
 #include <optimizer/pathnode.h>
+#include <optimizer/predtest.h>
 #include <optimizer/prep.h>
 #include <optimizer/restrictinfo.h>
 #include <optimizer/tlist.h>
+#include <parser/parse_coerce.h>
 #include <parser/parse_func.h>
 #include <parser/parsetree.h>
 #include <partitioning/partbounds.h>
+#include <utils/array.h>
 #include <utils/date.h>
 #include <utils/errcodes.h>
 #include <utils/fmgroids.h>
 #include <utils/fmgrprotos.h>
+#include <utils/hsearch.h>
+#include <utils/lsyscache.h>
 #include <utils/syscache.h>
+#include <utils/typcache.h>
 
 #include "chunk.h"
 #include "compat/compat.h"
 #include "cross_module_fn.h"
+#include "dimension_slice.h"
 #include "extension.h"
 #include "extension_constants.h"
 #include "guc.h"
@@ -56,7 +68,11 @@
 #include "partitioning.h"
 #include "partialize.h"
 #include "planner.h"
+#include "planner_timing.h"
 #include "time_utils.h"
+#include "ts_catalog/catalog.h"
+#include "ts_catalog/chunk_column_stats.h"
+#include "utils.h"
 
 typedef struct CollectQualCtx
 {
@@ -64,6 +80,9 @@ typedef struct CollectQualCtx
 	RelOptInfo *rel;
 	List *restrictions;
 	FuncExpr *chunk_exclusion_func;
+	/* Chunk IDs the relation is restricted to by chunk_id_from_relid quals */
+	bool chunk_ids_restricted;
+	List *chunk_ids;
 	List *join_conditions;
 	List *propagate_conditions;
 	List *all_quals;
@@ -73,8 +92,10 @@ typedef struct CollectQualCtx
 static void propagate_join_quals(PlannerInfo *root, RelOptInfo *rel, CollectQualCtx *ctx);
 
 static Oid chunk_exclusion_func = InvalidOid;
+static Oid chunk_id_from_relid_func = InvalidOid;
 
 static Oid ts_chunks_arg_types[] = { RECORDOID, INT4ARRAYOID };
+static Oid ts_chunk_id_from_relid_arg_types[] = { OIDOID };
 
 static void
 init_chunk_exclusion_func()
@@ -86,6 +107,16 @@ init_chunk_exclusion_func()
 			LookupFuncName(l, lengthof(ts_chunks_arg_types), ts_chunks_arg_types, false);
 	}
 	Assert(OidIsValid(chunk_exclusion_func));
+
+	if (!OidIsValid(chunk_id_from_relid_func))
+	{
+		List *l =
+			list_make2(makeString(INTERNAL_SCHEMA_NAME), makeString(CHUNK_ID_FROM_RELID_FUNC_NAME));
+		chunk_id_from_relid_func = LookupFuncName(l,
+												  lengthof(ts_chunk_id_from_relid_arg_types),
+												  ts_chunk_id_from_relid_arg_types,
+												  true);
+	}
 }
 
 static bool
@@ -97,6 +128,108 @@ is_chunk_exclusion_func(Expr *node)
 	return false;
 }
 
+/*
+ * Check for chunk_id_from_relid(tableoid) on the given relation.
+ */
+static bool
+is_chunk_id_of_rel(Expr *node, Index relid)
+{
+	FuncExpr *func;
+	Var *var;
+
+	if (!OidIsValid(chunk_id_from_relid_func) || !IsA(node, FuncExpr))
+		return false;
+
+	func = castNode(FuncExpr, node);
+
+	if (func->funcid != chunk_id_from_relid_func || list_length(func->args) != 1 ||
+		!IsA(linitial(func->args), Var))
+		return false;
+
+	var = linitial_node(Var, func->args);
+
+	return var->varno == relid && var->varattno == TableOidAttributeNumber &&
+		   var->varlevelsup == 0;
+}
+
+/*
+ * Get the chunk IDs from a qual of the form
+ *
+ *   chunk_id_from_relid(tableoid) = Const
+ *   chunk_id_from_relid(tableoid) = ANY(Const)
+ *
+ * Continuous aggregates that store partials per chunk use these quals to
+ * refresh the partials of some chunks only, which would otherwise scan every
+ * chunk of the refreshed buckets.
+ */
+static bool
+get_chunk_id_qual_chunk_ids(Expr *qual, Index relid, List **chunk_ids)
+{
+	Expr *left, *right;
+	Const *c;
+
+	if (IsA(qual, OpExpr) && list_length(castNode(OpExpr, qual)->args) == 2)
+	{
+		OpExpr *op = castNode(OpExpr, qual);
+
+		if (op->opno != Int4EqualOperator)
+			return false;
+
+		left = linitial(op->args);
+		right = lsecond(op->args);
+
+		if (IsA(left, Const) && is_chunk_id_of_rel(right, relid))
+			c = castNode(Const, left);
+		else if (IsA(right, Const) && is_chunk_id_of_rel(left, relid))
+			c = castNode(Const, right);
+		else
+			return false;
+
+		*chunk_ids = c->constisnull ? NIL : list_make1_int(DatumGetInt32(c->constvalue));
+		return true;
+	}
+
+	if (IsA(qual, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *op = castNode(ScalarArrayOpExpr, qual);
+		Datum *elems;
+		bool *nulls;
+		int num_elems;
+
+		if (!op->useOr || op->opno != Int4EqualOperator)
+			return false;
+
+		left = linitial(op->args);
+		right = lsecond(op->args);
+
+		if (!is_chunk_id_of_rel(left, relid) || !IsA(right, Const))
+			return false;
+
+		c = castNode(Const, right);
+		*chunk_ids = NIL;
+
+		if (c->constisnull)
+			return true;
+
+		deconstruct_array(DatumGetArrayTypeP(c->constvalue),
+						  INT4OID,
+						  sizeof(int32),
+						  true,
+						  TYPALIGN_INT,
+						  &elems,
+						  &nulls,
+						  &num_elems);
+
+		for (int i = 0; i < num_elems; i++)
+			if (!nulls[i])
+				*chunk_ids = list_append_unique_int(*chunk_ids, DatumGetInt32(elems[i]));
+
+		return true;
+	}
+
+	return false;
+}
+
 static bool
 is_time_bucket_function(Expr *node)
 {
@@ -680,6 +813,19 @@ process_quals(Node *quals, CollectQualCtx *ctx, bool is_outer_join)
 			return quals;
 		}
 
+		if (!is_outer_join)
+		{
+			List *chunk_ids;
+
+			if (get_chunk_id_qual_chunk_ids(qual, ctx->rel->relid, &chunk_ids))
+			{
+				ctx->chunk_ids = ctx->chunk_ids_restricted ?
+									 list_intersection_int(ctx->chunk_ids, chunk_ids) :
+									 chunk_ids;
+				ctx->chunk_ids_restricted = true;
+			}
+		}
+
 		if (IsA(qual, OpExpr) && list_length(castNode(OpExpr, qual)->args) == 2)
 		{
 			OpExpr *op = castNode(OpExpr, qual);
@@ -971,9 +1117,9 @@ should_order_append(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht, List *jo
 
 	/*
 	 * only do this optimization for hypertables with 1 dimension and queries
-	 * with an ORDER BY clause
+	 * with an ORDER BY or GROUP BY clause
 	 */
-	if (root->parse->sortClause == NIL)
+	if (root->parse->sortClause == NIL && root->parse->groupClause == NIL)
 		return false;
 
 	return ts_ordered_append_should_optimize(root, rel, ht, join_conditions, order_attno, reverse);
@@ -1125,6 +1271,37 @@ get_explicit_chunks(CollectQualCtx *ctx, PlannerInfo *root, RelOptInfo *rel, Hyp
 	return chunks;
 }
 
+/*
+ * Get the chunks matching the restrict info that are also in the list of
+ * chunk IDs, ordered like find_children_chunks() orders them.
+ */
+static Chunk **
+get_chunks_restricted_by_id(HypertableRestrictInfo *hri, Hypertable *ht, List *chunk_ids,
+							unsigned int *num_chunks)
+{
+	Chunk **chunks;
+	unsigned int num_restricted = 0;
+
+	if (chunk_ids == NIL)
+	{
+		*num_chunks = 0;
+		return NULL;
+	}
+
+	chunks = ts_hypertable_restrict_info_get_chunks(hri, ht, num_chunks);
+
+	for (unsigned int i = 0; i < *num_chunks; i++)
+	{
+		if (list_member_int(chunk_ids, chunks[i]->fd.id))
+			chunks[num_restricted++] = chunks[i];
+	}
+
+	*num_chunks = num_restricted;
+	qsort(chunks, *num_chunks, sizeof(Chunk *), chunk_cmp_chunk_reloid);
+
+	return chunks;
+}
+
 /**
  * Get chunks from either restrict info or explicit chunk exclusion. Explicit chunk exclusion
  * takes precedence.
@@ -1141,6 +1318,7 @@ get_chunks(CollectQualCtx *ctx, PlannerInfo *root, RelOptInfo *rel, Hypertable *
 {
 	bool reverse;
 	int order_attno;
+	Chunk **chunks = NULL;
 
 	if (ctx->chunk_exclusion_func != NULL)
 	{
@@ -1156,6 +1334,14 @@ get_chunks(CollectQualCtx *ctx, PlannerInfo *root, RelOptInfo *rel, Hypertable *
 	 */
 	ts_hypertable_restrict_info_add(hri, root, ctx->restrictions);
 
+	if (ctx->chunk_ids_restricted && !TS_HYPERTABLE_IS_INTERNAL_COMPRESSION_TABLE(ht))
+	{
+		chunks = get_chunks_restricted_by_id(hri, ht, ctx->chunk_ids, num_chunks);
+
+		if (*num_chunks == 0)
+			return NULL;
+	}
+
 	/*
 	 * If fdw_private has not been setup by caller there is no point checking
 	 * for ordered append as we can't pass the required metadata in fdw_private
@@ -1180,15 +1366,392 @@ get_chunks(CollectQualCtx *ctx, PlannerInfo *root, RelOptInfo *rel, Hypertable *
 
 		return ts_hypertable_restrict_info_get_chunks_ordered(hri,
 															  ht,
-															  NULL,
+															  chunks,
 															  reverse,
 															  nested_oids,
 															  num_chunks);
 	}
 
+	if (chunks != NULL)
+		return chunks;
+
 	return find_children_chunks(hri, ht, num_chunks);
 }
 
+/* A tracked column of the hypertable that the restrictions refer to */
+typedef struct ColumnStatsExclusion
+{
+	NameData column_name;
+	Var *var;
+	/* the column, relabeled to the input type of the btree operators if needed */
+	Expr *expr;
+	Oid opintype;
+	int16 typlen;
+	bool typbyval;
+	Oid ge_opno;
+	Oid le_opno;
+} ColumnStatsExclusion;
+
+typedef struct ChunkColumnStatsEntry
+{
+	int32 chunk_id;
+	List *stats;
+} ChunkColumnStatsEntry;
+
+static bool
+column_stats_exclusion_init(ColumnStatsExclusion *col, Hypertable *ht, Index relid,
+							const char *column_name)
+{
+	AttrNumber attno = get_attnum(ht->main_table_relid, column_name);
+	TypeCacheEntry *tce;
+	Oid typid, collid;
+	int32 typmod;
+
+	if (attno == InvalidAttrNumber)
+		return false;
+
+	get_atttypetypmodcoll(ht->main_table_relid, attno, &typid, &typmod, &collid);
+	tce = lookup_type_cache(typid, TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->btree_opf) || !IsBinaryCoercible(typid, tce->btree_opintype))
+		return false;
+
+	namestrcpy(&col->column_name, column_name);
+	col->var = makeVar(relid, attno, typid, typmod, collid, 0);
+	col->expr = (Expr *) col->var;
+	col->opintype = tce->btree_opintype;
+	get_typlenbyval(typid, &col->typlen, &col->typbyval);
+	col->ge_opno = get_opfamily_member(tce->btree_opf,
+									   tce->btree_opintype,
+									   tce->btree_opintype,
+									   BTGreaterEqualStrategyNumber);
+	col->le_opno = get_opfamily_member(tce->btree_opf,
+									   tce->btree_opintype,
+									   tce->btree_opintype,
+									   BTLessEqualStrategyNumber);
+
+	if (!OidIsValid(col->ge_opno) || !OidIsValid(col->le_opno))
+		return false;
+
+	/* Like the partition constraints of a varchar column */
+	if (typid != tce->btree_opintype)
+		col->expr = (Expr *)
+			makeRelabelType(col->expr, tce->btree_opintype, -1, collid, COERCE_IMPLICIT_CAST);
+
+	return true;
+}
+
+static Expr *
+column_stats_make_bound(const ColumnStatsExclusion *col, Oid opno, const bytea *value)
+{
+	Const *bound = makeConst(col->opintype,
+							 -1,
+							 col->var->varcollid,
+							 col->typlen,
+							 ts_chunk_column_stats_decode(value, col->var->vartype),
+							 false,
+							 col->typbyval);
+
+	return make_opclause(opno,
+						 BOOLOID,
+						 false,
+						 copyObject(col->expr),
+						 (Expr *) bound,
+						 InvalidOid,
+						 col->var->varcollid);
+}
+
+static NullTest *
+column_stats_make_nulltest(const ColumnStatsExclusion *col, NullTestType nulltesttype)
+{
+	NullTest *nulltest = makeNode(NullTest);
+
+	nulltest->arg = (Expr *) copyObject(col->var);
+	nulltest->nulltesttype = nulltesttype;
+	nulltest->argisrow = false;
+	nulltest->location = -1;
+
+	return nulltest;
+}
+
+/*
+ * Exclude the compressed chunks whose column ranges contradict the
+ * restrictions, the same way as PostgreSQL excludes relations by their CHECK
+ * constraints. The ranges are recorded when the chunks are compressed (see
+ * chunk_column_stats.c), so they are not used for partial chunks.
+ *
+ * The plan depends on the chunk status, so a plan that excluded chunks is
+ * invalidated together with the hypertable cache, e.g., when a chunk becomes
+ * partial.
+ */
+static void
+exclude_chunks_by_column_stats(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
+							   List *restrictions, Chunk **chunks, unsigned int *num_chunks)
+{
+	ColumnStatsExclusion *columns;
+	Bitmapset *attnos = NULL;
+	int num_columns = 0;
+	unsigned int num_kept = 0;
+	List *stats_list;
+	HASHCTL hashctl;
+	HTAB *htab;
+	ListCell *lc;
+
+	if (!ts_guc_enable_chunk_skipping || restrictions == NIL || *num_chunks == 0 ||
+		hypertable_is_distributed(ht) || !TS_HYPERTABLE_HAS_COMPRESSION_TABLE(ht))
+		return;
+
+	stats_list = ts_chunk_column_stats_get_by_hypertable_id(ht->fd.id);
+
+	if (stats_list == NIL)
+		return;
+
+	foreach (lc, restrictions)
+		pull_varattnos((Node *) castNode(RestrictInfo, lfirst(lc))->clause, rel->relid, &attnos);
+
+	/* The rows of the hypertable come first and tell the tracked columns */
+	columns = palloc(sizeof(ColumnStatsExclusion) * list_length(stats_list));
+
+	foreach (lc, stats_list)
+	{
+		ChunkColumnStats *stats = lfirst(lc);
+		ColumnStatsExclusion *col = &columns[num_columns];
+
+		if (stats->chunk_id != CHUNK_COLUMN_STATS_HYPERTABLE_CHUNK_ID)
+			break;
+
+		if (column_stats_exclusion_init(col, ht, rel->relid, NameStr(stats->column_name)) &&
+			bms_is_member(col->var->varattno - FirstLowInvalidHeapAttributeNumber, attnos))
+			num_columns++;
+	}
+
+	if (num_columns == 0)
+		return;
+
+	hashctl.keysize = sizeof(int32);
+	hashctl.entrysize = sizeof(ChunkColumnStatsEntry);
+	hashctl.hcxt = CurrentMemoryContext;
+	htab = hash_create("chunk column stats",
+					   list_length(stats_list),
+					   &hashctl,
+					   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	foreach (lc, stats_list)
+	{
+		ChunkColumnStats *stats = lfirst(lc);
+		ChunkColumnStatsEntry *entry;
+		bool found;
+
+		if (stats->chunk_id == CHUNK_COLUMN_STATS_HYPERTABLE_CHUNK_ID)
+			continue;
+
+		entry = hash_search(htab, &stats->chunk_id, HASH_ENTER, &found);
+		if (!found)
+			entry->stats = NIL;
+		entry->stats = lappend(entry->stats, stats);
+	}
+
+	for (unsigned int i = 0; i < *num_chunks; i++)
+	{
+		Chunk *chunk = chunks[i];
+		ChunkColumnStatsEntry *entry = NULL;
+		List *constraints = NIL;
+
+		if (ts_chunk_is_compressed(chunk) && !ts_chunk_is_partial(chunk))
+			entry = hash_search(htab, &chunk->fd.id, HASH_FIND, NULL);
+
+		for (int j = 0; entry != NULL && j < num_columns; j++)
+		{
+			ColumnStatsExclusion *col = &columns[j];
+			ListCell *lc_stats;
+
+			foreach (lc_stats, entry->stats)
+			{
+				ChunkColumnStats *stats = lfirst(lc_stats);
+
+				if (namestrcmp(&stats->column_name, NameStr(col->column_name)) != 0)
+					continue;
+
+				if (stats->range_start != NULL && stats->range_end != NULL)
+				{
+					constraints =
+						lappend(constraints,
+								column_stats_make_bound(col, col->ge_opno, stats->range_start));
+					constraints =
+						lappend(constraints,
+								column_stats_make_bound(col, col->le_opno, stats->range_end));
+					if (!stats->has_nulls)
+						constraints =
+							lappend(constraints, column_stats_make_nulltest(col, IS_NOT_NULL));
+				}
+				else if (stats->has_nulls)
+					constraints = lappend(constraints, column_stats_make_nulltest(col, IS_NULL));
+			}
+		}
+
+		if (constraints != NIL && predicate_refuted_by(constraints, restrictions, false))
+			continue;
+
+		chunks[num_kept++] = chunk;
+	}
+
+	if (num_kept < *num_chunks)
+		root->glob->relationOids =
+			lappend_oid(root->glob->relationOids,
+						ts_catalog_get_cache_proxy_id(ts_catalog_get(), CACHE_TYPE_HYPERTABLE));
+
+	*num_chunks = num_kept;
+	hash_destroy(htab);
+}
+
+/*
+ * Check if a clause compares a dimension column with an expression that is
+ * only known at execution time, like a parameter of a generic plan, the
+ * result of an initplan or a stable function.
+ */
+static bool
+is_runtime_dimension_restriction(RelOptInfo *rel, Hypertable *ht, Expr *clause)
+{
+	List *args;
+	Expr *leftop, *rightop, *expr;
+	Var *var;
+
+	if (IsA(clause, OpExpr))
+		args = castNode(OpExpr, clause)->args;
+	else if (IsA(clause, ScalarArrayOpExpr))
+		args = castNode(ScalarArrayOpExpr, clause)->args;
+	else
+		return false;
+
+	if (list_length(args) != 2)
+		return false;
+
+	leftop = linitial(args);
+	rightop = lsecond(args);
+
+	if (IsA(leftop, RelabelType))
+		leftop = castNode(RelabelType, leftop)->arg;
+	if (IsA(rightop, RelabelType))
+		rightop = castNode(RelabelType, rightop)->arg;
+
+	if (IsA(leftop, Var))
+	{
+		var = castNode(Var, leftop);
+		expr = rightop;
+	}
+	else if (IsA(rightop, Var))
+	{
+		var = castNode(Var, rightop);
+		expr = leftop;
+	}
+	else
+		return false;
+
+	if ((Index) var->varno != rel->relid || var->varlevelsup != 0)
+		return false;
+
+	for (int i = 0; i < ht->space->num_dimensions; i++)
+	{
+		if (ht->space->dimensions[i].column_attno != var->varattno)
+			continue;
+
+		return !IsA(expr, Const) && !contain_var_clause((Node *) expr) &&
+			   !contain_volatile_functions((Node *) expr) &&
+			   (ts_contain_param((Node *) expr) || contain_mutable_functions((Node *) expr));
+	}
+
+	return false;
+}
+
+/*
+ * Check if the chunks of the hypertable should be resolved only at execution
+ * time by ChunkAppend instead of being expanded here.
+ *
+ * Expanding opens and locks every chunk that survives plan-time exclusion and
+ * builds a child relation with index paths for it. When the restrictions on
+ * the dimensions are only known at execution time, this is every chunk of the
+ * hypertable, most of which runtime exclusion then throws away. So if no chunk
+ * can be excluded at planning time but some can at execution time, ChunkAppend
+ * scans the hypertable itself and finds the matching chunks when it runs.
+ */
+static bool
+should_expand_lazily(CollectQualCtx *ctx, PlannerInfo *root, RelOptInfo *rel, Hypertable *ht)
+{
+	HypertableRestrictInfo *hri;
+	ListCell *lc;
+	int order_attno;
+	bool reverse;
+	bool has_runtime_restriction = false;
+
+	if (!ts_guc_enable_lazy_chunk_expansion || !ts_guc_enable_chunk_append ||
+		ctx->chunk_exclusion_func != NULL || ctx->chunk_ids_restricted ||
+		root->parse->commandType != CMD_SELECT ||
+		rel->fdw_private == NULL || hypertable_is_distributed(ht) ||
+		TS_HYPERTABLE_HAS_COMPRESSION_ENABLED(ht))
+		return false;
+
+	foreach (lc, ctx->restrictions)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		if (is_runtime_dimension_restriction(rel, ht, rinfo->clause))
+		{
+			has_runtime_restriction = true;
+			break;
+		}
+	}
+
+	if (!has_runtime_restriction)
+		return false;
+
+	/* Prefer expanding the chunks if some of them can be excluded already */
+	hri = ts_hypertable_restrict_info_create(rel, ht);
+	ts_hypertable_restrict_info_add(hri, root, ctx->restrictions);
+
+	if (ts_hypertable_restrict_info_has_restrictions(hri))
+		return false;
+
+	/* Ordered append needs the chunks at planning time */
+	if (should_order_append(root, rel, ht, ctx->join_conditions, &order_attno, &reverse))
+		return false;
+
+	/* The OSM chunk is a foreign table that has to be scanned through its FDW */
+	return ts_chunk_get_osm_chunk_id(ht->fd.id) == INVALID_CHUNK_ID;
+}
+
+/*
+ * Estimate the size of a hypertable that is not expanded from the statistics
+ * of its chunks, since there are no child relations to take them from.
+ */
+static void
+set_lazy_rel_size(PlannerInfo *root, RelOptInfo *rel, Oid parent_oid)
+{
+	List *children = find_inheritance_children(parent_oid, NoLock);
+	double pages = 0;
+	double tuples = 0;
+	ListCell *lc;
+
+	foreach (lc, children)
+	{
+		HeapTuple tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(lfirst_oid(lc)));
+		Form_pg_class form;
+
+		if (!HeapTupleIsValid(tuple))
+			continue;
+
+		form = (Form_pg_class) GETSTRUCT(tuple);
+		pages += form->relpages;
+		/* reltuples is -1 for tables that have never been analyzed */
+		if (form->reltuples > 0)
+			tuples += form->reltuples;
+		ReleaseSysCache(tuple);
+	}
+
+	rel->pages = (BlockNumber) Min(pages, (double) MaxBlockNumber);
+	rel->tuples = tuples;
+	set_baserel_size_estimates(root, rel);
+}
+
 /*
  * Create partition expressions for a hypertable.
  *
@@ -1289,6 +1852,211 @@ build_hypertable_partition_info(Hypertable *ht, PlannerInfo *root, RelOptInfo *h
 	hyper_rel->part_rels = palloc0(sizeof(*hyper_rel->part_rels) * nparts);
 }
 
+/*
+ * Check if the hypertable can be planned as a range partitioned table so that
+ * PostgreSQL considers a partitionwise join, i.e., a join of every chunk with
+ * the matching chunk of another hypertable.
+ *
+ * This requires a hypertable with only a time dimension that is joined on its
+ * time column. The partition scheme makes PostgreSQL build partition pruning
+ * info for Appends with runtime restrictions on the partition key, which only
+ * works for real partitioned tables, so those queries are left alone.
+ */
+static bool
+should_plan_chunkwise_join(CollectQualCtx *ctx, PlannerInfo *root, RelOptInfo *rel,
+						   Hypertable *ht, Chunk **chunks, unsigned int num_chunks)
+{
+	const Dimension *dim = &ht->space->dimensions[0];
+	bool has_time_join = false;
+	ListCell *lc;
+
+	if (!ts_guc_enable_chunkwise_join || !enable_partitionwise_join || num_chunks == 0 ||
+		root->parse->commandType != CMD_SELECT || hypertable_is_distributed(ht) ||
+		has_partialize_function(root->parse, TS_DO_NOT_FIX_AGGREF) ||
+		ht->space->num_dimensions != 1 || dim->partitioning != NULL ||
+		ts_get_private_reloptinfo(rel)->appends_ordered)
+		return false;
+
+	foreach (lc, ctx->join_conditions)
+	{
+		OpExpr *op = lfirst_node(OpExpr, lc);
+		Var *left = linitial_node(Var, op->args);
+		Var *right = lsecond_node(Var, op->args);
+		Var *ht_var = (Index) left->varno == rel->relid ? left : right;
+
+		if (ht_var->varattno == dim->column_attno)
+		{
+			has_time_join = true;
+			break;
+		}
+	}
+
+	if (!has_time_join)
+		return false;
+
+	foreach (lc, ctx->restrictions)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		if (contain_mutable_functions((Node *) rinfo->clause) ||
+			ts_contain_param((Node *) rinfo->clause))
+			return false;
+	}
+
+	for (unsigned int i = 0; i < num_chunks; i++)
+	{
+		const DimensionSlice *slice = chunks[i]->cube->slices[0];
+
+		/* The OSM chunk can cover any range of time */
+		if (IS_OSM_CHUNK(chunks[i]) || slice->fd.range_start == DIMENSION_SLICE_MINVALUE ||
+			slice->fd.range_end == DIMENSION_SLICE_MAXVALUE)
+			return false;
+	}
+
+	return true;
+}
+
+static int
+chunk_cmp_time_slice(const void *a, const void *b)
+{
+	const Chunk *ca = *((const Chunk **) a);
+	const Chunk *cb = *((const Chunk **) b);
+	int64 start_a = ca->cube->slices[0]->fd.range_start;
+	int64 start_b = cb->cube->slices[0]->fd.range_start;
+
+	if (start_a == start_b)
+		return 0;
+
+	return start_a < start_b ? -1 : 1;
+}
+
+/*
+ * Get the range partition scheme for a time partitioning key.
+ *
+ * PostgreSQL only joins relations partitionwise if they share the same
+ * partition scheme, so a matching scheme in root->part_schemes is reused like
+ * find_partition_scheme() does for partitioned tables.
+ */
+static PartitionScheme
+get_time_partition_scheme(PlannerInfo *root, Oid keytype, Oid collation)
+{
+	PartitionScheme part_scheme;
+	Oid opclass = GetDefaultOpClass(keytype, BTREE_AM_OID);
+	Oid opfamily;
+	Oid opcintype;
+	ListCell *lc;
+
+	if (!OidIsValid(opclass))
+		return NULL;
+
+	opfamily = get_opclass_family(opclass);
+	opcintype = get_opclass_input_type(opclass);
+
+	foreach (lc, root->part_schemes)
+	{
+		part_scheme = lfirst(lc);
+
+		if (part_scheme->strategy == PARTITION_STRATEGY_RANGE && part_scheme->partnatts == 1 &&
+			part_scheme->partopfamily[0] == opfamily &&
+			part_scheme->partopcintype[0] == opcintype &&
+			part_scheme->partcollation[0] == collation)
+			return part_scheme;
+	}
+
+	part_scheme = palloc0(sizeof(PartitionSchemeData));
+	part_scheme->strategy = PARTITION_STRATEGY_RANGE;
+	part_scheme->partnatts = 1;
+	part_scheme->partopfamily = palloc(sizeof(Oid));
+	part_scheme->partopfamily[0] = opfamily;
+	part_scheme->partopcintype = palloc(sizeof(Oid));
+	part_scheme->partopcintype[0] = opcintype;
+	part_scheme->partcollation = palloc(sizeof(Oid));
+	part_scheme->partcollation[0] = collation;
+	part_scheme->parttyplen = palloc(sizeof(int16));
+	part_scheme->parttypbyval = palloc(sizeof(bool));
+	get_typlenbyval(keytype, &part_scheme->parttyplen[0], &part_scheme->parttypbyval[0]);
+	part_scheme->partsupfunc = palloc0(sizeof(FmgrInfo));
+	fmgr_info(get_opfamily_proc(opfamily, opcintype, opcintype, BTORDER_PROC),
+			  &part_scheme->partsupfunc[0]);
+
+	root->part_schemes = lappend(root->part_schemes, part_scheme);
+
+	return part_scheme;
+}
+
+/*
+ * Range partition info for hypertables with only a time dimension.
+ *
+ * The chunks have to be sorted by time since PostgreSQL takes the partitions
+ * of a range partitioned table to be in bound order, e.g., when it builds an
+ * ordered Append. Time slices that are not adjacent leave a gap in the bounds,
+ * which is marked with a partition index of -1 like PostgreSQL does.
+ */
+static bool
+build_hypertable_range_partition_info(Hypertable *ht, PlannerInfo *root, RelOptInfo *hyper_rel,
+									  Chunk **chunks, unsigned int num_chunks)
+{
+	const Dimension *dim = &ht->space->dimensions[0];
+	Oid keytype = ts_dimension_get_partition_type(dim);
+	List **partexprs = get_hypertable_partexprs(ht, root->parse, hyper_rel->relid);
+	PartitionScheme part_scheme;
+	PartitionBoundInfo boundinfo;
+	int ndatums = 0;
+
+	if (linitial(partexprs[0]) == NULL)
+		return false;
+
+	part_scheme = get_time_partition_scheme(root, keytype, exprCollation(linitial(partexprs[0])));
+
+	if (part_scheme == NULL)
+		return false;
+
+	boundinfo = palloc0(sizeof(PartitionBoundInfoData));
+	boundinfo->strategy = PARTITION_STRATEGY_RANGE;
+	boundinfo->datums = palloc(sizeof(Datum *) * num_chunks * 2);
+	boundinfo->kind = palloc(sizeof(PartitionRangeDatumKind *) * num_chunks * 2);
+	boundinfo->indexes = palloc(sizeof(int) * (num_chunks * 2 + 1));
+	boundinfo->null_index = -1;
+	boundinfo->default_index = -1;
+
+	for (unsigned int i = 0; i < num_chunks; i++)
+	{
+		const DimensionSlice *slice = chunks[i]->cube->slices[0];
+		int64 bounds[2] = { slice->fd.range_start, slice->fd.range_end };
+
+		for (int j = 0; j < 2; j++)
+		{
+			bool is_upper = (j == 1);
+
+			/* The lower bound of a chunk is the upper bound of an adjacent chunk */
+			if (!is_upper && i > 0 && chunks[i - 1]->cube->slices[0]->fd.range_end == bounds[j])
+				continue;
+
+			boundinfo->datums[ndatums] = palloc(sizeof(Datum));
+			boundinfo->datums[ndatums][0] = ts_internal_to_time_value(bounds[j], keytype);
+			boundinfo->kind[ndatums] = palloc(sizeof(PartitionRangeDatumKind));
+			boundinfo->kind[ndatums][0] = PARTITION_RANGE_DATUM_VALUE;
+			boundinfo->indexes[ndatums] = is_upper ? (int) i : -1;
+			ndatums++;
+		}
+	}
+
+	boundinfo->ndatums = ndatums;
+	boundinfo->indexes[ndatums] = -1;
+#if PG14_GE
+	boundinfo->nindexes = ndatums + 1;
+#endif
+
+	hyper_rel->part_scheme = part_scheme;
+	hyper_rel->boundinfo = boundinfo;
+	hyper_rel->nparts = num_chunks;
+	hyper_rel->partexprs = partexprs;
+	hyper_rel->nullable_partexprs = (List **) palloc0(sizeof(List *));
+	hyper_rel->part_rels = palloc0(sizeof(*hyper_rel->part_rels) * num_chunks);
+
+	return true;
+}
+
 static bool
 timebucket_annotate_walker(Node *node, CollectQualCtx *ctx)
 {
@@ -1361,6 +2129,8 @@ ts_plan_expand_hypertable_chunks(Hypertable *ht, PlannerInfo *root, RelOptInfo *
 		.join_level = 0,
 	};
 	Index first_chunk_index = 0;
+	unsigned int num_matching_chunks;
+	instr_time start;
 
 	/* double check our permissions are valid */
 	Assert(rti != (Index) parse->resultRelation);
@@ -1382,12 +2152,35 @@ ts_plan_expand_hypertable_chunks(Hypertable *ht, PlannerInfo *root, RelOptInfo *
 	if (ctx.propagate_conditions != NIL)
 		propagate_join_quals(root, rel, &ctx);
 
+	if (should_expand_lazily(&ctx, root, rel, ht))
+	{
+		priv->expand_lazily = true;
+		set_lazy_rel_size(root, rel, parent_oid);
+		return;
+	}
+
 	Chunk **chunks = NULL;
 	unsigned int num_chunks = 0;
 	chunks = get_chunks(&ctx, root, rel, ht, &num_chunks);
 	/* Can have zero chunks. */
 	Assert(num_chunks == 0 || chunks != NULL);
 
+	num_matching_chunks = num_chunks;
+	ts_planner_timing_start(&start);
+	exclude_chunks_by_column_stats(root, rel, ht, ctx.restrictions, chunks, &num_chunks);
+	ts_planner_timing_stop(PLANNER_TIMING_CHUNK_EXCLUSION,
+						   &start,
+						   num_matching_chunks - num_chunks);
+
+	ts_planner_timing_start(&start);
+
+	/* The children of a range partitioned table have to be in bound order */
+	if (should_plan_chunkwise_join(&ctx, root, rel, ht, chunks, num_chunks))
+	{
+		qsort(chunks, num_chunks, sizeof(Chunk *), chunk_cmp_time_slice);
+		priv->chunkwise_join = true;
+	}
+
 	for (unsigned int i = 0; i < num_chunks; i++)
 	{
 		inh_oids = lappend_oid(inh_oids, chunks[i]->table_id);
@@ -1414,10 +2207,15 @@ ts_plan_expand_hypertable_chunks(Hypertable *ht, PlannerInfo *root, RelOptInfo *
 
 	/* Adding partition info will make PostgreSQL consider the inheritance
 	 * children as part of a partitioned relation. This will enable
-	 * partitionwise aggregation. */
-	if ((enable_partitionwise_aggregate &&
-		 !has_partialize_function(root->parse, TS_DO_NOT_FIX_AGGREF)) ||
-		hypertable_is_distributed(ht))
+	 * partitionwise joins and aggregation. */
+	if (priv->chunkwise_join)
+		priv->chunkwise_join =
+			build_hypertable_range_partition_info(ht, root, rel, chunks, num_chunks);
+
+	if (!priv->chunkwise_join &&
+		((enable_partitionwise_aggregate &&
+		  !has_partialize_function(root->parse, TS_DO_NOT_FIX_AGGREF)) ||
+		 hypertable_is_distributed(ht)))
 	{
 		build_hypertable_partition_info(ht, root, rel, list_length(inh_oids));
 	}
@@ -1543,6 +2341,8 @@ ts_plan_expand_hypertable_chunks(Hypertable *ht, PlannerInfo *root, RelOptInfo *
 		ts_get_private_reloptinfo(child_rel)->chunk = chunks[i];
 		Assert(chunks[i]->table_id == root->simple_rte_array[child_rtindex]->relid);
 	}
+
+	ts_planner_timing_stop(PLANNER_TIMING_CHILD_EXPANSION, &start, list_length(inh_oids));
 }
 
 void
@@ -28,6 +28,7 @@
 #include <utils/memutils.h>
 #include <utils/selfuncs.h>
 #include <utils/timestamp.h>
+#include <utils/typcache.h>
 
 #include "compat/compat-msvc-enter.h"
 #include <catalog/pg_constraint.h>
@@ -50,6 +51,7 @@
 #include "extension.h"
 #include "func_cache.h"
 #include "guc.h"
+#include "hypercube.h"
 #include "hypertable_cache.h"
 #include "import/allpaths.h"
 #include "license_guc.h"
@@ -59,6 +61,7 @@
 #include "nodes/hypertable_modify.h"
 #include "partitioning.h"
 #include "planner/planner.h"
+#include "planner/planner_timing.h"
 #include "utils.h"
 
 #include "compat/compat.h"
@@ -194,6 +197,71 @@ ts_rte_is_marked_for_expansion(const RangeTblEntry *rte)
 	return strcmp(rte->ctename, TS_CTE_EXPAND) == 0;
 }
 
+/*
+ * Relations that are known to be neither hypertables nor chunks.
+ *
+ * The hypertable cache remembers that a relation is not a hypertable, but
+ * telling whether it is a chunk takes a scan of the chunk catalog, which was
+ * done for every plain table in every query. Once a relation is known to be
+ * plain, the planner skips both lookups for it.
+ *
+ * The set lives for the whole backend. An entry is removed when the relcache
+ * entry of the relation is invalidated, which happens whenever a table is
+ * turned into a chunk or dropped, and the set is reset together with the
+ * hypertable cache.
+ */
+#define PLAIN_RELATIONS_MAX 10000
+
+static HTAB *plain_relations = NULL;
+
+static bool
+plain_relation_is_known(Oid relid)
+{
+	return plain_relations != NULL && hash_search(plain_relations, &relid, HASH_FIND, NULL) != NULL;
+}
+
+static void
+plain_relation_add(Oid relid)
+{
+	if (plain_relations == NULL)
+	{
+		HASHCTL ctl = {
+			.keysize = sizeof(Oid),
+			.entrysize = sizeof(Oid),
+			.hcxt = CacheMemoryContext,
+		};
+
+		plain_relations = hash_create("TimescaleDB plain relations",
+									  64,
+									  &ctl,
+									  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	/* When the set is full, the relation is just not remembered */
+	if (hash_get_num_entries(plain_relations) < PLAIN_RELATIONS_MAX)
+		hash_search(plain_relations, &relid, HASH_ENTER, NULL);
+}
+
+/*
+ * Forget that a relation is plain, or all of them for InvalidOid. This is
+ * called from the relcache invalidation callback, so it must not access the
+ * catalog.
+ */
+void
+ts_planner_plain_relations_invalidate(Oid relid)
+{
+	if (plain_relations == NULL)
+		return;
+
+	if (OidIsValid(relid))
+		hash_search(plain_relations, &relid, HASH_REMOVE, NULL);
+	else
+	{
+		hash_destroy(plain_relations);
+		plain_relations = NULL;
+	}
+}
+
 /*
  * Planner-global hypertable cache.
  *
@@ -317,6 +385,8 @@ typedef struct
  * 3. Reordering of GROUP BY clauses for continuous aggregates.
  *
  * 4. Constifying now() expressions for primary time dimension.
+ *
+ * 5. Answering last() queries from the last point cache of the hypertable.
  */
 static bool
 preprocess_query(Node *node, PreprocessQueryContext *context)
@@ -376,9 +446,20 @@ preprocess_query(Node *node, PreprocessQueryContext *context)
 					}
 					break;
 				case RTE_RELATION:
+					if (plain_relation_is_known(rte->relid))
+						break;
+
 					/* This lookup will warm the cache with all hypertables in the query */
 					ht = ts_hypertable_cache_get_entry(hcache, rte->relid, CACHE_FLAG_MISSING_OK);
 
+					/* The query now reads the cache, which is a plain table */
+					if (ht && ts_last_point_rewrite_query(query, ht))
+						break;
+
+					/* The query still reads the hypertable, with DISTINCT ON instead of GROUP BY */
+					if (ht)
+						ts_first_last_distinct_rewrite_query(query, ht);
+
 					if (ht)
 					{
 						/* Mark hypertable RTEs we'd like to expand ourselves */
@@ -417,6 +498,8 @@ preprocess_query(Node *node, PreprocessQueryContext *context)
 						Chunk *chunk = ts_chunk_get_by_relid(rte->relid, false);
 						if (chunk && rte->inh)
 							rte_mark_for_expansion(rte);
+						else if (chunk == NULL)
+							plain_relation_add(rte->relid);
 					}
 					break;
 				default:
@@ -449,6 +532,7 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 	 * modified between setjmp/longjmp calls.
 	 */
 	volatile bool reset_fetcher_type = false;
+	volatile bool reset_partitionwise_agg = false;
 	volatile bool reset_baserel_info = false;
 
 	/*
@@ -483,6 +567,7 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 		ts_baserel_info = BaserelInfo_create(CurrentMemoryContext,
 											 /* nelements = */ 1,
 											 /* private_data = */ NULL);
+		ts_planner_timing_begin();
 	}
 
 	PG_TRY();
@@ -546,6 +631,15 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 										 "queries with multiple distributed hypertables."
 										 " Use cursor fetcher instead.")));
 					}
+					if (ts_guc_remote_data_fetcher == ColumnarFetcherType)
+					{
+						ereport(ERROR,
+								(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								 errmsg("columnar fetcher not supported"),
+								 errhint("Columnar fetching of data is not supported in "
+										 "queries with multiple distributed hypertables."
+										 " Use cursor fetcher instead.")));
+					}
 					ts_data_node_fetcher_scan_type = CursorFetcherType;
 				}
 				else
@@ -560,6 +654,22 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 					}
 				}
 			}
+
+			/*
+			 * Without partitionwise aggregation, PostgreSQL only aggregates
+			 * on top of the data node scans, so all raw rows have to be
+			 * transferred to the access node. With it, the aggregation is
+			 * pushed down in full when the GROUP BY covers the partitioning
+			 * of the data nodes and otherwise split into partial aggregates
+			 * on the data nodes and a finalize step on the access node. Like
+			 * the fetcher type, this is only set at the topmost level.
+			 */
+			if (context.num_distributed_tables > 0 && ts_guc_enable_dist_partial_agg &&
+				!enable_partitionwise_aggregate)
+			{
+				enable_partitionwise_aggregate = true;
+				reset_partitionwise_agg = true;
+			}
 		}
 
 		if (prev_planner_hook != NULL)
@@ -603,12 +713,16 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 			Assert(ts_baserel_info != NULL);
 			BaserelInfo_destroy(ts_baserel_info);
 			ts_baserel_info = NULL;
+			ts_planner_timing_end(true);
 		}
 
 		if (reset_fetcher_type)
 		{
 			ts_data_node_fetcher_scan_type = AutoFetcherType;
 		}
+
+		if (reset_partitionwise_agg)
+			enable_partitionwise_aggregate = false;
 	}
 	PG_CATCH();
 	{
@@ -617,6 +731,7 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 			Assert(ts_baserel_info != NULL);
 			BaserelInfo_destroy(ts_baserel_info);
 			ts_baserel_info = NULL;
+			ts_planner_timing_end(false);
 		}
 
 		if (reset_fetcher_type)
@@ -624,6 +739,9 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 			ts_data_node_fetcher_scan_type = AutoFetcherType;
 		}
 
+		if (reset_partitionwise_agg)
+			enable_partitionwise_aggregate = false;
+
 		/* Pop the cache, but do not release since caches are auto-released on
 		 * error */
 		planner_hcache_pop(false);
@@ -744,7 +862,7 @@ classify_relation(const PlannerInfo *root, const RelOptInfo *rel, Hypertable **h
 
 	RangeTblEntry *rte = planner_rt_fetch(rel->relid, root);
 
-	if (!OidIsValid(rte->relid))
+	if (!OidIsValid(rte->relid) || plain_relation_is_known(rte->relid))
 	{
 		return TS_REL_OTHER;
 	}
@@ -981,6 +1099,16 @@ reenable_inheritance(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntr
 			Assert(ht != NULL && in_rel != NULL);
 			ts_plan_expand_hypertable_chunks(ht, root, in_rel);
 
+			/*
+			 * A hypertable that is expanded lazily stays a plain relation
+			 * that ChunkAppend scans, so it must not be expanded again.
+			 */
+			if (ts_get_private_reloptinfo(in_rel)->expand_lazily)
+			{
+				in_rte->ctename = NULL;
+				continue;
+			}
+
 			in_rte->inh = true;
 			reenabled_inheritance = true;
 			/* Redo set_rel_consider_parallel, as results of the call may no longer be valid
@@ -1076,6 +1204,25 @@ reenable_inheritance(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntr
 	}
 }
 
+static List *
+remove_parameterized_append_paths(List *pathlist)
+{
+	List *new_pathlist = NIL;
+	ListCell *lc;
+
+	foreach (lc, pathlist)
+	{
+		Path *path = lfirst(lc);
+
+		if (IsA(path, AppendPath) && path->param_info != NULL)
+			continue;
+
+		new_pathlist = lappend(new_pathlist, path);
+	}
+
+	return new_pathlist;
+}
+
 static void
 apply_optimizations(PlannerInfo *root, TsRelType reltype, RelOptInfo *rel, RangeTblEntry *rte,
 					Hypertable *ht)
@@ -1124,6 +1271,28 @@ apply_optimizations(PlannerInfo *root, TsRelType reltype, RelOptInfo *rel, Range
 
 		Assert(ht != NULL);
 
+		/*
+		 * The paths of a lazily expanded hypertable scan only the empty root
+		 * table, so replace them with a ChunkAppend that finds the chunks at
+		 * execution time.
+		 */
+		if (private->expand_lazily)
+		{
+			rel->pathlist = NIL;
+			rel->partial_pathlist = NIL;
+			add_path(rel, ts_chunk_append_lazy_path_create(root, rel, ht));
+			return;
+		}
+
+		/*
+		 * PostgreSQL adds partition pruning info to parameterized Appends of a
+		 * partitioned relation, which the executor can only set up for real
+		 * partitioned tables. A chunk-wise join scans the chunks with
+		 * parameterized paths instead.
+		 */
+		if (private->chunkwise_join)
+			rel->pathlist = remove_parameterized_append_paths(rel->pathlist);
+
 		foreach (lc, rel->pathlist)
 		{
 			Path **pathptr = (Path **) &lfirst(lc);
@@ -1184,6 +1353,146 @@ dml_involves_hypertable(PlannerInfo *root, Hypertable *ht, Index rti)
 	return result_rti == rti || ht->main_table_relid == result_rte->relid;
 }
 
+#if PG14_GE
+static bool
+relation_has_delete_triggers(Oid relid)
+{
+	Relation rel = table_open(relid, NoLock);
+	TriggerDesc *trigdesc = rel->trigdesc;
+	bool result = trigdesc != NULL &&
+				  (trigdesc->trig_delete_before_row || trigdesc->trig_delete_after_row ||
+				   trigdesc->trig_delete_instead_row || trigdesc->trig_delete_old_table);
+
+	table_close(rel, NoLock);
+	return result;
+}
+
+/*
+ * Check if a DELETE removes all the rows of a chunk, in which case the chunk
+ * can be truncated instead of having its rows deleted one by one.
+ *
+ * This is the case when every restriction on the chunk compares the time
+ * column with a constant and the time range of the chunk lies within the
+ * range these comparisons select. Anything that needs to see the deleted rows,
+ * like RETURNING or row triggers, or a join with other relations, prevents
+ * the truncation.
+ */
+static bool
+delete_covers_chunk(PlannerInfo *root, RelOptInfo *rel, RangeTblEntry *rte, Hypertable *ht)
+{
+	const Dimension *dim = hyperspace_get_open_dimension(ht->space, 0);
+	const DimensionSlice *slice;
+	TypeCacheEntry *tce;
+	AttrNumber time_attno;
+	Oid time_type;
+	Chunk *chunk;
+	/* the selected range, the upper bound is exclusive */
+	int64 lower = PG_INT64_MIN;
+	int64 upper = PG_INT64_MAX;
+	ListCell *lc;
+
+	if (!ts_guc_enable_delete_truncation || root->parse->commandType != CMD_DELETE ||
+		root->parse->returningList != NIL || root->hasPseudoConstantQuals ||
+		bms_num_members(root->all_baserels) != 1 || hypertable_is_distributed(ht) ||
+		dim == NULL || dim->partitioning != NULL || rte->relkind != RELKIND_RELATION)
+		return false;
+
+	time_type = dim->fd.column_type;
+	time_attno = get_attnum(rte->relid, NameStr(dim->fd.column_name));
+	tce = lookup_type_cache(time_type, TYPECACHE_BTREE_OPFAMILY);
+
+	if (time_attno == InvalidAttrNumber || !OidIsValid(tce->btree_opf))
+		return false;
+
+	foreach (lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+		OpExpr *op = (OpExpr *) rinfo->clause;
+		Node *left, *right;
+		Var *var;
+		Const *c;
+		int strategy;
+		Oid lefttype, righttype;
+		int64 value;
+
+		if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+			return false;
+
+		left = linitial(op->args);
+		right = lsecond(op->args);
+
+		if (IsA(left, Var) && IsA(right, Const))
+		{
+			var = castNode(Var, left);
+			c = castNode(Const, right);
+		}
+		else if (IsA(left, Const) && IsA(right, Var))
+		{
+			var = castNode(Var, right);
+			c = castNode(Const, left);
+		}
+		else
+			return false;
+
+		if (var->varno != rel->relid || var->varattno != time_attno || var->vartype != time_type ||
+			c->consttype != time_type || c->constisnull ||
+			!op_in_opfamily(op->opno, tce->btree_opf))
+			return false;
+
+		get_op_opfamily_properties(op->opno,
+								   tce->btree_opf,
+								   false,
+								   &strategy,
+								   &lefttype,
+								   &righttype);
+
+		/* normalize the comparison to "time_column op constant" */
+		if ((Node *) var == right)
+			strategy = BTCommuteStrategyNumber(strategy);
+
+		value = ts_time_value_to_internal_or_infinite(c->constvalue, time_type, NULL);
+
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+				upper = Min(upper, value);
+				break;
+			case BTLessEqualStrategyNumber:
+				if (value < PG_INT64_MAX)
+					upper = Min(upper, value + 1);
+				break;
+			case BTEqualStrategyNumber:
+				lower = Max(lower, value);
+				if (value < PG_INT64_MAX)
+					upper = Min(upper, value + 1);
+				break;
+			case BTGreaterEqualStrategyNumber:
+				lower = Max(lower, value);
+				break;
+			case BTGreaterStrategyNumber:
+				lower = Max(lower, value < PG_INT64_MAX ? value + 1 : value);
+				break;
+			default:
+				return false;
+		}
+	}
+
+	chunk = ts_chunk_get_by_relid(rte->relid, false);
+
+	if (chunk == NULL || chunk->fd.compressed_chunk_id != INVALID_CHUNK_ID ||
+		ts_chunk_is_compressed(chunk))
+		return false;
+
+	slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+
+	if (slice == NULL || slice->fd.range_start < lower || slice->fd.range_end > upper)
+		return false;
+
+	return !relation_has_delete_triggers(rte->relid) &&
+		   !relation_has_delete_triggers(ht->main_table_relid);
+}
+#endif
+
 static void
 timescaledb_set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntry *rte)
 {
@@ -1226,6 +1535,20 @@ timescaledb_set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti, Rang
 			/* Check for UPDATE/DELETE (DML) on compressed chunks */
 			if (IS_UPDL_CMD(root->parse) && dml_involves_hypertable(root, ht, rti))
 			{
+#if PG14_GE
+				/* Chunks that a DELETE empties completely are truncated by
+				 * HypertableModify, so they need not be scanned */
+				if (reltype == TS_REL_CHUNK_CHILD && delete_covers_chunk(root, rel, rte, ht))
+				{
+					RelOptInfo *parent_rel = root->simple_rel_array[root->parse->resultRelation];
+					TimescaleDBPrivate *private = ts_get_private_reloptinfo(parent_rel);
+
+					private->truncated_chunk_oids =
+						lappend_oid(private->truncated_chunk_oids, rte->relid);
+					mark_dummy_rel(rel);
+					break;
+				}
+#endif
 				if (ts_cm_functions->set_rel_pathlist_dml != NULL)
 					ts_cm_functions->set_rel_pathlist_dml(root, rel, rti, rte, ht);
 				break;
@@ -1526,8 +1849,13 @@ timescaledb_create_upper_paths_hook(PlannerInfo *root, UpperRelationKind stage,
 	if (stage == UPPERREL_GROUP_AGG && output_rel != NULL)
 	{
 		if (!partials_found)
+		{
 			ts_plan_add_hashagg(root, input_rel, output_rel);
 
+			if (reltype == TS_REL_HYPERTABLE)
+				ts_plan_add_space_partitionwise_agg(root, input_rel, output_rel, ht);
+		}
+
 		if (parse->hasAggs)
 			ts_preprocess_first_last_aggregates(root, root->processed_tlist);
 	}
@@ -16,6 +16,7 @@
 #include "guc.h"
 
 #define CHUNK_EXCL_FUNC_NAME "chunks_in"
+#define CHUNK_ID_FROM_RELID_FUNC_NAME "chunk_id_from_relid"
 /*
  * Constraints created during planning to improve chunk exclusion
  * will be marked with this value as location so they can be easily
@@ -33,8 +34,14 @@ typedef struct TimescaleDBPrivate
 	/* attno of the time dimension in the parent table if appends are ordered */
 	int order_attno;
 	List *nested_oids;
+	/* chunks of the hypertable are resolved at execution time by ChunkAppend */
+	bool expand_lazily;
+	/* hypertable is planned as a range partitioned table for chunk-wise joins */
+	bool chunkwise_join;
 	bool compressed;
 	List *chunk_oids;
+	/* chunks of a DELETE that are truncated instead of scanned */
+	List *truncated_chunk_oids;
 	List *serverids;
 	Relids server_relids;
 	TsFdwRelInfo *fdw_relation_info;
@@ -99,7 +106,11 @@ bool has_partialize_function(Query *parse, PartializeAggFixAggref fix_aggref);
 bool ts_plan_process_partialize_agg(PlannerInfo *root, RelOptInfo *output_rel);
 
 extern void ts_plan_add_hashagg(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel);
+extern void ts_plan_add_space_partitionwise_agg(PlannerInfo *root, RelOptInfo *input_rel,
+												RelOptInfo *output_rel, const Hypertable *ht);
 extern void ts_preprocess_first_last_aggregates(PlannerInfo *root, List *tlist);
+extern bool ts_last_point_rewrite_query(Query *query, Hypertable *ht);
+extern bool ts_first_last_distinct_rewrite_query(Query *query, Hypertable *ht);
 extern void ts_plan_expand_hypertable_chunks(Hypertable *ht, PlannerInfo *root, RelOptInfo *rel);
 extern void ts_plan_expand_timebucket_annotate(PlannerInfo *root, RelOptInfo *rel);
 extern Node *ts_constify_now(PlannerInfo *root, List *rtable, Node *node);
@@ -107,5 +118,6 @@ extern void ts_planner_constraint_cleanup(PlannerInfo *root, RelOptInfo *rel);
 extern Node *ts_add_space_constraints(PlannerInfo *root, List *rtable, Node *node);
 
 extern void add_baserel_cache_entry_for_chunk(Oid chunk_reloid, Hypertable *hypertable);
+extern void ts_planner_plain_relations_invalidate(Oid relid);
 
 #endif /* TIMESCALEDB_PLANNER_H */
@@ -0,0 +1,175 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * Timing of the phases of the hypertable planning. The total planning time
+ * shown by EXPLAIN doesn't tell whether the time is spent on the query shape
+ * or on the number of chunks, so when timescaledb.enable_planner_timing is
+ * set, the chunk lookup, the loading of the chunk catalog data, the chunk
+ * exclusion and the expansion into the chunks are timed separately. The
+ * timings of the last planned query that expanded a hypertable are returned
+ * by _timescaledb_internal.planner_timing().
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <access/htup_details.h>
+#include <utils/builtins.h>
+
+#include "export.h"
+#include "planner/planner_timing.h"
+
+#define PLANNER_TIMING_NATTS 4
+
+typedef struct PlannerTimingCounter
+{
+	int64 calls;
+	int64 chunks;
+	instr_time time;
+} PlannerTimingCounter;
+
+static const char *planner_timing_phase_names[_PLANNER_TIMING_MAX] = {
+	[PLANNER_TIMING_CHUNK_LOOKUP] = "chunk_lookup",
+	[PLANNER_TIMING_CHUNK_LOAD] = "chunk_load",
+	[PLANNER_TIMING_CHUNK_EXCLUSION] = "chunk_exclusion",
+	[PLANNER_TIMING_CHILD_EXPANSION] = "child_expansion",
+};
+
+/* The counters of the query being planned */
+static PlannerTimingCounter current_counters[_PLANNER_TIMING_MAX];
+static instr_time current_start;
+static bool timing_active = false;
+
+/* The counters of the last planned query that expanded a hypertable */
+static PlannerTimingCounter last_counters[_PLANNER_TIMING_MAX];
+static instr_time last_planning_time;
+static bool have_last = false;
+
+/*
+ * Start timing a top-level planner call. The nested planner calls, e.g. for
+ * the SQL functions evaluated during planning, add to the same counters.
+ */
+void
+ts_planner_timing_begin(void)
+{
+	timing_active = ts_guc_enable_planner_timing;
+
+	if (!timing_active)
+		return;
+
+	memset(current_counters, 0, sizeof(current_counters));
+	INSTR_TIME_SET_CURRENT(current_start);
+}
+
+/*
+ * Finish timing a top-level planner call. The counters are kept only when
+ * the planning succeeded and timed something, so that querying the timings
+ * doesn't overwrite them.
+ */
+void
+ts_planner_timing_end(bool success)
+{
+	bool timed = false;
+
+	if (!timing_active)
+		return;
+
+	timing_active = false;
+
+	if (!success)
+		return;
+
+	for (int i = 0; i < _PLANNER_TIMING_MAX; i++)
+		timed |= current_counters[i].calls > 0;
+
+	if (!timed)
+		return;
+
+	INSTR_TIME_SET_CURRENT(last_planning_time);
+	INSTR_TIME_SUBTRACT(last_planning_time, current_start);
+	memcpy(last_counters, current_counters, sizeof(last_counters));
+	have_last = true;
+}
+
+/*
+ * Add the time since start to the phase. The chunks are the number of the
+ * chunks the phase produced or excluded.
+ */
+void
+ts_planner_timing_stop(PlannerTimingPhase phase, const instr_time *start, int64 chunks)
+{
+	instr_time duration;
+
+	if (!timing_active || INSTR_TIME_IS_ZERO(*start))
+		return;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, *start);
+	INSTR_TIME_ADD(current_counters[phase].time, duration);
+	current_counters[phase].calls++;
+	current_counters[phase].chunks += chunks;
+}
+
+/*
+ * The timings of the phases of the last planned query that expanded a
+ * hypertable, followed by its total planning time.
+ */
+TS_FUNCTION_INFO_V1(ts_planner_timing);
+
+Datum
+ts_planner_timing(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("function returning record called in context "
+							"that cannot accept type record")));
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->max_calls = have_last ? _PLANNER_TIMING_MAX + 1 : 0;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		Datum values[PLANNER_TIMING_NATTS];
+		bool nulls[PLANNER_TIMING_NATTS] = { false };
+		HeapTuple tuple;
+
+		if (funcctx->call_cntr < _PLANNER_TIMING_MAX)
+		{
+			const PlannerTimingCounter *counter = &last_counters[funcctx->call_cntr];
+
+			values[0] = CStringGetTextDatum(planner_timing_phase_names[funcctx->call_cntr]);
+			values[1] = Int64GetDatum(counter->calls);
+			values[2] = Int64GetDatum(counter->chunks);
+			values[3] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(counter->time));
+		}
+		else
+		{
+			values[0] = CStringGetTextDatum("planning");
+			values[1] = Int64GetDatum(1);
+			nulls[2] = true;
+			values[3] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(last_planning_time));
+		}
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
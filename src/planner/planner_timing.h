@@ -0,0 +1,44 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_PLANNER_TIMING_H
+#define TIMESCALEDB_PLANNER_TIMING_H
+
+#include <postgres.h>
+#include <portability/instr_time.h>
+
+#include "guc.h"
+
+/*
+ * The phases of the hypertable planning that are timed when
+ * timescaledb.enable_planner_timing is set.
+ */
+typedef enum PlannerTimingPhase
+{
+	/* Finding the ids of the chunks matching the dimension restrictions */
+	PLANNER_TIMING_CHUNK_LOOKUP,
+	/* Loading the catalog data of the matching chunks */
+	PLANNER_TIMING_CHUNK_LOAD,
+	/* Excluding the chunks by the column statistics and constraints */
+	PLANNER_TIMING_CHUNK_EXCLUSION,
+	/* Creating the range table entries and the rels of the chunks */
+	PLANNER_TIMING_CHILD_EXPANSION,
+	_PLANNER_TIMING_MAX,
+} PlannerTimingPhase;
+
+extern void ts_planner_timing_begin(void);
+extern void ts_planner_timing_end(bool success);
+extern void ts_planner_timing_stop(PlannerTimingPhase phase, const instr_time *start, int64 chunks);
+
+static inline void
+ts_planner_timing_start(instr_time *start)
+{
+	if (ts_guc_enable_planner_timing)
+		INSTR_TIME_SET_CURRENT(*start);
+	else
+		INSTR_TIME_SET_ZERO(*start);
+}
+
+#endif /* TIMESCALEDB_PLANNER_TIMING_H */
@@ -14,6 +14,7 @@
 #include <catalog/objectaddress.h>
 #include <catalog/pg_trigger.h>
 #include <commands/copy.h>
+#include <commands/progress.h>
 #include <commands/vacuum.h>
 #include <commands/defrem.h>
 #include <commands/trigger.h>
@@ -34,6 +35,11 @@
 #include <utils/guc.h>
 #include <utils/snapmgr.h>
 #include <parser/parse_utilcmd.h>
+#include <pgstat.h>
+#include <port/atomics.h>
+#include <postmaster/bgworker.h>
+#include <storage/dsm.h>
+#include <storage/latch.h>
 #include <commands/tablespace.h>
 
 #include <catalog/pg_constraint.h>
@@ -49,15 +55,18 @@
 #include "ts_catalog/catalog.h"
 #include "chunk.h"
 #include "chunk_index.h"
+#include "ts_catalog/chunk_column_stats.h"
 #include "ts_catalog/chunk_data_node.h"
 #include "compat/compat.h"
 #include "copy.h"
 #include "errors.h"
 #include "event_trigger.h"
 #include "extension.h"
+#include "guc.h"
 #include "hypercube.h"
 #include "hypertable.h"
 #include "hypertable_cache.h"
+#include "hypertable_stats.h"
 #include "ts_catalog/hypertable_data_node.h"
 #include "dimension_vector.h"
 #include "indexing.h"
@@ -106,6 +115,16 @@ prev_ProcessUtility(ProcessUtilityArgs *args)
 		 args->completion_tag);
 }
 
+/*
+ * Temporary tables can be neither hypertables nor chunks, so commands on them
+ * don't need to look them up in the catalog.
+ */
+static bool
+is_temp_relation(Oid relid)
+{
+	return get_rel_persistence(relid) == RELPERSISTENCE_TEMP;
+}
+
 static ObjectType
 get_altertable_objecttype(AlterTableStmt *stmt)
 {
@@ -634,7 +653,7 @@ process_copy(ProcessUtilityArgs *args)
 	{
 		relid = RangeVarGetRelid(stmt->relation, NoLock, true);
 
-		if (!OidIsValid(relid))
+		if (!OidIsValid(relid) || is_temp_relation(relid))
 			return DDL_CONTINUE;
 
 		ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_MISSING_OK, &hcache);
@@ -760,8 +779,19 @@ typedef struct VacuumCtx
 	VacuumRelation *ht_vacuum_rel;
 	List *chunk_rels;
 	List *chunk_pairs;
+	/* Add only the chunks changed since they were last analyzed */
+	bool only_changed;
+	List *merged_hypertables;
 } VacuumCtx;
 
+/* A hypertable whose statistics are merged from the ones of its chunks */
+typedef struct MergedHypertable
+{
+	Oid relid;
+	List *va_cols;
+	char *open_dim_column;
+} MergedHypertable;
+
 typedef struct ChunkPair
 {
 	Oid uncompressed_relid;
@@ -801,6 +831,17 @@ add_chunk_to_vacuum(Hypertable *ht, Oid chunk_relid, void *arg)
 	VacuumRelation *chunk_vacuum_rel;
 	RangeVar *chunk_range_var;
 
+	if (ctx->only_changed)
+	{
+		Oid analyzed_relid = chunk_relid;
+
+		if (chunk->fd.compressed_chunk_id != INVALID_CHUNK_ID)
+			analyzed_relid = ts_chunk_get_relid(chunk->fd.compressed_chunk_id, false);
+
+		if (ts_hypertable_stats_chunk_is_current(analyzed_relid))
+			return;
+	}
+
 	/* If the chunk has an associated compressed chunk, analyze that instead
 	 * When we compress a chunk, we save stats for the raw chunk, do
 	 * not modify that. Data now lives in the compressed chunk, so
@@ -909,6 +950,8 @@ process_vacuum(ProcessUtilityArgs *args)
 		.ht_vacuum_rel = NULL,
 		.chunk_rels = NIL,
 		.chunk_pairs = NIL,
+		.only_changed = false,
+		.merged_hypertables = NIL,
 	};
 	ListCell *lc;
 	Hypertable *ht;
@@ -956,6 +999,28 @@ process_vacuum(ProcessUtilityArgs *args)
 						ctx.ht_vacuum_rel = vacuum_rel;
 						foreach_chunk(ht, add_compressed_chunk_to_vacuum, &ctx);
 					}
+					else if (!is_vacuumcmd && ts_guc_enable_merged_hypertable_stats)
+					{
+						const Dimension *dim = hyperspace_get_open_dimension(ht->space, 0);
+						MergedHypertable *mh = palloc(sizeof(MergedHypertable));
+
+						/*
+						 * Analyze only the changed chunks, and instead of
+						 * sampling the hypertable, merge the statistics of
+						 * its chunks after they are analyzed.
+						 */
+						ctx.ht_vacuum_rel = vacuum_rel;
+						ctx.only_changed = true;
+						foreach_chunk(ht, add_chunk_to_vacuum, &ctx);
+						ctx.only_changed = false;
+
+						mh->relid = ht->main_table_relid;
+						mh->va_cols = vacuum_rel->va_cols;
+						mh->open_dim_column =
+							dim ? pstrdup(NameStr(dim->fd.column_name)) : NULL;
+						ctx.merged_hypertables = lappend(ctx.merged_hypertables, mh);
+						continue;
+					}
 					else
 					{
 						ctx.ht_vacuum_rel = vacuum_rel;
@@ -985,6 +1050,18 @@ process_vacuum(ProcessUtilityArgs *args)
 															  cp->compressed_relid);
 		}
 	}
+
+	if (ctx.merged_hypertables != NIL)
+	{
+		PreventCommandDuringRecovery("ANALYZE");
+
+		foreach (lc, ctx.merged_hypertables)
+		{
+			MergedHypertable *mh = lfirst(lc);
+
+			ts_hypertable_stats_merge(mh->relid, mh->va_cols, mh->open_dim_column);
+		}
+	}
 	/*
 	Restore original list. stmt->rels which has references to
 	VacuumRelation list is freed up, however VacuumStmt is not
@@ -1120,10 +1197,17 @@ process_truncate(ProcessUtilityArgs *args)
 				/* TRUNCATE for foreign tables not implemented yet. This will raise an error. */
 				case RELKIND_FOREIGN_TABLE:
 				{
-					Hypertable *ht =
-						ts_hypertable_cache_get_entry(hcache, relid, CACHE_FLAG_MISSING_OK);
+					Hypertable *ht;
 					Chunk *chunk;
 
+					if (is_temp_relation(relid))
+					{
+						list_append = true;
+						break;
+					}
+
+					ht = ts_hypertable_cache_get_entry(hcache, relid, CACHE_FLAG_MISSING_OK);
+
 					if (ht)
 					{
 						ContinuousAggHypertableStatus agg_status;
@@ -1252,6 +1336,18 @@ process_truncate(ProcessUtilityArgs *args)
 
 			handle_truncate_hypertable(args, stmt, compressed_ht);
 		}
+
+		/* the last point cache has no rows without the hypertable */
+		if (OidIsValid(ht->last_point_relid))
+		{
+			TruncateStmt cache_stmt = *stmt;
+			cache_stmt.relations =
+				list_make1(makeRangeVar(INTERNAL_SCHEMA_NAME,
+										get_rel_name(ht->last_point_relid),
+										-1));
+
+			ExecuteTruncate(&cache_stmt);
+		}
 	}
 
 	ts_cache_release(hcache);
@@ -1652,6 +1748,17 @@ process_grant_and_revoke(ProcessUtilityArgs *args)
 												  &compressed_hypertable->fd.schema_name,
 												  &compressed_hypertable->fd.table_name);
 					}
+
+					/* The last point cache is read with the permissions on the hypertable */
+					if (hypertable && OidIsValid(hypertable->last_point_relid))
+					{
+						Name cache_schema = palloc(NAMEDATALEN);
+						Name cache_name = palloc(NAMEDATALEN);
+
+						namestrcpy(cache_schema, INTERNAL_SCHEMA_NAME);
+						namestrcpy(cache_name, get_rel_name(hypertable->last_point_relid));
+						process_grant_add_by_name(stmt, was_schema_op, cache_schema, cache_name);
+					}
 				}
 
 				/* Process all hypertables, including those added in the loop above */
@@ -2017,6 +2124,7 @@ process_rename_column(ProcessUtilityArgs *args, Cache *hcache, Oid relid, Rename
 
 		if (dim)
 			ts_dimension_set_name(dim, stmt->newname);
+		ts_chunk_column_stats_rename_column(ht->fd.id, stmt->subname, stmt->newname);
 		if (ts_cm_functions->process_rename_cmd)
 			ts_cm_functions->process_rename_cmd(relid, hcache, stmt);
 	}
@@ -2238,6 +2346,12 @@ process_altertable_change_owner(Hypertable *ht, AlterTableCmd *cmd)
 
 	foreach_chunk(ht, process_altertable_change_owner_chunk, cmd);
 
+	if (OidIsValid(ht->last_point_relid))
+		ATExecChangeOwner(ht->last_point_relid,
+						  get_rolespec_oid(cmd->newowner, false),
+						  false,
+						  AccessExclusiveLock);
+
 	if (TS_HYPERTABLE_HAS_COMPRESSION_TABLE(ht))
 	{
 		Hypertable *compressed_hypertable =
@@ -2312,6 +2426,8 @@ process_altertable_drop_column(Hypertable *ht, AlterTableCmd *cmd)
 					 errdetail("Cannot drop column that is a hypertable partitioning (space or "
 							   "time) dimension.")));
 	}
+
+	ts_chunk_column_stats_delete_by_column_name(ht->fd.id, cmd->name);
 }
 
 /* process all regular-table alter commands to make sure they aren't adding
@@ -2440,6 +2556,8 @@ typedef struct HypertableIndexOptions
 	 * transaction for all the chunks
 	 */
 	bool multitransaction;
+	/* number of background workers to build the chunk indexes in */
+	int parallel_workers;
 	int n_ht_atts;
 
 	/* Concurrency testing options. */
@@ -2465,8 +2583,33 @@ typedef struct CreateIndexInfo
 	Oid main_table_relid;
 	HypertableIndexOptions extended_options;
 	MemoryContext mctx;
+	/* Number of chunks indexed so far, for progress reporting */
+	int64 chunks_done;
+	/* The chunk queue shared with the index build workers, if any */
+	struct ChunkIndexBuildShared *shared;
 } CreateIndexInfo;
 
+/*
+ * The state shared with the background workers that build the chunk indexes
+ * in parallel, see process_index_chunks_parallel(). The workers and the
+ * leader take the next chunk from the queue until it is empty.
+ */
+typedef struct ChunkIndexBuildShared
+{
+	Oid database_id;
+	Oid user_id;
+	int32 hypertable_id;
+	Oid main_table_relid;
+	Oid index_relid;
+	int n_ht_atts;
+	pg_atomic_uint32 next_chunk;
+	pg_atomic_uint32 chunks_done;
+	int num_chunks;
+	Oid chunk_relids[FLEXIBLE_ARRAY_MEMBER];
+} ChunkIndexBuildShared;
+
+PGDLLEXPORT void ts_chunk_index_build_worker_main(Datum main_arg);
+
 /*
  * Create index on a chunk.
  *
@@ -2593,11 +2736,205 @@ process_index_chunk_multitransaction(int32 hypertable_id, Oid chunk_relid, void
 
 	PopActiveSnapshot();
 	CommitTransactionCommand();
+
+	if (info->shared != NULL)
+		info->chunks_done = pg_atomic_add_fetch_u32(&info->shared->chunks_done, 1);
+	else
+		info->chunks_done++;
+
+	/* the leader reports the progress of the workers too */
+	if (!IsBackgroundWorker)
+		pgstat_progress_update_param(PROGRESS_CREATEIDX_PARTITIONS_DONE, info->chunks_done);
+}
+
+/*
+ * Take the chunks from the shared queue and index them until the queue is
+ * empty.
+ */
+static void
+process_index_chunks_from_queue(CreateIndexInfo *info)
+{
+	ChunkIndexBuildShared *shared = info->shared;
+
+	while (true)
+	{
+		uint32 next = pg_atomic_fetch_add_u32(&shared->next_chunk, 1);
+
+		if (next >= (uint32) shared->num_chunks)
+			break;
+
+		process_index_chunk_multitransaction(shared->hypertable_id,
+											 shared->chunk_relids[next],
+											 info);
+	}
+}
+
+/*
+ * Entrypoint of the background workers that build chunk indexes in
+ * parallel. The workers connect as the user running CREATE INDEX.
+ */
+void
+ts_chunk_index_build_worker_main(Datum main_arg)
+{
+	dsm_segment *seg;
+	ChunkIndexBuildShared *shared;
+	CreateIndexInfo info = {
+#ifdef DEBUG
+		.extended_options = {.multitransaction = true, .max_chunks = -1,},
+#else
+		.extended_options = {.multitransaction = true,},
+#endif
+	};
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	seg = dsm_attach(DatumGetUInt32(main_arg));
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+
+	shared = dsm_segment_address(seg);
+	BackgroundWorkerInitializeConnectionByOid(shared->database_id, shared->user_id, 0);
+
+	info.obj.objectId = shared->index_relid;
+	info.main_table_relid = shared->main_table_relid;
+	info.extended_options.n_ht_atts = shared->n_ht_atts;
+	info.mctx = CurrentMemoryContext;
+	info.shared = shared;
+
+	process_index_chunks_from_queue(&info);
+
+	dsm_detach(seg);
+}
+
+/*
+ * Build the chunk indexes in background workers, in one transaction per
+ * chunk like the serial multi-transaction build. The leader takes part in
+ * the build, so the index is also built if no workers could be started.
+ *
+ * If a worker fails, its chunk is not indexed. Returns the number of chunks
+ * to compare with the number of indexed chunks.
+ */
+static int
+process_index_chunks_parallel(CreateIndexInfo *info, int nworkers)
+{
+	Cache *hcache;
+	Hypertable *ht;
+	List *chunks;
+	ListCell *lc;
+	dsm_segment *seg;
+	ChunkIndexBuildShared *shared;
+	BackgroundWorkerHandle **handles;
+	int num_chunks;
+	int i = 0;
+
+	StartTransactionCommand();
+	MemoryContextSwitchTo(info->mctx);
+	LockRelationOid(info->main_table_relid, AccessShareLock);
+
+	ht = ts_hypertable_cache_get_cache_and_entry(info->main_table_relid,
+												 CACHE_FLAG_MISSING_OK,
+												 &hcache);
+	if (NULL == ht)
+	{
+		ts_cache_release(hcache);
+		CommitTransactionCommand();
+		return -1;
+	}
+
+	chunks = find_inheritance_children(ht->main_table_relid, NoLock);
+	num_chunks = list_length(chunks);
+
+	seg = dsm_create(offsetof(ChunkIndexBuildShared, chunk_relids) + sizeof(Oid) * num_chunks, 0);
+	/* keep the segment across the transactions of the build */
+	dsm_pin_mapping(seg);
+
+	shared = dsm_segment_address(seg);
+	shared->database_id = MyDatabaseId;
+	shared->user_id = GetUserId();
+	shared->hypertable_id = ht->fd.id;
+	shared->main_table_relid = info->main_table_relid;
+	shared->index_relid = info->obj.objectId;
+	shared->n_ht_atts = info->extended_options.n_ht_atts;
+	pg_atomic_init_u32(&shared->next_chunk, 0);
+	pg_atomic_init_u32(&shared->chunks_done, 0);
+	shared->num_chunks = num_chunks;
+	foreach (lc, chunks)
+		shared->chunk_relids[i++] = lfirst_oid(lc);
+
+	ts_cache_release(hcache);
+	CommitTransactionCommand();
+
+	info->shared = shared;
+	nworkers = Min(nworkers, num_chunks);
+	handles = palloc0(sizeof(BackgroundWorkerHandle *) * Max(nworkers, 1));
+
+	for (i = 0; i < nworkers; i++)
+	{
+		BackgroundWorker worker = {
+			.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION,
+			.bgw_start_time = BgWorkerStart_RecoveryFinished,
+			.bgw_restart_time = BGW_NEVER_RESTART,
+			.bgw_notify_pid = MyProcPid,
+			.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(seg)),
+		};
+
+		snprintf(worker.bgw_name, BGW_MAXLEN, "TimescaleDB index build worker %d", i);
+		strlcpy(worker.bgw_library_name, ts_extension_get_so_name(), BGW_MAXLEN);
+		strlcpy(worker.bgw_function_name, "ts_chunk_index_build_worker_main", BGW_MAXLEN);
+
+		if (!RegisterDynamicBackgroundWorker(&worker, &handles[i]))
+		{
+			elog(DEBUG1, "could not start index build worker, started %d workers", i);
+			break;
+		}
+	}
+	nworkers = i;
+
+	PG_TRY();
+	{
+		process_index_chunks_from_queue(info);
+
+		/* wait for the workers to finish their chunks, and report their progress */
+		for (i = 0; i < nworkers; i++)
+		{
+			pid_t pid;
+
+			while (GetBackgroundWorkerPid(handles[i], &pid) != BGWH_STOPPED)
+			{
+				pgstat_progress_update_param(PROGRESS_CREATEIDX_PARTITIONS_DONE,
+											 pg_atomic_read_u32(&shared->chunks_done));
+				(void) WaitLatch(MyLatch,
+								 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+								 1000L,
+								 PG_WAIT_EXTENSION);
+				ResetLatch(MyLatch);
+				CHECK_FOR_INTERRUPTS();
+			}
+		}
+	}
+	PG_CATCH();
+	{
+		for (i = 0; i < nworkers; i++)
+			TerminateBackgroundWorker(handles[i]);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	info->chunks_done = pg_atomic_read_u32(&shared->chunks_done);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_PARTITIONS_DONE, info->chunks_done);
+	info->shared = NULL;
+	dsm_detach(seg);
+
+	return num_chunks;
 }
 
 typedef enum HypertableIndexFlags
 {
 	HypertableIndexFlagMultiTransaction = 0,
+	HypertableIndexFlagParallelWorkers,
 #ifdef DEBUG
 	HypertableIndexFlagBarrierTable,
 	HypertableIndexFlagMaxChunks,
@@ -2606,6 +2943,7 @@ typedef enum HypertableIndexFlags
 
 static const WithClauseDefinition index_with_clauses[] = {
 	[HypertableIndexFlagMultiTransaction] = {.arg_name = "transaction_per_chunk", .type_id = BOOLOID,},
+	[HypertableIndexFlagParallelWorkers] = {.arg_name = "parallel_workers", .type_id = INT4OID, .default_val = Int32GetDatum(0)},
 #ifdef DEBUG
 	[HypertableIndexFlagBarrierTable] = {.arg_name = "barrier_table", .type_id = REGCLASSOID,},
 	[HypertableIndexFlagMaxChunks] = {.arg_name = "max_chunks", .type_id = INT4OID, .default_val = Int32GetDatum(-1)},
@@ -2652,6 +2990,7 @@ process_index_start(ProcessUtilityArgs *args)
 	int sec_ctx;
 	Oid uid = InvalidOid, saved_uid = InvalidOid;
 	ContinuousAgg *cagg = NULL;
+	int num_chunks = -1;
 
 	Assert(IsA(stmt, IndexStmt));
 
@@ -2730,6 +3069,8 @@ process_index_start(ProcessUtilityArgs *args)
 
 	info.extended_options.multitransaction =
 		DatumGetBool(parsed_with_clauses[HypertableIndexFlagMultiTransaction].parsed);
+	info.extended_options.parallel_workers =
+		DatumGetInt32(parsed_with_clauses[HypertableIndexFlagParallelWorkers].parsed);
 #ifdef DEBUG
 	info.extended_options.max_chunks =
 		DatumGetInt32(parsed_with_clauses[HypertableIndexFlagMaxChunks].parsed);
@@ -2751,11 +3092,18 @@ process_index_start(ProcessUtilityArgs *args)
 				 errmsg(
 					 "cannot use timescaledb.transaction_per_chunk with UNIQUE or PRIMARY KEY")));
 
-	if (info.extended_options.multitransaction && hypertable_is_distributed(ht))
+	if (info.extended_options.parallel_workers < 0 ||
+		info.extended_options.parallel_workers > MAX_PARALLEL_WORKER_LIMIT)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for timescaledb.parallel_workers"),
+				 errdetail("Value must be between 0 and %d.", MAX_PARALLEL_WORKER_LIMIT)));
+
+	if (info.extended_options.parallel_workers > 0 && !info.extended_options.multitransaction)
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg(
-					 "cannot use timescaledb.transaction_per_chunk with distributed hypertable")));
+				 errmsg("cannot use timescaledb.parallel_workers without "
+						"timescaledb.transaction_per_chunk")));
 
 	ts_indexing_verify_index(ht->space, stmt);
 
@@ -2854,6 +3202,19 @@ process_index_start(ProcessUtilityArgs *args)
 	CacheInvalidateRelcacheByRelid(info.main_table_relid);
 	CacheInvalidateRelcacheByRelid(info.obj.objectId);
 
+	/*
+	 * Report per-chunk progress in pg_stat_progress_create_index. The
+	 * chunks are counted as partitions, so that building the index on a
+	 * hypertable with many chunks can be followed in the same way as on a
+	 * partitioned table.
+	 */
+	pgstat_progress_start_command(PROGRESS_COMMAND_CREATE_INDEX, info.main_table_relid);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_COMMAND, PROGRESS_CREATEIDX_COMMAND_CREATE);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_INDEX_OID, info.obj.objectId);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_PARTITIONS_TOTAL,
+								 list_length(find_inheritance_children(info.main_table_relid,
+																	   NoLock)));
+
 	ts_cache_release(hcache);
 
 	/* we need a long-lived context in which to store the list of chunks since the per-transaction
@@ -2863,14 +3224,27 @@ process_index_start(ProcessUtilityArgs *args)
 	PopActiveSnapshot();
 	CommitTransactionCommand();
 
-	foreach_chunk_multitransaction(info.main_table_relid,
-								   info.mctx,
-								   process_index_chunk_multitransaction,
-								   &info);
+	if (info.extended_options.parallel_workers > 0)
+		num_chunks = process_index_chunks_parallel(&info, info.extended_options.parallel_workers);
+	else
+		foreach_chunk_multitransaction(info.main_table_relid,
+									   info.mctx,
+									   process_index_chunk_multitransaction,
+									   &info);
 
 	StartTransactionCommand();
 	MemoryContextSwitchTo(info.mctx);
 
+	/* a failed index build worker leaves the hypertable index invalid */
+	if (info.chunks_done < num_chunks)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not create the index on all chunks"),
+				 errdetail("Created the index on " INT64_FORMAT " of %d chunks.",
+						   info.chunks_done,
+						   num_chunks),
+				 errhint("Check the server log for errors of the index build workers.")));
+
 	if (multitransaction_create_index_mark_valid(info))
 	{
 		/* we're done, the index is now valid */
@@ -2883,6 +3257,7 @@ process_index_start(ProcessUtilityArgs *args)
 	CommitTransactionCommand();
 	StartTransactionCommand();
 
+	pgstat_progress_end_command();
 	UnlockRelationIdForSession(&main_table_index_lock_relid, AccessShareLock);
 
 	DEBUG_WAITPOINT("process_index_start_indexing_done");
@@ -4394,6 +4769,38 @@ process_ddl_sql_drop(EventTriggerDropObject *obj)
 	}
 }
 
+/*
+ * Utility commands that can involve neither hypertables nor any other object
+ * of the extension, like SET, PREPARE and transaction control.
+ *
+ * These are frequent, so they skip the extension entirely, including the
+ * extension state check and the TSL hooks, which read the catalog.
+ */
+static bool
+process_utility_is_passthrough(Node *parsetree)
+{
+	switch (nodeTag(parsetree))
+	{
+		case T_VariableSetStmt:
+		case T_VariableShowStmt:
+		case T_TransactionStmt:
+		case T_PrepareStmt:
+		case T_DeallocateStmt:
+		case T_DeclareCursorStmt:
+		case T_FetchStmt:
+		case T_ClosePortalStmt:
+		case T_ConstraintsSetStmt:
+		case T_DiscardStmt:
+		case T_ListenStmt:
+		case T_UnlistenStmt:
+		case T_NotifyStmt:
+		case T_CheckPointStmt:
+			return true;
+		default:
+			return false;
+	}
+}
+
 /*
  * ProcessUtility hook for DDL commands that have not yet been processed by
  * PostgreSQL.
@@ -4424,15 +4831,13 @@ timescaledb_ddl_command_start(PlannedStmt *pstmt, const char *query_string,
 		.pstmt = pstmt,
 		.parsetree = pstmt->utilityStmt,
 		.queryEnv = queryEnv,
-		.parse_state = make_parsestate(NULL),
+		.parse_state = NULL,
 		.hypertable_list = NIL
 	};
 
 	bool altering_timescaledb = false;
 	DDLResult result;
 
-	args.parse_state->p_sourcetext = query_string;
-
 	if (IsA(args.parsetree, AlterExtensionStmt))
 	{
 		AlterExtensionStmt *stmt = (AlterExtensionStmt *) args.parsetree;
@@ -4444,12 +4849,16 @@ timescaledb_ddl_command_start(PlannedStmt *pstmt, const char *query_string,
 	 * We don't want to load the extension if we just got the command to alter
 	 * it.
 	 */
-	if (altering_timescaledb || !ts_extension_is_loaded())
+	if (altering_timescaledb || process_utility_is_passthrough(args.parsetree) ||
+		!ts_extension_is_loaded())
 	{
 		prev_ProcessUtility(&args);
 		return;
 	}
 
+	args.parse_state = make_parsestate(NULL);
+	args.parse_state->p_sourcetext = query_string;
+
 	/*
 	 * Process Utility/DDL operation locally then pass it on for
 	 * execution in TSL.
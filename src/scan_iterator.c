@@ -4,7 +4,13 @@
  * LICENSE-APACHE for a copy of the license.
  */
 #include <postgres.h>
+#include <access/stratnum.h>
+#include <catalog/pg_collation.h>
+#include <catalog/pg_type.h>
+#include <utils/array.h>
+#include <utils/fmgroids.h>
 
+#include "compat/compat.h"
 #include "scan_iterator.h"
 
 TSDLLEXPORT void
@@ -53,6 +59,52 @@ ts_scan_iterator_scan_key_init(ScanIterator *iterator, AttrNumber attributeNumbe
 	MemoryContextSwitchTo(oldmcxt);
 }
 
+/*
+ * Initialize a scan key that matches any of the given int4 values, so that
+ * the rows for many keys, e.g., chunk IDs, are found in a single index scan
+ * instead of one scan per key. The index returns the matching rows in the
+ * index order, i.e., ordered by the value and not by the position in the
+ * given array.
+ *
+ * Array keys are supported only by index scans, so the index must be set
+ * before initializing the key.
+ */
+TSDLLEXPORT void
+ts_scan_iterator_scan_key_init_int4_array(ScanIterator *iterator, AttrNumber attributeNumber,
+										  const int32 *values, int num_values)
+{
+	MemoryContext oldmcxt;
+	Datum *datums;
+	ArrayType *arr;
+
+	Assert(iterator->ctx.scankey == NULL || iterator->ctx.scankey == iterator->scankey);
+	iterator->ctx.scankey = iterator->scankey;
+
+	if (!OidIsValid(iterator->ctx.index))
+		elog(ERROR, "array scan keys require an index scan");
+
+	if (iterator->ctx.nkeys >= EMBEDDED_SCAN_KEY_SIZE)
+		elog(ERROR, "cannot scan more than %d keys", EMBEDDED_SCAN_KEY_SIZE);
+
+	/* The array must live as long as the scan key, see above */
+	oldmcxt = MemoryContextSwitchTo(iterator->ctx.internal.scan_mcxt);
+	datums = palloc(sizeof(Datum) * Max(num_values, 1));
+
+	for (int i = 0; i < num_values; i++)
+		datums[i] = Int32GetDatum(values[i]);
+
+	arr = construct_array(datums, num_values, INT4OID, sizeof(int32), true, TYPALIGN_INT);
+	ScanKeyEntryInitialize(&iterator->scankey[iterator->ctx.nkeys++],
+						   SK_SEARCHARRAY,
+						   attributeNumber,
+						   BTEqualStrategyNumber,
+						   InvalidOid,
+						   C_COLLATION_OID,
+						   F_INT4EQ,
+						   PointerGetDatum(arr));
+	MemoryContextSwitchTo(oldmcxt);
+}
+
 TSDLLEXPORT void
 ts_scan_iterator_rescan(ScanIterator *iterator)
 {
@@ -106,6 +106,9 @@ void TSDLLEXPORT ts_scan_iterator_close(ScanIterator *iterator);
 void TSDLLEXPORT ts_scan_iterator_scan_key_init(ScanIterator *iterator, AttrNumber attributeNumber,
 												StrategyNumber strategy, RegProcedure procedure,
 												Datum argument);
+void TSDLLEXPORT ts_scan_iterator_scan_key_init_int4_array(ScanIterator *iterator,
+														   AttrNumber attributeNumber,
+														   const int32 *values, int num_values);
 
 /*
  * Reset the scan to use a new scan key.
@@ -8,226 +8,266 @@
 
 #include "dimension.h"
 #include "dimension_slice.h"
-#include "dimension_vector.h"
 #include "hypercube.h"
 #include "subspace_store.h"
 
 /*
- * In terms of datastructures, the subspace store is actually a tree. At the
- * root of a tree is a DimensionVec representing the different DimensionSlices
- * for the first dimension. Each of the DimensionSlices of the
- * first dimension point to a DimensionVec of the second dimension. This recurses
- * for the N dimensions. The leaf DimensionSlice points to the data being stored.
+ * The subspace store keeps the stored objects in a flat array of entries,
+ * sorted by the start of their range in the first (time) dimension. The ranges
+ * of all dimensions are stored separately in one contiguous array, with
+ * num_dimensions (start, end) pairs per entry, so that a lookup only touches
+ * the ranges and not the entries.
  *
- * */
+ * A lookup does a binary search for the last entry that starts before the
+ * point in the first dimension and walks back from it until no entry can
+ * contain the point anymore, which is known from the widest range of the
+ * first dimension in the store. For the usual hypertable, where all chunks
+ * have the same interval, this only visits the entries of one time slice.
+ *
+ * When the store is full, the least recently used entry is evicted, so that
+ * out-of-order inserts that come back to older chunks keep them cached.
+ */
 
-typedef struct SubspaceStoreInternalNode
+typedef struct SubspaceStoreEntry
 {
-	DimensionVec *vector;
-	uint16 descendants;
-	bool last_internal_node;
-} SubspaceStoreInternalNode;
+	void *object;
+	void (*object_free)(void *);
+	uint64 last_used;
+} SubspaceStoreEntry;
 
 typedef struct SubspaceStore
 {
 	MemoryContext mcxt;
 	uint16 num_dimensions;
-	/* limit growth of store by  limiting number of slices in first dimension,	0 for no limit */
+	/* limit growth of store by limiting number of entries, 0 for no limit */
 	uint16 max_items;
-	SubspaceStoreInternalNode *origin; /* origin of the tree */
+	int num_entries;
+	int capacity;
+	SubspaceStoreEntry *entries;
+	/* num_dimensions (start, end) pairs per entry, in the order of the entries */
+	int64 *ranges;
+	/* widest range of the first dimension of the entries */
+	uint64 max_span;
+	/* incremented on every lookup or addition, for the LRU eviction */
+	uint64 clock;
+	SubspaceStoreStats stats;
 } SubspaceStore;
 
-static inline SubspaceStoreInternalNode *
-subspace_store_internal_node_create(bool last_internal_node)
-{
-	SubspaceStoreInternalNode *node = palloc(sizeof(SubspaceStoreInternalNode));
+#define SUBSPACE_STORE_DEFAULT_SIZE 10
 
-	node->vector = ts_dimension_vec_create(DIMENSION_VEC_DEFAULT_SIZE);
-	node->descendants = 0;
-	node->last_internal_node = last_internal_node;
-	return node;
-}
+#define ENTRY_RANGES(store, i) (&(store)->ranges[(size_t) (i) * 2 * (store)->num_dimensions])
 
-static inline void
-subspace_store_internal_node_free(void *node)
+/*
+ * The last coordinate is included in the slices that end at the maximum
+ * value, see REMAP_LAST_COORDINATE in dimension_slice.c.
+ */
+static inline int64
+remap_last_coordinate(int64 coord)
 {
-	ts_dimension_vec_free(((SubspaceStoreInternalNode *) node)->vector);
-	pfree(node);
-}
-
-static size_t
-subspace_store_internal_node_descendants(SubspaceStoreInternalNode *node, int index)
-{
-	const DimensionSlice *slice = ts_dimension_vec_get(node->vector, index);
-
-	if (slice == NULL)
-		return 0;
-
-	if (node->last_internal_node)
-		return 1;
-
-	return ((SubspaceStoreInternalNode *) slice->storage)->descendants;
+	return coord == DIMENSION_SLICE_MAXVALUE ? DIMENSION_SLICE_MAXVALUE - 1 : coord;
 }
 
 SubspaceStore *
 ts_subspace_store_init(const Hyperspace *space, MemoryContext mcxt, int16 max_items)
 {
 	MemoryContext old = MemoryContextSwitchTo(mcxt);
-	SubspaceStore *sst = palloc(sizeof(SubspaceStore));
-
-	/*
-	 * make sure that the first dimension is a time dimension, otherwise the
-	 * tree will grow in a way that makes pruning less effective.
-	 */
-	Assert(space->num_dimensions < 1 || space->dimensions[0].type == DIMENSION_TYPE_OPEN);
+	SubspaceStore *sst = palloc0(sizeof(SubspaceStore));
 
-	sst->origin = subspace_store_internal_node_create(space->num_dimensions == 1);
 	sst->num_dimensions = space->num_dimensions;
 	/* max_items = 0 is treated as unlimited */
 	sst->max_items = max_items;
 	sst->mcxt = mcxt;
+	sst->capacity = max_items > 0 ? Min(max_items, SUBSPACE_STORE_DEFAULT_SIZE) :
+									SUBSPACE_STORE_DEFAULT_SIZE;
+	sst->entries = palloc(sizeof(SubspaceStoreEntry) * sst->capacity);
+	sst->ranges = palloc(sizeof(int64) * 2 * Max(sst->num_dimensions, 1) * sst->capacity);
 	MemoryContextSwitchTo(old);
 	return sst;
 }
 
-void
-ts_subspace_store_add(SubspaceStore *subspace_store, const Hypercube *hypercube, void *object,
-					  void (*object_free)(void *))
+/*
+ * Returns the number of entries that start before or at the coordinate in the
+ * first dimension.
+ */
+static inline int
+subspace_store_upper_bound(const SubspaceStore *subspace_store, int64 coord)
 {
-	SubspaceStoreInternalNode *node = subspace_store->origin;
-	DimensionSlice *last = NULL;
-	MemoryContext old = MemoryContextSwitchTo(subspace_store->mcxt);
-	int i;
-
-	Assert(hypercube->num_slices == subspace_store->num_dimensions);
+	int low = 0;
+	int high = subspace_store->num_entries;
 
-	for (i = 0; i < hypercube->num_slices; i++)
+	while (low < high)
 	{
-		const DimensionSlice *target = hypercube->slices[i];
-		DimensionSlice *match;
+		int mid = low + (high - low) / 2;
 
-		Assert(target->storage == NULL);
+		if (ENTRY_RANGES(subspace_store, mid)[0] <= coord)
+			low = mid + 1;
+		else
+			high = mid;
+	}
 
-		if (node == NULL)
-		{
-			/*
-			 * We should have one internal node per dimension in the
-			 * hypertable. If we don't have one for the current dimension,
-			 * create one now. (There will always be one for time)
-			 */
-			Assert(last != NULL);
-			last->storage = subspace_store_internal_node_create(i == (hypercube->num_slices - 1));
-			last->storage_free = subspace_store_internal_node_free;
-			node = last->storage;
-		}
+	return low;
+}
 
-		Assert(subspace_store->max_items == 0 ||
-			   node->descendants <= (size_t) subspace_store->max_items);
+static void
+subspace_store_remove(SubspaceStore *subspace_store, int index)
+{
+	SubspaceStoreEntry *entry = &subspace_store->entries[index];
+	int num_following = subspace_store->num_entries - index - 1;
 
-		/*
-		 * We only call this function on a cache miss, so number of leaves
-		 * will definitely increase see `Assert(last != NULL && last->storage
-		 * == NULL);` at bottom.
-		 */
-		node->descendants += 1;
+	if (entry->object_free != NULL)
+		entry->object_free(entry->object);
 
-		Assert(0 == node->vector->num_slices ||
-			   node->vector->slices[0]->fd.dimension_id == target->fd.dimension_id);
+	memmove(entry, entry + 1, sizeof(SubspaceStoreEntry) * num_following);
+	memmove(ENTRY_RANGES(subspace_store, index),
+			ENTRY_RANGES(subspace_store, index + 1),
+			sizeof(int64) * 2 * subspace_store->num_dimensions * num_following);
+	subspace_store->num_entries--;
+}
 
-		/* Do we have enough space to store the object? */
-		if (subspace_store->max_items > 0 && node->descendants > subspace_store->max_items)
-		{
-			/*
-			 * Always delete the slice corresponding to the earliest time
-			 * range. In the normal case that inserts are performed in
-			 * time-order this is the one least likely to be reused. (Note
-			 * that we made sure that the first dimension is a time dimension
-			 * when creating the subspace_store). If out-of-order inserts are
-			 * become significant we may wish to change this to something more
-			 * sophisticated like LRU.
-			 */
-			size_t items_removed = subspace_store_internal_node_descendants(node, i);
-
-			/*
-			 * descendants at the root is inclusive of the descendants at the
-			 * children, so if we have an overflow it must be in the time dim
-			 */
-			Assert(i == 0);
-
-			Assert(subspace_store->max_items + 1 == node->descendants);
-
-			ts_dimension_vec_remove_slice(&node->vector, i);
-
-			/*
-			 * Note we would have to do this to ancestors if this was not the
-			 * root.
-			 */
-			node->descendants -= items_removed;
-		}
+static void
+subspace_store_evict_least_recently_used(SubspaceStore *subspace_store)
+{
+	int victim = 0;
 
-		match = ts_dimension_vec_find_slice(node->vector, target->fd.range_start);
+	for (int i = 1; i < subspace_store->num_entries; i++)
+	{
+		if (subspace_store->entries[i].last_used < subspace_store->entries[victim].last_used)
+			victim = i;
+	}
 
-		/* Do we have a slot in this vector for the new object? */
-		if (match == NULL)
-		{
-			DimensionSlice *copy;
+	subspace_store_remove(subspace_store, victim);
+}
 
-			/*
-			 * create a new copy of the range this slice covers, to store the
-			 * object in
-			 */
-			copy = ts_dimension_slice_copy(target);
+bool
+ts_subspace_store_add(SubspaceStore *subspace_store, const Hypercube *hypercube, void *object,
+					  void (*object_free)(void *))
+{
+	MemoryContext old = MemoryContextSwitchTo(subspace_store->mcxt);
+	int num_dimensions = subspace_store->num_dimensions;
+	int index;
+	int64 *ranges;
+	bool evicted = false;
 
-			ts_dimension_vec_add_slice_sort(&node->vector, copy);
-			match = copy;
-		}
+	Assert(hypercube->num_slices == num_dimensions);
+	Assert(num_dimensions > 0);
 
-		Assert(subspace_store->max_items == 0 ||
-			   node->descendants <= (size_t) subspace_store->max_items);
+	/* Do we have enough space to store the object? */
+	if (subspace_store->max_items > 0 && subspace_store->num_entries >= subspace_store->max_items)
+	{
+		subspace_store_evict_least_recently_used(subspace_store);
+		subspace_store->stats.evictions++;
+		evicted = true;
+	}
 
-		last = match;
-		/* internal slices point to the next SubspaceStoreInternalNode */
-		node = last->storage;
+	if (subspace_store->num_entries == subspace_store->capacity)
+	{
+		subspace_store->capacity *= 2;
+		if (subspace_store->max_items > 0)
+			subspace_store->capacity = Min(subspace_store->capacity, subspace_store->max_items);
+		subspace_store->entries =
+			repalloc(subspace_store->entries,
+					 sizeof(SubspaceStoreEntry) * subspace_store->capacity);
+		subspace_store->ranges =
+			repalloc(subspace_store->ranges,
+					 sizeof(int64) * 2 * num_dimensions * subspace_store->capacity);
 	}
 
-	Assert(last != NULL && last->storage == NULL);
-	last->storage = object; /* at the end we store the object */
-	last->storage_free = object_free;
+	/* Keep the entries sorted by the start of the first dimension */
+	index = subspace_store_upper_bound(subspace_store, hypercube->slices[0]->fd.range_start);
+	memmove(&subspace_store->entries[index + 1],
+			&subspace_store->entries[index],
+			sizeof(SubspaceStoreEntry) * (subspace_store->num_entries - index));
+	memmove(ENTRY_RANGES(subspace_store, index + 1),
+			ENTRY_RANGES(subspace_store, index),
+			sizeof(int64) * 2 * num_dimensions * (subspace_store->num_entries - index));
+	subspace_store->num_entries++;
+
+	subspace_store->entries[index] = (SubspaceStoreEntry){
+		.object = object,
+		.object_free = object_free,
+		.last_used = ++subspace_store->clock,
+	};
+
+	ranges = ENTRY_RANGES(subspace_store, index);
+	for (int i = 0; i < num_dimensions; i++)
+	{
+		ranges[2 * i] = hypercube->slices[i]->fd.range_start;
+		ranges[2 * i + 1] = hypercube->slices[i]->fd.range_end;
+	}
+
+	/* The unsigned difference cannot overflow, even for unbounded slices */
+	subspace_store->max_span =
+		Max(subspace_store->max_span, (uint64) ranges[1] - (uint64) ranges[0]);
+
 	MemoryContextSwitchTo(old);
+
+	return evicted;
 }
 
 void *
-ts_subspace_store_get(const SubspaceStore *subspace_store, const Point *target)
+ts_subspace_store_get(SubspaceStore *subspace_store, const Point *target)
 {
-	int i;
-	DimensionVec *vec = subspace_store->origin->vector;
-	DimensionSlice *match = NULL;
+	int num_dimensions = subspace_store->num_dimensions;
+	int64 coord;
 
-	Assert(target->cardinality == subspace_store->num_dimensions);
+	Assert(target->cardinality == num_dimensions);
 
 	/* The internal compressed hypertable has no dimensions as
 	 * chunks are created explicitly by compress_chunk and linked
 	 * to the source chunk. */
-	if (subspace_store->num_dimensions == 0)
+	if (num_dimensions == 0)
+	{
+		subspace_store->stats.misses++;
 		return NULL;
+	}
+
+	coord = remap_last_coordinate(target->coordinates[0]);
 
-	for (i = 0; i < target->cardinality; i++)
+	for (int index = subspace_store_upper_bound(subspace_store, coord) - 1; index >= 0; index--)
 	{
-		match = ts_dimension_vec_find_slice(vec, target->coordinates[i]);
+		const int64 *ranges = ENTRY_RANGES(subspace_store, index);
+		int i;
 
-		if (NULL == match)
-			return NULL;
+		/* No entry starting here or earlier is wide enough to contain the point */
+		if ((uint64) coord - (uint64) ranges[0] >= subspace_store->max_span)
+			break;
 
-		vec = ((SubspaceStoreInternalNode *) match->storage)->vector;
+		if (coord >= ranges[1])
+			continue;
+
+		for (i = 1; i < num_dimensions; i++)
+		{
+			int64 c = remap_last_coordinate(target->coordinates[i]);
+
+			if (c < ranges[2 * i] || c >= ranges[2 * i + 1])
+				break;
+		}
+
+		if (i == num_dimensions)
+		{
+			subspace_store->entries[index].last_used = ++subspace_store->clock;
+			subspace_store->stats.hits++;
+			return subspace_store->entries[index].object;
+		}
 	}
-	Assert(match != NULL);
-	return match->storage;
+
+	subspace_store->stats.misses++;
+	return NULL;
 }
 
 void
 ts_subspace_store_free(SubspaceStore *subspace_store)
 {
-	subspace_store_internal_node_free(subspace_store->origin);
+	for (int i = 0; i < subspace_store->num_entries; i++)
+	{
+		SubspaceStoreEntry *entry = &subspace_store->entries[i];
+
+		if (entry->object_free != NULL)
+			entry->object_free(entry->object);
+	}
+
+	pfree(subspace_store->entries);
+	pfree(subspace_store->ranges);
 	pfree(subspace_store);
 }
 
@@ -236,3 +276,15 @@ ts_subspace_store_mcxt(const SubspaceStore *subspace_store)
 {
 	return subspace_store->mcxt;
 }
+
+int
+ts_subspace_store_num_entries(const SubspaceStore *subspace_store)
+{
+	return subspace_store->num_entries;
+}
+
+const SubspaceStoreStats *
+ts_subspace_store_stats(const SubspaceStore *subspace_store)
+{
+	return &subspace_store->stats;
+}
@@ -19,18 +19,30 @@ typedef struct Hypercube Hypercube;
 typedef struct Point Point;
 typedef struct SubspaceStore SubspaceStore;
 
+typedef struct SubspaceStoreStats
+{
+	uint64 hits;
+	uint64 misses;
+	uint64 evictions;
+} SubspaceStoreStats;
+
 extern SubspaceStore *ts_subspace_store_init(const Hyperspace *space, MemoryContext mcxt,
 											 int16 max_items);
 
-/* Store an object associate with the subspace represented by a hypercube */
-extern void ts_subspace_store_add(SubspaceStore *subspace_store, const Hypercube *hypercube,
+/* Store an object associate with the subspace represented by a hypercube.
+ * Return true if the least recently used object was evicted to make room.
+ */
+extern bool ts_subspace_store_add(SubspaceStore *subspace_store, const Hypercube *hypercube,
 								  void *object, void (*object_free)(void *));
 
 /* Get the object stored for the subspace that a point is in.
  * Return the object stored or NULL if this subspace is not in the store.
+ * The object is marked as used for the least-recently-used eviction.
  */
-extern void *ts_subspace_store_get(const SubspaceStore *subspace_store, const Point *target);
+extern void *ts_subspace_store_get(SubspaceStore *subspace_store, const Point *target);
 extern void ts_subspace_store_free(SubspaceStore *subspace_store);
 extern MemoryContext ts_subspace_store_mcxt(const SubspaceStore *subspace_store);
+extern int ts_subspace_store_num_entries(const SubspaceStore *subspace_store);
+extern const SubspaceStoreStats *ts_subspace_store_stats(const SubspaceStore *subspace_store);
 
 #endif /* TIMESCALEDB_SUBSPACE_STORE_H */
@@ -10,6 +10,7 @@
 #include <access/genam.h>
 #include <access/htup_details.h>
 #include <access/table.h>
+#include <access/xact.h>
 #include <catalog/indexing.h>
 #include <catalog/pg_depend.h>
 #include <catalog/pg_extension.h>
@@ -17,9 +18,12 @@
 #include <commands/extension.h>
 #include <nodes/nodeFuncs.h>
 #include <port/atomics.h>
+#include <storage/ipc.h>
 #include <storage/lwlock.h>
 #include <utils/hsearch.h>
 #include <utils/fmgroids.h>
+#include <utils/memutils.h>
+#include <utils/timestamp.h>
 
 #include <utils/regproc.h>
 
@@ -32,6 +36,8 @@ static bool skip_telemetry = false;
 static LWLock *function_counts_lock = NULL;
 static HTAB *function_counts;
 
+static void function_counts_flush(void);
+
 /***************************
  * Telemetry draining code *
  ***************************/
@@ -199,6 +205,9 @@ ts_function_telemetry_read(const char **visible_extensions, int num_visible_exte
 		function_counts_lock = (*rendezvous)->lock;
 	}
 
+	/* Include the counts of this backend that were not added yet */
+	function_counts_flush();
+
 	all_entries = read_shared_map();
 	entries_to_send =
 		fn_telemetry_entry_vec_create(CurrentMemoryContext, all_entries->num_elements);
@@ -265,31 +274,107 @@ ts_function_telemetry_reset_counts()
  * Telemetry gathering code *
  ****************************/
 
-static bool
-function_telemetry_increment(Oid func_id, HTAB **local_counts)
+/*
+ * The counts are gathered in a backend-local table and only added to the
+ * shared table every FN_TELEMETRY_FLUSH_QUERIES queries or after
+ * FN_TELEMETRY_FLUSH_INTERVAL_MS, whichever comes first, and when the backend
+ * exits.
+ *
+ * Entries are never removed from the shared table, only their counts are
+ * reset, so a backend can keep pointers to the shared entries of the
+ * functions it has seen. Once the entry of a function is known, its count is
+ * added with an atomic fetch-add without taking the lock at all.
+ */
+#define FN_TELEMETRY_FLUSH_QUERIES 1000
+#define FN_TELEMETRY_FLUSH_INTERVAL_MS 1000
+
+typedef struct FnTelemetryLocalEntry
 {
-	FnTelemetryEntry *entry;
-	bool found;
+	Oid fn;
+	uint64 count;
+	FnTelemetryHashEntry *shared_entry;
+} FnTelemetryLocalEntry;
+
+typedef struct FnTelemetryGatherContext
+{
+	uint64 weight;
+} FnTelemetryGatherContext;
+
+static HTAB *local_function_counts = NULL;
+static int queries_since_flush = 0;
+static TimestampTz last_flush = 0;
+static int queries_until_sample = 0;
 
-	// if this is the first function we've seen initialize local_counts
-	if (!*local_counts)
+static void
+function_counts_flush(void)
+{
+	HASH_SEQ_STATUS hash_seq;
+	FnTelemetryLocalEntry *entry;
+	bool locked = false;
+
+	queries_since_flush = 0;
+
+	if (local_function_counts == NULL || function_counts == NULL)
+		return;
+
+	hash_seq_init(&hash_seq, local_function_counts);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
 	{
-		HASHCTL hash_info = {
-			.keysize = sizeof(Oid),
-			.entrysize = sizeof(FnTelemetryEntry),
-			.hcxt = CurrentMemoryContext,
-		};
-		*local_counts = hash_create("fn telemetry local function hash",
-									10,
-									&hash_info,
-									HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+		if (entry->count == 0)
+			continue;
+
+		/* Functions seen for the first time need their shared entry */
+		if (entry->shared_entry == NULL)
+		{
+			bool found;
+
+			if (!locked)
+			{
+				LWLockAcquire(function_counts_lock, LW_EXCLUSIVE);
+				locked = true;
+			}
+
+			entry->shared_entry = hash_search(function_counts, &entry->fn, HASH_ENTER_NULL, &found);
+
+			/* The shared table is full, drop the count */
+			if (entry->shared_entry == NULL)
+			{
+				entry->count = 0;
+				continue;
+			}
+
+			if (!found)
+				pg_atomic_init_u64(&entry->shared_entry->count, 0);
+		}
+
+		pg_atomic_fetch_add_u64(&entry->shared_entry->count, entry->count);
+		entry->count = 0;
 	}
 
-	entry = hash_search(*local_counts, &func_id, HASH_ENTER, &found);
+	if (locked)
+		LWLockRelease(function_counts_lock);
+}
+
+static void
+function_counts_flush_at_exit(int code, Datum arg)
+{
+	function_counts_flush();
+}
+
+static bool
+function_telemetry_increment(Oid func_id, FnTelemetryGatherContext *context)
+{
+	FnTelemetryLocalEntry *entry;
+	bool found;
+
+	entry = hash_search(local_function_counts, &func_id, HASH_ENTER, &found);
 	if (!found)
+	{
 		entry->count = 0;
+		entry->shared_entry = NULL;
+	}
 
-	entry->count += 1;
+	entry->count += context->weight;
 
 	return true;
 }
@@ -321,116 +406,106 @@ function_gather_walker(Node *node, void *context)
 	return expression_tree_walker(node, function_gather_walker, context);
 }
 
-static HTAB *
-record_function_counts(Query *query)
+static void
+record_function_counts(Query *query, uint64 weight)
 {
-	HTAB *query_function_counts = NULL;
-	query_tree_walker(query, function_gather_walker, &query_function_counts, 0);
-	return query_function_counts;
+	FnTelemetryGatherContext context = { .weight = weight };
+
+	query_tree_walker(query, function_gather_walker, &context, 0);
 }
 
 /*
- * Store a map of (function_oid, count) into shared memory so it can be seen by
- * the telemetry worker. This insertion works in two phases:
- *   1. Under a SHARED lock, we increment the counts of all those functions that
- *      are already present in the map, using atomic fetch-add to prevent races.
- *   2. Under an EXCLUSIVE lock, we insert entries for all those functions that
- *      were not already in the map.
- * At steady state we expect that vast majority the time all the functions a
- * query uses will already be in the shared map, so this strategy should
- * minimize contention between queries.
+ * Decide whether to search the query for functions, and with which weight to
+ * count them.
  *
- * @param query_function_counts A hashtable of FnTelemetryEntry storing
- *                              function usage counts
+ * With a sample interval of N, the distance to the next sampled query is
+ * random with a mean of N, so that the sample does not follow any periodic
+ * pattern of the workload.
  */
-static void
-store_function_counts_in_shared_mem(HTAB *query_function_counts)
+static bool
+function_telemetry_sample(uint64 *weight)
 {
-	HASH_SEQ_STATUS hash_seq;
-	FnTelemetryEntry *local_entry = NULL;
-	fn_telemetry_entry_vec missing_entries;
-	fn_telemetry_entry_vec_init(&missing_entries, CurrentMemoryContext, 0);
-
-	/*
-	 * Increment the counts of any functions already in the table under a
-	 * shared lock; the atomicity of increments will handle concurrency.
-	 */
-	LWLockAcquire(function_counts_lock, LW_SHARED);
-	hash_seq_init(&hash_seq, query_function_counts);
+	int interval = ts_guc_telemetry_function_sample_interval;
 
-	while ((local_entry = hash_seq_search(&hash_seq)))
+	if (interval <= 1)
 	{
-		FnTelemetryHashEntry *shared_entry =
-			hash_search(function_counts, &local_entry->fn, HASH_FIND, NULL);
-
-		if (shared_entry)
-			pg_atomic_fetch_add_u64(&shared_entry->count, local_entry->count);
-		else
-			fn_telemetry_entry_vec_append(&missing_entries, *local_entry);
+		*weight = 1;
+		return true;
 	}
 
-	LWLockRelease(function_counts_lock);
+	if (--queries_until_sample > 0)
+		return false;
 
-	/*
-	 * If any functions did not have an entries create them under an
-	 * exclusive lock
-	 */
-	if (missing_entries.num_elements > 0)
-	{
-		LWLockAcquire(function_counts_lock, LW_EXCLUSIVE);
-		for (uint32 i = 0; i < missing_entries.num_elements; i++)
-		{
-			bool found = false;
-			FnTelemetryEntry *missing_entry = fn_telemetry_entry_vec_at(&missing_entries, i);
-			FnTelemetryHashEntry *shared_entry =
-				hash_search(function_counts, &missing_entry->fn, HASH_ENTER_NULL, &found);
-
-			if (!shared_entry)
-				break;
-
-			if (found)
-				pg_atomic_fetch_add_u64(&shared_entry->count, missing_entry->count);
-			else
-				pg_atomic_init_u64(&shared_entry->count, missing_entry->count);
-		}
-		LWLockRelease(function_counts_lock);
-	}
+	*weight = interval;
+	queries_until_sample = 1 + random() % (2 * interval - 1);
+
+	return true;
+}
+
+static bool
+function_telemetry_init(void)
+{
+	FnTelemetryRendezvous **rendezvous;
+	HASHCTL hash_info = {
+		.keysize = sizeof(Oid),
+		.entrysize = sizeof(FnTelemetryLocalEntry),
+		.hcxt = TopMemoryContext,
+	};
+
+	if (function_counts != NULL && local_function_counts != NULL)
+		return true;
+
+	rendezvous =
+		(FnTelemetryRendezvous **) find_rendezvous_variable(RENDEZVOUS_FUNCTION_TELEMENTRY);
+
+	if (*rendezvous == NULL)
+		return false;
+
+	function_counts = (*rendezvous)->function_counts;
+	function_counts_lock = (*rendezvous)->lock;
+
+	local_function_counts = hash_create("fn telemetry local function hash",
+										100,
+										&hash_info,
+										HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	before_shmem_exit(function_counts_flush_at_exit, 0);
+
+	return true;
 }
 
 /*
  * Gather function usage telemetry for a query.
  *
- * This function walks a query looking for function Oids, counts their
- * occurrence, and stores the (function_id, count) set into the shared-memory
- * function telemetry hashtable for later processing by the telemetry background
- * worker.
+ * This function walks a query looking for function Oids and counts their
+ * occurrence in the backend-local counts, which are added to the
+ * shared-memory function telemetry hashtable for later processing by the
+ * telemetry background worker, see function_counts_flush().
  */
 void
 ts_telemetry_function_info_gather(Query *query)
 {
-	HTAB *query_function_counts;
+	TimestampTz now;
+	uint64 weight;
 
 	if (skip_telemetry || !ts_function_telemetry_on())
 		return;
 
 	// At the first time through initialize the shared state
-	if (function_counts == NULL)
+	if (local_function_counts == NULL && !function_telemetry_init())
 	{
-		FnTelemetryRendezvous **rendezvous =
-			(FnTelemetryRendezvous **) find_rendezvous_variable(RENDEZVOUS_FUNCTION_TELEMENTRY);
-
-		if (*rendezvous == NULL)
-		{
-			skip_telemetry = true;
-			return;
-		}
-
-		function_counts = (*rendezvous)->function_counts;
-		function_counts_lock = (*rendezvous)->lock;
+		skip_telemetry = true;
+		return;
 	}
 
-	query_function_counts = record_function_counts(query);
+	if (function_telemetry_sample(&weight))
+		record_function_counts(query, weight);
 
-	if (query_function_counts)
-		store_function_counts_in_shared_mem(query_function_counts);
+	/* The statement start time is already known, so it costs nothing */
+	now = GetCurrentStatementStartTimestamp();
+	if (++queries_since_flush >= FN_TELEMETRY_FLUSH_QUERIES ||
+		TimestampDifferenceExceeds(last_flush, now, FN_TELEMETRY_FLUSH_INTERVAL_MS))
+	{
+		function_counts_flush();
+		last_flush = now;
+	}
 }
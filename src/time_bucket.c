@@ -6,6 +6,8 @@
 #include <postgres.h>
 #include <catalog/pg_type.h>
 #include <fmgr.h>
+#include <parser/scansup.h>
+#include <pgtime.h>
 #include <utils/builtins.h>
 #include <utils/date.h>
 #include <utils/datetime.h>
@@ -321,6 +323,165 @@ ts_timestamptz_offset_bucket(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(timestamp);
 }
 
+/*
+ * No time zone moves its UTC offset by more than a day, so a local time that
+ * is this far from the zone transitions maps to exactly one UTC time.
+ */
+#define TIMEZONE_CACHE_TRANSITION_MARGIN (2 * USECS_PER_DAY)
+
+/*
+ * The UTC offset of a time zone, cached in fn_extra for the duration of the
+ * query. The cache holds a range of UTC times [start, end) without zone
+ * transitions, found with pg_next_dst_boundary(), so that the conversions of
+ * the times in the range are integer arithmetic instead of going through the
+ * time zone machinery for every value. Bucketing by local time mostly
+ * converts values in the same range, so the range is rarely recomputed.
+ */
+typedef struct TimezoneCache
+{
+	char tzname[TZ_STRLEN_MAX + 1];
+	/* NULL for abbreviations and unknown zones, they are converted by PostgreSQL */
+	pg_tz *tz;
+	bool valid;
+	TimestampTz start;
+	TimestampTz end;
+	int64 gmtoff;
+} TimezoneCache;
+
+static TimezoneCache *
+timezone_cache_get(FunctionCallInfo fcinfo, Datum tzname)
+{
+	TimezoneCache *cache;
+	char name[TZ_STRLEN_MAX + 1];
+	char *lowzone;
+	pg_tz *abbrev_tz;
+	int offset;
+	int type;
+
+	/* there is nowhere to keep the cache when called with DirectFunctionCall */
+	if (fcinfo->flinfo == NULL)
+		return NULL;
+
+	text_to_cstring_buffer(DatumGetTextPP(tzname), name, sizeof(name));
+	cache = fcinfo->flinfo->fn_extra;
+
+	if (cache != NULL && strcmp(cache->tzname, name) == 0)
+		return cache;
+
+	if (cache == NULL)
+	{
+		cache = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(TimezoneCache));
+		fcinfo->flinfo->fn_extra = cache;
+	}
+
+	strlcpy(cache->tzname, name, sizeof(cache->tzname));
+	cache->valid = false;
+
+	/* the abbreviations take precedence over the zone names, like in timestamptz_zone() */
+	lowzone = downcase_truncate_identifier(name, strlen(name), false);
+	type = DecodeTimezoneAbbrev(0, lowzone, &offset, &abbrev_tz);
+
+	if (type == TZ || type == DTZ || type == DYNTZ)
+		cache->tz = NULL;
+	else
+		cache->tz = pg_tzset(name);
+
+	return cache;
+}
+
+/*
+ * Make sure that the cached range contains the UTC time. Returns false if the
+ * offset could not be determined.
+ */
+static bool
+timezone_cache_lookup(TimezoneCache *cache, TimestampTz utc)
+{
+	pg_time_t t;
+	pg_time_t boundary;
+	long int before_gmtoff, after_gmtoff;
+	int before_isdst, after_isdst;
+	TimestampTz end;
+	int res;
+
+	if (cache->valid && utc >= cache->start && utc < cache->end)
+		return true;
+
+	/* the transitions are at whole seconds, so round down to find the next one after utc */
+	t = (utc >= 0 ? utc / USECS_PER_SEC : -((-utc + USECS_PER_SEC - 1) / USECS_PER_SEC)) +
+		(POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * SECS_PER_DAY;
+	res = pg_next_dst_boundary(&t,
+							   &before_gmtoff,
+							   &before_isdst,
+							   &boundary,
+							   &after_gmtoff,
+							   &after_isdst,
+							   cache->tz);
+
+	if (res < 0)
+		return false;
+
+	end = (res == 0) ? DT_NOEND : time_t_to_timestamptz(boundary);
+
+	/* the same transition follows, so the offset is the same down to utc */
+	if (cache->valid && end == cache->end && before_gmtoff * USECS_PER_SEC == cache->gmtoff &&
+		utc < cache->start)
+	{
+		cache->start = utc;
+		return true;
+	}
+
+	cache->start = utc;
+	cache->end = end;
+	cache->gmtoff = before_gmtoff * USECS_PER_SEC;
+	cache->valid = true;
+	return true;
+}
+
+/*
+ * Same as timestamptz_zone(), i.e., 'timestamptz AT TIME ZONE tzname'.
+ */
+static Datum
+timezone_cache_to_local(TimezoneCache *cache, Datum tzname, Datum timestamptz)
+{
+	TimestampTz utc = DatumGetTimestampTz(timestamptz);
+
+	if (cache != NULL && cache->tz != NULL && !TIMESTAMP_NOT_FINITE(utc) &&
+		timezone_cache_lookup(cache, utc))
+	{
+		Timestamp local = utc + cache->gmtoff;
+
+		if (IS_VALID_TIMESTAMP(local))
+			return TimestampGetDatum(local);
+	}
+
+	return DirectFunctionCall2(timestamptz_zone, tzname, timestamptz);
+}
+
+/*
+ * Same as timestamp_zone(), i.e., 'timestamp AT TIME ZONE tzname'. The
+ * cached offset is only used when there are no transitions near the result,
+ * so the local times that are skipped or repeated by a transition are left
+ * to PostgreSQL.
+ */
+static Datum
+timezone_cache_from_local(TimezoneCache *cache, Datum tzname, Datum timestamp)
+{
+	Timestamp local = DatumGetTimestamp(timestamp);
+
+	if (cache != NULL && cache->tz != NULL && cache->valid && !TIMESTAMP_NOT_FINITE(local))
+	{
+		int64 gmtoff = cache->gmtoff;
+		TimestampTz utc = local - gmtoff;
+
+		if (timezone_cache_lookup(cache, utc - TIMEZONE_CACHE_TRANSITION_MARGIN) &&
+			cache->gmtoff == gmtoff && utc + TIMEZONE_CACHE_TRANSITION_MARGIN < cache->end &&
+			IS_VALID_TIMESTAMP(utc))
+			return TimestampTzGetDatum(utc);
+	}
+
+	return DirectFunctionCall2(timestamp_zone, tzname, timestamp);
+}
+
 TS_FUNCTION_INFO_V1(ts_timestamptz_timezone_bucket);
 
 /*
@@ -341,6 +502,7 @@ ts_timestamptz_timezone_bucket(PG_FUNCTION_ARGS)
 	 */
 	bool have_origin = PG_NARGS() > 3 && !PG_ARGISNULL(3);
 	bool have_offset = PG_NARGS() > 4 && !PG_ARGISNULL(4);
+	TimezoneCache *cache;
 
 	/*
 	 * We need to check for NULL arguments here because the function cannot be
@@ -349,8 +511,10 @@ ts_timestamptz_timezone_bucket(PG_FUNCTION_ARGS)
 	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
 		PG_RETURN_NULL();
 
+	cache = timezone_cache_get(fcinfo, tzname);
+
 	/* Convert to local timestamp according to timezone */
-	timestamp = DirectFunctionCall2(timestamptz_zone, tzname, timestamp);
+	timestamp = timezone_cache_to_local(cache, tzname, timestamp);
 	if (have_offset)
 	{
 		/* Apply offset. */
@@ -359,7 +523,7 @@ ts_timestamptz_timezone_bucket(PG_FUNCTION_ARGS)
 
 	if (have_origin)
 	{
-		Datum origin = DirectFunctionCall2(timestamptz_zone, tzname, PG_GETARG_DATUM(3));
+		Datum origin = timezone_cache_to_local(cache, tzname, PG_GETARG_DATUM(3));
 		timestamp = DirectFunctionCall3(ts_timestamp_bucket, period, timestamp, origin);
 	}
 	else
@@ -374,7 +538,7 @@ ts_timestamptz_timezone_bucket(PG_FUNCTION_ARGS)
 	}
 
 	/* Convert back to timezone */
-	timestamp = DirectFunctionCall2(timestamp_zone, tzname, timestamp);
+	timestamp = timezone_cache_from_local(cache, tzname, timestamp);
 
 	PG_RETURN_DATUM(timestamp);
 }
@@ -511,6 +675,89 @@ ts_time_bucket_by_type(int64 interval, int64 timestamp, Oid timestamp_type)
 	return ts_time_value_to_internal(time_bucketed, timestamp_type);
 }
 
+/*
+ * Get the width and the origin of time_bucket over an int64 based type, i.e.
+ * bigint, timestamp or timestamptz, for ts_time_bucket_int64_array(). Returns
+ * false when the width is not a fixed number of units, like for months.
+ */
+TSDLLEXPORT bool
+ts_time_bucket_int64_params(Oid type, Datum width, Datum origin, bool has_origin, int64 *period,
+							int64 *shift)
+{
+	switch (type)
+	{
+		case INT8OID:
+			*period = DatumGetInt64(width);
+			*shift = has_origin ? DatumGetInt64(origin) : 0;
+			return true;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		{
+			Interval *interval = DatumGetIntervalP(width);
+
+			if (interval->month != 0)
+				return false;
+
+			*period = get_interval_period_timestamp_units(interval);
+			*shift = has_origin ? DatumGetTimestamp(origin) : DEFAULT_ORIGIN;
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+/*
+ * Bucket an array of values with the same width and origin, for the
+ * vectorized aggregation. This is the arithmetic of ts_int64_bucket and of
+ * ts_timestamp_bucket without months, with the width checked once instead of
+ * for every value. The infinite timestamps are not bucketed.
+ */
+TSDLLEXPORT void
+ts_time_bucket_int64_array(Oid type, int64 period, int64 shift, const int64 *values, int n,
+						   int64 *result)
+{
+	bool is_timestamp = type != INT8OID;
+
+	if (period <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("period must be greater than 0")));
+
+	shift = shift % period;
+
+	for (int i = 0; i < n; i++)
+	{
+		int64 value = values[i];
+		int64 bucket;
+
+		if (is_timestamp && TIMESTAMP_NOT_FINITE(value))
+		{
+			result[i] = value;
+			continue;
+		}
+
+		if ((shift > 0 && value < PG_INT64_MIN + shift) ||
+			(shift < 0 && value > PG_INT64_MAX + shift))
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("timestamp out of range")));
+
+		value -= shift;
+		bucket = (value / period) * period;
+		if (value < 0 && value % period != 0)
+		{
+			if (bucket < PG_INT64_MIN + period)
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("timestamp out of range")));
+			bucket -= period;
+		}
+
+		result[i] = bucket + shift;
+	}
+}
+
 TS_FUNCTION_INFO_V1(ts_time_bucket_ng_timestamp);
 TSDLLEXPORT Datum
 ts_time_bucket_ng_timestamp(PG_FUNCTION_ARGS)
@@ -685,12 +932,13 @@ ts_time_bucket_ng_timezone(PG_FUNCTION_ARGS)
 	Datum interval = PG_GETARG_DATUM(0);
 	Datum timestamptz = PG_GETARG_DATUM(1);
 	Datum tzname = PG_GETARG_DATUM(2);
+	TimezoneCache *cache = timezone_cache_get(fcinfo, tzname);
 
 	/*
 	 * Convert 'timestamptz' to TIMESTAMP at given 'tzname'.
 	 * The code is equal to 'timestamptz AT TIME ZONE tzname'.
 	 */
-	timestamp = DirectFunctionCall2(timestamptz_zone, tzname, timestamptz);
+	timestamp = timezone_cache_to_local(cache, tzname, timestamptz);
 
 	/* Then treat resulting timestamp as a regular one */
 	result =
@@ -698,7 +946,7 @@ ts_time_bucket_ng_timezone(PG_FUNCTION_ARGS)
 	if (TIMESTAMP_NOT_FINITE(result))
 		PG_RETURN_TIMESTAMP(result);
 
-	PG_RETURN_DATUM(DirectFunctionCall2(timestamp_zone, tzname, TimestampGetDatum(result)));
+	PG_RETURN_DATUM(timezone_cache_from_local(cache, tzname, TimestampGetDatum(result)));
 }
 
 TS_FUNCTION_INFO_V1(ts_time_bucket_ng_timezone_origin);
@@ -711,15 +959,16 @@ ts_time_bucket_ng_timezone_origin(PG_FUNCTION_ARGS)
 	Datum timestamptz = PG_GETARG_DATUM(1);
 	Datum origintz = PG_GETARG_DATUM(2);
 	Datum tzname = PG_GETARG_DATUM(3);
+	TimezoneCache *cache = timezone_cache_get(fcinfo, tzname);
 
 	/*
 	 * Convert 'origin' to TIMESTAMP at given 'tzname'.
 	 * The code is equal to 'origin AT TIME ZONE tzname'.
 	 */
-	origin = DirectFunctionCall2(timestamptz_zone, tzname, origintz);
+	origin = timezone_cache_to_local(cache, tzname, origintz);
 
 	/* Same for 'timestamptz' */
-	timestamp = DirectFunctionCall2(timestamptz_zone, tzname, timestamptz);
+	timestamp = timezone_cache_to_local(cache, tzname, timestamptz);
 
 	/* Then treat resulting 'timestamp' and 'origin' as a regular ones */
 	result = DatumGetTimestamp(
@@ -727,5 +976,5 @@ ts_time_bucket_ng_timezone_origin(PG_FUNCTION_ARGS)
 	if (TIMESTAMP_NOT_FINITE(result))
 		PG_RETURN_TIMESTAMP(result);
 
-	PG_RETURN_DATUM(DirectFunctionCall2(timestamp_zone, tzname, TimestampGetDatum(result)));
+	PG_RETURN_DATUM(timezone_cache_from_local(cache, tzname, TimestampGetDatum(result)));
 }
@@ -19,6 +19,10 @@ extern TSDLLEXPORT Datum ts_timestamp_bucket(PG_FUNCTION_ARGS);
 extern TSDLLEXPORT Datum ts_timestamptz_bucket(PG_FUNCTION_ARGS);
 extern TSDLLEXPORT Datum ts_timestamptz_timezone_bucket(PG_FUNCTION_ARGS);
 extern TSDLLEXPORT int64 ts_time_bucket_by_type(int64 interval, int64 timestamp, Oid type);
+extern TSDLLEXPORT bool ts_time_bucket_int64_params(Oid type, Datum width, Datum origin,
+													bool has_origin, int64 *period, int64 *shift);
+extern TSDLLEXPORT void ts_time_bucket_int64_array(Oid type, int64 period, int64 shift,
+												   const int64 *values, int n, int64 *result);
 extern TSDLLEXPORT Datum ts_time_bucket_ng_date(PG_FUNCTION_ARGS);
 extern TSDLLEXPORT Datum ts_time_bucket_ng_timestamp(PG_FUNCTION_ARGS);
 extern TSDLLEXPORT Datum ts_time_bucket_ng_timestamptz(PG_FUNCTION_ARGS);
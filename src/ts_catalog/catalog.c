@@ -4,11 +4,16 @@
  * LICENSE-APACHE for a copy of the license.
  */
 #include <postgres.h>
+#include <access/genam.h>
+#include <access/table.h>
+#include <catalog/index.h>
+#include <catalog/pg_extension.h>
 #include <catalog/pg_namespace.h>
 #include <catalog/namespace.h>
 #include <catalog/indexing.h>
 #include <utils/lsyscache.h>
 #include <utils/builtins.h>
+#include <utils/fmgroids.h>
 #include <utils/regproc.h>
 #include <utils/syscache.h>
 #include <utils/inval.h>
@@ -18,10 +23,12 @@
 #include <commands/dbcommands.h>
 #include <commands/sequence.h>
 
+#include "bgw/launcher_interface.h"
 #include "compat/compat.h"
 #include "ts_catalog/catalog.h"
 #include "extension.h"
 #include "cache_invalidate.h"
+#include "loader/catalog_cache.h"
 
 static const TableInfoDef catalog_table_names[_MAX_CATALOG_TABLES + 1] = {
 	[HYPERTABLE] = {
@@ -120,6 +127,26 @@ static const TableInfoDef catalog_table_names[_MAX_CATALOG_TABLES + 1] = {
 		.schema_name = INTERNAL_SCHEMA_NAME,
 		.table_name = JOB_ERRORS_TABLE_NAME,
 	},
+	[CHUNK_COLUMN_STATS] = {
+		.schema_name = CATALOG_SCHEMA_NAME,
+		.table_name = CHUNK_COLUMN_STATS_TABLE_NAME,
+	},
+	[JOB_HISTORY] = {
+		.schema_name = INTERNAL_SCHEMA_NAME,
+		.table_name = JOB_HISTORY_TABLE_NAME,
+	},
+	[CONTINUOUS_AGGS_WATERMARK] = {
+		.schema_name = CATALOG_SCHEMA_NAME,
+		.table_name = CONTINUOUS_AGGS_WATERMARK_TABLE_NAME,
+	},
+	[CHUNK_SIZE_STATS] = {
+		.schema_name = CATALOG_SCHEMA_NAME,
+		.table_name = CHUNK_SIZE_STATS_TABLE_NAME,
+	},
+	[CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG] = {
+		.schema_name = CATALOG_SCHEMA_NAME,
+		.table_name = CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_TABLE_NAME,
+	},
 	[_MAX_CATALOG_TABLES] = {
 		.schema_name = "invalid schema",
 		.table_name = "invalid table",
@@ -282,6 +309,30 @@ static const TableIndexDef catalog_table_index_definitions[_MAX_CATALOG_TABLES]
 		.names = (char *[]) {
 			[CONTINUOUS_AGGS_BUCKET_FUNCTION_PKEY_IDX] = "continuous_aggs_bucket_function_pkey",
 		},
+	},
+	[CHUNK_COLUMN_STATS] = {
+		.length = _MAX_CHUNK_COLUMN_STATS_INDEX,
+		.names = (char *[]) {
+			[CHUNK_COLUMN_STATS_PKEY] = "chunk_column_stats_pkey",
+		},
+	},
+	[CONTINUOUS_AGGS_WATERMARK] = {
+		.length = _MAX_CONTINUOUS_AGGS_WATERMARK_INDEX,
+		.names = (char *[]) {
+			[CONTINUOUS_AGGS_WATERMARK_PKEY] = "continuous_aggs_watermark_pkey",
+		},
+	},
+	[CHUNK_SIZE_STATS] = {
+		.length = _MAX_CHUNK_SIZE_STATS_INDEX,
+		.names = (char *[]) {
+			[CHUNK_SIZE_STATS_PKEY] = "chunk_size_stats_pkey",
+		},
+	},
+	[CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG] = {
+		.length = _MAX_CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_INDEX,
+		.names = (char *[]) {
+			[CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_IDX] = "continuous_aggs_partition_invalidation_log_idx",
+		},
 	}
 };
 
@@ -464,37 +515,192 @@ ts_catalog_table_info_init(CatalogTableInfo *tables_info, int max_tables,
 	}
 }
 
-TSDLLEXPORT Catalog *
-ts_catalog_get(void)
+/*
+ * The number of OIDs of the catalog in the shared catalog cache, see
+ * catalog_cache_oids().
+ */
+#define CATALOG_NUM_OIDS                                                                           \
+	(_MAX_CATALOG_TABLES * (2 + _MAX_TABLE_INDEXES) + _TS_MAX_SCHEMA + _MAX_CACHE_TYPES +          \
+	 _MAX_INTERNAL_FUNCTIONS)
+
+/*
+ * The shared catalog cache is allocated by the loader when
+ * timescaledb.shared_catalog_cache_size is set, so it is only available when
+ * the loader is preloaded.
+ */
+static CatalogCacheRendezvous *
+catalog_cache_get(void)
+{
+	static CatalogCacheRendezvous *catalog_cache = NULL;
+
+	if (catalog_cache == NULL)
+		catalog_cache =
+			*(CatalogCacheRendezvous **) find_rendezvous_variable(RENDEZVOUS_CATALOG_CACHE);
+
+	return catalog_cache;
+}
+
+/*
+ * The xmin of the extension's row in pg_extension. The row is updated by
+ * ALTER EXTENSION, which can recreate catalog tables, so the cached OIDs are
+ * only valid for the row version they were looked up with. The same goes for
+ * the ids in the catalog tables when the extension is created again.
+ */
+static TransactionId
+catalog_extension_xmin(Oid extension_id)
 {
+	Relation rel = table_open(ExtensionRelationId, AccessShareLock);
+	TransactionId xmin = InvalidTransactionId;
+	SysScanDesc scan;
+	ScanKeyData key;
+	HeapTuple tuple;
+
+	ScanKeyInit(&key,
+				Anum_pg_extension_oid,
+				BTEqualStrategyNumber,
+				F_OIDEQ,
+				ObjectIdGetDatum(extension_id));
+	scan = systable_beginscan(rel, ExtensionOidIndexId, true, NULL, 1, &key);
+	tuple = systable_getnext(scan);
+
+	/* The raw xmin, since freezing the row doesn't change the catalog */
+	if (HeapTupleIsValid(tuple))
+		xmin = HeapTupleHeaderGetRawXmin(tuple->t_data);
+
+	systable_endscan(scan);
+	table_close(rel, AccessShareLock);
+
+	return xmin;
+}
+
+/*
+ * Copy the OIDs of the catalog from or to the array of OIDs of the shared
+ * catalog cache.
+ */
+static void
+catalog_cache_oids(Catalog *catalog, Oid *oids, bool store)
+{
+	Oid *values[CATALOG_NUM_OIDS];
+	int n = 0;
 	int i;
+	int j;
 
-	if (!OidIsValid(MyDatabaseId))
-		elog(ERROR, "invalid database ID");
+	for (i = 0; i < _MAX_CATALOG_TABLES; i++)
+	{
+		values[n++] = &catalog->tables[i].id;
+		values[n++] = &catalog->tables[i].serial_relid;
 
-	if (!ts_extension_is_loaded())
-		elog(ERROR, "tried calling catalog_get when extension isn't loaded");
+		for (j = 0; j < _MAX_TABLE_INDEXES; j++)
+			values[n++] = &catalog->tables[i].index_ids[j];
+	}
 
-	if (s_catalog.initialized || !IsTransactionState())
-		return &s_catalog;
+	for (i = 0; i < _TS_MAX_SCHEMA; i++)
+		values[n++] = &catalog->extension_schema_id[i];
 
-	memset(&s_catalog, 0, sizeof(Catalog));
-	ts_catalog_table_info_init(s_catalog.tables,
+	for (i = 0; i < _MAX_CACHE_TYPES; i++)
+		values[n++] = &catalog->caches[i].inval_proxy_id;
+
+	for (i = 0; i < _MAX_INTERNAL_FUNCTIONS; i++)
+		values[n++] = &catalog->functions[i].function_id;
+
+	Assert(n == CATALOG_NUM_OIDS);
+
+	for (i = 0; i < n; i++)
+	{
+		if (store)
+			oids[i] = *values[i];
+		else
+			*values[i] = oids[i];
+	}
+}
+
+/*
+ * Get the OIDs of the catalog from the shared catalog cache.
+ *
+ * Returns false if they are not cached for the current version of the
+ * extension.
+ */
+static bool
+catalog_cache_lookup(Catalog *catalog, Oid extension_id, TransactionId extension_xmin)
+{
+	CatalogCacheRendezvous *catalog_cache = catalog_cache_get();
+	CatalogCacheEntry *entry;
+	bool found = false;
+
+	if (catalog_cache == NULL)
+		return false;
+
+	LWLockAcquire(catalog_cache->lock, LW_SHARED);
+	entry = hash_search(catalog_cache->databases, &MyDatabaseId, HASH_FIND, NULL);
+	if (entry != NULL && entry->extension_id == extension_id &&
+		entry->extension_xmin == extension_xmin && entry->num_oids == CATALOG_NUM_OIDS)
+	{
+		catalog_cache_oids(catalog, entry->oids, false);
+		found = true;
+	}
+	LWLockRelease(catalog_cache->lock);
+
+	return found;
+}
+
+static void
+catalog_cache_add(Catalog *catalog, Oid extension_id, TransactionId extension_xmin)
+{
+	CatalogCacheRendezvous *catalog_cache = catalog_cache_get();
+	CatalogCacheEntry *entry;
+	bool found;
+
+	StaticAssertStmt(CATALOG_NUM_OIDS <= CATALOG_CACHE_MAX_OIDS,
+					 "catalog OIDs don't fit in the shared catalog cache");
+
+	/*
+	 * CREATE and ALTER EXTENSION update the row before running the scripts,
+	 * so the catalog can still change within the transaction that did it.
+	 */
+	if (catalog_cache == NULL || !TransactionIdIsValid(extension_xmin) ||
+		TransactionIdIsCurrentTransactionId(extension_xmin))
+		return;
+
+	LWLockAcquire(catalog_cache->lock, LW_EXCLUSIVE);
+
+	/* When the cache is full, the catalog is just not cached */
+	entry = hash_search(catalog_cache->databases, &MyDatabaseId, HASH_FIND, NULL);
+	if (entry == NULL &&
+		hash_get_num_entries(catalog_cache->databases) < catalog_cache->max_entries)
+		entry = hash_search(catalog_cache->databases, &MyDatabaseId, HASH_ENTER_NULL, &found);
+
+	if (entry != NULL)
+	{
+		entry->extension_id = extension_id;
+		entry->extension_xmin = extension_xmin;
+		entry->num_oids = CATALOG_NUM_OIDS;
+		catalog_cache_oids(catalog, entry->oids, true);
+	}
+
+	LWLockRelease(catalog_cache->lock);
+}
+
+/*
+ * Look up the OIDs of the catalog tables, indexes, sequences and functions.
+ */
+static void
+catalog_lookup_oids(Catalog *catalog)
+{
+	int i;
+
+	ts_catalog_table_info_init(catalog->tables,
 							   _MAX_CATALOG_TABLES,
 							   catalog_table_names,
 							   catalog_table_index_definitions,
 							   catalog_table_serial_id_names);
 
 	for (i = 0; i < _TS_MAX_SCHEMA; i++)
-		s_catalog.extension_schema_id[i] = get_namespace_oid(ts_extension_schema_names[i], false);
+		catalog->extension_schema_id[i] = get_namespace_oid(ts_extension_schema_names[i], false);
 
 	for (i = 0; i < _MAX_CACHE_TYPES; i++)
-		s_catalog.caches[i].inval_proxy_id =
+		catalog->caches[i].inval_proxy_id =
 			get_relname_relid(cache_proxy_table_names[i],
-							  s_catalog.extension_schema_id[TS_CACHE_SCHEMA]);
-
-	ts_cache_invalidate_set_proxy_tables(s_catalog.caches[CACHE_TYPE_HYPERTABLE].inval_proxy_id,
-										 s_catalog.caches[CACHE_TYPE_BGW_JOB].inval_proxy_id);
+							  catalog->extension_schema_id[TS_CACHE_SCHEMA]);
 
 	for (i = 0; i < _MAX_INTERNAL_FUNCTIONS; i++)
 	{
@@ -517,8 +723,49 @@ ts_catalog_get(void)
 				 def.name,
 				 def.args);
 
-		s_catalog.functions[i].function_id = funclist->oid;
+		catalog->functions[i].function_id = funclist->oid;
 	}
+}
+
+TSDLLEXPORT Catalog *
+ts_catalog_get(void)
+{
+	int i;
+
+	if (!OidIsValid(MyDatabaseId))
+		elog(ERROR, "invalid database ID");
+
+	if (!ts_extension_is_loaded())
+		elog(ERROR, "tried calling catalog_get when extension isn't loaded");
+
+	if (s_catalog.initialized || !IsTransactionState())
+		return &s_catalog;
+
+	memset(&s_catalog, 0, sizeof(Catalog));
+
+	/*
+	 * Looking up all the OIDs takes more than a hundred catalog lookups, which
+	 * is a noticeable part of the first query of a new backend, so they are
+	 * shared between the backends through the loader when possible.
+	 */
+	s_catalog.extension_id = ts_extension_get_oid();
+	s_catalog.extension_xmin = catalog_extension_xmin(s_catalog.extension_id);
+
+	if (!catalog_cache_lookup(&s_catalog, s_catalog.extension_id, s_catalog.extension_xmin))
+	{
+		catalog_lookup_oids(&s_catalog);
+		catalog_cache_add(&s_catalog, s_catalog.extension_id, s_catalog.extension_xmin);
+	}
+
+	for (i = 0; i < _MAX_CATALOG_TABLES; i++)
+	{
+		s_catalog.tables[i].name = catalog_table_names[i].table_name;
+		s_catalog.tables[i].schema_name = catalog_table_names[i].schema_name;
+	}
+
+	ts_cache_invalidate_set_proxy_tables(s_catalog.caches[CACHE_TYPE_HYPERTABLE].inval_proxy_id,
+										 s_catalog.caches[CACHE_TYPE_BGW_JOB].inval_proxy_id,
+										 s_catalog.tables[DIMENSION_SLICE].id);
 	s_catalog.initialized = true;
 
 	return &s_catalog;
@@ -530,7 +777,7 @@ ts_catalog_reset(void)
 	s_catalog.initialized = false;
 	database_info.database_id = InvalidOid;
 
-	ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid);
+	ts_cache_invalidate_set_proxy_tables(InvalidOid, InvalidOid, InvalidOid);
 }
 
 static CatalogTable
@@ -674,6 +921,71 @@ ts_catalog_insert_values(Relation rel, TupleDesc tupdesc, Datum *values, bool *n
 	heap_freetuple(tuple);
 }
 
+/*
+ * Insert the index entries of a tuple into the indexes opened with
+ * CatalogOpenIndexes(). This is a copy of the static CatalogIndexInsert() of
+ * PostgreSQL, so it only supports plain indexes like the catalog ones, which
+ * is also what the indexes of the compressed chunks are.
+ */
+TSDLLEXPORT void
+ts_catalog_index_insert(CatalogIndexState indstate, HeapTuple heapTuple)
+{
+	int i;
+	int numIndexes;
+	RelationPtr relationDescs;
+	Relation heapRelation;
+	TupleTableSlot *slot;
+	IndexInfo **indexInfoArray;
+	Datum values[INDEX_MAX_KEYS];
+	bool isnull[INDEX_MAX_KEYS];
+
+	/* HOT update does not require index inserts */
+	if (HeapTupleIsHeapOnly(heapTuple))
+		return;
+
+	numIndexes = indstate->ri_NumIndices;
+	if (numIndexes == 0)
+		return;
+	relationDescs = indstate->ri_IndexRelationDescs;
+	indexInfoArray = indstate->ri_IndexRelationInfo;
+	heapRelation = indstate->ri_RelationDesc;
+
+	/* Need a slot to hold the tuple being examined */
+	slot = MakeSingleTupleTableSlot(RelationGetDescr(heapRelation), &TTSOpsHeapTuple);
+	ExecStoreHeapTuple(heapTuple, slot, false);
+
+	for (i = 0; i < numIndexes; i++)
+	{
+		IndexInfo *indexInfo = indexInfoArray[i];
+
+		/* If the index is marked as read-only, ignore it */
+		if (!indexInfo->ii_ReadyForInserts)
+			continue;
+
+		/* Expressional and partial indexes are not supported */
+		Assert(indexInfo->ii_Expressions == NIL);
+		Assert(indexInfo->ii_Predicate == NIL);
+		Assert(indexInfo->ii_ExclusionOps == NULL);
+		Assert(relationDescs[i]->rd_index->indimmediate);
+		Assert(indexInfo->ii_NumIndexKeyAttrs != 0);
+
+		FormIndexDatum(indexInfo, slot, NULL, values, isnull);
+
+		index_insert(relationDescs[i],
+					 values,
+					 isnull,
+					 &(heapTuple->t_self),
+					 heapRelation,
+					 relationDescs[i]->rd_index->indisunique ? UNIQUE_CHECK_YES : UNIQUE_CHECK_NO,
+#if PG14_GE
+					 false,
+#endif
+					 indexInfo);
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+}
+
 void
 ts_catalog_update_tid_only(Relation rel, ItemPointer tid, HeapTuple tuple)
 {
@@ -755,12 +1067,23 @@ ts_catalog_invalidate_cache(Oid catalog_relid, CmdType operation)
 		case CHUNK:
 		case CHUNK_CONSTRAINT:
 		case CHUNK_DATA_NODE:
+			if (operation == CMD_UPDATE || operation == CMD_DELETE)
+			{
+				relid = ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
+				CacheInvalidateRelcacheByRelid(relid);
+			}
+			break;
 		case DIMENSION_SLICE:
 			if (operation == CMD_UPDATE || operation == CMD_DELETE)
 			{
 				relid = ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
 				CacheInvalidateRelcacheByRelid(relid);
 			}
+			else
+			{
+				/* New slices only affect the dimension slice index */
+				CacheInvalidateRelcacheByRelid(catalog_relid);
+			}
 			break;
 		case HYPERTABLE:
 		case HYPERTABLE_DATA_NODE:
@@ -773,6 +1096,7 @@ ts_catalog_invalidate_cache(Oid catalog_relid, CmdType operation)
 		case BGW_JOB:
 			relid = ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_BGW_JOB);
 			CacheInvalidateRelcacheByRelid(relid);
+			ts_bgw_scheduler_jobs_changed();
 			break;
 		case CHUNK_INDEX:
 		default:
@@ -11,6 +11,7 @@
 #include <utils/rel.h>
 #include <nodes/nodes.h>
 #include <access/heapam.h>
+#include <catalog/indexing.h>
 
 #include "export.h"
 #include "extension_constants.h"
@@ -57,6 +58,11 @@ typedef enum CatalogTable
 	CHUNK_COPY_OPERATION,
 	CONTINUOUS_AGGS_BUCKET_FUNCTION,
 	JOB_ERRORS,
+	CHUNK_COLUMN_STATS,
+	JOB_HISTORY,
+	CONTINUOUS_AGGS_WATERMARK,
+	CHUNK_SIZE_STATS,
+	CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
 	/* Don't forget updating catalog.c when adding new tables! */
 	_MAX_CATALOG_TABLES,
 } CatalogTable;
@@ -1261,6 +1267,128 @@ typedef enum Anum_compression_chunk_size_pkey
 
 #define Natts_compression_chunk_size_pkey (_Anum_compression_chunk_size_pkey_max - 1)
 
+/*********************************************
+ *
+ * Chunk column stats table definitions
+ *
+ *********************************************/
+#define CHUNK_COLUMN_STATS_TABLE_NAME "chunk_column_stats"
+
+/* The row with this chunk id marks a column as tracked on the hypertable */
+#define CHUNK_COLUMN_STATS_HYPERTABLE_CHUNK_ID 0
+
+typedef enum Anum_chunk_column_stats
+{
+	Anum_chunk_column_stats_hypertable_id = 1,
+	Anum_chunk_column_stats_chunk_id,
+	Anum_chunk_column_stats_column_name,
+	Anum_chunk_column_stats_range_start,
+	Anum_chunk_column_stats_range_end,
+	Anum_chunk_column_stats_has_nulls,
+	_Anum_chunk_column_stats_max,
+} Anum_chunk_column_stats;
+
+#define Natts_chunk_column_stats (_Anum_chunk_column_stats_max - 1)
+
+enum
+{
+	CHUNK_COLUMN_STATS_PKEY = 0,
+	_MAX_CHUNK_COLUMN_STATS_INDEX,
+};
+typedef enum Anum_chunk_column_stats_pkey
+{
+	Anum_chunk_column_stats_pkey_hypertable_id = 1,
+	Anum_chunk_column_stats_pkey_chunk_id,
+	Anum_chunk_column_stats_pkey_column_name,
+	_Anum_chunk_column_stats_pkey_max,
+} Anum_chunk_column_stats_pkey;
+
+#define Natts_chunk_column_stats_pkey (_Anum_chunk_column_stats_pkey_max - 1)
+
+/*********************************************
+ *
+ * Chunk size stats table definitions
+ *
+ *********************************************/
+#define CHUNK_SIZE_STATS_TABLE_NAME "chunk_size_stats"
+
+typedef enum Anum_chunk_size_stats
+{
+	Anum_chunk_size_stats_hypertable_id = 1,
+	Anum_chunk_size_stats_chunk_id,
+	Anum_chunk_size_stats_heap_bytes,
+	Anum_chunk_size_stats_index_bytes,
+	Anum_chunk_size_stats_toast_bytes,
+	Anum_chunk_size_stats_compressed_heap_bytes,
+	Anum_chunk_size_stats_compressed_index_bytes,
+	Anum_chunk_size_stats_compressed_toast_bytes,
+	Anum_chunk_size_stats_last_updated,
+	_Anum_chunk_size_stats_max,
+} Anum_chunk_size_stats;
+
+#define Natts_chunk_size_stats (_Anum_chunk_size_stats_max - 1)
+
+enum
+{
+	CHUNK_SIZE_STATS_PKEY = 0,
+	_MAX_CHUNK_SIZE_STATS_INDEX,
+};
+typedef enum Anum_chunk_size_stats_pkey
+{
+	Anum_chunk_size_stats_pkey_hypertable_id = 1,
+	Anum_chunk_size_stats_pkey_chunk_id,
+	_Anum_chunk_size_stats_pkey_max,
+} Anum_chunk_size_stats_pkey;
+
+#define Natts_chunk_size_stats_pkey (_Anum_chunk_size_stats_pkey_max - 1)
+
+/*********************************************
+ *
+ * Continuous aggregate partition invalidation log definitions
+ *
+ *********************************************/
+#define CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_TABLE_NAME                                      \
+	"continuous_aggs_partition_invalidation_log"
+typedef enum Anum_continuous_aggs_partition_invalidation_log
+{
+	Anum_continuous_aggs_partition_invalidation_log_materialization_id = 1,
+	Anum_continuous_aggs_partition_invalidation_log_lowest_modified_value,
+	Anum_continuous_aggs_partition_invalidation_log_greatest_modified_value,
+	Anum_continuous_aggs_partition_invalidation_log_partition_range_start,
+	Anum_continuous_aggs_partition_invalidation_log_partition_range_end,
+	_Anum_continuous_aggs_partition_invalidation_log_max,
+} Anum_continuous_aggs_partition_invalidation_log;
+
+#define Natts_continuous_aggs_partition_invalidation_log                                           \
+	(_Anum_continuous_aggs_partition_invalidation_log_max - 1)
+
+typedef struct FormData_continuous_aggs_partition_invalidation_log
+{
+	int32 materialization_id;
+	int64 lowest_modified_value;
+	int64 greatest_modified_value;
+	int64 partition_range_start;
+	int64 partition_range_end;
+} FormData_continuous_aggs_partition_invalidation_log;
+
+typedef FormData_continuous_aggs_partition_invalidation_log
+	*Form_continuous_aggs_partition_invalidation_log;
+
+enum
+{
+	CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_IDX = 0,
+	_MAX_CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_INDEX,
+};
+typedef enum Anum_continuous_aggs_partition_invalidation_log_idx
+{
+	Anum_continuous_aggs_partition_invalidation_log_idx_materialization_id = 1,
+	Anum_continuous_aggs_partition_invalidation_log_idx_lowest_modified_value,
+	_Anum_continuous_aggs_partition_invalidation_log_idx_max,
+} Anum_continuous_aggs_partition_invalidation_log_idx;
+
+#define Natts_continuous_aggs_partition_invalidation_log_idx                                       \
+	(_Anum_continuous_aggs_partition_invalidation_log_idx_max - 1)
+
 /*
  * The maximum number of indexes a catalog table can have.
  * This needs to be bumped in case of new catalog tables that have more indexes.
@@ -1399,6 +1527,11 @@ typedef struct Catalog
 		Oid function_id;
 	} functions[_MAX_INTERNAL_FUNCTIONS];
 
+	/* The extension and the xmin of its row in pg_extension, which identify
+	 * the catalog version for the caches shared between backends */
+	Oid extension_id;
+	TransactionId extension_xmin;
+
 	bool initialized;
 } Catalog;
 
@@ -1433,6 +1566,58 @@ typedef struct FormData_job_error
 
 typedef FormData_job_error *Form_job_error;
 
+#define JOB_HISTORY_TABLE_NAME "job_history"
+
+enum Anum_job_history
+{
+	Anum_job_history_job_id = 1,
+	Anum_job_history_pid,
+	Anum_job_history_start_time,
+	Anum_job_history_finish_time,
+	Anum_job_history_rows_processed,
+	Anum_job_history_chunks_processed,
+	Anum_job_history_bytes_read,
+	Anum_job_history_bytes_written,
+	Anum_job_history_wal_bytes,
+	Anum_job_history_user_cpu_time,
+	Anum_job_history_system_cpu_time,
+	_Anum_job_history_max,
+};
+
+#define Natts_job_history (_Anum_job_history_max - 1)
+
+/****** CONTINUOUS_AGGS_WATERMARK_TABLE definitions*/
+#define CONTINUOUS_AGGS_WATERMARK_TABLE_NAME "continuous_aggs_watermark"
+typedef enum Anum_continuous_aggs_watermark
+{
+	Anum_continuous_aggs_watermark_mat_hypertable_id = 1,
+	Anum_continuous_aggs_watermark_watermark,
+	_Anum_continuous_aggs_watermark_max,
+} Anum_continuous_aggs_watermark;
+
+#define Natts_continuous_aggs_watermark (_Anum_continuous_aggs_watermark_max - 1)
+
+typedef struct FormData_continuous_aggs_watermark
+{
+	int32 mat_hypertable_id;
+	int64 watermark;
+} FormData_continuous_aggs_watermark;
+
+typedef FormData_continuous_aggs_watermark *Form_continuous_aggs_watermark;
+
+enum
+{
+	CONTINUOUS_AGGS_WATERMARK_PKEY = 0,
+	_MAX_CONTINUOUS_AGGS_WATERMARK_INDEX,
+};
+typedef enum Anum_continuous_aggs_watermark_pkey
+{
+	Anum_continuous_aggs_watermark_pkey_mat_hypertable_id = 1,
+	_Anum_continuous_aggs_watermark_pkey_max,
+} Anum_continuous_aggs_watermark_pkey;
+
+#define Natts_continuous_aggs_watermark_pkey (_Anum_continuous_aggs_watermark_pkey_max - 1)
+
 extern void ts_catalog_table_info_init(CatalogTableInfo *tables, int max_table,
 									   const TableInfoDef *table_ary,
 									   const TableIndexDef *index_ary, const char **serial_id_ary);
@@ -1467,6 +1652,7 @@ extern TSDLLEXPORT void ts_catalog_insert_only(Relation rel, HeapTuple tuple);
 extern TSDLLEXPORT void ts_catalog_insert(Relation rel, HeapTuple tuple);
 extern TSDLLEXPORT void ts_catalog_insert_values(Relation rel, TupleDesc tupdesc, Datum *values,
 												 bool *nulls);
+extern TSDLLEXPORT void ts_catalog_index_insert(CatalogIndexState indstate, HeapTuple heapTuple);
 extern TSDLLEXPORT void ts_catalog_update_tid_only(Relation rel, ItemPointer tid, HeapTuple tuple);
 extern TSDLLEXPORT void ts_catalog_update_tid(Relation rel, ItemPointer tid, HeapTuple tuple);
 extern TSDLLEXPORT void ts_catalog_update(Relation rel, HeapTuple tuple);
@@ -0,0 +1,677 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/table.h>
+#include <access/tableam.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/datum.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/typcache.h>
+
+#include "ts_catalog/chunk_column_stats.h"
+#include "ts_catalog/catalog.h"
+#include "hypertable_cache.h"
+#include "scan_iterator.h"
+#include "scanner.h"
+#include "utils.h"
+
+/*
+ * The chunk column stats are the ranges of the values of some columns in
+ * every compressed chunk, like a BRIN summary of the whole chunk. The planner
+ * uses them to exclude the chunks that cannot match the filters on columns
+ * that are not partitioning the hypertable but correlate with its chunks,
+ * e.g., a region that changes over time.
+ *
+ * The ranges are calculated when a chunk is compressed, since the compressed
+ * chunks are rarely modified. Changing a compressed chunk makes it partial, and
+ * the ranges of partial chunks are not used until the chunk is recompressed and
+ * its range is widened with the new rows.
+ *
+ * The values are stored in the binary send format of the column type, so any
+ * type with a default btree operator class can be tracked and the stored
+ * values do not depend on the settings of the session, like DateStyle.
+ */
+
+/* The range of the values of a column seen so far */
+typedef struct ColumnRange
+{
+	NameData column_name;
+	AttrNumber attno;
+	Oid typid;
+	Oid collation;
+	int16 typlen;
+	bool typbyval;
+	FmgrInfo *cmp;
+	bool has_range;
+	Datum min;
+	Datum max;
+	bool has_nulls;
+} ColumnRange;
+
+static void
+init_scan_by_hypertable_id(ScanIterator *iterator, int32 hypertable_id, int32 chunk_id)
+{
+	iterator->ctx.index =
+		catalog_get_index(ts_catalog_get(), CHUNK_COLUMN_STATS, CHUNK_COLUMN_STATS_PKEY);
+	ts_scan_iterator_scan_key_init(iterator,
+								   Anum_chunk_column_stats_pkey_hypertable_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(hypertable_id));
+
+	/* A negative chunk id scans the rows of all the chunks */
+	if (chunk_id >= 0)
+		ts_scan_iterator_scan_key_init(iterator,
+									   Anum_chunk_column_stats_pkey_chunk_id,
+									   BTEqualStrategyNumber,
+									   F_INT4EQ,
+									   Int32GetDatum(chunk_id));
+}
+
+static ChunkColumnStats *
+chunk_column_stats_from_tuple(TupleInfo *ti)
+{
+	Datum values[Natts_chunk_column_stats];
+	bool nulls[Natts_chunk_column_stats];
+	ChunkColumnStats *stats = palloc0(sizeof(ChunkColumnStats));
+	bool should_free;
+	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+
+	heap_deform_tuple(tuple, ts_scanner_get_tupledesc(ti), values, nulls);
+
+	stats->chunk_id =
+		DatumGetInt32(values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_chunk_id)]);
+	namestrcpy(&stats->column_name,
+			   NameStr(*DatumGetName(
+				   values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_column_name)])));
+	if (!nulls[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_start)])
+		stats->range_start = DatumGetByteaPCopy(
+			values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_start)]);
+	if (!nulls[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_end)])
+		stats->range_end = DatumGetByteaPCopy(
+			values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_end)]);
+	stats->has_nulls =
+		DatumGetBool(values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_has_nulls)]);
+
+	if (should_free)
+		heap_freetuple(tuple);
+
+	return stats;
+}
+
+static List *
+chunk_column_stats_scan(int32 hypertable_id, int32 chunk_id)
+{
+	List *result = NIL;
+	ScanIterator iterator =
+		ts_scan_iterator_create(CHUNK_COLUMN_STATS, AccessShareLock, CurrentMemoryContext);
+
+	init_scan_by_hypertable_id(&iterator, hypertable_id, chunk_id);
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+
+		result = lappend(result, chunk_column_stats_from_tuple(ti));
+	}
+
+	return result;
+}
+
+static ChunkColumnStats *
+chunk_column_stats_find(List *stats_list, const char *column_name)
+{
+	ListCell *lc;
+
+	foreach (lc, stats_list)
+	{
+		ChunkColumnStats *stats = lfirst(lc);
+
+		if (namestrcmp(&stats->column_name, column_name) == 0)
+			return stats;
+	}
+
+	return NULL;
+}
+
+/*
+ * Get the stats of all the chunks of a hypertable, including the rows of the
+ * columns that are tracked.
+ */
+List *
+ts_chunk_column_stats_get_by_hypertable_id(int32 hypertable_id)
+{
+	return chunk_column_stats_scan(hypertable_id, -1);
+}
+
+static int
+chunk_column_stats_delete(int32 hypertable_id, int32 chunk_id, const char *column_name)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(CHUNK_COLUMN_STATS, RowExclusiveLock, CurrentMemoryContext);
+	CatalogSecurityContext sec_ctx;
+	int count = 0;
+
+	init_scan_by_hypertable_id(&iterator, hypertable_id, chunk_id);
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+
+		if (column_name != NULL)
+		{
+			bool isnull;
+			Datum name = slot_getattr(ti->slot, Anum_chunk_column_stats_column_name, &isnull);
+
+			Assert(!isnull);
+			if (namestrcmp(DatumGetName(name), column_name) != 0)
+				continue;
+		}
+
+		ts_catalog_delete_tid(ti->scanrel, ts_scanner_get_tuple_tid(ti));
+		count++;
+	}
+	ts_catalog_restore_user(&sec_ctx);
+
+	return count;
+}
+
+TSDLLEXPORT int
+ts_chunk_column_stats_delete_by_chunk_id(int32 hypertable_id, int32 chunk_id)
+{
+	return chunk_column_stats_delete(hypertable_id, chunk_id, NULL);
+}
+
+int
+ts_chunk_column_stats_delete_by_hypertable_id(int32 hypertable_id)
+{
+	return chunk_column_stats_delete(hypertable_id, -1, NULL);
+}
+
+int
+ts_chunk_column_stats_delete_by_column_name(int32 hypertable_id, const char *column_name)
+{
+	return chunk_column_stats_delete(hypertable_id, -1, column_name);
+}
+
+void
+ts_chunk_column_stats_rename_column(int32 hypertable_id, const char *old_column_name,
+									const char *new_column_name)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(CHUNK_COLUMN_STATS, RowExclusiveLock, CurrentMemoryContext);
+	CatalogSecurityContext sec_ctx;
+
+	init_scan_by_hypertable_id(&iterator, hypertable_id, -1);
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_scanner_foreach(&iterator)
+	{
+		Datum values[Natts_chunk_column_stats];
+		bool nulls[Natts_chunk_column_stats];
+		bool replace[Natts_chunk_column_stats] = { false };
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		TupleDesc tupdesc = ts_scanner_get_tupledesc(ti);
+		NameData new_name;
+		HeapTuple tuple, new_tuple;
+		bool should_free;
+
+		tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+		heap_deform_tuple(tuple, tupdesc, values, nulls);
+
+		if (namestrcmp(DatumGetName(values[AttrNumberGetAttrOffset(
+						   Anum_chunk_column_stats_column_name)]),
+					   old_column_name) == 0)
+		{
+			namestrcpy(&new_name, new_column_name);
+			values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_column_name)] =
+				NameGetDatum(&new_name);
+			replace[AttrNumberGetAttrOffset(Anum_chunk_column_stats_column_name)] = true;
+			new_tuple = heap_modify_tuple(tuple, tupdesc, values, nulls, replace);
+			ts_catalog_update(ti->scanrel, new_tuple);
+			heap_freetuple(new_tuple);
+		}
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	ts_catalog_restore_user(&sec_ctx);
+}
+
+static void
+chunk_column_stats_insert(int32 hypertable_id, int32 chunk_id, const char *column_name,
+						  bytea *range_start, bytea *range_end, bool has_nulls)
+{
+	Catalog *catalog = ts_catalog_get();
+	Datum values[Natts_chunk_column_stats];
+	bool nulls[Natts_chunk_column_stats] = { false };
+	CatalogSecurityContext sec_ctx;
+	NameData name;
+	Relation rel;
+
+	rel = table_open(catalog_get_table_id(catalog, CHUNK_COLUMN_STATS), RowExclusiveLock);
+	namestrcpy(&name, column_name);
+
+	values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_hypertable_id)] =
+		Int32GetDatum(hypertable_id);
+	values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_chunk_id)] = Int32GetDatum(chunk_id);
+	values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_column_name)] = NameGetDatum(&name);
+	values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_start)] =
+		PointerGetDatum(range_start);
+	nulls[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_start)] = range_start == NULL;
+	values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_end)] =
+		PointerGetDatum(range_end);
+	nulls[AttrNumberGetAttrOffset(Anum_chunk_column_stats_range_end)] = range_end == NULL;
+	values[AttrNumberGetAttrOffset(Anum_chunk_column_stats_has_nulls)] = BoolGetDatum(has_nulls);
+
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	ts_catalog_restore_user(&sec_ctx);
+	table_close(rel, RowExclusiveLock);
+}
+
+Datum
+ts_chunk_column_stats_decode(const bytea *value, Oid typid)
+{
+	StringInfoData buf;
+	Oid typreceive;
+	Oid typioparam;
+
+	getTypeBinaryInputInfo(typid, &typreceive, &typioparam);
+
+	/* The receive functions expect a trailing null like any StringInfo */
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
+
+	return OidReceiveFunctionCall(typreceive, &buf, typioparam, -1);
+}
+
+static bytea *
+chunk_column_stats_encode(Datum value, Oid typid)
+{
+	Oid typsend;
+	bool typisvarlena;
+
+	getTypeBinaryOutputInfo(typid, &typsend, &typisvarlena);
+
+	return OidSendFunctionCall(typsend, value);
+}
+
+/*
+ * Set up the range of a column of a relation. Returns false if the column
+ * does not exist anymore or its type cannot be ordered.
+ */
+static bool
+column_range_init(ColumnRange *range, Relation rel, const char *column_name)
+{
+	AttrNumber attno = get_attnum(RelationGetRelid(rel), column_name);
+	Form_pg_attribute attr;
+	TypeCacheEntry *tce;
+
+	if (attno == InvalidAttrNumber)
+		return false;
+
+	attr = TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(attno));
+	tce = lookup_type_cache(attr->atttypid, TYPECACHE_CMP_PROC_FINFO);
+
+	if (!OidIsValid(tce->cmp_proc))
+		return false;
+
+	*range = (ColumnRange){
+		.attno = attno,
+		.typid = attr->atttypid,
+		.collation = attr->attcollation,
+		.typlen = attr->attlen,
+		.typbyval = attr->attbyval,
+		.cmp = &tce->cmp_proc_finfo,
+	};
+	namestrcpy(&range->column_name, column_name);
+
+	return true;
+}
+
+static void
+column_range_add(ColumnRange *range, Datum value, bool isnull)
+{
+	bool is_min, is_max;
+
+	if (isnull)
+	{
+		range->has_nulls = true;
+		return;
+	}
+
+	if (!range->has_range)
+		is_min = is_max = true;
+	else
+	{
+		is_min = DatumGetInt32(FunctionCall2Coll(range->cmp, range->collation, value, range->min)) <
+				 0;
+		is_max = !is_min &&
+				 DatumGetInt32(
+					 FunctionCall2Coll(range->cmp, range->collation, value, range->max)) > 0;
+	}
+
+	if (!is_min && !is_max)
+		return;
+
+	/* Keep detoasted copies, the values of the chunk are gone once it is compressed */
+	if (range->typlen == -1)
+		value = PointerGetDatum(PG_DETOAST_DATUM_COPY(value));
+	else
+		value = datumCopy(value, range->typbyval, range->typlen);
+
+	if (is_min)
+	{
+		if (range->has_range && !range->typbyval)
+			pfree(DatumGetPointer(range->min));
+		range->min = value;
+	}
+
+	if (is_max)
+	{
+		if (range->has_range && !range->typbyval)
+			pfree(DatumGetPointer(range->max));
+		range->max = range->has_range ? value : datumCopy(value, range->typbyval, range->typlen);
+	}
+
+	range->has_range = true;
+}
+
+static void
+column_range_add_stats(ColumnRange *range, const ChunkColumnStats *stats)
+{
+	if (stats->range_start != NULL)
+		column_range_add(range,
+						 ts_chunk_column_stats_decode(stats->range_start, range->typid),
+						 false);
+	if (stats->range_end != NULL)
+		column_range_add(range,
+						 ts_chunk_column_stats_decode(stats->range_end, range->typid),
+						 false);
+	if (stats->has_nulls)
+		range->has_nulls = true;
+}
+
+static void
+column_range_store(const ColumnRange *range, int32 hypertable_id, int32 chunk_id)
+{
+	chunk_column_stats_delete(hypertable_id, chunk_id, NameStr(range->column_name));
+	chunk_column_stats_insert(hypertable_id,
+							  chunk_id,
+							  NameStr(range->column_name),
+							  range->has_range ? chunk_column_stats_encode(range->min, range->typid) :
+												 NULL,
+							  range->has_range ? chunk_column_stats_encode(range->max, range->typid) :
+												 NULL,
+							  range->has_nulls);
+}
+
+/*
+ * Calculate the ranges of the tracked columns of a chunk from the rows of a
+ * relation, normally the chunk itself before it is compressed.
+ *
+ * With widen, the existing ranges of the chunk are extended with the rows of
+ * the relation instead, e.g., with the new rows of a partially compressed
+ * chunk. The columns of the chunk that have no range are left without one,
+ * since the rows that are already compressed are not known.
+ */
+TSDLLEXPORT void
+ts_chunk_column_stats_calculate(const Hypertable *ht, Oid relid, int32 chunk_id, bool widen)
+{
+	List *tracked = chunk_column_stats_scan(ht->fd.id, CHUNK_COLUMN_STATS_HYPERTABLE_CHUNK_ID);
+	List *existing = NIL;
+	ColumnRange *ranges;
+	int num_ranges = 0;
+	AttrNumber max_attno = 0;
+	TableScanDesc scan;
+	TupleTableSlot *slot;
+	Relation rel;
+	ListCell *lc;
+
+	if (tracked == NIL)
+		return;
+
+	if (widen)
+		existing = chunk_column_stats_scan(ht->fd.id, chunk_id);
+
+	rel = table_open(relid, AccessShareLock);
+	ranges = palloc(sizeof(ColumnRange) * list_length(tracked));
+
+	foreach (lc, tracked)
+	{
+		const char *column_name = NameStr(((ChunkColumnStats *) lfirst(lc))->column_name);
+		ColumnRange *range = &ranges[num_ranges];
+
+		if (!column_range_init(range, rel, column_name))
+			continue;
+
+		if (widen)
+		{
+			ChunkColumnStats *stats = chunk_column_stats_find(existing, column_name);
+
+			if (stats == NULL)
+				continue;
+
+			column_range_add_stats(range, stats);
+		}
+
+		max_attno = Max(max_attno, range->attno);
+		num_ranges++;
+	}
+
+	if (num_ranges == 0)
+	{
+		table_close(rel, AccessShareLock);
+		return;
+	}
+
+	slot = table_slot_create(rel, NULL);
+	scan = table_beginscan(rel, GetLatestSnapshot(), 0, NULL);
+
+	while (table_scan_getnextslot(scan, ForwardScanDirection, slot))
+	{
+		slot_getsomeattrs(slot, max_attno);
+
+		for (int i = 0; i < num_ranges; i++)
+		{
+			int off = AttrNumberGetAttrOffset(ranges[i].attno);
+
+			column_range_add(&ranges[i], slot->tts_values[off], slot->tts_isnull[off]);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	table_endscan(scan);
+	ExecDropSingleTupleTableSlot(slot);
+	table_close(rel, AccessShareLock);
+
+	for (int i = 0; i < num_ranges; i++)
+		column_range_store(&ranges[i], ht->fd.id, chunk_id);
+}
+
+/*
+ * Widen the ranges of a chunk with the ranges of a chunk that is merged into
+ * it. The ranges the merged chunk does not have are removed from the chunk.
+ */
+TSDLLEXPORT void
+ts_chunk_column_stats_merge(const Hypertable *ht, int32 chunk_id, int32 merged_chunk_id)
+{
+	List *stats_list = chunk_column_stats_scan(ht->fd.id, chunk_id);
+	List *merged_stats_list;
+	Relation rel;
+	ListCell *lc;
+
+	if (stats_list == NIL)
+		return;
+
+	merged_stats_list = chunk_column_stats_scan(ht->fd.id, merged_chunk_id);
+	rel = table_open(ht->main_table_relid, AccessShareLock);
+
+	foreach (lc, stats_list)
+	{
+		ChunkColumnStats *stats = lfirst(lc);
+		ChunkColumnStats *merged_stats =
+			chunk_column_stats_find(merged_stats_list, NameStr(stats->column_name));
+		ColumnRange range;
+
+		if (merged_stats == NULL || !column_range_init(&range, rel, NameStr(stats->column_name)))
+		{
+			chunk_column_stats_delete(ht->fd.id, chunk_id, NameStr(stats->column_name));
+			continue;
+		}
+
+		column_range_add_stats(&range, stats);
+		column_range_add_stats(&range, merged_stats);
+		column_range_store(&range, ht->fd.id, chunk_id);
+	}
+
+	table_close(rel, AccessShareLock);
+}
+
+TS_FUNCTION_INFO_V1(ts_chunk_column_stats_enable);
+
+/*
+ * Track the ranges of a column in the chunks of a hypertable.
+ *
+ * hypertable - The hypertable
+ * column_name - The column to track
+ * if_not_exists - Do not fail if the column is tracked already
+ */
+Datum
+ts_chunk_column_stats_enable(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool if_not_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	TypeCacheEntry *tce;
+	Hypertable *ht;
+	Cache *hcache;
+	AttrNumber attno;
+	Oid typid;
+	Oid typfunc;
+	Oid typioparam;
+	bool typisvarlena;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("hypertable cannot be NULL")));
+
+	if (column_name == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("column name cannot be NULL")));
+
+	ts_hypertable_permissions_check(relid, GetUserId());
+	ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+
+	if (hypertable_is_distributed(ht) || TS_HYPERTABLE_IS_INTERNAL_COMPRESSION_TABLE(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("chunk skipping is not supported on hypertable \"%s\"",
+						get_rel_name(relid))));
+
+	attno = get_attnum(relid, NameStr(*column_name));
+
+	if (attno == InvalidAttrNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("column \"%s\" does not exist", NameStr(*column_name))));
+
+	typid = get_atttype(relid, attno);
+	tce = lookup_type_cache(typid, TYPECACHE_CMP_PROC | TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->cmp_proc) || !OidIsValid(tce->btree_opf))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),
+				 errmsg("cannot enable chunk skipping on column \"%s\"", NameStr(*column_name)),
+				 errdetail("The column type %s needs a default btree operator class.",
+						   format_type_be(typid))));
+
+	/* The ranges are stored in the binary format, so fail now if there is none */
+	getTypeBinaryOutputInfo(typid, &typfunc, &typisvarlena);
+	getTypeBinaryInputInfo(typid, &typfunc, &typioparam);
+
+	if (chunk_column_stats_find(chunk_column_stats_scan(ht->fd.id,
+														CHUNK_COLUMN_STATS_HYPERTABLE_CHUNK_ID),
+								NameStr(*column_name)) != NULL)
+	{
+		ereport(if_not_exists ? NOTICE : ERROR,
+				(errcode(ERRCODE_DUPLICATE_OBJECT),
+				 errmsg("chunk skipping already enabled on column \"%s\"%s",
+						NameStr(*column_name),
+						if_not_exists ? ", skipping" : "")));
+		ts_cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	chunk_column_stats_insert(ht->fd.id,
+							  CHUNK_COLUMN_STATS_HYPERTABLE_CHUNK_ID,
+							  NameStr(*column_name),
+							  NULL,
+							  NULL,
+							  false);
+	ts_cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(ts_chunk_column_stats_disable);
+
+/*
+ * Stop tracking the ranges of a column and remove the ranges of the chunks.
+ *
+ * hypertable - The hypertable
+ * column_name - The tracked column
+ * if_exists - Do not fail if the column is not tracked
+ */
+Datum
+ts_chunk_column_stats_disable(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool if_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("hypertable cannot be NULL")));
+
+	if (column_name == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("column name cannot be NULL")));
+
+	ts_hypertable_permissions_check(relid, GetUserId());
+	ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+
+	if (chunk_column_stats_find(chunk_column_stats_scan(ht->fd.id,
+														CHUNK_COLUMN_STATS_HYPERTABLE_CHUNK_ID),
+								NameStr(*column_name)) == NULL)
+	{
+		ereport(if_exists ? NOTICE : ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("chunk skipping not enabled on column \"%s\"%s",
+						NameStr(*column_name),
+						if_exists ? ", skipping" : "")));
+		ts_cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	ts_chunk_column_stats_delete_by_column_name(ht->fd.id, NameStr(*column_name));
+	ts_cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,39 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_CHUNK_COLUMN_STATS_H
+#define TIMESCALEDB_CHUNK_COLUMN_STATS_H
+
+#include <postgres.h>
+#include <nodes/pg_list.h>
+
+#include "export.h"
+#include "hypertable.h"
+
+typedef struct ChunkColumnStats
+{
+	int32 chunk_id;
+	NameData column_name;
+	/* The range in the binary format of the column type, NULL if there is none */
+	bytea *range_start;
+	bytea *range_end;
+	bool has_nulls;
+} ChunkColumnStats;
+
+extern List *ts_chunk_column_stats_get_by_hypertable_id(int32 hypertable_id);
+extern Datum ts_chunk_column_stats_decode(const bytea *value, Oid typid);
+extern TSDLLEXPORT void ts_chunk_column_stats_calculate(const Hypertable *ht, Oid relid,
+														int32 chunk_id, bool widen);
+extern TSDLLEXPORT void ts_chunk_column_stats_merge(const Hypertable *ht, int32 chunk_id,
+													int32 merged_chunk_id);
+extern TSDLLEXPORT int ts_chunk_column_stats_delete_by_chunk_id(int32 hypertable_id,
+																int32 chunk_id);
+extern int ts_chunk_column_stats_delete_by_hypertable_id(int32 hypertable_id);
+extern int ts_chunk_column_stats_delete_by_column_name(int32 hypertable_id,
+													   const char *column_name);
+extern void ts_chunk_column_stats_rename_column(int32 hypertable_id, const char *old_column_name,
+												const char *new_column_name);
+
+#endif /* TIMESCALEDB_CHUNK_COLUMN_STATS_H */
@@ -0,0 +1,239 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/table.h>
+#include <fmgr.h>
+#include <miscadmin.h>
+#include <utils/fmgroids.h>
+#include <utils/rel.h>
+#include <utils/timestamp.h>
+
+#include "ts_catalog/chunk_size_stats.h"
+#include "ts_catalog/catalog.h"
+#include "chunk.h"
+#include "hypertable_cache.h"
+#include "scan_iterator.h"
+#include "scanner.h"
+#include "utils.h"
+
+/*
+ * The chunk size stats are the sizes of the relations of every chunk, so that
+ * the approximate size functions can sum them up in a single catalog scan
+ * instead of opening every chunk, its compressed chunk, and their indexes and
+ * TOAST tables.
+ *
+ * The stats of a chunk are updated when the chunk is compressed, decompressed
+ * or recompressed. The chunks that can change otherwise, i.e., the
+ * uncompressed and the partially compressed chunks, are updated by
+ * refresh_chunk_size_stats(), which the compression policy calls after every
+ * run. Fully compressed chunks keep their stats until they are changed.
+ */
+
+static void
+init_scan_by_hypertable_id(ScanIterator *iterator, int32 hypertable_id, int32 chunk_id)
+{
+	iterator->ctx.index =
+		catalog_get_index(ts_catalog_get(), CHUNK_SIZE_STATS, CHUNK_SIZE_STATS_PKEY);
+	ts_scan_iterator_scan_key_init(iterator,
+								   Anum_chunk_size_stats_pkey_hypertable_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(hypertable_id));
+
+	/* A negative chunk id scans the rows of all the chunks */
+	if (chunk_id >= 0)
+		ts_scan_iterator_scan_key_init(iterator,
+									   Anum_chunk_size_stats_pkey_chunk_id,
+									   BTEqualStrategyNumber,
+									   F_INT4EQ,
+									   Int32GetDatum(chunk_id));
+}
+
+/* The IDs of the chunks of the hypertable that have stats */
+static List *
+chunk_size_stats_chunk_ids(int32 hypertable_id)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(CHUNK_SIZE_STATS, AccessShareLock, CurrentMemoryContext);
+	List *chunk_ids = NIL;
+
+	init_scan_by_hypertable_id(&iterator, hypertable_id, -1);
+	ts_scanner_foreach(&iterator)
+	{
+		bool isnull;
+		Datum chunk_id = slot_getattr(ts_scan_iterator_slot(&iterator),
+									  Anum_chunk_size_stats_chunk_id,
+									  &isnull);
+
+		Assert(!isnull);
+		chunk_ids = lappend_int(chunk_ids, DatumGetInt32(chunk_id));
+	}
+
+	return chunk_ids;
+}
+
+static void
+chunk_size_stats_store(const Chunk *chunk)
+{
+	Datum values[Natts_chunk_size_stats];
+	bool nulls[Natts_chunk_size_stats] = { false };
+	RelationSize size = ts_relation_size_impl(chunk->table_id);
+	RelationSize compressed_size = { 0 };
+	ScanIterator iterator =
+		ts_scan_iterator_create(CHUNK_SIZE_STATS, RowExclusiveLock, CurrentMemoryContext);
+	CatalogSecurityContext sec_ctx;
+	bool found = false;
+
+	if (chunk->fd.compressed_chunk_id != INVALID_CHUNK_ID)
+		compressed_size =
+			ts_relation_size_impl(ts_chunk_get_relid(chunk->fd.compressed_chunk_id, false));
+
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_hypertable_id)] =
+		Int32GetDatum(chunk->fd.hypertable_id);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_chunk_id)] = Int32GetDatum(chunk->fd.id);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_heap_bytes)] =
+		Int64GetDatum(size.heap_size);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_index_bytes)] =
+		Int64GetDatum(size.index_size);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_toast_bytes)] =
+		Int64GetDatum(size.toast_size);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_compressed_heap_bytes)] =
+		Int64GetDatum(compressed_size.heap_size);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_compressed_index_bytes)] =
+		Int64GetDatum(compressed_size.index_size);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_compressed_toast_bytes)] =
+		Int64GetDatum(compressed_size.toast_size);
+	values[AttrNumberGetAttrOffset(Anum_chunk_size_stats_last_updated)] =
+		TimestampTzGetDatum(GetCurrentTimestamp());
+
+	init_scan_by_hypertable_id(&iterator, chunk->fd.hypertable_id, chunk->fd.id);
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		HeapTuple new_tuple = heap_form_tuple(ts_scanner_get_tupledesc(ti), values, nulls);
+
+		ts_catalog_update_tid(ti->scanrel, ts_scanner_get_tuple_tid(ti), new_tuple);
+		heap_freetuple(new_tuple);
+		found = true;
+	}
+
+	if (!found)
+	{
+		Catalog *catalog = ts_catalog_get();
+		Relation rel =
+			table_open(catalog_get_table_id(catalog, CHUNK_SIZE_STATS), RowExclusiveLock);
+
+		ts_catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+		table_close(rel, RowExclusiveLock);
+	}
+	ts_catalog_restore_user(&sec_ctx);
+}
+
+/*
+ * Update the size stats of a chunk after its relations changed, e.g., after
+ * compressing it.
+ */
+TSDLLEXPORT void
+ts_chunk_size_stats_update(int32 chunk_id)
+{
+	/* Read the chunk again, the compressed chunk could have changed */
+	Chunk *chunk = ts_chunk_get_by_id(chunk_id, true);
+
+	chunk_size_stats_store(chunk);
+}
+
+/*
+ * Update the size stats of the chunks of the hypertable that could have
+ * changed since they were stored, and of the chunks that have no stats yet.
+ *
+ * Returns the number of updated chunks.
+ */
+int
+ts_chunk_size_stats_refresh(const Hypertable *ht)
+{
+	List *chunk_ids = ts_chunk_get_chunk_ids_by_hypertable_id(ht->fd.id);
+	List *known_chunk_ids = chunk_size_stats_chunk_ids(ht->fd.id);
+	ListCell *lc;
+	int count = 0;
+
+	foreach (lc, chunk_ids)
+	{
+		int32 chunk_id = lfirst_int(lc);
+		Chunk *chunk = ts_chunk_get_by_id(chunk_id, false);
+
+		if (chunk == NULL || chunk->fd.dropped)
+			continue;
+
+		if (ts_chunk_is_compressed(chunk) && !ts_chunk_is_partial(chunk) &&
+			list_member_int(known_chunk_ids, chunk_id))
+			continue;
+
+		chunk_size_stats_store(chunk);
+		count++;
+	}
+
+	return count;
+}
+
+int
+ts_chunk_size_stats_delete_by_chunk_id(int32 hypertable_id, int32 chunk_id)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(CHUNK_SIZE_STATS, RowExclusiveLock, CurrentMemoryContext);
+	CatalogSecurityContext sec_ctx;
+	int count = 0;
+
+	init_scan_by_hypertable_id(&iterator, hypertable_id, chunk_id);
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+
+		ts_catalog_delete_tid(ti->scanrel, ts_scanner_get_tuple_tid(ti));
+		count++;
+	}
+	ts_catalog_restore_user(&sec_ctx);
+
+	return count;
+}
+
+TS_FUNCTION_INFO_V1(ts_chunk_size_stats_refresh_hypertable);
+
+/*
+ * Refresh the size stats of the chunks of a hypertable.
+ *
+ * hypertable - The hypertable
+ *
+ * Returns the number of chunks whose stats were updated.
+ */
+Datum
+ts_chunk_size_stats_refresh_hypertable(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Hypertable *ht;
+	Cache *hcache;
+	int count;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("hypertable cannot be NULL")));
+
+	ts_hypertable_permissions_check(relid, GetUserId());
+	ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+
+	/* The chunks of a distributed hypertable have no local data */
+	if (hypertable_is_distributed(ht))
+		count = 0;
+	else
+		count = ts_chunk_size_stats_refresh(ht);
+	ts_cache_release(hcache);
+
+	PG_RETURN_INT32(count);
+}
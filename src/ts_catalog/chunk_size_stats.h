@@ -0,0 +1,18 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_CHUNK_SIZE_STATS_H
+#define TIMESCALEDB_CHUNK_SIZE_STATS_H
+
+#include <postgres.h>
+
+#include "export.h"
+#include "hypertable.h"
+
+extern TSDLLEXPORT void ts_chunk_size_stats_update(int32 chunk_id);
+extern int ts_chunk_size_stats_refresh(const Hypertable *ht);
+extern int ts_chunk_size_stats_delete_by_chunk_id(int32 hypertable_id, int32 chunk_id);
+
+#endif /* TIMESCALEDB_CHUNK_SIZE_STATS_H */
@@ -129,3 +129,31 @@ ts_compression_chunk_size_row_count(int32 uncompressed_chunk_id)
 	}
 	return rowcnt;
 }
+
+/*
+ * Return the average number of rows in the batches of the compressed chunk,
+ * or 0 if it is not known.
+ */
+double
+ts_compression_chunk_size_batch_size(int32 uncompressed_chunk_id)
+{
+	double batch_size = 0;
+	ScanIterator iterator =
+		ts_scan_iterator_create(COMPRESSION_CHUNK_SIZE, AccessShareLock, CurrentMemoryContext);
+	init_scan_by_uncompressed_chunk_id(&iterator, uncompressed_chunk_id);
+	ts_scanner_foreach(&iterator)
+	{
+		bool isnull_pre, isnull_post;
+		Datum rows_pre = slot_getattr(ts_scan_iterator_slot(&iterator),
+									  Anum_compression_chunk_size_numrows_pre_compression,
+									  &isnull_pre);
+		Datum rows_post = slot_getattr(ts_scan_iterator_slot(&iterator),
+									   Anum_compression_chunk_size_numrows_post_compression,
+									   &isnull_post);
+
+		if (!isnull_pre && !isnull_post && DatumGetInt64(rows_post) > 0)
+			batch_size = (double) DatumGetInt64(rows_pre) / DatumGetInt64(rows_post);
+	}
+
+	return batch_size;
+}
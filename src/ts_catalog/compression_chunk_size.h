@@ -22,5 +22,6 @@ typedef struct TotalSizes
 
 extern TSDLLEXPORT TotalSizes ts_compression_chunk_size_totals(void);
 extern TSDLLEXPORT int64 ts_compression_chunk_size_row_count(int32 uncompressed_chunk_id);
+extern TSDLLEXPORT double ts_compression_chunk_size_batch_size(int32 uncompressed_chunk_id);
 
 #endif
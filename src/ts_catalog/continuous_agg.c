@@ -192,6 +192,59 @@ invalidation_threshold_delete(int32 raw_hypertable_id)
 	}
 }
 
+static void
+init_watermark_scan_by_mat_hypertable_id(ScanIterator *iterator, const int32 mat_hypertable_id)
+{
+	iterator->ctx.index = catalog_get_index(ts_catalog_get(),
+											CONTINUOUS_AGGS_WATERMARK,
+											CONTINUOUS_AGGS_WATERMARK_PKEY);
+
+	ts_scan_iterator_scan_key_init(iterator,
+								   Anum_continuous_aggs_watermark_pkey_mat_hypertable_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(mat_hypertable_id));
+}
+
+static void
+cagg_watermark_delete(int32 mat_hypertable_id)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(CONTINUOUS_AGGS_WATERMARK, RowExclusiveLock, CurrentMemoryContext);
+
+	init_watermark_scan_by_mat_hypertable_id(&iterator, mat_hypertable_id);
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		ts_catalog_delete_tid(ti->scanrel, ts_scanner_get_tuple_tid(ti));
+	}
+}
+
+static void
+cagg_partition_invalidation_log_delete(int32 mat_hypertable_id)
+{
+	ScanIterator iterator = ts_scan_iterator_create(CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
+													RowExclusiveLock,
+													CurrentMemoryContext);
+
+	iterator.ctx.index = catalog_get_index(ts_catalog_get(),
+										   CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
+										   CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_IDX);
+	ts_scan_iterator_scan_key_init(
+		&iterator,
+		Anum_continuous_aggs_partition_invalidation_log_idx_materialization_id,
+		BTEqualStrategyNumber,
+		F_INT4EQ,
+		Int32GetDatum(mat_hypertable_id));
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		ts_catalog_delete_tid(ti->scanrel, ts_scanner_get_tuple_tid(ti));
+	}
+}
+
 static void
 cagg_bucket_function_delete(int32 mat_hypertable_id)
 {
@@ -1113,6 +1166,9 @@ drop_continuous_agg(FormData_continuous_agg *cadata, bool drop_user_view)
 		cagg_bucket_function_delete(cadata->mat_hypertable_id);
 	}
 
+	cagg_watermark_delete(cadata->mat_hypertable_id);
+	cagg_partition_invalidation_log_delete(cadata->mat_hypertable_id);
+
 	/* Perform actual deletions now */
 	if (OidIsValid(user_view.objectId))
 		performDeletion(&user_view, DROP_RESTRICT, 0);
@@ -1497,7 +1553,7 @@ typedef struct Watermark
 } Watermark;
 
 /* Globally cache the watermark for better performance (by avoiding repeated
- * max bucket calculations). The watermark will be reset at the end of the
+ * catalog lookups). The watermark will be reset at the end of the
  * transaction, when the watermark function's input argument (materialized
  * hypertable ID) changes, or when a new command is executed. One could
  * potentially create a hashtable of watermarks keyed on materialized
@@ -1530,24 +1586,18 @@ watermark_valid(const Watermark *w, int32 hyper_id)
 	return w != NULL && w->hyper_id == hyper_id && w->cid == GetCurrentCommandId(false);
 }
 
-static Watermark *
-watermark_create(const ContinuousAgg *cagg, MemoryContext top_mctx)
+/*
+ * Compute the watermark from the materialized data, which is the end of the
+ * last (highest) bucket in the materialized hypertable.
+ */
+static int64
+cagg_watermark_compute(const ContinuousAgg *cagg)
 {
 	Hypertable *ht;
 	const Dimension *dim;
 	Datum maxdat;
 	bool max_isnull;
 	Oid timetype;
-	Watermark *w;
-	MemoryContext mctx =
-		AllocSetContextCreate(top_mctx, "Watermark function", ALLOCSET_DEFAULT_SIZES);
-
-	w = MemoryContextAllocZero(mctx, sizeof(Watermark));
-	w->mctx = mctx;
-	w->hyper_id = cagg->data.mat_hypertable_id;
-	w->cid = GetCurrentCommandId(false);
-	w->cb.func = reset_watermark;
-	MemoryContextRegisterResetCallback(mctx, &w->cb);
 
 	ht = ts_hypertable_get_by_id(cagg->data.mat_hypertable_id);
 	Assert(NULL != ht);
@@ -1569,21 +1619,132 @@ watermark_create(const ContinuousAgg *cagg, MemoryContext top_mctx)
 			 * be added to ts_compute_beginning_of_the_next_bucket_variable() as
 			 * an optimization, if necessary.
 			 */
-			w->value =
-				ts_compute_beginning_of_the_next_bucket_variable(value, cagg->bucket_function);
+			return ts_compute_beginning_of_the_next_bucket_variable(value, cagg->bucket_function);
 		}
-		else
+
+		return ts_time_saturating_add(value, ts_continuous_agg_bucket_width(cagg), timetype);
+	}
+
+	/* Nothing materialized, so return min */
+	return ts_time_get_min(timetype);
+}
+
+/*
+ * Read the watermark stored by the last refresh of the continuous aggregate.
+ *
+ * Returns false if there is no stored watermark, which is the case for
+ * continuous aggregates that were not refreshed since they were created or
+ * since the extension was updated.
+ */
+static bool
+cagg_watermark_get(int32 mat_hypertable_id, int64 *value)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(CONTINUOUS_AGGS_WATERMARK, AccessShareLock, CurrentMemoryContext);
+	bool found = false;
+
+	init_watermark_scan_by_mat_hypertable_id(&iterator, mat_hypertable_id);
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool isnull;
+		Datum datum = slot_getattr(ti->slot, Anum_continuous_aggs_watermark_watermark, &isnull);
+
+		Assert(!isnull);
+		*value = DatumGetInt64(datum);
+		found = true;
+	}
+	ts_scan_iterator_close(&iterator);
+
+	return found;
+}
+
+/*
+ * Recompute the watermark of the continuous aggregate and store it in the
+ * catalog. Must be called whenever the materialized data changes, i.e., after
+ * a refresh or after dropping chunks of the materialized hypertable.
+ *
+ * The scheduled refresh windows of a continuous aggregate can run
+ * concurrently, so the writers are serialized by a self-conflicting lock on
+ * the catalog table that doesn't block the readers. A writer that doesn't see
+ * the data of a concurrent one can only store a lower watermark, which is
+ * still correct for real-time aggregation since the buckets above it are
+ * computed from the raw hypertable.
+ */
+TSDLLEXPORT void
+ts_cagg_watermark_update(const ContinuousAgg *cagg)
+{
+	int32 mat_hypertable_id = cagg->data.mat_hypertable_id;
+	Catalog *catalog = ts_catalog_get();
+	Relation rel =
+		table_open(catalog_get_table_id(catalog, CONTINUOUS_AGGS_WATERMARK), ShareRowExclusiveLock);
+	int64 value = cagg_watermark_compute(cagg);
+	ScanIterator iterator =
+		ts_scan_iterator_create(CONTINUOUS_AGGS_WATERMARK, RowExclusiveLock, CurrentMemoryContext);
+	bool found = false;
+
+	init_watermark_scan_by_mat_hypertable_id(&iterator, mat_hypertable_id);
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool should_free;
+		HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+		HeapTuple new_tuple = heap_copytuple(tuple);
+		Form_continuous_aggs_watermark form =
+			(Form_continuous_aggs_watermark) GETSTRUCT(new_tuple);
+
+		if (form->watermark != value)
 		{
-			w->value =
-				ts_time_saturating_add(value, ts_continuous_agg_bucket_width(cagg), timetype);
+			form->watermark = value;
+			ts_catalog_update(ti->scanrel, new_tuple);
 		}
+
+		heap_freetuple(new_tuple);
+		if (should_free)
+			heap_freetuple(tuple);
+		found = true;
 	}
-	else
+
+	if (!found)
 	{
-		/* Nothing materialized, so return min */
-		w->value = ts_time_get_min(timetype);
+		Datum values[Natts_continuous_aggs_watermark];
+		bool nulls[Natts_continuous_aggs_watermark] = { false };
+
+		values[AttrNumberGetAttrOffset(Anum_continuous_aggs_watermark_mat_hypertable_id)] =
+			Int32GetDatum(mat_hypertable_id);
+		values[AttrNumberGetAttrOffset(Anum_continuous_aggs_watermark_watermark)] =
+			Int64GetDatum(value);
+
+		ts_catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
 	}
 
+	/* Keep the lock until the end of the transaction */
+	table_close(rel, NoLock);
+
+	/* The cached watermark of the current command is outdated */
+	if (watermark != NULL && watermark->hyper_id == mat_hypertable_id)
+		MemoryContextDelete(watermark->mctx);
+}
+
+static Watermark *
+watermark_create(const ContinuousAgg *cagg, MemoryContext top_mctx)
+{
+	Watermark *w;
+	MemoryContext mctx =
+		AllocSetContextCreate(top_mctx, "Watermark function", ALLOCSET_DEFAULT_SIZES);
+
+	w = MemoryContextAllocZero(mctx, sizeof(Watermark));
+	w->mctx = mctx;
+	w->hyper_id = cagg->data.mat_hypertable_id;
+	w->cid = GetCurrentCommandId(false);
+	w->cb.func = reset_watermark;
+	MemoryContextRegisterResetCallback(mctx, &w->cb);
+
+	if (!cagg_watermark_get(w->hyper_id, &w->value))
+		w->value = cagg_watermark_compute(cagg);
+
 	return w;
 }
 
@@ -164,6 +164,7 @@ typedef struct CaggPolicyOffset
 } CaggPolicyOffset;
 
 extern TSDLLEXPORT Oid ts_cagg_permissions_check(Oid cagg_oid, Oid userid);
+extern TSDLLEXPORT void ts_cagg_watermark_update(const ContinuousAgg *cagg);
 
 extern TSDLLEXPORT CaggsInfo ts_continuous_agg_get_all_caggs_info(int32 raw_hypertable_id);
 extern TSDLLEXPORT void ts_populate_caggs_info_from_arrays(ArrayType *mat_hypertable_ids,
@@ -5,22 +5,29 @@
  */
 #include <postgres.h>
 #include <access/heapam.h>
+#include <access/tableam.h>
 #include <access/xact.h>
 #include <catalog/catalog.h>
 #include <commands/tablecmds.h>
+#include <executor/tuptable.h>
+#include <miscadmin.h>
 #include <nodes/parsenodes.h>
 #include <utils/array.h>
+#include <utils/lsyscache.h>
 #include <utils/palloc.h>
 #include <utils/rel.h>
 #include <utils/builtins.h>
 #include <utils/snapmgr.h>
 
 #include "ts_catalog/catalog.h"
+#include "chunk.h"
 #include "dimension.h"
 #include "dimension_slice.h"
 #include "dimension_partition.h"
 #include "hypertable_cache.h"
+#include "partitioning.h"
 #include "scanner.h"
+#include "utils.h"
 #include "config.h"
 
 #include "compat/compat.h"
@@ -318,19 +325,15 @@ ts_dimension_partition_info_delete(int dimension_id)
 }
 
 /*
- * Recreate dimension partitions based on changes to one or more of these
- * variables:
- *
- * - number of partitions
- * - list of data nodes
- * - replication factor
+ * Create dimension partitions starting at the given range starts, replacing
+ * the existing partitions of the dimension. The range starts must be sorted
+ * and the first one must be DIMENSION_SLICE_MINVALUE.
  */
-DimensionPartitionInfo *
-ts_dimension_partition_info_recreate(int32 dimension_id, unsigned int num_partitions,
-									 List *data_nodes, int replication_factor)
+static DimensionPartitionInfo *
+dimension_partition_info_create(int32 dimension_id, const int64 *range_starts,
+								unsigned int num_partitions, List *data_nodes,
+								int replication_factor)
 {
-	int64 partition_size = DIMENSION_SLICE_CLOSED_MAX / ((int64) num_partitions);
-	int64 range_start = DIMENSION_SLICE_MINVALUE;
 	Catalog *catalog = ts_catalog_get();
 	Oid relid = catalog_get_table_id(catalog, DIMENSION_PARTITION);
 	DimensionPartitionInfo *dpi;
@@ -339,6 +342,7 @@ ts_dimension_partition_info_recreate(int32 dimension_id, unsigned int num_partit
 	unsigned int i;
 
 	Assert(num_partitions > 0);
+	Assert(range_starts[0] == DIMENSION_SLICE_MINVALUE);
 	Assert(data_nodes == NIL || replication_factor > 0);
 
 	/* Delete all partitions for the dimension */
@@ -352,7 +356,7 @@ ts_dimension_partition_info_recreate(int32 dimension_id, unsigned int num_partit
 	for (i = 0; i < num_partitions; i++)
 	{
 		int64 range_end =
-			(i == (num_partitions - 1)) ? DIMENSION_SLICE_CLOSED_MAX : range_start + partition_size;
+			(i == (num_partitions - 1)) ? DIMENSION_SLICE_CLOSED_MAX : range_starts[i + 1];
 		DimensionPartition *dp;
 		CatalogSecurityContext sec_ctx;
 		HeapTuple tuple;
@@ -360,7 +364,7 @@ ts_dimension_partition_info_recreate(int32 dimension_id, unsigned int num_partit
 		dp = palloc0(sizeof(DimensionPartition));
 		*dp = (DimensionPartition){
 			.dimension_id = dimension_id,
-			.range_start = range_start,
+			.range_start = range_starts[i],
 			.range_end = range_end,
 			.data_nodes = get_replica_nodes(data_nodes, i, replication_factor),
 		};
@@ -372,14 +376,6 @@ ts_dimension_partition_info_recreate(int32 dimension_id, unsigned int num_partit
 		heap_freetuple(tuple);
 
 		partitions[i] = dp;
-
-		/* Hash values for space partitions are in range 0 to INT32_MAX, so
-		 * the first partition covers 0 to partition size (although the start
-		 * is written as -INF) */
-		if (range_start == DIMENSION_SLICE_MINVALUE)
-			range_start = 0;
-
-		range_start += partition_size;
 	}
 
 	table_close(rel, RowExclusiveLock);
@@ -397,6 +393,39 @@ ts_dimension_partition_info_recreate(int32 dimension_id, unsigned int num_partit
 	return dpi;
 }
 
+/*
+ * Recreate dimension partitions based on changes to one or more of these
+ * variables:
+ *
+ * - number of partitions
+ * - list of data nodes
+ * - replication factor
+ */
+DimensionPartitionInfo *
+ts_dimension_partition_info_recreate(int32 dimension_id, unsigned int num_partitions,
+									 List *data_nodes, int replication_factor)
+{
+	int64 partition_size = DIMENSION_SLICE_CLOSED_MAX / ((int64) num_partitions);
+	int64 *range_starts = palloc(sizeof(int64) * num_partitions);
+	unsigned int i;
+
+	Assert(num_partitions > 0);
+
+	/* Hash values for space partitions are in range 0 to INT32_MAX, so
+	 * the first partition covers 0 to partition size (although the start
+	 * is written as -INF) */
+	range_starts[0] = DIMENSION_SLICE_MINVALUE;
+
+	for (i = 1; i < num_partitions; i++)
+		range_starts[i] = partition_size * i;
+
+	return dimension_partition_info_create(dimension_id,
+										   range_starts,
+										   num_partitions,
+										   data_nodes,
+										   replication_factor);
+}
+
 /*
  * Manually update the dimension partition state for a hypertable.
  *
@@ -416,3 +445,199 @@ ts_dimension_partition_update(PG_FUNCTION_ARGS)
 	ts_cache_release(hcache);
 	PG_RETURN_VOID();
 }
+
+/*
+ * Add up the sizes of the rows of the uncompressed chunks in the latest time
+ * slice of the hypertable per virtual partition. Returns the number of rows.
+ */
+static int64
+dimension_partition_observe_sizes(const Hypertable *ht, const Dimension *dim, uint64 *sizes,
+								  int num_virtual)
+{
+	int64 virtual_size = DIMENSION_SLICE_CLOSED_MAX / num_virtual;
+	List *chunk_ids = ts_chunk_get_chunk_ids_by_hypertable_id(ht->fd.id);
+	List *chunks = NIL;
+	int64 latest_start = PG_INT64_MIN;
+	int64 nrows = 0;
+	ListCell *lc;
+
+	foreach (lc, chunk_ids)
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+
+		if (chunk == NULL || chunk->fd.dropped || chunk->fd.osm_chunk ||
+			chunk->relkind != RELKIND_RELATION)
+			continue;
+
+		if (ts_chunk_primary_dimension_start(chunk) > latest_start)
+		{
+			latest_start = ts_chunk_primary_dimension_start(chunk);
+			list_free(chunks);
+			chunks = NIL;
+		}
+
+		if (ts_chunk_primary_dimension_start(chunk) == latest_start)
+			chunks = lappend(chunks, chunk);
+	}
+
+	foreach (lc, chunks)
+	{
+		Chunk *chunk = lfirst(lc);
+		Relation rel = table_open(chunk->table_id, AccessShareLock);
+		AttrNumber attno = get_attnum(chunk->table_id, NameStr(dim->fd.column_name));
+		Oid collation = TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(attno))
+							->attcollation;
+		TupleTableSlot *slot = table_slot_create(rel, NULL);
+		Snapshot snapshot = RegisterSnapshot(GetTransactionSnapshot());
+		TableScanDesc scan = table_beginscan(rel, snapshot, 0, NULL);
+
+		while (table_scan_getnextslot(scan, ForwardScanDirection, slot))
+		{
+			bool should_free;
+			bool isnull;
+			HeapTuple tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+			Datum value = slot_getattr(slot, attno, &isnull);
+			int64 coord = 0;
+
+			/* NULL values are in the first partition, like on insert */
+			if (!isnull)
+				coord = (int64) DatumGetInt32(
+					ts_partitioning_func_apply(dim->partitioning, collation, value));
+
+			sizes[Min(coord / virtual_size, num_virtual - 1)] += tuple->t_len;
+			nrows++;
+
+			if (should_free)
+				heap_freetuple(tuple);
+		}
+
+		table_endscan(scan);
+		UnregisterSnapshot(snapshot);
+		ExecDropSingleTupleTableSlot(slot);
+		table_close(rel, NoLock);
+	}
+
+	return nrows;
+}
+
+/*
+ * Calculate the range starts of the partitions so that every partition gets
+ * about the same share of the total size, without splitting virtual
+ * partitions. Every partition gets at least one virtual partition.
+ */
+static void
+dimension_partition_balance(const uint64 *sizes, int num_virtual, int64 *range_starts,
+							int num_partitions)
+{
+	int64 virtual_size = DIMENSION_SLICE_CLOSED_MAX / num_virtual;
+	uint64 *cumulative = palloc(sizeof(uint64) * (num_virtual + 1));
+	int boundary = 0;
+	int i;
+
+	cumulative[0] = 0;
+	for (i = 0; i < num_virtual; i++)
+		cumulative[i + 1] = cumulative[i] + sizes[i];
+
+	range_starts[0] = DIMENSION_SLICE_MINVALUE;
+
+	for (i = 1; i < num_partitions; i++)
+	{
+		double target = (double) cumulative[num_virtual] * i / num_partitions;
+		int min_boundary = boundary + 1;
+		int max_boundary = num_virtual - (num_partitions - i);
+
+		/* The first boundary where the size reaches the target, or the one before */
+		boundary = min_boundary;
+		while (boundary < max_boundary && cumulative[boundary] < target)
+			boundary++;
+
+		if (boundary > min_boundary &&
+			target - cumulative[boundary - 1] < cumulative[boundary] - target)
+			boundary--;
+
+		range_starts[i] = virtual_size * boundary;
+	}
+
+	pfree(cumulative);
+}
+
+TS_FUNCTION_INFO_V1(ts_dimension_partition_balance);
+
+/*
+ * Balance the partitions of the first space dimension of a hypertable by the
+ * observed sizes of its partitions.
+ *
+ * The hash values are divided into equally sized virtual partitions, which
+ * are mapped onto the partitions of the dimension as contiguous ranges, so
+ * that all partitions get about the same amount of data of the latest time
+ * slice. A heavy tenant then gets a partition (of the new chunks) of its own
+ * instead of sharing an equally sized hash range with other tenants. The
+ * number of partitions and the hash function are not changed, and
+ * rebalance_chunks() can apply the partitioning to existing chunks.
+ *
+ * Setting the number of partitions recreates equally sized partitions.
+ *
+ * hypertable - The hypertable
+ * virtual_partitions - The number of virtual partitions
+ *
+ * Returns the number of observed rows. Without rows, the partitions are
+ * equally sized.
+ */
+Datum
+ts_dimension_partition_balance(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	int32 num_virtual = PG_ARGISNULL(1) ? 0 : PG_GETARG_INT32(1);
+	const Dimension *dim;
+	uint64 *sizes;
+	int64 *range_starts;
+	int64 nrows;
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("hypertable cannot be NULL")));
+
+	ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+	ts_hypertable_permissions_check(relid, GetUserId());
+
+	dim = hyperspace_get_closed_dimension(ht->space, 0);
+	if (dim == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("hypertable \"%s\" has no space dimension", get_rel_name(relid))));
+
+	if (num_virtual < dim->fd.num_slices)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of virtual partitions: must be at least %d",
+						dim->fd.num_slices)));
+
+	/* The chunks of a distributed hypertable have no local data */
+	if (hypertable_is_distributed(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("balancing partitions is not supported on distributed hypertables")));
+
+	/* The slices of new chunks change, so wait for concurrent chunk creators */
+	ts_chunk_creation_lock(ht->fd.id, ExclusiveLock);
+
+	sizes = palloc0(sizeof(uint64) * num_virtual);
+	range_starts = palloc(sizeof(int64) * dim->fd.num_slices);
+	nrows = dimension_partition_observe_sizes(ht, dim, sizes, num_virtual);
+
+	if (nrows > 0)
+	{
+		dimension_partition_balance(sizes, num_virtual, range_starts, dim->fd.num_slices);
+		dimension_partition_info_create(dim->fd.id, range_starts, dim->fd.num_slices, NIL, 0);
+	}
+	else
+		ts_dimension_partition_info_recreate(dim->fd.id, dim->fd.num_slices, NIL, 0);
+
+	ts_cache_release(hcache);
+
+	PG_RETURN_INT64(nrows);
+}
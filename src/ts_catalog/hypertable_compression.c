@@ -267,3 +267,49 @@ ts_hypertable_compression_rename_column(int32 htid, char *old_column_name, char
 	if (found == false)
 		elog(ERROR, "column %s not found in hypertable_compression catalog table", old_column_name);
 }
+
+TSDLLEXPORT void
+ts_hypertable_compression_set_algorithm(int32 htid, const char *attname, int16 algo_id)
+{
+	bool found = false;
+	ScanIterator iterator =
+		ts_scan_iterator_create(HYPERTABLE_COMPRESSION, RowExclusiveLock, CurrentMemoryContext);
+	iterator.ctx.index =
+		catalog_get_index(ts_catalog_get(), HYPERTABLE_COMPRESSION, HYPERTABLE_COMPRESSION_PKEY);
+	ts_scan_iterator_scan_key_init(&iterator,
+								   Anum_hypertable_compression_pkey_hypertable_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(htid));
+	ts_scan_iterator_scan_key_init(&iterator,
+								   Anum_hypertable_compression_pkey_attname,
+								   BTEqualStrategyNumber,
+								   F_NAMEEQ,
+								   CStringGetDatum(attname));
+
+	ts_scanner_foreach(&iterator)
+	{
+		Datum values[Natts_hypertable_compression];
+		bool isnulls[Natts_hypertable_compression];
+		bool doReplace[Natts_hypertable_compression] = { false };
+		bool should_free;
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		TupleDesc tupdesc = ts_scanner_get_tupledesc(ti);
+		HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+		HeapTuple new_tuple;
+
+		found = true;
+		heap_deform_tuple(tuple, tupdesc, values, isnulls);
+		values[AttrNumberGetAttrOffset(Anum_hypertable_compression_algo_id)] =
+			Int16GetDatum(algo_id);
+		doReplace[AttrNumberGetAttrOffset(Anum_hypertable_compression_algo_id)] = true;
+		new_tuple = heap_modify_tuple(tuple, tupdesc, values, isnulls, doReplace);
+		ts_catalog_update(ti->scanrel, new_tuple);
+
+		heap_freetuple(new_tuple);
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	if (!found)
+		elog(ERROR, "column %s not found in hypertable_compression catalog table", attname);
+}
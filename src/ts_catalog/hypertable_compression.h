@@ -22,5 +22,7 @@ extern TSDLLEXPORT bool ts_hypertable_compression_delete_by_hypertable_id(int32
 extern TSDLLEXPORT bool ts_hypertable_compression_delete_by_pkey(int32 htid, const char *attname);
 extern TSDLLEXPORT void ts_hypertable_compression_rename_column(int32 htid, char *old_column_name,
 																char *new_column_name);
+extern TSDLLEXPORT void ts_hypertable_compression_set_algorithm(int32 htid, const char *attname,
+																int16 algo_id);
 
 #endif
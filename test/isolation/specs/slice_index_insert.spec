@@ -0,0 +1,30 @@
+# This file and its contents are licensed under the Apache License 2.0.
+# Please see the included NOTICE for copyright information and
+# LICENSE-APACHE for a copy of the license.
+
+setup {
+  CREATE TABLE slice_index(time timestamptz, device int, temp float);
+  SELECT create_hypertable('slice_index', 'time', 'device', 2);
+  INSERT INTO slice_index VALUES ('2020-01-03 10:30', 1, 1.0);
+}
+
+teardown {
+  DROP TABLE slice_index;
+}
+
+# Test that chunk exclusion sees the chunks created by a concurrent
+# insert. The first queries build the dimension slice index of the
+# session, which has to be invalidated when the insert adds new
+# slices, also in an open transaction that already holds the locks
+# on the hypertable.
+
+session "s1"
+setup	{ BEGIN; SET TRANSACTION ISOLATION LEVEL READ COMMITTED; }
+step "s1_query_time"	{ SELECT * FROM slice_index WHERE time >= '2020-01-01' ORDER BY 1; }
+step "s1_query_device"	{ SELECT * FROM slice_index WHERE device = 2 ORDER BY 1; }
+step "s1_commit"	{ COMMIT; }
+
+session "s2"
+step "s2_insert"	{ INSERT INTO slice_index VALUES ('2020-06-01 10:30', 2, 2.0); }
+
+permutation "s1_query_time" "s1_query_device" "s2_insert" "s1_query_time" "s1_query_device" "s1_commit"
@@ -0,0 +1,31 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test inserting at the end of the chunks without using the free space map
+CREATE TABLE ao(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('ao', 'time', chunk_time_interval => 100000);
+
+-- leave free space at the start of the chunk
+INSERT INTO ao SELECT t, t % 4, t * 0.5 FROM generate_series(1, 2000) t;
+SELECT ch AS "CHUNK" FROM show_chunks('ao') ch \gset
+DELETE FROM ao WHERE time <= 1000;
+VACUUM ao;
+SELECT max((ctid::text::point)[0])::int AS last_block FROM :CHUNK \gset
+
+-- reconnect so that the chunk has no cached target block
+\c :TEST_DBNAME
+SET timescaledb.enable_append_only_inserts TO on;
+INSERT INTO ao VALUES (2001, 1, 1000.5);
+INSERT INTO ao SELECT t, t % 4, t * 0.5 FROM generate_series(2002, 2100) t;
+SELECT count(*), min((ctid::text::point)[0]) >= :last_block AS appended
+FROM :CHUNK WHERE time > 2000;
+
+-- without append-only inserts the row goes to the free space
+\c :TEST_DBNAME
+SET timescaledb.enable_append_only_inserts TO off;
+INSERT INTO ao VALUES (2101, 1, 1050.5);
+SELECT (ctid::text::point)[0] < :last_block AS reused FROM :CHUNK WHERE time = 2101;
+
+SELECT count(*), sum(time), sum(value) FROM ao;
+DROP TABLE ao;
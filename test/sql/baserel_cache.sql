@@ -25,3 +25,17 @@ CREATE FUNCTION KNOWN_ID(UUID, TEXT) RETURNS UUID AS $$
 $$ LANGUAGE SQL;
 
 SELECT KNOWN_ID(NULL, ''), KNOWN_ID(NULL, '');
+
+-- A table that was planned as a plain table is planned as a hypertable
+-- after it is turned into one
+CREATE TABLE plain_then_ht(time int NOT NULL, value int);
+INSERT INTO plain_then_ht VALUES (1, 1), (11, 2);
+SELECT count(*) FROM plain_then_ht WHERE time < 5;
+SELECT table_name FROM create_hypertable('plain_then_ht', 'time', chunk_time_interval => 10,
+    migrate_data => true);
+SET enable_indexscan TO off;
+SET enable_bitmapscan TO off;
+EXPLAIN (costs off) SELECT * FROM plain_then_ht WHERE time < 5;
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DROP TABLE plain_then_ht;
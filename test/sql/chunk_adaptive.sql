@@ -285,6 +285,31 @@ SELECT create_hypertable('test_adaptive_after_multiple_dims', 'time',
                          create_default_indexes => true);
 INSERT INTO test_adaptive_after_multiple_dims VALUES('2018-01-01T00:00:00+00'::timestamptz, 0.0, 5);
 
+-- Same data as test_adaptive, but with the min and max values of chunks
+-- tracked from the inserts instead of scanning the chunks. This should
+-- result in the same chunks.
+SET timescaledb.enable_adaptive_chunking_insert_stats TO on;
+CREATE TABLE test_adaptive_insert_stats(time timestamptz, temp float, location int);
+SELECT table_name FROM create_hypertable('test_adaptive_insert_stats', 'time',
+                         chunk_target_size => '1MB',
+                         create_default_indexes => true);
+INSERT INTO test_adaptive_insert_stats
+SELECT time, random() * 35, _timescaledb_internal.get_partition_hash(time) FROM
+generate_series('2017-03-07T18:18:03+00'::timestamptz - interval '175 days',
+                '2017-03-07T18:18:03+00'::timestamptz,
+                '2 minutes') as time;
+SELECT count(*) AS differing_chunks FROM (
+  (SELECT range_start, range_end FROM timescaledb_information.chunks WHERE hypertable_name = 'test_adaptive'
+   EXCEPT
+   SELECT range_start, range_end FROM timescaledb_information.chunks WHERE hypertable_name = 'test_adaptive_insert_stats')
+  UNION ALL
+  (SELECT range_start, range_end FROM timescaledb_information.chunks WHERE hypertable_name = 'test_adaptive_insert_stats'
+   EXCEPT
+   SELECT range_start, range_end FROM timescaledb_information.chunks WHERE hypertable_name = 'test_adaptive')
+) d;
+RESET timescaledb.enable_adaptive_chunking_insert_stats;
+DROP TABLE test_adaptive_insert_stats;
+
 \c  :TEST_DBNAME :ROLE_DEFAULT_PERM_USER_2
 \set ON_ERROR_STOP 0
 SELECT * FROM set_adaptive_chunking('test_adaptive', '2MB');
@@ -0,0 +1,33 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+create table space(time timestamptz not null, device int, value float);
+select table_name from create_hypertable('space', 'time', 'device', 4,
+    chunk_time_interval => interval '1 day');
+insert into space select t + d * interval '1 second', d, d
+from generate_series('2022-01-01 00:00'::timestamptz, '2022-01-03 23:00', '1 hour') t,
+    generate_series(1, 8) d;
+analyze space;
+
+set timescaledb.enable_chunk_append_merge to on;
+
+-- the space partitions of a time slice are merged by ChunkAppend
+select test.plan_contains('select * from space order by time limit 5', '%Merged time slices%'),
+    test.plan_contains('select * from space order by time limit 5', '%Merge Append%');
+
+select time, device from space order by time limit 5;
+select time, device from space order by time desc limit 3;
+select time, device from space where time > '2022-01-02 12:00' order by time limit 3;
+
+-- the whole output is ordered
+select count(*) from (
+    select time < lag(time) over () as out_of_order
+    from (select time from space order by time) s
+) o where out_of_order;
+
+reset timescaledb.enable_chunk_append_merge;
+select test.plan_contains('select * from space order by time limit 5', '%Merged time slices%'),
+    test.plan_contains('select * from space order by time limit 5', '%Merge Append%');
+
+drop table space;
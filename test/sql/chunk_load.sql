@@ -0,0 +1,68 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- The chunks of a query are loaded in batches, so test that the constraints
+-- end up with the right chunks when the chunk IDs have gaps
+create table cl(time timestamptz not null, device int, value float);
+select table_name from create_hypertable('cl', 'time', 'device', 3,
+    chunk_time_interval => interval '1 day');
+insert into cl select t, d, d
+from generate_series('2020-01-01 00:00'::timestamptz, '2020-01-10 23:00', '1 hour') t,
+    generate_series(1, 6) d;
+
+-- drop the chunks of a time slice in the middle
+select count(*) > 0 as dropped
+from drop_chunks('cl', older_than => '2020-01-06 00:00'::timestamptz,
+    newer_than => '2020-01-04 00:00'::timestamptz);
+analyze cl;
+
+select count(*), sum(value) from cl;
+
+-- startup exclusion uses the constraints of every chunk
+select test.plan_contains('select device, count(*) from cl
+    where time >= ''2020-01-03 00:00''::text::timestamptz
+    and time < ''2020-01-07 00:00''::text::timestamptz group by device',
+    '%Chunks excluded during startup%');
+select device, count(*) from cl
+where time >= '2020-01-03 00:00'::text::timestamptz
+and time < '2020-01-07 00:00'::text::timestamptz
+group by device order by device;
+select count(*) from cl
+where device = 4 and time >= '2020-01-09 00:00'::text::timestamptz;
+
+-- ordered append orders the chunks by their time slices
+select time, count(*) from cl
+where time between '2020-01-04 14:00' and '2020-01-05 17:00'
+group by time order by time;
+select time, device from cl where time > '2020-01-04 15:00' order by time, device limit 4;
+select time, device from cl order by time desc, device limit 2;
+
+drop table cl;
+
+-- the chunks of a time slice share the time slice, and the chunks of a
+-- space partition share its slice, when they are loaded
+create table cl2(time timestamptz not null, device int, sensor int, value float);
+select table_name from create_hypertable('cl2', 'time', 'device', 2,
+    chunk_time_interval => interval '1 day');
+select column_name from add_dimension('cl2', 'sensor', number_partitions => 2);
+insert into cl2 select t, d, s, d * 10 + s
+from generate_series('2020-01-01 00:00'::timestamptz, '2020-01-03 23:00', '1 hour') t,
+    generate_series(1, 4) d, generate_series(1, 2) s;
+analyze cl2;
+
+select count(*), sum(value) from cl2;
+select count(*), sum(value) from cl2 where device = 2 and sensor = 1;
+select date_trunc('day', time) as day, count(*) from cl2
+where device in (1, 3) and time >= '2020-01-01 12:00'::text::timestamptz
+group by day order by day;
+
+set timescaledb.enable_chunk_append_merge to on;
+select time, device, sensor from cl2 order by time desc, device desc, sensor desc limit 1;
+select count(*) from (
+    select time < lag(time) over () as out_of_order
+    from (select time from cl2 order by time) s
+) o where out_of_order;
+reset timescaledb.enable_chunk_append_merge;
+
+drop table cl2;
@@ -0,0 +1,62 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test chunk-wise joins of hypertables with the same time partitioning
+SET max_parallel_workers_per_gather TO 0;
+CREATE TABLE metrics(time int NOT NULL, device int, val int);
+CREATE TABLE metrics_meta(time int NOT NULL, device int, note text);
+CREATE TABLE metrics_wide(time int NOT NULL, device int, val int);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => 10);
+SELECT table_name FROM create_hypertable('metrics_meta', 'time', chunk_time_interval => 10);
+SELECT table_name FROM create_hypertable('metrics_wide', 'time', chunk_time_interval => 20);
+INSERT INTO metrics SELECT t, t % 3, t FROM generate_series(0, 49) t;
+INSERT INTO metrics_meta SELECT t, t % 3, 'note ' || t FROM generate_series(0, 49) t;
+INSERT INTO metrics_wide SELECT t, t % 3, t FROM generate_series(0, 49) t;
+ANALYZE metrics, metrics_meta, metrics_wide;
+
+-- the join is chunk-wise if an Append sits above the first join
+CREATE FUNCTION join_is_chunkwise(query text) RETURNS bool
+LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+    seen_append bool := false;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (costs off) ' || query LOOP
+        IF line LIKE '%Join%' OR line LIKE '%Nested Loop%' THEN
+            RETURN seen_append;
+        END IF;
+        seen_append := seen_append OR line LIKE '%Append%';
+    END LOOP;
+    RETURN false;
+END
+$$;
+
+SET enable_partitionwise_join TO true;
+SELECT join_is_chunkwise('SELECT * FROM metrics m JOIN metrics_meta mm ON m.time = mm.time');
+SET timescaledb.enable_chunkwise_join TO true;
+SELECT join_is_chunkwise('SELECT * FROM metrics m JOIN metrics_meta mm ON m.time = mm.time'),
+    join_is_chunkwise('SELECT * FROM metrics m JOIN metrics_meta mm ON m.time = mm.time AND m.device = mm.device'),
+    join_is_chunkwise('SELECT * FROM metrics m JOIN metrics_meta mm ON m.time = mm.time WHERE m.time < 30');
+
+-- joins that are not on the time column or need the partition bounds at
+-- execution time are planned as before
+SELECT join_is_chunkwise('SELECT * FROM metrics m JOIN metrics_meta mm ON m.device = mm.device'),
+    join_is_chunkwise('SELECT * FROM metrics m JOIN metrics_meta mm ON m.time = mm.time WHERE m.time < length(version())');
+
+-- chunks of different sizes can't be joined one by one
+SELECT join_is_chunkwise('SELECT * FROM metrics m JOIN metrics_wide mw ON m.time = mw.time');
+
+-- the results are the same as with a single join
+SELECT count(*), sum(m.val), count(DISTINCT mm.note)
+FROM metrics m JOIN metrics_meta mm ON m.time = mm.time AND m.device = mm.device;
+RESET timescaledb.enable_chunkwise_join;
+SELECT count(*), sum(m.val), count(DISTINCT mm.note)
+FROM metrics m JOIN metrics_meta mm ON m.time = mm.time AND m.device = mm.device;
+
+RESET enable_partitionwise_join;
+RESET max_parallel_workers_per_gather;
+DROP FUNCTION join_is_chunkwise(text);
+DROP TABLE metrics;
+DROP TABLE metrics_meta;
+DROP TABLE metrics_wide;
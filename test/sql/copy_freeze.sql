@@ -0,0 +1,34 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test COPY FREEZE into the chunks created in the same transaction
+CREATE TABLE frz(time int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('frz', 'time', chunk_time_interval => 10);
+INSERT INTO frz VALUES (1, 1);
+
+-- the chunk that already exists is loaded as usual, the two new chunks are
+-- frozen and their pages are marked all-visible
+BEGIN;
+COPY frz FROM STDIN WITH (FREEZE);
+2	2
+15	15
+25	25
+\.
+COMMIT;
+ANALYZE frz;
+SELECT c.relname, c.relpages, c.relallvisible
+FROM show_chunks('frz') ch
+JOIN pg_class c ON c.oid = ch
+ORDER BY c.relname;
+
+-- like for plain tables, an open cursor prevents freezing
+BEGIN;
+DECLARE cur CURSOR FOR SELECT 1;
+COPY frz FROM STDIN WITH (FREEZE);
+35	35
+\.
+ROLLBACK;
+
+SELECT count(*), min(time), max(time) FROM frz;
+DROP TABLE frz;
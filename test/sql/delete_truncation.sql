@@ -0,0 +1,46 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test truncating the chunks a DELETE removes all rows from
+CREATE TABLE del(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('del', 'time', chunk_time_interval => 10);
+INSERT INTO del SELECT t, t % 3, t FROM generate_series(0, 49) t;
+SET timescaledb.enable_delete_truncation TO on;
+
+-- the two chunks below 25 are truncated and only the chunk with the
+-- boundary has its rows deleted
+EXPLAIN (costs off) DELETE FROM del WHERE time < 25;
+\set QUIET off
+DELETE FROM del WHERE time < 25;
+\set QUIET on
+SELECT count(*), min(time), max(time) FROM del;
+SELECT count(*) FROM show_chunks('del');
+
+-- the truncation is rolled back with the transaction
+BEGIN;
+DELETE FROM del WHERE time < 40;
+SELECT count(*) FROM del;
+ROLLBACK;
+SELECT count(*) FROM del;
+
+-- restrictions on other columns need the rows to be deleted one by one
+EXPLAIN (costs off) DELETE FROM del WHERE time >= 40 AND device = 1;
+
+-- as do row triggers
+CREATE FUNCTION del_trigger() RETURNS trigger LANGUAGE plpgsql AS
+$$ BEGIN RETURN OLD; END $$;
+CREATE TRIGGER del_trigger BEFORE DELETE ON del FOR EACH ROW EXECUTE FUNCTION del_trigger();
+EXPLAIN (costs off) DELETE FROM del WHERE time >= 40;
+DROP TRIGGER del_trigger ON del;
+
+-- without restrictions every chunk is truncated
+EXPLAIN (costs off) DELETE FROM del;
+\set QUIET off
+DELETE FROM del;
+\set QUIET on
+SELECT count(*) FROM del;
+
+RESET timescaledb.enable_delete_truncation;
+DROP TABLE del;
+DROP FUNCTION del_trigger();
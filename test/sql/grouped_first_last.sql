@@ -0,0 +1,38 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test planning grouped first() and last() as DISTINCT ON
+CREATE TABLE gfl(time int NOT NULL, device int NOT NULL, temp float8, note text);
+SELECT table_name FROM create_hypertable('gfl', 'time', chunk_time_interval => 100,
+    create_default_indexes => false);
+CREATE INDEX ON gfl(device, time DESC);
+INSERT INTO gfl SELECT t, t % 3, t * 0.5, 'n' || t FROM generate_series(1, 250) t;
+ANALYZE gfl;
+
+SELECT test.plan_contains('SELECT device, last(temp, time) FROM gfl GROUP BY device', '%Unique%');
+SET timescaledb.enable_grouped_first_last TO on;
+SELECT test.plan_contains('SELECT device, last(temp, time) FROM gfl GROUP BY device', '%Unique%');
+
+SELECT device, last(temp, time), max(time), last(note, time) FROM gfl GROUP BY device
+ORDER BY device;
+SELECT device, last(temp, time) FROM gfl WHERE temp < 100 GROUP BY device ORDER BY device;
+-- first() scans the index backward, so the devices come in descending order
+SELECT test.plan_contains('SELECT device, first(temp, time) FROM gfl GROUP BY device ORDER BY device DESC',
+    '%Unique%');
+SELECT device, first(temp, time), min(time) FROM gfl GROUP BY device ORDER BY device DESC;
+
+-- not rewritten
+SELECT test.plan_contains('SELECT device, first(temp, time) FROM gfl GROUP BY device ORDER BY device',
+    '%Unique%');
+SELECT test.plan_contains('SELECT device, first(temp, time), last(temp, time) FROM gfl GROUP BY device',
+    '%Unique%');
+SELECT test.plan_contains('SELECT device, last(temp, time), count(*) FROM gfl GROUP BY device',
+    '%Unique%');
+SELECT test.plan_contains('SELECT device + 1, last(temp, time) FROM gfl GROUP BY device + 1',
+    '%Unique%');
+SELECT test.plan_contains('SELECT note, last(temp, time) FROM gfl GROUP BY note', '%Unique%');
+SELECT device, first(temp, time), min(time) FROM gfl GROUP BY device ORDER BY device;
+
+RESET timescaledb.enable_grouped_first_last;
+DROP TABLE gfl;
@@ -0,0 +1,56 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+CREATE TABLE cache_a(time int NOT NULL, device int, value float);
+CREATE TABLE cache_b(time int NOT NULL, device int, value float);
+CREATE TABLE cache_c(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('cache_a', 'time', chunk_time_interval => 10);
+SELECT table_name FROM create_hypertable('cache_b', 'time', chunk_time_interval => 10);
+SELECT table_name FROM create_hypertable('cache_c', 'time', chunk_time_interval => 10);
+INSERT INTO cache_a SELECT t, t % 2, t FROM generate_series(0, 29) t;
+INSERT INTO cache_b SELECT t, t % 2, t FROM generate_series(0, 29) t;
+INSERT INTO cache_c SELECT t, t % 2, t FROM generate_series(0, 29) t;
+
+SELECT count(*) FROM cache_a;
+SELECT count(*) FROM cache_b;
+SELECT count(*) FROM cache_c;
+SELECT cache_name, entries >= 3 AS has_entries, memory_bytes > 0 AS has_memory,
+    hits > 0 AS has_hits, misses > 0 AS has_misses
+FROM _timescaledb_internal.cache_info()
+WHERE cache_name = 'hypertable_cache';
+
+-- the inserts look up the chunks in the chunk cache first, a new chunk is
+-- always a miss and the second insert into the same chunks always hits
+SELECT hits AS chunk_hits, misses AS chunk_misses
+FROM _timescaledb_internal.cache_info() WHERE cache_name = 'chunk_cache' \gset
+INSERT INTO cache_a VALUES (35, 1, 1);
+INSERT INTO cache_a VALUES (1, 1, 1), (11, 1, 1), (21, 1, 1);
+INSERT INTO cache_a VALUES (2, 1, 1), (12, 1, 1), (22, 1, 1);
+SELECT entries >= 3 AS has_entries, memory_bytes > 0 AS has_memory,
+    hits > :chunk_hits AS has_hits, misses > :chunk_misses AS has_misses
+FROM _timescaledb_internal.cache_info() WHERE cache_name = 'chunk_cache';
+
+-- with the memory limit, the least recently used hypertables are evicted
+SELECT evictions AS evictions FROM _timescaledb_internal.cache_info()
+WHERE cache_name = 'hypertable_cache' \gset
+SET timescaledb.max_hypertable_cache_memory TO '1kB';
+SELECT count(*) FROM cache_a;
+SELECT count(*) FROM cache_b;
+SELECT count(*) FROM cache_c;
+INSERT INTO cache_b VALUES (3, 1, 1), (13, 1, 1), (23, 1, 1);
+SELECT count(*) FROM cache_b;
+SELECT evictions > :evictions AS evicted FROM _timescaledb_internal.cache_info()
+WHERE cache_name = 'hypertable_cache';
+
+SET timescaledb.max_hypertable_cache_memory TO '64MB';
+SELECT count(*) FROM cache_a;
+SELECT count(*) FROM cache_b;
+SELECT count(*) FROM cache_c;
+SELECT entries >= 3 AS has_entries FROM _timescaledb_internal.cache_info()
+WHERE cache_name = 'hypertable_cache';
+
+RESET timescaledb.max_hypertable_cache_memory;
+DROP TABLE cache_a;
+DROP TABLE cache_b;
+DROP TABLE cache_c;
@@ -0,0 +1,44 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test building the statistics of a hypertable from the ones of its chunks
+CREATE TABLE stats(time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('stats', 'time', chunk_time_interval => 1000);
+INSERT INTO stats SELECT t, t % 4, CASE WHEN t % 10 = 0 THEN NULL ELSE t END
+FROM generate_series(0, 2999) t;
+
+CREATE VIEW stats_summary AS
+SELECT attname, inherited, null_frac, avg_width, n_distinct,
+    most_common_vals::text AS mcv, most_common_freqs AS mcf,
+    (histogram_bounds::text::int[])[1] AS first_bound,
+    (histogram_bounds::text::int[])[array_length(histogram_bounds::text::int[], 1)] AS last_bound,
+    array_length(histogram_bounds::text::int[], 1) AS bounds
+FROM pg_stats WHERE schemaname = 'public' AND tablename = 'stats';
+
+-- the chunks are analyzed and the statistics of the hypertable are merged
+-- from theirs, the hypertable itself is not sampled
+SET timescaledb.enable_merged_hypertable_stats TO on;
+ANALYZE stats;
+SELECT count(*) FROM show_chunks('stats') ch
+WHERE EXISTS (SELECT FROM pg_stats s
+    WHERE format('%I.%I', s.schemaname, s.tablename)::regclass = ch);
+SELECT * FROM stats_summary ORDER BY attname, inherited;
+
+-- the same as sampling the hypertable
+RESET timescaledb.enable_merged_hypertable_stats;
+ANALYZE stats;
+SELECT * FROM stats_summary ORDER BY attname, inherited;
+
+-- a new chunk, with a single device, is analyzed and merged
+INSERT INTO stats SELECT t, 0, t FROM generate_series(3000, 3999) t;
+SET timescaledb.enable_merged_hypertable_stats TO on;
+ANALYZE stats;
+SELECT * FROM stats_summary ORDER BY attname, inherited;
+
+-- only the given columns
+ANALYZE stats (device);
+RESET timescaledb.enable_merged_hypertable_stats;
+
+DROP VIEW stats_summary;
+DROP TABLE stats;
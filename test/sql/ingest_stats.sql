@@ -0,0 +1,42 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- The statistics are collected since timescaledb.ingest_stats_max_hypertables
+-- is set in the test configuration
+CREATE TABLE ingest(time timestamptz NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('ingest', 'time', chunk_time_interval => interval '1 day');
+
+SET timescaledb.max_open_chunks_per_insert = 2;
+-- rows in time order, one chunk insert state miss for every new chunk
+INSERT INTO ingest
+SELECT t, 1, 1.0 FROM generate_series('2023-01-01 00:00+00'::timestamptz,
+    '2023-01-04 23:00+00', '1 hour') t;
+SELECT hypertable_name, statements, rows, insert_state_hits, insert_state_misses,
+    insert_state_evictions, chunk_cache_hits + chunk_cache_misses AS chunk_lookups,
+    chunks_created, copy_flushes_end
+FROM timescaledb_information.hypertable_ingest_stats;
+
+-- rows out of order, every row evicts a chunk insert state
+INSERT INTO ingest VALUES ('2023-01-01 01:30+00', 2, 2.0), ('2023-01-02 01:30+00', 2, 2.0),
+    ('2023-01-03 01:30+00', 2, 2.0), ('2023-01-01 02:30+00', 2, 2.0);
+SELECT hypertable_name, statements, rows, insert_state_hits, insert_state_misses,
+    insert_state_evictions, chunk_cache_hits + chunk_cache_misses AS chunk_lookups,
+    chunks_created, copy_flushes_end
+FROM timescaledb_information.hypertable_ingest_stats;
+
+-- the multi-insert buffers of COPY are flushed at the end
+COPY ingest FROM STDIN DELIMITER ',';
+2023-01-05 00:00+00,3,3.0
+2023-01-05 01:00+00,3,3.0
+2023-01-05 02:00+00,3,3.0
+\.
+SELECT hypertable_name, statements, rows, insert_state_hits, insert_state_misses,
+    insert_state_evictions, chunk_cache_hits + chunk_cache_misses AS chunk_lookups,
+    chunks_created, copy_flushes_end
+FROM timescaledb_information.hypertable_ingest_stats;
+RESET timescaledb.max_open_chunks_per_insert;
+
+-- the statistics of dropped hypertables are not shown
+DROP TABLE ingest;
+SELECT count(*) FROM timescaledb_information.hypertable_ingest_stats;
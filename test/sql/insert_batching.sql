@@ -0,0 +1,44 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test batching the rows of INSERTs per chunk
+CREATE TABLE bi(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('bi', 'time', chunk_time_interval => 1000);
+SET timescaledb.enable_insert_batching TO on;
+
+INSERT INTO bi SELECT t, t % 4, t * 0.5 FROM generate_series(1, 5000) t;
+INSERT INTO bi VALUES (6001, 1, 1.5), (6002, 2, 2.5), (10, 1, 3.5);
+-- the rows alternate between the chunks
+INSERT INTO bi SELECT (t % 3) * 1000 + 500, 9, t FROM generate_series(1, 3000) t;
+
+SELECT tableoid::regclass, count(*), sum(value) FROM bi GROUP BY 1 ORDER BY 1;
+SELECT count(*), sum(time), sum(value) FROM bi;
+
+-- the index entries of the batched rows are inserted too
+SET enable_seqscan TO off;
+SET enable_bitmapscan TO off;
+SELECT count(*) FROM bi WHERE time = 500;
+SELECT count(*) FROM bi WHERE time = 1500;
+SELECT count(*) FROM bi WHERE time = 6002;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+-- the rows are inserted one by one with RETURNING
+INSERT INTO bi VALUES (7000, 1, 1) RETURNING *;
+
+-- the rows are inserted before the statement triggers run
+CREATE FUNCTION bi_count() RETURNS trigger LANGUAGE plpgsql AS
+$$
+BEGIN
+    RAISE NOTICE 'bi has % rows', (SELECT count(*) FROM bi);
+    RETURN NULL;
+END
+$$;
+CREATE TRIGGER bi_count AFTER INSERT ON bi FOR EACH STATEMENT EXECUTE FUNCTION bi_count();
+INSERT INTO bi SELECT 8000 + t, 0, 0 FROM generate_series(1, 10) t;
+DROP TRIGGER bi_count ON bi;
+
+RESET timescaledb.enable_insert_batching;
+DROP TABLE bi;
+DROP FUNCTION bi_count();
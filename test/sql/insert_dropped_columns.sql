@@ -0,0 +1,31 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- The chunks created after dropping a column don't have the dropped column,
+-- so the chunks of the hypertable have three different layouts. The tuple
+-- conversion maps are shared by the chunks with the same layout.
+create table lay(time int not null, a int, device int, b int, value float,
+    primary key (time, device));
+select table_name from create_hypertable('lay', 'time', chunk_time_interval => 10);
+insert into lay select t, t, 1, t, t from generate_series(0, 29) t;
+alter table lay drop column a;
+insert into lay select t, 1, t, t from generate_series(30, 59) t;
+alter table lay drop column b;
+insert into lay select t, 1, t from generate_series(60, 89) t;
+
+select relnatts, count(*) from pg_class
+where oid in (select show_chunks('lay')) group by relnatts order by relnatts;
+
+-- update and insert rows in two chunks of every layout
+with r as (
+    insert into lay select t, d, t * 10
+    from generate_series(0, 89, 15) t, generate_series(1, 2) d
+    on conflict (time, device) do update set value = excluded.value + lay.value
+    returning *
+) select * from r order by time, device;
+
+select * from lay where time % 15 = 0 order by time, device;
+select count(*), sum(value) from lay;
+
+drop table lay;
@@ -0,0 +1,67 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test the last point cache of hypertables
+CREATE TABLE lp(time int NOT NULL, device int NOT NULL, temp float8, note text);
+SELECT table_name FROM create_hypertable('lp', 'time', chunk_time_interval => 100);
+INSERT INTO lp SELECT t, t % 3, t * 0.5, 'n' || t FROM generate_series(1, 250) t;
+CREATE TABLE lp_null(time int NOT NULL, device int);
+SELECT table_name FROM create_hypertable('lp_null', 'time');
+
+\set ON_ERROR_STOP 0
+SELECT enable_last_point_cache('lp_null', 'device');
+SELECT enable_last_point_cache('lp', 'time');
+SELECT enable_last_point_cache('lp', 'nope');
+SELECT disable_last_point_cache('lp');
+\set ON_ERROR_STOP 1
+
+SELECT enable_last_point_cache('lp', 'device');
+SELECT enable_last_point_cache('lp', 'device', if_not_exists => true);
+
+-- the cache is filled with the existing rows
+SELECT test.plan_contains('SELECT device, last(temp, time) FROM lp GROUP BY device',
+    '%_hyper_1_last_point%');
+SELECT device, last(temp, time), max(time) FROM lp GROUP BY device ORDER BY device;
+
+-- quals on other columns than the key need the rows of the hypertable
+SELECT test.plan_contains('SELECT device, last(temp, time) FROM lp WHERE temp > 0 GROUP BY device',
+    '%_hyper_1_last_point%');
+SELECT test.plan_contains('SELECT device, last(temp, time) FROM lp WHERE device > 0 GROUP BY device',
+    '%_hyper_1_last_point%');
+SELECT test.plan_contains('SELECT device, first(temp, time) FROM lp GROUP BY device',
+    '%_hyper_1_last_point%');
+
+-- older rows do not replace the newer ones
+INSERT INTO lp VALUES (300, 1, 1.5, 'new'), (10, 2, 9.9, 'old'), (301, 5, 2.5, 'five');
+SELECT device, last(temp, time), max(time), last(note, time) FROM lp GROUP BY device
+ORDER BY device;
+SET timescaledb.enable_last_point_cache TO off;
+SELECT test.plan_contains('SELECT device, last(temp, time) FROM lp GROUP BY device',
+    '%_hyper_1_last_point%');
+SELECT device, last(temp, time), max(time), last(note, time) FROM lp GROUP BY device
+ORDER BY device;
+RESET timescaledb.enable_last_point_cache;
+
+-- UPDATE, DELETE and drop_chunks rebuild the cache
+UPDATE lp SET temp = 0 WHERE time = 300;
+SELECT device, last(temp, time), max(time) FROM lp GROUP BY device ORDER BY device;
+DELETE FROM lp WHERE device = 5;
+DELETE FROM lp WHERE time >= 249;
+SELECT device, last(temp, time), max(time), last(note, time) FROM lp GROUP BY device
+ORDER BY device;
+SELECT count(*) FROM drop_chunks('lp', newer_than => 200);
+INSERT INTO lp VALUES (5, 0, 7.5, 'older');
+SELECT device, last(temp, time), max(time), last(note, time) FROM lp GROUP BY device
+ORDER BY device;
+
+TRUNCATE lp;
+SELECT count(*) FROM _timescaledb_internal._hyper_1_last_point;
+
+SELECT disable_last_point_cache('lp');
+SELECT disable_last_point_cache('lp', if_exists => true);
+SELECT test.plan_contains('SELECT device, last(temp, time) FROM lp GROUP BY device',
+    '%_hyper_1_last_point%');
+
+DROP TABLE lp_null;
+DROP TABLE lp;
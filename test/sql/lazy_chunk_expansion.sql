@@ -0,0 +1,44 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+create table metrics(time timestamptz not null, device int, value float);
+select table_name from create_hypertable('metrics', 'time', chunk_time_interval => interval '1 day');
+insert into metrics select t, 1, 1.0
+from generate_series('2022-01-01 00:00'::timestamptz, '2022-01-03 23:00', '1 hour') t;
+analyze metrics;
+
+set timescaledb.enable_lazy_chunk_expansion to on;
+set plan_cache_mode to force_generic_plan;
+
+-- the generic plan has no chunks, they are found at execution time
+prepare recent(timestamptz) as select count(*) from metrics where time > $1;
+explain (costs off) execute recent('2022-01-03 12:00');
+explain (analyze, costs off, summary off, timing off) execute recent('2022-01-03 12:00');
+execute recent('2022-01-03 12:00');
+
+-- chunks created after planning are found too
+insert into metrics values ('2022-01-10 00:00', 1, 1.0);
+explain (analyze, costs off, summary off, timing off) execute recent('2022-01-03 12:00');
+execute recent('2022-01-03 12:00');
+
+-- chunks are found again when the parameters change on rescan
+select d.t, (select count(*) from metrics m where m.time > d.t)
+from (values ('2022-01-03 12:00'::timestamptz), ('2022-01-01 12:00')) d(t)
+order by d.t;
+
+-- the cached plan does not reference the chunks, so they can be dropped
+select count(*) from drop_chunks('metrics', older_than => '2022-01-02 00:00'::timestamptz);
+execute recent('2022-01-01 12:00');
+
+-- compare with the expanded hypertable
+reset timescaledb.enable_lazy_chunk_expansion;
+deallocate recent;
+prepare recent(timestamptz) as select count(*) from metrics where time > $1;
+execute recent('2022-01-03 12:00');
+select d.t, (select count(*) from metrics m where m.time > d.t)
+from (values ('2022-01-03 12:00'::timestamptz), ('2022-01-01 12:00')) d(t)
+order by d.t;
+
+reset plan_cache_mode;
+drop table metrics;
@@ -143,6 +143,18 @@ SELECT * FROM partial_index_test WHERE time < 2 ORDER BY time LIMIT 2;
 SET enable_seqscan TO true;
 SET enable_bitmapscan TO true;
 
+-- build the chunk indexes in parallel background workers
+CREATE INDEX ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.parallel_workers = 2);
+SELECT * FROM test.show_indexes('partial_index_test');
+SELECT * FROM test.show_indexesp('_timescaledb_internal._hyper%_chunk') ORDER BY 1,2;
+SELECT indisvalid FROM pg_index WHERE indexrelid = 'partial_index_test_time_idx'::regclass;
+DROP INDEX partial_index_test_time_idx;
+
+\set ON_ERROR_STOP 0
+CREATE INDEX ON partial_index_test (time) WITH (timescaledb.parallel_workers = 2);
+CREATE INDEX ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.parallel_workers = -1);
+\set ON_ERROR_STOP 1
+
 \c  :TEST_DBNAME :ROLE_DEFAULT_PERM_USER_2
 \set ON_ERROR_STOP 0
 CREATE INDEX ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.max_chunks='1');
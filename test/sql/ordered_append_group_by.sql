@@ -0,0 +1,41 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test ordered append for queries grouped by the time dimension
+CREATE TABLE oagb(time int NOT NULL, device int, val int);
+SELECT table_name FROM create_hypertable('oagb', 'time', chunk_time_interval => 100);
+INSERT INTO oagb SELECT t, d, t FROM generate_series(1, 1000) t, generate_series(1, 3) d;
+ANALYZE oagb;
+
+-- compare the sorted plans only
+SET enable_hashagg TO false;
+SET enable_sort TO false;
+
+SELECT test.plan_contains('SELECT time_bucket(10, time), sum(val) FROM oagb GROUP BY 1', '%ChunkAppend%');
+SET timescaledb.enable_ordered_append_group_by TO true;
+SELECT test.plan_contains('SELECT time_bucket(10, time), sum(val) FROM oagb GROUP BY 1', '%ChunkAppend%'),
+    test.plan_contains('SELECT time_bucket(10, time), sum(val) FROM oagb GROUP BY 1', '%Merge Append%'),
+    test.plan_contains('SELECT time, sum(val) FROM oagb GROUP BY time', '%ChunkAppend%');
+
+-- buckets may span chunks, so the chunks can't simply be appended when
+-- grouping on further columns
+SELECT test.plan_contains('SELECT time_bucket(10, time), device, sum(val) FROM oagb GROUP BY 1, 2', '%ChunkAppend%'),
+    test.plan_contains('SELECT device, sum(val) FROM oagb GROUP BY device', '%ChunkAppend%');
+
+SELECT * FROM (
+    SELECT time_bucket(10, time) AS bucket, count(*), sum(val) FROM oagb WHERE time < 35 GROUP BY 1
+) b ORDER BY bucket;
+
+-- the results are the same as without ordered append
+CREATE TABLE oagb_results AS SELECT time_bucket(10, time), count(*), sum(val) FROM oagb GROUP BY 1;
+RESET timescaledb.enable_ordered_append_group_by;
+RESET enable_sort;
+RESET enable_hashagg;
+SELECT count(*) FROM (
+    (SELECT time_bucket(10, time), count(*), sum(val) FROM oagb GROUP BY 1)
+    EXCEPT SELECT * FROM oagb_results
+) e;
+
+DROP TABLE oagb_results;
+DROP TABLE oagb;
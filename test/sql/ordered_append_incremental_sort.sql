@@ -0,0 +1,37 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test incremental sorts of chunks below an ordered append when the chunk
+-- indexes only cover a prefix of the ORDER BY
+CREATE TABLE oais(time int NOT NULL, device int, val int);
+SELECT table_name FROM create_hypertable('oais', 'time', chunk_time_interval => 100);
+INSERT INTO oais SELECT t, d, t * d FROM generate_series(1, 300) t, generate_series(3, 1, -1) d;
+ANALYZE oais;
+
+-- an index on one chunk makes the ordered append consider the full ordering
+DO $$
+BEGIN
+    EXECUTE format('CREATE INDEX ON %s(time, device)', (SELECT show_chunks('oais') LIMIT 1));
+END
+$$;
+
+SET enable_seqscan TO false;
+SELECT test.plan_contains('SELECT * FROM oais ORDER BY time, device', 'Custom Scan (ChunkAppend)%'),
+    test.plan_contains('SELECT * FROM oais ORDER BY time, device', '%->  Incremental Sort%'),
+    test.plan_contains('SELECT * FROM oais ORDER BY time, device', '%->  Sort%');
+
+-- the rows are in order
+SELECT count(*), count(*) FILTER (WHERE (prev_time, prev_device) > (time, device))
+FROM (SELECT time, device, lag(time) OVER () AS prev_time, lag(device) OVER () AS prev_device
+    FROM (SELECT * FROM oais ORDER BY time, device) o) l;
+
+-- chunks are fully sorted without incremental sorts
+SET enable_incremental_sort TO false;
+SELECT test.plan_contains('SELECT * FROM oais ORDER BY time, device', 'Custom Scan (ChunkAppend)%'),
+    test.plan_contains('SELECT * FROM oais ORDER BY time, device', '%->  Incremental Sort%'),
+    test.plan_contains('SELECT * FROM oais ORDER BY time, device', '%->  Sort%');
+
+RESET enable_incremental_sort;
+RESET enable_seqscan;
+DROP TABLE oais;
@@ -307,3 +307,77 @@ INSERT INTO part_time_func_null_ret VALUES (1530214157.134, 23.4, 'dev1'),
 CREATE FUNCTION _timescaledb_internal.update_dimension_partition(hypertable REGCLASS) RETURNS VOID AS :MODULE_PATHNAME, 'ts_dimension_partition_update' LANGUAGE C VOLATILE;
 SELECT _timescaledb_internal.update_dimension_partition('part_custom_dim');
 DROP FUNCTION _timescaledb_internal.update_dimension_partition;
+
+-- The default partitioning function is computed without a function call
+-- for the common column types. The rows must be placed in the same
+-- partitions as the function places them.
+CREATE TABLE part_inline_hash(time int NOT NULL, i2 int2, i4 int4, i8 int8, t text, tc text COLLATE "C");
+SELECT table_name FROM create_hypertable('part_inline_hash', 'time', 'i2', 2, chunk_time_interval => 10);
+SELECT column_name FROM add_dimension('part_inline_hash', 'i4', 2);
+SELECT column_name FROM add_dimension('part_inline_hash', 'i8', 2);
+SELECT column_name FROM add_dimension('part_inline_hash', 't', 2);
+SELECT column_name FROM add_dimension('part_inline_hash', 'tc', 2);
+INSERT INTO part_inline_hash
+SELECT t % 20, (t * 7 - 500)::int2, t * 1000003 - 100000000, t * 1000000000007 - 99999999999999,
+       'dev' || t, 'dev' || t
+FROM generate_series(1, 200) t;
+
+SELECT d.column_name, count(*) AS rows,
+       count(*) FILTER (WHERE h.value < ds.range_start OR h.value >= ds.range_end) AS misplaced
+FROM part_inline_hash p
+JOIN _timescaledb_catalog.chunk c ON format('%I.%I', c.schema_name, c.table_name)::regclass = p.tableoid
+JOIN _timescaledb_catalog.chunk_constraint cc ON cc.chunk_id = c.id
+JOIN _timescaledb_catalog.dimension_slice ds ON ds.id = cc.dimension_slice_id
+JOIN _timescaledb_catalog.dimension d ON d.id = ds.dimension_id
+CROSS JOIN LATERAL (
+  SELECT CASE d.column_name
+         WHEN 'i2' THEN _timescaledb_internal.get_partition_hash(p.i2)
+         WHEN 'i4' THEN _timescaledb_internal.get_partition_hash(p.i4)
+         WHEN 'i8' THEN _timescaledb_internal.get_partition_hash(p.i8)
+         WHEN 't' THEN _timescaledb_internal.get_partition_hash(p.t)
+         WHEN 'tc' THEN _timescaledb_internal.get_partition_hash(p.tc)
+         END) h(value)
+WHERE d.num_slices IS NOT NULL
+GROUP BY 1 ORDER BY 1;
+DROP TABLE part_inline_hash;
+
+-- Balancing the partitions by the observed sizes puts the boundary of the
+-- partitions next to a heavy tenant
+CREATE TABLE part_balance(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('part_balance', 'time', 'device', 2, chunk_time_interval => 10);
+INSERT INTO part_balance SELECT t % 10, 1, t FROM generate_series(1, 1000) t;
+INSERT INTO part_balance SELECT t % 10, d, t FROM generate_series(1, 10) t, generate_series(2, 20) d;
+SELECT _timescaledb_internal.balance_dimension_partitions('part_balance', 1024);
+SELECT count(*), bool_and(dp.range_start IN (h.vp * 2097151, (h.vp + 1) * 2097151)) AS next_to_heavy
+FROM _timescaledb_catalog.dimension_partition dp
+JOIN _timescaledb_catalog.dimension d ON d.id = dp.dimension_id
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = d.hypertable_id
+CROSS JOIN (SELECT _timescaledb_internal.get_partition_hash(1) / 2097151 AS vp) h
+WHERE ht.table_name = 'part_balance' AND dp.range_start > 0;
+
+-- New chunks follow the balanced partitions
+INSERT INTO part_balance SELECT 10 + t % 10, d, t FROM generate_series(1, 10) t, generate_series(1, 20) d;
+SELECT count(*) AS rows,
+       count(*) FILTER (WHERE h.value < ds.range_start OR h.value >= ds.range_end) AS misplaced,
+       bool_and(ds.range_start IN (SELECT dp.range_start FROM _timescaledb_catalog.dimension_partition dp
+                                   WHERE dp.dimension_id = d.id)) AS follows_partitions
+FROM part_balance p
+JOIN _timescaledb_catalog.chunk c ON format('%I.%I', c.schema_name, c.table_name)::regclass = p.tableoid
+JOIN _timescaledb_catalog.chunk_constraint cc ON cc.chunk_id = c.id
+JOIN _timescaledb_catalog.dimension_slice ds ON ds.id = cc.dimension_slice_id
+JOIN _timescaledb_catalog.dimension d ON d.id = ds.dimension_id
+CROSS JOIN LATERAL (SELECT _timescaledb_internal.get_partition_hash(p.device)) h(value)
+WHERE d.column_name = 'device' AND p.time >= 10;
+
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.balance_dimension_partitions('part_balance', 1);
+\set ON_ERROR_STOP 1
+
+-- Setting the number of partitions recreates equally sized partitions
+SELECT set_number_partitions('part_balance', 2);
+SELECT dp.range_start
+FROM _timescaledb_catalog.dimension_partition dp
+JOIN _timescaledb_catalog.dimension d ON d.id = dp.dimension_id
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = d.hypertable_id
+WHERE ht.table_name = 'part_balance' ORDER BY 1;
+DROP TABLE part_balance;
@@ -0,0 +1,29 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+CREATE TABLE timing(time int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('timing', 'time', chunk_time_interval => 10);
+INSERT INTO timing SELECT t, t FROM generate_series(0, 39) t;
+
+-- nothing is timed by default
+SELECT count(*) FROM timing WHERE time < 15;
+SELECT * FROM _timescaledb_internal.planner_timing();
+
+SET timescaledb.enable_planner_timing TO on;
+SELECT count(*) FROM timing WHERE time < 15;
+SELECT phase, calls > 0 AS called, chunks, total_time >= 0 AS timed
+FROM _timescaledb_internal.planner_timing();
+-- planning the query on the timings doesn't overwrite them
+SELECT phase, chunks FROM _timescaledb_internal.planner_timing();
+
+-- all chunks
+SELECT count(*) FROM timing;
+SELECT phase, calls > 0 AS called, chunks FROM _timescaledb_internal.planner_timing();
+
+-- no chunks match
+SELECT count(*) FROM timing WHERE time > 100;
+SELECT phase, chunks FROM _timescaledb_internal.planner_timing();
+
+RESET timescaledb.enable_planner_timing;
+DROP TABLE timing;
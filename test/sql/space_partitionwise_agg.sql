@@ -0,0 +1,81 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Test full aggregation per space partition when grouping on the
+-- space-partitioning column
+SET max_parallel_workers_per_gather TO 0;
+CREATE TABLE sp(time int NOT NULL, device int NOT NULL, val int);
+SELECT table_name FROM create_hypertable('sp', 'time', 'device', 3, chunk_time_interval => 100,
+    create_default_indexes => false);
+INSERT INTO sp SELECT t, d, t * d FROM generate_series(1, 300) t, generate_series(1, 30) d;
+ANALYZE sp;
+
+-- the aggregation is partitionwise if an Append sits above the first aggregate
+CREATE FUNCTION agg_is_partitionwise(query text) RETURNS bool
+LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+    seen_append bool := false;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (costs off) ' || query LOOP
+        IF line LIKE '%Aggregate%' THEN
+            RETURN seen_append;
+        END IF;
+        seen_append := seen_append OR line LIKE '%Append%';
+    END LOOP;
+    RETURN false;
+END
+$$;
+
+-- cursors are planned for fast startup, which favours aggregating the
+-- partitions one by one
+CREATE FUNCTION sp_agg(min_total bigint) RETURNS TABLE(device int, cnt bigint, total bigint)
+LANGUAGE plpgsql AS $$
+DECLARE
+    c CURSOR FOR
+        SELECT s.device, count(*), sum(s.val) FROM sp s GROUP BY s.device
+        HAVING sum(s.val) >= min_total;
+BEGIN
+    FOR r IN c LOOP
+        device := r.device;
+        cnt := r.count;
+        total := r.sum;
+        RETURN NEXT;
+    END LOOP;
+END
+$$;
+
+SELECT agg_is_partitionwise('SELECT device, sum(val) FROM sp GROUP BY device LIMIT 1');
+SET timescaledb.enable_space_partitionwise_aggregate TO true;
+SELECT agg_is_partitionwise('SELECT device, sum(val) FROM sp GROUP BY device LIMIT 1'),
+    agg_is_partitionwise('SELECT time, device, sum(val) FROM sp GROUP BY device, time LIMIT 1'),
+    agg_is_partitionwise('SELECT device, sum(val) FROM sp GROUP BY device HAVING sum(val) > 0 LIMIT 1');
+
+-- grouping without the space column can't be split up
+SELECT agg_is_partitionwise('SELECT time, sum(val) FROM sp GROUP BY time LIMIT 1'),
+    agg_is_partitionwise('SELECT device % 2, sum(val) FROM sp GROUP BY device % 2 LIMIT 1');
+
+SELECT * FROM sp_agg(0) ORDER BY device;
+SELECT * FROM sp_agg(1000000) ORDER BY device;
+
+-- the results are the same as with a single aggregate
+CREATE TABLE sp_results AS SELECT * FROM sp_agg(0);
+RESET timescaledb.enable_space_partitionwise_aggregate;
+SELECT count(*) FROM (SELECT * FROM sp_agg(0) EXCEPT SELECT * FROM sp_results) e;
+SET timescaledb.enable_space_partitionwise_aggregate TO true;
+
+-- after changing the number of partitions the slices of new chunks overlap
+-- those of old chunks and the overlapping chunks must be aggregated together
+SELECT set_number_partitions('sp', 2);
+INSERT INTO sp SELECT t, d, t * d FROM generate_series(401, 500) t, generate_series(1, 30) d;
+ANALYZE sp;
+SELECT agg_is_partitionwise('SELECT device, sum(val) FROM sp GROUP BY device LIMIT 1');
+SELECT count(*), sum(cnt), sum(total) FROM sp_agg(0);
+
+RESET timescaledb.enable_space_partitionwise_aggregate;
+RESET max_parallel_workers_per_gather;
+DROP FUNCTION sp_agg(bigint);
+DROP FUNCTION agg_is_partitionwise(text);
+DROP TABLE sp_results;
+DROP TABLE sp;
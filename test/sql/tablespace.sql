@@ -227,6 +227,35 @@ DROP TABLE tbl_1;
 DROP TABLE tbl_2;
 DROP TABLE tbl_3;
 
+-- with least_used selection, a new chunk goes to the tablespace with the
+-- fewest chunks of its time slice and, on a tie, to the smaller tablespace
+CREATE TABLE tspace_least(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('tspace_least', 'time', 'device', 2, chunk_time_interval => 10);
+SELECT attach_tablespace('tablespace1', 'tspace_least');
+SELECT attach_tablespace('tablespace2', 'tspace_least');
+SET timescaledb.chunk_tablespace_selection TO least_used;
+INSERT INTO tspace_least SELECT t, d, t FROM generate_series(0, 19) t, generate_series(1, 20) d;
+SELECT l.time / 10 AS slice, count(DISTINCT c.reltablespace)
+FROM tspace_least l JOIN pg_class c ON c.oid = l.tableoid
+GROUP BY 1 ORDER BY 1;
+
+CREATE TABLE tspace_filler(value int) TABLESPACE tablespace1;
+INSERT INTO tspace_filler SELECT generate_series(1, 10000);
+CREATE TABLE tspace_time(time int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('tspace_time', 'time', chunk_time_interval => 10);
+SELECT attach_tablespace('tablespace1', 'tspace_time');
+SELECT attach_tablespace('tablespace2', 'tspace_time');
+INSERT INTO tspace_time SELECT t, t FROM generate_series(0, 29) t;
+SELECT t.spcname, count(*)
+FROM show_chunks('tspace_time') ch JOIN pg_class c ON c.oid = ch
+JOIN pg_tablespace t ON t.oid = c.reltablespace
+GROUP BY 1 ORDER BY 1;
+
+RESET timescaledb.chunk_tablespace_selection;
+DROP TABLE tspace_least;
+DROP TABLE tspace_time;
+DROP TABLE tspace_filler;
+
 -- verify that one cannot DROP a tablespace while it is attached to a
 -- hypertable
 CREATE TABLE tbl_1(time timestamp, temp float, device text);
@@ -693,6 +693,17 @@ SELECT
   time_bucket('2month', ts, current_setting('timezone'), '2000-02-01'::timestamp, '7 day'::interval) AS "2m offset + origin"
 
 FROM generate_series('1999-12-01'::timestamptz,'2000-09-01'::timestamptz, '9 day'::interval) ts;
+-- the zone offsets are cached between calls, check that the buckets still
+-- match the ones computed in local time across the DST transitions
+SELECT
+  w AS "interval",
+  count(*) FILTER (WHERE time_bucket(w, ts, 'Europe/Berlin') IS DISTINCT FROM time_bucket(w, ts AT TIME ZONE 'Europe/Berlin') AT TIME ZONE 'Europe/Berlin') AS "Berlin",
+  count(*) FILTER (WHERE time_bucket(w, ts, 'America/New_York') IS DISTINCT FROM time_bucket(w, ts AT TIME ZONE 'America/New_York') AT TIME ZONE 'America/New_York') AS "New York",
+  count(*) FILTER (WHERE timescaledb_experimental.time_bucket_ng(w, ts, 'Europe/Berlin') IS DISTINCT FROM timescaledb_experimental.time_bucket_ng(w, ts AT TIME ZONE 'Europe/Berlin') AT TIME ZONE 'Europe/Berlin') AS "Berlin ng"
+FROM generate_series('2020-03-20 00:00+00'::timestamptz,'2020-11-10 00:00+00'::timestamptz, '7 min'::interval) ts,
+  unnest('{15 min,1 hour,1 day,1 week}'::interval[]) w
+GROUP BY w
+ORDER BY w;
 
 RESET datestyle;
 
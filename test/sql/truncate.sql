@@ -149,3 +149,16 @@ SET client_min_messages TO ERROR;
 DROP DATABASE test_trunc_ht;
 DROP ROLE owner;
 DROP ROLE truncator;
+
+-- temporary tables are neither hypertables nor chunks
+CREATE TABLE trunc_ht(time int NOT NULL, value int);
+SELECT table_name FROM create_hypertable('trunc_ht', 'time', chunk_time_interval => 10);
+CREATE TEMP TABLE trunc_temp(time int, value int);
+INSERT INTO trunc_ht VALUES (1, 1), (11, 2);
+INSERT INTO trunc_temp VALUES (1, 1);
+TRUNCATE trunc_temp, trunc_ht;
+SELECT count(*) FROM trunc_temp;
+SELECT count(*) FROM trunc_ht;
+SELECT count(*) FROM show_chunks('trunc_ht');
+DROP TABLE trunc_ht;
+DROP TABLE trunc_temp;
@@ -308,3 +308,19 @@ $sql$ LANGUAGE PLPGSQL;
 SELECT counter,test_upsert2('2000-01-01',1.0) FROM generate_series(1,10) AS g(counter);
 
 SELECT * FROM prepared_test;
+
+-- chunk insert states that are evicted and created again reuse the ON
+-- CONFLICT state of their chunk, both for chunks with the tuple descriptor
+-- of the hypertable and for chunks with a different one
+CREATE TABLE upsert_evict(time int NOT NULL, dropme int, device int, value int, UNIQUE (time, device));
+SELECT table_name FROM create_hypertable('upsert_evict', 'time', chunk_time_interval => 10);
+INSERT INTO upsert_evict(time, device, value) VALUES (1, 3, 1);
+ALTER TABLE upsert_evict DROP COLUMN dropme;
+INSERT INTO upsert_evict VALUES (11, 1, 1), (21, 2, 1), (11, 4, 200);
+SET timescaledb.max_open_chunks_per_insert = 1;
+INSERT INTO upsert_evict SELECT t % 3 * 10 + 1, t, t FROM generate_series(1, 9) t
+ON CONFLICT (time, device) DO UPDATE SET value = upsert_evict.value + excluded.value
+WHERE upsert_evict.value < 100;
+SELECT * FROM upsert_evict ORDER BY time, device;
+RESET timescaledb.max_open_chunks_per_insert;
+DROP TABLE upsert_evict;
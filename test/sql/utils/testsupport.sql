@@ -292,6 +292,23 @@ BEGIN
 END
 $BODY$;
 
+-- Check if a line of the plan of the query matches the LIKE pattern, for
+-- tests that only depend on a node of a plan that varies otherwise
+CREATE OR REPLACE FUNCTION test.plan_contains(query text, pattern text)
+RETURNS BOOL LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (costs off) ' || query LOOP
+        IF line LIKE pattern THEN
+            RETURN true;
+        END IF;
+    END LOOP;
+    RETURN false;
+END
+$BODY$;
+
 -- Used to set a deterministic memory setting during tests
 CREATE OR REPLACE FUNCTION test.set_memory_cache_size(memory_amount text)
 RETURNS BIGINT AS :MODULE_PATHNAME, 'ts_set_memory_cache_size' LANGUAGE C VOLATILE STRICT;
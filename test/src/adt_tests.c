@@ -20,6 +20,7 @@ TS_FUNCTION_INFO_V1(ts_test_adts);
 #include <adts/vec.h>
 
 #include <adts/bit_array.h>
+#include <adts/int32_small_vec.h>
 
 static void
 i32_vec_test(void)
@@ -93,6 +94,74 @@ uint64_vec_test(void)
 	TestAssertPtrEq(vec.data, NULL);
 }
 
+static void
+int32_small_vec_test(void)
+{
+	int32_small_vec vec;
+	int32_small_vec other;
+	int i;
+
+	/* small vectors use the inline elements until they grow */
+	int32_small_vec_init(&vec, CurrentMemoryContext, 0);
+	TestAssertPtrEq(vec.data, vec.inline_elements);
+	TestAssertInt64Eq(vec.max_elements, 16);
+
+	for (i = 0; i < 16; i++)
+		int32_small_vec_append(&vec, 100 - 2 * i);
+	TestAssertPtrEq(vec.data, vec.inline_elements);
+
+	for (i = 16; i < 40; i++)
+		int32_small_vec_append(&vec, 100 - 2 * i);
+	TestAssertInt64Eq(vec.num_elements, 40);
+	TestAssertTrue(vec.data != vec.inline_elements);
+	for (i = 0; i < 40; i++)
+		TestAssertInt64Eq(*int32_small_vec_at(&vec, i), 100 - 2 * i);
+
+	/* duplicates are removed by sorting */
+	int32_small_vec_append(&vec, 100);
+	int32_small_vec_append(&vec, 42);
+	int32_small_vec_sort_unique(&vec);
+	TestAssertInt64Eq(vec.num_elements, 40);
+	for (i = 0; i < 40; i++)
+		TestAssertInt64Eq(*int32_small_vec_at(&vec, i), 22 + 2 * i);
+	TestAssertTrue(int32_small_vec_contains(&vec, 22));
+	TestAssertTrue(int32_small_vec_contains(&vec, 100));
+	TestAssertTrue(!int32_small_vec_contains(&vec, 23));
+	TestAssertTrue(!int32_small_vec_contains(&vec, 101));
+
+	/* the multiples of three between 0 and 150 */
+	int32_small_vec_init(&other, CurrentMemoryContext, 0);
+	for (i = 0; i <= 50; i++)
+		int32_small_vec_append(&other, 3 * i);
+
+	int32_small_vec_union(&vec, &other);
+	TestAssertInt64Eq(vec.num_elements, 40 + 51 - 13);
+	for (i = 1; i < (int) vec.num_elements; i++)
+		TestAssertTrue(*int32_small_vec_at(&vec, i - 1) < *int32_small_vec_at(&vec, i));
+	TestAssertInt64Eq(*int32_small_vec_at(&vec, 0), 0);
+	TestAssertInt64Eq(*int32_small_vec_last(&vec), 150);
+
+	/* the even multiples of three between 22 and 100 */
+	int32_small_vec_clear(&vec);
+	for (i = 11; i <= 50; i++)
+		int32_small_vec_append(&vec, 2 * i);
+	int32_small_vec_intersect(&vec, &other);
+	TestAssertInt64Eq(vec.num_elements, 13);
+	for (i = 0; i < 13; i++)
+		TestAssertInt64Eq(*int32_small_vec_at(&vec, i), 24 + 6 * i);
+
+	int32_small_vec_clear(&other);
+	int32_small_vec_intersect(&vec, &other);
+	TestAssertInt64Eq(vec.num_elements, 0);
+
+	/* freeing the data goes back to the inline elements */
+	int32_small_vec_free_data(&vec);
+	TestAssertPtrEq(vec.data, vec.inline_elements);
+	TestAssertInt64Eq(vec.num_elements, 0);
+	TestAssertInt64Eq(vec.max_elements, 16);
+	int32_small_vec_free_data(&other);
+}
+
 static void
 bit_array_test(void)
 {
@@ -138,6 +207,7 @@ ts_test_adts(PG_FUNCTION_ARGS)
 {
 	i32_vec_test();
 	uint64_vec_test();
+	int32_small_vec_test();
 	bit_array_test();
 	PG_RETURN_VOID();
 }
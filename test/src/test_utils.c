@@ -19,6 +19,7 @@
 #include <utils/guc.h>
 #include <utils/memutils.h>
 
+#include "bgw/launcher_interface.h"
 #include "debug_point.h"
 
 TS_FUNCTION_INFO_V1(ts_test_error_injection);
@@ -274,3 +275,38 @@ ts_debug_allocated_bytes(PG_FUNCTION_ARGS)
 	PG_RETURN_UINT64(MemoryContextMemAllocated(context, /* recurse = */ true));
 #endif
 }
+
+/*
+ * Take all unreserved TimescaleDB background workers, so that nothing else
+ * can start one. Returns the number of workers reserved.
+ */
+TS_FUNCTION_INFO_V1(ts_test_bgw_reserve_all_workers);
+Datum
+ts_test_bgw_reserve_all_workers(PG_FUNCTION_ARGS)
+{
+	int32 nreserved = 0;
+
+	while (ts_bgw_worker_reserve())
+		nreserved++;
+
+	PG_RETURN_INT32(nreserved);
+}
+
+TS_FUNCTION_INFO_V1(ts_test_bgw_release_workers);
+Datum
+ts_test_bgw_release_workers(PG_FUNCTION_ARGS)
+{
+	int32 nworkers = PG_GETARG_INT32(0);
+
+	while (nworkers-- > 0)
+		ts_bgw_worker_release();
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(ts_test_bgw_num_unreserved);
+Datum
+ts_test_bgw_num_unreserved(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT32(ts_bgw_num_unreserved());
+}
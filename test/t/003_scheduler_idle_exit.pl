@@ -0,0 +1,62 @@
+# This file and its contents are licensed under the Timescale License.
+# Please see the included NOTICE for copyright information and
+# LICENSE-TIMESCALE for a copy of the license.
+
+use strict;
+use warnings;
+use TimescaleNode;
+use Test::More tests => 6;
+
+# This test checks that with timescaledb.bgw_scheduler_idle_exit_time the
+# database scheduler exits when no job is due, and that the launcher starts
+# it again when the jobs change and when the next job is due. The setting
+# can only be set at server start, so it can't be tested in a regression test.
+my $node = TimescaleNode->create('scheduler_idle_exit');
+$node->append_conf('postgresql.conf',
+	'timescaledb.bgw_scheduler_idle_exit_time = 2s');
+$node->restart;
+
+my $num_schedulers = <<'END_OF_SQL';
+SELECT count(*) FROM pg_stat_activity
+WHERE application_name = 'TimescaleDB Background Worker Scheduler'
+  AND datname = 'postgres'
+END_OF_SQL
+
+is($node->poll_query_until('postgres', $num_schedulers, '0'),
+	1, 'scheduler exits when no job is due');
+
+$node->safe_psql(
+	'postgres', q[
+CREATE TABLE job_runs(run_at timestamptz);
+CREATE PROCEDURE record_run(job_id int, config jsonb) LANGUAGE SQL AS
+$$ INSERT INTO job_runs VALUES (now()) $$;
+]);
+
+# adding a job starts the scheduler right away
+my $jobid = $node->safe_psql('postgres',
+	q[SELECT add_job('record_run', '1 hour', initial_start => now())]);
+is($jobid, '1000', 'job was added');
+is( $node->poll_query_until(
+		'postgres', 'SELECT count(*) FROM job_runs', '1'),
+	1,
+	'scheduler is started for the new job');
+
+# the next run is an hour away, so the scheduler exits again
+is($node->poll_query_until('postgres', $num_schedulers, '0'),
+	1, 'scheduler exits after the job ran');
+
+# the next run is later than the idle exit time, so the scheduler that is
+# started for the changed job exits again and is woken up when the job is due
+my $next_start = $node->safe_psql('postgres',
+	q[SELECT next_start FROM alter_job(1000, next_start => now() + interval '10 seconds')]
+);
+is( $node->poll_query_until(
+		'postgres', 'SELECT count(*) FROM job_runs', '2'),
+	1,
+	'scheduler is woken up when the job is due');
+is( $node->safe_psql(
+		'postgres', "SELECT max(run_at) >= '$next_start' FROM job_runs"),
+	't',
+	'job runs at its next start');
+
+done_testing();
@@ -0,0 +1,71 @@
+# This file and its contents are licensed under the Timescale License.
+# Please see the included NOTICE for copyright information and
+# LICENSE-TIMESCALE for a copy of the license.
+
+use strict;
+use warnings;
+use TimescaleNode;
+use Test::More tests => 6;
+
+# This test checks that with timescaledb.bgw_job_stat_pending_max_jobs the
+# end of a successful job run is kept pending in shared memory and that the
+# scheduler writes it to the job statistics table once the flush interval has
+# passed. The setting can only be set at server start, so it can't be tested
+# in a regression test.
+my $node = TimescaleNode->create('job_stat_pending');
+$node->append_conf(
+	'postgresql.conf', q[
+timescaledb.bgw_job_stat_pending_max_jobs = 10
+timescaledb.bgw_job_stat_flush_interval = 1h
+]);
+$node->restart;
+
+$node->safe_psql(
+	'postgres', q[
+CREATE TABLE job_runs(run_at timestamptz);
+CREATE PROCEDURE record_run(job_id int, config jsonb) LANGUAGE SQL AS
+$$ INSERT INTO job_runs VALUES (now()) $$;
+]);
+
+my $job_stat = <<'END_OF_SQL';
+SELECT total_runs, total_successes
+FROM _timescaledb_internal.bgw_job_stat WHERE job_id = 1000
+END_OF_SQL
+
+my $jobid = $node->safe_psql('postgres',
+	q[SELECT add_job('record_run', '1 hour', initial_start => now())]);
+is($jobid, '1000', 'job was added');
+
+# the scheduler has not written any statistics yet, so the first run is
+# written right away
+is($node->poll_query_until('postgres', $job_stat, '1|1'),
+	1, 'statistics of the first run are written');
+
+# the start of the second run is written right away, its end is pending
+# until the flush interval has passed
+$node->safe_psql('postgres',
+	'SELECT next_start FROM alter_job(1000, next_start => now())');
+is( $node->poll_query_until(
+		'postgres', 'SELECT count(*) FROM job_runs', '2'),
+	1,
+	'job ran again');
+$node->safe_psql('postgres', 'SELECT pg_sleep(2)');
+is($node->safe_psql('postgres', $job_stat),
+	'2|1', 'end of the second run is pending');
+
+# with a short flush interval the scheduler writes the pending statistics
+$node->safe_psql(
+	'postgres', q[
+ALTER SYSTEM SET timescaledb.bgw_job_stat_flush_interval = '1s';
+SELECT pg_reload_conf();
+]);
+is($node->poll_query_until('postgres', $job_stat, '2|2'),
+	1, 'pending statistics are written after the flush interval');
+is( $node->safe_psql(
+		'postgres',
+		'SELECT last_run_success FROM _timescaledb_internal.bgw_job_stat WHERE job_id = 1000'
+	),
+	't',
+	'pending statistics are complete');
+
+done_testing();
@@ -0,0 +1,347 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include <postgres.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+
+#include <hypertable_cache.h>
+#include <jsonb_utils.h>
+
+#include "bgw/job.h"
+#include "bgw/job_stat.h"
+#include "bgw/timer.h"
+#include "bgw_policy/chunk_precreation_api.h"
+#include "bgw_policy/job.h"
+#include "dimension.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "utils.h"
+
+/*
+ * The chunk precreation policy creates the chunks that follow the newest data
+ * of a hypertable, so that inserts that cross a chunk boundary find the chunk
+ * already created instead of creating it, and taking the locks that come with
+ * it, while other writers wait.
+ *
+ * The default schedule interval is half the chunk interval for time types
+ * (see policy_chunk_precreation_add) and one day otherwise.
+ */
+#define DEFAULT_SCHEDULE_INTERVAL                                                                  \
+	{                                                                                              \
+		.day = 1                                                                                   \
+	}
+
+/* Default max runtime for a chunk precreation job should not be very long */
+#define DEFAULT_MAX_RUNTIME                                                                        \
+	{                                                                                              \
+		.time = 5 * USECS_PER_MINUTE                                                               \
+	}
+/* There is an infinite number of retries for chunk precreation jobs */
+#define DEFAULT_MAX_RETRIES (-1)
+/* Default retry period for chunk precreation jobs is 5 minutes */
+#define DEFAULT_RETRY_PERIOD                                                                       \
+	{                                                                                              \
+		.time = 5 * USECS_PER_MINUTE                                                               \
+	}
+
+#define CONFIG_KEY_HYPERTABLE_ID "hypertable_id"
+#define CONFIG_KEY_CHUNKS_AHEAD "chunks_ahead"
+
+#define POLICY_CHUNK_PRECREATION_PROC_NAME "policy_chunk_precreation"
+#define POLICY_CHUNK_PRECREATION_CHECK_NAME "policy_chunk_precreation_check"
+
+int32
+policy_chunk_precreation_get_hypertable_id(const Jsonb *config)
+{
+	bool found;
+	int32 hypertable_id = ts_jsonb_get_int32_field(config, CONFIG_KEY_HYPERTABLE_ID, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find hypertable_id in config for job")));
+
+	return hypertable_id;
+}
+
+int32
+policy_chunk_precreation_get_chunks_ahead(const Jsonb *config)
+{
+	bool found;
+	int32 chunks_ahead = ts_jsonb_get_int32_field(config, CONFIG_KEY_CHUNKS_AHEAD, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find chunks_ahead in config for job")));
+
+	if (chunks_ahead <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of chunks to create ahead: %d", chunks_ahead),
+				 errhint("The number of chunks to create ahead must be greater than 0.")));
+
+	return chunks_ahead;
+}
+
+/*
+ * Check that the chunks following the newest data can be computed for the
+ * hypertable, which needs the values of a single open dimension to be its
+ * internal time values.
+ */
+void
+policy_chunk_precreation_validate_hypertable(const Hypertable *ht)
+{
+	const Dimension *dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (TS_HYPERTABLE_IS_INTERNAL_COMPRESSION_TABLE(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot add chunk precreation policy to compressed hypertable \"%s\"",
+						get_rel_name(ht->main_table_relid)),
+				 errhint("Please add the policy to the corresponding uncompressed hypertable "
+						 "instead.")));
+
+	if (hypertable_is_distributed(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("chunk precreation policies not supported on distributed hypertables")));
+
+	if (dim == NULL || hyperspace_get_open_dimension(ht->space, 1) != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("chunk precreation policies require a single time dimension"),
+				 errdetail("Hypertable \"%s\" has %s time dimension.",
+						   get_rel_name(ht->main_table_relid),
+						   dim == NULL ? "no" : "more than one")));
+
+	if (dim->partitioning != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("chunk precreation policies not supported on a time dimension with a "
+						"partitioning function"),
+				 errdetail("Hypertable \"%s\" partitions column \"%s\" with a function.",
+						   get_rel_name(ht->main_table_relid),
+						   NameStr(dim->fd.column_name))));
+}
+
+Datum
+policy_chunk_precreation_check(PG_FUNCTION_ARGS)
+{
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), errmsg("config must not be NULL")));
+	}
+
+	policy_chunk_precreation_read_and_validate_config(PG_GETARG_JSONB_P(0), NULL);
+
+	PG_RETURN_VOID();
+}
+
+Datum
+policy_chunk_precreation_proc(PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2 || PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_VOID();
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	policy_chunk_precreation_execute(PG_GETARG_INT32(0), PG_GETARG_JSONB_P(1));
+
+	PG_RETURN_VOID();
+}
+
+Datum
+policy_chunk_precreation_add(PG_FUNCTION_ARGS)
+{
+	/* behave like a strict function */
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
+		PG_RETURN_NULL();
+
+	NameData application_name;
+	NameData proc_name, proc_schema, check_name, check_schema, owner;
+	int32 job_id;
+	const Dimension *dim;
+	Oid ht_oid = PG_GETARG_OID(0);
+	int32 chunks_ahead = PG_GETARG_INT32(1);
+	bool if_not_exists = PG_GETARG_BOOL(2);
+	Interval schedule_interval = DEFAULT_SCHEDULE_INTERVAL;
+	Interval max_runtime = DEFAULT_MAX_RUNTIME;
+	Interval retry_period = DEFAULT_RETRY_PERIOD;
+	TimestampTz initial_start = PG_ARGISNULL(4) ? DT_NOBEGIN : PG_GETARG_TIMESTAMPTZ(4);
+	bool fixed_schedule = !PG_ARGISNULL(4);
+	text *timezone = PG_ARGISNULL(5) ? NULL : PG_GETARG_TEXT_PP(5);
+	char *valid_timezone = NULL;
+	Cache *hcache;
+	Hypertable *ht;
+	int32 hypertable_id;
+	Oid owner_id;
+	List *jobs;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (timezone != NULL)
+		valid_timezone = ts_bgw_job_validate_timezone(PG_GETARG_DATUM(5));
+
+	if (chunks_ahead <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of chunks to create ahead: %d", chunks_ahead),
+				 errhint("The number of chunks to create ahead must be greater than 0.")));
+
+	ht = ts_hypertable_cache_get_cache_and_entry(ht_oid, CACHE_FLAG_NONE, &hcache);
+	Assert(ht != NULL);
+	hypertable_id = ht->fd.id;
+
+	/* First verify that the hypertable corresponds to a valid table */
+	owner_id = ts_hypertable_permissions_check(ht_oid, GetUserId());
+
+	policy_chunk_precreation_validate_hypertable(ht);
+
+	/* Verify that the hypertable owner can create a background worker */
+	ts_bgw_job_validate_job_owner(owner_id);
+
+	/* Make sure that an existing policy doesn't exist on this hypertable */
+	jobs = ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_CHUNK_PRECREATION_PROC_NAME,
+													 INTERNAL_SCHEMA_NAME,
+													 hypertable_id);
+
+	/*
+	 * Run the job twice per chunk interval by default, so that the chunks
+	 * ahead are created well before the inserts reach them
+	 */
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+	if (!PG_ARGISNULL(3))
+		schedule_interval = *PG_GETARG_INTERVAL_P(3);
+	else if (IS_TIMESTAMP_TYPE(ts_dimension_get_partition_type(dim)))
+	{
+		schedule_interval.time = dim->fd.interval_length / 2;
+		schedule_interval.day = 0;
+		schedule_interval.month = 0;
+	}
+
+	ts_cache_release(hcache);
+
+	if (jobs != NIL)
+	{
+		BgwJob *existing = linitial(jobs);
+		Assert(list_length(jobs) == 1);
+
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("chunk precreation policy already exists for hypertable \"%s\"",
+							get_rel_name(ht_oid))));
+
+		if (policy_chunk_precreation_get_chunks_ahead(existing->fd.config) != chunks_ahead)
+		{
+			ereport(WARNING,
+					(errmsg("chunk precreation policy already exists for hypertable \"%s\"",
+							get_rel_name(ht_oid)),
+					 errdetail("A policy already exists with different arguments."),
+					 errhint("Remove the existing policy before adding a new one.")));
+			PG_RETURN_INT32(-1);
+		}
+		/* If all arguments are the same, do nothing */
+		ereport(NOTICE,
+				(errmsg("chunk precreation policy already exists for hypertable \"%s\", skipping",
+						get_rel_name(ht_oid))));
+		PG_RETURN_INT32(-1);
+	}
+
+	/* if users pass in -infinity for initial_start, then use the current_timestamp instead */
+	if (fixed_schedule)
+	{
+		ts_bgw_job_validate_schedule_interval(&schedule_interval);
+		if (TIMESTAMP_NOT_FINITE(initial_start))
+			initial_start = ts_timer_get_current_timestamp();
+	}
+
+	/* Next, insert a new job into jobs table */
+	namestrcpy(&application_name, "Chunk Precreation Policy");
+	namestrcpy(&proc_name, POLICY_CHUNK_PRECREATION_PROC_NAME);
+	namestrcpy(&proc_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&check_name, POLICY_CHUNK_PRECREATION_CHECK_NAME);
+	namestrcpy(&check_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&owner, GetUserNameFromId(owner_id, false));
+
+	JsonbParseState *parse_state = NULL;
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+	ts_jsonb_add_int32(parse_state, CONFIG_KEY_HYPERTABLE_ID, hypertable_id);
+	ts_jsonb_add_int32(parse_state, CONFIG_KEY_CHUNKS_AHEAD, chunks_ahead);
+	JsonbValue *result = pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL);
+	Jsonb *config = JsonbValueToJsonb(result);
+
+	job_id = ts_bgw_job_insert_relation(&application_name,
+										&schedule_interval,
+										&max_runtime,
+										DEFAULT_MAX_RETRIES,
+										&retry_period,
+										&proc_schema,
+										&proc_name,
+										&check_schema,
+										&check_name,
+										&owner,
+										true,
+										fixed_schedule,
+										hypertable_id,
+										config,
+										initial_start,
+										valid_timezone);
+
+	if (!TIMESTAMP_NOT_FINITE(initial_start))
+		ts_bgw_job_stat_upsert_next_start(job_id, initial_start);
+
+	PG_RETURN_INT32(job_id);
+}
+
+Datum
+policy_chunk_precreation_remove(PG_FUNCTION_ARGS)
+{
+	Oid hypertable_oid = PG_GETARG_OID(0);
+	bool if_exists = PG_GETARG_BOOL(1);
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	ht = ts_hypertable_cache_get_cache_and_entry(hypertable_oid, CACHE_FLAG_NONE, &hcache);
+
+	List *jobs = ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_CHUNK_PRECREATION_PROC_NAME,
+														   INTERNAL_SCHEMA_NAME,
+														   ht->fd.id);
+	ts_cache_release(hcache);
+
+	if (jobs == NIL)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("chunk precreation policy not found for hypertable \"%s\"",
+							get_rel_name(hypertable_oid))));
+		else
+		{
+			ereport(NOTICE,
+					(errmsg("chunk precreation policy not found for hypertable \"%s\", skipping",
+							get_rel_name(hypertable_oid))));
+			PG_RETURN_VOID();
+		}
+	}
+	Assert(list_length(jobs) == 1);
+	BgwJob *job = linitial(jobs);
+
+	ts_hypertable_permissions_check(hypertable_oid, GetUserId());
+
+	ts_bgw_job_delete_by_id(job->fd.id);
+
+	PG_RETURN_VOID();
+}
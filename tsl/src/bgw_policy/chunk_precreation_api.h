@@ -0,0 +1,24 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_TSL_BGW_POLICY_CHUNK_PRECREATION_API_H
+#define TIMESCALEDB_TSL_BGW_POLICY_CHUNK_PRECREATION_API_H
+
+#include <postgres.h>
+
+#include "hypertable.h"
+
+/* User-facing API functions */
+extern Datum policy_chunk_precreation_add(PG_FUNCTION_ARGS);
+extern Datum policy_chunk_precreation_remove(PG_FUNCTION_ARGS);
+extern Datum policy_chunk_precreation_proc(PG_FUNCTION_ARGS);
+extern Datum policy_chunk_precreation_check(PG_FUNCTION_ARGS);
+
+extern int32 policy_chunk_precreation_get_hypertable_id(const Jsonb *config);
+extern int32 policy_chunk_precreation_get_chunks_ahead(const Jsonb *config);
+extern void policy_chunk_precreation_validate_hypertable(const Hypertable *ht);
+
+#endif /* TIMESCALEDB_TSL_BGW_POLICY_CHUNK_PRECREATION_API_H */
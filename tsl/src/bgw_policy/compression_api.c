@@ -459,6 +459,196 @@ policy_compression_remove(PG_FUNCTION_ARGS)
 	return policy_compression_remove_internal(user_rel_oid, if_exists);
 }
 
+/*
+ * Batched compression policy.
+ *
+ * A compression policy runs one job per hypertable, so compressing one chunk
+ * on each of many small hypertables takes as many job runs. A compression
+ * policy that has "batched" set in its config is instead run by the
+ * compression batch policy of the database, which compresses the eligible
+ * chunks of all batched policies in one job run, oldest chunk first, until
+ * the time budget of the run is used up.
+ */
+#define DEFAULT_COMPRESSION_BATCH_SCHEDULE_INTERVAL                                                \
+	DatumGetIntervalP(DirectFunctionCall3(interval_in, CStringGetDatum("1 hour"), InvalidOid, -1))
+
+static Interval *
+policy_compression_batch_get_time_budget(const Jsonb *config)
+{
+	Interval *time_budget =
+		ts_jsonb_get_interval_field(config, POL_COMPRESSION_BATCH_CONF_KEY_TIME_BUDGET);
+
+	if (time_budget == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find time_budget in config for job")));
+
+	return time_budget;
+}
+
+static void
+policy_compression_batch_validate_time_budget(const Interval *time_budget)
+{
+	Interval zero = { 0 };
+
+	if (DatumGetInt32(DirectFunctionCall2(interval_cmp,
+										  IntervalPGetDatum(time_budget),
+										  IntervalPGetDatum(&zero))) <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("time_budget must be greater than zero")));
+}
+
+Datum
+policy_compression_batch_check(PG_FUNCTION_ARGS)
+{
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), errmsg("config must not be NULL")));
+	}
+
+	policy_compression_batch_validate_time_budget(
+		policy_compression_batch_get_time_budget(PG_GETARG_JSONB_P(0)));
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * CREATE OR REPLACE FUNCTION add_compression_batch_policy(
+ * 0 time_budget INTERVAL,
+ * 1 schedule_interval INTERVAL = NULL,
+ * 2 if_not_exists BOOL = false,
+ * 3 initial_start TIMESTAMPTZ = NULL,
+ * 4 timezone TEXT = NULL
+ * ) RETURNS INTEGER
+ */
+Datum
+policy_compression_batch_add(PG_FUNCTION_ARGS)
+{
+	/* behave like a strict function */
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(2))
+		PG_RETURN_NULL();
+
+	NameData application_name;
+	NameData proc_name, proc_schema, check_name, check_schema, owner;
+	Interval *time_budget = PG_GETARG_INTERVAL_P(0);
+	Interval *schedule_interval =
+		PG_ARGISNULL(1) ? DEFAULT_COMPRESSION_BATCH_SCHEDULE_INTERVAL : PG_GETARG_INTERVAL_P(1);
+	bool if_not_exists = PG_GETARG_BOOL(2);
+	TimestampTz initial_start = PG_ARGISNULL(3) ? DT_NOBEGIN : PG_GETARG_TIMESTAMPTZ(3);
+	bool fixed_schedule = !PG_ARGISNULL(3);
+	text *timezone = PG_ARGISNULL(4) ? NULL : PG_GETARG_TEXT_PP(4);
+	char *valid_timezone = NULL;
+	Oid owner_id = GetUserId();
+	List *jobs;
+	int32 job_id;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	policy_compression_batch_validate_time_budget(time_budget);
+
+	if (timezone != NULL)
+		valid_timezone = ts_bgw_job_validate_timezone(PG_GETARG_DATUM(4));
+
+	ts_bgw_job_validate_job_owner(owner_id);
+
+	/* There is one compression batch policy per database */
+	jobs = ts_bgw_job_find_by_proc(POLICY_COMPRESSION_BATCH_PROC_NAME, INTERNAL_SCHEMA_NAME);
+
+	if (jobs != NIL)
+	{
+		Assert(list_length(jobs) == 1);
+
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("compression batch policy already exists")));
+
+		ereport(NOTICE, (errmsg("compression batch policy already exists, skipping")));
+		PG_RETURN_INT32(-1);
+	}
+
+	/* if users pass in -infinity for initial_start, then use the current_timestamp instead */
+	if (fixed_schedule)
+	{
+		ts_bgw_job_validate_schedule_interval(schedule_interval);
+		if (TIMESTAMP_NOT_FINITE(initial_start))
+			initial_start = ts_timer_get_current_timestamp();
+	}
+
+	namestrcpy(&application_name, "Compression Batch Policy");
+	namestrcpy(&proc_name, POLICY_COMPRESSION_BATCH_PROC_NAME);
+	namestrcpy(&proc_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&check_name, POLICY_COMPRESSION_BATCH_CHECK_NAME);
+	namestrcpy(&check_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&owner, GetUserNameFromId(owner_id, false));
+
+	JsonbParseState *parse_state = NULL;
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+	ts_jsonb_add_interval(parse_state, POL_COMPRESSION_BATCH_CONF_KEY_TIME_BUDGET, time_budget);
+	JsonbValue *result = pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL);
+	Jsonb *config = JsonbValueToJsonb(result);
+
+	job_id = ts_bgw_job_insert_relation(&application_name,
+										schedule_interval,
+										DEFAULT_MAX_RUNTIME,
+										DEFAULT_MAX_RETRIES,
+										DEFAULT_RETRY_PERIOD,
+										&proc_schema,
+										&proc_name,
+										&check_schema,
+										&check_name,
+										&owner,
+										true,
+										fixed_schedule,
+										0,
+										config,
+										initial_start,
+										valid_timezone);
+
+	if (!TIMESTAMP_NOT_FINITE(initial_start))
+		ts_bgw_job_stat_upsert_next_start(job_id, initial_start);
+
+	PG_RETURN_INT32(job_id);
+}
+
+/*
+ * CREATE OR REPLACE FUNCTION remove_compression_batch_policy(
+ * 0 if_exists BOOL = false
+ * ) RETURNS VOID
+ */
+Datum
+policy_compression_batch_remove(PG_FUNCTION_ARGS)
+{
+	bool if_exists = PG_GETARG_BOOL(0);
+	List *jobs;
+	BgwJob *job;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	jobs = ts_bgw_job_find_by_proc(POLICY_COMPRESSION_BATCH_PROC_NAME, INTERNAL_SCHEMA_NAME);
+
+	if (jobs == NIL)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("compression batch policy not found")));
+
+		ereport(NOTICE, (errmsg("compression batch policy not found, skipping")));
+		PG_RETURN_VOID();
+	}
+
+	Assert(list_length(jobs) == 1);
+	job = linitial(jobs);
+
+	ts_bgw_job_permission_check(job);
+	ts_bgw_job_delete_by_id(job->fd.id);
+
+	PG_RETURN_VOID();
+}
+
 /* compare cagg job config  with compression job config. If there is an overlap, then
  * throw an error. We do this since we cannot refresh compressed
  * regions. We do not want cont. aggregate jobs to fail
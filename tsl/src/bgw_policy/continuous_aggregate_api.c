@@ -132,6 +132,32 @@ policy_refresh_cagg_get_refresh_end(const Dimension *dim, const Jsonb *config)
 	return res;
 }
 
+/*
+ * Refresh only the parts of the refresh window with pending changes, in
+ * batches of at most this many buckets. Zero refreshes the whole window.
+ */
+int32
+policy_refresh_cagg_get_buckets_per_batch(const Jsonb *config)
+{
+	bool found;
+	int32 buckets_per_batch =
+		ts_jsonb_get_int32_field(config, POL_REFRESH_CONF_KEY_BUCKETS_PER_BATCH, &found);
+	return (found && buckets_per_batch > 0) ? buckets_per_batch : 0;
+}
+
+/*
+ * Refresh at most this many batches per run and run again right away for the
+ * rest. Zero refreshes all batches.
+ */
+int32
+policy_refresh_cagg_get_max_batches_per_execution(const Jsonb *config)
+{
+	bool found;
+	int32 max_batches =
+		ts_jsonb_get_int32_field(config, POL_REFRESH_CONF_KEY_MAX_BATCHES_PER_EXECUTION, &found);
+	return (found && max_batches > 0) ? max_batches : 0;
+}
+
 /* returns false if a policy could not be found */
 bool
 policy_refresh_cagg_exists(int32 materialization_id)
@@ -219,6 +245,18 @@ policy_refresh_cagg_proc(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+Datum
+policy_refresh_cagg_window_proc(PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2 || PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_VOID();
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+	policy_refresh_cagg_window_execute(PG_GETARG_INT32(0), PG_GETARG_JSONB_P(1));
+
+	PG_RETURN_VOID();
+}
+
 Datum
 policy_refresh_cagg_check(PG_FUNCTION_ARGS)
 {
@@ -753,3 +791,50 @@ policy_refresh_cagg_remove(PG_FUNCTION_ARGS)
 	(void) policy_refresh_cagg_remove_internal(cagg_oid, if_exists);
 	PG_RETURN_VOID();
 }
+
+/*
+ * Add a job that materializes a window of a continuous aggregate refresh,
+ * see timescaledb.cagg_refresh_parallel_jobs. The job removes itself when
+ * the window is materialized and is retried until then.
+ */
+int32
+policy_refresh_cagg_window_add(const ContinuousAgg *cagg, const InternalTimeRange *window)
+{
+	NameData application_name;
+	NameData proc_name, proc_schema, check_name, check_schema, owner;
+	Interval retry_period = { .time = 5 * USECS_PER_MINUTE };
+	JsonbParseState *parse_state = NULL;
+
+	namestrcpy(&application_name, "Refresh Continuous Aggregate Window");
+	namestrcpy(&proc_name, POLICY_REFRESH_CAGG_WINDOW_PROC_NAME);
+	namestrcpy(&proc_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&check_name, "");
+	namestrcpy(&check_schema, "");
+	namestrcpy(&owner, GetUserNameFromId(ts_rel_get_owner(cagg->relid), false));
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+	ts_jsonb_add_int32(parse_state,
+					   POL_REFRESH_CONF_KEY_MAT_HYPERTABLE_ID,
+					   cagg->data.mat_hypertable_id);
+	ts_jsonb_add_int64(parse_state, POL_REFRESH_WINDOW_CONF_KEY_WINDOW_START, window->start);
+	ts_jsonb_add_int64(parse_state, POL_REFRESH_WINDOW_CONF_KEY_WINDOW_END, window->end);
+	JsonbValue *result = pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL);
+	Jsonb *config = JsonbValueToJsonb(result);
+
+	return ts_bgw_job_insert_relation(&application_name,
+									  &retry_period,
+									  DEFAULT_MAX_RUNTIME,
+									  DEFAULT_MAX_RETRIES,
+									  &retry_period,
+									  &proc_schema,
+									  &proc_name,
+									  &check_schema,
+									  &check_name,
+									  &owner,
+									  true,
+									  false,
+									  cagg->data.mat_hypertable_id,
+									  config,
+									  DT_NOBEGIN,
+									  NULL);
+}
@@ -16,10 +16,13 @@ extern Datum policy_refresh_cagg_add(PG_FUNCTION_ARGS);
 extern Datum policy_refresh_cagg_proc(PG_FUNCTION_ARGS);
 extern Datum policy_refresh_cagg_check(PG_FUNCTION_ARGS);
 extern Datum policy_refresh_cagg_remove(PG_FUNCTION_ARGS);
+extern Datum policy_refresh_cagg_window_proc(PG_FUNCTION_ARGS);
 
 int32 policy_continuous_aggregate_get_mat_hypertable_id(const Jsonb *config);
 int64 policy_refresh_cagg_get_refresh_start(const Dimension *dim, const Jsonb *config);
 int64 policy_refresh_cagg_get_refresh_end(const Dimension *dim, const Jsonb *config);
+int32 policy_refresh_cagg_get_buckets_per_batch(const Jsonb *config);
+int32 policy_refresh_cagg_get_max_batches_per_execution(const Jsonb *config);
 bool policy_refresh_cagg_refresh_start_lt(int32 materialization_id, Oid cmp_type,
 										  Datum cmp_interval);
 bool policy_refresh_cagg_exists(int32 materialization_id);
@@ -30,5 +33,6 @@ Datum policy_refresh_cagg_add_internal(Oid cagg_oid, Oid start_offset_type,
 									   bool if_not_exists, bool fixed_schedule,
 									   TimestampTz initial_start, const char *timezone);
 Datum policy_refresh_cagg_remove_internal(Oid cagg_oid, bool if_exists);
+int32 policy_refresh_cagg_window_add(const ContinuousAgg *cagg, const InternalTimeRange *window);
 
 #endif /* TIMESCALEDB_TSL_BGW_POLICY_CAGG_API_H */
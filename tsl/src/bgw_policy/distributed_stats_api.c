@@ -0,0 +1,266 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include <postgres.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+
+#include <hypertable_cache.h>
+#include <jsonb_utils.h>
+
+#include "bgw/job.h"
+#include "bgw/job_stat.h"
+#include "bgw/timer.h"
+#include "bgw_policy/distributed_stats_api.h"
+#include "bgw_policy/job.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "utils.h"
+
+/*
+ * The distributed statistics policy fetches the relation and column
+ * statistics of the chunks of a distributed hypertable from the data nodes,
+ * in one query per data node, and stores them as the local statistics of the
+ * foreign chunks. The planner then estimates the chunk sizes from these
+ * statistics instead of from heuristics, without remote calls during planning
+ * and without running ANALYZE on the data nodes.
+ */
+#define DEFAULT_SCHEDULE_INTERVAL                                                                  \
+	{                                                                                              \
+		.time = 30 * USECS_PER_MINUTE                                                              \
+	}
+
+/* Default max runtime for a distributed statistics job should not be very long */
+#define DEFAULT_MAX_RUNTIME                                                                        \
+	{                                                                                              \
+		.time = 5 * USECS_PER_MINUTE                                                               \
+	}
+/* There is an infinite number of retries for distributed statistics jobs */
+#define DEFAULT_MAX_RETRIES (-1)
+/* Default retry period for distributed statistics jobs is 5 minutes */
+#define DEFAULT_RETRY_PERIOD                                                                       \
+	{                                                                                              \
+		.time = 5 * USECS_PER_MINUTE                                                               \
+	}
+
+#define CONFIG_KEY_HYPERTABLE_ID "hypertable_id"
+
+#define POLICY_DISTRIBUTED_STATS_PROC_NAME "policy_distributed_stats"
+#define POLICY_DISTRIBUTED_STATS_CHECK_NAME "policy_distributed_stats_check"
+
+int32
+policy_distributed_stats_get_hypertable_id(const Jsonb *config)
+{
+	bool found;
+	int32 hypertable_id = ts_jsonb_get_int32_field(config, CONFIG_KEY_HYPERTABLE_ID, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find hypertable_id in config for job")));
+
+	return hypertable_id;
+}
+
+/* The statistics are only fetched for distributed hypertables */
+void
+policy_distributed_stats_validate_hypertable(const Hypertable *ht)
+{
+	if (!hypertable_is_distributed(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_TS_HYPERTABLE_NOT_DISTRIBUTED),
+				 errmsg("hypertable \"%s\" is not distributed", get_rel_name(ht->main_table_relid)),
+				 errhint("Add the distributed statistics policy to a distributed hypertable.")));
+}
+
+Datum
+policy_distributed_stats_check(PG_FUNCTION_ARGS)
+{
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), errmsg("config must not be NULL")));
+	}
+
+	policy_distributed_stats_read_and_validate_config(PG_GETARG_JSONB_P(0), NULL);
+
+	PG_RETURN_VOID();
+}
+
+Datum
+policy_distributed_stats_proc(PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2 || PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_VOID();
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	policy_distributed_stats_execute(PG_GETARG_INT32(0), PG_GETARG_JSONB_P(1));
+
+	PG_RETURN_VOID();
+}
+
+Datum
+policy_distributed_stats_add(PG_FUNCTION_ARGS)
+{
+	/* behave like a strict function */
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	NameData application_name;
+	NameData proc_name, proc_schema, check_name, check_schema, owner;
+	int32 job_id;
+	Oid ht_oid = PG_GETARG_OID(0);
+	bool if_not_exists = PG_GETARG_BOOL(1);
+	Interval schedule_interval = DEFAULT_SCHEDULE_INTERVAL;
+	Interval max_runtime = DEFAULT_MAX_RUNTIME;
+	Interval retry_period = DEFAULT_RETRY_PERIOD;
+	TimestampTz initial_start = PG_ARGISNULL(3) ? DT_NOBEGIN : PG_GETARG_TIMESTAMPTZ(3);
+	bool fixed_schedule = !PG_ARGISNULL(3);
+	text *timezone = PG_ARGISNULL(4) ? NULL : PG_GETARG_TEXT_PP(4);
+	char *valid_timezone = NULL;
+	Cache *hcache;
+	Hypertable *ht;
+	int32 hypertable_id;
+	Oid owner_id;
+	List *jobs;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (timezone != NULL)
+		valid_timezone = ts_bgw_job_validate_timezone(PG_GETARG_DATUM(4));
+
+	if (!PG_ARGISNULL(2))
+		schedule_interval = *PG_GETARG_INTERVAL_P(2);
+
+	ht = ts_hypertable_cache_get_cache_and_entry(ht_oid, CACHE_FLAG_NONE, &hcache);
+	Assert(ht != NULL);
+	hypertable_id = ht->fd.id;
+
+	/* First verify that the hypertable corresponds to a valid table */
+	owner_id = ts_hypertable_permissions_check(ht_oid, GetUserId());
+
+	policy_distributed_stats_validate_hypertable(ht);
+	ts_cache_release(hcache);
+
+	/* Verify that the hypertable owner can create a background worker */
+	ts_bgw_job_validate_job_owner(owner_id);
+
+	/* Make sure that an existing policy doesn't exist on this hypertable */
+	jobs = ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_DISTRIBUTED_STATS_PROC_NAME,
+													 INTERNAL_SCHEMA_NAME,
+													 hypertable_id);
+
+	if (jobs != NIL)
+	{
+		Assert(list_length(jobs) == 1);
+
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("distributed statistics policy already exists for hypertable "
+							"\"%s\"",
+							get_rel_name(ht_oid))));
+
+		ereport(NOTICE,
+				(errmsg("distributed statistics policy already exists for hypertable "
+						"\"%s\", skipping",
+						get_rel_name(ht_oid))));
+		PG_RETURN_INT32(-1);
+	}
+
+	/* if users pass in -infinity for initial_start, then use the current_timestamp instead */
+	if (fixed_schedule)
+	{
+		ts_bgw_job_validate_schedule_interval(&schedule_interval);
+		if (TIMESTAMP_NOT_FINITE(initial_start))
+			initial_start = ts_timer_get_current_timestamp();
+	}
+
+	/* Next, insert a new job into jobs table */
+	namestrcpy(&application_name, "Distributed Statistics Policy");
+	namestrcpy(&proc_name, POLICY_DISTRIBUTED_STATS_PROC_NAME);
+	namestrcpy(&proc_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&check_name, POLICY_DISTRIBUTED_STATS_CHECK_NAME);
+	namestrcpy(&check_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&owner, GetUserNameFromId(owner_id, false));
+
+	JsonbParseState *parse_state = NULL;
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+	ts_jsonb_add_int32(parse_state, CONFIG_KEY_HYPERTABLE_ID, hypertable_id);
+	JsonbValue *result = pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL);
+	Jsonb *config = JsonbValueToJsonb(result);
+
+	job_id = ts_bgw_job_insert_relation(&application_name,
+										&schedule_interval,
+										&max_runtime,
+										DEFAULT_MAX_RETRIES,
+										&retry_period,
+										&proc_schema,
+										&proc_name,
+										&check_schema,
+										&check_name,
+										&owner,
+										true,
+										fixed_schedule,
+										hypertable_id,
+										config,
+										initial_start,
+										valid_timezone);
+
+	if (!TIMESTAMP_NOT_FINITE(initial_start))
+		ts_bgw_job_stat_upsert_next_start(job_id, initial_start);
+
+	PG_RETURN_INT32(job_id);
+}
+
+Datum
+policy_distributed_stats_remove(PG_FUNCTION_ARGS)
+{
+	Oid hypertable_oid = PG_GETARG_OID(0);
+	bool if_exists = PG_GETARG_BOOL(1);
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	ht = ts_hypertable_cache_get_cache_and_entry(hypertable_oid, CACHE_FLAG_NONE, &hcache);
+
+	List *jobs =
+		ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_DISTRIBUTED_STATS_PROC_NAME,
+												  INTERNAL_SCHEMA_NAME,
+												  ht->fd.id);
+	ts_cache_release(hcache);
+
+	if (jobs == NIL)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("distributed statistics policy not found for hypertable \"%s\"",
+							get_rel_name(hypertable_oid))));
+		else
+		{
+			ereport(NOTICE,
+					(errmsg("distributed statistics policy not found for hypertable "
+							"\"%s\", skipping",
+							get_rel_name(hypertable_oid))));
+			PG_RETURN_VOID();
+		}
+	}
+	Assert(list_length(jobs) == 1);
+	BgwJob *job = linitial(jobs);
+
+	ts_hypertable_permissions_check(hypertable_oid, GetUserId());
+
+	ts_bgw_job_delete_by_id(job->fd.id);
+
+	PG_RETURN_VOID();
+}
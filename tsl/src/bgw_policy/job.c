@@ -5,9 +5,13 @@
  */
 
 #include <postgres.h>
+#include <access/htup_details.h>
+#include <access/transam.h>
 #include <access/xact.h>
+#include <catalog/pg_class.h>
 #include <catalog/namespace.h>
 #include <catalog/pg_type.h>
+#include <commands/vacuum.h>
 #include <funcapi.h>
 #include <hypertable_cache.h>
 #include <nodes/makefuncs.h>
@@ -15,6 +19,7 @@
 #include <nodes/primnodes.h>
 #include <parser/parse_func.h>
 #include <parser/parser.h>
+#include <pgstat.h>
 #include <tcop/pquery.h>
 #include <utils/builtins.h>
 #include <utils/lsyscache.h>
@@ -26,15 +31,22 @@
 
 #include "bgw/timer.h"
 #include "bgw/job.h"
+#include "bgw/job_history.h"
 #include "bgw/job_stat.h"
+#include "bgw_policy/chunk_precreation_api.h"
 #include "bgw_policy/chunk_stats.h"
 #include "bgw_policy/compression_api.h"
 #include "bgw_policy/continuous_aggregate_api.h"
+#include "bgw_policy/distributed_stats_api.h"
+#include "bgw_policy/invalidation_log_api.h"
+#include "bgw_policy/policies_v2.h"
 #include "bgw_policy/policy_utils.h"
 #include "bgw_policy/reorder_api.h"
 #include "bgw_policy/retention_api.h"
+#include "bgw_policy/vacuum_api.h"
 #include "compat/compat.h"
 #include "compression/api.h"
+#include "continuous_aggs/invalidation.h"
 #include "continuous_aggs/materialize.h"
 #include "continuous_aggs/refresh.h"
 #include "ts_catalog/continuous_agg.h"
@@ -45,9 +57,11 @@
 #include "errors.h"
 #include "job.h"
 #include "chunk.h"
+#include "chunk_api.h"
 #include "dimension.h"
 #include "dimension_slice.h"
 #include "dimension_vector.h"
+#include "hypercube.h"
 #include "errors.h"
 #include "job.h"
 #include "reorder.h"
@@ -328,15 +342,98 @@ policy_retention_read_and_validate_config(Jsonb *config, PolicyRetentionData *po
 	}
 }
 
+/*
+ * Refresh the continuous aggregate of a refresh policy.
+ *
+ * With "buckets_per_batch" in the config, only the parts of the refresh
+ * window with pending changes are refreshed, in batches that each commit, so
+ * that a run costs what changed rather than the size of the window. A run
+ * without pending changes refreshes nothing. With
+ * "max_batches_per_execution", a run refreshes at most that many batches and
+ * the job runs again right away for the rest.
+ */
 bool
 policy_refresh_cagg_execute(int32 job_id, Jsonb *config)
 {
 	PolicyContinuousAggData policy_data;
+	int32 buckets_per_batch = policy_refresh_cagg_get_buckets_per_batch(config);
+	int32 max_batches = policy_refresh_cagg_get_max_batches_per_execution(config);
+	int32 mat_id;
+	List *batches;
+	ListCell *lc;
+	bool more;
 
 	policy_refresh_cagg_read_and_validate_config(config, &policy_data);
-	continuous_agg_refresh_internal(policy_data.cagg,
-									&policy_data.refresh_window,
-									CAGG_REFRESH_POLICY);
+
+	if (buckets_per_batch == 0)
+	{
+		continuous_agg_refresh_internal(policy_data.cagg,
+										&policy_data.refresh_window,
+										CAGG_REFRESH_POLICY);
+		return true;
+	}
+
+	mat_id = policy_data.cagg->data.mat_hypertable_id;
+	batches = continuous_agg_refresh_batches(policy_data.cagg,
+											 &policy_data.refresh_window,
+											 buckets_per_batch,
+											 max_batches,
+											 &more);
+
+	elog(LOG,
+		 "refreshing continuous aggregate \"%s\" in %d batches%s",
+		 NameStr(policy_data.cagg->data.user_view_name),
+		 list_length(batches),
+		 more ? ", more pending" : "");
+
+	foreach (lc, batches)
+	{
+		/* Each refresh commits, so look up the continuous aggregate again */
+		ContinuousAgg *cagg = ts_continuous_agg_find_by_mat_hypertable_id(mat_id);
+
+		if (cagg == NULL)
+			return true;
+
+		continuous_agg_refresh_internal(cagg, lfirst(lc), CAGG_REFRESH_POLICY);
+	}
+
+	if (more)
+		enable_fast_restart(job_id, "refresh continuous aggregate");
+
+	return true;
+}
+
+/*
+ * Materialize a window handed over by a continuous aggregate refresh and
+ * remove the job, in the same transaction. If the continuous aggregate is
+ * gone, there is nothing to materialize.
+ */
+bool
+policy_refresh_cagg_window_execute(int32 job_id, Jsonb *config)
+{
+	int32 materialization_id = policy_continuous_aggregate_get_mat_hypertable_id(config);
+	ContinuousAgg *cagg = ts_continuous_agg_find_by_mat_hypertable_id(materialization_id);
+	bool start_found, end_found;
+	InternalTimeRange window = {
+		.start = ts_jsonb_get_int64_field(config,
+										  POL_REFRESH_WINDOW_CONF_KEY_WINDOW_START,
+										  &start_found),
+		.end =
+			ts_jsonb_get_int64_field(config, POL_REFRESH_WINDOW_CONF_KEY_WINDOW_END, &end_found),
+	};
+
+	if (!start_found || !end_found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find the refresh window in config for job %d", job_id)));
+
+	if (cagg != NULL)
+	{
+		window.type = cagg->partition_type;
+		continuous_agg_refresh_scheduled_window(cagg, &window);
+	}
+
+	ts_bgw_job_delete_by_id(job_id);
 
 	return true;
 }
@@ -538,6 +635,557 @@ policy_recompression_execute(int32 job_id, Jsonb *config)
 	return true;
 }
 
+void
+policy_chunk_precreation_read_and_validate_config(Jsonb *config, PolicyChunkPrecreationData *policy)
+{
+	int32 htid = policy_chunk_precreation_get_hypertable_id(config);
+	int32 chunks_ahead = policy_chunk_precreation_get_chunks_ahead(config);
+	Oid table_relid = ts_hypertable_id_to_relid(htid);
+	Cache *hcache;
+	Hypertable *hypertable;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("configuration hypertable id %d not found", htid)));
+
+	hypertable = ts_hypertable_cache_get_cache_and_entry(table_relid, CACHE_FLAG_NONE, &hcache);
+	policy_chunk_precreation_validate_hypertable(hypertable);
+
+	if (policy)
+	{
+		policy->hypertable = hypertable;
+		policy->hcache = hcache;
+		policy->chunks_ahead = chunks_ahead;
+	}
+	else
+		ts_cache_release(hcache);
+}
+
+/*
+ * Find or create the chunk of every space partition at the time coordinate
+ * and return the end of the earliest of them in the time dimension, which is
+ * where the next chunks start.
+ */
+static int64
+precreate_chunks_at(const Hypertable *ht, const Dimension *time_dim, int64 time_coord,
+					int *num_created)
+{
+	const Hyperspace *hs = ht->space;
+	Point *point = ts_point_create(hs->num_dimensions);
+	int64 time_end = DIMENSION_SLICE_MAXVALUE;
+	int num_partitions = 1;
+
+	for (int i = 0; i < hs->num_dimensions; i++)
+	{
+		if (IS_CLOSED_DIMENSION(&hs->dimensions[i]))
+			num_partitions *= hs->dimensions[i].fd.num_slices;
+	}
+
+	for (int partition = 0; partition < num_partitions; partition++)
+	{
+		const DimensionSlice *time_slice;
+		Chunk *chunk;
+		int remaining = partition;
+
+		/* Open dimension coordinates are stored before the closed coordinates */
+		point->num_coords = 0;
+		for (int i = 0; i < hs->num_dimensions; i++)
+		{
+			const Dimension *dim = &hs->dimensions[i];
+
+			if (IS_OPEN_DIMENSION(dim))
+				point->coordinates[point->num_coords++] = time_coord;
+			else
+			{
+				/* The start of the partition, see calculate_closed_range_default() */
+				int64 interval = DIMENSION_SLICE_CLOSED_MAX / dim->fd.num_slices;
+
+				point->coordinates[point->num_coords++] =
+					(remaining % dim->fd.num_slices) * interval;
+				remaining /= dim->fd.num_slices;
+			}
+		}
+
+		chunk = ts_hypertable_find_chunk_for_point(ht, point);
+
+		if (chunk == NULL)
+		{
+			bool found;
+
+			chunk = ts_hypertable_create_chunk_for_point(ht, point, &found);
+
+			if (!found)
+			{
+				elog(DEBUG1,
+					 "created chunk \"%s.%s\" ahead of the inserts",
+					 NameStr(chunk->fd.schema_name),
+					 NameStr(chunk->fd.table_name));
+				(*num_created)++;
+			}
+		}
+
+		time_slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube, time_dim->fd.id);
+		Assert(time_slice != NULL);
+		time_end = Min(time_end, time_slice->fd.range_end);
+	}
+
+	pfree(point);
+
+	return time_end;
+}
+
+/*
+ * Create the chunks that follow the chunk of the newest data in the time
+ * dimension, for all space partitions.
+ *
+ * The chunks are found from the newest data rather than from the newest chunk
+ * so that running the policy again, before the inserts reached the chunks
+ * created ahead, does not create more chunks. The chunks of the newest data
+ * are created too for the space partitions that have no data yet. The interval
+ * of each next chunk is computed the same way as on insert, so it follows
+ * changes of the chunk interval and adaptive chunking.
+ */
+bool
+policy_chunk_precreation_execute(int32 job_id, Jsonb *config)
+{
+	PolicyChunkPrecreationData policy_data;
+	const Dimension *time_dim;
+	Oid time_type;
+	Datum maxdat;
+	bool max_isnull;
+	int64 time_coord;
+	int num_created = 0;
+
+	policy_chunk_precreation_read_and_validate_config(config, &policy_data);
+	time_dim = hyperspace_get_open_dimension(policy_data.hypertable->space, 0);
+	time_type = ts_dimension_get_partition_type(time_dim);
+
+	maxdat = ts_hypertable_get_open_dim_max_value(policy_data.hypertable, 0, &max_isnull);
+
+	if (max_isnull)
+	{
+		elog(NOTICE,
+			 "no chunks created ahead for hypertable \"%s.%s\" without data",
+			 NameStr(policy_data.hypertable->fd.schema_name),
+			 NameStr(policy_data.hypertable->fd.table_name));
+		ts_cache_release(policy_data.hcache);
+		return true;
+	}
+
+	time_coord = ts_time_value_to_internal(maxdat, time_type);
+
+	for (int i = 0; i <= policy_data.chunks_ahead; i++)
+	{
+		time_coord =
+			precreate_chunks_at(policy_data.hypertable, time_dim, time_coord, &num_created);
+
+		/* The chunks reach the end of the time dimension */
+		if (time_coord == DIMENSION_SLICE_MAXVALUE)
+			break;
+	}
+
+	elog(DEBUG1,
+		 "job %d created %d chunks ahead of the inserts into hypertable \"%s.%s\"",
+		 job_id,
+		 num_created,
+		 NameStr(policy_data.hypertable->fd.schema_name),
+		 NameStr(policy_data.hypertable->fd.table_name));
+
+	ts_cache_release(policy_data.hcache);
+
+	return true;
+}
+
+void
+policy_distributed_stats_read_and_validate_config(Jsonb *config, Oid *table_relid)
+{
+	int32 htid = policy_distributed_stats_get_hypertable_id(config);
+	Oid relid = ts_hypertable_id_to_relid(htid);
+	Cache *hcache;
+	Hypertable *hypertable;
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("configuration hypertable id %d not found", htid)));
+
+	hypertable = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+	policy_distributed_stats_validate_hypertable(hypertable);
+	ts_cache_release(hcache);
+
+	if (table_relid)
+		*table_relid = relid;
+}
+
+/*
+ * Fetch the statistics of the chunks of a distributed hypertable from the
+ * data nodes into the local statistics of the foreign chunks, which the
+ * planner uses for the cost estimates.
+ */
+bool
+policy_distributed_stats_execute(int32 job_id, Jsonb *config)
+{
+	Oid table_relid;
+
+	policy_distributed_stats_read_and_validate_config(config, &table_relid);
+	chunk_api_update_distributed_hypertable_stats(table_relid);
+
+	elog(DEBUG1,
+		 "job %d updated the chunk statistics of \"%s\"",
+		 job_id,
+		 get_rel_name(table_relid));
+
+	return true;
+}
+
+void
+policy_invalidation_log_compaction_read_and_validate_config(Jsonb *config, int32 *hypertable_id)
+{
+	int32 htid = policy_invalidation_log_compaction_get_hypertable_id(config);
+	Oid table_relid = ts_hypertable_id_to_relid(htid);
+	Cache *hcache;
+	Hypertable *hypertable;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("configuration hypertable id %d not found", htid)));
+
+	hypertable = ts_hypertable_cache_get_cache_and_entry(table_relid, CACHE_FLAG_NONE, &hcache);
+	policy_invalidation_log_compaction_validate_hypertable(hypertable);
+	ts_cache_release(hcache);
+
+	if (hypertable_id)
+		*hypertable_id = htid;
+}
+
+/*
+ * Merge the overlapping and adjacent entries of the hypertable invalidation
+ * log, independent of refreshes of the continuous aggregates.
+ */
+bool
+policy_invalidation_log_compaction_execute(int32 job_id, Jsonb *config)
+{
+	int32 hypertable_id;
+	int64 num_deleted;
+
+	policy_invalidation_log_compaction_read_and_validate_config(config, &hypertable_id);
+	num_deleted = invalidation_hyper_log_compact(hypertable_id);
+
+	elog(DEBUG1,
+		 "job %d merged " INT64_FORMAT " invalidation log entries of hypertable %d",
+		 job_id,
+		 num_deleted,
+		 hypertable_id);
+
+	return true;
+}
+
+void
+policy_vacuum_read_and_validate_config(Jsonb *config, PolicyVacuumData *policy_data)
+{
+	int32 htid = policy_vacuum_get_hypertable_id(config);
+	int32 max_chunks = policy_vacuum_get_max_chunks(config);
+	Oid table_relid = ts_hypertable_id_to_relid(htid);
+	Cache *hcache;
+	Hypertable *hypertable;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("configuration hypertable id %d not found", htid)));
+
+	hypertable = ts_hypertable_cache_get_cache_and_entry(table_relid, CACHE_FLAG_NONE, &hcache);
+	policy_vacuum_validate_hypertable(hypertable);
+
+	if (policy_data)
+	{
+		policy_data->hypertable = hypertable;
+		policy_data->hcache = hcache;
+		policy_data->max_chunks = max_chunks;
+	}
+	else
+		ts_cache_release(hcache);
+}
+
+/*
+ * Chunks with fewer changed rows than this fraction of their rows are left to
+ * autovacuum, e.g., old chunks that get a few late rows.
+ */
+#define VACUUM_POLICY_MIN_CHANGED_FRACTION 0.01
+
+typedef struct VacuumCandidate
+{
+	int32 chunk_id;
+	Oid relid;
+	bool vacuum;
+	bool analyze;
+	bool freeze;
+	/* The rows changed since the last VACUUM or ANALYZE per row of the chunk */
+	double activity;
+} VacuumCandidate;
+
+/*
+ * Check from the table statistics whether a chunk needs VACUUM or ANALYZE.
+ * Rows inserted since the last VACUUM count for VACUUM because they are not
+ * in the visibility map yet, which rules out index-only scans on them.
+ */
+static bool
+vacuum_candidate_set_activity(VacuumCandidate *cand)
+{
+	PgStat_StatTabEntry *tabentry = pgstat_fetch_stat_tabentry(cand->relid);
+	PgStat_Counter changed_since_vacuum;
+	double rows;
+
+	/* Without the table statistics, e.g., with track_counts disabled */
+	if (tabentry == NULL)
+		return false;
+
+	rows = Max(tabentry->n_live_tuples, 1);
+	changed_since_vacuum = tabentry->n_dead_tuples;
+#if PG13_GE
+	changed_since_vacuum += tabentry->inserts_since_vacuum;
+#endif
+
+	cand->vacuum = changed_since_vacuum > 0 &&
+				   changed_since_vacuum >= VACUUM_POLICY_MIN_CHANGED_FRACTION * rows;
+	cand->analyze = tabentry->changes_since_analyze > 0 &&
+					tabentry->changes_since_analyze >= VACUUM_POLICY_MIN_CHANGED_FRACTION * rows;
+	cand->activity = Max(changed_since_vacuum, tabentry->changes_since_analyze) / rows;
+
+	return cand->vacuum || cand->analyze;
+}
+
+/*
+ * Check whether a compressed chunk needs to be frozen. It does if it was not
+ * frozen since it was created by compression, i.e., its relfrozenxid is not
+ * newer than the transaction that created it, or if it changed since its last
+ * VACUUM, e.g., by DML on the compressed data.
+ */
+static bool
+compressed_chunk_needs_freeze(Oid relid)
+{
+	HeapTuple tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+	PgStat_StatTabEntry *tabentry;
+	TransactionId created;
+	TransactionId frozenxid;
+
+	if (!HeapTupleIsValid(tuple))
+		return false;
+
+	created = HeapTupleHeaderGetXmin(tuple->t_data);
+	frozenxid = ((Form_pg_class) GETSTRUCT(tuple))->relfrozenxid;
+	ReleaseSysCache(tuple);
+
+	if (TransactionIdIsNormal(created) && TransactionIdIsNormal(frozenxid) &&
+		TransactionIdPrecedesOrEquals(frozenxid, created))
+		return true;
+
+	tabentry = pgstat_fetch_stat_tabentry(relid);
+
+	return tabentry != NULL && (tabentry->n_dead_tuples > 0 || tabentry->changes_since_analyze > 0);
+}
+
+/*
+ * The chunks with activity go first, the most active first, and then the
+ * compressed chunks to freeze, the newest first.
+ */
+static int
+vacuum_candidate_cmp(const void *a, const void *b)
+{
+	const VacuumCandidate *ca = (const VacuumCandidate *) a;
+	const VacuumCandidate *cb = (const VacuumCandidate *) b;
+
+	if (ca->freeze != cb->freeze)
+		return ca->freeze ? 1 : -1;
+
+	if (ca->activity != cb->activity)
+		return ca->activity < cb->activity ? 1 : -1;
+
+	return (ca->chunk_id < cb->chunk_id) - (ca->chunk_id > cb->chunk_id);
+}
+
+/*
+ * Find the chunks of the hypertable that need VACUUM, ANALYZE or freezing.
+ * Returns the number of candidates in the candidates array.
+ */
+static int
+policy_vacuum_get_candidates(const Hypertable *ht, VacuumCandidate **candidates)
+{
+	List *chunk_ids = ts_chunk_get_chunk_ids_by_hypertable_id(ht->fd.id);
+	VacuumCandidate *cands = palloc0(sizeof(VacuumCandidate) * 2 * list_length(chunk_ids));
+	int num_cands = 0;
+	ListCell *lc;
+
+	foreach (lc, chunk_ids)
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+
+		if (chunk == NULL || chunk->fd.dropped || chunk->relkind != RELKIND_RELATION ||
+			IS_OSM_CHUNK(chunk))
+			continue;
+
+		/*
+		 * Only the uncompressed rows of a partial chunk can change, the rest
+		 * of the uncompressed chunk is empty after compression
+		 */
+		if (!ts_chunk_is_compressed(chunk) || ts_chunk_is_partial(chunk))
+		{
+			VacuumCandidate *cand = &cands[num_cands];
+
+			cand->chunk_id = chunk->fd.id;
+			cand->relid = chunk->table_id;
+			if (vacuum_candidate_set_activity(cand))
+				num_cands++;
+		}
+
+		if (ts_chunk_is_compressed(chunk))
+		{
+			Oid compressed_relid = ts_chunk_get_relid(chunk->fd.compressed_chunk_id, true);
+
+			if (OidIsValid(compressed_relid) && compressed_chunk_needs_freeze(compressed_relid))
+			{
+				VacuumCandidate *cand = &cands[num_cands++];
+
+				cand->chunk_id = chunk->fd.id;
+				cand->relid = compressed_relid;
+				cand->freeze = true;
+			}
+		}
+	}
+
+	if (num_cands > 1)
+		qsort(cands, num_cands, sizeof(VacuumCandidate), vacuum_candidate_cmp);
+
+	*candidates = cands;
+	return num_cands;
+}
+
+/*
+ * Run VACUUM, ANALYZE, or VACUUM (FREEZE, ANALYZE) on a chunk. The ANALYZE of
+ * a frozen compressed chunk resets its changes, so the chunk is skipped by
+ * the next runs until it changes again.
+ */
+static void
+policy_vacuum_chunk(const VacuumCandidate *cand)
+{
+	VacuumRelation vr = {
+		.type = T_VacuumRelation,
+		.relation = NULL,
+		.oid = cand->relid,
+		.va_cols = NIL,
+	};
+	VacuumStmt vs = {
+		.type = T_VacuumStmt,
+		.rels = list_make1(&vr),
+		.is_vacuumcmd = cand->vacuum || cand->freeze,
+		.options = NIL,
+	};
+
+	if (cand->freeze)
+		vs.options = lappend(vs.options, makeDefElem("freeze", NULL, -1));
+
+	if (vs.is_vacuumcmd && (cand->analyze || cand->freeze))
+		vs.options = lappend(vs.options, makeDefElem("analyze", NULL, -1));
+
+	if (vs.is_vacuumcmd)
+	{
+		/* VACUUM runs in its own transactions */
+		ExecVacuum(NULL, &vs, true);
+	}
+	else
+	{
+		/* ANALYZE runs in the current transaction and needs a snapshot */
+		PushActiveSnapshot(GetTransactionSnapshot());
+		ExecVacuum(NULL, &vs, true);
+		PopActiveSnapshot();
+	}
+}
+
+/*
+ * Run VACUUM and ANALYZE on the chunks of a hypertable by their activity.
+ *
+ * Autovacuum picks tables by thresholds relative to their size, one table at
+ * a time and without regard for the hypertable, so it can be busy with old
+ * chunks while the statistics of the chunk receiving the inserts are stale.
+ * This policy looks at the changes of every chunk since its last VACUUM and
+ * ANALYZE, from the table statistics, and processes the chunks with the
+ * largest share of changed rows first. The compressed chunks are frozen once
+ * after compression, so that autovacuum does not have to rewrite them for
+ * wraparound later, and are skipped while they do not change. At most
+ * max_chunks chunks are processed per run, each in its own transaction.
+ */
+bool
+policy_vacuum_execute(int32 job_id, Jsonb *config)
+{
+	PolicyVacuumData policy_data;
+	VacuumCandidate *candidates;
+	MemoryContext saved_cxt, multitxn_cxt;
+	bool used_portalcxt = false;
+	int num_candidates;
+	int num_processed = 0;
+
+	policy_vacuum_read_and_validate_config(config, &policy_data);
+
+	/* the candidates are kept across the transactions, see policy_recompression_execute() */
+	if (PortalContext)
+	{
+		multitxn_cxt = PortalContext;
+		used_portalcxt = true;
+	}
+	else
+		multitxn_cxt =
+			AllocSetContextCreate(TopMemoryContext, "VacuumJobCxt", ALLOCSET_DEFAULT_SIZES);
+
+	saved_cxt = MemoryContextSwitchTo(multitxn_cxt);
+	num_candidates = policy_vacuum_get_candidates(policy_data.hypertable, &candidates);
+	MemoryContextSwitchTo(saved_cxt);
+
+	ts_cache_release(policy_data.hcache);
+
+	if (ActiveSnapshotSet())
+		PopActiveSnapshot();
+
+	for (int i = 0; i < num_candidates && num_processed < policy_data.max_chunks; i++)
+	{
+		const VacuumCandidate *cand = &candidates[i];
+		const char *command;
+		char *relname;
+
+		CommitTransactionCommand();
+		StartTransactionCommand();
+
+		/* the chunk was dropped in the meantime */
+		relname = get_rel_name(cand->relid);
+		if (relname == NULL)
+			continue;
+
+		if (cand->freeze)
+			command = "VACUUM (FREEZE, ANALYZE)";
+		else if (cand->vacuum)
+			command = cand->analyze ? "VACUUM (ANALYZE)" : "VACUUM";
+		else
+			command = "ANALYZE";
+
+		elog(DEBUG1, "job %d running %s on \"%s\"", job_id, command, relname);
+
+		policy_vacuum_chunk(cand);
+		num_processed++;
+	}
+
+	elog(DEBUG1,
+		 "job %d processed %d of %d chunks that need maintenance",
+		 job_id,
+		 num_processed,
+		 num_candidates);
+
+	if (!used_portalcxt)
+		MemoryContextDelete(multitxn_cxt);
+
+	return true;
+}
+
 static void
 job_execute_function(FuncExpr *funcexpr)
 {
@@ -643,6 +1291,8 @@ job_execute(BgwJob *job)
 					 quote_identifier(NameStr(job->fd.proc_name)));
 	pgstat_report_activity(STATE_RUNNING, query->data);
 
+	ts_job_history_start();
+
 	switch (prokind)
 	{
 		case PROKIND_FUNCTION:
@@ -657,6 +1307,9 @@ job_execute(BgwJob *job)
 			break;
 	}
 
+	/* A procedure may have committed, but it always returns in a transaction */
+	ts_job_history_finish(job->fd.id);
+
 	/* Drop portal if it was created */
 	if (portal_created)
 	{
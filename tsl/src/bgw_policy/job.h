@@ -37,6 +37,20 @@ typedef struct PolicyContinuousAggData
 	ContinuousAgg *cagg;
 } PolicyContinuousAggData;
 
+typedef struct PolicyChunkPrecreationData
+{
+	Hypertable *hypertable;
+	Cache *hcache;
+	int32 chunks_ahead;
+} PolicyChunkPrecreationData;
+
+typedef struct PolicyVacuumData
+{
+	Hypertable *hypertable;
+	Cache *hcache;
+	int32 max_chunks;
+} PolicyVacuumData;
+
 typedef struct PolicyCompressionData
 {
 	Hypertable *hypertable;
@@ -51,7 +65,12 @@ typedef void (*reorder_func)(Oid tableOid, Oid indexOid, bool verbose, Oid wait_
 extern bool policy_reorder_execute(int32 job_id, Jsonb *config);
 extern bool policy_retention_execute(int32 job_id, Jsonb *config);
 extern bool policy_refresh_cagg_execute(int32 job_id, Jsonb *config);
+extern bool policy_refresh_cagg_window_execute(int32 job_id, Jsonb *config);
 extern bool policy_recompression_execute(int32 job_id, Jsonb *config);
+extern bool policy_chunk_precreation_execute(int32 job_id, Jsonb *config);
+extern bool policy_distributed_stats_execute(int32 job_id, Jsonb *config);
+extern bool policy_invalidation_log_compaction_execute(int32 job_id, Jsonb *config);
+extern bool policy_vacuum_execute(int32 job_id, Jsonb *config);
 extern void policy_reorder_read_and_validate_config(Jsonb *config, PolicyReorderData *policy_data);
 extern void policy_retention_read_and_validate_config(Jsonb *config,
 													  PolicyRetentionData *policy_data);
@@ -61,6 +80,12 @@ extern void policy_compression_read_and_validate_config(Jsonb *config,
 														PolicyCompressionData *policy_data);
 extern void policy_recompression_read_and_validate_config(Jsonb *config,
 														  PolicyCompressionData *policy_data);
+extern void policy_chunk_precreation_read_and_validate_config(Jsonb *config,
+															  PolicyChunkPrecreationData *policy);
+extern void policy_distributed_stats_read_and_validate_config(Jsonb *config, Oid *table_relid);
+extern void policy_invalidation_log_compaction_read_and_validate_config(Jsonb *config,
+																	 int32 *hypertable_id);
+extern void policy_vacuum_read_and_validate_config(Jsonb *config, PolicyVacuumData *policy_data);
 extern bool job_execute(BgwJob *job);
 
 #endif /* TIMESCALEDB_TSL_BGW_POLICY_JOB_H */
@@ -18,6 +18,7 @@
 
 #include "job.h"
 #include "job_api.h"
+#include "jsonb_utils.h"
 #include "hypertable_cache.h"
 #include "bgw/timer.h"
 #include "debug_assert.h"
@@ -481,3 +482,105 @@ job_alter_set_hypertable_id(PG_FUNCTION_ARGS)
 		ts_cache_release(hcache);
 	PG_RETURN_INT32(job_id);
 }
+
+static bool
+jsonb_key_equals(const JsonbValue *key, const char *name)
+{
+	return key->val.string.len == strlen(name) &&
+		   strncmp(key->val.string.val, name, key->val.string.len) == 0;
+}
+
+/*
+ * Copy the job config without the concurrency class keys and add the new
+ * concurrency class, if any.
+ */
+static Jsonb *
+job_config_set_concurrency_class(Jsonb *config, const char *concurrency_class,
+								 int32 max_concurrency)
+{
+	JsonbParseState *parse_state = NULL;
+	JsonbValue *result;
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+
+	if (config != NULL)
+	{
+		JsonbIterator *it;
+		JsonbIteratorToken token;
+		JsonbValue key;
+		JsonbValue value;
+
+		if (!JB_ROOT_IS_OBJECT(config))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("job config must be an object to set a concurrency class")));
+
+		it = JsonbIteratorInit(&config->root);
+
+		while ((token = JsonbIteratorNext(&it, &key, true)) != WJB_DONE)
+		{
+			if (token != WJB_KEY)
+				continue;
+
+			token = JsonbIteratorNext(&it, &value, true);
+			Assert(token == WJB_VALUE);
+
+			if (jsonb_key_equals(&key, BGW_JOB_CONFIG_CONCURRENCY_CLASS) ||
+				jsonb_key_equals(&key, BGW_JOB_CONFIG_MAX_CONCURRENCY))
+				continue;
+
+			pushJsonbValue(&parse_state, WJB_KEY, &key);
+			pushJsonbValue(&parse_state, WJB_VALUE, &value);
+		}
+	}
+
+	if (concurrency_class != NULL)
+	{
+		ts_jsonb_add_str(parse_state, BGW_JOB_CONFIG_CONCURRENCY_CLASS, concurrency_class);
+		ts_jsonb_add_int32(parse_state, BGW_JOB_CONFIG_MAX_CONCURRENCY, max_concurrency);
+	}
+
+	result = pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL);
+
+	return JsonbValueToJsonb(result);
+}
+
+/*
+ * CREATE OR REPLACE FUNCTION set_job_concurrency_class(
+ * 0    job_id INTEGER,
+ * 1    concurrency_class NAME,
+ * 2    max_concurrency INTEGER = 1
+ * ) RETURNS VOID
+ *
+ * Jobs in the same concurrency class share the limit on the number of jobs
+ * of the class that the scheduler runs at a time, so that, e.g., policies
+ * that are all due at the top of the hour are spread out instead of all
+ * competing for I/O. Each job carries the limit in its config, and the limit
+ * of the job about to be started applies.
+ */
+Datum
+job_set_concurrency_class(PG_FUNCTION_ARGS)
+{
+	int32 job_id = PG_GETARG_INT32(0);
+	Name concurrency_class = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	BgwJob *job;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (concurrency_class != NULL && (PG_ARGISNULL(2) || PG_GETARG_INT32(2) < 1))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("max_concurrency must be at least 1")));
+
+	job = find_job(job_id, PG_ARGISNULL(0), false /* missing_ok */);
+	ts_bgw_job_permission_check(job);
+
+	job->fd.config = job_config_set_concurrency_class(job->fd.config,
+													  concurrency_class != NULL ?
+														  NameStr(*concurrency_class) :
+														  NULL,
+													  PG_ARGISNULL(2) ? 0 : PG_GETARG_INT32(2));
+	ts_bgw_job_update_by_id(job_id, job);
+
+	PG_RETURN_VOID();
+}
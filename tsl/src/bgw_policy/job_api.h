@@ -14,5 +14,6 @@ extern Datum job_alter(PG_FUNCTION_ARGS);
 extern Datum job_delete(PG_FUNCTION_ARGS);
 extern Datum job_run(PG_FUNCTION_ARGS);
 extern Datum job_alter_set_hypertable_id(PG_FUNCTION_ARGS);
+extern Datum job_set_concurrency_class(PG_FUNCTION_ARGS);
 
 #endif /* TSL_BGW_POLICY_JOB_API_H */
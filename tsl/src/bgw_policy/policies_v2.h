@@ -17,6 +17,12 @@
 #define POL_REFRESH_CONF_KEY_MAT_HYPERTABLE_ID "mat_hypertable_id"
 #define POL_REFRESH_CONF_KEY_START_OFFSET "start_offset"
 #define POL_REFRESH_CONF_KEY_END_OFFSET "end_offset"
+#define POL_REFRESH_CONF_KEY_BUCKETS_PER_BATCH "buckets_per_batch"
+#define POL_REFRESH_CONF_KEY_MAX_BATCHES_PER_EXECUTION "max_batches_per_execution"
+
+#define POLICY_REFRESH_CAGG_WINDOW_PROC_NAME "policy_refresh_continuous_aggregate_window"
+#define POL_REFRESH_WINDOW_CONF_KEY_WINDOW_START "window_start"
+#define POL_REFRESH_WINDOW_CONF_KEY_WINDOW_END "window_end"
 
 #define POLICY_COMPRESSION_PROC_NAME "policy_compression"
 #define POLICY_COMPRESSION_CHECK_NAME "policy_compression_check"
@@ -24,6 +30,10 @@
 #define POL_COMPRESSION_CONF_KEY_COMPRESS_AFTER "compress_after"
 #define POL_COMPRESSION_CONF_KEY_MAXCHUNKS_TO_COMPRESS "maxchunks_to_compress"
 
+#define POLICY_COMPRESSION_BATCH_PROC_NAME "policy_compression_batch"
+#define POLICY_COMPRESSION_BATCH_CHECK_NAME "policy_compression_batch_check"
+#define POL_COMPRESSION_BATCH_CONF_KEY_TIME_BUDGET "time_budget"
+
 #define POLICY_RECOMPRESSION_PROC_NAME "policy_recompression"
 #define POL_RECOMPRESSION_CONF_KEY_RECOMPRESS_AFTER "recompress_after"
 
@@ -0,0 +1,309 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include <postgres.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+
+#include <hypertable_cache.h>
+#include <jsonb_utils.h>
+
+#include "bgw/job.h"
+#include "bgw/job_stat.h"
+#include "bgw/timer.h"
+#include "bgw_policy/vacuum_api.h"
+#include "bgw_policy/job.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "utils.h"
+
+/*
+ * The vacuum policy runs VACUUM and ANALYZE on the chunks of a hypertable in
+ * the order of their activity, so that the chunk receiving the inserts gets
+ * fresh statistics and an up-to-date visibility map before autovacuum, which
+ * treats every chunk as an unrelated table, gets to it. It also freezes
+ * every compressed chunk once after compression. See
+ * policy_vacuum_execute() for how the chunks are picked.
+ */
+#define DEFAULT_SCHEDULE_INTERVAL                                                                  \
+	{                                                                                              \
+		.time = 30 * USECS_PER_MINUTE                                                              \
+	}
+
+/* No max runtime by default, VACUUM of a large chunk can take long */
+#define DEFAULT_MAX_RUNTIME                                                                        \
+	{                                                                                              \
+		.time = 0                                                                                  \
+	}
+/* There is an infinite number of retries for vacuum jobs */
+#define DEFAULT_MAX_RETRIES (-1)
+/* Default retry period for vacuum jobs is 5 minutes */
+#define DEFAULT_RETRY_PERIOD                                                                       \
+	{                                                                                              \
+		.time = 5 * USECS_PER_MINUTE                                                               \
+	}
+
+#define CONFIG_KEY_HYPERTABLE_ID "hypertable_id"
+#define CONFIG_KEY_MAX_CHUNKS "max_chunks"
+
+#define POLICY_VACUUM_PROC_NAME "policy_vacuum"
+#define POLICY_VACUUM_CHECK_NAME "policy_vacuum_check"
+
+int32
+policy_vacuum_get_hypertable_id(const Jsonb *config)
+{
+	bool found;
+	int32 hypertable_id = ts_jsonb_get_int32_field(config, CONFIG_KEY_HYPERTABLE_ID, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find hypertable_id in config for job")));
+
+	return hypertable_id;
+}
+
+int32
+policy_vacuum_get_max_chunks(const Jsonb *config)
+{
+	bool found;
+	int32 max_chunks = ts_jsonb_get_int32_field(config, CONFIG_KEY_MAX_CHUNKS, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find max_chunks in config for job")));
+
+	if (max_chunks <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of chunks to vacuum: %d", max_chunks),
+				 errhint("The number of chunks to vacuum must be greater than 0.")));
+
+	return max_chunks;
+}
+
+/* The chunks of distributed hypertables are vacuumed on the data nodes */
+void
+policy_vacuum_validate_hypertable(const Hypertable *ht)
+{
+	if (TS_HYPERTABLE_IS_INTERNAL_COMPRESSION_TABLE(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot add vacuum policy to compressed hypertable \"%s\"",
+						get_rel_name(ht->main_table_relid)),
+				 errhint("Please add the policy to the corresponding uncompressed hypertable "
+						 "instead.")));
+
+	if (hypertable_is_distributed(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("vacuum policies not supported on distributed hypertables")));
+}
+
+Datum
+policy_vacuum_check(PG_FUNCTION_ARGS)
+{
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), errmsg("config must not be NULL")));
+	}
+
+	policy_vacuum_read_and_validate_config(PG_GETARG_JSONB_P(0), NULL);
+
+	PG_RETURN_VOID();
+}
+
+Datum
+policy_vacuum_proc(PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2 || PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_VOID();
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	policy_vacuum_execute(PG_GETARG_INT32(0), PG_GETARG_JSONB_P(1));
+
+	PG_RETURN_VOID();
+}
+
+Datum
+policy_vacuum_add(PG_FUNCTION_ARGS)
+{
+	/* behave like a strict function */
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
+		PG_RETURN_NULL();
+
+	NameData application_name;
+	NameData proc_name, proc_schema, check_name, check_schema, owner;
+	int32 job_id;
+	Oid ht_oid = PG_GETARG_OID(0);
+	int32 max_chunks = PG_GETARG_INT32(1);
+	bool if_not_exists = PG_GETARG_BOOL(2);
+	Interval schedule_interval = DEFAULT_SCHEDULE_INTERVAL;
+	Interval max_runtime = DEFAULT_MAX_RUNTIME;
+	Interval retry_period = DEFAULT_RETRY_PERIOD;
+	TimestampTz initial_start = PG_ARGISNULL(4) ? DT_NOBEGIN : PG_GETARG_TIMESTAMPTZ(4);
+	bool fixed_schedule = !PG_ARGISNULL(4);
+	text *timezone = PG_ARGISNULL(5) ? NULL : PG_GETARG_TEXT_PP(5);
+	char *valid_timezone = NULL;
+	Cache *hcache;
+	Hypertable *ht;
+	int32 hypertable_id;
+	Oid owner_id;
+	List *jobs;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (timezone != NULL)
+		valid_timezone = ts_bgw_job_validate_timezone(PG_GETARG_DATUM(5));
+
+	if (!PG_ARGISNULL(3))
+		schedule_interval = *PG_GETARG_INTERVAL_P(3);
+
+	if (max_chunks <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of chunks to vacuum: %d", max_chunks),
+				 errhint("The number of chunks to vacuum must be greater than 0.")));
+
+	ht = ts_hypertable_cache_get_cache_and_entry(ht_oid, CACHE_FLAG_NONE, &hcache);
+	Assert(ht != NULL);
+	hypertable_id = ht->fd.id;
+
+	/* First verify that the hypertable corresponds to a valid table */
+	owner_id = ts_hypertable_permissions_check(ht_oid, GetUserId());
+
+	policy_vacuum_validate_hypertable(ht);
+	ts_cache_release(hcache);
+
+	/* Verify that the hypertable owner can create a background worker */
+	ts_bgw_job_validate_job_owner(owner_id);
+
+	/* Make sure that an existing policy doesn't exist on this hypertable */
+	jobs = ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_VACUUM_PROC_NAME,
+													 INTERNAL_SCHEMA_NAME,
+													 hypertable_id);
+
+	if (jobs != NIL)
+	{
+		BgwJob *existing = linitial(jobs);
+		Assert(list_length(jobs) == 1);
+
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("vacuum policy already exists for hypertable \"%s\"",
+							get_rel_name(ht_oid))));
+
+		if (policy_vacuum_get_max_chunks(existing->fd.config) != max_chunks)
+		{
+			ereport(WARNING,
+					(errmsg("vacuum policy already exists for hypertable \"%s\"",
+							get_rel_name(ht_oid)),
+					 errdetail("A policy already exists with different arguments."),
+					 errhint("Remove the existing policy before adding a new one.")));
+			PG_RETURN_INT32(-1);
+		}
+		/* If all arguments are the same, do nothing */
+		ereport(NOTICE,
+				(errmsg("vacuum policy already exists for hypertable \"%s\", skipping",
+						get_rel_name(ht_oid))));
+		PG_RETURN_INT32(-1);
+	}
+
+	/* if users pass in -infinity for initial_start, then use the current_timestamp instead */
+	if (fixed_schedule)
+	{
+		ts_bgw_job_validate_schedule_interval(&schedule_interval);
+		if (TIMESTAMP_NOT_FINITE(initial_start))
+			initial_start = ts_timer_get_current_timestamp();
+	}
+
+	/* Next, insert a new job into jobs table */
+	namestrcpy(&application_name, "Vacuum Policy");
+	namestrcpy(&proc_name, POLICY_VACUUM_PROC_NAME);
+	namestrcpy(&proc_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&check_name, POLICY_VACUUM_CHECK_NAME);
+	namestrcpy(&check_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&owner, GetUserNameFromId(owner_id, false));
+
+	JsonbParseState *parse_state = NULL;
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+	ts_jsonb_add_int32(parse_state, CONFIG_KEY_HYPERTABLE_ID, hypertable_id);
+	ts_jsonb_add_int32(parse_state, CONFIG_KEY_MAX_CHUNKS, max_chunks);
+	JsonbValue *result = pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL);
+	Jsonb *config = JsonbValueToJsonb(result);
+
+	job_id = ts_bgw_job_insert_relation(&application_name,
+										&schedule_interval,
+										&max_runtime,
+										DEFAULT_MAX_RETRIES,
+										&retry_period,
+										&proc_schema,
+										&proc_name,
+										&check_schema,
+										&check_name,
+										&owner,
+										true,
+										fixed_schedule,
+										hypertable_id,
+										config,
+										initial_start,
+										valid_timezone);
+
+	if (!TIMESTAMP_NOT_FINITE(initial_start))
+		ts_bgw_job_stat_upsert_next_start(job_id, initial_start);
+
+	PG_RETURN_INT32(job_id);
+}
+
+Datum
+policy_vacuum_remove(PG_FUNCTION_ARGS)
+{
+	Oid hypertable_oid = PG_GETARG_OID(0);
+	bool if_exists = PG_GETARG_BOOL(1);
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	ht = ts_hypertable_cache_get_cache_and_entry(hypertable_oid, CACHE_FLAG_NONE, &hcache);
+
+	List *jobs = ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_VACUUM_PROC_NAME,
+														   INTERNAL_SCHEMA_NAME,
+														   ht->fd.id);
+	ts_cache_release(hcache);
+
+	if (jobs == NIL)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("vacuum policy not found for hypertable \"%s\"",
+							get_rel_name(hypertable_oid))));
+		else
+		{
+			ereport(NOTICE,
+					(errmsg("vacuum policy not found for hypertable \"%s\", skipping",
+							get_rel_name(hypertable_oid))));
+			PG_RETURN_VOID();
+		}
+	}
+	Assert(list_length(jobs) == 1);
+	BgwJob *job = linitial(jobs);
+
+	ts_hypertable_permissions_check(hypertable_oid, GetUserId());
+
+	ts_bgw_job_delete_by_id(job->fd.id);
+
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,24 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_TSL_BGW_POLICY_VACUUM_API_H
+#define TIMESCALEDB_TSL_BGW_POLICY_VACUUM_API_H
+
+#include <postgres.h>
+
+#include "hypertable.h"
+
+/* User-facing API functions */
+extern Datum policy_vacuum_add(PG_FUNCTION_ARGS);
+extern Datum policy_vacuum_remove(PG_FUNCTION_ARGS);
+extern Datum policy_vacuum_proc(PG_FUNCTION_ARGS);
+extern Datum policy_vacuum_check(PG_FUNCTION_ARGS);
+
+extern int32 policy_vacuum_get_hypertable_id(const Jsonb *config);
+extern int32 policy_vacuum_get_max_chunks(const Jsonb *config);
+extern void policy_vacuum_validate_hypertable(const Hypertable *ht);
+
+#endif /* TIMESCALEDB_TSL_BGW_POLICY_VACUUM_API_H */
@@ -5,7 +5,10 @@
  */
 
 #include <postgres.h>
+#include <access/heapam.h>
 #include <access/htup_details.h>
+#include <access/tableam.h>
+#include <access/tupconvert.h>
 #include <access/xact.h>
 #include <catalog/pg_foreign_server.h>
 #include <catalog/pg_foreign_table.h>
@@ -42,6 +45,8 @@
 
 #include "chunk.h"
 #include "chunk_api.h"
+#include "compression/api.h"
+#include "compression/compression.h"
 #include "data_node.h"
 #include "deparse.h"
 #include "debug_point.h"
@@ -563,6 +568,477 @@ chunk_unfreeze_chunk(PG_FUNCTION_ARGS)
 	PG_RETURN_BOOL(ret);
 }
 
+static void
+chunk_merge_validate(const Chunk *chunk, ChunkOperation cmd)
+{
+	if (chunk->relkind == RELKIND_FOREIGN_TABLE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("operation not supported on distributed chunk or foreign table \"%s\"",
+						get_rel_name(chunk->table_id))));
+
+	if (chunk->fd.osm_chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("operation not supported on OSM chunk \"%s\"",
+						get_rel_name(chunk->table_id))));
+
+	ts_chunk_validate_chunk_status_for_operation(chunk->table_id, chunk->fd.status, cmd, true);
+}
+
+/*
+ * Merge two chunks that are adjacent along the primary time dimension and
+ * share all other dimension slices. The data of the later chunk is moved into
+ * the earlier chunk, whose time slice is extended to cover both chunks, and
+ * the later chunk is dropped. Returns the merged chunk.
+ *
+ * Both chunks must either be compressed or uncompressed. Since the merge only
+ * appends rows to the earlier chunk, it is cheap enough to be run periodically
+ * from a user-defined action to reduce the number of chunks after lowering the
+ * chunk time interval.
+ */
+Datum
+chunk_merge_chunks(PG_FUNCTION_ARGS)
+{
+	Oid chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Oid merge_chunk_relid = PG_ARGISNULL(1) ? InvalidOid : PG_GETARG_OID(1);
+	Chunk *chunk, *merge_chunk;
+	const Dimension *time_dim;
+	const DimensionSlice *slice, *merge_slice;
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	chunk = ts_chunk_get_by_relid(chunk_relid, true);
+	merge_chunk = ts_chunk_get_by_relid(merge_chunk_relid, true);
+
+	if (chunk->fd.id == merge_chunk->fd.id)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot merge chunk \"%s\" with itself", get_rel_name(chunk_relid))));
+
+	ht = ts_hypertable_cache_get_cache_and_entry(chunk->hypertable_relid, CACHE_FLAG_NONE, &hcache);
+	ts_hypertable_permissions_check(ht->main_table_relid, GetUserId());
+
+	chunk_merge_validate(chunk, CHUNK_INSERT);
+	chunk_merge_validate(merge_chunk, CHUNK_DROP);
+
+	if (ts_chunk_is_compressed(chunk) != ts_chunk_is_compressed(merge_chunk))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("cannot merge compressed and uncompressed chunks"),
+				 errhint("Compress or decompress chunk \"%s\" or \"%s\" before merging.",
+						 get_rel_name(chunk_relid),
+						 get_rel_name(merge_chunk_relid))));
+
+	time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Assert(time_dim != NULL);
+
+	/* Always merge the later chunk into the earlier one */
+	slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube, time_dim->fd.id);
+	merge_slice = ts_hypercube_get_slice_by_dimension_id(merge_chunk->cube, time_dim->fd.id);
+	if (slice != NULL && merge_slice != NULL && slice->fd.range_start > merge_slice->fd.range_start)
+	{
+		Chunk *tmp = chunk;
+		chunk = merge_chunk;
+		merge_chunk = tmp;
+		slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube, time_dim->fd.id);
+		merge_slice = ts_hypercube_get_slice_by_dimension_id(merge_chunk->cube, time_dim->fd.id);
+	}
+
+	/* Check before moving any data, the remaining checks are done by the merge */
+	if (slice != NULL && merge_slice != NULL && slice->fd.range_end != merge_slice->fd.range_start)
+		ereport(ERROR,
+				(errmsg("cannot merge non-adjacent chunks over supplied dimension"),
+				 errhint("chunk 1: \"%s\", chunk 2: \"%s\", dimension ID %d",
+						 get_rel_name(chunk->table_id),
+						 get_rel_name(merge_chunk->table_id),
+						 time_dim->fd.id)));
+
+	if (ts_chunk_is_compressed(chunk))
+		tsl_merge_compressed_chunks(chunk, merge_chunk, time_dim);
+	else
+	{
+		LockRelationOid(chunk->table_id, ExclusiveLock);
+		LockRelationOid(merge_chunk->table_id, ExclusiveLock);
+		copy_chunk_rows(merge_chunk->table_id, chunk->table_id);
+		merge_chunk_relstats(chunk->table_id, merge_chunk->table_id);
+		ts_chunk_merge_on_dimension(chunk, merge_chunk, time_dim->fd.id);
+	}
+
+	ts_cache_release(hcache);
+	PG_RETURN_OID(chunk->table_id);
+}
+
+/*
+ * A chunk is balanced if its slices in the closed dimensions are the slices
+ * that a new chunk would get with the current partitioning of the hypertable.
+ */
+static bool
+chunk_is_balanced(const Hypertable *ht, const Chunk *chunk)
+{
+	int i;
+
+	for (i = 0; i < ht->space->num_dimensions; i++)
+	{
+		const Dimension *dim = &ht->space->dimensions[i];
+		const DimensionSlice *slice;
+		DimensionSlice *expected;
+
+		if (!IS_CLOSED_DIMENSION(dim))
+			continue;
+
+		slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+		if (slice == NULL)
+			return false;
+
+		expected = ts_dimension_calculate_closed_slice(dim, Max(slice->fd.range_start, 0));
+		if (expected->fd.range_start != slice->fd.range_start ||
+			expected->fd.range_end != slice->fd.range_end)
+			return false;
+	}
+
+	return true;
+}
+
+/* Check whether two chunks have the same slices in all open dimensions */
+static bool
+chunk_same_open_slices(const Hypertable *ht, const Chunk *chunk1, const Chunk *chunk2)
+{
+	int i;
+
+	for (i = 0; i < ht->space->num_dimensions; i++)
+	{
+		const Dimension *dim = &ht->space->dimensions[i];
+		const DimensionSlice *slice1, *slice2;
+
+		if (!IS_OPEN_DIMENSION(dim))
+			continue;
+
+		slice1 = ts_hypercube_get_slice_by_dimension_id(chunk1->cube, dim->fd.id);
+		slice2 = ts_hypercube_get_slice_by_dimension_id(chunk2->cube, dim->fd.id);
+		if (slice1 == NULL || slice2 == NULL || slice1->fd.range_start != slice2->fd.range_start ||
+			slice1->fd.range_end != slice2->fd.range_end)
+			return false;
+	}
+
+	return true;
+}
+
+typedef struct RebalanceTarget
+{
+	int32 chunk_id;
+	Relation rel;
+	ResultRelInfo *rri;
+	TupleConversionMap *map;
+	TupleTableSlot *slot;
+	BulkInsertState bistate;
+} RebalanceTarget;
+
+static RebalanceTarget *
+rebalance_target_open(const Chunk *chunk, TupleDesc ht_desc)
+{
+	RebalanceTarget *target = palloc0(sizeof(RebalanceTarget));
+
+	if (ts_chunk_is_compressed(chunk) || ts_chunk_is_frozen((Chunk *) chunk))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("cannot move rows into chunk \"%s\"", get_rel_name(chunk->table_id)),
+				 errdetail("The chunk is compressed or frozen.")));
+
+	target->chunk_id = chunk->fd.id;
+	target->rel = table_open(chunk->table_id, RowExclusiveLock);
+	target->rri = makeNode(ResultRelInfo);
+	InitResultRelInfo(target->rri, target->rel, 1, NULL, 0);
+	ExecOpenIndices(target->rri, false);
+	target->map = convert_tuples_by_name_compat(ht_desc, RelationGetDescr(target->rel), NULL);
+	target->slot = MakeSingleTupleTableSlot(RelationGetDescr(target->rel), &TTSOpsHeapTuple);
+	target->bistate = GetBulkInsertState();
+
+	return target;
+}
+
+static void
+rebalance_target_close(RebalanceTarget *target)
+{
+	ExecDropSingleTupleTableSlot(target->slot);
+	ExecCloseIndices(target->rri);
+	FreeBulkInsertState(target->bistate);
+	if (target->map != NULL)
+		free_conversion_map(target->map);
+	table_close(target->rel, NoLock);
+}
+
+/*
+ * Move the rows of a table that is no longer a chunk to the chunks of the
+ * hypertable, creating the chunks as needed. Like copy_chunk_rows(), this
+ * maintains the indexes of the target chunks but does not fire triggers since
+ * the rows already are in the hypertable.
+ */
+static int64
+rebalance_chunk_rows(const Hypertable *ht, Oid src_relid)
+{
+	Relation src_rel = table_open(src_relid, AccessShareLock);
+	Relation ht_rel = table_open(ht->main_table_relid, AccessShareLock);
+	TupleDesc ht_desc = RelationGetDescr(ht_rel);
+	TupleConversionMap *map =
+		convert_tuples_by_name_compat(RelationGetDescr(src_rel), ht_desc, NULL);
+	TupleTableSlot *src_slot = table_slot_create(src_rel, NULL);
+	TupleTableSlot *ht_slot = MakeSingleTupleTableSlot(ht_desc, &TTSOpsHeapTuple);
+	CommandId mycid = GetCurrentCommandId(true);
+	Snapshot snapshot = RegisterSnapshot(GetLatestSnapshot());
+	EState *estate = CreateExecutorState();
+	RebalanceTarget *target = NULL;
+	List *targets = NIL;
+	TableScanDesc scan;
+	ListCell *lc;
+	int64 nrows = 0;
+
+	scan = table_beginscan(src_rel, snapshot, 0, NULL);
+
+	while (table_scan_getnextslot(scan, ForwardScanDirection, src_slot))
+	{
+		bool should_free;
+		HeapTuple tuple = ExecFetchSlotHeapTuple(src_slot, false, &should_free);
+		HeapTuple ht_tuple = map != NULL ? execute_attr_map_tuple(tuple, map) : tuple;
+		HeapTuple new_tuple;
+		MemoryContext old_context;
+		Point *point;
+		Chunk *chunk;
+		List *recheck_indexes;
+
+		ExecStoreHeapTuple(ht_tuple, ht_slot, false);
+
+		/* The chunk search functions may leak memory */
+		old_context = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+		point = ts_hyperspace_calculate_point(ht->space, ht_slot);
+
+		chunk = ts_hypertable_find_chunk_for_point(ht, point);
+		if (chunk == NULL)
+		{
+			bool found;
+
+			chunk = ts_hypertable_create_chunk_for_point(ht, point, &found);
+		}
+		MemoryContextSwitchTo(old_context);
+
+		/* Rows of the same chunk are mostly consecutive */
+		if (target == NULL || target->chunk_id != chunk->fd.id)
+		{
+			target = NULL;
+			foreach (lc, targets)
+			{
+				RebalanceTarget *t = lfirst(lc);
+
+				if (t->chunk_id == chunk->fd.id)
+					target = t;
+			}
+
+			if (target == NULL)
+			{
+				target = rebalance_target_open(chunk, ht_desc);
+				targets = lappend(targets, target);
+			}
+		}
+
+		new_tuple = target->map != NULL ? execute_attr_map_tuple(ht_tuple, target->map) : ht_tuple;
+		heap_insert(target->rel, new_tuple, mycid, 0 /*=options*/, target->bistate);
+
+		ExecStoreHeapTuple(new_tuple, target->slot, false);
+#if PG14_LT
+		estate->es_result_relation_info = target->rri;
+#endif
+		recheck_indexes =
+			ExecInsertIndexTuplesCompat(target->rri, target->slot, estate, false, false, NULL, NIL);
+		list_free(recheck_indexes);
+		ExecClearTuple(target->slot);
+		ExecClearTuple(ht_slot);
+		ResetPerTupleExprContext(estate);
+
+		if (new_tuple != ht_tuple)
+			heap_freetuple(new_tuple);
+		if (ht_tuple != tuple)
+			heap_freetuple(ht_tuple);
+		if (should_free)
+			heap_freetuple(tuple);
+
+		nrows++;
+	}
+
+	table_endscan(scan);
+	foreach (lc, targets)
+		rebalance_target_close(lfirst(lc));
+	ExecDropSingleTupleTableSlot(src_slot);
+	ExecDropSingleTupleTableSlot(ht_slot);
+	FreeExecutorState(estate);
+	UnregisterSnapshot(snapshot);
+	if (map != NULL)
+		free_conversion_map(map);
+	CommandCounterIncrement();
+
+	table_close(ht_rel, NoLock);
+	table_close(src_rel, NoLock);
+
+	return nrows;
+}
+
+/*
+ * Rebalance the chunks of one time slice: the chunks are removed from the
+ * catalog, so that the rows are routed to chunks with the current space
+ * partitioning, which splits or merges the chunks as needed. The old tables
+ * are dropped after their rows are moved.
+ */
+static void
+rebalance_chunk_group(Oid hypertable_relid, List *chunks)
+{
+	List *relids = NIL;
+	Hypertable *ht;
+	Cache *hcache;
+	ListCell *lc;
+
+	foreach (lc, chunks)
+	{
+		Chunk *chunk = lfirst(lc);
+
+		/* Lock up front since the table is dropped at the end */
+		LockRelationOid(chunk->table_id, AccessExclusiveLock);
+		ts_chunk_delete_by_name(NameStr(chunk->fd.schema_name),
+								NameStr(chunk->fd.table_name),
+								DROP_RESTRICT);
+		relids = lappend_oid(relids, chunk->table_id);
+	}
+
+	/* Get the hypertable again, the chunks in its chunk cache are gone */
+	ht = ts_hypertable_cache_get_cache_and_entry(hypertable_relid, CACHE_FLAG_NONE, &hcache);
+
+	foreach (lc, relids)
+	{
+		ObjectAddress objaddr = {
+			.classId = RelationRelationId,
+			.objectId = lfirst_oid(lc),
+		};
+		int64 nrows = rebalance_chunk_rows(ht, objaddr.objectId);
+
+		elog(DEBUG1,
+			 "moved " INT64_FORMAT " rows of \"%s\"",
+			 nrows,
+			 get_rel_name(objaddr.objectId));
+		performDeletion(&objaddr, DROP_RESTRICT, 0);
+	}
+
+	ts_cache_release(hcache);
+}
+
+/*
+ * Rebalance the chunks of a hypertable after the number of partitions of a
+ * space dimension was changed with set_number_partitions(). That only affects
+ * new chunks, so the rows of the existing chunks are moved to chunks with the
+ * current partitioning, splitting or merging the existing chunks.
+ *
+ * The chunks of a time slice are rebalanced together, in the order the chunks
+ * were created, with at most max_time_slices time slices per call. The
+ * rebalanced chunks are locked until the end of the transaction, so the
+ * function should be called repeatedly with a small max_time_slices, e.g.,
+ * from a user-defined action, to rebalance a large hypertable in short
+ * transactions. Time slices with compressed, frozen or OSM chunks are skipped.
+ *
+ * Returns the number of rebalanced chunks.
+ */
+Datum
+chunk_rebalance_chunks(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	int32 max_time_slices = PG_ARGISNULL(1) ? -1 : PG_GETARG_INT32(1);
+	List *chunks = NIL;
+	List *chunk_ids;
+	Hypertable *ht;
+	Cache *hcache;
+	ListCell *lc;
+	int num_slices = 0;
+	int count = 0;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (!OidIsValid(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg("hypertable cannot be NULL")));
+
+	ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+	ts_hypertable_permissions_check(ht->main_table_relid, GetUserId());
+
+	if (hypertable_is_distributed(ht))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("rebalancing chunks is not supported on distributed hypertables")));
+
+	if (hyperspace_get_closed_dimension(ht->space, 0) == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("hypertable \"%s\" has no space dimension", get_rel_name(relid))));
+
+	chunk_ids = ts_chunk_get_chunk_ids_by_hypertable_id(ht->fd.id);
+	chunk_ids = list_sort_compat(chunk_ids, list_int_cmp_compat);
+	foreach (lc, chunk_ids)
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+
+		if (chunk != NULL && !chunk->fd.dropped)
+			chunks = lappend(chunks, chunk);
+	}
+
+	while (chunks != NIL && (max_time_slices < 0 || num_slices < max_time_slices))
+	{
+		Chunk *chunk = NULL;
+		List *group = NIL;
+		List *remaining = NIL;
+		bool skip = false;
+
+		foreach (lc, chunks)
+		{
+			if (!chunk_is_balanced(ht, lfirst(lc)))
+			{
+				chunk = lfirst(lc);
+				break;
+			}
+		}
+
+		if (chunk == NULL)
+			break;
+
+		foreach (lc, chunks)
+		{
+			Chunk *other = lfirst(lc);
+
+			if (chunk_same_open_slices(ht, chunk, other))
+			{
+				group = lappend(group, other);
+				skip = skip || other->fd.osm_chunk || ts_chunk_is_compressed(other) ||
+					   ts_chunk_is_frozen(other);
+			}
+			else
+				remaining = lappend(remaining, other);
+		}
+		chunks = remaining;
+
+		if (skip)
+		{
+			ereport(NOTICE,
+					(errmsg("skipping rebalancing of chunk \"%s\"", get_rel_name(chunk->table_id)),
+					 errdetail("The time slice of the chunk has compressed, frozen or OSM "
+							   "chunks.")));
+			continue;
+		}
+
+		rebalance_chunk_group(ht->main_table_relid, group);
+		count += list_length(group);
+		num_slices++;
+	}
+
+	ts_cache_release(hcache);
+	PG_RETURN_INT32(count);
+}
+
 static List *
 chunk_id_list_create(ArrayType *array)
 {
@@ -45,12 +45,16 @@
 #include "chunk_copy.h"
 #include "data_node.h"
 #include "debug_point.h"
+#include "guc.h"
+#include "remote/async.h"
+#include "remote/connection.h"
 #include "remote/dist_commands.h"
 #include "dist_util.h"
 
 #define CCS_INIT "init"
 #define CCS_CREATE_EMPTY_CHUNK "create_empty_chunk"
 #define CCS_CREATE_EMPTY_COMPRESSED_CHUNK "create_empty_compressed_chunk"
+#define CCS_COPY_DATA "copy_data"
 #define CCS_CREATE_PUBLICATION "create_publication"
 #define CCS_CREATE_REPLICATION_SLOT "create_replication_slot"
 #define CCS_CREATE_SUBSCRIPTION "create_subscription"
@@ -73,6 +77,8 @@ struct ChunkCopyStage
 	const char *name;
 	chunk_copy_stage_func function;
 	chunk_copy_stage_func function_cleanup;
+	/* stage is skipped when the chunk data is streamed */
+	bool logical_replication_only;
 };
 
 /* To track a chunk move or copy activity */
@@ -88,6 +94,8 @@ struct ChunkCopy
 	/* from/to foreign servers */
 	ForeignServer *src_server;
 	ForeignServer *dst_server;
+	/* stream the data with COPY instead of using logical replication */
+	bool streaming;
 	/* temporary memory context */
 	MemoryContext mcxt;
 };
@@ -283,6 +291,7 @@ chunk_copy_setup(ChunkCopy *cc, Oid chunk_relid, const char *src_node, const cha
 	cc->mcxt = mcxt;
 	cc->chunk = ts_chunk_get_by_relid(chunk_relid, true);
 	cc->stage = NULL;
+	cc->streaming = ts_guc_enable_streaming_chunk_copy;
 
 	/* It has to be a foreign table chunk */
 	if (cc->chunk->relkind != RELKIND_FOREIGN_TABLE)
@@ -578,6 +587,134 @@ chunk_copy_stage_create_empty_compressed_chunk_cleanup(ChunkCopy *cc)
 	cc->fd.compressed_chunk_name.data[0] = 0;
 }
 
+/*
+ * Stream the contents of a table on the source data node into the table with
+ * the same name on the destination data node.
+ *
+ * The binary COPY data is relayed through the access node as is, including
+ * the header and trailer sent by the source, so no tuples are decoded
+ * here. Both sides run as part of the stage's distributed transaction, so the
+ * copied data is committed or rolled back together with the stage.
+ */
+static void
+chunk_copy_stream_table(ChunkCopy *cc, const char *schema_name, const char *table_name)
+{
+	TSConnection *src_conn =
+		data_node_get_connection(NameStr(cc->fd.source_node_name), REMOTE_TXN_NO_PREP_STMT, true);
+	TSConnection *dst_conn =
+		data_node_get_connection(NameStr(cc->fd.dest_node_name), REMOTE_TXN_NO_PREP_STMT, true);
+	PGconn *src_pg_conn = remote_connection_get_pg_conn(src_conn);
+	const char *table_name_qualified = quote_qualified_identifier(schema_name, table_name);
+	TSConnectionError err;
+	AsyncRequest *req;
+	PGresult *res;
+	char *volatile buf = NULL;
+	bool success = true;
+
+	req = async_request_send(src_conn,
+							 psprintf("COPY %s TO STDOUT WITH (FORMAT binary)",
+									  table_name_qualified));
+	res = PQgetResult(src_pg_conn);
+
+	if (res == NULL)
+	{
+		remote_connection_get_error(src_conn, &err);
+		remote_connection_error_elog(&err, ERROR);
+	}
+
+	if (PQresultStatus(res) != PGRES_COPY_OUT)
+	{
+		remote_connection_get_result_error(res, &err);
+		remote_connection_error_elog(&err, ERROR);
+	}
+
+	PQclear(res);
+	pfree(req);
+
+	if (!remote_connection_begin_copy(dst_conn,
+									  psprintf("COPY %s FROM STDIN WITH (FORMAT binary)",
+											   table_name_qualified),
+									  false,
+									  &err))
+		remote_connection_error_elog(&err, ERROR);
+
+	PG_TRY();
+	{
+		for (;;)
+		{
+			char *data;
+			int len;
+
+			CHECK_FOR_INTERRUPTS();
+
+			len = PQgetCopyData(src_pg_conn, &data, /* async = */ false);
+			buf = data;
+
+			/* End of data, or an error reported by the final result below */
+			if (len == -1)
+				break;
+
+			if (len == -2)
+				remote_connection_elog(src_conn, ERROR);
+
+			if (!remote_connection_put_copy_data(dst_conn, buf, len, &err))
+				remote_connection_error_elog(&err, ERROR);
+
+			PQfreemem(buf);
+			buf = NULL;
+		}
+	}
+	PG_CATCH();
+	{
+		if (buf != NULL)
+			PQfreemem(buf);
+
+		/* Bring the destination connection out of COPY mode */
+		remote_connection_end_copy(dst_conn, &err);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	/* Read the final result of the COPY on the source data node */
+	while ((res = PQgetResult(src_pg_conn)))
+	{
+		if (success && PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			remote_connection_get_result_error(res, &err);
+			success = false;
+		}
+
+		PQclear(res);
+	}
+
+	remote_connection_set_status(src_conn, CONN_IDLE);
+
+	if (!success)
+	{
+		TSConnectionError dst_err;
+
+		remote_connection_end_copy(dst_conn, &dst_err);
+		remote_connection_error_elog(&err, ERROR);
+	}
+
+	if (!remote_connection_end_copy(dst_conn, &err))
+		remote_connection_error_elog(&err, ERROR);
+}
+
+static void
+chunk_copy_stage_copy_data(ChunkCopy *cc)
+{
+	if (!cc->streaming)
+		return;
+
+	chunk_copy_stream_table(cc,
+							NameStr(cc->chunk->fd.schema_name),
+							NameStr(cc->chunk->fd.table_name));
+
+	if (ts_chunk_is_compressed(cc->chunk))
+		chunk_copy_stream_table(cc, INTERNAL_SCHEMA_NAME, NameStr(cc->fd.compressed_chunk_name));
+}
+
 static void
 chunk_copy_stage_create_publication(ChunkCopy *cc)
 {
@@ -982,6 +1119,14 @@ static const ChunkCopyStage chunk_copy_stages[] = {
 	  chunk_copy_stage_create_empty_compressed_chunk,
 	  chunk_copy_stage_create_empty_compressed_chunk_cleanup },
 
+	/*
+	 * Stream the chunk data, and the compressed chunk data if any, from the
+	 * src_node to the dst_node with binary COPY. Only done in streaming mode,
+	 * which skips the logical replication stages below. Cleanup of the empty
+	 * chunks above removes any copied data.
+	 */
+	{ CCS_COPY_DATA, chunk_copy_stage_copy_data, NULL },
+
 	/*
 	 * Setup logical replication between nodes.
 	 * The corresponding cleanup functions should drop the subscription and
@@ -990,27 +1135,30 @@ static const ChunkCopyStage chunk_copy_stages[] = {
 	 */
 	{ CCS_CREATE_PUBLICATION,
 	  chunk_copy_stage_create_publication,
-	  chunk_copy_stage_create_publication_cleanup },
+	  chunk_copy_stage_create_publication_cleanup,
+	  true },
 	{ CCS_CREATE_REPLICATION_SLOT,
 	  chunk_copy_stage_create_replication_slot,
-	  chunk_copy_stage_create_replication_slot_cleanup },
+	  chunk_copy_stage_create_replication_slot_cleanup,
+	  true },
 	{ CCS_CREATE_SUBSCRIPTION,
 	  chunk_copy_stage_create_subscription,
-	  chunk_copy_stage_create_subscription_cleanup },
+	  chunk_copy_stage_create_subscription_cleanup,
+	  true },
 
 	/*
 	 * Begin data transfer and wait for completion.
 	 * The corresponding cleanup function should just disable the subscription so
 	 * that earlier steps above can drop the subcription/publication cleanly.
 	 */
-	{ CCS_SYNC_START, chunk_copy_stage_sync_start, chunk_copy_stage_sync_start_cleanup },
-	{ CCS_SYNC, chunk_copy_stage_sync, NULL },
+	{ CCS_SYNC_START, chunk_copy_stage_sync_start, chunk_copy_stage_sync_start_cleanup, true },
+	{ CCS_SYNC, chunk_copy_stage_sync, NULL, true },
 
 	/*
 	 * Cleanup. Nothing else required via the cleanup functions.
 	 */
-	{ CCS_DROP_SUBSCRIPTION, chunk_copy_stage_drop_subscription, NULL },
-	{ CCS_DROP_PUBLICATION, chunk_copy_stage_drop_publication, NULL },
+	{ CCS_DROP_SUBSCRIPTION, chunk_copy_stage_drop_subscription, NULL, true },
+	{ CCS_DROP_PUBLICATION, chunk_copy_stage_drop_publication, NULL, true },
 
 	/*
 	 * Attach chunk to the hypertable on the dst_node.
@@ -1054,6 +1202,9 @@ chunk_copy_execute(ChunkCopy *cc)
 		Oid saved_uid;
 		bool is_superuser;
 
+		if (cc->streaming && stage->logical_replication_only)
+			continue;
+
 		/*
 		 * A chunk copy/move operation involves a lot of stages. Many of these
 		 * stages need different user permissions.
@@ -8,6 +8,10 @@
  *  compress and decompress chunks
  */
 #include <postgres.h>
+#include <access/genam.h>
+#include <access/stratnum.h>
+#include <access/table.h>
+#include <access/tableam.h>
 #include <access/xact.h>
 #include <catalog/dependency.h>
 #include <commands/tablecmds.h>
@@ -17,26 +21,38 @@
 #include <nodes/pg_list.h>
 #include <nodes/parsenodes.h>
 #include <parser/parse_func.h>
+#include <port/pg_bswap.h>
 #include <storage/lmgr.h>
 #include <trigger.h>
 #include <utils/builtins.h>
 #include <utils/elog.h>
 #include <utils/fmgrprotos.h>
+#include <utils/lsyscache.h>
+#include <utils/snapmgr.h>
+#include <utils/typcache.h>
 #include <libpq-fe.h>
 
+#include <remote/connection.h>
 #include <remote/dist_commands.h>
 #include "compat/compat.h"
+#include "bgw/job_history.h"
 #include "cache.h"
 #include "chunk.h"
+#include "chunk_prewarm.h"
+#include "data_node.h"
 #include "debug_point.h"
 #include "errors.h"
 #include "error_utils.h"
 #include "hypercube.h"
 #include "hypertable.h"
 #include "hypertable_cache.h"
+#include "guc.h"
+#include "nodes/chunk_insert_state.h"
 #include "ts_catalog/continuous_agg.h"
 #include "ts_catalog/hypertable_compression.h"
 #include "ts_catalog/compression_chunk_size.h"
+#include "ts_catalog/chunk_column_stats.h"
+#include "ts_catalog/chunk_size_stats.h"
 #include "create.h"
 #include "api.h"
 #include "compression.h"
@@ -178,6 +194,59 @@ compression_chunk_size_catalog_update_merged(int32 chunk_id, const RelationSize
 	return updated;
 }
 
+/* Read the uncompressed sizes and row counts recorded for a compressed chunk */
+static bool
+compression_chunk_size_catalog_fetch(int32 chunk_id, RelationSize *size, int64 *rowcnt_pre,
+									 int64 *rowcnt_post)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(COMPRESSION_CHUNK_SIZE, AccessShareLock, CurrentMemoryContext);
+	bool found = false;
+
+	iterator.ctx.index =
+		catalog_get_index(ts_catalog_get(), COMPRESSION_CHUNK_SIZE, COMPRESSION_CHUNK_SIZE_PKEY);
+	ts_scan_iterator_scan_key_init(&iterator,
+								   Anum_compression_chunk_size_pkey_chunk_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(chunk_id));
+	ts_scanner_foreach(&iterator)
+	{
+		Datum values[Natts_compression_chunk_size];
+		bool isnull[Natts_compression_chunk_size];
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool should_free;
+		HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+
+		heap_deform_tuple(tuple, ts_scanner_get_tupledesc(ti), values, isnull);
+		size->heap_size = DatumGetInt64(
+			values[AttrNumberGetAttrOffset(Anum_compression_chunk_size_uncompressed_heap_size)]);
+		size->toast_size = DatumGetInt64(
+			values[AttrNumberGetAttrOffset(Anum_compression_chunk_size_uncompressed_toast_size)]);
+		size->index_size = DatumGetInt64(
+			values[AttrNumberGetAttrOffset(Anum_compression_chunk_size_uncompressed_index_size)]);
+		*rowcnt_pre = isnull[AttrNumberGetAttrOffset(
+						  Anum_compression_chunk_size_numrows_pre_compression)] ?
+						  0 :
+						  DatumGetInt64(values[AttrNumberGetAttrOffset(
+							  Anum_compression_chunk_size_numrows_pre_compression)]);
+		*rowcnt_post = isnull[AttrNumberGetAttrOffset(
+						   Anum_compression_chunk_size_numrows_post_compression)] ?
+						   0 :
+						   DatumGetInt64(values[AttrNumberGetAttrOffset(
+							   Anum_compression_chunk_size_numrows_post_compression)]);
+
+		if (should_free)
+			heap_freetuple(tuple);
+
+		found = true;
+		break;
+	}
+
+	ts_scan_iterator_close(&iterator);
+	return found;
+}
+
 static void
 get_hypertable_or_cagg_name(Hypertable *ht, Name objname)
 {
@@ -444,6 +513,8 @@ compress_chunk_impl(Oid hypertable_relid, Oid chunk_relid)
 	/* get compression properties for hypertable */
 	htcols_list = ts_hypertable_compression_get(cxt.srcht->fd.id);
 	htcols_listlen = list_length(htcols_list);
+	if (ts_guc_enable_compression_sampling)
+		compression_sample_algorithms(cxt.srcht_chunk->table_id, htcols_list);
 	mergable_chunk = find_chunk_to_merge_into(cxt.srcht, cxt.srcht_chunk);
 	if (!mergable_chunk)
 	{
@@ -464,6 +535,19 @@ compress_chunk_impl(Oid hypertable_relid, Oid chunk_relid)
 		FormData_hypertable_compression *fd = (FormData_hypertable_compression *) lfirst(lc);
 		colinfo_array[i++] = fd;
 	}
+
+	/* The ranges of the tracked columns are taken from the rows before they are compressed */
+	if (new_compressed_chunk)
+		ts_chunk_column_stats_calculate(cxt.srcht,
+										cxt.srcht_chunk->table_id,
+										cxt.srcht_chunk->fd.id,
+										false);
+	else
+		ts_chunk_column_stats_calculate(cxt.srcht,
+										cxt.srcht_chunk->table_id,
+										mergable_chunk->fd.id,
+										true);
+
 	before_size = ts_relation_size_impl(cxt.srcht_chunk->table_id);
 	cstat = compress_chunk(cxt.srcht_chunk->table_id,
 						   compress_ht_chunk->table_id,
@@ -476,6 +560,8 @@ compress_chunk_impl(Oid hypertable_relid, Oid chunk_relid)
 	 */
 	ts_chunk_drop_fks(cxt.srcht_chunk);
 	after_size = ts_relation_size_impl(compress_ht_chunk->table_id);
+	ts_job_history_add_chunks(1);
+	ts_job_history_add_rows(cstat.rowcnt_pre_compression);
 
 	if (new_compressed_chunk)
 	{
@@ -497,6 +583,7 @@ compress_chunk_impl(Oid hypertable_relid, Oid chunk_relid)
 									compress_ht_chunk->fd.hypertable_id);
 		ts_trigger_create_all_on_chunk(compress_ht_chunk);
 		ts_chunk_set_compressed_chunk(cxt.srcht_chunk, compress_ht_chunk->fd.id);
+		ts_chunk_size_stats_update(cxt.srcht_chunk->fd.id);
 	}
 	else
 	{
@@ -524,6 +611,8 @@ compress_chunk_impl(Oid hypertable_relid, Oid chunk_relid)
 			ts_chunk_set_unordered(mergable_chunk);
 			tsl_recompress_chunk_wrapper(mergable_chunk);
 		}
+		else
+			ts_chunk_size_stats_update(mergable_chunk->fd.id);
 	}
 
 	ts_cache_release(hcache);
@@ -618,6 +707,7 @@ decompress_chunk_impl(Oid uncompressed_hypertable_relid, Oid uncompressed_chunk_
 												 true);
 
 	decompress_chunk(compressed_chunk->table_id, uncompressed_chunk->table_id);
+	ts_job_history_add_chunks(1);
 
 	/* Recreate FK constraints, since they were dropped during compression. */
 	ts_chunk_create_fks(uncompressed_chunk);
@@ -637,6 +727,8 @@ decompress_chunk_impl(Oid uncompressed_hypertable_relid, Oid uncompressed_chunk_
 	 */
 	LockRelationOid(compressed_chunk->table_id, AccessExclusiveLock);
 	ts_chunk_drop(compressed_chunk, DROP_RESTRICT, -1);
+	ts_chunk_size_stats_update(uncompressed_chunk->fd.id);
+	ts_chunk_prewarm_request(uncompressed_chunk->table_id);
 
 	/* reenable autovacuum if necessary */
 	restore_autovacuum_on_decompress(uncompressed_hypertable_relid, uncompressed_chunk_relid);
@@ -732,6 +824,181 @@ decompress_remote_chunk(FunctionCallInfo fcinfo, const Chunk *chunk, bool if_com
 	return success;
 }
 
+/*
+ * Send all rows of a local table with compressed data to a data node in
+ * binary COPY format.
+ *
+ * The binary format of the compressed columns is the one of
+ * compressed_data_send(), so batches are shipped as they are and are never
+ * decompressed on either side.
+ */
+static void
+copy_compressed_data_to_data_node(Relation rel, TSConnection *conn, const char *remote_table)
+{
+	TupleDesc tupdesc = RelationGetDescr(rel);
+	FmgrInfo *out_functions = palloc0(sizeof(FmgrInfo) * tupdesc->natts);
+	TupleTableSlot *slot = table_slot_create(rel, NULL);
+	TableScanDesc scan;
+	StringInfoData row;
+	TSConnectionError err;
+	int natts = 0;
+
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		Oid out_func_oid;
+		bool isvarlena;
+
+		if (attr->attisdropped)
+			continue;
+
+		getTypeBinaryOutputInfo(attr->atttypid, &out_func_oid, &isvarlena);
+		fmgr_info(out_func_oid, &out_functions[i]);
+		natts++;
+	}
+
+	if (!remote_connection_begin_copy(conn,
+									  psprintf("COPY %s FROM STDIN WITH (FORMAT binary)",
+											   remote_table),
+									  true,
+									  &err))
+		remote_connection_error_elog(&err, ERROR);
+
+	initStringInfo(&row);
+	scan = table_beginscan(rel, GetActiveSnapshot(), 0, NULL);
+
+	PG_TRY();
+	{
+		while (table_scan_getnextslot(scan, ForwardScanDirection, slot))
+		{
+			uint16 buf16 = pg_hton16((uint16) natts);
+
+			CHECK_FOR_INTERRUPTS();
+
+			slot_getallattrs(slot);
+			resetStringInfo(&row);
+			appendBinaryStringInfo(&row, (char *) &buf16, sizeof(buf16));
+
+			for (int i = 0; i < tupdesc->natts; i++)
+			{
+				uint32 buf32;
+
+				if (TupleDescAttr(tupdesc, i)->attisdropped)
+					continue;
+
+				if (slot->tts_isnull[i])
+				{
+					buf32 = pg_hton32((uint32) -1);
+					appendBinaryStringInfo(&row, (char *) &buf32, sizeof(buf32));
+				}
+				else
+				{
+					bytea *outputbytes = SendFunctionCall(&out_functions[i], slot->tts_values[i]);
+					int output_length = VARSIZE(outputbytes) - VARHDRSZ;
+
+					buf32 = pg_hton32((uint32) output_length);
+					appendBinaryStringInfo(&row, (char *) &buf32, sizeof(buf32));
+					appendBinaryStringInfo(&row, VARDATA(outputbytes), output_length);
+					pfree(outputbytes);
+				}
+			}
+
+			if (!remote_connection_put_copy_data(conn, row.data, row.len, &err))
+				remote_connection_error_elog(&err, ERROR);
+		}
+	}
+	PG_CATCH();
+	{
+		/* Bring the connection out of COPY mode */
+		remote_connection_end_copy(conn, &err);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	table_endscan(scan);
+	ExecDropSingleTupleTableSlot(slot);
+
+	if (!remote_connection_end_copy(conn, &err))
+		remote_connection_error_elog(&err, ERROR);
+}
+
+/*
+ * Create compressed chunks on the data nodes of a chunk of a distributed
+ * hypertable from a local table with compressed data.
+ *
+ * On every data node of the chunk, an empty chunk of the compressed
+ * hypertable is created, filled with the compressed batches of the local
+ * table and attached as the compressed chunk. This allows loading data that
+ * was compressed elsewhere without ever materializing it as rows.
+ */
+static void
+create_remote_compressed_chunk(FunctionCallInfo fcinfo, const Chunk *chunk, Oid chunk_table)
+{
+	const char *remote_name = psprintf("compress%s", NameStr(chunk->fd.table_name));
+	const char *remote_table = quote_qualified_identifier(INTERNAL_SCHEMA_NAME, remote_name);
+	const char *chunk_name = quote_qualified_identifier(NameStr(chunk->fd.schema_name),
+														NameStr(chunk->fd.table_name));
+	Relation rel;
+	ListCell *lc;
+	char *create_cmd;
+	char *attach_cmd;
+	Cache *hcache;
+	Hypertable *ht;
+
+	Assert(chunk->relkind == RELKIND_FOREIGN_TABLE);
+
+	if (ts_chunk_is_compressed(chunk))
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_OBJECT),
+				 errmsg("chunk \"%s\" is already compressed", get_rel_name(chunk->table_id))));
+
+	ht = ts_hypertable_cache_get_cache_and_entry(chunk->hypertable_relid, CACHE_FLAG_NONE, &hcache);
+	create_cmd =
+		psprintf("SELECT %s.create_chunk_table(h2.schema_name || '.' || h2.table_name, "
+				 "'{}'::jsonb, %s, %s) "
+				 "FROM _timescaledb_catalog.hypertable h1 "
+				 "JOIN _timescaledb_catalog.hypertable h2 ON (h1.compressed_hypertable_id = h2.id) "
+				 "WHERE h1.schema_name = %s AND h1.table_name = %s",
+				 INTERNAL_SCHEMA_NAME,
+				 quote_literal_cstr(INTERNAL_SCHEMA_NAME),
+				 quote_literal_cstr(remote_name),
+				 quote_literal_cstr(NameStr(ht->fd.schema_name)),
+				 quote_literal_cstr(NameStr(ht->fd.table_name)));
+	ts_cache_release(hcache);
+
+	attach_cmd = psprintf("SELECT %s.create_compressed_chunk(%s, %s, " INT64_FORMAT
+						  ", " INT64_FORMAT ", " INT64_FORMAT ", " INT64_FORMAT
+						  ", " INT64_FORMAT ", " INT64_FORMAT ", " INT64_FORMAT
+						  ", " INT64_FORMAT ")",
+						  INTERNAL_SCHEMA_NAME,
+						  quote_literal_cstr(chunk_name),
+						  quote_literal_cstr(remote_table),
+						  PG_GETARG_INT64(2),
+						  PG_GETARG_INT64(3),
+						  PG_GETARG_INT64(4),
+						  PG_GETARG_INT64(5),
+						  PG_GETARG_INT64(6),
+						  PG_GETARG_INT64(7),
+						  PG_GETARG_INT64(8),
+						  PG_GETARG_INT64(9));
+
+	rel = table_open(chunk_table, AccessShareLock);
+
+	foreach (lc, ts_chunk_get_data_node_name_list(chunk))
+	{
+		char *node_name = lfirst(lc);
+		List *data_node = list_make1(node_name);
+		TSConnection *conn;
+
+		ts_dist_cmd_run_on_data_nodes(create_cmd, data_node, true);
+		conn = data_node_get_connection(node_name, REMOTE_TXN_NO_PREP_STMT, true);
+		copy_compressed_data_to_data_node(rel, conn, remote_table);
+		ts_dist_cmd_run_on_data_nodes(attach_cmd, data_node, true);
+	}
+
+	table_close(rel, NoLock);
+}
+
 /*
  * Create a new compressed chunk using existing table with compressed data.
  *
@@ -762,6 +1029,15 @@ tsl_create_compressed_chunk(PG_FUNCTION_ARGS)
 	TS_PREVENT_FUNC_IF_READ_ONLY();
 
 	chunk = ts_chunk_get_by_relid(chunk_relid, true);
+
+	if (chunk->relkind == RELKIND_FOREIGN_TABLE)
+	{
+		/* chunks of distributed hypertables are foreign tables */
+		create_remote_compressed_chunk(fcinfo, chunk, chunk_table);
+		ts_chunk_set_compressed_chunk(chunk, INVALID_CHUNK_ID);
+		PG_RETURN_OID(chunk_relid);
+	}
+
 	hcache = ts_hypertable_cache_pin();
 	compresschunkcxt_init(&cxt, hcache, chunk->hypertable_relid, chunk_relid);
 
@@ -892,3 +1168,665 @@ tsl_recompress_chunk_wrapper(Chunk *uncompressed_chunk)
 	tsl_compress_chunk_wrapper(chunk, false);
 	return true;
 }
+
+/*
+ * Recompress a partially compressed chunk in place. Only the compressed
+ * batches of the segments that have new rows in the uncompressed chunk are
+ * decompressed and compressed again together with the new rows, the other
+ * batches of the compressed chunk are left as they are.
+ */
+static void
+recompress_chunk_segmentwise_impl(Chunk *uncompressed_chunk)
+{
+	Oid uncompressed_chunk_relid = uncompressed_chunk->table_id;
+	Cache *hcache;
+	Hypertable *uncompressed_hypertable =
+		ts_hypertable_cache_get_cache_and_entry(uncompressed_chunk->hypertable_relid,
+												CACHE_FLAG_NONE,
+												&hcache);
+	Hypertable *compressed_hypertable;
+	Chunk *compressed_chunk;
+	ListCell *lc;
+	List *htcols_list = NIL;
+	const ColumnCompressionInfo **colinfo_array;
+	int i = 0, htcols_listlen;
+	RelationSize before_size, after_size;
+	CompressionStats cstat;
+
+	ts_hypertable_permissions_check(uncompressed_hypertable->main_table_relid, GetUserId());
+
+	compressed_hypertable =
+		ts_hypertable_get_by_id(uncompressed_hypertable->fd.compressed_hypertable_id);
+	if (compressed_hypertable == NULL)
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), errmsg("missing compressed hypertable")));
+
+	compressed_chunk = ts_chunk_get_by_id(uncompressed_chunk->fd.compressed_chunk_id, true);
+
+	/* acquire locks on src and compress hypertable and both chunks */
+	LockRelationOid(uncompressed_hypertable->main_table_relid, AccessShareLock);
+	LockRelationOid(compressed_hypertable->main_table_relid, AccessShareLock);
+	LockRelationOid(uncompressed_chunk->table_id, ExclusiveLock);
+	LockRelationOid(compressed_chunk->table_id, ExclusiveLock);
+
+	/* acquire locks on catalog tables to keep till end of txn */
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), HYPERTABLE_COMPRESSION),
+					AccessShareLock);
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), CHUNK), RowExclusiveLock);
+
+	DEBUG_WAITPOINT("recompress_chunk_segmentwise_start");
+
+	/*
+	 * Re-read the state of the chunk after all locks have been acquired. Another
+	 * process might have recompressed the chunk while we were waiting for the
+	 * locks.
+	 */
+	Chunk *chunk_state_after_lock = ts_chunk_get_by_relid(uncompressed_chunk_relid, true);
+
+	if (!ts_chunk_is_partial(chunk_state_after_lock))
+	{
+		ts_cache_release(hcache);
+		return;
+	}
+
+	/* get compression properties for hypertable */
+	htcols_list = ts_hypertable_compression_get(uncompressed_hypertable->fd.id);
+	htcols_listlen = list_length(htcols_list);
+	/* convert list to array of pointers for compress_chunk */
+	colinfo_array = palloc(sizeof(ColumnCompressionInfo *) * htcols_listlen);
+	foreach (lc, htcols_list)
+	{
+		FormData_hypertable_compression *fd = (FormData_hypertable_compression *) lfirst(lc);
+		colinfo_array[i++] = fd;
+	}
+
+	/* widen the ranges of the tracked columns with the new rows */
+	ts_chunk_column_stats_calculate(uncompressed_hypertable,
+									uncompressed_chunk->table_id,
+									uncompressed_chunk->fd.id,
+									true);
+
+	/* only the new rows add to the uncompressed size of the chunk */
+	before_size = ts_relation_size_impl(uncompressed_chunk->table_id);
+	cstat = recompress_chunk_segmentwise(uncompressed_chunk->table_id,
+										 compressed_chunk->table_id,
+										 colinfo_array,
+										 htcols_listlen);
+	after_size = ts_relation_size_impl(compressed_chunk->table_id);
+	ts_job_history_add_chunks(1);
+	ts_job_history_add_rows(cstat.rowcnt_pre_compression);
+
+	compression_chunk_size_catalog_update_merged(uncompressed_chunk->fd.id,
+												 &before_size,
+												 compressed_chunk->fd.id,
+												 &after_size,
+												 cstat.rowcnt_pre_compression,
+												 cstat.rowcnt_post_compression);
+
+	ts_chunk_clear_partial(chunk_state_after_lock);
+	ts_cache_release(hcache);
+}
+
+/*
+ * Update the compression size and the chunk status after decompressing
+ * batches of a compressed chunk.
+ */
+static bool
+decompress_chunk_batches_finish(Chunk *uncompressed_chunk, Chunk *compressed_chunk,
+								int64 decompressed_rows, int64 deleted_batches)
+{
+	RelationSize before_size = { 0 }, after_size;
+
+	if (deleted_batches == 0)
+		return false;
+
+	/* the decompressed rows no longer count as compressed rows */
+	after_size = ts_relation_size_impl(compressed_chunk->table_id);
+	compression_chunk_size_catalog_update_merged(uncompressed_chunk->fd.id,
+												 &before_size,
+												 compressed_chunk->fd.id,
+												 &after_size,
+												 -decompressed_rows,
+												 -deleted_batches);
+
+	if (!ts_chunk_is_partial(uncompressed_chunk))
+		ts_chunk_set_partial(uncompressed_chunk);
+
+	return true;
+}
+
+/*
+ * Decompress the batches of a compressed chunk that overlap the range
+ * [start, end) of the primary dimension, so that the rows in the range can be
+ * modified in the uncompressed chunk. The chunk is marked partial, so that
+ * the rows are compressed again by the next recompression.
+ *
+ * Returns true if any batch was decompressed.
+ */
+bool
+decompress_chunk_range(Chunk *uncompressed_chunk, int64 start, int64 end)
+{
+	Hypertable *ht = ts_hypertable_get_by_id(uncompressed_chunk->fd.hypertable_id);
+	const Dimension *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Oid time_type = ts_dimension_get_partition_type(time_dim);
+	FormData_hypertable_compression *time_colinfo = NULL;
+	Chunk *compressed_chunk;
+	int64 decompressed_rows, deleted_batches;
+	ListCell *lc;
+
+	Assert(ts_chunk_is_compressed(uncompressed_chunk));
+
+	foreach (lc, ts_hypertable_compression_get(ht->fd.id))
+	{
+		FormData_hypertable_compression *fd = lfirst(lc);
+
+		if (fd->orderby_column_index > 0 &&
+			namestrcmp(&fd->attname, NameStr(time_dim->fd.column_name)) == 0)
+			time_colinfo = fd;
+	}
+
+	if (time_colinfo == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot decompress a range of chunk \"%s\"",
+						get_rel_name(uncompressed_chunk->table_id)),
+				 errdetail("Column \"%s\" is not an order by column of the compression settings.",
+						   NameStr(time_dim->fd.column_name))));
+
+	compressed_chunk = ts_chunk_get_by_id(uncompressed_chunk->fd.compressed_chunk_id, true);
+
+	/* acquire locks on catalog tables to keep till end of txn */
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), HYPERTABLE_COMPRESSION),
+					AccessShareLock);
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), CHUNK), RowExclusiveLock);
+
+	decompressed_rows =
+		decompress_batches_in_range(compressed_chunk->table_id,
+									uncompressed_chunk->table_id,
+									compression_column_segment_min_name(time_colinfo),
+									compression_column_segment_max_name(time_colinfo),
+									time_type,
+									ts_internal_to_time_value(start, time_type),
+									ts_internal_to_time_value(end, time_type),
+									&deleted_batches);
+
+	return decompress_chunk_batches_finish(uncompressed_chunk,
+										   compressed_chunk,
+										   decompressed_rows,
+										   deleted_batches);
+}
+
+/*
+ * Delete the compressed batches of a chunk that only hold values of the
+ * primary dimension before older_than, so that retention does not have to
+ * wait until the whole chunk is older than the cutoff. The batches are found
+ * with the max metadata of the time column and deleted without decompressing
+ * them. Chunks that are not ordered by the time column are left alone.
+ *
+ * Returns the number of deleted batches.
+ */
+int64
+tsl_compressed_chunk_drop_batches(const Hypertable *ht, const Chunk *chunk, int64 older_than)
+{
+	const Dimension *time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	Oid time_type = ts_dimension_get_partition_type(time_dim);
+	FormData_hypertable_compression *time_colinfo = NULL;
+	RelationSize before_size = { 0 }, after_size;
+	Chunk *compressed_chunk;
+	int64 deleted_rows, deleted_batches;
+	ListCell *lc;
+
+	Assert(ts_chunk_is_compressed(chunk));
+
+	foreach (lc, ts_hypertable_compression_get(ht->fd.id))
+	{
+		FormData_hypertable_compression *fd = lfirst(lc);
+
+		if (fd->orderby_column_index > 0 &&
+			namestrcmp(&fd->attname, NameStr(time_dim->fd.column_name)) == 0)
+			time_colinfo = fd;
+	}
+
+	if (time_colinfo == NULL)
+		return 0;
+
+	compressed_chunk = ts_chunk_get_by_id(chunk->fd.compressed_chunk_id, true);
+
+	/* acquire locks on catalog tables to keep till end of txn */
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), HYPERTABLE_COMPRESSION),
+					AccessShareLock);
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), CHUNK), RowExclusiveLock);
+
+	deleted_batches = delete_batches_before(compressed_chunk->table_id,
+											compression_column_segment_max_name(time_colinfo),
+											time_type,
+											ts_internal_to_time_value(older_than, time_type),
+											&deleted_rows);
+
+	if (deleted_batches > 0)
+	{
+		after_size = ts_relation_size_impl(compressed_chunk->table_id);
+		compression_chunk_size_catalog_update_merged(chunk->fd.id,
+													 &before_size,
+													 compressed_chunk->fd.id,
+													 &after_size,
+													 -deleted_rows,
+													 -deleted_batches);
+	}
+
+	return deleted_batches;
+}
+
+/*
+ * Decompress the batches of a compressed chunk that match the scan keys on
+ * the compressed chunk, e.g., on segment by columns or on the min and max
+ * metadata of order by columns. The chunk is marked partial, so that the
+ * rows are compressed again by the next recompression.
+ *
+ * Returns true if any batch was decompressed.
+ */
+bool
+decompress_chunk_batches(Chunk *uncompressed_chunk, Chunk *compressed_chunk, ScanKeyData *scankeys,
+						 int num_scankeys)
+{
+	int64 decompressed_rows, deleted_batches;
+
+	Assert(ts_chunk_is_compressed(uncompressed_chunk));
+	Assert(uncompressed_chunk->fd.compressed_chunk_id == compressed_chunk->fd.id);
+
+	/* acquire locks on catalog tables to keep till end of txn */
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), HYPERTABLE_COMPRESSION),
+					AccessShareLock);
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), CHUNK), RowExclusiveLock);
+
+	decompressed_rows = decompress_batches(compressed_chunk->table_id,
+										   uncompressed_chunk->table_id,
+										   scankeys,
+										   num_scankeys,
+										   &deleted_batches);
+
+	return decompress_chunk_batches_finish(uncompressed_chunk,
+										   compressed_chunk,
+										   decompressed_rows,
+										   deleted_batches);
+}
+
+/*
+ * A key column of a unique index of a compressed chunk, and how to find the
+ * compressed batches that can contain a value of the column: by equality on
+ * a segment by column, or by the min and max metadata of an order by column.
+ * Other columns do not restrict the batches.
+ */
+typedef struct UniqueCheckColumn
+{
+	AttrNumber attno;
+	Oid collation;
+	bool segmentby;
+	AttrNumber compressed_attno;
+	RegProcedure eq_proc;
+	AttrNumber min_attno;
+	RegProcedure le_proc;
+	AttrNumber max_attno;
+	RegProcedure ge_proc;
+} UniqueCheckColumn;
+
+typedef struct UniqueCheckIndex
+{
+	bool nulls_not_distinct;
+	int num_columns;
+	UniqueCheckColumn columns[FLEXIBLE_ARRAY_MEMBER];
+} UniqueCheckIndex;
+
+typedef struct UniqueCheckState
+{
+	Chunk *chunk;
+	Chunk *compressed_chunk;
+	List *indexes;
+} UniqueCheckState;
+
+static RegProcedure
+unique_check_btree_proc(Oid opfamily, Oid type, StrategyNumber strategy)
+{
+	Oid opno = get_opfamily_member(opfamily, type, type, strategy);
+
+	if (!OidIsValid(opno))
+		elog(ERROR, "no btree operator for type %s", format_type_be(type));
+
+	return get_opcode(opno);
+}
+
+static UniqueCheckIndex *
+unique_check_index_create(Relation index_rel, Relation rel, Oid compressed_relid, List *htcols)
+{
+	int nkeys = index_rel->rd_index->indnkeyatts;
+	UniqueCheckIndex *check =
+		palloc0(sizeof(UniqueCheckIndex) + sizeof(UniqueCheckColumn) * Max(nkeys, 1));
+
+#if PG15_GE
+	check->nulls_not_distinct = index_rel->rd_index->indnullsnotdistinct;
+#endif
+
+	for (int i = 0; i < nkeys; i++)
+	{
+		AttrNumber attno = index_rel->rd_index->indkey.values[i];
+		Form_pg_attribute attr;
+		FormData_hypertable_compression *colinfo = NULL;
+		UniqueCheckColumn *col;
+		TypeCacheEntry *tce;
+		ListCell *lc;
+
+		/* expressions do not restrict the batches */
+		if (attno == InvalidAttrNumber)
+			continue;
+
+		attr = TupleDescAttr(RelationGetDescr(rel), AttrNumberGetAttrOffset(attno));
+
+		foreach (lc, htcols)
+		{
+			FormData_hypertable_compression *fd = lfirst(lc);
+
+			if (namestrcmp(&fd->attname, NameStr(attr->attname)) == 0)
+			{
+				colinfo = fd;
+				break;
+			}
+		}
+
+		if (colinfo == NULL ||
+			(colinfo->segmentby_column_index <= 0 && colinfo->orderby_column_index <= 0))
+			continue;
+
+		tce = lookup_type_cache(attr->atttypid, TYPECACHE_BTREE_OPFAMILY);
+		if (!OidIsValid(tce->btree_opf))
+			continue;
+
+		col = &check->columns[check->num_columns++];
+		col->attno = attno;
+		col->collation = attr->attcollation;
+
+		if (colinfo->segmentby_column_index > 0)
+		{
+			col->segmentby = true;
+			col->compressed_attno = get_attnum(compressed_relid, NameStr(attr->attname));
+			col->eq_proc =
+				unique_check_btree_proc(tce->btree_opf, attr->atttypid, BTEqualStrategyNumber);
+
+			if (col->compressed_attno == InvalidAttrNumber)
+				elog(ERROR,
+					 "missing column \"%s\" in compressed chunk \"%s\"",
+					 NameStr(attr->attname),
+					 get_rel_name(compressed_relid));
+		}
+		else
+		{
+			col->min_attno =
+				get_attnum(compressed_relid, compression_column_segment_min_name(colinfo));
+			col->max_attno =
+				get_attnum(compressed_relid, compression_column_segment_max_name(colinfo));
+			col->le_proc = unique_check_btree_proc(tce->btree_opf,
+												   attr->atttypid,
+												   BTLessEqualStrategyNumber);
+			col->ge_proc = unique_check_btree_proc(tce->btree_opf,
+												   attr->atttypid,
+												   BTGreaterEqualStrategyNumber);
+
+			if (col->min_attno == InvalidAttrNumber || col->max_attno == InvalidAttrNumber)
+				elog(ERROR,
+					 "missing metadata columns in compressed chunk \"%s\"",
+					 get_rel_name(compressed_relid));
+		}
+	}
+
+	return check;
+}
+
+static UniqueCheckState *
+unique_check_state_create(ChunkInsertState *cis)
+{
+	UniqueCheckState *state = palloc0(sizeof(UniqueCheckState));
+	List *htcols;
+	List *index_oids;
+	ListCell *lc;
+
+	state->chunk = ts_chunk_get_by_id(cis->chunk_id, true);
+
+	if (!ts_chunk_is_compressed(state->chunk))
+		return state;
+
+	state->compressed_chunk = ts_chunk_get_by_id(state->chunk->fd.compressed_chunk_id, true);
+	htcols = ts_hypertable_compression_get(state->chunk->fd.hypertable_id);
+	index_oids = RelationGetIndexList(cis->rel);
+
+	foreach (lc, index_oids)
+	{
+		Relation index_rel = index_open(lfirst_oid(lc), AccessShareLock);
+
+		if (index_rel->rd_index->indisunique)
+			state->indexes = lappend(state->indexes,
+									 unique_check_index_create(index_rel,
+															   cis->rel,
+															   state->compressed_chunk->table_id,
+															   htcols));
+
+		index_close(index_rel, AccessShareLock);
+	}
+
+	return state;
+}
+
+/*
+ * Decompress the compressed batches that can contain a row conflicting with
+ * the row inserted into the chunk on a unique index. The unique indexes of
+ * the uncompressed chunk then check the row against the decompressed rows,
+ * and ON CONFLICT finds the conflicting row in the uncompressed chunk.
+ *
+ * Only the batches that match the row on the segment by columns of the index,
+ * and whose min and max metadata of the order by columns of the index include
+ * the values of the row, are decompressed. The chunk is marked partial, so
+ * that the rows are compressed again by the next recompression.
+ */
+void
+tsl_decompress_batches_for_insert(ChunkInsertState *cis, TupleTableSlot *slot)
+{
+	UniqueCheckState *state = cis->decompress_for_insert_state;
+	bool decompressed = false;
+	ListCell *lc;
+
+	if (state == NULL)
+	{
+		MemoryContext old_mcxt = MemoryContextSwitchTo(cis->mctx);
+
+		state = unique_check_state_create(cis);
+		cis->decompress_for_insert_state = state;
+		MemoryContextSwitchTo(old_mcxt);
+	}
+
+	/* the chunk could have been decompressed since the insert state was created */
+	if (state->compressed_chunk == NULL)
+		return;
+
+	foreach (lc, state->indexes)
+	{
+		UniqueCheckIndex *check = lfirst(lc);
+		ScanKeyData *scankeys = palloc0(sizeof(ScanKeyData) * 2 * Max(check->num_columns, 1));
+		int num_scankeys = 0;
+		bool can_conflict = true;
+
+		for (int i = 0; i < check->num_columns; i++)
+		{
+			UniqueCheckColumn *col = &check->columns[i];
+			bool isnull;
+			Datum value = slot_getattr(slot, col->attno, &isnull);
+
+			if (isnull)
+			{
+				/* NULLs are distinct, so the row cannot conflict on this index */
+				if (!check->nulls_not_distinct)
+					can_conflict = false;
+				continue;
+			}
+
+			if (col->segmentby)
+				ScanKeyEntryInitialize(&scankeys[num_scankeys++],
+									   0,
+									   col->compressed_attno,
+									   BTEqualStrategyNumber,
+									   InvalidOid,
+									   col->collation,
+									   col->eq_proc,
+									   value);
+			else
+			{
+				ScanKeyEntryInitialize(&scankeys[num_scankeys++],
+									   0,
+									   col->min_attno,
+									   BTLessEqualStrategyNumber,
+									   InvalidOid,
+									   col->collation,
+									   col->le_proc,
+									   value);
+				ScanKeyEntryInitialize(&scankeys[num_scankeys++],
+									   0,
+									   col->max_attno,
+									   BTGreaterEqualStrategyNumber,
+									   InvalidOid,
+									   col->collation,
+									   col->ge_proc,
+									   value);
+			}
+		}
+
+		if (can_conflict &&
+			decompress_chunk_batches(state->chunk, state->compressed_chunk, scankeys, num_scankeys))
+			decompressed = true;
+
+		pfree(scankeys);
+	}
+
+	/*
+	 * The decompressed rows are inserted with the command id of the current
+	 * statement, so advance the command id to make them visible to ON
+	 * CONFLICT DO UPDATE, like for UPDATE and DELETE in compress_dml.c.
+	 */
+	if (decompressed && cis->estate->es_snapshot != NULL)
+	{
+		cis->estate->es_output_cid = GetCurrentCommandId(true);
+		cis->estate->es_snapshot->curcid = cis->estate->es_output_cid;
+	}
+}
+
+/*
+ * Merge two adjacent compressed chunks. The compressed batches (and any
+ * uncompressed rows of a partial chunk) of merge_chunk are moved into chunk,
+ * the dimension slice of chunk is extended to cover merge_chunk, and
+ * merge_chunk is dropped together with its compressed chunk.
+ *
+ * The batches of the two chunks are not merged, so the chunk is marked
+ * unordered and recompressed if the merge violates the order of the batches.
+ */
+void
+tsl_merge_compressed_chunks(Chunk *chunk, Chunk *merge_chunk, const Dimension *dim)
+{
+	Chunk *compressed_chunk = ts_chunk_get_by_id(chunk->fd.compressed_chunk_id, true);
+	Chunk *merge_compressed_chunk = ts_chunk_get_by_id(merge_chunk->fd.compressed_chunk_id, true);
+	List *htcols_list = ts_hypertable_compression_get(chunk->fd.hypertable_id);
+	int htcols_listlen = list_length(htcols_list);
+	const ColumnCompressionInfo **colinfo_array;
+	RelationSize merge_size, after_size;
+	int64 rowcnt_pre, rowcnt_post;
+	bool chunk_unordered;
+	ListCell *lc;
+	int i = 0;
+
+	Assert(ts_chunk_is_compressed(chunk) && ts_chunk_is_compressed(merge_chunk));
+
+	/* same lock order as compress_chunk: uncompressed chunks before compressed chunks */
+	LockRelationOid(chunk->table_id, ExclusiveLock);
+	LockRelationOid(merge_chunk->table_id, ExclusiveLock);
+	LockRelationOid(compressed_chunk->table_id, ExclusiveLock);
+	LockRelationOid(merge_compressed_chunk->table_id, ExclusiveLock);
+	LockRelationOid(catalog_get_table_id(ts_catalog_get(), CHUNK), RowExclusiveLock);
+
+	if (!compression_chunk_size_catalog_fetch(merge_chunk->fd.id,
+											  &merge_size,
+											  &rowcnt_pre,
+											  &rowcnt_post))
+		elog(ERROR,
+			 "missing compression size for chunk \"%s\"",
+			 get_rel_name(merge_chunk->table_id));
+
+	colinfo_array = palloc(sizeof(ColumnCompressionInfo *) * htcols_listlen);
+	foreach (lc, htcols_list)
+		colinfo_array[i++] = (FormData_hypertable_compression *) lfirst(lc);
+
+	chunk_unordered = ts_chunk_is_unordered(chunk) || ts_chunk_is_unordered(merge_chunk) ||
+					  check_is_chunk_order_violated_by_merge(dim,
+															 chunk,
+															 merge_chunk,
+															 colinfo_array,
+															 htcols_listlen);
+
+	copy_chunk_rows(merge_compressed_chunk->table_id, compressed_chunk->table_id);
+	if (copy_chunk_rows(merge_chunk->table_id, chunk->table_id) > 0)
+		ts_chunk_set_partial(chunk);
+
+	after_size = ts_relation_size_impl(compressed_chunk->table_id);
+	compression_chunk_size_catalog_update_merged(chunk->fd.id,
+												 &merge_size,
+												 compressed_chunk->fd.id,
+												 &after_size,
+												 rowcnt_pre,
+												 rowcnt_post);
+	merge_chunk_relstats(chunk->table_id, merge_chunk->table_id);
+	merge_chunk_relstats(compressed_chunk->table_id, merge_compressed_chunk->table_id);
+	ts_chunk_column_stats_merge(ts_hypertable_get_by_id(chunk->fd.hypertable_id),
+								chunk->fd.id,
+								merge_chunk->fd.id);
+
+	ts_chunk_merge_on_dimension(chunk, merge_chunk, dim->fd.id);
+
+	if (chunk_unordered)
+	{
+		ts_chunk_set_unordered(chunk);
+		tsl_recompress_chunk_wrapper(chunk);
+	}
+}
+
+Datum
+tsl_recompress_chunk_segmentwise(PG_FUNCTION_ARGS)
+{
+	Oid uncompressed_chunk_id = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	bool if_not_compressed = PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1);
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+	Chunk *chunk = ts_chunk_get_by_relid(uncompressed_chunk_id, true);
+
+	if (chunk->relkind == RELKIND_FOREIGN_TABLE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("segmentwise recompression is not supported for distributed hypertables"),
+				 errhint("Use recompress_chunk() instead.")));
+
+	if (!ts_chunk_is_compressed(chunk))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("call compress_chunk instead of recompress_chunk_segmentwise")));
+
+	if (!ts_chunk_is_partial(chunk))
+	{
+		ereport((if_not_compressed ? NOTICE : ERROR),
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("nothing to recompress in chunk \"%s\"",
+						get_rel_name(uncompressed_chunk_id))));
+		PG_RETURN_OID(uncompressed_chunk_id);
+	}
+
+	/* the batches of an unordered chunk have to be compressed again anyway */
+	if (ts_chunk_is_unordered(chunk))
+		tsl_recompress_chunk_wrapper(chunk);
+	else
+	{
+		recompress_chunk_segmentwise_impl(chunk);
+		ts_chunk_size_stats_update(chunk->fd.id);
+	}
+
+	PG_RETURN_OID(uncompressed_chunk_id);
+}
@@ -8,12 +8,25 @@
 
 #include <postgres.h>
 #include <fmgr.h>
+#include <access/skey.h>
+#include <executor/tuptable.h>
+
+struct ChunkInsertState;
 
 extern Datum tsl_create_compressed_chunk(PG_FUNCTION_ARGS);
 extern Datum tsl_compress_chunk(PG_FUNCTION_ARGS);
 extern Datum tsl_decompress_chunk(PG_FUNCTION_ARGS);
 extern Datum tsl_recompress_chunk(PG_FUNCTION_ARGS);
+extern Datum tsl_recompress_chunk_segmentwise(PG_FUNCTION_ARGS);
 extern Oid tsl_compress_chunk_wrapper(Chunk *chunk, bool if_not_compressed);
 extern bool tsl_recompress_chunk_wrapper(Chunk *chunk);
+extern bool decompress_chunk_range(Chunk *uncompressed_chunk, int64 start, int64 end);
+extern bool decompress_chunk_batches(Chunk *uncompressed_chunk, Chunk *compressed_chunk,
+									 ScanKeyData *scankeys, int num_scankeys);
+extern void tsl_decompress_batches_for_insert(struct ChunkInsertState *cis,
+											  TupleTableSlot *slot);
+extern int64 tsl_compressed_chunk_drop_batches(const Hypertable *ht, const Chunk *chunk,
+											   int64 older_than);
+extern void tsl_merge_compressed_chunks(Chunk *chunk, Chunk *merge_chunk, const Dimension *dim);
 
 #endif /* TIMESCALEDB_TSL_COMPRESSION_API_H */
@@ -0,0 +1,602 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include "compression/bitpack.h"
+
+#include <catalog/pg_type.h>
+#include <libpq/pqformat.h>
+#include <port/pg_bitutils.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+
+#include "compression/compression.h"
+#include "compression/simple8b_rle.h"
+
+typedef struct BitpackCompressed
+{
+	CompressedDataHeaderFields;
+	uint8 has_nulls; /* 1 if this has a NULLs bitmap after the packed words, 0 otherwise */
+	uint8 bits_per_value;
+	uint8 padding[5];
+	uint32 num_values;
+	/* the minimum of the batch, the values are stored as offsets from it */
+	uint64 reference;
+	uint64 words[FLEXIBLE_ARRAY_MEMBER];
+} BitpackCompressed;
+
+static void
+pg_attribute_unused() assertions(void)
+{
+	BitpackCompressed test_val = { .vl_len_ = { 0 } };
+	/* make sure no padding bytes make it to disk */
+	StaticAssertStmt(sizeof(BitpackCompressed) ==
+						 sizeof(test_val.vl_len_) + sizeof(test_val.compression_algorithm) +
+							 sizeof(test_val.has_nulls) + sizeof(test_val.bits_per_value) +
+							 sizeof(test_val.padding) + sizeof(test_val.num_values) +
+							 sizeof(test_val.reference),
+					 "BitpackCompressed wrong size");
+	StaticAssertStmt(sizeof(BitpackCompressed) == 24, "BitpackCompressed wrong size");
+}
+
+typedef struct BitpackDecompressionIterator
+{
+	DecompressionIterator base;
+	const BitpackCompressed *compressed;
+	/* the number of non-null values returned so far */
+	uint32 num_returned;
+	Simple8bRleDecompressionIterator nulls;
+	bool has_nulls;
+} BitpackDecompressionIterator;
+
+typedef struct BitpackCompressor
+{
+	uint64 *values;
+	uint32 num_values;
+	uint32 max_values;
+	int64 min_value;
+	int64 max_value;
+	Simple8bRleCompressor nulls;
+	bool has_nulls;
+} BitpackCompressor;
+
+typedef struct ExtendedCompressor
+{
+	Compressor base;
+	BitpackCompressor *internal;
+} ExtendedCompressor;
+
+static inline uint8
+bitpack_bits_for_range(uint64 range)
+{
+	return range == 0 ? 0 : pg_leftmost_one_pos64(range) + 1;
+}
+
+static inline uint32
+bitpack_num_words(uint8 bits_per_value, uint32 num_values)
+{
+	uint32 values_per_word;
+
+	if (bits_per_value == 0)
+		return 0;
+
+	values_per_word = 64 / bits_per_value;
+	return num_values / values_per_word + (num_values % values_per_word != 0 ? 1 : 0);
+}
+
+static inline uint64
+bitpack_mask(uint8 bits_per_value)
+{
+	return bits_per_value == 64 ? PG_UINT64_MAX : (UINT64CONST(1) << bits_per_value) - 1;
+}
+
+static Simple8bRleSerialized *
+bitpack_compressed_get_nulls(const BitpackCompressed *compressed)
+{
+	const char *data =
+		(const char *) (compressed->words +
+						bitpack_num_words(compressed->bits_per_value, compressed->num_values));
+
+	Assert(compressed->has_nulls == 1);
+	return bytes_deserialize_simple8b_and_advance(&data);
+}
+
+/*
+ * The value of the non-null element at the index, found without decoding the
+ * previous elements.
+ */
+int64
+bitpack_compressed_get_value(const BitpackCompressed *compressed, uint32 index)
+{
+	const uint8 bits = compressed->bits_per_value;
+	uint32 values_per_word;
+
+	Assert(index < compressed->num_values);
+
+	if (bits == 0)
+		return (int64) compressed->reference;
+
+	values_per_word = 64 / bits;
+	return (int64) (compressed->reference + ((compressed->words[index / values_per_word] >>
+											  ((index % values_per_word) * bits)) &
+											 bitpack_mask(bits)));
+}
+
+/*
+ * The size of the compressed data for the given number of values in the
+ * range, not counting the nulls bitmap.
+ */
+Size
+bitpack_compressed_size_without_nulls(int64 min_value, int64 max_value, uint32 num_values)
+{
+	const uint8 bits = bitpack_bits_for_range((uint64) max_value - (uint64) min_value);
+
+	return sizeof(BitpackCompressed) + sizeof(uint64) * bitpack_num_words(bits, num_values);
+}
+
+//////////////////
+/// Compressor ///
+//////////////////
+
+static void
+bitpack_compressor_append_int16(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetInt16(val));
+}
+
+static void
+bitpack_compressor_append_int32(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetInt32(val));
+}
+
+static void
+bitpack_compressor_append_int64(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_value(extended->internal, DatumGetInt64(val));
+}
+
+static void
+bitpack_compressor_append_null_value(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = bitpack_compressor_alloc();
+
+	bitpack_compressor_append_null(extended->internal);
+}
+
+static void *
+bitpack_compressor_finish_and_reset(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	void *compressed = bitpack_compressor_finish(extended->internal);
+	pfree(extended->internal->values);
+	pfree(extended->internal);
+	extended->internal = NULL;
+	return compressed;
+}
+
+const Compressor bitpack_uint16_compressor = {
+	.append_val = bitpack_compressor_append_int16,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+const Compressor bitpack_uint32_compressor = {
+	.append_val = bitpack_compressor_append_int32,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+const Compressor bitpack_uint64_compressor = {
+	.append_val = bitpack_compressor_append_int64,
+	.append_null = bitpack_compressor_append_null_value,
+	.finish = bitpack_compressor_finish_and_reset,
+};
+
+Compressor *
+bitpack_compressor_for_type(Oid element_type)
+{
+	ExtendedCompressor *compressor = palloc(sizeof(*compressor));
+	switch (element_type)
+	{
+		case INT2OID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_uint16_compressor };
+			return &compressor->base;
+		case INT4OID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_uint32_compressor };
+			return &compressor->base;
+		case INT8OID:
+			*compressor = (ExtendedCompressor){ .base = bitpack_uint64_compressor };
+			return &compressor->base;
+		default:
+			elog(ERROR,
+				 "invalid type for bitpack compressor \"%s\"",
+				 format_type_be(element_type));
+	}
+
+	pg_unreachable();
+}
+
+BitpackCompressor *
+bitpack_compressor_alloc(void)
+{
+	BitpackCompressor *compressor = palloc0(sizeof(*compressor));
+	compressor->max_values = 64;
+	compressor->values = palloc(sizeof(uint64) * compressor->max_values);
+	simple8brle_compressor_init(&compressor->nulls);
+	return compressor;
+}
+
+void
+bitpack_compressor_append_null(BitpackCompressor *compressor)
+{
+	compressor->has_nulls = true;
+	simple8brle_compressor_append(&compressor->nulls, 1);
+}
+
+void
+bitpack_compressor_append_value(BitpackCompressor *compressor, int64 next_val)
+{
+	if (compressor->num_values == compressor->max_values)
+	{
+		compressor->max_values *= 2;
+		compressor->values =
+			repalloc(compressor->values, sizeof(uint64) * compressor->max_values);
+	}
+
+	if (compressor->num_values == 0 || next_val < compressor->min_value)
+		compressor->min_value = next_val;
+	if (compressor->num_values == 0 || next_val > compressor->max_value)
+		compressor->max_value = next_val;
+
+	compressor->values[compressor->num_values++] = (uint64) next_val;
+	simple8brle_compressor_append(&compressor->nulls, 0);
+}
+
+static BitpackCompressed *
+bitpack_from_parts(uint64 reference, uint8 bits_per_value, uint32 num_values, const uint64 *words,
+				   Simple8bRleSerialized *nulls)
+{
+	const uint32 num_words = bitpack_num_words(bits_per_value, num_values);
+	Size nulls_size = 0;
+	Size compressed_size;
+	BitpackCompressed *compressed;
+
+	if (nulls != NULL)
+		nulls_size = simple8brle_serialized_total_size(nulls);
+
+	compressed_size = sizeof(BitpackCompressed) + sizeof(uint64) * num_words + nulls_size;
+
+	if (!AllocSizeIsValid(compressed_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("compressed size exceeds the maximum allowed (%d)", (int) MaxAllocSize)));
+
+	compressed = palloc0(compressed_size);
+	SET_VARSIZE(&compressed->vl_len_, compressed_size);
+
+	compressed->compression_algorithm = COMPRESSION_ALGORITHM_BITPACK;
+	compressed->has_nulls = nulls_size != 0 ? 1 : 0;
+	compressed->bits_per_value = bits_per_value;
+	compressed->num_values = num_values;
+	compressed->reference = reference;
+
+	if (num_words > 0)
+		memcpy(compressed->words, words, sizeof(uint64) * num_words);
+
+	if (compressed->has_nulls == 1)
+	{
+		Assert(nulls->num_elements > num_values);
+		bytes_serialize_simple8b_and_advance((char *) (compressed->words + num_words),
+											 nulls_size,
+											 nulls);
+	}
+
+	return compressed;
+}
+
+BitpackCompressed *
+bitpack_compressor_finish(BitpackCompressor *compressor)
+{
+	Simple8bRleSerialized *nulls = simple8brle_compressor_finish(&compressor->nulls);
+	const uint64 reference = (uint64) compressor->min_value;
+	uint8 bits;
+	uint32 num_words;
+	uint32 values_per_word;
+	uint64 *words;
+
+	if (compressor->num_values == 0)
+		return NULL;
+
+	bits = bitpack_bits_for_range((uint64) compressor->max_value - reference);
+	num_words = bitpack_num_words(bits, compressor->num_values);
+	words = palloc0(sizeof(uint64) * Max(num_words, 1));
+
+	if (bits > 0)
+	{
+		values_per_word = 64 / bits;
+		for (uint32 i = 0; i < compressor->num_values; i++)
+			words[i / values_per_word] |= (compressor->values[i] - reference)
+										  << ((i % values_per_word) * bits);
+	}
+
+	return bitpack_from_parts(reference,
+							  bits,
+							  compressor->num_values,
+							  words,
+							  compressor->has_nulls ? nulls : NULL);
+}
+
+////////////////////
+/// Decompressor ///
+////////////////////
+
+static void
+bitpack_decompression_iterator_init(BitpackDecompressionIterator *iter,
+									const BitpackCompressed *compressed, bool scan_forward,
+									Oid element_type)
+{
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	*iter = (BitpackDecompressionIterator){
+		.base = {
+			.compression_algorithm = COMPRESSION_ALGORITHM_BITPACK,
+			.forward = scan_forward,
+			.element_type = element_type,
+			.try_next = scan_forward ? bitpack_decompression_iterator_try_next_forward :
+									   bitpack_decompression_iterator_try_next_reverse,
+		},
+		.compressed = compressed,
+		.num_returned = 0,
+		.has_nulls = compressed->has_nulls == 1,
+	};
+
+	if (iter->has_nulls)
+	{
+		Simple8bRleSerialized *nulls = bitpack_compressed_get_nulls(compressed);
+		if (scan_forward)
+			simple8brle_decompression_iterator_init_forward(&iter->nulls, nulls);
+		else
+			simple8brle_decompression_iterator_init_reverse(&iter->nulls, nulls);
+	}
+}
+
+DecompressionIterator *
+bitpack_decompression_iterator_from_datum_forward(Datum compressed, Oid element_type)
+{
+	BitpackDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	bitpack_decompression_iterator_init(iterator,
+										(void *) PG_DETOAST_DATUM(compressed),
+										true,
+										element_type);
+	return &iterator->base;
+}
+
+DecompressionIterator *
+bitpack_decompression_iterator_from_datum_reverse(Datum compressed, Oid element_type)
+{
+	BitpackDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	bitpack_decompression_iterator_init(iterator,
+										(void *) PG_DETOAST_DATUM(compressed),
+										false,
+										element_type);
+	return &iterator->base;
+}
+
+static inline DecompressResult
+convert_from_internal(DecompressResultInternal res_internal, Oid element_type)
+{
+	if (res_internal.is_done || res_internal.is_null)
+	{
+		return (DecompressResult){
+			.is_done = res_internal.is_done,
+			.is_null = res_internal.is_null,
+		};
+	}
+
+	switch (element_type)
+	{
+		case INT8OID:
+			return (DecompressResult){
+				.val = Int64GetDatum(res_internal.val),
+			};
+		case INT4OID:
+			return (DecompressResult){
+				.val = Int32GetDatum(res_internal.val),
+			};
+		case INT2OID:
+			return (DecompressResult){
+				.val = Int16GetDatum(res_internal.val),
+			};
+		default:
+			elog(ERROR,
+				 "invalid type requested from bitpack decompression \"%s\"",
+				 format_type_be(element_type));
+	}
+
+	pg_unreachable();
+}
+
+static DecompressResultInternal
+bitpack_decompression_iterator_try_next_internal(BitpackDecompressionIterator *iter)
+{
+	const BitpackCompressed *compressed = iter->compressed;
+	uint32 index;
+
+	/* check for a null value */
+	if (iter->has_nulls)
+	{
+		Simple8bRleDecompressResult result =
+			iter->base.forward ? simple8brle_decompression_iterator_try_next_forward(&iter->nulls) :
+								 simple8brle_decompression_iterator_try_next_reverse(&iter->nulls);
+		if (result.is_done)
+			return (DecompressResultInternal){
+				.is_done = true,
+			};
+
+		if (result.val != 0)
+		{
+			Assert(result.val == 1);
+			return (DecompressResultInternal){
+				.is_null = true,
+			};
+		}
+	}
+
+	if (iter->num_returned >= compressed->num_values)
+		return (DecompressResultInternal){
+			.is_done = true,
+		};
+
+	index = iter->base.forward ? iter->num_returned :
+								 compressed->num_values - 1 - iter->num_returned;
+	iter->num_returned++;
+
+	return (DecompressResultInternal){
+		.val = (uint64) bitpack_compressed_get_value(compressed, index),
+	};
+}
+
+DecompressResult
+bitpack_decompression_iterator_try_next_forward(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_BITPACK && iter->forward);
+	return convert_from_internal(bitpack_decompression_iterator_try_next_internal(
+									 (BitpackDecompressionIterator *) iter),
+								 iter->element_type);
+}
+
+DecompressResult
+bitpack_decompression_iterator_try_next_reverse(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_BITPACK && !iter->forward);
+	return convert_from_internal(bitpack_decompression_iterator_try_next_internal(
+									 (BitpackDecompressionIterator *) iter),
+								 iter->element_type);
+}
+
+/*
+ * Decompress the whole datum at once. All the full words hold the same number
+ * of values at the same shifts, so unpacking them is a loop with a fixed step
+ * and no dependencies between the iterations, which the compiler vectorizes.
+ */
+DecompressedColumn *
+bitpack_decompress_all(Datum compressed_data, Oid element_type)
+{
+	const BitpackCompressed *compressed = (BitpackCompressed *) PG_DETOAST_DATUM(compressed_data);
+	const uint32 n_values = compressed->num_values;
+	const uint8 bits = compressed->bits_per_value;
+	const uint64 reference = compressed->reference;
+	uint64 *restrict values = palloc(sizeof(uint64) * Max(n_values, 1));
+	uint64 *nulls = NULL;
+	uint32 n_rows = n_values;
+
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	if (bits == 0)
+	{
+		for (uint32 i = 0; i < n_values; i++)
+			values[i] = reference;
+	}
+	else
+	{
+		const uint32 values_per_word = 64 / bits;
+		const uint32 n_full_words = n_values / values_per_word;
+		const uint64 mask = bitpack_mask(bits);
+
+		for (uint32 word = 0; word < n_full_words; word++)
+		{
+			const uint64 packed = compressed->words[word];
+			uint64 *restrict out = values + (Size) word * values_per_word;
+
+			for (uint32 j = 0; j < values_per_word; j++)
+				out[j] = reference + ((packed >> (j * bits)) & mask);
+		}
+
+		for (uint32 i = n_full_words * values_per_word; i < n_values; i++)
+			values[i] =
+				reference +
+				((compressed->words[n_full_words] >> ((i % values_per_word) * bits)) & mask);
+	}
+
+	if (compressed->has_nulls == 1)
+	{
+		Simple8bRleSerialized *nulls_serialized = bitpack_compressed_get_nulls(compressed);
+
+		n_rows = nulls_serialized->num_elements;
+		nulls = palloc(sizeof(uint64) * Max(n_rows, 1));
+		simple8brle_decompress_all_buf(nulls_serialized, nulls, n_rows);
+	}
+
+	return decompressed_column_build(element_type, values, n_values, nulls, n_rows);
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+void
+bitpack_compressed_send(CompressedDataHeader *header, StringInfo buffer)
+{
+	const BitpackCompressed *data = (BitpackCompressed *) header;
+	const uint32 num_words = bitpack_num_words(data->bits_per_value, data->num_values);
+
+	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_BITPACK);
+	pq_sendbyte(buffer, data->has_nulls);
+	pq_sendbyte(buffer, data->bits_per_value);
+	pq_sendint32(buffer, data->num_values);
+	pq_sendint64(buffer, data->reference);
+	for (uint32 i = 0; i < num_words; i++)
+		pq_sendint64(buffer, data->words[i]);
+	if (data->has_nulls)
+		simple8brle_serialized_send(buffer, bitpack_compressed_get_nulls(data));
+}
+
+Datum
+bitpack_compressed_recv(StringInfo buffer)
+{
+	uint8 has_nulls;
+	uint8 bits_per_value;
+	uint32 num_values;
+	uint64 reference;
+	uint32 num_words;
+	uint64 *words;
+	Simple8bRleSerialized *nulls = NULL;
+
+	has_nulls = pq_getmsgbyte(buffer);
+	if (has_nulls != 0 && has_nulls != 1)
+		elog(ERROR, "invalid recv in bitpack: bad bool");
+
+	bits_per_value = pq_getmsgbyte(buffer);
+	if (bits_per_value > 64)
+		elog(ERROR, "invalid recv in bitpack: bad bit width");
+
+	num_values = pq_getmsgint32(buffer);
+	reference = pq_getmsgint64(buffer);
+
+	num_words = bitpack_num_words(bits_per_value, num_values);
+	if (num_words > (uint32) (buffer->len - buffer->cursor) / sizeof(uint64))
+		elog(ERROR, "invalid recv in bitpack: bad number of values");
+
+	words = palloc(sizeof(uint64) * Max(num_words, 1));
+	for (uint32 i = 0; i < num_words; i++)
+		words[i] = pq_getmsgint64(buffer);
+
+	if (has_nulls)
+		nulls = simple8brle_serialized_recv(buffer);
+
+	PG_RETURN_POINTER(bitpack_from_parts(reference, bits_per_value, num_values, words, nulls));
+}
@@ -0,0 +1,67 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+/*
+ * Bitpack is used to encode integers whose values in a batch lie in a small range but don't follow
+ * a trend, e.g. status codes, percentages or small counters, where delta-of-deltas jump back and
+ * forth. The minimum of the batch is stored as the frame of reference and every value is stored
+ * as its offset from the reference, using the number of bits needed by the largest offset.
+ *
+ * The offsets are packed into 64-bit words without crossing word boundaries, so the value of any
+ * row can be read without decoding the previous ones, and unpacking a word is a loop with a fixed
+ * shift step. The nulls are stored as a simple8b_rle bitmap like in deltadelta.
+ *
+ * The algorithm is not chosen for a column directly. The deltadelta compressor of the integer types
+ * switches to it for the batches where it is smaller, see timescaledb.enable_bitpack_compression.
+ */
+#ifndef TIMESCALEDB_TSL_COMPRESSION_BITPACK_H
+#define TIMESCALEDB_TSL_COMPRESSION_BITPACK_H
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+
+#include "compression/compression.h"
+
+typedef struct BitpackCompressor BitpackCompressor;
+typedef struct BitpackCompressed BitpackCompressed;
+typedef struct BitpackDecompressionIterator BitpackDecompressionIterator;
+
+extern Compressor *bitpack_compressor_for_type(Oid element_type);
+extern BitpackCompressor *bitpack_compressor_alloc(void);
+extern void bitpack_compressor_append_null(BitpackCompressor *compressor);
+extern void bitpack_compressor_append_value(BitpackCompressor *compressor, int64 next_val);
+extern BitpackCompressed *bitpack_compressor_finish(BitpackCompressor *compressor);
+
+extern Size bitpack_compressed_size_without_nulls(int64 min_value, int64 max_value,
+												  uint32 num_values);
+extern int64 bitpack_compressed_get_value(const BitpackCompressed *compressed, uint32 index);
+
+extern DecompressionIterator *bitpack_decompression_iterator_from_datum_forward(Datum compressed,
+																				Oid element_type);
+extern DecompressionIterator *bitpack_decompression_iterator_from_datum_reverse(Datum compressed,
+																				Oid element_type);
+extern DecompressResult
+bitpack_decompression_iterator_try_next_forward(DecompressionIterator *iter);
+extern DecompressResult
+bitpack_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
+
+extern DecompressedColumn *bitpack_decompress_all(Datum compressed_data, Oid element_type);
+
+extern void bitpack_compressed_send(CompressedDataHeader *header, StringInfo buffer);
+extern Datum bitpack_compressed_recv(StringInfo buf);
+
+#define BITPACK_ALGORITHM_DEFINITION                                                               \
+	{                                                                                              \
+		.iterator_init_forward = bitpack_decompression_iterator_from_datum_forward,                \
+		.iterator_init_reverse = bitpack_decompression_iterator_from_datum_reverse,                \
+		.compressed_data_send = bitpack_compressed_send,                                           \
+		.compressed_data_recv = bitpack_compressed_recv,                                           \
+		.compressor_for_type = bitpack_compressor_for_type,                                        \
+		.compressed_data_storage = TOAST_STORAGE_EXTERNAL,                                         \
+		.decompress_all = bitpack_decompress_all,                                                  \
+	}
+
+#endif
@@ -9,6 +9,9 @@
 #include <access/heapam.h>
 #include <access/htup_details.h>
 #include <access/multixact.h>
+#include <access/parallel.h>
+#include <access/tableam.h>
+#include <access/tupconvert.h>
 #include <access/xact.h>
 #include <catalog/namespace.h>
 #include <catalog/pg_attribute.h>
@@ -16,33 +19,51 @@
 #include <catalog/index.h>
 #include <catalog/heap.h>
 #include <common/base64.h>
+#include <executor/executor.h>
 #include <executor/tuptable.h>
 #include <funcapi.h>
 #include <libpq/pqformat.h>
 #include <miscadmin.h>
 #include <nodes/pg_list.h>
+#include <pgstat.h>
+#include <port/atomics.h>
+#include <storage/bufmgr.h>
 #include <storage/lmgr.h>
 #include <storage/predicate.h>
+#include <storage/shm_mq.h>
+#include <storage/shm_toc.h>
+#include <storage/spin.h>
 #include <utils/builtins.h>
 #include <utils/datum.h>
+#include <utils/hsearch.h>
 #include <utils/lsyscache.h>
 #include <utils/memutils.h>
+#include <utils/portal.h>
 #include <utils/rel.h>
 #include <utils/snapmgr.h>
 #include <utils/syscache.h>
 #include <utils/tuplesort.h>
+#include <utils/tuplestore.h>
 #include <utils/typcache.h>
 #include <catalog/pg_am.h>
 #include <utils.h>
 
 #include "compat/compat.h"
+#if PG13_LT
+#include <access/tuptoaster.h>
+#else
+#include <access/heaptoast.h>
+#endif
 
 #include "array.h"
+#include "bitpack.h"
 #include "chunk.h"
 #include "debug_point.h"
 #include "deltadelta.h"
 #include "dictionary.h"
+#include "extension_constants.h"
 #include "gorilla.h"
+#include "sample_stats.h"
 #include "ts_catalog/compression_chunk_size.h"
 #include "create.h"
 #include "custom_type_cache.h"
@@ -50,11 +71,17 @@
 #include "ts_catalog/hypertable_compression.h"
 #include "ts_catalog/catalog.h"
 #include "guc.h"
+#include "jsonb_compression.h"
+#include "uuid_compression.h"
 #include <nodes/print.h>
 
-#define MAX_ROWS_PER_COMPRESSION 1000
 /* gap in sequence id between rows, potential for adding rows in gap later */
 #define SEQUENCE_NUM_GAP 10
+/* limits on the compressed tuples buffered for one table_multi_insert call */
+#define MAX_BUFFERED_COMPRESSED_TUPLES 1000
+#define MAX_BUFFERED_COMPRESSED_BYTES (1024 * 1024)
+/* limit on the decompressed tuples buffered for one table_multi_insert call */
+#define MAX_BUFFERED_DECOMPRESSED_TUPLES 1000
 #define COMPRESSIONCOL_IS_SEGMENT_BY(col) ((col)->segmentby_column_index > 0)
 #define COMPRESSIONCOL_IS_ORDER_BY(col) ((col)->orderby_column_index > 0)
 
@@ -63,6 +90,9 @@ static const CompressionAlgorithmDefinition definitions[_END_COMPRESSION_ALGORIT
 	[COMPRESSION_ALGORITHM_DICTIONARY] = DICTIONARY_ALGORITHM_DEFINITION,
 	[COMPRESSION_ALGORITHM_GORILLA] = GORILLA_ALGORITHM_DEFINITION,
 	[COMPRESSION_ALGORITHM_DELTADELTA] = DELTA_DELTA_ALGORITHM_DEFINITION,
+	[COMPRESSION_ALGORITHM_BITPACK] = BITPACK_ALGORITHM_DEFINITION,
+	[COMPRESSION_ALGORITHM_UUID] = UUID_ALGORITHM_DEFINITION,
+	[COMPRESSION_ALGORITHM_JSONB] = JSONB_ALGORITHM_DEFINITION,
 };
 
 static Compressor *
@@ -86,6 +116,91 @@ DecompressionIterator *(*tsl_get_decompression_iterator_init(CompressionAlgorith
 		return definitions[algorithm].iterator_init_forward;
 }
 
+DecompressAllFunction
+tsl_get_decompress_all_function(CompressionAlgorithms algorithm)
+{
+	if (algorithm >= _END_COMPRESSION_ALGORITHMS)
+		elog(ERROR, "invalid compression algorithm %d", algorithm);
+
+	return definitions[algorithm].decompress_all;
+}
+
+#define STORE_DECOMPRESSED_VALUES(CTYPE)                                                           \
+	do                                                                                             \
+	{                                                                                              \
+		CTYPE *restrict typed_dest = (CTYPE *) dest;                                               \
+		if (nulls == NULL)                                                                         \
+		{                                                                                          \
+			for (uint32 row = 0; row < n_rows; row++)                                              \
+				typed_dest[row] = (CTYPE) values[row];                                             \
+		}                                                                                          \
+		else                                                                                       \
+		{                                                                                          \
+			for (uint32 row = 0; row < n_rows; row++)                                              \
+			{                                                                                      \
+				if (nulls[row] != 0)                                                               \
+					continue;                                                                      \
+				if (value_index >= n_values)                                                       \
+					elog(ERROR, "compressed nulls out of sync with compressed values");            \
+				typed_dest[row] = (CTYPE) values[value_index++];                                   \
+				validity[row / 64] |= UINT64CONST(1) << (row % 64);                                \
+			}                                                                                      \
+		}                                                                                          \
+	} while (0)
+
+/*
+ * Build a DecompressedColumn from the decoded non-null values of a compressed
+ * datum. The values are given as uint64 in the representation the compression
+ * algorithms use internally and are narrowed to the width of the element type.
+ * `nulls` holds one 0/1 flag per row, or is NULL if there are no nulls.
+ */
+DecompressedColumn *
+decompressed_column_build(Oid element_type, const uint64 *restrict values, uint32 n_values,
+						  const uint64 *restrict nulls, uint32 n_rows)
+{
+	const int16 value_bytes = get_typlen(element_type);
+	DecompressedColumn *column = palloc0(sizeof(DecompressedColumn));
+	char *dest = palloc(value_bytes * Max(n_rows, 1));
+	uint64 *validity = NULL;
+	uint32 value_index = 0;
+
+	if (nulls == NULL && n_values != n_rows)
+		elog(ERROR, "compressed value count does not match the row count");
+
+	if (nulls != NULL)
+		validity = decompressed_column_validity_alloc(n_rows);
+
+	switch (value_bytes)
+	{
+		case 1:
+			STORE_DECOMPRESSED_VALUES(uint8);
+			break;
+		case 2:
+			STORE_DECOMPRESSED_VALUES(uint16);
+			break;
+		case 4:
+			STORE_DECOMPRESSED_VALUES(uint32);
+			break;
+		case 8:
+			STORE_DECOMPRESSED_VALUES(uint64);
+			break;
+		default:
+			elog(ERROR,
+				 "unsupported type for bulk decompression \"%s\"",
+				 format_type_be(element_type));
+	}
+
+	*column = (DecompressedColumn){
+		.length = n_rows,
+		.null_count = nulls == NULL ? 0 : n_rows - value_index,
+		.value_bytes = value_bytes,
+		.validity = validity,
+		.values = dest,
+	};
+
+	return column;
+}
+
 typedef struct SegmentInfo
 {
 	Datum val;
@@ -103,15 +218,31 @@ typedef struct PerColumn
 	Compressor *compressor;
 	/*
 	 * Information on the metadata we'll store for this column (currently only min/max).
-	 * Only used for order-by columns right now, will be {-1, NULL} for others.
+	 * Only used for order-by columns and the columns listed in the compress_minmax
+	 * option, will be {-1, NULL} for others. The null count is stored only for
+	 * the compress_minmax columns, and is -1 for others.
 	 */
 	int16 min_metadata_attr_offset;
 	int16 max_metadata_attr_offset;
+	int16 nulls_metadata_attr_offset;
 	SegmentMetaMinMaxBuilder *min_max_metadata_builder;
 
+	/* the bloom filter of the compress_bloom columns, {-1, NULL} for others */
+	int16 bloom1_metadata_attr_offset;
+	SegmentMetaBloomBuilder *bloom1_metadata_builder;
+
 	/* segment info; only used if compressor is NULL */
 	SegmentInfo *segment_info;
 	int16 segmentby_column_index;
+
+	/*
+	 * The values of the current compressed row, when the compressor appends
+	 * them in bulk with append_vals. Only used for the pass-by-value types,
+	 * whose datums stay valid until the row is flushed.
+	 */
+	Datum *buffered_values;
+	bool *buffered_nulls;
+	int n_buffered;
 } PerColumn;
 
 typedef struct RowCompressor
@@ -122,6 +253,17 @@ typedef struct RowCompressor
 	/* the table we're writing the compressed data to */
 	Relation compressed_table;
 	BulkInsertState bistate;
+	/* the indexes of the compressed table to insert into, if it already has them */
+	CatalogIndexState index_state;
+	/* compressed tuples waiting for table_multi_insert, only used without index_state */
+	TupleTableSlot **insert_slots;
+	int n_insert_slots;
+	Size insert_bytes;
+	CommandId insert_cid;
+	/* table_multi_insert/heap_insert options for the compressed table */
+	int insert_options;
+	/* the parallel workers send the compressed tuples to the leader instead */
+	shm_mq_handle *output_queue;
 	/* segment by index Oid if any */
 	Oid index_oid;
 
@@ -140,23 +282,30 @@ typedef struct RowCompressor
 	int16 count_metadata_column_offset;
 	int16 sequence_num_metadata_column_offset;
 
+	/* the maximum number of rows compressed into one compressed row */
+	uint32 max_rows_per_compression;
 	/* the number of uncompressed rows compressed into the current compressed row */
 	uint32 rows_compressed_into_current_value;
 	/* a unique monotonically increasing (according to order by) id for each compressed row */
 	int32 sequence_num;
+	/* no row was added yet, so there is no current segment */
+	bool first_iteration;
 
 	/* cached arrays used to build the HeapTuple */
 	Datum *compressed_values;
 	bool *compressed_is_null;
 	int64 rowcnt_pre_compression;
 	int64 num_compressed_rows;
+
+	/* the sample of the input rows for its statistics, NULL to ANALYZE it instead */
+	SampleStats *sample;
 } RowCompressor;
 
 static int16 *compress_chunk_populate_keys(Oid in_table, const ColumnCompressionInfo **columns,
 										   int n_columns, int *n_keys_out,
 										   const ColumnCompressionInfo ***keys_out);
-static Tuplesortstate *compress_chunk_sort_relation(Relation in_rel, int n_keys,
-													const ColumnCompressionInfo **keys);
+static void compress_chunk_sort_and_append(RowCompressor *row_compressor, Relation in_rel,
+										   int n_keys, const ColumnCompressionInfo **keys);
 static void row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_desc,
 								Relation compressed_table, int num_compression_infos,
 								const ColumnCompressionInfo **column_compression_info,
@@ -165,10 +314,16 @@ static void row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompr
 static void row_compressor_append_sorted_rows(RowCompressor *row_compressor,
 											  Tuplesortstate *sorted_rel, TupleDesc sorted_desc);
 static void row_compressor_finish(RowCompressor *row_compressor);
+static void row_compressor_insert_tuple(RowCompressor *row_compressor, HeapTuple compressed_tuple,
+										CommandId mycid);
+static void row_compressor_update_segment_info(RowCompressor *row_compressor,
+											   TupleTableSlot *row);
 static void row_compressor_update_group(RowCompressor *row_compressor, TupleTableSlot *row);
 static bool row_compressor_new_row_is_in_new_group(RowCompressor *row_compressor,
 												   TupleTableSlot *row);
 static void row_compressor_append_row(RowCompressor *row_compressor, TupleTableSlot *row);
+static void row_compressor_process_ordered_slot(RowCompressor *row_compressor,
+												TupleTableSlot *slot, CommandId mycid);
 static void row_compressor_flush(RowCompressor *row_compressor, CommandId mycid,
 								 bool changed_groups);
 
@@ -176,6 +331,15 @@ static SegmentInfo *segment_info_new(Form_pg_attribute column_attr);
 static void segment_info_update(SegmentInfo *segment_info, Datum val, bool is_null);
 static bool segment_info_datum_is_in_group(SegmentInfo *segment_info, Datum datum, bool is_null);
 static void run_analyze_on_chunk(Oid chunk_relid);
+static int compress_chunk_parallel_workers(int n_keys, const ColumnCompressionInfo **keys,
+										   TupleDesc in_desc);
+static bool compress_chunk_parallel(RowCompressor *row_compressor, Relation in_rel,
+									Relation out_rel,
+									const ColumnCompressionInfo **column_compression_info,
+									int num_compression_infos, int nworkers);
+static bool compress_chunk_hash_grouped(RowCompressor *row_compressor, Relation in_rel,
+										Relation out_rel, int n_keys,
+										const ColumnCompressionInfo **keys);
 
 /********************
  ** compress_chunk **
@@ -256,6 +420,100 @@ merge_chunk_relstats(Oid merged_relid, Oid compressed_relid)
 	restore_pgclass_stats(merged_relid, merged_pages, merged_visible, merged_tuples);
 }
 
+/*
+ * Store the statistics built from the rows sampled while compressing the
+ * chunk, instead of running ANALYZE on it. The row count is exact, and the
+ * pages are the ones the chunk has before it is truncated, like the ones
+ * ANALYZE would have recorded.
+ */
+static void
+store_sample_stats(SampleStats *sample, Relation in_rel, int64 rowcnt)
+{
+	Oid relid = RelationGetRelid(in_rel);
+	int pages, visible;
+	float tuples;
+
+	sample_stats_store(sample, in_rel);
+	capture_pgclass_stats(relid, &pages, &visible, &tuples);
+	restore_pgclass_stats(relid, RelationGetNumberOfBlocks(in_rel), visible, (float) rowcnt);
+	CommandCounterIncrement();
+	sample_stats_free(sample);
+}
+
+/* Append all rows of one chunk to another chunk of the same hypertable
+ * while maintaining the indexes of the target. The chunks may differ in
+ * their physical layout (e.g., due to dropped columns), so tuples are
+ * converted by attribute name. Constraints are not checked; the caller
+ * is responsible for ensuring that the rows are valid in the target,
+ * e.g., by merging the dimension slices of the two chunks.
+ */
+int64
+copy_chunk_rows(Oid src_relid, Oid dst_relid)
+{
+	Relation src_rel = table_open(src_relid, AccessShareLock);
+	Relation dst_rel = table_open(dst_relid, RowExclusiveLock);
+	TupleDesc src_desc = RelationGetDescr(src_rel);
+	TupleDesc dst_desc = RelationGetDescr(dst_rel);
+	TupleConversionMap *map = convert_tuples_by_name_compat(src_desc, dst_desc, NULL);
+	TupleTableSlot *src_slot = table_slot_create(src_rel, NULL);
+	TupleTableSlot *dst_slot = MakeSingleTupleTableSlot(dst_desc, &TTSOpsHeapTuple);
+	BulkInsertState bistate = GetBulkInsertState();
+	CommandId mycid = GetCurrentCommandId(true);
+	Snapshot snapshot = RegisterSnapshot(GetLatestSnapshot());
+	EState *estate = CreateExecutorState();
+	ResultRelInfo *rri = makeNode(ResultRelInfo);
+	TableScanDesc scan;
+	int64 nrows = 0;
+
+	InitResultRelInfo(rri, dst_rel, 1, NULL, 0);
+	ExecOpenIndices(rri, false);
+#if PG14_LT
+	estate->es_result_relation_info = rri;
+#endif
+
+	scan = table_beginscan(src_rel, snapshot, 0, NULL);
+
+	while (table_scan_getnextslot(scan, ForwardScanDirection, src_slot))
+	{
+		bool should_free;
+		HeapTuple tuple = ExecFetchSlotHeapTuple(src_slot, false, &should_free);
+		HeapTuple new_tuple = map != NULL ? execute_attr_map_tuple(tuple, map) : tuple;
+		List *recheck_indexes;
+
+		heap_insert(dst_rel, new_tuple, mycid, 0 /*=options*/, bistate);
+
+		ExecStoreHeapTuple(new_tuple, dst_slot, false);
+		recheck_indexes =
+			ExecInsertIndexTuplesCompat(rri, dst_slot, estate, false, false, NULL, NIL);
+		list_free(recheck_indexes);
+		ExecClearTuple(dst_slot);
+		ResetPerTupleExprContext(estate);
+
+		if (new_tuple != tuple)
+			heap_freetuple(new_tuple);
+		if (should_free)
+			heap_freetuple(tuple);
+
+		nrows++;
+	}
+
+	table_endscan(scan);
+	ExecDropSingleTupleTableSlot(src_slot);
+	ExecDropSingleTupleTableSlot(dst_slot);
+	ExecCloseIndices(rri);
+	FreeExecutorState(estate);
+	UnregisterSnapshot(snapshot);
+	FreeBulkInsertState(bistate);
+	if (map != NULL)
+		free_conversion_map(map);
+	CommandCounterIncrement();
+
+	table_close(dst_rel, NoLock);
+	table_close(src_rel, NoLock);
+
+	return nrows;
+}
+
 /* Truncate the relation WITHOUT applying triggers. This is the
  * main difference with ExecuteTruncate. Triggers aren't applied
  * because the data remains, just in compressed form. Also don't
@@ -317,9 +575,6 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 	Relation matched_index_rel = NULL;
 	TupleTableSlot *slot;
 	IndexScanDesc index_scan;
-	bool first_iteration = true;
-	bool changed_groups, compressed_row_is_full;
-	MemoryContext old_ctx;
 	CommandId mycid = GetCurrentCommandId(true);
 	HeapTuple in_table_tp = NULL, index_tp = NULL;
 	Form_pg_attribute in_table_attr_tp, index_attr_tp;
@@ -369,6 +624,8 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 	 * b) [Null_First]ASC ==> NULL->[1]->[2]
 	 * c) DSC[Null_Last]  ==> [2]->[1]->NULL
 	 * d) [Null_First]DSC ==> NULL->[2]->[1]
+	 *
+	 * The NULL ordering of the index is ignored for the NOT NULL columns.
 	 */
 	if (ts_guc_enable_compression_indexscan)
 	{
@@ -416,13 +673,18 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 					in_table_attr_tp = (Form_pg_attribute) GETSTRUCT(in_table_tp);
 					index_attr_tp = (Form_pg_attribute) GETSTRUCT(index_tp);
 
-					if (index_orderby_asc == is_orderby_asc && index_null_first == is_null_first &&
+					/* the position of the NULLs doesn't matter when there are none */
+					bool nulls_match =
+						in_table_attr_tp->attnotnull || index_null_first == is_null_first;
+					bool nulls_reversed =
+						in_table_attr_tp->attnotnull || index_null_first != is_null_first;
+
+					if (index_orderby_asc == is_orderby_asc && nulls_match &&
 						in_table_attr_tp->attcollation == index_attr_tp->attcollation)
 					{
 						current_direction = ForwardScanDirection;
 					}
-					else if (index_orderby_asc != is_orderby_asc &&
-							 index_null_first != is_null_first &&
+					else if (index_orderby_asc != is_orderby_asc && nulls_reversed &&
 							 in_table_attr_tp->attcollation == index_attr_tp->attcollation)
 					{
 						current_direction = BackwardScanDirection;
@@ -487,6 +749,8 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 						in_column_offsets,
 						out_desc->natts,
 						true /*need_bistate*/);
+	if (ts_guc_enable_compression_sample_stats)
+		row_compressor.sample = sample_stats_create(in_rel);
 
 	if (matched_index_rel != NULL)
 	{
@@ -501,33 +765,15 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 		index_scan = index_beginscan(in_rel, matched_index_rel, GetTransactionSnapshot(), 0, 0);
 		slot = table_slot_create(in_rel, NULL);
 		index_rescan(index_scan, NULL, 0, NULL, 0);
+		/* the index returns the rows sorted, so they are compressed as we go */
 		while (index_getnext_slot(index_scan, indexscan_direction, slot))
 		{
-			slot_getallattrs(slot);
-			old_ctx = MemoryContextSwitchTo(row_compressor.per_row_ctx);
-			/* first time through */
-			if (first_iteration)
-			{
-				row_compressor_update_group(&row_compressor, slot);
-				first_iteration = false;
-			}
-			changed_groups = row_compressor_new_row_is_in_new_group(&row_compressor, slot);
-			compressed_row_is_full =
-				row_compressor.rows_compressed_into_current_value >= MAX_ROWS_PER_COMPRESSION;
-			if (compressed_row_is_full || changed_groups)
-			{
-				if (row_compressor.rows_compressed_into_current_value > 0)
-					row_compressor_flush(&row_compressor, mycid, changed_groups);
-				if (changed_groups)
-					row_compressor_update_group(&row_compressor, slot);
-			}
-
-			row_compressor_append_row(&row_compressor, slot);
-			MemoryContextSwitchTo(old_ctx);
+			row_compressor_process_ordered_slot(&row_compressor, slot, mycid);
 			ExecClearTuple(slot);
 		}
 
-		run_analyze_on_chunk(in_rel->rd_id);
+		if (row_compressor.sample == NULL)
+			run_analyze_on_chunk(in_rel->rd_id);
 		if (row_compressor.rows_compressed_into_current_value > 0)
 			row_compressor_flush(&row_compressor, mycid, true);
 
@@ -535,20 +781,31 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 		index_endscan(index_scan);
 		index_close(matched_index_rel, AccessShareLock);
 	}
-	else
+	else if (!ts_guc_enable_compression_hash_grouping ||
+			 !compress_chunk_hash_grouped(&row_compressor, in_rel, out_rel, n_keys, keys))
 	{
+		int nworkers = compress_chunk_parallel_workers(n_keys, keys, in_desc);
+
+		if (nworkers == 0 || !compress_chunk_parallel(&row_compressor,
+													  in_rel,
+													  out_rel,
+													  column_compression_info,
+													  num_compression_infos,
+													  nworkers))
+		{
 #ifdef TS_DEBUG
-		const char *compression_path =
-			GetConfigOption("timescaledb.show_compression_path_info", true, false);
-		if (compression_path != NULL && strcmp(compression_path, "on") == 0)
-			elog(INFO, "compress_chunk_tuplesort_start");
+			const char *compression_path =
+				GetConfigOption("timescaledb.show_compression_path_info", true, false);
+			if (compression_path != NULL && strcmp(compression_path, "on") == 0)
+				elog(INFO, "compress_chunk_tuplesort_start");
 #endif
-		Tuplesortstate *sorted_rel = compress_chunk_sort_relation(in_rel, n_keys, keys);
-		row_compressor_append_sorted_rows(&row_compressor, sorted_rel, in_desc);
-		tuplesort_end(sorted_rel);
+			compress_chunk_sort_and_append(&row_compressor, in_rel, n_keys, keys);
+		}
 	}
 
 	row_compressor_finish(&row_compressor);
+	if (row_compressor.sample != NULL)
+		store_sample_stats(row_compressor.sample, in_rel, row_compressor.rowcnt_pre_compression);
 	truncate_relation(in_table);
 
 	/* Recreate all indexes on out rel, we already have an exclusive lock on it,
@@ -621,13 +878,10 @@ static void compress_chunk_populate_sort_info_for_column(Oid table,
 														 Oid *collation, bool *nulls_first);
 
 static Tuplesortstate *
-compress_chunk_sort_relation(Relation in_rel, int n_keys, const ColumnCompressionInfo **keys)
+compress_chunk_begin_sort(Relation in_rel, int n_keys, const ColumnCompressionInfo **keys,
+						  int sort_mem)
 {
 	TupleDesc tupDesc = RelationGetDescr(in_rel);
-	Tuplesortstate *tuplesortstate;
-	HeapTuple tuple;
-	TableScanDesc heapScan;
-	TupleTableSlot *heap_tuple_slot = MakeTupleTableSlot(tupDesc, &TTSOpsHeapTuple);
 	AttrNumber *sort_keys = palloc(sizeof(*sort_keys) * n_keys);
 	Oid *sort_operators = palloc(sizeof(*sort_operators) * n_keys);
 	Oid *sort_collations = palloc(sizeof(*sort_collations) * n_keys);
@@ -642,189 +896,749 @@ compress_chunk_sort_relation(Relation in_rel, int n_keys, const ColumnCompressio
 													 &sort_collations[n],
 													 &nulls_first[n]);
 
-	tuplesortstate = tuplesort_begin_heap(tupDesc,
-										  n_keys,
-										  sort_keys,
-										  sort_operators,
-										  sort_collations,
-										  nulls_first,
-										  maintenance_work_mem,
-										  NULL,
-										  false /*=randomAccess*/);
+	return tuplesort_begin_heap(tupDesc,
+								n_keys,
+								sort_keys,
+								sort_operators,
+								sort_collations,
+								nulls_first,
+								sort_mem,
+								NULL,
+								false /*=randomAccess*/);
+}
 
-	heapScan = table_beginscan(in_rel, GetLatestSnapshot(), 0, (ScanKey) NULL);
-	for (tuple = heap_getnext(heapScan, ForwardScanDirection); tuple != NULL;
-		 tuple = heap_getnext(heapScan, ForwardScanDirection))
-	{
-		if (HeapTupleIsValid(tuple))
-		{
-			/*    This may not be the most efficient way to do things.
-			 *     Since we use begin_heap() the tuplestore expects tupleslots,
-			 *      so ISTM that the options are this or maybe putdatum().
-			 */
-			ExecStoreHeapTuple(tuple, heap_tuple_slot, false);
+/*
+ * Sorting the rows of a chunk by integer keys.
+ *
+ * When all the segmentby and orderby columns are integers, dates or
+ * timestamps, the rows are sorted by a radix sort of their keys instead of a
+ * tuplesort with fmgr comparators. Every key is mapped to an unsigned integer
+ * that sorts in the order of the column, and the rows are sorted with a
+ * stable least-significant-digit radix sort on the bytes of the keys. The
+ * bytes that are the same in all the rows, e.g., the high bytes of the time,
+ * are skipped.
+ *
+ * The rows are kept in memory, so this is used only while they fit in the
+ * sort memory and have no NULL keys. Otherwise the rows read so far are
+ * handed to a tuplesort.
+ */
+typedef struct KeySort
+{
+	MemoryContext mcxt;
+	int n_keys;
+	AttrNumber *attnos;
+	Oid *typids;
+	bool *descending;
+	/* the rows and their n_keys keys per row */
+	HeapTuple *rows;
+	uint64 *keys;
+	uint32 n_rows;
+	uint32 max_rows;
+	Size mem_used;
+	Size mem_limit;
+	/* the row numbers in sorted order, set by key_sort_perform */
+	uint32 *order;
+} KeySort;
 
-			tuplesort_puttupleslot(tuplesortstate, heap_tuple_slot);
-		}
+static bool
+key_sort_type_supported(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return true;
+		default:
+			return false;
 	}
+}
 
-	heap_endscan(heapScan);
+/*
+ * Returns false if the keys can't be sorted by a radix sort.
+ */
+static bool
+key_sort_init(KeySort *ks, Relation in_rel, int n_keys, const ColumnCompressionInfo **keys,
+			  int sort_mem)
+{
+	TupleDesc tupdesc = RelationGetDescr(in_rel);
+
+	*ks = (KeySort){
+		.n_keys = n_keys,
+		.attnos = palloc(sizeof(AttrNumber) * n_keys),
+		.typids = palloc(sizeof(Oid) * n_keys),
+		.descending = palloc(sizeof(bool) * n_keys),
+		.mem_limit = (Size) sort_mem * 1024,
+	};
 
-	/* Perform an analyze on the chunk to get up-to-date stats before compressing.
-	 * We do it at this point because we've just read out the entire chunk into
-	 * tuplesort, so its pages are likely to be cached and we can save on I/O.
-	 */
-	run_analyze_on_chunk(in_rel->rd_id);
+	for (int i = 0; i < n_keys; i++)
+	{
+		AttrNumber attno = get_attnum(RelationGetRelid(in_rel), NameStr(keys[i]->attname));
 
-	ExecDropSingleTupleTableSlot(heap_tuple_slot);
+		if (!AttributeNumberIsValid(attno))
+			return false;
 
-	tuplesort_performsort(tuplesortstate);
+		ks->attnos[i] = attno;
+		ks->typids[i] = TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(attno))->atttypid;
+		ks->descending[i] = !COMPRESSIONCOL_IS_SEGMENT_BY(keys[i]) && !keys[i]->orderby_asc;
 
-	return tuplesortstate;
+		if (!key_sort_type_supported(ks->typids[i]))
+			return false;
+	}
+
+	ks->mcxt =
+		AllocSetContextCreate(CurrentMemoryContext, "compression sort", ALLOCSET_DEFAULT_SIZES);
+	return true;
 }
 
-static void
-compress_chunk_populate_sort_info_for_column(Oid table, const ColumnCompressionInfo *column,
-											 AttrNumber *att_nums, Oid *sort_operator,
-											 Oid *collation, bool *nulls_first)
+/* map the value to an unsigned integer with the same sort order */
+static inline uint64
+key_sort_encode(Datum value, Oid typid, bool descending)
 {
-	HeapTuple tp;
-	Form_pg_attribute att_tup;
-	TypeCacheEntry *tentry;
+	int64 v;
+	uint64 key;
 
-	tp = SearchSysCacheAttName(table, NameStr(column->attname));
-	if (!HeapTupleIsValid(tp))
-		elog(ERROR,
-			 "table \"%s\" does not have column \"%s\"",
-			 get_rel_name(table),
-			 NameStr(column->attname));
+	switch (typid)
+	{
+		case INT2OID:
+			v = DatumGetInt16(value);
+			break;
+		case INT4OID:
+		case DATEOID:
+			v = DatumGetInt32(value);
+			break;
+		default:
+			v = DatumGetInt64(value);
+			break;
+	}
 
-	att_tup = (Form_pg_attribute) GETSTRUCT(tp);
-	/* Other valdation checks beyond just existence of a valid comparison operator could be useful
-	 */
+	key = ((uint64) v) ^ (UINT64CONST(1) << 63);
+	return descending ? ~key : key;
+}
 
-	*att_nums = att_tup->attnum;
-	*collation = att_tup->attcollation;
-	*nulls_first = (!(COMPRESSIONCOL_IS_SEGMENT_BY(column))) && column->orderby_nullsfirst;
+/*
+ * Add a row, returns false without adding it if the row has a NULL key or
+ * doesn't fit in the sort memory.
+ */
+static bool
+key_sort_put(KeySort *ks, HeapTuple tuple, TupleDesc tupdesc)
+{
+	Size row_size = HEAPTUPLESIZE + tuple->t_len + sizeof(HeapTuple) +
+					sizeof(uint64) * ks->n_keys + 2 * sizeof(uint32);
+	uint64 *row_keys;
+	MemoryContext oldcxt;
 
-	tentry = lookup_type_cache(att_tup->atttypid, TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+	if (ks->mem_used + row_size > ks->mem_limit || ks->n_rows == PG_UINT32_MAX)
+		return false;
 
-	if (COMPRESSIONCOL_IS_SEGMENT_BY(column) || column->orderby_asc)
-		*sort_operator = tentry->lt_opr;
-	else
-		*sort_operator = tentry->gt_opr;
+	for (int i = 0; i < ks->n_keys; i++)
+	{
+		bool isnull;
 
-	if (!OidIsValid(*sort_operator))
-		elog(ERROR,
-			 "no valid sort operator for column \"%s\" of type \"%s\"",
-			 NameStr(column->attname),
-			 format_type_be(att_tup->atttypid));
+		heap_getattr(tuple, ks->attnos[i], tupdesc, &isnull);
+		if (isnull)
+			return false;
+	}
 
-	ReleaseSysCache(tp);
-}
+	if (ks->n_rows == ks->max_rows)
+	{
+		ks->max_rows = ks->max_rows == 0 ? 1024 : ks->max_rows * 2;
+		if (ks->rows == NULL)
+		{
+			ks->rows = MemoryContextAllocHuge(ks->mcxt, sizeof(HeapTuple) * ks->max_rows);
+			ks->keys =
+				MemoryContextAllocHuge(ks->mcxt, sizeof(uint64) * ks->n_keys * ks->max_rows);
+		}
+		else
+		{
+			ks->rows = repalloc_huge(ks->rows, sizeof(HeapTuple) * ks->max_rows);
+			ks->keys = repalloc_huge(ks->keys, sizeof(uint64) * ks->n_keys * ks->max_rows);
+		}
+	}
 
-static void
-run_analyze_on_chunk(Oid chunk_relid)
-{
-	VacuumRelation vr = {
-		.type = T_VacuumRelation,
-		.relation = NULL,
-		.oid = chunk_relid,
-		.va_cols = NIL,
-	};
-	VacuumStmt vs = {
-		.type = T_VacuumStmt,
-		.rels = list_make1(&vr),
-		.is_vacuumcmd = false,
-		.options = NIL,
-	};
+	row_keys = &ks->keys[(Size) ks->n_rows * ks->n_keys];
+	for (int i = 0; i < ks->n_keys; i++)
+	{
+		bool isnull;
+		Datum value = heap_getattr(tuple, ks->attnos[i], tupdesc, &isnull);
 
-	ExecVacuum(NULL, &vs, true);
+		row_keys[i] = key_sort_encode(value, ks->typids[i], ks->descending[i]);
+	}
+
+	oldcxt = MemoryContextSwitchTo(ks->mcxt);
+	ks->rows[ks->n_rows++] = heap_copytuple(tuple);
+	MemoryContextSwitchTo(oldcxt);
+	ks->mem_used += row_size;
+
+	return true;
 }
 
-/* Find segment by index for setting the correct sequence number if
- * we are trying to roll up chunks while compressing
- */
-static Oid
-get_compressed_chunk_index(Relation compressed_chunk, int16 *uncompressed_col_to_compressed_col,
-						   PerColumn *per_column, int n_input_columns)
+static void
+key_sort_perform(KeySort *ks)
 {
-	ListCell *lc;
-	int i;
+	const uint32 n_rows = ks->n_rows;
+	const int n_keys = ks->n_keys;
+	uint32 *order = MemoryContextAllocHuge(ks->mcxt, sizeof(uint32) * Max(n_rows, 1));
+	uint32 *next = MemoryContextAllocHuge(ks->mcxt, sizeof(uint32) * Max(n_rows, 1));
 
-	List *index_oids = RelationGetIndexList(compressed_chunk);
+	for (uint32 i = 0; i < n_rows; i++)
+		order[i] = i;
 
-	foreach (lc, index_oids)
+	/* the last key is the least significant */
+	for (int k = n_keys - 1; k >= 0 && n_rows > 1; k--)
 	{
-		Oid index_oid = lfirst_oid(lc);
-		bool matches = true;
-		int num_segmentby_columns = 0;
-		Relation index_rel = index_open(index_oid, AccessShareLock);
-		IndexInfo *index_info = BuildIndexInfo(index_rel);
+		uint64 differing_bits = 0;
 
-		for (i = 0; i < n_input_columns; i++)
+		for (uint32 i = 1; i < n_rows; i++)
+			differing_bits |= ks->keys[(Size) i * n_keys + k] ^ ks->keys[k];
+
+		for (int shift = 0; shift < 64; shift += 8)
 		{
-			if (per_column[i].segmentby_column_index < 1)
+			uint32 offsets[256] = { 0 };
+			uint32 offset = 0;
+			uint32 *swap;
+
+			if (((differing_bits >> shift) & 0xFF) == 0)
 				continue;
 
-			/* Last member of the index must be the sequence number column. */
-			if (per_column[i].segmentby_column_index >= index_rel->rd_att->natts)
+			for (uint32 i = 0; i < n_rows; i++)
+				offsets[(ks->keys[(Size) i * n_keys + k] >> shift) & 0xFF]++;
+
+			for (int digit = 0; digit < 256; digit++)
 			{
-				matches = false;
-				break;
-			}
+				uint32 count = offsets[digit];
 
-			int index_att_offset = AttrNumberGetAttrOffset(per_column[i].segmentby_column_index);
+				offsets[digit] = offset;
+				offset += count;
+			}
 
-			if (index_info->ii_IndexAttrNumbers[index_att_offset] !=
-				AttrOffsetGetAttrNumber(uncompressed_col_to_compressed_col[i]))
+			for (uint32 i = 0; i < n_rows; i++)
 			{
-				matches = false;
-				break;
+				uint32 row = order[i];
+
+				next[offsets[(ks->keys[(Size) row * n_keys + k] >> shift) & 0xFF]++] = row;
 			}
 
-			num_segmentby_columns++;
+			swap = order;
+			order = next;
+			next = swap;
 		}
+	}
 
-		/* Check that we have the correct number of index attributes
-		 * and that the last one is the sequence number
-		 */
-		if (num_segmentby_columns != index_rel->rd_att->natts - 1 ||
-			namestrcmp((Name) &index_rel->rd_att->attrs[num_segmentby_columns].attname,
-					   COMPRESSION_COLUMN_METADATA_SEQUENCE_NUM_NAME) != 0)
-			matches = false;
-
-		index_close(index_rel, AccessShareLock);
+	pfree(next);
+	ks->order = order;
+}
 
-		if (matches)
-			return index_oid;
+/* hand the rows that were added so far to a tuplesort */
+static void
+key_sort_move_to_tuplesort(KeySort *ks, Tuplesortstate *tuplesortstate, TupleTableSlot *slot)
+{
+	for (uint32 i = 0; i < ks->n_rows; i++)
+	{
+		ExecStoreHeapTuple(ks->rows[i], slot, false);
+		tuplesort_puttupleslot(tuplesortstate, slot);
+		ExecClearTuple(slot);
 	}
 
-	return InvalidOid;
+	MemoryContextReset(ks->mcxt);
+	ks->rows = NULL;
+	ks->keys = NULL;
+	ks->n_rows = 0;
+	ks->max_rows = 0;
+	ks->mem_used = 0;
 }
 
-static int32
-index_scan_sequence_number(Relation table_rel, Oid index_oid, ScanKeyData *scankey,
-						   int num_scankeys)
+static void
+row_compressor_append_key_sorted_rows(RowCompressor *row_compressor, KeySort *ks,
+									  TupleTableSlot *slot)
 {
-	int32 result = 0;
-	bool is_null;
-	Relation index_rel = index_open(index_oid, AccessShareLock);
-
-	IndexScanDesc index_scan =
-		index_beginscan(table_rel, index_rel, GetTransactionSnapshot(), num_scankeys, 0);
-	index_scan->xs_want_itup = true;
-	index_rescan(index_scan, scankey, num_scankeys, NULL, 0);
+	CommandId mycid = GetCurrentCommandId(row_compressor->output_queue == NULL);
 
-	if (index_getnext_tid(index_scan, BackwardScanDirection))
+	for (uint32 i = 0; i < ks->n_rows; i++)
 	{
-		result = index_getattr(index_scan->xs_itup,
-							   index_scan->xs_itupdesc
-								   ->natts, /* Last attribute of the index is sequence number. */
-							   index_scan->xs_itupdesc,
-							   &is_null);
-		if (is_null)
-			result = 0;
+		ExecStoreHeapTuple(ks->rows[ks->order[i]], slot, false);
+		row_compressor_process_ordered_slot(row_compressor, slot, mycid);
+		ExecClearTuple(slot);
+	}
+
+	if (row_compressor->rows_compressed_into_current_value > 0)
+		row_compressor_flush(row_compressor, mycid, true);
+}
+
+/*
+ * Sort the rows of the chunk by the segmentby and orderby columns and compress
+ * them, with the radix sort above when possible and a tuplesort otherwise.
+ */
+static void
+compress_chunk_sort_and_append(RowCompressor *row_compressor, Relation in_rel, int n_keys,
+							   const ColumnCompressionInfo **keys)
+{
+	TupleDesc tupDesc = RelationGetDescr(in_rel);
+	Tuplesortstate *tuplesortstate = NULL;
+	KeySort ks;
+	bool use_key_sort =
+		ts_guc_enable_compression_radix_sort &&
+		key_sort_init(&ks, in_rel, n_keys, keys, maintenance_work_mem);
+	HeapTuple tuple;
+	TableScanDesc heapScan;
+	TupleTableSlot *heap_tuple_slot = MakeTupleTableSlot(tupDesc, &TTSOpsHeapTuple);
+
+	if (!use_key_sort)
+		tuplesortstate = compress_chunk_begin_sort(in_rel, n_keys, keys, maintenance_work_mem);
+
+	heapScan = table_beginscan(in_rel, GetLatestSnapshot(), 0, (ScanKey) NULL);
+	for (tuple = heap_getnext(heapScan, ForwardScanDirection); tuple != NULL;
+		 tuple = heap_getnext(heapScan, ForwardScanDirection))
+	{
+		if (HeapTupleIsValid(tuple))
+		{
+			if (tuplesortstate == NULL)
+			{
+				if (key_sort_put(&ks, tuple, tupDesc))
+					continue;
+
+				tuplesortstate =
+					compress_chunk_begin_sort(in_rel, n_keys, keys, maintenance_work_mem);
+				key_sort_move_to_tuplesort(&ks, tuplesortstate, heap_tuple_slot);
+			}
+
+			/*    This may not be the most efficient way to do things.
+			 *     Since we use begin_heap() the tuplestore expects tupleslots,
+			 *      so ISTM that the options are this or maybe putdatum().
+			 */
+			ExecStoreHeapTuple(tuple, heap_tuple_slot, false);
+
+			tuplesort_puttupleslot(tuplesortstate, heap_tuple_slot);
+		}
+	}
+
+	heap_endscan(heapScan);
+
+	/* Perform an analyze on the chunk to get up-to-date stats before compressing.
+	 * We do it at this point because we've just read out the entire chunk into
+	 * the sort, so its pages are likely to be cached and we can save on I/O.
+	 * The statistics are built from the sample of the rows instead if we take
+	 * one.
+	 */
+	if (row_compressor->sample == NULL)
+		run_analyze_on_chunk(in_rel->rd_id);
+
+	if (tuplesortstate == NULL)
+	{
+		key_sort_perform(&ks);
+		row_compressor_append_key_sorted_rows(row_compressor, &ks, heap_tuple_slot);
+	}
+	else
+	{
+		tuplesort_performsort(tuplesortstate);
+		row_compressor_append_sorted_rows(row_compressor, tuplesortstate, tupDesc);
+		tuplesort_end(tuplesortstate);
+	}
+
+	if (use_key_sort)
+		MemoryContextDelete(ks.mcxt);
+	ExecDropSingleTupleTableSlot(heap_tuple_slot);
+}
+
+/*
+ * The number of batches sampled from a chunk to choose the compression
+ * algorithms, and how much smaller in percent an algorithm that is slower to
+ * decode has to be to be chosen.
+ */
+#define COMPRESSION_SAMPLE_BATCHES 10
+#define COMPRESSION_SAMPLE_MIN_GAIN 10
+
+/* the algorithms that can be chosen for a column, from the fastest to decode */
+static const CompressionAlgorithms sample_candidates[] = {
+	COMPRESSION_ALGORITHM_DELTADELTA,
+	COMPRESSION_ALGORITHM_GORILLA,
+	COMPRESSION_ALGORITHM_UUID,
+	COMPRESSION_ALGORITHM_JSONB,
+	COMPRESSION_ALGORITHM_DICTIONARY,
+	COMPRESSION_ALGORITHM_ARRAY,
+};
+
+typedef struct SampledColumn
+{
+	FormData_hypertable_compression *info;
+	AttrNumber attno;
+	int n_candidates;
+	CompressionAlgorithms candidates[lengthof(sample_candidates)];
+	Compressor *compressors[lengthof(sample_candidates)];
+	Size sizes[lengthof(sample_candidates)];
+} SampledColumn;
+
+static bool
+compression_algorithm_supports_type(CompressionAlgorithms algorithm, Oid typeoid)
+{
+	switch (algorithm)
+	{
+		case COMPRESSION_ALGORITHM_DELTADELTA:
+			return typeoid == BOOLOID || typeoid == INT2OID || typeoid == INT4OID ||
+				   typeoid == INT8OID || typeoid == DATEOID || typeoid == TIMESTAMPOID ||
+				   typeoid == TIMESTAMPTZOID;
+		case COMPRESSION_ALGORITHM_GORILLA:
+			return typeoid == FLOAT4OID || typeoid == FLOAT8OID || typeoid == INT2OID ||
+				   typeoid == INT4OID || typeoid == INT8OID;
+		case COMPRESSION_ALGORITHM_UUID:
+			return typeoid == UUIDOID && ts_guc_enable_uuid_compression;
+		case COMPRESSION_ALGORITHM_JSONB:
+			return typeoid == JSONBOID && ts_guc_enable_jsonb_compression;
+		case COMPRESSION_ALGORITHM_DICTIONARY:
+		{
+			TypeCacheEntry *tentry =
+				lookup_type_cache(typeoid, TYPECACHE_EQ_OPR_FINFO | TYPECACHE_HASH_PROC_FINFO);
+			return tentry->hash_proc_finfo.fn_addr != NULL && tentry->eq_opr_finfo.fn_addr != NULL;
+		}
+		case COMPRESSION_ALGORITHM_ARRAY:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static void
+compression_sample_finish_batch(SampledColumn *sampled, int n_sampled)
+{
+	for (int i = 0; i < n_sampled; i++)
+	{
+		for (int j = 0; j < sampled[i].n_candidates; j++)
+		{
+			void *compressed = sampled[i].compressors[j]->finish(sampled[i].compressors[j]);
+
+			if (compressed != NULL)
+				sampled[i].sizes[j] += VARSIZE(compressed);
+		}
+	}
+}
+
+/*
+ * Choose the compression algorithm of the compressed columns by sampling the
+ * chunk instead of using the type-based default, and record the choice in the
+ * hypertable_compression catalog. The first rows of the chunk are sorted and
+ * split into batches like for compression, and each batch is compressed with
+ * all the algorithms that support the column type. The algorithms are tried
+ * from the fastest to the slowest to decode, and a slower one is only chosen
+ * when it compresses the sample at least COMPRESSION_SAMPLE_MIN_GAIN percent
+ * smaller. The algo_id of the passed FormData_hypertable_compression entries
+ * is updated as well, so that they can be used to compress the chunk.
+ */
+void
+compression_sample_algorithms(Oid in_table, List *column_compression_info)
+{
+	int n_columns = list_length(column_compression_info);
+	const ColumnCompressionInfo **columns = palloc(sizeof(*columns) * n_columns);
+	const ColumnCompressionInfo **keys;
+	SampledColumn *sampled = palloc0(sizeof(*sampled) * n_columns);
+	SegmentInfo **segment_info = palloc0(sizeof(*segment_info) * n_columns);
+	AttrNumber *segment_attnos = palloc0(sizeof(*segment_attnos) * n_columns);
+	CompressionAlgorithms *chosen = palloc(sizeof(*chosen) * n_columns);
+	int n_sampled = 0, n_segment_keys = 0, n_keys, n_rows = 0, rows_in_batch = 0;
+	Relation in_rel = table_open(in_table, AccessShareLock);
+	TupleDesc in_desc = RelationGetDescr(in_rel);
+	MemoryContext sample_ctx, old_ctx;
+	Tuplesortstate *sorted_rel;
+	TableScanDesc heap_scan;
+	TupleTableSlot *heap_tuple_slot, *slot;
+	HeapTuple tuple;
+	ListCell *lc;
+	int i = 0;
+
+	foreach (lc, column_compression_info)
+		columns[i++] = lfirst(lc);
+
+	sample_ctx = AllocSetContextCreate(CurrentMemoryContext,
+									   "compression sampling",
+									   ALLOCSET_DEFAULT_SIZES);
+	old_ctx = MemoryContextSwitchTo(sample_ctx);
+
+	compress_chunk_populate_keys(in_table, columns, n_columns, &n_keys, &keys);
+
+	for (i = 0; i < n_columns; i++)
+	{
+		FormData_hypertable_compression *info = list_nth(column_compression_info, i);
+		AttrNumber attno = get_attnum(in_table, NameStr(info->attname));
+		Form_pg_attribute attr = TupleDescAttr(in_desc, AttrNumberGetAttrOffset(attno));
+		SampledColumn *column = &sampled[n_sampled];
+
+		if (COMPRESSIONCOL_IS_SEGMENT_BY(info))
+		{
+			segment_info[n_segment_keys] = segment_info_new(attr);
+			segment_attnos[n_segment_keys++] = attno;
+			continue;
+		}
+
+		column->info = info;
+		column->attno = attno;
+		for (int j = 0; j < (int) lengthof(sample_candidates); j++)
+		{
+			if (!compression_algorithm_supports_type(sample_candidates[j], attr->atttypid))
+				continue;
+
+			column->candidates[column->n_candidates] = sample_candidates[j];
+			column->compressors[column->n_candidates] =
+				compressor_for_algorithm_and_type(sample_candidates[j], attr->atttypid);
+			column->n_candidates++;
+		}
+		n_sampled++;
+	}
+
+	/* sort the first rows of the chunk like for compression */
+	sorted_rel = compress_chunk_begin_sort(in_rel, n_keys, keys, work_mem);
+	heap_tuple_slot = MakeTupleTableSlot(in_desc, &TTSOpsHeapTuple);
+	heap_scan = table_beginscan(in_rel, GetLatestSnapshot(), 0, (ScanKey) NULL);
+	while (n_rows < COMPRESSION_SAMPLE_BATCHES * ts_guc_compress_batch_size &&
+		   (tuple = heap_getnext(heap_scan, ForwardScanDirection)) != NULL)
+	{
+		ExecStoreHeapTuple(tuple, heap_tuple_slot, false);
+		tuplesort_puttupleslot(sorted_rel, heap_tuple_slot);
+		n_rows++;
+	}
+	heap_endscan(heap_scan);
+	ExecDropSingleTupleTableSlot(heap_tuple_slot);
+	tuplesort_performsort(sorted_rel);
+
+	slot = MakeTupleTableSlot(in_desc, &TTSOpsMinimalTuple);
+	while (tuplesort_gettupleslot(sorted_rel, true /*=forward*/, false /*=copy*/, slot, NULL))
+	{
+		bool changed_groups = false;
+
+		slot_getallattrs(slot);
+		for (i = 0; i < n_segment_keys && rows_in_batch > 0; i++)
+		{
+			bool is_null;
+			Datum val = slot_getattr(slot, segment_attnos[i], &is_null);
+
+			if (!segment_info_datum_is_in_group(segment_info[i], val, is_null))
+				changed_groups = true;
+		}
+
+		if (changed_groups || rows_in_batch >= ts_guc_compress_batch_size)
+		{
+			compression_sample_finish_batch(sampled, n_sampled);
+			rows_in_batch = 0;
+		}
+
+		if (rows_in_batch == 0)
+		{
+			for (i = 0; i < n_segment_keys; i++)
+			{
+				bool is_null;
+				Datum val = slot_getattr(slot, segment_attnos[i], &is_null);
+
+				segment_info_update(segment_info[i], val, is_null);
+			}
+		}
+
+		for (i = 0; i < n_sampled; i++)
+		{
+			bool is_null;
+			Datum val = slot_getattr(slot, sampled[i].attno, &is_null);
+
+			for (int j = 0; j < sampled[i].n_candidates; j++)
+			{
+				Compressor *compressor = sampled[i].compressors[j];
+
+				if (is_null)
+					compressor->append_null(compressor);
+				else
+					compressor->append_val(compressor, val);
+			}
+		}
+		rows_in_batch++;
+		ExecClearTuple(slot);
+	}
+	if (rows_in_batch > 0)
+		compression_sample_finish_batch(sampled, n_sampled);
+
+	ExecDropSingleTupleTableSlot(slot);
+	tuplesort_end(sorted_rel);
+
+	for (i = 0; i < n_sampled; i++)
+	{
+		int best = 0;
+
+		for (int j = 1; j < sampled[i].n_candidates; j++)
+		{
+			if (sampled[i].sizes[j] * 100 <
+				sampled[i].sizes[best] * (100 - COMPRESSION_SAMPLE_MIN_GAIN))
+				best = j;
+		}
+
+		/* keep the current algorithm if the sample has no values */
+		if (sampled[i].n_candidates == 0 || sampled[i].sizes[best] == 0)
+			chosen[i] = sampled[i].info->algo_id;
+		else
+			chosen[i] = sampled[i].candidates[best];
+	}
+
+	MemoryContextSwitchTo(old_ctx);
+	table_close(in_rel, NoLock);
+
+	for (i = 0; i < n_sampled; i++)
+	{
+		FormData_hypertable_compression *info = sampled[i].info;
+
+		if (chosen[i] == info->algo_id)
+			continue;
+
+		/* the chunks of a hypertable can be compressed concurrently */
+		LockRelationOid(catalog_get_table_id(ts_catalog_get(), HYPERTABLE_COMPRESSION),
+						ShareUpdateExclusiveLock);
+		ts_hypertable_compression_set_algorithm(info->hypertable_id,
+												NameStr(info->attname),
+												chosen[i]);
+		info->algo_id = chosen[i];
+	}
+
+	MemoryContextDelete(sample_ctx);
+}
+
+static void
+compress_chunk_populate_sort_info_for_column(Oid table, const ColumnCompressionInfo *column,
+											 AttrNumber *att_nums, Oid *sort_operator,
+											 Oid *collation, bool *nulls_first)
+{
+	HeapTuple tp;
+	Form_pg_attribute att_tup;
+	TypeCacheEntry *tentry;
+
+	tp = SearchSysCacheAttName(table, NameStr(column->attname));
+	if (!HeapTupleIsValid(tp))
+		elog(ERROR,
+			 "table \"%s\" does not have column \"%s\"",
+			 get_rel_name(table),
+			 NameStr(column->attname));
+
+	att_tup = (Form_pg_attribute) GETSTRUCT(tp);
+	/* Other valdation checks beyond just existence of a valid comparison operator could be useful
+	 */
+
+	*att_nums = att_tup->attnum;
+	*collation = att_tup->attcollation;
+	*nulls_first = (!(COMPRESSIONCOL_IS_SEGMENT_BY(column))) && column->orderby_nullsfirst;
+
+	tentry = lookup_type_cache(att_tup->atttypid, TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+
+	if (COMPRESSIONCOL_IS_SEGMENT_BY(column) || column->orderby_asc)
+		*sort_operator = tentry->lt_opr;
+	else
+		*sort_operator = tentry->gt_opr;
+
+	if (!OidIsValid(*sort_operator))
+		elog(ERROR,
+			 "no valid sort operator for column \"%s\" of type \"%s\"",
+			 NameStr(column->attname),
+			 format_type_be(att_tup->atttypid));
+
+	ReleaseSysCache(tp);
+}
+
+static void
+run_analyze_on_chunk(Oid chunk_relid)
+{
+	VacuumRelation vr = {
+		.type = T_VacuumRelation,
+		.relation = NULL,
+		.oid = chunk_relid,
+		.va_cols = NIL,
+	};
+	VacuumStmt vs = {
+		.type = T_VacuumStmt,
+		.rels = list_make1(&vr),
+		.is_vacuumcmd = false,
+		.options = NIL,
+	};
+
+	ExecVacuum(NULL, &vs, true);
+}
+
+/* Find segment by index for setting the correct sequence number if
+ * we are trying to roll up chunks while compressing
+ */
+static Oid
+get_compressed_chunk_index(Relation compressed_chunk, int16 *uncompressed_col_to_compressed_col,
+						   PerColumn *per_column, int n_input_columns)
+{
+	ListCell *lc;
+	int i;
+
+	List *index_oids = RelationGetIndexList(compressed_chunk);
+
+	foreach (lc, index_oids)
+	{
+		Oid index_oid = lfirst_oid(lc);
+		bool matches = true;
+		int num_segmentby_columns = 0;
+		Relation index_rel = index_open(index_oid, AccessShareLock);
+		IndexInfo *index_info = BuildIndexInfo(index_rel);
+
+		for (i = 0; i < n_input_columns; i++)
+		{
+			if (per_column[i].segmentby_column_index < 1)
+				continue;
+
+			/* Last member of the index must be the sequence number column. */
+			if (per_column[i].segmentby_column_index >= index_rel->rd_att->natts)
+			{
+				matches = false;
+				break;
+			}
+
+			int index_att_offset = AttrNumberGetAttrOffset(per_column[i].segmentby_column_index);
+
+			if (index_info->ii_IndexAttrNumbers[index_att_offset] !=
+				AttrOffsetGetAttrNumber(uncompressed_col_to_compressed_col[i]))
+			{
+				matches = false;
+				break;
+			}
+
+			num_segmentby_columns++;
+		}
+
+		/* Check that we have the correct number of index attributes
+		 * and that the last one is the sequence number
+		 */
+		if (num_segmentby_columns != index_rel->rd_att->natts - 1 ||
+			namestrcmp((Name) &index_rel->rd_att->attrs[num_segmentby_columns].attname,
+					   COMPRESSION_COLUMN_METADATA_SEQUENCE_NUM_NAME) != 0)
+			matches = false;
+
+		index_close(index_rel, AccessShareLock);
+
+		if (matches)
+			return index_oid;
+	}
+
+	return InvalidOid;
+}
+
+static int32
+index_scan_sequence_number(Relation table_rel, Oid index_oid, ScanKeyData *scankey,
+						   int num_scankeys)
+{
+	int32 result = 0;
+	bool is_null;
+	Relation index_rel = index_open(index_oid, AccessShareLock);
+
+	IndexScanDesc index_scan =
+		index_beginscan(table_rel, index_rel, GetTransactionSnapshot(), num_scankeys, 0);
+	index_scan->xs_want_itup = true;
+	index_rescan(index_scan, scankey, num_scankeys, NULL, 0);
+
+	if (index_getnext_tid(index_scan, BackwardScanDirection))
+	{
+		result = index_getattr(index_scan->xs_itup,
+							   index_scan->xs_itupdesc
+								   ->natts, /* Last attribute of the index is sequence number. */
+							   index_scan->xs_itupdesc,
+							   &is_null);
+		if (is_null)
+			result = 0;
 	}
 
 	index_endscan(index_scan);
@@ -843,8 +1657,9 @@ table_scan_sequence_number(Relation table_rel, int16 seq_num_column_num, ScanKey
 	Datum seq_num;
 	TupleDesc in_desc = RelationGetDescr(table_rel);
 
-	TableScanDesc heap_scan =
-		table_beginscan(table_rel, GetLatestSnapshot(), num_scankeys, scankey);
+	/* the parallel compression workers can't take new snapshots */
+	Snapshot snapshot = IsParallelWorker() ? GetActiveSnapshot() : GetLatestSnapshot();
+	TableScanDesc heap_scan = table_beginscan(table_rel, snapshot, num_scankeys, scankey);
 
 	for (compressed_tuple = heap_getnext(heap_scan, ForwardScanDirection); compressed_tuple != NULL;
 		 compressed_tuple = heap_getnext(heap_scan, ForwardScanDirection))
@@ -867,26 +1682,17 @@ table_scan_sequence_number(Relation table_rel, int16 seq_num_column_num, ScanKey
 	return max_seq_num;
 }
 
-/* Scan compressed chunk to get the sequence number for current group.
- * This is necessary to do when merging chunks. If the chunk is empty,
- * scan will always return 0 and the sequence number will start from
- * SEQUENCE_NUM_GAP.
+/*
+ * Build the scan keys that find the compressed tuples of the current segment
+ * of the row compressor, either in the segment by index or in the compressed
+ * chunk itself. Returns NULL if there are no segment by columns.
  */
-static int32
-get_sequence_number_for_current_group(Relation table_rel, Oid index_oid,
-									  int16 *uncompressed_col_to_compressed_col,
-									  PerColumn *per_column, int n_input_columns,
-									  int16 seq_num_column_num)
+static ScanKeyData *
+build_scankeys_for_current_group(int16 *uncompressed_col_to_compressed_col, PerColumn *per_column,
+								 int n_input_columns, bool is_index_scan, int *num_scankeys_out)
 {
-	/* No point scanning an empty relation. */
-	if (table_rel->rd_rel->relpages == 0)
-		return SEQUENCE_NUM_GAP;
-
-	/* If there is a suitable index, use index scan otherwise fallback to heap scan. */
-	bool is_index_scan = OidIsValid(index_oid);
-
 	int i, num_scankeys = 0;
-	int32 result = 0;
+	ScanKeyData *scankey = NULL;
 
 	for (i = 0; i < n_input_columns; i++)
 	{
@@ -896,14 +1702,6 @@ get_sequence_number_for_current_group(Relation table_rel, Oid index_oid,
 		num_scankeys++;
 	}
 
-	MemoryContext scan_ctx = AllocSetContextCreate(CurrentMemoryContext,
-												   "get max sequence number scan",
-												   ALLOCSET_DEFAULT_SIZES);
-	MemoryContext old_ctx;
-	old_ctx = MemoryContextSwitchTo(scan_ctx);
-
-	ScanKeyData *scankey = NULL;
-
 	if (num_scankeys > 0)
 	{
 		scankey = palloc0(sizeof(ScanKeyData) * num_scankeys);
@@ -943,6 +1741,43 @@ get_sequence_number_for_current_group(Relation table_rel, Oid index_oid,
 		}
 	}
 
+	*num_scankeys_out = num_scankeys;
+	return scankey;
+}
+
+/* Scan compressed chunk to get the sequence number for current group.
+ * This is necessary to do when merging chunks. If the chunk is empty,
+ * scan will always return 0 and the sequence number will start from
+ * SEQUENCE_NUM_GAP.
+ */
+static int32
+get_sequence_number_for_current_group(Relation table_rel, Oid index_oid,
+									  int16 *uncompressed_col_to_compressed_col,
+									  PerColumn *per_column, int n_input_columns,
+									  int16 seq_num_column_num)
+{
+	/* No point scanning an empty relation. */
+	if (table_rel->rd_rel->relpages == 0)
+		return SEQUENCE_NUM_GAP;
+
+	/* If there is a suitable index, use index scan otherwise fallback to heap scan. */
+	bool is_index_scan = OidIsValid(index_oid);
+
+	int num_scankeys;
+	int32 result = 0;
+
+	MemoryContext scan_ctx = AllocSetContextCreate(CurrentMemoryContext,
+												   "get max sequence number scan",
+												   ALLOCSET_DEFAULT_SIZES);
+	MemoryContext old_ctx;
+	old_ctx = MemoryContextSwitchTo(scan_ctx);
+
+	ScanKeyData *scankey = build_scankeys_for_current_group(uncompressed_col_to_compressed_col,
+															per_column,
+															n_input_columns,
+															is_index_scan,
+															&num_scankeys);
+
 	if (is_index_scan)
 	{
 		/* Index scan should always use at least one scan key to get the sequence number. */
@@ -962,6 +1797,29 @@ get_sequence_number_for_current_group(Relation table_rel, Oid index_oid,
 	return result + SEQUENCE_NUM_GAP;
 }
 
+/*
+ * The options to insert the tuples of compression or decompression with.
+ *
+ * Like COPY FREEZE, the tuples are written already frozen when the relation
+ * was created or truncated in the current subtransaction, and no earlier
+ * snapshot of the transaction could see the relation empty. This avoids
+ * rewriting every page later to freeze it, and also marks the pages as all
+ * visible. The relation isn't visible to other transactions until we commit.
+ */
+static int
+compression_insert_options(Relation rel)
+{
+	if (rel->rd_createSubid != GetCurrentSubTransactionId() &&
+		rel->rd_newRelfilenodeSubid != GetCurrentSubTransactionId())
+		return 0;
+
+	InvalidateCatalogSnapshot();
+	if (!ThereAreNoPriorRegisteredSnapshots() || !ThereAreNoReadyPortals())
+		return 0;
+
+	return TABLE_INSERT_FROZEN;
+}
+
 /********************
  ** row_compressor **
  ********************/
@@ -1001,6 +1859,13 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 											 ALLOCSET_DEFAULT_SIZES),
 		.compressed_table = compressed_table,
 		.bistate = need_bistate ? GetBulkInsertState() : NULL,
+		.index_state = NULL,
+		.insert_slots =
+			need_bistate ? palloc0(sizeof(TupleTableSlot *) * MAX_BUFFERED_COMPRESSED_TUPLES) : NULL,
+		.n_insert_slots = 0,
+		.insert_bytes = 0,
+		.insert_options = need_bistate ? compression_insert_options(compressed_table) : 0,
+		.output_queue = NULL,
 		.n_input_columns = uncompressed_tuple_desc->natts,
 		.per_column = palloc0(sizeof(PerColumn) * uncompressed_tuple_desc->natts),
 		.uncompressed_col_to_compressed_col =
@@ -1010,10 +1875,13 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 		.sequence_num_metadata_column_offset = AttrNumberGetAttrOffset(sequence_num_column_num),
 		.compressed_values = palloc(sizeof(Datum) * num_columns_in_compressed_table),
 		.compressed_is_null = palloc(sizeof(bool) * num_columns_in_compressed_table),
+		.max_rows_per_compression = ts_guc_compress_batch_size,
 		.rows_compressed_into_current_value = 0,
 		.rowcnt_pre_compression = 0,
 		.num_compressed_rows = 0,
 		.sequence_num = SEQUENCE_NUM_GAP,
+		.first_iteration = true,
+		.sample = NULL,
 	};
 
 	memset(row_compressor->compressed_is_null, 1, sizeof(bool) * num_columns_in_compressed_table);
@@ -1036,7 +1904,11 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 		{
 			int16 segment_min_attr_offset = -1;
 			int16 segment_max_attr_offset = -1;
+			int16 segment_nulls_attr_offset = -1;
 			SegmentMetaMinMaxBuilder *segment_min_max_builder = NULL;
+			int16 segment_bloom1_attr_offset = -1;
+			SegmentMetaBloomBuilder *segment_bloom1_builder = NULL;
+			char *segment_bloom1_col_name = compression_column_segment_bloom1_name(compression_info);
 			if (compressed_column_attr->atttypid != compressed_data_type_oid)
 				elog(ERROR,
 					 "expected column '%s' to be a compressed data type",
@@ -1060,14 +1932,73 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 					segment_meta_min_max_builder_create(column_attr->atttypid,
 														column_attr->attcollation);
 			}
+			else
+			{
+				/* the compress_minmax columns have the metadata columns if any */
+				char *segment_min_col_name = compression_column_segment_min_name(compression_info);
+				char *segment_max_col_name = compression_column_segment_max_name(compression_info);
+				char *segment_nulls_col_name =
+					compression_column_segment_nulls_name(compression_info);
+				AttrNumber segment_min_attr_number =
+					segment_min_col_name == NULL ?
+						InvalidAttrNumber :
+						get_attnum(compressed_table->rd_id, segment_min_col_name);
+
+				if (segment_min_attr_number != InvalidAttrNumber)
+				{
+					AttrNumber segment_max_attr_number =
+						get_attnum(compressed_table->rd_id, segment_max_col_name);
+					AttrNumber segment_nulls_attr_number =
+						get_attnum(compressed_table->rd_id, segment_nulls_col_name);
+					if (segment_max_attr_number == InvalidAttrNumber)
+						elog(ERROR, "couldn't find metadata column \"%s\"", segment_max_col_name);
+					if (segment_nulls_attr_number == InvalidAttrNumber)
+						elog(ERROR,
+							 "couldn't find metadata column \"%s\"",
+							 segment_nulls_col_name);
+					segment_min_attr_offset = AttrNumberGetAttrOffset(segment_min_attr_number);
+					segment_max_attr_offset = AttrNumberGetAttrOffset(segment_max_attr_number);
+					segment_nulls_attr_offset = AttrNumberGetAttrOffset(segment_nulls_attr_number);
+					segment_min_max_builder =
+						segment_meta_min_max_builder_create(column_attr->atttypid,
+															column_attr->attcollation);
+				}
+			}
+
+			if (segment_bloom1_col_name != NULL)
+			{
+				AttrNumber segment_bloom1_attr_number =
+					get_attnum(compressed_table->rd_id, segment_bloom1_col_name);
+
+				if (segment_bloom1_attr_number != InvalidAttrNumber)
+				{
+					segment_bloom1_attr_offset =
+						AttrNumberGetAttrOffset(segment_bloom1_attr_number);
+					segment_bloom1_builder =
+						segment_meta_bloom_builder_create(column_attr->atttypid,
+														  column_attr->attcollation);
+				}
+			}
+
 			*column = (PerColumn){
 				.compressor = compressor_for_algorithm_and_type(compression_info->algo_id,
 																column_attr->atttypid),
 				.min_metadata_attr_offset = segment_min_attr_offset,
 				.max_metadata_attr_offset = segment_max_attr_offset,
+				.nulls_metadata_attr_offset = segment_nulls_attr_offset,
 				.min_max_metadata_builder = segment_min_max_builder,
+				.bloom1_metadata_attr_offset = segment_bloom1_attr_offset,
+				.bloom1_metadata_builder = segment_bloom1_builder,
 				.segmentby_column_index = -1,
 			};
+
+			if (column->compressor->append_vals != NULL && column_attr->attbyval)
+			{
+				column->buffered_values =
+					palloc(sizeof(Datum) * row_compressor->max_rows_per_compression);
+				column->buffered_nulls =
+					palloc(sizeof(bool) * row_compressor->max_rows_per_compression);
+			}
 		}
 		else
 		{
@@ -1080,6 +2011,8 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 				.segmentby_column_index = compression_info->segmentby_column_index,
 				.min_metadata_attr_offset = -1,
 				.max_metadata_attr_offset = -1,
+				.nulls_metadata_attr_offset = -1,
+				.bloom1_metadata_attr_offset = -1,
 			};
 		}
 	}
@@ -1091,14 +2024,50 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 								   row_compressor->n_input_columns);
 }
 
+/*
+ * Add the next row of the input sorted by the segmentby and orderby columns,
+ * flushing the compressed row when it is full or the segment changes.
+ */
+static void
+row_compressor_process_ordered_slot(RowCompressor *row_compressor, TupleTableSlot *slot,
+									CommandId mycid)
+{
+	bool changed_groups, compressed_row_is_full;
+	MemoryContext old_ctx;
+	slot_getallattrs(slot);
+	old_ctx = MemoryContextSwitchTo(row_compressor->per_row_ctx);
+
+	/* first time through */
+	if (row_compressor->first_iteration)
+	{
+		row_compressor_update_group(row_compressor, slot);
+		row_compressor->first_iteration = false;
+	}
+
+	changed_groups = row_compressor_new_row_is_in_new_group(row_compressor, slot);
+	compressed_row_is_full =
+		row_compressor->rows_compressed_into_current_value >=
+		row_compressor->max_rows_per_compression;
+	if (compressed_row_is_full || changed_groups)
+	{
+		if (row_compressor->rows_compressed_into_current_value > 0)
+			row_compressor_flush(row_compressor, mycid, changed_groups);
+		if (changed_groups)
+			row_compressor_update_group(row_compressor, slot);
+	}
+
+	row_compressor_append_row(row_compressor, slot);
+	MemoryContextSwitchTo(old_ctx);
+}
+
 static void
 row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate *sorted_rel,
 								  TupleDesc sorted_desc)
 {
-	CommandId mycid = GetCurrentCommandId(true);
+	/* the parallel compression workers don't insert themselves */
+	CommandId mycid = GetCurrentCommandId(row_compressor->output_queue == NULL);
 	TupleTableSlot *slot = MakeTupleTableSlot(sorted_desc, &TTSOpsMinimalTuple);
 	bool got_tuple;
-	bool first_iteration = true;
 
 	for (got_tuple = tuplesort_gettupleslot(sorted_rel,
 											true /*=forward*/,
@@ -1112,31 +2081,7 @@ row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate
 											slot,
 											NULL /*=abbrev*/))
 	{
-		bool changed_groups, compressed_row_is_full;
-		MemoryContext old_ctx;
-		slot_getallattrs(slot);
-		old_ctx = MemoryContextSwitchTo(row_compressor->per_row_ctx);
-
-		/* first time through */
-		if (first_iteration)
-		{
-			row_compressor_update_group(row_compressor, slot);
-			first_iteration = false;
-		}
-
-		changed_groups = row_compressor_new_row_is_in_new_group(row_compressor, slot);
-		compressed_row_is_full =
-			row_compressor->rows_compressed_into_current_value >= MAX_ROWS_PER_COMPRESSION;
-		if (compressed_row_is_full || changed_groups)
-		{
-			if (row_compressor->rows_compressed_into_current_value > 0)
-				row_compressor_flush(row_compressor, mycid, changed_groups);
-			if (changed_groups)
-				row_compressor_update_group(row_compressor, slot);
-		}
-
-		row_compressor_append_row(row_compressor, slot);
-		MemoryContextSwitchTo(old_ctx);
+		row_compressor_process_ordered_slot(row_compressor, slot, mycid);
 		ExecClearTuple(slot);
 	}
 
@@ -1146,14 +2091,14 @@ row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate
 	ExecDropSingleTupleTableSlot(slot);
 }
 
+/* remember the segment by values of the row as the current segment */
 static void
-row_compressor_update_group(RowCompressor *row_compressor, TupleTableSlot *row)
+row_compressor_update_segment_info(RowCompressor *row_compressor, TupleTableSlot *row)
 {
 	int col;
 	/* save original memory context */
 	const MemoryContext oldcontext = CurrentMemoryContext;
 
-	Assert(row_compressor->rows_compressed_into_current_value == 0);
 	Assert(row_compressor->n_input_columns <= row->tts_nvalid);
 
 	MemoryContextSwitchTo(row_compressor->per_row_ctx->parent);
@@ -1175,6 +2120,14 @@ row_compressor_update_group(RowCompressor *row_compressor, TupleTableSlot *row)
 	}
 	/* switch to original memory context */
 	MemoryContextSwitchTo(oldcontext);
+}
+
+static void
+row_compressor_update_group(RowCompressor *row_compressor, TupleTableSlot *row)
+{
+	Assert(row_compressor->rows_compressed_into_current_value == 0);
+
+	row_compressor_update_segment_info(row_compressor, row);
 
 	/*
 	 * The sequence number of the compressed tuple is per segment by grouping
@@ -1217,13 +2170,32 @@ row_compressor_new_row_is_in_new_group(RowCompressor *row_compressor, TupleTable
 	return false;
 }
 
+/* hand the buffered values of the column to its compressor in one call */
+static void
+per_column_append_buffered(PerColumn *column)
+{
+	if (column->n_buffered == 0)
+		return;
+
+	column->compressor->append_vals(column->compressor,
+									column->buffered_values,
+									column->buffered_nulls,
+									column->n_buffered);
+	column->n_buffered = 0;
+}
+
 static void
 row_compressor_append_row(RowCompressor *row_compressor, TupleTableSlot *row)
 {
 	int col;
+
+	if (row_compressor->sample != NULL)
+		sample_stats_add(row_compressor->sample, row);
+
 	for (col = 0; col < row_compressor->n_input_columns; col++)
 	{
-		Compressor *compressor = row_compressor->per_column[col].compressor;
+		PerColumn *column = &row_compressor->per_column[col];
+		Compressor *compressor = column->compressor;
 		bool is_null;
 		Datum val;
 
@@ -1235,20 +2207,35 @@ row_compressor_append_row(RowCompressor *row_compressor, TupleTableSlot *row)
 		 * useless overhead here, and we should just access the array directly.
 		 */
 		val = slot_getattr(row, AttrOffsetGetAttrNumber(col), &is_null);
-		if (is_null)
+		if (column->buffered_values != NULL)
 		{
+			if ((uint32) column->n_buffered == row_compressor->max_rows_per_compression)
+				per_column_append_buffered(column);
+			column->buffered_values[column->n_buffered] = val;
+			column->buffered_nulls[column->n_buffered] = is_null;
+			column->n_buffered++;
+		}
+		else if (is_null)
 			compressor->append_null(compressor);
+		else
+			compressor->append_val(compressor, val);
+
+		if (is_null)
+		{
 			if (row_compressor->per_column[col].min_max_metadata_builder != NULL)
 				segment_meta_min_max_builder_update_null(
 					row_compressor->per_column[col].min_max_metadata_builder);
 		}
 		else
 		{
-			compressor->append_val(compressor, val);
 			if (row_compressor->per_column[col].min_max_metadata_builder != NULL)
 				segment_meta_min_max_builder_update_val(row_compressor->per_column[col]
 															.min_max_metadata_builder,
 														val);
+			if (row_compressor->per_column[col].bloom1_metadata_builder != NULL)
+				segment_meta_bloom_builder_update_val(row_compressor->per_column[col]
+														  .bloom1_metadata_builder,
+													  val);
 		}
 	}
 
@@ -1279,6 +2266,8 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 			void *compressed_data;
 			Assert(column->segment_info == NULL);
 
+			if (column->buffered_values != NULL)
+				per_column_append_buffered(column);
 			compressed_data = compressor->finish(compressor);
 
 			/* non-segment columns are NULL iff all the values are NULL */
@@ -1309,6 +2298,25 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 					row_compressor->compressed_is_null[column->min_metadata_attr_offset] = true;
 					row_compressor->compressed_is_null[column->max_metadata_attr_offset] = true;
 				}
+
+				if (column->nulls_metadata_attr_offset >= 0)
+				{
+					row_compressor->compressed_is_null[column->nulls_metadata_attr_offset] = false;
+					row_compressor->compressed_values[column->nulls_metadata_attr_offset] =
+						Int32GetDatum(segment_meta_min_max_builder_null_count(
+							column->min_max_metadata_builder));
+				}
+			}
+
+			if (column->bloom1_metadata_builder != NULL)
+			{
+				/* the bloom filter is NULL when all the values are NULL */
+				bool empty = segment_meta_bloom_builder_empty(column->bloom1_metadata_builder);
+
+				row_compressor->compressed_is_null[column->bloom1_metadata_attr_offset] = empty;
+				if (!empty)
+					row_compressor->compressed_values[column->bloom1_metadata_attr_offset] =
+						segment_meta_bloom_builder_finish(column->bloom1_metadata_builder);
 			}
 		}
 		else if (column->segment_info != NULL)
@@ -1335,14 +2343,27 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 	compressed_tuple = heap_form_tuple(RelationGetDescr(row_compressor->compressed_table),
 									   row_compressor->compressed_values,
 									   row_compressor->compressed_is_null);
-	Assert(row_compressor->bistate != NULL);
-	heap_insert(row_compressor->compressed_table,
-				compressed_tuple,
-				mycid,
-				0 /*=options*/,
-				row_compressor->bistate);
+	if (row_compressor->output_queue != NULL)
+	{
+		shm_mq_result result = shm_mq_send_compat(row_compressor->output_queue,
+												  compressed_tuple->t_len,
+												  compressed_tuple->t_data,
+												  false /*=nowait*/);
+
+		if (result != SHM_MQ_SUCCESS)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("could not send compressed tuple to parallel compression leader")));
+	}
+	else
+	{
+		/* takes ownership of the tuple */
+		row_compressor_insert_tuple(row_compressor, compressed_tuple, mycid);
+		compressed_tuple = NULL;
+	}
 
-	heap_freetuple(compressed_tuple);
+	if (compressed_tuple != NULL)
+		heap_freetuple(compressed_tuple);
 
 	/* free the compressed values now that we're done with them (the old compressor is freed in
 	 * finish()) */
@@ -1356,7 +2377,12 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 		compressed_col = row_compressor->uncompressed_col_to_compressed_col[col];
 		Assert(compressed_col >= 0);
 		if (row_compressor->compressed_is_null[compressed_col])
+		{
+			/* all the values were NULL, but the builders still count the NULLs */
+			if (column->min_max_metadata_builder != NULL)
+				segment_meta_min_max_builder_reset(column->min_max_metadata_builder);
 			continue;
+		}
 
 		/* don't free the segment-bys if we've overflowed the row, we still need them */
 		if (column->segment_info != NULL && !changed_groups)
@@ -1381,6 +2407,18 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 			segment_meta_min_max_builder_reset(column->min_max_metadata_builder);
 		}
 
+		if (column->bloom1_metadata_builder != NULL)
+		{
+			if (!row_compressor->compressed_is_null[column->bloom1_metadata_attr_offset])
+			{
+				pfree(DatumGetPointer(
+					row_compressor->compressed_values[column->bloom1_metadata_attr_offset]));
+				row_compressor->compressed_values[column->bloom1_metadata_attr_offset] = 0;
+				row_compressor->compressed_is_null[column->bloom1_metadata_attr_offset] = true;
+			}
+			segment_meta_bloom_builder_reset(column->bloom1_metadata_builder);
+		}
+
 		row_compressor->compressed_values[compressed_col] = 0;
 		row_compressor->compressed_is_null[compressed_col] = true;
 	}
@@ -1391,13 +2429,516 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 	MemoryContextReset(row_compressor->per_row_ctx);
 }
 
+/*
+ * Write the buffered compressed tuples with a single table_multi_insert call.
+ */
+static void
+row_compressor_flush_inserts(RowCompressor *row_compressor)
+{
+	if (row_compressor->n_insert_slots == 0)
+		return;
+
+	table_multi_insert(row_compressor->compressed_table,
+					   row_compressor->insert_slots,
+					   row_compressor->n_insert_slots,
+					   row_compressor->insert_cid,
+					   row_compressor->insert_options,
+					   row_compressor->bistate);
+
+	for (int i = 0; i < row_compressor->n_insert_slots; i++)
+		ExecClearTuple(row_compressor->insert_slots[i]);
+
+	row_compressor->n_insert_slots = 0;
+	row_compressor->insert_bytes = 0;
+}
+
+/*
+ * Forget the compressed tuples written so far, before the compressed table is
+ * truncated to start over.
+ */
+static void
+row_compressor_discard(RowCompressor *row_compressor)
+{
+	Assert(row_compressor->rows_compressed_into_current_value == 0);
+
+	for (int i = 0; i < row_compressor->n_insert_slots; i++)
+		ExecClearTuple(row_compressor->insert_slots[i]);
+
+	row_compressor->n_insert_slots = 0;
+	row_compressor->insert_bytes = 0;
+	/* the truncation can't drop a buffer we still have pinned */
+	if (row_compressor->bistate != NULL)
+		ReleaseBulkInsertStatePin(row_compressor->bistate);
+	row_compressor->first_iteration = true;
+	row_compressor->rowcnt_pre_compression = 0;
+	row_compressor->num_compressed_rows = 0;
+	if (row_compressor->sample != NULL)
+		sample_stats_reset(row_compressor->sample);
+}
+
+/*
+ * Insert a compressed tuple into the compressed chunk, taking ownership of it.
+ *
+ * When the compressed chunk already has indexes that we have to maintain, the
+ * tuple is inserted and indexed right away. Otherwise the indexes are rebuilt
+ * with a sorted build once compression is done, so the tuples are buffered and
+ * written in bulk with table_multi_insert, which fills the heap pages without
+ * looking for free space for every single tuple.
+ */
+static void
+row_compressor_insert_tuple(RowCompressor *row_compressor, HeapTuple compressed_tuple,
+							CommandId mycid)
+{
+	TupleTableSlot *slot;
+
+	Assert(row_compressor->bistate != NULL);
+
+	if (row_compressor->index_state != NULL || row_compressor->insert_slots == NULL)
+	{
+		heap_insert(row_compressor->compressed_table,
+					compressed_tuple,
+					mycid,
+					row_compressor->insert_options,
+					row_compressor->bistate);
+		if (row_compressor->index_state != NULL)
+			ts_catalog_index_insert(row_compressor->index_state, compressed_tuple);
+		heap_freetuple(compressed_tuple);
+		return;
+	}
+
+	Assert(row_compressor->n_insert_slots == 0 || row_compressor->insert_cid == mycid);
+	slot = row_compressor->insert_slots[row_compressor->n_insert_slots];
+	if (slot == NULL)
+	{
+		MemoryContext oldcxt =
+			MemoryContextSwitchTo(GetMemoryChunkContext(row_compressor->insert_slots));
+
+		slot = MakeSingleTupleTableSlot(RelationGetDescr(row_compressor->compressed_table),
+										&TTSOpsHeapTuple);
+		row_compressor->insert_slots[row_compressor->n_insert_slots] = slot;
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	ExecStoreHeapTuple(compressed_tuple, slot, true /*=shouldFree*/);
+	row_compressor->insert_cid = mycid;
+	row_compressor->insert_bytes += compressed_tuple->t_len;
+	row_compressor->n_insert_slots++;
+
+	if (row_compressor->n_insert_slots >= MAX_BUFFERED_COMPRESSED_TUPLES ||
+		row_compressor->insert_bytes >= MAX_BUFFERED_COMPRESSED_BYTES)
+		row_compressor_flush_inserts(row_compressor);
+}
+
 static void
 row_compressor_finish(RowCompressor *row_compressor)
 {
+	row_compressor_flush_inserts(row_compressor);
+
+	if (row_compressor->insert_slots != NULL)
+	{
+		for (int i = 0; i < MAX_BUFFERED_COMPRESSED_TUPLES; i++)
+		{
+			if (row_compressor->insert_slots[i] == NULL)
+				break;
+			ExecDropSingleTupleTableSlot(row_compressor->insert_slots[i]);
+		}
+		pfree(row_compressor->insert_slots);
+		row_compressor->insert_slots = NULL;
+	}
+
 	if (row_compressor->bistate)
 		FreeBulkInsertState(row_compressor->bistate);
 }
 
+/**************************
+ ** parallel compression **
+ **************************/
+
+/*
+ * The rows of the chunk are split into partitions by the hash of their
+ * segmentby values, so that all the rows of a segment are in the same
+ * partition. Each parallel worker claims the partitions one by one, sorts the
+ * rows of the partition and compresses them with its own RowCompressor.
+ *
+ * The parallel workers can't insert into the compressed chunk, and the leader
+ * can't insert either while in parallel mode, because the TOAST values need
+ * new OIDs. So the workers send the compressed tuples to the leader which
+ * buffers them in a tuplestore and inserts them after the workers are done.
+ * The compressed tuples are much smaller than the rows they compress, so the
+ * buffering is cheap compared to the sorting and the compression.
+ */
+#define PARALLEL_KEY_COMPRESS_SHARED UINT64CONST(0xA000000000000001)
+#define PARALLEL_KEY_COMPRESS_QUEUES UINT64CONST(0xA000000000000002)
+#define COMPRESS_PARALLEL_QUEUE_SIZE 65536
+
+typedef struct CompressParallelShared
+{
+	Oid in_relid;
+	Oid out_relid;
+	int num_partitions;
+	int sort_mem;
+	/* the next partition to be claimed by a worker */
+	pg_atomic_uint32 next_partition;
+
+	/* the number of the compressed rows, summed up by the workers */
+	slock_t mutex;
+	int64 rowcnt_pre_compression;
+
+	int num_compression_infos;
+	ColumnCompressionInfo column_compression_info[FLEXIBLE_ARRAY_MEMBER];
+} CompressParallelShared;
+
+PGDLLEXPORT void compress_chunk_parallel_main(dsm_segment *seg, shm_toc *toc);
+
+/*
+ * The number of parallel workers to compress the chunk with, 0 if it can't
+ * be compressed in parallel. A chunk without segmentby columns is a single
+ * partition, and we need the hash functions of the segmentby columns to
+ * partition the chunk.
+ */
+static int
+compress_chunk_parallel_workers(int n_keys, const ColumnCompressionInfo **keys, TupleDesc in_desc)
+{
+	bool has_segmentby = false;
+
+	if (ts_guc_compress_parallel_workers == 0 || IsInParallelMode())
+		return 0;
+
+	for (int i = 0; i < n_keys && COMPRESSIONCOL_IS_SEGMENT_BY(keys[i]); i++)
+	{
+		for (int j = 0; j < in_desc->natts; j++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(in_desc, j);
+
+			if (attr->attisdropped || namestrcmp(&attr->attname, NameStr(keys[i]->attname)) != 0)
+				continue;
+
+			if (!OidIsValid(lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC)->hash_proc))
+				return 0;
+		}
+		has_segmentby = true;
+	}
+
+	return has_segmentby ? ts_guc_compress_parallel_workers : 0;
+}
+
+static uint32
+compress_chunk_partition_hash(TupleTableSlot *slot, int n_segment_keys, AttrNumber *attnos,
+							  FmgrInfo **hash_procs, Oid *collations)
+{
+	uint32 hash = 0;
+
+	for (int i = 0; i < n_segment_keys; i++)
+	{
+		bool is_null;
+		Datum val = slot_getattr(slot, attnos[i], &is_null);
+
+		/* rotate and xor like the hash joins do to combine the hashes */
+		hash = (hash << 1) | (hash >> 31);
+		if (!is_null)
+			hash ^= DatumGetUInt32(FunctionCall1Coll(hash_procs[i], collations[i], val));
+	}
+
+	return hash;
+}
+
+/*
+ * Sort the rows of one partition of the chunk, in a parallel worker.
+ */
+static Tuplesortstate *
+compress_chunk_sort_partition(Relation in_rel, int n_keys, const ColumnCompressionInfo **keys,
+							  CompressParallelShared *shared, uint32 partition)
+{
+	TupleDesc tupDesc = RelationGetDescr(in_rel);
+	Tuplesortstate *tuplesortstate;
+	HeapTuple tuple;
+	TableScanDesc heapScan;
+	TupleTableSlot *heap_tuple_slot = MakeTupleTableSlot(tupDesc, &TTSOpsHeapTuple);
+	AttrNumber *attnos = palloc(sizeof(*attnos) * n_keys);
+	FmgrInfo **hash_procs = palloc(sizeof(*hash_procs) * n_keys);
+	Oid *collations = palloc(sizeof(*collations) * n_keys);
+	int n_segment_keys = 0;
+
+	while (n_segment_keys < n_keys && COMPRESSIONCOL_IS_SEGMENT_BY(keys[n_segment_keys]))
+	{
+		AttrNumber attno =
+			get_attnum(RelationGetRelid(in_rel), NameStr(keys[n_segment_keys]->attname));
+		Form_pg_attribute attr = TupleDescAttr(tupDesc, AttrNumberGetAttrOffset(attno));
+
+		attnos[n_segment_keys] = attno;
+		hash_procs[n_segment_keys] =
+			&lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC_FINFO)->hash_proc_finfo;
+		collations[n_segment_keys] = attr->attcollation;
+		n_segment_keys++;
+	}
+
+	tuplesortstate = compress_chunk_begin_sort(in_rel, n_keys, keys, shared->sort_mem);
+
+	/* the workers can't take new snapshots, use the one the leader took */
+	heapScan = table_beginscan(in_rel, GetActiveSnapshot(), 0, (ScanKey) NULL);
+	for (tuple = heap_getnext(heapScan, ForwardScanDirection); tuple != NULL;
+		 tuple = heap_getnext(heapScan, ForwardScanDirection))
+	{
+		ExecStoreHeapTuple(tuple, heap_tuple_slot, false);
+
+		if (compress_chunk_partition_hash(heap_tuple_slot,
+										  n_segment_keys,
+										  attnos,
+										  hash_procs,
+										  collations) %
+				shared->num_partitions ==
+			partition)
+			tuplesort_puttupleslot(tuplesortstate, heap_tuple_slot);
+	}
+
+	heap_endscan(heapScan);
+	ExecDropSingleTupleTableSlot(heap_tuple_slot);
+
+	tuplesort_performsort(tuplesortstate);
+
+	return tuplesortstate;
+}
+
+void
+compress_chunk_parallel_main(dsm_segment *seg, shm_toc *toc)
+{
+	CompressParallelShared *shared = shm_toc_lookup(toc, PARALLEL_KEY_COMPRESS_SHARED, false);
+	char *queues = shm_toc_lookup(toc, PARALLEL_KEY_COMPRESS_QUEUES, false);
+	shm_mq *mq = (shm_mq *) (queues + ParallelWorkerNumber * COMPRESS_PARALLEL_QUEUE_SIZE);
+	const ColumnCompressionInfo **column_compression_info;
+	const ColumnCompressionInfo **keys;
+	RowCompressor row_compressor;
+	shm_mq_handle *mqh;
+	int16 *in_column_offsets;
+	uint32 partition;
+	int n_keys;
+
+	shm_mq_set_sender(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+
+	/* the leader holds the stronger locks, the lock group shares them */
+	Relation in_rel = table_open(shared->in_relid, AccessShareLock);
+	Relation out_rel = table_open(shared->out_relid, AccessShareLock);
+	TupleDesc in_desc = RelationGetDescr(in_rel);
+
+	column_compression_info =
+		palloc(sizeof(*column_compression_info) * shared->num_compression_infos);
+	for (int i = 0; i < shared->num_compression_infos; i++)
+		column_compression_info[i] = &shared->column_compression_info[i];
+
+	in_column_offsets = compress_chunk_populate_keys(shared->in_relid,
+													 column_compression_info,
+													 shared->num_compression_infos,
+													 &n_keys,
+													 &keys);
+
+	row_compressor_init(&row_compressor,
+						in_desc,
+						out_rel,
+						shared->num_compression_infos,
+						column_compression_info,
+						in_column_offsets,
+						RelationGetDescr(out_rel)->natts,
+						false /*need_bistate*/);
+	row_compressor.output_queue = mqh;
+
+	for (partition = pg_atomic_fetch_add_u32(&shared->next_partition, 1);
+		 partition < (uint32) shared->num_partitions;
+		 partition = pg_atomic_fetch_add_u32(&shared->next_partition, 1))
+	{
+		Tuplesortstate *sorted_rel =
+			compress_chunk_sort_partition(in_rel, n_keys, keys, shared, partition);
+
+		row_compressor_append_sorted_rows(&row_compressor, sorted_rel, in_desc);
+		tuplesort_end(sorted_rel);
+	}
+
+	SpinLockAcquire(&shared->mutex);
+	shared->rowcnt_pre_compression += row_compressor.rowcnt_pre_compression;
+	SpinLockRelease(&shared->mutex);
+
+	row_compressor_finish(&row_compressor);
+	shm_mq_detach(mqh);
+
+	table_close(out_rel, AccessShareLock);
+	table_close(in_rel, AccessShareLock);
+}
+
+/*
+ * Receive the compressed tuples from the workers until all of them detach
+ * from their queues.
+ */
+static void
+compress_chunk_parallel_receive(ParallelContext *pcxt, shm_mq_handle **queues,
+								Tuplestorestate *store)
+{
+	int nworkers = pcxt->nworkers_launched;
+	bool *detached = palloc0(sizeof(*detached) * nworkers);
+	int nactive = nworkers;
+
+	while (nactive > 0)
+	{
+		bool received = false;
+
+		for (int i = 0; i < nworkers; i++)
+		{
+			HeapTupleData tuple;
+			shm_mq_result result;
+			Size nbytes;
+			void *data;
+
+			if (detached[i])
+				continue;
+
+			result = shm_mq_receive(queues[i], &nbytes, &data, true /*=nowait*/);
+			if (result == SHM_MQ_WOULD_BLOCK)
+				continue;
+
+			if (result == SHM_MQ_DETACHED)
+			{
+				detached[i] = true;
+				nactive--;
+				continue;
+			}
+
+			tuple.t_len = nbytes;
+			tuple.t_data = data;
+			ItemPointerSetInvalid(&tuple.t_self);
+			tuple.t_tableOid = InvalidOid;
+			tuplestore_puttuple(store, &tuple);
+			received = true;
+		}
+
+		if (!received && nactive > 0)
+		{
+			(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0, WAIT_EVENT_MQ_RECEIVE);
+			ResetLatch(MyLatch);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	pfree(detached);
+}
+
+/*
+ * Compress the chunk in parallel workers, see the comment above. Returns
+ * false if no workers could be launched, the caller compresses the chunk by
+ * itself then.
+ */
+static bool
+compress_chunk_parallel(RowCompressor *row_compressor, Relation in_rel, Relation out_rel,
+						const ColumnCompressionInfo **column_compression_info,
+						int num_compression_infos, int nworkers)
+{
+	Size shared_size = add_size(offsetof(CompressParallelShared, column_compression_info),
+								mul_size(sizeof(ColumnCompressionInfo), num_compression_infos));
+	Size queues_size = mul_size(COMPRESS_PARALLEL_QUEUE_SIZE, nworkers);
+	CompressParallelShared *shared;
+	ParallelContext *pcxt;
+	shm_mq_handle **queues;
+	char *queue_space;
+	Tuplestorestate *store;
+	TupleTableSlot *slot;
+	CommandId mycid;
+
+	/* the workers get the active snapshot of the leader */
+	PushActiveSnapshot(GetLatestSnapshot());
+	EnterParallelMode();
+	pcxt = CreateParallelContext(EXTENSION_TSL_SO, "compress_chunk_parallel_main", nworkers);
+
+	shm_toc_estimate_chunk(&pcxt->estimator, shared_size);
+	shm_toc_estimate_chunk(&pcxt->estimator, queues_size);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+	InitializeParallelDSM(pcxt);
+
+	shared = shm_toc_allocate(pcxt->toc, shared_size);
+	shared->in_relid = RelationGetRelid(in_rel);
+	shared->out_relid = RelationGetRelid(out_rel);
+	shared->num_partitions = nworkers;
+	shared->sort_mem = Max(maintenance_work_mem / nworkers, 64);
+	pg_atomic_init_u32(&shared->next_partition, 0);
+	SpinLockInit(&shared->mutex);
+	shared->rowcnt_pre_compression = 0;
+	shared->num_compression_infos = num_compression_infos;
+	for (int i = 0; i < num_compression_infos; i++)
+		shared->column_compression_info[i] = *column_compression_info[i];
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COMPRESS_SHARED, shared);
+
+	queue_space = shm_toc_allocate(pcxt->toc, queues_size);
+	queues = palloc(sizeof(*queues) * nworkers);
+	for (int i = 0; i < nworkers; i++)
+	{
+		shm_mq *mq = shm_mq_create(queue_space + i * COMPRESS_PARALLEL_QUEUE_SIZE,
+								   COMPRESS_PARALLEL_QUEUE_SIZE);
+
+		shm_mq_set_receiver(mq, MyProc);
+		queues[i] = shm_mq_attach(mq, pcxt->seg, NULL);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COMPRESS_QUEUES, queue_space);
+
+	/* no workers are launched when the DSM segment couldn't be created either */
+	LaunchParallelWorkers(pcxt);
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		PopActiveSnapshot();
+		return false;
+	}
+
+#ifdef TS_DEBUG
+	const char *compression_path =
+		GetConfigOption("timescaledb.show_compression_path_info", true, false);
+	if (compression_path != NULL && strcmp(compression_path, "on") == 0)
+		elog(INFO, "compress_chunk_parallel_start");
+#endif
+
+	/* a worker that fails to start would never attach to its queue */
+	for (int i = 0; i < pcxt->nworkers_launched; i++)
+		shm_mq_set_handle(queues[i], pcxt->worker[i].bgwhandle);
+
+	store = tuplestore_begin_heap(false, false, maintenance_work_mem);
+	compress_chunk_parallel_receive(pcxt, queues, store);
+
+	WaitForParallelWorkersToFinish(pcxt);
+	row_compressor->rowcnt_pre_compression = shared->rowcnt_pre_compression;
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+	PopActiveSnapshot();
+
+	/*
+	 * The serial path analyzes the chunk after reading it too. The leader
+	 * doesn't see the rows of the chunk, so it can't sample them.
+	 */
+	if (row_compressor->sample != NULL)
+	{
+		sample_stats_free(row_compressor->sample);
+		row_compressor->sample = NULL;
+	}
+	run_analyze_on_chunk(RelationGetRelid(in_rel));
+
+	mycid = GetCurrentCommandId(true);
+	slot = MakeSingleTupleTableSlot(RelationGetDescr(out_rel), &TTSOpsMinimalTuple);
+	while (tuplestore_gettupleslot(store, true /*=forward*/, false /*=copy*/, slot))
+	{
+		bool should_free;
+		HeapTuple compressed_tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+
+		if (!should_free)
+			compressed_tuple = heap_copytuple(compressed_tuple);
+
+		row_compressor_insert_tuple(row_compressor, compressed_tuple, mycid);
+		row_compressor->num_compressed_rows++;
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+	tuplestore_end(store);
+
+	return true;
+}
+
 /******************
  ** segment_info **
  ******************/
@@ -1506,10 +3047,26 @@ typedef struct RowDecompressor
 
 	CommandId mycid;
 	BulkInsertState bistate;
+	int insert_options;
+
+	/*
+	 * if set, the decompressed rows of a compressed row are written with a
+	 * single table_multi_insert call, only used without index_rri
+	 */
+	TupleTableSlot **insert_slots;
+	int n_insert_slots;
 
 	/* cache memory used to store the decompressed datums/is_null for form_tuple */
 	Datum *decompressed_datums;
 	bool *decompressed_is_nulls;
+
+	/* if set, the indexes of out_rel are updated for each decompressed row */
+	ResultRelInfo *index_rri;
+	EState *estate;
+	TupleTableSlot *index_slot;
+
+	/* the parallel workers send the decompressed tuples to the leader instead */
+	shm_mq_handle *output_queue;
 } RowDecompressor;
 
 static PerCompressedColumn *create_per_compressed_column(TupleDesc in_desc, TupleDesc out_desc,
@@ -1521,6 +3078,48 @@ static void populate_per_compressed_columns_from_data(PerCompressedColumn *per_c
 static void row_decompressor_decompress_row(RowDecompressor *row_decompressor);
 static bool per_compressed_col_get_data(PerCompressedColumn *per_compressed_col,
 										Datum *decompressed_datums, bool *decompressed_is_nulls);
+static RowDecompressor build_decompressor(Relation in_rel, Relation out_rel);
+static int decompress_chunk_parallel_workers(void);
+static bool decompress_chunk_parallel(Relation in_rel, Relation out_rel, int nworkers);
+
+static RowDecompressor
+build_decompressor(Relation in_rel, Relation out_rel)
+{
+	TupleDesc in_desc = RelationGetDescr(in_rel);
+	TupleDesc out_desc = RelationGetDescr(out_rel);
+
+	Oid compressed_data_type_oid = ts_custom_type_cache_get(CUSTOM_TYPE_COMPRESSED_DATA)->type_oid;
+
+	Assert(OidIsValid(compressed_data_type_oid));
+
+	RowDecompressor decompressor = {
+		.per_compressed_cols = create_per_compressed_column(in_desc,
+															out_desc,
+															RelationGetRelid(out_rel),
+															compressed_data_type_oid),
+		.num_compressed_columns = in_desc->natts,
+
+		.out_desc = out_desc,
+		.out_rel = out_rel,
+
+		/* the parallel decompression workers don't insert themselves */
+		.mycid = IsParallelWorker() ? InvalidCommandId : GetCurrentCommandId(true),
+		.bistate = IsParallelWorker() ? NULL : GetBulkInsertState(),
+
+		/* cache memory used to store the decompressed datums/is_null for form_tuple */
+		.decompressed_datums = palloc(sizeof(Datum) * out_desc->natts),
+		.decompressed_is_nulls = palloc(sizeof(bool) * out_desc->natts),
+	};
+	/*
+	 * We need to make sure decompressed_is_nulls is in a defined state. While this
+	 * will get written for normal columns it will not get written for dropped columns
+	 * since dropped columns don't exist in the compressed chunk so we initiallize
+	 * with true here.
+	 */
+	memset(decompressor.decompressed_is_nulls, true, out_desc->natts);
+
+	return decompressor;
+}
 
 void
 decompress_chunk(Oid in_table, Oid out_table)
@@ -1542,37 +3141,11 @@ decompress_chunk(Oid in_table, Oid out_table)
 	Relation in_rel = relation_open(in_table, ExclusiveLock);
 
 	TupleDesc in_desc = RelationGetDescr(in_rel);
-	TupleDesc out_desc = RelationGetDescr(out_rel);
-
-	Oid compressed_data_type_oid = ts_custom_type_cache_get(CUSTOM_TYPE_COMPRESSED_DATA)->type_oid;
-
-	Assert(OidIsValid(compressed_data_type_oid));
+	int nworkers = decompress_chunk_parallel_workers();
 
+	if (nworkers == 0 || !decompress_chunk_parallel(in_rel, out_rel, nworkers))
 	{
-		RowDecompressor decompressor = {
-			.per_compressed_cols = create_per_compressed_column(in_desc,
-																out_desc,
-																out_table,
-																compressed_data_type_oid),
-			.num_compressed_columns = in_desc->natts,
-
-			.out_desc = out_desc,
-			.out_rel = out_rel,
-
-			.mycid = GetCurrentCommandId(true),
-			.bistate = GetBulkInsertState(),
-
-			/* cache memory used to store the decompressed datums/is_null for form_tuple */
-			.decompressed_datums = palloc(sizeof(Datum) * out_desc->natts),
-			.decompressed_is_nulls = palloc(sizeof(bool) * out_desc->natts),
-		};
-		/*
-		 * We need to make sure decompressed_is_nulls is in a defined state. While this
-		 * will get written for normal columns it will not get written for dropped columns
-		 * since dropped columns don't exist in the compressed chunk so we initiallize
-		 * with true here.
-		 */
-		memset(decompressor.decompressed_is_nulls, true, out_desc->natts);
+		RowDecompressor decompressor = build_decompressor(in_rel, out_rel);
 
 		Datum *compressed_datums = palloc(sizeof(*compressed_datums) * in_desc->natts);
 		bool *compressed_is_nulls = palloc(sizeof(*compressed_is_nulls) * in_desc->natts);
@@ -1584,6 +3157,11 @@ decompress_chunk(Oid in_table, Oid out_table)
 								  "decompress chunk per-compressed row",
 								  ALLOCSET_DEFAULT_SIZES);
 
+		/* the indexes are rebuilt below, so the rows can be written in bulk */
+		decompressor.insert_slots =
+			palloc0(sizeof(TupleTableSlot *) * MAX_BUFFERED_DECOMPRESSED_TUPLES);
+		decompressor.insert_options = compression_insert_options(out_rel);
+
 		for (compressed_tuple = heap_getnext(heapScan, ForwardScanDirection);
 			 compressed_tuple != NULL;
 			 compressed_tuple = heap_getnext(heapScan, ForwardScanDirection))
@@ -1606,6 +3184,12 @@ decompress_chunk(Oid in_table, Oid out_table)
 		}
 
 		heap_endscan(heapScan);
+		for (int i = 0; i < MAX_BUFFERED_DECOMPRESSED_TUPLES; i++)
+		{
+			if (decompressor.insert_slots[i] == NULL)
+				break;
+			ExecDropSingleTupleTableSlot(decompressor.insert_slots[i]);
+		}
 		FreeBulkInsertState(decompressor.bistate);
 	}
 
@@ -1722,6 +3306,53 @@ populate_per_compressed_columns_from_data(PerCompressedColumn *per_compressed_co
 	}
 }
 
+/*
+ * Write the buffered decompressed tuples with a single table_multi_insert call.
+ */
+static void
+row_decompressor_flush_inserts(RowDecompressor *row_decompressor)
+{
+	if (row_decompressor->n_insert_slots == 0)
+		return;
+
+	table_multi_insert(row_decompressor->out_rel,
+					   row_decompressor->insert_slots,
+					   row_decompressor->n_insert_slots,
+					   row_decompressor->mycid,
+					   row_decompressor->insert_options,
+					   row_decompressor->bistate);
+
+	for (int i = 0; i < row_decompressor->n_insert_slots; i++)
+		ExecClearTuple(row_decompressor->insert_slots[i]);
+
+	row_decompressor->n_insert_slots = 0;
+}
+
+/*
+ * Buffer a decompressed tuple for table_multi_insert, taking ownership of it.
+ */
+static void
+row_decompressor_buffer_tuple(RowDecompressor *row_decompressor, HeapTuple tuple)
+{
+	TupleTableSlot *slot = row_decompressor->insert_slots[row_decompressor->n_insert_slots];
+
+	if (slot == NULL)
+	{
+		MemoryContext oldcxt =
+			MemoryContextSwitchTo(GetMemoryChunkContext(row_decompressor->insert_slots));
+
+		slot = MakeSingleTupleTableSlot(row_decompressor->out_desc, &TTSOpsHeapTuple);
+		row_decompressor->insert_slots[row_decompressor->n_insert_slots] = slot;
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	ExecStoreHeapTuple(tuple, slot, true /*=shouldFree*/);
+	row_decompressor->n_insert_slots++;
+
+	if (row_decompressor->n_insert_slots >= MAX_BUFFERED_DECOMPRESSED_TUPLES)
+		row_decompressor_flush_inserts(row_decompressor);
+}
+
 static void
 row_decompressor_decompress_row(RowDecompressor *row_decompressor)
 {
@@ -1751,16 +3382,62 @@ row_decompressor_decompress_row(RowDecompressor *row_decompressor)
 			HeapTuple decompressed_tuple = heap_form_tuple(row_decompressor->out_desc,
 														   row_decompressor->decompressed_datums,
 														   row_decompressor->decompressed_is_nulls);
+
+			if (row_decompressor->output_queue != NULL)
+			{
+				shm_mq_result result = shm_mq_send_compat(row_decompressor->output_queue,
+														  decompressed_tuple->t_len,
+														  decompressed_tuple->t_data,
+														  false /*=nowait*/);
+
+				if (result != SHM_MQ_SUCCESS)
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not send decompressed tuple to parallel "
+									"decompression leader")));
+				heap_freetuple(decompressed_tuple);
+				wrote_data = true;
+				continue;
+			}
+
+			if (row_decompressor->insert_slots != NULL)
+			{
+				row_decompressor_buffer_tuple(row_decompressor, decompressed_tuple);
+				wrote_data = true;
+				continue;
+			}
+
 			heap_insert(row_decompressor->out_rel,
 						decompressed_tuple,
 						row_decompressor->mycid,
-						0 /*=options*/,
+						row_decompressor->insert_options,
 						row_decompressor->bistate);
 
+			if (row_decompressor->index_rri != NULL)
+			{
+				TupleTableSlot *slot = row_decompressor->index_slot;
+				List *recheck_indexes;
+
+				ExecStoreHeapTuple(decompressed_tuple, slot, false);
+				recheck_indexes = ExecInsertIndexTuplesCompat(row_decompressor->index_rri,
+															  slot,
+															  row_decompressor->estate,
+															  false,
+															  false,
+															  NULL,
+															  NIL);
+				list_free(recheck_indexes);
+				ExecClearTuple(slot);
+				ResetPerTupleExprContext(row_decompressor->estate);
+			}
+
 			heap_freetuple(decompressed_tuple);
 			wrote_data = true;
 		}
 	} while (!is_done);
+
+	/* the buffered tuples are in the memory of the compressed row */
+	row_decompressor_flush_inserts(row_decompressor);
 }
 
 /* populate the relevent index in an array from a per_compressed_col.
@@ -1805,13 +3482,696 @@ per_compressed_col_get_data(PerCompressedColumn *per_compressed_col, Datum *deco
 		return true;
 	}
 
-	decompressed_is_nulls[decompressed_column_offset] = decompressed.is_null;
-	if (decompressed.is_null)
-		decompressed_datums[decompressed_column_offset] = 0;
-	else
-		decompressed_datums[decompressed_column_offset] = decompressed.val;
+	decompressed_is_nulls[decompressed_column_offset] = decompressed.is_null;
+	if (decompressed.is_null)
+		decompressed_datums[decompressed_column_offset] = 0;
+	else
+		decompressed_datums[decompressed_column_offset] = decompressed.val;
+
+	return false;
+}
+
+/****************************
+ ** parallel decompression **
+ ****************************/
+
+/*
+ * The parallel workers scan the compressed chunk with a parallel scan, so
+ * that each compressed batch is decompressed by one of them, and send the
+ * decompressed tuples to the leader, because the workers can't insert. The
+ * leader writes them with table_multi_insert as they arrive. The indexes are
+ * rebuilt at the end like in the serial path.
+ *
+ * The leader can insert while in parallel mode, but it can't assign the OIDs
+ * of new TOAST values then. The tuples that need to be toasted are buffered
+ * in a tuplestore and inserted after the workers are done.
+ */
+#define PARALLEL_KEY_DECOMPRESS_SHARED UINT64CONST(0xA000000000000011)
+#define PARALLEL_KEY_DECOMPRESS_SCAN UINT64CONST(0xA000000000000012)
+#define PARALLEL_KEY_DECOMPRESS_QUEUES UINT64CONST(0xA000000000000013)
+#define DECOMPRESS_PARALLEL_QUEUE_SIZE 65536
+
+typedef struct DecompressParallelShared
+{
+	Oid in_relid;
+	Oid out_relid;
+} DecompressParallelShared;
+
+PGDLLEXPORT void decompress_chunk_parallel_main(dsm_segment *seg, shm_toc *toc);
+
+/* The number of parallel workers to decompress the chunk with */
+static int
+decompress_chunk_parallel_workers(void)
+{
+	if (IsInParallelMode())
+		return 0;
+
+	return ts_guc_decompress_parallel_workers;
+}
+
+void
+decompress_chunk_parallel_main(dsm_segment *seg, shm_toc *toc)
+{
+	DecompressParallelShared *shared = shm_toc_lookup(toc, PARALLEL_KEY_DECOMPRESS_SHARED, false);
+	ParallelTableScanDesc pscan = shm_toc_lookup(toc, PARALLEL_KEY_DECOMPRESS_SCAN, false);
+	char *queues = shm_toc_lookup(toc, PARALLEL_KEY_DECOMPRESS_QUEUES, false);
+	shm_mq *mq = (shm_mq *) (queues + ParallelWorkerNumber * DECOMPRESS_PARALLEL_QUEUE_SIZE);
+	shm_mq_handle *mqh;
+
+	shm_mq_set_sender(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+
+	/* the leader holds the stronger locks, the lock group shares them */
+	Relation in_rel = table_open(shared->in_relid, AccessShareLock);
+	Relation out_rel = table_open(shared->out_relid, AccessShareLock);
+	TupleDesc in_desc = RelationGetDescr(in_rel);
+	RowDecompressor decompressor = build_decompressor(in_rel, out_rel);
+	Datum *compressed_datums = palloc(sizeof(*compressed_datums) * in_desc->natts);
+	bool *compressed_is_nulls = palloc(sizeof(*compressed_is_nulls) * in_desc->natts);
+	TableScanDesc heapScan = table_beginscan_parallel(in_rel, pscan);
+	MemoryContext per_compressed_row_ctx =
+		AllocSetContextCreate(CurrentMemoryContext,
+							  "decompress chunk per-compressed row",
+							  ALLOCSET_DEFAULT_SIZES);
+	HeapTuple compressed_tuple;
+
+	decompressor.output_queue = mqh;
+
+	for (compressed_tuple = heap_getnext(heapScan, ForwardScanDirection);
+		 compressed_tuple != NULL;
+		 compressed_tuple = heap_getnext(heapScan, ForwardScanDirection))
+	{
+		MemoryContext old_ctx = MemoryContextSwitchTo(per_compressed_row_ctx);
+
+		heap_deform_tuple(compressed_tuple, in_desc, compressed_datums, compressed_is_nulls);
+		populate_per_compressed_columns_from_data(decompressor.per_compressed_cols,
+												  in_desc->natts,
+												  compressed_datums,
+												  compressed_is_nulls);
+
+		row_decompressor_decompress_row(&decompressor);
+		MemoryContextSwitchTo(old_ctx);
+		MemoryContextReset(per_compressed_row_ctx);
+	}
+
+	heap_endscan(heapScan);
+	shm_mq_detach(mqh);
+
+	table_close(out_rel, AccessShareLock);
+	table_close(in_rel, AccessShareLock);
+}
+
+/*
+ * Receive the decompressed tuples from the workers and insert them, until
+ * all of the workers detach from their queues.
+ */
+static void
+decompress_chunk_parallel_receive(ParallelContext *pcxt, shm_mq_handle **queues,
+								  RowDecompressor *decompressor, Tuplestorestate *toast_store)
+{
+	int nworkers = pcxt->nworkers_launched;
+	bool *detached = palloc0(sizeof(*detached) * nworkers);
+	int nactive = nworkers;
+
+	while (nactive > 0)
+	{
+		bool received = false;
+
+		for (int i = 0; i < nworkers; i++)
+		{
+			HeapTupleData tuple;
+			shm_mq_result result;
+			Size nbytes;
+			void *data;
+
+			if (detached[i])
+				continue;
+
+			result = shm_mq_receive(queues[i], &nbytes, &data, true /*=nowait*/);
+			if (result == SHM_MQ_WOULD_BLOCK)
+				continue;
+
+			if (result == SHM_MQ_DETACHED)
+			{
+				detached[i] = true;
+				nactive--;
+				continue;
+			}
+
+			tuple.t_len = nbytes;
+			tuple.t_data = data;
+			ItemPointerSetInvalid(&tuple.t_self);
+			tuple.t_tableOid = InvalidOid;
+
+			/* same condition as heap_prepare_insert() uses to toast the tuple */
+			if (HeapTupleHasExternal(&tuple) || tuple.t_len > TOAST_TUPLE_THRESHOLD)
+				tuplestore_puttuple(toast_store, &tuple);
+			else
+				row_decompressor_buffer_tuple(decompressor, heap_copytuple(&tuple));
+			received = true;
+		}
+
+		if (!received && nactive > 0)
+		{
+			/* don't keep the buffered tuples while waiting */
+			row_decompressor_flush_inserts(decompressor);
+			(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0, WAIT_EVENT_MQ_RECEIVE);
+			ResetLatch(MyLatch);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	row_decompressor_flush_inserts(decompressor);
+	pfree(detached);
+}
+
+/*
+ * Decompress the chunk in parallel workers, see the comment above. Returns
+ * false if no workers could be launched, the caller decompresses the chunk
+ * by itself then.
+ */
+static bool
+decompress_chunk_parallel(Relation in_rel, Relation out_rel, int nworkers)
+{
+	Size queues_size = mul_size(DECOMPRESS_PARALLEL_QUEUE_SIZE, nworkers);
+	RowDecompressor decompressor;
+	DecompressParallelShared *shared;
+	ParallelTableScanDesc pscan;
+	Size pscan_size;
+	ParallelContext *pcxt;
+	shm_mq_handle **queues;
+	char *queue_space;
+	Tuplestorestate *toast_store;
+	TupleTableSlot *slot;
+
+	/*
+	 * The leader inserts while in parallel mode, so it needs its transaction
+	 * id and command id before entering it.
+	 */
+	decompressor = build_decompressor(in_rel, out_rel);
+	decompressor.insert_slots =
+		palloc0(sizeof(TupleTableSlot *) * MAX_BUFFERED_DECOMPRESSED_TUPLES);
+	decompressor.insert_options = compression_insert_options(out_rel);
+	(void) GetCurrentTransactionId();
+
+	/* the workers get the active snapshot of the leader */
+	PushActiveSnapshot(GetLatestSnapshot());
+	EnterParallelMode();
+	pcxt = CreateParallelContext(EXTENSION_TSL_SO, "decompress_chunk_parallel_main", nworkers);
+
+	pscan_size = table_parallelscan_estimate(in_rel, GetActiveSnapshot());
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(DecompressParallelShared));
+	shm_toc_estimate_chunk(&pcxt->estimator, pscan_size);
+	shm_toc_estimate_chunk(&pcxt->estimator, queues_size);
+	shm_toc_estimate_keys(&pcxt->estimator, 3);
+	InitializeParallelDSM(pcxt);
+
+	shared = shm_toc_allocate(pcxt->toc, sizeof(DecompressParallelShared));
+	shared->in_relid = RelationGetRelid(in_rel);
+	shared->out_relid = RelationGetRelid(out_rel);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_DECOMPRESS_SHARED, shared);
+
+	pscan = shm_toc_allocate(pcxt->toc, pscan_size);
+	table_parallelscan_initialize(in_rel, pscan, GetActiveSnapshot());
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_DECOMPRESS_SCAN, pscan);
+
+	queue_space = shm_toc_allocate(pcxt->toc, queues_size);
+	queues = palloc(sizeof(*queues) * nworkers);
+	for (int i = 0; i < nworkers; i++)
+	{
+		shm_mq *mq = shm_mq_create(queue_space + i * DECOMPRESS_PARALLEL_QUEUE_SIZE,
+								   DECOMPRESS_PARALLEL_QUEUE_SIZE);
+
+		shm_mq_set_receiver(mq, MyProc);
+		queues[i] = shm_mq_attach(mq, pcxt->seg, NULL);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_DECOMPRESS_QUEUES, queue_space);
+
+	/* no workers are launched when the DSM segment couldn't be created either */
+	LaunchParallelWorkers(pcxt);
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		PopActiveSnapshot();
+		FreeBulkInsertState(decompressor.bistate);
+		return false;
+	}
+
+#ifdef TS_DEBUG
+	const char *compression_path =
+		GetConfigOption("timescaledb.show_compression_path_info", true, false);
+	if (compression_path != NULL && strcmp(compression_path, "on") == 0)
+		elog(INFO, "decompress_chunk_parallel_start");
+#endif
+
+	/* a worker that fails to start would never attach to its queue */
+	for (int i = 0; i < pcxt->nworkers_launched; i++)
+		shm_mq_set_handle(queues[i], pcxt->worker[i].bgwhandle);
+
+	toast_store = tuplestore_begin_heap(false, false, work_mem);
+	decompress_chunk_parallel_receive(pcxt, queues, &decompressor, toast_store);
+
+	WaitForParallelWorkersToFinish(pcxt);
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+	PopActiveSnapshot();
+
+	slot = MakeSingleTupleTableSlot(decompressor.out_desc, &TTSOpsMinimalTuple);
+	while (tuplestore_gettupleslot(toast_store, true /*forward*/, false /*copy*/, slot))
+		row_decompressor_buffer_tuple(&decompressor, ExecCopySlotHeapTuple(slot));
+	row_decompressor_flush_inserts(&decompressor);
+	ExecDropSingleTupleTableSlot(slot);
+	tuplestore_end(toast_store);
+
+	for (int i = 0; i < MAX_BUFFERED_DECOMPRESSED_TUPLES; i++)
+	{
+		if (decompressor.insert_slots[i] == NULL)
+			break;
+		ExecDropSingleTupleTableSlot(decompressor.insert_slots[i]);
+	}
+	FreeBulkInsertState(decompressor.bistate);
+
+	return true;
+}
+
+/**********************************
+ ** recompress_chunk_segmentwise **
+ **********************************/
+
+/*
+ * Move the compressed batches of the current segment of the row compressor
+ * back to the uncompressed chunk, so that they are compressed again together
+ * with the new rows of the segment. The batches are found with the same scan
+ * keys that are used to look up the sequence number of the segment.
+ */
+static void
+decompress_segment_for_recompression(RowCompressor *row_compressor,
+									 RowDecompressor *decompressor, int64 *decompressed_rows,
+									 int64 *deleted_batches)
+{
+	Relation compressed_rel = row_compressor->compressed_table;
+	TupleDesc compressed_desc = RelationGetDescr(compressed_rel);
+	bool is_index_scan = OidIsValid(row_compressor->index_oid);
+	Relation index_rel = NULL;
+	IndexScanDesc index_scan = NULL;
+	TableScanDesc heap_scan = NULL;
+	int num_scankeys;
+
+	MemoryContext scan_ctx = AllocSetContextCreate(CurrentMemoryContext,
+												   "recompress segment scan",
+												   ALLOCSET_DEFAULT_SIZES);
+	MemoryContext per_compressed_row_ctx =
+		AllocSetContextCreate(scan_ctx,
+							  "recompress segment per-compressed row",
+							  ALLOCSET_DEFAULT_SIZES);
+	MemoryContext old_ctx = MemoryContextSwitchTo(scan_ctx);
+
+	ScanKeyData *scankey =
+		build_scankeys_for_current_group(row_compressor->uncompressed_col_to_compressed_col,
+										 row_compressor->per_column,
+										 row_compressor->n_input_columns,
+										 is_index_scan,
+										 &num_scankeys);
+	Datum *compressed_datums = palloc(sizeof(*compressed_datums) * compressed_desc->natts);
+	bool *compressed_is_nulls = palloc(sizeof(*compressed_is_nulls) * compressed_desc->natts);
+	TupleTableSlot *slot = table_slot_create(compressed_rel, NULL);
+	Snapshot snapshot = RegisterSnapshot(GetLatestSnapshot());
+
+	if (is_index_scan)
+	{
+		index_rel = index_open(row_compressor->index_oid, AccessShareLock);
+		index_scan = index_beginscan(compressed_rel, index_rel, snapshot, num_scankeys, 0);
+		index_rescan(index_scan, scankey, num_scankeys, NULL, 0);
+	}
+	else
+		heap_scan = table_beginscan(compressed_rel, snapshot, num_scankeys, scankey);
+
+	while (is_index_scan ? index_getnext_slot(index_scan, ForwardScanDirection, slot) :
+						   table_scan_getnextslot(heap_scan, ForwardScanDirection, slot))
+	{
+		bool should_free;
+		HeapTuple compressed_tuple;
+
+		MemoryContextSwitchTo(per_compressed_row_ctx);
+
+		compressed_tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+		heap_deform_tuple(compressed_tuple,
+						  compressed_desc,
+						  compressed_datums,
+						  compressed_is_nulls);
+		populate_per_compressed_columns_from_data(decompressor->per_compressed_cols,
+												  compressed_desc->natts,
+												  compressed_datums,
+												  compressed_is_nulls);
+		row_decompressor_decompress_row(decompressor);
+
+		*decompressed_rows +=
+			DatumGetInt32(compressed_datums[row_compressor->count_metadata_column_offset]);
+		(*deleted_batches)++;
+
+		simple_heap_delete(compressed_rel, &slot->tts_tid);
+
+		if (should_free)
+			heap_freetuple(compressed_tuple);
+
+		MemoryContextSwitchTo(scan_ctx);
+		MemoryContextReset(per_compressed_row_ctx);
+	}
+
+	if (is_index_scan)
+	{
+		index_endscan(index_scan);
+		index_close(index_rel, AccessShareLock);
+	}
+	else
+		table_endscan(heap_scan);
+
+	ExecDropSingleTupleTableSlot(slot);
+	UnregisterSnapshot(snapshot);
+
+	MemoryContextSwitchTo(old_ctx);
+	MemoryContextDelete(scan_ctx);
+}
+
+/*
+ * Recompress a partially compressed chunk without touching the segments that
+ * got no new rows. The uncompressed rows are sorted by the segment by columns,
+ * and the compressed batches of each of their segments are decompressed into
+ * the uncompressed chunk and deleted. The uncompressed chunk is then compressed
+ * into the compressed chunk like a chunk that is merged into it.
+ *
+ * The returned stats are the changes of the row counts of the compressed chunk.
+ */
+CompressionStats
+recompress_chunk_segmentwise(Oid in_table, Oid out_table,
+							 const ColumnCompressionInfo **column_compression_info,
+							 int num_compression_infos)
+{
+	int n_keys, n_segment_keys = 0;
+	const ColumnCompressionInfo **keys;
+	int64 decompressed_rows = 0, deleted_batches = 0;
+	RowCompressor row_compressor;
+	RowDecompressor decompressor;
+	CompressionStats cstat;
+
+	/* the same locks as compress_chunk, so that it doesn't have to upgrade them */
+	Relation in_rel = table_open(in_table, ExclusiveLock);
+	Relation out_rel = relation_open(out_table, ExclusiveLock);
+	int16 *in_column_offsets = compress_chunk_populate_keys(in_table,
+															column_compression_info,
+															num_compression_infos,
+															&n_keys,
+															&keys);
+	TupleDesc in_desc = RelationGetDescr(in_rel);
+	TupleDesc out_desc = RelationGetDescr(out_rel);
+
+	for (int i = 0; i < n_keys; i++)
+	{
+		if (COMPRESSIONCOL_IS_SEGMENT_BY(keys[i]))
+			n_segment_keys++;
+	}
+
+	/* the row compressor is only used to keep track of the current segment */
+	row_compressor_init(&row_compressor,
+						in_desc,
+						out_rel,
+						num_compression_infos,
+						column_compression_info,
+						in_column_offsets,
+						out_desc->natts,
+						false /*need_bistate*/);
+	decompressor = build_decompressor(out_rel, in_rel);
+
+	if (n_segment_keys > 0)
+	{
+		Tuplesortstate *segments =
+			compress_chunk_begin_sort(in_rel, n_segment_keys, keys, maintenance_work_mem);
+		TupleTableSlot *heap_slot = table_slot_create(in_rel, NULL);
+		TupleTableSlot *slot = MakeTupleTableSlot(in_desc, &TTSOpsMinimalTuple);
+		TableScanDesc heap_scan = table_beginscan(in_rel, GetLatestSnapshot(), 0, NULL);
+
+		while (table_scan_getnextslot(heap_scan, ForwardScanDirection, heap_slot))
+			tuplesort_puttupleslot(segments, heap_slot);
+
+		table_endscan(heap_scan);
+		ExecDropSingleTupleTableSlot(heap_slot);
+		tuplesort_performsort(segments);
+
+		while (tuplesort_gettupleslot(segments, true /*=forward*/, false /*=copy*/, slot, NULL))
+		{
+			slot_getallattrs(slot);
+			if (row_compressor.first_iteration ||
+				row_compressor_new_row_is_in_new_group(&row_compressor, slot))
+			{
+				row_compressor_update_segment_info(&row_compressor, slot);
+				row_compressor.first_iteration = false;
+				decompress_segment_for_recompression(&row_compressor,
+													 &decompressor,
+													 &decompressed_rows,
+													 &deleted_batches);
+			}
+			ExecClearTuple(slot);
+		}
+
+		ExecDropSingleTupleTableSlot(slot);
+		tuplesort_end(segments);
+	}
+	else
+	{
+		/* without segment by columns all the batches are in the same segment */
+		TableScanDesc heap_scan = table_beginscan(in_rel, GetLatestSnapshot(), 0, NULL);
+		bool has_new_rows = heap_getnext(heap_scan, ForwardScanDirection) != NULL;
+
+		heap_endscan(heap_scan);
+		if (has_new_rows)
+			decompress_segment_for_recompression(&row_compressor,
+												 &decompressor,
+												 &decompressed_rows,
+												 &deleted_batches);
+	}
+
+	FreeBulkInsertState(decompressor.bistate);
+	CommandCounterIncrement();
+
+	/* the decompressed rows have to be in the indexes that compress_chunk can scan */
+	if (decompressed_rows > 0)
+	{
+#if PG14_LT
+		int options = 0;
+#else
+		ReindexParams params = { 0 };
+		ReindexParams *options = &params;
+#endif
+		reindex_relation(in_table, 0, options);
+	}
+
+	table_close(out_rel, NoLock);
+	table_close(in_rel, NoLock);
+
+	cstat = compress_chunk(in_table, out_table, column_compression_info, num_compression_infos);
+	cstat.rowcnt_pre_compression -= decompressed_rows;
+	cstat.rowcnt_post_compression -= deleted_batches;
+	return cstat;
+}
+
+/************************
+ ** decompress_batches **
+ ************************/
+
+/*
+ * Move the compressed batches matching the scan keys back to the
+ * uncompressed chunk and delete them from the compressed chunk.
+ *
+ * The indexes of the uncompressed chunk are updated for each decompressed
+ * row instead of being rebuilt, so that this can be used while the current
+ * statement has the indexes open, e.g., when modifying rows of a compressed
+ * chunk.
+ *
+ * Returns the number of decompressed rows.
+ */
+int64
+decompress_batches(Oid in_table, Oid out_table, ScanKeyData *scankeys, int num_scankeys,
+				   int64 *deleted_batches)
+{
+	/* the same lock order as decompress_chunk, but allow concurrent inserts
+	 * into the uncompressed chunk since its indexes are maintained */
+	Relation out_rel = table_open(out_table, RowExclusiveLock);
+	Relation in_rel = relation_open(in_table, ExclusiveLock);
+	TupleDesc in_desc = RelationGetDescr(in_rel);
+	AttrNumber count_attno = get_attnum(in_table, COMPRESSION_COLUMN_METADATA_COUNT_NAME);
+	RowDecompressor decompressor = build_decompressor(in_rel, out_rel);
+	Datum *compressed_datums = palloc(sizeof(*compressed_datums) * in_desc->natts);
+	bool *compressed_is_nulls = palloc(sizeof(*compressed_is_nulls) * in_desc->natts);
+	TupleTableSlot *slot = table_slot_create(in_rel, NULL);
+	Snapshot snapshot = RegisterSnapshot(GetLatestSnapshot());
+	MemoryContext per_compressed_row_ctx = AllocSetContextCreate(CurrentMemoryContext,
+																 "decompress batches per-row",
+																 ALLOCSET_DEFAULT_SIZES);
+	int64 decompressed_rows = 0;
+	TableScanDesc heap_scan;
+
+	if (count_attno == InvalidAttrNumber)
+		elog(ERROR, "missing metadata columns in compressed chunk \"%s\"", get_rel_name(in_table));
+
+	decompressor.estate = CreateExecutorState();
+	decompressor.index_rri = makeNode(ResultRelInfo);
+	InitResultRelInfo(decompressor.index_rri, out_rel, 1, NULL, 0);
+	ExecOpenIndices(decompressor.index_rri, false);
+#if PG14_LT
+	decompressor.estate->es_result_relation_info = decompressor.index_rri;
+#endif
+	decompressor.index_slot = MakeSingleTupleTableSlot(decompressor.out_desc, &TTSOpsHeapTuple);
+
+	*deleted_batches = 0;
+	heap_scan = table_beginscan(in_rel, snapshot, num_scankeys, scankeys);
+
+	while (table_scan_getnextslot(heap_scan, ForwardScanDirection, slot))
+	{
+		bool should_free;
+		HeapTuple compressed_tuple;
+		MemoryContext old_ctx = MemoryContextSwitchTo(per_compressed_row_ctx);
+
+		compressed_tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+		heap_deform_tuple(compressed_tuple, in_desc, compressed_datums, compressed_is_nulls);
+		populate_per_compressed_columns_from_data(decompressor.per_compressed_cols,
+												  in_desc->natts,
+												  compressed_datums,
+												  compressed_is_nulls);
+		row_decompressor_decompress_row(&decompressor);
+
+		decompressed_rows += DatumGetInt32(compressed_datums[AttrNumberGetAttrOffset(count_attno)]);
+		(*deleted_batches)++;
+
+		simple_heap_delete(in_rel, &slot->tts_tid);
+
+		if (should_free)
+			heap_freetuple(compressed_tuple);
+
+		MemoryContextSwitchTo(old_ctx);
+		MemoryContextReset(per_compressed_row_ctx);
+	}
+
+	table_endscan(heap_scan);
+	ExecDropSingleTupleTableSlot(slot);
+	ExecDropSingleTupleTableSlot(decompressor.index_slot);
+	ExecCloseIndices(decompressor.index_rri);
+	FreeExecutorState(decompressor.estate);
+	UnregisterSnapshot(snapshot);
+	FreeBulkInsertState(decompressor.bistate);
+	MemoryContextDelete(per_compressed_row_ctx);
+	CommandCounterIncrement();
+
+	table_close(out_rel, NoLock);
+	table_close(in_rel, NoLock);
+
+	return decompressed_rows;
+}
+
+/*********************************
+ ** decompress_batches_in_range **
+ *********************************/
+
+/*
+ * Move the compressed batches that can hold values of an order by column in
+ * the range [start, end) back to the uncompressed chunk and delete them from
+ * the compressed chunk. The batches are found with the min and max metadata
+ * of the column. Rows of the moved batches outside of the range are kept in
+ * the uncompressed chunk as well.
+ *
+ * Returns the number of decompressed rows.
+ */
+int64
+decompress_batches_in_range(Oid in_table, Oid out_table, const char *min_column_name,
+							const char *max_column_name, Oid column_type, Datum start, Datum end,
+							int64 *deleted_batches)
+{
+	AttrNumber min_attno = get_attnum(in_table, min_column_name);
+	AttrNumber max_attno = get_attnum(in_table, max_column_name);
+	TypeCacheEntry *tce = lookup_type_cache(column_type, TYPECACHE_BTREE_OPFAMILY);
+	ScanKeyData scankeys[2];
+	Oid opno;
+
+	if (min_attno == InvalidAttrNumber || max_attno == InvalidAttrNumber)
+		elog(ERROR, "missing metadata columns in compressed chunk \"%s\"", get_rel_name(in_table));
+
+	if (!OidIsValid(tce->btree_opf))
+		elog(ERROR, "no btree operator family for type %s", format_type_be(column_type));
+
+	/* a batch overlaps the range if min < end and max >= start */
+	opno = get_opfamily_member(tce->btree_opf, column_type, column_type, BTLessStrategyNumber);
+	ScanKeyInit(&scankeys[0], min_attno, BTLessStrategyNumber, get_opcode(opno), end);
+	opno = get_opfamily_member(tce->btree_opf,
+							   column_type,
+							   column_type,
+							   BTGreaterEqualStrategyNumber);
+	ScanKeyInit(&scankeys[1], max_attno, BTGreaterEqualStrategyNumber, get_opcode(opno), start);
+
+	return decompress_batches(in_table, out_table, scankeys, 2, deleted_batches);
+}
+
+/***************************
+ ** delete_batches_before **
+ ***************************/
+
+/*
+ * Delete the compressed batches whose values of an order by column are all
+ * before the cutoff, without decompressing them. The batches are found with
+ * the max metadata of the column.
+ *
+ * Returns the number of deleted batches.
+ */
+int64
+delete_batches_before(Oid in_table, const char *max_column_name, Oid column_type, Datum cutoff,
+					  int64 *deleted_rows)
+{
+	/* the same lock as decompress_batches, readers are not blocked */
+	Relation in_rel = table_open(in_table, ExclusiveLock);
+	AttrNumber max_attno = get_attnum(in_table, max_column_name);
+	AttrNumber count_attno = get_attnum(in_table, COMPRESSION_COLUMN_METADATA_COUNT_NAME);
+	TypeCacheEntry *tce = lookup_type_cache(column_type, TYPECACHE_BTREE_OPFAMILY);
+	TupleTableSlot *slot = table_slot_create(in_rel, NULL);
+	Snapshot snapshot;
+	TableScanDesc heap_scan;
+	ScanKeyData scankey;
+	int64 deleted_batches = 0;
+	Oid opno;
+
+	if (max_attno == InvalidAttrNumber || count_attno == InvalidAttrNumber)
+		elog(ERROR, "missing metadata columns in compressed chunk \"%s\"", get_rel_name(in_table));
+
+	if (!OidIsValid(tce->btree_opf))
+		elog(ERROR, "no btree operator family for type %s", format_type_be(column_type));
+
+	opno = get_opfamily_member(tce->btree_opf, column_type, column_type, BTLessStrategyNumber);
+	ScanKeyInit(&scankey, max_attno, BTLessStrategyNumber, get_opcode(opno), cutoff);
+
+	*deleted_rows = 0;
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	heap_scan = table_beginscan(in_rel, snapshot, 1, &scankey);
+
+	while (table_scan_getnextslot(heap_scan, ForwardScanDirection, slot))
+	{
+		bool isnull;
+		Datum count = slot_getattr(slot, count_attno, &isnull);
+
+		/* count column should never be NULL */
+		Assert(!isnull);
+		*deleted_rows += DatumGetInt32(count);
+		deleted_batches++;
+
+		simple_heap_delete(in_rel, &slot->tts_tid);
+	}
+
+	table_endscan(heap_scan);
+	ExecDropSingleTupleTableSlot(slot);
+	UnregisterSnapshot(snapshot);
+	CommandCounterIncrement();
 
-	return false;
+	table_close(in_rel, NoLock);
+
+	return deleted_batches;
 }
 
 /********************/
@@ -1980,6 +4340,69 @@ tsl_compressed_data_out(PG_FUNCTION_ARGS)
 	PG_RETURN_CSTRING(encoded);
 }
 
+/*
+ * Aggregate that compresses its input with the default algorithm for the
+ * input type. Used by data nodes to ship scan results to the access node in
+ * columnar form, one compressed datum per column and batch.
+ */
+typedef struct CompressedDataAggState
+{
+	Compressor *compressor;
+} CompressedDataAggState;
+
+extern Datum
+tsl_compressed_data_agg_transfn(PG_FUNCTION_ARGS)
+{
+	CompressedDataAggState *state =
+		(CompressedDataAggState *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "tsl_compressed_data_agg_transfn called in non-aggregate context");
+	}
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	if (state == NULL)
+	{
+		Oid type_to_compress = get_fn_expr_argtype(fcinfo->flinfo, 1);
+
+		state = palloc0(sizeof(CompressedDataAggState));
+		state->compressor =
+			compressor_for_algorithm_and_type(get_default_algorithm_id(type_to_compress),
+											  type_to_compress);
+	}
+
+	if (PG_ARGISNULL(1))
+		state->compressor->append_null(state->compressor);
+	else
+		state->compressor->append_val(state->compressor, PG_GETARG_DATUM(1));
+
+	MemoryContextSwitchTo(old_context);
+	PG_RETURN_POINTER(state);
+}
+
+extern Datum
+tsl_compressed_data_agg_finalfn(PG_FUNCTION_ARGS)
+{
+	CompressedDataAggState *state =
+		(CompressedDataAggState *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+	void *compressed;
+
+	if (state == NULL)
+		PG_RETURN_NULL();
+
+	compressed = state->compressor->finish(state->compressor);
+
+	if (compressed == NULL)
+		PG_RETURN_NULL();
+
+	PG_RETURN_POINTER(compressed);
+}
+
 extern CompressionStorage
 compression_get_toast_storage(CompressionAlgorithms algorithm)
 {
@@ -2030,34 +4453,143 @@ update_compressed_chunk_relstats(Oid uncompressed_relid, Oid compressed_relid)
 	}
 }
 
+/*
+ * The rows inserted into a compressed chunk are buffered per segment. When a
+ * segment has timescaledb.compress_batch_size rows, they are sorted and compressed
+ * into a new batch of the compressed chunk. The rows of the segments that
+ * don't fill a batch are handed back to the caller to insert them into the
+ * uncompressed chunk, either when the insert ends or when too many rows are
+ * buffered, and get compressed with the next recompression of the chunk.
+ */
+#define COMPRESS_ROW_MAX_BUFFERED_ROWS 100000
+
+typedef struct CompressRowSegment
+{
+	/* the segment by values of the segment, indexed like the input columns */
+	Datum *values;
+	bool *isnull;
+	/* the sequence number of the next batch, 0 until the first batch is written */
+	int32 sequence_num;
+	int num_rows;
+	int max_rows;
+	MinimalTuple *rows;
+	/* the last row of the previous batch, only kept by compress_chunk_hash_grouped() */
+	MinimalTuple last_row;
+} CompressRowSegment;
+
+typedef struct CompressRowSegmentEntry
+{
+	/* the hash of the segment by values, the segments with equal hashes are chained */
+	uint32 hash;
+	List *segments;
+} CompressRowSegmentEntry;
+
 typedef struct CompressSingleRowState
 {
 	Relation in_rel;
 	Relation out_rel;
-	RowCompressor row_compressor;
-	TupleTableSlot *out_slot;
+	RowCompressor *row_compressor;
+	int n_keys;
+	const ColumnCompressionInfo **keys;
+	int n_segment_keys;
+	AttrNumber *segment_attnos;
+	FmgrInfo **segment_hash_procs;
+	Oid *segment_collations;
+	/* the segments by the hash of their segment by values */
+	HTAB *segments;
+	MemoryContext buffer_ctx;
+	int num_buffered_rows;
+	TupleTableSlot *buffer_slot;
+	/* the orderby columns, only set up by compress_chunk_hash_grouped() */
+	int n_orderby_keys;
+	AttrNumber *orderby_attnos;
+	SortSupport orderby_ssup;
+	void (*insert_row)(TupleTableSlot *slot, void *data);
+	void *insert_row_data;
+	/* compress the rows that didn't fill a batch instead of handing them back */
+	bool compress_partial_batches;
 } CompressSingleRowState;
 
-static TupleTableSlot *compress_singlerow(CompressSingleRowState *cr, TupleTableSlot *in_slot);
+/*
+ * Create the buffers of the segments, the caller sets up the row compressor.
+ *
+ * Returns NULL if the rows can't be buffered because the segment by columns
+ * can't be hashed.
+ */
+static CompressSingleRowState *
+compress_row_state_create(Relation in_rel, Relation out_rel, int n_keys,
+						  const ColumnCompressionInfo **keys)
+{
+	TupleDesc in_desc = RelationGetDescr(in_rel);
+	HASHCTL hctl = {
+		.keysize = sizeof(uint32),
+		.entrysize = sizeof(CompressRowSegmentEntry),
+	};
+	CompressSingleRowState *cr;
+
+	for (int i = 0; i < n_keys && COMPRESSIONCOL_IS_SEGMENT_BY(keys[i]); i++)
+	{
+		AttrNumber attno = get_attnum(RelationGetRelid(in_rel), NameStr(keys[i]->attname));
+		Form_pg_attribute attr = TupleDescAttr(in_desc, AttrNumberGetAttrOffset(attno));
+
+		if (!OidIsValid(lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC)->hash_proc))
+			return NULL;
+	}
+
+	cr = palloc0(sizeof(CompressSingleRowState));
+	cr->in_rel = in_rel;
+	cr->out_rel = out_rel;
+	cr->n_keys = n_keys;
+	cr->keys = keys;
+	cr->segment_attnos = palloc(sizeof(*cr->segment_attnos) * n_keys);
+	cr->segment_hash_procs = palloc(sizeof(*cr->segment_hash_procs) * n_keys);
+	cr->segment_collations = palloc(sizeof(*cr->segment_collations) * n_keys);
+	while (cr->n_segment_keys < n_keys && COMPRESSIONCOL_IS_SEGMENT_BY(keys[cr->n_segment_keys]))
+	{
+		AttrNumber attno =
+			get_attnum(RelationGetRelid(in_rel), NameStr(keys[cr->n_segment_keys]->attname));
+		Form_pg_attribute attr = TupleDescAttr(in_desc, AttrNumberGetAttrOffset(attno));
+
+		cr->segment_attnos[cr->n_segment_keys] = attno;
+		cr->segment_hash_procs[cr->n_segment_keys] =
+			&lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC_FINFO)->hash_proc_finfo;
+		cr->segment_collations[cr->n_segment_keys] = attr->attcollation;
+		cr->n_segment_keys++;
+	}
+
+	cr->buffer_ctx =
+		AllocSetContextCreate(CurrentMemoryContext, "compress row buffer", ALLOCSET_DEFAULT_SIZES);
+	hctl.hcxt = cr->buffer_ctx;
+	cr->segments = hash_create("compress row segments",
+							   16,
+							   &hctl,
+							   HASH_ELEM | HASH_CONTEXT | HASH_BLOBS);
+	cr->buffer_slot = MakeSingleTupleTableSlot(in_desc, &TTSOpsMinimalTuple);
+
+	return cr;
+}
 
+/*
+ * Returns NULL if the rows can't be buffered because the segment by columns
+ * can't be hashed.
+ *
+ * The rows of the segments that didn't fill a batch are handed back to the
+ * caller with insert_row, unless compress_partial_batches is set, in which
+ * case they are compressed into smaller batches.
+ */
 CompressSingleRowState *
-compress_row_init(int srcht_id, Relation in_rel, Relation out_rel)
+compress_row_init(int srcht_id, Relation in_rel, Relation out_rel, bool compress_partial_batches,
+				  void (*insert_row)(TupleTableSlot *slot, void *data), void *data)
 {
 	ListCell *lc;
 	List *htcols_list = NIL;
 	int i = 0, cclen;
 	const ColumnCompressionInfo **ccinfo;
-	TupleDesc in_desc = RelationGetDescr(in_rel);
 	TupleDesc out_desc = RelationGetDescr(out_rel);
 	int16 *in_column_offsets;
 	int n_keys;
 	const ColumnCompressionInfo **keys;
-
-	CompressSingleRowState *cr = palloc(sizeof(CompressSingleRowState));
-	cr->out_slot =
-		MakeSingleTupleTableSlot(RelationGetDescr(out_rel), table_slot_callbacks(out_rel));
-	cr->in_rel = in_rel;
-	cr->out_rel = out_rel;
+	CompressSingleRowState *cr;
 
 	/* get compression properties for hypertable */
 	htcols_list = ts_hypertable_compression_get(srcht_id);
@@ -2070,134 +4602,467 @@ compress_row_init(int srcht_id, Relation in_rel, Relation out_rel)
 	}
 	in_column_offsets =
 		compress_chunk_populate_keys(RelationGetRelid(in_rel), ccinfo, cclen, &n_keys, &keys);
-	row_compressor_init(&cr->row_compressor,
-						in_desc,
+
+	cr = compress_row_state_create(in_rel, out_rel, n_keys, keys);
+	if (cr == NULL)
+		return NULL;
+
+	cr->row_compressor = palloc0(sizeof(RowCompressor));
+	row_compressor_init(cr->row_compressor,
+						RelationGetDescr(in_rel),
 						out_rel,
 						cclen,
 						ccinfo,
 						in_column_offsets,
 						out_desc->natts,
-						false /*need_bistate*/);
+						true /*need_bistate*/);
+	/* the compressed chunk already has its indexes, so keep them up to date */
+	cr->row_compressor->index_state = CatalogOpenIndexes(out_rel);
+	cr->insert_row = insert_row;
+	cr->insert_row_data = data;
+	cr->compress_partial_batches = compress_partial_batches;
+
 	return cr;
 }
 
-/* create a single row compressed tuple from data in slot */
-TupleTableSlot *
-compress_row_exec(CompressSingleRowState *cr, TupleTableSlot *slot)
+static bool
+compress_row_segment_matches(CompressSingleRowState *cr, CompressRowSegment *segment,
+							 TupleTableSlot *slot)
 {
-	TupleTableSlot *compress_slot;
-	slot_getallattrs(slot);
+	for (int i = 0; i < cr->n_segment_keys; i++)
+	{
+		int col = AttrNumberGetAttrOffset(cr->segment_attnos[i]);
+		SegmentInfo *segment_info = cr->row_compressor->per_column[col].segment_info;
+
+		if (segment->isnull[col] != slot->tts_isnull[col])
+			return false;
+
+		if (!segment->isnull[col] &&
+			!DatumGetBool(FunctionCall2Coll(&segment_info->eq_fn,
+											segment_info->collation,
+											segment->values[col],
+											slot->tts_values[col])))
+			return false;
+	}
 
-	cr->row_compressor.rows_compressed_into_current_value = 0;
-	row_compressor_update_group(&cr->row_compressor, slot);
-	row_compressor_append_row(&cr->row_compressor, slot);
-	compress_slot = compress_singlerow(cr, slot);
-	return compress_slot;
+	return true;
 }
 
-static TupleTableSlot *
-compress_singlerow(CompressSingleRowState *cr, TupleTableSlot *in_slot)
+/* find the segment of the row, creating it if this is its first row */
+static CompressRowSegment *
+compress_row_get_segment(CompressSingleRowState *cr, TupleTableSlot *slot)
 {
-	Datum *invalues, *out_values;
-	bool *out_isnull;
-	TupleTableSlot *out_slot = cr->out_slot;
-	RowCompressor *row_compressor = &cr->row_compressor;
+	uint32 hash = compress_chunk_partition_hash(slot,
+												cr->n_segment_keys,
+												cr->segment_attnos,
+												cr->segment_hash_procs,
+												cr->segment_collations);
+	CompressRowSegmentEntry *entry;
+	CompressRowSegment *segment;
+	MemoryContext old_ctx;
+	bool found;
+	ListCell *lc;
+
+	entry = hash_search(cr->segments, &hash, HASH_ENTER, &found);
+	if (!found)
+		entry->segments = NIL;
 
-	ExecClearTuple(out_slot);
+	foreach (lc, entry->segments)
+	{
+		segment = lfirst(lc);
+		if (compress_row_segment_matches(cr, segment, slot))
+			return segment;
+	}
 
-	/* ExecClearTuple above will leave dropped columns as non-null, which will
-	 * cause a segmentation fault in `heap_compute_data_size` since that
-	 * function expects dropped columns to have the null bit set. Since the
-	 * null bits are set below for all columns except */
-	memset(out_slot->tts_isnull,
-		   true,
-		   sizeof(*out_slot->tts_isnull) * out_slot->tts_tupleDescriptor->natts);
+	old_ctx = MemoryContextSwitchTo(cr->buffer_ctx);
+	segment = palloc0(sizeof(CompressRowSegment));
+	segment->values = palloc0(sizeof(Datum) * cr->row_compressor->n_input_columns);
+	segment->isnull = palloc0(sizeof(bool) * cr->row_compressor->n_input_columns);
+	for (int i = 0; i < cr->n_segment_keys; i++)
+	{
+		int col = AttrNumberGetAttrOffset(cr->segment_attnos[i]);
+		SegmentInfo *segment_info = cr->row_compressor->per_column[col].segment_info;
+
+		segment->isnull[col] = slot->tts_isnull[col];
+		if (!slot->tts_isnull[col])
+			segment->values[col] = datumCopy(slot->tts_values[col],
+											 segment_info->typ_by_val,
+											 segment_info->typlen);
+	}
+	entry->segments = lappend(entry->segments, segment);
+	MemoryContextSwitchTo(old_ctx);
 
-	invalues = in_slot->tts_values;
-	out_values = out_slot->tts_values;
-	out_isnull = out_slot->tts_isnull;
+	return segment;
+}
 
-	/* Possible optimization: Can we do a pass through compression without a
-	 * full copy?  full copy needed for multiple values. But we are dealing
-	 * only with a single value, so just need the result of transformation
-	 * after passing it through the compressor function This probably needs a
-	 * bit of rewrite of the compression algorithm code
-	 */
-	Assert(row_compressor->n_input_columns == in_slot->tts_tupleDescriptor->natts);
-	for (int col = 0; col < row_compressor->n_input_columns; col++)
+static void
+compress_row_segment_reset(CompressSingleRowState *cr, CompressRowSegment *segment)
+{
+	for (int i = 0; i < segment->num_rows; i++)
+		pfree(segment->rows[i]);
+
+	cr->num_buffered_rows -= segment->num_rows;
+	segment->num_rows = 0;
+}
+
+/*
+ * Compress the rows of the segment into a new batch, sorting them first unless
+ * they are already in the orderby order.
+ */
+static void
+compress_row_flush_segment(CompressSingleRowState *cr, CompressRowSegment *segment, bool sort)
+{
+	RowCompressor *row_compressor = cr->row_compressor;
+	CommandId mycid = GetCurrentCommandId(true);
+	TupleTableSlot *slot = cr->buffer_slot;
+	Tuplesortstate *sorted_rel = NULL;
+	MemoryContext old_ctx;
+	bool first_row = true;
+
+	if (sort)
 	{
-		PerColumn *column = &row_compressor->per_column[col];
-		Compressor *compressor = row_compressor->per_column[col].compressor;
-		int in_colno = col;
+		sorted_rel = compress_chunk_begin_sort(cr->in_rel, cr->n_keys, cr->keys, work_mem);
+		for (int i = 0; i < segment->num_rows; i++)
+		{
+			ExecStoreMinimalTuple(segment->rows[i], slot, false);
+			tuplesort_puttupleslot(sorted_rel, slot);
+			ExecClearTuple(slot);
+		}
+		tuplesort_performsort(sorted_rel);
+	}
 
-		int16 out_colno = row_compressor->uncompressed_col_to_compressed_col[col];
-		/* if there is no compressor, this must be a segmenter */
-		if (compressor != NULL)
+	old_ctx = MemoryContextSwitchTo(row_compressor->per_row_ctx);
+	for (int i = 0;; i++)
+	{
+		if (sorted_rel == NULL)
 		{
-			void *compressed_data;
-			compressed_data = compressor->finish(compressor);
-			out_isnull[out_colno] = (compressed_data == NULL);
-			if (compressed_data)
-				out_values[out_colno] = PointerGetDatum(compressed_data);
-			if (column->min_max_metadata_builder != NULL)
-			{
-				if (compressed_data)
-				{
-					/* we can copy directly since we have only 1 row. */
-					out_isnull[column->min_metadata_attr_offset] = false;
-					out_isnull[column->max_metadata_attr_offset] = false;
-					out_values[column->min_metadata_attr_offset] = invalues[in_colno];
-					out_values[column->max_metadata_attr_offset] = invalues[in_colno];
-				}
-				else
-				{
-					out_isnull[column->min_metadata_attr_offset] = true;
-					out_isnull[column->max_metadata_attr_offset] = true;
-				}
+			if (i == segment->num_rows)
+				break;
+			ExecStoreMinimalTuple(segment->rows[i], slot, false);
+		}
+		else if (!tuplesort_gettupleslot(sorted_rel,
+										 true /*=forward*/,
+										 false /*=copy*/,
+										 slot,
+										 NULL /*=abbrev*/))
+			break;
 
-				segment_meta_min_max_builder_reset(column->min_max_metadata_builder);
+		slot_getallattrs(slot);
+		if (first_row)
+		{
+			/*
+			 * The batches written by this insert are not visible to the
+			 * lookup of the sequence number, so we only look it up for the
+			 * first batch of the segment.
+			 */
+			if (segment->sequence_num == 0)
+				row_compressor_update_group(row_compressor, slot);
+			else
+			{
+				row_compressor_update_segment_info(row_compressor, slot);
+				row_compressor->sequence_num = segment->sequence_num;
 			}
+			first_row = false;
 		}
-		/* if there is no compressor, this must be a segmenter */
-		else if (column->segment_info != NULL)
+		row_compressor_append_row(row_compressor, slot);
+		ExecClearTuple(slot);
+	}
+
+	row_compressor_flush(row_compressor, mycid, true);
+	MemoryContextSwitchTo(old_ctx);
+	segment->sequence_num = row_compressor->sequence_num;
+
+	if (sorted_rel != NULL)
+		tuplesort_end(sorted_rel);
+	compress_row_segment_reset(cr, segment);
+}
+
+/* hand the rows of the segments that didn't fill a batch back to the caller */
+static void
+compress_row_insert_buffered(CompressSingleRowState *cr)
+{
+	HASH_SEQ_STATUS status;
+	CompressRowSegmentEntry *entry;
+
+	hash_seq_init(&status, cr->segments);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		ListCell *lc;
+
+		foreach (lc, entry->segments)
 		{
-			out_isnull[out_colno] = column->segment_info->is_null;
-			if (column->segment_info->is_null)
-				out_values[out_colno] = 0;
-			else
-				out_values[out_colno] = invalues[in_colno];
+			CompressRowSegment *segment = lfirst(lc);
+
+			for (int i = 0; i < segment->num_rows; i++)
+			{
+				ExecStoreMinimalTuple(segment->rows[i], cr->buffer_slot, false);
+				cr->insert_row(cr->buffer_slot, cr->insert_row_data);
+				ExecClearTuple(cr->buffer_slot);
+			}
+			compress_row_segment_reset(cr, segment);
 		}
-		else
+	}
+
+	Assert(cr->num_buffered_rows == 0);
+}
+
+/* compress the rows of the segments that didn't fill a batch into smaller batches */
+static void
+compress_row_flush_partial(CompressSingleRowState *cr)
+{
+	HASH_SEQ_STATUS status;
+	CompressRowSegmentEntry *entry;
+
+	hash_seq_init(&status, cr->segments);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		ListCell *lc;
+
+		foreach (lc, entry->segments)
 		{
-			/* we have a 1-1 column mapping from uncompressed -> compressed chunk.
-			 * However, some columns could have been dropped from the uncompressed
-			 *chunk before the compressed one is created.
-			 */
-			Assert(out_colno == 0);
+			CompressRowSegment *segment = lfirst(lc);
+
+			if (segment->num_rows > 0)
+				compress_row_flush_segment(cr, segment, true);
 		}
 	}
 
-	/* fill in additional meta data info */
-	out_values[row_compressor->count_metadata_column_offset] =
-		Int32GetDatum(1); /*we have only 1 row */
-	out_isnull[row_compressor->count_metadata_column_offset] = false;
-	/* Add an invalid sequence number */
-	out_values[row_compressor->sequence_num_metadata_column_offset] = Int32GetDatum(0);
-	out_isnull[row_compressor->sequence_num_metadata_column_offset] = false;
+	Assert(cr->num_buffered_rows == 0);
+}
+
+/* empty the buffers of the segments that didn't fill a batch */
+static void
+compress_row_flush_buffered(CompressSingleRowState *cr)
+{
+	if (cr->compress_partial_batches)
+		compress_row_flush_partial(cr);
+	else
+		compress_row_insert_buffered(cr);
+}
+
+static void
+compress_row_buffer(CompressSingleRowState *cr, CompressRowSegment *segment, TupleTableSlot *slot)
+{
+	MemoryContext old_ctx = MemoryContextSwitchTo(cr->buffer_ctx);
+
+	if (segment->num_rows == segment->max_rows)
+	{
+		segment->max_rows = segment->max_rows == 0 ? 16 : segment->max_rows * 2;
+		if (segment->rows == NULL)
+			segment->rows = palloc(sizeof(MinimalTuple) * segment->max_rows);
+		else
+			segment->rows = repalloc(segment->rows, sizeof(MinimalTuple) * segment->max_rows);
+	}
+	segment->rows[segment->num_rows++] = ExecCopySlotMinimalTuple(slot);
+	cr->num_buffered_rows++;
+	MemoryContextSwitchTo(old_ctx);
+}
+
+/* buffer the row in its segment, compressing the segment when it fills a batch */
+void
+compress_row_exec(CompressSingleRowState *cr, TupleTableSlot *slot)
+{
+	CompressRowSegment *segment;
+
+	slot_getallattrs(slot);
+	segment = compress_row_get_segment(cr, slot);
+	compress_row_buffer(cr, segment, slot);
 
-	Assert(row_compressor->rows_compressed_into_current_value == 1);
-	ExecStoreVirtualTuple(out_slot);
-	return out_slot;
+	if ((uint32) segment->num_rows == cr->row_compressor->max_rows_per_compression)
+		compress_row_flush_segment(cr, segment, true);
+	else if (cr->num_buffered_rows >= COMPRESS_ROW_MAX_BUFFERED_ROWS)
+		compress_row_flush_buffered(cr);
 }
 
 void
 compress_row_end(CompressSingleRowState *cr)
 {
-	row_compressor_finish(&cr->row_compressor);
+	compress_row_flush_buffered(cr);
+	row_compressor_finish(cr->row_compressor);
 }
 
 void
 compress_row_destroy(CompressSingleRowState *cr)
 {
-	ExecDropSingleTupleTableSlot(cr->out_slot);
+	CatalogCloseIndexes(cr->row_compressor->index_state);
+	ExecDropSingleTupleTableSlot(cr->buffer_slot);
+	MemoryContextDelete(cr->buffer_ctx);
+}
+
+/*
+ * Hash-grouped compression of a chunk.
+ *
+ * When the rows of every segment are stored in the orderby order, e.g.,
+ * because they were inserted in time order, the chunk doesn't have to be
+ * sorted for compression. The rows are grouped by segment in the buffers of
+ * the compressed inserts in a single scan of the chunk, and a segment is
+ * compressed into a batch as it is whenever it has a full batch of rows. So
+ * at most one batch per segment is kept in memory.
+ *
+ * Every row is checked to come after the previous row of its segment. When
+ * one doesn't, the batches written so far are discarded by truncating the
+ * compressed chunk, which is only safe because it was created in the current
+ * subtransaction, and the chunk has to be compressed with a sort instead.
+ */
+static bool
+compress_row_is_in_order(CompressSingleRowState *cr, CompressRowSegment *segment,
+						 TupleTableSlot *slot)
+{
+	MinimalTuple previous =
+		segment->num_rows > 0 ? segment->rows[segment->num_rows - 1] : segment->last_row;
+	bool in_order = true;
+
+	if (previous == NULL)
+		return true;
+
+	ExecStoreMinimalTuple(previous, cr->buffer_slot, false);
+	for (int i = 0; i < cr->n_orderby_keys; i++)
+	{
+		bool previous_isnull, isnull;
+		Datum previous_value =
+			slot_getattr(cr->buffer_slot, cr->orderby_attnos[i], &previous_isnull);
+		Datum value = slot_getattr(slot, cr->orderby_attnos[i], &isnull);
+		int cmp = ApplySortComparator(previous_value,
+									  previous_isnull,
+									  value,
+									  isnull,
+									  &cr->orderby_ssup[i]);
+
+		if (cmp != 0)
+		{
+			in_order = cmp < 0;
+			break;
+		}
+	}
+	ExecClearTuple(cr->buffer_slot);
+
+	return in_order;
+}
+
+/* compress the segments that didn't fill their last batch */
+static void
+compress_row_flush_partial_segments(CompressSingleRowState *cr)
+{
+	HASH_SEQ_STATUS status;
+	CompressRowSegmentEntry *entry;
+
+	hash_seq_init(&status, cr->segments);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		ListCell *lc;
+
+		foreach (lc, entry->segments)
+		{
+			CompressRowSegment *segment = lfirst(lc);
+
+			if (segment->num_rows > 0)
+				compress_row_flush_segment(cr, segment, false);
+		}
+	}
+
+	Assert(cr->num_buffered_rows == 0);
+}
+
+/*
+ * Returns false if the chunk wasn't compressed, either because it can't be
+ * grouped by hashing or because its rows are not in order.
+ */
+static bool
+compress_chunk_hash_grouped(RowCompressor *row_compressor, Relation in_rel, Relation out_rel,
+							int n_keys, const ColumnCompressionInfo **keys)
+{
+	CompressSingleRowState *cr;
+	TableScanDesc scan;
+	TupleTableSlot *slot;
+	bool in_order = true;
+
+	if (out_rel->rd_createSubid != GetCurrentSubTransactionId() &&
+		out_rel->rd_newRelfilenodeSubid != GetCurrentSubTransactionId())
+		return false;
+
+	/* without segment by columns the whole chunk is a single segment */
+	if (n_keys == 0 || !COMPRESSIONCOL_IS_SEGMENT_BY(keys[0]))
+		return false;
+
+	cr = compress_row_state_create(in_rel, out_rel, n_keys, keys);
+	if (cr == NULL)
+		return false;
+
+	cr->row_compressor = row_compressor;
+	cr->n_orderby_keys = n_keys - cr->n_segment_keys;
+	cr->orderby_attnos = palloc(sizeof(*cr->orderby_attnos) * cr->n_orderby_keys);
+	cr->orderby_ssup = palloc0(sizeof(*cr->orderby_ssup) * cr->n_orderby_keys);
+	for (int i = 0; i < cr->n_orderby_keys; i++)
+	{
+		SortSupport ssup = &cr->orderby_ssup[i];
+		Oid sort_operator;
+
+		compress_chunk_populate_sort_info_for_column(RelationGetRelid(in_rel),
+													 keys[cr->n_segment_keys + i],
+													 &cr->orderby_attnos[i],
+													 &sort_operator,
+													 &ssup->ssup_collation,
+													 &ssup->ssup_nulls_first);
+		ssup->ssup_cxt = CurrentMemoryContext;
+		PrepareSortSupportFromOrderingOp(sort_operator, ssup);
+	}
+
+#ifdef TS_DEBUG
+	const char *compression_path =
+		GetConfigOption("timescaledb.show_compression_path_info", true, false);
+	if (compression_path != NULL && strcmp(compression_path, "on") == 0)
+		elog(INFO, "compress_chunk_hash_grouped_start");
+#endif
+
+	slot = table_slot_create(in_rel, NULL);
+	scan = table_beginscan(in_rel, GetLatestSnapshot(), 0, (ScanKey) NULL);
+	while (table_scan_getnextslot(scan, ForwardScanDirection, slot))
+	{
+		CompressRowSegment *segment;
+
+		slot_getallattrs(slot);
+		segment = compress_row_get_segment(cr, slot);
+		if (!compress_row_is_in_order(cr, segment, slot))
+		{
+			in_order = false;
+			break;
+		}
+
+		compress_row_buffer(cr, segment, slot);
+		if ((uint32) segment->num_rows == row_compressor->max_rows_per_compression)
+		{
+			/* keep the last row to check the order of the next batch against it */
+			MemoryContext old_ctx = MemoryContextSwitchTo(cr->buffer_ctx);
+
+			if (segment->last_row != NULL)
+				pfree(segment->last_row);
+			segment->last_row = heap_copy_minimal_tuple(segment->rows[segment->num_rows - 1]);
+			MemoryContextSwitchTo(old_ctx);
+
+			compress_row_flush_segment(cr, segment, false);
+		}
+	}
+	table_endscan(scan);
+	ExecDropSingleTupleTableSlot(slot);
+
+	if (in_order)
+	{
+		compress_row_flush_partial_segments(cr);
+		if (row_compressor->sample == NULL)
+			run_analyze_on_chunk(in_rel->rd_id);
+	}
+	else
+	{
+#ifdef TS_DEBUG
+		if (compression_path != NULL && strcmp(compression_path, "on") == 0)
+			elog(INFO, "compress_chunk_hash_grouped_out_of_order");
+#endif
+		row_compressor_discard(row_compressor);
+		heap_truncate_one_rel(out_rel);
+	}
+
+	ExecDropSingleTupleTableSlot(cr->buffer_slot);
+	MemoryContextDelete(cr->buffer_ctx);
+
+	return in_order;
 }
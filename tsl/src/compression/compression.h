@@ -8,9 +8,11 @@
 
 #include <postgres.h>
 #include <c.h>
+#include <access/skey.h>
 #include <executor/tuptable.h>
 #include <fmgr.h>
 #include <lib/stringinfo.h>
+#include <nodes/pg_list.h>
 #include <utils/relcache.h>
 /*
  * Compressed data starts with a specialized varlen type starting with the usual
@@ -57,6 +59,8 @@ struct Compressor
 {
 	void (*append_null)(Compressor *compressord);
 	void (*append_val)(Compressor *compressor, Datum val);
+	/* optional, appends n values at once, nulls[i] tells whether vals[i] is NULL */
+	void (*append_vals)(Compressor *compressor, const Datum *vals, const bool *nulls, int n);
 	void *(*finish)(Compressor *data);
 };
 
@@ -69,6 +73,40 @@ typedef struct DecompressionIterator
 	DecompressResult (*try_next)(struct DecompressionIterator *);
 } DecompressionIterator;
 
+/*
+ * Result of decompressing a whole compressed datum at once. The values are
+ * stored as a flat array in the in-memory representation of the element type,
+ * `value_bytes` bytes each, so that the value for row i can be fetched with
+ * fetch_att(). The validity bitmap has a set bit for every non-null row; it is
+ * NULL when the datum contains no nulls. The value of a null row is undefined.
+ */
+typedef struct DecompressedColumn
+{
+	int32 length;
+	int32 null_count;
+	int16 value_bytes;
+	const uint64 *validity;
+	const void *values;
+} DecompressedColumn;
+
+typedef DecompressedColumn *(*DecompressAllFunction)(Datum compressed, Oid element_type);
+
+static inline bool
+decompressed_column_is_null(const DecompressedColumn *column, int row)
+{
+	if (column->validity == NULL)
+		return false;
+
+	return (column->validity[row / 64] & (UINT64CONST(1) << (row % 64))) == 0;
+}
+
+/* Allocate a zeroed validity bitmap big enough for n_rows */
+static inline uint64 *
+decompressed_column_validity_alloc(int n_rows)
+{
+	return palloc0(sizeof(uint64) * ((n_rows + 63) / 64));
+}
+
 /*
  * TOAST_STORAGE_EXTENDED for out of line storage.
  * TOAST_STORAGE_EXTERNAL for out of line storage + native PG toast compression
@@ -90,6 +128,9 @@ typedef struct CompressionAlgorithmDefinition
 
 	Compressor *(*compressor_for_type)(Oid element_type);
 	CompressionStorage compressed_data_storage;
+
+	/* Optional bulk decompression, NULL if the algorithm only supports iterators */
+	DecompressAllFunction decompress_all;
 } CompressionAlgorithmDefinition;
 
 typedef enum CompressionAlgorithms
@@ -101,6 +142,9 @@ typedef enum CompressionAlgorithms
 	COMPRESSION_ALGORITHM_DICTIONARY,
 	COMPRESSION_ALGORITHM_GORILLA,
 	COMPRESSION_ALGORITHM_DELTADELTA,
+	COMPRESSION_ALGORITHM_BITPACK,
+	COMPRESSION_ALGORITHM_UUID,
+	COMPRESSION_ALGORITHM_JSONB,
 
 	/* When adding an algorithm also add a static assert statement below */
 	/* end of real values */
@@ -120,6 +164,8 @@ extern Datum tsl_compressed_data_send(PG_FUNCTION_ARGS);
 extern Datum tsl_compressed_data_recv(PG_FUNCTION_ARGS);
 extern Datum tsl_compressed_data_in(PG_FUNCTION_ARGS);
 extern Datum tsl_compressed_data_out(PG_FUNCTION_ARGS);
+extern Datum tsl_compressed_data_agg_transfn(PG_FUNCTION_ARGS);
+extern Datum tsl_compressed_data_agg_finalfn(PG_FUNCTION_ARGS);
 
 static void
 pg_attribute_unused() assert_num_compression_algorithms_sane(void)
@@ -134,31 +180,57 @@ pg_attribute_unused() assert_num_compression_algorithms_sane(void)
 	StaticAssertStmt(COMPRESSION_ALGORITHM_DICTIONARY == 2, "algorithm index has changed");
 	StaticAssertStmt(COMPRESSION_ALGORITHM_GORILLA == 3, "algorithm index has changed");
 	StaticAssertStmt(COMPRESSION_ALGORITHM_DELTADELTA == 4, "algorithm index has changed");
+	StaticAssertStmt(COMPRESSION_ALGORITHM_BITPACK == 5, "algorithm index has changed");
+	StaticAssertStmt(COMPRESSION_ALGORITHM_UUID == 6, "algorithm index has changed");
+	StaticAssertStmt(COMPRESSION_ALGORITHM_JSONB == 7, "algorithm index has changed");
 
 	/* This should change when adding a new algorithm after adding the new algorithm to the assert
 	 * list above. This statement prevents adding a new algorithm without updating the asserts above
 	 */
-	StaticAssertStmt(_END_COMPRESSION_ALGORITHMS == 5,
+	StaticAssertStmt(_END_COMPRESSION_ALGORITHMS == 8,
 					 "number of algorithms have changed, the asserts should be updated");
 }
 
 extern CompressionStorage compression_get_toast_storage(CompressionAlgorithms algo);
+extern void compression_sample_algorithms(Oid in_table, List *column_compression_info);
 extern CompressionStats compress_chunk(Oid in_table, Oid out_table,
 									   const ColumnCompressionInfo **column_compression_info,
 									   int num_compression_infos);
+extern CompressionStats
+recompress_chunk_segmentwise(Oid in_table, Oid out_table,
+							 const ColumnCompressionInfo **column_compression_info,
+							 int num_compression_infos);
 extern void decompress_chunk(Oid in_table, Oid out_table);
+extern int64 decompress_batches(Oid in_table, Oid out_table, ScanKeyData *scankeys,
+								int num_scankeys, int64 *deleted_batches);
+extern int64 decompress_batches_in_range(Oid in_table, Oid out_table, const char *min_column_name,
+										 const char *max_column_name, Oid column_type, Datum start,
+										 Datum end, int64 *deleted_batches);
+extern int64 delete_batches_before(Oid in_table, const char *max_column_name, Oid column_type,
+								   Datum cutoff, int64 *deleted_rows);
 
 extern DecompressionIterator *(*tsl_get_decompression_iterator_init(
 	CompressionAlgorithms algorithm, bool reverse))(Datum, Oid element_type);
+extern DecompressAllFunction tsl_get_decompress_all_function(CompressionAlgorithms algorithm);
+extern CompressionAlgorithms get_default_algorithm_id(Oid typeoid);
+extern DecompressedColumn *decompressed_column_build(Oid element_type,
+													 const uint64 *restrict values,
+													 uint32 n_values,
+													 const uint64 *restrict nulls, uint32 n_rows);
 extern void update_compressed_chunk_relstats(Oid uncompressed_relid, Oid compressed_relid);
 extern void merge_chunk_relstats(Oid merged_relid, Oid compressed_relid);
+extern int64 copy_chunk_rows(Oid src_relid, Oid dst_relid);
 
 /* CompressSingleRowState methods */
 struct CompressSingleRowState;
 typedef struct CompressSingleRowState CompressSingleRowState;
 
-extern CompressSingleRowState *compress_row_init(int srcht_id, Relation in_rel, Relation out_rel);
-extern TupleTableSlot *compress_row_exec(CompressSingleRowState *cr, TupleTableSlot *slot);
+extern CompressSingleRowState *compress_row_init(int srcht_id, Relation in_rel, Relation out_rel,
+												 bool compress_partial_batches,
+												 void (*insert_row)(TupleTableSlot *slot,
+																	void *data),
+												 void *data);
+extern void compress_row_exec(CompressSingleRowState *cr, TupleTableSlot *slot);
 extern void compress_row_end(CompressSingleRowState *cr);
 extern void compress_row_destroy(CompressSingleRowState *cr);
 
@@ -31,6 +31,7 @@
 #include <utils/syscache.h>
 #include <utils/typcache.h>
 
+#include "annotations.h"
 #include "ts_catalog/catalog.h"
 #include "create.h"
 #include "chunk.h"
@@ -42,6 +43,7 @@
 #include "hypertable_cache.h"
 #include "ts_catalog/hypertable_compression.h"
 #include "custom_type_cache.h"
+#include "guc.h"
 #include "trigger.h"
 #include "utils.h"
 
@@ -54,10 +56,12 @@ typedef struct CompressColInfo
 	FormData_hypertable_compression
 		*col_meta;	  /* metadata about columns from src hypertable that will be compressed*/
 	List *coldeflist; /*list of ColumnDef for the compressed column */
+	bool *minmax;	  /* columns that get min/max metadata without being orderby */
+	bool *bloom;	  /* columns that get the bloom filter metadata */
 } CompressColInfo;
 
 static void compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols,
-								 List *orderby_cols);
+								 List *orderby_cols, List *minmax_cols, List *bloom_cols);
 static void compresscolinfo_init_singlecolumn(CompressColInfo *cc, const char *colname, Oid typid);
 static void compresscolinfo_add_catalog_entries(CompressColInfo *compress_cols, int32 htid);
 
@@ -73,7 +77,7 @@ static void compresscolinfo_add_catalog_entries(CompressColInfo *compress_cols,
 		}                                                                                          \
 	} while (0);
 
-static enum CompressionAlgorithms
+enum CompressionAlgorithms
 get_default_algorithm_id(Oid typeoid)
 {
 	switch (typeoid)
@@ -93,6 +97,14 @@ get_default_algorithm_id(Oid typeoid)
 		case NUMERICOID:
 			return COMPRESSION_ALGORITHM_ARRAY;
 
+		case UUIDOID:
+		case JSONBOID:
+			if (typeoid == UUIDOID && ts_guc_enable_uuid_compression)
+				return COMPRESSION_ALGORITHM_UUID;
+			if (typeoid == JSONBOID && ts_guc_enable_jsonb_compression)
+				return COMPRESSION_ALGORITHM_JSONB;
+			TS_FALLTHROUGH;
+
 		default:
 		{
 			/* use dictitionary if possible, otherwise use array */
@@ -105,14 +117,46 @@ get_default_algorithm_id(Oid typeoid)
 	}
 }
 
+/*
+ * Name of a metadata column that is named after the column it describes, or
+ * NULL if the name doesn't fit into NAMEDATALEN.
+ */
+static char *
+compression_column_v2_metadata_name(const FormData_hypertable_compression *fd, const char *type)
+{
+	char *buf = palloc(sizeof(char) * NAMEDATALEN);
+	int ret = snprintf(buf,
+					   NAMEDATALEN,
+					   COMPRESSION_COLUMN_METADATA_V2_PREFIX "%s_%s",
+					   type,
+					   NameStr(fd->attname));
+
+	if (ret < 0 || ret >= NAMEDATALEN)
+	{
+		pfree(buf);
+		return NULL;
+	}
+	return buf;
+}
+
+/*
+ * The metadata columns of the orderby columns are named after the orderby
+ * index. The columns listed in the compress_minmax option are named after the
+ * column itself, so that they don't depend on the position of the column. For
+ * these, NULL is returned when the name doesn't fit into NAMEDATALEN, which
+ * means that the column can't have the metadata.
+ */
 static char *
 compression_column_segment_metadata_name(const FormData_hypertable_compression *fd,
 										 const char *type)
 {
-	char *buf = palloc(sizeof(char) * NAMEDATALEN);
+	char *buf;
 	int ret;
 
-	Assert(fd->orderby_column_index > 0);
+	if (fd->orderby_column_index <= 0)
+		return compression_column_v2_metadata_name(fd, type);
+
+	buf = palloc(sizeof(char) * NAMEDATALEN);
 	ret = snprintf(buf,
 				   NAMEDATALEN,
 				   COMPRESSION_COLUMN_METADATA_PREFIX "%s_%d",
@@ -138,6 +182,21 @@ compression_column_segment_max_name(const FormData_hypertable_compression *fd)
 	return compression_column_segment_metadata_name(fd, "max");
 }
 
+/* only the compress_minmax columns have the null count metadata */
+char *
+compression_column_segment_nulls_name(const FormData_hypertable_compression *fd)
+{
+	Assert(fd->orderby_column_index <= 0);
+	return compression_column_segment_metadata_name(fd, "nulls");
+}
+
+/* the bloom filter of the compress_bloom columns, named after the column */
+char *
+compression_column_segment_bloom1_name(const FormData_hypertable_compression *fd)
+{
+	return compression_column_v2_metadata_name(fd, "bloom1");
+}
+
 static void
 compresscolinfo_add_metadata_columns(CompressColInfo *cc, Relation uncompressed_rel)
 {
@@ -165,7 +224,7 @@ compresscolinfo_add_metadata_columns(CompressColInfo *cc, Relation uncompressed_
 
 	for (colno = 0; colno < cc->numcols; colno++)
 	{
-		if (cc->col_meta[colno].orderby_column_index > 0)
+		if (cc->col_meta[colno].orderby_column_index > 0 || cc->minmax[colno])
 		{
 			FormData_hypertable_compression fd = cc->col_meta[colno];
 			AttrNumber col_attno = get_attnum(uncompressed_rel->rd_id, NameStr(fd.attname));
@@ -176,9 +235,21 @@ compresscolinfo_add_metadata_columns(CompressColInfo *cc, Relation uncompressed_
 			if (!OidIsValid(type->lt_opr))
 				ereport(ERROR,
 						(errcode(ERRCODE_UNDEFINED_FUNCTION),
-						 errmsg("invalid ordering column type %s", format_type_be(attr->atttypid)),
+						 errmsg("invalid %s column type %s",
+								cc->minmax[colno] ? "min/max" : "ordering",
+								format_type_be(attr->atttypid)),
 						 errdetail("Could not identify a less-than operator for the type.")));
 
+			if (cc->minmax[colno] && compression_column_segment_nulls_name(&fd) == NULL)
+				ereport(ERROR,
+						(errcode(ERRCODE_NAME_TOO_LONG),
+						 errmsg("column name \"%s\" is too long for min/max metadata",
+								NameStr(fd.attname)),
+						 errhint("The timescaledb.compress_minmax columns must have names shorter "
+								 "than %d characters.",
+								 (int) (NAMEDATALEN - strlen(COMPRESSION_COLUMN_METADATA_V2_PREFIX
+															 "nulls_")))));
+
 			/* segment_meta min and max columns */
 			cc->coldeflist =
 				lappend(cc->coldeflist,
@@ -192,8 +263,59 @@ compresscolinfo_add_metadata_columns(CompressColInfo *cc, Relation uncompressed_
 									  attr->atttypid,
 									  -1 /* typemod */,
 									  0 /*collation*/));
+
+			/* count of NULL values of the compress_minmax columns */
+			if (cc->minmax[colno])
+				cc->coldeflist =
+					lappend(cc->coldeflist,
+							makeColumnDef(compression_column_segment_nulls_name(
+											  &cc->col_meta[colno]),
+										  INT4OID,
+										  -1 /* typemod */,
+										  0 /*collation*/));
 		}
 	}
+
+	/* bloom filters of the compress_bloom columns */
+	for (colno = 0; colno < cc->numcols; colno++)
+	{
+		FormData_hypertable_compression *fd = &cc->col_meta[colno];
+		char *bloom_name;
+		AttrNumber col_attno;
+		Form_pg_attribute attr;
+		TypeCacheEntry *type;
+
+		if (!cc->bloom[colno])
+			continue;
+
+		col_attno = get_attnum(uncompressed_rel->rd_id, NameStr(fd->attname));
+		attr = TupleDescAttr(RelationGetDescr(uncompressed_rel),
+							 AttrNumberGetAttrOffset(col_attno));
+		type = lookup_type_cache(attr->atttypid, TYPECACHE_HASH_EXTENDED_PROC);
+
+		if (!OidIsValid(type->hash_extended_proc))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_FUNCTION),
+					 errmsg("invalid bloom filter column type %s", format_type_be(attr->atttypid)),
+					 errdetail("Could not identify an extended hash function for the type.")));
+
+		bloom_name = compression_column_segment_bloom1_name(fd);
+		if (bloom_name == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_NAME_TOO_LONG),
+					 errmsg("column name \"%s\" is too long for bloom filter metadata",
+							NameStr(fd->attname)),
+					 errhint("The timescaledb.compress_bloom columns must have names shorter "
+							 "than %d characters.",
+							 (int) (NAMEDATALEN - strlen(COMPRESSION_COLUMN_METADATA_V2_PREFIX
+														 "bloom1_")))));
+
+		cc->coldeflist = lappend(cc->coldeflist,
+								 makeColumnDef(bloom_name,
+											   BYTEAOID,
+											   -1 /* typemod */,
+											   0 /*collation*/));
+	}
 }
 
 /*
@@ -203,15 +325,19 @@ compresscolinfo_add_metadata_columns(CompressColInfo *cc, Relation uncompressed_
  * 2. create the columndefs for the new compressed hypertable
  *     segmentby_cols have same datatype as the original table
  *     all other cols have COMPRESSEDDATA_TYPE type
+ * 3. mark the minmax_cols that need the min/max metadata columns in addition
+ *    to the orderby cols, and the bloom_cols that need the bloom filter
  */
 static void
 compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols,
-					 List *orderby_cols)
+					 List *orderby_cols, List *minmax_cols, List *bloom_cols)
 {
 	Relation rel;
 	TupleDesc tupdesc;
 	int i, colno, attno;
 	int16 *segorder_colindex;
+	bool *minmax_attno;
+	bool *bloom_attno;
 	int seg_attnolen = 0;
 	ListCell *lc;
 	Oid compresseddata_oid = ts_custom_type_cache_get(CUSTOM_TYPE_COMPRESSED_DATA)->type_oid;
@@ -263,8 +389,62 @@ compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols
 		segorder_colindex[col_attno - 1] = i++;
 	}
 
+	minmax_attno = palloc0(sizeof(bool) * (rel->rd_att->natts));
+	foreach (lc, minmax_cols)
+	{
+		CompressedParsedCol *col = (CompressedParsedCol *) lfirst(lc);
+		AttrNumber col_attno = get_attnum(rel->rd_id, NameStr(col->colname));
+
+		if (col_attno == InvalidAttrNumber)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("column \"%s\" does not exist", NameStr(col->colname)),
+					 errhint("The timescaledb.compress_minmax option must reference a valid "
+							 "column.")));
+
+		if (segorder_colindex[col_attno - 1] > 0 &&
+			segorder_colindex[col_attno - 1] <= seg_attnolen)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("cannot use column \"%s\" for both min/max metadata and segmenting",
+							NameStr(col->colname)),
+					 errhint("The segmentby columns are stored uncompressed and do not need "
+							 "min/max metadata.")));
+
+		/* the orderby columns always have the min/max metadata */
+		if (segorder_colindex[col_attno - 1] == 0)
+			minmax_attno[col_attno - 1] = true;
+	}
+
+	bloom_attno = palloc0(sizeof(bool) * (rel->rd_att->natts));
+	foreach (lc, bloom_cols)
+	{
+		CompressedParsedCol *col = (CompressedParsedCol *) lfirst(lc);
+		AttrNumber col_attno = get_attnum(rel->rd_id, NameStr(col->colname));
+
+		if (col_attno == InvalidAttrNumber)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("column \"%s\" does not exist", NameStr(col->colname)),
+					 errhint("The timescaledb.compress_bloom option must reference a valid "
+							 "column.")));
+
+		if (segorder_colindex[col_attno - 1] > 0 &&
+			segorder_colindex[col_attno - 1] <= seg_attnolen)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("cannot use column \"%s\" for both bloom filter and segmenting",
+							NameStr(col->colname)),
+					 errhint("The segmentby columns are stored uncompressed and do not need "
+							 "a bloom filter.")));
+
+		bloom_attno[col_attno - 1] = true;
+	}
+
 	cc->numcols = 0;
 	cc->col_meta = palloc0(sizeof(FormData_hypertable_compression) * tupdesc->natts);
+	cc->minmax = palloc0(sizeof(bool) * tupdesc->natts);
+	cc->bloom = palloc0(sizeof(bool) * tupdesc->natts);
 	cc->coldeflist = NIL;
 	colno = 0;
 	for (attno = 0; attno < tupdesc->natts; attno++)
@@ -285,6 +465,8 @@ compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols
 				 COMPRESSION_COLUMN_METADATA_PREFIX);
 
 		namestrcpy(&cc->col_meta[colno].attname, NameStr(attr->attname));
+		cc->minmax[colno] = minmax_attno[attno];
+		cc->bloom[colno] = bloom_attno[attno];
 		if (segorder_colindex[attno] > 0)
 		{
 			if (segorder_colindex[attno] <= seg_attnolen)
@@ -319,6 +501,8 @@ compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols
 	cc->numcols = colno;
 	compresscolinfo_add_metadata_columns(cc, rel);
 	pfree(segorder_colindex);
+	pfree(minmax_attno);
+	pfree(bloom_attno);
 	table_close(rel, AccessShareLock);
 }
 
@@ -335,6 +519,8 @@ compresscolinfo_init_singlecolumn(CompressColInfo *cc, const char *colname, Oid
 
 	cc->numcols = 1;
 	cc->col_meta = palloc0(sizeof(FormData_hypertable_compression) * cc->numcols);
+	cc->minmax = palloc0(sizeof(bool) * cc->numcols);
+	cc->bloom = palloc0(sizeof(bool) * cc->numcols);
 	cc->coldeflist = NIL;
 	namestrcpy(&cc->col_meta[colno].attname, colname);
 	cc->col_meta[colno].algo_id = get_default_algorithm_id(typid);
@@ -344,6 +530,11 @@ compresscolinfo_init_singlecolumn(CompressColInfo *cc, const char *colname, Oid
 
 /* modify storage attributes for toast table columns attached to the
  * compression table
+ *
+ * The columns with extended storage are compressed again when they are
+ * TOASTed. pglz is slow for this and often gives up on the compressed
+ * data, so the TOAST compression method of these columns can be set with
+ * timescaledb.compress_toast_compression.
  */
 static void
 modify_compressed_toast_table_storage(CompressColInfo *cc, Oid compress_relid)
@@ -365,6 +556,19 @@ modify_compressed_toast_table_storage(CompressColInfo *cc, Oid compress_relid)
 				Assert(stor == TOAST_STORAGE_EXTENDED);
 				cmd->def = (Node *) makeString("extended");
 				cmds = lappend(cmds, cmd);
+#if PG14_GE
+				if (ts_guc_compress_toast_compression != COMPRESS_TOAST_COMPRESSION_DEFAULT)
+				{
+					cmd = makeNode(AlterTableCmd);
+					cmd->subtype = AT_SetCompression;
+					cmd->name = pstrdup(NameStr(cc->col_meta[colno].attname));
+					cmd->def = (Node *) makeString(ts_guc_compress_toast_compression ==
+														   COMPRESS_TOAST_COMPRESSION_LZ4 ?
+													   "lz4" :
+													   "pglz");
+					cmds = lappend(cmds, cmd);
+				}
+#endif
 			}
 		}
 	}
@@ -540,6 +744,18 @@ set_statistics_on_compressed_table(Oid compressed_table_id)
 	table_close(table_rel, NoLock);
 }
 
+/*
+ * Use a low toast_tuple_target so that all compressed columns are moved out
+ * of line and the heap row of a batch only holds the TOAST pointers and the
+ * metadata columns. Only the compressed columns that are referenced by a
+ * query are fetched from the TOAST table.
+ *
+ * Note that the TOAST chunks of the columns of a batch are written one
+ * column after the other, so the data of a single column is not contiguous
+ * across batches. The heap AM re-toasts any external datum in a new tuple,
+ * so a column-major layout cannot be produced through heap_insert and would
+ * need separate per-column relations or a table access method.
+ */
 static void
 set_toast_tuple_target_on_compressed(Oid compressed_table_id)
 {
@@ -981,7 +1197,9 @@ disable_compression(Hypertable *ht, WithClauseResult *with_clause_options)
 {
 	bool compression_already_enabled = TS_HYPERTABLE_HAS_COMPRESSION_ENABLED(ht);
 	if (!with_clause_options[CompressOrderBy].is_default ||
-		!with_clause_options[CompressSegmentBy].is_default)
+		!with_clause_options[CompressSegmentBy].is_default ||
+		!with_clause_options[CompressMinMax].is_default ||
+		!with_clause_options[CompressBloom].is_default)
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("invalid compression configuration"),
@@ -1086,6 +1304,8 @@ tsl_process_compress_table(AlterTableCmd *cmd, Hypertable *ht,
 	Oid ownerid;
 	List *segmentby_cols;
 	List *orderby_cols;
+	List *minmax_cols;
+	List *bloom_cols;
 	List *constraint_list = NIL;
 
 	if (TS_HYPERTABLE_IS_INTERNAL_COMPRESSION_TABLE(ht))
@@ -1118,11 +1338,18 @@ tsl_process_compress_table(AlterTableCmd *cmd, Hypertable *ht,
 	segmentby_cols = ts_compress_hypertable_parse_segment_by(with_clause_options, ht);
 	orderby_cols = ts_compress_hypertable_parse_order_by(with_clause_options, ht);
 	orderby_cols = add_time_to_order_by_if_not_included(orderby_cols, segmentby_cols, ht);
+	minmax_cols = ts_compress_hypertable_parse_minmax(with_clause_options, ht);
+	bloom_cols = ts_compress_hypertable_parse_bloom(with_clause_options, ht);
 
 	if (TS_HYPERTABLE_HAS_COMPRESSION_ENABLED(ht))
 		check_modify_compression_options(ht, with_clause_options, orderby_cols);
 
-	compresscolinfo_init(&compress_cols, ht->main_table_relid, segmentby_cols, orderby_cols);
+	compresscolinfo_init(&compress_cols,
+						 ht->main_table_relid,
+						 segmentby_cols,
+						 orderby_cols,
+						 minmax_cols,
+						 bloom_cols);
 	/* check if we can create a compressed hypertable with existing constraints */
 	constraint_list = validate_existing_constraints(ht, &compress_cols);
 
@@ -1227,12 +1454,86 @@ tsl_process_compress_table_drop_column(Hypertable *ht, char *name)
 	if (TS_HYPERTABLE_HAS_COMPRESSION_TABLE(ht))
 	{
 		Hypertable *compress_ht = ts_hypertable_get_by_id(ht->fd.compressed_hypertable_id);
+		char *meta_names[] = {
+			compression_column_segment_min_name(ht_comp),
+			compression_column_segment_max_name(ht_comp),
+			compression_column_segment_nulls_name(ht_comp),
+			compression_column_segment_bloom1_name(ht_comp),
+		};
+
 		drop_column_from_compression_table(compress_ht, name);
+
+		/* the min/max and bloom filter metadata of the column, if any */
+		for (size_t i = 0; i < TS_ARRAY_LEN(meta_names); i++)
+		{
+			if (meta_names[i] != NULL &&
+				get_attnum(compress_ht->main_table_relid, meta_names[i]) != InvalidAttrNumber)
+				drop_column_from_compression_table(compress_ht, meta_names[i]);
+		}
 	}
 
 	ts_hypertable_compression_delete_by_pkey(ht->fd.id, name);
 }
 
+/*
+ * The metadata columns of the compress_minmax and compress_bloom columns are
+ * named after the column, so they have to be renamed together with it.
+ */
+static void
+rename_v2_metadata_columns(Hypertable *ht, Hypertable *compress_ht, const char *oldname,
+						   const char *newname)
+{
+	FormData_hypertable_compression *ht_comp =
+		ts_hypertable_compression_get_by_pkey(ht->fd.id, oldname);
+	FormData_hypertable_compression new_comp;
+	char *(*meta_name_funcs[])(const FormData_hypertable_compression *) = {
+		compression_column_segment_bloom1_name,
+		compression_column_segment_min_name,
+		compression_column_segment_max_name,
+		compression_column_segment_nulls_name,
+	};
+	size_t num_funcs = TS_ARRAY_LEN(meta_name_funcs);
+
+	if (ht_comp == NULL || ht_comp->segmentby_column_index > 0)
+		return;
+
+	/* the min/max metadata of the orderby columns is named after the orderby index */
+	if (ht_comp->orderby_column_index > 0)
+		num_funcs = 1;
+
+	new_comp = *ht_comp;
+	namestrcpy(&new_comp.attname, newname);
+
+	for (size_t i = 0; i < num_funcs; i++)
+	{
+		char *old_meta_name = meta_name_funcs[i](ht_comp);
+		char *new_meta_name;
+		RenameStmt *rename;
+
+		if (old_meta_name == NULL ||
+			get_attnum(compress_ht->main_table_relid, old_meta_name) == InvalidAttrNumber)
+			continue;
+
+		new_meta_name = meta_name_funcs[i](&new_comp);
+		if (new_meta_name == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_NAME_TOO_LONG),
+					 errmsg("column name \"%s\" is too long for the metadata", newname),
+					 errhint("The column has metadata set by the timescaledb.compress_minmax"
+							 " or timescaledb.compress_bloom option.")));
+
+		rename = makeNode(RenameStmt);
+		rename->renameType = OBJECT_COLUMN;
+		rename->relationType = OBJECT_TABLE;
+		rename->relation = makeRangeVar(NameStr(compress_ht->fd.schema_name),
+										NameStr(compress_ht->fd.table_name),
+										-1);
+		rename->subname = old_meta_name;
+		rename->newname = new_meta_name;
+		ExecRenameStmt(rename);
+	}
+}
+
 /* Rename a column on a hypertable that has compression enabled.
  *
  * This function renames the existing column in the internal compression table.
@@ -1256,6 +1557,7 @@ tsl_process_compress_table_rename_column(Hypertable *ht, const RenameStmt *stmt)
 												   NameStr(compress_ht->fd.table_name),
 												   -1);
 		ExecRenameStmt(compress_col_stmt);
+		rename_v2_metadata_columns(ht, compress_ht, stmt->subname, stmt->newname);
 	}
 	// update catalog entries for the renamed column for the hypertable
 	ts_hypertable_compression_rename_column(orig_htid, stmt->subname, stmt->newname);
@@ -15,6 +15,8 @@
 #define COMPRESSION_COLUMN_METADATA_COUNT_NAME COMPRESSION_COLUMN_METADATA_PREFIX "count"
 #define COMPRESSION_COLUMN_METADATA_SEQUENCE_NUM_NAME                                              \
 	COMPRESSION_COLUMN_METADATA_PREFIX "sequence_num"
+/* prefix of the metadata columns of the timescaledb.compress_minmax columns */
+#define COMPRESSION_COLUMN_METADATA_V2_PREFIX COMPRESSION_COLUMN_METADATA_PREFIX "v2_"
 
 bool tsl_process_compress_table(AlterTableCmd *cmd, Hypertable *ht,
 								WithClauseResult *with_clause_options);
@@ -25,5 +27,7 @@ Chunk *create_compress_chunk(Hypertable *compress_ht, Chunk *src_chunk, Oid tabl
 
 char *compression_column_segment_min_name(const FormData_hypertable_compression *fd);
 char *compression_column_segment_max_name(const FormData_hypertable_compression *fd);
+char *compression_column_segment_nulls_name(const FormData_hypertable_compression *fd);
+char *compression_column_segment_bloom1_name(const FormData_hypertable_compression *fd);
 
 #endif /* TIMESCALEDB_TSL_COMPRESSION_CREATE_H */
@@ -233,55 +233,77 @@ datum_to_bytes_and_advance(DatumSerializer *serializer, char *start, Size *max_s
 
 typedef struct DatumDeserializer
 {
+	Oid type_oid;
 	bool type_by_val;
 	int16 type_len;
 	char type_align;
 	char type_storage;
 
+	/* lazy load, only the binary string deserialization needs these */
+	bool io_info_set;
 	Oid type_recv;
-
 	Oid type_in;
 	Oid type_io_param;
 	int32 type_mod;
-	/* lazy load */
+
 	bool recv_info_set;
 	FmgrInfo recv_flinfo;
 	bool use_binary_recv;
 } DatumDeserializer;
 
+/*
+ * A deserializer is created for every compressed value that is decompressed,
+ * so the in-memory deserialization only uses the type cache. The send/recv
+ * in/out functions that aren't in the type cache are looked up in the syscache
+ * the first time a binary string is deserialized.
+ */
 DatumDeserializer *
 create_datum_deserializer(Oid type_oid)
 {
 	DatumDeserializer *res = palloc(sizeof(*res));
-	/* we use the syscache and not the type cache here b/c we need the
-	 * send/recv in/out functions that aren't in type cache */
-	Form_pg_type type;
-	HeapTuple tup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(type_oid));
-	if (!HeapTupleIsValid(tup))
-		elog(ERROR, "cache lookup failed for type %u", type_oid);
-	type = (Form_pg_type) GETSTRUCT(tup);
+	TypeCacheEntry *type = lookup_type_cache(type_oid, 0);
 
 	*res = (DatumDeserializer){
+		.type_oid = type_oid,
 		.type_by_val = type->typbyval,
 		.type_len = type->typlen,
 		.type_align = type->typalign,
 		.type_storage = type->typstorage,
-		.type_recv = type->typreceive,
-		.type_in = type->typinput,
-		.type_io_param = getTypeIOParam(tup),
-		.type_mod = type->typtypmod,
 	};
 
-	ReleaseSysCache(tup);
 	return res;
 }
 
+static void
+load_io_info(DatumDeserializer *des)
+{
+	Form_pg_type type;
+	HeapTuple tup;
+
+	if (des->io_info_set)
+		return;
+
+	tup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(des->type_oid));
+	if (!HeapTupleIsValid(tup))
+		elog(ERROR, "cache lookup failed for type %u", des->type_oid);
+	type = (Form_pg_type) GETSTRUCT(tup);
+
+	des->type_recv = type->typreceive;
+	des->type_in = type->typinput;
+	des->type_io_param = getTypeIOParam(tup);
+	des->type_mod = type->typtypmod;
+	des->io_info_set = true;
+
+	ReleaseSysCache(tup);
+}
+
 static inline void
 load_recv_fn(DatumDeserializer *des, bool use_binary)
 {
 	if (des->recv_info_set && des->use_binary_recv == use_binary)
 		return;
 
+	load_io_info(des);
 	des->recv_info_set = true;
 	des->use_binary_recv = use_binary;
 
@@ -291,7 +313,14 @@ load_recv_fn(DatumDeserializer *des, bool use_binary)
 		fmgr_info(des->type_in, &des->recv_flinfo);
 }
 
-/* Loosely based on `range_deserialize` in rangetypes.c */
+/*
+ * Loosely based on `range_deserialize` in rangetypes.c
+ *
+ * The values are not copied: a by-reference Datum points into the serialized
+ * data, so the data must outlive the Datum. The varlenas are stored either
+ * with a short header that needs no alignment or aligned with a full header,
+ * so the pointer is always a valid Datum of the type.
+ */
 Datum
 bytes_to_datum_and_advance(DatumDeserializer *deserializer, const char **ptr)
 {
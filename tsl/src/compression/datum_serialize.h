@@ -39,7 +39,7 @@ void datum_append_to_binary_string(DatumSerializer *serializer, BinaryStringEnco
 typedef struct DatumDeserializer DatumDeserializer;
 DatumDeserializer *create_datum_deserializer(Oid type);
 
-/* deserialization from bytes in memory */
+/* deserialization from bytes in memory, the result points into the bytes */
 Datum bytes_to_datum_and_advance(DatumDeserializer *deserializer, const char **ptr);
 
 /* deserialization from binary strings (for recv functions) */
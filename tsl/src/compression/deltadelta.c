@@ -20,8 +20,10 @@
 
 #include <utils.h>
 
+#include "compression/bitpack.h"
 #include "compression/compression.h"
 #include "compression/simple8b_rle.h"
+#include "guc.h"
 
 static uint64 zig_zag_encode(uint64 value);
 static uint64 zig_zag_decode(uint64 value);
@@ -67,6 +69,10 @@ typedef struct DeltaDeltaCompressor
 	Simple8bRleCompressor delta_delta;
 	Simple8bRleCompressor nulls;
 	bool has_nulls;
+	/* the range of the values, to check whether bitpack would be smaller */
+	uint32 num_values;
+	int64 min_value;
+	int64 max_value;
 } DeltaDeltaCompressor;
 
 typedef struct ExtendedCompressor
@@ -145,6 +151,106 @@ deltadelta_compressor_append_timestamptz(Compressor *compressor, Datum val)
 	delta_delta_compressor_append_value(extended->internal, DatumGetTimestampTz(val));
 }
 
+static inline void delta_delta_compressor_append_value_internal(DeltaDeltaCompressor *compressor,
+																int64 next_val);
+
+/*
+ * Append a batch of values of the given type. This is inlined into the
+ * per-type functions below, so the conversion of the datums is resolved at
+ * compile time and the loop makes no indirect calls.
+ */
+static pg_attribute_always_inline void
+deltadelta_compressor_append_datums(Compressor *compressor, const Datum *vals, const bool *nulls,
+									int n, Oid element_type)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	DeltaDeltaCompressor *internal;
+
+	if (extended->internal == NULL)
+		extended->internal = delta_delta_compressor_alloc();
+	internal = extended->internal;
+
+	for (int i = 0; i < n; i++)
+	{
+		int64 value;
+
+		if (nulls[i])
+		{
+			delta_delta_compressor_append_null(internal);
+			continue;
+		}
+
+		switch (element_type)
+		{
+			case BOOLOID:
+				value = DatumGetBool(vals[i]) ? 1 : 0;
+				break;
+			case INT2OID:
+				value = DatumGetInt16(vals[i]);
+				break;
+			case INT4OID:
+				value = DatumGetInt32(vals[i]);
+				break;
+			case DATEOID:
+				value = DatumGetDateADT(vals[i]);
+				break;
+			default:
+				value = DatumGetInt64(vals[i]);
+				break;
+		}
+		delta_delta_compressor_append_value_internal(internal, value);
+	}
+}
+
+static void
+deltadelta_compressor_append_bools(Compressor *compressor, const Datum *vals, const bool *nulls,
+								   int n)
+{
+	deltadelta_compressor_append_datums(compressor, vals, nulls, n, BOOLOID);
+}
+
+static void
+deltadelta_compressor_append_int16s(Compressor *compressor, const Datum *vals, const bool *nulls,
+									int n)
+{
+	deltadelta_compressor_append_datums(compressor, vals, nulls, n, INT2OID);
+}
+
+static void
+deltadelta_compressor_append_int32s(Compressor *compressor, const Datum *vals, const bool *nulls,
+									int n)
+{
+	deltadelta_compressor_append_datums(compressor, vals, nulls, n, INT4OID);
+}
+
+static void
+deltadelta_compressor_append_int64s(Compressor *compressor, const Datum *vals, const bool *nulls,
+									int n)
+{
+	deltadelta_compressor_append_datums(compressor, vals, nulls, n, INT8OID);
+}
+
+static void
+deltadelta_compressor_append_dates(Compressor *compressor, const Datum *vals, const bool *nulls,
+								   int n)
+{
+	deltadelta_compressor_append_datums(compressor, vals, nulls, n, DATEOID);
+}
+
+static void
+deltadelta_compressor_append_timestamps(Compressor *compressor, const Datum *vals,
+										const bool *nulls, int n)
+{
+	deltadelta_compressor_append_datums(compressor, vals, nulls, n, TIMESTAMPOID);
+}
+
+static void
+deltadelta_compressor_append_timestamptzs(Compressor *compressor, const Datum *vals,
+										  const bool *nulls, int n)
+{
+	deltadelta_compressor_append_datums(compressor, vals, nulls, n, TIMESTAMPTZOID);
+}
+
 static void
 deltadelta_compressor_append_null_value(Compressor *compressor)
 {
@@ -167,42 +273,105 @@ deltadelta_compressor_finish_and_reset(Compressor *compressor)
 	return compressed;
 }
 
+/*
+ * Decompress the delta-of-deltas and compress the values again with bitpack,
+ * see deltadelta_compressor_finish_integer_and_reset().
+ */
+static void *
+delta_delta_compressed_to_bitpack(DeltaDeltaCompressed *compressed)
+{
+	BitpackCompressor *compressor = bitpack_compressor_alloc();
+	DecompressionIterator *iter =
+		delta_delta_decompression_iterator_from_datum_forward(PointerGetDatum(compressed),
+															  INT8OID);
+
+	for (DecompressResult res = delta_delta_decompression_iterator_try_next_forward(iter);
+		 !res.is_done;
+		 res = delta_delta_decompression_iterator_try_next_forward(iter))
+	{
+		if (res.is_null)
+			bitpack_compressor_append_null(compressor);
+		else
+			bitpack_compressor_append_value(compressor, DatumGetInt64(res.val));
+	}
+
+	return bitpack_compressor_finish(compressor);
+}
+
+/*
+ * The integer columns are often not monotonic, e.g. status codes or small
+ * counters, and then the delta-of-deltas are larger than the values
+ * themselves. Such batches are stored with bitpack instead, when it is enabled
+ * and smaller. Both encodings use the same nulls bitmap, so only the sizes of
+ * the values are compared.
+ */
+static void *
+deltadelta_compressor_finish_integer_and_reset(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	DeltaDeltaCompressor *internal = extended->internal;
+	DeltaDeltaCompressed *compressed = delta_delta_compressor_finish(internal);
+	void *result = compressed;
+
+	if (compressed != NULL && ts_guc_enable_bitpack_compression &&
+		bitpack_compressed_size_without_nulls(internal->min_value,
+											  internal->max_value,
+											  internal->num_values) <
+			sizeof(DeltaDeltaCompressed) +
+				simple8brle_serialized_slot_size(&compressed->delta_deltas))
+	{
+		result = delta_delta_compressed_to_bitpack(compressed);
+		pfree(compressed);
+	}
+
+	pfree(internal);
+	extended->internal = NULL;
+	return result;
+}
+
 const Compressor deltadelta_bool_compressor = {
 	.append_val = deltadelta_compressor_append_bool,
+	.append_vals = deltadelta_compressor_append_bools,
 	.append_null = deltadelta_compressor_append_null_value,
 	.finish = deltadelta_compressor_finish_and_reset,
 };
 
 const Compressor deltadelta_uint16_compressor = {
 	.append_val = deltadelta_compressor_append_int16,
+	.append_vals = deltadelta_compressor_append_int16s,
 	.append_null = deltadelta_compressor_append_null_value,
-	.finish = deltadelta_compressor_finish_and_reset,
+	.finish = deltadelta_compressor_finish_integer_and_reset,
 };
 const Compressor deltadelta_uint32_compressor = {
 	.append_val = deltadelta_compressor_append_int32,
+	.append_vals = deltadelta_compressor_append_int32s,
 	.append_null = deltadelta_compressor_append_null_value,
-	.finish = deltadelta_compressor_finish_and_reset,
+	.finish = deltadelta_compressor_finish_integer_and_reset,
 };
 const Compressor deltadelta_uint64_compressor = {
 	.append_val = deltadelta_compressor_append_int64,
+	.append_vals = deltadelta_compressor_append_int64s,
 	.append_null = deltadelta_compressor_append_null_value,
-	.finish = deltadelta_compressor_finish_and_reset,
+	.finish = deltadelta_compressor_finish_integer_and_reset,
 };
 
 const Compressor deltadelta_date_compressor = {
 	.append_val = deltadelta_compressor_append_date,
+	.append_vals = deltadelta_compressor_append_dates,
 	.append_null = deltadelta_compressor_append_null_value,
 	.finish = deltadelta_compressor_finish_and_reset,
 };
 
 const Compressor deltadelta_timestamp_compressor = {
 	.append_val = deltadelta_compressor_append_timestamp,
+	.append_vals = deltadelta_compressor_append_timestamps,
 	.append_null = deltadelta_compressor_append_null_value,
 	.finish = deltadelta_compressor_finish_and_reset,
 };
 
 const Compressor deltadelta_timestamptz_compressor = {
 	.append_val = deltadelta_compressor_append_timestamptz,
+	.append_vals = deltadelta_compressor_append_timestamptzs,
 	.append_null = deltadelta_compressor_append_null_value,
 	.finish = deltadelta_compressor_finish_and_reset,
 };
@@ -374,6 +543,12 @@ delta_delta_compressor_append_null(DeltaDeltaCompressor *compressor)
 
 void
 delta_delta_compressor_append_value(DeltaDeltaCompressor *compressor, int64 next_val)
+{
+	delta_delta_compressor_append_value_internal(compressor, next_val);
+}
+
+static inline void
+delta_delta_compressor_append_value_internal(DeltaDeltaCompressor *compressor, int64 next_val)
 {
 	uint64 delta;
 	uint64 delta_delta;
@@ -393,6 +568,12 @@ delta_delta_compressor_append_value(DeltaDeltaCompressor *compressor, int64 next
 	compressor->prev_val = next_val;
 	compressor->prev_delta = delta;
 
+	if (compressor->num_values == 0 || next_val < compressor->min_value)
+		compressor->min_value = next_val;
+	if (compressor->num_values == 0 || next_val > compressor->max_value)
+		compressor->max_value = next_val;
+	compressor->num_values++;
+
 	/* step 2: ZigZag encode */
 	encoded = zig_zag_encode(delta_delta);
 
@@ -641,6 +822,82 @@ delta_delta_decompression_iterator_from_datum_reverse(Datum deltadelta_compresse
 	return &iterator->base;
 }
 
+/*
+ * Decompress the whole datum at once. Since the delta-of-deltas are decoded in
+ * bulk, reconstructing the values is just two running sums over a flat array,
+ * which is much cheaper than going through the iterator for every value.
+ *
+ * The running sums are computed for groups of DELTA_DELTA_SUM_GROUP values.
+ * Inside a group, the prefix sums of the delta-of-deltas and of those prefix
+ * sums don't depend on the previous groups, so only one addition per running
+ * sum is carried from group to group and the CPU can overlap the groups.
+ */
+#define DELTA_DELTA_SUM_GROUP 4
+
+DecompressedColumn *
+delta_delta_decompress_all(Datum compressed_data, Oid element_type)
+{
+	DeltaDeltaCompressed *compressed = (DeltaDeltaCompressed *) PG_DETOAST_DATUM(compressed_data);
+	const char *data = (char *) &compressed->delta_deltas;
+	Simple8bRleSerialized *deltas = bytes_deserialize_simple8b_and_advance(&data);
+	const uint32 n_values = deltas->num_elements;
+	uint64 *values = palloc(sizeof(uint64) * Max(n_values, 1));
+	uint64 *nulls = NULL;
+	uint32 n_rows = n_values;
+	uint64 current_delta = 0;
+	uint64 current_value = 0;
+	uint32 i = 0;
+
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	simple8brle_decompress_all_buf(deltas, values, n_values);
+
+	/* no dependencies between the values here, so this loop vectorizes */
+	for (i = 0; i < n_values; i++)
+		values[i] = zig_zag_decode(values[i]);
+
+	/*
+	 * With the prefix sums of the delta-of-deltas in the group p[k] and the
+	 * sums of those q[k], the values of the group are
+	 * current_value + (k + 1) * current_delta + q[k].
+	 */
+	for (i = 0; i + DELTA_DELTA_SUM_GROUP <= n_values; i += DELTA_DELTA_SUM_GROUP)
+	{
+		uint64 p = 0;
+		uint64 q = 0;
+
+		for (uint32 k = 0; k < DELTA_DELTA_SUM_GROUP; k++)
+		{
+			p += values[i + k];
+			q += p;
+			values[i + k] = current_value + (k + 1) * current_delta + q;
+		}
+
+		current_value += DELTA_DELTA_SUM_GROUP * current_delta + q;
+		current_delta += p;
+	}
+
+	for (; i < n_values; i++)
+	{
+		current_delta += values[i];
+		current_value += current_delta;
+		values[i] = current_value;
+	}
+
+	if (compressed->has_nulls == 1)
+	{
+		Simple8bRleSerialized *nulls_serialized = bytes_deserialize_simple8b_and_advance(&data);
+
+		n_rows = nulls_serialized->num_elements;
+		nulls = palloc(sizeof(uint64) * Max(n_rows, 1));
+		simple8brle_decompress_all_buf(nulls_serialized, nulls, n_rows);
+	}
+
+	return decompressed_column_build(element_type, values, n_values, nulls, n_rows);
+}
+
+#undef DELTA_DELTA_SUM_GROUP
+
 /**********************************************************************************/
 /**********************************************************************************/
 void
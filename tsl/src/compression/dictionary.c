@@ -344,15 +344,37 @@ dictionary_compressor_finish(DictionaryCompressor *compressor)
 /// Decompressor ///
 ////////////////////
 
+/*
+ * Decompress the distinct values of the dictionary, which are stored as an
+ * array after the index and null streams starting at `data`.
+ */
+static void
+dictionary_items_decompress(const DictionaryCompressed *compressed, const char *data,
+							Datum *values)
+{
+	Size remaining_size = VARSIZE(compressed) - (data - (const char *) compressed);
+	DecompressionIterator *dictionary_iterator =
+		array_decompression_iterator_alloc_forward(data,
+												   remaining_size,
+												   compressed->element_type,
+												   /* has_nulls */ false);
+
+	for (uint32 i = 0; i < compressed->num_distinct; i++)
+	{
+		DecompressResult res = array_decompression_iterator_try_next_forward(dictionary_iterator);
+		Assert(!res.is_null);
+		Assert(!res.is_done);
+		values[i] = res.val;
+	}
+	Assert(array_decompression_iterator_try_next_forward(dictionary_iterator).is_done);
+}
+
 static void
 dictionary_decompression_iterator_init(DictionaryDecompressionIterator *iter, const char *data,
 									   bool scan_forward, Oid element_type)
 {
 	const DictionaryCompressed *bitmap = (const DictionaryCompressed *) data;
-	Size total_size = VARSIZE(bitmap);
-	Size remaining_size;
 	Simple8bRleSerialized *s8_bitmap;
-	DecompressionIterator *dictionary_iterator;
 
 	*iter = (DictionaryDecompressionIterator){
 		.base = {
@@ -383,21 +405,7 @@ dictionary_decompression_iterator_init(DictionaryDecompressionIterator *iter, co
 			simple8brle_decompression_iterator_init_reverse(&iter->nulls, s8_null);
 	}
 
-	remaining_size = total_size - (data - (char *) bitmap);
-
-	dictionary_iterator = array_decompression_iterator_alloc_forward(data,
-																	 remaining_size,
-																	 bitmap->element_type,
-																	 /* has_nulls */ false);
-
-	for (uint32 i = 0; i < bitmap->num_distinct; i++)
-	{
-		DecompressResult res = array_decompression_iterator_try_next_forward(dictionary_iterator);
-		Assert(!res.is_null);
-		Assert(!res.is_done);
-		iter->values[i] = res.val;
-	}
-	Assert(array_decompression_iterator_try_next_forward(dictionary_iterator).is_done);
+	dictionary_items_decompress(bitmap, data, iter->values);
 }
 DecompressionIterator *
 tsl_dictionary_decompression_iterator_from_datum_forward(Datum dictionary_compressed,
@@ -423,6 +431,96 @@ tsl_dictionary_decompression_iterator_from_datum_reverse(Datum dictionary_compre
 	return &iterator->base;
 }
 
+/*
+ * Decompress only the distinct values of a dictionary compressed batch, so that
+ * a predicate can be evaluated once per value instead of once per row. The
+ * result has num_distinct entries in the order of the dictionary indexes.
+ */
+Datum *
+dictionary_decompress_items(const DictionaryCompressed *compressed, uint32 *num_distinct)
+{
+	const char *data = (const char *) compressed + sizeof(DictionaryCompressed);
+	Datum *values = palloc(sizeof(Datum) * Max(compressed->num_distinct, 1));
+
+	/* skip the index and null streams */
+	bytes_deserialize_simple8b_and_advance(&data);
+	if (compressed->has_nulls == 1)
+		bytes_deserialize_simple8b_and_advance(&data);
+
+	dictionary_items_decompress(compressed, data, values);
+
+	*num_distinct = compressed->num_distinct;
+	return values;
+}
+
+/*
+ * Clear the bits of the filter for the rows that are NULL or whose dictionary
+ * index doesn't match, according to item_matches that has an entry for every
+ * distinct value. The indexes are decompressed in bulk and the row values are
+ * never built.
+ */
+void
+dictionary_filter_rows(const DictionaryCompressed *compressed, const bool *item_matches,
+					   uint64 *restrict filter, int n_rows)
+{
+	const char *data = (const char *) compressed + sizeof(DictionaryCompressed);
+	Simple8bRleSerialized *indexes_serialized = bytes_deserialize_simple8b_and_advance(&data);
+	const uint32 n_indexes = indexes_serialized->num_elements;
+	uint64 *indexes = palloc(sizeof(uint64) * Max(n_indexes, 1));
+	uint64 *nulls = NULL;
+	uint32 n_total = n_indexes;
+	uint32 next_index = 0;
+
+	simple8brle_decompress_all_buf(indexes_serialized, indexes, n_indexes);
+
+	if (compressed->has_nulls == 1)
+	{
+		Simple8bRleSerialized *nulls_serialized = bytes_deserialize_simple8b_and_advance(&data);
+
+		n_total = nulls_serialized->num_elements;
+		nulls = palloc(sizeof(uint64) * Max(n_total, 1));
+		simple8brle_decompress_all_buf(nulls_serialized, nulls, n_total);
+	}
+
+	if (n_total != (uint32) n_rows)
+		elog(ERROR, "compressed column out of sync with batch counter");
+
+	for (uint32 i = 0; i < n_indexes; i++)
+	{
+		if (indexes[i] >= compressed->num_distinct)
+			elog(ERROR, "invalid dictionary index " UINT64_FORMAT, indexes[i]);
+	}
+
+	for (int word = 0; word < (n_rows + 63) / 64; word++)
+	{
+		const int start = word * 64;
+		const int end = Min(start + 64, n_rows);
+		uint64 word_result = 0;
+
+		if (nulls == NULL)
+		{
+			/* without nulls, the rows and the indexes are in lockstep */
+			for (int row = start; row < end; row++)
+				word_result |= ((uint64) item_matches[indexes[row]]) << (row - start);
+		}
+		else
+		{
+			for (int row = start; row < end; row++)
+			{
+				if (nulls[row] != 0)
+					continue;
+
+				if (next_index >= n_indexes)
+					elog(ERROR, "compressed column out of sync with batch counter");
+
+				word_result |= ((uint64) item_matches[indexes[next_index++]]) << (row - start);
+			}
+		}
+
+		filter[word] &= word_result;
+	}
+}
+
 DecompressResult
 dictionary_decompression_iterator_try_next_forward(DecompressionIterator *iter_base)
 {
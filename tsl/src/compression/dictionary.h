@@ -41,6 +41,11 @@ tsl_dictionary_decompression_iterator_from_datum_reverse(Datum dictionary_compre
 extern DecompressResult
 dictionary_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
 
+extern Datum *dictionary_decompress_items(const DictionaryCompressed *compressed,
+										  uint32 *num_distinct);
+extern void dictionary_filter_rows(const DictionaryCompressed *compressed, const bool *item_matches,
+								   uint64 *restrict filter, int n_rows);
+
 extern void dictionary_compressed_send(CompressedDataHeader *header, StringInfo buffer);
 extern Datum dictionary_compressed_recv(StringInfo buf);
 
@@ -169,6 +169,92 @@ gorilla_compressor_append_int64(Compressor *compressor, Datum val)
 	gorilla_compressor_append_value(extended->internal, DatumGetInt64(val));
 }
 
+static inline void gorilla_compressor_append_value_internal(GorillaCompressor *compressor,
+															uint64 val);
+
+/*
+ * Append a batch of values of the given type. This is inlined into the
+ * per-type functions below, so the conversion of the datums is resolved at
+ * compile time and the loop makes no indirect calls.
+ */
+static pg_attribute_always_inline void
+gorilla_compressor_append_datums(Compressor *compressor, const Datum *vals, const bool *nulls,
+								 int n, Oid element_type)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	GorillaCompressor *internal;
+
+	if (extended->internal == NULL)
+		extended->internal = gorilla_compressor_alloc();
+	internal = extended->internal;
+
+	for (int i = 0; i < n; i++)
+	{
+		uint64 value;
+
+		if (nulls[i])
+		{
+			gorilla_compressor_append_null(internal);
+			continue;
+		}
+
+		switch (element_type)
+		{
+			case FLOAT4OID:
+				value = float_get_bits(DatumGetFloat4(vals[i]));
+				break;
+			case FLOAT8OID:
+				value = double_get_bits(DatumGetFloat8(vals[i]));
+				break;
+			case INT2OID:
+				value = (uint16) DatumGetInt16(vals[i]);
+				break;
+			case INT4OID:
+				value = (uint32) DatumGetInt32(vals[i]);
+				break;
+			default:
+				value = DatumGetInt64(vals[i]);
+				break;
+		}
+		gorilla_compressor_append_value_internal(internal, value);
+	}
+}
+
+static void
+gorilla_compressor_append_floats(Compressor *compressor, const Datum *vals, const bool *nulls,
+								 int n)
+{
+	gorilla_compressor_append_datums(compressor, vals, nulls, n, FLOAT4OID);
+}
+
+static void
+gorilla_compressor_append_doubles(Compressor *compressor, const Datum *vals, const bool *nulls,
+								  int n)
+{
+	gorilla_compressor_append_datums(compressor, vals, nulls, n, FLOAT8OID);
+}
+
+static void
+gorilla_compressor_append_int16s(Compressor *compressor, const Datum *vals, const bool *nulls,
+								 int n)
+{
+	gorilla_compressor_append_datums(compressor, vals, nulls, n, INT2OID);
+}
+
+static void
+gorilla_compressor_append_int32s(Compressor *compressor, const Datum *vals, const bool *nulls,
+								 int n)
+{
+	gorilla_compressor_append_datums(compressor, vals, nulls, n, INT4OID);
+}
+
+static void
+gorilla_compressor_append_int64s(Compressor *compressor, const Datum *vals, const bool *nulls,
+								 int n)
+{
+	gorilla_compressor_append_datums(compressor, vals, nulls, n, INT8OID);
+}
+
 static void
 gorilla_compressor_append_null_value(Compressor *compressor)
 {
@@ -191,27 +277,32 @@ gorilla_compressor_finish_and_reset(Compressor *compressor)
 
 const Compressor gorilla_float_compressor = {
 	.append_val = gorilla_compressor_append_float,
+	.append_vals = gorilla_compressor_append_floats,
 	.append_null = gorilla_compressor_append_null_value,
 	.finish = gorilla_compressor_finish_and_reset,
 };
 
 const Compressor gorilla_double_compressor = {
 	.append_val = gorilla_compressor_append_double,
+	.append_vals = gorilla_compressor_append_doubles,
 	.append_null = gorilla_compressor_append_null_value,
 	.finish = gorilla_compressor_finish_and_reset,
 };
 const Compressor gorilla_uint16_compressor = {
 	.append_val = gorilla_compressor_append_int16,
+	.append_vals = gorilla_compressor_append_int16s,
 	.append_null = gorilla_compressor_append_null_value,
 	.finish = gorilla_compressor_finish_and_reset,
 };
 const Compressor gorilla_uint32_compressor = {
 	.append_val = gorilla_compressor_append_int32,
+	.append_vals = gorilla_compressor_append_int32s,
 	.append_null = gorilla_compressor_append_null_value,
 	.finish = gorilla_compressor_finish_and_reset,
 };
 const Compressor gorilla_uint64_compressor = {
 	.append_val = gorilla_compressor_append_int64,
+	.append_vals = gorilla_compressor_append_int64s,
 	.append_null = gorilla_compressor_append_null_value,
 	.finish = gorilla_compressor_finish_and_reset,
 };
@@ -302,6 +393,12 @@ gorilla_compressor_append_null(GorillaCompressor *compressor)
 
 void
 gorilla_compressor_append_value(GorillaCompressor *compressor, uint64 val)
+{
+	gorilla_compressor_append_value_internal(compressor, val);
+}
+
+static inline void
+gorilla_compressor_append_value_internal(GorillaCompressor *compressor, uint64 val)
 {
 	bool has_values;
 	uint64 xor = compressor->prev_val ^ val;
@@ -642,6 +739,105 @@ gorilla_decompression_iterator_try_next_forward(DecompressionIterator *iter_base
 								 iter_base->element_type);
 }
 
+/*
+ * Decompress the whole datum at once. The tag and bit-width streams are
+ * unpacked in bulk up front. The xors are then decoded only for the values
+ * that change, and the values are looked up by the running count of the
+ * changes, so the runs of repeated values don't touch the xor stream at all.
+ */
+DecompressedColumn *
+gorilla_decompress_all(Datum gorilla_compressed, Oid element_type)
+{
+	CompressedGorillaData gorilla_data;
+	BitArrayIterator leading_zeros_iter;
+	BitArrayIterator xors_iter;
+	uint64 *values;
+	uint64 *tag1s;
+	uint64 *bits_used;
+	uint64 *changed_values;
+	uint64 *nulls = NULL;
+	uint32 n_values;
+	uint32 n_tag1s;
+	uint32 n_bits_used;
+	uint32 n_changes = 0;
+	uint32 n_rows;
+	uint32 change = 0;
+	uint32 bits_used_index = 0;
+	uint64 prev_val = 0;
+	uint8 prev_leading_zeroes = 0;
+	uint8 prev_xor_bits_used = 0;
+
+	compressed_gorilla_data_init_from_datum(&gorilla_data, gorilla_compressed);
+
+	n_values = gorilla_data.tag0s->num_elements;
+	values = palloc(sizeof(uint64) * Max(n_values, 1));
+	simple8brle_decompress_all_buf(gorilla_data.tag0s, values, n_values);
+
+	n_tag1s = gorilla_data.tag1s->num_elements;
+	tag1s = palloc(sizeof(uint64) * Max(n_tag1s, 1));
+	simple8brle_decompress_all_buf(gorilla_data.tag1s, tag1s, n_tag1s);
+
+	n_bits_used = gorilla_data.num_bits_used_per_xor->num_elements;
+	bits_used = palloc(sizeof(uint64) * Max(n_bits_used, 1));
+	simple8brle_decompress_all_buf(gorilla_data.num_bits_used_per_xor, bits_used, n_bits_used);
+
+	bit_array_iterator_init(&leading_zeros_iter, &gorilla_data.leading_zeros);
+	bit_array_iterator_init(&xors_iter, &gorilla_data.xors);
+
+	/* a tag0 is set for each value that differs from the previous one */
+	for (uint32 i = 0; i < n_values; i++)
+		n_changes += values[i] != 0;
+
+	if (n_changes > n_tag1s)
+		elog(ERROR, "gorilla tag1 stream out of sync with tag0 stream");
+
+	/* changed_values[k] is the value after the k-th change */
+	changed_values = palloc(sizeof(uint64) * (n_changes + 1));
+	changed_values[0] = prev_val;
+	for (uint32 k = 0; k < n_changes; k++)
+	{
+		uint64 xor ;
+
+		if (tag1s[k] != 0)
+		{
+			if (bits_used_index >= n_bits_used)
+				elog(ERROR, "gorilla bit width stream out of sync with tag1 stream");
+
+			prev_leading_zeroes = bit_array_iter_next(&leading_zeros_iter, BITS_PER_LEADING_ZEROS);
+			prev_xor_bits_used = bits_used[bits_used_index++];
+		}
+
+		xor = bit_array_iter_next(&xors_iter, prev_xor_bits_used);
+		if (prev_leading_zeroes + prev_xor_bits_used < 64)
+			xor <<= 64 - (prev_leading_zeroes + prev_xor_bits_used);
+		prev_val ^= xor;
+		changed_values[k + 1] = prev_val;
+	}
+
+	/*
+	 * The tag0 array is reused in place for the decompressed values. There are
+	 * no branches here, so a run of repeated values costs a load and a store
+	 * per value.
+	 */
+	for (uint32 i = 0; i < n_values; i++)
+	{
+		change += values[i] != 0;
+		values[i] = changed_values[change];
+	}
+
+	pfree(changed_values);
+
+	n_rows = n_values;
+	if (gorilla_data.nulls != NULL)
+	{
+		n_rows = gorilla_data.nulls->num_elements;
+		nulls = palloc(sizeof(uint64) * Max(n_rows, 1));
+		simple8brle_decompress_all_buf(gorilla_data.nulls, nulls, n_rows);
+	}
+
+	return decompressed_column_build(element_type, values, n_values, nulls, n_rows);
+}
+
 /****************************************
  *** reversed  DecompressionIterator  ***
  ****************************************/
@@ -88,6 +88,8 @@ gorilla_decompression_iterator_from_datum_reverse(Datum gorilla_compressed, Oid
 extern DecompressResult
 gorilla_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
 
+extern DecompressedColumn *gorilla_decompress_all(Datum gorilla_compressed, Oid element_type);
+
 extern void gorilla_compressed_send(CompressedDataHeader *header, StringInfo buffer);
 extern Datum gorilla_compressed_recv(StringInfo buf);
 
@@ -102,6 +104,7 @@ extern Datum tsl_gorilla_compressor_finish(PG_FUNCTION_ARGS);
 		.compressed_data_recv = gorilla_compressed_recv,                                           \
 		.compressor_for_type = gorilla_compressor_for_type,                                        \
 		.compressed_data_storage = TOAST_STORAGE_EXTERNAL,                                         \
+		.decompress_all = gorilla_decompress_all,                                                  \
 	}
 
 #endif
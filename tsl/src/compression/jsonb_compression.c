@@ -0,0 +1,1051 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include "compression/jsonb_compression.h"
+
+#include <catalog/pg_type.h>
+#include <libpq/pqformat.h>
+#include <utils/builtins.h>
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
+#include <utils/numeric.h>
+
+#include "compat/compat.h"
+#if PG13_GE
+#include <common/hashfn.h>
+#else
+#include <utils/hashutils.h>
+#endif
+
+#include "compression/array.h"
+#include "compression/compression.h"
+#include "compression/deltadelta.h"
+#include "compression/dictionary.h"
+#include "compression/simple8b_rle.h"
+
+typedef enum JsonbEncoding
+{
+	JSONB_ENCODING_PLAIN = 0,
+	JSONB_ENCODING_KEYS = 1,
+	_JSONB_ENCODING_END,
+} JsonbEncoding;
+
+/*
+ * The kind of values of a key in a batch, which decides the type and the
+ * algorithm of its sub-column. The kinds widen as values of other kinds are
+ * seen: integers to numbers, and anything mixed to jsonb.
+ */
+typedef enum JsonbKeyType
+{
+	JSONB_KEY_INT8 = 0,
+	JSONB_KEY_NUMERIC = 1,
+	JSONB_KEY_TEXT = 2,
+	JSONB_KEY_JSONB = 3,
+	/* also the kind of a key whose values haven't been seen yet */
+	_JSONB_KEY_END,
+} JsonbKeyType;
+
+/*
+ * A batch with more distinct keys than this is stored plain, since the
+ * sub-columns would be mostly nulls.
+ */
+#define JSONB_MAX_KEYS 1000
+
+/*
+ * For the keys encoding, the data after the header holds the type of every
+ * key, then the names of the keys as null-terminated strings, then the
+ * sub-column of every key. For the plain encoding, it holds the values
+ * compressed with the array algorithm. The compressed sub-columns or values
+ * start at MAXALIGN'd offsets. The nulls bitmap follows if there are nulls.
+ */
+typedef struct JsonbCompressed
+{
+	CompressedDataHeaderFields;
+	uint8 encoding;
+	uint8 has_nulls; /* 1 if this has a NULLs bitmap at the end, 0 otherwise */
+	uint8 padding[1];
+	uint32 num_values;
+	/* the number of keys, 0 for the plain encoding */
+	uint32 num_keys;
+	char data[FLEXIBLE_ARRAY_MEMBER];
+} JsonbCompressed;
+
+static void
+pg_attribute_unused() assertions(void)
+{
+	JsonbCompressed test_val = { .vl_len_ = { 0 } };
+	/* make sure no padding bytes make it to disk */
+	StaticAssertStmt(sizeof(JsonbCompressed) ==
+						 sizeof(test_val.vl_len_) + sizeof(test_val.compression_algorithm) +
+							 sizeof(test_val.encoding) + sizeof(test_val.has_nulls) +
+							 sizeof(test_val.padding) + sizeof(test_val.num_values) +
+							 sizeof(test_val.num_keys),
+					 "JsonbCompressed wrong size");
+	StaticAssertStmt(sizeof(JsonbCompressed) == 16, "JsonbCompressed wrong size");
+}
+
+typedef struct JsonbDecompressionIterator
+{
+	DecompressionIterator base;
+	/* all the non-null values, decoded when the iterator is created */
+	Datum *values;
+	uint32 num_values;
+	/* the number of non-null values returned so far */
+	uint32 num_returned;
+	Simple8bRleDecompressionIterator nulls;
+	bool has_nulls;
+} JsonbDecompressionIterator;
+
+typedef struct JsonbCompressor
+{
+	/* the context of the copies of the values */
+	MemoryContext mcxt;
+	Jsonb **values;
+	uint32 num_values;
+	uint32 max_values;
+	Simple8bRleCompressor nulls;
+	bool has_nulls;
+} JsonbCompressor;
+
+typedef struct ExtendedCompressor
+{
+	Compressor base;
+	JsonbCompressor *internal;
+} ExtendedCompressor;
+
+/* A key of the batch, pointing into the values of the compressor */
+typedef struct JsonbKey
+{
+	const char *name;
+	int len;
+} JsonbKey;
+
+typedef struct JsonbKeyEntry
+{
+	JsonbKey key; /* the hash key */
+	uint32 index;
+} JsonbKeyEntry;
+
+typedef struct JsonbKeyColumn
+{
+	JsonbKey key;
+	JsonbKeyType type;
+	Compressor *compressor;
+	CompressedDataHeader *compressed;
+} JsonbKeyColumn;
+
+static const Oid jsonb_key_type_oids[_JSONB_KEY_END] = {
+	[JSONB_KEY_INT8] = INT8OID,
+	[JSONB_KEY_NUMERIC] = NUMERICOID,
+	[JSONB_KEY_TEXT] = TEXTOID,
+	[JSONB_KEY_JSONB] = JSONBOID,
+};
+
+static uint32
+jsonb_key_hash(const void *key, Size keysize)
+{
+	const JsonbKey *jkey = key;
+
+	return DatumGetUInt32(hash_any((const unsigned char *) jkey->name, jkey->len));
+}
+
+static int
+jsonb_key_match(const void *key1, const void *key2, Size keysize)
+{
+	const JsonbKey *jkey1 = key1;
+	const JsonbKey *jkey2 = key2;
+
+	if (jkey1->len != jkey2->len)
+		return 1;
+	return memcmp(jkey1->name, jkey2->name, jkey1->len);
+}
+
+/*
+ * The offset of the first compressed sub-column, or of the compressed values
+ * for the plain encoding, from the start of the compressed data.
+ */
+static Size
+jsonb_compressed_columns_offset(const JsonbCompressed *compressed)
+{
+	const char *names = compressed->data + compressed->num_keys;
+
+	for (uint32 i = 0; i < compressed->num_keys; i++)
+		names += strlen(names) + 1;
+
+	return MAXALIGN(names - (const char *) compressed);
+}
+
+static inline uint32
+jsonb_compressed_num_columns(const JsonbCompressed *compressed)
+{
+	return compressed->encoding == JSONB_ENCODING_KEYS ? compressed->num_keys : 1;
+}
+
+static const CompressedDataHeader *
+jsonb_compressed_get_column(const JsonbCompressed *compressed, uint32 index)
+{
+	const char *data = (const char *) compressed + jsonb_compressed_columns_offset(compressed);
+
+	Assert(index < jsonb_compressed_num_columns(compressed));
+	for (uint32 i = 0; i < index; i++)
+		data += MAXALIGN(VARSIZE(data));
+
+	return (const CompressedDataHeader *) data;
+}
+
+static Simple8bRleSerialized *
+jsonb_compressed_get_nulls(const JsonbCompressed *compressed)
+{
+	const uint32 num_columns = jsonb_compressed_num_columns(compressed);
+	const char *data;
+
+	Assert(compressed->has_nulls == 1);
+	if (num_columns == 0)
+		data = (const char *) compressed + jsonb_compressed_columns_offset(compressed);
+	else
+	{
+		data = (const char *) jsonb_compressed_get_column(compressed, num_columns - 1);
+		data += MAXALIGN(VARSIZE(data));
+	}
+
+	return bytes_deserialize_simple8b_and_advance(&data);
+}
+
+//////////////////
+/// Compressor ///
+//////////////////
+
+static void
+jsonb_compressor_append_jsonb(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = jsonb_compressor_alloc();
+
+	jsonb_compressor_append_value(extended->internal, val);
+}
+
+static void
+jsonb_compressor_append_null_value(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = jsonb_compressor_alloc();
+
+	jsonb_compressor_append_null(extended->internal);
+}
+
+static void *
+jsonb_compressor_finish_and_reset(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	void *compressed = jsonb_compressor_finish(extended->internal);
+
+	for (uint32 i = 0; i < extended->internal->num_values; i++)
+		pfree(extended->internal->values[i]);
+	pfree(extended->internal->values);
+	pfree(extended->internal);
+	extended->internal = NULL;
+	return compressed;
+}
+
+const Compressor jsonb_compressor = {
+	.append_val = jsonb_compressor_append_jsonb,
+	.append_null = jsonb_compressor_append_null_value,
+	.finish = jsonb_compressor_finish_and_reset,
+};
+
+Compressor *
+jsonb_compressor_for_type(Oid element_type)
+{
+	ExtendedCompressor *compressor;
+
+	if (element_type != JSONBOID)
+		elog(ERROR, "invalid type for jsonb compressor \"%s\"", format_type_be(element_type));
+
+	compressor = palloc(sizeof(*compressor));
+	*compressor = (ExtendedCompressor){ .base = jsonb_compressor };
+	return &compressor->base;
+}
+
+JsonbCompressor *
+jsonb_compressor_alloc(void)
+{
+	JsonbCompressor *compressor = palloc0(sizeof(*compressor));
+	compressor->mcxt = CurrentMemoryContext;
+	compressor->max_values = 64;
+	compressor->values = palloc(sizeof(Jsonb *) * compressor->max_values);
+	simple8brle_compressor_init(&compressor->nulls);
+	return compressor;
+}
+
+void
+jsonb_compressor_append_null(JsonbCompressor *compressor)
+{
+	compressor->has_nulls = true;
+	simple8brle_compressor_append(&compressor->nulls, 1);
+}
+
+void
+jsonb_compressor_append_value(JsonbCompressor *compressor, Datum value)
+{
+	MemoryContext old_mcxt = MemoryContextSwitchTo(compressor->mcxt);
+
+	if (compressor->num_values == compressor->max_values)
+	{
+		compressor->max_values *= 2;
+		compressor->values =
+			repalloc(compressor->values, sizeof(Jsonb *) * compressor->max_values);
+	}
+
+	/* the values are read twice when the batch is finished, so keep a copy */
+	compressor->values[compressor->num_values++] = DatumGetJsonbPCopy(value);
+	simple8brle_compressor_append(&compressor->nulls, 0);
+	MemoryContextSwitchTo(old_mcxt);
+}
+
+static Size
+jsonb_compressed_size(JsonbEncoding encoding, const JsonbKeyColumn *columns, uint32 num_columns,
+					  Simple8bRleSerialized *nulls)
+{
+	Size size = sizeof(JsonbCompressed);
+
+	if (encoding == JSONB_ENCODING_KEYS)
+	{
+		for (uint32 i = 0; i < num_columns; i++)
+			size += 1 + columns[i].key.len + 1;
+		size = MAXALIGN(size);
+	}
+
+	for (uint32 i = 0; i < num_columns; i++)
+		size += MAXALIGN(VARSIZE(columns[i].compressed));
+
+	if (nulls != NULL)
+		size += simple8brle_serialized_total_size(nulls);
+
+	return size;
+}
+
+/*
+ * Put the parts together. The plain encoding has a single column, with the
+ * values, and no key.
+ */
+static JsonbCompressed *
+jsonb_from_parts(JsonbEncoding encoding, uint32 num_values, const JsonbKeyColumn *columns,
+				 uint32 num_columns, Simple8bRleSerialized *nulls)
+{
+	const Size compressed_size = jsonb_compressed_size(encoding, columns, num_columns, nulls);
+	JsonbCompressed *compressed;
+	char *data;
+
+	if (!AllocSizeIsValid(compressed_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("compressed size exceeds the maximum allowed (%d)", (int) MaxAllocSize)));
+
+	compressed = palloc0(compressed_size);
+	SET_VARSIZE(&compressed->vl_len_, compressed_size);
+
+	compressed->compression_algorithm = COMPRESSION_ALGORITHM_JSONB;
+	compressed->encoding = encoding;
+	compressed->has_nulls = nulls != NULL ? 1 : 0;
+	compressed->num_values = num_values;
+	compressed->num_keys = encoding == JSONB_ENCODING_KEYS ? num_columns : 0;
+
+	data = compressed->data;
+	if (encoding == JSONB_ENCODING_KEYS)
+	{
+		for (uint32 i = 0; i < num_columns; i++)
+			*data++ = columns[i].type;
+
+		for (uint32 i = 0; i < num_columns; i++)
+		{
+			memcpy(data, columns[i].key.name, columns[i].key.len);
+			data += columns[i].key.len;
+			*data++ = '\0';
+		}
+	}
+	data = (char *) compressed + MAXALIGN(data - (char *) compressed);
+
+	for (uint32 i = 0; i < num_columns; i++)
+	{
+		memcpy(data, columns[i].compressed, VARSIZE(columns[i].compressed));
+		data += MAXALIGN(VARSIZE(columns[i].compressed));
+	}
+
+	if (compressed->has_nulls == 1)
+	{
+		Assert(nulls->num_elements > num_values);
+		bytes_serialize_simple8b_and_advance(data,
+											 simple8brle_serialized_total_size(nulls),
+											 nulls);
+	}
+
+	Assert(data <= (char *) compressed + compressed_size);
+	return compressed;
+}
+
+/* Whether the number has no fractional digits and fits into an int8 */
+static bool
+jsonb_numeric_is_int8(Numeric num, Datum min_int8, Datum max_int8)
+{
+	if (numeric_is_nan(num) ||
+		DatumGetInt32(DirectFunctionCall1(numeric_scale, NumericGetDatum(num))) != 0)
+		return false;
+
+	return DatumGetInt32(DirectFunctionCall2(numeric_cmp, NumericGetDatum(num), min_int8)) >= 0 &&
+		   DatumGetInt32(DirectFunctionCall2(numeric_cmp, NumericGetDatum(num), max_int8)) <= 0;
+}
+
+static JsonbKeyType
+jsonb_value_key_type(const JsonbValue *value, Datum min_int8, Datum max_int8)
+{
+	switch (value->type)
+	{
+		case jbvNumeric:
+			return jsonb_numeric_is_int8(value->val.numeric, min_int8, max_int8) ?
+					   JSONB_KEY_INT8 :
+					   JSONB_KEY_NUMERIC;
+		case jbvString:
+			return JSONB_KEY_TEXT;
+		default:
+			return JSONB_KEY_JSONB;
+	}
+}
+
+static JsonbKeyType
+jsonb_key_type_merge(JsonbKeyType type1, JsonbKeyType type2)
+{
+	if (type1 == type2)
+		return type1;
+
+	if ((type1 == JSONB_KEY_INT8 || type1 == JSONB_KEY_NUMERIC) &&
+		(type2 == JSONB_KEY_INT8 || type2 == JSONB_KEY_NUMERIC))
+		return JSONB_KEY_NUMERIC;
+
+	return JSONB_KEY_JSONB;
+}
+
+static Datum
+jsonb_value_to_key_datum(JsonbValue *value, JsonbKeyType type)
+{
+	switch (type)
+	{
+		case JSONB_KEY_INT8:
+			return DirectFunctionCall1(numeric_int8, NumericGetDatum(value->val.numeric));
+		case JSONB_KEY_NUMERIC:
+			return NumericGetDatum(value->val.numeric);
+		case JSONB_KEY_TEXT:
+			return PointerGetDatum(
+				cstring_to_text_with_len(value->val.string.val, value->val.string.len));
+		case JSONB_KEY_JSONB:
+			return JsonbPGetDatum(JsonbValueToJsonb(value));
+		default:
+			elog(ERROR, "invalid jsonb key type %d", type);
+	}
+
+	pg_unreachable();
+}
+
+static Compressor *
+jsonb_key_type_compressor(JsonbKeyType type)
+{
+	switch (type)
+	{
+		case JSONB_KEY_INT8:
+			return delta_delta_compressor_for_type(INT8OID);
+		case JSONB_KEY_TEXT:
+			return dictionary_compressor_for_type(TEXTOID);
+		case JSONB_KEY_NUMERIC:
+		case JSONB_KEY_JSONB:
+			return array_compressor_for_type(jsonb_key_type_oids[type]);
+		default:
+			elog(ERROR, "invalid jsonb key type %d", type);
+	}
+
+	pg_unreachable();
+}
+
+/*
+ * Collect the keys of the batch and the kind of values of every key. Returns
+ * NULL if a value is not an object or there are too many keys, where the keys
+ * encoding doesn't apply.
+ */
+static JsonbKeyColumn *
+jsonb_collect_keys(const JsonbCompressor *compressor, HTAB *keys, uint32 *num_keys)
+{
+	const Datum min_int8 = DirectFunctionCall1(int8_numeric, Int64GetDatum(PG_INT64_MIN));
+	const Datum max_int8 = DirectFunctionCall1(int8_numeric, Int64GetDatum(PG_INT64_MAX));
+	uint32 max_keys = 16;
+	JsonbKeyColumn *columns = palloc(sizeof(JsonbKeyColumn) * max_keys);
+
+	*num_keys = 0;
+
+	for (uint32 i = 0; i < compressor->num_values; i++)
+	{
+		Jsonb *jb = compressor->values[i];
+		JsonbIterator *it;
+		JsonbIteratorToken token;
+		JsonbValue value;
+		uint32 index = 0;
+
+		if (!JB_ROOT_IS_OBJECT(jb))
+			return NULL;
+
+		it = JsonbIteratorInit(&jb->root);
+		while ((token = JsonbIteratorNext(&it, &value, true)) != WJB_DONE)
+		{
+			if (token == WJB_KEY)
+			{
+				JsonbKey key = { .name = value.val.string.val, .len = value.val.string.len };
+				bool found;
+				JsonbKeyEntry *entry = hash_search(keys, &key, HASH_ENTER, &found);
+
+				if (!found)
+				{
+					if (*num_keys == JSONB_MAX_KEYS)
+						return NULL;
+
+					if (*num_keys == max_keys)
+					{
+						max_keys *= 2;
+						columns = repalloc(columns, sizeof(JsonbKeyColumn) * max_keys);
+					}
+
+					entry->index = (*num_keys)++;
+					columns[entry->index] = (JsonbKeyColumn){
+						.key = key,
+						.type = _JSONB_KEY_END,
+					};
+				}
+				index = entry->index;
+			}
+			else if (token == WJB_VALUE)
+			{
+				JsonbKeyType type = jsonb_value_key_type(&value, min_int8, max_int8);
+
+				if (columns[index].type == _JSONB_KEY_END)
+					columns[index].type = type;
+				else
+					columns[index].type = jsonb_key_type_merge(columns[index].type, type);
+			}
+		}
+	}
+
+	return columns;
+}
+
+/*
+ * Compress the values of every key into its sub-column. Returns NULL if the
+ * keys encoding doesn't apply to the batch.
+ */
+static JsonbCompressed *
+jsonb_compress_keys(const JsonbCompressor *compressor, Simple8bRleSerialized *nulls)
+{
+	HASHCTL hash_ctl = {
+		.keysize = sizeof(JsonbKey),
+		.entrysize = sizeof(JsonbKeyEntry),
+		.hash = jsonb_key_hash,
+		.match = jsonb_key_match,
+		.hcxt = CurrentMemoryContext,
+	};
+	HTAB *keys = hash_create("jsonb compression keys",
+							 64,
+							 &hash_ctl,
+							 HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+	MemoryContext row_mcxt;
+	JsonbCompressed *compressed;
+	JsonbKeyColumn *columns;
+	uint32 num_keys;
+	Datum *row_values;
+	bool *row_present;
+
+	columns = jsonb_collect_keys(compressor, keys, &num_keys);
+	if (columns == NULL)
+	{
+		hash_destroy(keys);
+		return NULL;
+	}
+
+	for (uint32 k = 0; k < num_keys; k++)
+		columns[k].compressor = jsonb_key_type_compressor(columns[k].type);
+
+	row_values = palloc(sizeof(Datum) * Max(num_keys, 1));
+	row_present = palloc(sizeof(bool) * Max(num_keys, 1));
+	row_mcxt = AllocSetContextCreate(CurrentMemoryContext,
+									 "jsonb compression row",
+									 ALLOCSET_DEFAULT_SIZES);
+
+	for (uint32 i = 0; i < compressor->num_values; i++)
+	{
+		MemoryContext old_mcxt = MemoryContextSwitchTo(row_mcxt);
+		JsonbIterator *it = JsonbIteratorInit(&compressor->values[i]->root);
+		JsonbIteratorToken token;
+		JsonbValue value;
+		uint32 index = 0;
+
+		memset(row_present, 0, sizeof(bool) * num_keys);
+		while ((token = JsonbIteratorNext(&it, &value, true)) != WJB_DONE)
+		{
+			if (token == WJB_KEY)
+			{
+				JsonbKey key = { .name = value.val.string.val, .len = value.val.string.len };
+				JsonbKeyEntry *entry = hash_search(keys, &key, HASH_FIND, NULL);
+
+				Assert(entry != NULL);
+				index = entry->index;
+			}
+			else if (token == WJB_VALUE)
+			{
+				row_values[index] = jsonb_value_to_key_datum(&value, columns[index].type);
+				row_present[index] = true;
+			}
+		}
+		MemoryContextSwitchTo(old_mcxt);
+
+		for (uint32 k = 0; k < num_keys; k++)
+		{
+			if (row_present[k])
+				columns[k].compressor->append_val(columns[k].compressor, row_values[k]);
+			else
+				columns[k].compressor->append_null(columns[k].compressor);
+		}
+		MemoryContextReset(row_mcxt);
+	}
+
+	MemoryContextDelete(row_mcxt);
+	hash_destroy(keys);
+
+	/* every key has a value in at least one row, so every sub-column has data */
+	for (uint32 k = 0; k < num_keys; k++)
+	{
+		columns[k].compressed = columns[k].compressor->finish(columns[k].compressor);
+		Assert(columns[k].compressed != NULL);
+	}
+
+	compressed =
+		jsonb_from_parts(JSONB_ENCODING_KEYS, compressor->num_values, columns, num_keys, nulls);
+
+	for (uint32 k = 0; k < num_keys; k++)
+	{
+		pfree(columns[k].compressed);
+		pfree(columns[k].compressor);
+	}
+	pfree(columns);
+	pfree(row_values);
+	pfree(row_present);
+	return compressed;
+}
+
+static JsonbCompressed *
+jsonb_compress_plain(const JsonbCompressor *compressor, Simple8bRleSerialized *nulls)
+{
+	JsonbKeyColumn column = { .compressor = array_compressor_for_type(JSONBOID) };
+	JsonbCompressed *compressed;
+
+	for (uint32 i = 0; i < compressor->num_values; i++)
+		column.compressor->append_val(column.compressor, JsonbPGetDatum(compressor->values[i]));
+
+	column.compressed = column.compressor->finish(column.compressor);
+	compressed = jsonb_from_parts(JSONB_ENCODING_PLAIN, compressor->num_values, &column, 1, nulls);
+	pfree(column.compressed);
+	pfree(column.compressor);
+	return compressed;
+}
+
+/*
+ * Encode the values in every applicable encoding and keep the smallest one.
+ * On a tie, the keys encoding wins, since it can decode a single key.
+ */
+JsonbCompressed *
+jsonb_compressor_finish(JsonbCompressor *compressor)
+{
+	Simple8bRleSerialized *nulls = simple8brle_compressor_finish(&compressor->nulls);
+	JsonbCompressed *plain;
+	JsonbCompressed *keys;
+
+	if (compressor->num_values == 0)
+		return NULL;
+
+	if (!compressor->has_nulls)
+		nulls = NULL;
+
+	plain = jsonb_compress_plain(compressor, nulls);
+	keys = jsonb_compress_keys(compressor, nulls);
+
+	if (keys == NULL)
+		return plain;
+
+	if (VARSIZE(keys) <= VARSIZE(plain))
+	{
+		pfree(plain);
+		return keys;
+	}
+
+	pfree(keys);
+	return plain;
+}
+
+////////////////////
+/// Decompressor ///
+////////////////////
+
+static DecompressionIterator *
+jsonb_column_iterator(const CompressedDataHeader *column, Oid element_type)
+{
+	if (column->compression_algorithm == COMPRESSION_ALGORITHM_JSONB)
+		elog(ERROR, "invalid compression algorithm in jsonb compressed data");
+
+	return tsl_get_decompression_iterator_init(column->compression_algorithm,
+											   false)(PointerGetDatum(column), element_type);
+}
+
+static void
+jsonb_key_datum_to_value(Datum datum, JsonbKeyType type, JsonbValue *value)
+{
+	switch (type)
+	{
+		case JSONB_KEY_INT8:
+			value->type = jbvNumeric;
+			value->val.numeric = DatumGetNumeric(DirectFunctionCall1(int8_numeric, datum));
+			break;
+		case JSONB_KEY_NUMERIC:
+			value->type = jbvNumeric;
+			value->val.numeric = DatumGetNumeric(datum);
+			break;
+		case JSONB_KEY_TEXT:
+		{
+			text *str = DatumGetTextPP(datum);
+
+			value->type = jbvString;
+			value->val.string.val = VARDATA_ANY(str);
+			value->val.string.len = VARSIZE_ANY_EXHDR(str);
+			break;
+		}
+		case JSONB_KEY_JSONB:
+		{
+			Jsonb *jb = DatumGetJsonbP(datum);
+
+			if (JB_ROOT_IS_SCALAR(jb))
+			{
+				JsonbExtractScalar(&jb->root, value);
+				break;
+			}
+
+			value->type = jbvBinary;
+			value->val.binary.data = &jb->root;
+			value->val.binary.len = VARSIZE(jb) - VARHDRSZ;
+			break;
+		}
+		default:
+			elog(ERROR, "invalid jsonb key type %d", type);
+	}
+}
+
+/*
+ * Decode the values of a batch in the keys encoding, building every object
+ * from the values of its keys in the sub-columns.
+ */
+static void
+jsonb_decode_keys(const JsonbCompressed *compressed, Datum *values)
+{
+	const uint32 num_keys = compressed->num_keys;
+	const uint8 *types = (const uint8 *) compressed->data;
+	const char *name = compressed->data + num_keys;
+	JsonbValue *names = palloc(sizeof(JsonbValue) * Max(num_keys, 1));
+	DecompressionIterator **iters = palloc(sizeof(DecompressionIterator *) * Max(num_keys, 1));
+
+	for (uint32 k = 0; k < num_keys; k++)
+	{
+		if (types[k] >= _JSONB_KEY_END)
+			elog(ERROR, "invalid jsonb key type %d", types[k]);
+
+		names[k] = (JsonbValue){
+			.type = jbvString,
+			.val.string = { .val = (char *) name, .len = strlen(name) },
+		};
+		name += names[k].val.string.len + 1;
+
+		iters[k] = jsonb_column_iterator(jsonb_compressed_get_column(compressed, k),
+										 jsonb_key_type_oids[types[k]]);
+	}
+
+	for (uint32 i = 0; i < compressed->num_values; i++)
+	{
+		JsonbParseState *state = NULL;
+		JsonbValue *object;
+
+		pushJsonbValue(&state, WJB_BEGIN_OBJECT, NULL);
+		for (uint32 k = 0; k < num_keys; k++)
+		{
+			DecompressResult result = iters[k]->try_next(iters[k]);
+			JsonbValue value;
+
+			if (result.is_done)
+				elog(ERROR, "invalid number of values in jsonb compressed data");
+			if (result.is_null)
+				continue;
+
+			jsonb_key_datum_to_value(result.val, types[k], &value);
+			pushJsonbValue(&state, WJB_KEY, &names[k]);
+			pushJsonbValue(&state, WJB_VALUE, &value);
+		}
+		object = pushJsonbValue(&state, WJB_END_OBJECT, NULL);
+		values[i] = JsonbPGetDatum(JsonbValueToJsonb(object));
+	}
+
+	pfree(names);
+	pfree(iters);
+}
+
+static void
+jsonb_decode_plain(const JsonbCompressed *compressed, Datum *values)
+{
+	DecompressionIterator *iter =
+		jsonb_column_iterator(jsonb_compressed_get_column(compressed, 0), JSONBOID);
+
+	for (uint32 i = 0; i < compressed->num_values; i++)
+	{
+		DecompressResult result = iter->try_next(iter);
+
+		if (result.is_done || result.is_null)
+			elog(ERROR, "invalid number of values in jsonb compressed data");
+		values[i] = result.val;
+	}
+}
+
+static void
+jsonb_decompression_iterator_init(JsonbDecompressionIterator *iter,
+								  const JsonbCompressed *compressed, bool scan_forward,
+								  Oid element_type)
+{
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	if (compressed->encoding >= _JSONB_ENCODING_END)
+		elog(ERROR, "invalid jsonb encoding %d", compressed->encoding);
+
+	*iter = (JsonbDecompressionIterator){
+		.base = {
+			.compression_algorithm = COMPRESSION_ALGORITHM_JSONB,
+			.forward = scan_forward,
+			.element_type = element_type,
+			.try_next = scan_forward ? jsonb_decompression_iterator_try_next_forward :
+									   jsonb_decompression_iterator_try_next_reverse,
+		},
+		.values = palloc(sizeof(Datum) * Max(compressed->num_values, 1)),
+		.num_values = compressed->num_values,
+		.num_returned = 0,
+		.has_nulls = compressed->has_nulls == 1,
+	};
+
+	if (compressed->encoding == JSONB_ENCODING_KEYS)
+		jsonb_decode_keys(compressed, iter->values);
+	else
+		jsonb_decode_plain(compressed, iter->values);
+
+	if (iter->has_nulls)
+	{
+		Simple8bRleSerialized *nulls = jsonb_compressed_get_nulls(compressed);
+		if (scan_forward)
+			simple8brle_decompression_iterator_init_forward(&iter->nulls, nulls);
+		else
+			simple8brle_decompression_iterator_init_reverse(&iter->nulls, nulls);
+	}
+}
+
+DecompressionIterator *
+jsonb_decompression_iterator_from_datum_forward(Datum compressed, Oid element_type)
+{
+	JsonbDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	jsonb_decompression_iterator_init(iterator,
+									  (void *) PG_DETOAST_DATUM(compressed),
+									  true,
+									  element_type);
+	return &iterator->base;
+}
+
+DecompressionIterator *
+jsonb_decompression_iterator_from_datum_reverse(Datum compressed, Oid element_type)
+{
+	JsonbDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	jsonb_decompression_iterator_init(iterator,
+									  (void *) PG_DETOAST_DATUM(compressed),
+									  false,
+									  element_type);
+	return &iterator->base;
+}
+
+static DecompressResult
+jsonb_decompression_iterator_try_next(JsonbDecompressionIterator *iter)
+{
+	uint32 index;
+
+	/* check for a null value */
+	if (iter->has_nulls)
+	{
+		Simple8bRleDecompressResult result =
+			iter->base.forward ? simple8brle_decompression_iterator_try_next_forward(&iter->nulls) :
+								 simple8brle_decompression_iterator_try_next_reverse(&iter->nulls);
+		if (result.is_done)
+			return (DecompressResult){
+				.is_done = true,
+			};
+
+		if (result.val != 0)
+		{
+			Assert(result.val == 1);
+			return (DecompressResult){
+				.is_null = true,
+			};
+		}
+	}
+
+	if (iter->num_returned >= iter->num_values)
+		return (DecompressResult){
+			.is_done = true,
+		};
+
+	index = iter->base.forward ? iter->num_returned : iter->num_values - 1 - iter->num_returned;
+	iter->num_returned++;
+
+	return (DecompressResult){
+		.val = iter->values[index],
+	};
+}
+
+DecompressResult
+jsonb_decompression_iterator_try_next_forward(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_JSONB && iter->forward);
+	return jsonb_decompression_iterator_try_next((JsonbDecompressionIterator *) iter);
+}
+
+DecompressResult
+jsonb_decompression_iterator_try_next_reverse(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_JSONB && !iter->forward);
+	return jsonb_decompression_iterator_try_next((JsonbDecompressionIterator *) iter);
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+/* The sub-columns are sent in the format of the compressed_data type */
+static void
+jsonb_column_send(StringInfo buffer, const CompressedDataHeader *column)
+{
+	bytea *data =
+		DatumGetByteaP(DirectFunctionCall1(tsl_compressed_data_send, PointerGetDatum(column)));
+
+	pq_sendint32(buffer, VARSIZE(data) - VARHDRSZ);
+	pq_sendbytes(buffer, VARDATA(data), VARSIZE(data) - VARHDRSZ);
+}
+
+static CompressedDataHeader *
+jsonb_column_recv(StringInfo buffer)
+{
+	StringInfoData column;
+	int len = pq_getmsgint(buffer, 4);
+
+	if (len < 0 || len > buffer->len - buffer->cursor)
+		elog(ERROR, "invalid recv in jsonb: bad column size");
+
+	column = (StringInfoData){
+		.data = (char *) pq_getmsgbytes(buffer, len),
+		.len = len,
+		.maxlen = len,
+		.cursor = 0,
+	};
+
+	return (CompressedDataHeader *) DatumGetPointer(
+		DirectFunctionCall1(tsl_compressed_data_recv, PointerGetDatum(&column)));
+}
+
+void
+jsonb_compressed_send(CompressedDataHeader *header, StringInfo buffer)
+{
+	const JsonbCompressed *data = (JsonbCompressed *) header;
+	const uint32 num_columns = jsonb_compressed_num_columns(data);
+	const char *name = data->data + data->num_keys;
+
+	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_JSONB);
+	pq_sendbyte(buffer, data->encoding);
+	pq_sendbyte(buffer, data->has_nulls);
+	pq_sendint32(buffer, data->num_values);
+	pq_sendint32(buffer, data->num_keys);
+	for (uint32 k = 0; k < data->num_keys; k++)
+	{
+		const int len = strlen(name);
+
+		pq_sendbyte(buffer, (uint8) data->data[k]);
+		pq_sendint32(buffer, len);
+		pq_sendbytes(buffer, name, len);
+		name += len + 1;
+	}
+	for (uint32 i = 0; i < num_columns; i++)
+		jsonb_column_send(buffer, jsonb_compressed_get_column(data, i));
+	if (data->has_nulls)
+		simple8brle_serialized_send(buffer, jsonb_compressed_get_nulls(data));
+}
+
+Datum
+jsonb_compressed_recv(StringInfo buffer)
+{
+	uint8 encoding;
+	uint8 has_nulls;
+	uint32 num_values;
+	uint32 num_keys;
+	uint32 num_columns;
+	JsonbKeyColumn *columns;
+	Simple8bRleSerialized *nulls = NULL;
+
+	encoding = pq_getmsgbyte(buffer);
+	if (encoding >= _JSONB_ENCODING_END)
+		elog(ERROR, "invalid recv in jsonb: bad encoding");
+
+	has_nulls = pq_getmsgbyte(buffer);
+	if (has_nulls != 0 && has_nulls != 1)
+		elog(ERROR, "invalid recv in jsonb: bad bool");
+
+	num_values = pq_getmsgint32(buffer);
+	num_keys = pq_getmsgint32(buffer);
+	if (encoding != JSONB_ENCODING_KEYS && num_keys != 0)
+		elog(ERROR, "invalid recv in jsonb: bad number of keys");
+	if (num_keys > JSONB_MAX_KEYS)
+		elog(ERROR, "invalid recv in jsonb: bad number of keys");
+
+	num_columns = encoding == JSONB_ENCODING_KEYS ? num_keys : 1;
+	columns = palloc0(sizeof(JsonbKeyColumn) * Max(num_columns, 1));
+
+	for (uint32 k = 0; k < num_keys; k++)
+	{
+		int len;
+
+		columns[k].type = pq_getmsgbyte(buffer);
+		if (columns[k].type >= _JSONB_KEY_END)
+			elog(ERROR, "invalid recv in jsonb: bad key type");
+
+		len = pq_getmsgint(buffer, 4);
+		if (len < 0 || len > buffer->len - buffer->cursor)
+			elog(ERROR, "invalid recv in jsonb: bad key length");
+		columns[k].key.name = pq_getmsgbytes(buffer, len);
+		columns[k].key.len = len;
+		if (memchr(columns[k].key.name, '\0', len) != NULL)
+			elog(ERROR, "invalid recv in jsonb: bad key");
+	}
+
+	for (uint32 i = 0; i < num_columns; i++)
+	{
+		columns[i].compressed = jsonb_column_recv(buffer);
+		if (columns[i].compressed->compression_algorithm == COMPRESSION_ALGORITHM_JSONB)
+			elog(ERROR, "invalid recv in jsonb: bad column algorithm");
+	}
+
+	if (has_nulls)
+		nulls = simple8brle_serialized_recv(buffer);
+
+	PG_RETURN_POINTER(jsonb_from_parts(encoding, num_values, columns, num_columns, nulls));
+}
@@ -0,0 +1,63 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+/*
+ * The jsonb algorithm stores the JSONB values of a batch in whichever of the
+ * following encodings is the smallest for the batch:
+ *
+ * - plain: the values compressed with the array algorithm.
+ * - keys: for batches of only objects, the dictionary of the top-level keys
+ *   of the batch, followed by one sub-column per key with the value of the
+ *   key in every row, or a null where the row doesn't have the key. The
+ *   sub-columns are compressed with the existing algorithms, by the kind of
+ *   values the key has in the batch: deltadelta for integers, array for other
+ *   numbers, dictionary for strings and array for the rest as jsonb. Every
+ *   sub-column is a complete compressed datum, so a single key can be decoded
+ *   without the others.
+ *
+ * The nulls are stored as a simple8b_rle bitmap like in deltadelta.
+ */
+#ifndef TIMESCALEDB_TSL_COMPRESSION_JSONB_COMPRESSION_H
+#define TIMESCALEDB_TSL_COMPRESSION_JSONB_COMPRESSION_H
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+#include <utils/jsonb.h>
+
+#include "compression/compression.h"
+
+typedef struct JsonbCompressor JsonbCompressor;
+typedef struct JsonbCompressed JsonbCompressed;
+typedef struct JsonbDecompressionIterator JsonbDecompressionIterator;
+
+extern Compressor *jsonb_compressor_for_type(Oid element_type);
+extern JsonbCompressor *jsonb_compressor_alloc(void);
+extern void jsonb_compressor_append_null(JsonbCompressor *compressor);
+extern void jsonb_compressor_append_value(JsonbCompressor *compressor, Datum value);
+extern JsonbCompressed *jsonb_compressor_finish(JsonbCompressor *compressor);
+
+extern DecompressionIterator *jsonb_decompression_iterator_from_datum_forward(Datum compressed,
+																			  Oid element_type);
+extern DecompressionIterator *jsonb_decompression_iterator_from_datum_reverse(Datum compressed,
+																			  Oid element_type);
+extern DecompressResult jsonb_decompression_iterator_try_next_forward(DecompressionIterator *iter);
+extern DecompressResult jsonb_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
+
+extern void jsonb_compressed_send(CompressedDataHeader *header, StringInfo buffer);
+extern Datum jsonb_compressed_recv(StringInfo buf);
+
+#define JSONB_ALGORITHM_DEFINITION                                                                 \
+	{                                                                                              \
+		.iterator_init_forward = jsonb_decompression_iterator_from_datum_forward,                  \
+		.iterator_init_reverse = jsonb_decompression_iterator_from_datum_reverse,                  \
+		.compressed_data_send = jsonb_compressed_send,                                             \
+		.compressed_data_recv = jsonb_compressed_recv,                                             \
+		.compressor_for_type = jsonb_compressor_for_type,                                          \
+		.compressed_data_storage = TOAST_STORAGE_EXTENDED,                                         \
+		.decompress_all = NULL,                                                                    \
+	}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <commands/vacuum.h>
+#include <utils/attoptcache.h>
+#include <utils/memutils.h>
+#include <utils/sampling.h>
+
+#include "compression/sample_stats.h"
+#include "import/analyze.h"
+
+struct SampleStats
+{
+	MemoryContext mcxt;
+	/* the analyzable columns of the relation */
+	VacAttrStats **attrs;
+	int n_attrs;
+	/* the reservoir of sampled rows, the largest minrows of the columns */
+	HeapTuple *rows;
+	int targrows;
+	int numrows;
+	/* the number of rows added so far */
+	double rows_seen;
+};
+
+/*
+ * Set up the sample for the columns of the relation that ANALYZE would
+ * process. Returns NULL if there are none.
+ */
+SampleStats *
+sample_stats_create(Relation rel)
+{
+	TupleDesc desc = RelationGetDescr(rel);
+	MemoryContext mcxt = AllocSetContextCreate(CurrentMemoryContext,
+											   "compression sample stats",
+											   ALLOCSET_DEFAULT_SIZES);
+	MemoryContext old_ctx = MemoryContextSwitchTo(mcxt);
+	SampleStats *sample = palloc0(sizeof(*sample));
+
+	sample->mcxt = mcxt;
+	sample->attrs = palloc(sizeof(*sample->attrs) * desc->natts);
+	for (int attnum = 1; attnum <= desc->natts; attnum++)
+	{
+		VacAttrStats *stats = ts_examine_attribute(rel, attnum, mcxt);
+
+		if (stats == NULL)
+			continue;
+
+		sample->attrs[sample->n_attrs++] = stats;
+		sample->targrows = Max(sample->targrows, stats->minrows);
+	}
+	MemoryContextSwitchTo(old_ctx);
+
+	if (sample->n_attrs == 0)
+	{
+		MemoryContextDelete(mcxt);
+		return NULL;
+	}
+
+	sample->rows = MemoryContextAlloc(mcxt, sizeof(HeapTuple) * sample->targrows);
+	return sample;
+}
+
+/*
+ * Add a row to the reservoir. The first targrows rows fill it, after that
+ * the n-th row replaces a random one with the probability targrows/n, so that
+ * every row is in the sample with the same probability (Algorithm R).
+ */
+void
+sample_stats_add(SampleStats *sample, TupleTableSlot *slot)
+{
+	MemoryContext old_ctx;
+	int k;
+
+	if (sample->numrows < sample->targrows)
+		k = sample->numrows++;
+	else
+	{
+		k = (int) ((sample->rows_seen + 1) * anl_random_fract());
+		if (k >= sample->targrows)
+		{
+			sample->rows_seen += 1;
+			return;
+		}
+		heap_freetuple(sample->rows[k]);
+	}
+
+	old_ctx = MemoryContextSwitchTo(sample->mcxt);
+	sample->rows[k] = ExecCopySlotHeapTuple(slot);
+	MemoryContextSwitchTo(old_ctx);
+	sample->rows_seen += 1;
+}
+
+/* Forget the rows added so far, when the input is read again */
+void
+sample_stats_reset(SampleStats *sample)
+{
+	for (int i = 0; i < sample->numrows; i++)
+		heap_freetuple(sample->rows[i]);
+
+	sample->numrows = 0;
+	sample->rows_seen = 0;
+}
+
+/*
+ * Compute the statistics of the columns from the sample, and store them in
+ * pg_statistic like ANALYZE does. The sampled rows can point to the TOAST
+ * table of the relation, so this must be done before it is truncated.
+ */
+void
+sample_stats_store(SampleStats *sample, Relation rel)
+{
+	MemoryContext col_context;
+	MemoryContext old_ctx;
+
+	if (sample->numrows == 0)
+		return;
+
+	col_context = AllocSetContextCreate(sample->mcxt,
+										"compression sample stats column",
+										ALLOCSET_DEFAULT_SIZES);
+	old_ctx = MemoryContextSwitchTo(col_context);
+	for (int i = 0; i < sample->n_attrs; i++)
+	{
+		VacAttrStats *stats = sample->attrs[i];
+		AttributeOpts *aopt;
+
+		stats->rows = sample->rows;
+		stats->tupDesc = RelationGetDescr(rel);
+		stats->compute_stats(stats, ts_std_fetch_func, sample->numrows, sample->rows_seen);
+
+		/* the n_distinct option overrides the estimate, as in ANALYZE */
+		aopt = get_attribute_options(RelationGetRelid(rel), stats->attr->attnum);
+		if (aopt != NULL && aopt->n_distinct != 0.0)
+			stats->stadistinct = aopt->n_distinct;
+
+		MemoryContextReset(col_context);
+	}
+	MemoryContextSwitchTo(old_ctx);
+
+	ts_update_attstats(RelationGetRelid(rel), false, sample->n_attrs, sample->attrs);
+}
+
+void
+sample_stats_free(SampleStats *sample)
+{
+	MemoryContextDelete(sample->mcxt);
+}
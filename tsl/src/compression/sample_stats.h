@@ -0,0 +1,26 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_TSL_COMPRESSION_SAMPLE_STATS_H
+#define TIMESCALEDB_TSL_COMPRESSION_SAMPLE_STATS_H
+
+#include <postgres.h>
+#include <executor/tuptable.h>
+#include <utils/rel.h>
+
+/*
+ * A random sample of the rows of a chunk, taken while the rows go through the
+ * compression, to build the column statistics of the chunk the same way
+ * ANALYZE does without reading the chunk again.
+ */
+typedef struct SampleStats SampleStats;
+
+extern SampleStats *sample_stats_create(Relation rel);
+extern void sample_stats_add(SampleStats *sample, TupleTableSlot *slot);
+extern void sample_stats_reset(SampleStats *sample);
+extern void sample_stats_store(SampleStats *sample, Relation rel);
+extern void sample_stats_free(SampleStats *sample);
+
+#endif
@@ -18,7 +18,7 @@ typedef struct SegmentMetaMinMaxBuilder
 {
 	Oid type_oid;
 	bool empty;
-	bool has_null;
+	int32 null_count;
 
 	SortSupportData ssup;
 	bool type_by_val;
@@ -42,7 +42,7 @@ segment_meta_min_max_builder_create(Oid type_oid, Oid collation)
 	*builder = (SegmentMetaMinMaxBuilder){
 		.type_oid = type_oid,
 		.empty = true,
-		.has_null = false,
+		.null_count = 0,
 		.type_by_val = type->typbyval,
 		.type_len = type->typlen,
 	};
@@ -89,7 +89,7 @@ segment_meta_min_max_builder_update_val(SegmentMetaMinMaxBuilder *builder, Datum
 void
 segment_meta_min_max_builder_update_null(SegmentMetaMinMaxBuilder *builder)
 {
-	builder->has_null = true;
+	builder->null_count++;
 }
 
 void
@@ -106,7 +106,7 @@ segment_meta_min_max_builder_reset(SegmentMetaMinMaxBuilder *builder)
 		builder->max = 0;
 	}
 	builder->empty = true;
-	builder->has_null = false;
+	builder->null_count = 0;
 }
 
 Datum
@@ -144,3 +144,187 @@ segment_meta_min_max_builder_empty(SegmentMetaMinMaxBuilder *builder)
 {
 	return builder->empty;
 }
+
+int32
+segment_meta_min_max_builder_null_count(SegmentMetaMinMaxBuilder *builder)
+{
+	return builder->null_count;
+}
+
+/*
+ * The bloom filter of a compressed batch. The filter is stored as a bytea, its
+ * size in bits is a power of two chosen from the number of distinct values in
+ * the batch. The bit positions are derived from the 64-bit extended hash of the
+ * value with double hashing, using the type's default hash opclass, so that the
+ * values that are equal according to the hash opfamily map to the same bits.
+ */
+#define BLOOM1_HASHES 6
+#define BLOOM1_BITS_PER_VALUE 8
+#define BLOOM1_MIN_BITS 64
+
+typedef struct SegmentMetaBloomBuilder
+{
+	FmgrInfo *hash_proc;
+	Oid collation;
+	int num_hashes;
+	int max_hashes;
+	uint64 *hashes;
+} SegmentMetaBloomBuilder;
+
+static FmgrInfo *
+bloom1_get_hash_proc(Oid type_oid)
+{
+	TypeCacheEntry *type = lookup_type_cache(type_oid, TYPECACHE_HASH_EXTENDED_PROC_FINFO);
+
+	if (!OidIsValid(type->hash_extended_proc))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),
+				 errmsg("could not identify an extended hash function for type %s",
+						format_type_be(type_oid))));
+
+	return &type->hash_extended_proc_finfo;
+}
+
+static inline uint64
+bloom1_hash(FmgrInfo *hash_proc, Oid collation, Datum val)
+{
+	return DatumGetUInt64(FunctionCall2Coll(hash_proc, collation, val, Int64GetDatum(0)));
+}
+
+static inline uint32
+bloom1_bit(uint64 hash, int i, uint32 nbits)
+{
+	uint32 h1 = (uint32) hash;
+	uint32 h2 = ((uint32) (hash >> 32)) | 1;
+
+	return (h1 + i * h2) & (nbits - 1);
+}
+
+SegmentMetaBloomBuilder *
+segment_meta_bloom_builder_create(Oid type_oid, Oid collation)
+{
+	SegmentMetaBloomBuilder *builder = palloc(sizeof(*builder));
+
+	*builder = (SegmentMetaBloomBuilder){
+		.hash_proc = bloom1_get_hash_proc(type_oid),
+		.collation = collation,
+		.num_hashes = 0,
+		.max_hashes = 64,
+	};
+	builder->hashes = palloc(sizeof(uint64) * builder->max_hashes);
+
+	return builder;
+}
+
+void
+segment_meta_bloom_builder_update_val(SegmentMetaBloomBuilder *builder, Datum val)
+{
+	if (builder->num_hashes == builder->max_hashes)
+	{
+		builder->max_hashes *= 2;
+		builder->hashes = repalloc(builder->hashes, sizeof(uint64) * builder->max_hashes);
+	}
+
+	builder->hashes[builder->num_hashes++] =
+		bloom1_hash(builder->hash_proc, builder->collation, val);
+}
+
+bool
+segment_meta_bloom_builder_empty(SegmentMetaBloomBuilder *builder)
+{
+	return builder->num_hashes == 0;
+}
+
+void
+segment_meta_bloom_builder_reset(SegmentMetaBloomBuilder *builder)
+{
+	builder->num_hashes = 0;
+}
+
+static int
+uint64_cmp(const void *a, const void *b)
+{
+	uint64 x = *(const uint64 *) a;
+	uint64 y = *(const uint64 *) b;
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+Datum
+segment_meta_bloom_builder_finish(SegmentMetaBloomBuilder *builder)
+{
+	int num_distinct = 0;
+	uint32 nbits = BLOOM1_MIN_BITS;
+	bytea *bloom;
+	uint8 *bits;
+
+	if (builder->num_hashes == 0)
+		elog(ERROR, "trying to get bloom filter from an empty builder");
+
+	/* size the filter by the number of distinct values */
+	qsort(builder->hashes, builder->num_hashes, sizeof(uint64), uint64_cmp);
+	for (int i = 0; i < builder->num_hashes; i++)
+	{
+		if (i == 0 || builder->hashes[i] != builder->hashes[num_distinct - 1])
+			builder->hashes[num_distinct++] = builder->hashes[i];
+	}
+
+	while (nbits < (uint32) num_distinct * BLOOM1_BITS_PER_VALUE)
+		nbits *= 2;
+	bloom = palloc0(VARHDRSZ + nbits / 8);
+	SET_VARSIZE(bloom, VARHDRSZ + nbits / 8);
+	bits = (uint8 *) VARDATA(bloom);
+
+	for (int i = 0; i < num_distinct; i++)
+	{
+		for (int j = 0; j < BLOOM1_HASHES; j++)
+		{
+			uint32 bit = bloom1_bit(builder->hashes[i], j, nbits);
+			bits[bit / 8] |= 1 << (bit % 8);
+		}
+	}
+
+	return PointerGetDatum(bloom);
+}
+
+/*
+ * _timescaledb_internal.bloom1_contains(bloom bytea, value anyelement)
+ *
+ * Returns false if the batch with this bloom filter cannot contain the value.
+ */
+Datum
+tsl_bloom1_contains(PG_FUNCTION_ARGS)
+{
+	bytea *bloom = PG_GETARG_BYTEA_PP(0);
+	Datum val = PG_GETARG_DATUM(1);
+	FmgrInfo *hash_proc = fcinfo->flinfo->fn_extra;
+	uint32 nbits = VARSIZE_ANY_EXHDR(bloom) * 8;
+	const uint8 *bits = (const uint8 *) VARDATA_ANY(bloom);
+	uint64 hash;
+
+	if (hash_proc == NULL)
+	{
+		Oid type_oid = get_fn_expr_argtype(fcinfo->flinfo, 1);
+
+		if (!OidIsValid(type_oid))
+			elog(ERROR, "could not determine the type of the bloom filter value");
+
+		/* the type cache entries are never freed, so we can keep the pointer */
+		hash_proc = bloom1_get_hash_proc(type_oid);
+		fcinfo->flinfo->fn_extra = hash_proc;
+	}
+
+	/* not a valid bloom filter, so it can contain anything */
+	if (nbits == 0 || (nbits & (nbits - 1)) != 0)
+		PG_RETURN_BOOL(true);
+
+	hash = bloom1_hash(hash_proc, PG_GET_COLLATION(), val);
+	for (int j = 0; j < BLOOM1_HASHES; j++)
+	{
+		uint32 bit = bloom1_bit(hash, j, nbits);
+		if ((bits[bit / 8] & (1 << (bit % 8))) == 0)
+			PG_RETURN_BOOL(false);
+	}
+
+	PG_RETURN_BOOL(true);
+}
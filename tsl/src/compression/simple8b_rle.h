@@ -158,6 +158,10 @@ static inline size_t simple8brle_serialized_slot_size(const Simple8bRleSerialize
 static inline size_t simple8brle_serialized_total_size(const Simple8bRleSerialized *data);
 static inline size_t simple8brle_compressor_compressed_size(Simple8bRleCompressor *compressor);
 
+/* Decode all elements at once into a caller-provided buffer of at least num_elements values */
+static inline uint32 simple8brle_decompress_all_buf(const Simple8bRleSerialized *compressed,
+													 uint64 *restrict out, uint32 n_out);
+
 /*********************
  ***  Private API  ***
  *********************/
@@ -677,6 +681,105 @@ simple8brle_decompression_iterator_try_next_reverse(Simple8bRleDecompressionIter
 	};
 }
 
+/*
+ * Unpack a full block for one of the bit-packing selectors. The bit width and
+ * the number of values are compile-time constants here, so the compiler can
+ * unroll the loop and vectorize it with whatever SIMD instructions the build
+ * targets, without any CPU-specific code on our side.
+ */
+#define SIMPLE8B_UNPACK_FULL_BLOCK(SELECTOR, BITS, NUM_VALUES)                                     \
+	case SELECTOR:                                                                                 \
+		for (uint32 i = 0; i < (NUM_VALUES); i++)                                                  \
+			out[decoded + i] = (block_data >> ((BITS) * i)) & (~0ULL >> (64 - (BITS)));            \
+		n_block_values = (NUM_VALUES);                                                             \
+		break
+
+/*
+ * Decompress all the elements of a simple8b stream in one pass. Unlike the
+ * iterator, this walks the selectors directly and unpacks a whole block per
+ * step, so there is no per-element function call or branching on the block
+ * state. Returns the number of elements written to `out`.
+ */
+static inline uint32
+simple8brle_decompress_all_buf(const Simple8bRleSerialized *compressed, uint64 *restrict out,
+							   uint32 n_out)
+{
+	const uint32 num_elements = compressed->num_elements;
+	const uint32 num_blocks = compressed->num_blocks;
+	const uint32 num_selector_slots = simple8brle_num_selector_slots_for_num_blocks(num_blocks);
+	const uint64 *restrict selectors = compressed->slots;
+	const uint64 *restrict blocks = compressed->slots + num_selector_slots;
+	uint32 decoded = 0;
+
+	if (num_elements > n_out)
+		elog(ERROR, "simple8brle output buffer too small");
+
+	for (uint32 block_index = 0; block_index < num_blocks && decoded < num_elements; block_index++)
+	{
+		const uint8 selector =
+			(selectors[block_index / SIMPLE8B_SELECTORS_PER_SELECTOR_SLOT] >>
+			 ((block_index % SIMPLE8B_SELECTORS_PER_SELECTOR_SLOT) * SIMPLE8B_BITS_PER_SELECTOR)) &
+			((1 << SIMPLE8B_BITS_PER_SELECTOR) - 1);
+		const uint64 block_data = blocks[block_index];
+		uint32 n_block_values;
+
+		if (selector == 0)
+			elog(ERROR, "invalid selector 0");
+
+		if (simple8brle_selector_is_rle(selector))
+		{
+			const uint64 repeated_value = simple8brle_rledata_value(block_data);
+
+			n_block_values =
+				Min(simple8brle_rledata_repeatcount(block_data), num_elements - decoded);
+			for (uint32 i = 0; i < n_block_values; i++)
+				out[decoded + i] = repeated_value;
+		}
+		else if (num_elements - decoded >= SIMPLE8B_NUM_ELEMENTS[selector])
+		{
+			switch (selector)
+			{
+				SIMPLE8B_UNPACK_FULL_BLOCK(1, 1, 64);
+				SIMPLE8B_UNPACK_FULL_BLOCK(2, 2, 32);
+				SIMPLE8B_UNPACK_FULL_BLOCK(3, 3, 21);
+				SIMPLE8B_UNPACK_FULL_BLOCK(4, 4, 16);
+				SIMPLE8B_UNPACK_FULL_BLOCK(5, 5, 12);
+				SIMPLE8B_UNPACK_FULL_BLOCK(6, 6, 10);
+				SIMPLE8B_UNPACK_FULL_BLOCK(7, 7, 9);
+				SIMPLE8B_UNPACK_FULL_BLOCK(8, 8, 8);
+				SIMPLE8B_UNPACK_FULL_BLOCK(9, 10, 6);
+				SIMPLE8B_UNPACK_FULL_BLOCK(10, 12, 5);
+				SIMPLE8B_UNPACK_FULL_BLOCK(11, 16, 4);
+				SIMPLE8B_UNPACK_FULL_BLOCK(12, 21, 3);
+				SIMPLE8B_UNPACK_FULL_BLOCK(13, 32, 2);
+				SIMPLE8B_UNPACK_FULL_BLOCK(14, 64, 1);
+				default:
+					elog(ERROR, "invalid selector %d", selector);
+					pg_unreachable();
+			}
+		}
+		else
+		{
+			/* the last block can be only partially used */
+			const uint32 bits_per_val = SIMPLE8B_BIT_LENGTH[selector];
+			const uint64 mask = simple8brle_selector_get_bitmask(selector);
+
+			n_block_values = num_elements - decoded;
+			for (uint32 i = 0; i < n_block_values; i++)
+				out[decoded + i] = (block_data >> (bits_per_val * i)) & mask;
+		}
+
+		decoded += n_block_values;
+	}
+
+	if (decoded != num_elements)
+		elog(ERROR, "simple8brle stream is shorter than its element count");
+
+	return decoded;
+}
+
+#undef SIMPLE8B_UNPACK_FULL_BLOCK
+
 /********************************************
  ***  Simple8bRlePartiallyCompressedData  ***
  ********************************************/
@@ -0,0 +1,712 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include "compression/uuid_compression.h"
+
+#include <catalog/pg_type.h>
+#include <libpq/pqformat.h>
+#include <port/pg_bswap.h>
+#include <utils/builtins.h>
+#include <utils/hsearch.h>
+
+#include "compression/compression.h"
+#include "compression/simple8b_rle.h"
+
+typedef enum UuidEncoding
+{
+	UUID_ENCODING_PLAIN = 0,
+	UUID_ENCODING_DICTIONARY = 1,
+	UUID_ENCODING_TIME_V7 = 2,
+	UUID_ENCODING_TIME_V1 = 3,
+	_UUID_ENCODING_END,
+} UuidEncoding;
+
+/*
+ * The fixed-size part after the header holds the 16-byte values for the plain
+ * encoding, the distinct values for the dictionary one, and the last 8 bytes
+ * of every value for the time ones. The dictionary indexes or the time deltas
+ * follow as simple8b_rle, then the nulls bitmap if there are nulls.
+ */
+typedef struct UuidCompressed
+{
+	CompressedDataHeaderFields;
+	uint8 encoding;
+	uint8 has_nulls; /* 1 if this has a NULLs bitmap at the end, 0 otherwise */
+	uint8 padding[1];
+	uint32 num_values;
+	/* the number of dictionary entries, 0 for the other encodings */
+	uint32 num_distinct;
+	uint64 data[FLEXIBLE_ARRAY_MEMBER];
+} UuidCompressed;
+
+static void
+pg_attribute_unused() assertions(void)
+{
+	UuidCompressed test_val = { .vl_len_ = { 0 } };
+	/* make sure no padding bytes make it to disk */
+	StaticAssertStmt(sizeof(UuidCompressed) ==
+						 sizeof(test_val.vl_len_) + sizeof(test_val.compression_algorithm) +
+							 sizeof(test_val.encoding) + sizeof(test_val.has_nulls) +
+							 sizeof(test_val.padding) + sizeof(test_val.num_values) +
+							 sizeof(test_val.num_distinct),
+					 "UuidCompressed wrong size");
+	StaticAssertStmt(sizeof(UuidCompressed) == 16, "UuidCompressed wrong size");
+	StaticAssertStmt(sizeof(pg_uuid_t) == UUID_LEN, "pg_uuid_t wrong size");
+}
+
+typedef struct UuidDecompressionIterator
+{
+	DecompressionIterator base;
+	/* all the non-null values, decoded when the iterator is created */
+	pg_uuid_t *values;
+	uint32 num_values;
+	/* the number of non-null values returned so far */
+	uint32 num_returned;
+	Simple8bRleDecompressionIterator nulls;
+	bool has_nulls;
+} UuidDecompressionIterator;
+
+typedef struct UuidCompressor
+{
+	pg_uuid_t *values;
+	uint32 num_values;
+	uint32 max_values;
+	Simple8bRleCompressor nulls;
+	bool has_nulls;
+} UuidCompressor;
+
+typedef struct ExtendedCompressor
+{
+	Compressor base;
+	UuidCompressor *internal;
+} ExtendedCompressor;
+
+typedef struct UuidDictionaryEntry
+{
+	pg_uuid_t value; /* the hash key */
+	uint32 index;
+} UuidDictionaryEntry;
+
+static inline uint64
+zig_zag_encode(uint64 value)
+{
+	return (value << 1) ^ (((int64) value) < 0 ? PG_UINT64_MAX : 0);
+}
+
+static inline uint64
+zig_zag_decode(uint64 value)
+{
+	return (value >> 1) ^ (uint64) - (int64) (value & 1);
+}
+
+static inline uint8
+uuid_version(const pg_uuid_t *value)
+{
+	return value->data[6] >> 4;
+}
+
+/* The first 8 bytes of the value as a big-endian number */
+static inline uint64
+uuid_get_high(const pg_uuid_t *value)
+{
+	uint64 high;
+
+	memcpy(&high, value->data, sizeof(high));
+	return pg_ntoh64(high);
+}
+
+static inline void
+uuid_set_high(pg_uuid_t *value, uint64 high)
+{
+	high = pg_hton64(high);
+	memcpy(value->data, &high, sizeof(high));
+}
+
+/*
+ * The number whose consecutive values are close for the time-ordered UUIDs.
+ * Version 7 starts with the timestamp, but version 1 starts with the low
+ * 32 bits of it, then the middle 16 bits, then the version and the high 12
+ * bits, so the fields are swapped around for it.
+ */
+static inline uint64
+uuid_time_key(uint64 high, UuidEncoding encoding)
+{
+	if (encoding == UUID_ENCODING_TIME_V1)
+		return ((high & 0xffff) << 48) | (((high >> 16) & 0xffff) << 32) | (high >> 32);
+
+	return high;
+}
+
+static inline uint64
+uuid_time_key_to_high(uint64 key, UuidEncoding encoding)
+{
+	if (encoding == UUID_ENCODING_TIME_V1)
+		return ((key & 0xffffffff) << 32) | (((key >> 32) & 0xffff) << 16) | (key >> 48);
+
+	return key;
+}
+
+/* The size of the fixed-size part of the data after the header */
+static inline Size
+uuid_fixed_size(UuidEncoding encoding, uint32 num_values, uint32 num_distinct)
+{
+	switch (encoding)
+	{
+		case UUID_ENCODING_PLAIN:
+			return (Size) num_values * UUID_LEN;
+		case UUID_ENCODING_DICTIONARY:
+			return (Size) num_distinct * UUID_LEN;
+		case UUID_ENCODING_TIME_V7:
+		case UUID_ENCODING_TIME_V1:
+			return (Size) num_values * sizeof(uint64);
+		default:
+			elog(ERROR, "invalid uuid encoding %d", encoding);
+	}
+
+	pg_unreachable();
+}
+
+static inline bool
+uuid_encoding_has_simple8b(UuidEncoding encoding)
+{
+	return encoding != UUID_ENCODING_PLAIN;
+}
+
+/* The dictionary indexes or the time deltas */
+static Simple8bRleSerialized *
+uuid_compressed_get_simple8b(const UuidCompressed *compressed)
+{
+	const char *data = (const char *) compressed->data +
+					   uuid_fixed_size(compressed->encoding,
+									   compressed->num_values,
+									   compressed->num_distinct);
+
+	Assert(uuid_encoding_has_simple8b(compressed->encoding));
+	return bytes_deserialize_simple8b_and_advance(&data);
+}
+
+static Simple8bRleSerialized *
+uuid_compressed_get_nulls(const UuidCompressed *compressed)
+{
+	const char *data = (const char *) compressed->data +
+					   uuid_fixed_size(compressed->encoding,
+									   compressed->num_values,
+									   compressed->num_distinct);
+
+	Assert(compressed->has_nulls == 1);
+	if (uuid_encoding_has_simple8b(compressed->encoding))
+		bytes_deserialize_simple8b_and_advance(&data);
+	return bytes_deserialize_simple8b_and_advance(&data);
+}
+
+//////////////////
+/// Compressor ///
+//////////////////
+
+static void
+uuid_compressor_append_uuid(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = uuid_compressor_alloc();
+
+	uuid_compressor_append_value(extended->internal, DatumGetUUIDP(val));
+}
+
+static void
+uuid_compressor_append_null_value(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = uuid_compressor_alloc();
+
+	uuid_compressor_append_null(extended->internal);
+}
+
+static void *
+uuid_compressor_finish_and_reset(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	void *compressed = uuid_compressor_finish(extended->internal);
+	pfree(extended->internal->values);
+	pfree(extended->internal);
+	extended->internal = NULL;
+	return compressed;
+}
+
+const Compressor uuid_compressor = {
+	.append_val = uuid_compressor_append_uuid,
+	.append_null = uuid_compressor_append_null_value,
+	.finish = uuid_compressor_finish_and_reset,
+};
+
+Compressor *
+uuid_compressor_for_type(Oid element_type)
+{
+	ExtendedCompressor *compressor;
+
+	if (element_type != UUIDOID)
+		elog(ERROR, "invalid type for uuid compressor \"%s\"", format_type_be(element_type));
+
+	compressor = palloc(sizeof(*compressor));
+	*compressor = (ExtendedCompressor){ .base = uuid_compressor };
+	return &compressor->base;
+}
+
+UuidCompressor *
+uuid_compressor_alloc(void)
+{
+	UuidCompressor *compressor = palloc0(sizeof(*compressor));
+	compressor->max_values = 64;
+	compressor->values = palloc(sizeof(pg_uuid_t) * compressor->max_values);
+	simple8brle_compressor_init(&compressor->nulls);
+	return compressor;
+}
+
+void
+uuid_compressor_append_null(UuidCompressor *compressor)
+{
+	compressor->has_nulls = true;
+	simple8brle_compressor_append(&compressor->nulls, 1);
+}
+
+void
+uuid_compressor_append_value(UuidCompressor *compressor, const pg_uuid_t *value)
+{
+	if (compressor->num_values == compressor->max_values)
+	{
+		compressor->max_values *= 2;
+		compressor->values =
+			repalloc(compressor->values, sizeof(pg_uuid_t) * compressor->max_values);
+	}
+
+	compressor->values[compressor->num_values++] = *value;
+	simple8brle_compressor_append(&compressor->nulls, 0);
+}
+
+static UuidCompressed *
+uuid_from_parts(UuidEncoding encoding, uint32 num_values, uint32 num_distinct, const void *fixed,
+				Simple8bRleSerialized *simple8b, Simple8bRleSerialized *nulls)
+{
+	const Size fixed_size = uuid_fixed_size(encoding, num_values, num_distinct);
+	Size simple8b_size = 0;
+	Size nulls_size = 0;
+	Size compressed_size;
+	UuidCompressed *compressed;
+	char *data;
+
+	if (uuid_encoding_has_simple8b(encoding))
+	{
+		if (simple8b == NULL || simple8b->num_elements != num_values)
+			elog(ERROR, "invalid number of elements in uuid compressed data");
+		simple8b_size = simple8brle_serialized_total_size(simple8b);
+	}
+
+	if (nulls != NULL)
+		nulls_size = simple8brle_serialized_total_size(nulls);
+
+	compressed_size = sizeof(UuidCompressed) + fixed_size + simple8b_size + nulls_size;
+
+	if (!AllocSizeIsValid(compressed_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("compressed size exceeds the maximum allowed (%d)", (int) MaxAllocSize)));
+
+	compressed = palloc0(compressed_size);
+	SET_VARSIZE(&compressed->vl_len_, compressed_size);
+
+	compressed->compression_algorithm = COMPRESSION_ALGORITHM_UUID;
+	compressed->encoding = encoding;
+	compressed->has_nulls = nulls_size != 0 ? 1 : 0;
+	compressed->num_values = num_values;
+	compressed->num_distinct = num_distinct;
+
+	data = (char *) compressed->data;
+	if (fixed_size > 0)
+		memcpy(data, fixed, fixed_size);
+	data += fixed_size;
+
+	if (simple8b_size > 0)
+		data = bytes_serialize_simple8b_and_advance(data, simple8b_size, simple8b);
+
+	if (compressed->has_nulls == 1)
+	{
+		Assert(nulls->num_elements > num_values);
+		bytes_serialize_simple8b_and_advance(data, nulls_size, nulls);
+	}
+
+	return compressed;
+}
+
+/*
+ * Build the dictionary of the values. Returns NULL if there are as many
+ * distinct values as values, where the dictionary can't be smaller.
+ */
+static Simple8bRleSerialized *
+uuid_build_dictionary(const UuidCompressor *compressor, pg_uuid_t **distinct,
+					  uint32 *num_distinct)
+{
+	HASHCTL hash_ctl = {
+		.keysize = sizeof(pg_uuid_t),
+		.entrysize = sizeof(UuidDictionaryEntry),
+		.hcxt = CurrentMemoryContext,
+	};
+	HTAB *dictionary = hash_create("uuid compression dictionary",
+								   compressor->num_values,
+								   &hash_ctl,
+								   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	Simple8bRleCompressor indexes;
+	uint32 count = 0;
+
+	*distinct = palloc(sizeof(pg_uuid_t) * compressor->num_values);
+	simple8brle_compressor_init(&indexes);
+
+	for (uint32 i = 0; i < compressor->num_values; i++)
+	{
+		bool found;
+		UuidDictionaryEntry *entry =
+			hash_search(dictionary, &compressor->values[i], HASH_ENTER, &found);
+
+		if (!found)
+		{
+			entry->index = count;
+			(*distinct)[count++] = compressor->values[i];
+		}
+		simple8brle_compressor_append(&indexes, entry->index);
+	}
+
+	hash_destroy(dictionary);
+	*num_distinct = count;
+
+	if (count == compressor->num_values)
+		return NULL;
+
+	return simple8brle_compressor_finish(&indexes);
+}
+
+/*
+ * The time encoding matching the version of all the values, or the plain
+ * encoding if the values are not all time-ordered UUIDs of the same version.
+ */
+static UuidEncoding
+uuid_time_encoding(const UuidCompressor *compressor)
+{
+	const uint8 version = uuid_version(&compressor->values[0]);
+
+	if (version != 7 && version != 1)
+		return UUID_ENCODING_PLAIN;
+
+	for (uint32 i = 1; i < compressor->num_values; i++)
+		if (uuid_version(&compressor->values[i]) != version)
+			return UUID_ENCODING_PLAIN;
+
+	return version == 7 ? UUID_ENCODING_TIME_V7 : UUID_ENCODING_TIME_V1;
+}
+
+static Simple8bRleSerialized *
+uuid_build_time_deltas(const UuidCompressor *compressor, UuidEncoding encoding, uint64 **low)
+{
+	Simple8bRleCompressor deltas;
+	uint64 prev = 0;
+
+	*low = palloc(sizeof(uint64) * compressor->num_values);
+	simple8brle_compressor_init(&deltas);
+
+	for (uint32 i = 0; i < compressor->num_values; i++)
+	{
+		const uint64 key = uuid_time_key(uuid_get_high(&compressor->values[i]), encoding);
+
+		memcpy(&(*low)[i], compressor->values[i].data + sizeof(uint64), sizeof(uint64));
+		simple8brle_compressor_append(&deltas, zig_zag_encode(key - prev));
+		prev = key;
+	}
+
+	return simple8brle_compressor_finish(&deltas);
+}
+
+/*
+ * Encode the values in every applicable encoding and keep the smallest one.
+ * On a tie, the one that is cheaper to decode wins.
+ */
+UuidCompressed *
+uuid_compressor_finish(UuidCompressor *compressor)
+{
+	Simple8bRleSerialized *nulls = simple8brle_compressor_finish(&compressor->nulls);
+	UuidEncoding encoding = UUID_ENCODING_PLAIN;
+	Size best_size;
+	const void *fixed = compressor->values;
+	Simple8bRleSerialized *simple8b = NULL;
+	uint32 num_distinct = 0;
+	pg_uuid_t *distinct;
+	Simple8bRleSerialized *indexes;
+	UuidEncoding time_encoding;
+
+	if (compressor->num_values == 0)
+		return NULL;
+
+	best_size = uuid_fixed_size(UUID_ENCODING_PLAIN, compressor->num_values, 0);
+
+	indexes = uuid_build_dictionary(compressor, &distinct, &num_distinct);
+	if (indexes != NULL)
+	{
+		Size size =
+			uuid_fixed_size(UUID_ENCODING_DICTIONARY, compressor->num_values, num_distinct) +
+			simple8brle_serialized_total_size(indexes);
+
+		if (size < best_size)
+		{
+			encoding = UUID_ENCODING_DICTIONARY;
+			best_size = size;
+			fixed = distinct;
+			simple8b = indexes;
+		}
+	}
+
+	time_encoding = uuid_time_encoding(compressor);
+	if (time_encoding != UUID_ENCODING_PLAIN)
+	{
+		uint64 *low;
+		Simple8bRleSerialized *deltas = uuid_build_time_deltas(compressor, time_encoding, &low);
+		Size size = uuid_fixed_size(time_encoding, compressor->num_values, 0) +
+					simple8brle_serialized_total_size(deltas);
+
+		if (size < best_size)
+		{
+			encoding = time_encoding;
+			best_size = size;
+			fixed = low;
+			simple8b = deltas;
+		}
+	}
+
+	return uuid_from_parts(encoding,
+						   compressor->num_values,
+						   encoding == UUID_ENCODING_DICTIONARY ? num_distinct : 0,
+						   fixed,
+						   simple8b,
+						   compressor->has_nulls ? nulls : NULL);
+}
+
+////////////////////
+/// Decompressor ///
+////////////////////
+
+/* Decode all the non-null values of the compressed data */
+static pg_uuid_t *
+uuid_decode_values(const UuidCompressed *compressed)
+{
+	const uint32 num_values = compressed->num_values;
+	pg_uuid_t *values = palloc(sizeof(pg_uuid_t) * Max(num_values, 1));
+	uint64 *decoded;
+
+	if (compressed->encoding == UUID_ENCODING_PLAIN)
+	{
+		memcpy(values, compressed->data, sizeof(pg_uuid_t) * num_values);
+		return values;
+	}
+
+	decoded = palloc(sizeof(uint64) * Max(num_values, 1));
+	if (simple8brle_decompress_all_buf(uuid_compressed_get_simple8b(compressed),
+									   decoded,
+									   num_values) != num_values)
+		elog(ERROR, "invalid number of elements in uuid compressed data");
+
+	if (compressed->encoding == UUID_ENCODING_DICTIONARY)
+	{
+		const pg_uuid_t *distinct = (const pg_uuid_t *) compressed->data;
+
+		for (uint32 i = 0; i < num_values; i++)
+		{
+			if (decoded[i] >= compressed->num_distinct)
+				elog(ERROR, "invalid dictionary index in uuid compressed data");
+			values[i] = distinct[decoded[i]];
+		}
+	}
+	else
+	{
+		const UuidEncoding encoding = compressed->encoding;
+		uint64 key = 0;
+
+		for (uint32 i = 0; i < num_values; i++)
+		{
+			key += zig_zag_decode(decoded[i]);
+			uuid_set_high(&values[i], uuid_time_key_to_high(key, encoding));
+			memcpy(values[i].data + sizeof(uint64), &compressed->data[i], sizeof(uint64));
+		}
+	}
+
+	pfree(decoded);
+	return values;
+}
+
+static void
+uuid_decompression_iterator_init(UuidDecompressionIterator *iter, const UuidCompressed *compressed,
+								 bool scan_forward, Oid element_type)
+{
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	if (compressed->encoding >= _UUID_ENCODING_END)
+		elog(ERROR, "invalid uuid encoding %d", compressed->encoding);
+
+	*iter = (UuidDecompressionIterator){
+		.base = {
+			.compression_algorithm = COMPRESSION_ALGORITHM_UUID,
+			.forward = scan_forward,
+			.element_type = element_type,
+			.try_next = scan_forward ? uuid_decompression_iterator_try_next_forward :
+									   uuid_decompression_iterator_try_next_reverse,
+		},
+		.values = uuid_decode_values(compressed),
+		.num_values = compressed->num_values,
+		.num_returned = 0,
+		.has_nulls = compressed->has_nulls == 1,
+	};
+
+	if (iter->has_nulls)
+	{
+		Simple8bRleSerialized *nulls = uuid_compressed_get_nulls(compressed);
+		if (scan_forward)
+			simple8brle_decompression_iterator_init_forward(&iter->nulls, nulls);
+		else
+			simple8brle_decompression_iterator_init_reverse(&iter->nulls, nulls);
+	}
+}
+
+DecompressionIterator *
+uuid_decompression_iterator_from_datum_forward(Datum compressed, Oid element_type)
+{
+	UuidDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	uuid_decompression_iterator_init(iterator,
+									 (void *) PG_DETOAST_DATUM(compressed),
+									 true,
+									 element_type);
+	return &iterator->base;
+}
+
+DecompressionIterator *
+uuid_decompression_iterator_from_datum_reverse(Datum compressed, Oid element_type)
+{
+	UuidDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	uuid_decompression_iterator_init(iterator,
+									 (void *) PG_DETOAST_DATUM(compressed),
+									 false,
+									 element_type);
+	return &iterator->base;
+}
+
+static DecompressResult
+uuid_decompression_iterator_try_next(UuidDecompressionIterator *iter)
+{
+	uint32 index;
+
+	/* check for a null value */
+	if (iter->has_nulls)
+	{
+		Simple8bRleDecompressResult result =
+			iter->base.forward ? simple8brle_decompression_iterator_try_next_forward(&iter->nulls) :
+								 simple8brle_decompression_iterator_try_next_reverse(&iter->nulls);
+		if (result.is_done)
+			return (DecompressResult){
+				.is_done = true,
+			};
+
+		if (result.val != 0)
+		{
+			Assert(result.val == 1);
+			return (DecompressResult){
+				.is_null = true,
+			};
+		}
+	}
+
+	if (iter->num_returned >= iter->num_values)
+		return (DecompressResult){
+			.is_done = true,
+		};
+
+	index = iter->base.forward ? iter->num_returned : iter->num_values - 1 - iter->num_returned;
+	iter->num_returned++;
+
+	return (DecompressResult){
+		.val = UUIDPGetDatum(&iter->values[index]),
+	};
+}
+
+DecompressResult
+uuid_decompression_iterator_try_next_forward(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_UUID && iter->forward);
+	return uuid_decompression_iterator_try_next((UuidDecompressionIterator *) iter);
+}
+
+DecompressResult
+uuid_decompression_iterator_try_next_reverse(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_UUID && !iter->forward);
+	return uuid_decompression_iterator_try_next((UuidDecompressionIterator *) iter);
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+void
+uuid_compressed_send(CompressedDataHeader *header, StringInfo buffer)
+{
+	const UuidCompressed *data = (UuidCompressed *) header;
+	const Size fixed_size = uuid_fixed_size(data->encoding, data->num_values, data->num_distinct);
+
+	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_UUID);
+	pq_sendbyte(buffer, data->encoding);
+	pq_sendbyte(buffer, data->has_nulls);
+	pq_sendint32(buffer, data->num_values);
+	pq_sendint32(buffer, data->num_distinct);
+	pq_sendbytes(buffer, (const char *) data->data, fixed_size);
+	if (uuid_encoding_has_simple8b(data->encoding))
+		simple8brle_serialized_send(buffer, uuid_compressed_get_simple8b(data));
+	if (data->has_nulls)
+		simple8brle_serialized_send(buffer, uuid_compressed_get_nulls(data));
+}
+
+Datum
+uuid_compressed_recv(StringInfo buffer)
+{
+	uint8 encoding;
+	uint8 has_nulls;
+	uint32 num_values;
+	uint32 num_distinct;
+	Size fixed_size;
+	const char *fixed;
+	Simple8bRleSerialized *simple8b = NULL;
+	Simple8bRleSerialized *nulls = NULL;
+
+	encoding = pq_getmsgbyte(buffer);
+	if (encoding >= _UUID_ENCODING_END)
+		elog(ERROR, "invalid recv in uuid: bad encoding");
+
+	has_nulls = pq_getmsgbyte(buffer);
+	if (has_nulls != 0 && has_nulls != 1)
+		elog(ERROR, "invalid recv in uuid: bad bool");
+
+	num_values = pq_getmsgint32(buffer);
+	num_distinct = pq_getmsgint32(buffer);
+	if (encoding != UUID_ENCODING_DICTIONARY && num_distinct != 0)
+		elog(ERROR, "invalid recv in uuid: bad number of distinct values");
+	if (encoding == UUID_ENCODING_DICTIONARY && num_distinct > num_values)
+		elog(ERROR, "invalid recv in uuid: bad number of distinct values");
+
+	fixed_size = uuid_fixed_size(encoding, num_values, num_distinct);
+	if (fixed_size > (Size) (buffer->len - buffer->cursor))
+		elog(ERROR, "invalid recv in uuid: bad number of values");
+	fixed = pq_getmsgbytes(buffer, fixed_size);
+
+	if (uuid_encoding_has_simple8b(encoding))
+		simple8b = simple8brle_serialized_recv(buffer);
+
+	if (has_nulls)
+		nulls = simple8brle_serialized_recv(buffer);
+
+	PG_RETURN_POINTER(uuid_from_parts(encoding, num_values, num_distinct, fixed, simple8b, nulls));
+}
@@ -0,0 +1,63 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+/*
+ * The uuid algorithm stores the UUIDs of a batch as packed 16-byte values, in
+ * whichever of the following encodings is the smallest for the batch:
+ *
+ * - plain: the values one after the other.
+ * - dictionary: the distinct values, followed by the index of every value
+ *   into them as simple8b_rle. This suits the batches where the same trace
+ *   or parent span ids repeat.
+ * - time prefix: the time-ordered UUIDs, i.e. versions 7 and 1, start with
+ *   their timestamp, so the first 8 bytes of consecutive values are close.
+ *   They are stored as zig-zag encoded deltas in simple8b_rle, after the last
+ *   8 bytes of every value. The timestamp fields of version 1 are stored
+ *   from the low to the high ones, so they are reordered into a number first.
+ *
+ * The nulls are stored as a simple8b_rle bitmap like in deltadelta.
+ */
+#ifndef TIMESCALEDB_TSL_COMPRESSION_UUID_COMPRESSION_H
+#define TIMESCALEDB_TSL_COMPRESSION_UUID_COMPRESSION_H
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+#include <utils/uuid.h>
+
+#include "compression/compression.h"
+
+typedef struct UuidCompressor UuidCompressor;
+typedef struct UuidCompressed UuidCompressed;
+typedef struct UuidDecompressionIterator UuidDecompressionIterator;
+
+extern Compressor *uuid_compressor_for_type(Oid element_type);
+extern UuidCompressor *uuid_compressor_alloc(void);
+extern void uuid_compressor_append_null(UuidCompressor *compressor);
+extern void uuid_compressor_append_value(UuidCompressor *compressor, const pg_uuid_t *value);
+extern UuidCompressed *uuid_compressor_finish(UuidCompressor *compressor);
+
+extern DecompressionIterator *uuid_decompression_iterator_from_datum_forward(Datum compressed,
+																			 Oid element_type);
+extern DecompressionIterator *uuid_decompression_iterator_from_datum_reverse(Datum compressed,
+																			 Oid element_type);
+extern DecompressResult uuid_decompression_iterator_try_next_forward(DecompressionIterator *iter);
+extern DecompressResult uuid_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
+
+extern void uuid_compressed_send(CompressedDataHeader *header, StringInfo buffer);
+extern Datum uuid_compressed_recv(StringInfo buf);
+
+#define UUID_ALGORITHM_DEFINITION                                                                  \
+	{                                                                                              \
+		.iterator_init_forward = uuid_decompression_iterator_from_datum_forward,                   \
+		.iterator_init_reverse = uuid_decompression_iterator_from_datum_reverse,                   \
+		.compressed_data_send = uuid_compressed_send,                                              \
+		.compressed_data_recv = uuid_compressed_recv,                                              \
+		.compressor_for_type = uuid_compressor_for_type,                                           \
+		.compressed_data_storage = TOAST_STORAGE_EXTERNAL,                                         \
+		.decompress_all = NULL,                                                                    \
+	}
+
+#endif
@@ -64,6 +64,7 @@
 #include "dimension.h"
 #include "extension_constants.h"
 #include "func_cache.h"
+#include "guc.h"
 #include "hypertable_cache.h"
 #include "hypertable.h"
 #include "invalidation.h"
@@ -224,6 +225,8 @@ static Oid relation_oid(NameData schema, NameData name);
 static Query *build_union_query(CAggTimebucketInfo *tbinfo, int matpartcolno, Query *q1, Query *q2,
 								int materialize_htid);
 static Query *destroy_union_query(Query *q);
+static void cagg_partial_query_use_parent_materialization(Query *partial_query,
+														  int32 parent_mat_hypertable_id);
 
 /* create a entry for the materialization table in table CONTINUOUS_AGGS */
 static void
@@ -2438,6 +2441,11 @@ cagg_create(const CreateTableAsStmt *create_stmt, ViewStmt *stmt, Query *panquer
 	partial_selquery =
 		mattablecolumninfo_get_partial_select_query(&mattblinfo, panquery, finalqinfo.finalized);
 
+	if (origquery_ht->parent_mat_hypertable_id != INVALID_HYPERTABLE_ID &&
+		ts_guc_enable_cagg_nested_materialized_source)
+		cagg_partial_query_use_parent_materialization(partial_selquery,
+													  origquery_ht->parent_mat_hypertable_id);
+
 	PRINT_MATINTERNAL_NAME(relnamebuf, "_partial_view_%d", materialize_hypertable_id);
 	part_rel = makeRangeVar(pstrdup(INTERNAL_SCHEMA_NAME), pstrdup(relnamebuf), -1);
 	create_view_for_query(partial_selquery, part_rel);
@@ -3201,6 +3209,56 @@ destroy_union_query(Query *q)
 	return query;
 }
 
+/*
+ * Make the partial query of a continuous aggregate on top of another
+ * continuous aggregate read the materialized data of the parent instead of
+ * going through the parent user view.
+ *
+ * The user view of a real-time parent is a UNION ALL with the raw data above
+ * the parent watermark. Refreshing the nested aggregate never needs that part
+ * since its refresh window is capped at the invalidation threshold of the
+ * parent materialization hypertable, so the materialized part of the parent
+ * view is inlined as a subquery. Changes to the parent materialization reach
+ * the nested aggregate through the invalidation trigger on the parent
+ * materialization hypertable.
+ */
+static void
+cagg_partial_query_use_parent_materialization(Query *partial_query, int32 parent_mat_hypertable_id)
+{
+	ContinuousAgg *parent = ts_continuous_agg_find_by_mat_hypertable_id(parent_mat_hypertable_id);
+	Oid parent_view_oid;
+	ListCell *lc;
+
+	Assert(parent != NULL);
+	parent_view_oid = relation_oid(parent->data.user_view_schema, parent->data.user_view_name);
+
+	foreach (lc, partial_query->rtable)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+		Relation parent_view_rel;
+		Query *parent_query;
+
+		if (rte->rtekind != RTE_RELATION || rte->relid != parent_view_oid)
+			continue;
+
+		parent_view_rel = relation_open(parent_view_oid, AccessShareLock);
+		parent_query = copyObject(get_view_query(parent_view_rel));
+		/* keep lock until end of transaction */
+		relation_close(parent_view_rel, NoLock);
+		remove_old_and_new_rte_from_query(parent_query);
+
+		if (!parent->data.materialized_only)
+			parent_query = destroy_union_query(parent_query);
+
+		rte->rtekind = RTE_SUBQUERY;
+		rte->subquery = parent_query;
+		rte->relid = InvalidOid;
+		rte->relkind = 0;
+		rte->inh = false; /* never true for subqueries */
+		rte->requiredPerms = 0;
+	}
+}
+
 /*
  * return Oid for a schema-qualified relation
  */
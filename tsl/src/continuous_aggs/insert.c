@@ -26,10 +26,13 @@
 
 #include "chunk.h"
 #include "dimension.h"
+#include "dimension_slice.h"
+#include "hypercube.h"
 #include "hypertable.h"
 #include "hypertable_cache.h"
 #include "invalidation.h"
 #include "export.h"
+#include "guc.h"
 #include "partitioning.h"
 #include "utils.h"
 #include "time_bucket.h"
@@ -56,7 +59,31 @@
  * multiple can have tuples modified during a single transaction. (And if we
  * move to per-chunk cache-invalidation it makes it even easier).
  *
+ * When timescaledb.enable_cagg_invalidation_tracking is set, inserts do not go
+ * through the trigger. Instead, each chunk insert state tracks the range of
+ * time values it has dispatched and adds it to the hashtable once, when the
+ * insert state is destroyed (see continuous_agg_add_invalidation_range).
+ *
+ * With timescaledb.cagg_max_invalidation_ranges above one, each entry also
+ * keeps a sorted list of disjoint modified ranges, so that a transaction that
+ * modifies a few distant time values does not invalidate everything in
+ * between. Values closer than the smallest bucket width of the continuous
+ * aggregates on the hypertable end up in the same range. When the list is
+ * full, the two ranges with the smallest gap between them are merged.
+ *
+ * With timescaledb.enable_cagg_partition_invalidation, each entry also keeps
+ * the range of space partitions of the chunks that were modified. If all
+ * continuous aggregates on the hypertable group by the space column, the
+ * ranges are written to their partition invalidation logs instead of the
+ * hypertable invalidation log, so that refreshes only recompute the groups
+ * of the modified partitions.
  */
+typedef struct InvalidationRange
+{
+	int64 lowest_modified_value;
+	int64 greatest_modified_value;
+} InvalidationRange;
+
 typedef struct ContinuousAggsCacheInvalEntry
 {
 	int32 hypertable_id;
@@ -72,6 +99,17 @@ typedef struct ContinuousAggsCacheInvalEntry
 	bool value_is_set;
 	int64 lowest_modified_value;
 	int64 greatest_modified_value;
+	/* Disjoint modified ranges, sorted, if tracking more than one */
+	int max_ranges;
+	int num_ranges;
+	InvalidationRange *ranges;
+	/* Values at most this far apart are merged into one range */
+	int64 merge_distance;
+	/* The space dimension whose modified partitions are tracked, or 0 */
+	int32 partition_dimension_id;
+	bool partition_is_set;
+	int64 partition_range_start;
+	int64 partition_range_end;
 } ContinuousAggsCacheInvalEntry;
 
 static int64 get_lowest_invalidated_time_for_hypertable(Oid hypertable_relid);
@@ -158,9 +196,86 @@ cache_inval_entry_init(ContinuousAggsCacheInvalEntry *cache_entry, int32 hyperta
 	cache_entry->value_is_set = false;
 	cache_entry->lowest_modified_value = INVAL_POS_INFINITY;
 	cache_entry->greatest_modified_value = INVAL_NEG_INFINITY;
+	cache_entry->max_ranges = ts_guc_cagg_max_invalidation_ranges;
+	cache_entry->num_ranges = 0;
+	cache_entry->ranges = NULL;
+	cache_entry->merge_distance = 1;
+	cache_entry->partition_dimension_id = 0;
+	cache_entry->partition_is_set = false;
+
+	/* Distributed hypertables only track time on the data nodes */
+	if (ts_guc_enable_cagg_partition_invalidation && entry_id == hypertable_id &&
+		!hypertable_is_distributed_member(ht))
+	{
+		const Dimension *space_dim = hyperspace_get_closed_dimension(ht->space, 0);
+
+		if (space_dim != NULL)
+			cache_entry->partition_dimension_id = space_dim->fd.id;
+	}
+
+	if (cache_entry->max_ranges > 1)
+	{
+		ListCell *lc;
+		int64 min_bucket_width = PG_INT64_MAX;
+
+		/* Room for one more range than the maximum, which is merged away
+		 * when adding it */
+		cache_entry->ranges = MemoryContextAlloc(continuous_aggs_trigger_mctx,
+												 sizeof(InvalidationRange) *
+													 (cache_entry->max_ranges + 1));
+
+		/* Values within a bucket of each other invalidate the same buckets, so
+		 * there is no point in keeping them in separate ranges. Variable
+		 * sized buckets have no fixed width and are ignored here. */
+		foreach (lc, ts_continuous_aggs_find_by_raw_table_id(hypertable_id))
+		{
+			ContinuousAgg *cagg = lfirst(lc);
+
+			if (!ts_continuous_agg_bucket_width_variable(cagg))
+				min_bucket_width = Min(min_bucket_width, ts_continuous_agg_bucket_width(cagg));
+		}
+
+		if (min_bucket_width != PG_INT64_MAX && min_bucket_width > 1)
+			cache_entry->merge_distance = min_bucket_width;
+	}
+
 	ts_cache_release(ht_cache);
 }
 
+/*
+ * Add the space partition of a modified chunk to the tracked partition range.
+ */
+static void
+cache_entry_add_chunk_partition(ContinuousAggsCacheInvalEntry *cache_entry, const Chunk *chunk)
+{
+	const DimensionSlice *slice;
+	int64 range_start = DIMENSION_SLICE_MINVALUE;
+	int64 range_end = DIMENSION_SLICE_MAXVALUE;
+
+	if (cache_entry->partition_dimension_id == 0)
+		return;
+
+	slice = ts_hypercube_get_slice_by_dimension_id(chunk->cube,
+												   cache_entry->partition_dimension_id);
+
+	if (slice != NULL)
+	{
+		range_start = slice->fd.range_start;
+		range_end = slice->fd.range_end;
+	}
+
+	if (!cache_entry->partition_is_set)
+	{
+		cache_entry->partition_range_start = range_start;
+		cache_entry->partition_range_end = range_end;
+		cache_entry->partition_is_set = true;
+		return;
+	}
+
+	cache_entry->partition_range_start = Min(cache_entry->partition_range_start, range_start);
+	cache_entry->partition_range_end = Max(cache_entry->partition_range_end, range_end);
+}
+
 static inline void
 cache_entry_switch_to_chunk(ContinuousAggsCacheInvalEntry *cache_entry, Oid chunk_id,
 							Relation chunk_relation)
@@ -169,6 +284,8 @@ cache_entry_switch_to_chunk(ContinuousAggsCacheInvalEntry *cache_entry, Oid chun
 	if (modified_tuple_chunk == NULL)
 		elog(ERROR, "continuous agg trigger function must be called on hypertable chunks only");
 
+	cache_entry_add_chunk_partition(cache_entry, modified_tuple_chunk);
+
 	cache_entry->previous_chunk_relid = modified_tuple_chunk->table_id;
 	cache_entry->previous_chunk_open_dimension =
 		get_attnum(chunk_relation->rd_id,
@@ -178,14 +295,111 @@ cache_entry_switch_to_chunk(ContinuousAggsCacheInvalEntry *cache_entry, Oid chun
 		elog(ERROR, "continuous agg trigger function must be called on hypertable chunks only");
 }
 
+/*
+ * Check if a value that is not lower than the end of a range is close enough
+ * to be merged into it. The unsigned difference cannot overflow.
+ */
+static inline bool
+range_within_merge_distance(int64 greatest_modified_value, int64 value, int64 merge_distance)
+{
+	return value <= greatest_modified_value ||
+		   (uint64) value - (uint64) greatest_modified_value <= (uint64) merge_distance;
+}
+
+/*
+ * Merge the two adjacent ranges with the smallest gap between them.
+ */
+static void
+cache_entry_merge_closest_ranges(ContinuousAggsCacheInvalEntry *cache_entry)
+{
+	InvalidationRange *ranges = cache_entry->ranges;
+	uint64 min_gap = PG_UINT64_MAX;
+	int min_i = 0;
+	int i;
+
+	Assert(cache_entry->num_ranges > 1);
+
+	for (i = 0; i < cache_entry->num_ranges - 1; i++)
+	{
+		uint64 gap =
+			(uint64) ranges[i + 1].lowest_modified_value - (uint64) ranges[i].greatest_modified_value;
+
+		if (gap < min_gap)
+		{
+			min_gap = gap;
+			min_i = i;
+		}
+	}
+
+	ranges[min_i].greatest_modified_value = ranges[min_i + 1].greatest_modified_value;
+	memmove(&ranges[min_i + 1],
+			&ranges[min_i + 2],
+			sizeof(InvalidationRange) * (cache_entry->num_ranges - min_i - 2));
+	cache_entry->num_ranges--;
+}
+
+static void
+cache_entry_add_range(ContinuousAggsCacheInvalEntry *cache_entry, int64 lowest, int64 greatest)
+{
+	InvalidationRange *ranges = cache_entry->ranges;
+	int64 distance = cache_entry->merge_distance;
+	int low = 0;
+	int high = cache_entry->num_ranges;
+	int end;
+
+	cache_entry->value_is_set = true;
+	if (lowest < cache_entry->lowest_modified_value)
+		cache_entry->lowest_modified_value = lowest;
+	if (greatest > cache_entry->greatest_modified_value)
+		cache_entry->greatest_modified_value = greatest;
+
+	if (cache_entry->max_ranges <= 1)
+		return;
+
+	/* Find the first range that the new one can be merged with or that
+	 * comes after it */
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (range_within_merge_distance(ranges[mid].greatest_modified_value, lowest, distance))
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	/* Find the end of the ranges that the new one can be merged with */
+	end = low;
+	while (end < cache_entry->num_ranges &&
+		   range_within_merge_distance(greatest, ranges[end].lowest_modified_value, distance))
+		end++;
+
+	if (end > low)
+	{
+		ranges[low].lowest_modified_value = Min(lowest, ranges[low].lowest_modified_value);
+		ranges[low].greatest_modified_value = Max(greatest, ranges[end - 1].greatest_modified_value);
+		memmove(&ranges[low + 1],
+				&ranges[end],
+				sizeof(InvalidationRange) * (cache_entry->num_ranges - end));
+		cache_entry->num_ranges -= end - low - 1;
+		return;
+	}
+
+	memmove(&ranges[low + 1],
+			&ranges[low],
+			sizeof(InvalidationRange) * (cache_entry->num_ranges - low));
+	ranges[low].lowest_modified_value = lowest;
+	ranges[low].greatest_modified_value = greatest;
+	cache_entry->num_ranges++;
+
+	if (cache_entry->num_ranges > cache_entry->max_ranges)
+		cache_entry_merge_closest_ranges(cache_entry);
+}
+
 static inline void
 update_cache_entry(ContinuousAggsCacheInvalEntry *cache_entry, int64 timeval)
 {
-	cache_entry->value_is_set = true;
-	if (timeval < cache_entry->lowest_modified_value)
-		cache_entry->lowest_modified_value = timeval;
-	if (timeval > cache_entry->greatest_modified_value)
-		cache_entry->greatest_modified_value = timeval;
+	cache_entry_add_range(cache_entry, timeval, timeval);
 }
 
 /*
@@ -242,15 +456,13 @@ continuous_agg_trigfn(PG_FUNCTION_ARGS)
  * (for updates: this is the row before modification)
  * chunk_newtuple is the tuple from trigdata->tg_newtuple.
  */
-void
-execute_cagg_trigger(int32 hypertable_id, Relation chunk_rel, HeapTuple chunk_tuple,
-					 HeapTuple chunk_newtuple, bool update, bool is_distributed_hypertable_trigger,
-					 int32 parent_hypertable_id)
+static ContinuousAggsCacheInvalEntry *
+get_cache_inval_entry(int32 hypertable_id, bool is_distributed_hypertable_trigger,
+					  int32 parent_hypertable_id)
 {
 	ContinuousAggsCacheInvalEntry *cache_entry;
 	bool found;
-	int64 timeval;
-	Oid chunk_relid = chunk_rel->rd_id;
+
 	/* On first call, init the mctx and hash table */
 	if (!continuous_aggs_cache_inval_htab)
 		cache_inval_init();
@@ -264,6 +476,21 @@ execute_cagg_trigger(int32 hypertable_id, Relation chunk_rel, HeapTuple chunk_tu
 							   is_distributed_hypertable_trigger ? parent_hypertable_id :
 																   hypertable_id);
 
+	return cache_entry;
+}
+
+void
+execute_cagg_trigger(int32 hypertable_id, Relation chunk_rel, HeapTuple chunk_tuple,
+					 HeapTuple chunk_newtuple, bool update, bool is_distributed_hypertable_trigger,
+					 int32 parent_hypertable_id)
+{
+	ContinuousAggsCacheInvalEntry *cache_entry;
+	int64 timeval;
+	Oid chunk_relid = chunk_rel->rd_id;
+
+	cache_entry =
+		get_cache_inval_entry(hypertable_id, is_distributed_hypertable_trigger, parent_hypertable_id);
+
 	/* handle the case where we need to repopulate the cached chunk data */
 	if (cache_entry->previous_chunk_relid != chunk_relid)
 		cache_entry_switch_to_chunk(cache_entry, chunk_relid, chunk_rel);
@@ -287,17 +514,107 @@ execute_cagg_trigger(int32 hypertable_id, Relation chunk_rel, HeapTuple chunk_tu
 	update_cache_entry(cache_entry, timeval);
 }
 
+/*
+ * Add the range of time values modified by a statement, like the trigger does
+ * for every row. This is used by the chunk insert states, which track the
+ * range of the rows inserted into a chunk instead of calling the trigger. The
+ * range is in the internal time format of the hypertable's open dimension.
+ */
+void
+continuous_agg_add_invalidation_range(int32 hypertable_id, bool is_distributed_hypertable_trigger,
+									  int32 parent_hypertable_id, Oid chunk_relid,
+									  int64 lowest_modified_value, int64 greatest_modified_value)
+{
+	ContinuousAggsCacheInvalEntry *cache_entry =
+		get_cache_inval_entry(hypertable_id, is_distributed_hypertable_trigger, parent_hypertable_id);
+
+	if (cache_entry->partition_dimension_id != 0)
+		cache_entry_add_chunk_partition(cache_entry, ts_chunk_get_by_relid(chunk_relid, true));
+
+	cache_entry_add_range(cache_entry, lowest_modified_value, greatest_modified_value);
+}
+
+/*
+ * Get the continuous aggregates to add the invalidations of an entry to
+ * their partition invalidation logs.
+ *
+ * Returns NIL if the invalidations should go to the hypertable invalidation
+ * log, which is the case unless all continuous aggregates on the hypertable
+ * group by the space column and only some of the partitions were modified.
+ */
+static List *
+cache_inval_entry_get_partition_caggs(const ContinuousAggsCacheInvalEntry *entry,
+									  const Hypertable *ht)
+{
+	const Dimension *space_dim = hyperspace_get_closed_dimension(ht->space, 0);
+	List *cagg_ids = NIL;
+	ListCell *lc;
+
+	if (!entry->partition_is_set || space_dim == NULL ||
+		space_dim->fd.id != entry->partition_dimension_id ||
+		(entry->partition_range_start == DIMENSION_SLICE_MINVALUE &&
+		 entry->partition_range_end == DIMENSION_SLICE_MAXVALUE))
+		return NIL;
+
+	foreach (lc, ts_continuous_aggs_find_by_raw_table_id(entry->hypertable_id))
+	{
+		ContinuousAgg *cagg = lfirst(lc);
+
+		if (invalidation_get_partition_column(cagg, space_dim) == NULL)
+			return NIL;
+
+		cagg_ids = lappend_int(cagg_ids, cagg->data.mat_hypertable_id);
+	}
+
+	return cagg_ids;
+}
+
+static void
+cache_inval_entry_add_log_entry(const ContinuousAggsCacheInvalEntry *entry, List *cagg_ids,
+								const InvalidationRange *range)
+{
+	ListCell *lc;
+
+	if (cagg_ids == NIL)
+	{
+		invalidation_hyper_log_add_entry(entry->entry_id,
+										 range->lowest_modified_value,
+										 range->greatest_modified_value);
+		return;
+	}
+
+	foreach (lc, cagg_ids)
+		invalidation_partition_log_add_entry(lfirst_int(lc),
+											 range->lowest_modified_value,
+											 range->greatest_modified_value,
+											 entry->partition_range_start,
+											 entry->partition_range_end);
+}
+
 static void
 cache_inval_entry_write(ContinuousAggsCacheInvalEntry *entry)
 {
+	InvalidationRange single_range;
+	InvalidationRange *ranges = entry->ranges;
+	int num_ranges = entry->num_ranges;
 	int64 liv;
+	int i;
 
 	if (!entry->value_is_set)
 		return;
 
+	if (entry->max_ranges <= 1)
+	{
+		single_range.lowest_modified_value = entry->lowest_modified_value;
+		single_range.greatest_modified_value = entry->greatest_modified_value;
+		ranges = &single_range;
+		num_ranges = 1;
+	}
+
 	Cache *ht_cache = ts_hypertable_cache_pin();
 	Hypertable *ht = ts_hypertable_cache_get_entry_by_id(ht_cache, entry->hypertable_id);
 	bool is_distributed_member = hypertable_is_distributed_member(ht);
+	List *cagg_ids = cache_inval_entry_get_partition_caggs(entry, ht);
 	ts_cache_release(ht_cache);
 
 	/* The materialization worker uses a READ COMMITTED isolation level by default. Therefore, if we
@@ -309,18 +626,16 @@ cache_inval_entry_write(ContinuousAggsCacheInvalEntry *entry)
 	 */
 	if (IsolationUsesXactSnapshot() || is_distributed_member)
 	{
-		invalidation_hyper_log_add_entry(entry->entry_id,
-										 entry->lowest_modified_value,
-										 entry->greatest_modified_value);
+		for (i = 0; i < num_ranges; i++)
+			cache_inval_entry_add_log_entry(entry, cagg_ids, &ranges[i]);
 		return;
 	}
 
 	liv = get_lowest_invalidated_time_for_hypertable(entry->hypertable_relid);
 
-	if (entry->lowest_modified_value < liv)
-		invalidation_hyper_log_add_entry(entry->entry_id,
-										 entry->lowest_modified_value,
-										 entry->greatest_modified_value);
+	/* The ranges are sorted, so stop at the first one above the threshold */
+	for (i = 0; i < num_ranges && ranges[i].lowest_modified_value < liv; i++)
+		cache_inval_entry_add_log_entry(entry, cagg_ids, &ranges[i]);
 };
 
 static void
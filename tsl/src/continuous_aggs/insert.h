@@ -16,5 +16,10 @@ extern void execute_cagg_trigger(int32 hypertable_id, Relation chunk_rel, HeapTu
 								 HeapTuple chunk_newtuple, bool update,
 								 bool is_distributed_hypertable_trigger,
 								 int32 parent_hypertable_id);
+extern void continuous_agg_add_invalidation_range(int32 hypertable_id,
+												  bool is_distributed_hypertable_trigger,
+												  int32 parent_hypertable_id, Oid chunk_relid,
+												  int64 lowest_modified_value,
+												  int64 greatest_modified_value);
 
 #endif /* TIMESCALEDB_TSL_CONTINUOUS_AGGS_INSERT_H */
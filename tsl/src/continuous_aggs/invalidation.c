@@ -11,6 +11,9 @@
 #include <utils/tuplestore.h>
 #include <nodes/makefuncs.h>
 #include <nodes/memnodes.h>
+#include <optimizer/tlist.h>
+#include <parser/parsetree.h>
+#include <storage/lmgr.h>
 #include <storage/lockdefs.h>
 #include <access/htup_details.h>
 #include <access/htup.h>
@@ -26,6 +29,7 @@
 #include <utils.h>
 #include <time_utils.h>
 #include <time_bucket.h>
+#include <dimension.h>
 #include <hypertable_cache.h>
 
 #include "compat/compat.h"
@@ -65,6 +69,14 @@
  * Thus, invalidations are generated by mutations and are processed and used
  * as input for refreshing the a continuous aggregate.
  *
+ * With timescaledb.enable_cagg_partition_invalidation, mutations on a
+ * hypertable with a space dimension can instead add their invalidations
+ * directly to a per-cagg partition invalidation log
+ * [cagg_id, start, end, partition_start, partition_end], which also records
+ * the range of space partitions that was modified. This is only done when
+ * every continuous aggregate on the hypertable groups by the space column, so
+ * that a refresh can recompute only the groups of the modified partitions.
+ *
  * Invalidations can overlap or be duplicates. Therefore, invalidations are
  * merged during processing to reduce the number of entries in the logs. This
  * typically happens during a refresh of a continuous aggregate, which also
@@ -109,6 +121,7 @@ typedef enum LogType
 {
 	LOG_HYPER,
 	LOG_CAGG,
+	LOG_PARTITION,
 } LogType;
 
 static Relation
@@ -117,6 +130,7 @@ open_invalidation_log(LogType type, LOCKMODE lockmode)
 	static const CatalogTable logmappings[] = {
 		[LOG_HYPER] = CONTINUOUS_AGGS_HYPERTABLE_INVALIDATION_LOG,
 		[LOG_CAGG] = CONTINUOUS_AGGS_MATERIALIZATION_INVALIDATION_LOG,
+		[LOG_PARTITION] = CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
 	};
 	Catalog *catalog = ts_catalog_get();
 	Oid relid = catalog_get_table_id(catalog, logmappings[type]);
@@ -306,6 +320,108 @@ invalidation_hyper_log_add_entry(int32 hyper_id, int64 start, int64 end)
 		 end);
 }
 
+static HeapTuple
+create_partition_invalidation_tup(const TupleDesc tupdesc, int32 cagg_hyper_id, int64 start,
+								  int64 end, int64 partition_start, int64 partition_end)
+{
+	Datum values[Natts_continuous_aggs_partition_invalidation_log] = { 0 };
+	bool isnull[Natts_continuous_aggs_partition_invalidation_log] = { false };
+
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_partition_invalidation_log_materialization_id)] =
+		Int32GetDatum(cagg_hyper_id);
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_partition_invalidation_log_lowest_modified_value)] =
+		Int64GetDatum(start);
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_partition_invalidation_log_greatest_modified_value)] =
+		Int64GetDatum(end);
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_partition_invalidation_log_partition_range_start)] =
+		Int64GetDatum(partition_start);
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_partition_invalidation_log_partition_range_end)] =
+		Int64GetDatum(partition_end);
+
+	return heap_form_tuple(tupdesc, values, isnull);
+}
+
+/*
+ * Add an entry to the partition invalidation log of a continuous aggregate.
+ *
+ * The entry only invalidates the groups in the space partitions
+ * [partition_start, partition_end) of the raw hypertable.
+ */
+void
+invalidation_partition_log_add_entry(int32 cagg_hyper_id, int64 start, int64 end,
+									 int64 partition_start, int64 partition_end)
+{
+	Relation rel = open_invalidation_log(LOG_PARTITION, RowExclusiveLock);
+	CatalogSecurityContext sec_ctx;
+	HeapTuple tuple;
+
+	Assert(start <= end);
+	Assert(partition_start < partition_end);
+	tuple = create_partition_invalidation_tup(RelationGetDescr(rel),
+											  cagg_hyper_id,
+											  start,
+											  end,
+											  partition_start,
+											  partition_end);
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_catalog_insert_only(rel, tuple);
+	ts_catalog_restore_user(&sec_ctx);
+	heap_freetuple(tuple);
+	table_close(rel, NoLock);
+	elog(DEBUG1,
+		 "partition log for continuous aggregate %d added entry [" INT64_FORMAT ", " INT64_FORMAT
+		 "] in partitions [" INT64_FORMAT ", " INT64_FORMAT ")",
+		 cagg_hyper_id,
+		 start,
+		 end,
+		 partition_start,
+		 partition_end);
+}
+
+/*
+ * Get the column of a continuous aggregate that holds the values of a space
+ * dimension of its raw hypertable.
+ *
+ * Returns NULL unless the continuous aggregate is finalized and groups by the
+ * dimension column. Then every group, and every row of the materialized
+ * hypertable, belongs to a single space partition.
+ */
+const char *
+invalidation_get_partition_column(const ContinuousAgg *cagg, const Dimension *dim)
+{
+	Query *query;
+	ListCell *lc;
+
+	if (!ContinuousAggIsFinalized(cagg))
+		return NULL;
+
+	query = ts_continuous_agg_get_query((ContinuousAgg *) cagg);
+
+	foreach (lc, query->targetList)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+		Var *var = (Var *) tle->expr;
+		RangeTblEntry *rte;
+
+		if (tle->resjunk || tle->resname == NULL || !IsA(var, Var) || var->varlevelsup > 0 ||
+			get_sortgroupref_clause_noerr(tle->ressortgroupref, query->groupClause) == NULL)
+			continue;
+
+		rte = rt_fetch(var->varno, query->rtable);
+
+		if (rte->rtekind == RTE_RELATION && rte->relid == dim->main_table_relid &&
+			var->varattno == dim->column_attno)
+			return tle->resname;
+	}
+
+	return NULL;
+}
+
 /*
  * Invalidate one or more continuous aggregates.
  *
@@ -1089,6 +1205,373 @@ invalidation_process_hypertable_log(int32 mat_hypertable_id, int32 raw_hypertabl
 	invalidation_state_cleanup(&state);
 }
 
+static void
+hyper_log_update_merged_entry(Relation rel, const Invalidation *entry)
+{
+	Datum values[Natts_continuous_aggs_hypertable_invalidation_log];
+	bool nulls[Natts_continuous_aggs_hypertable_invalidation_log] = { false };
+	HeapTuple tuple;
+
+	if (!entry->is_modified)
+		return;
+
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_hypertable_invalidation_log_hypertable_id)] =
+		Int32GetDatum(entry->hyper_id);
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_hypertable_invalidation_log_lowest_modified_value)] =
+		Int64GetDatum(entry->lowest_modified_value);
+	values[AttrNumberGetAttrOffset(
+		Anum_continuous_aggs_hypertable_invalidation_log_greatest_modified_value)] =
+		Int64GetDatum(entry->greatest_modified_value);
+
+	tuple = heap_form_tuple(RelationGetDescr(rel), values, nulls);
+	ts_catalog_update_tid_only(rel, (ItemPointer) &entry->tid, tuple);
+	heap_freetuple(tuple);
+}
+
+/*
+ * Compact the hypertable invalidation log of a hypertable.
+ *
+ * Overlapping and adjacent entries are merged into the first of them, and
+ * the other entries are deleted. The entries keep the time values of the
+ * hypertable; they are expanded to the buckets of each continuous aggregate
+ * only when moved to the continuous aggregate invalidation log, which
+ * invalidates the same buckets whether the entries were merged before or
+ * not.
+ *
+ * Refreshes process the log while holding an AccessExclusiveLock on the
+ * invalidation threshold table. Taking a ShareUpdateExclusiveLock serializes
+ * the compaction with refreshes and other compactions, but not with the
+ * writers that read the threshold and add new entries. New entries are not
+ * visible to the snapshot and are left for the next compaction.
+ *
+ * Returns the number of entries deleted.
+ */
+int64
+invalidation_hyper_log_compact(int32 hyper_id)
+{
+	Catalog *catalog = ts_catalog_get();
+	CatalogSecurityContext sec_ctx;
+	Invalidation mergedentry;
+	ScanIterator iterator;
+	Snapshot snapshot;
+	Relation rel;
+	int64 num_deleted = 0;
+
+	LockRelationOid(catalog_get_table_id(catalog, CONTINUOUS_AGGS_INVALIDATION_THRESHOLD),
+					ShareUpdateExclusiveLock);
+
+	rel = open_invalidation_log(LOG_HYPER, RowExclusiveLock);
+	snapshot = RegisterSnapshot(GetTransactionSnapshot());
+	invalidation_entry_reset(&mergedentry);
+	hypertable_invalidation_scan_init(&iterator, hyper_id, RowExclusiveLock);
+	iterator.ctx.snapshot = snapshot;
+
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+
+	/* The scan is ordered on lowest_modified_value, which is what
+	 * invalidation_entry_try_merge() expects */
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		Invalidation logentry;
+
+		INVALIDATION_ENTRY_SET(&logentry,
+							   ti,
+							   hypertable_id,
+							   Form_continuous_aggs_hypertable_invalidation_log);
+
+		if (!IS_VALID_INVALIDATION(&mergedentry))
+			mergedentry = logentry;
+		else if (invalidation_entry_try_merge(&mergedentry, &logentry))
+		{
+			ts_catalog_delete_tid_only(rel, &logentry.tid);
+			num_deleted++;
+		}
+		else
+		{
+			hyper_log_update_merged_entry(rel, &mergedentry);
+			mergedentry = logentry;
+		}
+	}
+
+	ts_scan_iterator_close(&iterator);
+
+	if (IS_VALID_INVALIDATION(&mergedentry))
+		hyper_log_update_merged_entry(rel, &mergedentry);
+
+	ts_catalog_restore_user(&sec_ctx);
+	UnregisterSnapshot(snapshot);
+	table_close(rel, NoLock);
+
+	elog(DEBUG1,
+		 "hypertable log for hypertable %d compacted by " INT64_FORMAT " entries",
+		 hyper_id,
+		 num_deleted);
+
+	return num_deleted;
+}
+
+/*
+ * Add an invalidation to a list of partition invalidations, merging it with
+ * an invalidation of the same partitions if they overlap or are adjacent.
+ */
+static List *
+partition_invalidations_add(List *invalidations, const Invalidation *entry, int64 partition_start,
+							int64 partition_end)
+{
+	PartitionInvalidation *pinv;
+	ListCell *lc;
+
+	foreach (lc, invalidations)
+	{
+		Invalidation merged;
+
+		pinv = lfirst(lc);
+
+		if (pinv->partition_range_start != partition_start ||
+			pinv->partition_range_end != partition_end)
+			continue;
+
+		invalidation_entry_reset(&merged);
+		merged.hyper_id = entry->hyper_id;
+		merged.lowest_modified_value = pinv->lowest_modified_value;
+		merged.greatest_modified_value = pinv->greatest_modified_value;
+
+		if (!invalidations_can_be_merged(&merged, entry))
+			continue;
+
+		pinv->lowest_modified_value =
+			Min(pinv->lowest_modified_value, entry->lowest_modified_value);
+		pinv->greatest_modified_value =
+			Max(pinv->greatest_modified_value, entry->greatest_modified_value);
+		return invalidations;
+	}
+
+	pinv = palloc(sizeof(PartitionInvalidation));
+	pinv->lowest_modified_value = entry->lowest_modified_value;
+	pinv->greatest_modified_value = entry->greatest_modified_value;
+	pinv->partition_range_start = partition_start;
+	pinv->partition_range_end = partition_end;
+
+	return lappend(invalidations, pinv);
+}
+
+/*
+ * Process the partition invalidation log of a continuous aggregate.
+ *
+ * The entries are cut along the refresh window like the entries of the
+ * continuous aggregate invalidation log: the parts outside of the window
+ * stay in the log and the parts within the window are removed and returned
+ * as a list of PartitionInvalidation. The returned invalidations are
+ * expanded to bucket boundaries, and the ones in the same partitions are
+ * merged.
+ */
+List *
+invalidation_process_partition_log(int32 mat_hypertable_id,
+								   const InternalTimeRange *refresh_window, int64 bucket_width,
+								   const ContinuousAggsBucketFunction *bucket_function)
+{
+	Relation rel = open_invalidation_log(LOG_PARTITION, RowExclusiveLock);
+	TupleDesc tupdesc = RelationGetDescr(rel);
+	Snapshot snapshot = RegisterSnapshot(GetTransactionSnapshot());
+	CatalogSecurityContext sec_ctx;
+	ScanIterator iterator;
+	List *invalidations = NIL;
+
+	iterator = ts_scan_iterator_create(CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
+									   RowExclusiveLock,
+									   CurrentMemoryContext);
+	iterator.ctx.index = catalog_get_index(ts_catalog_get(),
+										   CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
+										   CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_IDX);
+	iterator.ctx.snapshot = snapshot;
+	ts_scan_iterator_scan_key_init(
+		&iterator,
+		Anum_continuous_aggs_partition_invalidation_log_idx_materialization_id,
+		BTEqualStrategyNumber,
+		F_INT4EQ,
+		Int32GetDatum(mat_hypertable_id));
+
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool should_free;
+		HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+		Form_continuous_aggs_partition_invalidation_log form =
+			(Form_continuous_aggs_partition_invalidation_log) GETSTRUCT(tuple);
+		HeapTuple lower = NULL;
+		HeapTuple upper = NULL;
+		Invalidation entry;
+
+		/* Invalidations are inclusive while the window is exclusive at the end */
+		if (form->greatest_modified_value >= refresh_window->start &&
+			form->lowest_modified_value < refresh_window->end)
+		{
+			if (form->lowest_modified_value < refresh_window->start)
+				lower = create_partition_invalidation_tup(tupdesc,
+														  mat_hypertable_id,
+														  form->lowest_modified_value,
+														  refresh_window->start - 1,
+														  form->partition_range_start,
+														  form->partition_range_end);
+
+			if (form->greatest_modified_value >= refresh_window->end)
+				upper = create_partition_invalidation_tup(tupdesc,
+														  mat_hypertable_id,
+														  refresh_window->end,
+														  form->greatest_modified_value,
+														  form->partition_range_start,
+														  form->partition_range_end);
+
+			/* Keep the parts outside of the window in the log */
+			if (lower != NULL || upper != NULL)
+				ts_catalog_update_tid_only(rel, &tuple->t_self, lower != NULL ? lower : upper);
+			else
+				ts_catalog_delete_tid_only(rel, &tuple->t_self);
+
+			if (lower != NULL && upper != NULL)
+				ts_catalog_insert_only(rel, upper);
+
+			if (lower != NULL)
+				heap_freetuple(lower);
+			if (upper != NULL)
+				heap_freetuple(upper);
+
+			invalidation_entry_reset(&entry);
+			entry.hyper_id = mat_hypertable_id;
+			entry.lowest_modified_value =
+				Max(form->lowest_modified_value, refresh_window->start);
+			entry.greatest_modified_value =
+				Min(form->greatest_modified_value, refresh_window->end - 1);
+			invalidation_expand_to_bucket_boundaries(&entry,
+													 refresh_window->type,
+													 bucket_width,
+													 bucket_function);
+			invalidations = partition_invalidations_add(invalidations,
+														&entry,
+														form->partition_range_start,
+														form->partition_range_end);
+		}
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+
+	ts_scan_iterator_close(&iterator);
+	ts_catalog_restore_user(&sec_ctx);
+	UnregisterSnapshot(snapshot);
+	table_close(rel, NoLock);
+
+	return invalidations;
+}
+
+static List *
+pending_ranges_add(List *ranges, const InternalTimeRange *window, int64 lowest_modified_value,
+				   int64 greatest_modified_value)
+{
+	InternalTimeRange *range;
+
+	/* Invalidations are inclusive while the window is exclusive at the end */
+	if (greatest_modified_value < window->start || lowest_modified_value >= window->end)
+		return ranges;
+
+	range = palloc(sizeof(InternalTimeRange));
+	range->type = window->type;
+	range->start = Max(lowest_modified_value, window->start);
+	range->end = greatest_modified_value >= window->end ? window->end : greatest_modified_value + 1;
+
+	return lappend(ranges, range);
+}
+
+/*
+ * Get the invalidated ranges of a continuous aggregate within a window,
+ * without processing them. The ranges come from the hypertable log of the
+ * raw hypertable, which is not yet moved to the continuous aggregates, and
+ * the continuous aggregate's own logs. They are clipped to the window, have
+ * exclusive ends and are neither sorted nor merged.
+ */
+List *
+invalidation_get_pending_ranges(int32 mat_hypertable_id, int32 raw_hypertable_id,
+								const InternalTimeRange *window)
+{
+	ScanIterator iterator;
+	List *ranges = NIL;
+
+	hypertable_invalidation_scan_init(&iterator, raw_hypertable_id, AccessShareLock);
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool should_free;
+		HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+		Form_continuous_aggs_hypertable_invalidation_log form =
+			(Form_continuous_aggs_hypertable_invalidation_log) GETSTRUCT(tuple);
+
+		ranges = pending_ranges_add(ranges,
+									window,
+									form->lowest_modified_value,
+									form->greatest_modified_value);
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	ts_scan_iterator_close(&iterator);
+
+	cagg_invalidations_scan_by_hypertable_init(&iterator, mat_hypertable_id, AccessShareLock);
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool should_free;
+		HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+		Form_continuous_aggs_materialization_invalidation_log form =
+			(Form_continuous_aggs_materialization_invalidation_log) GETSTRUCT(tuple);
+
+		ranges = pending_ranges_add(ranges,
+									window,
+									form->lowest_modified_value,
+									form->greatest_modified_value);
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	ts_scan_iterator_close(&iterator);
+
+	iterator = ts_scan_iterator_create(CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
+									   AccessShareLock,
+									   CurrentMemoryContext);
+	iterator.ctx.index = catalog_get_index(ts_catalog_get(),
+										   CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG,
+										   CONTINUOUS_AGGS_PARTITION_INVALIDATION_LOG_IDX);
+	ts_scan_iterator_scan_key_init(
+		&iterator,
+		Anum_continuous_aggs_partition_invalidation_log_idx_materialization_id,
+		BTEqualStrategyNumber,
+		F_INT4EQ,
+		Int32GetDatum(mat_hypertable_id));
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		bool should_free;
+		HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
+		Form_continuous_aggs_partition_invalidation_log form =
+			(Form_continuous_aggs_partition_invalidation_log) GETSTRUCT(tuple);
+
+		ranges = pending_ranges_add(ranges,
+									window,
+									form->lowest_modified_value,
+									form->greatest_modified_value);
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	ts_scan_iterator_close(&iterator);
+
+	return ranges;
+}
+
 /*
  * Generates the default bucket_functions[] argument for the following functions:
  *
@@ -26,6 +26,19 @@ typedef struct Invalidation
 	ItemPointerData tid;
 } Invalidation;
 
+/*
+ * An invalidation of the groups in a range of space partitions of the raw
+ * hypertable. The partition range is exclusive at the end, like the range of
+ * a dimension slice.
+ */
+typedef struct PartitionInvalidation
+{
+	int64 lowest_modified_value;
+	int64 greatest_modified_value;
+	int64 partition_range_start;
+	int64 partition_range_end;
+} PartitionInvalidation;
+
 #define INVAL_NEG_INFINITY PG_INT64_MIN
 #define INVAL_POS_INFINITY PG_INT64_MAX
 
@@ -36,9 +49,14 @@ typedef struct InvalidationStore
 } InvalidationStore;
 
 typedef struct Hypertable Hypertable;
+typedef struct Dimension Dimension;
 
 extern void invalidation_cagg_log_add_entry(int32 cagg_hyper_id, int64 start, int64 end);
 extern void invalidation_hyper_log_add_entry(int32 hyper_id, int64 start, int64 end);
+extern void invalidation_partition_log_add_entry(int32 cagg_hyper_id, int64 start, int64 end,
+												 int64 partition_start, int64 partition_end);
+extern const char *invalidation_get_partition_column(const ContinuousAgg *cagg,
+													 const Dimension *dim);
 extern void continuous_agg_invalidate_raw_ht(const Hypertable *raw_ht, int64 start, int64 end);
 extern void continuous_agg_invalidate_mat_ht(const Hypertable *raw_ht, const Hypertable *mat_ht,
 											 int64 start, int64 end);
@@ -55,6 +73,12 @@ extern void remote_invalidation_process_hypertable_log(int32 mat_hypertable_id,
 													   int32 raw_hypertable_id, Oid dimtype,
 													   const CaggsInfo *all_caggs);
 extern Datum tsl_invalidation_process_hypertable_log(PG_FUNCTION_ARGS);
+extern int64 invalidation_hyper_log_compact(int32 hyper_id);
+extern List *invalidation_process_partition_log(
+	int32 mat_hypertable_id, const InternalTimeRange *refresh_window, int64 bucket_width,
+	const ContinuousAggsBucketFunction *bucket_function);
+extern List *invalidation_get_pending_ranges(int32 mat_hypertable_id, int32 raw_hypertable_id,
+											 const InternalTimeRange *window);
 
 extern InvalidationStore *invalidation_process_cagg_log(
 	int32 mat_hypertable_id, int32 raw_hypertable_id, const InternalTimeRange *refresh_window,
@@ -189,10 +189,13 @@ invalidation_threshold_tuple_found(TupleInfo *ti, void *data)
 	return SCAN_CONTINUE;
 }
 
-int64
-invalidation_threshold_get(int32 hypertable_id)
+/*
+ * Find the invalidation threshold of a hypertable. A hypertable has no
+ * threshold until one of its continuous aggregates is refreshed.
+ */
+bool
+invalidation_threshold_find(int32 hypertable_id, int64 *threshold)
 {
-	int64 threshold = 0;
 	ScanKeyData scankey[1];
 
 	ScanKeyInit(&scankey[0],
@@ -201,14 +204,22 @@ invalidation_threshold_get(int32 hypertable_id)
 				F_INT4EQ,
 				Int32GetDatum(hypertable_id));
 
-	if (!ts_catalog_scan_one(CONTINUOUS_AGGS_INVALIDATION_THRESHOLD /*=table*/,
-							 CONTINUOUS_AGGS_INVALIDATION_THRESHOLD_PKEY /*=indexid*/,
-							 scankey /*=scankey*/,
-							 1 /*=num_keys*/,
-							 invalidation_threshold_tuple_found /*=tuple_found*/,
-							 AccessShareLock /*=lockmode*/,
-							 CONTINUOUS_AGGS_INVALIDATION_THRESHOLD_TABLE_NAME /*=table_name*/,
-							 &threshold /*=data*/))
+	return ts_catalog_scan_one(CONTINUOUS_AGGS_INVALIDATION_THRESHOLD /*=table*/,
+							   CONTINUOUS_AGGS_INVALIDATION_THRESHOLD_PKEY /*=indexid*/,
+							   scankey /*=scankey*/,
+							   1 /*=num_keys*/,
+							   invalidation_threshold_tuple_found /*=tuple_found*/,
+							   AccessShareLock /*=lockmode*/,
+							   CONTINUOUS_AGGS_INVALIDATION_THRESHOLD_TABLE_NAME /*=table_name*/,
+							   threshold /*=data*/);
+}
+
+int64
+invalidation_threshold_get(int32 hypertable_id)
+{
+	int64 threshold = 0;
+
+	if (!invalidation_threshold_find(hypertable_id, &threshold))
 		elog(ERROR, "could not find invalidation threshold for hypertable %d", hypertable_id);
 
 	return threshold;
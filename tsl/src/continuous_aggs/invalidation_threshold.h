@@ -11,6 +11,7 @@
 typedef struct InternalTimeRange InternalTimeRange;
 typedef struct ContinuousAgg ContinuousAgg;
 
+extern bool invalidation_threshold_find(int32 hypertable_id, int64 *threshold);
 extern int64 invalidation_threshold_get(int32 hypertable_id);
 extern int64 invalidation_threshold_set_or_get(int32 raw_hypertable_id,
 											   int64 invalidation_threshold);
@@ -19,6 +19,8 @@
 #include "ts_catalog/continuous_agg.h"
 #include <time_utils.h>
 
+#include "bgw/job_history.h"
+#include "guc.h"
 #include "materialize.h"
 
 static bool ranges_overlap(InternalTimeRange invalidation_range,
@@ -35,7 +37,8 @@ static Datum internal_to_time_value_or_infinite(int64 internal, Oid time_type,
 static void spi_update_materializations(SchemaAndName partial_view,
 										SchemaAndName materialization_table,
 										const NameData *time_column_name,
-										TimeRange invalidation_range, const int32 chunk_id);
+										TimeRange invalidation_range,
+										const char *const chunk_condition);
 static void spi_delete_materializations(SchemaAndName materialization_table,
 										const NameData *time_column_name,
 										TimeRange invalidation_range,
@@ -45,20 +48,43 @@ static void spi_insert_materializations(SchemaAndName partial_view,
 										const NameData *time_column_name,
 										TimeRange materialization_range,
 										const char *const chunk_condition);
+static void spi_merge_materializations(SchemaAndName partial_view,
+									   SchemaAndName materialization_table,
+									   const NameData *time_column_name,
+									   TimeRange materialization_range,
+									   const char *const chunk_condition);
 
 void
 continuous_agg_update_materialization(SchemaAndName partial_view,
 									  SchemaAndName materialization_table,
 									  const NameData *time_column_name,
 									  InternalTimeRange new_materialization_range,
-									  InternalTimeRange invalidation_range, int32 chunk_id)
+									  InternalTimeRange invalidation_range, int32 chunk_id,
+									  const char *partition_condition)
 {
 	InternalTimeRange combined_materialization_range = new_materialization_range;
 	bool materialize_invalidations_separately = range_length(invalidation_range) > 0;
+	StringInfo chunk_condition = makeStringInfo();
 	int res = SPI_connect();
 	if (res != SPI_OK_CONNECT)
 		elog(ERROR, "could not connect to SPI in materializer");
 
+	/*
+	 * chunk_id is valid if the materializaion update should be done only on the given chunk.
+	 * This is used currently for refresh on chunk drop only. In other cases, manual
+	 * call to refresh_continuous_aggregate or call from a refresh policy, chunk_id is
+	 * not provided, i.e., invalid.
+	 */
+	if (chunk_id != INVALID_CHUNK_ID)
+		appendStringInfo(chunk_condition, "AND chunk_id = %d", chunk_id);
+
+	/*
+	 * partition_condition restricts the update to the groups of some space
+	 * partitions when refreshing partition invalidations.
+	 */
+	if (partition_condition != NULL)
+		appendStringInfo(chunk_condition, " %s", partition_condition);
+
 	/* pin the start of new_materialization to the end of new_materialization,
 	 * we are not allowed to materialize beyond that point
 	 */
@@ -97,7 +123,7 @@ continuous_agg_update_materialization(SchemaAndName partial_view,
 									time_column_name,
 									internal_time_range_to_time_range(
 										combined_materialization_range),
-									chunk_id);
+									chunk_condition->data);
 	}
 	else
 	{
@@ -105,19 +131,63 @@ continuous_agg_update_materialization(SchemaAndName partial_view,
 									materialization_table,
 									time_column_name,
 									internal_time_range_to_time_range(invalidation_range),
-									chunk_id);
+									chunk_condition->data);
 
 		spi_update_materializations(partial_view,
 									materialization_table,
 									time_column_name,
 									internal_time_range_to_time_range(new_materialization_range),
-									chunk_id);
+									chunk_condition->data);
 	}
 
 	if ((res = SPI_finish()) != SPI_OK_FINISH)
 		elog(ERROR, "SPI_finish failed: %s", SPI_result_code_string(res));
 }
 
+/*
+ * Update the materializations of the given chunks in the range.
+ *
+ * This is for continuous aggregates that materialize partials per chunk. The
+ * finalization combines the partials of the chunks of a bucket, so
+ * recomputing the partials of the chunks that changed is enough to bring the
+ * buckets up to date.
+ */
+void
+continuous_agg_update_materialization_chunks(SchemaAndName partial_view,
+											 SchemaAndName materialization_table,
+											 const NameData *time_column_name,
+											 InternalTimeRange materialization_range,
+											 List *chunk_ids)
+{
+	StringInfo chunk_condition = makeStringInfo();
+	ListCell *lc;
+	int res;
+
+	Assert(chunk_ids != NIL);
+
+	appendStringInfoString(chunk_condition, "AND chunk_id = ANY('{");
+	foreach (lc, chunk_ids)
+	{
+		if (lc != list_head(chunk_ids))
+			appendStringInfoChar(chunk_condition, ',');
+		appendStringInfo(chunk_condition, "%d", lfirst_int(lc));
+	}
+	appendStringInfoString(chunk_condition, "}'::integer[])");
+
+	res = SPI_connect();
+	if (res != SPI_OK_CONNECT)
+		elog(ERROR, "could not connect to SPI in materializer");
+
+	spi_update_materializations(partial_view,
+								materialization_table,
+								time_column_name,
+								internal_time_range_to_time_range(materialization_range),
+								chunk_condition->data);
+
+	if ((res = SPI_finish()) != SPI_OK_FINISH)
+		elog(ERROR, "SPI_finish failed: %s", SPI_result_code_string(res));
+}
+
 static bool
 ranges_overlap(InternalTimeRange invalidation_range, InternalTimeRange new_materialization_range)
 {
@@ -209,28 +279,27 @@ internal_time_range_to_time_range(InternalTimeRange internal)
 static void
 spi_update_materializations(SchemaAndName partial_view, SchemaAndName materialization_table,
 							const NameData *time_column_name, TimeRange invalidation_range,
-							const int32 chunk_id)
+							const char *const chunk_condition)
 {
-	StringInfo chunk_condition = makeStringInfo();
-
-	/*
-	 * chunk_id is valid if the materializaion update should be done only on the given chunk.
-	 * This is used currently for refresh on chunk drop only. In other cases, manual
-	 * call to refresh_continuous_aggregate or call from a refresh policy, chunk_id is
-	 * not provided, i.e., invalid.
-	 */
-	if (chunk_id != INVALID_CHUNK_ID)
-		appendStringInfo(chunk_condition, "AND chunk_id = %d", chunk_id);
+	if (ts_guc_enable_cagg_diff_materialization)
+	{
+		spi_merge_materializations(partial_view,
+								   materialization_table,
+								   time_column_name,
+								   invalidation_range,
+								   chunk_condition);
+		return;
+	}
 
 	spi_delete_materializations(materialization_table,
 								time_column_name,
 								invalidation_range,
-								chunk_condition->data);
+								chunk_condition);
 	spi_insert_materializations(partial_view,
 								materialization_table,
 								time_column_name,
 								invalidation_range,
-								chunk_condition->data);
+								chunk_condition);
 }
 
 static void
@@ -309,4 +378,84 @@ spi_insert_materializations(SchemaAndName partial_view, SchemaAndName materializ
 
 	if (res < 0)
 		elog(ERROR, "could not materialize values into the materialization table");
+
+	ts_job_history_add_rows(SPI_processed);
+}
+
+/*
+ * Update the materializations in the range in a single statement that only
+ * deletes the materialized rows that changed and only inserts the new or
+ * changed rows of the partial view, which is computed once. The rows are
+ * compared by their binary image with the *= operator, which works for every
+ * column type, also those without an equality operator, and unlike their
+ * text representation doesn't depend on settings like extra_float_digits.
+ * Unchanged rows are left alone, so refreshing a range where little changed
+ * writes little.
+ *
+ * All parts of the statement see the same snapshot, so the INSERT compares
+ * against the rows as they were before the DELETE.
+ */
+static void
+spi_merge_materializations(SchemaAndName partial_view, SchemaAndName materialization_table,
+						   const NameData *time_column_name, TimeRange materialization_range,
+						   const char *const chunk_condition)
+{
+	int res;
+	StringInfo command = makeStringInfo();
+	Oid out_fn;
+	bool type_is_varlena;
+	char *materialization_start;
+	char *materialization_end;
+	const char *mat_table;
+	const char *time_column = quote_identifier(NameStr(*time_column_name));
+
+	getTypeOutputInfo(materialization_range.type, &out_fn, &type_is_varlena);
+	materialization_start =
+		quote_literal_cstr(OidOutputFunctionCall(out_fn, materialization_range.start));
+	materialization_end =
+		quote_literal_cstr(OidOutputFunctionCall(out_fn, materialization_range.end));
+	mat_table = quote_qualified_identifier(NameStr(*materialization_table.schema),
+										   NameStr(*materialization_table.name));
+
+	appendStringInfo(command,
+					 "WITH I AS MATERIALIZED ("
+					 "SELECT * FROM %s AS I WHERE I.%s >= %s AND I.%s < %s %s), "
+					 "D AS (DELETE FROM %s AS D WHERE D.%s >= %s AND D.%s < %s %s "
+					 "AND NOT EXISTS (SELECT FROM I WHERE I *= D)) "
+					 "INSERT INTO %s SELECT * FROM I WHERE NOT EXISTS ("
+					 "SELECT FROM %s AS D WHERE D.%s >= %s AND D.%s < %s %s "
+					 "AND D *= I);",
+					 quote_qualified_identifier(NameStr(*partial_view.schema),
+												NameStr(*partial_view.name)),
+					 time_column,
+					 materialization_start,
+					 time_column,
+					 materialization_end,
+					 chunk_condition,
+					 mat_table,
+					 time_column,
+					 materialization_start,
+					 time_column,
+					 materialization_end,
+					 chunk_condition,
+					 mat_table,
+					 mat_table,
+					 time_column,
+					 materialization_start,
+					 time_column,
+					 materialization_end,
+					 chunk_condition);
+
+	res = SPI_execute_with_args(command->data,
+								0 /*=nargs*/,
+								NULL /*=argtypes*/,
+								NULL /*=Values*/,
+								NULL /*=Nulls*/,
+								false /*=read_only*/,
+								0 /*count*/);
+
+	if (res < 0)
+		elog(ERROR, "could not materialize values into the materialization table");
+
+	ts_job_history_add_rows(SPI_processed);
 }
@@ -16,9 +16,12 @@
 #include <fmgr.h>
 #include <executor/spi.h>
 
+#include "bgw_policy/continuous_aggregate_api.h"
 #include "ts_catalog/catalog.h"
 #include "ts_catalog/continuous_agg.h"
+#include <chunk.h>
 #include <dimension.h>
+#include <dimension_slice.h>
 #include <hypertable.h>
 #include <hypertable_cache.h>
 #include <time_bucket.h>
@@ -30,6 +33,8 @@
 #include "invalidation.h"
 #include "invalidation_threshold.h"
 #include "guc.h"
+#include "compression/api.h"
+#include "nodes/compress_dml/compress_dml.h"
 
 typedef struct CaggRefreshState
 {
@@ -37,6 +42,12 @@ typedef struct CaggRefreshState
 	Hypertable *cagg_ht;
 	InternalTimeRange refresh_window;
 	SchemaAndName partial_view;
+	/* Only recompute the partials of the chunks that overlap invalidations */
+	bool incremental;
+	/* Decompress the batches of compressed materialization chunks in the range */
+	bool decompress;
+	/* Only recompute the groups of some space partitions, if not NULL */
+	const char *partition_condition;
 } CaggRefreshState;
 
 static Hypertable *
@@ -274,7 +285,8 @@ continuous_agg_refresh_execute(const CaggRefreshState *refresh,
 										  &time_dim->fd.column_name,
 										  *bucketed_refresh_window,
 										  unused_invalidation_range,
-										  chunk_id);
+										  chunk_id,
+										  refresh->partition_condition);
 }
 
 static void
@@ -346,12 +358,154 @@ materialization_per_refresh_window(void)
 	return max_materializations;
 }
 
-typedef void (*scan_refresh_ranges_funct_t)(const InternalTimeRange *bucketed_refresh_window,
+typedef void (*scan_refresh_ranges_funct_t)(const InternalTimeRange *invalidation,
+											const InternalTimeRange *bucketed_refresh_window,
 											const long iteration, /* 0 is first range */
 											void *arg1, void *arg2);
 
+/*
+ * Refresh the buckets of an invalidation by only recomputing the partials of
+ * the raw hypertable chunks that overlap the invalidated range.
+ *
+ * The materialization stores partials per chunk and the finalization
+ * combines them, so the partials of chunks outside of the invalidated range
+ * are still valid. A bucket that spans many chunks, like the latest bucket
+ * that data is appended to, then only rereads the chunks that changed
+ * instead of the whole bucket. Chunks that were dropped are included, which
+ * removes their partials.
+ *
+ * Returns false if no chunk overlaps the invalidated range, in which case
+ * the buckets should be refreshed as a whole.
+ */
+static bool
+continuous_agg_refresh_execute_incremental(const CaggRefreshState *refresh,
+										   const InternalTimeRange *invalidation,
+										   const InternalTimeRange *bucketed_refresh_window)
+{
+	const Hypertable *raw_ht = cagg_get_hypertable_or_fail(refresh->cagg.data.raw_hypertable_id);
+	SchemaAndName cagg_hypertable_name = {
+		.schema = &refresh->cagg_ht->fd.schema_name,
+		.name = &refresh->cagg_ht->fd.table_name,
+	};
+	const Dimension *time_dim = hyperspace_get_open_dimension(refresh->cagg_ht->space, 0);
+	List *chunk_ids =
+		ts_chunk_get_chunk_ids_in_time_range(raw_ht, invalidation->start, invalidation->end);
+
+	if (chunk_ids == NIL)
+		return false;
+
+	elog(DEBUG1,
+		 "refreshing %d chunks of continuous aggregate \"%s\" incrementally",
+		 list_length(chunk_ids),
+		 NameStr(refresh->cagg.data.user_view_name));
+
+	continuous_agg_update_materialization_chunks(refresh->partial_view,
+												 cagg_hypertable_name,
+												 &time_dim->fd.column_name,
+												 *bucketed_refresh_window,
+												 chunk_ids);
+	return true;
+}
+
+/*
+ * Decompress the batches of the compressed materialization chunks that
+ * overlap the refreshed range, so that the materialization can modify the
+ * rows in the range. Batches outside of the range stay compressed, and the
+ * chunks are recompressed by the next recompression.
+ *
+ * Returns the relids of the compressed chunks in the range.
+ */
+static List *
+continuous_agg_decompress_refresh_window(const CaggRefreshState *refresh,
+										 const InternalTimeRange *bucketed_refresh_window)
+{
+	List *chunk_ids = ts_chunk_get_chunk_ids_in_time_range(refresh->cagg_ht,
+														   bucketed_refresh_window->start,
+														   bucketed_refresh_window->end);
+	List *chunk_relids = NIL;
+	ListCell *lc;
+
+	foreach (lc, chunk_ids)
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+
+		if (chunk == NULL || chunk->fd.dropped || !ts_chunk_is_compressed(chunk))
+			continue;
+
+		if (decompress_chunk_range(chunk,
+								   bucketed_refresh_window->start,
+								   bucketed_refresh_window->end))
+			elog(DEBUG1,
+				 "decompressed refresh window of chunk \"%s\" of continuous aggregate \"%s\"",
+				 get_rel_name(chunk->table_id),
+				 NameStr(refresh->cagg.data.user_view_name));
+
+		chunk_relids = lappend_oid(chunk_relids, chunk->table_id);
+	}
+
+	return chunk_relids;
+}
+
+/*
+ * Materialize a bucketed range. The invalidation is NULL when refreshing the
+ * merged range of all invalidations.
+ */
 static void
-continuous_agg_refresh_execute_wrapper(const InternalTimeRange *bucketed_refresh_window,
+continuous_agg_refresh_execute_range(const CaggRefreshState *refresh,
+									 const InternalTimeRange *invalidation,
+									 const InternalTimeRange *bucketed_refresh_window,
+									 const int32 chunk_id)
+{
+	if (refresh->incremental && invalidation != NULL &&
+		continuous_agg_refresh_execute_incremental(refresh, invalidation, bucketed_refresh_window))
+		return;
+
+	continuous_agg_refresh_execute(refresh, bucketed_refresh_window, chunk_id);
+}
+
+static void
+continuous_agg_refresh_execute_decompressed(const CaggRefreshState *refresh,
+											const InternalTimeRange *invalidation,
+											const InternalTimeRange *bucketed_refresh_window,
+											const int32 chunk_id)
+{
+	List *decompressed_chunks = NIL;
+
+	if (refresh->decompress)
+		decompressed_chunks =
+			continuous_agg_decompress_refresh_window(refresh, bucketed_refresh_window);
+
+	if (decompressed_chunks == NIL)
+	{
+		continuous_agg_refresh_execute_range(refresh,
+											 invalidation,
+											 bucketed_refresh_window,
+											 chunk_id);
+		return;
+	}
+
+	/* Let the materialization modify the decompressed range of the chunks */
+	PG_TRY();
+	{
+		compress_chunk_dml_set_decompressed_chunks(decompressed_chunks);
+		continuous_agg_refresh_execute_range(refresh,
+											 invalidation,
+											 bucketed_refresh_window,
+											 chunk_id);
+	}
+	PG_CATCH();
+	{
+		compress_chunk_dml_set_decompressed_chunks(NIL);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	compress_chunk_dml_set_decompressed_chunks(NIL);
+}
+
+static void
+continuous_agg_refresh_execute_wrapper(const InternalTimeRange *invalidation,
+									   const InternalTimeRange *bucketed_refresh_window,
 									   const long iteration, void *arg1_refresh,
 									   void *arg2_chunk_id)
 {
@@ -360,14 +514,19 @@ continuous_agg_refresh_execute_wrapper(const InternalTimeRange *bucketed_refresh
 	(void) iteration;
 
 	log_refresh_window(DEBUG1, &refresh->cagg, bucketed_refresh_window, "invalidation refresh on");
-	continuous_agg_refresh_execute(refresh, bucketed_refresh_window, chunk_id);
+	continuous_agg_refresh_execute_decompressed(refresh,
+												invalidation,
+												bucketed_refresh_window,
+												chunk_id);
 }
 
 static void
-update_merged_refresh_window(const InternalTimeRange *bucketed_refresh_window, const long iteration,
+update_merged_refresh_window(const InternalTimeRange *invalidation,
+							 const InternalTimeRange *bucketed_refresh_window, const long iteration,
 							 void *arg1_merged_refresh_window, void *arg2)
 {
 	InternalTimeRange *merged_refresh_window = (InternalTimeRange *) arg1_merged_refresh_window;
+	(void) invalidation;
 	(void) arg2;
 
 	if (iteration == 0)
@@ -382,6 +541,21 @@ update_merged_refresh_window(const InternalTimeRange *bucketed_refresh_window, c
 	}
 }
 
+static void
+collect_refresh_window(const InternalTimeRange *invalidation,
+					   const InternalTimeRange *bucketed_refresh_window, const long iteration,
+					   void *arg1_windows, void *arg2)
+{
+	List **windows = (List **) arg1_windows;
+	InternalTimeRange *window = palloc(sizeof(InternalTimeRange));
+	(void) invalidation;
+	(void) iteration;
+	(void) arg2;
+
+	*window = *bucketed_refresh_window;
+	*windows = lappend(*windows, window);
+}
+
 static long
 continuous_agg_scan_refresh_window_ranges(const InternalTimeRange *refresh_window,
 										  const InvalidationStore *invalidations,
@@ -422,7 +596,7 @@ continuous_agg_scan_refresh_window_ranges(const InternalTimeRange *refresh_windo
 														  bucket_width,
 														  bucket_function);
 
-		(*exec_func)(&bucketed_refresh_window, count, func_arg1, func_arg2);
+		(*exec_func)(&invalidation, &bucketed_refresh_window, count, func_arg1, func_arg2);
 
 		count++;
 	}
@@ -432,6 +606,311 @@ continuous_agg_scan_refresh_window_ranges(const InternalTimeRange *refresh_windo
 	return count;
 }
 
+/*
+ * Split the refresh windows into at most max_windows windows for refresh
+ * jobs.
+ *
+ * A single (merged) window is split into parts with the same number of
+ * buckets. When there are more windows than jobs, consecutive windows are
+ * joined, which also refreshes the valid buckets between them.
+ */
+static List *
+split_refresh_windows(List *windows, int64 bucket_width, int max_windows)
+{
+	List *result = NIL;
+	ListCell *lc;
+	int num_windows = list_length(windows);
+
+	if (num_windows == 1)
+	{
+		InternalTimeRange *window = linitial(windows);
+		int64 num_buckets;
+		int64 buckets_per_window;
+		int64 start = window->start;
+
+		/* Windows open towards the start or end of time are not split */
+		if (window->start <= ts_time_get_min(window->type) ||
+			window->end >= ts_time_get_end_or_max(window->type))
+			return windows;
+
+		num_buckets = (int64) (((uint64) window->end - (uint64) window->start) / bucket_width);
+		if (num_buckets <= 1)
+			return windows;
+
+		buckets_per_window = (num_buckets + max_windows - 1) / max_windows;
+
+		while (start < window->end)
+		{
+			InternalTimeRange *part = palloc(sizeof(InternalTimeRange));
+
+			part->type = window->type;
+			part->start = start;
+			part->end =
+				ts_time_saturating_add(start, buckets_per_window * bucket_width, window->type);
+			if (part->end > window->end)
+				part->end = window->end;
+			result = lappend(result, part);
+			start = part->end;
+		}
+
+		return result;
+	}
+
+	if (num_windows <= max_windows)
+		return windows;
+
+	/* Windows are sorted by their start, join each run of consecutive ones */
+	for (int i = 0; i < max_windows; i++)
+	{
+		int first = (int) ((int64) i * num_windows / max_windows);
+		int last = (int) ((int64) (i + 1) * num_windows / max_windows) - 1;
+		InternalTimeRange *part = palloc(sizeof(InternalTimeRange));
+
+		*part = *((InternalTimeRange *) list_nth(windows, first));
+		for (int j = first + 1; j <= last; j++)
+		{
+			InternalTimeRange *window = list_nth(windows, j);
+
+			part->start = Min(part->start, window->start);
+			part->end = Max(part->end, window->end);
+		}
+		result = lappend(result, part);
+	}
+
+	foreach (lc, windows)
+		pfree(lfirst(lc));
+
+	return result;
+}
+
+/*
+ * Hand the materialization of the refresh windows over to refresh jobs
+ * instead of materializing them in this transaction, so that background
+ * workers can materialize them in parallel.
+ *
+ * The jobs are added in the same transaction that removes the invalidations
+ * from the continuous aggregate invalidation log, so the invalidated ranges
+ * are either still in the log or in a job. Failing jobs are retried by the
+ * scheduler. The invalidation threshold was already moved by the first
+ * transaction of the refresh and is not affected.
+ */
+static void
+continuous_agg_schedule_refresh_jobs(const ContinuousAgg *cagg,
+									 const InternalTimeRange *refresh_window,
+									 const InvalidationStore *invalidations,
+									 const int64 bucket_width, const bool do_merged_refresh,
+									 const InternalTimeRange merged_refresh_window)
+{
+	List *windows = NIL;
+	ListCell *lc;
+
+	if (do_merged_refresh)
+	{
+		InternalTimeRange *window = palloc(sizeof(InternalTimeRange));
+
+		*window = merged_refresh_window;
+		windows = list_make1(window);
+	}
+	else
+		continuous_agg_scan_refresh_window_ranges(refresh_window,
+												  invalidations,
+												  bucket_width,
+												  cagg->bucket_function,
+												  collect_refresh_window,
+												  (void *) &windows,
+												  NULL);
+
+	windows = split_refresh_windows(windows, bucket_width, ts_guc_cagg_refresh_parallel_jobs);
+
+	foreach (lc, windows)
+	{
+		InternalTimeRange *window = lfirst(lc);
+
+		log_refresh_window(DEBUG1, cagg, window, "scheduling refresh job for");
+		policy_refresh_cagg_window_add(cagg, window);
+	}
+}
+
+static int
+refresh_window_start_cmp(const void *left, const void *right)
+{
+	const InternalTimeRange *lw = *((const InternalTimeRange **) left);
+	const InternalTimeRange *rw = *((const InternalTimeRange **) right);
+
+	if (lw->start < rw->start)
+		return -1;
+	if (lw->start > rw->start)
+		return 1;
+	return 0;
+}
+
+/*
+ * Split the part of a refresh window that has pending changes into batches
+ * for a refresh policy.
+ *
+ * The pending changes are the invalidated ranges that are not yet processed
+ * and the data above the invalidation threshold. The ranges are aligned with
+ * the buckets, merged and split into batches of at most buckets_per_batch
+ * buckets, oldest first. Refreshing the batches oldest first keeps the data
+ * above the invalidation threshold that is not yet refreshed above the
+ * threshold. If there are more than max_batches batches (unless zero), only
+ * the first max_batches ones are returned and "more" is set.
+ *
+ * An empty list means that there is nothing to refresh. Continuous
+ * aggregates with variable-sized buckets, on distributed hypertables or that
+ * were never refreshed get the whole refresh window as a single batch.
+ */
+List *
+continuous_agg_refresh_batches(const ContinuousAgg *cagg,
+							   const InternalTimeRange *refresh_window_arg,
+							   int32 buckets_per_batch, int32 max_batches, bool *more)
+{
+	const Hypertable *raw_ht = cagg_get_hypertable_or_fail(cagg->data.raw_hypertable_id);
+	InternalTimeRange refresh_window;
+	InternalTimeRange largest_bucketed_window;
+	InternalTimeRange **ranges;
+	int64 bucket_width = 0;
+	int64 threshold = 0;
+	List *pending;
+	List *batches = NIL;
+	ListCell *lc;
+	int num_ranges = 0;
+
+	Assert(buckets_per_batch > 0);
+	*more = false;
+
+	if (!ts_continuous_agg_bucket_width_variable(cagg) && !hypertable_is_distributed(raw_ht) &&
+		invalidation_threshold_find(cagg->data.raw_hypertable_id, &threshold))
+	{
+		bucket_width = ts_continuous_agg_bucket_width(cagg);
+		refresh_window =
+			compute_inscribed_bucketed_refresh_window(refresh_window_arg, bucket_width);
+	}
+	else
+		refresh_window.start = refresh_window.end = 0;
+
+	/* Let the refresh of the whole window handle these cases */
+	if (refresh_window.start >= refresh_window.end)
+	{
+		InternalTimeRange *window = palloc(sizeof(InternalTimeRange));
+
+		*window = *refresh_window_arg;
+		return list_make1(window);
+	}
+
+	pending = invalidation_get_pending_ranges(cagg->data.mat_hypertable_id,
+											  cagg->data.raw_hypertable_id,
+											  &refresh_window);
+
+	/* Changes above the invalidation threshold are not logged */
+	if (threshold < refresh_window.end)
+	{
+		bool isnull;
+		Datum maxdat = ts_hypertable_get_open_dim_max_value(raw_ht, 0, &isnull);
+
+		if (!isnull)
+		{
+			int64 maxval = ts_time_value_to_internal(maxdat, refresh_window.type);
+
+			if (maxval >= threshold && maxval >= refresh_window.start)
+			{
+				InternalTimeRange *range = palloc(sizeof(InternalTimeRange));
+
+				range->type = refresh_window.type;
+				range->start = Max(threshold, refresh_window.start);
+				range->end = maxval >= refresh_window.end ? refresh_window.end : maxval + 1;
+				pending = lappend(pending, range);
+			}
+		}
+	}
+
+	if (pending == NIL)
+		return NIL;
+
+	ranges = palloc(sizeof(InternalTimeRange *) * list_length(pending));
+
+	foreach (lc, pending)
+	{
+		InternalTimeRange *range = lfirst(lc);
+
+		*range = compute_circumscribed_bucketed_refresh_window(range, bucket_width, NULL);
+		range->start = Max(range->start, refresh_window.start);
+		range->end = Min(range->end, refresh_window.end);
+		ranges[num_ranges++] = range;
+	}
+
+	qsort(ranges, num_ranges, sizeof(InternalTimeRange *), refresh_window_start_cmp);
+	largest_bucketed_window = get_largest_bucketed_window(refresh_window.type, bucket_width);
+
+	for (int i = 0; i < num_ranges && !*more;)
+	{
+		InternalTimeRange range = *ranges[i];
+		int64 start = range.start;
+		bool split;
+
+		for (i++; i < num_ranges && ranges[i]->start <= range.end; i++)
+			range.end = Max(range.end, ranges[i]->end);
+
+		/* Ranges open towards the start or end of time are not split */
+		split = range.start > largest_bucketed_window.start &&
+				range.end < largest_bucketed_window.end &&
+				bucket_width <= PG_INT64_MAX / buckets_per_batch;
+
+		while (start < range.end)
+		{
+			InternalTimeRange *batch;
+
+			if (max_batches > 0 && list_length(batches) >= max_batches)
+			{
+				*more = true;
+				break;
+			}
+
+			batch = palloc(sizeof(InternalTimeRange));
+			batch->type = range.type;
+			batch->start = start;
+			batch->end = range.end;
+
+			if (split)
+				batch->end = Min(ts_time_saturating_add(start,
+														buckets_per_batch * bucket_width,
+														range.type),
+								 range.end);
+
+			batches = lappend(batches, batch);
+			start = batch->end;
+		}
+	}
+
+	pfree(ranges);
+	list_free_deep(pending);
+
+	return batches;
+}
+
+/*
+ * Materialize a refresh window scheduled by a refresh job.
+ *
+ * Unlike a regular refresh, this does not process invalidations and only
+ * takes the lock needed to write to the materialized hypertable, so that the
+ * jobs of the windows of a continuous aggregate can run concurrently. They
+ * still wait for regular refreshes of the continuous aggregate, which take
+ * an exclusive lock.
+ */
+void
+continuous_agg_refresh_scheduled_window(const ContinuousAgg *cagg,
+										const InternalTimeRange *refresh_window)
+{
+	CaggRefreshState refresh;
+
+	LockRelationOid(ts_hypertable_id_to_relid(cagg->data.mat_hypertable_id), RowExclusiveLock);
+
+	continuous_agg_refresh_init(&refresh, cagg, refresh_window);
+	log_refresh_window(DEBUG1, cagg, refresh_window, "scheduled refresh on");
+	continuous_agg_refresh_execute(&refresh, refresh_window, INVALID_CHUNK_ID);
+	ts_cagg_watermark_update(cagg);
+}
+
 /*
  * Execute refreshes based on the processed invalidations.
  *
@@ -468,12 +947,37 @@ continuous_agg_refresh_with_window(const ContinuousAgg *cagg,
 {
 	CaggRefreshState refresh;
 	bool old_per_data_node_queries = ts_guc_enable_per_data_node_queries;
+	bool remote_refresh = is_raw_ht_distributed && ts_guc_enable_cagg_remote_refresh &&
+						  ContinuousAggIsFinalized(cagg);
+	int nestlevel = 0;
 
 	continuous_agg_refresh_init(&refresh, cagg, refresh_window);
 
-	/* Disable per-data-node optimization so that 'tableoid' system column is evaluated in the
-	 * Access Node to generate Access Node chunk-IDs for the materialization table. */
-	ts_guc_enable_per_data_node_queries = false;
+	/*
+	 * A finalized CAgg has no chunk-ID column, so the query on the raw
+	 * hypertable can be planned with per-data-node queries. Enabling
+	 * partitionwise aggregation then makes the data nodes compute (partial)
+	 * aggregates for the refreshed range, so only the aggregate states are
+	 * fetched instead of the raw rows.
+	 */
+	if (remote_refresh)
+	{
+		nestlevel = NewGUCNestLevel();
+		(void) set_config_option("enable_partitionwise_aggregate",
+								 "on",
+								 PGC_USERSET,
+								 PGC_S_SESSION,
+								 GUC_ACTION_SAVE,
+								 true,
+								 0,
+								 false);
+	}
+	else
+	{
+		/* Disable per-data-node optimization so that 'tableoid' system column is evaluated in
+		 * the Access Node to generate Access Node chunk-IDs for the materialization table. */
+		ts_guc_enable_per_data_node_queries = false;
+	}
 
 	/*
 	 * If we're refreshing a finalized CAgg then we should force
@@ -488,6 +992,18 @@ continuous_agg_refresh_with_window(const ContinuousAgg *cagg,
 	if (ContinuousAggIsFinalized(cagg))
 		chunk_id = INVALID_CHUNK_ID;
 
+	/*
+	 * Partials are stored per chunk unless the CAgg is finalized, so only
+	 * then the partials of single chunks can be recomputed.
+	 */
+	refresh.incremental = ts_guc_enable_cagg_incremental_refresh &&
+						  !ContinuousAggIsFinalized(cagg) && !is_raw_ht_distributed &&
+						  chunk_id == INVALID_CHUNK_ID;
+
+	/* Compressed materialization chunks can only be modified once decompressed */
+	refresh.decompress = ts_guc_enable_cagg_compressed_refresh && !is_raw_ht_distributed &&
+						 TS_HYPERTABLE_HAS_COMPRESSION_TABLE(refresh.cagg_ht);
+
 	if (do_merged_refresh)
 	{
 		Assert(merged_refresh_window.type == refresh_window->type);
@@ -499,7 +1015,10 @@ continuous_agg_refresh_with_window(const ContinuousAgg *cagg,
 						   cagg,
 						   &merged_refresh_window,
 						   "merged invalidations for refresh on");
-		continuous_agg_refresh_execute(&refresh, &merged_refresh_window, chunk_id);
+		continuous_agg_refresh_execute_decompressed(&refresh,
+													NULL,
+													&merged_refresh_window,
+													chunk_id);
 	}
 	else
 	{
@@ -514,6 +1033,11 @@ continuous_agg_refresh_with_window(const ContinuousAgg *cagg,
 		Assert(count);
 	}
 	ts_guc_enable_per_data_node_queries = old_per_data_node_queries;
+
+	if (remote_refresh)
+		AtEOXact_GUC(true, nestlevel);
+
+	ts_cagg_watermark_update(cagg);
 }
 
 static ContinuousAgg *
@@ -613,6 +1137,131 @@ continuous_agg_calculate_merged_refresh_window(const InternalTimeRange *refresh_
 	Assert(count);
 }
 
+/*
+ * Get the condition that restricts a refresh to the groups of a range of
+ * space partitions. The partitioning function of the dimension maps the
+ * values of the grouping column to the partitions.
+ */
+static char *
+partition_invalidation_condition(const Dimension *dim, const char *column,
+								 const PartitionInvalidation *invalidation)
+{
+	StringInfo condition = makeStringInfo();
+	const char *partition_value =
+		psprintf("%s(%s)",
+				 quote_qualified_identifier(NameStr(dim->fd.partitioning_func_schema),
+											NameStr(dim->fd.partitioning_func)),
+				 quote_identifier(column));
+
+	if (invalidation->partition_range_start != DIMENSION_SLICE_MINVALUE)
+		appendStringInfo(condition,
+						 "AND %s >= " INT64_FORMAT " ",
+						 partition_value,
+						 invalidation->partition_range_start);
+
+	if (invalidation->partition_range_end != DIMENSION_SLICE_MAXVALUE)
+		appendStringInfo(condition,
+						 "AND %s < " INT64_FORMAT,
+						 partition_value,
+						 invalidation->partition_range_end);
+
+	return condition->data;
+}
+
+/*
+ * Refresh the invalidations in the partition invalidation log of a
+ * continuous aggregate that are within the refresh window.
+ *
+ * Every invalidation only recomputes the groups of the space partitions
+ * that were modified. If there are many invalidations, the buckets of all of
+ * them are refreshed in a single, unrestricted, refresh instead.
+ *
+ * Returns true if anything was refreshed.
+ */
+static bool
+continuous_agg_refresh_partition_invalidations(const ContinuousAgg *cagg,
+											   const Hypertable *raw_ht,
+											   const InternalTimeRange *refresh_window,
+											   long max_materializations)
+{
+	int64 bucket_width = ts_continuous_agg_bucket_width_variable(cagg) ?
+							 BUCKET_WIDTH_VARIABLE :
+							 ts_continuous_agg_bucket_width(cagg);
+	const Dimension *space_dim = hyperspace_get_closed_dimension(raw_ht->space, 0);
+	const char *column = NULL;
+	InternalTimeRange merged_refresh_window = { 0 };
+	CaggRefreshState refresh;
+	List *invalidations;
+	bool do_merged_refresh;
+	ListCell *lc;
+
+	invalidations = invalidation_process_partition_log(cagg->data.mat_hypertable_id,
+													   refresh_window,
+													   bucket_width,
+													   cagg->bucket_function);
+
+	if (invalidations == NIL)
+		return false;
+
+	if (space_dim != NULL)
+		column = invalidation_get_partition_column(cagg, space_dim);
+
+	do_merged_refresh = column == NULL || list_length(invalidations) > max_materializations;
+
+	continuous_agg_refresh_init(&refresh, cagg, refresh_window);
+	refresh.decompress = ts_guc_enable_cagg_compressed_refresh &&
+						 TS_HYPERTABLE_HAS_COMPRESSION_TABLE(refresh.cagg_ht);
+
+	foreach (lc, invalidations)
+	{
+		const PartitionInvalidation *pinv = lfirst(lc);
+		InternalTimeRange invalidation = {
+			.type = refresh_window->type,
+			.start = pinv->lowest_modified_value,
+			/* Invalidations are inclusive at the end, while refresh windows
+			 * aren't */
+			.end = ts_time_saturating_add(pinv->greatest_modified_value, 1, refresh_window->type),
+		};
+		InternalTimeRange bucketed_refresh_window =
+			compute_circumscribed_bucketed_refresh_window(&invalidation,
+														  bucket_width,
+														  cagg->bucket_function);
+
+		if (do_merged_refresh)
+		{
+			if (lc == list_head(invalidations))
+				merged_refresh_window = bucketed_refresh_window;
+			merged_refresh_window.start =
+				Min(merged_refresh_window.start, bucketed_refresh_window.start);
+			merged_refresh_window.end = Max(merged_refresh_window.end, bucketed_refresh_window.end);
+			continue;
+		}
+
+		refresh.partition_condition = partition_invalidation_condition(space_dim, column, pinv);
+		log_refresh_window(DEBUG1, cagg, &bucketed_refresh_window, "partition refresh on");
+		continuous_agg_refresh_execute_decompressed(&refresh,
+													NULL,
+													&bucketed_refresh_window,
+													INVALID_CHUNK_ID);
+	}
+
+	if (do_merged_refresh)
+	{
+		log_refresh_window(DEBUG1,
+						   cagg,
+						   &merged_refresh_window,
+						   "merged partition invalidations for refresh on");
+		continuous_agg_refresh_execute_decompressed(&refresh,
+													NULL,
+													&merged_refresh_window,
+													INVALID_CHUNK_ID);
+	}
+
+	ts_cagg_watermark_update(cagg);
+
+	return true;
+}
+
 static bool
 process_cagg_invalidations_and_refresh(const ContinuousAgg *cagg,
 									   const InternalTimeRange *refresh_window,
@@ -623,6 +1272,7 @@ process_cagg_invalidations_and_refresh(const ContinuousAgg *cagg,
 	bool do_merged_refresh = false;
 	InternalTimeRange merged_refresh_window;
 	long max_materializations;
+	bool refreshed = false;
 
 	/* Lock the continuous aggregate's materialized hypertable to protect
 	 * against concurrent refreshes. Only concurrent reads will be
@@ -664,6 +1314,13 @@ process_cagg_invalidations_and_refresh(const ContinuousAgg *cagg,
 													  &merged_refresh_window);
 	}
 
+	/* Partition invalidations are only added for local hypertables */
+	if (!is_raw_ht_distributed)
+		refreshed = continuous_agg_refresh_partition_invalidations(cagg,
+																   ht,
+																   refresh_window,
+																   max_materializations);
+
 	if (invalidations != NULL || do_merged_refresh)
 	{
 		if (callctx == CAGG_REFRESH_CREATION)
@@ -679,6 +1336,21 @@ process_cagg_invalidations_and_refresh(const ContinuousAgg *cagg,
 								 BUCKET_WIDTH_VARIABLE :
 								 ts_continuous_agg_bucket_width(cagg);
 
+		/* Refreshes on chunk drop must happen before the chunk is gone */
+		if (ts_guc_cagg_refresh_parallel_jobs > 0 && !is_raw_ht_distributed &&
+			bucket_width != BUCKET_WIDTH_VARIABLE && chunk_id == INVALID_CHUNK_ID)
+		{
+			continuous_agg_schedule_refresh_jobs(cagg,
+												 refresh_window,
+												 invalidations,
+												 bucket_width,
+												 do_merged_refresh,
+												 merged_refresh_window);
+			if (invalidations)
+				invalidation_store_free(invalidations);
+			return true;
+		}
+
 		continuous_agg_refresh_with_window(cagg,
 										   refresh_window,
 										   invalidations,
@@ -692,7 +1364,7 @@ process_cagg_invalidations_and_refresh(const ContinuousAgg *cagg,
 		return true;
 	}
 
-	return false;
+	return refreshed;
 }
 
 void
@@ -29,5 +29,11 @@ extern void continuous_agg_calculate_merged_refresh_window(
 extern void continuous_agg_refresh_internal(const ContinuousAgg *cagg,
 											const InternalTimeRange *refresh_window,
 											const CaggRefreshCallContext callctx);
+extern List *continuous_agg_refresh_batches(const ContinuousAgg *cagg,
+											const InternalTimeRange *refresh_window,
+											int32 buckets_per_batch, int32 max_batches,
+											bool *more);
+extern void continuous_agg_refresh_scheduled_window(const ContinuousAgg *cagg,
+													const InternalTimeRange *refresh_window);
 
 #endif /* TIMESCALEDB_TSL_CONTINUOUS_AGGS_REFRESH_H */
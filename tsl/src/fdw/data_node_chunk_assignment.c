@@ -19,6 +19,8 @@
 #include "ts_catalog/chunk_data_node.h"
 #include "relinfo.h"
 #include "planner.h"
+#include "remote/healthcheck.h"
+#include "utils.h"
 
 /*
  * Find an existing data node chunk assignment or initialize a new one.
@@ -49,6 +51,119 @@ get_slice_for_dimension(Chunk *chunk, int32 dimension_id)
 	return ts_hypercube_get_slice_by_dimension_id(chunk->cube, dimension_id);
 }
 
+/*
+ * Get the relative cost of scanning the given amount of rows on a data node.
+ *
+ * Data nodes that respond slowly, e.g., because they are busy, get a higher
+ * cost. Data nodes not contacted yet are assumed to respond as fast as the
+ * fastest known data node.
+ */
+static double
+data_node_scan_cost(const char *node_name, double rows, double min_response_ms)
+{
+	double response_ms = remote_node_response_time_get(node_name);
+
+	if (response_ms < 0 || min_response_ms <= 0)
+		return rows;
+
+	return rows * (response_ms / min_response_ms);
+}
+
+/*
+ * Pick the data node to scan a chunk on among the data nodes that have a
+ * replica of the chunk.
+ *
+ * The data node with the lowest cost after adding the chunk to its
+ * assignment is picked. This balances the rows to scan across data nodes,
+ * while shifting work away from data nodes that respond slowly. Data nodes
+ * that recently missed a response deadline are only picked if no other
+ * replica is available.
+ */
+static Oid
+get_least_loaded_data_node(DataNodeChunkAssignments *scas, RelOptInfo *chunkrel, Chunk *chunk)
+{
+	Oid best_serverid = chunkrel->serverid;
+	double best_cost = -1;
+	bool best_responsive = false;
+	double min_response_ms = -1;
+	ListCell *lc;
+
+	foreach (lc, chunk->data_nodes)
+	{
+		ChunkDataNode *cdn = lfirst(lc);
+		double response_ms = remote_node_response_time_get(NameStr(cdn->fd.node_name));
+
+		if (response_ms > 0 && (min_response_ms < 0 || response_ms < min_response_ms))
+			min_response_ms = response_ms;
+	}
+
+	foreach (lc, chunk->data_nodes)
+	{
+		ChunkDataNode *cdn = lfirst(lc);
+		Oid serverid = cdn->foreign_server_oid;
+		DataNodeChunkAssignment *sca;
+		bool responsive;
+		double cost;
+
+		if (!list_member_oid(scas->data_node_serverids, serverid) ||
+			!ts_data_node_is_available_by_server(GetForeignServer(serverid)))
+			continue;
+
+		sca = hash_search(scas->assignments, &serverid, HASH_FIND, NULL);
+		/* Count each chunk as an extra row to balance chunks without
+		 * statistics */
+		cost = data_node_scan_cost(NameStr(cdn->fd.node_name),
+								   (sca == NULL ? 0 : sca->rows + list_length(sca->chunks)) +
+									   chunkrel->rows + 1,
+								   min_response_ms);
+		responsive = remote_node_is_responsive(NameStr(cdn->fd.node_name));
+
+		if (best_cost < 0 || (responsive == best_responsive ? cost < best_cost : responsive))
+		{
+			best_cost = cost;
+			best_responsive = responsive;
+			best_serverid = serverid;
+		}
+	}
+
+	return best_serverid;
+}
+
+/*
+ * Pick another replica of a chunk if the default data node recently missed a
+ * response deadline, so that the next query does not wait on it again.
+ */
+static Oid
+get_responsive_data_node(DataNodeChunkAssignments *scas, RelOptInfo *chunkrel, Chunk *chunk)
+{
+	ListCell *lc;
+
+	foreach (lc, chunk->data_nodes)
+	{
+		ChunkDataNode *cdn = lfirst(lc);
+
+		if (cdn->foreign_server_oid == chunkrel->serverid)
+		{
+			if (remote_node_is_responsive(NameStr(cdn->fd.node_name)))
+				return chunkrel->serverid;
+			break;
+		}
+	}
+
+	foreach (lc, chunk->data_nodes)
+	{
+		ChunkDataNode *cdn = lfirst(lc);
+		Oid serverid = cdn->foreign_server_oid;
+
+		if (list_member_oid(scas->data_node_serverids, serverid) &&
+			remote_node_is_responsive(NameStr(cdn->fd.node_name)) &&
+			ts_data_node_is_available_by_server(GetForeignServer(serverid)))
+			return serverid;
+	}
+
+	return chunkrel->serverid;
+}
+
 /*
  * Assign the given chunk relation to a data node.
  *
@@ -58,10 +173,19 @@ get_slice_for_dimension(Chunk *chunk, int32 dimension_id)
 DataNodeChunkAssignment *
 data_node_chunk_assignment_assign_chunk(DataNodeChunkAssignments *scas, RelOptInfo *chunkrel)
 {
-	DataNodeChunkAssignment *sca = get_or_create_sca(scas, chunkrel->serverid, NULL);
 	TimescaleDBPrivate *chunk_private = ts_get_private_reloptinfo(chunkrel);
+	Oid serverid = chunkrel->serverid;
+	DataNodeChunkAssignment *sca;
 	MemoryContext old;
 
+	if (scas->strategy == SCA_STRATEGY_LEAST_LOADED &&
+		list_length(chunk_private->chunk->data_nodes) > 1)
+		serverid = get_least_loaded_data_node(scas, chunkrel, chunk_private->chunk);
+	else if (list_length(chunk_private->chunk->data_nodes) > 1)
+		serverid = get_responsive_data_node(scas, chunkrel, chunk_private->chunk);
+
+	sca = get_or_create_sca(scas, serverid, NULL);
+
 	/* Should never assign the same chunk twice */
 	Assert(!bms_is_member(chunkrel->relid, sca->chunk_relids));
 
@@ -81,7 +205,7 @@ data_node_chunk_assignment_assign_chunk(DataNodeChunkAssignments *scas, RelOptIn
 	foreach (lc, chunk_private->chunk->data_nodes)
 	{
 		ChunkDataNode *cdn = (ChunkDataNode *) lfirst(lc);
-		if (cdn->foreign_server_oid == chunkrel->serverid)
+		if (cdn->foreign_server_oid == serverid)
 		{
 			remote_chunk_relid = cdn->fd.node_chunk_id;
 			break;
@@ -110,7 +234,7 @@ data_node_chunk_assignment_assign_chunk(DataNodeChunkAssignments *scas, RelOptIn
 void
 data_node_chunk_assignments_init(DataNodeChunkAssignments *scas,
 								 DataNodeChunkAssignmentStrategy strategy, PlannerInfo *root,
-								 unsigned int nrels_hint)
+								 List *data_node_serverids, unsigned int nrels_hint)
 {
 	HASHCTL hctl = {
 		.keysize = sizeof(Oid),
@@ -120,6 +244,7 @@ data_node_chunk_assignments_init(DataNodeChunkAssignments *scas,
 
 	scas->strategy = strategy;
 	scas->root = root;
+	scas->data_node_serverids = data_node_serverids;
 	scas->mctx = hctl.hcxt;
 	scas->total_num_chunks = 0;
 	scas->num_nodes_with_chunks = 0;
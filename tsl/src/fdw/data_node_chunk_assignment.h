@@ -34,18 +34,26 @@ typedef struct DataNodeChunkAssignment
 } DataNodeChunkAssignment;
 
 /*
- * Only "attached data node" strategy is supported at this time. This strategy
- * picks the data node that is associated with a chunk's foreign table
+ * The "attached data node" strategy picks the data node that is associated
+ * with a chunk's foreign table. The "least loaded" strategy picks, among the
+ * data nodes that have a replica of a chunk, the one with the least expected
+ * work given the chunks assigned so far and the observed response time of
+ * the data node.
+ *
+ * With either strategy, a replicated chunk is not assigned to a data node
+ * that recently missed a response deadline if another replica is available.
  */
 typedef enum DataNodeChunkAssignmentStrategy
 {
 	SCA_STRATEGY_ATTACHED_DATA_NODE,
+	SCA_STRATEGY_LEAST_LOADED,
 } DataNodeChunkAssignmentStrategy;
 
 typedef struct DataNodeChunkAssignments
 {
 	DataNodeChunkAssignmentStrategy strategy;
 	PlannerInfo *root;
+	List *data_node_serverids; /* Data nodes chunks can be assigned to */
 	HTAB *assignments;
 	unsigned long total_num_chunks;
 	unsigned long num_nodes_with_chunks;
@@ -64,7 +72,8 @@ data_node_chunk_assignment_get_or_create(DataNodeChunkAssignments *scas, RelOptI
 
 extern void data_node_chunk_assignments_init(DataNodeChunkAssignments *scas,
 											 DataNodeChunkAssignmentStrategy strategy,
-											 PlannerInfo *root, unsigned int nrels_hint);
+											 PlannerInfo *root, List *data_node_serverids,
+											 unsigned int nrels_hint);
 
 extern bool data_node_chunk_assignments_are_overlapping(DataNodeChunkAssignments *scas,
 														int32 partitioning_dimension_id);
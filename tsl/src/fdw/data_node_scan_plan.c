@@ -5,6 +5,8 @@
  */
 #include <postgres.h>
 #include <access/sysattr.h>
+#include <catalog/pg_am.h>
+#include <commands/defrem.h>
 #include <foreign/fdwapi.h>
 #include <nodes/extensible.h>
 #include <nodes/makefuncs.h>
@@ -20,16 +22,21 @@
 #include <optimizer/restrictinfo.h>
 #include <optimizer/tlist.h>
 #include <parser/parsetree.h>
+#include <partitioning/partbounds.h>
+#include <utils/lsyscache.h>
 #include <utils/memutils.h>
 
 #include <math.h>
 
+#include <chunk.h>
 #include <compat/compat.h>
 #include <debug.h>
 #include <debug_guc.h>
 #include <dimension.h>
 #include <export.h>
 #include <func_cache.h>
+#include <guc.h>
+#include <hypercube.h>
 #include <hypertable_cache.h>
 #include <import/allpaths.h>
 #include <import/planner.h>
@@ -674,6 +681,315 @@ push_down_group_bys(PlannerInfo *root, RelOptInfo *hyper_rel, Hyperspace *hs,
 	}
 }
 
+/*
+ * The range of a space slice and the data node it is placed on.
+ */
+typedef struct ColocatedSlice
+{
+	int64 range_start;
+	int64 range_end;
+	Oid serverid;
+} ColocatedSlice;
+
+/*
+ * Partition scheme for distributed hypertables with chunks placed on data
+ * nodes along a closed "space" dimension.
+ *
+ * PostgreSQL only joins relations partitionwise if they share the same
+ * partition scheme. Two distributed hypertables get the same scheme if a row
+ * with a given key value is always placed on the same data node for both,
+ * i.e., if they use the same partitioning function on the same key type and
+ * their space slices are placed on the same data nodes. Each data node rel of
+ * one hypertable can then be joined with the data node rel of the other
+ * hypertable on the same data node.
+ *
+ * The scheme uses the hash strategy with the hash operator family of the key,
+ * since that is what a partitionwise join on the key requires, but the input
+ * type of the key is left invalid. This keeps the scheme from matching the
+ * scheme of any real partitioned table.
+ */
+typedef struct ColocationScheme
+{
+	PartitionSchemeData scheme;
+	Oid partfunc;
+	/* Data nodes of the partitions, in partition order */
+	List *serverids;
+	/* Sorted by range */
+	ColocatedSlice *slices;
+	int nslices;
+} ColocationScheme;
+
+static int
+colocated_slice_cmp(const void *a, const void *b)
+{
+	const ColocatedSlice *sa = a;
+	const ColocatedSlice *sb = b;
+
+	if (sa->range_start != sb->range_start)
+		return sa->range_start < sb->range_start ? -1 : 1;
+
+	if (sa->range_end != sb->range_end)
+		return sa->range_end < sb->range_end ? -1 : 1;
+
+	if (sa->serverid != sb->serverid)
+		return sa->serverid < sb->serverid ? -1 : 1;
+
+	return 0;
+}
+
+static int
+data_node_rel_cmp(const void *a, const void *b)
+{
+	const RelOptInfo *rel_a = *((const RelOptInfo **) a);
+	const RelOptInfo *rel_b = *((const RelOptInfo **) b);
+
+	if (rel_a->serverid == rel_b->serverid)
+		return 0;
+
+	return rel_a->serverid < rel_b->serverid ? -1 : 1;
+}
+
+static bool
+colocation_scheme_matches(const ColocationScheme *cs, Oid opfamily, Oid collation, Oid partfunc,
+						  List *serverids, const ColocatedSlice *slices, int nslices)
+{
+	if (cs->scheme.strategy != PARTITION_STRATEGY_HASH || cs->scheme.partnatts != 1 ||
+		OidIsValid(cs->scheme.partopcintype[0]) || cs->scheme.partopfamily[0] != opfamily ||
+		cs->scheme.partcollation[0] != collation || cs->partfunc != partfunc ||
+		!equal(cs->serverids, serverids) || cs->nslices != nslices)
+		return false;
+
+	for (int i = 0; i < nslices; i++)
+	{
+		if (colocated_slice_cmp(&cs->slices[i], &slices[i]) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Get the partition scheme for a distributed hypertable with the given key
+ * and placement of space slices. A matching scheme in root->part_schemes is
+ * reused, like find_partition_scheme() does for partitioned tables.
+ */
+static PartitionScheme
+get_colocation_scheme(PlannerInfo *root, Oid keytype, Oid collation, Oid partfunc,
+					  List *serverids, ColocatedSlice *slices, int nslices)
+{
+	Oid opclass = GetDefaultOpClass(keytype, HASH_AM_OID);
+	ColocationScheme *cs;
+	Oid opfamily;
+	ListCell *lc;
+
+	if (!OidIsValid(opclass))
+		return NULL;
+
+	opfamily = get_opclass_family(opclass);
+
+	foreach (lc, root->part_schemes)
+	{
+		PartitionScheme part_scheme = lfirst(lc);
+
+		/* Only our schemes have an invalid key input type */
+		if (part_scheme->strategy == PARTITION_STRATEGY_HASH && part_scheme->partnatts == 1 &&
+			!OidIsValid(part_scheme->partopcintype[0]) &&
+			colocation_scheme_matches((ColocationScheme *) part_scheme,
+									  opfamily,
+									  collation,
+									  partfunc,
+									  serverids,
+									  slices,
+									  nslices))
+			return part_scheme;
+	}
+
+	cs = palloc0(sizeof(ColocationScheme));
+	cs->scheme.strategy = PARTITION_STRATEGY_HASH;
+	cs->scheme.partnatts = 1;
+	cs->scheme.partopfamily = palloc(sizeof(Oid));
+	cs->scheme.partopfamily[0] = opfamily;
+	cs->scheme.partopcintype = palloc0(sizeof(Oid));
+	cs->scheme.partcollation = palloc(sizeof(Oid));
+	cs->scheme.partcollation[0] = collation;
+	cs->scheme.parttyplen = palloc(sizeof(int16));
+	cs->scheme.parttypbyval = palloc(sizeof(bool));
+	get_typlenbyval(keytype, &cs->scheme.parttyplen[0], &cs->scheme.parttypbyval[0]);
+	cs->scheme.partsupfunc = palloc0(sizeof(FmgrInfo));
+	cs->partfunc = partfunc;
+	cs->serverids = serverids;
+	cs->slices = slices;
+	cs->nslices = nslices;
+
+	root->part_schemes = lappend(root->part_schemes, cs);
+
+	return &cs->scheme;
+}
+
+/*
+ * Make the data node rels the partitions of a hypertable partitioned on its
+ * first closed "space" dimension, so that PostgreSQL considers joining it
+ * partitionwise with other distributed hypertables placed the same way (see
+ * ColocationScheme). The join of two data node rels on the same data node is
+ * then pushed down by data_node_scan_add_join_paths().
+ *
+ * This needs the chunk assignments to be non-overlapping along the space
+ * dimension. The data node rels are sorted by data node, which is also the
+ * partition order. The partition bounds use the hash strategy with one
+ * remainder per data node, so the bounds of two hypertables with the same
+ * scheme always match.
+ *
+ * Like for chunk-wise joins of regular hypertables, queries with runtime
+ * restrictions are left alone, since PostgreSQL would build partition pruning
+ * info for them.
+ */
+static bool
+set_colocated_partition_info(PlannerInfo *root, RelOptInfo *hyper_rel, Hyperspace *hs,
+							 DataNodeChunkAssignments *scas, RelOptInfo **data_node_rels,
+							 int ndata_node_rels)
+{
+	const Dimension *dim = hyperspace_get_closed_dimension(hs, 0);
+	PartitionScheme part_scheme;
+	PartitionBoundInfo boundinfo;
+	ColocatedSlice *slices;
+	List *serverids = NIL;
+	List *partexprs;
+	Expr *key;
+	int nslices = 0;
+	ListCell *lc;
+	int i;
+
+	if (!ts_guc_enable_colocated_join || !enable_partitionwise_join ||
+		root->parse->commandType != CMD_SELECT || hyper_rel->reloptkind != RELOPT_BASEREL ||
+		hyper_rel->attr_needed[InvalidAttrNumber - hyper_rel->min_attr] != NULL || dim == NULL ||
+		scas->num_nodes_with_chunks <= 1 ||
+		data_node_chunk_assignments_are_overlapping(scas, dim->fd.id))
+		return false;
+
+	foreach (lc, hyper_rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		if (contain_mutable_functions((Node *) rinfo->clause) ||
+			ts_contain_param((Node *) rinfo->clause))
+			return false;
+	}
+
+	partexprs = ts_dimension_get_partexprs(dim, hyper_rel->relid);
+	key = linitial(partexprs);
+
+	if (key == NULL)
+		return false;
+
+	/* Collect the range and data node of every space slice */
+	slices = palloc0(sizeof(ColocatedSlice) * scas->total_num_chunks);
+
+	for (i = 0; i < ndata_node_rels; i++)
+	{
+		DataNodeChunkAssignment *sca =
+			data_node_chunk_assignment_get_or_create(scas, data_node_rels[i]);
+
+		foreach (lc, sca->chunks)
+		{
+			Chunk *chunk = lfirst(lc);
+			const DimensionSlice *slice =
+				ts_hypercube_get_slice_by_dimension_id(chunk->cube, dim->fd.id);
+
+			Assert(slice != NULL);
+			slices[nslices].range_start = slice->fd.range_start;
+			slices[nslices].range_end = slice->fd.range_end;
+			slices[nslices].serverid = sca->node_server_oid;
+			nslices++;
+		}
+	}
+
+	if (nslices > 1)
+	{
+		int nunique = 1;
+
+		qsort(slices, nslices, sizeof(ColocatedSlice), colocated_slice_cmp);
+
+		for (i = 1; i < nslices; i++)
+		{
+			if (colocated_slice_cmp(&slices[nunique - 1], &slices[i]) != 0)
+				slices[nunique++] = slices[i];
+		}
+
+		nslices = nunique;
+	}
+
+	qsort(data_node_rels, ndata_node_rels, sizeof(RelOptInfo *), data_node_rel_cmp);
+
+	for (i = 0; i < ndata_node_rels; i++)
+		serverids = lappend_oid(serverids, data_node_rels[i]->serverid);
+
+	part_scheme = get_colocation_scheme(root,
+										exprType((Node *) key),
+										exprCollation((Node *) key),
+										dim->partitioning != NULL ?
+											dim->partitioning->partfunc.func_fmgr.fn_oid :
+											InvalidOid,
+										serverids,
+										slices,
+										nslices);
+
+	if (part_scheme == NULL)
+		return false;
+
+	boundinfo = palloc0(sizeof(PartitionBoundInfoData));
+	boundinfo->strategy = PARTITION_STRATEGY_HASH;
+	boundinfo->ndatums = ndata_node_rels;
+	boundinfo->datums = palloc(sizeof(Datum *) * ndata_node_rels);
+	boundinfo->indexes = palloc(sizeof(int) * ndata_node_rels);
+	boundinfo->null_index = -1;
+	boundinfo->default_index = -1;
+
+	for (i = 0; i < ndata_node_rels; i++)
+	{
+		/* The modulus and remainder of the partition */
+		boundinfo->datums[i] = palloc(sizeof(Datum) * 2);
+		boundinfo->datums[i][0] = Int32GetDatum(ndata_node_rels);
+		boundinfo->datums[i][1] = Int32GetDatum(i);
+		boundinfo->indexes[i] = i;
+	}
+#if PG14_GE
+	boundinfo->nindexes = ndata_node_rels;
+#endif
+
+	hyper_rel->part_scheme = part_scheme;
+	hyper_rel->boundinfo = boundinfo;
+	hyper_rel->partexprs = palloc0(sizeof(List *));
+	hyper_rel->partexprs[0] = partexprs;
+	hyper_rel->nullable_partexprs = palloc0(sizeof(List *));
+	hyper_rel->consider_partitionwise_join = true;
+
+	return true;
+}
+
+/*
+ * Remove the parameterized Append paths of a hypertable that is planned for
+ * co-located joins. PostgreSQL adds partition pruning info to parameterized
+ * Appends of a partitioned relation, which does not apply to data node rels.
+ */
+static void
+remove_parameterized_append_paths(RelOptInfo *hyper_rel)
+{
+	List *pathlist = NIL;
+	ListCell *lc;
+
+	foreach (lc, hyper_rel->pathlist)
+	{
+		Path *path = lfirst(lc);
+
+		if (IsA(path, AppendPath) && path->param_info != NULL)
+			continue;
+
+		pathlist = lappend(pathlist, path);
+	}
+
+	hyper_rel->pathlist = pathlist;
+}
+
 /*
  * Turn chunk append paths into data node append paths.
  *
@@ -699,6 +1015,7 @@ data_node_scan_add_node_paths(PlannerInfo *root, RelOptInfo *hyper_rel)
 #endif
 	int ndata_node_rels;
 	DataNodeChunkAssignments scas;
+	bool colocated;
 	int i;
 
 	Assert(NULL != ht);
@@ -714,7 +1031,13 @@ data_node_scan_add_node_paths(PlannerInfo *root, RelOptInfo *hyper_rel)
 
 	Assert(ndata_node_rels > 0);
 
-	data_node_chunk_assignments_init(&scas, SCA_STRATEGY_ATTACHED_DATA_NODE, root, ndata_node_rels);
+	data_node_chunk_assignments_init(&scas,
+									 ts_guc_enable_replica_load_balancing ?
+										 SCA_STRATEGY_LEAST_LOADED :
+										 SCA_STRATEGY_ATTACHED_DATA_NODE,
+									 root,
+									 ((TimescaleDBPrivate *) hyper_rel->fdw_private)->serverids,
+									 ndata_node_rels);
 
 	/* Assign chunks to data nodes */
 	data_node_chunk_assignment_assign_chunks(&scas, chunk_rels, nchunk_rels);
@@ -722,6 +1045,14 @@ data_node_scan_add_node_paths(PlannerInfo *root, RelOptInfo *hyper_rel)
 	/* Try to push down GROUP BY expressions and bucketing, if possible */
 	push_down_group_bys(root, hyper_rel, ht->space, &scas);
 
+	/* Plan the hypertable for co-located joins, if possible */
+	colocated = set_colocated_partition_info(root,
+											 hyper_rel,
+											 ht->space,
+											 &scas,
+											 data_node_rels,
+											 ndata_node_rels);
+
 	/*
 	 * Create estimates and paths for each data node rel based on data node chunk
 	 * assignments.
@@ -783,6 +1114,10 @@ data_node_scan_add_node_paths(PlannerInfo *root, RelOptInfo *hyper_rel)
 #endif
 
 	add_paths_to_append_rel(root, hyper_rel, data_node_rels_list);
+
+	if (colocated)
+		remove_parameterized_append_paths(hyper_rel);
+
 	ts_cache_release(hcache);
 }
 
@@ -804,8 +1139,10 @@ data_node_scan_create_upper_paths(PlannerInfo *root, UpperRelationKind stage, Re
 
 	fpinfo = fdw_relinfo_get(input_rel);
 
-	/* Verify that this is a data node rel */
-	if (NULL == fpinfo || fpinfo->type != TS_FDW_RELINFO_HYPERTABLE_DATA_NODE)
+	/* Verify that this is a data node rel. Aggregates are not pushed down
+	 * over joins of data node rels. */
+	if (NULL == fpinfo || fpinfo->type != TS_FDW_RELINFO_HYPERTABLE_DATA_NODE ||
+		IS_JOIN_REL(input_rel))
 		return;
 
 	fdw_create_upper_paths(fpinfo,
@@ -817,6 +1154,23 @@ data_node_scan_create_upper_paths(PlannerInfo *root, UpperRelationKind stage, Re
 						   data_node_scan_upper_path_create);
 }
 
+/*
+ * Create paths for a join of two data node rels of co-located distributed
+ * hypertables. The join is pushed down to the data node as a whole.
+ */
+void
+data_node_scan_create_join_paths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+								 RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+{
+	fdw_create_join_paths(root,
+						  joinrel,
+						  outerrel,
+						  innerrel,
+						  jointype,
+						  extra,
+						  data_node_scan_path_create);
+}
+
 static CustomScanMethods data_node_scan_plan_methods = {
 	.CustomName = "DataNodeScan",
 	.CreateCustomScanState = data_node_scan_state_create,
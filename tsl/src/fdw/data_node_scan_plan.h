@@ -16,6 +16,9 @@ extern void data_node_scan_add_node_paths(PlannerInfo *root, RelOptInfo *hyper_r
 extern void data_node_scan_create_upper_paths(PlannerInfo *root, UpperRelationKind stage,
 											  RelOptInfo *input_rel, RelOptInfo *output_rel,
 											  void *extra);
+extern void data_node_scan_create_join_paths(PlannerInfo *root, RelOptInfo *joinrel,
+											 RelOptInfo *outerrel, RelOptInfo *innerrel,
+											 JoinType jointype, JoinPathExtraData *extra);
 
 /* Indexes of fields in ForeignScan->custom_private */
 typedef enum
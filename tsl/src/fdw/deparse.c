@@ -223,7 +223,8 @@ static void deparseLockingClause(deparse_expr_cxt *context);
 static void appendOrderByClause(List *pathkeys, deparse_expr_cxt *context);
 static void appendLimit(deparse_expr_cxt *context, List *pathkeys);
 
-static void append_chunk_exclusion_condition(deparse_expr_cxt *context, bool use_alias);
+static void append_chunk_exclusion_condition(deparse_expr_cxt *context, RelOptInfo *rel,
+											 DataNodeChunkAssignment *sca, bool use_alias);
 static void appendConditions(List *exprs, deparse_expr_cxt *context, bool is_first);
 static void deparseFromExprForRel(StringInfo buf, PlannerInfo *root, RelOptInfo *foreignrel,
 								  bool use_alias, Index ignore_rel, List **ignore_conds,
@@ -1061,7 +1062,7 @@ deparseSelectSql(List *tlist, bool is_subquery, List **retrieved_attrs, deparse_
 		 */
 		deparseSubqueryTargetList(context);
 	}
-	else if (tlist != NIL)
+	else if (tlist != NIL || IS_JOIN_REL(foreignrel))
 	{
 		/*
 		 * For a join, hypertable-data node or upper relation the input tlist gives the list of
@@ -1127,14 +1128,29 @@ deparseFromExpr(List *quals, deparse_expr_cxt *context)
 						  context->params_list);
 
 	/* Construct WHERE clause */
-	if (quals != NIL || context->sca != NULL)
+	if (quals != NIL || context->sca != NULL || IS_JOIN_REL(scanrel))
 		appendStringInfoString(buf, " WHERE ");
 
 	if (context->sca != NULL)
-		append_chunk_exclusion_condition(context, use_alias);
+		append_chunk_exclusion_condition(context, scanrel, context->sca, use_alias);
+	else if (IS_JOIN_REL(scanrel))
+	{
+		/* Each joined data node rel scans only its assigned chunks */
+		TsFdwRelInfo *fpinfo = fdw_relinfo_get(scanrel);
+
+		append_chunk_exclusion_condition(context,
+										 fpinfo->outerrel,
+										 fdw_relinfo_get(fpinfo->outerrel)->sca,
+										 true);
+		appendStringInfoString(buf, " AND ");
+		append_chunk_exclusion_condition(context,
+										 fpinfo->innerrel,
+										 fdw_relinfo_get(fpinfo->innerrel)->sca,
+										 true);
+	}
 
 	if (quals != NIL)
-		appendConditions(quals, context, (context->sca == NULL));
+		appendConditions(quals, context, (context->sca == NULL && !IS_JOIN_REL(scanrel)));
 }
 
 /*
@@ -1293,11 +1309,10 @@ deparseLockingClause(deparse_expr_cxt *context)
 }
 
 static void
-append_chunk_exclusion_condition(deparse_expr_cxt *context, bool use_alias)
+append_chunk_exclusion_condition(deparse_expr_cxt *context, RelOptInfo *scanrel,
+								 DataNodeChunkAssignment *sca, bool use_alias)
 {
 	StringInfo buf = context->buf;
-	DataNodeChunkAssignment *sca = context->sca;
-	RelOptInfo *scanrel = context->scanrel;
 	ListCell *lc;
 	bool first = true;
 
@@ -1446,6 +1461,35 @@ deparseSubqueryTargetList(deparse_expr_cxt *context)
 		appendStringInfoString(buf, "NULL");
 }
 
+/*
+ * Output join name for given join type
+ */
+const char *
+get_jointype_name(JoinType jointype)
+{
+	switch (jointype)
+	{
+		case JOIN_INNER:
+			return "INNER";
+
+		case JOIN_LEFT:
+			return "LEFT";
+
+		case JOIN_RIGHT:
+			return "RIGHT";
+
+		case JOIN_FULL:
+			return "FULL";
+
+		default:
+			/* Shouldn't come here, but protect from buggy code. */
+			elog(ERROR, "unsupported join type %d", jointype);
+	}
+
+	/* Keep compiler happy */
+	return NULL;
+}
+
 /*
  * Construct FROM clause for given relation
  *
@@ -1464,9 +1508,57 @@ deparseFromExprForRel(StringInfo buf, PlannerInfo *root, RelOptInfo *foreignrel,
 					  Index ignore_rel, List **ignore_conds, List **params_list)
 {
 	if (IS_JOIN_REL(foreignrel))
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("distributed JOINs are currently unsupported")));
+	{
+		TsFdwRelInfo *fpinfo = fdw_relinfo_get(foreignrel);
+		StringInfoData join_sql_o;
+		StringInfoData join_sql_i;
+
+		/* Deparse outer and inner relations */
+		initStringInfo(&join_sql_o);
+		deparseFromExprForRel(&join_sql_o,
+							  root,
+							  fpinfo->outerrel,
+							  true,
+							  ignore_rel,
+							  ignore_conds,
+							  params_list);
+		initStringInfo(&join_sql_i);
+		deparseFromExprForRel(&join_sql_i,
+							  root,
+							  fpinfo->innerrel,
+							  true,
+							  ignore_rel,
+							  ignore_conds,
+							  params_list);
+
+		appendStringInfo(buf,
+						 "(%s %s JOIN %s ON ",
+						 join_sql_o.data,
+						 get_jointype_name(fpinfo->jointype),
+						 join_sql_i.data);
+
+		/* Append join clause; (TRUE) if no join clause */
+		if (fpinfo->joinclauses)
+		{
+			deparse_expr_cxt context;
+
+			context.buf = buf;
+			context.foreignrel = foreignrel;
+			context.scanrel = foreignrel;
+			context.root = root;
+			context.params_list = params_list;
+			context.sca = NULL;
+
+			appendStringInfoChar(buf, '(');
+			appendConditions(fpinfo->joinclauses, &context, true);
+			appendStringInfoChar(buf, ')');
+		}
+		else
+			appendStringInfoString(buf, "(TRUE)");
+
+		/* End the FROM clause entry. */
+		appendStringInfoChar(buf, ')');
+	}
 	else
 	{
 		RangeTblEntry *rte = planner_rt_fetch(foreignrel->relid, root);
@@ -231,6 +231,57 @@ get_base_rel_estimate(PlannerInfo *root, RelOptInfo *rel, CostEstimate *ce)
 	ce->run_cost += rel->reltarget->cost.per_tuple * ce->rows;
 }
 
+/*
+ * Estimate a join as the cost of generating the rows of the joined relations
+ * plus the cost of applying the join clauses. The join strategy chosen by the
+ * data node is not known, so its startup cost is not accounted for.
+ */
+static void
+get_join_rel_estimate(PlannerInfo *root, RelOptInfo *rel, CostEstimate *ce)
+{
+	TsFdwRelInfo *fpinfo = fdw_relinfo_get(rel);
+	TsFdwRelInfo *fpinfo_o = fdw_relinfo_get(fpinfo->outerrel);
+	TsFdwRelInfo *fpinfo_i = fdw_relinfo_get(fpinfo->innerrel);
+	QualCost join_cost;
+	QualCost remote_conds_cost;
+	double nrows;
+
+	/* Use rows/width estimates made by the core code. */
+	ce->rows = rel->rows;
+	ce->width = rel->reltarget->width;
+
+	/* Estimate of number of rows in cross product */
+	nrows = fpinfo_o->rows * fpinfo_i->rows;
+
+	/* Back into an estimate of the number of retrieved rows. */
+	ce->retrieved_rows = clamp_row_est(ce->rows / fpinfo->local_conds_sel);
+	ce->retrieved_rows = Min(ce->retrieved_rows, nrows);
+
+	cost_qual_eval(&remote_conds_cost, fpinfo->remote_conds, root);
+	cost_qual_eval(&join_cost, fpinfo->joinclauses, root);
+
+	ce->startup_cost = fpinfo_o->rel_startup_cost + fpinfo_i->rel_startup_cost;
+	ce->startup_cost += join_cost.startup;
+	ce->startup_cost += remote_conds_cost.startup;
+	ce->startup_cost += fpinfo->local_conds_cost.startup;
+
+	/*
+	 * Run time cost includes the run time cost of the joined relations, of
+	 * applying the join clauses to their cross product, and of applying the
+	 * other conditions to the result of the join.
+	 */
+	ce->run_cost = fpinfo_o->rel_total_cost - fpinfo_o->rel_startup_cost;
+	ce->run_cost += fpinfo_i->rel_total_cost - fpinfo_i->rel_startup_cost;
+	ce->run_cost += nrows * join_cost.per_tuple;
+	nrows = clamp_row_est(nrows * fpinfo->joinclause_sel);
+	ce->run_cost += nrows * remote_conds_cost.per_tuple;
+	ce->run_cost += fpinfo->local_conds_cost.per_tuple * ce->retrieved_rows;
+
+	/* Add in tlist eval cost for each output row */
+	ce->startup_cost += rel->reltarget->cost.startup;
+	ce->run_cost += rel->reltarget->cost.per_tuple * ce->rows;
+}
+
 #define REL_HAS_CACHED_COSTS(fpinfo)                                                               \
 	((fpinfo)->rel_startup_cost >= 0 && (fpinfo)->rel_total_cost >= 0 &&                           \
 	 (fpinfo)->rel_retrieved_rows >= 0)
@@ -286,9 +337,10 @@ adjust_foreign_grouping_path_cost(PlannerInfo *root, List *pathkeys, double retr
 /*
  * fdw_estimate_path_cost_size
  *		Get cost and size estimates for a foreign scan on given foreign
- *		relation either a base relation or an upper relation containing
- *		foreign relations. Estimate rows using whatever statistics we have
- *      locally, in a way similar to ordinary tables.
+ *		relation either a base relation, a join of two base relations or an
+ *		upper relation containing foreign relations. Estimate rows using
+ *		whatever statistics we have locally, in a way similar to ordinary
+ *		tables.
  *
  * pathkeys specify the expected sort order if any for given path being costed.
  *
@@ -309,11 +361,6 @@ fdw_estimate_path_cost_size(PlannerInfo *root, RelOptInfo *rel, List *pathkeys,
 		.width = rel->reltarget->width,
 	};
 
-	if (IS_JOIN_REL(rel))
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("foreign joins are not supported")));
-
 	/*
 	 * We will come here again and again with different set of pathkeys
 	 * that caller wants to cost. We don't need to calculate the cost of
@@ -330,6 +377,8 @@ fdw_estimate_path_cost_size(PlannerInfo *root, RelOptInfo *rel, List *pathkeys,
 	}
 	else if (IS_UPPER_REL(rel))
 		get_upper_rel_estimate(root, rel, &ce);
+	else if (IS_JOIN_REL(rel))
+		get_join_rel_estimate(root, rel, &ce);
 	else
 		get_base_rel_estimate(root, rel, &ce);
 
@@ -372,6 +372,32 @@ get_foreign_upper_paths(PlannerInfo *root, UpperRelationKind stage, RelOptInfo *
 #endif
 }
 
+static bool
+is_data_node_rel(RelOptInfo *rel)
+{
+	TsFdwRelInfo *fpinfo = rel->fdw_private ? fdw_relinfo_get(rel) : NULL;
+
+	return fpinfo != NULL && fpinfo->type == TS_FDW_RELINFO_HYPERTABLE_DATA_NODE;
+}
+
+/*
+ * get_foreign_join_paths
+ *		Add a path for pushing down a join of two data node rels.
+ *
+ * Data node rels are only joined with each other when the distributed
+ * hypertables are co-located, i.e., partitionwise joins are possible and
+ * both sides are on the same data node.
+ */
+static void
+get_foreign_join_paths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+					   RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+{
+	if (!is_data_node_rel(outerrel) || !is_data_node_rel(innerrel))
+		return;
+
+	data_node_scan_create_join_paths(root, joinrel, outerrel, innerrel, jointype, extra);
+}
+
 static FdwRoutine timescaledb_fdw_routine = {
 	.type = T_FdwRoutine,
 	/* scan (mandatory) */
@@ -382,6 +408,7 @@ static FdwRoutine timescaledb_fdw_routine = {
 	.IterateForeignScan = iterate_foreign_scan,
 	.EndForeignScan = end_foreign_scan,
 	.ReScanForeignScan = rescan_foreign_scan,
+	.GetForeignJoinPaths = get_foreign_join_paths,
 	.GetForeignUpperPaths = get_foreign_upper_paths,
 	/* update */
 	.IsForeignRelUpdatable = is_foreign_rel_updatable,
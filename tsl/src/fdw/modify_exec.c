@@ -366,21 +366,15 @@ fdw_begin_foreign_modify(PlanState *pstate, ResultRelInfo *rri, CmdType operatio
 static PreparedStmt *
 prepare_foreign_modify_data_node(TsFdwModifyState *fmstate, TsFdwDataNodeState *fdw_data_node)
 {
-	AsyncRequest *req;
-
 	Assert(NULL == fdw_data_node->p_stmt);
 
-	req = async_request_send_prepare(fdw_data_node->conn,
-									 fmstate->query,
-									 stmt_params_num_params(fmstate->stmt_params));
-
-	Assert(NULL != req);
-
 	/*
 	 * Async request interface doesn't seem to allow waiting for multiple
 	 * prepared statements in an AsyncRequestSet. Should fix async API
 	 */
-	return async_request_wait_prepared_statement(req);
+	return async_request_get_prepared_statement(fdw_data_node->conn,
+												fmstate->query,
+												stmt_params_num_params(fmstate->stmt_params));
 }
 
 /*
@@ -19,6 +19,7 @@
 #include "scan_exec.h"
 #include "utils.h"
 #include "remote/data_fetcher.h"
+#include "remote/columnar_fetcher.h"
 #include "remote/copy_fetcher.h"
 #include "remote/cursor_fetcher.h"
 #include "guc.h"
@@ -152,6 +153,16 @@ create_data_fetcher(ScanState *ss, TsFdwScanState *fsstate)
 		}
 	}
 
+	/*
+	 * Columnar fetcher compresses the result columns on the data node, which
+	 * needs binary serialization of the column types. It is never picked
+	 * automatically, so there is nothing to fall back from.
+	 */
+	if (!tuplefactory_is_binary(tf) && fsstate->planned_fetcher_type == ColumnarFetcherType)
+		ereport(ERROR,
+				(errmsg("cannot use columnar fetcher because some of the column types do not "
+						"have binary serialization")));
+
 	/*
 	 * COPY fetcher uses COPY statement that don't work with prepared
 	 * statements. If this plan is parameterized, this means we'll have to
@@ -177,6 +188,10 @@ create_data_fetcher(ScanState *ss, TsFdwScanState *fsstate)
 	{
 		fetcher = cursor_fetcher_create_for_scan(fsstate->conn, fsstate->query, params, tf);
 	}
+	else if (fsstate->planned_fetcher_type == ColumnarFetcherType)
+	{
+		fetcher = columnar_fetcher_create_for_scan(fsstate->conn, fsstate->query, params, tf);
+	}
 	else
 	{
 		/*
@@ -247,11 +262,13 @@ fdw_scan_debug_override_current_timestamp(TimestampTz time)
 }
 #endif
 
-static TSConnection *
-get_connection(ScanState *ss, Oid const server_id, Bitmapset *scanrelids, List *exprs)
+/*
+ * Get the ID of the connection a scan will use.
+ */
+TSConnectionId
+fdw_scan_get_connection_id(Scan *scan, EState *estate, Bitmapset *scanrelids, List *fdw_private)
 {
-	Scan *scan = (Scan *) ss->ps.plan;
-	EState *estate = ss->ps.state;
+	Oid server_oid = intVal(list_nth(fdw_private, FdwScanPrivateServerId));
 	RangeTblEntry *rte;
 	TSConnectionId id;
 	int rtindex;
@@ -269,7 +286,16 @@ get_connection(ScanState *ss, Oid const server_id, Bitmapset *scanrelids, List *
 
 	rte = rt_fetch(rtindex, estate->es_range_table);
 
-	remote_connection_id_set(&id, server_id, rte->checkAsUser ? rte->checkAsUser : GetUserId());
+	remote_connection_id_set(&id, server_oid, rte->checkAsUser ? rte->checkAsUser : GetUserId());
+
+	return id;
+}
+
+static TSConnection *
+get_connection(ScanState *ss, Bitmapset *scanrelids, List *fdw_private, List *exprs)
+{
+	TSConnectionId id =
+		fdw_scan_get_connection_id((Scan *) ss->ps.plan, ss->ps.state, scanrelids, fdw_private);
 
 	return remote_dist_txn_get_connection(id,
 										  list_length(exprs) ? REMOTE_TXN_USE_PREP_STMT :
@@ -297,7 +323,8 @@ fdw_scan_init(ScanState *ss, TsFdwScanState *fsstate, Bitmapset *scanrelids, Lis
 	 * Get connection to the foreign server.  Connection manager will
 	 * establish new connection if necessary.
 	 */
-	fsstate->conn = get_connection(ss, server_oid, scanrelids, fdw_exprs);
+	fsstate->conn = get_connection(ss, scanrelids, fdw_private, fdw_exprs);
+	fsstate->netstats_start = *remote_connection_net_stats(fsstate->conn);
 
 	/* Get private info created by planner functions. */
 	fsstate->query = strVal(list_nth(fdw_private, FdwScanPrivateSelectSql));
@@ -448,12 +475,27 @@ explain_fetcher_type(DataFetcherType type)
 			return "COPY";
 		case CursorFetcherType:
 			return "Cursor";
+		case ColumnarFetcherType:
+			return "Columnar";
 		default:
 			Assert(false);
 			return "";
 	}
 }
 
+/*
+ * Show the network activity of a node. Like timings, the numbers vary
+ * between runs, so they are only shown with EXPLAIN (ANALYZE, TIMING).
+ */
+void
+fdw_explain_net_stats(const TSConnectionNetStats *netstats, ExplainState *es)
+{
+	ExplainPropertyInteger("Network Bytes Sent", NULL, netstats->bytes_sent, es);
+	ExplainPropertyInteger("Network Bytes Received", NULL, netstats->bytes_received, es);
+	ExplainPropertyInteger("Network Round Trips", NULL, netstats->round_trips, es);
+	ExplainPropertyFloat("Network Wait Time", "ms", netstats->wait_time / 1000.0, 3, es);
+}
+
 void
 fdw_scan_explain(ScanState *ss, List *fdw_private, ExplainState *es, TsFdwScanState *fsstate)
 {
@@ -469,6 +511,18 @@ fdw_scan_explain(ScanState *ss, List *fdw_private, ExplainState *es, TsFdwScanSt
 		ExplainPropertyText("Relations", relations, es);
 	}
 
+	/*
+	 * The connection can be shared with other scans of the same data node,
+	 * whose activity is then included.
+	 */
+	if (es->analyze && es->timing && fsstate && fsstate->conn)
+	{
+		TSConnectionNetStats netstats;
+
+		remote_connection_net_stats_since(fsstate->conn, &fsstate->netstats_start, &netstats);
+		fdw_explain_net_stats(&netstats, es);
+	}
+
 	/*
 	 * Add remote query, data node name, and chunks when VERBOSE option is specified.
 	 */
@@ -13,6 +13,7 @@
 #include <access/htup.h>
 #include <commands/explain.h>
 
+#include "remote/connection.h"
 #include "remote/data_fetcher.h"
 #include "guc.h"
 
@@ -46,8 +47,12 @@ typedef struct TsFdwScanState
 	 */
 	DataFetcherType planned_fetcher_type;
 	int row_counter;
+	/* Network statistics of the connection when the scan started */
+	TSConnectionNetStats netstats_start;
 } TsFdwScanState;
 
+extern TSConnectionId fdw_scan_get_connection_id(Scan *scan, EState *estate,
+												 Bitmapset *scanrelids, List *fdw_private);
 extern void fdw_scan_init(ScanState *ss, TsFdwScanState *fsstate, Bitmapset *scanrelids,
 						  List *fdw_private, List *fdw_exprs, int eflags);
 extern TupleTableSlot *fdw_scan_iterate(ScanState *ss, TsFdwScanState *fsstate);
@@ -55,6 +60,7 @@ extern void fdw_scan_rescan(ScanState *ss, TsFdwScanState *fsstate);
 extern void fdw_scan_end(TsFdwScanState *fsstate);
 extern void fdw_scan_explain(ScanState *ss, List *fdw_private, ExplainState *es,
 							 TsFdwScanState *fsstate);
+extern void fdw_explain_net_stats(const TSConnectionNetStats *netstats, ExplainState *es);
 
 extern DataFetcher *create_data_fetcher(ScanState *ss, TsFdwScanState *fsstate);
 
@@ -132,7 +132,7 @@ add_paths_with_pathkeys_for_rel(PlannerInfo *root, RelOptInfo *rel, Path *epq_pa
 
 		if (create_scan_path)
 		{
-			Assert(IS_SIMPLE_REL(rel));
+			Assert(IS_SIMPLE_REL(rel) || IS_JOIN_REL(rel));
 			scan_path = create_scan_path(root,
 										 rel,
 										 NULL,
@@ -435,6 +435,32 @@ eval_stable_functions(PlannerInfo *root, Node *node)
 	return eval_stable_functions_mutator(node, NULL);
 }
 
+/*
+ * Get the chunks scanned by a data node rel, or by the data node rels of a
+ * join.
+ */
+static List *
+get_chunk_oids(RelOptInfo *rel)
+{
+	TsFdwRelInfo *fpinfo = fdw_relinfo_get(rel);
+	List *chunk_oids = NIL;
+	ListCell *lc;
+
+	if (IS_JOIN_REL(rel))
+		return list_concat(get_chunk_oids(fpinfo->outerrel), get_chunk_oids(fpinfo->innerrel));
+
+	if (fpinfo->sca)
+	{
+		foreach (lc, fpinfo->sca->chunks)
+		{
+			Chunk *chunk = (Chunk *) lfirst(lc);
+			chunk_oids = lappend_oid(chunk_oids, chunk->table_id);
+		}
+	}
+
+	return chunk_oids;
+}
+
 void
 fdw_scan_info_init(ScanInfo *scaninfo, PlannerInfo *root, RelOptInfo *rel, Path *best_path,
 				   List *scan_clauses)
@@ -504,9 +530,23 @@ fdw_scan_info_init(ScanInfo *scaninfo, PlannerInfo *root, RelOptInfo *rel, Path
 	}
 	else if (IS_JOIN_REL(rel))
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("foreign joins are not supported")));
+		/*
+		 * Join relation - set scan_relid to 0.
+		 */
+		scan_relid = 0;
+
+		/*
+		 * Parameterized joins are not pushed down, so there are no
+		 * scan_clauses. The join clauses go into the ON clause and the
+		 * conditions of the joined relations into the WHERE clause. There
+		 * is no EPQ recheck since joins are only pushed down for SELECTs.
+		 */
+		Assert(!scan_clauses);
+		remote_where = extract_actual_clauses(fpinfo->remote_conds, false);
+		local_exprs = extract_actual_clauses(fpinfo->local_conds, false);
+
+		/* Build the list of columns to be fetched from the data node. */
+		fdw_scan_tlist = build_tlist_to_deparse(rel);
 	}
 	else
 	{
@@ -583,15 +623,7 @@ fdw_scan_info_init(ScanInfo *scaninfo, PlannerInfo *root, RelOptInfo *rel, Path
 	fpinfo->final_remote_exprs = remote_where;
 
 	/* Build the chunk oid list for use by EXPLAIN. */
-	List *chunk_oids = NIL;
-	if (fpinfo->sca)
-	{
-		foreach (lc, fpinfo->sca->chunks)
-		{
-			Chunk *chunk = (Chunk *) lfirst(lc);
-			chunk_oids = lappend_oid(chunk_oids, chunk->table_id);
-		}
-	}
+	List *chunk_oids = get_chunk_oids(rel);
 
 	/*
 	 * Build the fdw_private list that will be available to the executor.
@@ -602,9 +634,8 @@ fdw_scan_info_init(ScanInfo *scaninfo, PlannerInfo *root, RelOptInfo *rel, Path
 							 makeInteger(fpinfo->fetch_size),
 							 makeInteger(fpinfo->server->serverid),
 							 chunk_oids);
-	Assert(!IS_JOIN_REL(rel));
 
-	if (IS_UPPER_REL(rel))
+	if (IS_UPPER_REL(rel) || IS_JOIN_REL(rel))
 		fdw_private = lappend(fdw_private, makeString(fpinfo->relation_name->data));
 
 	scaninfo->fdw_private = fdw_private;
@@ -634,10 +665,6 @@ merge_fdw_options(TsFdwRelInfo *fpinfo, const TsFdwRelInfo *fpinfo_o, const TsFd
 	/* fpinfo_i may be NULL, but if present the servers must both match. */
 	Assert(!fpinfo_i || fpinfo_i->server->serverid == fpinfo_o->server->serverid);
 
-	/* Currently, we don't support JOINs, so Asserting fpinfo_i is NULL here
-	 * in the meantime. */
-	Assert(fpinfo_i == NULL);
-
 	/*
 	 * Copy the server specific FDW options. (For a join, both relations come
 	 * from the same server, so the server options should have the same value
@@ -988,3 +1015,153 @@ fdw_create_upper_paths(TsFdwRelInfo *input_fpinfo, PlannerInfo *root, UpperRelat
 			break;
 	}
 }
+
+/*
+ * Assess whether the join of the outer and inner relations can be pushed down
+ * to the data node. As a side effect, save information we obtain in this
+ * function to the TsFdwRelInfo of the join relation.
+ *
+ * Only inner joins of two scans on the same data node are pushed down, which
+ * is what a partitionwise join of co-located distributed hypertables gives.
+ * The chunks that each scan is assigned are part of the remote query.
+ */
+static bool
+foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel, JoinType jointype, RelOptInfo *outerrel,
+				RelOptInfo *innerrel, JoinPathExtraData *extra)
+{
+	TsFdwRelInfo *fpinfo = fdw_relinfo_get(joinrel);
+	TsFdwRelInfo *fpinfo_o = outerrel->fdw_private ? fdw_relinfo_get(outerrel) : NULL;
+	TsFdwRelInfo *fpinfo_i = innerrel->fdw_private ? fdw_relinfo_get(innerrel) : NULL;
+	Relids relids;
+	ListCell *lc;
+
+	if (jointype != JOIN_INNER || root->parse->commandType != CMD_SELECT)
+		return false;
+
+	if (fpinfo_o == NULL || fpinfo_i == NULL || !fpinfo_o->pushdown_safe ||
+		!fpinfo_i->pushdown_safe || fpinfo_o->sca == NULL || fpinfo_i->sca == NULL)
+		return false;
+
+	/*
+	 * The conditions of the joined relations that cannot be evaluated on the
+	 * data node have to be applied before the join.
+	 */
+	if (fpinfo_o->local_conds != NIL || fpinfo_i->local_conds != NIL)
+		return false;
+
+	/* Parameterized joins are not pushed down */
+	if (!bms_is_empty(joinrel->lateral_relids))
+		return false;
+
+	/*
+	 * A PlaceHolderVar that has to be evaluated at this join would need to be
+	 * computed on the data node.
+	 */
+	relids = IS_OTHER_REL(joinrel) ? joinrel->top_parent_relids : joinrel->relids;
+
+	foreach (lc, root->placeholder_list)
+	{
+		PlaceHolderInfo *phinfo = lfirst(lc);
+
+		if (bms_is_subset(phinfo->ph_eval_at, relids) &&
+			bms_nonempty_difference(relids, phinfo->ph_eval_at))
+			return false;
+	}
+
+	fpinfo->server = fpinfo_o->server;
+	merge_fdw_options(fpinfo, fpinfo_o, fpinfo_i);
+
+	/* All the join clauses have to be evaluated on the data node */
+	foreach (lc, extra->restrictlist)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		if (!ts_is_foreign_expr(root, joinrel, rinfo->clause))
+			return false;
+
+		fpinfo->joinclauses = lappend(fpinfo->joinclauses, rinfo);
+	}
+
+	fpinfo->outerrel = outerrel;
+	fpinfo->innerrel = innerrel;
+	fpinfo->jointype = jointype;
+	fpinfo->remote_conds =
+		list_concat(list_copy(fpinfo_o->remote_conds), list_copy(fpinfo_i->remote_conds));
+	fpinfo->local_conds = NIL;
+	fpinfo->make_outerrel_subquery = false;
+	fpinfo->make_innerrel_subquery = false;
+	fpinfo->lower_subquery_rels = NULL;
+	fpinfo->relation_index =
+		list_length(root->parse->rtable) + list_length(root->join_rel_list);
+
+	fpinfo->joinclause_sel =
+		clauselist_selectivity(root, fpinfo->joinclauses, 0, jointype, extra->sjinfo);
+	fpinfo->local_conds_sel = 1.0;
+
+	/*
+	 * Set the string describing this join relation to be used in EXPLAIN
+	 * output of the scan.
+	 */
+	fpinfo->relation_name = makeStringInfo();
+	appendStringInfo(fpinfo->relation_name,
+					 "(%s) %s JOIN (%s)",
+					 fpinfo_o->relation_name->data,
+					 get_jointype_name(jointype),
+					 fpinfo_i->relation_name->data);
+
+	fpinfo->pushdown_safe = true;
+
+	return true;
+}
+
+void
+fdw_create_join_paths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+					  RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra,
+					  CreatePathFunc create_path)
+{
+	TsFdwRelInfo *fpinfo;
+	Path *joinpath;
+
+	/*
+	 * Skip if this join combination has been considered already. The
+	 * relation info is created even if the join cannot be pushed down.
+	 */
+	if (joinrel->fdw_private != NULL && fdw_relinfo_get(joinrel) != NULL)
+		return;
+
+	fpinfo = fdw_relinfo_alloc_or_get(joinrel);
+	fpinfo->type = TS_FDW_RELINFO_HYPERTABLE_DATA_NODE;
+	fpinfo->pushdown_safe = false;
+
+	if (!foreign_join_ok(root, joinrel, jointype, outerrel, innerrel, extra))
+		return;
+
+	/* Set cached relation costs to some negative value */
+	fpinfo->rel_startup_cost = -1;
+	fpinfo->rel_total_cost = -1;
+	fpinfo->rel_retrieved_rows = -1;
+
+	fdw_estimate_path_cost_size(root,
+								joinrel,
+								NIL,
+								&fpinfo->rows,
+								&fpinfo->width,
+								&fpinfo->startup_cost,
+								&fpinfo->total_cost);
+
+	joinpath = create_path(root,
+						   joinrel,
+						   NULL, /* default pathtarget */
+						   fpinfo->rows,
+						   fpinfo->startup_cost,
+						   fpinfo->total_cost,
+						   NIL, /* no pathkeys */
+						   NULL,
+						   NULL, /* no EPQ path */
+						   NIL);
+
+	fdw_utils_add_path(joinrel, joinpath);
+
+	/* Add paths with pathkeys */
+	fdw_add_paths_with_pathkeys_for_rel(root, joinrel, NULL, create_path);
+}
@@ -52,5 +52,8 @@ extern void fdw_create_upper_paths(TsFdwRelInfo *input_fpinfo, PlannerInfo *root
 								   UpperRelationKind stage, RelOptInfo *input_rel,
 								   RelOptInfo *output_rel, void *extra,
 								   CreateUpperPathFunc create_paths);
+extern void fdw_create_join_paths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+								  RelOptInfo *innerrel, JoinType jointype,
+								  JoinPathExtraData *extra, CreatePathFunc create_path);
 
 #endif /* TIMESCALEDB_TSL_FDW_SCAN_PLAN_H */
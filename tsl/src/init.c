@@ -12,6 +12,10 @@
 #include "bgw_policy/retention_api.h"
 #include "bgw_policy/job.h"
 #include "bgw_policy/job_api.h"
+#include "bgw_policy/chunk_precreation_api.h"
+#include "bgw_policy/distributed_stats_api.h"
+#include "bgw_policy/vacuum_api.h"
+#include "bgw_policy/invalidation_log_api.h"
 #include "bgw_policy/reorder_api.h"
 #include "bgw_policy/policies_v2.h"
 #include "chunk.h"
@@ -40,6 +44,7 @@
 #include "license_guc.h"
 #include "nodes/decompress_chunk/planner.h"
 #include "nodes/skip_scan/skip_scan.h"
+#include "nodes/vector_agg/vector_agg.h"
 #include "nodes/gapfill/gapfill_functions.h"
 #include "partialize_finalize.h"
 #include "planner.h"
@@ -99,22 +104,43 @@ CrossModuleFunctions tsl_cm_functions = {
 	.policy_compression_remove = policy_compression_remove,
 	.policy_recompression_proc = policy_recompression_proc,
 	.policy_compression_check = policy_compression_check,
+	.policy_compression_batch_add = policy_compression_batch_add,
+	.policy_compression_batch_remove = policy_compression_batch_remove,
+	.policy_compression_batch_check = policy_compression_batch_check,
 	.policy_refresh_cagg_add = policy_refresh_cagg_add,
 	.policy_refresh_cagg_proc = policy_refresh_cagg_proc,
+	.policy_refresh_cagg_window_proc = policy_refresh_cagg_window_proc,
 	.policy_refresh_cagg_check = policy_refresh_cagg_check,
 	.policy_refresh_cagg_remove = policy_refresh_cagg_remove,
 	.policy_reorder_add = policy_reorder_add,
 	.policy_reorder_proc = policy_reorder_proc,
 	.policy_reorder_check = policy_reorder_check,
 	.policy_reorder_remove = policy_reorder_remove,
+	.policy_chunk_precreation_add = policy_chunk_precreation_add,
+	.policy_chunk_precreation_proc = policy_chunk_precreation_proc,
+	.policy_chunk_precreation_check = policy_chunk_precreation_check,
+	.policy_chunk_precreation_remove = policy_chunk_precreation_remove,
+	.policy_distributed_stats_add = policy_distributed_stats_add,
+	.policy_distributed_stats_proc = policy_distributed_stats_proc,
+	.policy_distributed_stats_check = policy_distributed_stats_check,
+	.policy_distributed_stats_remove = policy_distributed_stats_remove,
+	.policy_invalidation_log_compaction_add = policy_invalidation_log_compaction_add,
+	.policy_invalidation_log_compaction_proc = policy_invalidation_log_compaction_proc,
+	.policy_invalidation_log_compaction_check = policy_invalidation_log_compaction_check,
+	.policy_invalidation_log_compaction_remove = policy_invalidation_log_compaction_remove,
 	.policy_retention_add = policy_retention_add,
 	.policy_retention_proc = policy_retention_proc,
 	.policy_retention_check = policy_retention_check,
 	.policy_retention_remove = policy_retention_remove,
+	.policy_vacuum_add = policy_vacuum_add,
+	.policy_vacuum_proc = policy_vacuum_proc,
+	.policy_vacuum_check = policy_vacuum_check,
+	.policy_vacuum_remove = policy_vacuum_remove,
 
 	.job_add = job_add,
 	.job_alter = job_alter,
 	.job_alter_set_hypertable_id = job_alter_set_hypertable_id,
+	.job_set_concurrency_class = job_set_concurrency_class,
 	.job_delete = job_delete,
 	.job_run = job_run,
 	.job_execute = job_execute,
@@ -149,6 +175,7 @@ CrossModuleFunctions tsl_cm_functions = {
 	.process_cagg_viewstmt = tsl_process_continuous_agg_viewstmt,
 	.continuous_agg_invalidation_trigger = continuous_agg_trigfn,
 	.continuous_agg_call_invalidation_trigger = execute_cagg_trigger,
+	.continuous_agg_add_invalidation_range = continuous_agg_add_invalidation_range,
 	.continuous_agg_refresh = continuous_agg_refresh,
 	.continuous_agg_invalidate_raw_ht = continuous_agg_invalidate_raw_ht,
 	.continuous_agg_invalidate_mat_ht = continuous_agg_invalidate_mat_ht,
@@ -168,6 +195,8 @@ CrossModuleFunctions tsl_cm_functions = {
 	.compressed_data_recv = tsl_compressed_data_recv,
 	.compressed_data_in = tsl_compressed_data_in,
 	.compressed_data_out = tsl_compressed_data_out,
+	.compressed_data_agg_transfn = tsl_compressed_data_agg_transfn,
+	.compressed_data_agg_finalfn = tsl_compressed_data_agg_finalfn,
 	.deltadelta_compressor_append = tsl_deltadelta_compressor_append,
 	.deltadelta_compressor_finish = tsl_deltadelta_compressor_finish,
 	.gorilla_compressor_append = tsl_gorilla_compressor_append,
@@ -181,10 +210,13 @@ CrossModuleFunctions tsl_cm_functions = {
 	.process_rename_cmd = tsl_process_rename_cmd,
 	.compress_chunk = tsl_compress_chunk,
 	.decompress_chunk = tsl_decompress_chunk,
+	.recompress_chunk_segmentwise = tsl_recompress_chunk_segmentwise,
+	.bloom1_contains = tsl_bloom1_contains,
 	.compress_row_init = compress_row_init,
 	.compress_row_exec = compress_row_exec,
 	.compress_row_end = compress_row_end,
 	.compress_row_destroy = compress_row_destroy,
+	.decompress_batches_for_insert = tsl_decompress_batches_for_insert,
 	.data_node_add = data_node_add,
 	.data_node_delete = data_node_delete,
 	.data_node_attach = data_node_attach,
@@ -201,6 +233,8 @@ CrossModuleFunctions tsl_cm_functions = {
 	.chunk_drop_replica = chunk_drop_replica,
 	.chunk_freeze_chunk = chunk_freeze_chunk,
 	.chunk_unfreeze_chunk = chunk_unfreeze_chunk,
+	.chunk_merge_chunks = chunk_merge_chunks,
+	.chunk_rebalance_chunks = chunk_rebalance_chunks,
 	.chunks_drop_stale = chunk_drop_stale_chunks,
 	.hypertable_make_distributed = hypertable_make_distributed,
 	.get_and_validate_data_node_list = hypertable_get_and_validate_data_nodes,
@@ -209,6 +243,7 @@ CrossModuleFunctions tsl_cm_functions = {
 	.remote_txn_id_in = remote_txn_id_in_pg,
 	.remote_txn_id_out = remote_txn_id_out_pg,
 	.remote_txn_heal_data_node = remote_txn_heal_data_node,
+	.remote_txn_heal_data_nodes = remote_txn_heal_data_nodes,
 	.remote_connection_cache_show = remote_connection_cache_show,
 	.set_rel_pathlist = tsl_set_rel_pathlist,
 	.distributed_insert_path_create = tsl_create_distributed_insert_path,
@@ -236,6 +271,7 @@ CrossModuleFunctions tsl_cm_functions = {
 	.hypertable_distributed_set_replication_factor = hypertable_set_replication_factor,
 	.cache_syscache_invalidate = cache_syscache_invalidate,
 	.update_compressed_chunk_relstats = update_compressed_chunk_relstats,
+	.compressed_chunk_drop_batches = tsl_compressed_chunk_drop_batches,
 	.health_check = ts_dist_health_check,
 };
 
@@ -260,6 +296,7 @@ ts_module_init(PG_FUNCTION_ARGS)
 	_continuous_aggs_cache_inval_init();
 	_decompress_chunk_init();
 	_skip_scan_init();
+	_vector_agg_init();
 	_remote_connection_cache_init();
 	_remote_dist_txn_init();
 	_tsl_process_utility_init();
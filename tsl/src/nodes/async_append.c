@@ -12,6 +12,7 @@
 #include <optimizer/pathnode.h>
 #include <optimizer/prep.h>
 #include <foreign/fdwapi.h>
+#include <foreign/foreign.h>
 #include <access/sysattr.h>
 #include <miscadmin.h>
 
@@ -19,6 +20,8 @@
 #include "fdw/scan_plan.h"
 #include "fdw/scan_exec.h"
 #include "fdw/data_node_scan_plan.h"
+#include "remote/connection_cache.h"
+#include "guc.h"
 #include "planner.h"
 #include "cache.h"
 #include "hypertable.h"
@@ -161,6 +164,9 @@ find_data_node_scan_state_child(PlanState *state)
 			case T_AggState:
 			case T_ResultState:
 			case T_SortState:
+#if PG13_GE
+			case T_IncrementalSortState:
+#endif
 				/* Data scan state can be buried under AggState or SortState  */
 				return find_data_node_scan_state_child(state->lefttree);
 			default:
@@ -205,6 +211,63 @@ get_data_node_async_scan_states(AsyncAppendState *state)
 	return dn_plans;
 }
 
+/*
+ * Collect the IDs of the connections used by the DataNodeScans in a plan.
+ */
+static List *
+get_data_node_scan_connection_ids(Plan *plan, EState *estate, List *conn_ids)
+{
+	ListCell *lc;
+
+	if (plan == NULL)
+		return conn_ids;
+
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			foreach (lc, castNode(Append, plan)->appendplans)
+				conn_ids = get_data_node_scan_connection_ids(lfirst(lc), estate, conn_ids);
+			break;
+		case T_MergeAppend:
+			foreach (lc, castNode(MergeAppend, plan)->mergeplans)
+				conn_ids = get_data_node_scan_connection_ids(lfirst(lc), estate, conn_ids);
+			break;
+		case T_Agg:
+		case T_Result:
+		case T_Sort:
+#if PG13_GE
+		case T_IncrementalSort:
+#endif
+			conn_ids = get_data_node_scan_connection_ids(plan->lefttree, estate, conn_ids);
+			break;
+		case T_CustomScan:
+		{
+			CustomScan *cscan = castNode(CustomScan, plan);
+			TSConnectionId *id;
+
+			if (strcmp(cscan->methods->CustomName, "DataNodeScan") != 0)
+				break;
+
+			id = palloc(sizeof(TSConnectionId));
+			*id = fdw_scan_get_connection_id(&cscan->scan,
+											 estate,
+											 cscan->custom_relids,
+											 list_nth(cscan->custom_private,
+													  DataNodeScanFdwPrivate));
+
+			/* Unavailable data nodes are reported when the scan is
+			 * initialized */
+			if (ts_data_node_is_available_by_server(GetForeignServer(id->server_id)))
+				conn_ids = lappend(conn_ids, id);
+			break;
+		}
+		default:
+			break;
+	}
+
+	return conn_ids;
+}
+
 static void
 async_append_begin(CustomScanState *node, EState *estate, int eflags)
 {
@@ -217,10 +280,25 @@ async_append_begin(CustomScanState *node, EState *estate, int eflags)
 	Assert(list_length(cscan->custom_plans) == 1);
 
 	subplan = linitial(cscan->custom_plans);
+
+	/* Initializing the DataNodeScans opens the data node connections one by
+	 * one, so open the missing ones concurrently first */
+	if (ts_guc_enable_parallel_connect &&
+		(!(eflags & EXEC_FLAG_EXPLAIN_ONLY) || ts_guc_enable_remote_explain))
+		remote_connection_cache_open_connections(
+			get_data_node_scan_connection_ids(subplan, estate, NIL));
+
 	subplan_state = ExecInitNode(subplan, estate, eflags);
 	state->subplan_state = subplan_state;
 	state->css.custom_ps = list_make1(state->subplan_state);
 	state->data_node_scans = get_data_node_async_scan_states(state);
+
+	/* Limit the number of data node requests issued up front. The remaining
+	 * scans start their requests when the subplan first reads from them. */
+	if (ts_guc_async_append_max_fanout > 0 &&
+		list_length(state->data_node_scans) > ts_guc_async_append_max_fanout)
+		state->data_node_scans =
+			list_truncate(state->data_node_scans, ts_guc_async_append_max_fanout);
 }
 
 static void
@@ -452,11 +530,24 @@ path_process(PlannerInfo *root, Path **path)
 
 	child = linitial(children);
 
-	/* sometimes data node scan is buried under ProjectionPath or AggPath */
-	if (IsA(child, ProjectionPath))
-		child = castNode(ProjectionPath, child)->subpath;
-	else if (IsA(child, AggPath))
-		child = castNode(AggPath, child)->subpath;
+	/* Sometimes data node scan is buried under ProjectionPath or AggPath, or
+	 * under a SortPath for a MergeAppend when the ordering could not be
+	 * pushed down to the data nodes */
+	for (;;)
+	{
+		if (IsA(child, ProjectionPath))
+			child = castNode(ProjectionPath, child)->subpath;
+		else if (IsA(child, AggPath))
+			child = castNode(AggPath, child)->subpath;
+		else if (IsA(child, SortPath))
+			child = castNode(SortPath, child)->subpath;
+#if PG13_GE
+		else if (IsA(child, IncrementalSortPath))
+			child = castNode(IncrementalSortPath, child)->spath.subpath;
+#endif
+		else
+			break;
+	}
 
 	if (!is_data_node_scan_path(child))
 		return;
@@ -5,23 +5,59 @@
  */
 
 #include <postgres.h>
+#include <access/skey.h>
+#include <access/stratnum.h>
+#include <access/xact.h>
+#include <executor/executor.h>
 #include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <optimizer/optimizer.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
 
 #include "compat/compat.h"
 #include "chunk.h"
+#include "compression/api.h"
+#include "compression/create.h"
+#include "guc.h"
 #include "hypertable.h"
 #include "ts_catalog/hypertable_compression.h"
 #include "compress_dml.h"
 #include "utils.h"
 
-/*Path, Plan and State node for processing dml on compressed chunks
- * For now, this just blocks updates/deletes on compressed chunks
- * since trigger based approach does not work
+/*
+ * Path, Plan and State node for processing dml on compressed chunks.
+ *
+ * Unless timescaledb.enable_dml_decompression is set, this blocks
+ * updates/deletes on compressed chunks since trigger based approach does not
+ * work. Otherwise, the compressed batches that can contain modified rows are
+ * moved to the uncompressed chunk when the node is initialized, before any
+ * row is modified. The batches are found using the restrictions of the
+ * statement on segment by columns, and on the min and max metadata of order
+ * by columns. The modified rows then stay in the uncompressed chunk until the
+ * chunk is recompressed.
  */
 
-static Path *compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid);
+/* A filter on the compressed chunk, stored as a list in custom_private */
+enum BatchFilterIndex
+{
+	BatchFilterColumnName,
+	BatchFilterStrategy,
+	BatchFilterOperator,
+	BatchFilterCollation,
+	BatchFilterValue
+};
+
+enum CompressChunkDmlPrivateIndex
+{
+	CompressChunkDmlChunkRelid,
+	CompressChunkDmlDecompress,
+	CompressChunkDmlBatchFilters
+};
+
+static Path *compress_chunk_dml_path_create(Path *subpath, Chunk *chunk);
 static Plan *compress_chunk_dml_plan_create(PlannerInfo *root, RelOptInfo *relopt,
 											CustomPath *best_path, List *tlist, List *clauses,
 											List *custom_plans);
@@ -32,6 +68,14 @@ static TupleTableSlot *compress_chunk_dml_exec(CustomScanState *node);
 static void compress_chunk_dml_end(CustomScanState *node);
 static void compress_chunk_dml_rescan(CustomScanState *node);
 
+/*
+ * Compressed chunks whose batches in the range modified by the current
+ * statement were moved to the uncompressed chunk beforehand, see
+ * decompress_chunk_range(). DML on these chunks only touches uncompressed rows
+ * and is not blocked.
+ */
+static List *decompressed_chunk_relids = NIL;
+
 static CustomPathMethods compress_chunk_dml_path_methods = {
 	.CustomName = "CompressChunkDml",
 	.PlanCustomPath = compress_chunk_dml_plan_create,
@@ -50,11 +94,75 @@ static CustomExecMethods compress_chunk_dml_state_methods = {
 	.ReScanCustomScan = compress_chunk_dml_rescan,
 };
 
+/*
+ * Move the compressed batches matching the batch filters to the uncompressed
+ * chunk.
+ *
+ * The decompressed rows are inserted with the command id of the current
+ * statement, so advance the command id and make the rows visible to the scans
+ * of the statement, which have not started yet. Rows modified by the
+ * statement use the new command id.
+ */
+static void
+compress_chunk_dml_decompress_batches(CompressChunkDmlState *state, EState *estate)
+{
+	Chunk *chunk = ts_chunk_get_by_relid(state->chunk_relid, true);
+	Chunk *compressed_chunk;
+	ScanKeyData *scankeys;
+	int num_scankeys = 0;
+	ListCell *lc;
+
+	/* the chunk could have been decompressed since planning */
+	if (!ts_chunk_is_compressed(chunk))
+		return;
+
+	compressed_chunk = ts_chunk_get_by_id(chunk->fd.compressed_chunk_id, true);
+	scankeys = palloc0(sizeof(ScanKeyData) * Max(list_length(state->batch_filters), 1));
+
+	foreach (lc, state->batch_filters)
+	{
+		List *filter = lfirst(lc);
+		const char *column_name = strVal(list_nth(filter, BatchFilterColumnName));
+		Const *value = list_nth_node(Const, filter, BatchFilterValue);
+		AttrNumber attno = get_attnum(compressed_chunk->table_id, column_name);
+
+		if (attno == InvalidAttrNumber)
+			elog(ERROR,
+				 "missing column \"%s\" in compressed chunk \"%s\"",
+				 column_name,
+				 get_rel_name(compressed_chunk->table_id));
+
+		ScanKeyEntryInitialize(&scankeys[num_scankeys++],
+							   0,
+							   attno,
+							   intVal(list_nth(filter, BatchFilterStrategy)),
+							   InvalidOid,
+							   (Oid) intVal(list_nth(filter, BatchFilterCollation)),
+							   get_opcode((Oid) intVal(list_nth(filter, BatchFilterOperator))),
+							   value->constvalue);
+	}
+
+	if (decompress_chunk_batches(chunk, compressed_chunk, scankeys, num_scankeys))
+	{
+		CommandCounterIncrement();
+		estate->es_output_cid = GetCurrentCommandId(true);
+		estate->es_snapshot->curcid = estate->es_output_cid;
+	}
+
+	pfree(scankeys);
+}
+
 static void
 compress_chunk_dml_begin(CustomScanState *node, EState *estate, int eflags)
 {
+	CompressChunkDmlState *state = (CompressChunkDmlState *) node;
 	CustomScan *cscan = castNode(CustomScan, node->ss.ps.plan);
 	Plan *subplan = linitial(cscan->custom_plans);
+
+	/* decompress before the scans of the chunk are initialized */
+	if (state->decompress && !(eflags & EXEC_FLAG_EXPLAIN_ONLY))
+		compress_chunk_dml_decompress_batches(state, estate);
+
 	node->custom_ps = list_make1(ExecInitNode(subplan, estate, eflags));
 }
 
@@ -67,14 +175,19 @@ compress_chunk_dml_rescan(CustomScanState *node)
 }
 
 /* we cannot update/delete rows if we have a compressed chunk. so
- * throw an error. Note this subplan will return 0 tuples as the chunk is empty
- * and all rows are saved in the compressed chunk.
+ * throw an error unless the affected batches were decompressed. Note this
+ * subplan will return 0 tuples as the chunk is empty and all rows are saved in
+ * the compressed chunk.
  */
 static TupleTableSlot *
 compress_chunk_dml_exec(CustomScanState *node)
 {
 	CompressChunkDmlState *state = (CompressChunkDmlState *) node;
 	Oid chunk_relid = state->chunk_relid;
+
+	if (state->decompress)
+		return ExecProcNode(linitial(node->custom_ps));
+
 	elog(ERROR,
 		 "cannot update/delete rows from chunk \"%s\" as it is compressed",
 		 get_rel_name(chunk_relid));
@@ -90,7 +203,7 @@ compress_chunk_dml_end(CustomScanState *node)
 }
 
 static Path *
-compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid)
+compress_chunk_dml_path_create(Path *subpath, Chunk *chunk)
 {
 	CompressChunkDmlPath *path = (CompressChunkDmlPath *) palloc0(sizeof(CompressChunkDmlPath));
 
@@ -102,11 +215,175 @@ compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid)
 	// path->cpath.path.param_info = subpath->param_info;
 	path->cpath.methods = &compress_chunk_dml_path_methods;
 	path->cpath.custom_paths = list_make1(subpath);
-	path->chunk_relid = chunk_relid;
+	path->chunk_relid = chunk->table_id;
+	path->hypertable_id = chunk->fd.hypertable_id;
+	path->decompress = ts_guc_enable_dml_decompression;
 
 	return &path->cpath.path;
 }
 
+static List *
+make_batch_filter(const char *column_name, StrategyNumber strategy, Oid opno, Oid collation,
+				  Const *value)
+{
+	List *filter = list_make4(makeString(pstrdup(column_name)),
+							  makeInteger(strategy),
+							  makeInteger(opno),
+							  makeInteger(collation));
+
+	return lappend(filter, value);
+}
+
+/*
+ * Build the filters on the compressed chunk for the restrictions of the
+ * modified chunk that compare a column with a constant.
+ *
+ * Restrictions on segment by columns are applied to the same column of the
+ * compressed chunk. Restrictions on order by columns are applied to the min
+ * and max metadata: a batch can contain a value less than the constant only
+ * if its min is less than the constant, and so on. All other restrictions are
+ * ignored, which only means that more batches are decompressed.
+ */
+static List *
+compress_chunk_dml_batch_filters(CompressChunkDmlPath *cdpath, Index relid, List *clauses)
+{
+	List *settings = ts_hypertable_compression_get(cdpath->hypertable_id);
+	List *filters = NIL;
+	ListCell *lc;
+
+	foreach (lc, clauses)
+	{
+		Expr *clause = lfirst(lc);
+		FormData_hypertable_compression *colinfo = NULL;
+		OpExpr *op;
+		Expr *left, *right;
+		Var *var;
+		Const *value;
+		Oid opno, lefttype, righttype;
+		TypeCacheEntry *tce;
+		StrategyNumber strategy;
+		char *column_name;
+		ListCell *lc_setting;
+
+		if (IsA(clause, RestrictInfo))
+			clause = castNode(RestrictInfo, clause)->clause;
+
+		if (!IsA(clause, OpExpr) || list_length(castNode(OpExpr, clause)->args) != 2)
+			continue;
+
+		op = castNode(OpExpr, clause);
+		opno = op->opno;
+		left = linitial(op->args);
+		right = lsecond(op->args);
+
+		/* normalize to "column op constant" */
+		if (IsA(left, Const) && IsA(right, Var))
+		{
+			Expr *tmp = left;
+
+			opno = get_commutator(opno);
+			left = right;
+			right = tmp;
+		}
+
+		if (!OidIsValid(opno) || !IsA(left, Var) || !IsA(right, Const))
+			continue;
+
+		var = castNode(Var, left);
+		value = castNode(Const, right);
+
+		if ((Index) var->varno != relid || var->varattno <= 0 || var->varlevelsup != 0 ||
+			value->constisnull)
+			continue;
+
+		column_name = get_attname(cdpath->chunk_relid, var->varattno, false);
+
+		foreach (lc_setting, settings)
+		{
+			FormData_hypertable_compression *fd = lfirst(lc_setting);
+
+			if (namestrcmp(&fd->attname, column_name) == 0)
+				colinfo = fd;
+		}
+
+		if (colinfo == NULL)
+			continue;
+
+		tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+		if (!OidIsValid(tce->btree_opf))
+			continue;
+
+		strategy = get_op_opfamily_strategy(opno, tce->btree_opf);
+		if (strategy == InvalidStrategy)
+			continue;
+
+		op_input_types(opno, &lefttype, &righttype);
+
+		if (colinfo->segmentby_column_index > 0)
+		{
+			filters = lappend(filters,
+							  make_batch_filter(column_name,
+												strategy,
+												opno,
+												op->inputcollid,
+												value));
+			continue;
+		}
+
+		if (colinfo->orderby_column_index <= 0)
+			continue;
+
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+				filters = lappend(filters,
+								  make_batch_filter(compression_column_segment_min_name(colinfo),
+													strategy,
+													opno,
+													op->inputcollid,
+													value));
+				break;
+			case BTGreaterStrategyNumber:
+			case BTGreaterEqualStrategyNumber:
+				filters = lappend(filters,
+								  make_batch_filter(compression_column_segment_max_name(colinfo),
+													strategy,
+													opno,
+													op->inputcollid,
+													value));
+				break;
+			case BTEqualStrategyNumber:
+				/* the batch contains the value only if min <= value <= max */
+				filters =
+					lappend(filters,
+							make_batch_filter(compression_column_segment_min_name(colinfo),
+											  BTLessEqualStrategyNumber,
+											  get_opfamily_member(tce->btree_opf,
+																  lefttype,
+																  righttype,
+																  BTLessEqualStrategyNumber),
+											  op->inputcollid,
+											  value));
+				filters =
+					lappend(filters,
+							make_batch_filter(compression_column_segment_max_name(colinfo),
+											  BTGreaterEqualStrategyNumber,
+											  get_opfamily_member(tce->btree_opf,
+																  lefttype,
+																  righttype,
+																  BTGreaterEqualStrategyNumber),
+											  op->inputcollid,
+											  value));
+				break;
+			default:
+				break;
+		}
+	}
+
+	return filters;
+}
+
 static Plan *
 compress_chunk_dml_plan_create(PlannerInfo *root, RelOptInfo *relopt, CustomPath *best_path,
 							   List *tlist, List *clauses, List *custom_plans)
@@ -121,7 +398,13 @@ compress_chunk_dml_plan_create(PlannerInfo *root, RelOptInfo *relopt, CustomPath
 	cscan->scan.scanrelid = relopt->relid;
 	cscan->scan.plan.targetlist = tlist;
 	cscan->custom_scan_tlist = NIL;
-	cscan->custom_private = list_make1_oid(cdpath->chunk_relid);
+	cscan->custom_private = list_make3(makeInteger(cdpath->chunk_relid),
+									   makeInteger(cdpath->decompress),
+									   cdpath->decompress ?
+										   compress_chunk_dml_batch_filters(cdpath,
+																			relopt->relid,
+																			clauses) :
+										   NIL);
 	return &cscan->scan.plan;
 }
 
@@ -131,7 +414,10 @@ compress_chunk_dml_state_create(CustomScan *scan)
 	CompressChunkDmlState *state;
 
 	state = (CompressChunkDmlState *) newNode(sizeof(CompressChunkDmlState), T_CustomScanState);
-	state->chunk_relid = linitial_oid(scan->custom_private);
+	state->chunk_relid =
+		(Oid) intVal(list_nth(scan->custom_private, CompressChunkDmlChunkRelid));
+	state->decompress = intVal(list_nth(scan->custom_private, CompressChunkDmlDecompress));
+	state->batch_filters = list_nth(scan->custom_private, CompressChunkDmlBatchFilters);
 	state->cscan_state.methods = &compress_chunk_dml_state_methods;
 	return (Node *) state;
 }
@@ -140,5 +426,17 @@ Path *
 compress_chunk_dml_generate_paths(Path *subpath, Chunk *chunk)
 {
 	Assert(chunk->fd.compressed_chunk_id > 0);
-	return compress_chunk_dml_path_create(subpath, chunk->table_id);
+	return compress_chunk_dml_path_create(subpath, chunk);
+}
+
+void
+compress_chunk_dml_set_decompressed_chunks(List *chunk_relids)
+{
+	decompressed_chunk_relids = chunk_relids;
+}
+
+bool
+compress_chunk_dml_is_decompressed_chunk(Oid chunk_relid)
+{
+	return list_member_oid(decompressed_chunk_relids, chunk_relid);
 }
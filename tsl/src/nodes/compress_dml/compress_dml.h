@@ -16,15 +16,22 @@ typedef struct CompressChunkDmlPath
 {
 	CustomPath cpath;
 	Oid chunk_relid;
+	int32 hypertable_id;
+	/* decompress the affected batches instead of raising an error */
+	bool decompress;
 } CompressChunkDmlPath;
 
 typedef struct CompressChunkDmlState
 {
 	CustomScanState cscan_state;
 	Oid chunk_relid;
+	bool decompress;
+	List *batch_filters;
 } CompressChunkDmlState;
 
 Path *compress_chunk_dml_generate_paths(Path *subpath, Chunk *chunk);
+void compress_chunk_dml_set_decompressed_chunks(List *chunk_relids);
+bool compress_chunk_dml_is_decompressed_chunk(Oid chunk_relid);
 
 #define COMPRESS_CHUNK_DML_STATE_NAME "CompressChunkDmlState"
 #endif
@@ -35,6 +35,7 @@
 #include "remote/utils.h"
 #include "remote/dist_txn.h"
 #include "remote/async.h"
+#include "remote/connection.h"
 #include "remote/data_format.h"
 #include "remote/tuplefactory.h"
 
@@ -126,7 +127,16 @@ typedef struct DataNodeDispatchPath
  *   soon as a tuple store is filled instead of continuing to fill until more
  *   stores can be flushed. Further, after flushing tuples for a data node, the
  *   code immediately waits for a response instead of doing other work while
- *   waiting.
+ *   waiting. When there is no RETURNING clause, this can be mitigated by
+ *   setting timescaledb.max_insert_pipeline_depth, which sends several
+ *   batches in libpq pipeline mode before waiting for the responses. The
+ *   pipelined batches share a sync point each, so a failing batch does not
+ *   abort the batches that follow it, but the error is still raised when the
+ *   responses are read. Without pipelining, timescaledb.enable_async_insert_flush
+ *   double buffers the batches instead: a batch is sent without waiting for
+ *   the response, and the response is only read when the next batch for the
+ *   same data node is sent, so the next batch fills while the previous one
+ *   is in flight.
  *
  * - Currently, there is one "global" state machine for the
  *   DataNodeDispatchState executor node. Turning this into per-node state
@@ -158,6 +168,8 @@ typedef struct DataNodeDispatchState
 	DeparsedInsertStmt stmt; /* Partially deparsed insert statement */
 	const char *sql_stmt;	 /* Fully deparsed insert statement */
 	TupleFactory *tupfactory;
+	/* Insert statements for partial batches, indexed by the number of tuples */
+	const char **last_flush_sql;
 	List *target_attrs;		  /* The attributes to send to remote data nodes */
 	List *responses;		  /* List of responses to process in RETURNING state */
 	HTAB *nodestates;		  /* Hashtable of per-nodestate (tuple stores) */
@@ -169,6 +181,12 @@ typedef struct DataNodeDispatchState
 	int replication_factor;	  /* > 1 if we replicate tuples across data nodes */
 	StmtParams *stmt_params;  /* Parameters to send with statement. Format can be binary or text */
 	int flush_threshold;	  /* Batch size used for this dispatch state */
+	int pipeline_depth;		  /* Max batches in flight per data node, 1 if
+							   * pipelining is disabled */
+	MemoryContext pipeline_mcxt;	 /* Memory context for pipelined requests */
+	AsyncRequestSet *pipeline_reqset; /* Pipelined requests in flight */
+	bool async_flush;				  /* Keep one batch per data node in flight
+									   * while filling the next one */
 	TupleTableSlot *batch_slot; /* Slot used for sending tuples to data
 								 * nodes. Note that this needs to be a
 								 * MinimalTuple slot, so we cannot use the
@@ -187,7 +205,8 @@ enum CustomScanPrivateIndex
 	CustomScanPrivateTargetAttrs,
 	CustomScanPrivateDeparsedInsertStmt,
 	CustomScanPrivateSetProcessed,
-	CustomScanPrivateFlushThreshold
+	CustomScanPrivateFlushThreshold,
+	CustomScanPrivateSingleRowSql
 };
 
 #define HAS_RETURNING(sds) ((sds)->stmt.returning != NULL)
@@ -223,7 +242,13 @@ typedef struct DataNodeState
 	int num_tuples_inserted;		   /* Number of tuples inserted (returned in result)
 										* during the FLUSH or LAST_FLUSH states */
 	int next_tuple;					   /* The next tuple to return in the RETURNING state */
+	int num_batches_in_flight;		   /* Number of pipelined batches awaiting a
+										* response */
+	AsyncRequest *flush_req;		   /* Batch in flight with async flush */
+	MemoryContext flush_mcxt;		   /* Memory context for the batch in flight */
 	TupleTableSlot *slot;
+	/* Network statistics of the connection when the node state was created */
+	TSConnectionNetStats netstats_start;
 } DataNodeState;
 
 #define NUM_STORED_TUPLES(ss)                                                                      \
@@ -244,11 +269,16 @@ data_node_state_init(DataNodeState *ss, DataNodeDispatchState *sds, TSConnection
 		ss->replica_tupstore = NULL;
 
 	ss->conn = remote_dist_txn_get_connection(id, REMOTE_TXN_USE_PREP_STMT);
+	ss->netstats_start = *remote_connection_net_stats(ss->conn);
 	ss->pstmt = NULL;
 	ss->next_tuple = 0;
 	ss->num_tuples_sent = 0;
 	ss->num_tuples_inserted = 0;
 
+	if (sds->async_flush)
+		ss->flush_mcxt =
+			AllocSetContextCreate(sds->mcxt, "DataNodeDispatch flush", ALLOCSET_SMALL_SIZES);
+
 	MemoryContextSwitchTo(old);
 }
 
@@ -359,6 +389,10 @@ data_node_dispatch_begin(CustomScanState *node, EState *estate, int eflags)
 	sds->target_attrs = list_nth(cscan->custom_private, CustomScanPrivateTargetAttrs);
 	sds->set_processed = intVal(list_nth(cscan->custom_private, CustomScanPrivateSetProcessed));
 	sds->flush_threshold = intVal(list_nth(cscan->custom_private, CustomScanPrivateFlushThreshold));
+	sds->last_flush_sql = MemoryContextAllocZero(mcxt, sizeof(char *) * sds->flush_threshold);
+	if (sds->flush_threshold > 1)
+		sds->last_flush_sql[1] =
+			strVal(list_nth(cscan->custom_private, CustomScanPrivateSingleRowSql));
 
 	sds->mcxt = mcxt;
 	sds->batch_mcxt = AllocSetContextCreate(mcxt, "DataNodeDispatch batch", ALLOCSET_SMALL_SIZES);
@@ -370,6 +404,23 @@ data_node_dispatch_begin(CustomScanState *node, EState *estate, int eflags)
 	deparsed_insert_stmt_from_list(&sds->stmt,
 								   list_nth(cscan->custom_private,
 											CustomScanPrivateDeparsedInsertStmt));
+
+	sds->pipeline_depth = 1;
+
+	/* Pipelining is only used without RETURNING since returned tuples are
+	 * consumed batch by batch */
+	if (!HAS_RETURNING(sds) && ts_guc_max_insert_pipeline_depth > 1 &&
+		remote_connection_pipeline_supported())
+	{
+		sds->pipeline_depth = ts_guc_max_insert_pipeline_depth;
+		sds->pipeline_mcxt =
+			AllocSetContextCreate(mcxt, "DataNodeDispatch pipeline", ALLOCSET_SMALL_SIZES);
+	}
+
+	/* Without pipelining, batches can still be double buffered by reading
+	 * the response of a batch only when the next one is sent */
+	sds->async_flush =
+		!HAS_RETURNING(sds) && sds->pipeline_depth == 1 && ts_guc_enable_async_insert_flush;
 	/* Setup output functions to generate string values for each target attribute */
 	sds->stmt_params = stmt_params_create(sds->target_attrs, false, tupdesc, sds->flush_threshold);
 
@@ -453,18 +504,33 @@ data_node_dispatch_set_state(DataNodeDispatchState *sds, DispatchState new_state
 static PreparedStmt *
 prepare_data_node_insert_stmt(DataNodeDispatchState *sds, TSConnection *conn, int total_params)
 {
-	AsyncRequest *req;
 	PreparedStmt *stmt;
 	MemoryContext oldcontext = MemoryContextSwitchTo(sds->mcxt);
 
-	req = async_request_send_prepare(conn, sds->sql_stmt, total_params);
-	Assert(req != NULL);
-	stmt = async_request_wait_prepared_statement(req);
+	stmt = async_request_get_prepared_statement(conn, sds->sql_stmt, total_params);
 	MemoryContextSwitchTo(oldcontext);
 
 	return stmt;
 }
 
+/*
+ * Get the insert statement for a partial batch of the given number of
+ * tuples. The statement for a single tuple, which is what point inserts
+ * send, is deparsed when planning, so that executions of a cached plan reuse
+ * it. The statements for other sizes are deparsed once per execution.
+ */
+static const char *
+get_last_flush_sql(DataNodeDispatchState *sds, int num_tuples)
+{
+	Assert(num_tuples > 0 && num_tuples < sds->flush_threshold);
+
+	if (NULL == sds->last_flush_sql[num_tuples])
+		sds->last_flush_sql[num_tuples] =
+			MemoryContextStrdup(sds->mcxt, deparsed_insert_stmt_get_sql(&sds->stmt, num_tuples));
+
+	return sds->last_flush_sql[num_tuples];
+}
+
 /*
  * Send a batch of tuples to a data node.
  *
@@ -538,12 +604,33 @@ send_batch_to_data_node(DataNodeDispatchState *sds, DataNodeState *ss)
 															   response_type);
 			break;
 		case SD_LAST_FLUSH:
-			sql_stmt = deparsed_insert_stmt_get_sql(&sds->stmt,
-													stmt_params_converted_tuples(sds->stmt_params));
-			Assert(sql_stmt != NULL);
 			Assert(ss->num_tuples_sent < sds->flush_threshold);
-			req =
-				async_request_send_with_params(ss->conn, sql_stmt, sds->stmt_params, response_type);
+			sql_stmt = get_last_flush_sql(sds, stmt_params_converted_tuples(sds->stmt_params));
+
+			/*
+			 * With the prepared statement cache, the partial batches also use
+			 * prepared statements, so that repeated inserts of the same number
+			 * of tuples are not parsed and planned again on the data node. A
+			 * statement can only be prepared while no pipelined request is in
+			 * flight on the connection.
+			 */
+			if (ts_guc_enable_prepared_stmt_cache && !remote_connection_is_pipelined(ss->conn))
+			{
+				PreparedStmt *pstmt =
+					async_request_get_prepared_statement(ss->conn,
+														 sql_stmt,
+														 stmt_params_total_values(
+															 sds->stmt_params));
+
+				req = async_request_send_prepared_stmt_with_params(pstmt,
+																   sds->stmt_params,
+																   response_type);
+			}
+			else
+				req = async_request_send_with_params(ss->conn,
+													 sql_stmt,
+													 sds->stmt_params,
+													 response_type);
 			break;
 		default:
 			elog(ERROR, "unexpected data node dispatch state %s", state_names[sds->state]);
@@ -660,7 +747,8 @@ await_all_responses(DataNodeDispatchState *sds, AsyncRequestSet *reqset)
 
 				results = lappend(results, rsp);
 				ss->num_tuples_inserted = PQntuples(res);
-				Assert(sds->stmt.do_nothing || (ss->num_tuples_inserted == ss->num_tuples_sent));
+				Assert(sds->stmt.do_nothing || sds->pipeline_depth > 1 ||
+					   (ss->num_tuples_inserted == ss->num_tuples_sent));
 				report_error = false;
 				break;
 			case PGRES_COMMAND_OK:
@@ -669,7 +757,10 @@ await_all_responses(DataNodeDispatchState *sds, AsyncRequestSet *reqset)
 
 				ss->num_tuples_inserted = atoi(PQcmdTuples(res));
 				async_response_result_close(rsp);
-				Assert(sds->stmt.do_nothing || (ss->num_tuples_inserted == ss->num_tuples_sent));
+				/* Several batches of different sizes can be in flight when
+				 * pipelining */
+				Assert(sds->stmt.do_nothing || sds->pipeline_depth > 1 || sds->async_flush ||
+					   (ss->num_tuples_inserted == ss->num_tuples_sent));
 				report_error = false;
 				break;
 			default:
@@ -689,6 +780,181 @@ await_all_responses(DataNodeDispatchState *sds, AsyncRequestSet *reqset)
 	return results;
 }
 
+/*
+ * Wait for the responses of all pipelined batches and take the connections
+ * out of pipeline mode.
+ */
+static void
+await_pipelined_responses(DataNodeDispatchState *sds)
+{
+	DataNodeState *ss;
+	HASH_SEQ_STATUS hseq;
+
+	if (NULL == sds->pipeline_reqset)
+		return;
+
+	await_all_responses(sds, sds->pipeline_reqset);
+	hash_seq_init(&hseq, sds->nodestates);
+
+	for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
+	{
+		ss->num_batches_in_flight = 0;
+		remote_connection_exit_pipeline_mode(ss->conn);
+	}
+
+	sds->pipeline_reqset = NULL;
+	MemoryContextReset(sds->pipeline_mcxt);
+}
+
+/*
+ * Flush the tuples of data nodes that have a full batch without waiting for
+ * the responses.
+ *
+ * The batches are sent in pipeline mode and the responses are only awaited
+ * when a data node has the maximum number of batches in flight or on the
+ * last flush. A batch in FLUSH state uses a prepared statement, which is
+ * prepared before the connection enters pipeline mode.
+ */
+static void
+flush_data_nodes_pipelined(DataNodeDispatchState *sds)
+{
+	MemoryContext oldcontext;
+	DataNodeState *ss;
+	HASH_SEQ_STATUS hseq;
+
+	Assert(sds->state == SD_FLUSH || sds->state == SD_LAST_FLUSH);
+	Assert(sds->pipeline_depth > 1);
+	Assert(!HAS_RETURNING(sds));
+
+	hash_seq_init(&hseq, sds->nodestates);
+
+	for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
+	{
+		AsyncRequest *req;
+
+		if (!should_flush_data_node(sds, ss))
+			continue;
+
+		if (ss->num_batches_in_flight >= sds->pipeline_depth ||
+			(sds->state == SD_FLUSH && NULL == ss->pstmt && ss->num_batches_in_flight > 0))
+			await_pipelined_responses(sds);
+
+		if (sds->state == SD_FLUSH && NULL == ss->pstmt)
+			ss->pstmt =
+				prepare_data_node_insert_stmt(sds,
+											  ss->conn,
+											  stmt_params_total_values(sds->stmt_params));
+
+		oldcontext = MemoryContextSwitchTo(sds->pipeline_mcxt);
+
+		if (!remote_connection_is_pipelined(ss->conn))
+			remote_connection_enter_pipeline_mode(ss->conn);
+
+		req = send_batch_to_data_node(sds, ss);
+
+		if (NULL == sds->pipeline_reqset)
+			sds->pipeline_reqset = async_request_set_create();
+
+		async_request_set_add(sds->pipeline_reqset, req);
+		ss->num_batches_in_flight++;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	if (sds->state == SD_LAST_FLUSH)
+		await_pipelined_responses(sds);
+}
+
+/*
+ * Wait for the response of the batch in flight for a data node, if any.
+ */
+static void
+data_node_state_await_flush(DataNodeState *ss)
+{
+	AsyncResponseResult *rsp;
+	PGresult *res;
+
+	if (NULL == ss->flush_req)
+		return;
+
+	remote_connection_clear_prefetch(ss->conn, ss);
+	rsp = async_request_wait_any_result(ss->flush_req);
+	res = async_response_result_get_pg_result(rsp);
+
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		async_response_report_error((AsyncResponse *) rsp, ERROR);
+
+	ss->num_tuples_inserted = atoi(PQcmdTuples(res));
+	async_response_result_close(rsp);
+	ss->flush_req = NULL;
+	MemoryContextReset(ss->flush_mcxt);
+}
+
+/*
+ * Read the response of the batch in flight when something else needs the
+ * connection, e.g., to create a new chunk on the data node.
+ */
+static void
+data_node_state_complete_flush(void *arg)
+{
+	DataNodeState *ss = (DataNodeState *) arg;
+
+	Assert(NULL != ss->flush_req);
+	data_node_state_await_flush(ss);
+}
+
+/*
+ * Flush the tuples of data nodes that have a full batch without waiting for
+ * the responses.
+ *
+ * At most one batch per data node is in flight. Its response is read before
+ * the next batch for the same data node is sent, which limits the memory
+ * used to two batches per data node: the one in flight and the one being
+ * filled. On the last flush, all responses are awaited.
+ */
+static void
+flush_data_nodes_async(DataNodeDispatchState *sds)
+{
+	DataNodeState *ss;
+	HASH_SEQ_STATUS hseq;
+
+	Assert(sds->state == SD_FLUSH || sds->state == SD_LAST_FLUSH);
+	Assert(sds->async_flush);
+	Assert(!HAS_RETURNING(sds));
+
+	hash_seq_init(&hseq, sds->nodestates);
+
+	for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
+	{
+		MemoryContext oldcontext;
+
+		if (!should_flush_data_node(sds, ss))
+			continue;
+
+		data_node_state_await_flush(ss);
+
+		if (sds->state == SD_FLUSH && NULL == ss->pstmt)
+			ss->pstmt =
+				prepare_data_node_insert_stmt(sds,
+											  ss->conn,
+											  stmt_params_total_values(sds->stmt_params));
+
+		oldcontext = MemoryContextSwitchTo(ss->flush_mcxt);
+		ss->flush_req = send_batch_to_data_node(sds, ss);
+		MemoryContextSwitchTo(oldcontext);
+
+		/* Anything else sent on the connection reads the response first */
+		remote_connection_set_prefetch(ss->conn, data_node_state_complete_flush, ss);
+	}
+
+	if (sds->state == SD_LAST_FLUSH)
+	{
+		hash_seq_init(&hseq, sds->nodestates);
+
+		for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
+			data_node_state_await_flush(ss);
+	}
+}
+
 /*
  * Read tuples from the child scan node.
  *
@@ -810,6 +1076,22 @@ handle_flush(DataNodeDispatchState *sds)
 
 	Assert(sds->state == SD_FLUSH || sds->state == SD_LAST_FLUSH);
 
+	if (sds->pipeline_depth > 1)
+	{
+		flush_data_nodes_pipelined(sds);
+		sds->responses = NIL;
+		data_node_dispatch_set_state(sds, SD_RETURNING);
+		return;
+	}
+
+	if (sds->async_flush)
+	{
+		flush_data_nodes_async(sds);
+		sds->responses = NIL;
+		data_node_dispatch_set_state(sds, SD_RETURNING);
+		return;
+	}
+
 	/* Save the requests and responses in the batch memory context since they
 	 * need to survive across several iterations of the executor loop when
 	 * there is a RETURNING clause. The batch memory context is cleared the
@@ -1045,7 +1327,10 @@ data_node_dispatch_end(CustomScanState *node)
 	hash_seq_init(&hseq, sds->nodestates);
 
 	for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
+	{
+		data_node_state_await_flush(ss);
 		data_node_state_close(ss);
+	}
 
 	hash_destroy(sds->nodestates);
 	ExecDropSingleTupleTableSlot(sds->batch_slot);
@@ -1059,6 +1344,35 @@ data_node_dispatch_explain(CustomScanState *node, List *ancestors, ExplainState
 
 	ExplainPropertyInteger("Batch size", NULL, sds->flush_threshold, es);
 
+	if (sds->pipeline_depth > 1)
+		ExplainPropertyInteger("Pipeline depth", NULL, sds->pipeline_depth, es);
+
+	if (sds->async_flush)
+		ExplainPropertyBool("Async flush", true, es);
+
+	/* Network activity summed over all data nodes inserted into */
+	if (es->analyze && es->timing)
+	{
+		TSConnectionNetStats total = { 0 };
+		HASH_SEQ_STATUS hseq;
+		DataNodeState *ss;
+
+		hash_seq_init(&hseq, sds->nodestates);
+
+		for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
+		{
+			TSConnectionNetStats netstats;
+
+			remote_connection_net_stats_since(ss->conn, &ss->netstats_start, &netstats);
+			total.bytes_sent += netstats.bytes_sent;
+			total.bytes_received += netstats.bytes_received;
+			total.round_trips += netstats.round_trips;
+			total.wait_time += netstats.wait_time;
+		}
+
+		fdw_explain_net_stats(&total, es);
+	}
+
 	/*
 	 * Add remote query, when VERBOSE option is specified.
 	 */
@@ -1193,11 +1507,12 @@ plan_remote_insert(PlannerInfo *root, DataNodeDispatchPath *sdpath)
 
 	table_close(rel, NoLock);
 
-	return list_make5(makeString((char *) sql),
-					  target_attrs,
-					  deparsed_insert_stmt_to_list(&stmt),
-					  makeInteger(sdpath->mtpath->canSetTag),
-					  makeInteger(flush_threshold));
+	return lappend(list_make5(makeString((char *) sql),
+							  target_attrs,
+							  deparsed_insert_stmt_to_list(&stmt),
+							  makeInteger(sdpath->mtpath->canSetTag),
+							  makeInteger(flush_threshold)),
+				   makeString((char *) deparsed_insert_stmt_get_sql(&stmt, 1)));
 }
 
 static Plan *
@@ -0,0 +1,219 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * A backend-local cache of bulk decompressed columns. Queries that repeatedly
+ * scan the same compressed batches, like dashboards refreshing every few
+ * seconds, get the decompressed arrays from the cache instead of decoding the
+ * compressed data again.
+ *
+ * The entries are keyed by the TOAST pointer of the compressed value, which
+ * identifies it the same way as the TOAST cache of PostgreSQL would. The
+ * compressed values are never updated in place: recompression deletes the old
+ * batches and writes new ones with new TOAST values, so the old entries are
+ * never hit again and age out of the cache. The entries of a compressed chunk
+ * are also dropped on the relcache invalidation of its TOAST table, e.g.,
+ * when the chunk is truncated or dropped.
+ *
+ * The cache is bounded by timescaledb.decompress_cache_size and the least
+ * recently used entries are evicted first.
+ */
+
+#include <postgres.h>
+#include <lib/ilist.h>
+#include <utils/hsearch.h>
+#include <utils/inval.h>
+#include <utils/memutils.h>
+
+#include "guc.h"
+#include "nodes/decompress_chunk/column_cache.h"
+
+typedef struct DecompressedColumnCacheKey
+{
+	Oid toastrelid;
+	Oid valueid;
+	Oid typid;
+} DecompressedColumnCacheKey;
+
+typedef struct DecompressedColumnCacheEntry
+{
+	DecompressedColumnCacheKey key;
+	/* The validity bitmap and the values are stored in one allocation */
+	DecompressedColumn column;
+	Size size;
+	dlist_node lru_node;
+} DecompressedColumnCacheEntry;
+
+static MemoryContext column_cache_context = NULL;
+static HTAB *column_cache = NULL;
+/* The most recently used entries first */
+static dlist_head column_cache_lru = DLIST_STATIC_INIT(column_cache_lru);
+static Size column_cache_size = 0;
+static bool column_cache_callback_registered = false;
+
+static void
+column_cache_remove(DecompressedColumnCacheEntry *entry)
+{
+	dlist_delete(&entry->lru_node);
+	column_cache_size -= entry->size;
+	pfree((void *) entry->column.values);
+	hash_search(column_cache, &entry->key, HASH_REMOVE, NULL);
+}
+
+static void
+column_cache_invalidate_callback(Datum arg, Oid relid)
+{
+	HASH_SEQ_STATUS status;
+	DecompressedColumnCacheEntry *entry;
+
+	if (column_cache == NULL)
+		return;
+
+	if (!OidIsValid(relid))
+	{
+		/* all relations are invalidated, e.g., after a sinval queue overflow */
+		hash_destroy(column_cache);
+		MemoryContextReset(column_cache_context);
+		column_cache = NULL;
+		dlist_init(&column_cache_lru);
+		column_cache_size = 0;
+		return;
+	}
+
+	hash_seq_init(&status, column_cache);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.toastrelid == relid)
+			column_cache_remove(entry);
+	}
+}
+
+static void
+column_cache_init(void)
+{
+	HASHCTL ctl;
+
+	if (column_cache_context == NULL)
+		column_cache_context = AllocSetContextCreate(TopMemoryContext,
+													 "DecompressedColumnCache",
+													 ALLOCSET_DEFAULT_SIZES);
+
+	if (!column_cache_callback_registered)
+	{
+		CacheRegisterRelcacheCallback(column_cache_invalidate_callback, PointerGetDatum(NULL));
+		column_cache_callback_registered = true;
+	}
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(DecompressedColumnCacheKey);
+	ctl.entrysize = sizeof(DecompressedColumnCacheEntry);
+	ctl.hcxt = column_cache_context;
+	column_cache =
+		hash_create("DecompressedColumnCache", 256, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	dlist_init(&column_cache_lru);
+	column_cache_size = 0;
+}
+
+static inline void
+column_cache_key_init(DecompressedColumnCacheKey *key, const struct varatt_external *toast_pointer,
+					  Oid typid)
+{
+	memset(key, 0, sizeof(*key));
+	key->toastrelid = toast_pointer->va_toastrelid;
+	key->valueid = toast_pointer->va_valueid;
+	key->typid = typid;
+}
+
+static inline Size
+column_cache_validity_bytes(const DecompressedColumn *column)
+{
+	return column->validity == NULL ? 0 : sizeof(uint64) * ((column->length + 63) / 64);
+}
+
+/*
+ * Return a copy of the cached decompressed column in the current memory
+ * context, or NULL if the value is not cached. The copy is needed because the
+ * entry can be evicted while the batch is still being read.
+ */
+DecompressedColumn *
+decompressed_column_cache_get(const struct varatt_external *toast_pointer, Oid typid)
+{
+	DecompressedColumnCacheKey key;
+	DecompressedColumnCacheEntry *entry;
+	DecompressedColumn *result;
+	Size values_bytes;
+	Size validity_bytes;
+	char *data;
+
+	if (column_cache == NULL)
+		return NULL;
+
+	column_cache_key_init(&key, toast_pointer, typid);
+	entry = hash_search(column_cache, &key, HASH_FIND, NULL);
+
+	if (entry == NULL)
+		return NULL;
+
+	dlist_move_head(&column_cache_lru, &entry->lru_node);
+
+	values_bytes = (Size) entry->column.value_bytes * Max(entry->column.length, 1);
+	validity_bytes = column_cache_validity_bytes(&entry->column);
+	result = palloc(sizeof(DecompressedColumn));
+	data = palloc(values_bytes + validity_bytes);
+	memcpy(data, entry->column.values, values_bytes + validity_bytes);
+
+	*result = entry->column;
+	result->values = data;
+	result->validity = validity_bytes == 0 ? NULL : (const uint64 *) (data + values_bytes);
+
+	return result;
+}
+
+/*
+ * Store a bulk decompressed column in the cache, evicting the least recently
+ * used entries to stay within timescaledb.decompress_cache_size.
+ */
+void
+decompressed_column_cache_put(const struct varatt_external *toast_pointer, Oid typid,
+							  const DecompressedColumn *column)
+{
+	Size limit = (Size) ts_guc_decompress_cache_size * 1024;
+	DecompressedColumnCacheKey key;
+	DecompressedColumnCacheEntry *entry;
+	Size values_bytes = (Size) column->value_bytes * Max(column->length, 1);
+	Size validity_bytes = column_cache_validity_bytes(column);
+	Size size = values_bytes + validity_bytes + sizeof(DecompressedColumnCacheEntry);
+	char *data;
+
+	if (size > limit)
+		return;
+
+	if (column_cache == NULL)
+		column_cache_init();
+
+	column_cache_key_init(&key, toast_pointer, typid);
+	if (hash_search(column_cache, &key, HASH_FIND, NULL) != NULL)
+		return;
+
+	while (column_cache_size + size > limit && !dlist_is_empty(&column_cache_lru))
+		column_cache_remove(dlist_container(DecompressedColumnCacheEntry,
+											lru_node,
+											dlist_tail_node(&column_cache_lru)));
+
+	entry = hash_search(column_cache, &key, HASH_ENTER, NULL);
+
+	data = MemoryContextAlloc(column_cache_context, values_bytes + validity_bytes);
+	memcpy(data, column->values, values_bytes);
+	if (validity_bytes > 0)
+		memcpy(data + values_bytes, column->validity, validity_bytes);
+
+	entry->column = *column;
+	entry->column.values = data;
+	entry->column.validity = validity_bytes == 0 ? NULL : (const uint64 *) (data + values_bytes);
+	entry->size = size;
+	dlist_push_head(&column_cache_lru, &entry->lru_node);
+	column_cache_size += size;
+}
@@ -0,0 +1,19 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#ifndef TIMESCALEDB_DECOMPRESS_CHUNK_COLUMN_CACHE_H
+#define TIMESCALEDB_DECOMPRESS_CHUNK_COLUMN_CACHE_H
+
+#include <postgres.h>
+
+#include "compression/compression.h"
+
+extern DecompressedColumn *decompressed_column_cache_get(const struct varatt_external *toast_pointer,
+														 Oid typid);
+extern void decompressed_column_cache_put(const struct varatt_external *toast_pointer, Oid typid,
+										  const DecompressedColumn *column);
+
+#endif /* TIMESCALEDB_DECOMPRESS_CHUNK_COLUMN_CACHE_H */
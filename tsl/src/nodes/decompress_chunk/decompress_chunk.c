@@ -5,6 +5,8 @@
  */
 
 #include <postgres.h>
+#include <access/htup_details.h>
+#include <catalog/pg_attribute.h>
 #include <catalog/pg_operator.h>
 #include <miscadmin.h>
 #include <nodes/bitmapset.h>
@@ -14,17 +16,23 @@
 #include <optimizer/optimizer.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
+#include <optimizer/planmain.h>
 #include <parser/parsetree.h>
 #include <utils/builtins.h>
 #include <utils/lsyscache.h>
+#include <utils/syscache.h>
 #include <utils/typcache.h>
+#include <math.h>
 
 #include <planner.h>
 
 #include "compat/compat.h"
+#include "ts_catalog/compression_chunk_size.h"
 #include "ts_catalog/hypertable_compression.h"
 #include "import/planner.h"
+#include "compression/compression.h"
 #include "compression/create.h"
+#include "guc.h"
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "nodes/decompress_chunk/planner.h"
 #include "nodes/decompress_chunk/qual_pushdown.h"
@@ -38,11 +46,19 @@ static CustomPathMethods decompress_chunk_path_methods = {
 	.PlanCustomPath = decompress_chunk_plan_create,
 };
 
+bool
+ts_is_decompress_chunk_path(Path *path)
+{
+	return IsA(path, CustomPath) &&
+		   castNode(CustomPath, path)->methods == &decompress_chunk_path_methods;
+}
+
 typedef struct SortInfo
 {
 	List *compressed_pathkeys;
 	bool needs_sequence_num;
 	bool can_pushdown_sort; /* sort can be pushed below DecompressChunk */
+	bool use_batch_sorted_merge; /* the batches can be merged in the sort order */
 	bool reverse;
 } SortInfo;
 
@@ -54,6 +70,7 @@ static void create_compressed_scan_paths(PlannerInfo *root, RelOptInfo *compress
 static DecompressChunkPath *decompress_chunk_path_create(PlannerInfo *root, CompressionInfo *info,
 														 int parallel_workers,
 														 Path *compressed_path);
+static Path *decompress_chunk_batch_parallel_path_create(PlannerInfo *root, CompressionInfo *info);
 
 static void decompress_chunk_add_plannerinfo(PlannerInfo *root, CompressionInfo *info, Chunk *chunk,
 											 RelOptInfo *chunk_rel, bool needs_sequence_num);
@@ -289,6 +306,52 @@ build_compressed_scan_pathkeys(SortInfo *sort_info, PlannerInfo *root, List *chu
 	sort_info->compressed_pathkeys = compressed_pathkeys;
 }
 
+/*
+ * The batch sorted merge needs the compressed batches in the order of their
+ * first rows, that is by the min metadata of the first sort column for the
+ * ascending order and by the max metadata for the descending one.
+ */
+static void
+build_batch_sorted_merge_pathkeys(SortInfo *sort_info, PlannerInfo *root, List *chunk_pathkeys,
+								  CompressionInfo *info)
+{
+	PathKey *pk = linitial(chunk_pathkeys);
+	Var *var = (Var *) find_em_expr_for_rel(pk->pk_eclass, info->chunk_rel);
+	FormData_hypertable_compression *ci;
+	char *column_name;
+	char *meta_name;
+	Oid sortop;
+
+	/* this should not happen because we validated the pathkeys when creating the path */
+	if (var == NULL || !IsA(var, Var))
+		elog(ERROR, "Invalid pathkey for compressed scan");
+
+	column_name = get_attname(info->chunk_rte->relid, var->varattno, false);
+	ci = get_column_compressioninfo(info->hypertable_compression_info, column_name);
+	meta_name = pk->pk_strategy == BTLessStrategyNumber ? compression_column_segment_min_name(ci) :
+														  compression_column_segment_max_name(ci);
+
+	var = makeVar(info->compressed_rel->relid,
+				  get_attnum(info->compressed_rte->relid, meta_name),
+				  var->vartype,
+				  var->vartypmod,
+				  var->varcollid,
+				  0);
+
+	sortop = get_opfamily_member(pk->pk_opfamily, var->vartype, var->vartype, pk->pk_strategy);
+	if (!OidIsValid(sortop) && type_is_enum(var->vartype))
+		sortop = get_opfamily_member(pk->pk_opfamily, ANYENUMOID, ANYENUMOID, pk->pk_strategy);
+	if (!OidIsValid(sortop))
+		elog(ERROR, "sort operator lookup failed for column \"%s\"", column_name);
+
+	pk = make_pathkey_from_compressed(root,
+									  info->compressed_rel->relid,
+									  (Expr *) var,
+									  sortop,
+									  pk->pk_nulls_first);
+	sort_info->compressed_pathkeys = list_make1(pk);
+}
+
 static DecompressChunkPath *
 copy_decompress_chunk_path(DecompressChunkPath *src)
 {
@@ -306,6 +369,8 @@ build_compressioninfo(PlannerInfo *root, Hypertable *ht, RelOptInfo *chunk_rel)
 	CompressionInfo *info = palloc0(sizeof(CompressionInfo));
 
 	info->chunk_rel = chunk_rel;
+	info->batch_size = DECOMPRESS_CHUNK_BATCH_SIZE;
+	info->decompression_cost = DECOMPRESS_CHUNK_CPU_TUPLE_COST;
 	info->chunk_rte = planner_rt_fetch(chunk_rel->relid, root);
 
 	if (chunk_rel->reloptkind == RELOPT_OTHER_MEMBER_REL)
@@ -348,15 +413,129 @@ build_compressioninfo(PlannerInfo *root, Hypertable *ht, RelOptInfo *chunk_rel)
  * we put cost of 1 tuple of compressed_scan as startup cost
  */
 static void
-cost_decompress_chunk(Path *path, Path *compressed_path)
+cost_decompress_chunk(DecompressChunkPath *dcpath, Path *compressed_path)
 {
+	Path *path = &dcpath->cpath.path;
+	CompressionInfo *info = dcpath->info;
+	double rows = compressed_path->rows * info->batch_size;
+
 	/* startup_cost is cost before fetching first tuple */
 	if (compressed_path->rows > 0)
 		path->startup_cost = compressed_path->total_cost / compressed_path->rows;
 
-	/* total_cost is cost for fetching all tuples */
-	path->total_cost = compressed_path->total_cost + path->rows * DECOMPRESS_CHUNK_CPU_TUPLE_COST;
-	path->rows = compressed_path->rows * DECOMPRESS_CHUNK_BATCH_SIZE;
+	if (ts_guc_enable_compression_cost_stats)
+	{
+		/* the first batch is decompressed before its first tuple is returned */
+		path->startup_cost += Min(info->batch_size, rows) * info->decompression_cost;
+		path->total_cost = compressed_path->total_cost + rows * info->decompression_cost;
+	}
+	else
+	{
+		/* total_cost is cost for fetching all tuples */
+		path->total_cost =
+			compressed_path->total_cost + path->rows * DECOMPRESS_CHUNK_CPU_TUPLE_COST;
+	}
+
+	path->rows = rows;
+}
+
+/*
+ * The cost of decompressing a value of a column compressed with the
+ * algorithm, in units of cpu_operator_cost. Delta-delta and bit-packing
+ * decode whole blocks with a few instructions per value, the array and
+ * dictionary algorithms have to copy or look up every value.
+ */
+static const double decompression_cost_factor[_END_COMPRESSION_ALGORITHMS] = {
+	[COMPRESSION_ALGORITHM_ARRAY] = 2.0,	  [COMPRESSION_ALGORITHM_DICTIONARY] = 1.5,
+	[COMPRESSION_ALGORITHM_GORILLA] = 1.0,	  [COMPRESSION_ALGORITHM_DELTADELTA] = 0.5,
+	[COMPRESSION_ALGORITHM_BITPACK] = 0.25,	  [COMPRESSION_ALGORITHM_UUID] = 1.0,
+	[COMPRESSION_ALGORITHM_JSONB] = 2.5,
+};
+
+/*
+ * Estimate the batch size of the chunk from the row counts recorded when it
+ * was compressed, and the cost per row from the algorithms of the compressed
+ * columns that the query needs. Must be called after the reltarget of the
+ * compressed rel was set up.
+ */
+static void
+estimate_decompression_cost(CompressionInfo *info, Chunk *chunk)
+{
+	ListCell *lc;
+
+	if (!ts_guc_enable_compression_cost_stats)
+		return;
+
+	double batch_size = ts_compression_chunk_size_batch_size(chunk->fd.id);
+
+	if (batch_size > 0)
+		info->batch_size = batch_size;
+
+	foreach (lc, info->compressed_rel->reltarget->exprs)
+	{
+		Var *var = lfirst(lc);
+		FormData_hypertable_compression *column_info;
+
+		if (!IsA(var, Var) || var->varattno <= 0 ||
+			!bms_is_member(var->varattno, info->compressed_chunk_compressed_attnos))
+			continue;
+
+		column_info = get_column_compressioninfo(info->hypertable_compression_info,
+												 get_attname(info->compressed_rte->relid,
+															 var->varattno,
+															 false));
+
+		if (column_info->algo_id > _INVALID_COMPRESSION_ALGORITHM &&
+			column_info->algo_id < _END_COMPRESSION_ALGORITHMS)
+			info->decompression_cost +=
+				decompression_cost_factor[column_info->algo_id] * cpu_operator_cost;
+	}
+}
+
+/*
+ * Copy a DecompressChunkPath with a different path for the compressed scan,
+ * e.g. a SkipScan over the index scan the original path used.
+ */
+DecompressChunkPath *
+ts_decompress_chunk_path_copy(DecompressChunkPath *path, Path *compressed_path)
+{
+	DecompressChunkPath *dcpath = copy_decompress_chunk_path(path);
+
+	dcpath->cpath.custom_paths = list_make1(compressed_path);
+	dcpath->cpath.path.rows = compressed_path->rows * path->info->batch_size;
+	cost_decompress_chunk(dcpath, compressed_path);
+
+	return dcpath;
+}
+
+/*
+ * Calculate the cost of the batch sorted merge. The compressed scan has to be
+ * sorted by the batch metadata, and every decompressed row costs a comparison
+ * in the binary heap of the open batches, like in cost_merge_append.
+ */
+static void
+cost_batch_sorted_merge(PlannerInfo *root, DecompressChunkPath *dcpath, Path *compressed_path)
+{
+	Path sort_path; /* dummy for result of cost_sort */
+	double open_batches = Max(compressed_path->rows, 2);
+
+	if (!pathkeys_contained_in(dcpath->compressed_pathkeys, compressed_path->pathkeys))
+	{
+		cost_sort(&sort_path,
+				  root,
+				  dcpath->compressed_pathkeys,
+				  compressed_path->total_cost,
+				  compressed_path->rows,
+				  compressed_path->pathtarget->width,
+				  0.0,
+				  work_mem,
+				  -1);
+		compressed_path = &sort_path;
+	}
+
+	cost_decompress_chunk(dcpath, compressed_path);
+	dcpath->cpath.path.total_cost +=
+		dcpath->cpath.path.rows * 2.0 * cpu_operator_cost * log2(open_batches);
 }
 
 void
@@ -404,7 +583,8 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 				   info->hypertable_compression_info,
 				   ts_chunk_is_partial(chunk));
 	set_baserel_size_estimates(root, compressed_rel);
-	new_row_estimate = compressed_rel->rows * DECOMPRESS_CHUNK_BATCH_SIZE;
+	estimate_decompression_cost(info, chunk);
+	new_row_estimate = compressed_rel->rows * info->batch_size;
 
 	if (!info->single_chunk)
 	{
@@ -544,11 +724,26 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 						  0.0,
 						  work_mem,
 						  -1);
-				cost_decompress_chunk(&dcpath->cpath.path, &sort_path);
+				cost_decompress_chunk(dcpath, &sort_path);
 			}
 			add_path(chunk_rel, &dcpath->cpath.path);
 		}
 
+		/*
+		 * The batches of the different segments are merged in the order of
+		 * the query pathkeys, so we don't need a Sort above this node.
+		 */
+		if (sort_info.use_batch_sorted_merge)
+		{
+			DecompressChunkPath *dcpath = copy_decompress_chunk_path((DecompressChunkPath *) path);
+			dcpath->reverse = sort_info.reverse;
+			dcpath->batch_sorted_merge = true;
+			dcpath->compressed_pathkeys = sort_info.compressed_pathkeys;
+			dcpath->cpath.path.pathkeys = root->query_pathkeys;
+			cost_batch_sorted_merge(root, dcpath, child_path);
+			add_path(chunk_rel, &dcpath->cpath.path);
+		}
+
 		/*
 		 * If this is a partially compressed chunk we have to combine data
 		 * from compressed and uncompressed chunk.
@@ -606,6 +801,14 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 		/* the chunk_rel now owns the paths, remove them from the compressed_rel so they can't be
 		 * freed if it's planned */
 		compressed_rel->partial_pathlist = NIL;
+
+		if (ts_guc_enable_parallel_batch_decompression && !ts_chunk_is_partial(chunk))
+		{
+			Path *path = decompress_chunk_batch_parallel_path_create(root, info);
+
+			if (path != NULL)
+				add_partial_path(chunk_rel, path);
+		}
 	}
 	/* set reloptkind to RELOPT_DEADREL to prevent postgresql from replanning this relation */
 	compressed_rel->reloptkind = RELOPT_DEADREL;
@@ -1214,12 +1417,56 @@ decompress_chunk_path_create(PlannerInfo *root, CompressionInfo *info, int paral
 
 	path->cpath.custom_paths = list_make1(compressed_path);
 	path->reverse = false;
+	path->batch_sorted_merge = false;
 	path->compressed_pathkeys = NIL;
-	cost_decompress_chunk(&path->cpath.path, compressed_path);
+	cost_decompress_chunk(path, compressed_path);
 
 	return path;
 }
 
+/*
+ * Create a partial path where the parallel processes claim the compressed
+ * batches one at a time, see decompress_chunk_next_compressed(). Each of them
+ * scans the whole compressed chunk, but that only reads the small heap tuples
+ * of the batches, while the TOASTed compressed columns are only fetched and
+ * decompressed for the claimed batches. Unlike the parallel scan of the
+ * compressed chunk, which hands out block ranges, this spreads the work evenly
+ * even over the few blocks of a compressed chunk, so the number of workers
+ * follows the size of the decompressed data.
+ */
+static Path *
+decompress_chunk_batch_parallel_path_create(PlannerInfo *root, CompressionInfo *info)
+{
+	RelOptInfo *chunk_rel = info->chunk_rel;
+	double pages = ceil(chunk_rel->rows * chunk_rel->reltarget->width / BLCKSZ);
+	int parallel_workers =
+		compute_parallel_worker(chunk_rel, pages, -1, max_parallel_workers_per_gather);
+	DecompressChunkPath *path;
+	Path *compressed_path;
+	double divisor;
+	double leader_contribution;
+
+	if (parallel_workers <= 0)
+		return NULL;
+
+	compressed_path = create_seqscan_path(root, info->compressed_rel, NULL, 0);
+	path = decompress_chunk_path_create(root, info, parallel_workers, compressed_path);
+	path->cpath.path.parallel_aware = true;
+
+	/* Same as get_parallel_divisor(), the decompression is split between the processes */
+	divisor = parallel_workers;
+	leader_contribution = 1.0 - (0.3 * parallel_workers);
+	if (parallel_leader_participation && leader_contribution > 0)
+		divisor += leader_contribution;
+
+	path->cpath.path.rows = clamp_row_est(path->cpath.path.rows / divisor);
+	path->cpath.path.total_cost =
+		compressed_path->total_cost +
+		(path->cpath.path.total_cost - compressed_path->total_cost) / divisor;
+
+	return &path->cpath.path;
+}
+
 /* NOTE: this needs to be called strictly after all restrictinfos have been added
  *       to the compressed rel
  */
@@ -1276,6 +1523,9 @@ create_compressed_scan_paths(PlannerInfo *root, RelOptInfo *compressed_rel, int
 	}
 	else
 	{
+		if (sort_info->use_batch_sorted_merge)
+			build_batch_sorted_merge_pathkeys(sort_info, root, root->query_pathkeys, info);
+
 		check_index_predicates(root, compressed_rel);
 		create_index_paths(root, compressed_rel);
 	}
@@ -1413,6 +1663,21 @@ find_restrictinfo_equality(RelOptInfo *chunk_rel, CompressionInfo *info)
 	info->chunk_segmentby_ri = segmentby_columns;
 }
 
+static bool
+column_is_not_null(Oid relid, AttrNumber attno)
+{
+	HeapTuple tuple = SearchSysCache2(ATTNUM, ObjectIdGetDatum(relid), Int16GetDatum(attno));
+	bool attnotnull;
+
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for attribute %d of relation %u", attno, relid);
+
+	attnotnull = ((Form_pg_attribute) GETSTRUCT(tuple))->attnotnull;
+	ReleaseSysCache(tuple);
+
+	return attnotnull;
+}
+
 /*
  * Check if we can push down the sort below the DecompressChunk node and fill
  * SortInfo accordingly
@@ -1422,6 +1687,10 @@ find_restrictinfo_equality(RelOptInfo *chunk_rel, CompressionInfo *info)
  *  - the rest of pathkeys needs to match compress_orderby
  *
  * If query pathkeys is shorter than segmentby + compress_orderby pushdown can still be done
+ *
+ * If the segmentby columns are not a prefix of the pathkeys, but the pathkeys
+ * match compress_orderby, the sorted batches can still be merged, see
+ * decompress_chunk_exec_sorted_merge().
  */
 static SortInfo
 build_sortinfo(Chunk *chunk, RelOptInfo *chunk_rel, CompressionInfo *info, List *pathkeys)
@@ -1433,7 +1702,10 @@ build_sortinfo(Chunk *chunk, RelOptInfo *chunk_rel, CompressionInfo *info, List
 	char *column_name;
 	FormData_hypertable_compression *ci;
 	ListCell *lc = list_head(pathkeys);
-	SortInfo sort_info = { .can_pushdown_sort = false, .needs_sequence_num = false };
+	bool batch_sorted_merge = false;
+	SortInfo sort_info = { .can_pushdown_sort = false,
+						   .needs_sequence_num = false,
+						   .use_batch_sorted_merge = false };
 
 	if (pathkeys == NIL || ts_chunk_is_unordered(chunk) || ts_chunk_is_partial(chunk))
 		return sort_info;
@@ -1481,14 +1753,21 @@ build_sortinfo(Chunk *chunk, RelOptInfo *chunk_rel, CompressionInfo *info, List
 		 * we cannot push down sort
 		 */
 		if (lc != NULL && bms_num_members(segmentby_columns) != info->num_segmentby_columns)
-			return sort_info;
+		{
+			if (!ts_guc_enable_decompression_sorted_merge)
+				return sort_info;
+
+			/* all the pathkeys have to match compress_orderby for the merge */
+			batch_sorted_merge = true;
+			lc = list_head(pathkeys);
+		}
 	}
 
 	/*
 	 * if pathkeys includes columns past segmentby columns
 	 * we need sequence_num in the targetlist for ordering
 	 */
-	if (lc != NULL)
+	if (lc != NULL && !batch_sorted_merge)
 		sort_info.needs_sequence_num = true;
 
 	/*
@@ -1546,11 +1825,23 @@ build_sortinfo(Chunk *chunk, RelOptInfo *chunk_rel, CompressionInfo *info, List
 			sort_info.reverse = reverse;
 		else if (reverse != sort_info.reverse)
 			return sort_info;
+
+		/*
+		 * The merge opens the batches in the order of the min/max metadata of
+		 * the first column, which doesn't account for the NULLs. So the NULLs
+		 * can't go first unless the column has none.
+		 */
+		if (batch_sorted_merge && pk_index == 1 && pk->pk_nulls_first &&
+			!column_is_not_null(info->chunk_rte->relid, var->varattno))
+			return sort_info;
 	}
 
 	/* all pathkeys should be processed */
 	Assert(lc == NULL);
 
-	sort_info.can_pushdown_sort = true;
+	if (batch_sorted_merge)
+		sort_info.use_batch_sorted_merge = true;
+	else
+		sort_info.can_pushdown_sort = true;
 	return sort_info;
 }
@@ -36,6 +36,11 @@ typedef struct CompressionInfo
 
 	bool single_chunk; /* query on explicit chunk */
 
+	/* average number of rows in a batch */
+	double batch_size;
+	/* cost of decompressing and returning one row */
+	Cost decompression_cost;
+
 } CompressionInfo;
 
 typedef struct DecompressChunkPath
@@ -52,11 +57,17 @@ typedef struct DecompressChunkPath
 	List *compressed_pathkeys;
 	bool needs_sequence_num;
 	bool reverse;
+	/* merge the sorted batches instead of returning them one by one */
+	bool batch_sorted_merge;
 } DecompressChunkPath;
 
 void ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 										Chunk *chunk);
 
+bool ts_is_decompress_chunk_path(Path *path);
+DecompressChunkPath *ts_decompress_chunk_path_copy(DecompressChunkPath *path,
+												   Path *compressed_path);
+
 FormData_hypertable_compression *get_column_compressioninfo(List *hypertable_compression_info,
 															char *column_name);
 
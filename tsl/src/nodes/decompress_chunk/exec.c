@@ -6,24 +6,50 @@
 
 #include <postgres.h>
 #include <miscadmin.h>
+#include <access/genam.h>
+#include <access/parallel.h>
+#include <access/stratnum.h>
 #include <access/sysattr.h>
+#include <access/table.h>
+#include <access/tableam.h>
+#include <commands/explain.h>
 #include <executor/executor.h>
+#include <executor/instrument.h>
+#include <lib/binaryheap.h>
 #include <nodes/bitmapset.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
+#include <optimizer/optimizer.h>
 #include <parser/parsetree.h>
+#include <port/atomics.h>
+#include <port/pg_bitutils.h>
 #include <rewrite/rewriteManip.h>
+#include <storage/bufmgr.h>
 #include <utils/builtins.h>
 #include <utils/datum.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
 #include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/sortsupport.h>
 #include <utils/typcache.h>
 
 #include "compat/compat.h"
+#if PG13_GE
+#include <access/detoast.h>
+#else
+#include <access/tuptoaster.h>
+#endif
 #include "compression/array.h"
 #include "compression/compression.h"
+#include "compression/create.h"
+#include "guc.h"
+#include "nodes/decompress_chunk/column_cache.h"
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "nodes/decompress_chunk/exec.h"
 #include "nodes/decompress_chunk/planner.h"
+#include "nodes/decompress_chunk/vector_predicates.h"
 #include "ts_catalog/hypertable_compression.h"
 
 typedef enum DecompressChunkColumnType
@@ -52,20 +78,136 @@ typedef struct DecompressChunkColumnState
 	 */
 	AttrNumber compressed_scan_attno;
 
+	/* Type properties needed to fetch values from bulk decompressed arrays */
+	int16 typlen;
+	bool typbyval;
+	bool bulk_decompression_supported;
+
+	/*
+	 * The column is not referenced by the vector predicates, so it is only
+	 * detoasted and decompressed for batches that pass them.
+	 */
+	bool lazy;
+
+	/*
+	 * The column is only referenced by the vector predicates, so it is not
+	 * decompressed at all for batches where the batch metadata shows that
+	 * all rows pass them.
+	 */
+	bool qual_only;
+} DecompressChunkColumnState;
+
+/*
+ * The batch metadata of the column of a vector predicate, used to check
+ * whether all the rows of a batch pass the predicate without decompressing
+ * the column.
+ */
+typedef struct VectorPredicateMetadata
+{
+	/* Compressed scan attnos of the min, max and null count metadata, 0 if missing */
+	AttrNumber min_attno;
+	AttrNumber max_attno;
+	AttrNumber nulls_attno;
+	/* The column has no NULLs, so there is no need for the null count */
+	bool notnull;
+	FmgrInfo *cmp;
+	/* All the rows of the current batch pass the predicate */
+	bool satisfied;
+} VectorPredicateMetadata;
+
+/*
+ * The state of a column for the current row of a batch.
+ */
+typedef struct DecompressBatchColumnState
+{
 	union
 	{
 		struct
 		{
 			Datum value;
 			bool isnull;
-			int count;
 		} segmentby;
 		struct
 		{
 			DecompressionIterator *iterator;
+			/*
+			 * Set instead of the iterator when the whole batch was decompressed
+			 * at once.
+			 */
+			DecompressedColumn *bulk;
+			/* The compressed data, for the predicates evaluated on the dictionary */
+			const CompressedDataHeader *header;
 		} compressed;
 	};
-} DecompressChunkColumnState;
+} DecompressBatchColumnState;
+
+/*
+ * The counters shown by EXPLAIN ANALYZE with
+ * timescaledb.enable_decompression_stats. They are only collected in the
+ * process that runs the node, the parallel workers don't report theirs.
+ */
+typedef struct DecompressChunkStats
+{
+	int64 batches;
+	/* no row of the batch passed the vector predicates */
+	int64 batches_filtered;
+	/* the vector predicates that all rows of a batch pass by the batch metadata */
+	int64 predicates_skipped;
+	/* the columns taken from the cache of decompressed columns */
+	int64 cached_columns;
+	int64 detoasted_bytes;
+	/*
+	 * The decompressed columns and the time spent decompressing them, per
+	 * compression algorithm. For the columns that are decompressed row by row
+	 * with an iterator, only the initialization of the iterator is timed.
+	 */
+	int64 columns[_END_COMPRESSION_ALGORITHMS];
+	instr_time time[_END_COMPRESSION_ALGORITHMS];
+} DecompressChunkStats;
+
+static const char *const compression_algorithm_names[_END_COMPRESSION_ALGORITHMS] = {
+	[_INVALID_COMPRESSION_ALGORITHM] = "invalid",
+	[COMPRESSION_ALGORITHM_ARRAY] = "array",
+	[COMPRESSION_ALGORITHM_DICTIONARY] = "dictionary",
+	[COMPRESSION_ALGORITHM_GORILLA] = "gorilla",
+	[COMPRESSION_ALGORITHM_DELTADELTA] = "deltadelta",
+	[COMPRESSION_ALGORITHM_BITPACK] = "bitpack",
+	[COMPRESSION_ALGORITHM_UUID] = "uuid",
+	[COMPRESSION_ALGORITHM_JSONB] = "jsonb",
+};
+
+/*
+ * A compressed batch that is being decompressed. Usually there is only one,
+ * but the batch sorted merge keeps several batches open at once.
+ */
+typedef struct DecompressBatchState
+{
+	bool initialized;
+	int counter;
+	/* Index of the next row of the batch, used for bulk decompressed columns */
+	int next_row;
+	int rows;
+	/* Selection bitmap for the batch, NULL if the fallback is used */
+	uint64 *filter;
+	/* The decompressed tuple, this is the scan slot unless we merge batches */
+	TupleTableSlot *decompressed_slot;
+	/* Copy of the compressed tuple, only when we merge batches */
+	TupleTableSlot *compressed_slot;
+	MemoryContext per_batch_context;
+	/* The size of the first block of the per-batch context, which a reset keeps */
+	Size per_batch_context_size;
+	DecompressBatchColumnState *columns;
+} DecompressBatchState;
+
+/*
+ * The shared state of a parallel aware DecompressChunk node, see
+ * decompress_chunk_fetch_compressed().
+ */
+typedef struct DecompressChunkParallelState
+{
+	/* The index of the next compressed batch to claim, in the compressed scan order */
+	pg_atomic_uint64 next_batch;
+} DecompressChunkParallelState;
 
 typedef struct DecompressChunkState
 {
@@ -74,26 +216,97 @@ typedef struct DecompressChunkState
 	int num_columns;
 	DecompressChunkColumnState *columns;
 
-	bool initialized;
 	bool reverse;
+	bool enable_bulk_decompression;
 	int hypertable_id;
 	Oid chunk_relid;
 	List *hypertable_compression_info;
-	int counter;
-	MemoryContext per_batch_context;
+
+	/* The current batch, when we don't merge batches */
+	DecompressBatchState *batch;
+
+	/*
+	 * Quals that are evaluated over whole bulk decompressed batches, and the
+	 * offsets of their columns in the columns array.
+	 */
+	List *vector_predicates;
+	List *vector_predicate_columns;
+	/* The batch metadata for each of the vector predicates */
+	VectorPredicateMetadata *vector_predicate_metadata;
+	/* The same quals, for batches where some of the columns are not bulk decompressed */
+	ExprState *vector_qual_fallback;
+
+	/*
+	 * The batch sorted merge, see decompress_chunk_exec_sorted_merge(). The
+	 * open batches are kept in a binary heap ordered by their current rows.
+	 */
+	bool batch_sorted_merge;
+	/* Compressed scan attno of the metadata bounding the first sort column */
+	AttrNumber merge_bound_attno;
+	int n_sortkeys;
+	SortSupportData *sortkeys;
+	int n_batches;
+	DecompressBatchState **batches;
+	Bitmapset *unused_batches;
+	binaryheap *merge_heap;
+	/* The batch at the top of the heap returned its row, advance it first */
+	bool merge_advance_top;
+	/* The next compressed tuple, read ahead to check its bound */
+	TupleTableSlot *merge_next_compressed;
+	bool merge_input_done;
+
+	/*
+	 * The compressed tuples read ahead of the current batch, see
+	 * decompress_chunk_next_compressed(). The TOAST chunks of their
+	 * compressed columns are prefetched.
+	 */
+	int prefetch_batches;
+	TupleTableSlot **prefetch_slots;
+	int prefetch_head;
+	int prefetch_count;
+	bool prefetch_input_done;
+	/* The TOAST relation and index of the compressed chunk, opened on demand */
+	Relation toast_rel;
+	Relation toast_index;
+
+	/*
+	 * The batches claimed by the parallel processes, when the node is parallel
+	 * aware, and the index of the next compressed tuple of this process.
+	 */
+	DecompressChunkParallelState *parallel_state;
+	uint64 parallel_position;
+
+	/* EXPLAIN ANALYZE with timescaledb.enable_decompression_stats */
+	bool collect_stats;
+	bool collect_timing;
+	DecompressChunkStats stats;
 } DecompressChunkState;
 
 static TupleTableSlot *decompress_chunk_exec(CustomScanState *node);
 static void decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags);
 static void decompress_chunk_end(CustomScanState *node);
 static void decompress_chunk_rescan(CustomScanState *node);
-static TupleTableSlot *decompress_chunk_create_tuple(DecompressChunkState *state);
+static void decompress_chunk_explain(CustomScanState *node, List *ancestors, ExplainState *es);
+static Size decompress_chunk_estimate_dsm(CustomScanState *node, ParallelContext *pcxt);
+static void decompress_chunk_initialize_dsm(CustomScanState *node, ParallelContext *pcxt,
+											void *coordinate);
+static void decompress_chunk_reinitialize_dsm(CustomScanState *node, ParallelContext *pcxt,
+											  void *coordinate);
+static void decompress_chunk_initialize_worker(CustomScanState *node, shm_toc *toc,
+											   void *coordinate);
+static TupleTableSlot *decompress_batch_next_tuple(DecompressChunkState *state,
+												   DecompressBatchState *batch);
 
 static CustomExecMethods decompress_chunk_state_methods = {
 	.BeginCustomScan = decompress_chunk_begin,
 	.ExecCustomScan = decompress_chunk_exec,
 	.EndCustomScan = decompress_chunk_end,
 	.ReScanCustomScan = decompress_chunk_rescan,
+	.ExplainCustomScan = decompress_chunk_explain,
+	.EstimateDSMCustomScan = decompress_chunk_estimate_dsm,
+	.InitializeDSMCustomScan = decompress_chunk_initialize_dsm,
+	.ReInitializeDSMCustomScan = decompress_chunk_reinitialize_dsm,
+	.InitializeWorkerCustomScan = decompress_chunk_initialize_worker,
 };
 
 Node *
@@ -110,6 +323,12 @@ decompress_chunk_state_create(CustomScan *cscan)
 	state->hypertable_id = linitial_int(settings);
 	state->chunk_relid = lsecond_int(settings);
 	state->reverse = lthird_int(settings);
+	state->enable_bulk_decompression = lfourth_int(settings);
+	state->batch_sorted_merge = list_nth_int(settings, 4);
+	state->merge_bound_attno = list_nth_int(settings, 5);
+#ifdef USE_PREFETCH
+	state->prefetch_batches = ts_guc_decompress_prefetch_batches;
+#endif
 	state->decompression_map = lsecond(cscan->custom_private);
 
 	return (Node *) state;
@@ -166,11 +385,20 @@ initialize_column_state(DecompressChunkState *state)
 										   NameStr(attribute->attname));
 
 			column->typid = attribute->atttypid;
+			get_typlenbyval(column->typid, &column->typlen, &column->typbyval);
 
 			if (ht_info->segmentby_column_index > 0)
 				column->type = SEGMENTBY_COLUMN;
 			else
 				column->type = COMPRESSED_COLUMN;
+
+			/*
+			 * Bulk decompression produces fixed-width values only, the
+			 * algorithm is checked per batch since it can differ between
+			 * batches.
+			 */
+			column->bulk_decompression_supported =
+				state->enable_bulk_decompression && column->typlen > 0 && column->typlen <= 8;
 		}
 		else
 		{
@@ -191,6 +419,269 @@ initialize_column_state(DecompressChunkState *state)
 	}
 }
 
+/*
+ * Find the attno of a metadata column of the compressed chunk in the output
+ * of the compressed scan. Returns InvalidAttrNumber when the compressed scan
+ * does not output it.
+ */
+static AttrNumber
+find_compressed_scan_metadata_attno(Plan *compressed_scan, Oid compressed_relid, char *name)
+{
+	AttrNumber attno;
+	ListCell *lc;
+
+	/* the name of a compress_minmax metadata column can be too long */
+	if (name == NULL)
+		return InvalidAttrNumber;
+
+	attno = get_attnum(compressed_relid, name);
+	if (attno == InvalidAttrNumber)
+		return InvalidAttrNumber;
+
+	foreach (lc, compressed_scan->targetlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+
+		if (IsA(tle->expr, Var) && castNode(Var, tle->expr)->varattno == attno)
+			return tle->resno;
+	}
+
+	return InvalidAttrNumber;
+}
+
+/*
+ * Look up the min/max batch metadata of the columns of the vector comparison
+ * predicates, and find the columns that are only referenced by the vector
+ * predicates. For batches where the metadata shows that all rows pass the
+ * predicates on such a column, we skip decompressing the column, so e.g.
+ * count(*) with a time range that covers whole batches is computed from the
+ * batch row counts only.
+ */
+static void
+initialize_vector_predicate_metadata(DecompressChunkState *state, CustomScan *cscan,
+									 List *other_quals)
+{
+	PlanState *ps = &state->csstate.ss.ps;
+	TupleDesc desc = state->csstate.ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	Plan *compressed_scan = linitial(cscan->custom_plans);
+	Index scanrelid = cscan->scan.scanrelid;
+	Bitmapset *output_attnos = NULL;
+	Oid compressed_relid;
+	ListCell *lc_predicate;
+	ListCell *lc_column;
+	int i = 0;
+
+	state->vector_predicate_metadata =
+		palloc0(sizeof(VectorPredicateMetadata) * list_length(state->vector_predicates));
+
+	/* the metadata columns can only be found in the output of a plain scan */
+	if (!IsA(compressed_scan, SeqScan) && !IsA(compressed_scan, IndexScan) &&
+		!IsA(compressed_scan, BitmapHeapScan))
+		return;
+
+	compressed_relid = rt_fetch(((Scan *) compressed_scan)->scanrelid, ps->state->es_range_table)
+						   ->relid;
+
+	pull_varattnos((Node *) cscan->scan.plan.targetlist, scanrelid, &output_attnos);
+	pull_varattnos((Node *) other_quals, scanrelid, &output_attnos);
+
+	forboth (lc_predicate, state->vector_predicates, lc_column, state->vector_predicate_columns)
+	{
+		VectorPredicate *predicate = lfirst(lc_predicate);
+		DecompressChunkColumnState *column = &state->columns[lfirst_int(lc_column)];
+		VectorPredicateMetadata *metadata = &state->vector_predicate_metadata[i++];
+		Form_pg_attribute attr = TupleDescAttr(desc, AttrNumberGetAttrOffset(column->output_attno));
+		FormData_hypertable_compression *ht_info =
+			get_column_compressioninfo(state->hypertable_compression_info,
+									   NameStr(attr->attname));
+		TypeCacheEntry *tce;
+
+		if (!bms_is_member(column->output_attno - FirstLowInvalidHeapAttributeNumber,
+						   output_attnos))
+			column->qual_only = true;
+
+		if (predicate->type != VECTOR_PREDICATE_COMPARE)
+			continue;
+
+		metadata->min_attno =
+			find_compressed_scan_metadata_attno(compressed_scan,
+												compressed_relid,
+												compression_column_segment_min_name(ht_info));
+		metadata->max_attno =
+			find_compressed_scan_metadata_attno(compressed_scan,
+												compressed_relid,
+												compression_column_segment_max_name(ht_info));
+		metadata->notnull = attr->attnotnull;
+
+		/* the orderby columns have no null count, only the compress_minmax columns */
+		if (!metadata->notnull && ht_info->orderby_column_index <= 0)
+			metadata->nulls_attno =
+				find_compressed_scan_metadata_attno(compressed_scan,
+													compressed_relid,
+													compression_column_segment_nulls_name(
+														ht_info));
+
+		tce = lookup_type_cache(column->typid, TYPECACHE_CMP_PROC_FINFO);
+		if (OidIsValid(tce->cmp_proc))
+			metadata->cmp = &tce->cmp_proc_finfo;
+	}
+}
+
+/*
+ * Check whether the batch metadata shows that all the rows of the batch pass
+ * the vector comparison predicate.
+ */
+static bool
+vector_predicate_metadata_satisfied(const VectorPredicate *predicate,
+									const VectorPredicateMetadata *metadata, TupleTableSlot *slot)
+{
+	Datum min, max;
+	bool min_isnull, max_isnull;
+	int min_cmp, max_cmp;
+
+	if (metadata->min_attno == InvalidAttrNumber || metadata->max_attno == InvalidAttrNumber ||
+		metadata->cmp == NULL)
+		return false;
+
+	/* the comparison is false for the NULL rows */
+	if (!metadata->notnull)
+	{
+		bool nulls_isnull;
+		Datum nulls;
+
+		if (metadata->nulls_attno == InvalidAttrNumber)
+			return false;
+
+		nulls = slot_getattr(slot, metadata->nulls_attno, &nulls_isnull);
+		if (nulls_isnull || DatumGetInt32(nulls) != 0)
+			return false;
+	}
+
+	min = slot_getattr(slot, metadata->min_attno, &min_isnull);
+	max = slot_getattr(slot, metadata->max_attno, &max_isnull);
+	if (min_isnull || max_isnull)
+		return false;
+
+	min_cmp = DatumGetInt32(
+		FunctionCall2Coll(metadata->cmp, InvalidOid, min, predicate->constvalue));
+	max_cmp = DatumGetInt32(
+		FunctionCall2Coll(metadata->cmp, InvalidOid, max, predicate->constvalue));
+
+	switch (predicate->strategy)
+	{
+		case BTLessStrategyNumber:
+			return max_cmp < 0;
+		case BTLessEqualStrategyNumber:
+			return max_cmp <= 0;
+		case BTEqualStrategyNumber:
+			/* "<>" is negated equality, all rows pass if the value is outside the range */
+			if (predicate->negate)
+				return min_cmp > 0 || max_cmp < 0;
+			return min_cmp == 0 && max_cmp == 0;
+		case BTGreaterEqualStrategyNumber:
+			return min_cmp >= 0;
+		case BTGreaterStrategyNumber:
+			return min_cmp > 0;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Check the vector predicates against the batch metadata. Returns a bitmap of
+ * the columns that don't need to be decompressed for the batch, because they
+ * are only referenced by the predicates that all rows of the batch pass.
+ */
+static Bitmapset *
+compute_vector_predicate_metadata(DecompressChunkState *state, TupleTableSlot *slot)
+{
+	Bitmapset *unneeded_columns = NULL;
+	Bitmapset *needed_columns = NULL;
+	ListCell *lc_predicate;
+	ListCell *lc_column;
+	int i = 0;
+
+	forboth (lc_predicate, state->vector_predicates, lc_column, state->vector_predicate_columns)
+	{
+		VectorPredicateMetadata *metadata = &state->vector_predicate_metadata[i++];
+		int column_index = lfirst_int(lc_column);
+
+		metadata->satisfied =
+			vector_predicate_metadata_satisfied(lfirst(lc_predicate), metadata, slot);
+		if (metadata->satisfied && state->collect_stats)
+			state->stats.predicates_skipped++;
+
+		if (metadata->satisfied && state->columns[column_index].qual_only)
+			unneeded_columns = bms_add_member(unneeded_columns, column_index);
+		else
+			needed_columns = bms_add_member(needed_columns, column_index);
+	}
+
+	return bms_del_members(unneeded_columns, needed_columns);
+}
+
+/*
+ * Split the quals into the ones we can evaluate over whole bulk decompressed
+ * columns and the ones that still need ExecQual for every row.
+ */
+static void
+initialize_vector_predicates(DecompressChunkState *state, CustomScan *cscan)
+{
+	PlanState *ps = &state->csstate.ss.ps;
+	List *vector_quals = NIL;
+	List *other_quals = NIL;
+	ListCell *lc;
+
+	foreach (lc, cscan->scan.plan.qual)
+	{
+		Expr *qual = lfirst(lc);
+		VectorPredicate *predicate = vector_predicate_make(qual, cscan->scan.scanrelid);
+		int column_index = -1;
+
+		for (int i = 0; predicate != NULL && i < state->num_columns; i++)
+		{
+			DecompressChunkColumnState *column = &state->columns[i];
+
+			/* the IN predicates don't need bulk decompression, only the dictionary */
+			if (column->type == COMPRESSED_COLUMN &&
+				(column->bulk_decompression_supported ||
+				 predicate->type == VECTOR_PREDICATE_IN) &&
+				column->output_attno == predicate->output_attno &&
+				column->typid == predicate->typid)
+			{
+				column_index = i;
+				break;
+			}
+		}
+
+		if (column_index < 0)
+		{
+			other_quals = lappend(other_quals, qual);
+			continue;
+		}
+
+		state->vector_predicates = lappend(state->vector_predicates, predicate);
+		state->vector_predicate_columns =
+			lappend_int(state->vector_predicate_columns, column_index);
+		vector_quals = lappend(vector_quals, qual);
+	}
+
+	if (vector_quals == NIL)
+		return;
+
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		if (state->columns[i].type == COMPRESSED_COLUMN &&
+			!list_member_int(state->vector_predicate_columns, i))
+			state->columns[i].lazy = true;
+	}
+
+	initialize_vector_predicate_metadata(state, cscan, other_quals);
+
+	ps->qual = ExecInitQual(other_quals, ps);
+	state->vector_qual_fallback = ExecInitQual(vector_quals, ps);
+}
+
 typedef struct ConstifyTableOidContext
 {
 	Index chunk_index;
@@ -249,6 +740,113 @@ constify_tableoid(List *node, Index chunk_index, Oid chunk_relid)
 	return node;
 }
 
+
+static DecompressBatchState *
+decompress_batch_state_create(DecompressChunkState *state, TupleTableSlot *decompressed_slot)
+{
+	DecompressBatchState *batch = palloc0(sizeof(DecompressBatchState));
+
+	batch->decompressed_slot = decompressed_slot;
+	batch->columns = palloc0(sizeof(DecompressBatchColumnState) * Max(state->num_columns, 1));
+	batch->per_batch_context = AllocSetContextCreate(CurrentMemoryContext,
+													 "DecompressChunk per_batch",
+													 ALLOCSET_DEFAULT_SIZES);
+	batch->per_batch_context_size = ALLOCSET_DEFAULT_INITSIZE;
+	return batch;
+}
+
+/*
+ * The memory of a context that is in use, not counting the free space of its
+ * blocks and its free chunks.
+ */
+static Size
+memory_context_used_space(MemoryContext context)
+{
+	MemoryContextCounters counters = { 0 };
+
+#if PG14_LT
+	context->methods->stats(context, NULL, NULL, &counters);
+#else
+	context->methods->stats(context, NULL, NULL, &counters, false);
+#endif
+
+	return counters.totalspace - counters.freespace;
+}
+
+/*
+ * Reset the per-batch memory context for the next batch.
+ *
+ * A reset frees all the blocks of the context except the first one, so the
+ * iterators and decompressed columns of a batch that does not fit into the
+ * first block are allocated with malloc and freed again for every batch.
+ * When that happens, the context is recreated with a first block that fits
+ * the batch, which the following batches, usually of the same columns and
+ * number of rows, reuse without malloc and free. Values larger than the chunk
+ * limit of the context still get blocks of their own.
+ */
+static void
+decompress_batch_reset_context(DecompressBatchState *batch)
+{
+	Size used = memory_context_used_space(batch->per_batch_context);
+	Size size = batch->per_batch_context_size;
+
+	if (used <= size || size >= ALLOCSET_DEFAULT_MAXSIZE)
+	{
+		MemoryContextReset(batch->per_batch_context);
+		return;
+	}
+
+	while (size < used && size < ALLOCSET_DEFAULT_MAXSIZE)
+		size *= 2;
+
+	MemoryContext parent = batch->per_batch_context->parent;
+	MemoryContextDelete(batch->per_batch_context);
+	batch->per_batch_context = AllocSetContextCreate(parent,
+													 "DecompressChunk per_batch",
+													 size,
+													 size,
+													 ALLOCSET_DEFAULT_MAXSIZE);
+	batch->per_batch_context_size = size;
+}
+
+/*
+ * Initialize the sort keys of the batch sorted merge from the sort settings
+ * in the plan, like ExecInitMergeAppend does.
+ */
+static void
+initialize_batch_sorted_merge(DecompressChunkState *state, CustomScan *cscan)
+{
+	List *sortinfo = lthird(cscan->custom_private);
+	List *sort_col_idx = linitial(sortinfo);
+	List *sort_operators = lsecond(sortinfo);
+	List *collations = lthird(sortinfo);
+	List *nulls_first = lfourth(sortinfo);
+
+	state->n_sortkeys = list_length(sort_col_idx);
+	state->sortkeys = palloc0(sizeof(SortSupportData) * state->n_sortkeys);
+
+	for (int i = 0; i < state->n_sortkeys; i++)
+	{
+		SortSupport sortkey = &state->sortkeys[i];
+
+		sortkey->ssup_cxt = CurrentMemoryContext;
+		sortkey->ssup_collation = list_nth_oid(collations, i);
+		sortkey->ssup_nulls_first = list_nth_int(nulls_first, i);
+		sortkey->ssup_attno = list_nth_int(sort_col_idx, i);
+		sortkey->abbreviate = false;
+
+		PrepareSortSupportFromOrderingOp(list_nth_oid(sort_operators, i), sortkey);
+	}
+
+	state->n_batches = 0;
+	state->batches = NULL;
+	state->unused_batches = NULL;
+	state->merge_heap = NULL;
+	state->merge_advance_top = false;
+	state->merge_next_compressed = NULL;
+	state->merge_input_done = false;
+}
+
 /*
  * Complete initialization of the supplied CustomScanState.
  *
@@ -293,154 +891,1186 @@ decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
 
 	initialize_column_state(state);
 
+	if (state->enable_bulk_decompression)
+		initialize_vector_predicates(state, cscan);
+
+	if (state->batch_sorted_merge)
+		initialize_batch_sorted_merge(state, cscan);
+	else
+		state->batch = decompress_batch_state_create(state, node->ss.ss_ScanTupleSlot);
+
 	node->custom_ps = lappend(node->custom_ps, ExecInitNode(compressed_scan, estate, eflags));
 
-	state->per_batch_context = AllocSetContextCreate(CurrentMemoryContext,
-													 "DecompressChunk per_batch",
-													 ALLOCSET_DEFAULT_SIZES);
+	if (ts_guc_enable_decompression_stats && node->ss.ps.instrument != NULL)
+	{
+		state->collect_stats = true;
+		state->collect_timing = node->ss.ps.instrument->need_timer;
+	}
+
+	if (state->prefetch_batches > 0)
+	{
+		TupleDesc compressed_desc = ExecGetResultType(linitial(node->custom_ps));
+
+		state->prefetch_slots = palloc(sizeof(TupleTableSlot *) * state->prefetch_batches);
+		for (int i = 0; i < state->prefetch_batches; i++)
+			state->prefetch_slots[i] =
+				MakeSingleTupleTableSlot(compressed_desc, &TTSOpsMinimalTuple);
+	}
 }
 
+#ifdef USE_PREFETCH
+/*
+ * Look up the TOAST chunks of an external value in the TOAST index and
+ * prefetch the heap blocks that hold them. The index lookup itself is
+ * synchronous, but the index is small and usually cached, while the TOAST
+ * heap blocks are the ones that are read at random.
+ */
 static void
-initialize_batch(DecompressChunkState *state, TupleTableSlot *slot)
+prefetch_toast_value(DecompressChunkState *state, struct varatt_external *toast_pointer)
 {
-	Datum value;
-	bool isnull;
-	int i;
-	MemoryContext old_context = MemoryContextSwitchTo(state->per_batch_context);
-	MemoryContextReset(state->per_batch_context);
+	IndexScanDesc scan;
+	ScanKeyData key;
+	ItemPointer tid;
+	BlockNumber last_block = InvalidBlockNumber;
 
-	for (i = 0; i < state->num_columns; i++)
+	if (state->toast_rel == NULL)
 	{
-		DecompressChunkColumnState *column = &state->columns[i];
+		List *indexes;
+		ListCell *lc;
 
-		switch (column->type)
-		{
-			case COMPRESSED_COLUMN:
-			{
-				value = slot_getattr(slot, column->compressed_scan_attno, &isnull);
-				if (!isnull)
-				{
-					CompressedDataHeader *header = (CompressedDataHeader *) PG_DETOAST_DATUM(value);
+		state->toast_rel = table_open(toast_pointer->va_toastrelid, AccessShareLock);
+		indexes = RelationGetIndexList(state->toast_rel);
 
-					column->compressed.iterator =
-						tsl_get_decompression_iterator_init(header->compression_algorithm,
-															state->reverse)(PointerGetDatum(header),
-																			column->typid);
-				}
-				else
-					column->compressed.iterator = NULL;
+		foreach (lc, indexes)
+		{
+			Relation index = index_open(lfirst_oid(lc), AccessShareLock);
 
+			if (index->rd_index->indisvalid)
+			{
+				state->toast_index = index;
 				break;
 			}
-			case SEGMENTBY_COLUMN:
-				value = slot_getattr(slot, column->compressed_scan_attno, &isnull);
-				if (!isnull)
-					column->segmentby.value = value;
-				else
-					column->segmentby.value = (Datum) 0;
 
-				column->segmentby.isnull = isnull;
-				break;
-			case COUNT_COLUMN:
-				value = slot_getattr(slot, column->compressed_scan_attno, &isnull);
-				state->counter = DatumGetInt32(value);
-				/* count column should never be NULL */
-				Assert(!isnull);
-				break;
-			case SEQUENCE_NUM_COLUMN:
-				/*
-				 * nothing to do here for sequence number
-				 * we only needed this for sorting in node below
-				 */
-				break;
+			index_close(index, AccessShareLock);
 		}
-	}
-	state->initialized = true;
-	MemoryContextSwitchTo(old_context);
-}
-
-static TupleTableSlot *
-decompress_chunk_exec(CustomScanState *node)
-{
-	DecompressChunkState *state = (DecompressChunkState *) node;
-	ExprContext *econtext = node->ss.ps.ps_ExprContext;
 
-	if (node->custom_ps == NIL)
-		return NULL;
+		list_free(indexes);
+	}
 
-	while (true)
-	{
-		TupleTableSlot *slot = decompress_chunk_create_tuple(state);
+	/* the compressed chunk and its TOAST relation do not change during the scan */
+	if (state->toast_index == NULL ||
+		RelationGetRelid(state->toast_rel) != toast_pointer->va_toastrelid)
+		return;
 
-		if (TupIsNull(slot))
-			return NULL;
+	ScanKeyInit(&key,
+				(AttrNumber) 1,
+				BTEqualStrategyNumber,
+				F_OIDEQ,
+				ObjectIdGetDatum(toast_pointer->va_valueid));
 
-		econtext->ecxt_scantuple = slot;
+	/*
+	 * Visibility does not matter here, prefetching the block of a dead chunk
+	 * is harmless, so we don't need to fetch the heap tuples.
+	 */
+	scan = index_beginscan(state->toast_rel, state->toast_index, SnapshotAny, 1, 0);
+	index_rescan(scan, &key, 1, NULL, 0);
 
-		/* Reset expression memory context to clean out any cruft from
-		 * previous tuple. */
-		ResetExprContext(econtext);
+	while ((tid = index_getnext_tid(scan, ForwardScanDirection)) != NULL)
+	{
+		BlockNumber block = ItemPointerGetBlockNumber(tid);
 
-		if (node->ss.ps.qual && !ExecQual(node->ss.ps.qual, econtext))
-		{
-			InstrCountFiltered1(node, 1);
-			ExecClearTuple(slot);
+		if (block == last_block)
 			continue;
-		}
-
-		if (!node->ss.ps.ps_ProjInfo)
-			return slot;
 
-		return ExecProject(node->ss.ps.ps_ProjInfo);
+		(void) PrefetchBuffer(state->toast_rel, MAIN_FORKNUM, block);
+		last_block = block;
 	}
+
+	index_endscan(scan);
 }
 
 static void
-decompress_chunk_rescan(CustomScanState *node)
+prefetch_compressed_tuple(DecompressChunkState *state, TupleTableSlot *slot)
 {
-	((DecompressChunkState *) node)->initialized = false;
-	ExecReScan(linitial(node->custom_ps));
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+		struct varatt_external toast_pointer;
+		struct varlena *value;
+		bool isnull;
+
+		if (column->type != COMPRESSED_COLUMN)
+			continue;
+
+		value = (struct varlena *) DatumGetPointer(
+			slot_getattr(slot, column->compressed_scan_attno, &isnull));
+
+		if (isnull || !VARATT_IS_EXTERNAL_ONDISK(value))
+			continue;
+
+		VARATT_EXTERNAL_GET_POINTER(toast_pointer, value);
+		prefetch_toast_value(state, &toast_pointer);
+	}
 }
+#endif
 
-static void
-decompress_chunk_end(CustomScanState *node)
+/*
+ * Return the next compressed tuple of the compressed scan.
+ *
+ * When the node is parallel aware, every process runs the whole compressed
+ * scan, and they claim the batches one at a time from a shared counter of the
+ * position in the scan. A process skips the compressed tuples up to the batch
+ * it claimed, which is cheap because their TOASTed compressed columns are not
+ * fetched. The processes see the same compressed tuples in the same order,
+ * since they use the same snapshot and the scan is not synchronized, see
+ * decompress_chunk_parallel_attach().
+ */
+static TupleTableSlot *
+decompress_chunk_fetch_compressed(DecompressChunkState *state)
 {
-	MemoryContextReset(((DecompressChunkState *) node)->per_batch_context);
-	ExecEndNode(linitial(node->custom_ps));
+	PlanState *compressed_scan = linitial(state->csstate.custom_ps);
+	TupleTableSlot *slot;
+	uint64 claimed;
+
+	if (state->parallel_state == NULL)
+		return ExecProcNode(compressed_scan);
+
+	claimed = pg_atomic_fetch_add_u64(&state->parallel_state->next_batch, 1);
+
+	for (;;)
+	{
+		slot = ExecProcNode(compressed_scan);
+
+		if (TupIsNull(slot) || state->parallel_position++ == claimed)
+			return slot;
+	}
 }
 
 /*
- * Create generated tuple according to column state
+ * Return the next compressed tuple.
+ *
+ * With timescaledb.decompress_prefetch_batches, the compressed tuples of the
+ * next batches are read ahead into a ring of slots and the TOAST chunks of
+ * their compressed columns are prefetched, so that the reads are already in
+ * flight when the batches are detoasted in initialize_batch(). The returned
+ * slot stays valid until the next call.
  */
 static TupleTableSlot *
-decompress_chunk_create_tuple(DecompressChunkState *state)
+decompress_chunk_next_compressed(DecompressChunkState *state)
 {
-	TupleTableSlot *slot = state->csstate.ss.ss_ScanTupleSlot;
-	bool batch_done = false;
+	TupleTableSlot *slot;
+
+	if (state->prefetch_batches == 0)
+		return decompress_chunk_fetch_compressed(state);
+
+	while (!state->prefetch_input_done && state->prefetch_count < state->prefetch_batches)
+	{
+		TupleTableSlot *subslot = decompress_chunk_fetch_compressed(state);
+		int slot_index;
+
+		if (TupIsNull(subslot))
+		{
+			state->prefetch_input_done = true;
+			break;
+		}
+
+		slot_index = (state->prefetch_head + state->prefetch_count) % state->prefetch_batches;
+		slot = ExecCopySlot(state->prefetch_slots[slot_index], subslot);
+#ifdef USE_PREFETCH
+		prefetch_compressed_tuple(state, slot);
+#endif
+		state->prefetch_count++;
+	}
+
+	if (state->prefetch_count == 0)
+		return NULL;
+
+	slot = state->prefetch_slots[state->prefetch_head];
+	state->prefetch_head = (state->prefetch_head + 1) % state->prefetch_batches;
+	state->prefetch_count--;
+
+	return slot;
+}
+
+/*
+ * Evaluate the vector predicates for the batch. This is only possible when
+ * all the columns they reference were bulk decompressed, or are dictionary
+ * compressed for the IN predicates. Otherwise the batch filter is left NULL
+ * and the quals are checked row by row. The predicates that the batch
+ * metadata shows all rows to pass are skipped.
+ *
+ * Returns false if no row of the batch can pass the quals.
+ */
+static bool
+compute_batch_filter(DecompressChunkState *state, DecompressBatchState *batch)
+{
+	ListCell *lc_predicate;
+	ListCell *lc_column;
+	int n_words;
+	int i = 0;
+
+	batch->filter = NULL;
+	batch->rows = batch->counter;
+
+	forboth (lc_predicate, state->vector_predicates, lc_column, state->vector_predicate_columns)
+	{
+		VectorPredicate *predicate = lfirst(lc_predicate);
+		DecompressBatchColumnState *column = &batch->columns[lfirst_int(lc_column)];
+
+		/* all rows pass according to the batch metadata */
+		if (state->vector_predicate_metadata[i++].satisfied)
+			continue;
+
+		if (predicate->type == VECTOR_PREDICATE_IN)
+		{
+			if (column->compressed.header == NULL ||
+				column->compressed.header->compression_algorithm !=
+					COMPRESSION_ALGORITHM_DICTIONARY)
+				return true;
+
+			continue;
+		}
+
+		if (column->compressed.bulk == NULL)
+			return true;
+
+		batch->rows = column->compressed.bulk->length;
+	}
+
+	n_words = (batch->rows + 63) / 64;
+	batch->filter = palloc(sizeof(uint64) * Max(n_words, 1));
+	memset(batch->filter, 0xFF, sizeof(uint64) * Max(n_words, 1));
+
+	i = 0;
+	forboth (lc_predicate, state->vector_predicates, lc_column, state->vector_predicate_columns)
+	{
+		VectorPredicate *predicate = lfirst(lc_predicate);
+		DecompressBatchColumnState *column = &batch->columns[lfirst_int(lc_column)];
+
+		if (state->vector_predicate_metadata[i++].satisfied)
+			continue;
+
+		if (predicate->type == VECTOR_PREDICATE_IN)
+			vector_predicate_compute_dictionary(predicate,
+												(const DictionaryCompressed *)
+													column->compressed.header,
+												batch->rows,
+												batch->filter);
+		else
+			vector_predicate_compute(predicate, column->compressed.bulk, batch->filter);
+	}
+
+	return !vector_predicate_filter_is_empty(batch->filter, batch->rows);
+}
+
+static inline void
+decompression_timer_start(DecompressChunkState *state, instr_time *start)
+{
+	if (state->collect_timing)
+		INSTR_TIME_SET_CURRENT(*start);
+	else
+		INSTR_TIME_SET_ZERO(*start);
+}
+
+static inline void
+decompression_timer_stop(DecompressChunkState *state, int algorithm, instr_time *start)
+{
+	instr_time end;
+
+	if (!state->collect_timing || algorithm <= 0 || algorithm >= _END_COMPRESSION_ALGORITHMS)
+		return;
+
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_ACCUM_DIFF(state->stats.time[algorithm], end, *start);
+}
+
+static void
+initialize_batch_compressed_column(DecompressChunkState *state, DecompressChunkColumnState *column,
+								   DecompressBatchColumnState *column_values, TupleTableSlot *slot)
+{
+	bool isnull;
+	Datum value = slot_getattr(slot, column->compressed_scan_attno, &isnull);
+
+	column_values->compressed.iterator = NULL;
+	column_values->compressed.bulk = NULL;
+	column_values->compressed.header = NULL;
+
+	if (!isnull)
+	{
+		CompressedDataHeader *header;
+		DecompressAllFunction decompress_all = NULL;
+		struct varatt_external toast_pointer;
+		instr_time start;
+		bool use_cache = ts_guc_decompress_cache_size > 0 && column->bulk_decompression_supported &&
+						 VARATT_IS_EXTERNAL_ONDISK(DatumGetPointer(value));
+
+		/*
+		 * The batches that were decompressed recently are taken from the cache
+		 * without even detoasting them. Without the compressed data, the
+		 * predicates on the dictionary fall back to the decompressed values.
+		 */
+		if (use_cache)
+		{
+			VARATT_EXTERNAL_GET_POINTER(toast_pointer, DatumGetPointer(value));
+			column_values->compressed.bulk =
+				decompressed_column_cache_get(&toast_pointer, column->typid);
+
+			if (column_values->compressed.bulk != NULL)
+			{
+				if (state->collect_stats)
+					state->stats.cached_columns++;
+				return;
+			}
+		}
+
+		header = (CompressedDataHeader *) PG_DETOAST_DATUM(value);
+		column_values->compressed.header = header;
+
+		if (state->collect_stats)
+		{
+			if ((Pointer) header != DatumGetPointer(value))
+				state->stats.detoasted_bytes += VARSIZE(header);
+			if (header->compression_algorithm < _END_COMPRESSION_ALGORITHMS)
+				state->stats.columns[header->compression_algorithm]++;
+		}
+
+		if (column->bulk_decompression_supported)
+			decompress_all = tsl_get_decompress_all_function(header->compression_algorithm);
+
+		decompression_timer_start(state, &start);
+
+		if (decompress_all != NULL)
+		{
+			column_values->compressed.bulk = decompress_all(PointerGetDatum(header), column->typid);
+
+			if (use_cache)
+				decompressed_column_cache_put(&toast_pointer,
+											  column->typid,
+											  column_values->compressed.bulk);
+		}
+		else
+		{
+			DecompressionIterator *(*iterator_init)(Datum, Oid) =
+				tsl_get_decompression_iterator_init(header->compression_algorithm,
+													state->reverse);
+
+			column_values->compressed.iterator =
+				iterator_init(PointerGetDatum(header), column->typid);
+		}
+
+		decompression_timer_stop(state, header->compression_algorithm, &start);
+	}
+}
+
+static void
+initialize_batch(DecompressChunkState *state, DecompressBatchState *batch, TupleTableSlot *slot)
+{
+	Datum value;
+	bool isnull;
 	int i;
+	Bitmapset *unneeded_columns = NULL;
+	MemoryContext old_context;
+
+	decompress_batch_reset_context(batch);
+	old_context = MemoryContextSwitchTo(batch->per_batch_context);
+
+	/*
+	 * The decompressed values can point into the compressed tuple, so when
+	 * several batches are open at once, each of them needs its own copy.
+	 */
+	if (batch->compressed_slot != NULL)
+		slot = ExecCopySlot(batch->compressed_slot, slot);
+
+	if (state->vector_predicates != NIL)
+		unneeded_columns = compute_vector_predicate_metadata(state, slot);
+
+	for (i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+		DecompressBatchColumnState *column_values = &batch->columns[i];
+
+		switch (column->type)
+		{
+			case COMPRESSED_COLUMN:
+				column_values->compressed.iterator = NULL;
+				column_values->compressed.bulk = NULL;
+				column_values->compressed.header = NULL;
+
+				/* lazy columns are decompressed after the vector predicates */
+				if (!column->lazy && !bms_is_member(i, unneeded_columns))
+					initialize_batch_compressed_column(state, column, column_values, slot);
+				break;
+			case SEGMENTBY_COLUMN:
+				value = slot_getattr(slot, column->compressed_scan_attno, &isnull);
+				if (!isnull)
+					column_values->segmentby.value = value;
+				else
+					column_values->segmentby.value = (Datum) 0;
+
+				column_values->segmentby.isnull = isnull;
+				break;
+			case COUNT_COLUMN:
+				value = slot_getattr(slot, column->compressed_scan_attno, &isnull);
+				batch->counter = DatumGetInt32(value);
+				/* count column should never be NULL */
+				Assert(!isnull);
+				break;
+			case SEQUENCE_NUM_COLUMN:
+				/*
+				 * nothing to do here for sequence number
+				 * we only needed this for sorting in node below
+				 */
+				break;
+		}
+	}
+	batch->next_row = 0;
+	batch->filter = NULL;
+	batch->initialized = true;
+
+	if (state->collect_stats)
+		state->stats.batches++;
+
+	if (state->vector_predicates != NIL && !compute_batch_filter(state, batch))
+	{
+		/* no row of this batch can pass the quals, skip the whole batch */
+		InstrCountFiltered1(state, batch->rows);
+		if (state->collect_stats)
+			state->stats.batches_filtered++;
+		batch->initialized = false;
+		MemoryContextSwitchTo(old_context);
+		return;
+	}
+
+	/*
+	 * Detoast and decompress the columns that are not referenced by the
+	 * vector predicates only for the batches that pass them. On wide tables
+	 * this skips most of the work for batches that are filtered out.
+	 */
+	for (i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+
+		if (column->lazy)
+			initialize_batch_compressed_column(state, column, &batch->columns[i], slot);
+	}
+
+	/*
+	 * The quals are checked row by row when the batch filter could not be
+	 * computed, and then they need all their columns.
+	 */
+	if (batch->filter == NULL)
+	{
+		i = -1;
+		while ((i = bms_next_member(unneeded_columns, i)) >= 0)
+			initialize_batch_compressed_column(state, &state->columns[i], &batch->columns[i], slot);
+	}
+
+	MemoryContextSwitchTo(old_context);
+}
+
+/*
+ * Return the next row of the batch that passes the quals, or NULL when the
+ * batch is exhausted.
+ */
+static TupleTableSlot *
+decompress_batch_next_qualifying_tuple(DecompressChunkState *state, DecompressBatchState *batch)
+{
+	CustomScanState *node = &state->csstate;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+
+	while (true)
+	{
+		TupleTableSlot *slot = decompress_batch_next_tuple(state, batch);
+
+		if (TupIsNull(slot))
+			return NULL;
+
+		econtext->ecxt_scantuple = slot;
+
+		/* Reset expression memory context to clean out any cruft from
+		 * previous tuple. */
+		ResetExprContext(econtext);
+
+		if (state->vector_qual_fallback && batch->filter == NULL &&
+			!ExecQual(state->vector_qual_fallback, econtext))
+		{
+			InstrCountFiltered1(node, 1);
+			ExecClearTuple(slot);
+			continue;
+		}
+
+		if (node->ss.ps.qual && !ExecQual(node->ss.ps.qual, econtext))
+		{
+			InstrCountFiltered1(node, 1);
+			ExecClearTuple(slot);
+			continue;
+		}
+
+		return slot;
+	}
+}
+
+/*
+ * Compare the current rows of two batches in the heap of the batch sorted
+ * merge. The binary heap puts the largest element first, so the result is
+ * inverted to get the first row in the sort order at the top.
+ */
+static int
+decompress_batch_heap_compare(Datum a, Datum b, void *arg)
+{
+	DecompressChunkState *state = (DecompressChunkState *) arg;
+	TupleTableSlot *slot_a = state->batches[DatumGetInt32(a)]->decompressed_slot;
+	TupleTableSlot *slot_b = state->batches[DatumGetInt32(b)]->decompressed_slot;
+
+	for (int i = 0; i < state->n_sortkeys; i++)
+	{
+		SortSupport sortkey = &state->sortkeys[i];
+		bool isnull_a, isnull_b;
+		Datum value_a = slot_getattr(slot_a, sortkey->ssup_attno, &isnull_a);
+		Datum value_b = slot_getattr(slot_b, sortkey->ssup_attno, &isnull_b);
+		int compare = ApplySortComparator(value_a, isnull_a, value_b, isnull_b, sortkey);
+
+		if (compare != 0)
+		{
+			INVERT_COMPARE_RESULT(compare);
+			return compare;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Get a free batch state for the batch sorted merge, allocating more of them
+ * if all are in use.
+ */
+static int
+decompress_batch_acquire(DecompressChunkState *state)
+{
+	int batch_index = bms_next_member(state->unused_batches, -1);
+
+	if (batch_index < 0)
+	{
+		TupleDesc compressed_desc = ExecGetResultType(linitial(state->csstate.custom_ps));
+		TupleDesc decompressed_desc = state->csstate.ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+		int n_batches = Max(state->n_batches * 2, 16);
+
+		if (state->batches == NULL)
+			state->batches = palloc(sizeof(DecompressBatchState *) * n_batches);
+		else
+			state->batches = repalloc(state->batches, sizeof(DecompressBatchState *) * n_batches);
+
+		for (int i = state->n_batches; i < n_batches; i++)
+		{
+			TupleTableSlot *slot = MakeSingleTupleTableSlot(decompressed_desc, &TTSOpsVirtual);
+			DecompressBatchState *batch = decompress_batch_state_create(state, slot);
+
+			batch->compressed_slot = MakeSingleTupleTableSlot(compressed_desc, &TTSOpsMinimalTuple);
+			state->batches[i] = batch;
+			state->unused_batches = bms_add_member(state->unused_batches, i);
+		}
+
+		state->n_batches = n_batches;
+
+		/* the heap can't grow, so we build a larger one */
+		if (state->merge_heap == NULL)
+			state->merge_heap =
+				binaryheap_allocate(n_batches, decompress_batch_heap_compare, state);
+		else
+		{
+			binaryheap *old_heap = state->merge_heap;
+
+			state->merge_heap =
+				binaryheap_allocate(n_batches, decompress_batch_heap_compare, state);
+			for (int i = 0; i < old_heap->bh_size; i++)
+				binaryheap_add_unordered(state->merge_heap, old_heap->bh_nodes[i]);
+			binaryheap_build(state->merge_heap);
+			binaryheap_free(old_heap);
+		}
+
+		batch_index = bms_next_member(state->unused_batches, -1);
+	}
+
+	state->unused_batches = bms_del_member(state->unused_batches, batch_index);
+	return batch_index;
+}
+
+static inline TupleTableSlot *
+decompress_batch_top_slot(DecompressChunkState *state)
+{
+	return state->batches[DatumGetInt32(binaryheap_first(state->merge_heap))]->decompressed_slot;
+}
+
+static void
+decompress_batch_release(DecompressChunkState *state, int batch_index)
+{
+	DecompressBatchState *batch = state->batches[batch_index];
+
+	batch->initialized = false;
+	ExecClearTuple(batch->decompressed_slot);
+	ExecClearTuple(batch->compressed_slot);
+	decompress_batch_reset_context(batch);
+	state->unused_batches = bms_add_member(state->unused_batches, batch_index);
+}
+
+/*
+ * Check if a batch that is not open yet can contain rows that go before the
+ * current row at the top of the heap. The compressed batches come in the
+ * order of the min or max metadata of the first sort column, which bounds the
+ * values of the batch and of all the batches after it.
+ */
+static bool
+decompress_batch_can_precede_top(DecompressChunkState *state, TupleTableSlot *compressed_slot)
+{
+	SortSupport sortkey = &state->sortkeys[0];
+	TupleTableSlot *top_slot;
+	Datum top_value, bound;
+	bool top_isnull, bound_isnull;
+
+	if (state->merge_heap == NULL || binaryheap_empty(state->merge_heap))
+		return true;
+
+	top_slot = decompress_batch_top_slot(state);
+	top_value = slot_getattr(top_slot, sortkey->ssup_attno, &top_isnull);
+	bound = slot_getattr(compressed_slot, state->merge_bound_attno, &bound_isnull);
+
+	return ApplySortComparator(top_value, top_isnull, bound, bound_isnull, sortkey) >= 0;
+}
+
+/*
+ * Merge the decompressed batches into a sorted output. Every batch is sorted
+ * by the orderby columns, so we keep the open batches in a binary heap by
+ * their current rows and return the top one, like MergeAppend does for its
+ * children. The compressed scan returns the batches in the order of their
+ * first sort column metadata, so a batch only has to be opened when its
+ * bound is not after the current top row. This way, the number of open
+ * batches is the number of batches that overlap, and not all the batches of
+ * the chunk.
+ */
+static TupleTableSlot *
+decompress_chunk_exec_sorted_merge(DecompressChunkState *state)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	TupleTableSlot *slot;
+
+	/* move the batch that returned the previous row to its next row */
+	if (state->merge_advance_top)
+	{
+		int batch_index = DatumGetInt32(binaryheap_first(state->merge_heap));
+
+		state->merge_advance_top = false;
+		if (decompress_batch_next_qualifying_tuple(state, state->batches[batch_index]) != NULL)
+			binaryheap_replace_first(state->merge_heap, Int32GetDatum(batch_index));
+		else
+		{
+			(void) binaryheap_remove_first(state->merge_heap);
+			decompress_batch_release(state, batch_index);
+		}
+	}
 
+	/* open the batches that can have rows before the current top row */
 	while (true)
 	{
-		if (!state->initialized)
+		int batch_index;
+		DecompressBatchState *batch;
+
+		if (state->merge_next_compressed == NULL && !state->merge_input_done)
 		{
-			TupleTableSlot *subslot = ExecProcNode(linitial(state->csstate.custom_ps));
+			TupleTableSlot *subslot = decompress_chunk_next_compressed(state);
+
+			if (TupIsNull(subslot))
+				state->merge_input_done = true;
+			else
+				state->merge_next_compressed = subslot;
+		}
+
+		if (state->merge_next_compressed == NULL ||
+			!decompress_batch_can_precede_top(state, state->merge_next_compressed))
+			break;
+
+		batch_index = decompress_batch_acquire(state);
+		batch = state->batches[batch_index];
+		initialize_batch(state, batch, state->merge_next_compressed);
+		state->merge_next_compressed = NULL;
+
+		if (!batch->initialized || decompress_batch_next_qualifying_tuple(state, batch) == NULL)
+		{
+			/* no rows of this batch pass the quals */
+			decompress_batch_release(state, batch_index);
+			continue;
+		}
+
+		binaryheap_add(state->merge_heap, Int32GetDatum(batch_index));
+	}
+
+	if (state->merge_heap == NULL || binaryheap_empty(state->merge_heap))
+		return NULL;
+
+	state->merge_advance_top = true;
+	slot = decompress_batch_top_slot(state);
+
+	if (!state->csstate.ss.ps.ps_ProjInfo)
+		return slot;
+
+	econtext->ecxt_scantuple = slot;
+	return ExecProject(state->csstate.ss.ps.ps_ProjInfo);
+}
+
+static TupleTableSlot *
+decompress_chunk_exec(CustomScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+	DecompressBatchState *batch = state->batch;
+
+	if (node->custom_ps == NIL)
+		return NULL;
+
+	if (state->batch_sorted_merge)
+		return decompress_chunk_exec_sorted_merge(state);
+
+	while (true)
+	{
+		TupleTableSlot *slot;
+
+		if (!batch->initialized)
+		{
+			TupleTableSlot *subslot = decompress_chunk_next_compressed(state);
 
 			if (TupIsNull(subslot))
 				return NULL;
 
-			batch_done = false;
-			initialize_batch(state, subslot);
+			initialize_batch(state, batch, subslot);
+
+			/* the batch was filtered out by the vector predicates */
+			if (!batch->initialized)
+				continue;
+		}
+
+		slot = decompress_batch_next_qualifying_tuple(state, batch);
+
+		/* the batch is exhausted */
+		if (TupIsNull(slot))
+			continue;
+
+		if (!node->ss.ps.ps_ProjInfo)
+			return slot;
+
+		return ExecProject(node->ss.ps.ps_ProjInfo);
+	}
+}
+
+static void
+decompress_chunk_rescan(CustomScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	if (state->batch_sorted_merge)
+	{
+		for (int i = 0; i < state->n_batches; i++)
+		{
+			if (!bms_is_member(i, state->unused_batches))
+				decompress_batch_release(state, i);
+		}
+
+		if (state->merge_heap != NULL)
+			binaryheap_reset(state->merge_heap);
+
+		state->merge_advance_top = false;
+		state->merge_next_compressed = NULL;
+		state->merge_input_done = false;
+	}
+	else
+		state->batch->initialized = false;
+
+	state->prefetch_head = 0;
+	state->prefetch_count = 0;
+	state->prefetch_input_done = false;
+	state->parallel_position = 0;
+
+	ExecReScan(linitial(node->custom_ps));
+}
+
+/*
+ * Use the shared counter of the claimed batches. All the processes have to see
+ * the compressed tuples in the same order, so the scan of the compressed chunk
+ * must not start at the current position of another scan of it, as a
+ * synchronized sequential scan of a large compressed chunk would.
+ */
+static void
+decompress_chunk_parallel_attach(DecompressChunkState *state, DecompressChunkParallelState *pstate)
+{
+	PlanState *compressed_scan = linitial(state->csstate.custom_ps);
+
+	state->parallel_state = pstate;
+	state->parallel_position = 0;
+
+	if (IsA(compressed_scan, SeqScanState))
+	{
+		ScanState *ss = (ScanState *) compressed_scan;
+
+		if (ss->ss_currentScanDesc == NULL)
+			ss->ss_currentScanDesc = table_beginscan_strat(ss->ss_currentRelation,
+														   compressed_scan->state->es_snapshot,
+														   0,
+														   NULL,
+														   true,
+														   false);
+	}
+}
+
+static Size
+decompress_chunk_estimate_dsm(CustomScanState *node, ParallelContext *pcxt)
+{
+	return sizeof(DecompressChunkParallelState);
+}
+
+static void
+decompress_chunk_initialize_dsm(CustomScanState *node, ParallelContext *pcxt, void *coordinate)
+{
+	DecompressChunkParallelState *pstate = (DecompressChunkParallelState *) coordinate;
+
+	pg_atomic_init_u64(&pstate->next_batch, 0);
+	decompress_chunk_parallel_attach((DecompressChunkState *) node, pstate);
+}
+
+static void
+decompress_chunk_reinitialize_dsm(CustomScanState *node, ParallelContext *pcxt, void *coordinate)
+{
+	DecompressChunkParallelState *pstate = (DecompressChunkParallelState *) coordinate;
+
+	pg_atomic_write_u64(&pstate->next_batch, 0);
+}
+
+static void
+decompress_chunk_initialize_worker(CustomScanState *node, shm_toc *toc, void *coordinate)
+{
+	decompress_chunk_parallel_attach((DecompressChunkState *) node,
+									 (DecompressChunkParallelState *) coordinate);
+}
+
+static void
+decompress_chunk_end(CustomScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	if (state->batch_sorted_merge)
+	{
+		for (int i = 0; i < state->n_batches; i++)
+		{
+			ExecDropSingleTupleTableSlot(state->batches[i]->decompressed_slot);
+			ExecDropSingleTupleTableSlot(state->batches[i]->compressed_slot);
+			MemoryContextDelete(state->batches[i]->per_batch_context);
+		}
+	}
+	else
+		MemoryContextReset(state->batch->per_batch_context);
+
+	for (int i = 0; i < state->prefetch_batches; i++)
+		ExecDropSingleTupleTableSlot(state->prefetch_slots[i]);
+
+	if (state->toast_index != NULL)
+		index_close(state->toast_index, AccessShareLock);
+	if (state->toast_rel != NULL)
+		table_close(state->toast_rel, AccessShareLock);
+
+	ExecEndNode(linitial(node->custom_ps));
+}
+
+static void
+decompress_chunk_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	if (state->batch_sorted_merge)
+		ExplainPropertyBool("Batch Sorted Merge", true, es);
+
+	if (state->collect_stats)
+	{
+		DecompressChunkStats *stats = &state->stats;
+
+		ExplainPropertyInteger("Batches", NULL, stats->batches, es);
+		ExplainPropertyInteger("Batches Filtered", NULL, stats->batches_filtered, es);
+		ExplainPropertyInteger("Predicates Satisfied by Metadata",
+							   NULL,
+							   stats->predicates_skipped,
+							   es);
+		ExplainPropertyInteger("Cached Columns", NULL, stats->cached_columns, es);
+		ExplainPropertyInteger("Detoasted", "bytes", stats->detoasted_bytes, es);
+
+		for (int i = 1; i < _END_COMPRESSION_ALGORITHMS; i++)
+		{
+			const char *name = compression_algorithm_names[i];
+
+			if (stats->columns[i] == 0)
+				continue;
+
+			ExplainPropertyInteger(psprintf("Decompressed Columns (%s)", name),
+								   NULL,
+								   stats->columns[i],
+								   es);
+			if (state->collect_timing)
+				ExplainPropertyFloat(psprintf("Decompression Time (%s)", name),
+									 "ms",
+									 INSTR_TIME_GET_MILLISEC(stats->time[i]),
+									 3,
+									 es);
+		}
+	}
+}
+
+/*
+ * Whole batch access for the nodes that consume the decompressed columns
+ * directly, like VectorAgg. This is only possible when no quals have to be
+ * checked row by row, the batches are not reversed or merged and all the
+ * compressed columns are fixed-width, so that they can be returned as arrays.
+ */
+bool
+decompress_chunk_batch_mode_supported(PlanState *ps)
+{
+	DecompressChunkState *state = (DecompressChunkState *) ps;
+	ListCell *lc;
+
+	if (!IsA(ps, CustomScanState) ||
+		((CustomScanState *) ps)->methods != &decompress_chunk_state_methods)
+		return false;
+
+	if (ps->qual != NULL || state->reverse || state->batch_sorted_merge)
+		return false;
+
+	/* the IN predicates can't be evaluated for the batches that are not dictionary compressed */
+	foreach (lc, state->vector_predicates)
+	{
+		if (((VectorPredicate *) lfirst(lc))->type == VECTOR_PREDICATE_IN)
+			return false;
+	}
+
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+
+		if (column->type == COMPRESSED_COLUMN && (column->typlen <= 0 || column->typlen > 8))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * The uncompressed chunk of a DecompressChunk node, or InvalidOid if the node
+ * is something else.
+ */
+Oid
+decompress_chunk_get_chunk_relid(PlanState *ps)
+{
+	if (!IsA(ps, CustomScanState) ||
+		((CustomScanState *) ps)->methods != &decompress_chunk_state_methods)
+		return InvalidOid;
+
+	return ((DecompressChunkState *) ps)->chunk_relid;
+}
+
+/*
+ * Decompress the rest of the column with its iterator, for the algorithms that
+ * don't support bulk decompression.
+ */
+static DecompressedColumn *
+decompress_column_with_iterator(DecompressChunkColumnState *column,
+								DecompressBatchColumnState *column_values, int n_rows)
+{
+	DecompressedColumn *result = palloc0(sizeof(DecompressedColumn));
+	uint64 *validity = decompressed_column_validity_alloc(n_rows);
+	char *values = palloc0((Size) Max(n_rows, 1) * column->typlen);
+	DecompressionIterator *iterator = column_values->compressed.iterator;
+	int row = 0;
+
+	while (true)
+	{
+		DecompressResult next = iterator->try_next(iterator);
+
+		if (next.is_done)
+			break;
+
+		if (row >= n_rows)
+			elog(ERROR, "compressed column out of sync with batch counter");
+
+		if (next.is_null)
+			result->null_count++;
+		else
+		{
+			validity[row / 64] |= UINT64CONST(1) << (row % 64);
+
+			if (column->typbyval)
+				store_att_byval(values + (Size) row * column->typlen, next.val, column->typlen);
+			else
+				memcpy(values + (Size) row * column->typlen,
+					   DatumGetPointer(next.val),
+					   column->typlen);
+		}
+
+		row++;
+	}
+
+	if (row != n_rows)
+		elog(ERROR, "compressed column out of sync with batch counter");
+
+	result->length = n_rows;
+	result->value_bytes = column->typlen;
+	result->validity = validity;
+	result->values = values;
+	return result;
+}
+
+/*
+ * Fetch the next batch and decompress all its columns into arrays. Returns
+ * the number of rows in the batch, or -1 when there are no more batches. The
+ * filter, if not NULL, is the bitmap of rows that passed the vector quals.
+ */
+int
+decompress_chunk_next_batch(PlanState *ps, const uint64 **filter)
+{
+	DecompressChunkState *state = (DecompressChunkState *) ps;
+	DecompressBatchState *batch = state->batch;
+
+	while (true)
+	{
+		TupleTableSlot *subslot = decompress_chunk_next_compressed(state);
+		MemoryContext old_context;
+		int n_passed;
+
+		if (TupIsNull(subslot))
+			return -1;
+
+		initialize_batch(state, batch, subslot);
+
+		/* the batch was filtered out by the vector predicates */
+		if (!batch->initialized)
+			continue;
+
+		/* the batch is consumed as a whole */
+		batch->initialized = false;
+		batch->rows = batch->counter;
+
+		old_context = MemoryContextSwitchTo(batch->per_batch_context);
+		for (int i = 0; i < state->num_columns; i++)
+		{
+			DecompressChunkColumnState *column = &state->columns[i];
+			DecompressBatchColumnState *column_values = &batch->columns[i];
+
+			if (column->type == COMPRESSED_COLUMN && column_values->compressed.iterator != NULL)
+			{
+				instr_time start;
+
+				decompression_timer_start(state, &start);
+				column_values->compressed.bulk =
+					decompress_column_with_iterator(column, column_values, batch->rows);
+				column_values->compressed.iterator = NULL;
+				decompression_timer_stop(state,
+										 column_values->compressed.header->compression_algorithm,
+										 &start);
+			}
+		}
+
+		/* now all the columns of the vector quals are decompressed */
+		if (state->vector_predicates != NIL && batch->filter == NULL &&
+			!compute_batch_filter(state, batch))
+		{
+			MemoryContextSwitchTo(old_context);
+			InstrCountFiltered1(state, batch->rows);
+			if (state->collect_stats)
+				state->stats.batches_filtered++;
+			continue;
+		}
+		MemoryContextSwitchTo(old_context);
+
+		*filter = batch->filter;
+		if (batch->filter != NULL)
+		{
+			/* the consumers count the set bits, clear the ones past the end */
+			if (batch->rows % 64 != 0)
+				batch->filter[batch->rows / 64] &= (UINT64CONST(1) << (batch->rows % 64)) - 1;
+
+			n_passed = 0;
+			for (int i = 0; i < (batch->rows + 63) / 64; i++)
+				n_passed += pg_popcount64(batch->filter[i]);
+			InstrCountFiltered1(state, batch->rows - n_passed);
+		}
+
+		return batch->rows;
+	}
+}
+
+void
+decompress_chunk_batch_column(PlanState *ps, AttrNumber attno, DecompressChunkBatchColumn *result)
+{
+	DecompressChunkState *state = (DecompressChunkState *) ps;
+
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+		DecompressBatchColumnState *column_values = &state->batch->columns[i];
+
+		if (column->output_attno != attno)
+			continue;
+
+		result->values = NULL;
+		result->scalar_value = (Datum) 0;
+		result->scalar_isnull = true;
+
+		if (column->type == SEGMENTBY_COLUMN)
+		{
+			result->scalar_value = column_values->segmentby.value;
+			result->scalar_isnull = column_values->segmentby.isnull;
 		}
+		else if (column_values->compressed.bulk != NULL)
+			result->values = column_values->compressed.bulk;
+		else
+			result->scalar_value =
+				getmissingattr(state->csstate.ss.ss_ScanTupleSlot->tts_tupleDescriptor,
+							   attno,
+							   &result->scalar_isnull);
+		return;
+	}
+
+	elog(ERROR, "column %d is not decompressed", attno);
+}
+
+/*
+ * Create the next decompressed tuple of the batch according to column state.
+ * Returns NULL when the batch is exhausted.
+ */
+static TupleTableSlot *
+decompress_batch_next_tuple(DecompressChunkState *state, DecompressBatchState *batch)
+{
+	TupleTableSlot *slot = batch->decompressed_slot;
+	bool batch_done = false;
+	bool row_filtered;
+	int i;
+
+	while (true)
+	{
+		if (!batch->initialized)
+			return NULL;
 
 		ExecClearTuple(slot);
 
+		if (batch->filter != NULL && batch->next_row < batch->rows)
+		{
+			int row = state->reverse ? batch->rows - 1 - batch->next_row : batch->next_row;
+
+			row_filtered = (batch->filter[row / 64] & (UINT64CONST(1) << (row % 64))) == 0;
+		}
+		else
+			row_filtered = false;
+
 		for (i = 0; i < state->num_columns; i++)
 		{
 			DecompressChunkColumnState *column = &state->columns[i];
+			DecompressBatchColumnState *column_values = &batch->columns[i];
+
 			switch (column->type)
 			{
 				case COUNT_COLUMN:
-					if (state->counter <= 0)
+					if (batch->counter <= 0)
 						/*
 						 * we continue checking other columns even if counter
 						 * reaches zero to sanity check all columns are in sync
@@ -448,13 +2078,48 @@ decompress_chunk_create_tuple(DecompressChunkState *state)
 						 */
 						batch_done = true;
 					else
-						state->counter--;
+						batch->counter--;
 					break;
 				case COMPRESSED_COLUMN:
 				{
 					AttrNumber attr = AttrNumberGetAttrOffset(column->output_attno);
 
-					if (!column->compressed.iterator)
+					if (column_values->compressed.bulk)
+					{
+						const DecompressedColumn *bulk = column_values->compressed.bulk;
+						int row;
+
+						if (batch->next_row >= bulk->length)
+						{
+							batch_done = true;
+							continue;
+						}
+						else if (batch_done)
+							elog(ERROR, "compressed column out of sync with batch counter");
+
+						/* no need to fetch values of rows we are going to skip */
+						if (row_filtered)
+							continue;
+
+						row = state->reverse ? bulk->length - 1 - batch->next_row :
+											   batch->next_row;
+
+						if (decompressed_column_is_null(bulk, row))
+						{
+							slot->tts_values[attr] = (Datum) 0;
+							slot->tts_isnull[attr] = true;
+						}
+						else
+						{
+							const char *value_ptr =
+								(const char *) bulk->values + (Size) row * bulk->value_bytes;
+
+							slot->tts_values[attr] =
+								fetch_att(value_ptr, column->typbyval, column->typlen);
+							slot->tts_isnull[attr] = false;
+						}
+					}
+					else if (!column_values->compressed.iterator)
 					{
 						slot->tts_values[attr] = getmissingattr(slot->tts_tupleDescriptor,
 																attr + 1,
@@ -462,8 +2127,8 @@ decompress_chunk_create_tuple(DecompressChunkState *state)
 					}
 					else
 					{
-						DecompressResult result;
-						result = column->compressed.iterator->try_next(column->compressed.iterator);
+						DecompressionIterator *iterator = column_values->compressed.iterator;
+						DecompressResult result = iterator->try_next(iterator);
 
 						if (result.is_done)
 						{
@@ -490,8 +2155,8 @@ decompress_chunk_create_tuple(DecompressChunkState *state)
 				{
 					AttrNumber attr = AttrNumberGetAttrOffset(column->output_attno);
 
-					slot->tts_values[attr] = column->segmentby.value;
-					slot->tts_isnull[attr] = column->segmentby.isnull;
+					slot->tts_values[attr] = column_values->segmentby.value;
+					slot->tts_isnull[attr] = column_values->segmentby.isnull;
 					break;
 				}
 				case SEQUENCE_NUM_COLUMN:
@@ -505,7 +2170,15 @@ decompress_chunk_create_tuple(DecompressChunkState *state)
 
 		if (batch_done)
 		{
-			state->initialized = false;
+			batch->initialized = false;
+			return NULL;
+		}
+
+		batch->next_row++;
+
+		if (row_filtered)
+		{
+			InstrCountFiltered1(state, 1);
 			continue;
 		}
 
@@ -8,10 +8,32 @@
 #define TIMESCALEDB_DECOMPRESS_CHUNK_EXEC_H
 
 #include <postgres.h>
+#include <nodes/execnodes.h>
+
+#include "compression/compression.h"
 
 #define DECOMPRESS_CHUNK_COUNT_ID -9
 #define DECOMPRESS_CHUNK_SEQUENCE_NUM_ID -10
 
+/*
+ * A column of a decompressed batch, as returned to the nodes that consume
+ * whole batches (see decompress_chunk_next_batch). The values are either
+ * decompressed into arrays, or, for segmentby columns and columns missing from
+ * the compressed data, a single value is the same for all rows of the batch.
+ */
+typedef struct DecompressChunkBatchColumn
+{
+	const DecompressedColumn *values;
+	Datum scalar_value;
+	bool scalar_isnull;
+} DecompressChunkBatchColumn;
+
 extern Node *decompress_chunk_state_create(CustomScan *cscan);
 
+extern bool decompress_chunk_batch_mode_supported(PlanState *ps);
+extern Oid decompress_chunk_get_chunk_relid(PlanState *ps);
+extern int decompress_chunk_next_batch(PlanState *ps, const uint64 **filter);
+extern void decompress_chunk_batch_column(PlanState *ps, AttrNumber attno,
+										  DecompressChunkBatchColumn *result);
+
 #endif /* TIMESCALEDB_DECOMPRESS_CHUNK_EXEC_H */
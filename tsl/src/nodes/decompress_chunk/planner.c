@@ -8,6 +8,7 @@
 #include <access/sysattr.h>
 #include <catalog/pg_namespace.h>
 #include <catalog/pg_operator.h>
+#include <catalog/pg_type.h>
 #include <nodes/bitmapset.h>
 #include <nodes/extensible.h>
 #include <nodes/makefuncs.h>
@@ -19,8 +20,10 @@
 #include <optimizer/tlist.h>
 #include <parser/parsetree.h>
 #include <utils/builtins.h>
+#include <utils/lsyscache.h>
 #include <utils/typcache.h>
 
+#include "compat/compat.h"
 #include "compression/compression.h"
 #include "compression/create.h"
 #include "nodes/decompress_chunk/decompress_chunk.h"
@@ -333,6 +336,74 @@ clause_has_compressed_attrs(Node *node, void *context)
 	return expression_tree_walker(node, clause_has_compressed_attrs, context);
 }
 
+/*
+ * Find the position of the metadata column that bounds the first sort column
+ * of the batch sorted merge in the compressed scan targetlist. The compressed
+ * scan is sorted by it, so the var is the one of the first compressed pathkey.
+ */
+static AttrNumber
+find_merge_bound_attno(DecompressChunkPath *path, List *scan_tlist)
+{
+	PathKey *pk = linitial(path->compressed_pathkeys);
+	Expr *expr = find_em_expr_for_rel(pk->pk_eclass, path->info->compressed_rel);
+	ListCell *lc;
+
+	if (expr == NULL || !IsA(expr, Var))
+		elog(ERROR, "invalid pathkey for the batch sorted merge");
+
+	foreach (lc, scan_tlist)
+	{
+		TargetEntry *target = lfirst_node(TargetEntry, lc);
+
+		if (IsA(target->expr, Var) &&
+			castNode(Var, target->expr)->varattno == castNode(Var, expr)->varattno)
+			return target->resno;
+	}
+
+	elog(ERROR, "the batch metadata column was not found in the compressed scan targetlist");
+	pg_unreachable();
+}
+
+/*
+ * The sort settings of the batch sorted merge for the executor, in the same
+ * form as the ones of the MergeAppend node: the attribute numbers of the sort
+ * columns in the decompressed tuple, the sort operators, the collations and
+ * the nulls first flags.
+ */
+static List *
+build_batch_sorted_merge_info(DecompressChunkPath *path)
+{
+	List *sort_col_idx = NIL;
+	List *sort_operators = NIL;
+	List *collations = NIL;
+	List *nulls_first = NIL;
+	ListCell *lc;
+
+	foreach (lc, path->cpath.path.pathkeys)
+	{
+		PathKey *pk = lfirst(lc);
+		Var *var = (Var *) find_em_expr_for_rel(pk->pk_eclass, path->info->chunk_rel);
+		Oid sortop;
+
+		/* this should not happen because we validated the pathkeys when creating the path */
+		if (var == NULL || !IsA(var, Var))
+			elog(ERROR, "invalid pathkey for the batch sorted merge");
+
+		sortop = get_opfamily_member(pk->pk_opfamily, var->vartype, var->vartype, pk->pk_strategy);
+		if (!OidIsValid(sortop) && type_is_enum(var->vartype))
+			sortop = get_opfamily_member(pk->pk_opfamily, ANYENUMOID, ANYENUMOID, pk->pk_strategy);
+		if (!OidIsValid(sortop))
+			elog(ERROR, "could not find the sort operator for the batch sorted merge");
+
+		sort_col_idx = lappend_int(sort_col_idx, var->varattno);
+		sort_operators = lappend_oid(sort_operators, sortop);
+		collations = lappend_oid(collations, pk->pk_eclass->ec_collation);
+		nulls_first = lappend_int(nulls_first, pk->pk_nulls_first);
+	}
+
+	return list_make4(sort_col_idx, sort_operators, collations, nulls_first);
+}
+
 Plan *
 decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path,
 							 List *decompressed_tlist, List *clauses, List *custom_plans)
@@ -413,13 +484,15 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 	 * DecompressChunk can choose only the needed columns itself.
 	 * Note that Postgres uses the CP_EXACT_TLIST option when planning the child
 	 * paths of the Custom path, so we won't automatically get a phsyical tlist
-	 * here.
+	 * here. A SkipScan over the compressed scan returns the tuples of its
+	 * index scan unchanged, so it has to keep the targetlist it was planned
+	 * with.
 	 */
 	if (compressed_path->pathtype == T_IndexOnlyScan)
 	{
 		compressed_scan->plan.targetlist = ((IndexPath *) compressed_path)->indexinfo->indextlist;
 	}
-	else
+	else if (compressed_path->pathtype != T_CustomScan)
 	{
 		List *physical_tlist = build_physical_tlist(root, dcpath->info->compressed_rel);
 		/* Can be null if the relation has dropped columns. */
@@ -446,6 +519,18 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 				   dcpath->info->chunk_rel->relid,
 				   &chunk_attrs_needed);
 
+	/* the batch sorted merge compares the values of the sort columns */
+	if (dcpath->batch_sorted_merge)
+	{
+		foreach (lc, dcpath->cpath.path.pathkeys)
+		{
+			PathKey *pk = lfirst(lc);
+			Expr *expr = find_em_expr_for_rel(pk->pk_eclass, dcpath->info->chunk_rel);
+
+			pull_varattnos((Node *) expr, dcpath->info->chunk_rel->relid, &chunk_attrs_needed);
+		}
+	}
+
 	/*
 	 * Determine which compressed colum goes to which output column.
 	 */
@@ -469,10 +554,20 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 
 	Assert(list_length(custom_plans) == 1);
 
-	settings = list_make3_int(dcpath->info->hypertable_id,
+	settings = list_make4_int(dcpath->info->hypertable_id,
 							  dcpath->info->chunk_rte->relid,
-							  dcpath->reverse);
+							  dcpath->reverse,
+							  ts_guc_enable_bulk_decompression);
+	settings = lappend_int(settings, dcpath->batch_sorted_merge);
+	settings = lappend_int(settings,
+						   dcpath->batch_sorted_merge ?
+							   find_merge_bound_attno(dcpath, compressed_scan->plan.targetlist) :
+							   InvalidAttrNumber);
 	decompress_plan->custom_private = list_make2(settings, dcpath->decompression_map);
 
+	if (dcpath->batch_sorted_merge)
+		decompress_plan->custom_private =
+			lappend(decompress_plan->custom_private, build_batch_sorted_merge_info(dcpath));
+
 	return &decompress_plan->scan.plan;
 }
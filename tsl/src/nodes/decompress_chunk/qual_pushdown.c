@@ -4,6 +4,7 @@
  */
 
 #include <postgres.h>
+#include <catalog/pg_operator.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
 #include <optimizer/optimizer.h>
@@ -14,7 +15,9 @@
 #include <utils/typcache.h>
 
 #include "decompress_chunk.h"
+#include "extension_constants.h"
 #include "qual_pushdown.h"
+#include "utils.h"
 #include "ts_catalog/hypertable_compression.h"
 #include "compression/create.h"
 #include "custom_type_cache.h"
@@ -133,8 +136,9 @@ get_segment_meta_min_attr_number(FormData_hypertable_compression *compression_in
 {
 	char *meta_col_name = compression_column_segment_min_name(compression_info);
 
+	/* the name of a compress_minmax column can be too long for the metadata */
 	if (meta_col_name == NULL)
-		elog(ERROR, "could not find meta column");
+		return InvalidAttrNumber;
 
 	return get_attnum(compressed_relid, meta_col_name);
 }
@@ -151,6 +155,23 @@ get_segment_meta_max_attr_number(FormData_hypertable_compression *compression_in
 	return get_attnum(compressed_relid, meta_col_name);
 }
 
+static AttrNumber
+get_segment_meta_nulls_attr_number(FormData_hypertable_compression *compression_info,
+								   Oid compressed_relid)
+{
+	char *meta_col_name;
+
+	/* Only the compress_minmax columns have the null count */
+	if (compression_info->orderby_column_index > 0)
+		return InvalidAttrNumber;
+
+	meta_col_name = compression_column_segment_nulls_name(compression_info);
+	if (meta_col_name == NULL)
+		return InvalidAttrNumber;
+
+	return get_attnum(compressed_relid, meta_col_name);
+}
+
 static Expr *
 get_pushdownsafe_expr(const QualPushdownContext *input_context, Expr *input)
 {
@@ -178,8 +199,16 @@ get_compression_info_for_column_with_segment_meta(QualPushdownContext *context,
 	v = (Var *) expr;
 
 	compression_info = get_compression_info_from_var(context, v);
-	/* Only order by vars have segment meta */
-	if (compression_info == NULL || compression_info->orderby_column_index <= 0)
+	if (compression_info == NULL || compression_info->segmentby_column_index > 0)
+		return NULL;
+
+	/*
+	 * The order by vars always have segment meta, the others only if they
+	 * were listed in the compress_minmax option.
+	 */
+	if (compression_info->orderby_column_index <= 0 &&
+		get_segment_meta_min_attr_number(compression_info, context->compressed_rte->relid) ==
+			InvalidAttrNumber)
 		return NULL;
 
 	return compression_info;
@@ -330,6 +359,157 @@ pushdown_op_to_segment_meta_min_max(QualPushdownContext *context, List *expr_arg
 	}
 }
 
+/*
+ * "var = expr" implies that the bloom filter of the batch contains expr. The
+ * filter is built with the hash function of the default hash opclass of the
+ * column type, so we can check only the equality operators of its opfamily.
+ */
+static Expr *
+pushdown_op_to_segment_meta_bloom1(QualPushdownContext *context, List *expr_args, Oid op_oid,
+								   Oid op_collation)
+{
+	Expr *leftop, *rightop, *expr;
+	Var *var;
+	FormData_hypertable_compression *compression_info;
+	TypeCacheEntry *tce;
+	char *bloom_col_name;
+	AttrNumber bloom_attno;
+	Oid funcid;
+	Oid argtypes[] = { BYTEAOID, ANYELEMENTOID };
+
+	if (list_length(expr_args) != 2)
+		return NULL;
+
+	leftop = linitial(expr_args);
+	rightop = lsecond(expr_args);
+
+	if (IsA(leftop, RelabelType))
+		leftop = ((RelabelType *) leftop)->arg;
+	if (IsA(rightop, RelabelType))
+		rightop = ((RelabelType *) rightop)->arg;
+
+	if (IsA(leftop, Var) && (compression_info = get_compression_info_from_var(context,
+																			  (Var *) leftop)))
+	{
+		var = (Var *) leftop;
+		expr = rightop;
+	}
+	else if (IsA(rightop, Var) &&
+			 (compression_info = get_compression_info_from_var(context, (Var *) rightop)))
+	{
+		var = (Var *) rightop;
+		expr = leftop;
+	}
+	else
+		return NULL;
+
+	if (compression_info->segmentby_column_index > 0)
+		return NULL;
+
+	bloom_col_name = compression_column_segment_bloom1_name(compression_info);
+	if (bloom_col_name == NULL)
+		return NULL;
+
+	bloom_attno = get_attnum(context->compressed_rte->relid, bloom_col_name);
+	if (bloom_attno == InvalidAttrNumber)
+		return NULL;
+
+	if (!OidIsValid(op_oid) || !op_strict(op_oid) || var->varcollid != op_collation)
+		return NULL;
+
+	tce = lookup_type_cache(var->vartype, TYPECACHE_HASH_OPFAMILY);
+	if (!OidIsValid(tce->hash_opf) ||
+		get_op_opfamily_strategy(op_oid, tce->hash_opf) != HTEqualStrategyNumber)
+		return NULL;
+
+	/* the value is hashed with the hash function of its own type */
+	if (lookup_type_cache(exprType((Node *) expr), TYPECACHE_HASH_OPFAMILY)->hash_opf !=
+		tce->hash_opf)
+		return NULL;
+
+	expr = get_pushdownsafe_expr(context, expr);
+	if (expr == NULL)
+		return NULL;
+
+	funcid = ts_get_function_oid("bloom1_contains",
+								 INTERNAL_SCHEMA_NAME,
+								 lengthof(argtypes),
+								 argtypes);
+
+	return (Expr *) makeFuncExpr(funcid,
+								 BOOLOID,
+								 list_make2(makeVar(context->compressed_rel->relid,
+													bloom_attno,
+													BYTEAOID,
+													-1,
+													InvalidOid,
+													0),
+											copyObject(expr)),
+								 InvalidOid,
+								 var->varcollid,
+								 COERCE_EXPLICIT_CALL);
+}
+
+/*
+ * "var IS NOT NULL" implies that the min is not null, and "var IS NULL"
+ * implies that the null count is not zero. Only the compress_minmax columns
+ * have the null count, so we handle only them here.
+ */
+static Expr *
+pushdown_nulltest_to_segment_meta(QualPushdownContext *context, NullTest *test)
+{
+	FormData_hypertable_compression *compression_info;
+	Expr *arg = test->arg;
+	AttrNumber attno;
+	Var *meta_var;
+
+	if (test->argisrow)
+		return NULL;
+
+	if (IsA(arg, RelabelType))
+		arg = ((RelabelType *) arg)->arg;
+
+	compression_info = get_compression_info_for_column_with_segment_meta(context, arg);
+	if (compression_info == NULL || compression_info->orderby_column_index > 0)
+		return NULL;
+
+	if (test->nulltesttype == IS_NOT_NULL)
+	{
+		NullTest *meta_test = makeNode(NullTest);
+
+		attno = get_segment_meta_min_attr_number(compression_info, context->compressed_rte->relid);
+		meta_test->arg = (Expr *) makeVar(context->compressed_rel->relid,
+										  attno,
+										  ((Var *) arg)->vartype,
+										  -1,
+										  InvalidOid,
+										  0);
+		meta_test->nulltesttype = IS_NOT_NULL;
+		meta_test->argisrow = false;
+		meta_test->location = -1;
+		return (Expr *) meta_test;
+	}
+
+	attno = get_segment_meta_nulls_attr_number(compression_info, context->compressed_rte->relid);
+	if (attno == InvalidAttrNumber)
+		return NULL;
+
+	meta_var = makeVar(context->compressed_rel->relid, attno, INT4OID, -1, InvalidOid, 0);
+	return make_opclause(get_commutator(Int4LessOperator),
+						 BOOLOID,
+						 false,
+						 (Expr *) meta_var,
+						 (Expr *) makeConst(INT4OID,
+											-1,
+											InvalidOid,
+											sizeof(int32),
+											Int32GetDatum(0),
+											false,
+											true),
+						 InvalidOid,
+						 InvalidOid);
+}
+
 static Node *
 modify_expression(Node *node, QualPushdownContext *context)
 {
@@ -347,6 +527,15 @@ modify_expression(Node *node, QualPushdownContext *context)
 															   opexpr->args,
 															   opexpr->opno,
 															   opexpr->inputcollid);
+				Expr *bloom = pushdown_op_to_segment_meta_bloom1(context,
+																 opexpr->args,
+																 opexpr->opno,
+																 opexpr->inputcollid);
+				if (pd != NULL && bloom != NULL)
+					pd = make_andclause(list_make2(pd, bloom));
+				else if (bloom != NULL)
+					pd = bloom;
+
 				if (pd != NULL)
 				{
 					context->needs_recheck = true;
@@ -357,11 +546,22 @@ modify_expression(Node *node, QualPushdownContext *context)
 			/* opexpr will still be checked for segment by columns */
 			break;
 		}
+		case T_NullTest:
+		{
+			Expr *pd = pushdown_nulltest_to_segment_meta(context, castNode(NullTest, node));
+			if (pd != NULL)
+			{
+				context->needs_recheck = true;
+				/* pd is on the compressed table so do not mutate further */
+				return (Node *) pd;
+			}
+			/* the test will still be checked for segment by columns */
+			break;
+		}
 		case T_RelabelType:
 		case T_ScalarArrayOpExpr:
 		case T_List:
 		case T_Const:
-		case T_NullTest:
 		case T_Param:
 			break;
 		case T_Var:
@@ -0,0 +1,445 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Evaluation of simple quals over bulk decompressed columns. Instead of
+ * building a tuple for every row and running ExecQual on it, the predicate is
+ * applied to the whole array of values of a batch in a tight loop that the
+ * compiler can vectorize, and the result is stored in a selection bitmap. Rows
+ * that don't pass are then never materialized.
+ */
+
+#include <postgres.h>
+#include <catalog/pg_type.h>
+#include <nodes/nodeFuncs.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/date.h>
+#include <utils/float.h>
+#include <utils/lsyscache.h>
+#include <utils/timestamp.h>
+#include <utils/typcache.h>
+
+#include "nodes/decompress_chunk/vector_predicates.h"
+
+static bool
+vector_predicate_type_supported(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static Var *
+vector_predicate_get_var(Node *node, Index scanrelid)
+{
+	Var *var;
+
+	if (!IsA(node, Var))
+		return NULL;
+
+	var = castNode(Var, node);
+	if ((Index) var->varno != scanrelid || var->varlevelsup != 0 || var->varattno <= 0)
+		return NULL;
+
+	return var;
+}
+
+/*
+ * Equality with one of the constants, for the types that are not bulk
+ * decompressed. The predicate is evaluated once per distinct value of
+ * dictionary compressed batches, see vector_predicate_compute_dictionary().
+ */
+static VectorPredicate *
+vector_predicate_make_in(Var *var, Oid opno, Oid collation, Datum *constvalues, int n_constvalues)
+{
+	TypeCacheEntry *tce = lookup_type_cache(var->vartype, TYPECACHE_EQ_OPR);
+	VectorPredicate *predicate;
+
+	if (!OidIsValid(opno) || opno != tce->eq_opr)
+		return NULL;
+
+	predicate = palloc0(sizeof(VectorPredicate));
+	predicate->type = VECTOR_PREDICATE_IN;
+	predicate->output_attno = var->varattno;
+	predicate->typid = var->vartype;
+	predicate->eq_func = palloc0(sizeof(FmgrInfo));
+	fmgr_info(get_opcode(opno), predicate->eq_func);
+	predicate->collation = collation;
+	predicate->n_constvalues = n_constvalues;
+	predicate->constvalues = constvalues;
+	return predicate;
+}
+
+/*
+ * Check whether the qual can be evaluated as a vector predicate and build it
+ * if so. Returns NULL for quals that have to go through ExecQual.
+ */
+VectorPredicate *
+vector_predicate_make(Expr *qual, Index scanrelid)
+{
+	VectorPredicate *predicate;
+
+	if (IsA(qual, NullTest))
+	{
+		NullTest *test = castNode(NullTest, qual);
+		Var *var;
+
+		if (test->argisrow)
+			return NULL;
+
+		var = vector_predicate_get_var((Node *) test->arg, scanrelid);
+		if (var == NULL || !vector_predicate_type_supported(var->vartype))
+			return NULL;
+
+		predicate = palloc0(sizeof(VectorPredicate));
+		predicate->type =
+			test->nulltesttype == IS_NULL ? VECTOR_PREDICATE_IS_NULL : VECTOR_PREDICATE_IS_NOT_NULL;
+		predicate->output_attno = var->varattno;
+		predicate->typid = var->vartype;
+		return predicate;
+	}
+
+	if (IsA(qual, OpExpr))
+	{
+		OpExpr *opexpr = castNode(OpExpr, qual);
+		Oid opno = opexpr->opno;
+		Var *var;
+		Const *constant;
+		TypeCacheEntry *tce;
+		int strategy;
+		bool negate = false;
+
+		if (list_length(opexpr->args) != 2)
+			return NULL;
+
+		if (IsA(lsecond(opexpr->args), Const))
+		{
+			var = vector_predicate_get_var(linitial(opexpr->args), scanrelid);
+			constant = lsecond_node(Const, opexpr->args);
+		}
+		else if (IsA(linitial(opexpr->args), Const))
+		{
+			/* const op var, use the commutator to get the column on the left side */
+			var = vector_predicate_get_var(lsecond(opexpr->args), scanrelid);
+			constant = linitial_node(Const, opexpr->args);
+			opno = get_commutator(opno);
+		}
+		else
+			return NULL;
+
+		if (var == NULL || !OidIsValid(opno) || constant->constisnull ||
+			constant->consttype != var->vartype)
+			return NULL;
+
+		if (!vector_predicate_type_supported(var->vartype))
+		{
+			Datum *constvalues = palloc(sizeof(Datum));
+
+			constvalues[0] = constant->constvalue;
+			return vector_predicate_make_in(var, opno, opexpr->inputcollid, constvalues, 1);
+		}
+
+		tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+		if (!OidIsValid(tce->btree_opf))
+			return NULL;
+
+		strategy = get_op_opfamily_strategy(opno, tce->btree_opf);
+		if (strategy == InvalidStrategy)
+		{
+			Oid negator = get_negator(opno);
+
+			if (!OidIsValid(negator) ||
+				get_op_opfamily_strategy(negator, tce->btree_opf) != BTEqualStrategyNumber)
+				return NULL;
+
+			strategy = BTEqualStrategyNumber;
+			negate = true;
+		}
+
+		predicate = palloc0(sizeof(VectorPredicate));
+		predicate->type = VECTOR_PREDICATE_COMPARE;
+		predicate->output_attno = var->varattno;
+		predicate->typid = var->vartype;
+		predicate->strategy = strategy;
+		predicate->negate = negate;
+		predicate->constvalue = constant->constvalue;
+		return predicate;
+	}
+
+	if (IsA(qual, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = castNode(ScalarArrayOpExpr, qual);
+		Var *var;
+		Const *constant;
+		ArrayType *array;
+		int16 typlen;
+		bool typbyval;
+		char typalign;
+		Datum *elements;
+		bool *nulls;
+		int n_elements;
+		int n_constvalues = 0;
+
+		/* only "column = ANY(constant array)", that is IN lists */
+		if (!saop->useOr || list_length(saop->args) != 2 || !IsA(lsecond(saop->args), Const))
+			return NULL;
+
+		var = vector_predicate_get_var(linitial(saop->args), scanrelid);
+		constant = lsecond_node(Const, saop->args);
+		if (var == NULL || constant->constisnull || vector_predicate_type_supported(var->vartype))
+			return NULL;
+
+		array = DatumGetArrayTypeP(constant->constvalue);
+		if (ARR_ELEMTYPE(array) != var->vartype)
+			return NULL;
+
+		get_typlenbyvalalign(var->vartype, &typlen, &typbyval, &typalign);
+		deconstruct_array(array,
+						  var->vartype,
+						  typlen,
+						  typbyval,
+						  typalign,
+						  &elements,
+						  &nulls,
+						  &n_elements);
+
+		/* the null elements never compare equal */
+		for (int i = 0; i < n_elements; i++)
+		{
+			if (!nulls[i])
+				elements[n_constvalues++] = elements[i];
+		}
+
+		return vector_predicate_make_in(var,
+										saop->opno,
+										saop->inputcollid,
+										elements,
+										n_constvalues);
+	}
+
+	return NULL;
+}
+
+#define INT_LT(a, b) ((a) < (b))
+#define INT_LE(a, b) ((a) <= (b))
+#define INT_EQ(a, b) ((a) == (b))
+#define INT_GE(a, b) ((a) >= (b))
+#define INT_GT(a, b) ((a) > (b))
+
+/*
+ * Compare every value of the batch with the constant and AND the result into
+ * the filter, one 64-row bitmap word at a time.
+ */
+#define VECTOR_COMPARE(CTYPE, CONST, PRED)                                                         \
+	do                                                                                             \
+	{                                                                                              \
+		const CTYPE *restrict values = (const CTYPE *) column->values;                             \
+		const CTYPE constvalue = (CONST);                                                          \
+		for (int word = 0; word < n_words; word++)                                                 \
+		{                                                                                          \
+			const int start = word * 64;                                                           \
+			const int end = Min(start + 64, n_rows);                                               \
+			uint64 word_result = 0;                                                                \
+			for (int row = start; row < end; row++)                                                \
+				word_result |= ((uint64) PRED(values[row], constvalue)) << (row - start);          \
+			if (predicate->negate)                                                                 \
+				word_result = ~word_result;                                                        \
+			filter[word] &= word_result;                                                           \
+		}                                                                                          \
+	} while (0)
+
+#define VECTOR_COMPARE_STRATEGY(CTYPE, CONST, LT, LE, EQ, GE, GT)                                  \
+	do                                                                                             \
+	{                                                                                              \
+		switch (predicate->strategy)                                                               \
+		{                                                                                          \
+			case BTLessStrategyNumber:                                                             \
+				VECTOR_COMPARE(CTYPE, CONST, LT);                                                  \
+				break;                                                                             \
+			case BTLessEqualStrategyNumber:                                                        \
+				VECTOR_COMPARE(CTYPE, CONST, LE);                                                  \
+				break;                                                                             \
+			case BTEqualStrategyNumber:                                                            \
+				VECTOR_COMPARE(CTYPE, CONST, EQ);                                                  \
+				break;                                                                             \
+			case BTGreaterEqualStrategyNumber:                                                     \
+				VECTOR_COMPARE(CTYPE, CONST, GE);                                                  \
+				break;                                                                             \
+			case BTGreaterStrategyNumber:                                                          \
+				VECTOR_COMPARE(CTYPE, CONST, GT);                                                  \
+				break;                                                                             \
+			default:                                                                               \
+				elog(ERROR, "invalid strategy %d for vector predicate", predicate->strategy);      \
+		}                                                                                          \
+	} while (0)
+
+void
+vector_predicate_compute(const VectorPredicate *predicate, const DecompressedColumn *column,
+						 uint64 *restrict filter)
+{
+	const int n_rows = column->length;
+	const int n_words = (n_rows + 63) / 64;
+
+	switch (predicate->type)
+	{
+		case VECTOR_PREDICATE_IS_NULL:
+			for (int word = 0; word < n_words; word++)
+				filter[word] &= column->validity != NULL ? ~column->validity[word] : 0;
+			return;
+		case VECTOR_PREDICATE_IS_NOT_NULL:
+			if (column->validity != NULL)
+			{
+				for (int word = 0; word < n_words; word++)
+					filter[word] &= column->validity[word];
+			}
+			return;
+		case VECTOR_PREDICATE_COMPARE:
+			break;
+		case VECTOR_PREDICATE_IN:
+			elog(ERROR, "vector predicate on a dictionary column used with a bulk column");
+	}
+
+	switch (predicate->typid)
+	{
+		case INT2OID:
+			VECTOR_COMPARE_STRATEGY(int16,
+									DatumGetInt16(predicate->constvalue),
+									INT_LT,
+									INT_LE,
+									INT_EQ,
+									INT_GE,
+									INT_GT);
+			break;
+		case INT4OID:
+		case DATEOID:
+			VECTOR_COMPARE_STRATEGY(int32,
+									DatumGetInt32(predicate->constvalue),
+									INT_LT,
+									INT_LE,
+									INT_EQ,
+									INT_GE,
+									INT_GT);
+			break;
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			VECTOR_COMPARE_STRATEGY(int64,
+									DatumGetInt64(predicate->constvalue),
+									INT_LT,
+									INT_LE,
+									INT_EQ,
+									INT_GE,
+									INT_GT);
+			break;
+		case FLOAT4OID:
+			/* the float comparison functions follow the PostgreSQL NaN semantics */
+			VECTOR_COMPARE_STRATEGY(float4,
+									DatumGetFloat4(predicate->constvalue),
+									float4_lt,
+									float4_le,
+									float4_eq,
+									float4_ge,
+									float4_gt);
+			break;
+		case FLOAT8OID:
+			VECTOR_COMPARE_STRATEGY(float8,
+									DatumGetFloat8(predicate->constvalue),
+									float8_lt,
+									float8_le,
+									float8_eq,
+									float8_ge,
+									float8_gt);
+			break;
+		default:
+			elog(ERROR,
+				 "unsupported type for vector predicate \"%s\"",
+				 format_type_be(predicate->typid));
+	}
+
+	/* comparisons with null values are never true */
+	if (column->validity != NULL)
+	{
+		for (int word = 0; word < n_words; word++)
+			filter[word] &= column->validity[word];
+	}
+}
+
+/*
+ * Evaluate the IN predicate over a dictionary compressed column. The constants
+ * are compared with every distinct value of the batch once, and then the rows
+ * are matched by their dictionary indexes. When no distinct value matches, the
+ * whole batch is filtered out without decompressing the indexes.
+ */
+void
+vector_predicate_compute_dictionary(const VectorPredicate *predicate,
+									const DictionaryCompressed *compressed, int n_rows,
+									uint64 *restrict filter)
+{
+	uint32 n_items;
+	Datum *items = dictionary_decompress_items(compressed, &n_items);
+	bool *item_matches = palloc(sizeof(bool) * Max(n_items, 1));
+	bool have_matches = false;
+
+	Assert(predicate->type == VECTOR_PREDICATE_IN);
+
+	for (uint32 i = 0; i < n_items; i++)
+	{
+		item_matches[i] = false;
+		for (int j = 0; j < predicate->n_constvalues; j++)
+		{
+			if (DatumGetBool(FunctionCall2Coll(predicate->eq_func,
+											   predicate->collation,
+											   items[i],
+											   predicate->constvalues[j])))
+			{
+				item_matches[i] = true;
+				have_matches = true;
+				break;
+			}
+		}
+	}
+
+	if (!have_matches)
+	{
+		memset(filter, 0, sizeof(uint64) * ((n_rows + 63) / 64));
+		return;
+	}
+
+	dictionary_filter_rows(compressed, item_matches, filter, n_rows);
+}
+
+/*
+ * Check whether no row of the batch passes the filter.
+ */
+bool
+vector_predicate_filter_is_empty(const uint64 *filter, int n_rows)
+{
+	const int n_full_words = n_rows / 64;
+	const int n_tail_rows = n_rows % 64;
+
+	for (int word = 0; word < n_full_words; word++)
+	{
+		if (filter[word] != 0)
+			return false;
+	}
+
+	if (n_tail_rows > 0 && (filter[n_full_words] & ((UINT64CONST(1) << n_tail_rows) - 1)) != 0)
+		return false;
+
+	return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_DECOMPRESS_CHUNK_VECTOR_PREDICATES_H
+#define TIMESCALEDB_DECOMPRESS_CHUNK_VECTOR_PREDICATES_H
+
+#include <postgres.h>
+#include <access/stratnum.h>
+#include <fmgr.h>
+#include <nodes/primnodes.h>
+
+#include "compression/compression.h"
+#include "compression/dictionary.h"
+
+/*
+ * Predicates of the form "column op constant" and "column IS [NOT] NULL" that
+ * can be evaluated over a whole bulk decompressed column at once, updating a
+ * selection bitmap with one bit per row of the batch.
+ *
+ * The equality and IN quals on the types without bulk decompression, like
+ * text, are evaluated over the dictionary of dictionary compressed batches
+ * instead, see vector_predicate_compute_dictionary().
+ */
+typedef enum VectorPredicateType
+{
+	VECTOR_PREDICATE_COMPARE,
+	VECTOR_PREDICATE_IS_NULL,
+	VECTOR_PREDICATE_IS_NOT_NULL,
+	VECTOR_PREDICATE_IN,
+} VectorPredicateType;
+
+typedef struct VectorPredicate
+{
+	VectorPredicateType type;
+	/* Attno of the column in the output of DecompressChunk */
+	AttrNumber output_attno;
+	Oid typid;
+	/* btree strategy of the comparison, with the column on the left side */
+	StrategyNumber strategy;
+	/* true for "<>", which is evaluated as negated equality */
+	bool negate;
+	Datum constvalue;
+	/* For VECTOR_PREDICATE_IN, the equality function and the non-null constants */
+	FmgrInfo *eq_func;
+	Oid collation;
+	int n_constvalues;
+	Datum *constvalues;
+} VectorPredicate;
+
+extern VectorPredicate *vector_predicate_make(Expr *qual, Index scanrelid);
+extern void vector_predicate_compute(const VectorPredicate *predicate,
+									 const DecompressedColumn *column, uint64 *restrict filter);
+extern void vector_predicate_compute_dictionary(const VectorPredicate *predicate,
+												const DictionaryCompressed *compressed, int n_rows,
+												uint64 *restrict filter);
+extern bool vector_predicate_filter_is_empty(const uint64 *filter, int n_rows);
+
+#endif /* TIMESCALEDB_DECOMPRESS_CHUNK_VECTOR_PREDICATES_H */
@@ -23,7 +23,8 @@ void gapfill_adjust_window_targetlist(PlannerInfo *root, RelOptInfo *input_rel,
 typedef struct GapFillPath
 {
 	CustomPath cpath;
-	FuncExpr *func; /* time_bucket_gapfill function call */
+	FuncExpr *func;   /* time_bucket_gapfill function call */
+	bool hash_groups; /* input is sorted only by time, see gapfill_hash_exec */
 } GapFillPath;
 
 #endif /* TIMESCALEDB_TSL_NODES_GAPFILL_H */
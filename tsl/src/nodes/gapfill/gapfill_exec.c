@@ -29,6 +29,11 @@
 
 #include <annotations.h>
 #include <compat/compat.h>
+#if PG13_GE
+#include <common/hashfn.h>
+#else
+#include <utils/hashutils.h>
+#endif
 #include "gapfill.h"
 #include "gapfill_internal.h"
 #include "locf.h"
@@ -41,6 +46,13 @@ typedef enum GapFillBoundary
 	GAPFILL_END,
 } GapFillBoundary;
 
+/* entry of the hash table of groups, the groups with the same hash value */
+typedef struct GapFillHashEntry
+{
+	uint32 hash;
+	List *groups;
+} GapFillHashEntry;
+
 typedef union GapFillColumnStateUnion
 {
 	GapFillColumnState *base;
@@ -70,6 +82,8 @@ static void gapfill_state_initialize_columns(GapFillState *state);
 static GapFillColumnState *gapfill_column_state_create(GapFillColumnType ctype, Oid typeid);
 static bool gapfill_is_group_column(GapFillState *state, TargetEntry *tle);
 static Node *gapfill_aggref_mutator(Node *node, void *context);
+static void gapfill_hash_initialize(GapFillState *state);
+static TupleTableSlot *gapfill_hash_exec(GapFillState *state);
 
 static CustomExecMethods gapfill_state_methods = {
 	.BeginCustomScan = gapfill_begin,
@@ -228,6 +242,7 @@ gapfill_state_create(CustomScan *cscan)
 	state->subplan = linitial(cscan->custom_plans);
 	state->args = lfourth(cscan->custom_private);
 	state->have_timezone = list_length(state->args) == 5;
+	state->hash_groups = intVal(list_nth(cscan->custom_private, 4));
 
 	return (Node *) state;
 }
@@ -770,6 +785,9 @@ gapfill_begin(CustomScanState *node, EState *estate, int eflags)
 
 	gapfill_state_initialize_columns(state);
 
+	if (state->hash_groups)
+		gapfill_hash_initialize(state);
+
 	/*
 	 * Build ProjectionInfo that will be used for gap filled tuples only.
 	 *
@@ -809,6 +827,9 @@ gapfill_exec(CustomScanState *node)
 	GapFillState *state = (GapFillState *) node;
 	TupleTableSlot *slot = NULL;
 
+	if (state->hash_groups)
+		return gapfill_hash_exec(state);
+
 	while (true)
 	{
 		CHECK_FOR_INTERRUPTS();
@@ -886,9 +907,27 @@ gapfill_exec(CustomScanState *node)
 	}
 }
 
+static void
+gapfill_hash_reset(GapFillState *state)
+{
+	if (state->hash_input != NULL)
+		tuplestore_end(state->hash_input);
+
+	state->hash_input = NULL;
+	state->hash_table = NULL;
+	state->hash_input_loaded = false;
+	state->hash_ngroups = 0;
+	MemoryContextReset(state->hash_context);
+}
+
 static void
 gapfill_end(CustomScanState *node)
 {
+	GapFillState *state = (GapFillState *) node;
+
+	if (state->hash_groups)
+		gapfill_hash_reset(state);
+
 	if (node->custom_ps != NIL)
 	{
 		ExecEndNode(linitial(node->custom_ps));
@@ -898,11 +937,21 @@ gapfill_end(CustomScanState *node)
 static void
 gapfill_rescan(CustomScanState *node)
 {
+	GapFillState *state = (GapFillState *) node;
+	ListCell *lc;
+
 	if (node->custom_ps != NIL)
 	{
 		ExecReScan(linitial(node->custom_ps));
 	}
-	((GapFillState *) node)->state = FETCHED_NONE;
+	state->state = FETCHED_NONE;
+
+	/* the lookups might depend on parameters of the rescan */
+	foreach (lc, state->lookups)
+		((GapFillLookup *) lfirst(lc))->valid = false;
+
+	if (state->hash_groups)
+		gapfill_hash_reset(state);
 }
 
 static void
@@ -1381,3 +1430,466 @@ gapfill_adjust_varnos(GapFillState *state, Expr *expr)
 	}
 	return expr;
 }
+
+/*
+ * Prepare the out of bounds lookup expression of a locf or interpolate
+ * column. The expression state is built once here instead of for every
+ * evaluation, so the subplans of the lookup are initialized only once.
+ */
+GapFillLookup *
+gapfill_lookup_create(GapFillState *state, Expr *expr)
+{
+	GapFillLookup *lookup = palloc0(sizeof(GapFillLookup));
+	TupleDesc tupledesc = state->csstate.ss.ps.ps_ResultTupleSlot->tts_tupleDescriptor;
+	List *vars;
+	ListCell *lc;
+
+	expr = gapfill_adjust_varnos(state, expr);
+	vars = pull_var_clause((Node *) expr, 0);
+
+	lookup->exprstate = ExecInitExpr(expr, &state->csstate.ss.ps);
+	lookup->cacheable = !contain_volatile_functions((Node *) expr);
+	lookup->attnos = palloc(sizeof(AttrNumber) * Max(list_length(vars), 1));
+	foreach (lc, vars)
+	{
+		Var *var = lfirst(lc);
+
+		if (var->varattno <= 0 || var->varattno > tupledesc->natts)
+			lookup->cacheable = false;
+		else
+			lookup->attnos[lookup->nattnos++] = var->varattno;
+	}
+	lookup->key_values = palloc(sizeof(Datum) * Max(lookup->nattnos, 1));
+	lookup->key_isnull = palloc(sizeof(bool) * Max(lookup->nattnos, 1));
+	get_typlenbyval(exprType((Node *) expr), &lookup->typlen, &lookup->typbyval);
+
+	state->lookups = lappend(state->lookups, lookup);
+
+	return lookup;
+}
+
+/*
+ * Check if the referenced columns of the gap tuple have the same values as
+ * for the cached result
+ */
+static bool
+gapfill_lookup_key_matches(GapFillState *state, GapFillLookup *lookup)
+{
+	TupleDesc tupledesc = state->scanslot->tts_tupleDescriptor;
+	int i;
+
+	for (i = 0; i < lookup->nattnos; i++)
+	{
+		Form_pg_attribute attr =
+			TupleDescAttr(tupledesc, AttrNumberGetAttrOffset(lookup->attnos[i]));
+		bool isnull;
+		Datum value = slot_getattr(state->scanslot, lookup->attnos[i], &isnull);
+
+		if (isnull != lookup->key_isnull[i])
+			return false;
+		if (!isnull &&
+			!datumIsEqual(value, lookup->key_values[i], attr->attbyval, attr->attlen))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Evaluate the lookup expression for the gap tuple in scanslot, reusing the
+ * result of the previous evaluation when the referenced columns are the same.
+ */
+Datum
+gapfill_lookup_exec(GapFillState *state, GapFillLookup *lookup, bool *isnull)
+{
+	ExprContext *exprcontext = GetPerTupleExprContext(state->csstate.ss.ps.state);
+	TupleDesc tupledesc = state->scanslot->tts_tupleDescriptor;
+	MemoryContext oldcontext;
+	Datum value;
+	int i;
+
+	if (lookup->valid && gapfill_lookup_key_matches(state, lookup))
+	{
+		*isnull = lookup->isnull;
+		return lookup->value;
+	}
+
+	exprcontext->ecxt_scantuple = state->scanslot;
+	value = ExecEvalExprSwitchContext(lookup->exprstate, exprcontext, isnull);
+
+	if (!lookup->cacheable)
+		return value;
+
+	oldcontext = MemoryContextSwitchTo(state->csstate.ss.ps.state->es_query_cxt);
+	for (i = 0; i < lookup->nattnos; i++)
+	{
+		Form_pg_attribute attr =
+			TupleDescAttr(tupledesc, AttrNumberGetAttrOffset(lookup->attnos[i]));
+		Datum key = slot_getattr(state->scanslot, lookup->attnos[i], &lookup->key_isnull[i]);
+
+		if (!lookup->key_isnull[i])
+			lookup->key_values[i] = datumCopy(key, attr->attbyval, attr->attlen);
+	}
+	lookup->isnull = *isnull;
+	if (!*isnull)
+		lookup->value = datumCopy(value, lookup->typbyval, lookup->typlen);
+	lookup->valid = true;
+	MemoryContextSwitchTo(oldcontext);
+
+	*isnull = lookup->isnull;
+	return lookup->isnull ? (Datum) 0 : lookup->value;
+}
+
+/*
+ * Hash grouped mode
+ *
+ * The sorted mode needs the subplan output sorted by the group columns and
+ * time, which requires sorting the whole aggregation output when there are
+ * many groups. In the hash grouped mode the subplan output only needs to be
+ * sorted by time. The tuples are read into a tuplestore first to collect the
+ * set of groups, then the tuplestore is replayed and every bucket gets the
+ * subplan tuples of the bucket followed by the gap tuples of the groups that
+ * had no tuple in the bucket.
+ *
+ * The column state that the sorted mode keeps for the current group (group
+ * column values and last locf value) is kept in flat arrays for all groups,
+ * and loaded into the column states before a tuple of the group is returned.
+ */
+static void
+gapfill_hash_initialize(GapFillState *state)
+{
+	GapFillColumnStateUnion column;
+	TupleDesc tupledesc = state->csstate.ss.ps.ps_ResultTupleSlot->tts_tupleDescriptor;
+	int i;
+
+	foreach_column(column.base, i, state)
+	{
+		if (column.base->ctype == INTERPOLATE_COLUMN)
+			elog(ERROR, "interpolate is not supported in the hash grouped gapfill");
+
+		if (column.base->ctype == GROUP_COLUMN)
+		{
+			TypeCacheEntry *tce =
+				lookup_type_cache(column.base->typid, TYPECACHE_HASH_PROC_FINFO);
+
+			if (!OidIsValid(tce->hash_proc))
+				elog(ERROR,
+					 "could not identify a hash function for type %s",
+					 format_type_be(column.base->typid));
+
+			fmgr_info_copy(&column.group->hash_func, &tce->hash_proc_finfo, CurrentMemoryContext);
+		}
+	}
+
+	state->hash_context =
+		AllocSetContextCreate(CurrentMemoryContext, "gapfill groups", ALLOCSET_DEFAULT_SIZES);
+	state->hash_slot = MakeSingleTupleTableSlot(tupledesc, &TTSOpsMinimalTuple);
+}
+
+static bool
+gapfill_hash_group_matches(GapFillState *state, int group, TupleTableSlot *slot)
+{
+	GapFillColumnStateUnion column;
+	int i;
+
+	foreach_column(column.base, i, state)
+	{
+		int offset = group * state->ncolumns + i;
+		Datum value;
+		bool isnull;
+
+		if (column.base->ctype != GROUP_COLUMN)
+			continue;
+
+		value = slot_getattr(slot, AttrOffsetGetAttrNumber(i), &isnull);
+		if (isnull && state->hash_isnull[offset])
+			continue;
+		if (isnull != state->hash_isnull[offset])
+			return false;
+		if (!DatumGetBool(DirectFunctionCall2Coll(column.group->eq_func.fn_addr,
+												  column.group->collation,
+												  value,
+												  state->hash_values[offset])))
+			return false;
+	}
+
+	return true;
+}
+
+static int
+gapfill_hash_add_group(GapFillState *state, TupleTableSlot *slot)
+{
+	GapFillColumnStateUnion column;
+	MemoryContext oldcontext;
+	int group;
+	int i;
+
+	if (state->hash_ngroups == state->hash_groups_allocated)
+	{
+		state->hash_groups_allocated *= 2;
+		state->hash_values =
+			repalloc(state->hash_values,
+					 sizeof(Datum) * state->hash_groups_allocated * state->ncolumns);
+		state->hash_isnull =
+			repalloc(state->hash_isnull,
+					 sizeof(bool) * state->hash_groups_allocated * state->ncolumns);
+		state->hash_filled =
+			repalloc(state->hash_filled, sizeof(int64) * state->hash_groups_allocated);
+	}
+
+	group = state->hash_ngroups++;
+	state->hash_filled[group] = PG_INT64_MIN;
+
+	oldcontext = MemoryContextSwitchTo(state->hash_context);
+	foreach_column(column.base, i, state)
+	{
+		int offset = group * state->ncolumns + i;
+
+		state->hash_values[offset] = (Datum) 0;
+		state->hash_isnull[offset] = true;
+
+		if (column.base->ctype == GROUP_COLUMN || column.base->ctype == DERIVED_COLUMN)
+		{
+			bool isnull;
+			Datum value = slot_getattr(slot, AttrOffsetGetAttrNumber(i), &isnull);
+
+			state->hash_isnull[offset] = isnull;
+			if (!isnull)
+				state->hash_values[offset] =
+					datumCopy(value, column.base->typbyval, column.base->typlen);
+		}
+	}
+	MemoryContextSwitchTo(oldcontext);
+
+	return group;
+}
+
+/*
+ * Find the group of the tuple, the group is added when it is not known yet
+ * and create is true.
+ */
+static int
+gapfill_hash_lookup_group(GapFillState *state, TupleTableSlot *slot, bool create)
+{
+	GapFillColumnStateUnion column;
+	GapFillHashEntry *entry;
+	MemoryContext oldcontext;
+	ListCell *lc;
+	uint32 hash = 0;
+	bool found;
+	int group;
+	int i;
+
+	foreach_column(column.base, i, state)
+	{
+		Datum value;
+		bool isnull;
+
+		if (column.base->ctype != GROUP_COLUMN)
+			continue;
+
+		value = slot_getattr(slot, AttrOffsetGetAttrNumber(i), &isnull);
+		hash = hash_combine(hash,
+							isnull ? 0 :
+									 DatumGetUInt32(FunctionCall1Coll(&column.group->hash_func,
+																	  column.group->collation,
+																	  value)));
+	}
+
+	entry = hash_search(state->hash_table, &hash, create ? HASH_ENTER : HASH_FIND, &found);
+	if (found)
+	{
+		foreach (lc, entry->groups)
+		{
+			if (gapfill_hash_group_matches(state, lfirst_int(lc), slot))
+				return lfirst_int(lc);
+		}
+	}
+	else if (create)
+		entry->groups = NIL;
+
+	if (!create)
+		elog(ERROR, "gapfill group not found");
+
+	group = gapfill_hash_add_group(state, slot);
+
+	oldcontext = MemoryContextSwitchTo(state->hash_context);
+	entry->groups = lappend_int(entry->groups, group);
+	MemoryContextSwitchTo(oldcontext);
+
+	return group;
+}
+
+/*
+ * Read the subplan output into the tuplestore and collect the groups
+ */
+static void
+gapfill_hash_load_input(GapFillState *state)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->hash_context);
+	TupleTableSlot *slot;
+	HASHCTL ctl;
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(uint32);
+	ctl.entrysize = sizeof(GapFillHashEntry);
+	ctl.hcxt = state->hash_context;
+	state->hash_table =
+		hash_create("gapfill groups", 256, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	state->hash_groups_allocated = 64;
+	state->hash_values = palloc(sizeof(Datum) * state->hash_groups_allocated * state->ncolumns);
+	state->hash_isnull = palloc(sizeof(bool) * state->hash_groups_allocated * state->ncolumns);
+	state->hash_filled = palloc(sizeof(int64) * state->hash_groups_allocated);
+	state->hash_input = tuplestore_begin_heap(false, false, work_mem);
+	MemoryContextSwitchTo(oldcontext);
+
+	while ((slot = gapfill_fetch_next_tuple(state)) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+		gapfill_hash_lookup_group(state, slot, true);
+		tuplestore_puttupleslot(state->hash_input, slot);
+	}
+
+	state->hash_input_loaded = true;
+	state->hash_next_group = 0;
+	state->next_timestamp = state->gapfill_start;
+	state->state = FETCHED_NONE;
+}
+
+/*
+ * Make the group the current group of the column states
+ */
+static void
+gapfill_hash_load_group(GapFillState *state, int group)
+{
+	GapFillColumnStateUnion column;
+	int i;
+
+	foreach_column(column.base, i, state)
+	{
+		int offset = group * state->ncolumns + i;
+
+		switch (column.base->ctype)
+		{
+			case GROUP_COLUMN:
+			case DERIVED_COLUMN:
+				column.group->value = state->hash_values[offset];
+				column.group->isnull = state->hash_isnull[offset];
+				break;
+			case LOCF_COLUMN:
+				column.locf->value = state->hash_values[offset];
+				column.locf->isnull = state->hash_isnull[offset];
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+/*
+ * Save the locf state of the current group
+ */
+static void
+gapfill_hash_save_group(GapFillState *state, int group)
+{
+	GapFillColumnStateUnion column;
+	int i;
+
+	foreach_column(column.base, i, state)
+	{
+		int offset = group * state->ncolumns + i;
+
+		if (column.base->ctype == LOCF_COLUMN)
+		{
+			state->hash_values[offset] = column.locf->value;
+			state->hash_isnull[offset] = column.locf->isnull;
+		}
+	}
+}
+
+/*
+ * Main loop of the hash grouped mode. The subplan tuples up to the current
+ * bucket are returned first, then a gap tuple for every group without a
+ * tuple in the current bucket.
+ */
+static TupleTableSlot *
+gapfill_hash_exec(GapFillState *state)
+{
+	TupleTableSlot *slot;
+
+	if (!state->hash_input_loaded)
+		gapfill_hash_load_input(state);
+
+	/* nothing to fill without any group */
+	if (state->hash_ngroups == 0)
+		return NULL;
+
+	while (true)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (FETCHED_NONE == state->state)
+		{
+			if (tuplestore_gettupleslot(state->hash_input, true, false, state->hash_slot))
+			{
+				Datum time_value;
+				bool isnull;
+
+				ExecCopySlot(state->subslot, state->hash_slot);
+				time_value = slot_getattr(state->subslot,
+										  AttrOffsetGetAttrNumber(state->time_index),
+										  &isnull);
+				Assert(!isnull);
+				state->subslot_time = gapfill_datum_get_internal(time_value, state->gapfill_typid);
+				state->hash_subslot_group =
+					gapfill_hash_lookup_group(state, state->subslot, false);
+				state->state = FETCHED_ONE;
+			}
+			else
+				state->state = FETCHED_LAST;
+		}
+
+		/*
+		 * return the subplan tuples before gapfill_start, of the current
+		 * bucket and after gapfill_end
+		 */
+		if (FETCHED_ONE == state->state && (state->subslot_time <= state->next_timestamp ||
+											state->next_timestamp >= state->gapfill_end))
+		{
+			int group = state->hash_subslot_group;
+
+			state->state = FETCHED_NONE;
+			if (state->subslot_time == state->next_timestamp)
+				state->hash_filled[group] = state->next_timestamp;
+
+			gapfill_hash_load_group(state, group);
+			slot = gapfill_state_return_subplan_slot(state);
+			gapfill_hash_save_group(state, group);
+			return slot;
+		}
+
+		/* fill the gaps of the current bucket */
+		if (state->next_timestamp < state->gapfill_end)
+		{
+			while (state->hash_next_group < state->hash_ngroups)
+			{
+				int group = state->hash_next_group++;
+
+				if (state->hash_filled[group] == state->next_timestamp)
+					continue;
+
+				gapfill_hash_load_group(state, group);
+				slot = gapfill_state_gaptuple_create(state, state->next_timestamp);
+				gapfill_hash_save_group(state, group);
+				return slot;
+			}
+
+			gapfill_advance_timestamp(state);
+			state->hash_next_group = 0;
+			continue;
+		}
+
+		return NULL;
+	}
+}
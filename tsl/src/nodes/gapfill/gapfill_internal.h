@@ -8,6 +8,8 @@
 
 #include <postgres.h>
 #include <nodes/execnodes.h>
+#include <utils/hsearch.h>
+#include <utils/tuplestore.h>
 
 /*
  * GapFillFetchState describes the state of subslot in GapFillState:
@@ -85,8 +87,30 @@ typedef struct GapFillGroupColumnState
 	bool isnull;
 	Oid collation;
 	FmgrInfo eq_func;
+	FmgrInfo hash_func; /* only used in the hash grouped mode */
 } GapFillGroupColumnState;
 
+/*
+ * Out of bounds lookup expression of locf or interpolate. The expression is
+ * evaluated when the first gap tuple of a group has no value, and its result
+ * only depends on the columns of the gap tuple it references, so the result
+ * is reused for the following groups as long as these columns don't change.
+ */
+typedef struct GapFillLookup
+{
+	ExprState *exprstate;
+	int nattnos;
+	AttrNumber *attnos; /* columns of the gap tuple referenced by the expression */
+	bool cacheable;		/* no volatile functions and no unresolved column references */
+	bool valid;
+	Datum *key_values;
+	bool *key_isnull;
+	int16 typlen;
+	bool typbyval;
+	Datum value;
+	bool isnull;
+} GapFillLookup;
+
 typedef struct GapFillState
 {
 	CustomScanState csstate;
@@ -118,11 +142,35 @@ typedef struct GapFillState
 	ProjectionInfo *pi;
 	TupleTableSlot *scanslot;
 	GapFillFetchState state;
+	List *lookups; /* GapFillLookup of the locf and interpolate columns */
+
+	/*
+	 * Hash grouped mode: the subplan output is only sorted by time. It is
+	 * read into hash_input first to collect the groups, and then the gaps of
+	 * all groups are filled bucket by bucket. The column state of the groups
+	 * is kept in flat arrays with ncolumns entries per group and swapped into
+	 * the column states when a tuple of the group is returned.
+	 */
+	bool hash_groups;
+	bool hash_input_loaded;
+	MemoryContext hash_context;
+	Tuplestorestate *hash_input;
+	TupleTableSlot *hash_slot; /* slot to read hash_input */
+	HTAB *hash_table;
+	int hash_ngroups;
+	int hash_groups_allocated;
+	Datum *hash_values;
+	bool *hash_isnull;
+	int64 *hash_filled;		/* last bucket with a subplan tuple per group */
+	int hash_subslot_group; /* group of the tuple in subslot */
+	int hash_next_group;	/* next group to check for a gap in the current bucket */
 } GapFillState;
 
 Node *gapfill_state_create(CustomScan *);
 Expr *gapfill_adjust_varnos(GapFillState *state, Expr *expr);
 Datum gapfill_exec_expr(GapFillState *state, Expr *expr, bool *isnull);
+GapFillLookup *gapfill_lookup_create(GapFillState *state, Expr *expr);
+Datum gapfill_lookup_exec(GapFillState *state, GapFillLookup *lookup, bool *isnull);
 int64 gapfill_datum_get_internal(Datum, Oid);
 
 #endif /* TIMESCALEDB_TSL_NODES_GAPFILL_INTERNAL_H */
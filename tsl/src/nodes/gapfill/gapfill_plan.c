@@ -17,6 +17,7 @@
 #include <parser/parse_func.h>
 
 #include "compat/compat.h"
+#include "guc.h"
 
 #include "gapfill.h"
 #include "gapfill_internal.h"
@@ -108,6 +109,27 @@ marker_function_walker(Node *node, gapfill_walker_context *context)
 	return expression_tree_walker((Node *) node, marker_function_walker, context);
 }
 
+/*
+ * Find interpolate function calls
+ */
+static bool
+interpolate_function_walker(Node *node, gapfill_walker_context *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, FuncExpr) &&
+		strncmp(get_func_name(castNode(FuncExpr, node)->funcid),
+				GAPFILL_INTERPOLATE_FUNCTION,
+				NAMEDATALEN) == 0)
+	{
+		context->call.node = node;
+		context->count++;
+	}
+
+	return expression_tree_walker((Node *) node, interpolate_function_walker, context);
+}
+
 /*
  * Find window function calls
  */
@@ -189,6 +211,7 @@ gapfill_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path, List *
 
 	cscan->custom_private =
 		list_make4(gfpath->func, root->parse->groupClause, root->parse->jointree, args);
+	cscan->custom_private = lappend(cscan->custom_private, makeInteger(gfpath->hash_groups));
 
 	return &cscan->scan.plan;
 }
@@ -322,15 +345,72 @@ gapfill_build_pathtarget(PathTarget *pt_upper, PathTarget *pt_path, PathTarget *
 	}
 }
 
+/*
+ * Find the time_bucket_gapfill pathkey in the group pathkeys, always in
+ * ascending order.
+ */
+static PathKey *
+gapfill_time_pathkey(PlannerInfo *root, FuncExpr *func)
+{
+	ListCell *lc;
+
+	foreach (lc, root->group_pathkeys)
+	{
+		PathKey *pk = lfirst(lc);
+		EquivalenceMember *em = linitial(pk->pk_eclass->ec_members);
+
+		if (IsA(em->em_expr, FuncExpr) && ((FuncExpr *) em->em_expr)->funcid == func->funcid)
+		{
+			if (BTLessStrategyNumber == pk->pk_strategy)
+				return pk;
+
+			return make_canonical_pathkey(root,
+										  pk->pk_eclass,
+										  pk->pk_opfamily,
+										  BTLessStrategyNumber,
+										  pk->pk_nulls_first);
+		}
+	}
+
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("no top level time_bucket_gapfill in group by clause")));
+	pg_unreachable();
+}
+
+/*
+ * Check if the gaps can be filled for all groups at once, bucket by bucket,
+ * from input that is only sorted by time. Interpolation needs the next value
+ * of the group, which is only at hand when the group is read in one go, and
+ * the window functions above the gapfill node expect the rows of a group to
+ * be together, so these queries keep the sorted input.
+ */
+static bool
+gapfill_use_hash_groups(PlannerInfo *root)
+{
+	Query *parse = root->parse;
+	gapfill_walker_context context;
+
+	if (!ts_guc_enable_gapfill_hash_groups || list_length(parse->groupClause) < 2 ||
+		parse->hasWindowFuncs || !grouping_is_hashable(parse->groupClause))
+		return false;
+
+	gapfill_expression_walker((Expr *) parse->targetList, interpolate_function_walker, &context);
+
+	return context.count == 0;
+}
+
 /*
  * Create a Gapfill Path node.
  *
  * The gap fill node needs rows to be sorted by time ASC
  * so we insert sort pathes if the query order does not match
- * that
+ * that. In the hash grouped mode the rows only need to be
+ * sorted by time, otherwise they are sorted by the group
+ * columns and time.
  */
 static Path *
-gapfill_path_create(PlannerInfo *root, Path *subpath, FuncExpr *func)
+gapfill_path_create(PlannerInfo *root, Path *subpath, FuncExpr *func, bool hash_groups)
 {
 	GapFillPath *path;
 
@@ -355,48 +435,51 @@ gapfill_path_create(PlannerInfo *root, Path *subpath, FuncExpr *func)
 							 path->cpath.path.pathtarget,
 							 subpath->pathtarget);
 
-	if (!gapfill_correct_order(root, subpath, func))
+	if (hash_groups)
 	{
-		List *new_order = NIL;
-		ListCell *lc;
-		PathKey *pk_func = NULL;
+		PathKey *pk_func = gapfill_time_pathkey(root, func);
+
+		if (subpath->pathkeys == NIL || linitial(subpath->pathkeys) != pk_func)
+			subpath = (Path *) create_sort_path(root,
+												subpath->parent,
+												subpath,
+												list_make1(pk_func),
+												root->limit_tuples);
 
-		/* subpath does not have correct order */
-		foreach (lc, root->group_pathkeys)
+		/* the gap tuples are only ordered by time */
+		path->cpath.path.pathkeys = list_make1(pk_func);
+	}
+	else
+	{
+		if (!gapfill_correct_order(root, subpath, func))
 		{
-			PathKey *pk = lfirst(lc);
-			EquivalenceMember *em = linitial(pk->pk_eclass->ec_members);
+			List *new_order = NIL;
+			ListCell *lc;
+			PathKey *pk_func = gapfill_time_pathkey(root, func);
 
-			if (!pk_func && IsA(em->em_expr, FuncExpr) &&
-				((FuncExpr *) em->em_expr)->funcid == func->funcid)
+			/* subpath does not have correct order */
+			foreach (lc, root->group_pathkeys)
 			{
-				if (BTLessStrategyNumber == pk->pk_strategy)
-					pk_func = pk;
-				else
-					pk_func = make_canonical_pathkey(root,
-													 pk->pk_eclass,
-													 pk->pk_opfamily,
-													 BTLessStrategyNumber,
-													 pk->pk_nulls_first);
+				PathKey *pk = lfirst(lc);
+				EquivalenceMember *em = linitial(pk->pk_eclass->ec_members);
+
+				if (!(IsA(em->em_expr, FuncExpr) &&
+					  ((FuncExpr *) em->em_expr)->funcid == func->funcid))
+					new_order = lappend(new_order, pk);
 			}
-			else
-				new_order = lappend(new_order, pk);
-		}
-		if (!pk_func)
-			ereport(ERROR,
-					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-					 errmsg("no top level time_bucket_gapfill in group by clause")));
 
-		new_order = lappend(new_order, pk_func);
-		subpath = (Path *)
-			create_sort_path(root, subpath->parent, subpath, new_order, root->limit_tuples);
+			new_order = lappend(new_order, pk_func);
+			subpath = (Path *)
+				create_sort_path(root, subpath->parent, subpath, new_order, root->limit_tuples);
+		}
+		path->cpath.path.pathkeys = subpath->pathkeys;
 	}
 
 	path->cpath.path.startup_cost = subpath->startup_cost;
 	path->cpath.path.total_cost = subpath->total_cost;
-	path->cpath.path.pathkeys = subpath->pathkeys;
 	path->cpath.custom_paths = list_make1(subpath);
 	path->func = func;
+	path->hash_groups = hash_groups;
 
 	return &path->cpath.path;
 }
@@ -447,9 +530,12 @@ plan_add_gapfill(PlannerInfo *root, RelOptInfo *group_rel)
 		list_free(group_rel->cheapest_parameterized_paths);
 		group_rel->cheapest_parameterized_paths = NULL;
 
+		bool hash_groups = gapfill_use_hash_groups(root);
+
 		foreach (lc, copy)
 		{
-			add_path(group_rel, gapfill_path_create(root, lfirst(lc), context.call.func));
+			add_path(group_rel,
+					 gapfill_path_create(root, lfirst(lc), context.call.func, hash_groups));
 		}
 		list_free(copy);
 	}
@@ -29,10 +29,10 @@ gapfill_interpolate_initialize(GapFillInterpolateColumnState *interpolate, GapFi
 	interpolate->next.isnull = true;
 	if (list_length(((FuncExpr *) function)->args) > 1)
 		interpolate->lookup_before =
-			gapfill_adjust_varnos(state, lsecond(((FuncExpr *) function)->args));
+			gapfill_lookup_create(state, lsecond(((FuncExpr *) function)->args));
 	if (list_length(((FuncExpr *) function)->args) > 2)
 		interpolate->lookup_after =
-			gapfill_adjust_varnos(state, lthird(((FuncExpr *) function)->args));
+			gapfill_lookup_create(state, lthird(((FuncExpr *) function)->args));
 }
 
 /*
@@ -87,14 +87,14 @@ gapfill_interpolate_tuple_returned(GapFillInterpolateColumnState *column, int64
  */
 static void
 gapfill_fetch_sample(GapFillState *state, GapFillInterpolateColumnState *column,
-					 GapFillInterpolateSample *sample, Expr *lookup)
+					 GapFillInterpolateSample *sample, GapFillLookup *lookup)
 {
 	HeapTupleHeader th;
 	HeapTupleData tuple;
 	TupleDesc tupdesc;
 	Datum value;
 	bool isnull;
-	Datum datum = gapfill_exec_expr(state, lookup, &isnull);
+	Datum datum = gapfill_lookup_exec(state, lookup, &isnull);
 
 	if (isnull)
 	{
@@ -18,8 +18,8 @@ typedef struct GapFillInterpolateSample
 typedef struct GapFillInterpolateColumnState
 {
 	GapFillColumnState base;
-	Expr *lookup_before;
-	Expr *lookup_after;
+	GapFillLookup *lookup_before;
+	GapFillLookup *lookup_after;
 	GapFillInterpolateSample prev;
 	GapFillInterpolateSample next;
 } GapFillInterpolateColumnState;
@@ -21,7 +21,7 @@ gapfill_locf_initialize(GapFillLocfColumnState *locf, GapFillState *state, FuncE
 
 	/* check if out of boundary lookup expression was supplied */
 	if (list_length(function->args) > 1)
-		locf->lookup_last = gapfill_adjust_varnos(state, lsecond(function->args));
+		locf->lookup_last = gapfill_lookup_create(state, lsecond(function->args));
 
 	/* check if treat_null_as_missing was supplied */
 	if (list_length(function->args) > 2)
@@ -66,7 +66,7 @@ gapfill_locf_calculate(GapFillLocfColumnState *locf, GapFillState *state, int64
 {
 	/* only evaluate expr for first tuple */
 	if (locf->isnull && locf->lookup_last && time == state->gapfill_start)
-		locf->value = gapfill_exec_expr(state, locf->lookup_last, &locf->isnull);
+		locf->value = gapfill_lookup_exec(state, locf->lookup_last, &locf->isnull);
 
 	*value = locf->value;
 	*isnull = locf->isnull;
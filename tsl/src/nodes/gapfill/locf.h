@@ -14,7 +14,7 @@
 typedef struct GapFillLocfColumnState
 {
 	GapFillColumnState base;
-	Expr *lookup_last;
+	GapFillLookup *lookup_last;
 	Datum value;
 	bool isnull;
 	bool treat_null_as_missing;
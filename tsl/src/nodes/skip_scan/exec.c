@@ -38,13 +38,25 @@
  *                    |   DONE    |
  *                    \===========/
  *
+ * With more than one DISTINCT column the flowchart above is followed for the
+ * first of the columns in the index. Every time a tuple is found, the scan
+ * first looks for the next tuple with the same values in the preceding
+ * columns and a value after the previous one in the last column, like
+ *     WHERE col1 = [prev col1] AND col2 > [prev col2]
+ * and when there is none, moves on to the column before it, until it is back
+ * at the first column and continues with the flowchart. The columns after
+ * the one we skip on are unconstrained, which is why all of them but the first
+ * have to be NOT NULL.
  */
 
 #include <postgres.h>
 #include <access/genam.h>
+#include <access/stratnum.h>
 #include <nodes/extensible.h>
 #include <nodes/pg_list.h>
 #include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
 
 #include "guc.h"
 #include "nodes/skip_scan/skip_scan.h"
@@ -59,6 +71,24 @@ typedef enum SkipScanStage
 	SS_END,
 } SkipScanStage;
 
+typedef struct SkipScanColumn
+{
+	/* Pointer into the ScanKeys of the Index(Only)Scan */
+	ScanKey skip_key;
+	/* The skip key as planned, and an equality key for the same column */
+	ScanKeyData skip_template;
+	ScanKeyData eq_template;
+
+	Datum prev_datum;
+	bool prev_is_null;
+
+	/* Info about the type we are performing DISTINCT on */
+	bool distinct_by_val;
+	int distinct_col_attnum;
+	int distinct_typ_len;
+	int sk_attno;
+} SkipScanColumn;
+
 typedef struct SkipScanState
 {
 	CustomScanState cscan_state;
@@ -71,16 +101,15 @@ typedef struct SkipScanState
 	/* Pointers into the Index(Only)Scan */
 	int *num_scan_keys;
 	ScanKey *scan_keys;
-	ScanKey skip_key;
 
-	Datum prev_datum;
-	bool prev_is_null;
-
-	/* Info about the type we are performing DISTINCT on */
-	bool distinct_by_val;
-	int distinct_col_attnum;
-	int distinct_typ_len;
-	int sk_attno;
+	/* The DISTINCT columns in the order of the index */
+	int num_columns;
+	SkipScanColumn *columns;
+	/*
+	 * The column we are skipping on, the columns before it have the values of
+	 * the previous tuple
+	 */
+	int skip_column;
 
 	SkipScanStage stage;
 
@@ -100,6 +129,7 @@ static void
 skip_scan_begin(CustomScanState *node, EState *estate, int eflags)
 {
 	SkipScanState *state = (SkipScanState *) node;
+	Relation index_rel;
 	state->ctx = AllocSetContextCreate(estate->es_query_cxt, "skipscan", ALLOCSET_DEFAULT_SIZES);
 
 	state->idx = (ScanState *) ExecInitNode(state->idx_scan, estate, eflags);
@@ -111,6 +141,7 @@ skip_scan_begin(CustomScanState *node, EState *estate, int eflags)
 		state->scan_keys = &idx->iss_ScanKeys;
 		state->num_scan_keys = &idx->iss_NumScanKeys;
 		state->scan_desc = &idx->iss_ScanDesc;
+		index_rel = idx->iss_RelationDesc;
 	}
 	else if (IsA(state->idx_scan, IndexOnlyScan))
 	{
@@ -118,6 +149,7 @@ skip_scan_begin(CustomScanState *node, EState *estate, int eflags)
 		state->scan_keys = &idx->ioss_ScanKeys;
 		state->num_scan_keys = &idx->ioss_NumScanKeys;
 		state->scan_desc = &idx->ioss_ScanDesc;
+		index_rel = idx->ioss_RelationDesc;
 	}
 	else
 		elog(ERROR, "unknown subscan type in SkipScan");
@@ -126,20 +158,49 @@ skip_scan_begin(CustomScanState *node, EState *estate, int eflags)
 	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
 		return;
 
-	/* find position of our skip key
+	/* find position of our skip keys
 	 * skip key is put as first key for the respective column in sort_indexquals
 	 */
 	ScanKey data = *state->scan_keys;
-	for (int i = 0; i < *state->num_scan_keys; i++)
+	for (int col = 0; col < state->num_columns; col++)
 	{
-		if (data[i].sk_flags == SK_ISNULL && data[i].sk_attno == state->sk_attno)
+		SkipScanColumn *column = &state->columns[col];
+
+		for (int i = 0; i < *state->num_scan_keys; i++)
 		{
-			state->skip_key = &data[i];
-			break;
+			if (data[i].sk_flags == SK_ISNULL && data[i].sk_attno == column->sk_attno)
+			{
+				column->skip_key = &data[i];
+				break;
+			}
+		}
+		if (!column->skip_key)
+			elog(ERROR, "ScanKey for skip qual not found");
+
+		column->skip_template = *column->skip_key;
+
+		/* the columns before the one we skip on are compared for equality */
+		if (state->num_columns > 1)
+		{
+			ScanKey key = column->skip_key;
+			Oid eq_opr = get_opfamily_member(index_rel->rd_opfamily[key->sk_attno - 1],
+											 key->sk_subtype,
+											 key->sk_subtype,
+											 BTEqualStrategyNumber);
+
+			if (!OidIsValid(eq_opr))
+				elog(ERROR, "missing equality operator for SkipScan");
+
+			ScanKeyEntryInitialize(&column->eq_template,
+								   0,
+								   key->sk_attno,
+								   BTEqualStrategyNumber,
+								   key->sk_subtype,
+								   key->sk_collation,
+								   get_opcode(eq_opr),
+								   (Datum) 0);
 		}
 	}
-	if (!state->skip_key)
-		elog(ERROR, "ScanKey for skip qual not found");
 }
 
 static bool
@@ -154,9 +215,76 @@ has_nulls_last(SkipScanState *state)
 	return !has_nulls_first(state);
 }
 
+/*
+ * Set the skip keys for the current stage and skip column. The columns before
+ * the skip column are fixed to the values of the previous tuple and the
+ * columns after it are unconstrained, which for the NOT NULL columns is the
+ * same as IS NOT NULL.
+ */
+static void
+skip_scan_set_keys(SkipScanState *state)
+{
+	for (int col = 0; col < state->num_columns; col++)
+	{
+		SkipScanColumn *column = &state->columns[col];
+		ScanKey key = column->skip_key;
+
+		if (col < state->skip_column)
+		{
+			if (column->prev_is_null)
+			{
+				*key = column->skip_template;
+				key->sk_flags = SK_ISNULL | SK_SEARCHNULL;
+				key->sk_argument = 0;
+			}
+			else
+			{
+				*key = column->eq_template;
+				key->sk_argument = column->prev_datum;
+			}
+			continue;
+		}
+
+		*key = column->skip_template;
+
+		if (col > state->skip_column)
+		{
+			key->sk_flags = SK_ISNULL | SK_SEARCHNOTNULL;
+			key->sk_argument = 0;
+			continue;
+		}
+
+		/* only the first column can have NULLs, so only it goes through the stages */
+		switch (col == 0 ? state->stage : SS_VALUES)
+		{
+			case SS_NOT_NULL:
+				key->sk_flags = SK_ISNULL | SK_SEARCHNOTNULL;
+				key->sk_argument = 0;
+				break;
+
+			case SS_VALUES:
+				key->sk_flags = 0;
+				key->sk_argument = column->prev_datum;
+				break;
+
+			case SS_NULLS_LAST:
+			case SS_NULLS_FIRST:
+				key->sk_flags = SK_ISNULL | SK_SEARCHNULL;
+				key->sk_argument = 0;
+				break;
+
+			case SS_BEGIN:
+			case SS_END:
+				break;
+		}
+	}
+}
+
 static void
 skip_scan_rescan_index(SkipScanState *state)
 {
+	skip_scan_set_keys(state);
+
 	/* if the scan in the child scan has not been
 	 * setup yet which is true before the first tuple
 	 * has been retrieved from child scan we cannot
@@ -173,66 +301,48 @@ skip_scan_rescan_index(SkipScanState *state)
 }
 
 /*
- * Update skip scankey flags according to stage
+ * Switch stage, the skip keys are updated accordingly on the next rescan
  */
 static void
 skip_scan_switch_stage(SkipScanState *state, SkipScanStage new_stage)
 {
 	Assert(new_stage > state->stage);
 
-	switch (new_stage)
-	{
-		case SS_NOT_NULL:
-			state->skip_key->sk_flags = SK_ISNULL | SK_SEARCHNOTNULL;
-			state->skip_key->sk_argument = 0;
-			state->needs_rescan = true;
-			break;
-
-		case SS_VALUES:
-			state->skip_key->sk_flags = 0;
-			state->needs_rescan = true;
-			break;
-
-		case SS_NULLS_LAST:
-		case SS_NULLS_FIRST:
-			state->skip_key->sk_flags = SK_ISNULL | SK_SEARCHNULL;
-			state->skip_key->sk_argument = 0;
-			state->needs_rescan = true;
-			break;
-
-		case SS_BEGIN:
-		case SS_END:
-			break;
-	}
+	if (new_stage != SS_BEGIN && new_stage != SS_END)
+		state->needs_rescan = true;
 
 	state->stage = new_stage;
 }
 
+/*
+ * Remember the values of the distinct columns of a tuple we return, the next
+ * search is for a tuple that differs in the last column.
+ */
 static void
 skip_scan_update_key(SkipScanState *state, TupleTableSlot *slot)
 {
-	if (!state->prev_is_null && !state->distinct_by_val)
-	{
-		Assert(state->stage == SS_VALUES);
-		pfree(DatumGetPointer(state->prev_datum));
-	}
-
 	MemoryContext old_ctx = MemoryContextSwitchTo(state->ctx);
-	state->prev_datum = slot_getattr(slot, state->distinct_col_attnum, &state->prev_is_null);
-	if (state->prev_is_null)
-	{
-		state->skip_key->sk_flags = SK_ISNULL;
-		state->skip_key->sk_argument = 0;
-	}
-	else
+
+	for (int col = 0; col < state->num_columns; col++)
 	{
-		state->prev_datum =
-			datumCopy(state->prev_datum, state->distinct_by_val, state->distinct_typ_len);
-		state->skip_key->sk_argument = state->prev_datum;
+		SkipScanColumn *column = &state->columns[col];
+
+		if (!column->prev_is_null && !column->distinct_by_val)
+			pfree(DatumGetPointer(column->prev_datum));
+
+		column->prev_datum =
+			slot_getattr(slot, column->distinct_col_attnum, &column->prev_is_null);
+		if (column->prev_is_null)
+			column->prev_datum = 0;
+		else
+			column->prev_datum =
+				datumCopy(column->prev_datum, column->distinct_by_val, column->distinct_typ_len);
 	}
 
 	MemoryContextSwitchTo(old_ctx);
 
+	state->skip_column = state->num_columns - 1;
+
 	/* we need to do a rescan whenever we modify the ScanKey */
 	state->needs_rescan = true;
 }
@@ -256,6 +366,25 @@ skip_scan_exec(CustomScanState *node)
 		if (state->needs_rescan)
 			skip_scan_rescan_index(state);
 
+		/*
+		 * Look for the next tuple with the same values in the columns before
+		 * the skip column, and if there is none skip on the column before.
+		 */
+		if (state->skip_column > 0)
+		{
+			result = state->idx->ps.ExecProcNode(&state->idx->ps);
+
+			if (!TupIsNull(result))
+			{
+				skip_scan_update_key(state, result);
+				return result;
+			}
+
+			state->skip_column--;
+			state->needs_rescan = true;
+			continue;
+		}
+
 		switch (state->stage)
 		{
 			case SS_BEGIN:
@@ -275,7 +404,10 @@ skip_scan_exec(CustomScanState *node)
 				 */
 				skip_scan_switch_stage(state, SS_NOT_NULL);
 				if (!TupIsNull(result))
+				{
+					skip_scan_update_key(state, result);
 					return result;
+				}
 
 				break;
 
@@ -316,6 +448,8 @@ skip_scan_exec(CustomScanState *node)
 			case SS_NULLS_LAST:
 				result = state->idx->ps.ExecProcNode(&state->idx->ps);
 				skip_scan_switch_stage(state, SS_END);
+				if (!TupIsNull(result))
+					skip_scan_update_key(state, result);
 				return result;
 				break;
 
@@ -340,17 +474,22 @@ skip_scan_rescan(CustomScanState *node)
 	/* reset stage so we can assert in skip_scan_switch_stage that stage always moves forward */
 	state->stage = SS_BEGIN;
 
-	/* Switching state here instead of in the main loop
-	 * means we dont have to call skip_scan_rescan_index
-	 * as ExecReScan on the child scan takes care of that. */
 	if (has_nulls_first(state))
 		skip_scan_switch_stage(state, SS_NULLS_FIRST);
 	else
 		skip_scan_switch_stage(state, SS_NOT_NULL);
 
-	state->prev_is_null = true;
-	state->prev_datum = 0;
+	for (int col = 0; col < state->num_columns; col++)
+	{
+		state->columns[col].prev_is_null = true;
+		state->columns[col].prev_datum = 0;
+	}
+	state->skip_column = 0;
 
+	/* Setting the keys here instead of in the main loop
+	 * means we dont have to call skip_scan_rescan_index
+	 * as ExecReScan on the child scan takes care of that. */
+	skip_scan_set_keys(state);
 	state->needs_rescan = false;
 	ExecReScan(&state->idx->ps);
 	MemoryContextReset(state->ctx);
@@ -368,17 +507,32 @@ Node *
 tsl_skip_scan_state_create(CustomScan *cscan)
 {
 	SkipScanState *state = (SkipScanState *) newNode(sizeof(SkipScanState), T_CustomScanState);
+	List *attnums = linitial(cscan->custom_private);
+	List *by_vals = lsecond(cscan->custom_private);
+	List *typ_lens = lthird(cscan->custom_private);
+	List *nulls_first = lfourth(cscan->custom_private);
+	List *sk_attnos = list_nth(cscan->custom_private, 4);
 
 	state->idx_scan = linitial(cscan->custom_plans);
 	state->stage = SS_BEGIN;
 
-	state->distinct_col_attnum = linitial_int(cscan->custom_private);
-	state->distinct_by_val = lsecond_int(cscan->custom_private);
-	state->distinct_typ_len = lthird_int(cscan->custom_private);
-	state->nulls_first = lfourth_int(cscan->custom_private);
-	state->sk_attno = list_nth_int(cscan->custom_private, 4);
+	state->num_columns = list_length(attnums);
+	state->columns = palloc0(sizeof(SkipScanColumn) * state->num_columns);
+	for (int col = 0; col < state->num_columns; col++)
+	{
+		SkipScanColumn *column = &state->columns[col];
+
+		column->distinct_col_attnum = list_nth_int(attnums, col);
+		column->distinct_by_val = list_nth_int(by_vals, col);
+		column->distinct_typ_len = list_nth_int(typ_lens, col);
+		column->sk_attno = list_nth_int(sk_attnos, col);
+		column->prev_is_null = true;
+	}
+
+	/* only the first column can have NULL values */
+	state->nulls_first = linitial_int(nulls_first);
+	state->skip_column = 0;
 
-	state->prev_is_null = true;
 	state->cscan_state.methods = &skip_scan_state_methods;
 	return (Node *) state;
 }
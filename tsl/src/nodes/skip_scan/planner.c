@@ -5,7 +5,9 @@
  */
 
 #include <postgres.h>
+#include <access/htup_details.h>
 #include <access/sysattr.h>
+#include <catalog/pg_attribute.h>
 #include <nodes/extensible.h>
 #include <nodes/nodeFuncs.h>
 #include <nodes/makefuncs.h>
@@ -21,6 +23,7 @@
 #include <parser/parse_coerce.h>
 #include <parser/parsetree.h>
 #include <rewrite/rewriteManip.h>
+#include <utils/lsyscache.h>
 #include <utils/syscache.h>
 #include <utils/typcache.h>
 
@@ -29,6 +32,7 @@
 #include "nodes/skip_scan/skip_scan.h"
 #include "nodes/constraint_aware_append/constraint_aware_append.h"
 #include "nodes/chunk_append/chunk_append.h"
+#include "nodes/decompress_chunk/decompress_chunk.h"
 #include "compat/compat.h"
 
 #include <math.h>
@@ -38,16 +42,18 @@ typedef struct SkipScanPath
 	CustomPath cpath;
 	IndexPath *index_path;
 
-	/* Index clause which we'll use to skip past elements we've already seen */
-	RestrictInfo *skip_clause;
-	/* attribute number of the distinct column on the table/chunk */
-	AttrNumber distinct_attno;
-	/* The column offset on the index we are calling DISTINCT on */
-	AttrNumber scankey_attno;
-	int distinct_typ_len;
-	bool distinct_by_val;
-	/* Var referencing the distinct column on the relation */
-	Var *distinct_var;
+	/*
+	 * Index clauses which we'll use to skip past elements we've already seen,
+	 * one for every distinct column in the order of the index columns. The
+	 * other lists below are in the same order.
+	 */
+	List *skip_clauses;
+	/* The column offsets on the index of the columns we are calling DISTINCT on */
+	List *scankey_attnos;
+	List *distinct_typ_lens;
+	List *distinct_by_vals;
+	/* Vars referencing the distinct columns on the relation */
+	List *distinct_vars;
 } SkipScanPath;
 
 static int get_idx_key(IndexOptInfo *idxinfo, AttrNumber attno);
@@ -57,8 +63,10 @@ static bool build_skip_qual(PlannerInfo *root, SkipScanPath *skip_scan_path, Ind
 							Var *var);
 static List *build_subpath(PlannerInfo *root, List *subpaths, double ndistinct);
 static ChunkAppendPath *copy_chunk_append_path(ChunkAppendPath *ca, List *subpaths);
-static Var *get_distinct_var(PlannerInfo *root, IndexPath *index_path,
-							 SkipScanPath *skip_scan_path);
+static List *get_distinct_vars(PlannerInfo *root, RelOptInfo *rel, List **not_null);
+static bool column_is_not_null(Oid relid, AttrNumber attno);
+static Path *skip_scan_compressed_path_create(PlannerInfo *root, DecompressChunkPath *dcpath,
+											  double ndistinct);
 static TargetEntry *tlist_member_match_var(Var *var, List *targetlist);
 
 /**************************
@@ -83,8 +91,13 @@ skip_scan_plan_create(PlannerInfo *root, RelOptInfo *relopt, CustomPath *best_pa
 	SkipScanPath *path = (SkipScanPath *) best_path;
 	CustomScan *skip_plan = makeNode(CustomScan);
 	IndexPath *index_path = path->index_path;
+	List *ops = NIL;
+	List *attnums = NIL;
+	List *nulls_first = NIL;
+	ListCell *lc, *lc_attno;
 
-	OpExpr *op = fix_indexqual(index_path->indexinfo, path->skip_clause, path->scankey_attno);
+	forboth (lc, path->skip_clauses, lc_attno, path->scankey_attnos)
+		ops = lappend(ops, fix_indexqual(index_path->indexinfo, lfirst(lc), lfirst_int(lc_attno)));
 
 	Plan *plan = linitial(custom_plans);
 	if (IsA(plan, IndexScan))
@@ -92,17 +105,19 @@ skip_scan_plan_create(PlannerInfo *root, RelOptInfo *relopt, CustomPath *best_pa
 		IndexScan *idx_plan = castNode(IndexScan, plan);
 		skip_plan->scan = idx_plan->scan;
 
-		/* we prepend skip qual here so sort_indexquals will put it as first qual for that column */
+		/* we prepend skip quals here so sort_indexquals will put them as first qual for their
+		 * columns */
 		idx_plan->indexqual =
-			sort_indexquals(index_path->indexinfo, lcons(op, idx_plan->indexqual));
+			sort_indexquals(index_path->indexinfo, list_concat(ops, idx_plan->indexqual));
 	}
 	else if (IsA(plan, IndexOnlyScan))
 	{
 		IndexOnlyScan *idx_plan = castNode(IndexOnlyScan, plan);
 		skip_plan->scan = idx_plan->scan;
-		/* we prepend skip qual here so sort_indexquals will put it as first qual for that column */
+		/* we prepend skip quals here so sort_indexquals will put them as first qual for their
+		 * columns */
 		idx_plan->indexqual =
-			sort_indexquals(index_path->indexinfo, lcons(op, idx_plan->indexqual));
+			sort_indexquals(index_path->indexinfo, list_concat(ops, idx_plan->indexqual));
 	}
 	else
 		elog(ERROR, "bad subplan type for SkipScan: %d", plan->type);
@@ -113,18 +128,24 @@ skip_scan_plan_create(PlannerInfo *root, RelOptInfo *relopt, CustomPath *best_pa
 	skip_plan->scan.plan.type = T_CustomScan;
 	skip_plan->methods = &skip_scan_plan_methods;
 	skip_plan->custom_plans = custom_plans;
-	/* get position of skipped column in tuples produced by child scan */
-	TargetEntry *tle = tlist_member_match_var(path->distinct_var, plan->targetlist);
+	forboth (lc, path->distinct_vars, lc_attno, path->scankey_attnos)
+	{
+		/* get position of skipped column in tuples produced by child scan */
+		TargetEntry *tle = tlist_member_match_var(lfirst(lc), plan->targetlist);
+		bool column_nulls_first = index_path->indexinfo->nulls_first[lfirst_int(lc_attno) - 1];
 
-	bool nulls_first = index_path->indexinfo->nulls_first[path->scankey_attno - 1];
-	if (index_path->indexscandir == BackwardScanDirection)
-		nulls_first = !nulls_first;
+		if (index_path->indexscandir == BackwardScanDirection)
+			column_nulls_first = !column_nulls_first;
 
-	skip_plan->custom_private = list_make5_int(tle->resno,
-											   path->distinct_by_val,
-											   path->distinct_typ_len,
-											   nulls_first,
-											   path->scankey_attno);
+		attnums = lappend_int(attnums, tle->resno);
+		nulls_first = lappend_int(nulls_first, column_nulls_first);
+	}
+
+	skip_plan->custom_private = list_make5(attnums,
+										   path->distinct_by_vals,
+										   path->distinct_typ_lens,
+										   nulls_first,
+										   path->scankey_attnos);
 	return &skip_plan->scan.plan;
 }
 
@@ -136,8 +157,8 @@ static CustomPathMethods skip_scan_path_methods = {
 	.PlanCustomPath = skip_scan_plan_create,
 };
 
-static SkipScanPath *skip_scan_path_create(PlannerInfo *root, IndexPath *index_path,
-										   double ndistinct);
+static SkipScanPath *skip_scan_path_create(PlannerInfo *root, IndexPath *index_path, List *vars,
+										   List *not_null, double ndistinct);
 
 /*
  * Create SkipScan paths based on existing Unique paths.
@@ -169,6 +190,10 @@ static SkipScanPath *skip_scan_path_create(PlannerInfo *root, IndexPath *index_p
  *                ->  Index Scan using _hyper_2_1_chunk_idx on _hyper_2_1_chunk
  *          ->  Custom Scan (SkipScan) on _hyper_2_2_chunk
  *                ->  Index Scan using _hyper_2_2_chunk_idx on _hyper_2_2_chunk
+ *
+ * For a compressed chunk the SkipScan is created below the DecompressChunk
+ * node when the DISTINCT column is a segmentby column, see
+ * skip_scan_compressed_path_create().
  */
 void
 tsl_skip_scan_paths_add(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel)
@@ -190,17 +215,6 @@ tsl_skip_scan_paths_add(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *ou
 		if (IsA(lfirst(lc), UpperUniquePath))
 		{
 			unique = lfirst_node(UpperUniquePath, lc);
-
-			/* currently we do not handle DISTINCT on more than one key. To do so,
-			 * we would need to break down the SkipScan into subproblems: first
-			 * find the minimal tuple then for each prefix find all unique suffix
-			 * tuples. For instance, if we are searching over (int, int), we would
-			 * first find (0, 0) then find (0, N) for all N in the domain, then
-			 * find (1, N), then (2, N), etc
-			 */
-			if (unique->numkeys > 1)
-				return;
-
 			break;
 		}
 	}
@@ -256,8 +270,22 @@ tsl_skip_scan_paths_add(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *ou
 		if (IsA(subpath, IndexPath))
 		{
 			IndexPath *index_path = castNode(IndexPath, subpath);
+			List *not_null;
+			List *vars = get_distinct_vars(root, index_path->path.parent, &not_null);
 
-			subpath = (Path *) skip_scan_path_create(root, index_path, unique->path.rows);
+			if (!vars)
+				continue;
+
+			subpath = (Path *)
+				skip_scan_path_create(root, index_path, vars, not_null, unique->path.rows);
+			if (!subpath)
+				continue;
+		}
+		else if (ts_is_decompress_chunk_path(subpath))
+		{
+			subpath = skip_scan_compressed_path_create(root,
+													   (DecompressChunkPath *) subpath,
+													   unique->path.rows);
 			if (!subpath)
 				continue;
 		}
@@ -339,8 +367,15 @@ copy_chunk_append_path(ChunkAppendPath *ca, List *subpaths)
 	return new;
 }
 
+/*
+ * Create a SkipScanPath for the distinct columns. With more than one distinct
+ * column the SkipScan skips to the next distinct prefix of the index tuples,
+ * see skip_scan_exec(). Only the first of the distinct columns in the index
+ * can have NULL values then, the others have to be declared NOT NULL.
+ */
 static SkipScanPath *
-skip_scan_path_create(PlannerInfo *root, IndexPath *index_path, double ndistinct)
+skip_scan_path_create(PlannerInfo *root, IndexPath *index_path, List *vars, List *not_null,
+					  double ndistinct)
 {
 	double startup = index_path->path.startup_cost;
 	double total = index_path->path.total_cost;
@@ -386,28 +421,53 @@ skip_scan_path_create(PlannerInfo *root, IndexPath *index_path, double ndistinct
 	 * free so reusing the IndexPath here is safe. */
 	skip_scan_path->index_path = index_path;
 
-	Var *var = get_distinct_var(root, index_path, skip_scan_path);
+	/* build the skip quals in the order of the index columns */
+	IndexOptInfo *info = index_path->indexinfo;
+	for (int i = 0; i < info->nkeycolumns; i++)
+	{
+		ListCell *lc_var, *lc_not_null;
 
-	if (!var)
-		return NULL;
+		forboth (lc_var, vars, lc_not_null, not_null)
+		{
+			Var *var = lfirst_node(Var, lc_var);
+
+			if (var->varattno != info->indexkeys[i])
+				continue;
+
+			if (skip_scan_path->distinct_vars != NIL && !lfirst_int(lc_not_null))
+				return NULL;
 
-	skip_scan_path->distinct_var = var;
+			/* build skip qual this may fail if we cannot look up the operator */
+			if (!build_skip_qual(root, skip_scan_path, index_path, var))
+				return NULL;
 
-	/* build skip qual this may fail if we cannot look up the operator */
-	if (!build_skip_qual(root, skip_scan_path, index_path, var))
+			skip_scan_path->distinct_vars = lappend(skip_scan_path->distinct_vars, var);
+			break;
+		}
+	}
+
+	/*
+	 * The index has to include all the distinct columns, see the comment in
+	 * build_skip_qual().
+	 */
+	if (list_length(skip_scan_path->distinct_vars) != list_length(vars))
 		return NULL;
 
 	return skip_scan_path;
 }
 
-/* Extract the Var to use for the SkipScan and do attno mapping if required. */
-static Var *
-get_distinct_var(PlannerInfo *root, IndexPath *index_path, SkipScanPath *skip_scan_path)
+/*
+ * Extract the Vars to use for the SkipScan and do attno mapping if required.
+ * For every Var, not_null gets whether the column is declared NOT NULL.
+ */
+static List *
+get_distinct_vars(PlannerInfo *root, RelOptInfo *rel, List **not_null)
 {
 	ListCell *lc;
-	int num_vars = 0;
-	RelOptInfo *rel = index_path->path.parent;
-	Expr *tlexpr = NULL;
+	List *vars = NIL;
+	Index varno = 0;
+
+	*not_null = NIL;
 
 	foreach (lc, root->parse->distinctClause)
 	{
@@ -419,39 +479,47 @@ get_distinct_var(PlannerInfo *root, IndexPath *index_path, SkipScanPath *skip_sc
 		if (IsA(estimate_expression_value(root, expr), Const))
 			continue;
 
-		num_vars++;
-
 		/* We ignore binary-compatible relabeling */
-		tlexpr = (Expr *) expr;
+		Expr *tlexpr = (Expr *) expr;
 		while (tlexpr && IsA(tlexpr, RelabelType))
 			tlexpr = ((RelabelType *) tlexpr)->arg;
-	}
 
-	if (num_vars != 1)
-		return NULL;
+		/* SkipScan on expressions not supported */
+		if (!tlexpr || !IsA(tlexpr, Var))
+			return NIL;
 
-	/* SkipScan on expressions not supported */
-	if (!tlexpr || !IsA(tlexpr, Var))
-		return NULL;
+		Var *var = castNode(Var, tlexpr);
 
-	Var *var = castNode(Var, tlexpr);
+		/* all the distinct columns have to come from the same relation */
+		if (varno != 0 && (Index) var->varno != varno)
+			return NIL;
 
-	/* If we are dealing with a hypertable Var extracted from distinctClause will point to
+		varno = var->varno;
+		vars = lappend(vars, var);
+		*not_null =
+			lappend_int(*not_null,
+						column_is_not_null(planner_rt_fetch(varno, root)->relid, var->varattno));
+	}
+
+	if (vars == NIL)
+		return NIL;
+
+	/* If we are dealing with a hypertable Vars extracted from distinctClause will point to
 	 * the parent hypertable while the IndexPath will be on a Chunk.
 	 * For a normal table they point to the same relation and we are done here. */
-	if ((Index) var->varno == rel->relid)
-		return var;
+	if (varno == rel->relid)
+		return vars;
 
-	RangeTblEntry *ht_rte = planner_rt_fetch(var->varno, root);
+	RangeTblEntry *ht_rte = planner_rt_fetch(varno, root);
 	RangeTblEntry *chunk_rte = planner_rt_fetch(rel->relid, root);
 
 	/* Check for hypertable */
-	if (!ts_is_hypertable(ht_rte->relid) || !bms_is_member(var->varno, rel->top_parent_relids))
-		return NULL;
+	if (!ts_is_hypertable(ht_rte->relid) || !bms_is_member(varno, rel->top_parent_relids))
+		return NIL;
 
 	Relation ht_rel = table_open(ht_rte->relid, AccessShareLock);
 	Relation chunk_rel = table_open(chunk_rte->relid, AccessShareLock);
-	bool found_wholerow;
+	bool found_wholerow = false;
 	TupleConversionMap *map =
 		convert_tuples_by_name_compat(RelationGetDescr(chunk_rel),
 									  RelationGetDescr(ht_rel),
@@ -460,38 +528,50 @@ get_distinct_var(PlannerInfo *root, IndexPath *index_path, SkipScanPath *skip_sc
 	/* attno mapping necessary */
 	if (map)
 	{
-		var = (Var *) map_variable_attnos_compat((Node *) var,
-												 var->varno,
-												 0,
-												 map->attrMap,
-												 map->outdesc->natts,
-												 InvalidOid,
-												 &found_wholerow);
+		vars = (List *) map_variable_attnos_compat((Node *) vars,
+												   varno,
+												   0,
+												   map->attrMap,
+												   map->outdesc->natts,
+												   InvalidOid,
+												   &found_wholerow);
 
 		free_conversion_map(map);
-
-		/* If we found whole row here skipscan wouldn't be applicable
-		 * but this should have been caught already in previous checks */
-		Assert(!found_wholerow);
-		if (found_wholerow)
-		{
-			table_close(ht_rel, NoLock);
-			table_close(chunk_rel, NoLock);
-
-			return NULL;
-		}
 	}
 	else
 	{
-		var = copyObject(var);
+		vars = copyObject(vars);
 	}
 
 	table_close(ht_rel, NoLock);
 	table_close(chunk_rel, NoLock);
 
-	var->varno = rel->relid;
+	/* If we found whole row here skipscan wouldn't be applicable
+	 * but this should have been caught already in previous checks */
+	Assert(!found_wholerow);
+	if (found_wholerow)
+		return NIL;
 
-	return var;
+	foreach (lc, vars)
+		lfirst_node(Var, lc)->varno = rel->relid;
+
+	return vars;
+}
+
+/* Check if a column is declared NOT NULL */
+static bool
+column_is_not_null(Oid relid, AttrNumber attno)
+{
+	HeapTuple tuple = SearchSysCache2(ATTNUM, ObjectIdGetDatum(relid), Int16GetDatum(attno));
+	bool attnotnull;
+
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for attribute %d of relation %u", attno, relid);
+
+	attnotnull = ((Form_pg_attribute) GETSTRUCT(tuple))->attnotnull;
+	ReleaseSysCache(tuple);
+
+	return attnotnull;
 }
 
 /*
@@ -511,8 +591,15 @@ build_subpath(PlannerInfo *root, List *subpaths, double ndistinct)
 		Path *child = lfirst(lc);
 		if (IsA(child, IndexPath))
 		{
+			List *not_null;
+			List *vars = get_distinct_vars(root, child->parent, &not_null);
 			SkipScanPath *skip_path =
-				skip_scan_path_create(root, castNode(IndexPath, child), ndistinct);
+				vars ? skip_scan_path_create(root,
+											 castNode(IndexPath, child),
+											 vars,
+											 not_null,
+											 ndistinct) :
+					   NULL;
 
 			if (skip_path)
 			{
@@ -520,6 +607,17 @@ build_subpath(PlannerInfo *root, List *subpaths, double ndistinct)
 				has_skip_path = true;
 			}
 		}
+		else if (ts_is_decompress_chunk_path(child))
+		{
+			Path *skip_path =
+				skip_scan_compressed_path_create(root, (DecompressChunkPath *) child, ndistinct);
+
+			if (skip_path)
+			{
+				child = skip_path;
+				has_skip_path = true;
+			}
+		}
 
 		new_paths = lappend(new_paths, child);
 	}
@@ -533,6 +631,93 @@ build_subpath(PlannerInfo *root, List *subpaths, double ndistinct)
 	return new_paths;
 }
 
+/*
+ * Create a DecompressChunkPath that runs a SkipScan over the index scan of the
+ * compressed chunk. When the DISTINCT columns are segmentby columns, all rows
+ * of a compressed batch have the same values in them, so only the first batch
+ * of every segment in the order of the compressed scan has to be decompressed.
+ * These are the batches producing the first decompressed rows of the segment,
+ * so this also works for DISTINCT ON with additional ORDER BY columns.
+ *
+ * Filters evaluated on the decompressed rows could remove all the rows of
+ * that batch, so all the restrictions of the chunk have to be on segmentby
+ * columns, which are also checked by the compressed scan.
+ */
+static Path *
+skip_scan_compressed_path_create(PlannerInfo *root, DecompressChunkPath *dcpath, double ndistinct)
+{
+	CompressionInfo *info = dcpath->info;
+	Path *compressed_path = linitial(dcpath->cpath.custom_paths);
+	ListCell *lc;
+
+	if (!ts_guc_enable_compressed_skip_scan)
+		return NULL;
+
+	if (!IsA(compressed_path, IndexPath) || compressed_path->param_info != NULL ||
+		dcpath->batch_sorted_merge)
+		return NULL;
+
+	/* the batches must not be sorted again after skipping */
+	if (!pathkeys_contained_in(dcpath->compressed_pathkeys, compressed_path->pathkeys))
+		return NULL;
+
+	foreach (lc, info->chunk_rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+		Bitmapset *attnos = NULL;
+		int attno = -1;
+
+		pull_varattnos((Node *) rinfo->clause, info->chunk_rel->relid, &attnos);
+		while ((attno = bms_next_member(attnos, attno)) >= 0)
+		{
+			if (!bms_is_member(attno + FirstLowInvalidHeapAttributeNumber,
+							   info->chunk_segmentby_attnos))
+				return NULL;
+		}
+	}
+
+	List *not_null;
+	List *chunk_vars = get_distinct_vars(root, info->chunk_rel, &not_null);
+	List *vars = NIL;
+
+	if (!chunk_vars)
+		return NULL;
+
+	foreach (lc, chunk_vars)
+	{
+		Var *chunk_var = lfirst_node(Var, lc);
+
+		if (!bms_is_member(chunk_var->varattno, info->chunk_segmentby_attnos))
+			return NULL;
+
+		/* segmentby columns are stored uncompressed in the compressed chunk */
+		char *attname = get_attname(info->chunk_rte->relid, chunk_var->varattno, false);
+		AttrNumber compressed_attno = get_attnum(info->compressed_rte->relid, attname);
+
+		if (compressed_attno == InvalidAttrNumber)
+			return NULL;
+
+		vars = lappend(vars,
+					   makeVar(info->compressed_rel->relid,
+							   compressed_attno,
+							   chunk_var->vartype,
+							   chunk_var->vartypmod,
+							   chunk_var->varcollid,
+							   0));
+	}
+
+	SkipScanPath *skip_path = skip_scan_path_create(root,
+													castNode(IndexPath, compressed_path),
+													vars,
+													not_null,
+													ndistinct);
+
+	if (!skip_path)
+		return NULL;
+
+	return (Path *) ts_decompress_chunk_path_copy(dcpath, (Path *) skip_path);
+}
+
 static bool
 build_skip_qual(PlannerInfo *root, SkipScanPath *skip_scan_path, IndexPath *index_path, Var *var)
 {
@@ -561,11 +746,10 @@ build_skip_qual(PlannerInfo *root, SkipScanPath *skip_scan_path, IndexPath *inde
 	if (idx_key < 0)
 		return false;
 
-	skip_scan_path->distinct_attno = var->varattno;
-	skip_scan_path->distinct_by_val = tce->typbyval;
-	skip_scan_path->distinct_typ_len = tce->typlen;
+	skip_scan_path->distinct_by_vals = lappend_int(skip_scan_path->distinct_by_vals, tce->typbyval);
+	skip_scan_path->distinct_typ_lens = lappend_int(skip_scan_path->distinct_typ_lens, tce->typlen);
 	/* sk_attno of the skip qual */
-	skip_scan_path->scankey_attno = idx_key + 1;
+	skip_scan_path->scankey_attnos = lappend_int(skip_scan_path->scankey_attnos, idx_key + 1);
 
 	int16 strategy = info->reverse_sort[idx_key] ? BTLessStrategyNumber : BTGreaterStrategyNumber;
 	if (index_path->indexscandir == BackwardScanDirection)
@@ -623,7 +807,8 @@ build_skip_qual(PlannerInfo *root, SkipScanPath *skip_scan_path, IndexPath *inde
 										  info->indexcollations[idx_key] /*inputcollid*/);
 	set_opfuncid(castNode(OpExpr, comparison_expr));
 
-	skip_scan_path->skip_clause = make_simple_restrictinfo_compat(root, comparison_expr);
+	RestrictInfo *skip_clause = make_simple_restrictinfo_compat(root, comparison_expr);
+	skip_scan_path->skip_clauses = lappend(skip_scan_path->skip_clauses, skip_clause);
 
 	return true;
 }
@@ -0,0 +1,1600 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * VectorAgg computes partial aggregates over the output of a DecompressChunk
+ * node. When the DecompressChunk node has no quals that must be evaluated row
+ * by row, the aggregates are computed directly from the decompressed column
+ * arrays of each batch, without forming the tuples. Otherwise the tuples of
+ * the child node are aggregated one by one.
+ *
+ * The grouping columns are segmentby columns, so the group only changes
+ * between the batches, and optionally one time_bucket over the first orderby
+ * column. The batches are sorted by that column, so the rows of a bucket are
+ * consecutive, and the batch is aggregated in the runs of rows that fall into
+ * the same bucket. The buckets are computed for the whole batch at once, and
+ * when the first and the last row of a batch are in the same bucket, the
+ * whole batch is in it and the buckets of the other rows are not computed.
+ *
+ * A partial aggregate row is emitted every time the group changes, so there
+ * can be several partial rows for the same group, which are combined by the
+ * Finalize Aggregate node above.
+ */
+
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/parallel.h>
+#include <catalog/pg_aggregate.h>
+#include <catalog/pg_type.h>
+#include <executor/executor.h>
+#include <nodes/makefuncs.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/pg_list.h>
+#include <optimizer/optimizer.h>
+#include <parser/parse_func.h>
+#include <port/pg_bitutils.h>
+#include <utils/array.h>
+#include <utils/datum.h>
+#include <utils/float.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/syscache.h>
+
+#include "chunk.h"
+#include "compat/compat.h"
+#include "extension.h"
+#include "func_cache.h"
+#include "guc.h"
+#include "histogram.h"
+#include "nodes/decompress_chunk/exec.h"
+#include "nodes/vector_agg/result_cache.h"
+#include "nodes/vector_agg/vector_agg.h"
+#include "time_bucket.h"
+
+typedef enum VectorAggFunction
+{
+	VAF_COUNT_STAR,
+	VAF_COUNT,
+	VAF_SUM,
+	VAF_MIN,
+	VAF_MAX,
+	VAF_AVG,
+	VAF_HISTOGRAM,
+} VectorAggFunction;
+
+/* How the values of the aggregate argument are read */
+typedef enum VectorAggArgType
+{
+	VAA_NONE, /* only the nulls matter, for count */
+	VAA_INT16,
+	VAA_INT32,
+	VAA_INT64,
+	VAA_FLOAT4,
+	VAA_FLOAT8,
+} VectorAggArgType;
+
+typedef struct VectorAggColumn
+{
+	bool is_aggregate;
+
+	/* Attno of the input column in the decompressed chunk, 0 for count(*) */
+	AttrNumber input_attno;
+	/* Position of the input column in the targetlist of the child node */
+	AttrNumber input_resno;
+	DecompressChunkBatchColumn batch_input;
+
+	/* grouping column */
+	int16 typlen;
+	bool typbyval;
+	Datum group_value;
+	bool group_isnull;
+
+	/* grouping column computed with time_bucket, see parse_time_bucket() */
+	bool is_bucket;
+	Oid bucket_type;
+	int64 bucket_period;
+	int64 bucket_shift;
+	/* the bucket of the current input */
+	int64 bucket;
+	bool bucket_isnull;
+
+	/* aggregate */
+	VectorAggFunction func;
+	VectorAggArgType argtype;
+	int64 count;
+	bool has_value;
+	int64 ival;
+	float8 fval;
+	float4 f4val;
+	float8 sxx;
+
+	/* histogram(value, min, max, nbuckets) with constant bounds */
+	float8 hist_min;
+	float8 hist_max;
+	int32 hist_nbuckets;
+	/* the counts of the nbuckets + 2 buckets, in the group context */
+	int32 *hist_counts;
+} VectorAggColumn;
+
+typedef struct VectorAggState
+{
+	CustomScanState csstate;
+	int num_columns;
+	VectorAggColumn *columns;
+	bool has_grouping;
+
+	/* consume whole batches instead of the tuples of the child node */
+	bool batch_mode;
+	int batch_rows;
+	const uint64 *batch_filter;
+	/* the rows of the batch that are aggregated next */
+	int first_row;
+	int end_row;
+	uint64 *mask_buffer;
+	int mask_buffer_words;
+	TupleTableSlot *input_slot;
+
+	/* the time_bucket grouping column, the batches are aggregated in runs */
+	VectorAggColumn *bucket_column;
+	/* all the rows of the current batch are in one bucket */
+	bool single_bucket;
+	int64 *buckets;
+	int buckets_size;
+
+	bool have_group;
+	bool input_done;
+	MemoryContext group_context;
+
+	/*
+	 * The result cache, see result_cache.c. The key is NULL when the result
+	 * can't be cached.
+	 */
+	char *cache_key;
+	Oid cache_chunk_relid;
+	MemoryContext cache_context;
+	bool cache_checked;
+	ChunkCompressedDataVersion cache_version;
+	/* the partial aggregates found in the cache, returned instead of the input */
+	MinimalTuple *cached_tuples;
+	int cached_ntuples;
+	int cached_position;
+	TupleTableSlot *cached_slot;
+	/* the partial aggregates emitted so far, to store in the cache */
+	bool cache_collecting;
+	List *cache_tuples;
+} VectorAggState;
+
+static void vector_agg_begin(CustomScanState *node, EState *estate, int eflags);
+static TupleTableSlot *vector_agg_exec(CustomScanState *node);
+static void vector_agg_end(CustomScanState *node);
+static void vector_agg_rescan(CustomScanState *node);
+
+static CustomExecMethods vector_agg_state_methods = {
+	.CustomName = "VectorAgg",
+	.BeginCustomScan = vector_agg_begin,
+	.ExecCustomScan = vector_agg_exec,
+	.EndCustomScan = vector_agg_end,
+	.ReScanCustomScan = vector_agg_rescan,
+};
+
+static void
+float_overflow(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE), errmsg("value out of range: overflow")));
+}
+
+static bool
+get_arg_type(Oid typid, VectorAggArgType *argtype)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			*argtype = VAA_INT16;
+			return true;
+		case INT4OID:
+		case DATEOID:
+			*argtype = VAA_INT32;
+			return true;
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			*argtype = VAA_INT64;
+			return true;
+		case FLOAT4OID:
+			*argtype = VAA_FLOAT4;
+			return true;
+		case FLOAT8OID:
+			*argtype = VAA_FLOAT8;
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Check that the Aggref is histogram(value, min, max, nbuckets) of the
+ * extension over a float8 column with constant bounds and number of buckets,
+ * and remember the arguments in the column when it is given.
+ */
+static bool
+parse_histogram(Aggref *aggref, VectorAggColumn *column)
+{
+	Oid argtypes[] = { FLOAT8OID, FLOAT8OID, FLOAT8OID, INT4OID };
+	List *funcname;
+	Expr *value;
+	Const *min;
+	Const *max;
+	Const *nbuckets;
+
+	if (list_length(aggref->args) != 4)
+		return false;
+
+	funcname = list_make2(makeString(ts_extension_schema_name()), makeString("histogram"));
+	if (aggref->aggfnoid != LookupFuncName(funcname, 4, argtypes, true))
+		return false;
+
+	value = linitial_node(TargetEntry, aggref->args)->expr;
+	min = (Const *) lsecond_node(TargetEntry, aggref->args)->expr;
+	max = (Const *) lthird_node(TargetEntry, aggref->args)->expr;
+	nbuckets = (Const *) lfourth_node(TargetEntry, aggref->args)->expr;
+
+	if (!IsA(value, Var) || castNode(Var, value)->varattno <= 0 || !IsA(min, Const) ||
+		min->constisnull || !IsA(max, Const) || max->constisnull || !IsA(nbuckets, Const) ||
+		nbuckets->constisnull)
+		return false;
+
+	if (column != NULL)
+	{
+		column->hist_min = DatumGetFloat8(min->constvalue);
+		column->hist_max = DatumGetFloat8(max->constvalue);
+		column->hist_nbuckets = DatumGetInt32(nbuckets->constvalue);
+	}
+
+	return true;
+}
+
+/*
+ * Determine which of the supported aggregate functions the Aggref is, by the
+ * transition and final functions of the aggregate. Only aggregates over a
+ * single plain column, without DISTINCT, ORDER BY or FILTER are supported,
+ * and the histogram aggregate of the extension.
+ */
+static bool
+classify_aggref(Aggref *aggref, VectorAggFunction *func, VectorAggArgType *argtype)
+{
+	HeapTuple tuple;
+	Form_pg_aggregate aggform;
+	Oid transfn;
+	Oid finalfn;
+	Oid input_type = InvalidOid;
+	bool is_int = false;
+	bool is_float = false;
+
+	if (aggref->aggdistinct != NIL || aggref->aggorder != NIL || aggref->aggfilter != NULL ||
+		aggref->aggkind != AGGKIND_NORMAL || aggref->agglevelsup != 0 || aggref->aggvariadic)
+		return false;
+
+	if (aggref->aggstar)
+	{
+		if (aggref->args != NIL)
+			return false;
+	}
+	else if (parse_histogram(aggref, NULL))
+	{
+		*func = VAF_HISTOGRAM;
+		*argtype = VAA_FLOAT8;
+		return true;
+	}
+	else
+	{
+		TargetEntry *tle;
+
+		if (list_length(aggref->args) != 1)
+			return false;
+
+		tle = linitial_node(TargetEntry, aggref->args);
+		if (!IsA(tle->expr, Var) || castNode(Var, tle->expr)->varattno <= 0)
+			return false;
+
+		/* only the histogram has a serialized transition state */
+		if (aggref->aggtranstype == INTERNALOID)
+			return false;
+
+		input_type = exprType((Node *) tle->expr);
+		if (get_arg_type(input_type, argtype))
+		{
+			is_float = *argtype == VAA_FLOAT4 || *argtype == VAA_FLOAT8;
+			is_int = !is_float;
+		}
+	}
+
+	tuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for aggregate %u", aggref->aggfnoid);
+	aggform = (Form_pg_aggregate) GETSTRUCT(tuple);
+	transfn = aggform->aggtransfn;
+	finalfn = aggform->aggfinalfn;
+	ReleaseSysCache(tuple);
+
+	switch (transfn)
+	{
+		case F_INT8INC:
+			*func = VAF_COUNT_STAR;
+			*argtype = VAA_NONE;
+			return aggref->aggstar;
+		case F_INT8INC_ANY:
+			*func = VAF_COUNT;
+			*argtype = VAA_NONE;
+			return !aggref->aggstar;
+		case F_INT2_SUM:
+		case F_INT4_SUM:
+		case F_FLOAT4PL:
+		case F_FLOAT8PL:
+			*func = VAF_SUM;
+			return is_int || is_float;
+		case F_INT2SMALLER:
+		case F_INT4SMALLER:
+		case F_INT8SMALLER:
+		case F_DATE_SMALLER:
+		case F_TIMESTAMP_SMALLER:
+		case F_TIMESTAMPTZ_SMALLER:
+		case F_FLOAT4SMALLER:
+		case F_FLOAT8SMALLER:
+			*func = VAF_MIN;
+			return is_int || is_float;
+		case F_INT2LARGER:
+		case F_INT4LARGER:
+		case F_INT8LARGER:
+		case F_DATE_LARGER:
+		case F_TIMESTAMP_LARGER:
+		case F_TIMESTAMPTZ_LARGER:
+		case F_FLOAT4LARGER:
+		case F_FLOAT8LARGER:
+			*func = VAF_MAX;
+			return is_int || is_float;
+		case F_INT2_AVG_ACCUM:
+		case F_INT4_AVG_ACCUM:
+			*func = VAF_AVG;
+			return is_int && finalfn == F_INT8_AVG;
+		case F_FLOAT4_ACCUM:
+		case F_FLOAT8_ACCUM:
+			/* the same transition function is used by stddev and variance */
+			*func = VAF_AVG;
+			return is_float && finalfn == F_FLOAT8_AVG;
+		default:
+			return false;
+	}
+}
+
+bool
+tsl_vector_agg_aggref_supported(Aggref *aggref)
+{
+	VectorAggFunction func;
+	VectorAggArgType argtype;
+
+	return classify_aggref(aggref, &func, &argtype);
+}
+
+/*
+ * Check that the grouping expression is time_bucket with a constant width and
+ * origin over a bigint, timestamp or timestamptz column, so that the buckets
+ * can be computed for whole batches with ts_time_bucket_int64_array().
+ */
+static bool
+parse_time_bucket(Expr *expr, VectorAggColumn *column)
+{
+	FuncExpr *func;
+	FuncInfo *info;
+	Const *width;
+	Const *origin = NULL;
+	Var *var;
+
+	if (!IsA(expr, FuncExpr))
+		return false;
+
+	func = castNode(FuncExpr, expr);
+	info = ts_func_cache_get(func->funcid);
+	if (info == NULL || info->origin != ORIGIN_TIMESCALE ||
+		strcmp(info->funcname, "time_bucket") != 0)
+		return false;
+
+	if (list_length(func->args) < 2 || list_length(func->args) > 3 ||
+		!IsA(linitial(func->args), Const) || !IsA(lsecond(func->args), Var))
+		return false;
+
+	width = linitial_node(Const, func->args);
+	var = lsecond_node(Var, func->args);
+	if (width->constisnull || var->varattno <= 0 ||
+		width->consttype != (var->vartype == INT8OID ? INT8OID : INTERVALOID))
+		return false;
+
+	if (list_length(func->args) == 3)
+	{
+		/* the variants with an offset interval are not supported */
+		if (!IsA(lthird(func->args), Const) || lthird_node(Const, func->args)->constisnull ||
+			lthird_node(Const, func->args)->consttype != var->vartype)
+			return false;
+
+		origin = lthird_node(Const, func->args);
+	}
+
+	column->is_bucket = true;
+	column->bucket_type = var->vartype;
+	column->input_attno = var->varattno;
+
+	return ts_time_bucket_int64_params(var->vartype,
+									   width->constvalue,
+									   origin != NULL ? origin->constvalue : (Datum) 0,
+									   origin != NULL,
+									   &column->bucket_period,
+									   &column->bucket_shift);
+}
+
+/*
+ * Check that the grouping expression is a time_bucket that VectorAgg can
+ * compute, and return the attno of its time column.
+ */
+bool
+tsl_vector_agg_time_bucket_supported(Expr *expr, AttrNumber *attno)
+{
+	VectorAggColumn column = { 0 };
+
+	if (!parse_time_bucket(expr, &column))
+		return false;
+
+	*attno = column.input_attno;
+	return true;
+}
+
+Node *
+tsl_vector_agg_state_create(CustomScan *cscan)
+{
+	VectorAggState *state;
+
+	state = (VectorAggState *) newNode(sizeof(VectorAggState), T_CustomScanState);
+	state->csstate.methods = &vector_agg_state_methods;
+
+	return (Node *) state;
+}
+
+/*
+ * Find the position of the column in the targetlist of the child node.
+ */
+static AttrNumber
+find_input_resno(List *child_tlist, AttrNumber attno)
+{
+	ListCell *lc;
+
+	foreach (lc, child_tlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+
+		if (IsA(tle->expr, Var) && castNode(Var, tle->expr)->varattno == attno)
+			return tle->resno;
+	}
+
+	elog(ERROR, "column %d not found in the targetlist of the VectorAgg input", attno);
+	pg_unreachable();
+}
+
+/*
+ * Check if the plan or any plan below it is parallel aware, so that it only
+ * returns a part of the rows in this process.
+ */
+static bool
+plan_is_parallel_aware(Plan *plan)
+{
+	ListCell *lc;
+
+	if (plan == NULL)
+		return false;
+
+	if (plan->parallel_aware)
+		return true;
+
+	if (IsA(plan, CustomScan))
+	{
+		foreach (lc, castNode(CustomScan, plan)->custom_plans)
+		{
+			if (plan_is_parallel_aware(lfirst(lc)))
+				return true;
+		}
+	}
+
+	return plan_is_parallel_aware(plan->lefttree) || plan_is_parallel_aware(plan->righttree);
+}
+
+static bool
+contain_param_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+		return true;
+
+	return expression_tree_walker(node, contain_param_walker, context);
+}
+
+/*
+ * The key of the partial aggregates in the result cache: the aggregates and
+ * the grouping, and the quals of the decompression and of the scan of the
+ * compressed chunk. Returns NULL when the result depends on something else
+ * than the compressed data, like parameters, mutable functions or a parallel
+ * scan.
+ */
+static char *
+result_cache_key(CustomScan *cscan, Plan *child_plan)
+{
+	Plan *compressed_plan;
+	List *exprs;
+
+	if (IsParallelWorker() || !IsA(child_plan, CustomScan) ||
+		plan_is_parallel_aware(child_plan) ||
+		list_length(castNode(CustomScan, child_plan)->custom_plans) != 1)
+		return NULL;
+
+	compressed_plan = linitial(castNode(CustomScan, child_plan)->custom_plans);
+	exprs = list_make4(cscan->custom_scan_tlist,
+					   child_plan->targetlist,
+					   child_plan->qual,
+					   compressed_plan->qual);
+
+	switch (nodeTag(compressed_plan))
+	{
+		case T_SeqScan:
+			break;
+		case T_IndexScan:
+			exprs = lappend(exprs, castNode(IndexScan, compressed_plan)->indexqualorig);
+			break;
+		case T_BitmapHeapScan:
+			exprs = lappend(exprs, castNode(BitmapHeapScan, compressed_plan)->bitmapqualorig);
+			break;
+		default:
+			return NULL;
+	}
+
+	if (contain_param_walker((Node *) exprs, NULL) || contain_mutable_functions((Node *) exprs))
+		return NULL;
+
+	return nodeToString(exprs);
+}
+
+static void
+vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	VectorAggState *state = (VectorAggState *) node;
+	CustomScan *cscan = castNode(CustomScan, node->ss.ps.plan);
+	Plan *child_plan = linitial(cscan->custom_plans);
+	PlanState *child;
+	ListCell *lc;
+	int i = 0;
+
+	Assert(list_length(cscan->custom_plans) == 1);
+
+	child = ExecInitNode(child_plan, estate, eflags);
+	node->custom_ps = list_make1(child);
+
+	state->num_columns = list_length(cscan->custom_scan_tlist);
+	state->columns = palloc0(sizeof(VectorAggColumn) * state->num_columns);
+
+	foreach (lc, cscan->custom_scan_tlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+		VectorAggColumn *column = &state->columns[i++];
+
+		if (IsA(tle->expr, Aggref))
+		{
+			Aggref *aggref = castNode(Aggref, tle->expr);
+
+			column->is_aggregate = true;
+			if (!classify_aggref(aggref, &column->func, &column->argtype))
+				elog(ERROR, "unsupported aggregate function in VectorAgg");
+
+			if (column->func == VAF_HISTOGRAM)
+				parse_histogram(aggref, column);
+
+			if (!aggref->aggstar)
+			{
+				Var *var = castNode(Var, linitial_node(TargetEntry, aggref->args)->expr);
+
+				column->input_attno = var->varattno;
+				column->input_resno = find_input_resno(child_plan->targetlist, var->varattno);
+			}
+		}
+		else if (IsA(tle->expr, Var))
+		{
+			Var *var = castNode(Var, tle->expr);
+
+			column->input_attno = var->varattno;
+			column->input_resno = find_input_resno(child_plan->targetlist, var->varattno);
+			get_typlenbyval(var->vartype, &column->typlen, &column->typbyval);
+			state->has_grouping = true;
+		}
+		else
+		{
+			if (!parse_time_bucket(tle->expr, column) || state->bucket_column != NULL)
+				elog(ERROR, "unsupported grouping expression in VectorAgg");
+
+			column->input_resno = find_input_resno(child_plan->targetlist, column->input_attno);
+			get_typlenbyval(column->bucket_type, &column->typlen, &column->typbyval);
+			state->bucket_column = column;
+			state->has_grouping = true;
+		}
+	}
+
+	state->batch_mode = decompress_chunk_batch_mode_supported(child);
+	state->group_context =
+		AllocSetContextCreate(CurrentMemoryContext, "VectorAgg group", ALLOCSET_DEFAULT_SIZES);
+
+	state->cache_chunk_relid = decompress_chunk_get_chunk_relid(child);
+	if (ts_guc_vector_agg_cache_size > 0 && OidIsValid(state->cache_chunk_relid))
+		state->cache_key = result_cache_key(cscan, child_plan);
+
+	if (state->cache_key != NULL)
+	{
+		state->cache_context =
+			AllocSetContextCreate(CurrentMemoryContext, "VectorAgg cache", ALLOCSET_DEFAULT_SIZES);
+		state->cached_slot = ExecInitExtraTupleSlot(estate,
+													node->ss.ss_ScanTupleSlot->tts_tupleDescriptor,
+													&TTSOpsMinimalTuple);
+	}
+}
+
+#define ROW_PASSES(mask, row)                                                                      \
+	((mask) == NULL || ((mask)[(row) / 64] & (UINT64CONST(1) << ((row) % 64))) != 0)
+
+/*
+ * Accumulate the values of an integer column. Sum is computed in int64 like
+ * int2_sum and int4_sum do, min and max compare the values as integers.
+ */
+#define DEFINE_ACCUMULATE_INT(CTYPE)                                                               \
+	static void accumulate_##CTYPE(VectorAggColumn *agg,                                           \
+								   const CTYPE *restrict values,                                   \
+								   const uint64 *restrict mask,                                    \
+								   int first_row,                                                  \
+								   int end_row)                                                    \
+	{                                                                                              \
+		int64 count = 0;                                                                           \
+		int64 result = agg->ival;                                                                  \
+                                                                                                   \
+		switch (agg->func)                                                                         \
+		{                                                                                          \
+			case VAF_SUM:                                                                          \
+			case VAF_AVG:                                                                          \
+				for (int row = first_row; row < end_row; row++)                                    \
+				{                                                                                  \
+					if (ROW_PASSES(mask, row))                                                     \
+					{                                                                              \
+						result += values[row];                                                     \
+						count++;                                                                   \
+					}                                                                              \
+				}                                                                                  \
+				break;                                                                             \
+			case VAF_MIN:                                                                          \
+				if (!agg->has_value)                                                               \
+					result = PG_INT64_MAX;                                                         \
+				for (int row = first_row; row < end_row; row++)                                    \
+				{                                                                                  \
+					if (ROW_PASSES(mask, row))                                                     \
+					{                                                                              \
+						result = Min(result, values[row]);                                         \
+						count++;                                                                   \
+					}                                                                              \
+				}                                                                                  \
+				break;                                                                             \
+			case VAF_MAX:                                                                          \
+				if (!agg->has_value)                                                               \
+					result = PG_INT64_MIN;                                                         \
+				for (int row = first_row; row < end_row; row++)                                    \
+				{                                                                                  \
+					if (ROW_PASSES(mask, row))                                                     \
+					{                                                                              \
+						result = Max(result, values[row]);                                         \
+						count++;                                                                   \
+					}                                                                              \
+				}                                                                                  \
+				break;                                                                             \
+			default:                                                                               \
+				Assert(false);                                                                     \
+				break;                                                                             \
+		}                                                                                          \
+                                                                                                   \
+		if (count > 0)                                                                             \
+		{                                                                                          \
+			agg->ival = result;                                                                    \
+			agg->count += count;                                                                   \
+			agg->has_value = true;                                                                 \
+		}                                                                                          \
+	}
+
+DEFINE_ACCUMULATE_INT(int16)
+DEFINE_ACCUMULATE_INT(int32)
+DEFINE_ACCUMULATE_INT(int64)
+
+/*
+ * The float8_accum() transition step, used for avg over float columns.
+ */
+static inline void
+float8_accum_value(VectorAggColumn *agg, float8 newval)
+{
+	float8 N = (float8) agg->count;
+	float8 Sx = agg->fval + newval;
+	float8 Sxx = agg->sxx;
+
+	if (N > 0.0)
+	{
+		float8 tmp = newval * (N + 1.0) - Sx;
+
+		Sxx += tmp * tmp / ((N + 1.0) * N);
+		if (isinf(Sx) || isinf(Sxx))
+		{
+			if (!isinf(agg->fval) && !isinf(newval))
+				float_overflow();
+
+			Sxx = get_float8_nan();
+		}
+	}
+	else if (isnan(newval) || isinf(newval))
+		Sxx = get_float8_nan();
+
+	agg->count++;
+	agg->fval = Sx;
+	agg->sxx = Sxx;
+	agg->has_value = true;
+}
+
+/*
+ * Accumulate the values of a float column. The values are added one by one in
+ * the row order, with the same overflow checks and NaN handling as float8pl,
+ * float8smaller and float8larger.
+ */
+static void
+accumulate_float8(VectorAggColumn *agg, const float8 *restrict values, const uint64 *restrict mask,
+				  int first_row, int end_row)
+{
+	for (int row = first_row; row < end_row; row++)
+	{
+		float8 value;
+
+		if (!ROW_PASSES(mask, row))
+			continue;
+
+		value = values[row];
+		switch (agg->func)
+		{
+			case VAF_SUM:
+				if (agg->has_value)
+				{
+					float8 sum = agg->fval + value;
+
+					if (unlikely(isinf(sum)) && !isinf(agg->fval) && !isinf(value))
+						float_overflow();
+					value = sum;
+				}
+				break;
+			case VAF_MIN:
+				if (agg->has_value && !float8_lt(value, agg->fval))
+					value = agg->fval;
+				break;
+			case VAF_MAX:
+				if (agg->has_value && !float8_gt(value, agg->fval))
+					value = agg->fval;
+				break;
+			case VAF_AVG:
+				float8_accum_value(agg, value);
+				continue;
+			default:
+				Assert(false);
+				break;
+		}
+
+		agg->fval = value;
+		agg->count++;
+		agg->has_value = true;
+	}
+}
+
+static void
+accumulate_float4(VectorAggColumn *agg, const float4 *restrict values, const uint64 *restrict mask,
+				  int first_row, int end_row)
+{
+	if (agg->func != VAF_SUM)
+	{
+		/* float4 values are compared and averaged as float8 */
+		for (int row = first_row; row < end_row; row++)
+		{
+			float8 value = values[row];
+
+			if (ROW_PASSES(mask, row))
+				accumulate_float8(agg, &value, NULL, 0, 1);
+		}
+		return;
+	}
+
+	/* the sum is computed in float4, like float4pl does */
+	for (int row = first_row; row < end_row; row++)
+	{
+		float4 value;
+
+		if (!ROW_PASSES(mask, row))
+			continue;
+
+		value = values[row];
+		if (agg->has_value)
+		{
+			float4 sum = agg->f4val + value;
+
+			if (unlikely(isinf(sum)) && !isinf(agg->f4val) && !isinf(value))
+				float_overflow();
+			value = sum;
+		}
+
+		agg->f4val = value;
+		agg->count++;
+		agg->has_value = true;
+	}
+}
+
+/*
+ * Count the values into the histogram buckets. The bucket is computed inline
+ * and the loop has no other branches than the row filters, so it runs at the
+ * speed of reading the column. A NULL value is counted as 0, the same as the
+ * row-by-row transition function does.
+ */
+static void
+accumulate_histogram(VectorAggColumn *agg, const float8 *restrict values,
+					 const uint64 *restrict validity, const uint64 *restrict mask, int first_row,
+					 int end_row)
+{
+	int32 *restrict counts = agg->hist_counts;
+	const float8 min = agg->hist_min;
+	const float8 max = agg->hist_max;
+	const int32 nbuckets = agg->hist_nbuckets;
+
+	ts_histogram_check_args(min, max, nbuckets);
+
+	for (int row = first_row; row < end_row; row++)
+	{
+		int32 bucket;
+
+		if (!ROW_PASSES(mask, row))
+			continue;
+
+		bucket = ts_histogram_bucket(ROW_PASSES(validity, row) ? values[row] : 0.0,
+									 min,
+									 max,
+									 nbuckets);
+		if (unlikely(counts[bucket] >= PG_INT32_MAX - 1))
+			elog(ERROR, "overflow in histogram");
+
+		counts[bucket]++;
+		agg->has_value = true;
+	}
+}
+
+static void
+accumulate_datum(VectorAggColumn *agg, Datum value, bool isnull)
+{
+	if (agg->func == VAF_COUNT_STAR)
+	{
+		agg->count++;
+		return;
+	}
+
+	if (agg->func == VAF_HISTOGRAM)
+	{
+		float8 v = isnull ? 0.0 : DatumGetFloat8(value);
+
+		accumulate_histogram(agg, &v, NULL, NULL, 0, 1);
+		return;
+	}
+
+	if (isnull)
+		return;
+
+	switch (agg->argtype)
+	{
+		case VAA_NONE:
+			agg->count++;
+			break;
+		case VAA_INT16:
+		{
+			int16 v = DatumGetInt16(value);
+			accumulate_int16(agg, &v, NULL, 0, 1);
+			break;
+		}
+		case VAA_INT32:
+		{
+			int32 v = DatumGetInt32(value);
+			accumulate_int32(agg, &v, NULL, 0, 1);
+			break;
+		}
+		case VAA_INT64:
+		{
+			int64 v = DatumGetInt64(value);
+			accumulate_int64(agg, &v, NULL, 0, 1);
+			break;
+		}
+		case VAA_FLOAT4:
+		{
+			float4 v = DatumGetFloat4(value);
+			accumulate_float4(agg, &v, NULL, 0, 1);
+			break;
+		}
+		case VAA_FLOAT8:
+		{
+			float8 v = DatumGetFloat8(value);
+			accumulate_float8(agg, &v, NULL, 0, 1);
+			break;
+		}
+	}
+}
+
+static int
+count_rows(const uint64 *mask, int first_row, int end_row)
+{
+	int count = 0;
+
+	if (end_row <= first_row)
+		return 0;
+
+	if (mask == NULL)
+		return end_row - first_row;
+
+	for (int i = first_row / 64; i <= (end_row - 1) / 64; i++)
+	{
+		uint64 word = mask[i];
+
+		if (i == first_row / 64)
+			word &= ~UINT64CONST(0) << (first_row % 64);
+		if (i == (end_row - 1) / 64 && end_row % 64 != 0)
+			word &= (UINT64CONST(1) << (end_row % 64)) - 1;
+
+		count += pg_popcount64(word);
+	}
+
+	return count;
+}
+
+/*
+ * The rows of the batch to aggregate: the ones that passed the vector quals
+ * and are not null. NULL means all rows.
+ */
+static const uint64 *
+build_row_mask(VectorAggState *state, const uint64 *validity)
+{
+	int n_words = (state->batch_rows + 63) / 64;
+
+	if (validity == NULL)
+		return state->batch_filter;
+
+	if (state->batch_filter == NULL)
+		return validity;
+
+	if (state->mask_buffer_words < n_words)
+	{
+		state->mask_buffer = MemoryContextAlloc(state->csstate.ss.ps.state->es_query_cxt,
+												sizeof(uint64) * n_words);
+		state->mask_buffer_words = n_words;
+	}
+
+	for (int i = 0; i < n_words; i++)
+		state->mask_buffer[i] = state->batch_filter[i] & validity[i];
+
+	return state->mask_buffer;
+}
+
+static void
+accumulate_batch(VectorAggState *state, VectorAggColumn *agg)
+{
+	const DecompressedColumn *input = agg->batch_input.values;
+	const uint64 *mask;
+
+	if (agg->func == VAF_COUNT_STAR)
+	{
+		agg->count += count_rows(state->batch_filter, state->first_row, state->end_row);
+		return;
+	}
+
+	if (input == NULL)
+	{
+		/* segmentby or missing column, the value is the same for all rows */
+		int n_rows = count_rows(state->batch_filter, state->first_row, state->end_row);
+
+		for (int i = 0; i < n_rows; i++)
+			accumulate_datum(agg, agg->batch_input.scalar_value, agg->batch_input.scalar_isnull);
+		return;
+	}
+
+	if (agg->func == VAF_HISTOGRAM)
+	{
+		accumulate_histogram(agg,
+							 input->values,
+							 input->null_count > 0 ? input->validity : NULL,
+							 state->batch_filter,
+							 state->first_row,
+							 state->end_row);
+		return;
+	}
+
+	mask = build_row_mask(state, input->null_count > 0 ? input->validity : NULL);
+
+	switch (agg->argtype)
+	{
+		case VAA_NONE:
+			agg->count += count_rows(mask, state->first_row, state->end_row);
+			break;
+		case VAA_INT16:
+			accumulate_int16(agg, input->values, mask, state->first_row, state->end_row);
+			break;
+		case VAA_INT32:
+			accumulate_int32(agg, input->values, mask, state->first_row, state->end_row);
+			break;
+		case VAA_INT64:
+			accumulate_int64(agg, input->values, mask, state->first_row, state->end_row);
+			break;
+		case VAA_FLOAT4:
+			accumulate_float4(agg, input->values, mask, state->first_row, state->end_row);
+			break;
+		case VAA_FLOAT8:
+			accumulate_float8(agg, input->values, mask, state->first_row, state->end_row);
+			break;
+	}
+}
+
+/*
+ * Produce the partial aggregate state, in the format of the transition state
+ * of the respective Postgres aggregate.
+ */
+static Datum
+finalize_partial(VectorAggColumn *agg, bool *isnull)
+{
+	*isnull = false;
+
+	switch (agg->func)
+	{
+		case VAF_COUNT_STAR:
+		case VAF_COUNT:
+			return Int64GetDatum(agg->count);
+		case VAF_AVG:
+			if (agg->argtype == VAA_FLOAT4 || agg->argtype == VAA_FLOAT8)
+			{
+				Datum transdatums[3] = {
+					Float8GetDatum((float8) agg->count),
+					Float8GetDatum(agg->fval),
+					Float8GetDatum(agg->sxx),
+				};
+
+				return PointerGetDatum(construct_array(transdatums,
+													   3,
+													   FLOAT8OID,
+													   sizeof(float8),
+													   FLOAT8PASSBYVAL,
+													   TYPALIGN_DOUBLE));
+			}
+			else
+			{
+				Datum transdatums[2] = {
+					Int64GetDatum(agg->count),
+					Int64GetDatum(agg->ival),
+				};
+
+				return PointerGetDatum(construct_array(transdatums,
+													   2,
+													   INT8OID,
+													   sizeof(int64),
+													   FLOAT8PASSBYVAL,
+													   TYPALIGN_DOUBLE));
+			}
+		case VAF_HISTOGRAM:
+			if (!agg->has_value)
+				break;
+
+			/* the partial histogram is in the serialized form */
+			return PointerGetDatum(
+				ts_histogram_serialize_counts(agg->hist_counts, agg->hist_nbuckets + 2));
+		default:
+			break;
+	}
+
+	if (!agg->has_value)
+	{
+		*isnull = true;
+		return (Datum) 0;
+	}
+
+	switch (agg->argtype)
+	{
+		case VAA_INT16:
+			return agg->func == VAF_SUM ? Int64GetDatum(agg->ival) : Int16GetDatum(agg->ival);
+		case VAA_INT32:
+			return agg->func == VAF_SUM ? Int64GetDatum(agg->ival) : Int32GetDatum(agg->ival);
+		case VAA_INT64:
+			return Int64GetDatum(agg->ival);
+		case VAA_FLOAT4:
+			return agg->func == VAF_SUM ? Float4GetDatum(agg->f4val) : Float4GetDatum(agg->fval);
+		case VAA_FLOAT8:
+			return Float8GetDatum(agg->fval);
+		case VAA_NONE:
+			break;
+	}
+
+	pg_unreachable();
+}
+
+static int64
+compute_bucket(const VectorAggColumn *column, int64 value)
+{
+	int64 result;
+
+	ts_time_bucket_int64_array(column->bucket_type,
+							   column->bucket_period,
+							   column->bucket_shift,
+							   &value,
+							   1,
+							   &result);
+	return result;
+}
+
+static inline bool
+row_is_null(const DecompressedColumn *column, int row)
+{
+	return column->null_count > 0 &&
+		   (column->validity[row / 64] & (UINT64CONST(1) << (row % 64))) == 0;
+}
+
+/*
+ * Compute the buckets of the rows of a new batch. The batches are sorted by
+ * the time column, so when the first and the last row are in the same bucket,
+ * all the rows are.
+ */
+static void
+compute_batch_buckets(VectorAggState *state)
+{
+	VectorAggColumn *column = state->bucket_column;
+	const DecompressedColumn *input = column->batch_input.values;
+
+	state->end_row = 0;
+	state->single_bucket = true;
+
+	if (input == NULL)
+	{
+		/* missing column, the value is the same for all rows */
+		column->bucket_isnull = column->batch_input.scalar_isnull;
+		if (!column->bucket_isnull)
+			column->bucket = compute_bucket(column, DatumGetInt64(column->batch_input.scalar_value));
+		return;
+	}
+
+	if (input->null_count == 0 && input->length > 0)
+	{
+		const int64 *values = input->values;
+		int64 first = compute_bucket(column, values[0]);
+
+		if (first == compute_bucket(column, values[input->length - 1]))
+		{
+			column->bucket = first;
+			column->bucket_isnull = false;
+			return;
+		}
+	}
+
+	if (state->buckets_size < input->length)
+	{
+		if (state->buckets != NULL)
+			pfree(state->buckets);
+		state->buckets = MemoryContextAlloc(state->csstate.ss.ps.state->es_query_cxt,
+											sizeof(int64) * input->length);
+		state->buckets_size = input->length;
+	}
+
+	ts_time_bucket_int64_array(column->bucket_type,
+							   column->bucket_period,
+							   column->bucket_shift,
+							   input->values,
+							   input->length,
+							   state->buckets);
+	state->single_bucket = false;
+}
+
+/*
+ * Advance to the next run of rows of the current batch that are in the same
+ * bucket, skipping the runs where no rows pass the vector quals. Returns false
+ * at the end of the batch.
+ */
+static bool
+next_bucket_run(VectorAggState *state)
+{
+	VectorAggColumn *column = state->bucket_column;
+	const DecompressedColumn *input = column->batch_input.values;
+
+	while (state->end_row < state->batch_rows)
+	{
+		state->first_row = state->end_row;
+
+		if (state->single_bucket)
+			state->end_row = state->batch_rows;
+		else
+		{
+			int row = state->first_row;
+			bool isnull = row_is_null(input, row);
+			int64 bucket = state->buckets[row];
+
+			for (row++; row < state->batch_rows; row++)
+			{
+				if (row_is_null(input, row) != isnull || (!isnull && state->buckets[row] != bucket))
+					break;
+			}
+
+			state->end_row = row;
+			column->bucket = bucket;
+			column->bucket_isnull = isnull;
+		}
+
+		if (count_rows(state->batch_filter, state->first_row, state->end_row) > 0)
+			return true;
+	}
+
+	return false;
+}
+
+static bool
+next_input(VectorAggState *state)
+{
+	PlanState *child = linitial(state->csstate.custom_ps);
+
+	if (!state->batch_mode)
+	{
+		state->input_slot = ExecProcNode(child);
+		return !TupIsNull(state->input_slot);
+	}
+
+	/* the next bucket of the current batch */
+	if (state->bucket_column != NULL && next_bucket_run(state))
+		return true;
+
+	while (true)
+	{
+		state->batch_rows = decompress_chunk_next_batch(child, &state->batch_filter);
+		if (state->batch_rows < 0)
+			return false;
+
+		state->first_row = 0;
+		state->end_row = state->batch_rows;
+
+		for (int i = 0; i < state->num_columns; i++)
+		{
+			VectorAggColumn *column = &state->columns[i];
+
+			if (column->input_attno == InvalidAttrNumber)
+				continue;
+
+			decompress_chunk_batch_column(child, column->input_attno, &column->batch_input);
+
+			if (!column->is_aggregate && !column->is_bucket &&
+				column->batch_input.values != NULL)
+				elog(ERROR, "VectorAgg grouping column is not a segmentby column");
+		}
+
+		if (state->bucket_column == NULL)
+			return true;
+
+		compute_batch_buckets(state);
+		if (next_bucket_run(state))
+			return true;
+	}
+}
+
+static Datum
+get_group_input(VectorAggState *state, VectorAggColumn *column, bool *isnull)
+{
+	Datum value;
+
+	if (column->is_bucket)
+	{
+		if (state->batch_mode)
+		{
+			*isnull = column->bucket_isnull;
+			return Int64GetDatum(column->bucket);
+		}
+
+		value = slot_getattr(state->input_slot, column->input_resno, isnull);
+		return *isnull ? (Datum) 0 : Int64GetDatum(compute_bucket(column, DatumGetInt64(value)));
+	}
+
+	if (state->batch_mode)
+	{
+		*isnull = column->batch_input.scalar_isnull;
+		return column->batch_input.scalar_value;
+	}
+
+	return slot_getattr(state->input_slot, column->input_resno, isnull);
+}
+
+static bool
+input_matches_group(VectorAggState *state)
+{
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		VectorAggColumn *column = &state->columns[i];
+		Datum value;
+		bool isnull;
+
+		if (column->is_aggregate)
+			continue;
+
+		value = get_group_input(state, column, &isnull);
+
+		/*
+		 * Binary comparison is enough here, equal values with different
+		 * representations only produce more partial rows.
+		 */
+		if (isnull != column->group_isnull)
+			return false;
+
+		if (!isnull &&
+			!datumIsEqual(value, column->group_value, column->typbyval, column->typlen))
+			return false;
+	}
+
+	return true;
+}
+
+static void
+start_group(VectorAggState *state)
+{
+	MemoryContext old_context;
+
+	MemoryContextReset(state->group_context);
+	old_context = MemoryContextSwitchTo(state->group_context);
+
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		VectorAggColumn *column = &state->columns[i];
+
+		if (column->is_aggregate)
+		{
+			column->count = 0;
+			column->has_value = false;
+			column->ival = 0;
+			column->fval = 0;
+			column->f4val = 0;
+			column->sxx = 0;
+			if (column->func == VAF_HISTOGRAM)
+				column->hist_counts =
+					palloc0(sizeof(int32) * ((Size) Max(column->hist_nbuckets, 0) + 2));
+			continue;
+		}
+
+		column->group_value = get_group_input(state, column, &column->group_isnull);
+		if (!column->group_isnull)
+			column->group_value =
+				datumCopy(column->group_value, column->typbyval, column->typlen);
+	}
+
+	MemoryContextSwitchTo(old_context);
+	state->have_group = true;
+}
+
+static void
+accumulate_input(VectorAggState *state)
+{
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		VectorAggColumn *column = &state->columns[i];
+
+		if (!column->is_aggregate)
+			continue;
+
+		if (state->batch_mode)
+			accumulate_batch(state, column);
+		else if (column->func == VAF_COUNT_STAR)
+			column->count++;
+		else
+		{
+			bool isnull;
+			Datum value = slot_getattr(state->input_slot, column->input_resno, &isnull);
+
+			accumulate_datum(column, value, isnull);
+		}
+	}
+}
+
+/*
+ * Form the partial aggregate tuple of the current group. The values are
+ * allocated in the per-tuple memory, so that the group context can be reused
+ * for the next group.
+ */
+static TupleTableSlot *
+emit_group(VectorAggState *state)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	TupleTableSlot *slot = state->csstate.ss.ss_ScanTupleSlot;
+	MemoryContext old_context = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	ExecClearTuple(slot);
+
+	for (int i = 0; i < state->num_columns; i++)
+	{
+		VectorAggColumn *column = &state->columns[i];
+
+		if (column->is_aggregate)
+			slot->tts_values[i] = finalize_partial(column, &slot->tts_isnull[i]);
+		else
+		{
+			slot->tts_isnull[i] = column->group_isnull;
+			slot->tts_values[i] =
+				column->group_isnull ?
+					(Datum) 0 :
+					datumCopy(column->group_value, column->typbyval, column->typlen);
+		}
+	}
+
+	MemoryContextSwitchTo(old_context);
+	ExecStoreVirtualTuple(slot);
+	state->have_group = false;
+
+	if (state->cache_collecting)
+	{
+		old_context = MemoryContextSwitchTo(state->cache_context);
+		state->cache_tuples = lappend(state->cache_tuples, ExecCopySlotMinimalTuple(slot));
+		MemoryContextSwitchTo(old_context);
+	}
+
+	if (state->csstate.ss.ps.ps_ProjInfo == NULL)
+		return slot;
+
+	econtext->ecxt_scantuple = slot;
+	return ExecProject(state->csstate.ss.ps.ps_ProjInfo);
+}
+
+/*
+ * Look up the partial aggregates of the compressed data that the snapshot of
+ * the query sees. When they are not cached, collect the emitted ones to store
+ * them once the input is done.
+ */
+static void
+result_cache_lookup(VectorAggState *state)
+{
+	EState *estate = state->csstate.ss.ps.state;
+	MemoryContext old_context;
+	int32 chunk_id = ts_chunk_get_id_by_relid(state->cache_chunk_relid);
+
+	state->cache_checked = true;
+
+	if (!ts_chunk_get_compressed_data_version(chunk_id,
+											  estate->es_snapshot,
+											  &state->cache_version))
+		return;
+
+	old_context = MemoryContextSwitchTo(state->cache_context);
+	state->cached_tuples = vector_agg_cache_get(state->cache_chunk_relid,
+												state->cache_key,
+												&state->cache_version,
+												&state->cached_ntuples);
+	MemoryContextSwitchTo(old_context);
+
+	state->cached_position = 0;
+	state->cache_collecting = state->cached_tuples == NULL;
+}
+
+static TupleTableSlot *
+emit_cached_group(VectorAggState *state)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	TupleTableSlot *slot = state->csstate.ss.ss_ScanTupleSlot;
+
+	if (state->cached_position >= state->cached_ntuples)
+		return NULL;
+
+	ExecStoreMinimalTuple(state->cached_tuples[state->cached_position++],
+						  state->cached_slot,
+						  false);
+	ExecCopySlot(slot, state->cached_slot);
+
+	if (state->csstate.ss.ps.ps_ProjInfo == NULL)
+		return slot;
+
+	econtext->ecxt_scantuple = slot;
+	return ExecProject(state->csstate.ss.ps.ps_ProjInfo);
+}
+
+static TupleTableSlot *
+vector_agg_exec(CustomScanState *node)
+{
+	VectorAggState *state = (VectorAggState *) node;
+
+	ResetExprContext(node->ss.ps.ps_ExprContext);
+
+	if (state->cache_key != NULL && !state->cache_checked)
+		result_cache_lookup(state);
+
+	if (state->cached_tuples != NULL)
+		return emit_cached_group(state);
+
+	if (state->input_done)
+	{
+		/* only the complete result of the chunk is stored */
+		if (state->cache_collecting)
+		{
+			vector_agg_cache_put(state->cache_chunk_relid,
+								 state->cache_key,
+								 &state->cache_version,
+								 state->cache_tuples);
+			state->cache_collecting = false;
+		}
+		return NULL;
+	}
+
+	while (true)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (!next_input(state))
+		{
+			state->input_done = true;
+
+			/* without grouping, there is one output row even for empty input */
+			if (!state->have_group && !state->has_grouping)
+			{
+				start_group(state);
+				return emit_group(state);
+			}
+
+			if (state->have_group)
+				return emit_group(state);
+
+			return NULL;
+		}
+
+		if (state->have_group && !input_matches_group(state))
+		{
+			TupleTableSlot *result = emit_group(state);
+
+			start_group(state);
+			accumulate_input(state);
+			return result;
+		}
+
+		if (!state->have_group)
+			start_group(state);
+
+		accumulate_input(state);
+	}
+}
+
+static void
+vector_agg_rescan(CustomScanState *node)
+{
+	VectorAggState *state = (VectorAggState *) node;
+
+	state->have_group = false;
+	state->input_done = false;
+	state->batch_rows = 0;
+	state->end_row = 0;
+
+	if (state->cache_key != NULL)
+	{
+		state->cache_checked = false;
+		state->cached_tuples = NULL;
+		state->cache_collecting = false;
+		state->cache_tuples = NIL;
+		MemoryContextReset(state->cache_context);
+	}
+
+	ExecReScan(linitial(node->custom_ps));
+}
+
+static void
+vector_agg_end(CustomScanState *node)
+{
+	MemoryContextDelete(((VectorAggState *) node)->group_context);
+	ExecEndNode(linitial(node->custom_ps));
+}
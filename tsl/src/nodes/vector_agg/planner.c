@@ -0,0 +1,345 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Planning of the vectorized aggregation. For an aggregate query over a
+ * hypertable, the aggregation is split into the partial and the final stages,
+ * and the partial aggregation is pushed below the Append of the chunks:
+ *
+ * Finalize Aggregate
+ *   -> Append
+ *        -> Custom Scan (VectorAgg)
+ *             -> Custom Scan (DecompressChunk)
+ *        -> Partial Aggregate
+ *             -> Seq Scan on uncompressed chunk
+ *
+ * The compressed chunks get the VectorAgg node that computes the partial
+ * aggregates from the decompressed batches, the other chunks get the usual
+ * partial aggregation.
+ */
+
+#include <postgres.h>
+#include <miscadmin.h>
+#include <catalog/pg_type.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/pathnodes.h>
+#include <optimizer/appendinfo.h>
+#include <optimizer/cost.h>
+#include <optimizer/optimizer.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/tlist.h>
+#include <utils/lsyscache.h>
+#include <utils/selfuncs.h>
+
+#include "compat/compat.h"
+#include "guc.h"
+#include "import/planner.h"
+#include "nodes/decompress_chunk/decompress_chunk.h"
+#include "nodes/vector_agg/vector_agg.h"
+
+static CustomScanMethods vector_agg_plan_methods = {
+	.CustomName = "VectorAgg",
+	.CreateCustomScanState = tsl_vector_agg_state_create,
+};
+
+void
+_vector_agg_init(void)
+{
+	TryRegisterCustomScanMethods(&vector_agg_plan_methods);
+}
+
+/*
+ * The VectorAgg node produces the partial aggregates itself, so both its
+ * custom scan tlist and the output tlist are the partial grouping target.
+ * The output tlist is rewritten to reference the custom scan tlist by setrefs.
+ */
+static Plan *
+vector_agg_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *best_path, List *tlist,
+					   List *clauses, List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+
+	Assert(list_length(custom_plans) == 1);
+
+	cscan->flags = best_path->flags;
+	cscan->methods = &vector_agg_plan_methods;
+	cscan->scan.scanrelid = 0;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->custom_scan_tlist = copyObject(tlist);
+	cscan->custom_plans = custom_plans;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods vector_agg_path_methods = {
+	.CustomName = "VectorAgg",
+	.PlanCustomPath = vector_agg_plan_create,
+};
+
+/*
+ * Check that the partial grouping target consists only of the grouping
+ * columns, at most one time_bucket over a column, and the aggregates we can
+ * compute.
+ */
+static bool
+is_supported_partial_target(PathTarget *target, Index relid)
+{
+	ListCell *lc;
+	int i = 0;
+	bool have_bucket = false;
+
+	foreach (lc, target->exprs)
+	{
+		Expr *expr = lfirst(lc);
+		Index sgref = get_pathtarget_sortgroupref(target, i++);
+
+		if (IsA(expr, Aggref))
+		{
+			Aggref *aggref = castNode(Aggref, expr);
+
+			if (!tsl_vector_agg_aggref_supported(aggref))
+				return false;
+		}
+		else if (IsA(expr, Var))
+		{
+			Var *var = castNode(Var, expr);
+
+			if (sgref == 0 || (Index) var->varno != relid || var->varattno <= 0)
+				return false;
+		}
+		else if (IsA(expr, FuncExpr))
+		{
+			AttrNumber attno;
+
+			if (sgref == 0 || have_bucket || !tsl_vector_agg_time_bucket_supported(expr, &attno) ||
+				(Index) lsecond_node(Var, castNode(FuncExpr, expr)->args)->varno != relid)
+				return false;
+
+			have_bucket = true;
+		}
+		else
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * The VectorAgg node can be used for the chunk when all the grouping columns
+ * are segmentby columns, so that the group changes only between the batches.
+ * The time_bucket grouping must be over the first orderby column, so that the
+ * rows of a bucket are consecutive in the batches.
+ */
+static bool
+can_vectorize_child(DecompressChunkPath *path, PathTarget *child_target)
+{
+	ListCell *lc;
+
+	foreach (lc, child_target->exprs)
+	{
+		Expr *expr = lfirst(lc);
+		AttrNumber attno;
+
+		if (IsA(expr, Var) &&
+			!bms_is_member(castNode(Var, expr)->varattno, path->info->chunk_segmentby_attnos))
+			return false;
+
+		if (IsA(expr, FuncExpr) && tsl_vector_agg_time_bucket_supported(expr, &attno) &&
+			!bms_is_member(attno, path->info->chunk_segmentby_attnos))
+		{
+			char *attname = get_attname(path->info->chunk_rte->relid, attno, false);
+			FormData_hypertable_compression *ht_info =
+				get_column_compressioninfo(path->info->hypertable_compression_info, attname);
+
+			if (ht_info->orderby_column_index != 1)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static Path *
+create_vector_agg_path(RelOptInfo *rel, Path *subpath, PathTarget *target, double num_groups)
+{
+	CustomPath *path = makeNode(CustomPath);
+
+	path->path.pathtype = T_CustomScan;
+	path->path.parent = rel;
+	path->path.pathtarget = target;
+	path->path.param_info = NULL;
+	path->path.parallel_aware = false;
+	path->path.parallel_safe = subpath->parallel_safe;
+	path->path.parallel_workers = 0;
+	path->path.rows = num_groups;
+	path->path.pathkeys = NIL;
+
+	/*
+	 * The scan of the child is the same, but we save the cost of forming the
+	 * tuples and of the per-row aggregation.
+	 */
+	path->path.startup_cost = subpath->total_cost;
+	path->path.total_cost = subpath->total_cost + cpu_tuple_cost * num_groups;
+
+	path->flags = 0;
+	path->custom_paths = list_make1(subpath);
+	path->methods = &vector_agg_path_methods;
+
+	return &path->path;
+}
+
+/*
+ * Add the path with the partial aggregation pushed down to the chunks, see
+ * the comment at the top of this file.
+ */
+void
+tsl_vector_agg_paths_add(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel)
+{
+	Query *parse = root->parse;
+	PathTarget *target = root->upper_targets[UPPERREL_GROUP_AGG];
+	PathTarget *partial_target;
+	RelOptInfo *partial_rel;
+	AppendPath *append;
+	AggClauseCosts agg_partial_costs;
+	AggClauseCosts agg_final_costs;
+	List *partial_subpaths = NIL;
+	List *group_exprs;
+	double num_groups = 1;
+	double append_rows = 0;
+	bool have_vector_agg = false;
+	ListCell *lc;
+
+	if (!ts_guc_enable_vectorized_aggregation || !parse->hasAggs || parse->groupingSets != NIL ||
+		root->hasHavingQual)
+		return;
+
+	if (parse->groupClause != NIL && !grouping_is_hashable(parse->groupClause))
+		return;
+
+	if (!IsA(input_rel->cheapest_total_path, AppendPath))
+		return;
+
+	append = castNode(AppendPath, input_rel->cheapest_total_path);
+	if (append->path.parallel_aware || append->path.param_info != NULL ||
+		append->first_partial_path < list_length(append->subpaths))
+		return;
+
+	partial_target = ts_make_partial_grouping_target(root, target);
+	if (!is_supported_partial_target(partial_target, input_rel->relid))
+		return;
+
+	MemSet(&agg_partial_costs, 0, sizeof(AggClauseCosts));
+	MemSet(&agg_final_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs_compat(root,
+								(Node *) partial_target->exprs,
+								AGGSPLIT_INITIAL_SERIAL,
+								&agg_partial_costs);
+	get_agg_clause_costs_compat(root,
+								(Node *) target->exprs,
+								AGGSPLIT_FINAL_DESERIAL,
+								&agg_final_costs);
+
+	foreach (lc, append->subpaths)
+	{
+		Path *subpath = lfirst(lc);
+		RelOptInfo *child_rel = subpath->parent;
+		AppendRelInfo *appinfo;
+		PathTarget *child_target;
+		RelOptInfo *child_partial_rel;
+		double child_groups = 1;
+		Path *child_path;
+
+		if (child_rel->reloptkind != RELOPT_OTHER_MEMBER_REL ||
+			root->append_rel_array[child_rel->relid] == NULL)
+			return;
+
+		appinfo = root->append_rel_array[child_rel->relid];
+		child_target = copy_pathtarget(partial_target);
+		child_target->exprs =
+			(List *) adjust_appendrel_attrs(root, (Node *) child_target->exprs, 1, &appinfo);
+
+		child_partial_rel = fetch_upper_rel(root, UPPERREL_PARTIAL_GROUP_AGG, child_rel->relids);
+		child_partial_rel->reltarget = child_target;
+
+		if (parse->groupClause != NIL)
+		{
+			group_exprs = get_sortgrouplist_exprs(parse->groupClause,
+												  make_tlist_from_pathtarget(child_target));
+			child_groups =
+				estimate_num_groups_compat(root, group_exprs, subpath->rows, NULL, NULL);
+		}
+
+		if (ts_is_decompress_chunk_path(subpath) &&
+			can_vectorize_child((DecompressChunkPath *) subpath, child_target))
+		{
+			child_path = create_vector_agg_path(child_partial_rel,
+												subpath,
+												child_target,
+												child_groups);
+			have_vector_agg = true;
+		}
+		else
+		{
+			child_path = (Path *) create_agg_path(root,
+												  child_partial_rel,
+												  subpath,
+												  child_target,
+												  parse->groupClause != NIL ? AGG_HASHED :
+																			  AGG_PLAIN,
+												  AGGSPLIT_INITIAL_SERIAL,
+												  parse->groupClause,
+												  NIL,
+												  &agg_partial_costs,
+												  child_groups);
+		}
+
+		append_rows += child_path->rows;
+		partial_subpaths = lappend(partial_subpaths, child_path);
+	}
+
+	/* no compressed chunks, the partial aggregation wouldn't help */
+	if (!have_vector_agg)
+		return;
+
+	partial_rel = fetch_upper_rel(root, UPPERREL_PARTIAL_GROUP_AGG, input_rel->relids);
+	partial_rel->reltarget = partial_target;
+
+	append = create_append_path_compat(root,
+									   partial_rel,
+									   partial_subpaths,
+									   NIL,
+									   NIL,
+									   NULL,
+									   0,
+									   false,
+									   NIL,
+									   append_rows);
+
+	if (parse->groupClause != NIL)
+	{
+		group_exprs =
+			get_sortgrouplist_exprs(parse->groupClause, make_tlist_from_pathtarget(target));
+		num_groups = estimate_num_groups_compat(root,
+												group_exprs,
+												input_rel->cheapest_total_path->rows,
+												NULL,
+												NULL);
+	}
+
+	add_path(output_rel,
+			 (Path *) create_agg_path(root,
+									  output_rel,
+									  &append->path,
+									  target,
+									  parse->groupClause != NIL ? AGG_HASHED : AGG_PLAIN,
+									  AGGSPLIT_FINAL_DESERIAL,
+									  parse->groupClause,
+									  NIL,
+									  &agg_final_costs,
+									  num_groups));
+}
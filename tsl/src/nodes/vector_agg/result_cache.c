@@ -0,0 +1,242 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * A backend-local cache of the partial aggregates that VectorAgg computes
+ * over compressed chunks. Dashboards aggregate the same old, rarely changing
+ * chunks over and over, so the partial aggregate rows of a chunk are kept and
+ * returned again by the next VectorAgg with the same aggregates, grouping and
+ * filters over the same compressed data.
+ *
+ * The entries are keyed by the chunk and the text of the aggregated
+ * expressions and quals, and carry the version of the compressed data they
+ * were computed from, see ts_chunk_get_compressed_data_version(). An entry is
+ * only used when the snapshot of the query sees the same version, so DML and
+ * recompression of the chunk make the entry stale even in transactions that
+ * started before the change. The entries of a chunk are also dropped on its
+ * relcache invalidation, e.g., when the chunk is dropped.
+ *
+ * The cache is bounded by timescaledb.vector_agg_cache_size and the least
+ * recently used entries are evicted first.
+ */
+
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <lib/ilist.h>
+#include <utils/hsearch.h>
+#include <utils/inval.h>
+#include <utils/memutils.h>
+
+#include <compat/compat.h>
+#if PG13_GE
+#include <common/hashfn.h>
+#else
+#include <utils/hashutils.h>
+#endif
+#include "guc.h"
+#include "nodes/vector_agg/result_cache.h"
+
+typedef struct VectorAggCacheKey
+{
+	Oid chunk_relid;
+	uint32 key_hash;
+} VectorAggCacheKey;
+
+typedef struct VectorAggCacheEntry
+{
+	VectorAggCacheKey key;
+	/* The full key, to tell apart the keys with the same hash */
+	char *key_text;
+	ChunkCompressedDataVersion version;
+	MinimalTuple *tuples;
+	int ntuples;
+	Size size;
+	dlist_node lru_node;
+} VectorAggCacheEntry;
+
+static MemoryContext result_cache_context = NULL;
+static HTAB *result_cache = NULL;
+/* The most recently used entries first */
+static dlist_head result_cache_lru = DLIST_STATIC_INIT(result_cache_lru);
+static Size result_cache_size = 0;
+static bool result_cache_callback_registered = false;
+
+static void
+result_cache_remove(VectorAggCacheEntry *entry)
+{
+	dlist_delete(&entry->lru_node);
+	result_cache_size -= entry->size;
+
+	for (int i = 0; i < entry->ntuples; i++)
+		pfree(entry->tuples[i]);
+	if (entry->tuples != NULL)
+		pfree(entry->tuples);
+	pfree(entry->key_text);
+
+	hash_search(result_cache, &entry->key, HASH_REMOVE, NULL);
+}
+
+static void
+result_cache_invalidate_callback(Datum arg, Oid relid)
+{
+	HASH_SEQ_STATUS status;
+	VectorAggCacheEntry *entry;
+
+	if (result_cache == NULL)
+		return;
+
+	if (!OidIsValid(relid))
+	{
+		/* all relations are invalidated, e.g., after a sinval queue overflow */
+		hash_destroy(result_cache);
+		MemoryContextReset(result_cache_context);
+		result_cache = NULL;
+		dlist_init(&result_cache_lru);
+		result_cache_size = 0;
+		return;
+	}
+
+	hash_seq_init(&status, result_cache);
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.chunk_relid == relid)
+			result_cache_remove(entry);
+	}
+}
+
+static void
+result_cache_init(void)
+{
+	HASHCTL ctl;
+
+	if (result_cache_context == NULL)
+		result_cache_context =
+			AllocSetContextCreate(TopMemoryContext, "VectorAggResultCache", ALLOCSET_DEFAULT_SIZES);
+
+	if (!result_cache_callback_registered)
+	{
+		CacheRegisterRelcacheCallback(result_cache_invalidate_callback, PointerGetDatum(NULL));
+		result_cache_callback_registered = true;
+	}
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(VectorAggCacheKey);
+	ctl.entrysize = sizeof(VectorAggCacheEntry);
+	ctl.hcxt = result_cache_context;
+	result_cache =
+		hash_create("VectorAggResultCache", 64, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	dlist_init(&result_cache_lru);
+	result_cache_size = 0;
+}
+
+static inline void
+result_cache_key_init(VectorAggCacheKey *key, Oid chunk_relid, const char *key_text)
+{
+	memset(key, 0, sizeof(*key));
+	key->chunk_relid = chunk_relid;
+	key->key_hash = hash_bytes((const unsigned char *) key_text, strlen(key_text));
+}
+
+static inline bool
+result_cache_version_equal(const ChunkCompressedDataVersion *a, const ChunkCompressedDataVersion *b)
+{
+	return ItemPointerEquals((ItemPointer) &a->chunk_tid, (ItemPointer) &b->chunk_tid) &&
+		   a->chunk_xmin == b->chunk_xmin &&
+		   ItemPointerEquals((ItemPointer) &a->size_tid, (ItemPointer) &b->size_tid) &&
+		   a->size_xmin == b->size_xmin;
+}
+
+/*
+ * Return a copy of the cached partial aggregate rows in the current memory
+ * context, or NULL if they are not cached for this version of the compressed
+ * data. An entry for another version is stale, or was computed by a
+ * transaction with a newer snapshot, and is removed either way.
+ */
+MinimalTuple *
+vector_agg_cache_get(Oid chunk_relid, const char *key_text,
+					 const ChunkCompressedDataVersion *version, int *ntuples)
+{
+	VectorAggCacheKey key;
+	VectorAggCacheEntry *entry;
+	MinimalTuple *result;
+
+	if (result_cache == NULL)
+		return NULL;
+
+	result_cache_key_init(&key, chunk_relid, key_text);
+	entry = hash_search(result_cache, &key, HASH_FIND, NULL);
+
+	if (entry == NULL || strcmp(entry->key_text, key_text) != 0)
+		return NULL;
+
+	if (!result_cache_version_equal(&entry->version, version))
+	{
+		result_cache_remove(entry);
+		return NULL;
+	}
+
+	dlist_move_head(&result_cache_lru, &entry->lru_node);
+
+	result = palloc(sizeof(MinimalTuple) * Max(entry->ntuples, 1));
+	for (int i = 0; i < entry->ntuples; i++)
+		result[i] = heap_copy_minimal_tuple(entry->tuples[i]);
+	*ntuples = entry->ntuples;
+
+	return result;
+}
+
+/*
+ * Store the partial aggregate rows computed for a version of the compressed
+ * data, evicting the least recently used entries to stay within
+ * timescaledb.vector_agg_cache_size.
+ */
+void
+vector_agg_cache_put(Oid chunk_relid, const char *key_text,
+					 const ChunkCompressedDataVersion *version, List *tuples)
+{
+	Size limit = (Size) ts_guc_vector_agg_cache_size * 1024;
+	Size size = sizeof(VectorAggCacheEntry) + strlen(key_text) + 1 +
+				sizeof(MinimalTuple) * list_length(tuples);
+	VectorAggCacheKey key;
+	VectorAggCacheEntry *entry;
+	MemoryContext old_context;
+	ListCell *lc;
+	bool found;
+	int i = 0;
+
+	foreach (lc, tuples)
+		size += ((MinimalTuple) lfirst(lc))->t_len;
+
+	if (size > limit)
+		return;
+
+	if (result_cache == NULL)
+		result_cache_init();
+
+	result_cache_key_init(&key, chunk_relid, key_text);
+	entry = hash_search(result_cache, &key, HASH_FIND, &found);
+	if (found)
+		result_cache_remove(entry);
+
+	while (result_cache_size + size > limit && !dlist_is_empty(&result_cache_lru))
+		result_cache_remove(
+			dlist_container(VectorAggCacheEntry, lru_node, dlist_tail_node(&result_cache_lru)));
+
+	entry = hash_search(result_cache, &key, HASH_ENTER, NULL);
+
+	old_context = MemoryContextSwitchTo(result_cache_context);
+	entry->key_text = pstrdup(key_text);
+	entry->version = *version;
+	entry->ntuples = list_length(tuples);
+	entry->tuples = entry->ntuples == 0 ? NULL : palloc(sizeof(MinimalTuple) * entry->ntuples);
+	foreach (lc, tuples)
+		entry->tuples[i++] = heap_copy_minimal_tuple(lfirst(lc));
+	MemoryContextSwitchTo(old_context);
+
+	entry->size = size;
+	dlist_push_head(&result_cache_lru, &entry->lru_node);
+	result_cache_size += size;
+}
@@ -0,0 +1,21 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_TSL_NODES_VECTOR_AGG_RESULT_CACHE_H
+#define TIMESCALEDB_TSL_NODES_VECTOR_AGG_RESULT_CACHE_H
+
+#include <postgres.h>
+#include <access/htup.h>
+#include <nodes/pg_list.h>
+
+#include "chunk.h"
+
+extern MinimalTuple *vector_agg_cache_get(Oid chunk_relid, const char *key,
+										  const ChunkCompressedDataVersion *version,
+										  int *ntuples);
+extern void vector_agg_cache_put(Oid chunk_relid, const char *key,
+								 const ChunkCompressedDataVersion *version, List *tuples);
+
+#endif /* TIMESCALEDB_TSL_NODES_VECTOR_AGG_RESULT_CACHE_H */
@@ -82,6 +82,10 @@ typedef struct FACombineFnMeta
 	FunctionCallInfo deserialfn_fcinfo;
 	FunctionCallInfo internal_deserialfn_fcinfo;
 	FunctionCallInfo combfn_fcinfo;
+	/* deserialfn can fail on partials stored by older versions and needs the repair path */
+	bool deserialfn_repairable;
+	/* buffer reused for every internal deserialization, allocated in the per-query context */
+	StringInfo recv_buf;
 
 } FACombineFnMeta;
 
@@ -224,6 +228,22 @@ zero_fill_bytearray(bytea *serialized_partial, size_t missing_length)
 }
 #endif
 
+/*
+ * Check if sanitize_serialized_partial() can repair partials for the given
+ * deserialize function. For all other functions a failing deserialization is
+ * an error anyway, so there is no need to set up an exception handler per
+ * partial.
+ */
+static bool
+serialized_partial_repairable(Oid deserialfnoid)
+{
+#if PG14_GE
+	return (deserialfnoid == F_NUMERIC_DESERIALIZE) || (deserialfnoid == F_NUMERIC_AVG_DESERIALIZE);
+#else
+	return false;
+#endif
+}
+
 /* Only call this function if the partial is known to be problematic. */
 static bytea *
 sanitize_serialized_partial(Oid deserialfnoid, bytea *serialized_partial)
@@ -267,6 +287,13 @@ inner_agg_deserialize(FACombineFnMeta *combine_meta, bytea *volatile serialized_
 		FC_NULL(deser_fcinfo, 0) = serialized_isnull;
 		deser_fcinfo->isnull = false;
 
+		if (!combine_meta->deserialfn_repairable)
+		{
+			deserialized = FunctionCallInvoke(deser_fcinfo);
+			*deserialized_isnull = deser_fcinfo->isnull;
+			PG_RETURN_DATUM(deserialized);
+		}
+
 		/*
 		 * When an exception is thrown and longjmp() is called, CurrentMemoryContext is potentially
 		 * different than what it was inside the PG_TRY() block below.
@@ -299,9 +326,11 @@ inner_agg_deserialize(FACombineFnMeta *combine_meta, bytea *volatile serialized_
 	else if (!serialized_isnull)
 	{
 		int32 typmod = -1;
-		StringInfo string = makeStringInfo();
+		StringInfo string = combine_meta->recv_buf;
 		FunctionCallInfo internal_deserialfn_fcinfo = combine_meta->internal_deserialfn_fcinfo;
 
+		/* receive functions copy out what they return, so the buffer can be reused */
+		resetStringInfo(string);
 		appendBinaryStringInfo(string,
 							   VARDATA_ANY(serialized_partial),
 							   VARSIZE_ANY_EXHDR(serialized_partial));
@@ -444,9 +473,14 @@ fa_perquery_state_init(FunctionCallInfo fcinfo)
 							 (void *) fa_aggstate,
 							 NULL);
 
+	tstate->combine_meta.deserialfn_repairable = false;
+	tstate->combine_meta.recv_buf = NULL;
+
 	if (OidIsValid(tstate->combine_meta.deserialfnoid)) /* deserial fn not necessary, no need to
 															throw errors if not found */
 	{
+		tstate->combine_meta.deserialfn_repairable =
+			serialized_partial_repairable(tstate->combine_meta.deserialfnoid);
 		fmgr_info_cxt(tstate->combine_meta.deserialfnoid,
 					  &tstate->combine_meta.deserialfn,
 					  qcontext);
@@ -486,6 +520,7 @@ fa_perquery_state_init(FunctionCallInfo fcinfo)
 								 InvalidOid,
 								 NULL,
 								 NULL);
+		tstate->combine_meta.recv_buf = makeStringInfo();
 	}
 	/* initialize finalfn specific state */
 	if (OidIsValid(tstate->final_meta.finalfnoid))
@@ -30,6 +30,7 @@
 #include "nodes/data_node_dispatch.h"
 #include "nodes/data_node_copy.h"
 #include "nodes/gapfill/gapfill.h"
+#include "nodes/vector_agg/vector_agg.h"
 #include "planner.h"
 
 #include <math.h>
@@ -91,6 +92,9 @@ tsl_create_upper_paths_hook(PlannerInfo *root, UpperRelationKind stage, RelOptIn
 		case UPPERREL_GROUP_AGG:
 			if (input_reltype != TS_REL_HYPERTABLE_CHILD)
 				plan_add_gapfill(root, output_rel);
+			if (input_reltype == TS_REL_HYPERTABLE && !dist_ht &&
+				TS_HYPERTABLE_HAS_COMPRESSION_TABLE(ht))
+				tsl_vector_agg_paths_add(root, input_rel, output_rel);
 			break;
 		case UPPERREL_WINDOW:
 			if (IsA(linitial(input_rel->pathlist), CustomPath))
@@ -159,7 +163,8 @@ tsl_set_rel_pathlist_dml(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTbl
 	{
 		ListCell *lc;
 		Chunk *chunk = ts_chunk_get_by_relid(rte->relid, true);
-		if (chunk->fd.compressed_chunk_id > 0)
+		if (chunk->fd.compressed_chunk_id > 0 &&
+			!compress_chunk_dml_is_decompressed_chunk(chunk->table_id))
 		{
 			foreach (lc, rel->pathlist)
 			{
@@ -12,6 +12,7 @@
 #include <pgstat.h>
 #include <fmgr.h>
 #include <utils/lsyscache.h>
+#include <utils/timestamp.h>
 #include <catalog/pg_type.h>
 #include <nodes/pathnodes.h>
 
@@ -20,6 +21,9 @@
 #include <annotations.h>
 #include "async.h"
 #include "connection.h"
+#include "data_format.h"
+#include "guc.h"
+#include "healthcheck.h"
 #include "utils.h"
 
 /**
@@ -47,11 +51,20 @@ typedef struct AsyncRequest
 	AsyncRequestState state;
 	const char *stmt_name;
 	int prep_stmt_params;
+	const char *exec_stmt_name; /* prepared statement to execute instead of
+								 * the SQL, if any */
 	async_response_callback response_cb;
 	void *user_data; /* custom data saved with the request */
 	StmtParams *params;
 	int res_format; /* text or binary */
 	bool is_xact_transition;
+	bool pipelined;			 /* sent in pipeline mode, ends with a sync point */
+	TimestampTz send_time; /* when the request was sent, if tracking response
+							* times */
+	/* time the data node has to produce the first result, or 0 for no limit */
+	int response_timeout_ms;
+	/* when the response timeout expires, if it applies to the request */
+	TimestampTz deadline;
 } AsyncRequest;
 
 typedef struct PreparedStmt
@@ -60,6 +73,7 @@ typedef struct PreparedStmt
 	TSConnection *conn;
 	const char *stmt_name;
 	int n_params;
+	bool cached; /* kept on the connection for reuse after close */
 } PreparedStmt;
 
 /* It is often useful to get the request along with the result in the response */
@@ -137,6 +151,44 @@ async_request_set_state(AsyncRequest *req, AsyncRequestState new_state)
 	req->state = new_state;
 }
 
+static void
+async_request_start_deadline(AsyncRequest *req)
+{
+	if (req->response_timeout_ms > 0)
+		req->deadline =
+			TimestampTzPlusMilliseconds(GetCurrentTimestamp(), req->response_timeout_ms);
+}
+
+/*
+ * Account for the statement and parameters of a request in the network
+ * statistics of its connection.
+ */
+static void
+async_request_count_sent(AsyncRequest *req)
+{
+	TSConnectionNetStats *netstats = remote_connection_net_stats(req->conn);
+	const char *const *values = stmt_params_values(req->params);
+	const int *lengths = stmt_params_lengths(req->params);
+	const int *formats = stmt_params_formats(req->params);
+	int nvalues = stmt_params_total_values(req->params);
+
+	if (req->exec_stmt_name == NULL)
+		netstats->bytes_sent += strlen(req->sql);
+
+	for (int i = 0; i < nvalues; i++)
+	{
+		if (values[i] == NULL)
+			continue;
+
+		if (formats != NULL && formats[i] == FORMAT_BINARY)
+			netstats->bytes_sent += lengths[i];
+		else
+			netstats->bytes_sent += strlen(values[i]);
+	}
+
+	netstats->round_trips++;
+}
+
 /* Send a request. In case there is an ongoing request for the connection,
    we will not send the request but set its status to DEFERRED.
    Getting a response from DEFERRED AsyncRequest will try sending it if
@@ -148,18 +200,31 @@ async_request_set_state(AsyncRequest *req, AsyncRequestState new_state)
    statements. In the future we can use a `PQsendQuery` variant for queries without parameters,
    which can support multiple statements because it uses the simple protocol. But this is
    an optimization for another time.
+
+   If the connection is in pipeline mode, the request is always sent, even if
+   other requests are in flight on the connection. Their responses must be
+   read in the order the requests were sent, so all pipelined requests on a
+   connection should be added to the same AsyncRequestSet in that order.
 */
 static AsyncRequest *
 async_request_send_internal(AsyncRequest *req, int elevel)
 {
+	bool pipelined = remote_connection_is_pipelined(req->conn);
+
 	if (req->state != DEFERRED)
 		elog(elevel, "can't send async request in state \"%d\"", req->state);
 
-	if (remote_connection_is_processing(req->conn))
+	/* Make room for the request if a prefetch is in flight on the connection */
+	if (!pipelined)
+		remote_connection_complete_prefetch(req->conn);
+
+	if (remote_connection_is_processing(req->conn) && !pipelined)
 		return req;
 
-	/* Send configuration parameters if necessary */
-	remote_connection_configure_if_changed(req->conn);
+	/* Send configuration parameters if necessary. This is done before
+	 * entering pipeline mode, which does not allow synchronous commands. */
+	if (!pipelined)
+		remote_connection_configure_if_changed(req->conn);
 
 	if (req->stmt_name)
 	{
@@ -184,6 +249,20 @@ async_request_send_internal(AsyncRequest *req, int elevel)
 			return NULL;
 		}
 	}
+	else if (req->exec_stmt_name)
+	{
+		if (0 == PQsendQueryPrepared(remote_connection_get_pg_conn(req->conn),
+									 req->exec_stmt_name,
+									 stmt_params_total_values(req->params),
+									 stmt_params_values(req->params),
+									 stmt_params_lengths(req->params),
+									 stmt_params_formats(req->params),
+									 req->res_format))
+		{
+			remote_connection_elog(req->conn, elevel);
+			return NULL;
+		}
+	}
 	else
 	{
 		if (0 == PQsendQueryParams(remote_connection_get_pg_conn(req->conn),
@@ -203,8 +282,39 @@ async_request_send_internal(AsyncRequest *req, int elevel)
 			return NULL;
 		}
 	}
+
+	async_request_count_sent(req);
+
+#ifdef LIBPQ_HAS_PIPELINING
+	if (pipelined)
+	{
+		/*
+		 * End each pipelined request with a sync point. This makes the data
+		 * node send the results without waiting for more requests and keeps
+		 * an error from aborting the requests that follow.
+		 */
+		if (0 == PQpipelineSync(remote_connection_get_pg_conn(req->conn)))
+		{
+			remote_connection_elog(req->conn, elevel);
+			return NULL;
+		}
+
+		req->pipelined = true;
+		async_request_set_state(req, EXECUTING);
+		remote_connection_pipeline_request_sent(req->conn);
+		async_request_start_deadline(req);
+		return req;
+	}
+#endif
+
 	async_request_set_state(req, EXECUTING);
 	remote_connection_set_status(req->conn, CONN_PROCESSING);
+
+	if (ts_guc_enable_replica_load_balancing)
+		req->send_time = GetCurrentTimestamp();
+
+	async_request_start_deadline(req);
+
 	return req;
 }
 
@@ -250,6 +360,7 @@ async_request_send_prepared_stmt(PreparedStmt *stmt, const char *const *param_va
 							 stmt_params_create_from_values((const char **) param_values,
 															stmt->n_params),
 							 FORMAT_TEXT);
+	req->exec_stmt_name = stmt->stmt_name;
 	return async_request_send_internal(req, ERROR);
 }
 
@@ -258,6 +369,7 @@ async_request_send_prepared_stmt_with_params(PreparedStmt *stmt, StmtParams *par
 {
 	AsyncRequest *req =
 		async_request_create(stmt->conn, stmt->sql, NULL, stmt->n_params, params, res_format);
+	req->exec_stmt_name = stmt->stmt_name;
 	return async_request_send_internal(req, ERROR);
 }
 
@@ -269,6 +381,21 @@ async_request_attach_user_data(AsyncRequest *req, void *user_data)
 	req->user_data = user_data;
 }
 
+/*
+ * Fail the request if the data node does not produce a first result within
+ * the given time, instead of waiting for the statement timeout. The data node
+ * is then marked unresponsive so that replicated chunks are scanned on other
+ * data nodes for a while.
+ */
+void
+async_request_set_response_timeout(AsyncRequest *req, int timeout_ms)
+{
+	req->response_timeout_ms = timeout_ms;
+
+	if (req->state == EXECUTING)
+		async_request_start_deadline(req);
+}
+
 void
 async_request_set_response_callback(AsyncRequest *req, async_response_callback cb, void *user_data)
 {
@@ -285,6 +412,21 @@ async_response_result_create(AsyncRequest *req, PGresult *res)
 	if (PQresultStatus(res) == PGRES_SINGLE_TUPLE)
 		type = RESPONSE_ROW;
 
+	/* Track the time until the first result as the response time of the
+	 * data node */
+	if (req->send_time != 0)
+	{
+		long secs;
+		int usecs;
+
+		TimestampDifference(req->send_time, GetCurrentTimestamp(), &secs, &usecs);
+		remote_node_response_time_add(remote_connection_node_name(req->conn),
+									  secs * 1000.0 + usecs / 1000.0);
+		req->send_time = 0;
+	}
+
+	req->deadline = 0;
+
 	ares = palloc0(sizeof(AsyncResponseResult));
 
 	*ares = (AsyncResponseResult){
@@ -334,6 +476,18 @@ async_response_error_create(const char *errmsg)
 	return &ares->base;
 }
 
+static AsyncResponse *
+async_response_deadline_error_create(AsyncRequest *req)
+{
+	const char *node_name = remote_connection_node_name(req->conn);
+
+	remote_node_mark_unresponsive(node_name);
+
+	return async_response_error_create(psprintf("data node \"%s\" did not respond within %d ms",
+												node_name,
+												req->response_timeout_ms));
+}
+
 void
 async_response_result_close(AsyncResponseResult *res)
 {
@@ -532,6 +686,8 @@ async_request_cleanup_result(AsyncRequest *req, TimestampTz endtime)
 	switch (req->state)
 	{
 		case DEFERRED:
+			remote_connection_complete_prefetch(req->conn);
+
 			if (remote_connection_is_processing(req->conn))
 				return async_response_error_create(
 					psprintf("request already in progress on port %d", PostPortNumber));
@@ -600,6 +756,68 @@ async_request_wait_prepared_statement(AsyncRequest *request)
 	return prep;
 }
 
+static void
+prepared_stmt_deallocate(TSConnection *conn, const char *stmt_name)
+{
+	char sql[64] = { '\0' };
+	int ret;
+
+	ret = snprintf(sql, sizeof(sql), "DEALLOCATE %s", stmt_name);
+
+	if (ret < 0 || (size_t) ret >= sizeof(sql))
+		elog(ERROR, "could not create deallocate statement");
+
+	async_request_wait_ok_command(async_request_send(conn, sql));
+}
+
+/*
+ * Get a prepared statement for the given SQL on the connection.
+ *
+ * With timescaledb.enable_prepared_stmt_cache, the statement is kept on the
+ * connection when closed and later calls with the same SQL and number of
+ * parameters reuse it without another round trip to the data node. Otherwise,
+ * a new statement is prepared on every call.
+ */
+PreparedStmt *
+async_request_get_prepared_statement(TSConnection *conn, const char *sql, int n_params)
+{
+	PreparedStmt *prep;
+	const char *stmt_name;
+	char *evicted_name;
+
+	if (!ts_guc_enable_prepared_stmt_cache)
+		return async_request_wait_prepared_statement(
+			async_request_send_prepare(conn, sql, n_params));
+
+	stmt_name = remote_connection_get_cached_prep_stmt(conn, sql, n_params);
+
+	if (stmt_name != NULL)
+	{
+		prep = palloc0(sizeof(PreparedStmt));
+		*prep = (PreparedStmt){
+			.conn = conn,
+			.sql = pstrdup(sql),
+			.stmt_name = pstrdup(stmt_name),
+			.n_params = n_params,
+			.cached = true,
+		};
+
+		return prep;
+	}
+
+	prep = async_request_wait_prepared_statement(async_request_send_prepare(conn, sql, n_params));
+	evicted_name = remote_connection_cache_prep_stmt(conn, sql, n_params, prep->stmt_name);
+	prep->cached = true;
+
+	if (evicted_name != NULL)
+	{
+		prepared_stmt_deallocate(conn, evicted_name);
+		pfree(evicted_name);
+	}
+
+	return prep;
+}
+
 AsyncRequestSet *
 async_request_set_create()
 {
@@ -616,16 +834,24 @@ static AsyncResponse *
 get_single_response_nonblocking(AsyncRequestSet *set)
 {
 	ListCell *lc;
+	List *busy_conns = NIL;
 
 	foreach (lc, set->requests)
 	{
 		AsyncRequest *req = lfirst(lc);
 		PGconn *pg_conn = remote_connection_get_pg_conn(req->conn);
 
+		if (list_member_ptr(busy_conns, req->conn))
+			continue;
+
 		switch (req->state)
 		{
 			case DEFERRED:
-				if (remote_connection_is_processing(req->conn))
+				if (!remote_connection_is_pipelined(req->conn))
+					remote_connection_complete_prefetch(req->conn);
+
+				if (remote_connection_is_processing(req->conn) &&
+					!remote_connection_is_pipelined(req->conn))
 				{
 					return async_response_error_create(
 						psprintf("request already in progress on port %d", PostPortNumber));
@@ -639,10 +865,32 @@ get_single_response_nonblocking(AsyncRequestSet *set)
 				Assert(req->state == EXECUTING);
 				TS_FALLTHROUGH;
 			case EXECUTING:
-				if (0 == PQisBusy(pg_conn))
+				while (0 == PQisBusy(pg_conn))
 				{
 					PGresult *res = PQgetResult(pg_conn);
 
+					if (NULL == res && req->pipelined)
+					{
+						/* The sync point of a pipelined request follows */
+						continue;
+					}
+#ifdef LIBPQ_HAS_PIPELINING
+					if (NULL != res && req->pipelined &&
+						PQresultStatus(res) == PGRES_PIPELINE_SYNC)
+					{
+						/*
+						 * The sync point means the pipelined request is
+						 * complete
+						 */
+						PQclear(res);
+						set->requests = list_delete_ptr(set->requests, req);
+						remote_connection_pipeline_request_done(req->conn);
+						async_request_set_state(req, COMPLETED);
+
+						/* set changed so rerun function */
+						return get_single_response_nonblocking(set);
+					}
+#endif
 					if (NULL == res)
 					{
 						/*
@@ -657,6 +905,13 @@ get_single_response_nonblocking(AsyncRequestSet *set)
 					}
 					return &async_response_result_create(req, res)->base;
 				}
+
+				/*
+				 * The responses of later requests on a pipelined connection
+				 * follow the response of this request, so skip them
+				 */
+				if (req->pipelined)
+					busy_conns = lappend(busy_conns, req->conn);
 				break;
 			case COMPLETED:
 				return async_response_error_create("request already completed");
@@ -686,11 +941,25 @@ wait_to_consume_data(AsyncRequestSet *set, TimestampTz end_time)
 	WaitEvent event;
 	uint32 wait_event_info = PG_WAIT_EXTENSION;
 	AsyncRequest *wait_req;
+	AsyncRequest *deadline_req = NULL;
 	AsyncResponse *result;
 	long timeout_ms = -1L;
+	List *conns = NIL;
 
 	Assert(list_length(set->requests) > 0);
 
+	/* Wait no longer than the earliest response deadline of the requests */
+	foreach (lc, set->requests)
+	{
+		AsyncRequest *req = lfirst(lc);
+
+		if (req->deadline != 0 && (end_time == TS_NO_TIMEOUT || req->deadline < end_time))
+		{
+			end_time = req->deadline;
+			deadline_req = req;
+		}
+	}
+
 	if (end_time != TS_NO_TIMEOUT)
 	{
 		TimestampTz now = GetCurrentTimestamp();
@@ -698,7 +967,8 @@ wait_to_consume_data(AsyncRequestSet *set, TimestampTz end_time)
 		int microsecs;
 
 		if (now >= end_time)
-			return async_response_timeout_create();
+			return deadline_req != NULL ? async_response_deadline_error_create(deadline_req) :
+										  async_response_timeout_create();
 
 		TimestampDifference(now, end_time, &secs, &microsecs);
 		timeout_ms = secs * 1000 + (microsecs / 1000);
@@ -713,6 +983,12 @@ wait_to_consume_data(AsyncRequestSet *set, TimestampTz end_time)
 	{
 		AsyncRequest *req = lfirst(lc);
 
+		/* Pipelined requests can share a connection, so wait on the first
+		 * request of each connection only */
+		if (list_member_ptr(conns, req->conn))
+			continue;
+
+		conns = lappend(conns, req->conn);
 		AddWaitEventToSet(we_set,
 						  WL_SOCKET_READABLE,
 						  PQsocket(remote_connection_get_pg_conn(req->conn)),
@@ -722,12 +998,15 @@ wait_to_consume_data(AsyncRequestSet *set, TimestampTz end_time)
 
 	while (true)
 	{
+		TimestampTz wait_start = GetCurrentTimestamp();
+
 		wait_req = NULL;
 		rc = WaitEventSetWait(we_set, timeout_ms, &event, 1, wait_event_info);
 
 		if (rc == 0)
 		{
-			result = async_response_timeout_create();
+			result = deadline_req != NULL ? async_response_deadline_error_create(deadline_req) :
+											async_response_timeout_create();
 			break;
 		}
 
@@ -755,6 +1034,13 @@ wait_to_consume_data(AsyncRequestSet *set, TimestampTz end_time)
 			wait_req = event.user_data;
 			Assert(wait_req != NULL);
 			PGconn *pg_conn = remote_connection_get_pg_conn(wait_req->conn);
+			long secs;
+			int microsecs;
+
+			/* Attribute the wait to the connection that has data */
+			TimestampDifference(wait_start, GetCurrentTimestamp(), &secs, &microsecs);
+			remote_connection_net_stats(wait_req->conn)->wait_time +=
+				secs * USECS_PER_SEC + microsecs;
 
 			if (0 == PQconsumeInput(pg_conn))
 			{
@@ -780,9 +1066,34 @@ wait_to_consume_data(AsyncRequestSet *set, TimestampTz end_time)
 	}
 
 	FreeWaitEventSet(we_set);
+	list_free(conns);
 	return result;
 }
 
+/*
+ * Wait until the first result of a request can be read without blocking.
+ *
+ * This is for callers that read the results with libpq directly, e.g., for
+ * COPY, so that the response timeout of the request still applies.
+ */
+void
+async_request_wait_readable(AsyncRequest *req)
+{
+	AsyncRequestSet set = { .requests = list_make1(req) };
+	PGconn *pg_conn = remote_connection_get_pg_conn(req->conn);
+
+	while (PQisBusy(pg_conn))
+	{
+		AsyncResponse *rsp = wait_to_consume_data(&set, TS_NO_TIMEOUT);
+
+		if (rsp != NULL)
+			async_response_report_error(rsp, ERROR);
+	}
+
+	req->deadline = 0;
+	list_free(set.requests);
+}
+
 /* Return NULL when nothing more to do in set */
 AsyncResponse *
 async_request_set_wait_any_response_deadline(AsyncRequestSet *set, TimestampTz endtime)
@@ -931,15 +1242,11 @@ async_request_discard_response(AsyncRequest *req)
 void
 prepared_stmt_close(PreparedStmt *stmt)
 {
-	char sql[64] = { '\0' };
-	int ret;
-
-	ret = snprintf(sql, sizeof(sql), "DEALLOCATE %s", stmt->stmt_name);
-
-	if (ret < 0 || (size_t) ret >= sizeof(sql))
-		elog(ERROR, "could not create deallocate statement");
+	/* Cached statements stay on the data node for reuse */
+	if (stmt->cached)
+		return;
 
-	async_request_wait_ok_command(async_request_send(stmt->conn, sql));
+	prepared_stmt_deallocate(stmt->conn, stmt->stmt_name);
 }
 
 /* Request must have been generated by async_request_send_prepare() */
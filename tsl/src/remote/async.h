@@ -98,17 +98,21 @@ extern AsyncRequest *async_request_send_prepared_stmt_with_params(PreparedStmt *
 																  int res_format);
 
 extern void async_request_attach_user_data(AsyncRequest *req, void *user_data);
+extern void async_request_set_response_timeout(AsyncRequest *req, int timeout_ms);
 extern void async_request_set_response_callback(AsyncRequest *req, async_response_callback cb,
 												void *user_data);
 extern bool async_request_set_single_row_mode(AsyncRequest *req);
 extern TSConnection *async_request_get_connection(AsyncRequest *req);
 extern AsyncResponseResult *async_request_wait_ok_result(AsyncRequest *request);
 extern AsyncResponseResult *async_request_wait_any_result(AsyncRequest *request);
+extern void async_request_wait_readable(AsyncRequest *req);
 extern AsyncResponse *async_request_cleanup_result(AsyncRequest *req, TimestampTz endtime);
 
 /* Returns on successful commands, throwing errors otherwise */
 extern void async_request_wait_ok_command(AsyncRequest *req);
 extern PreparedStmt *async_request_wait_prepared_statement(AsyncRequest *request);
+extern PreparedStmt *async_request_get_prepared_statement(TSConnection *conn, const char *sql,
+														 int n_params);
 
 /* Async Response */
 extern void async_response_close(AsyncResponse *res);
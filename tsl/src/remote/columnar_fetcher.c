@@ -0,0 +1,522 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Columnar data fetcher.
+ *
+ * Wraps the remote scan query into an aggregation that groups the result
+ * rows into batches and compresses every column of a batch with the default
+ * compression algorithm for the column type. Each row of the remote result
+ * is thus one batch: a row count followed by one compressed datum per
+ * retrieved column. The batches are decompressed here, using bulk
+ * decompression where the column type allows it, and returned as virtual
+ * tuples.
+ *
+ * This reduces the amount of data transferred for scans that return many
+ * rows of well-compressible columns (e.g., scans over compressed chunks) at
+ * the cost of compression work on the data node.
+ */
+#include <postgres.h>
+#include <access/tupmacs.h>
+#include <port/pg_bswap.h>
+#include <libpq-fe.h>
+
+#include "columnar_fetcher.h"
+#include "compression/compression.h"
+#include "tuplefactory.h"
+#include "async.h"
+
+/* Never put more rows into a batch than compression does for chunks */
+#define COLUMNAR_FETCHER_MAX_BATCH_ROWS 1000
+
+typedef struct ColumnarFetcher
+{
+	DataFetcher state;
+
+	/* Data for virtual tuples of the current retrieved batch. */
+	Datum *batch_values;
+	bool *batch_nulls;
+} ColumnarFetcher;
+
+static void columnar_fetcher_send_fetch_request(DataFetcher *df);
+static void columnar_fetcher_reset(ColumnarFetcher *fetcher);
+static int columnar_fetcher_fetch_data(DataFetcher *df);
+static void columnar_fetcher_set_fetch_size(DataFetcher *df, int fetch_size);
+static void columnar_fetcher_set_tuple_memcontext(DataFetcher *df, MemoryContext mctx);
+static void columnar_fetcher_store_next_tuple(DataFetcher *df, TupleTableSlot *slot);
+static void columnar_fetcher_rescan(DataFetcher *df);
+static void columnar_fetcher_close(DataFetcher *df);
+
+static DataFetcherFuncs funcs = {
+	.send_fetch_request = columnar_fetcher_send_fetch_request,
+	.fetch_data = columnar_fetcher_fetch_data,
+	.set_fetch_size = columnar_fetcher_set_fetch_size,
+	.set_tuple_mctx = columnar_fetcher_set_tuple_memcontext,
+	.store_next_tuple = columnar_fetcher_store_next_tuple,
+	.rewind = columnar_fetcher_rescan,
+	.close = columnar_fetcher_close,
+};
+
+static void
+columnar_fetcher_set_fetch_size(DataFetcher *df, int fetch_size)
+{
+	ColumnarFetcher *fetcher = cast_fetcher(ColumnarFetcher, df);
+
+	data_fetcher_set_fetch_size(&fetcher->state, Min(fetch_size, COLUMNAR_FETCHER_MAX_BATCH_ROWS));
+}
+
+static void
+columnar_fetcher_set_tuple_memcontext(DataFetcher *df, MemoryContext mctx)
+{
+	ColumnarFetcher *fetcher = cast_fetcher(ColumnarFetcher, df);
+	data_fetcher_set_tuple_mctx(&fetcher->state, mctx);
+}
+
+static void
+columnar_fetcher_reset(ColumnarFetcher *fetcher)
+{
+	fetcher->state.open = false;
+	data_fetcher_reset(&fetcher->state);
+}
+
+/*
+ * Build the query that compresses the result of the scan statement in
+ * batches of fetch_size rows. The row numbers keep the order of the scan
+ * statement within and across batches.
+ */
+static char *
+columnar_fetcher_build_query(ColumnarFetcher *fetcher)
+{
+	const int retrieved_natts =
+		list_length(tuplefactory_get_retrieved_attrs(fetcher->state.tf));
+	StringInfoData query;
+	int i;
+
+	initStringInfo(&query);
+	appendStringInfoString(&query, "SELECT count(*)");
+
+	for (i = 1; i <= retrieved_natts; i++)
+		appendStringInfo(&query,
+						 ", _timescaledb_internal.compressed_data_agg(c%d ORDER BY _ts_rn)",
+						 i);
+
+	appendStringInfo(&query,
+					 " FROM (SELECT *, row_number() OVER () AS _ts_rn FROM (%s) AS _ts_q",
+					 fetcher->state.stmt);
+
+	if (retrieved_natts > 0)
+	{
+		appendStringInfoString(&query, "(c1");
+
+		for (i = 2; i <= retrieved_natts; i++)
+			appendStringInfo(&query, ", c%d", i);
+
+		appendStringInfoChar(&query, ')');
+	}
+
+	appendStringInfo(&query,
+					 ") AS _ts_b GROUP BY (_ts_rn - 1) / %d ORDER BY (_ts_rn - 1) / %d",
+					 fetcher->state.fetch_size,
+					 fetcher->state.fetch_size);
+
+	return query.data;
+}
+
+static void
+columnar_fetcher_send_fetch_request(DataFetcher *df)
+{
+	AsyncRequest *volatile req = NULL;
+	MemoryContext oldcontext;
+	ColumnarFetcher *fetcher = cast_fetcher(ColumnarFetcher, df);
+
+	if (fetcher->state.open)
+	{
+		/* data request has already been sent */
+		return;
+	}
+
+	/* make sure to have a clean state */
+	columnar_fetcher_reset(fetcher);
+
+	char *query = columnar_fetcher_build_query(fetcher);
+
+	PG_TRY();
+	{
+		oldcontext = MemoryContextSwitchTo(fetcher->state.req_mctx);
+
+		req = async_request_send_with_stmt_params_elevel_res_format(fetcher->state.conn,
+																	query,
+																	fetcher->state.stmt_params,
+																	ERROR,
+																	FORMAT_BINARY);
+		Assert(NULL != req);
+
+		/*
+		 * Single-row mode makes every batch available as soon as the data
+		 * node has produced it, instead of after the whole result is done.
+		 */
+		if (!async_request_set_single_row_mode(req))
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_CONNECTION_FAILURE),
+					 errmsg("could not set single-row mode on connection to \"%s\"",
+							remote_connection_node_name(fetcher->state.conn)),
+					 errdetail("The aborted statement is: %s.", fetcher->state.stmt),
+					 errhint("Columnar fetcher is not supported together with sub-queries."
+							 " Use cursor fetcher instead.")));
+		}
+
+		fetcher->state.open = true;
+		pfree(req);
+	}
+	PG_CATCH();
+	{
+		if (NULL != req)
+			pfree(req);
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Read the final results of the query after the last batch has been
+ * received, leaving the connection idle.
+ */
+static void
+end_query(ColumnarFetcher *fetcher, PGresult *last_res)
+{
+	PGconn *conn = remote_connection_get_pg_conn(fetcher->state.conn);
+	PGresult *res;
+
+	Assert(fetcher->state.open);
+	remote_result_close(last_res);
+
+	while ((res = PQgetResult(conn)))
+		remote_result_close(res);
+
+	fetcher->state.open = false;
+	remote_connection_set_status(fetcher->state.conn, CONN_IDLE);
+}
+
+/*
+ * Prematurely end the query before all batches are received, e.g., when a
+ * LIMIT was reached.
+ */
+static void
+end_query_before_eof(ColumnarFetcher *fetcher)
+{
+	/*
+	 * The fetcher state might not be open if the fetcher got initialized but
+	 * never executed due to executor constraints.
+	 */
+	if (!fetcher->state.open)
+		return;
+
+	Assert(!fetcher->state.eof);
+	remote_connection_cancel_query(fetcher->state.conn);
+	fetcher->state.open = false;
+}
+
+/*
+ * Decompress one column of a batch into the column of the tuple arrays.
+ */
+static void
+columnar_fetcher_decompress_column(ColumnarFetcher *fetcher, Form_pg_attribute attr, int att,
+								   Datum compressed, int num_rows)
+{
+	const TupleDesc tupdesc = tuplefactory_get_tupdesc(fetcher->state.tf);
+	const int natts = tupdesc->natts;
+	CompressedDataHeader *header = (CompressedDataHeader *) DatumGetPointer(compressed);
+	DecompressAllFunction decompress_all = NULL;
+	int row;
+
+	if (attr->attlen > 0 && attr->attlen <= 8)
+		decompress_all = tsl_get_decompress_all_function(header->compression_algorithm);
+
+	if (decompress_all != NULL)
+	{
+		DecompressedColumn *column = decompress_all(compressed, attr->atttypid);
+
+		if (column->length != num_rows)
+			elog(ERROR,
+				 "wrong number of rows in columnar batch: expected %d, got %d",
+				 num_rows,
+				 column->length);
+
+		for (row = 0; row < num_rows; row++)
+		{
+			if (decompressed_column_is_null(column, row))
+				continue;
+
+			fetcher->batch_values[natts * row + att] =
+				fetch_att((const char *) column->values + (Size) row * column->value_bytes,
+						  attr->attbyval,
+						  attr->attlen);
+			fetcher->batch_nulls[natts * row + att] = false;
+		}
+	}
+	else
+	{
+		DecompressionIterator *iter =
+			tsl_get_decompression_iterator_init(header->compression_algorithm,
+												false)(compressed, attr->atttypid);
+
+		for (row = 0;; row++)
+		{
+			DecompressResult res = iter->try_next(iter);
+
+			if (res.is_done)
+				break;
+
+			if (row >= num_rows)
+				elog(ERROR, "too many rows in columnar batch: expected %d", num_rows);
+
+			if (res.is_null)
+				continue;
+
+			fetcher->batch_values[natts * row + att] = res.val;
+			fetcher->batch_nulls[natts * row + att] = false;
+		}
+
+		if (row != num_rows)
+			elog(ERROR,
+				 "wrong number of rows in columnar batch: expected %d, got %d",
+				 num_rows,
+				 row);
+	}
+}
+
+/*
+ * Process the next batch of the ongoing request.
+ */
+static int
+columnar_fetcher_complete(ColumnarFetcher *fetcher)
+{
+	PGresult *volatile res = NULL;
+	MemoryContext oldcontext;
+	PGconn *conn = remote_connection_get_pg_conn(fetcher->state.conn);
+
+	Assert(fetcher->state.open);
+	data_fetcher_validate(&fetcher->state);
+
+	/*
+	 * We'll store the tuples in the batch_mctx.  First, flush the previous
+	 * batch.
+	 */
+	MemoryContextReset(fetcher->state.batch_mctx);
+	oldcontext = MemoryContextSwitchTo(fetcher->state.batch_mctx);
+	fetcher->batch_values = NULL;
+	fetcher->batch_nulls = NULL;
+
+	PG_TRY();
+	{
+		const TupleDesc tupdesc = tuplefactory_get_tupdesc(fetcher->state.tf);
+		const List *retrieved_attrs = tuplefactory_get_retrieved_attrs(fetcher->state.tf);
+		const int tupdesc_natts = tupdesc->natts;
+		const int retrieved_natts = list_length(retrieved_attrs);
+		int num_rows = 0;
+
+		res = PQgetResult(conn);
+
+		if (res == NULL)
+		{
+			/* Shouldn't really happen but technically possible. */
+			TSConnectionError err;
+			remote_connection_get_error(fetcher->state.conn, &err);
+			remote_connection_error_elog(&err, ERROR);
+		}
+
+		switch (PQresultStatus(res))
+		{
+			case PGRES_SINGLE_TUPLE:
+			{
+				int64 count;
+				int total;
+				int i;
+
+				if (PQnfields(res) != retrieved_natts + 1 || PQntuples(res) != 1)
+					elog(ERROR,
+						 "wrong format of columnar batch: expected %d columns, got %d",
+						 retrieved_natts + 1,
+						 PQnfields(res));
+
+				Assert(PQgetlength(res, 0, 0) == sizeof(int64));
+				memcpy(&count, PQgetvalue(res, 0, 0), sizeof(int64));
+				count = (int64) pg_ntoh64((uint64) count);
+
+				if (count <= 0 || count > fetcher->state.fetch_size)
+					elog(ERROR, "invalid number of rows in columnar batch: " INT64_FORMAT, count);
+
+				num_rows = (int) count;
+				total = tupdesc_natts * num_rows;
+				fetcher->batch_nulls = palloc(sizeof(bool) * total);
+				memset(fetcher->batch_nulls, true, sizeof(bool) * total);
+				fetcher->batch_values = palloc0(sizeof(Datum) * total);
+
+				for (i = 0; i < retrieved_natts; i++)
+				{
+					const int att = list_nth_int(retrieved_attrs, i) - 1;
+					StringInfoData att_data = { 0 };
+					Datum compressed;
+
+					Assert(att >= 0);
+					Assert(att < tupdesc_natts);
+
+					/* A NULL batch means that all values of the column are NULL */
+					if (PQgetisnull(res, 0, i + 1))
+						continue;
+
+					att_data.data = PQgetvalue(res, 0, i + 1);
+					att_data.len = PQgetlength(res, 0, i + 1);
+					att_data.maxlen = att_data.len;
+					compressed =
+						DirectFunctionCall1(tsl_compressed_data_recv, PointerGetDatum(&att_data));
+
+					columnar_fetcher_decompress_column(fetcher,
+													   TupleDescAttr(tupdesc, att),
+													   att,
+													   compressed,
+													   num_rows);
+				}
+
+				remote_result_close(res);
+				res = NULL;
+				break;
+			}
+			case PGRES_TUPLES_OK:
+			{
+				PGresult *last_res = res;
+
+				/* No more batches */
+				res = NULL;
+				fetcher->state.eof = true;
+				end_query(fetcher, last_res);
+				break;
+			}
+			default:
+			{
+				TSConnectionError err;
+				remote_connection_get_result_error(res, &err);
+				remote_connection_error_elog(&err, ERROR);
+				break;
+			}
+		}
+
+		fetcher->state.num_tuples = num_rows;
+		fetcher->state.next_tuple_idx = 0;
+		fetcher->state.batch_count++;
+	}
+	PG_CATCH();
+	{
+		if (NULL != res)
+			remote_result_close(res);
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return fetcher->state.num_tuples;
+}
+
+static int
+columnar_fetcher_fetch_data(DataFetcher *df)
+{
+	ColumnarFetcher *fetcher = cast_fetcher(ColumnarFetcher, df);
+
+	if (fetcher->state.eof)
+		return 0;
+
+	if (!fetcher->state.open)
+		columnar_fetcher_send_fetch_request(df);
+
+	return columnar_fetcher_complete(fetcher);
+}
+
+static void
+columnar_fetcher_store_tuple(DataFetcher *df, int row, TupleTableSlot *slot)
+{
+	ColumnarFetcher *fetcher = cast_fetcher(ColumnarFetcher, df);
+
+	ExecClearTuple(slot);
+
+	if (row >= df->num_tuples)
+	{
+		if (df->eof || df->funcs->fetch_data(df) == 0)
+		{
+			return;
+		}
+
+		row = 0;
+		Assert(row == df->next_tuple_idx);
+	}
+
+	Assert(fetcher->batch_values != NULL);
+	Assert(fetcher->batch_nulls != NULL);
+	Assert(row >= 0 && row < df->num_tuples);
+
+	const int nattrs = tuplefactory_get_nattrs(fetcher->state.tf);
+	slot->tts_values = &fetcher->batch_values[nattrs * row];
+	slot->tts_isnull = &fetcher->batch_nulls[nattrs * row];
+	ExecStoreVirtualTuple(slot);
+}
+
+static void
+columnar_fetcher_store_next_tuple(DataFetcher *df, TupleTableSlot *slot)
+{
+	columnar_fetcher_store_tuple(df, df->next_tuple_idx, slot);
+
+	if (!TupIsNull(slot))
+		df->next_tuple_idx++;
+
+	Assert(df->next_tuple_idx <= df->num_tuples);
+}
+
+DataFetcher *
+columnar_fetcher_create_for_scan(TSConnection *conn, const char *stmt, StmtParams *params,
+								 TupleFactory *tf)
+{
+	ColumnarFetcher *fetcher = palloc0(sizeof(ColumnarFetcher));
+
+	data_fetcher_init(&fetcher->state, conn, stmt, params, tf);
+	fetcher->state.type = ColumnarFetcherType;
+	fetcher->state.funcs = &funcs;
+
+	return &fetcher->state;
+}
+
+static void
+columnar_fetcher_close(DataFetcher *df)
+{
+	ColumnarFetcher *fetcher = cast_fetcher(ColumnarFetcher, df);
+
+	/* If EOF was reached, the query was already ended when reading the last
+	 * batch. */
+	if (!fetcher->state.eof)
+		end_query_before_eof(fetcher);
+
+	Assert(!fetcher->state.open);
+	columnar_fetcher_reset(fetcher);
+}
+
+static void
+columnar_fetcher_rescan(DataFetcher *df)
+{
+	ColumnarFetcher *fetcher = cast_fetcher(ColumnarFetcher, df);
+
+	if (fetcher->state.batch_count > 1)
+	{
+		/* we're over the first batch so we need to close fetcher and restart from clean state */
+		columnar_fetcher_close(df);
+	}
+	else
+		/* we can reuse current batch of results */
+		fetcher->state.next_tuple_idx = 0;
+}
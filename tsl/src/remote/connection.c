@@ -78,6 +78,7 @@ static unsigned int prep_stmt_number = 0;
 static RemoteConnectionStats connstats = { 0 };
 
 static int eventproc(PGEventId eventid, void *eventinfo, void *data);
+static void remote_connection_setup(TSConnection *conn, const char *node_name, bool set_dist_id);
 
 TSConnectionId
 remote_connection_id(const Oid server_oid, const Oid user_oid)
@@ -91,6 +92,7 @@ remote_connection_id_set(TSConnectionId *const id, Oid const server_oid, Oid con
 {
 	id->server_id = server_oid;
 	id->user_id = user_oid;
+	id->channel = 0;
 }
 
 /*
@@ -150,6 +152,26 @@ typedef struct ResultEntry
 	PGresult *result;
 } ResultEntry;
 
+/*
+ * Maximum number of prepared statements kept on a connection for reuse. The
+ * least recently used statement is deallocated when the limit is reached.
+ */
+#define PREPARED_STMT_CACHE_SIZE 64
+
+/*
+ * A statement prepared on the data node that is kept for reuse across
+ * queries and transactions. Prepared statements are session objects that
+ * survive transaction end, so they are valid for the lifetime of the
+ * connection.
+ */
+typedef struct PreparedStmtCacheEntry
+{
+	struct PreparedStmtCacheEntry *next;
+	char *sql;
+	int n_params;
+	char stmt_name[NAMEDATALEN];
+} PreparedStmtCacheEntry;
+
 typedef struct TSConnection
 {
 	ListNode ln;		/* Must be first entry */
@@ -167,6 +189,16 @@ typedef struct TSConnection
 							   * another transaction state */
 	ListNode results;		  /* Head of PGresult list */
 	bool binary_copy;
+	int pipeline_requests; /* Number of requests in flight in pipeline mode */
+	RemoteConnectionPrefetchComplete prefetch_complete; /* Completes the prefetch
+														 * in flight, if any */
+	void *prefetch_arg;
+	bool commit_pending; /* Set if a COMMIT PREPARED is in flight */
+	PreparedStmtCacheEntry *prep_stmts; /* Cached prepared statements, most
+										 * recently used first */
+	int num_prep_stmts;
+	/* Network activity on the connection */
+	TSConnectionNetStats netstats;
 } TSConnection;
 
 /*
@@ -351,6 +383,15 @@ remote_connection_free(TSConnection *conn)
 	if (NULL != conn->tz_name)
 		free(conn->tz_name);
 
+	while (NULL != conn->prep_stmts)
+	{
+		PreparedStmtCacheEntry *entry = conn->prep_stmts;
+
+		conn->prep_stmts = entry->next;
+		free(entry->sql);
+		free(entry);
+	}
+
 	free(conn);
 }
 
@@ -436,6 +477,7 @@ handle_result_create(PGEventResultCreate *event)
 		 entry->subtxid);
 
 	connstats.results_created++;
+	conn->netstats.bytes_received += PQresultMemorySize(event->result);
 
 	return EVENTPROC_SUCCESS;
 }
@@ -864,6 +906,94 @@ remote_connection_get_status(const TSConnection *conn)
 	return conn->status;
 }
 
+/*
+ * Pipeline mode.
+ *
+ * In libpq pipeline mode, several requests can be sent on a connection
+ * before their results are read, which saves a network round trip per
+ * request. The results arrive in the order the requests were sent. The
+ * connection is processing as long as any pipelined request is in flight.
+ *
+ * Pipeline mode needs libpq from PostgreSQL 14 or later.
+ */
+bool
+remote_connection_pipeline_supported(void)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+ * Enter pipeline mode on an idle connection. Returns false if pipeline mode
+ * is not supported.
+ */
+bool
+remote_connection_enter_pipeline_mode(TSConnection *conn)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	if (PQpipelineStatus(conn->pg_conn) != PQ_PIPELINE_OFF)
+		return true;
+
+	Assert(conn->status == CONN_IDLE);
+
+	if (0 == PQenterPipelineMode(conn->pg_conn))
+		remote_connection_elog(conn, ERROR);
+
+	conn->pipeline_requests = 0;
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+ * Leave pipeline mode. All pipelined requests must have completed.
+ */
+void
+remote_connection_exit_pipeline_mode(TSConnection *conn)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	if (PQpipelineStatus(conn->pg_conn) == PQ_PIPELINE_OFF)
+		return;
+
+	Assert(conn->pipeline_requests == 0);
+
+	if (0 == PQexitPipelineMode(conn->pg_conn))
+		remote_connection_elog(conn, ERROR);
+#endif
+}
+
+bool
+remote_connection_is_pipelined(const TSConnection *conn)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	return PQpipelineStatus(conn->pg_conn) != PQ_PIPELINE_OFF;
+#else
+	return false;
+#endif
+}
+
+void
+remote_connection_pipeline_request_sent(TSConnection *conn)
+{
+	Assert(remote_connection_is_pipelined(conn));
+	conn->pipeline_requests++;
+	remote_connection_set_status(conn, CONN_PROCESSING);
+}
+
+void
+remote_connection_pipeline_request_done(TSConnection *conn)
+{
+	Assert(conn->pipeline_requests > 0);
+	conn->pipeline_requests--;
+
+	if (conn->pipeline_requests == 0)
+		remote_connection_set_status(conn, CONN_IDLE);
+}
+
 const char *
 remote_connection_node_name(const TSConnection *conn)
 {
@@ -901,6 +1031,8 @@ remote_connection_exec(TSConnection *conn, const char *cmd)
 {
 	PGresult *res;
 
+	remote_connection_complete_prefetch(conn);
+
 	if (!remote_connection_configure_if_changed(conn))
 	{
 		res = PQmakeEmptyPGresult(conn->pg_conn, PGRES_FATAL_ERROR);
@@ -908,6 +1040,8 @@ remote_connection_exec(TSConnection *conn, const char *cmd)
 		return res;
 	}
 
+	conn->netstats.bytes_sent += strlen(cmd);
+	conn->netstats.round_trips++;
 	res = PQexec(conn->pg_conn, cmd);
 
 	/*
@@ -1422,6 +1556,19 @@ remote_connection_open_with_options(const char *node_name, List *connection_opti
 				 errmsg("could not connect to \"%s\"", node_name),
 				 err == NULL ? 0 : errdetail_internal("%s", err)));
 
+	remote_connection_setup(conn, node_name, set_dist_id);
+
+	return conn;
+}
+
+/*
+ * Prepare a newly opened connection for use.
+ *
+ * The connection is closed if the setup fails.
+ */
+static void
+remote_connection_setup(TSConnection *conn, const char *node_name, bool set_dist_id)
+{
 	/*
 	 * Use PG_TRY block to ensure closing connection on error.
 	 */
@@ -1463,8 +1610,177 @@ remote_connection_open_with_options(const char *node_name, List *connection_opti
 		PG_RE_THROW();
 	}
 	PG_END_TRY();
+}
 
-	return conn;
+/*
+ * Drive the non-blocking connection attempts in pg_conns to completion.
+ *
+ * Each connection attempt has its own state machine (TCP connect, TLS
+ * handshake, authentication), so wait for any of the sockets to become ready
+ * and advance only the attempts that can make progress.
+ */
+static void
+poll_connections(PGconn **pg_conns, const char **node_names, int num_conns)
+{
+	PostgresPollingStatusType *status = palloc(sizeof(PostgresPollingStatusType) * num_conns);
+	WaitEvent *occurred = palloc(sizeof(WaitEvent) * (num_conns + 2));
+	int num_pending = num_conns;
+	int i;
+
+	/* As documented for PQconnectStartParams, start as if the last poll
+	 * returned PGRES_POLLING_WRITING */
+	for (i = 0; i < num_conns; i++)
+		status[i] = PGRES_POLLING_WRITING;
+
+	while (num_pending > 0)
+	{
+		/* The socket of a connection can change while it is being
+		 * established (e.g., when trying several hosts), so recreate the wait
+		 * event set on every iteration. */
+		WaitEventSet *set = CreateWaitEventSet(CurrentMemoryContext, num_pending + 2);
+		int num_events;
+
+		(void) AddWaitEventToSet(set, WL_LATCH_SET, PGINVALID_SOCKET, MyLatch, NULL);
+		(void) AddWaitEventToSet(set, WL_EXIT_ON_PM_DEATH, PGINVALID_SOCKET, NULL, NULL);
+
+		for (i = 0; i < num_conns; i++)
+		{
+			if (status[i] == PGRES_POLLING_READING || status[i] == PGRES_POLLING_WRITING)
+				(void) AddWaitEventToSet(set,
+										 status[i] == PGRES_POLLING_READING ? WL_SOCKET_READABLE :
+																			  WL_SOCKET_WRITEABLE,
+										 PQsocket(pg_conns[i]),
+										 NULL,
+										 &status[i]);
+		}
+
+		num_events = WaitEventSetWait(set, -1, occurred, num_pending + 2, PG_WAIT_EXTENSION);
+		FreeWaitEventSet(set);
+
+		for (i = 0; i < num_events; i++)
+		{
+			WaitEvent *event = &occurred[i];
+			int index;
+
+			if (event->events & WL_LATCH_SET)
+			{
+				ResetLatch(MyLatch);
+				CHECK_FOR_INTERRUPTS();
+				continue;
+			}
+
+			if (!(event->events & (WL_SOCKET_READABLE | WL_SOCKET_WRITEABLE)))
+				continue;
+
+			index = (PostgresPollingStatusType *) event->user_data - status;
+			Assert(index >= 0 && index < num_conns);
+			status[index] = PQconnectPoll(pg_conns[index]);
+
+			if (status[index] == PGRES_POLLING_FAILED)
+				ereport(ERROR,
+						(errcode(ERRCODE_SQLCLIENT_UNABLE_TO_ESTABLISH_SQLCONNECTION),
+						 errmsg("could not connect to \"%s\"", node_names[index]),
+						 errdetail_internal("%s", pchomp(PQerrorMessage(pg_conns[index])))));
+
+			if (status[index] == PGRES_POLLING_OK)
+				num_pending--;
+		}
+	}
+
+	pfree(status);
+	pfree(occurred);
+}
+
+/*
+ * Open connections for several connection IDs concurrently.
+ *
+ * Establishing a connection takes several network round trips, so opening
+ * connections to many data nodes one by one makes the time to run the first
+ * distributed query in a session grow with the number of data nodes. Here
+ * all connection attempts are started using the non-blocking libpq API and
+ * progress together, so that the total time is roughly that of the slowest
+ * connection. The connections are set up in the same way as
+ * `remote_connection_open_by_id` does and returned in the order of the given
+ * IDs.
+ */
+List *
+remote_connection_open_many_by_id(List *conn_ids)
+{
+	int num_conns = list_length(conn_ids);
+	PGconn **pg_conns = palloc0(sizeof(PGconn *) * num_conns);
+	const char **node_names = palloc(sizeof(char *) * num_conns);
+	List *volatile conns = NIL;
+	ListCell *lc;
+	int i;
+
+	PG_TRY();
+	{
+		i = 0;
+
+		foreach (lc, conn_ids)
+		{
+			TSConnectionId *id = lfirst(lc);
+			ForeignServer *server = GetForeignServer(id->server_id);
+			List *connection_options =
+				remote_connection_prepare_auth_options(server, id->user_id);
+			const char **keywords;
+			const char **values;
+
+			setup_full_connection_options(connection_options, &keywords, &values);
+			node_names[i] = server->servername;
+			pg_conns[i] = PQconnectStartParams(keywords, values, 0 /* Do not expand dbname */);
+
+			/* Cast to (char **) to silence warning with MSVC compiler */
+			pfree((char **) keywords);
+			pfree((char **) values);
+
+			if (NULL == pg_conns[i] || PQstatus(pg_conns[i]) == CONNECTION_BAD)
+				ereport(ERROR,
+						(errcode(ERRCODE_SQLCLIENT_UNABLE_TO_ESTABLISH_SQLCONNECTION),
+						 errmsg("could not connect to \"%s\"", node_names[i]),
+						 pg_conns[i] == NULL ?
+							 0 :
+							 errdetail_internal("%s", pchomp(PQerrorMessage(pg_conns[i])))));
+			i++;
+		}
+
+		poll_connections(pg_conns, node_names, num_conns);
+
+		for (i = 0; i < num_conns; i++)
+		{
+			TSConnection *conn = remote_connection_create(pg_conns[i], false, node_names[i]);
+
+			if (NULL == conn)
+				ereport(ERROR,
+						(errcode(ERRCODE_SQLCLIENT_UNABLE_TO_ESTABLISH_SQLCONNECTION),
+						 errmsg("could not connect to \"%s\"", node_names[i])));
+
+			/* The PGconn is now owned by the connection, which is closed by
+			 * the setup in case of failure */
+			pg_conns[i] = NULL;
+			remote_connection_setup(conn, node_names[i], true);
+			conns = lappend(conns, conn);
+		}
+	}
+	PG_CATCH();
+	{
+		for (i = 0; i < num_conns; i++)
+		{
+			if (NULL != pg_conns[i])
+				PQfinish(pg_conns[i]);
+		}
+
+		foreach (lc, conns)
+			remote_connection_close(lfirst(lc));
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	pfree(pg_conns);
+	pfree(node_names);
+
+	return conns;
 }
 
 /*
@@ -1780,6 +2096,90 @@ remote_connection_get_prep_stmt_number()
 	return ++prep_stmt_number;
 }
 
+/*
+ * Look up a statement prepared earlier on the connection for the given SQL
+ * and number of parameters.
+ *
+ * Parameter types are not part of the key since statements are prepared
+ * without them and the data node derives the types from the SQL.
+ *
+ * Returns the name of the prepared statement, or NULL if there is none.
+ */
+const char *
+remote_connection_get_cached_prep_stmt(TSConnection *conn, const char *sql, int n_params)
+{
+	PreparedStmtCacheEntry *prev = NULL;
+	PreparedStmtCacheEntry *entry;
+
+	for (entry = conn->prep_stmts; entry != NULL; prev = entry, entry = entry->next)
+	{
+		if (entry->n_params == n_params && strcmp(entry->sql, sql) == 0)
+		{
+			/* Move the entry to the front to keep the list in LRU order */
+			if (prev != NULL)
+			{
+				prev->next = entry->next;
+				entry->next = conn->prep_stmts;
+				conn->prep_stmts = entry;
+			}
+
+			return entry->stmt_name;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Remember a statement prepared on the connection for later reuse.
+ *
+ * If the cache is full, the least recently used statement is evicted and its
+ * name returned so that the caller can deallocate it on the data node.
+ * Otherwise, returns NULL.
+ */
+char *
+remote_connection_cache_prep_stmt(TSConnection *conn, const char *sql, int n_params,
+								  const char *stmt_name)
+{
+	PreparedStmtCacheEntry *entry = malloc(sizeof(PreparedStmtCacheEntry));
+	char *evicted_name = NULL;
+
+	if (NULL == entry)
+		return NULL;
+
+	entry->sql = strdup(sql);
+
+	if (NULL == entry->sql)
+	{
+		free(entry);
+		return NULL;
+	}
+
+	entry->n_params = n_params;
+	strlcpy(entry->stmt_name, stmt_name, sizeof(entry->stmt_name));
+	entry->next = conn->prep_stmts;
+	conn->prep_stmts = entry;
+	conn->num_prep_stmts++;
+
+	if (conn->num_prep_stmts > PREPARED_STMT_CACHE_SIZE)
+	{
+		PreparedStmtCacheEntry *prev = entry;
+		PreparedStmtCacheEntry *last;
+
+		while (prev->next->next != NULL)
+			prev = prev->next;
+
+		last = prev->next;
+		prev->next = NULL;
+		conn->num_prep_stmts--;
+		evicted_name = pstrdup(last->stmt_name);
+		free(last->sql);
+		free(last);
+	}
+
+	return evicted_name;
+}
+
 #define MAX_CONN_WAIT_TIMEOUT_MS 60000
 
 /*
@@ -1857,6 +2257,20 @@ remote_connection_drain(TSConnection *conn, TimestampTz endtime, PGresult **resu
 
 			if (res == NULL)
 			{
+#ifdef LIBPQ_HAS_PIPELINING
+				/*
+				 * In pipeline mode, the results of the remaining pipelined
+				 * queries follow. Pipeline mode can only be left once they
+				 * are all consumed.
+				 */
+				if (PQpipelineStatus(pg_conn) != PQ_PIPELINE_OFF)
+				{
+					if (0 == PQexitPipelineMode(pg_conn))
+						continue;
+
+					conn->pipeline_requests = 0;
+				}
+#endif
 				/* query is complete */
 				remote_connection_set_status(conn, CONN_IDLE);
 				connresult = CONN_OK;
@@ -1995,6 +2409,107 @@ remote_result_close(PGresult *res)
 	PQclear(res);
 }
 
+/*
+ * Register a prefetch request that was sent on the connection ahead of being
+ * needed. Other users of the connection call the complete function through
+ * remote_connection_complete_prefetch() before sending anything, which reads
+ * the response and leaves it to the owner of the request.
+ */
+void
+remote_connection_set_prefetch(TSConnection *conn, RemoteConnectionPrefetchComplete complete,
+							   void *arg)
+{
+	Assert(conn->prefetch_complete == NULL);
+	conn->prefetch_complete = complete;
+	conn->prefetch_arg = arg;
+}
+
+/*
+ * Unregister the prefetch of the given owner, if it is still registered.
+ */
+void
+remote_connection_clear_prefetch(TSConnection *conn, void *arg)
+{
+	if (conn->prefetch_arg == arg)
+	{
+		conn->prefetch_complete = NULL;
+		conn->prefetch_arg = NULL;
+	}
+}
+
+void
+remote_connection_complete_prefetch(TSConnection *conn)
+{
+	RemoteConnectionPrefetchComplete complete = conn->prefetch_complete;
+	void *arg = conn->prefetch_arg;
+
+	remote_connection_complete_pending_commit(conn);
+
+	if (complete == NULL)
+		return;
+
+	conn->prefetch_complete = NULL;
+	conn->prefetch_arg = NULL;
+	complete(arg);
+}
+
+/*
+ * Mark that a COMMIT PREPARED was sent on the connection without waiting for
+ * its result. The result is read before the connection is used again, so
+ * later commands on the connection still see the committed data.
+ */
+void
+remote_connection_set_pending_commit(TSConnection *conn)
+{
+	Assert(conn->status == CONN_PROCESSING);
+	conn->commit_pending = true;
+}
+
+bool
+remote_connection_has_pending_commit(const TSConnection *conn)
+{
+	return conn->commit_pending;
+}
+
+/*
+ * Read the result of a COMMIT PREPARED in flight, if any.
+ *
+ * Since the local transaction is already committed, a failure is only
+ * reported as a warning. The prepared transaction is then left to be
+ * resolved like any other unresolved two-phase commit and the connection
+ * remains marked as transitioning, so it will not be reused.
+ *
+ * Returns false if the commit failed.
+ */
+bool
+remote_connection_complete_pending_commit(TSConnection *conn)
+{
+	PGresult *res = NULL;
+	TSConnectionResult connres;
+	bool success;
+
+	if (!conn->commit_pending)
+		return true;
+
+	conn->commit_pending = false;
+	connres = remote_connection_drain(conn, DT_NOEND, &res);
+	success = (connres == CONN_OK && res != NULL && PQresultStatus(res) == PGRES_COMMAND_OK);
+
+	if (success)
+		remote_connection_xact_transition_end(conn);
+	else
+		ereport(WARNING,
+				(errcode(ERRCODE_CONNECTION_EXCEPTION),
+				 errmsg("could not commit prepared transaction on data node \"%s\"",
+						remote_connection_node_name(conn)),
+				 res == NULL ? 0 : errdetail_internal("%s", PQresultErrorMessage(res))));
+
+	PQclear(res);
+	remote_connection_set_status(conn, CONN_IDLE);
+
+	return success;
+}
+
 /*
  * Cleanup connections and results at the end of a (sub-)transaction.
  *
@@ -2016,6 +2531,14 @@ remote_connections_cleanup(SubTransactionId subtxid, bool isabort)
 		 * otherwise make the curr pointer invalid. */
 		curr = curr->next;
 
+		/* The owner of a prefetch might be gone with the (sub-)transaction's
+		 * memory */
+		if (isabort || subtxid == InvalidSubTransactionId)
+		{
+			conn->prefetch_complete = NULL;
+			conn->prefetch_arg = NULL;
+		}
+
 		if (conn->autoclose && (subtxid == InvalidSubTransactionId || subtxid == conn->subtxid))
 		{
 			/* Closes the connection and frees all its PGresult objects */
@@ -2195,6 +2718,8 @@ remote_connection_begin_copy(TSConnection *conn, const char *copycmd, bool binar
 #endif
 
 	/* Run the COPY query. */
+	conn->netstats.bytes_sent += strlen(copycmd);
+	conn->netstats.round_trips++;
 	res = PQexec(pg_conn, copycmd);
 
 	if (PQresultStatus(res) != PGRES_COPY_IN)
@@ -2246,9 +2771,31 @@ remote_connection_put_copy_data(TSConnection *conn, const char *buffer, size_t l
 									 "could not send COPY data",
 									 conn);
 
+	conn->netstats.bytes_sent += len;
+
 	return true;
 }
 
+TSConnectionNetStats *
+remote_connection_net_stats(TSConnection *conn)
+{
+	return &conn->netstats;
+}
+
+/*
+ * Get the network activity on a connection since the statistics in "start"
+ * were taken.
+ */
+void
+remote_connection_net_stats_since(TSConnection *conn, const TSConnectionNetStats *start,
+								  TSConnectionNetStats *diff)
+{
+	diff->bytes_sent = conn->netstats.bytes_sent - start->bytes_sent;
+	diff->bytes_received = conn->netstats.bytes_received - start->bytes_received;
+	diff->round_trips = conn->netstats.round_trips - start->round_trips;
+	diff->wait_time = conn->netstats.wait_time - start->wait_time;
+}
+
 static bool
 send_end_binary_copy_data(const TSConnection *conn, TSConnectionError *err)
 {
@@ -14,11 +14,16 @@
 
 typedef struct TSConnection TSConnection;
 
-/* Associated with a connection foreign server and user id */
+/*
+ * Associated with a connection foreign server and user id. The channel is 0
+ * for the regular connection and distinguishes extra connections to the same
+ * data node with the same user, e.g., for parallel COPY.
+ */
 typedef struct TSConnectionId
 {
 	Oid server_id;
 	Oid user_id;
+	uint32 channel;
 } TSConnectionId;
 
 typedef enum ConnOptionType
@@ -64,6 +69,7 @@ extern TSConnection *remote_connection_open_with_options_nothrow(const char *nod
 																 List *connection_options,
 																 char **errmsg);
 extern TSConnection *remote_connection_open_by_id(TSConnectionId id);
+extern List *remote_connection_open_many_by_id(List *conn_ids);
 extern TSConnection *remote_connection_open(Oid server_id, Oid user_id);
 extern TSConnection *remote_connection_open_nothrow(Oid server_id, Oid user_id, char **errmsg);
 extern List *remote_connection_prepare_auth_options(const ForeignServer *server, Oid user_id);
@@ -91,6 +97,10 @@ extern bool remote_connection_valid_node_option(const char *keyword);
 extern unsigned int remote_connection_get_cursor_number(void);
 extern void remote_connection_reset_cursor_number(void);
 extern unsigned int remote_connection_get_prep_stmt_number(void);
+extern const char *remote_connection_get_cached_prep_stmt(TSConnection *conn, const char *sql,
+														  int n_params);
+extern char *remote_connection_cache_prep_stmt(TSConnection *conn, const char *sql, int n_params,
+											   const char *stmt_name);
 extern bool remote_connection_configure(TSConnection *conn);
 extern bool remote_connection_check_extension(TSConnection *conn);
 extern void remote_validate_extension_version(TSConnection *conn, const char *data_node_version);
@@ -118,6 +128,26 @@ extern PGconn *remote_connection_get_pg_conn(const TSConnection *conn);
 extern bool remote_connection_is_processing(const TSConnection *conn);
 extern void remote_connection_set_status(TSConnection *conn, TSConnectionStatus status);
 extern TSConnectionStatus remote_connection_get_status(const TSConnection *conn);
+extern bool remote_connection_pipeline_supported(void);
+extern bool remote_connection_enter_pipeline_mode(TSConnection *conn);
+extern void remote_connection_exit_pipeline_mode(TSConnection *conn);
+extern bool remote_connection_is_pipelined(const TSConnection *conn);
+extern void remote_connection_pipeline_request_sent(TSConnection *conn);
+
+/*
+ * Callback that reads the response of a prefetch request in flight on a
+ * connection, so that the connection can be used for another request.
+ */
+typedef void (*RemoteConnectionPrefetchComplete)(void *arg);
+
+extern void remote_connection_set_prefetch(TSConnection *conn,
+										   RemoteConnectionPrefetchComplete complete, void *arg);
+extern void remote_connection_clear_prefetch(TSConnection *conn, void *arg);
+extern void remote_connection_complete_prefetch(TSConnection *conn);
+extern void remote_connection_set_pending_commit(TSConnection *conn);
+extern bool remote_connection_has_pending_commit(const TSConnection *conn);
+extern bool remote_connection_complete_pending_commit(TSConnection *conn);
+extern void remote_connection_pipeline_request_done(TSConnection *conn);
 extern bool remote_connection_configure_if_changed(TSConnection *conn);
 extern const char *remote_connection_node_name(const TSConnection *conn);
 extern bool remote_connection_set_single_row_mode(TSConnection *conn);
@@ -146,6 +176,24 @@ extern void remote_connection_stats_reset(void);
 extern RemoteConnectionStats *remote_connection_stats_get(void);
 #endif
 
+/*
+ * Network activity on a connection since it was made. Bytes are counted as
+ * the size of the statements, parameters, COPY data and results, excluding
+ * protocol overhead.
+ */
+typedef struct TSConnectionNetStats
+{
+	uint64 bytes_sent;
+	uint64 bytes_received;
+	uint64 round_trips;
+	/* Time blocked waiting for data from the data node, in microseconds */
+	uint64 wait_time;
+} TSConnectionNetStats;
+
+extern TSConnectionNetStats *remote_connection_net_stats(TSConnection *conn);
+extern void remote_connection_net_stats_since(TSConnection *conn, const TSConnectionNetStats *start,
+											  TSConnectionNetStats *diff);
+
 /*
  * Connection functions for COPY mode.
  */
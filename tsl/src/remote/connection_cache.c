@@ -25,6 +25,10 @@
 static Cache *connection_cache = NULL;
 static bool ignore_connection_invalidation = false;
 
+/* Connection opened ahead of time that is about to be added to the
+ * cache. See remote_connection_cache_open_connections(). */
+static TSConnection *preopened_connection = NULL;
+
 typedef struct ConnectionCacheEntry
 {
 	TSConnectionId id;
@@ -115,6 +119,12 @@ connection_should_be_remade(const ConnectionCacheEntry *entry)
 	if (NULL == entry->conn)
 		return true;
 
+	/* Read the result of an asynchronous COMMIT PREPARED first. If the commit
+	 * failed, the state of the remote session is unknown, so remake the
+	 * connection. */
+	if (!remote_connection_complete_pending_commit(entry->conn))
+		return true;
+
 	if (remote_connection_xact_is_transitioning(entry->conn))
 	{
 		NameData nodename;
@@ -162,7 +172,13 @@ connection_cache_create_entry(Cache *cache, CacheQuery *query)
 	 * because PGconn allocation happens using malloc. Which is why calling
 	 * remote_connection_close at cleanup is critical.
 	 */
-	entry->conn = remote_connection_open_by_id(*id);
+	if (NULL != preopened_connection)
+	{
+		entry->conn = preopened_connection;
+		preopened_connection = NULL;
+	}
+	else
+		entry->conn = remote_connection_open_by_id(*id);
 
 	/* Since this connection is managed by the cache, it should not auto-close
 	 * at the end of the transaction */
@@ -247,6 +263,87 @@ remote_connection_cache_get_connection(TSConnectionId id)
 	return entry->conn;
 }
 
+/*
+ * Make sure that the cache has connections for all the given connection IDs.
+ *
+ * Connections that are missing from the cache, or need to be remade, are
+ * opened concurrently and added to the cache. This avoids paying the
+ * connection setup latency once per data node when a session accesses many
+ * data nodes for the first time.
+ */
+void
+remote_connection_cache_open_connections(List *conn_ids)
+{
+	List *missing_ids = NIL;
+	List *conns;
+	ListCell *lc;
+	ListCell *lc_id;
+	ListCell *lc_conn;
+
+	foreach (lc, conn_ids)
+	{
+		TSConnectionId *id = lfirst(lc);
+		bool found;
+		ListCell *lc_missing;
+
+		/* Connections that are already cached are refreshed, if necessary,
+		 * when they are fetched from the cache */
+		hash_search(connection_cache->htab, id, HASH_FIND, &found);
+
+		if (found)
+			continue;
+
+		foreach (lc_missing, missing_ids)
+		{
+			if (memcmp(lfirst(lc_missing), id, sizeof(TSConnectionId)) == 0)
+			{
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			missing_ids = lappend(missing_ids, id);
+	}
+
+	/* Opening a single connection concurrently gives nothing, so leave it to
+	 * the regular code path */
+	if (list_length(missing_ids) < 2)
+	{
+		list_free(missing_ids);
+		return;
+	}
+
+	conns = remote_connection_open_many_by_id(missing_ids);
+
+	PG_TRY();
+	{
+		forboth (lc_id, missing_ids, lc_conn, conns)
+		{
+			preopened_connection = lfirst(lc_conn);
+			remote_connection_cache_get_connection(*((TSConnectionId *) lfirst(lc_id)));
+			Assert(preopened_connection == NULL);
+			lfirst(lc_conn) = NULL;
+		}
+	}
+	PG_CATCH();
+	{
+		/* Close the connections that did not make it into the cache */
+		foreach (lc_conn, conns)
+		{
+			if (NULL != lfirst(lc_conn))
+				remote_connection_close(lfirst(lc_conn));
+		}
+
+		preopened_connection = NULL;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	list_free(conns);
+	list_free(missing_ids);
+}
+
 bool
 remote_connection_cache_remove(TSConnectionId id)
 {
@@ -380,6 +477,10 @@ enum Anum_show_conn
 	Anum_show_conn_txn_depth,
 	Anum_show_conn_processing,
 	Anum_show_conn_invalidated,
+	Anum_show_conn_bytes_sent,
+	Anum_show_conn_bytes_received,
+	Anum_show_conn_round_trips,
+	Anum_show_conn_wait_time,
 	_Anum_show_conn_max,
 };
 
@@ -414,6 +515,7 @@ create_tuple_from_conn_entry(const ConnectionCacheEntry *entry, const TupleDesc
 	Datum values[Natts_show_conn];
 	bool nulls[Natts_show_conn] = { false };
 	PGconn *pgconn = remote_connection_get_pg_conn(entry->conn);
+	const TSConnectionNetStats *netstats = remote_connection_net_stats(entry->conn);
 	NameData conn_node_name, conn_user_name, conn_db;
 	const char *username = GetUserNameFromId(entry->id.user_id, true);
 
@@ -443,6 +545,14 @@ create_tuple_from_conn_entry(const ConnectionCacheEntry *entry, const TupleDesc
 	values[AttrNumberGetAttrOffset(Anum_show_conn_processing)] =
 		BoolGetDatum(remote_connection_is_processing(entry->conn));
 	values[AttrNumberGetAttrOffset(Anum_show_conn_invalidated)] = BoolGetDatum(entry->invalidated);
+	values[AttrNumberGetAttrOffset(Anum_show_conn_bytes_sent)] =
+		Int64GetDatum(netstats->bytes_sent);
+	values[AttrNumberGetAttrOffset(Anum_show_conn_bytes_received)] =
+		Int64GetDatum(netstats->bytes_received);
+	values[AttrNumberGetAttrOffset(Anum_show_conn_round_trips)] =
+		Int64GetDatum(netstats->round_trips);
+	values[AttrNumberGetAttrOffset(Anum_show_conn_wait_time)] =
+		Float8GetDatum(netstats->wait_time / 1000.0);
 
 	return heap_form_tuple(tupdesc, values, nulls);
 }
@@ -21,6 +21,7 @@
  */
 
 extern TSConnection *remote_connection_cache_get_connection(TSConnectionId id);
+extern void remote_connection_cache_open_connections(List *conn_ids);
 extern bool remote_connection_cache_remove(TSConnectionId id);
 extern void remote_connection_cache_invalidation_ignore(bool value);
 extern void remote_connection_cache_invalidate_callback(Datum arg, int cacheid, uint32 hashvalue);
@@ -11,6 +11,7 @@
 #include "copy_fetcher.h"
 #include "tuplefactory.h"
 #include "async.h"
+#include "guc.h"
 
 typedef struct CopyFetcher
 {
@@ -113,6 +114,10 @@ copy_fetcher_send_fetch_request(DataFetcher *df)
 							 " Use cursor fetcher instead.")));
 		}
 
+		/* Wait for the COPY to start within the response timeout, if any */
+		async_request_set_response_timeout(req, ts_guc_data_node_response_timeout);
+		async_request_wait_readable(req);
+
 		PGresult *res = PQgetResult(remote_connection_get_pg_conn(fetcher->state.conn));
 		if (res == NULL)
 		{
@@ -345,6 +350,7 @@ copy_fetcher_complete(CopyFetcher *fetcher)
 
 	PG_TRY();
 	{
+		Size batch_bytes = 0;
 		int row;
 
 		for (row = 0; row < fetcher->state.fetch_size; row++)
@@ -381,6 +387,8 @@ copy_fetcher_complete(CopyFetcher *fetcher)
 
 			copy_data.maxlen = copy_data.len;
 			Assert(copy_data.cursor == 0);
+			batch_bytes += copy_data.len + tupdesc_natts * (sizeof(Datum) + sizeof(bool));
+			remote_connection_net_stats(fetcher->state.conn)->bytes_received += copy_data.len;
 
 			if (fetcher->state.batch_count == 0 && row == 0)
 			{
@@ -468,14 +476,10 @@ copy_fetcher_complete(CopyFetcher *fetcher)
 						continue;
 					}
 
-					StringInfoData att_data = { 0 };
-					att_data.data = copy_data_read_bytes(&copy_data, att_bytes);
-					att_data.len = att_bytes;
-
-					values[att] = ReceiveFunctionCall(&attconv->conv_funcs[att],
-													  &att_data,
-													  attconv->ioparams[att],
-													  attconv->typmods[att]);
+					values[att] = data_format_recv(attconv,
+												   att,
+												   copy_data_read_bytes(&copy_data, att_bytes),
+												   att_bytes);
 					nulls[att] = false;
 				}
 			}
@@ -495,6 +499,7 @@ copy_fetcher_complete(CopyFetcher *fetcher)
 		}
 
 		fetcher->state.batch_count++;
+		data_fetcher_adapt_fetch_size(&fetcher->state, batch_bytes);
 
 		/* Finish the COPY here instead of at scan end (fetcher close) in
 		 * order to not leave the connection in COPY_OUT mode. This is
@@ -10,10 +10,12 @@
  * directory for a copy of the PostgreSQL License.
  */
 #include <postgres.h>
+#include <access/htup_details.h>
 #include <lib/stringinfo.h>
 #include <utils/rel.h>
 #include <utils/guc.h>
 
+#include "guc.h"
 #include "utils.h"
 #include "async.h"
 #include "stmt_params.h"
@@ -36,6 +38,12 @@
  * The downside of using a CURSOR, however, is that the plan on the remote
  * node cannot execute in parallel.
  *
+ * With timescaledb.enable_cursor_prefetch, the FETCH for the next batch is
+ * sent as soon as a batch has arrived, so that the data node produces the
+ * next batch while the current one is processed locally. If another request
+ * needs the connection in the meantime, the prefetched batch is read first
+ * and kept until the cursor gets to it.
+ *
  * https://www.postgresql.org/docs/current/when-can-parallel-query-be-used.html
  */
 typedef struct CursorFetcher
@@ -44,6 +52,8 @@ typedef struct CursorFetcher
 	unsigned int id;
 	char fetch_stmt[64];	  /* cursor fetch statement */
 	AsyncRequest *create_req; /* a request to create cursor */
+	AsyncResponseResult *prefetched; /* response to a prefetch that was read
+									  * to free the connection */
 } CursorFetcher;
 
 static void cursor_fetcher_send_fetch_request(DataFetcher *df);
@@ -86,6 +96,7 @@ cursor_create_req(CursorFetcher *cursor)
 												 FORMAT_TEXT);
 
 		Assert(NULL != req);
+		async_request_set_response_timeout(req, ts_guc_data_node_response_timeout);
 
 		cursor->create_req = req;
 		pfree(buf.data);
@@ -202,6 +213,7 @@ cursor_fetcher_send_fetch_request(DataFetcher *df)
 			req = async_request_send(conn, cursor->fetch_stmt);
 
 		Assert(NULL != req);
+		async_request_set_response_timeout(req, ts_guc_data_node_response_timeout);
 		cursor->state.data_req = req;
 	}
 	PG_CATCH();
@@ -216,6 +228,58 @@ cursor_fetcher_send_fetch_request(DataFetcher *df)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * Read the response of the prefetch request when another request needs the
+ * connection. The response is kept until the cursor needs the batch.
+ */
+static void
+cursor_fetcher_complete_prefetch(void *arg)
+{
+	CursorFetcher *cursor = (CursorFetcher *) arg;
+	MemoryContext oldcontext;
+
+	Assert(cursor->state.data_req != NULL);
+	Assert(cursor->prefetched == NULL);
+
+	oldcontext = MemoryContextSwitchTo(cursor->state.req_mctx);
+	cursor->prefetched = async_request_wait_any_result(cursor->state.data_req);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Send the FETCH for the next batch ahead of time, unless the connection is
+ * busy with something else.
+ */
+static void
+cursor_fetcher_prefetch(CursorFetcher *cursor)
+{
+	if (!ts_guc_enable_cursor_prefetch || cursor->state.eof || cursor->state.data_req != NULL ||
+		remote_connection_is_processing(cursor->state.conn))
+		return;
+
+	cursor_fetcher_send_fetch_request(&cursor->state);
+	remote_connection_set_prefetch(cursor->state.conn, cursor_fetcher_complete_prefetch, cursor);
+}
+
+/*
+ * Throw away the response of the fetch request in flight, if any.
+ */
+static void
+cursor_fetcher_discard_fetch_request(CursorFetcher *cursor)
+{
+	remote_connection_clear_prefetch(cursor->state.conn, cursor);
+
+	if (cursor->prefetched != NULL)
+	{
+		async_response_result_close(cursor->prefetched);
+		cursor->prefetched = NULL;
+	}
+	else if (!cursor->state.eof && cursor->state.data_req != NULL)
+		async_request_discard_response(cursor->state.data_req);
+
+	cursor->state.data_req = NULL;
+}
+
 /*
  * Retrieve data from ongoing async fetch request
  */
@@ -243,11 +307,22 @@ cursor_fetcher_fetch_data_complete(CursorFetcher *cursor)
 	PG_TRY();
 	{
 		PGresult *res;
+		Size batch_bytes = 0;
 		int i;
 
 		oldcontext = MemoryContextSwitchTo(cursor->state.req_mctx);
 
-		response = async_request_wait_any_result(cursor->state.data_req);
+		/* A prefetch is ours to read now */
+		remote_connection_clear_prefetch(cursor->state.conn, cursor);
+
+		if (cursor->prefetched != NULL)
+		{
+			response = cursor->prefetched;
+			cursor->prefetched = NULL;
+		}
+		else
+			response = async_request_wait_any_result(cursor->state.data_req);
+
 		Assert(NULL != response);
 
 		res = async_response_result_get_pg_result(response);
@@ -276,7 +351,10 @@ cursor_fetcher_fetch_data_complete(CursorFetcher *cursor)
 		MemoryContextSwitchTo(cursor->state.tuple_mctx);
 
 		for (i = 0; i < numrows; i++)
+		{
 			cursor->state.tuples[i] = tuplefactory_make_tuple(cursor->state.tf, res, i, format);
+			batch_bytes += HEAPTUPLESIZE + cursor->state.tuples[i]->t_len;
+		}
 
 		tuplefactory_reset_mctx(cursor->state.tf);
 		MemoryContextSwitchTo(cursor->state.batch_mctx);
@@ -292,6 +370,8 @@ cursor_fetcher_fetch_data_complete(CursorFetcher *cursor)
 		/* Must be EOF if we didn't get as many tuples as we asked for. */
 		cursor->state.eof = (numrows < cursor->state.fetch_size);
 
+		data_fetcher_adapt_fetch_size(&cursor->state, batch_bytes);
+
 		pfree(cursor->state.data_req);
 		cursor->state.data_req = NULL;
 
@@ -315,6 +395,8 @@ cursor_fetcher_fetch_data_complete(CursorFetcher *cursor)
 
 	MemoryContextSwitchTo(oldcontext);
 
+	cursor_fetcher_prefetch(cursor);
+
 	return numrows;
 }
 
@@ -371,8 +453,7 @@ cursor_fetcher_rewind(DataFetcher *df)
 	{
 		char sql[64];
 
-		if (!cursor->state.eof && cursor->state.data_req != NULL)
-			async_request_discard_response(cursor->state.data_req);
+		cursor_fetcher_discard_fetch_request(cursor);
 
 		/* We are beyond the first fetch, so need to rewind the remote end */
 		snprintf(sql, sizeof(sql), "MOVE BACKWARD ALL IN c%u", cursor->id);
@@ -398,8 +479,7 @@ cursor_fetcher_close(DataFetcher *df)
 		return;
 	}
 
-	if (!cursor->state.eof && cursor->state.data_req != NULL)
-		async_request_discard_response(cursor->state.data_req);
+	cursor_fetcher_discard_fetch_request(cursor);
 
 	snprintf(sql, sizeof(sql), "CLOSE c%u", cursor->id);
 	cursor->state.open = false;
@@ -12,6 +12,7 @@
 #include "errors.h"
 
 #define DEFAULT_FETCH_SIZE 100
+#define MAX_ADAPTIVE_FETCH_SIZE 100000
 
 void
 data_fetcher_init(DataFetcher *df, TSConnection *conn, const char *stmt, StmtParams *params,
@@ -93,6 +94,34 @@ data_fetcher_set_fetch_size(DataFetcher *df, int fetch_size)
 	df->fetch_size = fetch_size;
 }
 
+/*
+ * Adapt the fetch size after a batch of batch_bytes bytes was fetched.
+ *
+ * A new batch is only fetched once the previous one is consumed, so the fetch
+ * size doubles for every batch the scan asks for, saving round trips for long
+ * scans. Scans that stop early, e.g., due to a LIMIT, never get big
+ * batches. The fetch size is capped by the number of rows that fit in
+ * timescaledb.remote_fetch_memory, estimated from the average size of the
+ * rows of the last batch, which also shrinks the batches of wide rows.
+ */
+void
+data_fetcher_adapt_fetch_size(DataFetcher *df, Size batch_bytes)
+{
+	int64 row_bytes;
+	int64 fetch_size;
+
+	if (ts_guc_remote_fetch_memory <= 0 || df->eof || df->num_tuples <= 0)
+		return;
+
+	row_bytes = Max((int64) batch_bytes / df->num_tuples, 1);
+	fetch_size = Min((int64) df->fetch_size * 2, MAX_ADAPTIVE_FETCH_SIZE);
+	fetch_size = Min(fetch_size, (int64) ts_guc_remote_fetch_memory * 1024L / row_bytes);
+	fetch_size = Max(fetch_size, 1);
+
+	if (fetch_size != df->fetch_size)
+		df->funcs->set_fetch_size(df, (int) fetch_size);
+}
+
 void
 data_fetcher_set_tuple_mctx(DataFetcher *df, MemoryContext mctx)
 {
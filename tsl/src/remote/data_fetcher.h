@@ -68,6 +68,7 @@ extern void data_fetcher_init(DataFetcher *df, TSConnection *conn, const char *s
 extern void data_fetcher_store_tuple(DataFetcher *df, int row, TupleTableSlot *slot);
 extern void data_fetcher_store_next_tuple(DataFetcher *df, TupleTableSlot *slot);
 extern void data_fetcher_set_fetch_size(DataFetcher *df, int fetch_size);
+extern void data_fetcher_adapt_fetch_size(DataFetcher *df, Size batch_bytes);
 extern void data_fetcher_set_tuple_mctx(DataFetcher *df, MemoryContext mctx);
 extern void data_fetcher_validate(DataFetcher *df);
 extern void data_fetcher_reset(DataFetcher *df);
@@ -9,7 +9,9 @@
 #include <utils/lsyscache.h>
 #include <access/htup_details.h>
 #include <utils/builtins.h>
+#include <utils/timestamp.h>
 #include <access/sysattr.h>
+#include <port/pg_bswap.h>
 #include <funcapi.h>
 
 #include "guc.h"
@@ -82,6 +84,119 @@ data_format_get_type_input_func(Oid type, bool *is_binary, bool force_text, Oid
 	return get_type_in_out_func(type, is_binary, force_text, type_io_param, false);
 }
 
+static Datum
+decode_bool(const char *data)
+{
+	return BoolGetDatum(*data != 0);
+}
+
+static Datum
+decode_int16(const char *data)
+{
+	uint16 val;
+
+	memcpy(&val, data, sizeof(val));
+	return Int16GetDatum((int16) pg_ntoh16(val));
+}
+
+static Datum
+decode_int32(const char *data)
+{
+	uint32 val;
+
+	memcpy(&val, data, sizeof(val));
+	return Int32GetDatum((int32) pg_ntoh32(val));
+}
+
+static Datum
+decode_oid(const char *data)
+{
+	uint32 val;
+
+	memcpy(&val, data, sizeof(val));
+	return ObjectIdGetDatum((Oid) pg_ntoh32(val));
+}
+
+static Datum
+decode_int64(const char *data)
+{
+	uint64 val;
+
+	memcpy(&val, data, sizeof(val));
+	return Int64GetDatum((int64) pg_ntoh64(val));
+}
+
+static Datum
+decode_float4(const char *data)
+{
+	union
+	{
+		float4 f;
+		uint32 i;
+	} val;
+
+	memcpy(&val.i, data, sizeof(val.i));
+	val.i = pg_ntoh32(val.i);
+	return Float4GetDatum(val.f);
+}
+
+static Datum
+decode_float8(const char *data)
+{
+	union
+	{
+		float8 f;
+		uint64 i;
+	} val;
+
+	memcpy(&val.i, data, sizeof(val.i));
+	val.i = pg_ntoh64(val.i);
+	return Float8GetDatum(val.f);
+}
+
+static const DataFormatDecoder bool_decoder = { .len = 1, .decode = decode_bool };
+static const DataFormatDecoder int16_decoder = { .len = 2, .decode = decode_int16 };
+static const DataFormatDecoder int32_decoder = { .len = 4, .decode = decode_int32 };
+static const DataFormatDecoder oid_decoder = { .len = 4, .decode = decode_oid };
+static const DataFormatDecoder int64_decoder = { .len = 8, .decode = decode_int64 };
+static const DataFormatDecoder float4_decoder = { .len = 4, .decode = decode_float4 };
+static const DataFormatDecoder float8_decoder = { .len = 8, .decode = decode_float8 };
+
+/*
+ * Get a decoder for the binary format of a type, if there is one.
+ *
+ * Timestamps are decoded as integers without the range check of their
+ * receive functions, since the values were sent by a data node that already
+ * validated them. A type modifier would require rounding the timestamp, so
+ * the receive function is used in that case.
+ */
+static const DataFormatDecoder *
+get_binary_decoder(Oid type, int32 typmod)
+{
+	switch (type)
+	{
+		case BOOLOID:
+			return &bool_decoder;
+		case INT2OID:
+			return &int16_decoder;
+		case INT4OID:
+			return &int32_decoder;
+		case OIDOID:
+			return &oid_decoder;
+		case INT8OID:
+			return &int64_decoder;
+		case FLOAT4OID:
+			return &float4_decoder;
+		case FLOAT8OID:
+			return &float8_decoder;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return typmod < 0 ? &int64_decoder : NULL;
+		default:
+			return NULL;
+	}
+}
+
 AttConvInMetadata *
 data_format_create_att_conv_in_metadata(TupleDesc tupdesc, bool force_text)
 {
@@ -96,6 +211,7 @@ data_format_create_att_conv_in_metadata(TupleDesc tupdesc, bool force_text)
 	att_conv_metadata->conv_funcs = palloc(tupdesc->natts * sizeof(FmgrInfo));
 	att_conv_metadata->ioparams = palloc(tupdesc->natts * sizeof(Oid));
 	att_conv_metadata->typmods = palloc(tupdesc->natts * sizeof(int32));
+	att_conv_metadata->decoders = palloc0(tupdesc->natts * sizeof(DataFormatDecoder *));
 
 	while (i < tupdesc->natts)
 	{
@@ -122,5 +238,18 @@ data_format_create_att_conv_in_metadata(TupleDesc tupdesc, bool force_text)
 	}
 
 	att_conv_metadata->binary = isbinary;
+
+	if (isbinary)
+	{
+		for (i = 0; i < tupdesc->natts; i++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+			if (!attr->attisdropped)
+				att_conv_metadata->decoders[i] =
+					get_binary_decoder(attr->atttypid, attr->atttypmod);
+		}
+	}
+
 	return att_conv_metadata;
 }
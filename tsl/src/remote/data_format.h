@@ -9,16 +9,30 @@
 #include <postgres.h>
 #include <fmgr.h>
 #include <access/tupdesc.h>
+#include <lib/stringinfo.h>
 
 #define FORMAT_TEXT 0
 #define FORMAT_BINARY 1
 
+/*
+ * Decoder for the binary format of a fixed-width type. It is used instead of
+ * the receive function of the type to avoid the function call overhead for
+ * every value.
+ */
+typedef struct DataFormatDecoder
+{
+	int len; /* Size of the binary format */
+	Datum (*decode)(const char *data);
+} DataFormatDecoder;
+
 /* Metadata to convert PG result into tuples */
 typedef struct AttConvInMetadata
 {
 	FmgrInfo *conv_funcs; /* in functions for converting */
 	Oid *ioparams;
 	int32 *typmods;
+	/* Decoders of the binary format, or NULL if the in function is used */
+	const DataFormatDecoder **decoders;
 	bool binary; /* if we use function with binary input */
 } AttConvInMetadata;
 
@@ -29,4 +43,26 @@ extern Oid data_format_get_type_output_func(Oid type, bool *is_binary, bool forc
 extern Oid data_format_get_type_input_func(Oid type, bool *is_binary, bool force_text,
 										   Oid *type_io_param);
 
+/*
+ * Convert the binary format of a non-NULL value of an attribute (given by its
+ * offset) to a datum.
+ *
+ * Values of an unexpected size are passed to the receive function, which
+ * reports the error.
+ */
+static inline Datum
+data_format_recv(const AttConvInMetadata *attconv, int att, char *data, int len)
+{
+	const DataFormatDecoder *decoder = attconv->decoders[att];
+	StringInfoData si = { .data = data, .len = len, .maxlen = len };
+
+	if (decoder != NULL && decoder->len == len)
+		return decoder->decode(data);
+
+	return ReceiveFunctionCall(&attconv->conv_funcs[att],
+							   &si,
+							   attconv->ioparams[att],
+							   attconv->typmods[att]);
+}
+
 #endif
@@ -7,6 +7,7 @@
 
 #include <postgres.h>
 #include <access/tupdesc.h>
+#include <access/xact.h>
 #include <catalog/namespace.h>
 #include <executor/executor.h>
 #include <libpq-fe.h>
@@ -14,6 +15,7 @@
 #include <parser/parse_type.h>
 #include <port/pg_bswap.h>
 #include <utils/builtins.h>
+#include <utils/fmgroids.h>
 #include <utils/lsyscache.h>
 
 #include "compat/compat.h"
@@ -32,6 +34,10 @@
 #include "remote/dist_txn.h"
 #include "ts_catalog/chunk_data_node.h"
 
+#if PG14_GE
+#include <commands/copyfrom_internal.h>
+#endif
+
 #define DEFAULT_PG_DELIMITER '\t'
 #define DEFAULT_PG_NULL_VALUE "\\N"
 
@@ -117,6 +123,7 @@ typedef struct BinaryCopyContext
 	FmgrInfo *out_functions;
 	Datum *values;
 	bool *nulls;
+	bool *passthrough; /* Columns whose values are the raw binary input */
 } BinaryCopyContext;
 
 /* This is this high level state needed for an in-progress copy command.
@@ -131,6 +138,15 @@ typedef struct RemoteCopyContext
 	bool binary_operation;
 	MemoryContext mctx; /* MemoryContext that holds the RemoteCopyContext */
 
+	/*
+	 * Rows are sharded by chunk across this many connections per data node.
+	 * The extra connections run in their own remote transactions, so they
+	 * cannot see the chunks created by this transaction. Rows for those
+	 * chunks always go to the regular connection.
+	 */
+	int connections_per_data_node;
+	Bitmapset *new_chunk_ids; /* Chunks created by this COPY */
+
 	/*
 	 * Incoming rows are batched before creating the chunks and sending them to
 	 * data nodes. The following fields contain the current batch of rows.
@@ -279,7 +295,7 @@ get_copy_connection_to_data_node(RemoteCopyContext *context, TSConnectionId requ
 	{
 		DataNodeConnection *entry = (DataNodeConnection *) lfirst(lc);
 		if (required_id.server_id == entry->id.server_id &&
-			required_id.user_id == entry->id.user_id)
+			required_id.user_id == entry->id.user_id && required_id.channel == entry->id.channel)
 		{
 			connection = entry->connection;
 			break;
@@ -1003,6 +1019,7 @@ generate_binary_copy_context(ExprContext *econtext, const Hypertable *ht, const
 	ctx->econtext = econtext;
 	ctx->values = palloc0(columns * sizeof(Datum));
 	ctx->nulls = palloc0(columns * sizeof(bool));
+	ctx->passthrough = palloc0(columns * sizeof(bool));
 
 	return ctx;
 }
@@ -1032,6 +1049,8 @@ remote_copy_begin(const CopyStmt *stmt, Hypertable *ht, ExprContext *per_tuple_c
 	context->batch_row_count = 0;
 	context->batch_size_bytes = 0;
 	context->batch_ordinal = 0;
+	context->connections_per_data_node = 1;
+	context->new_chunk_ids = NULL;
 
 	if (binary_copy)
 		context->data_context = generate_binary_copy_context(per_tuple_ctx, ht, attnums);
@@ -1168,8 +1187,16 @@ parse_next_text_row(CopyFromState cstate, List *attnums, TextCopyContext *ctx)
 	return row_data;
 }
 
+/*
+ * Serialize a row in binary COPY format.
+ *
+ * Values of passthrough columns are bytea datums holding the binary input of
+ * the column, which are forwarded as is instead of being sent through the
+ * output function.
+ */
 static StringInfo
-generate_binary_copy_data(Datum *values, bool *nulls, List *attnums, FmgrInfo *out_functions)
+generate_binary_copy_data(Datum *values, bool *nulls, List *attnums, FmgrInfo *out_functions,
+						  const bool *passthrough)
 {
 	StringInfo row_data = makeStringInfo();
 	uint16 buf16;
@@ -1188,6 +1215,15 @@ generate_binary_copy_data(Datum *values, bool *nulls, List *attnums, FmgrInfo *o
 			buf32 = pg_hton32((uint32) -1);
 			appendBinaryStringInfo(row_data, (char *) &buf32, sizeof(buf32));
 		}
+		else if (passthrough != NULL && passthrough[offset])
+		{
+			bytea *inputbytes = DatumGetByteaPP(values[offset]);
+			int input_length = VARSIZE_ANY_EXHDR(inputbytes);
+
+			buf32 = pg_hton32((uint32) input_length);
+			appendBinaryStringInfo(row_data, (char *) &buf32, sizeof(buf32));
+			appendBinaryStringInfo(row_data, VARDATA_ANY(inputbytes), input_length);
+		}
 		else
 		{
 			Datum value = values[offset];
@@ -1215,7 +1251,60 @@ parse_next_binary_row(CopyFromState cstate, List *attnums, BinaryCopyContext *ct
 	if (!result)
 		return NULL;
 
-	return generate_binary_copy_data(ctx->values, ctx->nulls, attnums, ctx->out_functions);
+	return generate_binary_copy_data(ctx->values,
+									 ctx->nulls,
+									 attnums,
+									 ctx->out_functions,
+									 ctx->passthrough);
+}
+
+/*
+ * Forward the binary input of non-partitioning columns without decoding it.
+ *
+ * With binary input and binary transfer, decoding every column with its
+ * receive function only to encode it again with its send function is wasted
+ * work on the access node, since the data nodes decode the values anyway.
+ * Instead, replace the receive function of the columns that are not needed
+ * for routing with bytearecv, which keeps the raw input bytes of the value.
+ * The COPY code still validates the framing of each row, and the data nodes
+ * validate the values.
+ *
+ * This needs access to the COPY state, which is only possible in PG >= 14.
+ */
+static void
+setup_binary_passthrough(RemoteCopyContext *context, CopyFromState cstate)
+{
+#if PG14_GE
+	BinaryCopyContext *ctx = context->data_context;
+	const Hyperspace *hs = context->ht->space;
+	ListCell *lc;
+
+	Assert(context->binary_operation);
+
+	if (cstate == NULL || !cstate->opts.binary)
+		return;
+
+	foreach (lc, context->attnums)
+	{
+		AttrNumber attnum = lfirst_int(lc);
+		bool is_dimension = false;
+
+		for (int i = 0; i < hs->num_dimensions; i++)
+		{
+			if (hs->dimensions[i].column_attno == attnum)
+			{
+				is_dimension = true;
+				break;
+			}
+		}
+
+		if (is_dimension)
+			continue;
+
+		fmgr_info(F_BYTEARECV, &cstate->in_functions[AttrNumberGetAttrOffset(attnum)]);
+		ctx->passthrough[AttrNumberGetAttrOffset(attnum)] = true;
+	}
+#endif
 }
 
 static Point *
@@ -1320,6 +1409,7 @@ typedef struct DataNodeRows
 {
 	int data_node_id;
 	Oid server_oid;
+	uint32 channel; /* Which of the connections to the data node to use */
 	TSConnection *connection;
 	int rows_total;
 
@@ -1362,10 +1452,27 @@ remote_copy_process_and_send_data(RemoteCopyContext *context)
 				did_end_copy = true;
 			}
 			chunk = ts_hypertable_create_chunk_for_point(ht, point, &found);
+
+			if (!found)
+			{
+				MemoryContext old = MemoryContextSwitchTo(context->mctx);
+				context->new_chunk_ids = bms_add_member(context->new_chunk_ids, chunk->fd.id);
+				MemoryContextSwitchTo(old);
+			}
 		}
 		else
 			found = true;
 
+		/*
+		 * Shard the rows by chunk across the connections to each data node.
+		 * Chunks created by this COPY are only visible on the regular
+		 * connection, which created them.
+		 */
+		uint32 channel = 0;
+		if (context->connections_per_data_node > 1 &&
+			!bms_is_member(chunk->fd.id, context->new_chunk_ids))
+			channel = chunk->fd.id % context->connections_per_data_node;
+
 		/* get the filtered list of "available" DNs for this chunk but only if it's replicated */
 		if (found && ht->fd.replication_factor > 1)
 		{
@@ -1411,7 +1518,8 @@ remote_copy_process_and_send_data(RemoteCopyContext *context)
 			foreach (lc2, data_nodes)
 			{
 				data_node_rows = lfirst(lc2);
-				if (chunk_data_node->foreign_server_oid == data_node_rows->server_oid)
+				if (chunk_data_node->foreign_server_oid == data_node_rows->server_oid &&
+					channel == data_node_rows->channel)
 				{
 					break;
 				}
@@ -1423,6 +1531,7 @@ remote_copy_process_and_send_data(RemoteCopyContext *context)
 				data_node_rows = palloc(sizeof(DataNodeRows));
 				data_node_rows->connection = NULL;
 				data_node_rows->server_oid = chunk_data_node->foreign_server_oid;
+				data_node_rows->channel = channel;
 				data_node_rows->rows_total = 0;
 				/*
 				 * Not every tuple in a batch might be sent to every data node,
@@ -1464,6 +1573,7 @@ remote_copy_process_and_send_data(RemoteCopyContext *context)
 	{
 		DataNodeRows *dn = lfirst(lc);
 		TSConnectionId required_id = remote_connection_id(dn->server_oid, GetUserId());
+		required_id.channel = dn->channel;
 		Assert(dn->connection == NULL);
 		dn->connection = get_copy_connection_to_data_node(context, required_id);
 		PGconn *pg_conn = remote_connection_get_pg_conn(dn->connection);
@@ -1491,6 +1601,8 @@ remote_copy_process_and_send_data(RemoteCopyContext *context)
 					 errdetail("%s", PQerrorMessage(pg_conn))));
 		}
 
+		remote_connection_net_stats(dn->connection)->bytes_sent += copy_data.len;
+
 		/*
 		 * We don't have to specially flush the data here, because the flush is
 		 * attempted after finishing each protocol message (pqPutMsgEnd()).
@@ -1525,6 +1637,18 @@ remote_distributed_copy(const CopyStmt *stmt, CopyChunkState *ccstate, List *att
 												   copy_should_send_binary(stmt));
 	uint64 processed = 0;
 
+	if (context->binary_operation)
+		setup_binary_passthrough(context, ccstate->cstate);
+
+	/*
+	 * Use several connections per data node only outside of transaction
+	 * blocks. The extra connections don't see the changes made on the
+	 * regular connection earlier in the transaction, and could wait on its
+	 * locks.
+	 */
+	if (!IsTransactionBlock())
+		context->connections_per_data_node = ts_guc_dist_copy_connections_per_data_node;
+
 	MemoryContext batch_context =
 		AllocSetContextCreate(CurrentMemoryContext, "Remote COPY batch", ALLOCSET_DEFAULT_SIZES);
 
@@ -1614,7 +1738,8 @@ remote_copy_send_slot(RemoteCopyContext *context, TupleTableSlot *slot, const Ch
 		row_data = generate_binary_copy_data(binctx->values,
 											 binctx->nulls,
 											 context->attnums,
-											 binctx->out_functions);
+											 binctx->out_functions,
+											 NULL);
 	}
 	else
 	{
@@ -9,6 +9,7 @@
 #include <catalog/namespace.h>
 #include <commands/event_trigger.h>
 #include <commands/dbcommands.h>
+#include <commands/defrem.h>
 #include <commands/extension.h>
 #include <nodes/parsenodes.h>
 #include <parser/parse_func.h>
@@ -31,6 +32,7 @@
 #include "scan_iterator.h"
 #include "dist_util.h"
 #include "deparse.h"
+#include "with_clause_parser.h"
 
 /* DDL Query execution type */
 typedef enum
@@ -819,12 +821,54 @@ dist_ddl_process_alter_table(const ProcessUtilityArgs *args)
 	dist_ddl_state_schedule(exec_type, args);
 }
 
+/*
+ * Check if CREATE INDEX is using timescaledb.transaction_per_chunk.
+ *
+ * The TimescaleDB options are already filtered out from the parse tree by
+ * the time we get here, so look at the original query string instead.
+ */
+static bool
+dist_ddl_index_is_multitransaction(const ProcessUtilityArgs *args)
+{
+	List *parsetree_list = pg_parse_query(args->query_string);
+	RawStmt *rawstmt = linitial_node(RawStmt, parsetree_list);
+	List *hypertable_options = NIL;
+	ListCell *lc;
+
+	if (!IsA(rawstmt->stmt, IndexStmt))
+		return false;
+
+	ts_with_clause_filter(castNode(IndexStmt, rawstmt->stmt)->options, &hypertable_options, NULL);
+
+	foreach (lc, hypertable_options)
+	{
+		DefElem *def = lfirst_node(DefElem, lc);
+
+		if (pg_strcasecmp(def->defname, "transaction_per_chunk") == 0)
+			return defGetBoolean(def);
+	}
+
+	return false;
+}
+
 static void
 dist_ddl_process_index(const ProcessUtilityArgs *args)
 {
 	if (!dist_ddl_state_set_hypertable(args))
 		return;
 
+	/*
+	 * With timescaledb.transaction_per_chunk, each data node indexes its
+	 * chunks in separate transactions, so the command cannot be part of the
+	 * distributed transaction. The data nodes still build their indexes in
+	 * parallel with each other.
+	 */
+	if (dist_ddl_index_is_multitransaction(args))
+	{
+		dist_ddl_state_schedule(DIST_DDL_EXEC_ON_START_NO_2PC, args);
+		return;
+	}
+
 	/* Since we have custom CREATE INDEX implementation, currently it
 	 * does not support ddl_command_end trigger. */
 	dist_ddl_state_schedule(DIST_DDL_EXEC_ON_START, args);
@@ -1008,6 +1052,23 @@ dist_ddl_process(const ProcessUtilityArgs *args)
 	}
 }
 
+/*
+ * Set the search path on all data nodes of the command, or reset it if
+ * search_path is NULL.
+ */
+static void
+dist_ddl_set_search_path(const char *search_path, bool transactional)
+{
+	char *sql;
+
+	if (search_path != NULL)
+		sql = psprintf("SET search_path = %s, pg_catalog", search_path);
+	else
+		sql = "SET search_path = pg_catalog";
+
+	ts_dist_cmd_run_on_data_nodes(sql, dist_ddl_state.data_node_list, transactional);
+}
+
 static void
 dist_ddl_execute(bool transactional)
 {
@@ -1021,7 +1082,14 @@ dist_ddl_execute(bool transactional)
 		return;
 	}
 
+	/*
+	 * Set the search path once for all the commands, instead of setting and
+	 * resetting it around each command, to save round trips to the data
+	 * nodes.
+	 */
 	search_path = GetConfigOption("search_path", false, false);
+	remote_connection_cache_invalidation_ignore(true);
+	dist_ddl_set_search_path(search_path, transactional);
 
 	foreach (lc, dist_ddl_state.remote_commands)
 	{
@@ -1036,11 +1104,9 @@ dist_ddl_execute(bool transactional)
 				/* Execute single SQL command on each data node from the list */
 				const char *sql = strVal(command);
 
-				result = ts_dist_cmd_invoke_on_data_nodes_using_search_path(sql,
-																			search_path,
-																			dist_ddl_state
-																				.data_node_list,
-																			transactional);
+				result = ts_dist_cmd_invoke_on_data_nodes(sql,
+														  dist_ddl_state.data_node_list,
+														  transactional);
 				break;
 			}
 			case T_List:
@@ -1049,12 +1115,10 @@ dist_ddl_execute(bool transactional)
 				List *cmd_descriptors = command;
 				Assert(list_length(dist_ddl_state.data_node_list) == list_length(cmd_descriptors));
 
-				result =
-					ts_dist_multi_cmds_invoke_on_data_nodes_using_search_path(cmd_descriptors,
-																			  search_path,
-																			  dist_ddl_state
-																				  .data_node_list,
-																			  transactional);
+				result = ts_dist_multi_cmds_params_invoke_on_data_nodes(cmd_descriptors,
+																		dist_ddl_state
+																			.data_node_list,
+																		transactional);
 				break;
 			}
 			default:
@@ -1069,6 +1133,8 @@ dist_ddl_execute(bool transactional)
 		}
 	}
 
+	dist_ddl_set_search_path(NULL, transactional);
+	remote_connection_cache_invalidation_ignore(false);
 	dist_ddl_state_reset();
 }
 
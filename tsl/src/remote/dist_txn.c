@@ -237,6 +237,11 @@ cleanup_at_end_of_transaction(void)
 			Assert(remote_connection_xact_depth_get(conn) == 1);
 			remote_connection_xact_depth_dec(conn);
 
+			/* Connections with an asynchronous commit in flight are still
+			 * busy with the commit */
+			if (remote_connection_has_pending_commit(conn))
+				continue;
+
 			/* Cleanup connections with failed transactions */
 			if (PQstatus(pgconn) != CONNECTION_OK || PQtransactionStatus(pgconn) != PQTRANS_IDLE ||
 				remote_connection_xact_is_transitioning(conn))
@@ -381,8 +386,21 @@ dist_txn_send_commit_prepared_transaction()
 	 */
 	remote_txn_store_foreach(store, remote_txn)
 	{
+		TSConnection *conn = remote_txn_get_connection(remote_txn);
+		bool async_commit = false;
 		AsyncRequest *req;
 
+		/*
+		 * With asynchronous commit, the result is read before the connection
+		 * is used again. This is only possible if the request is sent right
+		 * away, i.e., nothing else is in flight on the connection.
+		 */
+		if (ts_guc_enable_async_commit_prepared)
+		{
+			remote_connection_complete_prefetch(conn);
+			async_commit = !remote_connection_is_processing(conn);
+		}
+
 		req = remote_txn_async_send_commit_prepared(remote_txn);
 
 		if (req == NULL)
@@ -391,7 +409,10 @@ dist_txn_send_commit_prepared_transaction()
 			continue;
 		}
 
-		async_request_set_add(ars, req);
+		if (async_commit)
+			remote_connection_set_pending_commit(conn);
+		else
+			async_request_set_add(ars, req);
 	}
 
 	eventcallback(DTXN_EVENT_WAIT_COMMIT_PREPARED);
@@ -6,8 +6,11 @@
 #include <postgres.h>
 #include <funcapi.h>
 #include <utils/builtins.h>
+#include <utils/hsearch.h>
 #include <utils/lsyscache.h>
+#include <utils/memutils.h>
 #include <utils/syscache.h>
+#include <utils/timestamp.h>
 
 #include "healthcheck.h"
 #include "data_node.h"
@@ -311,3 +314,119 @@ ts_dist_health_check(PG_FUNCTION_ARGS)
 
 	SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
 }
+
+/*
+ * Responsiveness of data nodes as seen by this backend.
+ *
+ * The response time of a data node is the time from sending a request until
+ * the first result arrives. It is tracked as an exponentially weighted moving
+ * average so that it follows changes in the load of the data node.
+ *
+ * A data node that misses a response deadline is considered unresponsive for
+ * a while, so that replicated chunks are scanned on other data nodes.
+ */
+typedef struct DataNodeResponseTime
+{
+	NameData node_name;
+	double avg_response_ms;
+	TimestampTz unresponsive_until;
+} DataNodeResponseTime;
+
+#define RESPONSE_TIME_WEIGHT 0.2
+#define UNRESPONSIVE_NODE_BACKOFF_MS 60000
+
+static HTAB *response_times = NULL;
+
+static HTAB *
+get_response_times(void)
+{
+	if (NULL == response_times)
+	{
+		HASHCTL hctl = {
+			.keysize = sizeof(NameData),
+			.entrysize = sizeof(DataNodeResponseTime),
+			.hcxt = TopMemoryContext,
+		};
+
+		response_times = hash_create("data node response times",
+									 16,
+									 &hctl,
+									 HASH_ELEM | HASH_CONTEXT | HASH_BLOBS);
+	}
+
+	return response_times;
+}
+
+void
+remote_node_response_time_add(const char *node_name, double response_ms)
+{
+	DataNodeResponseTime *entry;
+	NameData key;
+	bool found;
+
+	namestrcpy(&key, node_name);
+	entry = hash_search(get_response_times(), &key, HASH_ENTER, &found);
+
+	if (!found)
+		entry->unresponsive_until = 0;
+
+	if (!found || entry->avg_response_ms < 0)
+		entry->avg_response_ms = response_ms;
+	else
+		entry->avg_response_ms = RESPONSE_TIME_WEIGHT * response_ms +
+								 (1.0 - RESPONSE_TIME_WEIGHT) * entry->avg_response_ms;
+}
+
+/*
+ * Get the average response time of a data node in milliseconds, or -1 if no
+ * response was seen from the data node yet.
+ */
+double
+remote_node_response_time_get(const char *node_name)
+{
+	DataNodeResponseTime *entry;
+	NameData key;
+
+	if (NULL == response_times)
+		return -1;
+
+	namestrcpy(&key, node_name);
+	entry = hash_search(response_times, &key, HASH_FIND, NULL);
+
+	return entry == NULL ? -1 : entry->avg_response_ms;
+}
+
+/*
+ * Mark a data node as unresponsive after it missed a response deadline.
+ */
+void
+remote_node_mark_unresponsive(const char *node_name)
+{
+	DataNodeResponseTime *entry;
+	NameData key;
+	bool found;
+
+	namestrcpy(&key, node_name);
+	entry = hash_search(get_response_times(), &key, HASH_ENTER, &found);
+
+	if (!found)
+		entry->avg_response_ms = -1;
+
+	entry->unresponsive_until =
+		TimestampTzPlusMilliseconds(GetCurrentTimestamp(), UNRESPONSIVE_NODE_BACKOFF_MS);
+}
+
+bool
+remote_node_is_responsive(const char *node_name)
+{
+	DataNodeResponseTime *entry;
+	NameData key;
+
+	if (NULL == response_times)
+		return true;
+
+	namestrcpy(&key, node_name);
+	entry = hash_search(response_times, &key, HASH_FIND, NULL);
+
+	return entry == NULL || entry->unresponsive_until <= GetCurrentTimestamp();
+}
@@ -4,10 +4,15 @@
  * LICENSE-TIMESCALE for a copy of the license.
  */
 #ifndef TIMESCALEDB_TSL_REMOTE_HEALTHCHECK_H
+#define TIMESCALEDB_TSL_REMOTE_HEALTHCHECK_H
 
 #include <postgres.h>
 #include <fmgr.h>
 
 extern Datum ts_dist_health_check(PG_FUNCTION_ARGS);
+extern void remote_node_response_time_add(const char *node_name, double response_ms);
+extern double remote_node_response_time_get(const char *node_name);
+extern void remote_node_mark_unresponsive(const char *node_name);
+extern bool remote_node_is_responsive(const char *node_name);
 
 #endif /* TIMESCALEDB_TSL_REMOTE_HEALTHCHECK_H */
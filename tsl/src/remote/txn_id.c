@@ -23,9 +23,12 @@
 #define GID_MAX_SIZE 200
 
 #define REMOTE_TXN_ID_VERSION ((uint8) 1)
+#define REMOTE_TXN_ID_VERSION_CHANNEL ((uint8) 2)
 
 /* current_pattern: ts-version-xid-server_id-user_id */
 #define FMT_PATTERN GID_PREFIX "%hhu" GID_SEP "%u" GID_SEP "%u" GID_SEP "%u"
+/* channel pattern: ts-version-xid-server_id-user_id-channel */
+#define FMT_PATTERN_CHANNEL FMT_PATTERN GID_SEP "%hhu"
 
 static char *
 remote_txn_id_get_sql(const char *command, RemoteTxnId *id)
@@ -70,20 +73,45 @@ remote_txn_id_in(const char *id_string)
 {
 	RemoteTxnId *id = palloc0(sizeof(RemoteTxnId));
 	char dummy;
+	int nfields = 0;
+	int expected_nfields = 0;
 
-	if (sscanf(id_string,
-			   FMT_PATTERN "%c",
-			   &id->version,
-			   &id->xid,
-			   &id->id.server_id,
-			   &id->id.user_id,
-			   &dummy) != 4)
+	if (sscanf(id_string, GID_PREFIX "%hhu", &id->version) != 1)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
 				 errmsg("invalid input syntax for remote transaction ID: '%s'", id_string)));
 
-	if (id->version != REMOTE_TXN_ID_VERSION)
-		elog(ERROR, "invalid version for remote transaction ID: %hhu", id->version);
+	switch (id->version)
+	{
+		case REMOTE_TXN_ID_VERSION:
+			expected_nfields = 4;
+			nfields = sscanf(id_string,
+							 FMT_PATTERN "%c",
+							 &id->version,
+							 &id->xid,
+							 &id->id.server_id,
+							 &id->id.user_id,
+							 &dummy);
+			break;
+		case REMOTE_TXN_ID_VERSION_CHANNEL:
+			expected_nfields = 5;
+			nfields = sscanf(id_string,
+							 FMT_PATTERN_CHANNEL "%c",
+							 &id->version,
+							 &id->xid,
+							 &id->id.server_id,
+							 &id->id.user_id,
+							 &id->channel,
+							 &dummy);
+			break;
+		default:
+			elog(ERROR, "invalid version for remote transaction ID: %hhu", id->version);
+	}
+
+	if (nfields != expected_nfields)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				 errmsg("invalid input syntax for remote transaction ID: '%s'", id_string)));
 
 	return id;
 }
@@ -102,13 +130,23 @@ remote_txn_id_out(const RemoteTxnId *id)
 	char *out = palloc0(sizeof(char) * GID_MAX_SIZE);
 	int written;
 
-	written = snprintf(out,
-					   GID_MAX_SIZE,
-					   FMT_PATTERN,
-					   REMOTE_TXN_ID_VERSION,
-					   id->xid,
-					   id->id.server_id,
-					   id->id.user_id);
+	if (id->channel == 0)
+		written = snprintf(out,
+						   GID_MAX_SIZE,
+						   FMT_PATTERN,
+						   REMOTE_TXN_ID_VERSION,
+						   id->xid,
+						   id->id.server_id,
+						   id->id.user_id);
+	else
+		written = snprintf(out,
+						   GID_MAX_SIZE,
+						   FMT_PATTERN_CHANNEL,
+						   REMOTE_TXN_ID_VERSION_CHANNEL,
+						   id->xid,
+						   id->id.server_id,
+						   id->id.user_id,
+						   id->channel);
 
 	if (written < 0 || written >= GID_MAX_SIZE)
 		elog(ERROR, "unexpected length when generating a 2pc transaction name: %d", written);
@@ -129,8 +167,12 @@ remote_txn_id_create(TransactionId xid, TSConnectionId cid)
 {
 	RemoteTxnId *id = palloc0(sizeof(RemoteTxnId));
 
+	Assert(cid.channel <= PG_UINT8_MAX);
+
 	id->xid = xid;
-	id->id = cid;
+	id->id.server_id = cid.server_id;
+	id->id.user_id = cid.user_id;
+	id->channel = (uint8) cid.channel;
 
 	return id;
 }
@@ -35,6 +35,13 @@
  * - pair of server_id and user_id dedups the connections made under different
  * TSConnectionId mappings as part of the same access node's distributed txn.
  *
+ * Extra connections to the same data node (a non-zero TSConnectionId channel)
+ * use version 2 of the format, which appends the channel:
+ * version;xid;server_id;user_id;channel.
+ *
+ * The struct has to fit the fixed internal length of the rxid type, so it
+ * stores the parts of the TSConnectionId separately.
+ *
  * Note: When moving to multiple access nodes, we'll need to add a unique prefix for
  * each access node.
  */
@@ -42,9 +49,14 @@
 typedef struct RemoteTxnId
 {
 	uint8 version;
-	char reserved[3]; /* not currently serialized */
+	uint8 channel;	  /* only serialized in version 2 */
+	char reserved[2]; /* not currently serialized */
 	TransactionId xid;
-	TSConnectionId id;
+	struct
+	{
+		Oid server_id;
+		Oid user_id;
+	} id;
 } RemoteTxnId;
 
 extern RemoteTxnId *remote_txn_id_create(TransactionId xid, TSConnectionId id);
@@ -8,11 +8,15 @@
 #include <utils/guc.h>
 #include <utils/snapmgr.h>
 #include <utils/fmgroids.h>
+#include <utils/array.h>
+#include <utils/memutils.h>
+#include <catalog/pg_type.h>
 #include <access/xact.h>
 #include <access/transam.h>
 #include <miscadmin.h>
 
 #include "txn_resolve.h"
+#include "async.h"
 #include "connection.h"
 #include "txn.h"
 
@@ -53,155 +57,228 @@ remote_txn_resolution(Oid foreign_server, const RemoteTxnId *transaction_id)
  * Note that pg_prepared_xacts shared across other databases which
  * also could be distributed. Right now we interested only in
  * the current one.
+ *
+ * The resolution of a transaction is a lookup in the local remote_txn table,
+ * but the COMMIT PREPARED and ROLLBACK PREPARED that follow are a round trip
+ * each. So, the commands are sent in batches in pipeline mode, and several
+ * data nodes are healed at the same time.
  */
 #define GET_PREPARED_XACT_SQL                                                                      \
 	"SELECT gid FROM pg_prepared_xacts WHERE database = current_database()"
 
-Datum
-remote_txn_heal_data_node(PG_FUNCTION_ARGS)
-{
-	Oid foreign_server_oid = PG_GETARG_OID(0);
-	TSConnection *conn = remote_connection_open(foreign_server_oid, GetUserId());
-	int resolved = 0;
+/*
+ * The maximum number of COMMIT PREPARED and ROLLBACK PREPARED commands in
+ * flight on a data node in pipeline mode.
+ */
+#define HEAL_BATCH_SIZE 1000
 
+typedef struct HealDataNodeState
+{
+	Oid foreign_server_oid;
 	/*
 	 * Use a raw connection since you need to be out of transaction to do
 	 * COMMIT/ROLLBACK PREPARED
 	 */
-	PGresult *res;
-	int row;
-	List *in_progress_txn_gids = NIL, *healed_txn_gids = NIL;
-	int non_ts_txns = 0, ntuples;
+	TSConnection *conn;
+	AsyncResponseResult *xacts;
+	int ntuples;
+	int next_row;
+	int non_ts_txns;
+	int resolved;
+	List *in_progress_txn_gids;
+	List *healed_txn_gids;
+} HealDataNodeState;
+
+/* A COMMIT PREPARED or ROLLBACK PREPARED in flight */
+typedef struct HealTxn
+{
+	HealDataNodeState *state;
+	char *id_string;
+	RemoteTxnResolution resolution;
+} HealTxn;
+
 #ifdef TS_DEBUG
-	int n_gid_errors = 0; /* how many errors to induce? */
+static int n_gid_errors = 0; /* how many errors to induce? */
 #endif
 
+static RemoteTxnResolution
+heal_txn_resolution(HealDataNodeState *state, RemoteTxnId *tpc_gid)
+{
+	RemoteTxnResolution resolution = remote_txn_resolution(state->foreign_server_oid, tpc_gid);
+
+#ifdef TS_DEBUG
 	/*
-	 * This function cannot be called inside a transaction block since effects
-	 * cannot be rolled back
+	 * Induce an error in the GID so that the remote side errors out when it tries
+	 * to heal it.
+	 *
+	 * We inject the error by checking the value of the below session variable. Not
+	 * a full GUC, just a tool to allow us to randomly inject error for testing
+	 * purposes. Depending on the value we will inject an error in the GID and also
+	 * additionally change the resolution as per the accepted value:
+	 *
+	 * "commit"  : change GID + set resolution as COMMITTED
+	 * "abort"   : change GID + set resolution as ABORTED
+	 * "inprogress" : set resolution as IN_PROGRESS
+	 *
+	 * Any other setting will not have any effect
+	 *
+	 * We currently induce error in one GID processing. If needed this can be
+	 * changed in the future via another session variable to set to a specific
+	 * number of errors to induce. Note that this variable is incremented only
+	 * for valid values of "timescaledb.debug_inject_gid_error.
+	 *
+	 * Current logic also means that the first GID being processed will always
+	 * induce a change in resolution behavior. But that's ok, we could randomize
+	 * it later to any arbitrary integer value less than ntuples in the future.
 	 */
-	PreventInTransactionBlock(true, "remote_txn_heal_data_node");
+	if (n_gid_errors < 1)
+	{
+		const char *inject_gid_error =
+			GetConfigOption("timescaledb.debug_inject_gid_error", true, false);
+
+		/* increment the user_id field to cause mismatch in GID */
+		if (inject_gid_error)
+		{
+			if (strcmp(inject_gid_error, "abort") == 0)
+			{
+				tpc_gid->id.user_id++;
+				resolution = REMOTE_TXN_RESOLUTION_ABORT;
+				n_gid_errors++;
+			}
+			else if (strcmp(inject_gid_error, "commit") == 0)
+			{
+				tpc_gid->id.user_id++;
+				resolution = REMOTE_TXN_RESOLUTION_COMMIT;
+				n_gid_errors++;
+			}
+			else if (strcmp(inject_gid_error, "inprogress") == 0)
+			{
+				resolution = REMOTE_TXN_RESOLUTION_IN_PROGRESS;
+				n_gid_errors++;
+			}
+			/* any other value is simply ignored, n_gid_errors is also not incremented */
+		}
+	}
+#endif
 
-	res = remote_connection_query_ok(conn, GET_PREPARED_XACT_SQL);
+	return resolution;
+}
 
-	Assert(1 == PQnfields(res));
-	ntuples = PQntuples(res);
-	for (row = 0; row < ntuples; row++)
+/*
+ * Send the next batch of COMMIT PREPARED and ROLLBACK PREPARED commands to a
+ * data node. Without pipeline mode, a batch is a single command.
+ *
+ * The per-batch allocations go into the batch memory context, while the
+ * lists of the data node state are kept in the caller's context.
+ */
+static int
+heal_data_node_send_batch(HealDataNodeState *state, AsyncRequestSet *reqset,
+						  MemoryContext batch_mcxt)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(batch_mcxt);
+	int max_in_flight = 1;
+	int num_sent = 0;
+
+	if (remote_connection_enter_pipeline_mode(state->conn))
+		max_in_flight = HEAL_BATCH_SIZE;
+
+	while (state->next_row < state->ntuples && num_sent < max_in_flight)
 	{
-		char *id_string = PQgetvalue(res, row, 0);
+		PGresult *res = async_response_result_get_pg_result(state->xacts);
+		char *id_string = PQgetvalue(res, state->next_row++, 0);
 		RemoteTxnId *tpc_gid;
-		RemoteTxnResolution resolution;
+		HealTxn *txn;
+		AsyncRequest *req;
+		const char *sql = NULL;
 
 		if (!remote_txn_id_matches_prepared_txn(id_string))
 		{
-			non_ts_txns++;
+			state->non_ts_txns++;
 			continue;
 		}
 
 		tpc_gid = remote_txn_id_in(id_string);
-		resolution = remote_txn_resolution(foreign_server_oid, tpc_gid);
-
-#ifdef TS_DEBUG
-		/*
-		 * Induce an error in the GID so that the remote side errors out when it tries
-		 * to heal it.
-		 *
-		 * We inject the error by checking the value of the below session variable. Not
-		 * a full GUC, just a tool to allow us to randomly inject error for testing
-		 * purposes. Depending on the value we will inject an error in the GID and also
-		 * additionally change the resolution as per the accepted value:
-		 *
-		 * "commit"  : change GID + set resolution as COMMITTED
-		 * "abort"   : change GID + set resolution as ABORTED
-		 * "inprogress" : set resolution as IN_PROGRESS
-		 *
-		 * Any other setting will not have any effect
-		 *
-		 * We currently induce error in one GID processing. If needed this can be
-		 * changed in the future via another session variable to set to a specific
-		 * number of errors to induce. Note that this variable is incremented only
-		 * for valid values of "timescaledb.debug_inject_gid_error.
-		 *
-		 * Current logic also means that the first GID being processed will always
-		 * induce a change in resolution behavior. But that's ok, we could randomize
-		 * it later to any arbitrary integer value less than ntuples in the future.
-		 */
-		if (n_gid_errors < 1)
-		{
-			const char *inject_gid_error =
-				GetConfigOption("timescaledb.debug_inject_gid_error", true, false);
+		txn = palloc(sizeof(HealTxn));
+		txn->state = state;
+		txn->id_string = id_string;
+		txn->resolution = heal_txn_resolution(state, tpc_gid);
 
-			/* increment the user_id field to cause mismatch in GID */
-			if (inject_gid_error)
-			{
-				if (strcmp(inject_gid_error, "abort") == 0)
-				{
-					tpc_gid->id.user_id++;
-					resolution = REMOTE_TXN_RESOLUTION_ABORT;
-					n_gid_errors++;
-				}
-				else if (strcmp(inject_gid_error, "commit") == 0)
-				{
-					tpc_gid->id.user_id++;
-					resolution = REMOTE_TXN_RESOLUTION_COMMIT;
-					n_gid_errors++;
-				}
-				else if (strcmp(inject_gid_error, "inprogress") == 0)
-				{
-					resolution = REMOTE_TXN_RESOLUTION_IN_PROGRESS;
-					n_gid_errors++;
-				}
-				/* any other value is simply ignored, n_gid_errors is also not incremented */
-			}
-		}
-#endif
-		/*
-		 * We don't expect these commands to fail, but if they do, continue and move on to
-		 * healing up the next GID in the list. The ones that failed will get retried if
-		 * they are still around on the datanodes the next time over.
-		 */
-		switch (resolution)
+		switch (txn->resolution)
 		{
 			case REMOTE_TXN_RESOLUTION_COMMIT:
-				if (PQresultStatus(
-						remote_connection_exec(conn, remote_txn_id_commit_prepared_sql(tpc_gid))) ==
-					PGRES_COMMAND_OK)
-				{
-					healed_txn_gids = lappend(healed_txn_gids, id_string);
-					resolved++;
-				}
-				else
-					ereport(WARNING,
-							(errmsg("could not commit prepared transaction on data node \"%s\"",
-									remote_connection_node_name(conn)),
-							 errhint("To retry, manually run \"COMMIT PREPARED %s\" on the data "
-									 "node or run the healing function again.",
-									 id_string)));
+				sql = remote_txn_id_commit_prepared_sql(tpc_gid);
 				break;
 			case REMOTE_TXN_RESOLUTION_ABORT:
-				if (PQresultStatus(remote_connection_exec(conn,
-														  remote_txn_id_rollback_prepared_sql(
-															  tpc_gid))) == PGRES_COMMAND_OK)
-				{
-					healed_txn_gids = lappend(healed_txn_gids, id_string);
-					resolved++;
-				}
-				else
-					ereport(WARNING,
-							(errmsg("could not roll back prepared transaction on data node \"%s\"",
-									remote_connection_node_name(conn)),
-							 errhint("To retry, manually run \"ROLLBACK PREPARED %s\" on the data "
-									 "node or run the healing function again.",
-									 id_string)));
+				sql = remote_txn_id_rollback_prepared_sql(tpc_gid);
 				break;
 			case REMOTE_TXN_RESOLUTION_IN_PROGRESS:
-				in_progress_txn_gids = lappend(in_progress_txn_gids, id_string);
-				break;
+				MemoryContextSwitchTo(oldcontext);
+				state->in_progress_txn_gids = lappend(state->in_progress_txn_gids, id_string);
+				MemoryContextSwitchTo(batch_mcxt);
+				continue;
+		}
+
+		req = async_request_send(state->conn, sql);
+		async_request_attach_user_data(req, txn);
+		async_request_set_add(reqset, req);
+		num_sent++;
+	}
+
+	/* Nothing is in flight, so the connection can leave pipeline mode right away */
+	if (num_sent == 0)
+		remote_connection_exit_pipeline_mode(state->conn);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return num_sent;
+}
+
+/*
+ * Wait for the responses of all the commands in flight.
+ *
+ * We don't expect these commands to fail, but if they do, continue and move on to
+ * healing up the next GID in the list. The ones that failed will get retried if
+ * they are still around on the datanodes the next time over.
+ */
+static void
+heal_await_responses(AsyncRequestSet *reqset)
+{
+	AsyncResponseResult *rsp;
+
+	while ((rsp = async_request_set_wait_any_result(reqset)))
+	{
+		HealTxn *txn = async_response_result_get_user_data(rsp);
+		HealDataNodeState *state = txn->state;
+
+		if (PQresultStatus(async_response_result_get_pg_result(rsp)) == PGRES_COMMAND_OK)
+		{
+			state->healed_txn_gids = lappend(state->healed_txn_gids, txn->id_string);
+			state->resolved++;
 		}
+		else if (txn->resolution == REMOTE_TXN_RESOLUTION_COMMIT)
+			ereport(WARNING,
+					(errmsg("could not commit prepared transaction on data node \"%s\"",
+							remote_connection_node_name(state->conn)),
+					 errhint("To retry, manually run \"COMMIT PREPARED %s\" on the data "
+							 "node or run the healing function again.",
+							 txn->id_string)));
+		else
+			ereport(WARNING,
+					(errmsg("could not roll back prepared transaction on data node \"%s\"",
+							remote_connection_node_name(state->conn)),
+					 errhint("To retry, manually run \"ROLLBACK PREPARED %s\" on the data "
+							 "node or run the healing function again.",
+							 txn->id_string)));
+
+		async_response_result_close(rsp);
 	}
+}
 
-	if (non_ts_txns > 0)
-		elog(NOTICE, "skipping %d non-TimescaleDB prepared transaction", non_ts_txns);
+static void
+heal_data_node_finish(HealDataNodeState *state)
+{
+	if (state->non_ts_txns > 0)
+		elog(NOTICE, "skipping %d non-TimescaleDB prepared transaction", state->non_ts_txns);
 
 	/*
 	 * Perform cleanup of all records if there are no in progress txns and if the number of
@@ -212,18 +289,131 @@ remote_txn_heal_data_node(PG_FUNCTION_ARGS)
 	 * table. So, we track healed gids in a list and delete those specific rows to keep the
 	 * "remote_txn" table from growing up indefinitely.
 	 */
-	if (list_length(in_progress_txn_gids) == 0 && resolved == ntuples)
-		remote_txn_persistent_record_delete_for_data_node(foreign_server_oid, NULL);
-	else if (resolved)
+	if (list_length(state->in_progress_txn_gids) == 0 && state->resolved == state->ntuples)
+		remote_txn_persistent_record_delete_for_data_node(state->foreign_server_oid, NULL);
+	else if (state->resolved)
 	{
 		ListCell *lc;
-		Assert(healed_txn_gids != NIL);
+		Assert(state->healed_txn_gids != NIL);
+
+		foreach (lc, state->healed_txn_gids)
+			remote_txn_persistent_record_delete_for_data_node(state->foreign_server_oid,
+															  lfirst(lc));
+	}
+
+	async_response_result_close(state->xacts);
+	remote_connection_close(state->conn);
+}
+
+/*
+ * Heal the given data nodes in parallel and return the total number of
+ * resolved transactions.
+ */
+static int
+heal_data_nodes(Oid *foreign_server_oids, int num_data_nodes)
+{
+	HealDataNodeState *states = palloc0(sizeof(HealDataNodeState) * num_data_nodes);
+	AsyncRequest **reqs = palloc(sizeof(AsyncRequest *) * num_data_nodes);
+	MemoryContext batch_mcxt =
+		AllocSetContextCreate(CurrentMemoryContext, "Heal batch", ALLOCSET_DEFAULT_SIZES);
+	int resolved = 0;
+	int i;
+
+#ifdef TS_DEBUG
+	n_gid_errors = 0;
+#endif
+
+	/* Fetch the prepared transactions from all the data nodes at once */
+	for (i = 0; i < num_data_nodes; i++)
+	{
+		states[i].foreign_server_oid = foreign_server_oids[i];
+		states[i].conn = remote_connection_open(foreign_server_oids[i], GetUserId());
+		reqs[i] = async_request_send(states[i].conn, GET_PREPARED_XACT_SQL);
+	}
+
+	for (i = 0; i < num_data_nodes; i++)
+	{
+		states[i].xacts = async_request_wait_ok_result(reqs[i]);
+		Assert(1 == PQnfields(async_response_result_get_pg_result(states[i].xacts)));
+		states[i].ntuples = PQntuples(async_response_result_get_pg_result(states[i].xacts));
+	}
+
+	for (;;)
+	{
+		MemoryContext oldcontext;
+		AsyncRequestSet *reqset;
+		int num_sent = 0;
+
+		MemoryContextReset(batch_mcxt);
+		oldcontext = MemoryContextSwitchTo(batch_mcxt);
+		reqset = async_request_set_create();
+		MemoryContextSwitchTo(oldcontext);
 
-		foreach (lc, healed_txn_gids)
-			remote_txn_persistent_record_delete_for_data_node(foreign_server_oid, lfirst(lc));
+		for (i = 0; i < num_data_nodes; i++)
+			num_sent += heal_data_node_send_batch(&states[i], reqset, batch_mcxt);
+
+		if (num_sent == 0)
+			break;
+
+		heal_await_responses(reqset);
+
+		for (i = 0; i < num_data_nodes; i++)
+			remote_connection_exit_pipeline_mode(states[i].conn);
+	}
+
+	for (i = 0; i < num_data_nodes; i++)
+	{
+		heal_data_node_finish(&states[i]);
+		resolved += states[i].resolved;
+	}
+
+	MemoryContextDelete(batch_mcxt);
+
+	return resolved;
+}
+
+Datum
+remote_txn_heal_data_node(PG_FUNCTION_ARGS)
+{
+	Oid foreign_server_oid = PG_GETARG_OID(0);
+
+	/*
+	 * This function cannot be called inside a transaction block since effects
+	 * cannot be rolled back
+	 */
+	PreventInTransactionBlock(true, "remote_txn_heal_data_node");
+
+	PG_RETURN_INT32(heal_data_nodes(&foreign_server_oid, 1));
+}
+
+Datum
+remote_txn_heal_data_nodes(PG_FUNCTION_ARGS)
+{
+	ArrayType *foreign_server_arr = PG_GETARG_ARRAYTYPE_P(0);
+	Datum *elems;
+	bool *nulls;
+	int nelems;
+	Oid *foreign_server_oids;
+	int num_data_nodes = 0;
+	int i;
+
+	PreventInTransactionBlock(true, "remote_txn_heal_data_nodes");
+
+	deconstruct_array(foreign_server_arr,
+					  OIDOID,
+					  sizeof(Oid),
+					  true,
+					  TYPALIGN_INT,
+					  &elems,
+					  &nulls,
+					  &nelems);
+	foreign_server_oids = palloc(sizeof(Oid) * Max(nelems, 1));
+
+	for (i = 0; i < nelems; i++)
+	{
+		if (!nulls[i])
+			foreign_server_oids[num_data_nodes++] = DatumGetObjectId(elems[i]);
 	}
 
-	remote_result_close(res);
-	remote_connection_close(conn);
-	PG_RETURN_INT32(resolved);
+	PG_RETURN_INT32(heal_data_nodes(foreign_server_oids, num_data_nodes));
 }
@@ -16,6 +16,7 @@
 #include "utils.h"
 #include <postgres.h>
 #include <access/amapi.h>
+#include <access/heapam.h>
 #include <access/multixact.h>
 #include <access/relscan.h>
 #include <access/rewriteheap.h>
@@ -35,6 +36,7 @@
 #include <commands/tablecmds.h>
 #include <commands/tablespace.h>
 #include <commands/vacuum.h>
+#include <executor/executor.h>
 #include <miscadmin.h>
 #include <nodes/pg_list.h>
 #include <optimizer/planner.h>
@@ -47,6 +49,7 @@
 #include <utils/builtins.h>
 #include <utils/fmgroids.h>
 #include <utils/guc.h>
+#include <utils/hsearch.h>
 #include <utils/inval.h>
 #include <utils/lsyscache.h>
 #include <utils/memutils.h>
@@ -66,9 +69,11 @@
 #endif
 
 #include "annotations.h"
+#include "bgw/job_history.h"
 #include "chunk.h"
 #include "chunk_copy.h"
 #include "chunk_index.h"
+#include "guc.h"
 #include "hypertable_cache.h"
 #include "indexing.h"
 #include "reorder.h"
@@ -80,10 +85,15 @@ static void reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id,
 #define REORDER_ACCESS_EXCLUSIVE_DEADLOCK_TIMEOUT "101000"
 
 static void rebuild_relation(Relation OldHeap, Oid indexOid, bool verbose, Oid wait_id,
-							 Oid destination_tablespace, Oid index_tablespace);
+							 Oid destination_tablespace, Oid index_tablespace, bool concurrent);
 static void copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 						   bool *pSwapToastByContent, TransactionId *pFreezeXid,
 						   MultiXactId *pCutoffMulti);
+static List *copy_heap_data_concurrently(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex,
+										 bool verbose, Oid index_tablespace,
+										 List **old_index_oids, TransactionId *pFreezeXid,
+										 MultiXactId *pCutoffMulti);
+static bool reorder_tid_map_fits(Relation OldHeap);
 
 static void finish_heap_swaps(Oid OIDOldHeap, Oid OIDNewHeap, List *old_index_oids,
 							  List *new_index_oids, bool swap_toast_by_content, bool is_internal,
@@ -469,6 +479,7 @@ reorder_chunk(Oid chunk_id, Oid index_id, bool verbose, Oid wait_id, Oid destina
 				wait_id,
 				destination_tablespace,
 				index_tablespace);
+	ts_job_history_add_chunks(1);
 	ts_cache_release(hcache);
 }
 
@@ -520,6 +531,8 @@ reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id, Oid destinati
 	Relation OldHeap;
 	HeapTuple tuple;
 	Form_pg_index indexForm;
+	bool concurrent = ts_guc_enable_concurrent_reorder;
+	LOCKMODE lockmode = concurrent ? ShareUpdateExclusiveLock : ExclusiveLock;
 
 	if (!OidIsValid(indexOid))
 		elog(ERROR, "Reorder must specify an index.");
@@ -527,13 +540,46 @@ reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id, Oid destinati
 	/* Check for user-requested abort. */
 	CHECK_FOR_INTERRUPTS();
 
+	/*
+	 * A concurrent reorder copies the rows visible to new snapshots rather
+	 * than to the transaction snapshot.
+	 */
+	if (concurrent && IsolationUsesXactSnapshot())
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("concurrent reorder is not supported with isolation level \"%s\"",
+						XactIsoLevel == XACT_SERIALIZABLE ? "serializable" : "repeatable read"),
+				 errhint("Use isolation level \"read committed\" or disable "
+						 "timescaledb.enable_concurrent_reorder.")));
+
 	/*
 	 * We grab exclusive access to the target rel and index for the duration
 	 * of the transaction.  (This is redundant for the single-transaction
 	 * case, since cluster() already did it.)  The index lock is taken inside
 	 * check_index_is_clusterable.
+	 *
+	 * A concurrent reorder only blocks other DDL and vacuum while it copies
+	 * the data, and takes stronger locks at the end (see
+	 * copy_heap_data_concurrently()).
+	 */
+	OldHeap = try_relation_open(tableOid, lockmode);
+
+	/*
+	 * A concurrent reorder keeps the location of every row in memory, so
+	 * reorder chunks with too many rows while blocking writers instead.
 	 */
-	OldHeap = try_relation_open(tableOid, ExclusiveLock);
+	if (OldHeap != NULL && concurrent && !reorder_tid_map_fits(OldHeap))
+	{
+		ereport(NOTICE,
+				(errmsg("reordering \"%s\" without allowing concurrent writes",
+						RelationGetRelationName(OldHeap)),
+				 errdetail("Tracking the rows of the chunk exceeds \"maintenance_work_mem\"."),
+				 errhint("Increase \"maintenance_work_mem\" to reorder the chunk concurrently.")));
+		relation_close(OldHeap, lockmode);
+		concurrent = false;
+		lockmode = ExclusiveLock;
+		OldHeap = try_relation_open(tableOid, lockmode);
+	}
 
 	/* If the table has gone away, we can skip processing it */
 	if (!OldHeap)
@@ -549,7 +595,7 @@ reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id, Oid destinati
 	/* Check that the user still owns the relation */
 	if (!pg_class_ownercheck(tableOid, GetUserId()))
 	{
-		relation_close(OldHeap, ExclusiveLock);
+		relation_close(OldHeap, lockmode);
 		ereport(WARNING, (errcode(ERRCODE_WARNING), errmsg("ownership changed during reorder")));
 		return;
 	}
@@ -580,7 +626,7 @@ reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id, Oid destinati
 	if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(indexOid)))
 	{
 		ereport(WARNING, (errcode(ERRCODE_WARNING), errmsg("index disappeared during reorder")));
-		relation_close(OldHeap, ExclusiveLock);
+		relation_close(OldHeap, lockmode);
 		return;
 	}
 
@@ -591,7 +637,7 @@ reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id, Oid destinati
 	if (!HeapTupleIsValid(tuple)) /* probably can't happen */
 	{
 		ereport(WARNING, (errcode(ERRCODE_WARNING), errmsg("invalid index heap during reorder")));
-		relation_close(OldHeap, ExclusiveLock);
+		relation_close(OldHeap, lockmode);
 		return;
 	}
 	indexForm = (Form_pg_index) GETSTRUCT(tuple);
@@ -612,10 +658,16 @@ reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id, Oid destinati
 	CheckTableNotInUse(OldHeap, "CLUSTER");
 
 	/* Check heap and index are valid to cluster on */
-	check_index_is_clusterable_compat(OldHeap, indexOid, ExclusiveLock);
+	check_index_is_clusterable_compat(OldHeap, indexOid, lockmode);
 
 	/* rebuild_relation does all the dirty work */
-	rebuild_relation(OldHeap, indexOid, verbose, wait_id, destination_tablespace, index_tablespace);
+	rebuild_relation(OldHeap,
+					 indexOid,
+					 verbose,
+					 wait_id,
+					 destination_tablespace,
+					 index_tablespace,
+					 concurrent);
 
 	/* NB: rebuild_relation does table_close() on OldHeap */
 }
@@ -623,14 +675,15 @@ reorder_rel(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id, Oid destinati
 /*
  * rebuild_relation: rebuild an existing relation in index or physical order
  *
- * OldHeap: table to rebuild --- must be opened and exclusive-locked!
+ * OldHeap: table to rebuild --- must be opened and exclusive-locked, or
+ * share-update-exclusive-locked for a concurrent rebuild!
  * indexOid: index to cluster by, or InvalidOid to rewrite in physical order.
  *
  * NB: this routine closes OldHeap at the right time; caller should not.
  */
 static void
 rebuild_relation(Relation OldHeap, Oid indexOid, bool verbose, Oid wait_id,
-				 Oid destination_tablespace, Oid index_tablespace)
+				 Oid destination_tablespace, Oid index_tablespace, bool concurrent)
 {
 	Oid tableOid = RelationGetRelid(OldHeap);
 	Oid tableSpace = OidIsValid(destination_tablespace) ? destination_tablespace :
@@ -659,18 +712,38 @@ rebuild_relation(Relation OldHeap, Oid indexOid, bool verbose, Oid wait_id,
 									  relpersistence,
 									  ExclusiveLock);
 
-	/* Copy the heap data into the new table in the desired order */
-	copy_heap_data(OIDNewHeap,
-				   tableOid,
-				   indexOid,
-				   verbose,
-				   &swap_toast_by_content,
-				   &frozenXid,
-				   &cutoffMulti);
-
-	/* Create versions of the tables indexes for the new table */
-	new_index_oids =
-		ts_chunk_index_duplicate(tableOid, OIDNewHeap, &old_index_oids, index_tablespace);
+	if (concurrent)
+	{
+		/*
+		 * Copy the heap data and create the indexes of the new table while
+		 * writers continue, then catch up with their changes. The new table
+		 * has its own toast data, so toast tables are swapped by links.
+		 */
+		new_index_oids = copy_heap_data_concurrently(OIDNewHeap,
+													 tableOid,
+													 indexOid,
+													 verbose,
+													 index_tablespace,
+													 &old_index_oids,
+													 &frozenXid,
+													 &cutoffMulti);
+		swap_toast_by_content = false;
+	}
+	else
+	{
+		/* Copy the heap data into the new table in the desired order */
+		copy_heap_data(OIDNewHeap,
+					   tableOid,
+					   indexOid,
+					   verbose,
+					   &swap_toast_by_content,
+					   &frozenXid,
+					   &cutoffMulti);
+
+		/* Create versions of the tables indexes for the new table */
+		new_index_oids =
+			ts_chunk_index_duplicate(tableOid, OIDNewHeap, &old_index_oids, index_tablespace);
+	}
 
 	/*
 	 * Swap the physical files of the target and transient tables, then
@@ -687,6 +760,60 @@ rebuild_relation(Relation OldHeap, Oid indexOid, bool verbose, Oid wait_id,
 					  wait_id);
 }
 
+/*
+ * Compute xids used to freeze and weed out dead tuples and multixacts.
+ * Since we're going to rewrite the whole table anyway, there's no reason
+ * not to be aggressive about this.
+ */
+static void
+compute_xid_limits(Relation OldHeap, TransactionId *pOldestXmin, TransactionId *pFreezeXid,
+				   MultiXactId *pCutoffMulti)
+{
+	vacuum_set_xid_limits_compat(OldHeap, 0, 0, 0, 0, pOldestXmin, pFreezeXid, pCutoffMulti);
+
+	/*
+	 * FreezeXid will become the table's new relfrozenxid, and that mustn't go
+	 * backwards, so take the max.
+	 */
+	if (TransactionIdPrecedes(*pFreezeXid, OldHeap->rd_rel->relfrozenxid))
+		*pFreezeXid = OldHeap->rd_rel->relfrozenxid;
+
+	/*
+	 * MultiXactCutoff, similarly, shouldn't go backwards either.
+	 */
+	if (MultiXactIdPrecedes(*pCutoffMulti, OldHeap->rd_rel->relminmxid))
+		*pCutoffMulti = OldHeap->rd_rel->relminmxid;
+}
+
+/* Update pg_class to reflect the correct values of pages and tuples. */
+static void
+update_new_heap_stats(Oid OIDNewHeap, BlockNumber num_pages, double num_tuples)
+{
+	Relation relRelation;
+	HeapTuple reltup;
+	Form_pg_class relform;
+
+	relRelation = table_open(RelationRelationId, RowExclusiveLock);
+
+	reltup = SearchSysCacheCopy1(RELOID, ObjectIdGetDatum(OIDNewHeap));
+	if (!HeapTupleIsValid(reltup))
+		elog(ERROR, "cache lookup failed for relation %u", OIDNewHeap);
+	relform = (Form_pg_class) GETSTRUCT(reltup);
+
+	relform->relpages = num_pages;
+	relform->reltuples = num_tuples;
+
+	/* Don't update the stats for pg_class.  See swap_relation_files. */
+	CacheInvalidateRelcacheByTuple(reltup);
+
+	/* Clean up. */
+	heap_freetuple(reltup);
+	table_close(relRelation, RowExclusiveLock);
+
+	/* Make the update visible */
+	CommandCounterIncrement();
+}
+
 /*
  * Do the physical copying of heap data.
  *
@@ -700,9 +827,6 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 			   bool *pSwapToastByContent, TransactionId *pFreezeXid, MultiXactId *pCutoffMulti)
 {
 	Relation NewHeap, OldHeap, OldIndex;
-	Relation relRelation;
-	HeapTuple reltup;
-	Form_pg_class relform;
 	TupleDesc PG_USED_FOR_ASSERTS_ONLY oldTupDesc;
 	TupleDesc newTupDesc;
 	int natts;
@@ -795,25 +919,7 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	else
 		*pSwapToastByContent = false;
 
-	/*
-	 * Compute xids used to freeze and weed out dead tuples and multixacts.
-	 * Since we're going to rewrite the whole table anyway, there's no reason
-	 * not to be aggressive about this.
-	 */
-	vacuum_set_xid_limits_compat(OldHeap, 0, 0, 0, 0, &OldestXmin, &FreezeXid, &MultiXactCutoff);
-
-	/*
-	 * FreezeXid will become the table's new relfrozenxid, and that mustn't go
-	 * backwards, so take the max.
-	 */
-	if (TransactionIdPrecedes(FreezeXid, OldHeap->rd_rel->relfrozenxid))
-		FreezeXid = OldHeap->rd_rel->relfrozenxid;
-
-	/*
-	 * MultiXactCutoff, similarly, shouldn't go backwards either.
-	 */
-	if (MultiXactIdPrecedes(MultiXactCutoff, OldHeap->rd_rel->relminmxid))
-		MultiXactCutoff = OldHeap->rd_rel->relminmxid;
+	compute_xid_limits(OldHeap, &OldestXmin, &FreezeXid, &MultiXactCutoff);
 
 	/* return selected values to caller */
 	*pFreezeXid = FreezeXid;
@@ -884,27 +990,429 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	table_close(OldHeap, NoLock);
 	table_close(NewHeap, NoLock);
 
-	/* Update pg_class to reflect the correct values of pages and tuples. */
-	relRelation = table_open(RelationRelationId, RowExclusiveLock);
+	Assert(OIDOldHeap != RelationRelationId);
+	update_new_heap_stats(OIDNewHeap, num_pages, num_tuples);
+}
 
-	reltup = SearchSysCacheCopy1(RELOID, ObjectIdGetDatum(OIDNewHeap));
-	if (!HeapTupleIsValid(reltup))
-		elog(ERROR, "cache lookup failed for relation %u", OIDNewHeap);
-	relform = (Form_pg_class) GETSTRUCT(reltup);
+/*
+ * There's a risk of deadlock if some other process is also trying to
+ * upgrade their lock in the same manner as us, at this time. Since our
+ * transaction has performed a large amount of work, and only needs to be
+ * run once per chunk, we do not want to abort it due to this deadlock. To
+ * prevent abort we set our `deadlock_timeout` to a large value in the
+ * expectation that the other process will timeout and abort first.
+ * Currently we set `deadlock_timeout` to 1 hour, as this should be longer
+ * than any other normal process, while still allowing the system to make
+ * progress in the event of a real deadlock. As the lock upgrades are the
+ * last locks we grab, and the setting is local to our transaction we do not
+ * bother changing the guc back.
+ */
+static void
+set_upgrade_deadlock_timeout(void)
+{
+	int config_change = set_config_option("deadlock_timeout",
+										  REORDER_ACCESS_EXCLUSIVE_DEADLOCK_TIMEOUT,
+										  PGC_SUSET,
+										  PGC_S_SESSION,
+										  GUC_ACTION_LOCAL,
+										  true,
+										  0,
+										  false);
 
-	relform->relpages = num_pages;
-	relform->reltuples = num_tuples;
+	if (config_change == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("deadlock_timeout guc does not exist.")));
+	else if (config_change < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("could not set deadlock_timeout guc.")));
+}
 
-	/* Don't update the stats for pg_class.  See swap_relation_files. */
-	Assert(OIDOldHeap != RelationRelationId);
-	CacheInvalidateRelcacheByTuple(reltup);
+/*
+ * State of a concurrent copy of the heap data, used to apply the changes
+ * that writers make to the old heap while it is copied.
+ */
+typedef struct ReorderDeltaState
+{
+	Relation old_heap;
+	Relation new_heap;
+	/* Maps the TID of each copied tuple in the old heap to its TID in the new heap */
+	HTAB *tid_map;
+	TupleTableSlot *old_slot;
+	TupleTableSlot *new_slot;
+	BulkInsertState bistate;
+	CommandId cid;
+	/* Set once the indexes of the new heap exist and must be maintained */
+	EState *estate;
+	ResultRelInfo *rri;
+	double num_inserted;
+	double num_deleted;
+} ReorderDeltaState;
+
+typedef struct ReorderTidMapEntry
+{
+	ItemPointerData old_tid; /* hash key */
+	ItemPointerData new_tid;
+} ReorderTidMapEntry;
 
-	/* Clean up. */
-	heap_freetuple(reltup);
-	table_close(relRelation, RowExclusiveLock);
+/* Approximate memory used by an entry of the TID map, including the bucket */
+#define REORDER_TID_MAP_ENTRY_SIZE                                                                 \
+	(MAXALIGN(sizeof(HASHELEMENT)) + MAXALIGN(sizeof(ReorderTidMapEntry)) + sizeof(void *))
 
-	/* Make the update visible */
+/*
+ * Check that the TID map of a concurrent reorder of the relation is
+ * estimated to fit in maintenance_work_mem. The map has an entry for every
+ * row, and unlike the sort of the rows, it can't spill to disk.
+ */
+static bool
+reorder_tid_map_fits(Relation OldHeap)
+{
+	BlockNumber pages;
+	double tuples;
+	double allvisfrac;
+
+	/* Only tables can be reordered, which is checked later */
+	if (OldHeap->rd_rel->relkind != RELKIND_RELATION)
+		return true;
+
+	table_relation_estimate_size(OldHeap, NULL, &pages, &tuples, &allvisfrac);
+
+	return tuples * REORDER_TID_MAP_ENTRY_SIZE <= (double) maintenance_work_mem * 1024L;
+}
+
+/*
+ * Insert the tuple in new_slot, which is a copy of the tuple at old_tid in
+ * the old heap, into the new heap.
+ *
+ * Unlike CLUSTER, the copy does not keep the xmin and xmax of the original
+ * tuple, but is inserted by the current transaction. Like after TRUNCATE,
+ * transactions with a snapshot older than the reorder that did not access
+ * the chunk before then see it empty, rather than seeing rows committed
+ * after their snapshot.
+ */
+static void
+reorder_delta_insert(ReorderDeltaState *state, ItemPointer old_tid)
+{
+	ReorderTidMapEntry *entry;
+	bool found;
+
+	table_tuple_insert(state->new_heap, state->new_slot, state->cid, 0, state->bistate);
+
+	if (state->rri != NULL && state->rri->ri_NumIndices > 0)
+	{
+		list_free(ExecInsertIndexTuplesCompat(state->rri,
+											  state->new_slot,
+											  state->estate,
+											  false,
+											  false,
+											  NULL,
+											  NIL));
+		ResetPerTupleExprContext(state->estate);
+	}
+
+	entry = hash_search(state->tid_map, old_tid, HASH_ENTER, &found);
+	Assert(!found);
+	entry->new_tid = state->new_slot->tts_tid;
+	ExecClearTuple(state->new_slot);
+	state->num_inserted++;
+}
+
+/*
+ * Delete the copy of the tuple at old_tid in the old heap from the new heap.
+ *
+ * The index entries of the copy are left to vacuum, like for any delete.
+ */
+static void
+reorder_delta_delete(ReorderDeltaState *state, ItemPointer old_tid)
+{
+	ReorderTidMapEntry *entry = hash_search(state->tid_map, old_tid, HASH_REMOVE, NULL);
+
+	if (entry == NULL)
+		elog(ERROR,
+			 "no copy of tuple (%u,%u) found during reorder",
+			 ItemPointerGetBlockNumber(old_tid),
+			 ItemPointerGetOffsetNumber(old_tid));
+
+	simple_heap_delete(state->new_heap, &entry->new_tid);
+	state->num_deleted++;
+}
+
+/*
+ * Apply the changes to the old heap between two snapshots to the new heap.
+ *
+ * The new heap contains the tuples visible to prev_snapshot. Tuples that are
+ * no longer visible to snapshot were deleted or updated, and tuples that
+ * only became visible to it were inserted or are the new versions of
+ * updated tuples. Both snapshots must be registered, so that no tuple
+ * visible to either of them is pruned while we scan.
+ *
+ * The copies are deleted before the new tuples are inserted, so that the new
+ * version of an updated tuple does not conflict with its old version in a
+ * unique index.
+ */
+static void
+reorder_apply_delta(ReorderDeltaState *state, Snapshot prev_snapshot, Snapshot snapshot)
+{
+	TableScanDesc scan = table_beginscan(state->old_heap, SnapshotAny, 0, NULL);
+	List *inserted = NIL;
+	ListCell *lc;
+
+	while (table_scan_getnextslot(scan, ForwardScanDirection, state->old_slot))
+	{
+		bool was_visible;
+		bool is_visible;
+
+		CHECK_FOR_INTERRUPTS();
+
+		was_visible =
+			table_tuple_satisfies_snapshot(state->old_heap, state->old_slot, prev_snapshot);
+		is_visible = table_tuple_satisfies_snapshot(state->old_heap, state->old_slot, snapshot);
+
+		if (was_visible && !is_visible)
+			reorder_delta_delete(state, &state->old_slot->tts_tid);
+		else if (!was_visible && is_visible)
+		{
+			ItemPointer tid = palloc(sizeof(ItemPointerData));
+
+			ItemPointerCopy(&state->old_slot->tts_tid, tid);
+			inserted = lappend(inserted, tid);
+		}
+	}
+
+	table_endscan(scan);
+
+	foreach (lc, inserted)
+	{
+		ItemPointer tid = lfirst(lc);
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (!table_tuple_fetch_row_version(state->old_heap, tid, snapshot, state->old_slot))
+			elog(ERROR,
+				 "could not fetch tuple (%u,%u) during reorder",
+				 ItemPointerGetBlockNumber(tid),
+				 ItemPointerGetOffsetNumber(tid));
+
+		ExecCopySlot(state->new_slot, state->old_slot);
+		reorder_delta_insert(state, tid);
+	}
+
+	list_free_deep(inserted);
+	ExecClearTuple(state->old_slot);
+}
+
+/*
+ * Copy the tuples of the old heap visible to the snapshot into the new heap,
+ * in the order of the index.
+ */
+static void
+reorder_copy_snapshot(ReorderDeltaState *state, Relation OldIndex, Snapshot snapshot,
+					  int elevel)
+{
+	Relation OldHeap = state->old_heap;
+
+	if (OldIndex->rd_rel->relam == BTREE_AM_OID)
+	{
+		Tuplesortstate *tuplesort;
+		TableScanDesc scan;
+		HeapTuple tuple;
+
+		ereport(elevel,
+				(errmsg("reordering \"%s.%s\" concurrently using sequential scan and sort",
+						get_namespace_name(RelationGetNamespace(OldHeap)),
+						RelationGetRelationName(OldHeap))));
+
+		/* The sort keeps the TID of each tuple, see copytup_cluster() */
+		tuplesort = tuplesort_begin_cluster(RelationGetDescr(OldHeap),
+											OldIndex,
+											maintenance_work_mem,
+											NULL,
+											false);
+
+		scan = table_beginscan(OldHeap, snapshot, 0, NULL);
+
+		while (table_scan_getnextslot(scan, ForwardScanDirection, state->old_slot))
+		{
+			bool should_free;
+
+			CHECK_FOR_INTERRUPTS();
+
+			tuple = ExecFetchSlotHeapTuple(state->old_slot, false, &should_free);
+			tuplesort_putheaptuple(tuplesort, tuple);
+
+			if (should_free)
+				heap_freetuple(tuple);
+		}
+
+		table_endscan(scan);
+		ExecClearTuple(state->old_slot);
+
+		tuplesort_performsort(tuplesort);
+
+		while ((tuple = tuplesort_getheaptuple(tuplesort, true)) != NULL)
+		{
+			ItemPointerData old_tid = tuple->t_self;
+
+			CHECK_FOR_INTERRUPTS();
+
+			ExecStoreHeapTuple(tuple, state->new_slot, false);
+			reorder_delta_insert(state, &old_tid);
+		}
+
+		tuplesort_end(tuplesort);
+	}
+	else
+	{
+		IndexScanDesc scan;
+
+		ereport(elevel,
+				(errmsg("reordering \"%s.%s\" concurrently using index scan on \"%s\"",
+						get_namespace_name(RelationGetNamespace(OldHeap)),
+						RelationGetRelationName(OldHeap),
+						RelationGetRelationName(OldIndex))));
+
+		scan = index_beginscan(OldHeap, OldIndex, snapshot, 0, 0);
+		index_rescan(scan, NULL, 0, NULL, 0);
+
+		while (index_getnext_slot(scan, ForwardScanDirection, state->old_slot))
+		{
+			ItemPointerData old_tid = state->old_slot->tts_tid;
+
+			CHECK_FOR_INTERRUPTS();
+
+			ExecCopySlot(state->new_slot, state->old_slot);
+			reorder_delta_insert(state, &old_tid);
+		}
+
+		index_endscan(scan);
+		ExecClearTuple(state->old_slot);
+	}
+}
+
+/*
+ * Copy the heap data and create the indexes of the new heap without
+ * blocking writers of the old heap.
+ *
+ * The old heap is only locked against DDL and vacuum. The tuples visible to
+ * a snapshot are copied in index order and the indexes of the new heap are
+ * built. The changes that writers made in the meantime are then applied in
+ * a catch-up round, still concurrently with writers. Finally the lock is
+ * upgraded to block writers, and the changes made during the catch-up round
+ * are applied. This takes one sequential scan of the old heap, after which
+ * the caller swaps the heaps under a short ACCESS EXCLUSIVE lock.
+ *
+ * Tuples written during the copy are appended to the new heap and thus not
+ * in index order.
+ *
+ * Returns the indexes of the new heap, in the same order as the indexes of
+ * the old heap returned in old_index_oids.
+ */
+static List *
+copy_heap_data_concurrently(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
+							Oid index_tablespace, List **old_index_oids,
+							TransactionId *pFreezeXid, MultiXactId *pCutoffMulti)
+{
+	ReorderDeltaState state = { 0 };
+	Relation OldIndex;
+	HASHCTL ctl;
+	Snapshot snapshot;
+	Snapshot prev_snapshot;
+	TransactionId OldestXmin;
+	List *new_index_oids;
+	double num_copied;
+	int elevel = verbose ? INFO : DEBUG2;
+	PGRUsage ru0;
+	pg_rusage_init(&ru0);
+
+	state.new_heap = table_open(OIDNewHeap, AccessExclusiveLock);
+	state.old_heap = table_open(OIDOldHeap, ShareUpdateExclusiveLock);
+	OldIndex = index_open(OIDOldIndex, ShareUpdateExclusiveLock);
+
+	/* Keep vacuum away from the toast table, see copy_heap_data() */
+	if (state.old_heap->rd_rel->reltoastrelid)
+		LockRelationOid(state.old_heap->rd_rel->reltoastrelid, ShareUpdateExclusiveLock);
+
+	compute_xid_limits(state.old_heap, &OldestXmin, pFreezeXid, pCutoffMulti);
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(ItemPointerData);
+	ctl.entrysize = sizeof(ReorderTidMapEntry);
+	ctl.hcxt = CurrentMemoryContext;
+	state.tid_map = hash_create("reorder tid map",
+								1024,
+								&ctl,
+								HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	state.old_slot = table_slot_create(state.old_heap, NULL);
+	state.new_slot = MakeSingleTupleTableSlot(RelationGetDescr(state.new_heap), &TTSOpsHeapTuple);
+	state.bistate = GetBulkInsertState();
+	state.cid = GetCurrentCommandId(true);
+
+	/* Copy the tuples visible now in index order */
+	prev_snapshot = RegisterSnapshot(GetLatestSnapshot());
+	reorder_copy_snapshot(&state, OldIndex, prev_snapshot, elevel);
+	num_copied = state.num_inserted;
+
+	index_close(OldIndex, NoLock);
+	CommandCounterIncrement();
+
+	/* Create versions of the tables indexes for the new table */
+	new_index_oids =
+		ts_chunk_index_duplicate(OIDOldHeap, OIDNewHeap, old_index_oids, index_tablespace);
 	CommandCounterIncrement();
+
+	/* From here on, changes must also be added to the indexes of the new heap */
+	state.estate = CreateExecutorState();
+	state.rri = makeNode(ResultRelInfo);
+	InitResultRelInfo(state.rri, state.new_heap, 1, NULL, 0);
+	ExecOpenIndices(state.rri, false);
+#if PG14_LT
+	state.estate->es_result_relation_info = state.rri;
+#endif
+
+	/* Catch up with the changes made during the copy, concurrently with writers */
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	reorder_apply_delta(&state, prev_snapshot, snapshot);
+	UnregisterSnapshot(prev_snapshot);
+	prev_snapshot = snapshot;
+
+	/*
+	 * Block writers and apply the changes made during the catch-up round.
+	 * Acquiring the lock waits for the transactions that are writing to the
+	 * old heap, so the snapshot taken afterwards sees all changes.
+	 */
+	set_upgrade_deadlock_timeout();
+	LockRelationOid(OIDOldHeap, ExclusiveLock);
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	reorder_apply_delta(&state, prev_snapshot, snapshot);
+	UnregisterSnapshot(prev_snapshot);
+	UnregisterSnapshot(snapshot);
+
+	ereport(elevel,
+			(errmsg("\"%s\": copied %.0f row versions, applied %.0f inserted and %.0f deleted "
+					"row versions from concurrent changes",
+					RelationGetRelationName(state.old_heap),
+					num_copied,
+					state.num_inserted - num_copied,
+					state.num_deleted),
+			 errdetail("%s.", pg_rusage_show(&ru0))));
+
+	/* Clean up */
+	ExecCloseIndices(state.rri);
+	FreeExecutorState(state.estate);
+	ExecDropSingleTupleTableSlot(state.old_slot);
+	ExecDropSingleTupleTableSlot(state.new_slot);
+	FreeBulkInsertState(state.bistate);
+	hash_destroy(state.tid_map);
+
+	update_new_heap_stats(OIDNewHeap,
+						  RelationGetNumberOfBlocks(state.new_heap),
+						  state.num_inserted - state.num_deleted);
+
+	table_close(state.old_heap, NoLock);
+	table_close(state.new_heap, NoLock);
+
+	return new_index_oids;
 }
 
 /*
@@ -923,7 +1431,6 @@ finish_heap_swaps(Oid OIDOldHeap, Oid OIDNewHeap, List *old_index_oids, List *ne
 	Relation oldHeapRel;
 	ListCell *old_index_cell;
 	ListCell *new_index_cell;
-	int config_change;
 
 #ifdef DEBUG
 
@@ -940,36 +1447,7 @@ finish_heap_swaps(Oid OIDOldHeap, Oid OIDNewHeap, List *old_index_oids, List *ne
 	}
 #endif
 
-	/*
-	 * There's a risk of deadlock if some other process is also trying to
-	 * upgrade their lock in the same manner as us, at this time. Since our
-	 * transaction has performed a large amount of work, and only needs to be
-	 * run once per chunk, we do not want to abort it due to this deadlock. To
-	 * prevent abort we set our `deadlock_timeout` to a large value in the
-	 * expectation that the other process will timeout and abort first.
-	 * Currently we set `deadlock_timeout` to 1 hour, as this should be longer
-	 * than any other normal process, while still allowing the system to make
-	 * progress in the event of a real deadlock. As this is the last lock we
-	 * grab, and the setting is local to our transaction we do not bother
-	 * changing the guc back.
-	 */
-	config_change = set_config_option("deadlock_timeout",
-									  REORDER_ACCESS_EXCLUSIVE_DEADLOCK_TIMEOUT,
-									  PGC_SUSET,
-									  PGC_S_SESSION,
-									  GUC_ACTION_LOCAL,
-									  true,
-									  0,
-									  false);
-
-	if (config_change == 0)
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("deadlock_timeout guc does not exist.")));
-	else if (config_change < 0)
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("could not set deadlock_timeout guc.")));
+	set_upgrade_deadlock_timeout();
 
 	oldHeapRel = table_open(OIDOldHeap, AccessExclusiveLock);
 
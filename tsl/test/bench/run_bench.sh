@@ -0,0 +1,58 @@
+#!/usr/bin/env bash
+
+# Run the end-to-end benchmark workloads against a running server and write
+# the results as CSV.
+#
+# The following control variables are supported:
+#
+# BENCH_SCALE      multiplier for the data volume, 1 is about 1.5M rows
+# BENCH_CHUNKS     number of chunks for the chunk scaling workload
+# BENCH_DBNAME     database to (re)create for the benchmark
+# BENCH_OUTPUT     file to write the CSV results to, stdout if empty
+# BENCH_WORKDIR    directory for the generated ingest scripts
+# BENCH_WORKLOADS  only run workloads from this list, e.g. "01_ingest_copy 03_scan";
+#                  everything after 02_ingest_insert queries the data loaded by
+#                  01_ingest_copy
+#
+# The connection is configured with the usual libpq environment variables.
+
+set -e
+set -o pipefail
+
+CURRENT_DIR=$(cd "$(dirname "$0")" && pwd)
+PSQL=${PSQL:-psql}
+BENCH_SCALE=${BENCH_SCALE:-1}
+BENCH_CHUNKS=${BENCH_CHUNKS:-10000}
+BENCH_DBNAME=${BENCH_DBNAME:-bench}
+BENCH_OUTPUT=${BENCH_OUTPUT:-}
+BENCH_WORKDIR=${BENCH_WORKDIR:-$(mktemp -d)}
+BENCH_WORKLOADS=${BENCH_WORKLOADS:-}
+
+mkdir -p "${BENCH_WORKDIR}"
+
+run_psql() {
+    ${PSQL} -X -q -v ON_ERROR_STOP=1 -v VERBOSITY=terse \
+        -v scale="${BENCH_SCALE}" -v chunks="${BENCH_CHUNKS}" -v work_dir="${BENCH_WORKDIR}" "$@"
+}
+
+run_psql -d postgres -c "DROP DATABASE IF EXISTS ${BENCH_DBNAME}"
+run_psql -d postgres -c "CREATE DATABASE ${BENCH_DBNAME}"
+# The workloads print only the timing helper results, which are not
+# interesting since everything ends up in the report
+run_psql -d "${BENCH_DBNAME}" -f "${CURRENT_DIR}/sql/setup.sql" >/dev/null
+
+for file in "${CURRENT_DIR}"/sql/[0-9]*.sql; do
+    workload=$(basename "${file}" .sql)
+    if [[ -n ${BENCH_WORKLOADS} ]] && [[ " ${BENCH_WORKLOADS} " != *" ${workload} "* ]]; then
+        continue
+    fi
+    echo "running ${workload}" >&2
+    run_psql -d "${BENCH_DBNAME}" -v workload="${workload}" -f "${file}" >/dev/null
+done
+
+if [[ -n ${BENCH_OUTPUT} ]]; then
+    run_psql -d "${BENCH_DBNAME}" -f "${CURRENT_DIR}/sql/report.sql" -o "${BENCH_OUTPUT}"
+    echo "results written to ${BENCH_OUTPUT}" >&2
+else
+    run_psql -d "${BENCH_DBNAME}" -f "${CURRENT_DIR}/sql/report.sql"
+fi
@@ -0,0 +1,27 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- COPY the whole data set into the space-partitioned hypertable. The data is
+-- written to a script first, so that only the COPY itself is timed.
+SELECT * FROM bench_config \gset
+\set copy_file :work_dir '/ingest_copy.sql'
+
+\o :copy_file
+\qecho 'COPY metrics(time, device_id, cpu, temperature, status) FROM STDIN;'
+COPY (
+    SELECT :'range_start'::timestamptz + t * interval '1 minute', d,
+        (t * 7 + d * 13) % 100 + 0.5,
+        round((20 + 10 * sin(t / 60.0 + d))::numeric, 3),
+        CASE WHEN (t + d) % 50 = 0 THEN 'error' ELSE 'ok' END
+    FROM generate_series(0, :steps - 1) t, generate_series(1, :devices) d
+    ORDER BY t, d
+) TO STDOUT;
+\qecho '\\.'
+\o
+
+SELECT clock_timestamp() AS bench_start \gset
+\i :copy_file
+SELECT bench_record(:'workload', 'copy', :ROW_COUNT, :'bench_start');
+
+ANALYZE metrics;
@@ -0,0 +1,37 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Ingest with multi-row INSERTs of 1000 rows each, every statement in its
+-- own transaction, into a separate space-partitioned hypertable.
+SELECT * FROM bench_config \gset
+\set insert_file :work_dir '/ingest_insert.sql'
+
+CREATE TABLE metrics_insert (LIKE metrics);
+SELECT table_name FROM create_hypertable('metrics_insert', 'time', 'device_id', 4,
+    chunk_time_interval => interval '1 day');
+
+\pset format unaligned
+\pset tuples_only on
+\o :insert_file
+SELECT 'INSERT INTO metrics_insert VALUES ' ||
+    string_agg(format('(%L,%s,%s,%s,%L)', time, device_id, cpu, temperature, status), ',') || ';'
+FROM (
+    SELECT :'range_start'::timestamptz + t * interval '1 minute' AS time, d AS device_id,
+        (t * 7 + d * 13) % 100 + 0.5 AS cpu,
+        round((20 + 10 * sin(t / 60.0 + d))::numeric, 3) AS temperature,
+        CASE WHEN (t + d) % 50 = 0 THEN 'error' ELSE 'ok' END AS status,
+        t / (1000 / :devices) AS batch
+    FROM generate_series(0, :steps / 2 - 1) t, generate_series(1, :devices) d
+) data
+GROUP BY batch
+ORDER BY batch;
+\o
+\pset format aligned
+\pset tuples_only off
+
+SELECT clock_timestamp() AS bench_start \gset
+\i :insert_file
+SELECT bench_record(:'workload', 'insert_batch_1000', :steps / 2 * :devices, :'bench_start');
+
+ANALYZE metrics_insert;
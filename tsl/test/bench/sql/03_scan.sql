@@ -0,0 +1,52 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Compress the older half of the chunks and compare the time-range scans of
+-- the compressed and the uncompressed chunks.
+SELECT * FROM bench_config \gset
+SELECT date_trunc('day', :'range_start'::timestamptz + :steps / 2 * interval '1 minute')
+    AS compress_before \gset
+
+ALTER TABLE metrics SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device_id',
+    timescaledb.compress_orderby = 'time DESC');
+
+SELECT count(*) AS compress_rows FROM metrics WHERE time < :'compress_before' \gset
+SELECT clock_timestamp() AS bench_start \gset
+SELECT count(compress_chunk(c)) FROM show_chunks('metrics', older_than => :'compress_before'::timestamptz) c;
+SELECT bench_record(:'workload', 'compress', :compress_rows, :'bench_start');
+
+ANALYZE metrics;
+
+-- aggregate over one day
+SELECT bench_query(:'workload', 'compressed_day_agg',
+    format($$SELECT count(*), avg(cpu), max(temperature) FROM metrics
+        WHERE time >= %L AND time < %L$$,
+        :'range_start', :'range_start'::timestamptz + interval '1 day'));
+SELECT bench_query(:'workload', 'uncompressed_day_agg',
+    format($$SELECT count(*), avg(cpu), max(temperature) FROM metrics
+        WHERE time >= %L AND time < %L$$,
+        :'range_end'::timestamptz - interval '1 day', :'range_end'));
+
+-- one day of a single device
+SELECT bench_query(:'workload', 'compressed_day_device',
+    format($$SELECT time, cpu FROM metrics
+        WHERE device_id = 42 AND time >= %L AND time < %L ORDER BY time$$,
+        :'range_start', :'range_start'::timestamptz + interval '1 day'));
+SELECT bench_query(:'workload', 'uncompressed_day_device',
+    format($$SELECT time, cpu FROM metrics
+        WHERE device_id = 42 AND time >= %L AND time < %L ORDER BY time$$,
+        :'range_end'::timestamptz - interval '1 day', :'range_end'));
+
+-- all the rows of one hour
+SELECT bench_query(:'workload', 'compressed_hour_rows',
+    format($$SELECT * FROM metrics WHERE time >= %L AND time < %L ORDER BY time$$,
+        :'range_start', :'range_start'::timestamptz + interval '1 hour'));
+SELECT bench_query(:'workload', 'uncompressed_hour_rows',
+    format($$SELECT * FROM metrics WHERE time >= %L AND time < %L ORDER BY time$$,
+        :'range_end'::timestamptz - interval '1 hour', :'range_end'));
+
+-- the whole table, half of it compressed
+SELECT bench_query(:'workload', 'full_scan_by_device',
+    $$SELECT device_id, avg(cpu), count(*) FROM metrics GROUP BY device_id$$, 3);
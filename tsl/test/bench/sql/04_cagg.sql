@@ -0,0 +1,32 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Refresh of a continuous aggregate over the whole data set, followed by an
+-- incremental refresh after one more hour of data arrives.
+SELECT * FROM bench_config \gset
+
+CREATE MATERIALIZED VIEW metrics_hourly WITH (timescaledb.continuous) AS
+SELECT time_bucket('1 hour', time) AS bucket, device_id,
+    avg(cpu) AS avg_cpu, max(temperature) AS max_temperature, count(*) AS readings
+FROM metrics
+GROUP BY bucket, device_id
+WITH NO DATA;
+
+SELECT clock_timestamp() AS bench_start \gset
+CALL refresh_continuous_aggregate('metrics_hourly', NULL, NULL);
+SELECT bench_record(:'workload', 'refresh_full', :steps * :devices, :'bench_start');
+
+INSERT INTO metrics
+SELECT :'range_end'::timestamptz + t * interval '1 minute', d,
+    (t * 7 + d * 13) % 100 + 0.5, 20, 'ok'
+FROM generate_series(0, 59) t, generate_series(1, :devices) d;
+
+SELECT clock_timestamp() AS bench_start \gset
+CALL refresh_continuous_aggregate('metrics_hourly', NULL, NULL);
+SELECT bench_record(:'workload', 'refresh_incremental', 60 * :devices, :'bench_start');
+
+SELECT bench_query(:'workload', 'query_cagg_day',
+    format($$SELECT device_id, avg(avg_cpu), sum(readings) FROM metrics_hourly
+        WHERE bucket >= %L GROUP BY device_id$$,
+        :'range_end'::timestamptz - interval '1 day'));
@@ -0,0 +1,29 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- The distinct and last-point queries that SkipScan is meant for, with and
+-- without SkipScan.
+SELECT * FROM bench_config \gset
+SELECT :'range_end'::timestamptz - interval '1 day' AS recent \gset
+
+SELECT bench_query(:'workload', 'distinct_devices',
+    format($$SELECT DISTINCT device_id FROM metrics WHERE time >= %L$$, :'recent'));
+SELECT bench_query(:'workload', 'distinct_devices_compressed',
+    format($$SELECT DISTINCT device_id FROM metrics WHERE time < %L$$,
+        :'range_start'::timestamptz + interval '1 day'));
+SELECT bench_query(:'workload', 'last_point',
+    format($$SELECT DISTINCT ON (device_id) device_id, time, cpu FROM metrics
+        WHERE time >= %L ORDER BY device_id, time DESC$$, :'recent'));
+SELECT bench_query(:'workload', 'last_point_lateral',
+    format($$SELECT d, m.time, m.cpu FROM generate_series(1, %s) d
+        CROSS JOIN LATERAL (SELECT time, cpu FROM metrics
+            WHERE device_id = d ORDER BY time DESC LIMIT 1) m$$, :devices));
+
+SET timescaledb.enable_skipscan TO off;
+SELECT bench_query(:'workload', 'distinct_devices_no_skipscan',
+    format($$SELECT DISTINCT device_id FROM metrics WHERE time >= %L$$, :'recent'));
+SELECT bench_query(:'workload', 'last_point_no_skipscan',
+    format($$SELECT DISTINCT ON (device_id) device_id, time, cpu FROM metrics
+        WHERE time >= %L ORDER BY device_id, time DESC$$, :'recent'));
+RESET timescaledb.enable_skipscan;
@@ -0,0 +1,79 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Planning with a large number of chunks. The hypertable gets :chunks chunks
+-- over 10 space partitions, and the queries touch only a bounded number of
+-- them, so that the default max_locks_per_transaction is enough at any chunk
+-- count.
+SELECT :chunks / 10 AS slices, :chunks / 20 * 10 AS mid \gset
+
+CREATE TABLE many_chunks(time bigint NOT NULL, device int NOT NULL, value float8);
+SELECT table_name FROM create_hypertable('many_chunks', 'time', 'device', 10,
+    chunk_time_interval => 10);
+
+-- Every chunk creation takes locks, so commit after every 100 time slices
+CREATE PROCEDURE bench_create_chunks(slices int) LANGUAGE plpgsql AS
+$$
+BEGIN
+    FOR s IN 0..slices - 1 BY 100 LOOP
+        INSERT INTO many_chunks
+        SELECT t * 10, d, t + d
+        FROM generate_series(s, least(s + 99, slices - 1)) t, generate_series(1, 100) d;
+        COMMIT;
+    END LOOP;
+END
+$$;
+
+SELECT clock_timestamp() AS bench_start \gset
+CALL bench_create_chunks(:slices);
+SELECT bench_record(:'workload', 'create_chunks', :slices * 10, :'bench_start');
+ANALYZE many_chunks;
+
+-- The first query in a fresh backend fills the hypertable cache and reads the
+-- chunk catalog. The extension is loaded by the query reading the start time.
+\c
+SELECT clock_timestamp() AS bench_start \gset
+EXPLAIN SELECT * FROM many_chunks WHERE time = :mid AND device = 5;
+SELECT bench_record(:'workload', 'first_query_fresh_backend', NULL, :'bench_start');
+SELECT bench_memory(:'workload', 'memory_first_query/hypertable_cache', 'Hypertable cache');
+SELECT bench_memory(:'workload', 'memory_first_query/cache_memory', 'CacheMemoryContext');
+\c
+SELECT clock_timestamp() AS bench_start \gset
+EXPLAIN SELECT * FROM many_chunks WHERE time = :mid AND device = 5;
+SELECT bench_record(:'workload', 'first_query_fresh_backend', NULL, :'bench_start');
+\c
+SELECT clock_timestamp() AS bench_start \gset
+EXPLAIN SELECT * FROM many_chunks WHERE time = :mid AND device = 5;
+SELECT bench_record(:'workload', 'first_query_fresh_backend', NULL, :'bench_start');
+
+-- Planning time of the queries excluding most of the chunks at plan time
+DO $$
+BEGIN
+    PERFORM set_config('timescaledb.enable_planner_timing', 'on', false);
+EXCEPTION WHEN OTHERS THEN
+    NULL;
+END
+$$;
+
+SELECT bench_planning(:'workload', 'plan_1_chunk',
+    format('SELECT * FROM many_chunks WHERE time = %s AND device = 5', :mid));
+SELECT bench_planning(:'workload', 'plan_10_chunks',
+    format('SELECT * FROM many_chunks WHERE time = %s', :mid));
+SELECT bench_planning(:'workload', 'plan_100_chunks',
+    format('SELECT * FROM many_chunks WHERE time >= %s AND time < %s AND device = 5',
+        :mid, :mid + 1000));
+SELECT bench_planning(:'workload', 'plan_1000_chunks',
+    format('SELECT * FROM many_chunks WHERE time >= %s AND time < %s', :mid, :mid + 1000));
+
+-- The same chunk excluded at execution time out of 1000 chunks left by the
+-- plan time exclusion, compared to excluding it at plan time
+SELECT bench_query(:'workload', 'exclusion_plan_time',
+    format('SELECT * FROM many_chunks WHERE time >= %s AND time < %s AND time = %s',
+        :mid, :mid + 1000, :mid + 500));
+SELECT bench_query(:'workload', 'exclusion_runtime',
+    format('SELECT * FROM many_chunks WHERE time >= %s AND time < %s AND time = (SELECT %s)',
+        :mid, :mid + 1000, :mid + 500));
+
+SELECT bench_memory(:'workload', 'memory_after_planning/hypertable_cache', 'Hypertable cache');
+SELECT bench_memory(:'workload', 'memory_after_planning/cache_memory', 'CacheMemoryContext');
@@ -0,0 +1,23 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- One CSV line per benchmark step. The min and the median are over the
+-- recorded runs, the throughput is computed from the fastest run. The memory
+-- steps have only the max_bytes.
+COPY (
+    SELECT (SELECT extversion FROM pg_extension WHERE extname = 'timescaledb') AS timescaledb_version,
+        current_setting('server_version_num')::int AS pg_version,
+        (SELECT scale FROM bench_config) AS scale,
+        workload,
+        step,
+        count(*) AS runs,
+        max(rows) AS rows,
+        round(min(duration_ms)::numeric, 3) AS min_ms,
+        round((percentile_cont(0.5) WITHIN GROUP (ORDER BY duration_ms))::numeric, 3) AS median_ms,
+        round((max(rows) / nullif(min(duration_ms) / 1000, 0))::numeric) AS rows_per_sec,
+        max(bytes) AS max_bytes
+    FROM bench_results
+    GROUP BY workload, step
+    ORDER BY min(id)
+) TO STDOUT WITH (FORMAT csv, HEADER);
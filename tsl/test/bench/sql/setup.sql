@@ -0,0 +1,132 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Schema and helpers shared by all the workloads. The psql variable scale
+-- sets the data volume: the metrics table gets 10000 * scale one-minute
+-- steps for each of the 100 devices.
+CREATE EXTENSION IF NOT EXISTS timescaledb;
+ALTER DATABASE :"DBNAME" SET timezone TO 'UTC';
+SET timezone TO 'UTC';
+
+CREATE TABLE bench_config AS
+SELECT :scale::int AS scale,
+    100 AS devices,
+    10000 * :scale::int AS steps,
+    '2023-01-01 00:00+00'::timestamptz AS range_start,
+    '2023-01-01 00:00+00'::timestamptz + 10000 * :scale::int * interval '1 minute' AS range_end;
+
+CREATE TABLE bench_results(
+    id serial PRIMARY KEY,
+    workload text NOT NULL,
+    step text NOT NULL,
+    run int NOT NULL,
+    rows bigint,
+    duration_ms float8,
+    bytes bigint
+);
+
+CREATE FUNCTION bench_record_duration(workload text, step text, nrows bigint, duration_ms float8)
+RETURNS void LANGUAGE sql AS
+$$
+    INSERT INTO bench_results(workload, step, run, rows, duration_ms)
+    SELECT $1, $2, coalesce(max(r.run), 0) + 1, $3, $4
+    FROM bench_results r
+    WHERE r.workload = $1 AND r.step = $2;
+$$;
+
+-- Record a step that started at start_time and has just finished. Used for
+-- the steps that have to run as psql commands, like COPY or CALL.
+CREATE FUNCTION bench_record(workload text, step text, nrows bigint, start_time timestamptz)
+RETURNS void LANGUAGE sql AS
+$$
+    SELECT bench_record_duration($1, $2, $3, extract(epoch FROM clock_timestamp() - $4) * 1000);
+$$;
+
+-- Run the query repeat times after one unrecorded warm-up run and record
+-- the duration and the number of result rows of every run.
+CREATE FUNCTION bench_query(workload text, step text, query text, repeat int DEFAULT 5)
+RETURNS void LANGUAGE plpgsql AS
+$$
+DECLARE
+    start_time timestamptz;
+    nrows bigint;
+BEGIN
+    EXECUTE query;
+    FOR i IN 1..repeat LOOP
+        start_time := clock_timestamp();
+        EXECUTE query;
+        GET DIAGNOSTICS nrows = ROW_COUNT;
+        PERFORM bench_record(workload, step, nrows, start_time);
+    END LOOP;
+END
+$$;
+
+-- Run EXPLAIN of the query repeat times after one unrecorded warm-up run and
+-- record the planning time. With timescaledb.enable_planner_timing on, the
+-- time of the hypertable planning phases is recorded as well, as the steps
+-- step/phase. The versions without the planner timing record only the total.
+CREATE FUNCTION bench_planning(workload text, step text, query text, repeat int DEFAULT 5)
+RETURNS void LANGUAGE plpgsql AS
+$$
+DECLARE
+    plan json;
+    timing record;
+BEGIN
+    EXECUTE 'EXPLAIN (SUMMARY ON, FORMAT JSON) ' || query;
+    FOR i IN 1..repeat LOOP
+        EXECUTE 'EXPLAIN (SUMMARY ON, FORMAT JSON) ' || query INTO plan;
+        PERFORM bench_record_duration(workload, step, NULL, (plan->0->>'Planning Time')::float8);
+
+        IF coalesce(current_setting('timescaledb.enable_planner_timing', true)::bool, false) AND
+            to_regprocedure('_timescaledb_internal.planner_timing()') IS NOT NULL THEN
+            FOR timing IN
+                SELECT * FROM _timescaledb_internal.planner_timing() WHERE phase <> 'planning'
+            LOOP
+                PERFORM bench_record_duration(workload, step || '/' || timing.phase,
+                    timing.chunks, timing.total_time);
+            END LOOP;
+        END IF;
+    END LOOP;
+END
+$$;
+
+-- Record the memory of the backend memory context and all its children. The
+-- memory contexts are visible only on PG14 and later, the step is not
+-- recorded on the earlier versions.
+CREATE FUNCTION bench_memory(workload text, step text, context text)
+RETURNS void LANGUAGE plpgsql AS
+$$
+BEGIN
+    IF current_setting('server_version_num')::int < 140000 THEN
+        RETURN;
+    END IF;
+
+    EXECUTE $sql$
+        INSERT INTO bench_results(workload, step, run, bytes)
+        WITH RECURSIVE tree AS (
+            SELECT name, level, total_bytes FROM pg_backend_memory_contexts WHERE name = $3
+            UNION ALL
+            SELECT c.name, c.level, c.total_bytes
+            FROM pg_backend_memory_contexts c
+            JOIN tree ON c.parent = tree.name AND c.level = tree.level + 1
+        )
+        SELECT $1, $2,
+            (SELECT coalesce(max(run), 0) + 1 FROM bench_results r
+             WHERE r.workload = $1 AND r.step = $2),
+            sum(total_bytes)
+        FROM tree
+    $sql$ USING workload, step, context;
+END
+$$;
+
+-- The ingest target, partitioned by time and by device
+CREATE TABLE metrics(
+    time timestamptz NOT NULL,
+    device_id int NOT NULL,
+    cpu float8,
+    temperature float8,
+    status text
+);
+SELECT table_name FROM create_hypertable('metrics', 'time', 'device_id', 4,
+    chunk_time_interval => interval '1 day');
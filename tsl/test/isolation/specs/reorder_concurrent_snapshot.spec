@@ -0,0 +1,37 @@
+# This file and its contents are licensed under the Timescale License.
+# Please see the included NOTICE for copyright information and
+# LICENSE-TIMESCALE for a copy of the license.
+
+# A concurrent reorder must not make rows committed after the snapshot of a
+# repeatable read transaction visible to it. Like after TRUNCATE, the
+# transaction sees the reordered chunk empty if it did not access the chunk
+# before the reorder.
+setup
+{
+ CREATE TABLE rcs(time int NOT NULL, device int, value float);
+ SELECT table_name FROM create_hypertable('rcs', 'time', chunk_time_interval => 100);
+ CREATE INDEX rcs_device_time_idx ON rcs(device, time);
+ INSERT INTO rcs SELECT t, t % 3, t FROM generate_series(0, 8) t;
+ CREATE TABLE other(i int);
+}
+
+teardown {
+      DROP TABLE rcs;
+      DROP TABLE other;
+}
+
+session "S"
+setup		{ BEGIN ISOLATION LEVEL REPEATABLE READ; }
+step "S1"	{ SELECT count(*) FROM other; }
+step "S2"	{ SELECT count(*), count(*) FILTER (WHERE time = 50) AS new_rows FROM rcs; }
+step "Sc"	{ COMMIT; }
+
+session "I"
+step "I1"	{ INSERT INTO rcs VALUES (50, 1, 50); }
+
+session "R"
+setup		{ SET timescaledb.enable_concurrent_reorder TO on; }
+step "R1"	{ SELECT reorder_chunk(show_chunks('rcs'), 'rcs_device_time_idx'); }
+step "R2"	{ SELECT count(*), count(*) FILTER (WHERE time = 50) AS new_rows FROM rcs; }
+
+permutation "S1" "I1" "R1" "S2" "Sc" "R2"
@@ -0,0 +1,53 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE precreate(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('precreate', 'time', chunk_time_interval => 10);
+
+-- nothing to create ahead of without data
+SELECT add_chunk_precreation_policy('precreate', 2) AS job_id \gset
+SELECT application_name, schedule_interval, proc_name, check_name, config
+FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+CALL run_job(:job_id);
+
+INSERT INTO precreate VALUES (1, 1, 1.0), (15, 1, 2.0);
+
+-- the two chunks following the chunk of the newest data are created
+CALL run_job(:job_id);
+SELECT range_start_integer, range_end_integer FROM timescaledb_information.chunks
+WHERE hypertable_name = 'precreate' ORDER BY 1;
+
+-- no chunks are added until the inserts reach the chunks created ahead
+CALL run_job(:job_id);
+SELECT count(*) FROM timescaledb_information.chunks WHERE hypertable_name = 'precreate';
+
+-- the inserts use the chunks created ahead
+INSERT INTO precreate VALUES (25, 1, 3.0);
+SELECT count(*) FROM timescaledb_information.chunks WHERE hypertable_name = 'precreate';
+CALL run_job(:job_id);
+SELECT range_start_integer, range_end_integer FROM timescaledb_information.chunks
+WHERE hypertable_name = 'precreate' ORDER BY 1;
+
+SELECT add_chunk_precreation_policy('precreate', 2, if_not_exists => true);
+SELECT add_chunk_precreation_policy('precreate', 3, if_not_exists => true);
+\set ON_ERROR_STOP 0
+SELECT add_chunk_precreation_policy('precreate', 2);
+SELECT add_chunk_precreation_policy('precreate', 0);
+\set ON_ERROR_STOP 1
+
+SELECT remove_chunk_precreation_policy('precreate');
+SELECT remove_chunk_precreation_policy('precreate', if_exists => true);
+
+-- the chunks are created for all space partitions
+CREATE TABLE precreate_space(time int NOT NULL, device int);
+SELECT table_name FROM create_hypertable('precreate_space', 'time', 'device', 2,
+    chunk_time_interval => 10);
+INSERT INTO precreate_space VALUES (5, 1);
+SELECT add_chunk_precreation_policy('precreate_space', 1) AS job_id \gset
+CALL run_job(:job_id);
+SELECT range_start_integer, range_end_integer, count(*) FROM timescaledb_information.chunks
+WHERE hypertable_name = 'precreate_space' GROUP BY 1, 2 ORDER BY 1;
+
+DROP TABLE precreate;
+DROP TABLE precreate_space;
@@ -0,0 +1,71 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE metrics_a (time bigint NOT NULL, device int, value float);
+CREATE TABLE metrics_b (time bigint NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics_a', 'time', chunk_time_interval => 10);
+SELECT table_name FROM create_hypertable('metrics_b', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION bigint_now()
+RETURNS bigint LANGUAGE SQL STABLE AS
+$$
+    SELECT 49::bigint
+$$;
+SELECT set_integer_now_func('metrics_a', 'bigint_now');
+SELECT set_integer_now_func('metrics_b', 'bigint_now');
+ALTER TABLE metrics_a SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+ALTER TABLE metrics_b SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+
+INSERT INTO metrics_a SELECT t, t % 4, t FROM generate_series(0, 49, 1) t;
+INSERT INTO metrics_b SELECT t, t % 4, t FROM generate_series(0, 49, 1) t;
+
+SELECT add_compression_policy('metrics_a', BIGINT '10') AS job_a \gset
+SELECT add_compression_policy('metrics_b', BIGINT '10') AS job_b \gset
+
+-- move both policies into the batch
+SELECT scheduled FROM alter_job(:job_a, scheduled => false,
+    config => (SELECT config FROM _timescaledb_config.bgw_job WHERE id = :job_a) || '{"batched": true}');
+SELECT scheduled FROM alter_job(:job_b, scheduled => false,
+    config => (SELECT config FROM _timescaledb_config.bgw_job WHERE id = :job_b)
+              || '{"batched": true, "maxchunks_to_compress": 2}');
+
+\set ON_ERROR_STOP 0
+SELECT add_compression_batch_policy(INTERVAL '0');
+SELECT remove_compression_batch_policy();
+\set ON_ERROR_STOP 1
+SELECT remove_compression_batch_policy(if_exists => true);
+
+SELECT add_compression_batch_policy(INTERVAL '5 min') AS batch_job \gset
+SELECT application_name, schedule_interval, proc_name, check_name, config
+FROM _timescaledb_config.bgw_job WHERE id = :batch_job;
+
+SELECT add_compression_batch_policy(INTERVAL '5 min', if_not_exists => true);
+\set ON_ERROR_STOP 0
+SELECT add_compression_batch_policy(INTERVAL '5 min');
+\set ON_ERROR_STOP 1
+
+-- a batched policy leaves its chunks to the batch
+CALL run_job(:job_a);
+SELECT hypertable_name, count(*) FILTER (WHERE is_compressed) AS compressed
+FROM timescaledb_information.chunks
+WHERE hypertable_name IN ('metrics_a', 'metrics_b')
+GROUP BY 1 ORDER BY 1;
+
+-- the batch compresses the chunks of both hypertables and respects
+-- maxchunks_to_compress of each policy
+CALL run_job(:batch_job);
+SELECT hypertable_name, count(*) FILTER (WHERE is_compressed) AS compressed
+FROM timescaledb_information.chunks
+WHERE hypertable_name IN ('metrics_a', 'metrics_b')
+GROUP BY 1 ORDER BY 1;
+
+CALL run_job(:batch_job);
+SELECT hypertable_name, count(*) FILTER (WHERE is_compressed) AS compressed
+FROM timescaledb_information.chunks
+WHERE hypertable_name IN ('metrics_a', 'metrics_b')
+GROUP BY 1 ORDER BY 1;
+
+SELECT remove_compression_batch_policy();
+
+DROP TABLE metrics_a;
+DROP TABLE metrics_b;
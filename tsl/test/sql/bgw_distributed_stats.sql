@@ -0,0 +1,26 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- the statistics are only fetched for distributed hypertables
+CREATE TABLE conditions (time timestamptz NOT NULL, device int, temp float);
+SELECT table_name FROM create_hypertable('conditions', 'time');
+
+\set ON_ERROR_STOP 0
+SELECT add_distributed_stats_policy('conditions');
+SELECT add_distributed_stats_policy(NULL);
+SELECT remove_distributed_stats_policy('conditions');
+\set ON_ERROR_STOP 1
+
+SELECT remove_distributed_stats_policy('conditions', if_exists => true);
+
+-- the check rejects the configurations of other hypertables
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.policy_distributed_stats_check(
+    jsonb_build_object('hypertable_id', id))
+FROM _timescaledb_catalog.hypertable WHERE table_name = 'conditions';
+SELECT _timescaledb_internal.policy_distributed_stats_check('{}');
+SELECT _timescaledb_internal.policy_distributed_stats_check('{"hypertable_id": 12345}');
+\set ON_ERROR_STOP 1
+
+DROP TABLE conditions;
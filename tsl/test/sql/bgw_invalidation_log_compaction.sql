@@ -0,0 +1,88 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE conditions (time bigint NOT NULL, device int, temp float);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION bigint_now()
+RETURNS bigint LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'bigint_now');
+
+-- there is no invalidation log without continuous aggregates
+\set ON_ERROR_STOP 0
+SELECT add_invalidation_log_compaction_policy('conditions');
+\set ON_ERROR_STOP 1
+
+INSERT INTO conditions
+SELECT t, t % 4, t % 40
+FROM generate_series(0, 99, 1) t;
+
+CREATE MATERIALIZED VIEW cond_10
+WITH (timescaledb.continuous,
+      timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(BIGINT '10', time) AS bucket, device, avg(temp) AS avg_temp
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+
+CALL refresh_continuous_aggregate('cond_10', 0, 100);
+
+-- one invalidation per transaction
+INSERT INTO conditions VALUES (1, 1, 1.0);
+INSERT INTO conditions VALUES (2, 1, 1.0);
+INSERT INTO conditions VALUES (3, 1, 1.0);
+INSERT INTO conditions VALUES (5, 1, 1.0), (8, 1, 1.0);
+INSERT INTO conditions VALUES (7, 1, 1.0);
+INSERT INTO conditions VALUES (40, 1, 1.0);
+INSERT INTO conditions VALUES (40, 1, 1.0), (45, 1, 1.0);
+INSERT INTO conditions VALUES (46, 1, 1.0);
+INSERT INTO conditions VALUES (50, 1, 1.0);
+
+SELECT hypertable_id, lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log
+ORDER BY 1, 2, 3;
+
+SELECT add_invalidation_log_compaction_policy('conditions') AS job_id \gset
+SELECT application_name, schedule_interval, proc_name, check_name, config
+FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+
+-- overlapping and adjacent invalidations are merged
+CALL run_job(:job_id);
+SELECT hypertable_id, lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log
+ORDER BY 1, 2, 3;
+
+-- nothing left to merge
+CALL run_job(:job_id);
+SELECT hypertable_id, lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log
+ORDER BY 1, 2, 3;
+
+-- the refresh materializes the merged invalidations
+CALL refresh_continuous_aggregate('cond_10', 0, 100);
+SELECT count(*) AS hyper_invals
+FROM _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+SELECT count(*) AS mismatches FROM (
+    (SELECT * FROM cond_10
+     EXCEPT
+     SELECT time_bucket(BIGINT '10', time), device, avg(temp) FROM conditions GROUP BY 1, 2)
+    UNION ALL
+    (SELECT time_bucket(BIGINT '10', time), device, avg(temp) FROM conditions GROUP BY 1, 2
+     EXCEPT
+     SELECT * FROM cond_10)
+) diff;
+
+SELECT add_invalidation_log_compaction_policy('conditions', if_not_exists => true);
+\set ON_ERROR_STOP 0
+SELECT add_invalidation_log_compaction_policy('conditions');
+\set ON_ERROR_STOP 1
+
+SELECT remove_invalidation_log_compaction_policy('conditions');
+SELECT remove_invalidation_log_compaction_policy('conditions', if_exists => true);
+
+DROP MATERIALIZED VIEW cond_10;
+DROP TABLE conditions;
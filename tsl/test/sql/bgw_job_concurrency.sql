@@ -0,0 +1,33 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE OR REPLACE PROCEDURE custom_proc(job_id int, args jsonb) LANGUAGE SQL AS
+$$
+  SELECT 1;
+$$;
+
+SELECT add_job('custom_proc', '1h', config => '{"type": "custom"}') AS job_id \gset
+SELECT add_job('custom_proc', '1h') AS job_id_no_config \gset
+
+SELECT set_job_concurrency_class(:job_id, 'maintenance', 2);
+SELECT set_job_concurrency_class(:job_id_no_config, 'maintenance');
+SELECT id, config FROM _timescaledb_config.bgw_job WHERE id >= 1000 ORDER BY id;
+
+-- moving a job to another class replaces the class and the limit
+SELECT set_job_concurrency_class(:job_id, 'io_heavy', 1);
+SELECT id, config FROM _timescaledb_config.bgw_job WHERE id >= 1000 ORDER BY id;
+
+\set ON_ERROR_STOP 0
+SELECT set_job_concurrency_class(:job_id, 'io_heavy', 0);
+SELECT set_job_concurrency_class(:job_id, 'io_heavy', NULL);
+SELECT set_job_concurrency_class(-1, 'io_heavy', 1);
+\set ON_ERROR_STOP 1
+
+-- a NULL class takes the job out of its class
+SELECT set_job_concurrency_class(:job_id, NULL);
+SELECT set_job_concurrency_class(:job_id_no_config, NULL);
+SELECT id, config FROM _timescaledb_config.bgw_job WHERE id >= 1000 ORDER BY id;
+
+SELECT delete_job(:job_id);
+SELECT delete_job(:job_id_no_config);
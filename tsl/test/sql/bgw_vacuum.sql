@@ -0,0 +1,50 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE conditions(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+
+SELECT add_vacuum_policy('conditions') AS job_id \gset
+SELECT application_name, schedule_interval, max_runtime, proc_name, check_name, config
+FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+
+-- a run without chunks does nothing
+CALL run_job(:job_id);
+
+-- the chunks are vacuumed and analyzed, and the compressed chunk is frozen
+INSERT INTO conditions SELECT t, t % 3, t FROM generate_series(0, 29) t;
+ALTER TABLE conditions SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+SELECT count(compress_chunk(ch)) FROM show_chunks('conditions', older_than => 10) ch;
+CALL run_job(:job_id);
+
+SELECT add_vacuum_policy('conditions', if_not_exists => true);
+SELECT add_vacuum_policy('conditions', 5, if_not_exists => true);
+
+\set ON_ERROR_STOP 0
+SELECT add_vacuum_policy('conditions');
+SELECT add_vacuum_policy('conditions', 0);
+SELECT add_vacuum_policy(NULL);
+\set ON_ERROR_STOP 1
+
+SELECT remove_vacuum_policy('conditions');
+SELECT count(*) FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+
+\set ON_ERROR_STOP 0
+SELECT remove_vacuum_policy('conditions');
+\set ON_ERROR_STOP 1
+SELECT remove_vacuum_policy('conditions', if_exists => true);
+
+-- the check validates the configuration
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.policy_vacuum_check('{}');
+SELECT _timescaledb_internal.policy_vacuum_check('{"hypertable_id": 12345, "max_chunks": 1}');
+SELECT _timescaledb_internal.policy_vacuum_check(
+    jsonb_build_object('hypertable_id', id))
+FROM _timescaledb_catalog.hypertable WHERE table_name = 'conditions';
+SELECT _timescaledb_internal.policy_vacuum_check(
+    jsonb_build_object('hypertable_id', id, 'max_chunks', 0))
+FROM _timescaledb_catalog.hypertable WHERE table_name = 'conditions';
+\set ON_ERROR_STOP 1
+
+DROP TABLE conditions;
@@ -0,0 +1,78 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test refreshing compressed regions of a continuous aggregate with
+-- timescaledb.enable_cagg_compressed_refresh
+CREATE TABLE conditions (time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION int_now()
+RETURNS int LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'int_now');
+
+INSERT INTO conditions
+SELECT t, t % 2 + 1, t
+FROM generate_series(0, 39, 1) t;
+
+CREATE MATERIALIZED VIEW cond_10
+WITH (timescaledb.continuous, timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(10, time) AS bucket, device, sum(value) AS sum_value, count(*) AS num_values
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+
+SELECT h.id AS "MAT_ID", format('%I.%I', h.schema_name, h.table_name) AS "MAT_TABLE"
+FROM _timescaledb_catalog.continuous_agg ca
+JOIN _timescaledb_catalog.hypertable h ON (h.id = ca.mat_hypertable_id)
+WHERE ca.user_view_name = 'cond_10' \gset
+
+-- Two buckets per materialization chunk
+SELECT set_chunk_time_interval(:'MAT_TABLE', 20);
+CALL refresh_continuous_aggregate('cond_10', 0, 40);
+
+ALTER MATERIALIZED VIEW cond_10 SET (timescaledb.compress = true);
+SELECT compress_chunk(ch) FROM show_chunks('cond_10') ch;
+
+INSERT INTO conditions VALUES (5, 1, 1000);
+
+-- Compressed chunks cannot be modified by default
+\set ON_ERROR_STOP 0
+\set VERBOSITY terse
+CALL refresh_continuous_aggregate('cond_10', 0, 40);
+\set VERBOSITY default
+\set ON_ERROR_STOP 1
+
+-- Only the batches that overlap the refreshed bucket are decompressed
+SET timescaledb.enable_cagg_compressed_refresh = on;
+CALL refresh_continuous_aggregate('cond_10', 0, 40);
+RESET timescaledb.enable_cagg_compressed_refresh;
+
+SELECT c.table_name, c.status, s.numrows_pre_compression, s.numrows_post_compression
+FROM _timescaledb_catalog.chunk c
+JOIN _timescaledb_catalog.compression_chunk_size s ON (s.chunk_id = c.id)
+WHERE c.hypertable_id = :MAT_ID
+ORDER BY c.id;
+
+SELECT * FROM cond_10 ORDER BY 1,2;
+SELECT time_bucket(10, time) AS bucket, device, sum(value) AS sum_value, count(*) AS num_values
+FROM conditions
+GROUP BY 1,2 ORDER BY 1,2;
+
+-- The decompressed rows are compressed again by recompression
+SET timescaledb.enable_segmentwise_recompression = on;
+CALL recompress_chunk('_timescaledb_internal._hyper_2_5_chunk');
+RESET timescaledb.enable_segmentwise_recompression;
+
+SELECT c.table_name, c.status, s.numrows_pre_compression, s.numrows_post_compression
+FROM _timescaledb_catalog.chunk c
+JOIN _timescaledb_catalog.compression_chunk_size s ON (s.chunk_id = c.id)
+WHERE c.hypertable_id = :MAT_ID
+ORDER BY c.id;
+
+SELECT * FROM cond_10 ORDER BY 1,2;
+
+DROP MATERIALIZED VIEW cond_10;
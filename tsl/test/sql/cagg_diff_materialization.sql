@@ -0,0 +1,102 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test that refreshing a continuous aggregate with
+-- timescaledb.enable_cagg_diff_materialization only rewrites the
+-- materialized rows that changed
+CREATE TABLE conditions (time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION int_now()
+RETURNS int LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'int_now');
+
+INSERT INTO conditions
+SELECT t, t % 2 + 1, t
+FROM generate_series(0, 49, 1) t;
+
+CREATE MATERIALIZED VIEW cond_10
+WITH (timescaledb.continuous,
+      timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(10, time) AS bucket, device, sum(value) AS sum_value
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+
+SELECT format('%I.%I', h.schema_name, h.table_name) AS "MAT_TABLE"
+FROM _timescaledb_catalog.continuous_agg ca
+JOIN _timescaledb_catalog.hypertable h ON (h.id = ca.mat_hypertable_id)
+WHERE ca.user_view_name = 'cond_10' \gset
+
+SET timescaledb.enable_cagg_diff_materialization TO on;
+CALL refresh_continuous_aggregate('cond_10', 0, 50);
+SELECT * FROM cond_10 ORDER BY 1, 2;
+
+CREATE TABLE mat_before AS SELECT tableoid AS rel, ctid AS tid, * FROM :MAT_TABLE;
+
+-- Change one bucket of one device and delete all data of another
+-- bucket, the other materialized rows must not be rewritten
+UPDATE conditions SET value = value + 100 WHERE time = 25;
+DELETE FROM conditions WHERE time >= 40 AND time < 50 AND device = 2;
+CALL refresh_continuous_aggregate('cond_10', 0, 50);
+SELECT * FROM cond_10 ORDER BY 1, 2;
+
+SELECT count(*) AS unchanged_rows
+FROM :MAT_TABLE m
+JOIN mat_before b ON (b.rel = m.tableoid AND b.tid = m.ctid);
+
+-- A refresh of a range where the aggregates did not change writes nothing
+TRUNCATE mat_before;
+INSERT INTO mat_before SELECT tableoid, ctid, * FROM :MAT_TABLE;
+INSERT INTO conditions VALUES (12, 1, 0);
+CALL refresh_continuous_aggregate('cond_10', 0, 50);
+SELECT count(*) AS unchanged_rows
+FROM :MAT_TABLE m
+JOIN mat_before b ON (b.rel = m.tableoid AND b.tid = m.ctid);
+
+-- The materialization matches the aggregates of the raw data
+(SELECT * FROM cond_10
+ EXCEPT
+ SELECT time_bucket(10, time), device, sum(value) FROM conditions GROUP BY 1, 2)
+UNION ALL
+(SELECT time_bucket(10, time), device, sum(value) FROM conditions GROUP BY 1, 2
+ EXCEPT
+ SELECT * FROM cond_10);
+
+-- Changes of float aggregates below the precision of their text
+-- representation are materialized as well
+CREATE TABLE readings (time int NOT NULL, value float8);
+SELECT table_name FROM create_hypertable('readings', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION readings_now()
+RETURNS int LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM readings
+$$;
+SELECT set_integer_now_func('readings', 'readings_now');
+INSERT INTO readings VALUES (1, 1.0), (11, 2.0);
+
+CREATE MATERIALIZED VIEW readings_10
+WITH (timescaledb.continuous,
+      timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(10, time) AS bucket, max(value) AS max_value
+FROM readings
+GROUP BY 1 WITH NO DATA;
+
+SET extra_float_digits = 0;
+CALL refresh_continuous_aggregate('readings_10', 0, 20);
+UPDATE readings SET value = 1.0000000000000002 WHERE time = 1;
+CALL refresh_continuous_aggregate('readings_10', 0, 20);
+RESET extra_float_digits;
+
+SELECT bucket,
+       max_value = (SELECT max(value) FROM readings r WHERE time_bucket(10, r.time) = bucket)
+           AS matches_raw
+FROM readings_10 ORDER BY 1;
+
+RESET timescaledb.enable_cagg_diff_materialization;
@@ -0,0 +1,88 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test that refreshing a continuous aggregate that stores partials with
+-- timescaledb.enable_cagg_incremental_refresh only recomputes the
+-- partials of the chunks that changed
+CREATE TABLE conditions (time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION int_now()
+RETURNS int LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'int_now');
+
+INSERT INTO conditions
+SELECT t, t % 2 + 1, t
+FROM generate_series(0, 99, 1) t;
+
+-- Every bucket spans five chunks
+CREATE MATERIALIZED VIEW cond_50
+WITH (timescaledb.continuous,
+      timescaledb.materialized_only=true,
+      timescaledb.finalized=false)
+AS
+SELECT time_bucket(50, time) AS bucket, device, sum(value) AS sum_value, count(*) AS num_values
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+
+SELECT format('%I.%I', h.schema_name, h.table_name) AS "MAT_TABLE"
+FROM _timescaledb_catalog.continuous_agg ca
+JOIN _timescaledb_catalog.hypertable h ON (h.id = ca.mat_hypertable_id)
+WHERE ca.user_view_name = 'cond_50' \gset
+
+-- Restrictions on the chunk ID exclude the other chunks when planning
+EXPLAIN (costs off)
+SELECT * FROM conditions WHERE _timescaledb_internal.chunk_id_from_relid(tableoid) = 3;
+EXPLAIN (costs off)
+SELECT * FROM conditions
+WHERE _timescaledb_internal.chunk_id_from_relid(tableoid) = ANY('{9,10}'::integer[]);
+
+SET timescaledb.enable_cagg_incremental_refresh TO on;
+CALL refresh_continuous_aggregate('cond_50', 0, 100);
+SELECT * FROM cond_50 ORDER BY 1, 2;
+
+-- Appending to the latest bucket only rewrites the partials of the
+-- chunk the data was appended to
+CREATE TABLE mat_before AS SELECT tableoid AS rel, ctid AS tid FROM :MAT_TABLE;
+INSERT INTO conditions VALUES (95, 1, 1000);
+CALL refresh_continuous_aggregate('cond_50', 0, 100);
+SELECT * FROM cond_50 ORDER BY 1, 2;
+SELECT m.chunk_id, count(*) FILTER (WHERE b.tid IS NULL) AS rewritten, count(*) AS total
+FROM :MAT_TABLE m
+LEFT JOIN mat_before b ON (b.rel = m.tableoid AND b.tid = m.ctid)
+GROUP BY 1 ORDER BY 1;
+
+-- Without incremental refresh, the partials of all chunks of the bucket
+-- are rewritten
+RESET timescaledb.enable_cagg_incremental_refresh;
+TRUNCATE mat_before;
+INSERT INTO mat_before SELECT tableoid, ctid FROM :MAT_TABLE;
+INSERT INTO conditions VALUES (96, 1, 1000);
+CALL refresh_continuous_aggregate('cond_50', 0, 100);
+SELECT * FROM cond_50 ORDER BY 1, 2;
+SELECT m.chunk_id, count(*) FILTER (WHERE b.tid IS NULL) AS rewritten, count(*) AS total
+FROM :MAT_TABLE m
+LEFT JOIN mat_before b ON (b.rel = m.tableoid AND b.tid = m.ctid)
+GROUP BY 1 ORDER BY 1;
+
+-- The partials of dropped chunks are removed
+SET timescaledb.enable_cagg_incremental_refresh TO on;
+SELECT drop_chunks('conditions', older_than => 10);
+CALL refresh_continuous_aggregate('cond_50', 0, 100);
+SELECT * FROM cond_50 ORDER BY 1, 2;
+SELECT count(*) FROM :MAT_TABLE WHERE chunk_id = 1;
+
+-- The materialization matches the aggregates of the raw data
+(SELECT * FROM cond_50
+ EXCEPT
+ SELECT time_bucket(50, time), device, sum(value), count(*) FROM conditions GROUP BY 1, 2)
+UNION ALL
+(SELECT time_bucket(50, time), device, sum(value), count(*) FROM conditions GROUP BY 1, 2
+ EXCEPT
+ SELECT * FROM cond_50);
+
+RESET timescaledb.enable_cagg_incremental_refresh;
@@ -0,0 +1,124 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test that inserts tracked by the chunk insert states with
+-- timescaledb.enable_cagg_invalidation_tracking produce the same
+-- invalidations as the invalidation trigger
+CREATE TABLE conditions (time bigint NOT NULL, device int, temp float);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION bigint_now()
+RETURNS bigint LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'bigint_now');
+
+INSERT INTO conditions
+SELECT t, t % 4, t % 40
+FROM generate_series(0, 99, 1) t;
+
+CREATE MATERIALIZED VIEW cond_10
+WITH (timescaledb.continuous,
+      timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(BIGINT '10', time) AS bucket, device, avg(temp) AS avg_temp
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+
+CALL refresh_continuous_aggregate('cond_10', 0, 100);
+
+-- Another row trigger on the hypertable must still fire
+CREATE TABLE inserted (time bigint);
+CREATE OR REPLACE FUNCTION record_insert() RETURNS TRIGGER
+LANGUAGE plpgsql AS
+$$
+BEGIN
+    INSERT INTO inserted VALUES (NEW.time);
+    RETURN NULL;
+END
+$$;
+CREATE TRIGGER record_insert AFTER INSERT ON conditions
+FOR EACH ROW EXECUTE FUNCTION record_insert();
+
+CREATE OR REPLACE FUNCTION get_hyper_invals() RETURNS TABLE(
+      "hyper_id" INT,
+      "start" BIGINT,
+      "end" BIGINT
+)
+LANGUAGE SQL VOLATILE AS
+$$
+SELECT hypertable_id,
+       lowest_modified_value,
+       greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log
+ORDER BY 1,2,3
+$$;
+
+SELECT * FROM get_hyper_invals();
+
+-- Rows spanning several chunks, with the trigger
+SET timescaledb.enable_cagg_invalidation_tracking TO off;
+INSERT INTO conditions VALUES (15, 1, 1.0), (3, 1, 1.0), (27, 1, 1.0);
+SELECT * FROM get_hyper_invals();
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+
+-- The same rows tracked by the chunk insert states
+SET timescaledb.enable_cagg_invalidation_tracking TO on;
+INSERT INTO conditions VALUES (15, 1, 1.0), (3, 1, 1.0), (27, 1, 1.0);
+SELECT * FROM get_hyper_invals();
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+
+-- Several statements in one transaction are merged into one range
+BEGIN;
+INSERT INTO conditions VALUES (42, 1, 1.0);
+INSERT INTO conditions VALUES (38, 1, 1.0), (56, 1, 1.0);
+COMMIT;
+SELECT * FROM get_hyper_invals();
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+
+-- COPY is tracked as well
+COPY conditions FROM STDIN DELIMITER ',';
+71,2,1.0
+64,2,1.0
+\.
+SELECT * FROM get_hyper_invals();
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+
+-- Inserts above the invalidation threshold are not logged
+INSERT INTO conditions VALUES (120, 1, 1.0);
+SELECT * FROM get_hyper_invals();
+
+-- ON CONFLICT DO UPDATE still uses the trigger
+DELETE FROM conditions WHERE time IN (3, 15, 27, 38, 42, 56, 64, 71, 120);
+CREATE UNIQUE INDEX conditions_time_device ON conditions (time, device);
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+INSERT INTO conditions VALUES (81, 1, 1.0) ON CONFLICT (time, device) DO UPDATE SET temp = 2.0;
+SELECT * FROM get_hyper_invals();
+
+SELECT count(*) FROM inserted;
+
+RESET timescaledb.enable_cagg_invalidation_tracking;
+
+-- Keep several disjoint ranges per transaction. Values within a bucket
+-- of each other are merged and ranges above the invalidation threshold
+-- are not logged.
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+SET timescaledb.cagg_max_invalidation_ranges TO 4;
+INSERT INTO conditions VALUES (2, 5, 1.0), (91, 5, 1.0), (8, 5, 1.0), (45, 5, 1.0), (150, 5, 1.0);
+SELECT * FROM get_hyper_invals();
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+
+-- The closest ranges are merged when there are too many
+INSERT INTO conditions VALUES (1, 6, 1.0), (30, 6, 1.0), (50, 6, 1.0), (70, 6, 1.0), (95, 6, 1.0);
+SELECT * FROM get_hyper_invals();
+TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
+
+-- Ranges tracked by the chunk insert states are merged the same way
+SET timescaledb.enable_cagg_invalidation_tracking TO on;
+INSERT INTO conditions VALUES (3, 7, 1.0), (5, 7, 1.0), (62, 7, 1.0), (68, 7, 1.0);
+SELECT * FROM get_hyper_invals();
+
+RESET timescaledb.enable_cagg_invalidation_tracking;
+RESET timescaledb.cagg_max_invalidation_ranges;
@@ -0,0 +1,80 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test continuous aggregates on top of a real-time continuous aggregate
+-- created with timescaledb.enable_cagg_nested_materialized_source
+CREATE TABLE conditions (time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION int_now()
+RETURNS int LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'int_now');
+
+INSERT INTO conditions
+SELECT t, t % 2 + 1, t
+FROM generate_series(0, 99, 1) t;
+
+CREATE MATERIALIZED VIEW cond_10
+WITH (timescaledb.continuous, timescaledb.materialized_only=false)
+AS
+SELECT time_bucket(10, time) AS bucket, device, sum(value) AS sum_value, count(*) AS num_values
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+
+CALL refresh_continuous_aggregate('cond_10', 0, 50);
+
+SET timescaledb.enable_cagg_nested_materialized_source = on;
+
+CREATE MATERIALIZED VIEW cond_50
+WITH (timescaledb.continuous, timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(50, bucket) AS bucket, device, sum(sum_value) AS sum_value,
+       sum(num_values) AS num_values
+FROM cond_10
+GROUP BY 1,2 WITH NO DATA;
+
+RESET timescaledb.enable_cagg_nested_materialized_source;
+
+SELECT h.id AS "PARENT_MAT_ID"
+FROM _timescaledb_catalog.continuous_agg ca
+JOIN _timescaledb_catalog.hypertable h ON (h.id = ca.mat_hypertable_id)
+WHERE ca.user_view_name = 'cond_10' \gset
+
+-- The partial view reads the parent materialization hypertable instead of
+-- the real-time parent view
+SELECT pg_get_viewdef(format('%I.%I', partial_view_schema, partial_view_name)::regclass)
+         LIKE '%FROM cond_10%' AS reads_parent_view,
+       pg_get_viewdef(format('%I.%I', partial_view_schema, partial_view_name)::regclass)
+         LIKE '%_materialized_hypertable_' || :PARENT_MAT_ID || '%' AS reads_parent_materialization
+FROM _timescaledb_catalog.continuous_agg
+WHERE user_view_name = 'cond_50';
+
+-- Only the materialized part of the parent is rolled up
+CALL refresh_continuous_aggregate('cond_50', NULL, NULL);
+SELECT * FROM cond_50 ORDER BY 1,2;
+
+CALL refresh_continuous_aggregate('cond_10', 50, 100);
+CALL refresh_continuous_aggregate('cond_50', NULL, NULL);
+SELECT * FROM cond_50 ORDER BY 1,2;
+
+-- Refreshing the parent propagates the refreshed buckets to the nested
+-- continuous aggregate
+INSERT INTO conditions VALUES (55, 1, 1000);
+CALL refresh_continuous_aggregate('cond_10', 0, 100);
+SELECT lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log
+WHERE hypertable_id = :PARENT_MAT_ID;
+CALL refresh_continuous_aggregate('cond_50', NULL, NULL);
+SELECT * FROM cond_50 ORDER BY 1,2;
+
+-- The nested continuous aggregate matches rolling up the raw data
+SELECT time_bucket(50, time) AS bucket, device, sum(value) AS sum_value, count(*) AS num_values
+FROM conditions
+GROUP BY 1,2 ORDER BY 1,2;
+
+DROP MATERIALIZED VIEW cond_50;
+DROP MATERIALIZED VIEW cond_10;
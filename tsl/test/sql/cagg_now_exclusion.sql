@@ -0,0 +1,54 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test plan time chunk exclusion with now() through views and real-time
+-- continuous aggregates
+CREATE TABLE cnow(time timestamptz NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('cnow', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO cnow
+SELECT t, 1, 1.0 FROM generate_series(now() - interval '20 days', now(), interval '1 hour') t;
+CREATE VIEW cnow_v AS SELECT * FROM cnow;
+CREATE VIEW cnow_vv AS SELECT * FROM cnow_v;
+CREATE MATERIALIZED VIEW cnow_daily
+WITH (timescaledb.continuous, timescaledb.materialized_only = false) AS
+SELECT time_bucket('1 day', time) AS bucket, device, avg(value) FROM cnow GROUP BY 1, 2
+WITH NO DATA;
+
+-- the number of scanned chunks of the raw hypertable
+CREATE FUNCTION raw_chunks(query text) RETURNS int
+LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+    chunks int := 0;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (costs off) ' || query LOOP
+        IF line LIKE '% on _hyper_1_%' THEN
+            chunks := chunks + 1;
+        END IF;
+    END LOOP;
+    RETURN chunks;
+END
+$$;
+
+SELECT raw_chunks('SELECT * FROM cnow') > 20;
+SELECT raw_chunks('SELECT * FROM cnow_vv WHERE time > now() - interval ''3 days''') < 6;
+
+-- nothing is materialized, so all rows come from the raw hypertable
+SELECT raw_chunks('SELECT * FROM cnow_daily WHERE bucket > now() - interval ''3 days''') < 6;
+SELECT (SELECT count(*) FROM cnow_daily WHERE bucket > now() - interval '3 days') =
+    (SELECT count(DISTINCT time_bucket('1 day', time)) FROM cnow
+     WHERE time_bucket('1 day', time) > now() - interval '3 days');
+
+CALL refresh_continuous_aggregate('cnow_daily', NULL, now() - interval '10 days');
+SELECT raw_chunks('SELECT * FROM cnow_daily WHERE bucket >= now() - interval ''3 days''') < 6;
+SELECT raw_chunks('SELECT * FROM cnow_daily WHERE bucket >= now() - interval ''15 days''') > 9;
+SELECT (SELECT count(*) FROM cnow_daily WHERE bucket >= now() - interval '15 days') =
+    (SELECT count(DISTINCT time_bucket('1 day', time)) FROM cnow
+     WHERE time_bucket('1 day', time) >= now() - interval '15 days');
+
+DROP FUNCTION raw_chunks(text);
+DROP MATERIALIZED VIEW cnow_daily;
+DROP VIEW cnow_vv;
+DROP VIEW cnow_v;
+DROP TABLE cnow;
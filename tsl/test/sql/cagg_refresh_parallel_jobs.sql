@@ -0,0 +1,95 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test that refreshing a continuous aggregate with
+-- timescaledb.cagg_refresh_parallel_jobs hands the refresh windows over
+-- to refresh jobs
+CREATE TABLE conditions (time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION int_now()
+RETURNS int LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'int_now');
+
+INSERT INTO conditions
+SELECT t, t % 2 + 1, t
+FROM generate_series(0, 49, 1) t;
+
+CREATE MATERIALIZED VIEW cond_10
+WITH (timescaledb.continuous,
+      timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(10, time) AS bucket, device, sum(value) AS sum_value
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+
+CREATE VIEW window_jobs AS
+SELECT application_name, config->>'window_start' AS window_start,
+       config->>'window_end' AS window_end
+FROM _timescaledb_config.bgw_job
+WHERE proc_name = 'policy_refresh_continuous_aggregate_window';
+
+SET timescaledb.cagg_refresh_parallel_jobs TO 2;
+
+-- The merged window is split into one window per job and nothing is
+-- materialized by the refresh itself
+CALL refresh_continuous_aggregate('cond_10', 0, 50);
+SELECT * FROM window_jobs ORDER BY window_start::int;
+SELECT * FROM cond_10 ORDER BY 1, 2;
+
+-- Running the jobs materializes the windows and removes the jobs
+SELECT id AS job_id FROM _timescaledb_config.bgw_job
+WHERE proc_name = 'policy_refresh_continuous_aggregate_window'
+ORDER BY id LIMIT 1 \gset
+CALL run_job(:job_id);
+SELECT * FROM window_jobs ORDER BY window_start::int;
+SELECT * FROM cond_10 ORDER BY 1, 2;
+
+SELECT id AS job_id FROM _timescaledb_config.bgw_job
+WHERE proc_name = 'policy_refresh_continuous_aggregate_window' \gset
+CALL run_job(:job_id);
+SELECT * FROM window_jobs ORDER BY window_start::int;
+SELECT * FROM cond_10 ORDER BY 1, 2;
+
+-- Separate invalidated buckets get their own jobs and the invalidation
+-- threshold is not affected
+SELECT watermark FROM _timescaledb_catalog.continuous_aggs_invalidation_threshold;
+UPDATE conditions SET value = value + 100 WHERE time = 5;
+UPDATE conditions SET value = value + 100 WHERE time = 45;
+CALL refresh_continuous_aggregate('cond_10', 0, 50);
+SELECT * FROM window_jobs ORDER BY window_start::int;
+SELECT watermark FROM _timescaledb_catalog.continuous_aggs_invalidation_threshold;
+
+SELECT id AS job_id FROM _timescaledb_config.bgw_job
+WHERE proc_name = 'policy_refresh_continuous_aggregate_window'
+ORDER BY id LIMIT 1 \gset
+CALL run_job(:job_id);
+SELECT id AS job_id FROM _timescaledb_config.bgw_job
+WHERE proc_name = 'policy_refresh_continuous_aggregate_window' \gset
+CALL run_job(:job_id);
+SELECT * FROM window_jobs ORDER BY window_start::int;
+SELECT * FROM cond_10 ORDER BY 1, 2;
+
+-- A window of a single bucket is not split
+UPDATE conditions SET value = value + 100 WHERE time = 25;
+CALL refresh_continuous_aggregate('cond_10', 0, 50);
+SELECT * FROM window_jobs ORDER BY window_start::int;
+SELECT id AS job_id FROM _timescaledb_config.bgw_job
+WHERE proc_name = 'policy_refresh_continuous_aggregate_window' \gset
+CALL run_job(:job_id);
+SELECT count(*) FROM window_jobs;
+
+-- The materialization matches the aggregates of the raw data
+(SELECT * FROM cond_10
+ EXCEPT
+ SELECT time_bucket(10, time), device, sum(value) FROM conditions GROUP BY 1, 2)
+UNION ALL
+(SELECT time_bucket(10, time), device, sum(value) FROM conditions GROUP BY 1, 2
+ EXCEPT
+ SELECT * FROM cond_10);
+
+RESET timescaledb.cagg_refresh_parallel_jobs;
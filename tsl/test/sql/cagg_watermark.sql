@@ -195,3 +195,41 @@ DROP TABLE ts_continuous_test CASCADE;
 TRUNCATE _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log;
 TRUNCATE _timescaledb_catalog.continuous_aggs_invalidation_threshold;
 \c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+
+-- the watermark of real-time aggregation is stored in the catalog on refresh
+CREATE TABLE wm_test(time int NOT NULL, value int);
+SELECT table_name FROM create_hypertable('wm_test', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION integer_now_wm_test() returns int LANGUAGE SQL STABLE as $$ SELECT coalesce(max(time), 0) FROM wm_test $$;
+SELECT set_integer_now_func('wm_test', 'integer_now_wm_test');
+CREATE MATERIALIZED VIEW wm_view
+    WITH (timescaledb.continuous, timescaledb.materialized_only = false)
+    AS SELECT time_bucket('5', time) AS bucket, sum(value)
+        FROM wm_test
+        GROUP BY 1 WITH NO DATA;
+SELECT ca.mat_hypertable_id AS wm_mat_id, format('%I.%I', h.schema_name, h.table_name) AS wm_mat_ht
+FROM _timescaledb_catalog.continuous_agg ca
+JOIN _timescaledb_catalog.hypertable h ON (h.id = ca.mat_hypertable_id)
+WHERE ca.user_view_name = 'wm_view' \gset
+INSERT INTO wm_test SELECT i, i FROM generate_series(0, 29) i;
+
+-- nothing stored before the first refresh, the watermark is computed
+SELECT count(*) FROM _timescaledb_catalog.continuous_aggs_watermark WHERE mat_hypertable_id = :wm_mat_id;
+SELECT _timescaledb_internal.cagg_watermark(:wm_mat_id);
+
+CALL refresh_continuous_aggregate('wm_view', 0, 20);
+SELECT watermark FROM _timescaledb_catalog.continuous_aggs_watermark WHERE mat_hypertable_id = :wm_mat_id;
+SELECT _timescaledb_internal.cagg_watermark(:wm_mat_id);
+SELECT * FROM wm_view ORDER BY bucket;
+
+CALL refresh_continuous_aggregate('wm_view', 20, 30);
+SELECT watermark FROM _timescaledb_catalog.continuous_aggs_watermark WHERE mat_hypertable_id = :wm_mat_id;
+SELECT _timescaledb_internal.cagg_watermark(:wm_mat_id);
+
+-- dropping the materialized chunks moves the watermark back
+SELECT count(*) FROM drop_chunks(:'wm_mat_ht', older_than => 100);
+SELECT watermark FROM _timescaledb_catalog.continuous_aggs_watermark WHERE mat_hypertable_id = :wm_mat_id;
+SELECT * FROM wm_view ORDER BY bucket;
+
+-- the stored watermark is removed with the continuous aggregate
+DROP TABLE wm_test CASCADE;
+SELECT count(*) FROM _timescaledb_catalog.continuous_aggs_watermark WHERE mat_hypertable_id = :wm_mat_id;
@@ -0,0 +1,44 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE merge_test(time timestamptz NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('merge_test', 'time', chunk_time_interval => INTERVAL '1 hour');
+CREATE INDEX ON merge_test(device, time);
+
+-- This creates chunks 1 - 3
+INSERT INTO merge_test SELECT t, 1, 1.0 FROM generate_series('2018-03-02 1:00'::TIMESTAMPTZ, '2018-03-02 3:59', '1 minute') t;
+
+SELECT chunk_name, range_start, range_end FROM timescaledb_information.chunks WHERE hypertable_name = 'merge_test' ORDER BY range_start;
+
+\set ON_ERROR_STOP 0
+-- Cannot merge a chunk with itself
+SELECT _timescaledb_internal.merge_chunks('_timescaledb_internal._hyper_1_1_chunk', '_timescaledb_internal._hyper_1_1_chunk');
+-- Cannot merge non-adjacent chunks
+SELECT _timescaledb_internal.merge_chunks('_timescaledb_internal._hyper_1_1_chunk', '_timescaledb_internal._hyper_1_3_chunk');
+\set ON_ERROR_STOP 1
+
+-- The later chunk is always merged into the earlier chunk
+SELECT _timescaledb_internal.merge_chunks('_timescaledb_internal._hyper_1_2_chunk', '_timescaledb_internal._hyper_1_1_chunk');
+SELECT chunk_name, range_start, range_end FROM timescaledb_information.chunks WHERE hypertable_name = 'merge_test' ORDER BY range_start;
+SELECT count(*) FROM merge_test;
+SELECT count(*) FROM _timescaledb_internal._hyper_1_1_chunk;
+
+-- Index on the merged chunk contains the moved rows
+SET enable_seqscan TO off;
+SELECT count(*) FROM merge_test WHERE device = 1 AND time >= '2018-03-02 2:00';
+RESET enable_seqscan;
+
+-- Merging compressed chunks
+ALTER TABLE merge_test SET (timescaledb.compress, timescaledb.compress_segmentby = 'device', timescaledb.compress_orderby = 'time');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_3_chunk');
+
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.merge_chunks('_timescaledb_internal._hyper_1_1_chunk', '_timescaledb_internal._hyper_1_3_chunk');
+\set ON_ERROR_STOP 1
+
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+SELECT _timescaledb_internal.merge_chunks('_timescaledb_internal._hyper_1_1_chunk', '_timescaledb_internal._hyper_1_3_chunk');
+SELECT chunk_name, range_start, range_end, is_compressed FROM timescaledb_information.chunks WHERE hypertable_name = 'merge_test' ORDER BY range_start;
+SELECT count(*), min(time), max(time) FROM merge_test;
+SELECT numrows_pre_compression FROM _timescaledb_catalog.compression_chunk_size;
@@ -0,0 +1,60 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test that the chunk prewarm worker counts against
+-- timescaledb.max_background_workers
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION ts_test_bgw_reserve_all_workers() RETURNS int
+AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+CREATE OR REPLACE FUNCTION ts_test_bgw_release_workers(int) RETURNS void
+AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+CREATE OR REPLACE FUNCTION ts_test_bgw_num_unreserved() RETURNS int
+AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+
+-- Wait for the number of unreserved workers to get back to the given number
+CREATE OR REPLACE FUNCTION wait_for_unreserved(expected int) RETURNS bool
+LANGUAGE plpgsql AS
+$$
+BEGIN
+    FOR i IN 1..100 LOOP
+        IF ts_test_bgw_num_unreserved() = expected THEN
+            RETURN true;
+        END IF;
+        PERFORM pg_sleep(0.1);
+    END LOOP;
+    RETURN false;
+END
+$$;
+
+-- The scheduler would reserve workers as well
+SELECT _timescaledb_internal.stop_background_workers();
+
+CREATE TABLE pw(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('pw', 'time', chunk_time_interval => 1000);
+ALTER TABLE pw SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+INSERT INTO pw SELECT t, t % 4, t * 0.5 FROM generate_series(0, 2999) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('pw') ch;
+SELECT ts_test_bgw_num_unreserved() AS unreserved \gset
+
+-- The worker releases its reservation when it is done
+SET timescaledb.chunk_prewarm TO 'all';
+SELECT count(decompress_chunk(ch))
+FROM (SELECT ch FROM show_chunks('pw') ch ORDER BY ch LIMIT 1) c;
+SELECT wait_for_unreserved(:unreserved);
+
+-- Without a free worker the chunks are not prewarmed
+SELECT ts_test_bgw_reserve_all_workers() AS reserved \gset
+SELECT ts_test_bgw_num_unreserved();
+BEGIN;
+SELECT count(decompress_chunk(ch))
+FROM (SELECT ch FROM show_chunks('pw') ch ORDER BY ch OFFSET 1 LIMIT 1) c;
+SET LOCAL client_min_messages TO debug1;
+COMMIT;
+SELECT ts_test_bgw_num_unreserved();
+SELECT ts_test_bgw_release_workers(:reserved);
+SELECT wait_for_unreserved(:unreserved);
+RESET timescaledb.chunk_prewarm;
+
+SELECT count(*), sum(time), sum(value) FROM pw;
+DROP TABLE pw;
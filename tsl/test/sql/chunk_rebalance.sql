@@ -0,0 +1,60 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE rebal(time int NOT NULL, device int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('rebal', 'time', 'device', 1, chunk_time_interval => 10);
+CREATE UNIQUE INDEX ON rebal(device, time);
+INSERT INTO rebal SELECT t, d, t * d FROM generate_series(0, 19) t, generate_series(1, 20) d;
+SELECT count(*) FROM show_chunks('rebal');
+
+-- Existing chunks keep the old partitioning
+SELECT set_number_partitions('rebal', 2);
+SELECT time / 10 AS slice, count(DISTINCT tableoid) FROM rebal GROUP BY 1 ORDER BY 1;
+
+-- Splitting the chunks, one time slice at a time
+SELECT _timescaledb_internal.rebalance_chunks('rebal', 1);
+SELECT time / 10 AS slice, count(DISTINCT tableoid) FROM rebal GROUP BY 1 ORDER BY 1;
+SELECT _timescaledb_internal.rebalance_chunks('rebal');
+SELECT time / 10 AS slice, count(DISTINCT tableoid) FROM rebal GROUP BY 1 ORDER BY 1;
+SELECT count(*) FROM show_chunks('rebal');
+SELECT count(*), sum(value) FROM rebal;
+
+-- The rows of a device are in the same chunk
+SELECT count(*) FROM (
+    SELECT device, time / 10 FROM rebal GROUP BY 1, 2 HAVING count(DISTINCT tableoid) > 1
+) s;
+
+-- The indexes of the new chunks contain the moved rows
+SET enable_seqscan TO off;
+SELECT count(*), sum(value) FROM rebal WHERE device = 3;
+RESET enable_seqscan;
+
+-- Nothing left to rebalance
+SELECT _timescaledb_internal.rebalance_chunks('rebal');
+
+-- Merging the chunks
+SELECT set_number_partitions('rebal', 1);
+SELECT _timescaledb_internal.rebalance_chunks('rebal');
+SELECT time / 10 AS slice, count(DISTINCT tableoid) FROM rebal GROUP BY 1 ORDER BY 1;
+SELECT count(*) FROM show_chunks('rebal');
+SELECT count(*), sum(value) FROM rebal;
+
+-- Time slices with compressed chunks are skipped
+ALTER TABLE rebal SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_7_chunk');
+SELECT set_number_partitions('rebal', 2);
+SELECT _timescaledb_internal.rebalance_chunks('rebal');
+SELECT count(*) FROM show_chunks('rebal');
+SELECT count(*), sum(value) FROM rebal;
+
+CREATE TABLE rebal_time(time int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('rebal_time', 'time', chunk_time_interval => 10);
+
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.rebalance_chunks(NULL);
+SELECT _timescaledb_internal.rebalance_chunks('rebal_time');
+\set ON_ERROR_STOP 1
+
+DROP TABLE rebal;
+DROP TABLE rebal_time;
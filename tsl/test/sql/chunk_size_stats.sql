@@ -0,0 +1,63 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+CREATE TABLE sz(time timestamptz NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('sz', 'time', chunk_time_interval => interval '1 day');
+ALTER TABLE sz SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+INSERT INTO sz SELECT '2023-01-01 00:00+00'::timestamptz + i * interval '1 minute', i % 5, i
+FROM generate_series(0, 4319) i;
+SELECT ch AS first_chunk FROM show_chunks('sz') ch ORDER BY ch LIMIT 1 \gset
+
+CREATE VIEW sz_stats AS
+SELECT count(*) AS chunks
+FROM _timescaledb_catalog.chunk_size_stats s
+JOIN _timescaledb_catalog.hypertable h ON (h.id = s.hypertable_id)
+WHERE h.table_name = 'sz';
+
+CREATE VIEW sz_compare AS
+SELECT a.table_bytes = e.table_bytes AND a.index_bytes = e.index_bytes AND
+    a.toast_bytes = e.toast_bytes AND a.total_bytes = e.total_bytes AS same_detailed,
+    hypertable_approximate_size('sz') = hypertable_size('sz') AS same_total
+FROM hypertable_approximate_detailed_size('sz') a, hypertable_detailed_size('sz') e;
+
+-- only the root table is counted before the stats are refreshed
+SELECT * FROM sz_stats;
+SELECT hypertable_approximate_size('sz') < hypertable_size('sz') AS smaller;
+SELECT _timescaledb_internal.refresh_chunk_size_stats('sz');
+SELECT * FROM sz_stats;
+SELECT * FROM sz_compare;
+
+-- compressing a chunk updates its stats
+SELECT count(compress_chunk(:'first_chunk'));
+SELECT * FROM sz_compare;
+-- the compressed chunk is skipped by the refresh
+SELECT _timescaledb_internal.refresh_chunk_size_stats('sz');
+
+-- the inserts are counted after the refresh
+INSERT INTO sz SELECT '2023-01-03 00:00+00'::timestamptz + i * interval '1 second', 0, i
+FROM generate_series(0, 9999) i;
+SELECT hypertable_approximate_size('sz') < hypertable_size('sz') AS smaller;
+SELECT _timescaledb_internal.refresh_chunk_size_stats('sz');
+SELECT * FROM sz_compare;
+
+-- a partially compressed chunk is refreshed
+INSERT INTO sz VALUES ('2023-01-01 12:00:30+00', 1, 1);
+SELECT _timescaledb_internal.refresh_chunk_size_stats('sz');
+SELECT * FROM sz_compare;
+
+-- decompressing a chunk updates its stats
+SELECT count(decompress_chunk(:'first_chunk'));
+SELECT * FROM sz_compare;
+
+-- the stats are removed with the chunks
+SELECT count(*) FROM drop_chunks('sz', older_than => '2023-01-02 00:00+00'::timestamptz);
+SELECT * FROM sz_stats;
+SELECT * FROM sz_compare;
+
+-- not a hypertable
+SELECT * FROM hypertable_approximate_detailed_size('sz_stats');
+
+DROP VIEW sz_compare;
+DROP VIEW sz_stats;
+DROP TABLE sz;
@@ -0,0 +1,66 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the exclusion of compressed chunks by the ranges of a non-partitioning column
+CREATE OR REPLACE FUNCTION scanned_chunks(query text) RETURNS int LANGUAGE plpgsql AS
+$$
+DECLARE
+    line text;
+    chunks text[] := '{}';
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (costs off) ' || query LOOP
+        IF line ~ ' on _hyper_\d+_\d+_chunk' AND
+           NOT (substring(line from '_hyper_\d+_\d+_chunk') = ANY(chunks)) THEN
+            chunks := chunks || substring(line from '_hyper_\d+_\d+_chunk');
+        END IF;
+    END LOOP;
+    RETURN cardinality(chunks);
+END
+$$;
+
+CREATE TABLE readings(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('readings', 'time', chunk_time_interval => 10);
+ALTER TABLE readings SET (timescaledb.compress, timescaledb.compress_orderby = 'time');
+
+\set ON_ERROR_STOP 0
+SELECT enable_chunk_skipping('readings', 'foo');
+SELECT disable_chunk_skipping('readings', 'device');
+\set ON_ERROR_STOP 1
+
+SELECT enable_chunk_skipping('readings', 'device');
+\set ON_ERROR_STOP 0
+SELECT enable_chunk_skipping('readings', 'device');
+\set ON_ERROR_STOP 1
+SELECT enable_chunk_skipping('readings', 'device', if_not_exists => true);
+
+-- the device is correlated with the time, but not partitioned by it
+INSERT INTO readings SELECT t, 1000 - t, t FROM generate_series(0, 29) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('readings') ch;
+
+SELECT chunk_id, column_name, range_start, range_end, has_nulls
+FROM _timescaledb_catalog.chunk_column_stats ORDER BY chunk_id, column_name;
+
+SELECT scanned_chunks('SELECT * FROM readings WHERE device = 995');
+SELECT scanned_chunks('SELECT * FROM readings WHERE device < 985');
+SELECT scanned_chunks('SELECT * FROM readings WHERE device IS NULL');
+SELECT scanned_chunks('SELECT * FROM readings WHERE value = 5');
+SELECT count(*) FROM readings WHERE device = 995;
+SELECT count(*) FROM readings WHERE device < 985;
+
+SET timescaledb.enable_chunk_skipping TO off;
+SELECT scanned_chunks('SELECT * FROM readings WHERE device = 995');
+RESET timescaledb.enable_chunk_skipping;
+
+-- the ranges of a partially compressed chunk are not used
+INSERT INTO readings VALUES (1, 5000, 1);
+SELECT scanned_chunks('SELECT * FROM readings WHERE device = 5000');
+SELECT scanned_chunks('SELECT * FROM readings WHERE device = 985');
+SELECT count(*) FROM readings WHERE device = 5000;
+
+SELECT disable_chunk_skipping('readings', 'device');
+SELECT disable_chunk_skipping('readings', 'device', if_exists => true);
+SELECT count(*) FROM _timescaledb_catalog.chunk_column_stats;
+
+DROP TABLE readings;
+DROP FUNCTION scanned_chunks(text);
@@ -0,0 +1,34 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test dropping the compressed batches older than the retention cutoff
+CREATE TABLE br(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('br', 'time', chunk_time_interval => 10000);
+ALTER TABLE br SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+-- five batches of 1000 rows for each device in the first chunk
+INSERT INTO br SELECT t, t % 2, t FROM generate_series(0, 10009) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('br') ch;
+
+-- without batch retention, the chunk that spans the cutoff is kept as is
+SELECT drop_chunks('br', older_than => 4500);
+SELECT count(*), min(time) FROM br;
+
+-- the batches that only hold rows before the cutoff are deleted
+SET timescaledb.enable_batch_retention TO on;
+SELECT drop_chunks('br', older_than => 4500, verbose => true);
+SELECT count(*), min(time) FROM br;
+SELECT count(*) FROM br WHERE time < 4500;
+SELECT c.table_name, s.numrows_pre_compression, s.numrows_post_compression
+FROM _timescaledb_catalog.chunk c
+JOIN _timescaledb_catalog.compression_chunk_size s ON (s.chunk_id = c.id)
+ORDER BY c.id;
+
+-- the batches are not deleted with newer_than
+SELECT drop_chunks('br', older_than => 6500, newer_than => 0);
+SELECT count(*) FROM br;
+RESET timescaledb.enable_batch_retention;
+
+DROP TABLE br;
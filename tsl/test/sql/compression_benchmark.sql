@@ -0,0 +1,57 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION ts_bench_compression(algorithm_name TEXT, distribution_name TEXT,
+    num_rows INTEGER, iterations INTEGER, OUT algorithm TEXT, OUT distribution TEXT,
+    OUT rows INTEGER, OUT uncompressed_bytes BIGINT, OUT compressed_bytes BIGINT,
+    OUT ratio FLOAT8, OUT compress_mb_per_s FLOAT8, OUT decompress_mb_per_s FLOAT8)
+AS :TSL_MODULE_PATHNAME LANGUAGE C VOLATILE STRICT;
+CREATE OR REPLACE FUNCTION ts_bench_compression_values(algorithm_name TEXT, "values" ANYARRAY,
+    iterations INTEGER, OUT algorithm TEXT, OUT distribution TEXT,
+    OUT rows INTEGER, OUT uncompressed_bytes BIGINT, OUT compressed_bytes BIGINT,
+    OUT ratio FLOAT8, OUT compress_mb_per_s FLOAT8, OUT decompress_mb_per_s FLOAT8)
+AS :TSL_MODULE_PATHNAME LANGUAGE C VOLATILE STRICT;
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+
+-- The timings vary, so only check that the benchmark runs and that the data
+-- compresses where it must
+SELECT b.algorithm, b.distribution, b.rows, b.uncompressed_bytes, b.ratio > 1 AS compressed,
+    b.compress_mb_per_s > 0 AND b.decompress_mb_per_s > 0 AS timed
+FROM (VALUES ('deltadelta', 'constant'), ('deltadelta', 'sequential'),
+    ('deltadelta', 'timestamps'), ('gorilla', 'constant'), ('bitpack', 'small_range'),
+    ('dictionary', 'low_cardinality'), ('simple8b', 'sequential')) v(a, d),
+    ts_bench_compression(v.a, v.d, 2500, 2) b;
+
+-- the other distributions
+SELECT b.algorithm, b.distribution, b.compressed_bytes > 0 AS compressed,
+    b.compress_mb_per_s > 0 AND b.decompress_mb_per_s > 0 AS timed
+FROM (VALUES ('array', 'random'), ('array', 'unique_text'), ('dictionary', 'unique_text'),
+    ('gorilla', 'sine'), ('gorilla', 'random_float'), ('deltadelta', 'random'),
+    ('bitpack', 'random'), ('simple8b', 'random')) v(a, d),
+    ts_bench_compression(v.a, v.d, 1500, 1) b;
+
+-- recorded data, with nulls
+CREATE TABLE recorded(time timestamptz, value float8);
+INSERT INTO recorded
+SELECT '2023-01-01'::timestamptz + i * interval '1 minute', CASE WHEN i % 10 <> 0 THEN i % 7 END
+FROM generate_series(1, 2000) i;
+SELECT b.algorithm, b.distribution, b.rows, b.uncompressed_bytes, b.ratio > 1 AS compressed
+FROM (VALUES ('deltadelta'), ('simple8b')) v(a),
+    ts_bench_compression_values(v.a, (SELECT array_agg(time ORDER BY time) FROM recorded), 1) b;
+SELECT b.algorithm, b.distribution, b.rows, b.uncompressed_bytes, b.ratio > 1 AS compressed
+FROM (VALUES ('gorilla'), ('dictionary')) v(a),
+    ts_bench_compression_values(v.a, (SELECT array_agg(value ORDER BY time) FROM recorded), 1) b;
+
+\set ON_ERROR_STOP 0
+SELECT * FROM ts_bench_compression('lz4', 'constant', 10, 1);
+SELECT * FROM ts_bench_compression('deltadelta', 'zipf', 10, 1);
+SELECT * FROM ts_bench_compression('gorilla', 'unique_text', 10, 1);
+SELECT * FROM ts_bench_compression('simple8b', 'sine', 10, 1);
+SELECT * FROM ts_bench_compression('deltadelta', 'constant', 10, 0);
+SELECT * FROM ts_bench_compression_values('simple8b',
+    (SELECT array_agg(value::bigint) FROM recorded), 1);
+\set ON_ERROR_STOP 1
+
+DROP TABLE recorded;
@@ -0,0 +1,76 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the bit-packing of the integer batches that jitter in a small range
+CREATE TABLE bp(time int NOT NULL, device int, status int2, pct int4, counter int8);
+SELECT table_name FROM create_hypertable('bp', 'time', chunk_time_interval => 10000);
+ALTER TABLE bp SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO bp SELECT t, t % 2, h % 8, (h / 8) % 101,
+    CASE WHEN t % 10 = 0 THEN NULL ELSE (h / 1000) % 1000 END
+FROM (SELECT t, (t::int8 * 2654435761) % 4294967291 AS h FROM generate_series(1, 2000) t) s;
+CREATE TABLE bp_orig AS SELECT * FROM bp;
+
+-- the same data compressed with delta-delta only
+CREATE TABLE dd(time int NOT NULL, device int, status int2, pct int4, counter int8);
+SELECT table_name FROM create_hypertable('dd', 'time', chunk_time_interval => 10000);
+ALTER TABLE dd SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO dd SELECT * FROM bp_orig;
+
+SET timescaledb.enable_bitpack_compression TO on;
+SELECT count(compress_chunk(ch)) FROM show_chunks('bp') ch;
+RESET timescaledb.enable_bitpack_compression;
+SELECT count(compress_chunk(ch)) FROM show_chunks('dd') ch;
+
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "BP_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'bp' \gset
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "DD_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'dd' \gset
+
+-- the algorithm of each batch is stored in its header, the ordered time column
+-- stays delta-delta
+SELECT device, get_byte(decode(time::text, 'base64'), 0) AS time,
+    get_byte(decode(status::text, 'base64'), 0) AS status,
+    get_byte(decode(pct::text, 'base64'), 0) AS pct,
+    get_byte(decode(counter::text, 'base64'), 0) AS counter
+FROM :BP_CHUNK ORDER BY device;
+SELECT device, get_byte(decode(status::text, 'base64'), 0) AS status,
+    get_byte(decode(pct::text, 'base64'), 0) AS pct,
+    get_byte(decode(counter::text, 'base64'), 0) AS counter
+FROM :DD_CHUNK ORDER BY device;
+SELECT (SELECT sum(pg_column_size(status) + pg_column_size(pct) + pg_column_size(counter))
+        FROM :BP_CHUNK) <
+    (SELECT sum(pg_column_size(status) + pg_column_size(pct) + pg_column_size(counter))
+        FROM :DD_CHUNK) AS smaller;
+
+-- the text representation round-trips
+SELECT count(*) FROM :BP_CHUNK
+WHERE pct::text::_timescaledb_internal.compressed_data::text <> pct::text
+    OR counter::text::_timescaledb_internal.compressed_data::text <> counter::text;
+
+-- the decompressed data is the same as the original
+SELECT count(*) FROM (SELECT * FROM bp EXCEPT ALL SELECT * FROM bp_orig) e;
+SELECT count(*) FROM (SELECT * FROM bp_orig EXCEPT ALL SELECT * FROM bp) e;
+SELECT count(*), sum(status), sum(pct), sum(counter), count(counter) FROM bp;
+SELECT count(*), sum(status), sum(pct), sum(counter), count(counter) FROM bp_orig;
+SELECT * FROM bp ORDER BY time DESC LIMIT 5;
+SELECT (SELECT count(*) FROM bp WHERE pct > 50 AND counter < 500) =
+    (SELECT count(*) FROM bp_orig WHERE pct > 50 AND counter < 500) AS same;
+SET timescaledb.enable_bulk_decompression TO off;
+SELECT count(*) FROM (SELECT * FROM bp EXCEPT ALL SELECT * FROM bp_orig) e;
+SELECT * FROM bp ORDER BY time DESC LIMIT 5;
+RESET timescaledb.enable_bulk_decompression;
+
+SELECT count(decompress_chunk(ch)) FROM show_chunks('bp') ch;
+SELECT count(*) FROM (SELECT * FROM bp EXCEPT ALL SELECT * FROM bp_orig) e;
+DROP TABLE bp;
+DROP TABLE dd;
+DROP TABLE bp_orig;
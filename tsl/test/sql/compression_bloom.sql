@@ -0,0 +1,64 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the bloom filter metadata of the timescaledb.compress_bloom columns
+CREATE TABLE bl(time int NOT NULL, device int, ival int, trace text);
+SELECT table_name FROM create_hypertable('bl', 'time', chunk_time_interval => 10000);
+
+\set ON_ERROR_STOP 0
+ALTER TABLE bl SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_bloom = 'foo');
+ALTER TABLE bl SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_bloom = 'device');
+ALTER TABLE bl SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_bloom = 'ival desc');
+\set ON_ERROR_STOP 1
+
+ALTER TABLE bl SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time',
+    timescaledb.compress_bloom = 'ival, trace');
+INSERT INTO bl SELECT t, t % 2, t, 'trace-' || t FROM generate_series(1, 4000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('bl') ch;
+
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'bl' \gset
+
+SELECT attname, atttypid::regtype FROM pg_attribute
+WHERE attrelid = :'COMPRESSED_CHUNK'::regclass AND attnum > 0 AND NOT attisdropped
+ORDER BY attnum;
+SELECT device, _ts_meta_count, length(_ts_meta_v2_bloom1_ival) AS ival_bytes,
+    length(_ts_meta_v2_bloom1_trace) AS trace_bytes
+FROM :COMPRESSED_CHUNK ORDER BY device, _ts_meta_min_1;
+
+-- the batches are filtered by the bloom filter before decompression
+SELECT device, _ts_meta_min_1 FROM :COMPRESSED_CHUNK
+WHERE _timescaledb_internal.bloom1_contains(_ts_meta_v2_bloom1_ival, 1234)
+ORDER BY device, _ts_meta_min_1;
+SELECT device, _ts_meta_min_1 FROM :COMPRESSED_CHUNK
+WHERE _timescaledb_internal.bloom1_contains(_ts_meta_v2_bloom1_ival, 5000)
+ORDER BY device, _ts_meta_min_1;
+
+-- the equality filters on the column are pushed down to the compressed scan
+EXPLAIN (costs off) SELECT count(*) FROM bl WHERE ival = 1234;
+EXPLAIN (costs off) SELECT count(*) FROM bl WHERE trace = 'trace-1234';
+EXPLAIN (costs off) SELECT count(*) FROM bl WHERE ival > 1234;
+SELECT count(*) FROM bl WHERE ival = 1234;
+SELECT count(*) FROM bl WHERE ival = 5000;
+SELECT count(*) FROM bl WHERE trace = 'trace-1234';
+SELECT count(*) FROM bl WHERE trace = 'trace-5000';
+SELECT count(*) FROM bl WHERE ival > 1234;
+
+-- the bloom filter column follows the renames of the column
+ALTER TABLE bl RENAME COLUMN ival TO i;
+SELECT attname FROM pg_attribute
+WHERE attrelid = :'COMPRESSED_CHUNK'::regclass AND attnum > 0 AND NOT attisdropped
+ORDER BY attnum;
+SELECT count(*) FROM bl WHERE i = 1234;
+DROP TABLE bl;
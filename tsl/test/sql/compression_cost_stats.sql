@@ -0,0 +1,39 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test estimating DecompressChunk from the compression statistics
+CREATE TABLE ccs(time int NOT NULL, dev int, val float8);
+SELECT table_name FROM create_hypertable('ccs', 'time', chunk_time_interval => 1000);
+ALTER TABLE ccs SET (timescaledb.compress, timescaledb.compress_segmentby = 'dev');
+-- 10 batches of 10 rows
+INSERT INTO ccs SELECT t, t % 10, t FROM generate_series(1, 100) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('ccs') ch;
+SELECT format('%I.%I', c.schema_name, c.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk c JOIN _timescaledb_catalog.chunk u ON c.id = u.compressed_chunk_id
+WHERE u.hypertable_id = (SELECT id FROM _timescaledb_catalog.hypertable WHERE table_name = 'ccs') \gset
+ANALYZE :COMPRESSED_CHUNK;
+
+CREATE FUNCTION decompress_rows(query text) RETURNS text
+LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+        IF line LIKE '%DecompressChunk%' THEN
+            RETURN substring(line FROM 'rows=([0-9]+)');
+        END IF;
+    END LOOP;
+    RETURN NULL;
+END
+$$;
+
+-- without the statistics every batch is assumed to have 1000 rows
+SELECT decompress_rows('SELECT * FROM ccs');
+SET timescaledb.enable_compression_cost_stats TO on;
+SELECT decompress_rows('SELECT * FROM ccs');
+SELECT decompress_rows('SELECT * FROM ccs WHERE dev = 1');
+RESET timescaledb.enable_compression_cost_stats;
+
+DROP FUNCTION decompress_rows(text);
+DROP TABLE ccs;
@@ -0,0 +1,113 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test compressing the chunks created by inserts right away
+CREATE TABLE dc(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('dc', 'time', chunk_time_interval => 100000);
+ALTER TABLE dc SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+
+-- device 0 fills a batch, the other rows are compressed into smaller batches
+-- instead of going to the uncompressed chunk
+SET timescaledb.enable_direct_compression TO on;
+INSERT INTO dc SELECT t, CASE WHEN t % 4 = 0 THEN 1 ELSE 0 END, t * 0.5
+FROM generate_series(1, 1500) t;
+
+SELECT ch AS "CHUNK" FROM show_chunks('dc') ch \gset
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'dc' \gset
+
+SELECT device, _ts_meta_count, _ts_meta_sequence_num, _ts_meta_min_1, _ts_meta_max_1
+FROM :COMPRESSED_CHUNK ORDER BY device, _ts_meta_sequence_num;
+SELECT count(*) FROM ONLY :CHUNK;
+SELECT ch.status FROM _timescaledb_catalog.chunk ch
+WHERE format('%I.%I', ch.schema_name, ch.table_name)::regclass = :'CHUNK'::regclass;
+SELECT count(*), sum(time), sum(value) FROM dc;
+SELECT device, count(*), min(time), max(time) FROM dc GROUP BY device ORDER BY device;
+
+-- the rows inserted into the existing chunk only go into batches they fill
+INSERT INTO dc VALUES (1501, 0, 750.5);
+SELECT count(*) FROM ONLY :CHUNK;
+SELECT ch.status FROM _timescaledb_catalog.chunk ch
+WHERE format('%I.%I', ch.schema_name, ch.table_name)::regclass = :'CHUNK'::regclass;
+SELECT count(*), sum(time), sum(value) FROM dc;
+DROP TABLE dc;
+
+-- the rows can't be buffered with a row trigger, so the chunk isn't compressed
+CREATE TABLE dc_trig(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('dc_trig', 'time', chunk_time_interval => 100000);
+ALTER TABLE dc_trig SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+CREATE TABLE inserted (time int);
+CREATE OR REPLACE FUNCTION record_insert() RETURNS TRIGGER
+LANGUAGE plpgsql AS
+$$
+BEGIN
+    INSERT INTO inserted VALUES (NEW.time);
+    RETURN NULL;
+END
+$$;
+CREATE TRIGGER record_insert AFTER INSERT ON dc_trig
+FOR EACH ROW EXECUTE FUNCTION record_insert();
+
+INSERT INTO dc_trig SELECT t, t % 2, t * 0.5 FROM generate_series(1, 100) t;
+SELECT ch.status, ch.compressed_chunk_id IS NULL AS uncompressed
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.id
+WHERE ht.table_name = 'dc_trig';
+SELECT count(*) FROM dc_trig;
+SELECT count(*) FROM inserted;
+DROP TABLE dc_trig;
+DROP TABLE inserted;
+
+-- the continuous aggregate invalidation trigger only allows it when the
+-- chunk insert state tracks the invalidations
+CREATE TABLE conditions (time bigint NOT NULL, device int, temp float);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => 10);
+CREATE OR REPLACE FUNCTION bigint_now()
+RETURNS bigint LANGUAGE SQL STABLE AS
+$$
+    SELECT coalesce(max(time), 0)
+    FROM conditions
+$$;
+SELECT set_integer_now_func('conditions', 'bigint_now');
+ALTER TABLE conditions SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+
+RESET timescaledb.enable_direct_compression;
+INSERT INTO conditions
+SELECT t, t % 4, t % 40
+FROM generate_series(100, 199, 1) t;
+
+CREATE MATERIALIZED VIEW cond_10
+WITH (timescaledb.continuous,
+      timescaledb.materialized_only=true)
+AS
+SELECT time_bucket(BIGINT '10', time) AS bucket, device, avg(temp) AS avg_temp
+FROM conditions
+GROUP BY 1,2 WITH NO DATA;
+CALL refresh_continuous_aggregate('cond_10', 0, 200);
+
+SET timescaledb.enable_direct_compression TO on;
+SET timescaledb.enable_cagg_invalidation_tracking TO off;
+INSERT INTO conditions VALUES (3, 1, 1.0), (5, 1, 2.0);
+SET timescaledb.enable_cagg_invalidation_tracking TO on;
+INSERT INTO conditions VALUES (13, 1, 1.0), (15, 1, 2.0);
+
+SELECT ch.status, ds.range_start
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.id
+JOIN _timescaledb_catalog.chunk_constraint cc ON cc.chunk_id = ch.id
+JOIN _timescaledb_catalog.dimension_slice ds ON ds.id = cc.dimension_slice_id
+WHERE ht.table_name = 'conditions' AND ds.range_start < 100
+ORDER BY ds.range_start;
+SELECT lowest_modified_value, greatest_modified_value
+FROM _timescaledb_catalog.continuous_aggs_hypertable_invalidation_log
+ORDER BY 1, 2;
+
+CALL refresh_continuous_aggregate('cond_10', 0, 20);
+SELECT * FROM cond_10 WHERE bucket < 100 ORDER BY bucket, device;
+RESET timescaledb.enable_cagg_invalidation_tracking;
+RESET timescaledb.enable_direct_compression;
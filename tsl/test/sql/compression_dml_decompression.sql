@@ -0,0 +1,93 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test UPDATE and DELETE on compressed chunks
+CREATE TABLE dml(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('dml', 'time', chunk_time_interval => 100000);
+ALTER TABLE dml SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO dml SELECT t, t % 4, t FROM generate_series(1, 8000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('dml') ch;
+
+SELECT ch AS "CHUNK" FROM show_chunks('dml') ch \gset
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'dml' \gset
+
+\set ON_ERROR_STOP 0
+DELETE FROM dml WHERE device = 1;
+\set ON_ERROR_STOP 1
+
+SET timescaledb.enable_dml_decompression TO on;
+
+-- only the batches of device 1 are decompressed
+DELETE FROM dml WHERE device = 1;
+SELECT device, count(*) FROM :COMPRESSED_CHUNK GROUP BY device ORDER BY device;
+SELECT count(*) FROM ONLY :CHUNK;
+
+-- only the batch of device 2 with times above 7000 is decompressed
+UPDATE dml SET value = -1 WHERE device = 2 AND time > 7000;
+SELECT device, count(*) FROM :COMPRESSED_CHUNK GROUP BY device ORDER BY device;
+SELECT count(*), count(*) FILTER (WHERE value = -1) FROM ONLY :CHUNK;
+SELECT ch.status FROM _timescaledb_catalog.chunk ch
+WHERE format('%I.%I', ch.schema_name, ch.table_name)::regclass = :'CHUNK'::regclass;
+
+-- the indexes of the chunk include the decompressed rows
+SET enable_seqscan TO off;
+SELECT count(*) FROM ONLY :CHUNK WHERE time > 7000;
+RESET enable_seqscan;
+
+SELECT count(*), sum(time), sum(value) FROM dml;
+SELECT count(decompress_chunk(ch)) FROM show_chunks('dml') ch;
+SELECT count(*), sum(time), sum(value) FROM dml;
+
+RESET timescaledb.enable_dml_decompression;
+DROP TABLE dml;
+
+-- Test unique constraints and ON CONFLICT on compressed chunks. Only the
+-- batches that can contain a conflicting row are decompressed.
+CREATE TABLE dml_unique(time int NOT NULL, device int, value float8, UNIQUE (device, time));
+SELECT table_name FROM create_hypertable('dml_unique', 'time', chunk_time_interval => 100000);
+ALTER TABLE dml_unique SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO dml_unique SELECT t, t % 4, t FROM generate_series(1, 8000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('dml_unique') ch;
+
+SELECT ch AS "CHUNK" FROM show_chunks('dml_unique') ch \gset
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'dml_unique' \gset
+
+\set ON_ERROR_STOP 0
+INSERT INTO dml_unique VALUES (8, 0, 0);
+\set ON_ERROR_STOP 1
+
+SET timescaledb.enable_dml_decompression TO on;
+
+-- only the batch of device 0 with time 8 is decompressed
+INSERT INTO dml_unique VALUES (8, 0, 0) ON CONFLICT DO NOTHING;
+SELECT device, count(*) FROM :COMPRESSED_CHUNK GROUP BY device ORDER BY device;
+SELECT count(*) FROM ONLY :CHUNK;
+
+-- the first row is after all the batches of device 1, the second one updates
+-- a row of the decompressed batch
+INSERT INTO dml_unique VALUES (8001, 1, 0), (5, 1, 0)
+ON CONFLICT (device, time) DO UPDATE SET value = -1;
+SELECT device, count(*) FROM :COMPRESSED_CHUNK GROUP BY device ORDER BY device;
+SELECT count(*), count(*) FILTER (WHERE value = -1) FROM ONLY :CHUNK;
+SELECT ch.status FROM _timescaledb_catalog.chunk ch
+WHERE format('%I.%I', ch.schema_name, ch.table_name)::regclass = :'CHUNK'::regclass;
+
+-- rows with NULLs cannot conflict, nothing is decompressed
+INSERT INTO dml_unique VALUES (12, NULL, 0);
+SELECT device, count(*) FROM :COMPRESSED_CHUNK GROUP BY device ORDER BY device;
+
+SELECT count(*), sum(time), sum(value) FROM dml_unique;
+
+RESET timescaledb.enable_dml_decompression;
+DROP TABLE dml_unique;
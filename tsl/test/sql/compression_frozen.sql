@@ -0,0 +1,34 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test that compression and decompression write the rows frozen into the
+-- relations created or truncated in the same transaction. The xmin of a
+-- frozen row reads as FrozenTransactionId (2).
+CREATE TABLE fz(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('fz', 'time', chunk_time_interval => 100000);
+ALTER TABLE fz SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+INSERT INTO fz SELECT t, t % 4, t * 0.5 FROM generate_series(1, 4000) t;
+SELECT ch AS "CHUNK" FROM show_chunks('fz') ch \gset
+
+-- the compressed chunk is created by compress_chunk
+SELECT count(*) FROM compress_chunk(:'CHUNK');
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'fz' \gset
+SELECT count(*), count(*) FILTER (WHERE xmin::text = '2') AS frozen FROM :COMPRESSED_CHUNK;
+
+-- the uncompressed chunk was truncated by an earlier transaction
+SELECT count(*) FROM decompress_chunk(:'CHUNK');
+SELECT count(*), count(*) FILTER (WHERE xmin::text = '2') AS frozen FROM ONLY :CHUNK;
+
+-- the uncompressed chunk was truncated by compress_chunk in the same transaction
+BEGIN;
+SELECT count(*) FROM compress_chunk(:'CHUNK');
+SELECT count(*) FROM decompress_chunk(:'CHUNK');
+COMMIT;
+SELECT count(*), count(*) FILTER (WHERE xmin::text = '2') AS frozen FROM ONLY :CHUNK;
+SELECT count(*), sum(time), sum(value) FROM fz;
+
+DROP TABLE fz;
@@ -0,0 +1,49 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test compressing the chunks without sorting when the rows are in order
+CREATE TABLE hg(time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('hg', 'time', chunk_time_interval => 100000);
+ALTER TABLE hg SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO hg SELECT t, t % 4, t * 2 FROM generate_series(1, 1000) t;
+
+SET timescaledb.enable_compression_hash_grouping TO on;
+SET timescaledb.compress_batch_size TO 100;
+SELECT count(compress_chunk(ch)) FROM show_chunks('hg') ch;
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'hg' \gset
+SELECT device, count(*), sum(_ts_meta_count) FROM :COMPRESSED_CHUNK
+GROUP BY device ORDER BY device;
+-- the batches of a segment don't overlap
+SELECT count(*) FROM (
+    SELECT _ts_meta_min_1, lag(_ts_meta_max_1) OVER (
+        PARTITION BY device ORDER BY _ts_meta_sequence_num) AS prev_max
+    FROM :COMPRESSED_CHUNK
+) b WHERE _ts_meta_min_1 <= prev_max;
+SELECT count(*), sum(time), sum(value) FROM hg;
+
+-- a row out of order falls back to sorting the chunk
+SELECT count(decompress_chunk(ch)) FROM show_chunks('hg') ch;
+INSERT INTO hg VALUES (0, 1, 0);
+SELECT count(compress_chunk(ch)) FROM show_chunks('hg') ch;
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'hg' \gset
+SELECT device, count(*), sum(_ts_meta_count) FROM :COMPRESSED_CHUNK
+GROUP BY device ORDER BY device;
+SELECT count(*) FROM (
+    SELECT _ts_meta_min_1, lag(_ts_meta_max_1) OVER (
+        PARTITION BY device ORDER BY _ts_meta_sequence_num) AS prev_max
+    FROM :COMPRESSED_CHUNK
+) b WHERE _ts_meta_min_1 <= prev_max;
+SELECT count(*), sum(time), sum(value) FROM hg;
+
+RESET timescaledb.enable_compression_hash_grouping;
+RESET timescaledb.compress_batch_size;
+DROP TABLE hg;
@@ -0,0 +1,46 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test buffering the inserts into compressed chunks into new batches
+CREATE TABLE ib(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('ib', 'time', chunk_time_interval => 100000);
+ALTER TABLE ib SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO ib SELECT t, t % 2, t * 0.5 FROM generate_series(1, 2000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('ib') ch;
+CREATE TABLE ib_orig AS SELECT * FROM ib;
+
+SELECT ch AS "CHUNK" FROM show_chunks('ib') ch \gset
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'ib' \gset
+
+-- device 0 fills two new batches, the other rows go to the uncompressed chunk
+SET timescaledb.enable_compressed_insert_buffering TO on;
+INSERT INTO ib SELECT t, CASE WHEN t % 6 = 0 THEN 1 ELSE 0 END, t * 0.5
+FROM generate_series(2001, 5000) t;
+INSERT INTO ib_orig SELECT t, CASE WHEN t % 6 = 0 THEN 1 ELSE 0 END, t * 0.5
+FROM generate_series(2001, 5000) t;
+
+SELECT device, _ts_meta_count, _ts_meta_sequence_num, _ts_meta_min_1, _ts_meta_max_1
+FROM :COMPRESSED_CHUNK ORDER BY device, _ts_meta_sequence_num;
+SELECT device, count(*), min(time), max(time) FROM ONLY :CHUNK GROUP BY device ORDER BY device;
+SELECT ch.status FROM _timescaledb_catalog.chunk ch
+WHERE format('%I.%I', ch.schema_name, ch.table_name)::regclass = :'CHUNK'::regclass;
+
+SELECT count(*), sum(time), sum(value) FROM ib;
+SELECT device, count(*) FROM ib GROUP BY device ORDER BY device;
+SELECT * FROM ib WHERE device = 0 ORDER BY time DESC LIMIT 3;
+SELECT count(*) FROM (SELECT * FROM ib EXCEPT ALL SELECT * FROM ib_orig) d;
+SELECT count(*) FROM (SELECT * FROM ib_orig EXCEPT ALL SELECT * FROM ib) d;
+
+-- the new batches are decompressed like the others
+SELECT count(decompress_chunk(ch)) FROM show_chunks('ib') ch;
+SELECT count(*), sum(time), sum(value) FROM ib;
+SELECT count(*) FROM (SELECT * FROM ib EXCEPT ALL SELECT * FROM ib_orig) d;
+RESET timescaledb.enable_compressed_insert_buffering;
+DROP TABLE ib;
+DROP TABLE ib_orig;
@@ -0,0 +1,73 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the compression algorithm for JSONB with objects that share their keys
+-- and with values that are not all objects
+CREATE TABLE js(time int NOT NULL, device int, payload jsonb, mixed jsonb);
+SELECT table_name FROM create_hypertable('js', 'time', chunk_time_interval => 10000);
+SET timescaledb.enable_jsonb_compression TO on;
+ALTER TABLE js SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+RESET timescaledb.enable_jsonb_compression;
+INSERT INTO js SELECT t, t % 2,
+    CASE WHEN t % 11 = 0 THEN NULL ELSE jsonb_build_object(
+        'seq', t,
+        'temp', round((t % 50) / 3.0, 2),
+        'level', CASE WHEN t % 4 = 0 THEN to_jsonb(t / 4) ELSE to_jsonb(round(t / 4.0, 2)) END,
+        'status', (ARRAY['ok', 'warn', 'error'])[t % 3 + 1],
+        'note', CASE WHEN t % 7 = 0 THEN NULL ELSE 'n' END,
+        'tags', jsonb_build_array(t % 4, 'x'),
+        'flag', t % 2 = 0) ||
+        CASE WHEN t % 5 = 0 THEN jsonb_build_object('extra', 'e' || t) ELSE '{}' END
+    END,
+    CASE WHEN t % 3 = 0 THEN to_jsonb(t) ELSE jsonb_build_object('a', t) END
+FROM generate_series(1, 2000) t;
+CREATE TABLE js_orig AS SELECT * FROM js;
+
+SELECT attname, al.name
+FROM _timescaledb_catalog.hypertable_compression hc
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = hc.hypertable_id
+JOIN _timescaledb_catalog.compression_algorithm al ON al.id = hc.compression_algorithm_id
+WHERE ht.table_name = 'js' AND attname IN ('payload', 'mixed')
+ORDER BY attname;
+
+SELECT count(compress_chunk(ch)) FROM show_chunks('js') ch;
+
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "JS_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'js' \gset
+
+-- the algorithm and the encoding of every batch: keys for the objects and
+-- plain for the column with scalars
+SELECT device, get_byte(decode(payload::text, 'base64'), 0) AS algorithm,
+    get_byte(decode(payload::text, 'base64'), 1) AS payload,
+    get_byte(decode(mixed::text, 'base64'), 1) AS mixed
+FROM :JS_CHUNK ORDER BY device;
+
+-- the text representation round-trips
+SELECT count(*) FROM :JS_CHUNK
+WHERE payload::text::_timescaledb_internal.compressed_data::text <> payload::text
+    OR mixed::text::_timescaledb_internal.compressed_data::text <> mixed::text;
+
+-- the decompressed data is the same as the original, in both directions,
+-- compared as text since jsonb equality ignores the scale of numbers
+SELECT count(*) FROM (SELECT time, payload::text, mixed::text FROM js
+    EXCEPT ALL SELECT time, payload::text, mixed::text FROM js_orig) e;
+SELECT count(*) FROM (SELECT time, payload::text, mixed::text FROM js_orig
+    EXCEPT ALL SELECT time, payload::text, mixed::text FROM js) e;
+SELECT count(*), count(payload), count(mixed) FROM js;
+SELECT time, payload FROM js ORDER BY time DESC LIMIT 3;
+SELECT time, mixed FROM js ORDER BY time LIMIT 3;
+SELECT count(*) FILTER (WHERE payload->>'status' = 'warn') AS warn,
+    count(payload->'extra') AS extra,
+    count(*) FILTER (WHERE payload->'note' = 'null') AS note_null
+FROM js;
+
+SELECT count(decompress_chunk(ch)) FROM show_chunks('js') ch;
+SELECT count(*) FROM (SELECT time, payload::text, mixed::text FROM js
+    EXCEPT ALL SELECT time, payload::text, mixed::text FROM js_orig) e;
+DROP TABLE js;
+DROP TABLE js_orig;
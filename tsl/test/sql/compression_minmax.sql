@@ -0,0 +1,63 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the min/max metadata of the timescaledb.compress_minmax columns
+CREATE TABLE mm(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('mm', 'time', chunk_time_interval => 10000);
+
+\set ON_ERROR_STOP 0
+ALTER TABLE mm SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_minmax = 'foo');
+ALTER TABLE mm SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_minmax = 'device');
+ALTER TABLE mm SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_minmax = 'value desc');
+\set ON_ERROR_STOP 1
+
+ALTER TABLE mm SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time',
+    timescaledb.compress_minmax = 'value');
+INSERT INTO mm SELECT t, t % 2, CASE WHEN t % 100 = 0 THEN NULL ELSE t / 10.0 END
+FROM generate_series(1, 4000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('mm') ch;
+
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'mm' \gset
+
+SELECT attname FROM pg_attribute
+WHERE attrelid = :'COMPRESSED_CHUNK'::regclass AND attnum > 0 AND NOT attisdropped
+ORDER BY attnum;
+SELECT device, _ts_meta_count, _ts_meta_v2_min_value, _ts_meta_v2_max_value,
+    _ts_meta_v2_nulls_value
+FROM :COMPRESSED_CHUNK ORDER BY device, _ts_meta_min_1;
+
+-- the filters on the column are pushed down to the compressed scan
+EXPLAIN (costs off) SELECT count(*) FROM mm WHERE value > 300;
+EXPLAIN (costs off) SELECT count(*) FROM mm WHERE value = 250.1;
+EXPLAIN (costs off) SELECT count(*) FROM mm WHERE value IS NULL;
+EXPLAIN (costs off) SELECT count(*) FROM mm WHERE value IS NOT NULL;
+SELECT count(*) FROM mm WHERE value > 300;
+SELECT count(*) FROM mm WHERE value < 0.15;
+SELECT count(*) FROM mm WHERE value = 250.1;
+SELECT count(*) FROM mm WHERE value IS NULL;
+SELECT count(*) FROM mm WHERE value IS NOT NULL;
+
+-- the metadata columns follow the renames of the column
+ALTER TABLE mm RENAME COLUMN value TO val;
+SELECT attname FROM pg_attribute
+WHERE attrelid = :'COMPRESSED_CHUNK'::regclass AND attnum > 0 AND NOT attisdropped
+ORDER BY attnum;
+SELECT count(*) FROM mm WHERE val > 300;
+
+-- new chunks are compressed with the metadata too
+INSERT INTO mm SELECT t, t % 2, t / 10.0 FROM generate_series(10001, 10100) t;
+SELECT compress_chunk('_timescaledb_internal._hyper_1_3_chunk');
+SELECT count(*) FROM mm WHERE val > 1005;
+DROP TABLE mm;
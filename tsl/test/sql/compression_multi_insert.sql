@@ -0,0 +1,40 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test writing the compressed batches of a chunk in bulk
+CREATE TABLE cmi(time timestamptz NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('cmi', 'time', chunk_time_interval => interval '1 day');
+ALTER TABLE cmi SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+
+-- more batches than are written with one call
+INSERT INTO cmi
+SELECT '2020-01-01 00:00'::timestamptz + n * interval '1 hour', d, d + n
+FROM generate_series(0, 2) n, generate_series(1, 2500) d;
+SELECT count(*), sum(value) FROM cmi;
+
+SELECT compress_chunk(ch) IS NOT NULL AS compressed FROM show_chunks('cmi') ch;
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'cmi' \gset
+
+SELECT count(*), sum(_ts_meta_count), count(DISTINCT device) FROM :COMPRESSED_CHUNK;
+SELECT count(*), sum(value) FROM cmi;
+
+-- the index of the compressed chunk is built after the batches are written
+SET enable_seqscan TO off;
+SET enable_bitmapscan TO off;
+SELECT test.plan_contains(
+    format('SELECT * FROM %s WHERE device = 1000', :'COMPRESSED_CHUNK'),
+    '%Index Scan%') AS index_scan;
+SELECT device, _ts_meta_count FROM :COMPRESSED_CHUNK
+WHERE device IN (1, 1000, 1001, 2000, 2500) ORDER BY device;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+SELECT decompress_chunk(ch) IS NOT NULL AS decompressed FROM show_chunks('cmi') ch;
+SELECT count(*), sum(value) FROM cmi;
+DROP TABLE cmi;
@@ -0,0 +1,91 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the compression of a chunk in parallel workers
+CREATE TABLE pc(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('pc', 'time', chunk_time_interval => 100000);
+ALTER TABLE pc SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO pc SELECT t, t % 10, t / 10.0 FROM generate_series(1, 25000) t;
+CREATE TABLE pc_expected AS SELECT * FROM pc;
+
+SET timescaledb.compress_parallel_workers TO 2;
+SELECT count(compress_chunk(ch)) FROM show_chunks('pc') ch;
+RESET timescaledb.compress_parallel_workers;
+
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'pc' \gset
+
+-- every segment is compressed once, with the batches in order
+SELECT numrows_pre_compression, numrows_post_compression
+FROM _timescaledb_catalog.compression_chunk_size;
+SELECT device, count(*), sum(_ts_meta_count), min(_ts_meta_sequence_num),
+    max(_ts_meta_sequence_num)
+FROM :COMPRESSED_CHUNK GROUP BY device ORDER BY device;
+SELECT count(*) FROM (
+    SELECT _ts_meta_min_1, lag(_ts_meta_max_1) OVER (
+        PARTITION BY device ORDER BY _ts_meta_sequence_num) AS prev_max
+    FROM :COMPRESSED_CHUNK
+) b WHERE _ts_meta_min_1 <= prev_max;
+
+-- the compressed data is the same as the uncompressed one
+SELECT count(*) FROM (SELECT * FROM pc EXCEPT ALL SELECT * FROM pc_expected) d;
+SELECT count(*) FROM (SELECT * FROM pc_expected EXCEPT ALL SELECT * FROM pc) d;
+
+-- the size of the compressed batches is configurable
+SELECT count(decompress_chunk(ch)) FROM show_chunks('pc') ch;
+SET timescaledb.compress_batch_size TO 5000;
+SELECT count(compress_chunk(ch)) FROM show_chunks('pc') ch;
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'pc' \gset
+SELECT count(*), min(_ts_meta_count), max(_ts_meta_count) FROM :COMPRESSED_CHUNK;
+SELECT count(decompress_chunk(ch)) FROM show_chunks('pc') ch;
+SET timescaledb.compress_batch_size TO 100;
+SELECT count(compress_chunk(ch)) FROM show_chunks('pc') ch;
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'pc' \gset
+SELECT count(*), min(_ts_meta_count), max(_ts_meta_count) FROM :COMPRESSED_CHUNK;
+RESET timescaledb.compress_batch_size;
+SELECT count(*) FROM (SELECT * FROM pc EXCEPT ALL SELECT * FROM pc_expected) d;
+SELECT count(*) FROM (SELECT * FROM pc_expected EXCEPT ALL SELECT * FROM pc) d;
+
+-- the chunk is decompressed in parallel workers too, and its indexes rebuilt
+SET timescaledb.decompress_parallel_workers TO 2;
+SELECT count(decompress_chunk(ch)) FROM show_chunks('pc') ch;
+RESET timescaledb.decompress_parallel_workers;
+SELECT count(*) FROM (SELECT * FROM pc EXCEPT ALL SELECT * FROM pc_expected) d;
+SELECT count(*) FROM (SELECT * FROM pc_expected EXCEPT ALL SELECT * FROM pc) d;
+SET enable_seqscan TO off;
+SELECT count(*) FROM pc WHERE time BETWEEN 100 AND 199;
+RESET enable_seqscan;
+
+-- the rows that need to be toasted are inserted after the workers are done
+CREATE TABLE pt(time int NOT NULL, device int, note text);
+SELECT table_name FROM create_hypertable('pt', 'time', chunk_time_interval => 100000);
+ALTER TABLE pt SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO pt SELECT t, t % 2,
+    CASE WHEN t % 100 = 0 THEN repeat(md5(t::text), 300) ELSE md5(t::text) END
+FROM generate_series(1, 1000) t;
+CREATE TABLE pt_expected AS SELECT * FROM pt;
+SELECT count(compress_chunk(ch)) FROM show_chunks('pt') ch;
+SET timescaledb.decompress_parallel_workers TO 2;
+SELECT count(decompress_chunk(ch)) FROM show_chunks('pt') ch;
+RESET timescaledb.decompress_parallel_workers;
+SELECT count(*) FROM (SELECT * FROM pt EXCEPT ALL SELECT * FROM pt_expected) d;
+SELECT count(*) FROM (SELECT * FROM pt_expected EXCEPT ALL SELECT * FROM pt) d;
+SELECT count(*), max(length(note)) FROM pt;
+
+DROP TABLE pc;
+DROP TABLE pc_expected;
+DROP TABLE pt;
+DROP TABLE pt_expected;
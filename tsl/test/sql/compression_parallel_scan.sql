@@ -0,0 +1,34 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test handing out the compressed batches of a chunk to the parallel workers
+CREATE TABLE ps(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('ps', 'time', chunk_time_interval => 100000);
+ALTER TABLE ps SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO ps SELECT t, t % 10, t / 10.0 FROM generate_series(1, 25000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('ps') ch;
+ANALYZE ps;
+
+SET parallel_setup_cost TO 0;
+SET parallel_tuple_cost TO 0;
+SET min_parallel_table_scan_size TO 0;
+SET max_parallel_workers_per_gather TO 2;
+SET timescaledb.enable_parallel_batch_decompression TO on;
+
+EXPLAIN (costs off) SELECT count(*), sum(time) FROM ps;
+SELECT count(*), sum(time), count(DISTINCT value) FROM ps;
+SELECT device, count(*), min(time), max(time) FROM ps GROUP BY device ORDER BY device;
+
+-- the same results as without parallel workers
+RESET timescaledb.enable_parallel_batch_decompression;
+SET max_parallel_workers_per_gather TO 0;
+SELECT count(*), sum(time), count(DISTINCT value) FROM ps;
+
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE ps;
@@ -0,0 +1,54 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test building the chunk statistics from the rows sampled while compressing
+-- instead of running ANALYZE on the chunk
+CREATE TABLE ss(time int NOT NULL, device int, value float8, label text);
+SELECT table_name FROM create_hypertable('ss', 'time', chunk_time_interval => 10000);
+ALTER TABLE ss SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO ss SELECT t, t % 5, (t % 97) / 4.0,
+    CASE WHEN t % 9 = 0 THEN NULL ELSE 'label ' || (t % 13) END
+FROM generate_series(1, 3000) t;
+
+-- the same data, analyzed before compressing
+CREATE TABLE sa(time int NOT NULL, device int, value float8, label text);
+SELECT table_name FROM create_hypertable('sa', 'time', chunk_time_interval => 10000);
+ALTER TABLE sa SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO sa SELECT * FROM ss;
+
+SET timescaledb.enable_compression_sample_stats TO on;
+SELECT count(compress_chunk(ch)) FROM show_chunks('ss') ch;
+RESET timescaledb.enable_compression_sample_stats;
+SELECT count(compress_chunk(ch)) FROM show_chunks('sa') ch;
+
+SELECT ch AS "SS_CHUNK" FROM show_chunks('ss') ch \gset
+SELECT ch AS "SA_CHUNK" FROM show_chunks('sa') ch \gset
+
+-- all the rows fit into the sample, so the statistics are the same as the
+-- ones of ANALYZE, except for the correlation, which depends on the order
+SELECT attname, null_frac, n_distinct, avg_width
+FROM pg_stats WHERE schemaname || '.' || tablename = :'SS_CHUNK'
+ORDER BY attname;
+SELECT count(*) FROM (
+    SELECT attname, null_frac, n_distinct, avg_width, most_common_vals::text,
+        most_common_freqs, histogram_bounds::text
+    FROM pg_stats WHERE schemaname || '.' || tablename = :'SS_CHUNK'
+    EXCEPT
+    SELECT attname, null_frac, n_distinct, avg_width, most_common_vals::text,
+        most_common_freqs, histogram_bounds::text
+    FROM pg_stats WHERE schemaname || '.' || tablename = :'SA_CHUNK') e;
+SELECT (SELECT reltuples FROM pg_class WHERE oid = :'SS_CHUNK'::regclass) AS reltuples,
+    (SELECT relpages FROM pg_class WHERE oid = :'SS_CHUNK'::regclass) =
+    (SELECT relpages FROM pg_class WHERE oid = :'SA_CHUNK'::regclass) AS same_relpages;
+
+-- the data is unchanged
+SELECT count(*) FROM ss WHERE device = 1;
+SELECT count(*) FROM (SELECT * FROM ss EXCEPT ALL SELECT * FROM sa) e;
+
+DROP TABLE ss;
+DROP TABLE sa;
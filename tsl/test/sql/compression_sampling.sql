@@ -0,0 +1,54 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test choosing the compression algorithms from a sample of the chunk
+CREATE TABLE sp(time int NOT NULL, device int, code int4, reading float8, temp float8);
+SELECT table_name FROM create_hypertable('sp', 'time', chunk_time_interval => 10000);
+ALTER TABLE sp SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+-- code and reading have a few distinct values in random order, temp is smooth
+INSERT INTO sp SELECT t, t % 2, (ARRAY[1000, 5000, 90000])[h % 3 + 1], (h / 3) % 4 * 10.0, t * 0.25
+FROM (SELECT t, (t::int8 * 2654435761) % 4294967291 AS h FROM generate_series(1, 4000) t) s;
+CREATE TABLE sp_orig AS SELECT * FROM sp;
+
+SELECT format('%I.%I', schema_name, table_name) AS "COMPRESSED_HT"
+FROM _timescaledb_catalog.hypertable
+WHERE id = (SELECT compressed_hypertable_id FROM _timescaledb_catalog.hypertable
+    WHERE table_name = 'sp') \gset
+
+-- the type-based defaults
+SELECT attname, compression_algorithm_id FROM _timescaledb_catalog.hypertable_compression hc
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = hc.hypertable_id
+WHERE ht.table_name = 'sp' ORDER BY attname;
+
+SET timescaledb.enable_compression_sampling TO on;
+SELECT count(compress_chunk(ch)) FROM show_chunks('sp') ch;
+RESET timescaledb.enable_compression_sampling;
+
+-- the sampled choices are recorded and used to compress the chunk
+SELECT attname, compression_algorithm_id FROM _timescaledb_catalog.hypertable_compression hc
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = hc.hypertable_id
+WHERE ht.table_name = 'sp' ORDER BY attname;
+SELECT device, _ts_meta_min_1, get_byte(decode(code::text, 'base64'), 0) AS code,
+    get_byte(decode(reading::text, 'base64'), 0) AS reading,
+    get_byte(decode(temp::text, 'base64'), 0) AS temp
+FROM :COMPRESSED_HT ORDER BY device, _ts_meta_min_1;
+
+SELECT count(*) FROM (SELECT * FROM sp EXCEPT ALL SELECT * FROM sp_orig) e;
+SELECT count(*) FROM (SELECT * FROM sp_orig EXCEPT ALL SELECT * FROM sp) e;
+SELECT count(*), sum(code), sum(reading), sum(temp) FROM sp WHERE code = 5000;
+SELECT count(*), sum(code), sum(reading), sum(temp) FROM sp_orig WHERE code = 5000;
+
+-- the later chunks use the recorded algorithms without sampling
+INSERT INTO sp SELECT t, t % 2, (ARRAY[1000, 5000, 90000])[t % 3 + 1], t % 4 * 10.0, t * 0.25
+FROM generate_series(10001, 10100) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('sp', newer_than => 10000) ch;
+SELECT device, _ts_meta_min_1, get_byte(decode(code::text, 'base64'), 0) AS code,
+    get_byte(decode(reading::text, 'base64'), 0) AS reading,
+    get_byte(decode(temp::text, 'base64'), 0) AS temp
+FROM :COMPRESSED_HT ORDER BY device, _ts_meta_min_1;
+SELECT count(*), sum(code), sum(reading), sum(temp) FROM sp WHERE time > 10000;
+DROP TABLE sp;
+DROP TABLE sp_orig;
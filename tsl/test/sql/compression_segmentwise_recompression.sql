@@ -0,0 +1,56 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the recompression of only the segments that got new rows
+CREATE TABLE sw(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('sw', 'time', chunk_time_interval => 10000);
+ALTER TABLE sw SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO sw SELECT t, t % 4, t % 10 FROM generate_series(1, 400) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('sw') ch;
+
+SELECT show_chunks('sw') AS "CHUNK" \gset
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'sw' \gset
+
+-- nothing to recompress without new rows
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.recompress_chunk_segmentwise(:'CHUNK');
+\set ON_ERROR_STOP 1
+SELECT _timescaledb_internal.recompress_chunk_segmentwise(:'CHUNK', true);
+
+-- new rows for an existing and for a new segment
+INSERT INTO sw VALUES (401, 1, 1.5), (402, 5, 2.5);
+SELECT _timescaledb_internal.chunk_status(:'CHUNK');
+SELECT count(*), sum(value) FROM sw;
+CREATE TEMP TABLE batches_before AS SELECT ctid AS tid FROM :COMPRESSED_CHUNK;
+
+SELECT _timescaledb_internal.recompress_chunk_segmentwise(:'CHUNK');
+SELECT _timescaledb_internal.chunk_status(:'CHUNK');
+SELECT count(*) FROM ONLY :CHUNK;
+SELECT count(*), sum(value) FROM sw;
+
+-- only the batches of the segments with new rows are rewritten
+SELECT c.device, c._ts_meta_count, c._ts_meta_sequence_num, b.tid IS NOT NULL AS untouched
+FROM :COMPRESSED_CHUNK c LEFT JOIN batches_before b ON b.tid = c.ctid
+ORDER BY c.device, c._ts_meta_sequence_num;
+SELECT numrows_pre_compression, numrows_post_compression
+FROM _timescaledb_catalog.compression_chunk_size;
+
+-- recompress_chunk uses the segmentwise recompression when enabled
+SET timescaledb.enable_segmentwise_recompression TO on;
+DROP TABLE batches_before;
+CREATE TEMP TABLE batches_before AS SELECT ctid AS tid FROM :COMPRESSED_CHUNK;
+INSERT INTO sw VALUES (403, 2, 3.5);
+CALL recompress_chunk(:'CHUNK');
+RESET timescaledb.enable_segmentwise_recompression;
+SELECT _timescaledb_internal.chunk_status(:'CHUNK');
+SELECT c.device, c._ts_meta_count, c._ts_meta_sequence_num, b.tid IS NOT NULL AS untouched
+FROM :COMPRESSED_CHUNK c LEFT JOIN batches_before b ON b.tid = c.ctid
+ORDER BY c.device, c._ts_meta_sequence_num;
+SELECT count(*), sum(value) FROM sw;
+DROP TABLE sw;
@@ -0,0 +1,55 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the radix sort of the rows of a chunk for compression
+CREATE TABLE cs(time int NOT NULL, device int, value int2);
+SELECT table_name FROM create_hypertable('cs', 'time', chunk_time_interval => 100000);
+ALTER TABLE cs SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'value, time DESC');
+INSERT INTO cs SELECT t, t % 9 - 4, (t * 37) % 1000 - 500 FROM generate_series(1, 10000) t;
+SELECT ch AS "CHUNK" FROM show_chunks('cs') ch \gset
+
+SELECT count(compress_chunk(ch)) FROM show_chunks('cs') ch;
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'cs' \gset
+SELECT device, count(*), sum(_ts_meta_count) FROM :COMPRESSED_CHUNK
+GROUP BY device ORDER BY device;
+SELECT count(*) FROM (
+    SELECT _ts_meta_min_1, lag(_ts_meta_max_1) OVER (
+        PARTITION BY device ORDER BY _ts_meta_sequence_num) AS prev_max
+    FROM :COMPRESSED_CHUNK
+) b WHERE _ts_meta_min_1 < prev_max;
+
+-- the decompressed rows are written in the order of compression
+SELECT count(decompress_chunk(ch)) FROM show_chunks('cs') ch;
+SELECT count(*) FROM (
+    SELECT row_number() OVER (ORDER BY ctid) AS heap_pos,
+        row_number() OVER (ORDER BY device, value, time DESC) AS sort_pos
+    FROM :CHUNK
+) r WHERE heap_pos <> sort_pos;
+
+-- NULL keys are sorted by a tuplesort
+INSERT INTO cs SELECT t, NULL, (t * 37) % 1000 - 500 FROM generate_series(10001, 10100) t;
+CREATE TABLE cs_expected AS SELECT * FROM cs;
+SELECT count(compress_chunk(ch)) FROM show_chunks('cs') ch;
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'cs' \gset
+SELECT device, count(*), sum(_ts_meta_count) FROM :COMPRESSED_CHUNK
+GROUP BY device ORDER BY device;
+SELECT count(decompress_chunk(ch)) FROM show_chunks('cs') ch;
+SELECT count(*) FROM (
+    SELECT row_number() OVER (ORDER BY ctid) AS heap_pos,
+        row_number() OVER (ORDER BY device, value, time DESC) AS sort_pos
+    FROM :CHUNK
+) r WHERE heap_pos <> sort_pos;
+SELECT count(*) FROM (SELECT * FROM cs EXCEPT ALL SELECT * FROM cs_expected) d;
+SELECT count(*) FROM (SELECT * FROM cs_expected EXCEPT ALL SELECT * FROM cs) d;
+
+DROP TABLE cs;
+DROP TABLE cs_expected;
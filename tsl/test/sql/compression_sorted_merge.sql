@@ -0,0 +1,34 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the batch sorted merge of the compressed batches of different segments
+CREATE TABLE sm(time int NOT NULL, device int, value float8);
+SELECT table_name FROM create_hypertable('sm', 'time', chunk_time_interval => 10000);
+ALTER TABLE sm SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time DESC');
+INSERT INTO sm SELECT t, t % 3, t / 10.0 FROM generate_series(1, 6000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('sm') ch;
+
+SET timescaledb.enable_decompression_sorted_merge TO on;
+
+-- the batches are merged instead of sorting the decompressed rows
+EXPLAIN (costs off) SELECT * FROM sm ORDER BY time DESC LIMIT 5;
+EXPLAIN (costs off) SELECT * FROM sm ORDER BY time LIMIT 5;
+SELECT time, device FROM sm ORDER BY time DESC LIMIT 5;
+SELECT time, device FROM sm ORDER BY time LIMIT 5;
+SELECT time, device FROM sm WHERE value < 100 ORDER BY time DESC LIMIT 3;
+
+-- the whole output is in order
+SELECT count(*) FROM (
+    SELECT time, row_number() OVER () AS rn
+    FROM (SELECT time FROM sm ORDER BY time DESC) s
+) o WHERE time <> 6001 - rn;
+SELECT count(*) FROM (
+    SELECT time, row_number() OVER () AS rn
+    FROM (SELECT time FROM sm ORDER BY time) s
+) o WHERE time <> rn;
+
+RESET timescaledb.enable_decompression_sorted_merge;
+DROP TABLE sm;
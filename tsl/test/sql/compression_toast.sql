@@ -0,0 +1,36 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the TOAST compression method of the compressed columns
+CREATE TABLE tc(time int NOT NULL, device int, msg text, value float8);
+SELECT table_name FROM create_hypertable('tc', 'time', chunk_time_interval => 100000);
+SET timescaledb.compress_toast_compression TO pglz;
+ALTER TABLE tc SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+RESET timescaledb.compress_toast_compression;
+INSERT INTO tc SELECT t, t % 3, repeat('message ' || t % 7, 20), t FROM generate_series(1, 3000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('tc') ch;
+
+-- only the extended storage columns of the compressed chunk get the method
+SELECT a.attname, a.attstorage, a.attcompression
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+JOIN pg_attribute a ON a.attrelid = format('%I.%I', ch.schema_name, ch.table_name)::regclass
+WHERE ht.table_name = 'tc' AND a.attname IN ('time', 'device', 'msg', 'value')
+ORDER BY 1;
+SELECT count(*), count(DISTINCT msg), sum(value) FROM tc;
+
+-- the default leaves the method to default_toast_compression
+CREATE TABLE td(time int NOT NULL, msg text);
+SELECT table_name FROM create_hypertable('td', 'time', chunk_time_interval => 100000);
+ALTER TABLE td SET (timescaledb.compress);
+SELECT a.attname, a.attstorage, a.attcompression
+FROM _timescaledb_catalog.hypertable ht
+JOIN _timescaledb_catalog.hypertable cht ON cht.id = ht.compressed_hypertable_id
+JOIN pg_attribute a ON a.attrelid = format('%I.%I', cht.schema_name, cht.table_name)::regclass
+WHERE ht.table_name = 'td' AND a.attname = 'msg';
+
+DROP TABLE tc;
+DROP TABLE td;
@@ -0,0 +1,83 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the compression algorithm for UUIDs with repeated, time-ordered and
+-- random values
+CREATE TABLE uu(time int NOT NULL, device int, trace uuid, v7 uuid, v1 uuid, rnd uuid);
+SELECT table_name FROM create_hypertable('uu', 'time', chunk_time_interval => 10000);
+SET timescaledb.enable_uuid_compression TO on;
+ALTER TABLE uu SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+RESET timescaledb.enable_uuid_compression;
+INSERT INTO uu SELECT t, t % 2,
+    CASE WHEN t % 7 = 0 THEN NULL ELSE md5((t % 5)::text)::uuid END,
+    (lpad(to_hex(1700000000000 + t * 10), 12, '0') || '7abc8' || lpad(to_hex(h), 15, '0'))::uuid,
+    (lpad(to_hex(ts & 4294967295), 8, '0') || lpad(to_hex((ts >> 32) & 65535), 4, '0') ||
+        '1' || lpad(to_hex(ts >> 48), 3, '0') || '9' || lpad(to_hex(h), 15, '0'))::uuid,
+    CASE WHEN t % 10 = 0 THEN NULL ELSE md5(t::text)::uuid END
+FROM (SELECT t, (t::int8 * 2654435761) % 4294967291 AS h,
+        138000000000000000 + t::int8 * 10000 AS ts
+    FROM generate_series(1, 2000) t) s;
+CREATE TABLE uu_orig AS SELECT * FROM uu;
+
+-- the same data compressed with the default algorithms
+CREATE TABLE ud(time int NOT NULL, device int, trace uuid, v7 uuid, v1 uuid, rnd uuid);
+SELECT table_name FROM create_hypertable('ud', 'time', chunk_time_interval => 10000);
+ALTER TABLE ud SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO ud SELECT * FROM uu_orig;
+
+SELECT ht.table_name, attname, al.name
+FROM _timescaledb_catalog.hypertable_compression hc
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = hc.hypertable_id
+JOIN _timescaledb_catalog.compression_algorithm al ON al.id = hc.compression_algorithm_id
+WHERE ht.table_name IN ('uu', 'ud') AND attname = 'v7'
+ORDER BY ht.table_name;
+
+SELECT count(compress_chunk(ch)) FROM show_chunks('uu') ch;
+SELECT count(compress_chunk(ch)) FROM show_chunks('ud') ch;
+
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "UU_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'uu' \gset
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "UD_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'ud' \gset
+
+-- the algorithm and the encoding of every batch: dictionary for the repeated
+-- values, the time prefix for versions 7 and 1, and plain for the random ones
+SELECT device, get_byte(decode(trace::text, 'base64'), 0) AS algorithm,
+    get_byte(decode(trace::text, 'base64'), 1) AS trace,
+    get_byte(decode(v7::text, 'base64'), 1) AS v7,
+    get_byte(decode(v1::text, 'base64'), 1) AS v1,
+    get_byte(decode(rnd::text, 'base64'), 1) AS rnd
+FROM :UU_CHUNK ORDER BY device;
+SELECT (SELECT sum(pg_column_size(v7) + pg_column_size(v1)) FROM :UU_CHUNK) <
+    (SELECT sum(pg_column_size(v7) + pg_column_size(v1)) FROM :UD_CHUNK) AS smaller;
+
+-- the text representation round-trips
+SELECT count(*) FROM :UU_CHUNK
+WHERE trace::text::_timescaledb_internal.compressed_data::text <> trace::text
+    OR v7::text::_timescaledb_internal.compressed_data::text <> v7::text
+    OR v1::text::_timescaledb_internal.compressed_data::text <> v1::text
+    OR rnd::text::_timescaledb_internal.compressed_data::text <> rnd::text;
+
+-- the decompressed data is the same as the original, in both directions
+SELECT count(*) FROM (SELECT * FROM uu EXCEPT ALL SELECT * FROM uu_orig) e;
+SELECT count(*) FROM (SELECT * FROM uu_orig EXCEPT ALL SELECT * FROM uu) e;
+SELECT count(*), count(trace), count(DISTINCT trace), count(rnd) FROM uu;
+SELECT time, trace, v7, v1 FROM uu ORDER BY time DESC LIMIT 4;
+SELECT count(*) FROM uu u JOIN uu_orig o USING (time)
+WHERE u.v7 IS DISTINCT FROM o.v7 OR u.v1 IS DISTINCT FROM o.v1;
+SELECT count(*) FROM uu WHERE trace = md5('3')::uuid;
+
+SELECT count(decompress_chunk(ch)) FROM show_chunks('uu') ch;
+SELECT count(*) FROM (SELECT * FROM uu EXCEPT ALL SELECT * FROM uu_orig) e;
+DROP TABLE uu;
+DROP TABLE ud;
+DROP TABLE uu_orig;
@@ -0,0 +1,125 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test evaluation of quals over bulk decompressed batches
+CREATE TABLE vq(time int NOT NULL, device int, value float8, ival int8);
+SELECT table_name FROM create_hypertable('vq', 'time', chunk_time_interval => 10000);
+ALTER TABLE vq SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO vq SELECT t, t % 3, t / 2.0, CASE WHEN t % 10 = 0 THEN NULL ELSE t END
+FROM generate_series(1, 3000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('vq') ch;
+
+SET timescaledb.enable_bulk_decompression TO on;
+SELECT count(*) FROM vq WHERE ival > 2500;
+SELECT count(*) FROM vq WHERE 1000 < ival;
+SELECT count(*) FROM vq WHERE value <= 100;
+SELECT count(*) FROM vq WHERE value = 1.5;
+SELECT count(*) FROM vq WHERE ival <> 5;
+SELECT count(*) FROM vq WHERE ival IS NULL;
+SELECT count(*) FROM vq WHERE ival IS NOT NULL AND time <= 100;
+SELECT count(*) FROM vq WHERE ival > 2500 AND device = 1;
+SELECT count(*) FROM vq WHERE ival > 5000;
+-- value is only decompressed for the batches that pass the vector quals
+SELECT sum(value) FROM vq WHERE ival > 2500;
+SELECT sum(value) FROM vq WHERE ival > 5000;
+-- the batch metadata shows that all rows pass, time is not decompressed
+SELECT count(*) FROM vq WHERE time > 0;
+SELECT count(*) FROM vq WHERE time >= 1500;
+SELECT count(*) FROM vq WHERE time > 0 AND ival > 2500;
+SELECT count(*), sum(value) FROM vq WHERE time < 5000 AND time <> 4000;
+
+SET timescaledb.enable_bulk_decompression TO off;
+SELECT count(*) FROM vq WHERE ival > 2500;
+SELECT count(*) FROM vq WHERE 1000 < ival;
+SELECT count(*) FROM vq WHERE value <= 100;
+SELECT count(*) FROM vq WHERE value = 1.5;
+SELECT count(*) FROM vq WHERE ival <> 5;
+SELECT count(*) FROM vq WHERE ival IS NULL;
+SELECT count(*) FROM vq WHERE ival IS NOT NULL AND time <= 100;
+SELECT count(*) FROM vq WHERE ival > 2500 AND device = 1;
+SELECT count(*) FROM vq WHERE ival > 5000;
+
+-- reverse scan over the batch
+SET timescaledb.enable_bulk_decompression TO on;
+SELECT time, ival FROM vq WHERE ival > 2990 ORDER BY time DESC LIMIT 3;
+RESET timescaledb.enable_bulk_decompression;
+
+-- prefetch the TOAST chunks of the next batches
+SET timescaledb.decompress_prefetch_batches TO 2;
+SELECT count(*) FROM vq WHERE ival > 2500;
+SELECT count(*), min(time), max(time) FROM vq;
+SELECT time, ival FROM vq WHERE ival > 2990 ORDER BY time DESC LIMIT 3;
+RESET timescaledb.decompress_prefetch_batches;
+
+-- the second scan gets the decompressed columns from the cache
+SET timescaledb.decompress_cache_size TO '1MB';
+SELECT count(*) FROM vq WHERE ival > 2500;
+SELECT count(*) FROM vq WHERE ival > 2500;
+SELECT time, ival FROM vq WHERE ival > 2990 ORDER BY time DESC LIMIT 3;
+SELECT time, ival FROM vq WHERE ival > 2990 ORDER BY time DESC LIMIT 3;
+RESET timescaledb.decompress_cache_size;
+
+-- decompression statistics in EXPLAIN ANALYZE
+CREATE FUNCTION decompression_stats(query text) RETURNS SETOF text
+LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (analyze, costs off, timing off, summary off) ' || query LOOP
+        line := trim(line);
+        IF line LIKE 'Batches%' OR line LIKE 'Predicates%' OR line LIKE 'Cached%' OR
+            line LIKE 'Decompressed Columns%' THEN
+            RETURN NEXT line;
+        END IF;
+    END LOOP;
+END
+$$;
+SET timescaledb.enable_bulk_decompression TO on;
+SET timescaledb.enable_decompression_stats TO on;
+SELECT decompression_stats('SELECT count(*) FROM vq WHERE ival > 2500');
+SELECT decompression_stats('SELECT count(*) FROM vq WHERE ival > 5000');
+SELECT decompression_stats('SELECT count(*) FROM vq WHERE time > 0');
+RESET timescaledb.enable_decompression_stats;
+SELECT decompression_stats('SELECT count(*) FROM vq WHERE ival > 2500');
+RESET timescaledb.enable_bulk_decompression;
+DROP FUNCTION decompression_stats(text);
+DROP TABLE vq;
+
+-- Test equality and IN quals evaluated over the dictionary of text columns
+CREATE TABLE vt(time int NOT NULL, device int, status text);
+SELECT table_name FROM create_hypertable('vt', 'time', chunk_time_interval => 10000);
+ALTER TABLE vt SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+-- 'fatal' is only in the batch of device 0, the other batches are skipped
+INSERT INTO vt SELECT t, t % 3,
+    CASE WHEN t % 7 = 0 THEN NULL WHEN t % 33 = 0 THEN 'fatal'
+        WHEN t % 5 = 0 THEN 'error' WHEN t < 1500 THEN 'ok' ELSE 'warning' END
+FROM generate_series(1, 3000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('vt') ch;
+
+SET timescaledb.enable_bulk_decompression TO on;
+SELECT count(*) FROM vt WHERE status = 'error';
+SELECT count(*) FROM vt WHERE 'ok' = status;
+SELECT count(*) FROM vt WHERE status IN ('error', 'fatal');
+SELECT count(*) FROM vt WHERE status = 'fatal';
+SELECT count(*) FROM vt WHERE status = 'missing';
+SELECT count(*) FROM vt WHERE status = ANY(ARRAY['ok', NULL]);
+SELECT count(*) FROM vt WHERE status = 'error' AND time > 2000;
+
+SET timescaledb.enable_bulk_decompression TO off;
+SELECT count(*) FROM vt WHERE status = 'error';
+SELECT count(*) FROM vt WHERE 'ok' = status;
+SELECT count(*) FROM vt WHERE status IN ('error', 'fatal');
+SELECT count(*) FROM vt WHERE status = 'fatal';
+SELECT count(*) FROM vt WHERE status = 'missing';
+SELECT count(*) FROM vt WHERE status = ANY(ARRAY['ok', NULL]);
+SELECT count(*) FROM vt WHERE status = 'error' AND time > 2000;
+
+SET timescaledb.enable_bulk_decompression TO on;
+SELECT time, status FROM vt WHERE status = 'fatal' ORDER BY time DESC LIMIT 3;
+RESET timescaledb.enable_bulk_decompression;
+DROP TABLE vt;
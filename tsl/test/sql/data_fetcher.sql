@@ -11,9 +11,15 @@
 \set TEST_BASE_NAME data_fetcher
 SELECT format('include/%s_run.sql', :'TEST_BASE_NAME') as "TEST_QUERY_NAME",
        format('%s/results/%s_results_cursor.out', :'TEST_OUTPUT_DIR', :'TEST_BASE_NAME') as "TEST_RESULTS_CURSOR",
-       format('%s/results/%s_results_copy.out', :'TEST_OUTPUT_DIR', :'TEST_BASE_NAME') as "TEST_RESULTS_COPY"
+       format('%s/results/%s_results_copy.out', :'TEST_OUTPUT_DIR', :'TEST_BASE_NAME') as "TEST_RESULTS_COPY",
+       format('%s/results/%s_results_columnar.out', :'TEST_OUTPUT_DIR', :'TEST_BASE_NAME') as "TEST_RESULTS_COLUMNAR",
+       format('%s/results/%s_results_adaptive.out', :'TEST_OUTPUT_DIR', :'TEST_BASE_NAME') as "TEST_RESULTS_ADAPTIVE",
+       format('%s/results/%s_results_prefetch.out', :'TEST_OUTPUT_DIR', :'TEST_BASE_NAME') as "TEST_RESULTS_PREFETCH"
 \gset
-SELECT format('\! diff %s %s', :'TEST_RESULTS_CURSOR', :'TEST_RESULTS_COPY') as "DIFF_CMD"
+SELECT format('\! diff %s %s', :'TEST_RESULTS_CURSOR', :'TEST_RESULTS_COPY') as "DIFF_CMD",
+       format('\! diff %s %s', :'TEST_RESULTS_CURSOR', :'TEST_RESULTS_COLUMNAR') as "DIFF_CMD_COLUMNAR",
+       format('\! diff %s %s', :'TEST_RESULTS_CURSOR', :'TEST_RESULTS_ADAPTIVE') as "DIFF_CMD_ADAPTIVE",
+       format('\! diff %s %s', :'TEST_RESULTS_CURSOR', :'TEST_RESULTS_PREFETCH') as "DIFF_CMD_PREFETCH"
 \gset
 
 SET ROLE :ROLE_CLUSTER_SUPERUSER;
@@ -45,13 +51,37 @@ SET timescaledb.remote_data_fetcher = 'copy';
 \o
 \set ON_ERROR_STOP 1
 
+-- run the queries using columnar fetcher
+SET timescaledb.remote_data_fetcher = 'columnar';
+\o :TEST_RESULTS_COLUMNAR
+\ir :TEST_QUERY_NAME
+\o
+
 -- run queries using cursor fetcher
 SET timescaledb.remote_data_fetcher = 'cursor';
 \o :TEST_RESULTS_CURSOR
 \ir :TEST_QUERY_NAME
 \o
+
+-- run queries using cursor fetcher with a fetch size adapting to a
+-- small memory budget
+SET timescaledb.remote_fetch_memory = '8kB';
+\o :TEST_RESULTS_ADAPTIVE
+\ir :TEST_QUERY_NAME
+\o
+RESET timescaledb.remote_fetch_memory;
+
+-- run queries using cursor fetcher with prefetching
+SET timescaledb.enable_cursor_prefetch = on;
+\o :TEST_RESULTS_PREFETCH
+\ir :TEST_QUERY_NAME
+\o
+RESET timescaledb.enable_cursor_prefetch;
 -- compare results
 :DIFF_CMD
+:DIFF_CMD_COLUMNAR
+:DIFF_CMD_ADAPTIVE
+:DIFF_CMD_PREFETCH
 
 RESET ROLE;
 DROP DATABASE :DATA_NODE_1;
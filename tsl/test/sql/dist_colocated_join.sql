@@ -0,0 +1,65 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test pushing down joins of co-located distributed hypertables
+
+\c :TEST_DBNAME :ROLE_CLUSTER_SUPERUSER;
+
+\set DATA_NODE_1 :TEST_DBNAME _1
+\set DATA_NODE_2 :TEST_DBNAME _2
+
+SELECT node_name, database, node_created, database_created, extension_created
+FROM (
+  SELECT (add_data_node(name, host => 'localhost', DATABASE => name)).*
+  FROM (VALUES (:'DATA_NODE_1'), (:'DATA_NODE_2')) v(name)
+) a;
+GRANT USAGE ON FOREIGN SERVER :DATA_NODE_1, :DATA_NODE_2 TO PUBLIC;
+GRANT CREATE ON SCHEMA public TO :ROLE_1;
+SET ROLE :ROLE_1;
+
+-- both hypertables place the same space partitions on the same data nodes
+CREATE TABLE metrics(time timestamptz NOT NULL, device int, value float);
+SELECT table_name FROM create_distributed_hypertable('metrics', 'time', 'device',
+    number_partitions => 2, data_nodes => ARRAY[:'DATA_NODE_1', :'DATA_NODE_2']);
+CREATE TABLE devices(time timestamptz NOT NULL, device int, temp float);
+SELECT table_name FROM create_distributed_hypertable('devices', 'time', 'device',
+    number_partitions => 2, data_nodes => ARRAY[:'DATA_NODE_1', :'DATA_NODE_2']);
+
+INSERT INTO metrics
+SELECT t, d, d * 10 + extract(hour FROM t)
+FROM generate_series('2020-01-01 00:00'::timestamptz, '2020-01-01 01:00', '1 hour') t,
+     generate_series(1, 6) d;
+INSERT INTO devices SELECT '2020-01-01 00:00', d, d * 1.5 FROM generate_series(1, 6) d;
+ANALYZE metrics, devices;
+
+-- every data node holds the chunks of both hypertables
+SELECT hypertable_name, count(DISTINCT data_nodes)
+FROM timescaledb_information.chunks GROUP BY 1 ORDER BY 1;
+
+\set QUERY 'SELECT metrics.time, metrics.device, metrics.value, devices.temp FROM metrics JOIN devices ON metrics.time = devices.time AND metrics.device = devices.device'
+
+-- the join is pushed down to the data nodes
+SET enable_partitionwise_join TO on;
+SET timescaledb.enable_colocated_join TO on;
+SELECT test.plan_contains(:'QUERY', '%Relations: %INNER JOIN%') AS pushed_down;
+:QUERY ORDER BY metrics.device;
+
+-- and gives the same rows as the join on the access node
+RESET timescaledb.enable_colocated_join;
+SELECT test.plan_contains(:'QUERY', '%Relations: %INNER JOIN%') AS pushed_down;
+:QUERY ORDER BY metrics.device;
+
+-- outer joins are joined on the access node
+SET timescaledb.enable_colocated_join TO on;
+SELECT test.plan_contains(
+    'SELECT * FROM metrics LEFT JOIN devices ON metrics.device = devices.device',
+    '%Relations: %JOIN%') AS pushed_down;
+RESET timescaledb.enable_colocated_join;
+RESET enable_partitionwise_join;
+
+DROP TABLE metrics;
+DROP TABLE devices;
+RESET ROLE;
+DROP DATABASE :DATA_NODE_1;
+DROP DATABASE :DATA_NODE_2;
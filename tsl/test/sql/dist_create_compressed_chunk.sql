@@ -0,0 +1,73 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test loading compressed batches into a chunk of a distributed hypertable
+
+\c :TEST_DBNAME :ROLE_CLUSTER_SUPERUSER;
+
+\set DATA_NODE_1 :TEST_DBNAME _1
+\set DATA_NODE_2 :TEST_DBNAME _2
+
+SELECT node_name, database, node_created, database_created, extension_created
+FROM (
+  SELECT (add_data_node(name, host => 'localhost', DATABASE => name)).*
+  FROM (VALUES (:'DATA_NODE_1'), (:'DATA_NODE_2')) v(name)
+) a;
+GRANT USAGE ON FOREIGN SERVER :DATA_NODE_1, :DATA_NODE_2 TO PUBLIC;
+GRANT CREATE ON SCHEMA public TO :ROLE_1;
+SET ROLE :ROLE_1;
+
+-- the chunk is replicated, so the batches are loaded on both data nodes
+CREATE TABLE dist(time timestamptz NOT NULL, device int, value float);
+SELECT table_name FROM create_distributed_hypertable('dist', 'time',
+    chunk_time_interval => interval '1 day', replication_factor => 2);
+ALTER TABLE dist SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+
+-- create an empty chunk
+INSERT INTO dist VALUES ('2020-01-01 00:00', 1, 0);
+DELETE FROM dist;
+SELECT ch AS "CHUNK" FROM show_chunks('dist') ch \gset
+
+-- compress the batches with a local hypertable of the same layout
+CREATE TABLE local(time timestamptz NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('local', 'time', chunk_time_interval => interval '1 day');
+ALTER TABLE local SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO local
+SELECT '2020-01-01 00:00'::timestamptz + n * interval '1 minute', d, n * 0.5 + d
+FROM generate_series(0, 99) n, generate_series(1, 2) d;
+SELECT compress_chunk(ch) IS NOT NULL AS compressed FROM show_chunks('local') ch;
+
+SELECT format('%I.%I', ch.schema_name, ch.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk ch
+JOIN _timescaledb_catalog.hypertable ht ON ch.hypertable_id = ht.compressed_hypertable_id
+WHERE ht.table_name = 'local' \gset
+CREATE TABLE batches AS SELECT * FROM :COMPRESSED_CHUNK;
+
+SELECT _timescaledb_internal.create_compressed_chunk(:'CHUNK', 'batches',
+    8192, 0, 16384, 8192, 0, 16384, 200, 2) = :'CHUNK'::regclass AS attached;
+
+SELECT is_compressed FROM timescaledb_information.chunks WHERE hypertable_name = 'dist';
+SELECT node_name, compression_status, before_compression_table_bytes,
+       after_compression_table_bytes
+FROM chunk_compression_stats('dist') ORDER BY node_name;
+
+SELECT device, count(*), min(time), max(time), sum(value)
+FROM dist GROUP BY device ORDER BY device;
+SELECT count(*) FROM (SELECT * FROM dist EXCEPT SELECT * FROM local) d;
+
+\set ON_ERROR_STOP 0
+SELECT _timescaledb_internal.create_compressed_chunk(:'CHUNK', 'batches',
+    8192, 0, 16384, 8192, 0, 16384, 200, 2);
+\set ON_ERROR_STOP 1
+
+DROP TABLE dist;
+DROP TABLE local;
+DROP TABLE batches;
+RESET ROLE;
+DROP DATABASE :DATA_NODE_1;
+DROP DATABASE :DATA_NODE_2;
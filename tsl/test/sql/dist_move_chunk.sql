@@ -255,6 +255,28 @@ SELECT chunk_schema || '.' ||  chunk_name, data_nodes
 FROM timescaledb_information.chunks
 WHERE hypertable_name = 'dist_test';
 
+-- Move and copy chunks by streaming their data with COPY instead of
+-- using logical replication
+SET timescaledb.enable_streaming_chunk_copy = on;
+CALL timescaledb_experimental.move_chunk(chunk=>'_timescaledb_internal._dist_hyper_3_12_chunk', source_node=> :'DATA_NODE_3', destination_node => :'DATA_NODE_1');
+CALL timescaledb_experimental.copy_chunk(chunk=>'_timescaledb_internal._dist_hyper_3_9_chunk', source_node=> :'DATA_NODE_1', destination_node => :'DATA_NODE_2');
+RESET timescaledb.enable_streaming_chunk_copy;
+
+SELECT completed_stage, count(*) FROM _timescaledb_catalog.chunk_copy_operation GROUP BY 1;
+
+SELECT chunk_schema || '.' ||  chunk_name, data_nodes
+FROM timescaledb_information.chunks
+WHERE hypertable_name = 'dist_test';
+
+\c :DATA_NODE_1 :ROLE_CLUSTER_SUPERUSER;
+
+SELECT * FROM _timescaledb_internal._dist_hyper_3_12_chunk ORDER BY time;
+SELECT * FROM _timescaledb_internal.compressed_chunk_stats WHERE chunk_name = '_dist_hyper_3_12_chunk';
+
+\c :TEST_DBNAME :ROLE_CLUSTER_SUPERUSER;
+
+SELECT sum(device) FROM dist_test;
+
 RESET ROLE;
 DROP DATABASE :DATA_NODE_1;
 DROP DATABASE :DATA_NODE_2;
@@ -0,0 +1,64 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test failing distributed queries on data nodes that don't respond in time
+
+\c :TEST_DBNAME :ROLE_CLUSTER_SUPERUSER;
+
+\set DATA_NODE_1 :TEST_DBNAME _1
+\set DATA_NODE_2 :TEST_DBNAME _2
+
+SELECT node_name, database, node_created, database_created, extension_created
+FROM (
+  SELECT (add_data_node(name, host => 'localhost', DATABASE => name)).*
+  FROM (VALUES (:'DATA_NODE_1'), (:'DATA_NODE_2')) v(name)
+) a;
+GRANT USAGE ON FOREIGN SERVER :DATA_NODE_1, :DATA_NODE_2 TO PUBLIC;
+GRANT CREATE ON SCHEMA public TO :ROLE_1;
+SET ROLE :ROLE_1;
+
+CREATE OR REPLACE FUNCTION scan_data_nodes(query text) RETURNS SETOF text
+LANGUAGE plpgsql AS
+$$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (VERBOSE, COSTS OFF) ' || query LOOP
+        IF line ~ 'Data node:' THEN
+            RETURN NEXT trim(line);
+        END IF;
+    END LOOP;
+END
+$$;
+
+-- the chunk is placed on the first data node first
+CREATE TABLE rt(time timestamptz NOT NULL, device int, value float);
+SELECT table_name FROM create_distributed_hypertable('rt', 'time', 'device',
+    number_partitions => 1, replication_factor => 2,
+    data_nodes => ARRAY[:'DATA_NODE_1', :'DATA_NODE_2']);
+INSERT INTO rt VALUES ('2017-01-01 06:01', 1, 1.5), ('2017-01-01 09:11', 1, 2.0);
+
+-- make the first data node slow
+CALL distributed_exec($$
+    ALTER TABLE rt ENABLE ROW LEVEL SECURITY;
+    ALTER TABLE rt FORCE ROW LEVEL SECURITY;
+    CREATE POLICY slow ON rt USING ((SELECT true FROM pg_sleep(1)));
+$$, ARRAY[:'DATA_NODE_1']);
+
+SELECT scan_data_nodes('SELECT count(*) FROM rt');
+
+-- the query fails instead of waiting for the data node
+SET timescaledb.data_node_response_timeout TO '100ms';
+SELECT count(*) FROM rt;
+
+-- the data node is avoided for the replicated chunk
+SELECT scan_data_nodes('SELECT count(*) FROM rt');
+SELECT count(*), sum(value) FROM rt;
+RESET timescaledb.data_node_response_timeout;
+
+DROP TABLE rt;
+DROP FUNCTION scan_data_nodes(text);
+RESET ROLE;
+DROP DATABASE :DATA_NODE_1;
+DROP DATABASE :DATA_NODE_2;
@@ -87,6 +87,31 @@ WHERE
 ORDER BY
     chunk_schema, chunk_name;
 
+-- Reading replicated chunks from the least loaded data nodes gives the
+-- same result
+SELECT count(*), sum(temp) FROM dist_table;
+SET timescaledb.enable_replica_load_balancing = on;
+SELECT count(*), sum(temp) FROM dist_table;
+SELECT count(*), sum(temp) FROM dist_table;
+RESET timescaledb.enable_replica_load_balancing;
+
+-- Ordered reads start data node scans concurrently, also when the number
+-- of requests started up front is limited
+SELECT time, temp FROM dist_table ORDER BY time DESC LIMIT 2;
+SET timescaledb.async_append_max_fanout = 1;
+SELECT time, temp FROM dist_table ORDER BY time DESC LIMIT 2;
+RESET timescaledb.async_append_max_fanout;
+
+-- Inserts with batches flushed asynchronously, including batches in flight
+-- while new chunks are created on the data nodes
+SET timescaledb.max_insert_batch_size = 4;
+SET timescaledb.enable_async_insert_flush = on;
+INSERT INTO dist_table SELECT t, (abs(timestamp_hash(t::timestamp)) % 10) + 1, 90, '2020-01-01'
+FROM generate_series('2018-03-10 1:00'::TIMESTAMPTZ, '2018-03-11 1:00', '1 hour') t;
+RESET timescaledb.enable_async_insert_flush;
+RESET timescaledb.max_insert_batch_size;
+SELECT count(*), sum(temp) FROM dist_table WHERE temp = 90;
+
 \c :TEST_DBNAME :ROLE_CLUSTER_SUPERUSER
 DROP DATABASE :DATA_NODE_1;
 DROP DATABASE :DATA_NODE_2;
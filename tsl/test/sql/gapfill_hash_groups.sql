@@ -0,0 +1,24 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the hash grouped gapfill that only needs the input sorted by time
+CREATE TABLE gh(time int NOT NULL, device int, sensor text, value int);
+INSERT INTO gh VALUES (1, 1, 'a', 10), (2, 2, 'a', 20), (4, 1, 'a', 40), (5, 3, NULL, 50),
+    (7, 2, 'a', 70);
+
+SET timescaledb.enable_gapfill_hash_groups TO on;
+SELECT time_bucket_gapfill(2, time, 0, 8) AS bucket, device, min(value), locf(min(value))
+FROM gh GROUP BY bucket, device ORDER BY bucket, device;
+-- tuples before start and after finish, NULL group values
+SELECT time_bucket_gapfill(2, time, 2, 6) AS bucket, device, sensor, sum(value)
+FROM gh GROUP BY bucket, device, sensor ORDER BY bucket, device, sensor;
+
+SET timescaledb.enable_gapfill_hash_groups TO off;
+SELECT time_bucket_gapfill(2, time, 0, 8) AS bucket, device, min(value), locf(min(value))
+FROM gh GROUP BY bucket, device ORDER BY bucket, device;
+SELECT time_bucket_gapfill(2, time, 2, 6) AS bucket, device, sensor, sum(value)
+FROM gh GROUP BY bucket, device, sensor ORDER BY bucket, device, sensor;
+
+RESET timescaledb.enable_gapfill_hash_groups;
+DROP TABLE gh;
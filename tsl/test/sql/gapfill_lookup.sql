@@ -0,0 +1,26 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the locf lookup of groups without a value in the first bucket. The
+-- lookup only references the device, so the groups of the same device
+-- share its result.
+CREATE TABLE gl(time int NOT NULL, device int, sensor int, value int);
+INSERT INTO gl VALUES (0, 1, 1, 5), (5, 1, 1, 6), (0, 2, 1, 7), (11, 1, 1, 100), (16, 1, 2, 200),
+    (17, 1, 3, 400), (12, 2, 1, 300), (18, 2, 2, 500), (19, 3, 1, 600);
+
+SELECT time_bucket_gapfill(5, time, 10, 20) AS bucket, device, sensor,
+    locf(min(value), (SELECT value FROM gl g2 WHERE g2.device = g1.device AND g2.time < 10
+        ORDER BY time DESC LIMIT 1))
+FROM gl g1 WHERE time >= 10 AND time < 20
+GROUP BY bucket, device, sensor ORDER BY device, sensor, bucket;
+
+SET timescaledb.enable_gapfill_hash_groups TO on;
+SELECT time_bucket_gapfill(5, time, 10, 20) AS bucket, device, sensor,
+    locf(min(value), (SELECT value FROM gl g2 WHERE g2.device = g1.device AND g2.time < 10
+        ORDER BY time DESC LIMIT 1))
+FROM gl g1 WHERE time >= 10 AND time < 20
+GROUP BY bucket, device, sensor ORDER BY device, sensor, bucket;
+RESET timescaledb.enable_gapfill_hash_groups;
+
+DROP TABLE gl;
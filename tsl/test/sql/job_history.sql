@@ -0,0 +1,32 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the resource usage recorded for the job runs
+CREATE TABLE hist(time timestamptz NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('hist', 'time', chunk_time_interval => interval '1 day');
+ALTER TABLE hist SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+INSERT INTO hist SELECT t, 1, 1.0
+FROM generate_series('2000-01-01 00:00+00'::timestamptz, '2000-01-03 23:00+00', '1 hour') t;
+
+SELECT add_compression_policy('hist', interval '1 day') AS compress_job \gset
+SELECT add_retention_policy('hist', interval '1 day') AS retention_job \gset
+CALL run_job(:compress_job);
+CALL run_job(:retention_job);
+
+SELECT proc_name, hypertable_name, rows_processed, chunks_processed,
+    bytes_read >= 0 AND bytes_written >= 0 AS io,
+    user_cpu_time >= '0' AND system_cpu_time >= '0' AS cpu,
+    finish_time >= start_time AS finished
+FROM timescaledb_information.job_history
+WHERE job_id IN (:compress_job, :retention_job)
+ORDER BY start_time;
+
+-- the history is removed with the job errors by the retention job
+\c :TEST_DBNAME :ROLE_SUPERUSER
+UPDATE _timescaledb_internal.job_history SET finish_time = finish_time - interval '2 months';
+CALL run_job(2);
+SELECT count(*) FROM _timescaledb_internal.job_history
+WHERE job_id IN (:compress_job, :retention_job);
+
+DROP TABLE hist;
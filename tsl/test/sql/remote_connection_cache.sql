@@ -56,5 +56,19 @@ WHERE user_name='bob'
 ORDER BY 1,2;
 ROLLBACK;
 
+-- Test opening the data node connections in parallel. A new session
+-- starts with an empty connection cache.
+SET ROLE :ROLE_1;
+INSERT INTO testtable SELECT '2021-09-20', l, 10.0 FROM generate_series(1, 10) l;
+\c :TEST_DBNAME :ROLE_1
+SET timescaledb.enable_parallel_connect = on;
+SELECT count(*) FROM testtable;
+SELECT node_name, user_name, invalidated
+FROM _timescaledb_internal.show_connection_cache()
+WHERE user_name=:'ROLE_1'
+ORDER BY 1,2;
+RESET timescaledb.enable_parallel_connect;
+\c :TEST_DBNAME :ROLE_SUPERUSER
+
 DROP DATABASE :DN_DBNAME_1;
 DROP DATABASE :DN_DBNAME_2;
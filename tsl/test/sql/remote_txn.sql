@@ -580,6 +580,20 @@ BEGIN;
     SELECT test.remote_exec('{loopback}', $$ INSERT INTO "S 1"."T 1" VALUES (10051,1,'bleh', '2001-01-01', '2001-01-01', 'bleh') $$);
 PREPARE TRANSACTION 'test-1';
 
+-- test asynchronous commit of prepared transactions
+SET timescaledb.enable_async_commit_prepared = true;
+BEGIN;
+    SELECT test.remote_exec('{loopback}', $$ INSERT INTO "S 1"."T 1" VALUES (10052,1,'bleh', '2001-01-01', '2001-01-01', 'bleh') $$);
+COMMIT;
+--the result of the commit is read before the connection is used again
+BEGIN;
+    SELECT test.remote_exec('{loopback}', $$ INSERT INTO "S 1"."T 1" VALUES (10053,1,'bleh', '2001-01-01', '2001-01-01', 'bleh') $$);
+    SELECT node_name, connection_status, transaction_status, transaction_depth, processing
+    FROM _timescaledb_internal.show_connection_cache() WHERE node_name = 'loopback';
+    SELECT count(*) FROM "S 1"."T 1" WHERE "C 1" = 10052;
+COMMIT;
+RESET timescaledb.enable_async_commit_prepared;
+
 -- test remote_txn cleanup on data node delete
 --
 SELECT count(*) FROM _timescaledb_catalog.remote_txn WHERE data_node_name = 'loopback' or data_node_name = 'loopback2';
@@ -18,7 +18,7 @@ create table tbl_w_rxid(
 
 CREATE UNIQUE INDEX idx_name ON tbl_w_rxid ((txn_id::text));
 
-INSERT INTO tbl_w_rxid VALUES ('ts-1-10-20-30'), ('ts-1-11-20-30'), ('ts-1-10-21-30');
+INSERT INTO tbl_w_rxid VALUES ('ts-1-10-20-30'), ('ts-1-11-20-30'), ('ts-1-10-21-30'), ('ts-2-10-20-30-1');
 
 SELECT txn_id, _timescaledb_internal.rxid_in(_timescaledb_internal.rxid_out(txn_id))::text = txn_id::text FROM tbl_w_rxid;
 
@@ -32,6 +32,7 @@ SELECT 'ts---'::rxid;
 SELECT 'ts----'::rxid;
 SELECT 'ts-1-10-20a'::rxid;
 SELECT 'ts-2-10-20-40'::rxid;
+SELECT 'ts-3-10-20-40'::rxid;
 SELECT 'ts-1-10-20.0'::rxid;
 SELECT 'ts-1-10.0-20'::rxid;
 SELECT 'ts-a1-10-20-8'::rxid;
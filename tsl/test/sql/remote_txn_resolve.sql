@@ -142,3 +142,12 @@ SELECT _timescaledb_internal.remote_txn_heal_data_node((SELECT OID FROM pg_forei
 ROLLBACK PREPARED 'ts-1-10-20-30';
 \c :TEST_DBNAME :ROLE_SUPERUSER
 DROP DATABASE test_an2;
+
+-- heal all data nodes at once
+SELECT create_records();
+SELECT count(*) FROM pg_prepared_xacts;
+SELECT _timescaledb_internal.remote_txn_heal_data_nodes(array_agg(oid ORDER BY srvname))
+FROM pg_foreign_server WHERE srvname LIKE 'loopback%';
+SELECT count(*) FROM table_modified_by_txns;
+SELECT count(*) FROM pg_prepared_xacts;
+SELECT count(*) FROM _timescaledb_catalog.remote_txn;
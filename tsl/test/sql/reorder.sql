@@ -272,3 +272,32 @@ CREATE INDEX internal_idx ON :INTERNALTABLE(_ts_meta_min_1);
 SELECT add_reorder_policy(:'INTERNALTABLE','internal_idx');
 \set ON_ERROR_STOP 1
 
+
+-- reorder without blocking writers during the copy
+SET timescaledb.enable_concurrent_reorder TO on;
+CREATE TABLE concurrent_reorder(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('concurrent_reorder', 'time', chunk_time_interval => 100);
+CREATE UNIQUE INDEX concurrent_reorder_device_time_idx ON concurrent_reorder(device, time);
+INSERT INTO concurrent_reorder SELECT t, t % 3, t FROM generate_series(0, 8) t;
+SELECT reorder_chunk(chunk, 'concurrent_reorder_device_time_idx') FROM show_chunks('concurrent_reorder') chunk;
+SELECT ctid, time, device FROM concurrent_reorder ORDER BY ctid;
+SET enable_seqscan TO off;
+SELECT time FROM concurrent_reorder WHERE device = 1 ORDER BY time;
+RESET enable_seqscan;
+
+-- the rows are copied from new snapshots, not from the transaction snapshot
+SET default_transaction_isolation TO 'repeatable read';
+\set ON_ERROR_STOP 0
+SELECT reorder_chunk(chunk, 'concurrent_reorder_device_time_idx') FROM show_chunks('concurrent_reorder') chunk;
+\set ON_ERROR_STOP 1
+RESET default_transaction_isolation;
+
+-- chunks with more rows than can be tracked in maintenance_work_mem are
+-- reordered while blocking writers
+INSERT INTO concurrent_reorder SELECT t % 100, t, t FROM generate_series(9, 50008) t;
+ANALYZE concurrent_reorder;
+SET maintenance_work_mem TO '1MB';
+SELECT reorder_chunk(chunk, 'concurrent_reorder_device_time_idx') FROM show_chunks('concurrent_reorder') chunk;
+RESET maintenance_work_mem;
+SELECT count(*), sum(device) FROM concurrent_reorder;
+RESET timescaledb.enable_concurrent_reorder;
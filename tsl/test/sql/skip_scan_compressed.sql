@@ -0,0 +1,37 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test SkipScan over the segmentby index of compressed chunks
+CREATE TABLE skip_comp(time int NOT NULL, dev int, val float8);
+SELECT table_name FROM create_hypertable('skip_comp', 'time', chunk_time_interval => 10000);
+ALTER TABLE skip_comp SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'dev',
+    timescaledb.compress_orderby = 'time DESC');
+INSERT INTO skip_comp
+SELECT t, CASE WHEN t % 1000 = 0 THEN NULL ELSE t % 4 END, t / 10.0
+FROM generate_series(1, 19999) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('skip_comp') ch;
+ANALYZE skip_comp;
+
+SET timescaledb.enable_compressed_skipscan TO on;
+
+-- only the first batch of every segment is decompressed
+SELECT test.plan_contains('SELECT DISTINCT ON (dev) dev, time FROM skip_comp ORDER BY dev, time DESC',
+    '%SkipScan) on compress_hyper%');
+SELECT DISTINCT ON (dev) dev, time FROM skip_comp ORDER BY dev, time DESC;
+SELECT DISTINCT dev FROM skip_comp ORDER BY dev;
+SELECT DISTINCT ON (dev) dev, time FROM skip_comp WHERE dev > 1 ORDER BY dev, time DESC;
+
+-- filters on compressed columns could remove the rows of the first batch
+SELECT test.plan_contains('SELECT DISTINCT ON (dev) dev, time FROM skip_comp WHERE val < 500 ORDER BY dev, time DESC',
+    '%SkipScan) on compress_hyper%');
+SELECT DISTINCT ON (dev) dev, time FROM skip_comp WHERE val < 500 ORDER BY dev, time DESC;
+
+RESET timescaledb.enable_compressed_skipscan;
+
+SELECT test.plan_contains('SELECT DISTINCT ON (dev) dev, time FROM skip_comp ORDER BY dev, time DESC',
+    '%SkipScan) on compress_hyper%');
+SELECT DISTINCT ON (dev) dev, time FROM skip_comp ORDER BY dev, time DESC;
+
+DROP TABLE skip_comp;
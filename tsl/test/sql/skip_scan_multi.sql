@@ -0,0 +1,48 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test SkipScan with DISTINCT on more than one column
+CREATE TABLE skip_multi(time int NOT NULL, tenant int, device int NOT NULL, val int);
+INSERT INTO skip_multi
+SELECT t, tn, d, t * d FROM generate_series(1, 1000) t, generate_series(1, 3) tn,
+    generate_series(1, tn + 1) d;
+INSERT INTO skip_multi SELECT t, NULL, d, NULL FROM generate_series(1, 100) t, generate_series(1, 2) d;
+CREATE INDEX ON skip_multi(tenant, device, time DESC);
+ANALYZE skip_multi;
+
+CREATE TABLE skip_multi_ht(time int NOT NULL, tenant int, device int NOT NULL, val int);
+SELECT table_name FROM create_hypertable('skip_multi_ht', 'time', chunk_time_interval => 500,
+    create_default_indexes => false);
+INSERT INTO skip_multi_ht SELECT * FROM skip_multi;
+CREATE INDEX ON skip_multi_ht(tenant, device, time DESC);
+ANALYZE skip_multi_ht;
+
+-- the latest row of every device of every tenant
+SELECT test.plan_contains('SELECT DISTINCT ON (tenant, device) tenant, device, time FROM skip_multi ORDER BY tenant, device, time DESC', '%SkipScan%'),
+    test.plan_contains('SELECT DISTINCT ON (tenant, device) tenant, device, time FROM skip_multi_ht ORDER BY tenant, device, time DESC', '%SkipScan%');
+SELECT DISTINCT ON (tenant, device) tenant, device, time FROM skip_multi ORDER BY tenant, device, time DESC;
+SELECT DISTINCT ON (tenant, device) tenant, device, time FROM skip_multi_ht ORDER BY tenant, device, time DESC;
+SELECT DISTINCT tenant, device FROM skip_multi ORDER BY tenant DESC, device DESC;
+SELECT DISTINCT ON (tenant, device) tenant, device, time FROM skip_multi_ht
+WHERE tenant > 1 AND time < 900 ORDER BY tenant, device, time DESC;
+
+-- SkipScan and the normal plan return the same rows
+CREATE TABLE skip_multi_results AS
+SELECT DISTINCT ON (tenant, device) tenant, device, time, val FROM skip_multi_ht
+ORDER BY tenant, device, time DESC;
+SET timescaledb.enable_skipscan TO false;
+SELECT count(*) FROM (
+    (SELECT DISTINCT ON (tenant, device) tenant, device, time, val FROM skip_multi_ht
+     ORDER BY tenant, device, time DESC)
+    EXCEPT SELECT * FROM skip_multi_results
+) e;
+RESET timescaledb.enable_skipscan;
+
+-- only the first of the distinct columns in the index can have NULL values
+CREATE INDEX ON skip_multi(device, tenant);
+SELECT test.plan_contains('SELECT DISTINCT ON (device, tenant) device, tenant FROM skip_multi ORDER BY device, tenant', '%SkipScan%');
+
+DROP TABLE skip_multi_results;
+DROP TABLE skip_multi_ht;
+DROP TABLE skip_multi;
@@ -0,0 +1,81 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test vectorized partial aggregation over compressed chunks
+CREATE TABLE va(time int NOT NULL, device int, value float8, ival int4, sval int2);
+SELECT table_name FROM create_hypertable('va', 'time', chunk_time_interval => 10000);
+ALTER TABLE va SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO va SELECT t, t % 3, t / 2.0, CASE WHEN t % 10 = 0 THEN NULL ELSE t END, t % 100
+FROM generate_series(1, 3000) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('va') ch;
+-- uncompressed chunk
+INSERT INTO va SELECT t, t % 3, t / 2.0, t, t % 100 FROM generate_series(20001, 20010) t;
+
+SET timescaledb.enable_vectorized_aggregation TO on;
+SELECT device, count(*), count(ival), sum(ival), min(ival), max(ival), sum(sval)
+FROM va GROUP BY device ORDER BY device;
+SELECT count(*), sum(value), min(value), max(value), round(avg(ival), 3),
+    round(avg(value)::numeric, 3)
+FROM va;
+-- vector quals
+SELECT device, sum(ival), max(value) FROM va WHERE ival > 1000 GROUP BY device ORDER BY device;
+-- quals evaluated for every row
+SELECT device, count(*), sum(ival) FROM va WHERE ival % 7 = 0 GROUP BY device ORDER BY device;
+SELECT count(*), sum(ival) FROM va WHERE time > 100000;
+SELECT device, min(time), max(time) FROM va WHERE device = 1 GROUP BY device;
+SELECT device, histogram(value, 0, 1000, 4) FROM va GROUP BY device ORDER BY device;
+SELECT histogram(value, 100, 200, 5) FROM va WHERE ival > 150;
+
+SET timescaledb.enable_vectorized_aggregation TO off;
+SELECT device, count(*), count(ival), sum(ival), min(ival), max(ival), sum(sval)
+FROM va GROUP BY device ORDER BY device;
+SELECT count(*), sum(value), min(value), max(value), round(avg(ival), 3),
+    round(avg(value)::numeric, 3)
+FROM va;
+SELECT device, sum(ival), max(value) FROM va WHERE ival > 1000 GROUP BY device ORDER BY device;
+SELECT device, count(*), sum(ival) FROM va WHERE ival % 7 = 0 GROUP BY device ORDER BY device;
+SELECT count(*), sum(ival) FROM va WHERE time > 100000;
+SELECT device, min(time), max(time) FROM va WHERE device = 1 GROUP BY device;
+SELECT device, histogram(value, 0, 1000, 4) FROM va GROUP BY device ORDER BY device;
+SELECT histogram(value, 100, 200, 5) FROM va WHERE ival > 150;
+
+RESET timescaledb.enable_vectorized_aggregation;
+DROP TABLE va;
+
+-- time_bucket grouping over the orderby column
+CREATE TABLE vb(time timestamptz NOT NULL, device int, value int8);
+SELECT table_name FROM create_hypertable('vb', 'time', chunk_time_interval => interval '1 day');
+ALTER TABLE vb SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO vb SELECT '2023-01-01 00:00+00'::timestamptz + i * interval '1 minute', i % 3, i
+FROM generate_series(0, 2879) i;
+SELECT count(compress_chunk(ch)) FROM show_chunks('vb') ch;
+-- uncompressed chunk
+INSERT INTO vb SELECT '2023-01-03 00:00+00'::timestamptz + i * interval '1 hour', i % 3, i
+FROM generate_series(0, 5) i;
+
+SET timezone TO 'UTC';
+SET timescaledb.enable_vectorized_aggregation TO on;
+SELECT time_bucket('6 hours', time) AS bucket, count(*), sum(value), min(value), max(value)
+FROM vb GROUP BY bucket ORDER BY bucket;
+-- the whole batches are in one bucket
+SELECT device, time_bucket('1 day', time) AS bucket, count(*), sum(value)
+FROM vb GROUP BY device, bucket ORDER BY device, bucket;
+SELECT time_bucket('7 hours', time, '2023-01-01 03:00+00') AS bucket, count(*), max(value)
+FROM vb WHERE value > 1000 GROUP BY bucket ORDER BY bucket;
+
+SET timescaledb.enable_vectorized_aggregation TO off;
+SELECT time_bucket('6 hours', time) AS bucket, count(*), sum(value), min(value), max(value)
+FROM vb GROUP BY bucket ORDER BY bucket;
+SELECT device, time_bucket('1 day', time) AS bucket, count(*), sum(value)
+FROM vb GROUP BY device, bucket ORDER BY device, bucket;
+SELECT time_bucket('7 hours', time, '2023-01-01 03:00+00') AS bucket, count(*), max(value)
+FROM vb WHERE value > 1000 GROUP BY bucket ORDER BY bucket;
+
+RESET timescaledb.enable_vectorized_aggregation;
+RESET timezone;
+DROP TABLE vb;
@@ -0,0 +1,48 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test the cache of the partial aggregates of compressed chunks
+CREATE TABLE vc(time int NOT NULL, device int, value int);
+SELECT table_name FROM create_hypertable('vc', 'time', chunk_time_interval => 1000);
+ALTER TABLE vc SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device',
+    timescaledb.compress_orderby = 'time');
+INSERT INTO vc SELECT t, t % 3, t FROM generate_series(1, 1999) t;
+SELECT count(compress_chunk(ch)) FROM show_chunks('vc') ch;
+SELECT format('%I.%I', c.schema_name, c.table_name) AS "CHUNK",
+    format('%I.%I', cc.schema_name, cc.table_name) AS "COMPRESSED_CHUNK"
+FROM _timescaledb_catalog.chunk c
+JOIN _timescaledb_catalog.chunk cc ON cc.id = c.compressed_chunk_id
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = c.hypertable_id
+WHERE ht.table_name = 'vc' ORDER BY c.id LIMIT 1 \gset
+
+SET timescaledb.enable_vectorized_aggregation TO on;
+SET timescaledb.vector_agg_cache_size TO '1MB';
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+-- the second time the partial aggregates of the chunks come from the cache
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+-- other aggregates or quals are cached separately
+SELECT device, sum(value) FROM vc WHERE value > 1500 GROUP BY device ORDER BY device;
+
+-- deleting batches directly from the compressed chunk bypasses the catalog,
+-- so the cached partial aggregates of the chunk are still returned
+DELETE FROM :COMPRESSED_CHUNK WHERE device = 1;
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+SET timescaledb.vector_agg_cache_size TO 0;
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+SET timescaledb.vector_agg_cache_size TO '1MB';
+
+-- an insert makes the chunk partial, which is aggregated without the cache
+INSERT INTO vc VALUES (500, 1, 500);
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+-- recompression changes the version of the compressed data
+CALL recompress_chunk(:'CHUNK');
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+SELECT count(decompress_chunk(:'CHUNK'));
+SELECT device, count(*), sum(value) FROM vc GROUP BY device ORDER BY device;
+
+RESET timescaledb.vector_agg_cache_size;
+RESET timescaledb.enable_vectorized_aggregation;
+DROP TABLE vc;
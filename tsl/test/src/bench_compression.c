@@ -0,0 +1,562 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Microbenchmark of the compression algorithms. The values of a synthetic
+ * distribution, or the values of an array for recorded data, are compressed
+ * in batches of the size used for the compressed chunks and decompressed
+ * again, and the compression ratio and the throughput of both directions
+ * over the uncompressed size are reported. The decompression uses the bulk
+ * decompression of the algorithm when it has one, like DecompressChunk does.
+ *
+ * See scripts/bench_compression.sql for running the benchmark over all the
+ * algorithms and distributions.
+ */
+#include <postgres.h>
+#include <catalog/pg_type.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <access/htup_details.h>
+#include <portability/instr_time.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/timestamp.h>
+#include <math.h>
+
+#include <export.h>
+
+#include "compression/array.h"
+#include "compression/bitpack.h"
+#include "compression/compression.h"
+#include "compression/deltadelta.h"
+#include "compression/dictionary.h"
+#include "compression/gorilla.h"
+#include "compression/jsonb_compression.h"
+#include "compression/simple8b_rle.h"
+#include "compression/uuid_compression.h"
+
+TS_FUNCTION_INFO_V1(ts_bench_compression);
+TS_FUNCTION_INFO_V1(ts_bench_compression_values);
+
+/* The same as MAX_ROWS_PER_COMPRESSION in compression.c */
+#define BENCH_BATCH_ROWS 1000
+#define BENCH_NATTS 8
+
+typedef struct BenchAlgorithm
+{
+	const char *name;
+	/* NULL for simple8b, which is not a column compression algorithm itself */
+	Compressor *(*compressor_for_type)(Oid element_type);
+} BenchAlgorithm;
+
+static const BenchAlgorithm bench_algorithms[] = {
+	{ "array", array_compressor_for_type },
+	{ "dictionary", dictionary_compressor_for_type },
+	{ "gorilla", gorilla_compressor_for_type },
+	{ "deltadelta", delta_delta_compressor_for_type },
+	{ "bitpack", bitpack_compressor_for_type },
+	{ "uuid", uuid_compressor_for_type },
+	{ "jsonb", jsonb_compressor_for_type },
+	{ "simple8b", NULL },
+};
+
+typedef struct BenchData
+{
+	const char *distribution;
+	Oid type;
+	int16 typlen;
+	bool typbyval;
+	int num_rows;
+	Datum *values;
+	bool *nulls;
+	int64 uncompressed_bytes;
+} BenchData;
+
+typedef struct BenchResult
+{
+	int64 compressed_bytes;
+	instr_time compress_time;
+	instr_time decompress_time;
+} BenchResult;
+
+static const BenchAlgorithm *
+bench_algorithm_get(const char *name)
+{
+	for (size_t i = 0; i < lengthof(bench_algorithms); i++)
+	{
+		if (strcmp(bench_algorithms[i].name, name) == 0)
+			return &bench_algorithms[i];
+	}
+
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("unknown compression algorithm \"%s\"", name),
+			 errhint("Use one of array, dictionary, gorilla, deltadelta, bitpack, uuid, jsonb or "
+					 "simple8b.")));
+	pg_unreachable();
+}
+
+/* A linear congruential generator, so that the data is the same in every run */
+static uint64
+bench_random(uint64 *state)
+{
+	*state = *state * UINT64CONST(6364136223846793005) + UINT64CONST(1442695040888963407);
+	return *state;
+}
+
+static void
+bench_data_init(BenchData *data, const char *distribution, Oid type, int num_rows)
+{
+	data->distribution = distribution;
+	data->type = type;
+	get_typlenbyval(type, &data->typlen, &data->typbyval);
+	data->num_rows = num_rows;
+	data->values = palloc(sizeof(Datum) * num_rows);
+	data->nulls = palloc0(sizeof(bool) * num_rows);
+	data->uncompressed_bytes = 0;
+}
+
+/*
+ * Generate the values of a synthetic distribution:
+ *
+ * constant: the same bigint in every row
+ * sequential: increasing bigints
+ * timestamps: timestamps every 10 seconds with a jitter of up to 1 ms
+ * small_range: random bigints between 0 and 99, like status codes
+ * random: random bigints over the full range
+ * sine: a sine wave of doubles rounded to two decimals, like sensor readings
+ * random_float: random doubles between 0 and 1
+ * low_cardinality: texts with 10 distinct values
+ * unique_text: distinct texts
+ */
+static void
+bench_data_generate(BenchData *data, const char *distribution, int num_rows)
+{
+	uint64 state = 42;
+
+	if (strcmp(distribution, "constant") == 0)
+	{
+		bench_data_init(data, distribution, INT8OID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = Int64GetDatum(42);
+	}
+	else if (strcmp(distribution, "sequential") == 0)
+	{
+		bench_data_init(data, distribution, INT8OID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = Int64GetDatum(i);
+	}
+	else if (strcmp(distribution, "small_range") == 0)
+	{
+		bench_data_init(data, distribution, INT8OID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = Int64GetDatum(bench_random(&state) % 100);
+	}
+	else if (strcmp(distribution, "random") == 0)
+	{
+		bench_data_init(data, distribution, INT8OID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = Int64GetDatum((int64) bench_random(&state));
+	}
+	else if (strcmp(distribution, "timestamps") == 0)
+	{
+		/* 2023-01-01 00:00:00+00 */
+		const TimestampTz start = INT64CONST(725846400) * USECS_PER_SEC;
+
+		bench_data_init(data, distribution, TIMESTAMPTZOID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = TimestampTzGetDatum(start + i * 10 * USECS_PER_SEC +
+												  (int64) (bench_random(&state) % 1000));
+	}
+	else if (strcmp(distribution, "sine") == 0)
+	{
+		bench_data_init(data, distribution, FLOAT8OID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = Float8GetDatum(rint(sin(i / 100.0) * 10000.0) / 100.0);
+	}
+	else if (strcmp(distribution, "random_float") == 0)
+	{
+		bench_data_init(data, distribution, FLOAT8OID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] =
+				Float8GetDatum((double) (bench_random(&state) >> 11) / (UINT64CONST(1) << 53));
+	}
+	else if (strcmp(distribution, "low_cardinality") == 0)
+	{
+		bench_data_init(data, distribution, TEXTOID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = CStringGetTextDatum(psprintf("device_%d", i % 10));
+	}
+	else if (strcmp(distribution, "unique_text") == 0)
+	{
+		bench_data_init(data, distribution, TEXTOID, num_rows);
+		for (int i = 0; i < num_rows; i++)
+			data->values[i] = CStringGetTextDatum(psprintf("value_%d", i));
+	}
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unknown data distribution \"%s\"", distribution),
+				 errhint("Use one of constant, sequential, timestamps, small_range, random, sine, "
+						 "random_float, low_cardinality or unique_text.")));
+
+	for (int i = 0; i < num_rows; i++)
+		data->uncompressed_bytes +=
+			data->typlen > 0 ? data->typlen : VARSIZE_ANY(DatumGetPointer(data->values[i]));
+}
+
+static void
+bench_data_from_array(BenchData *data, ArrayType *values)
+{
+	Oid type = ARR_ELEMTYPE(values);
+
+	bench_data_init(data, "recorded", type, 0);
+	deconstruct_array(values,
+					  type,
+					  data->typlen,
+					  data->typbyval,
+					  get_typalign(type),
+					  &data->values,
+					  &data->nulls,
+					  &data->num_rows);
+
+	for (int i = 0; i < data->num_rows; i++)
+	{
+		if (!data->nulls[i])
+			data->uncompressed_bytes +=
+				data->typlen > 0 ? data->typlen : VARSIZE_ANY(DatumGetPointer(data->values[i]));
+	}
+}
+
+/* Map the signed values to unsigned ones with small absolute values staying small */
+static inline uint64
+bench_zig_zag_encode(int64 value)
+{
+	return ((uint64) value << 1) ^ (uint64) (value >> 63);
+}
+
+static void
+bench_check_simple8b(const BenchData *data)
+{
+	if (data->type != INT8OID && data->type != TIMESTAMPOID && data->type != TIMESTAMPTZOID)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("invalid type for simple8b compression \"%s\"",
+						format_type_be(data->type))));
+
+	for (int i = 0; i < data->num_rows; i++)
+	{
+		if (data->nulls[i])
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("simple8b compression does not support null values")));
+	}
+}
+
+static void *
+bench_compress_batch(const BenchAlgorithm *algorithm, const BenchData *data, int first, int count)
+{
+	if (algorithm->compressor_for_type == NULL)
+	{
+		Simple8bRleCompressor compressor;
+
+		simple8brle_compressor_init(&compressor);
+		for (int i = first; i < first + count; i++)
+			simple8brle_compressor_append(&compressor,
+										  bench_zig_zag_encode(DatumGetInt64(data->values[i])));
+
+		return simple8brle_compressor_finish(&compressor);
+	}
+	else
+	{
+		Compressor *compressor = algorithm->compressor_for_type(data->type);
+
+		/* like the row compressor, use the bulk append when there is one */
+		if (compressor->append_vals != NULL)
+			compressor->append_vals(compressor, &data->values[first], &data->nulls[first], count);
+		else
+		{
+			for (int i = first; i < first + count; i++)
+			{
+				if (data->nulls[i])
+					compressor->append_null(compressor);
+				else
+					compressor->append_val(compressor, data->values[i]);
+			}
+		}
+
+		return compressor->finish(compressor);
+	}
+}
+
+static int64
+bench_compressed_size(const BenchAlgorithm *algorithm, const void *compressed)
+{
+	if (compressed == NULL)
+		return 0;
+
+	if (algorithm->compressor_for_type == NULL)
+		return simple8brle_serialized_total_size(compressed);
+
+	return VARSIZE(compressed);
+}
+
+/* The number of the rows of the batch */
+static int
+bench_decompress_batch(const BenchAlgorithm *algorithm, const BenchData *data, void *compressed,
+					   uint64 *buffer)
+{
+	CompressionAlgorithms compression_algorithm;
+	DecompressAllFunction decompress_all;
+	DecompressionIterator *iter;
+	int num_rows = 0;
+
+	if (compressed == NULL)
+		return 0;
+
+	if (algorithm->compressor_for_type == NULL)
+		return simple8brle_decompress_all_buf(compressed, buffer, BENCH_BATCH_ROWS);
+
+	/* deltadelta can produce bitpack batches, so the algorithm is taken from the header */
+	compression_algorithm = ((CompressedDataHeader *) compressed)->compression_algorithm;
+	decompress_all = tsl_get_decompress_all_function(compression_algorithm);
+	if (decompress_all != NULL)
+		return decompress_all(PointerGetDatum(compressed), data->type)->length;
+
+	iter = tsl_get_decompression_iterator_init(compression_algorithm,
+											   false)(PointerGetDatum(compressed), data->type);
+	for (DecompressResult r = iter->try_next(iter); !r.is_done; r = iter->try_next(iter))
+		num_rows++;
+
+	return num_rows;
+}
+
+/* Check that the batch decompresses into the original values */
+static void
+bench_verify_batch(const BenchAlgorithm *algorithm, const BenchData *data, void *compressed,
+				   int first, int count)
+{
+	int row = first;
+
+	if (algorithm->compressor_for_type == NULL)
+	{
+		uint64 buffer[BENCH_BATCH_ROWS];
+		uint32 num_values = simple8brle_decompress_all_buf(compressed, buffer, BENCH_BATCH_ROWS);
+
+		if (num_values != (uint32) count)
+			elog(ERROR, "decompressed %u values instead of %d", num_values, count);
+
+		for (uint32 i = 0; i < num_values; i++)
+		{
+			if (buffer[i] != bench_zig_zag_encode(DatumGetInt64(data->values[first + i])))
+				elog(ERROR, "decompressed value of row %d differs", first + i);
+		}
+
+		return;
+	}
+
+	if (compressed == NULL)
+	{
+		/* all the values of the batch are null */
+		for (; row < first + count; row++)
+		{
+			if (!data->nulls[row])
+				elog(ERROR, "decompressed value of row %d differs", row);
+		}
+
+		return;
+	}
+
+	DecompressionIterator *iter = tsl_get_decompression_iterator_init(
+		((CompressedDataHeader *) compressed)->compression_algorithm,
+		false)(PointerGetDatum(compressed), data->type);
+
+	for (DecompressResult r = iter->try_next(iter); !r.is_done; r = iter->try_next(iter), row++)
+	{
+		if (row >= first + count || r.is_null != data->nulls[row] ||
+			(!r.is_null && !datumIsEqual(r.val, data->values[row], data->typbyval, data->typlen)))
+			elog(ERROR, "decompressed value of row %d differs", row);
+	}
+
+	if (row != first + count)
+		elog(ERROR, "decompressed %d values instead of %d", row - first, count);
+}
+
+static void
+bench_run(const BenchAlgorithm *algorithm, const BenchData *data, int iterations,
+		  BenchResult *result)
+{
+	MemoryContext compress_mcxt =
+		AllocSetContextCreate(CurrentMemoryContext, "bench compress", ALLOCSET_DEFAULT_SIZES);
+	MemoryContext decompress_mcxt =
+		AllocSetContextCreate(CurrentMemoryContext, "bench decompress", ALLOCSET_DEFAULT_SIZES);
+	MemoryContext oldcontext;
+	const int num_batches = (data->num_rows + BENCH_BATCH_ROWS - 1) / BENCH_BATCH_ROWS;
+	void **batches = palloc0(sizeof(void *) * Max(num_batches, 1));
+	uint64 *buffer = palloc(sizeof(uint64) * BENCH_BATCH_ROWS);
+	instr_time start;
+	instr_time duration;
+
+	if (algorithm->compressor_for_type == NULL)
+		bench_check_simple8b(data);
+
+	memset(result, 0, sizeof(*result));
+
+	/* The batches of the last iteration are kept for the decompression */
+	for (int i = 0; i < iterations; i++)
+	{
+		MemoryContextReset(compress_mcxt);
+		oldcontext = MemoryContextSwitchTo(compress_mcxt);
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (int batch = 0; batch < num_batches; batch++)
+		{
+			const int first = batch * BENCH_BATCH_ROWS;
+
+			batches[batch] = bench_compress_batch(algorithm,
+												  data,
+												  first,
+												  Min(BENCH_BATCH_ROWS, data->num_rows - first));
+		}
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, start);
+		INSTR_TIME_ADD(result->compress_time, duration);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	for (int batch = 0; batch < num_batches; batch++)
+	{
+		const int first = batch * BENCH_BATCH_ROWS;
+
+		result->compressed_bytes += bench_compressed_size(algorithm, batches[batch]);
+		bench_verify_batch(algorithm,
+						   data,
+						   batches[batch],
+						   first,
+						   Min(BENCH_BATCH_ROWS, data->num_rows - first));
+	}
+
+	for (int i = 0; i < iterations; i++)
+	{
+		MemoryContextReset(decompress_mcxt);
+		oldcontext = MemoryContextSwitchTo(decompress_mcxt);
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (int batch = 0; batch < num_batches; batch++)
+			bench_decompress_batch(algorithm, data, batches[batch], buffer);
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, start);
+		INSTR_TIME_ADD(result->decompress_time, duration);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	MemoryContextDelete(decompress_mcxt);
+	MemoryContextDelete(compress_mcxt);
+}
+
+static double
+bench_mb_per_s(int64 bytes, int iterations, instr_time time)
+{
+	return (double) bytes * iterations / (1024.0 * 1024.0) / INSTR_TIME_GET_DOUBLE(time);
+}
+
+static Datum
+bench_result_tuple(FunctionCallInfo fcinfo, const BenchAlgorithm *algorithm, const BenchData *data,
+				   int iterations, const BenchResult *result)
+{
+	TupleDesc tupdesc;
+	Datum values[BENCH_NATTS];
+	bool nulls[BENCH_NATTS] = { false };
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("function returning record called in context "
+						"that cannot accept type record")));
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	values[0] = CStringGetTextDatum(algorithm->name);
+	values[1] = CStringGetTextDatum(data->distribution);
+	values[2] = Int32GetDatum(data->num_rows);
+	values[3] = Int64GetDatum(data->uncompressed_bytes);
+	values[4] = Int64GetDatum(result->compressed_bytes);
+	if (result->compressed_bytes > 0)
+		values[5] = Float8GetDatum((double) data->uncompressed_bytes / result->compressed_bytes);
+	else
+		nulls[5] = true;
+	values[6] = Float8GetDatum(
+		bench_mb_per_s(data->uncompressed_bytes, iterations, result->compress_time));
+	values[7] = Float8GetDatum(
+		bench_mb_per_s(data->uncompressed_bytes, iterations, result->decompress_time));
+
+	return HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls));
+}
+
+static int
+bench_get_iterations(int32 iterations)
+{
+	if (iterations < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("the number of iterations must be positive")));
+
+	return iterations;
+}
+
+/*
+ * ts_bench_compression(algorithm text, distribution text, num_rows int, iterations int)
+ */
+Datum
+ts_bench_compression(PG_FUNCTION_ARGS)
+{
+	const BenchAlgorithm *algorithm = bench_algorithm_get(text_to_cstring(PG_GETARG_TEXT_PP(0)));
+	const char *distribution = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	int32 num_rows = PG_GETARG_INT32(2);
+	int iterations = bench_get_iterations(PG_GETARG_INT32(3));
+	BenchData data;
+	BenchResult result;
+
+	if (num_rows < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("the number of rows must be positive")));
+
+	bench_data_generate(&data, distribution, num_rows);
+	bench_run(algorithm, &data, iterations, &result);
+
+	PG_RETURN_DATUM(bench_result_tuple(fcinfo, algorithm, &data, iterations, &result));
+}
+
+/*
+ * ts_bench_compression_values(algorithm text, values anyarray, iterations int)
+ *
+ * Benchmark over recorded data, e.g. array_agg() of a column of a table in
+ * the order of the compression.
+ */
+Datum
+ts_bench_compression_values(PG_FUNCTION_ARGS)
+{
+	const BenchAlgorithm *algorithm = bench_algorithm_get(text_to_cstring(PG_GETARG_TEXT_PP(0)));
+	ArrayType *values = PG_GETARG_ARRAYTYPE_P(1);
+	int iterations = bench_get_iterations(PG_GETARG_INT32(2));
+	BenchData data;
+	BenchResult result;
+
+	if (ARR_NDIM(values) > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("the values must be a one-dimensional array")));
+
+	bench_data_from_array(&data, values);
+	bench_run(algorithm, &data, iterations, &result);
+
+	PG_RETURN_DATUM(bench_result_tuple(fcinfo, algorithm, &data, iterations, &result));
+}
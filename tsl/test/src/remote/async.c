@@ -74,6 +74,46 @@ test_prepared_stmts()
 	remote_connection_close(conn);
 }
 
+static void
+test_cached_prepared_stmts()
+{
+	TSConnection *conn = get_connection();
+	const char *params[1] = { "5" };
+	PreparedStmt *prep;
+	PGresult *res;
+
+	SetConfigOption("timescaledb.enable_prepared_stmt_cache", "on", PGC_USERSET, PGC_S_SESSION);
+
+	prep = async_request_get_prepared_statement(conn, "SELECT $1", 1);
+	prepared_stmt_close(prep);
+
+	/* The statement stays prepared on the data node after close and is reused */
+	prep = async_request_get_prepared_statement(conn, "SELECT $1", 1);
+	res = query_prepared_ok_result(prep, params);
+	TestAssertTrue(PQresultStatus(res) == PGRES_TUPLES_OK);
+	TestAssertTrue(strcmp(PQgetvalue(res, 0, 0), "5") == 0);
+	remote_result_close(res);
+	prepared_stmt_close(prep);
+
+	res = remote_connection_query_ok(conn, "SELECT count(*) FROM pg_prepared_statements");
+	TestAssertTrue(strcmp(PQgetvalue(res, 0, 0), "1") == 0);
+	remote_result_close(res);
+
+	/* Different SQL gets its own statement */
+	prep = async_request_get_prepared_statement(conn, "SELECT $1::int + 1", 1);
+	res = query_prepared_ok_result(prep, params);
+	TestAssertTrue(strcmp(PQgetvalue(res, 0, 0), "6") == 0);
+	remote_result_close(res);
+	prepared_stmt_close(prep);
+
+	res = remote_connection_query_ok(conn, "SELECT count(*) FROM pg_prepared_statements");
+	TestAssertTrue(strcmp(PQgetvalue(res, 0, 0), "2") == 0);
+	remote_result_close(res);
+
+	SetConfigOption("timescaledb.enable_prepared_stmt_cache", "off", PGC_USERSET, PGC_S_SESSION);
+	remote_connection_close(conn);
+}
+
 static void
 test_params()
 {
@@ -323,6 +363,7 @@ Datum
 ts_test_remote_async(PG_FUNCTION_ARGS)
 {
 	test_prepared_stmts();
+	test_cached_prepared_stmts();
 	test_params();
 	test_basic_request();
 	test_parameter_order();
@@ -37,9 +37,31 @@ test_basic_in_out()
 						  "ROLLBACK PREPARED \'ts-1-10-20-30\'") == 0);
 }
 
+static void
+test_channel_in_out()
+{
+	TSConnectionId cid = remote_connection_id(20, 30);
+	RemoteTxnId *id;
+
+	cid.channel = 3;
+	id = remote_txn_id_create(10, cid);
+	TestAssertTrue(id->channel == 3);
+	TestAssertTrue(strcmp(remote_txn_id_out(id), "ts-2-10-20-30-3") == 0);
+
+	id = remote_txn_id_in(remote_txn_id_out(id));
+	TestAssertTrue(id->id.server_id == 20);
+	TestAssertTrue(id->id.user_id == 30);
+	TestAssertTrue(id->xid == 10);
+	TestAssertTrue(id->channel == 3);
+
+	TestAssertTrue(strcmp(remote_txn_id_prepare_transaction_sql(id),
+						  "PREPARE TRANSACTION \'ts-2-10-20-30-3\'") == 0);
+}
+
 Datum
 ts_test_remote_txn_id(PG_FUNCTION_ARGS)
 {
 	test_basic_in_out();
+	test_channel_in_out();
 	PG_RETURN_VOID();
 }
@@ -14,6 +14,7 @@
 #include <lib/stringinfo.h>
 #include <utils/array.h>
 #include <utils/builtins.h>
+#include <utils/datum.h>
 #include <utils/lsyscache.h>
 #include <utils/rel.h>
 #include <utils/syscache.h>
@@ -25,6 +26,7 @@
 #include "test_utils.h"
 
 #include "compression/array.h"
+#include "compression/bitpack.h"
 #include "compression/dictionary.h"
 #include "compression/gorilla.h"
 #include "compression/deltadelta.h"
@@ -418,6 +420,238 @@ test_delta2()
 	TestAssertInt64Eq(i, 1015);
 }
 
+/*
+ * Check that bulk decompression returns the same values as the forward
+ * iterator.
+ */
+static void
+check_decompress_all_matches_iterator(Datum compressed, Oid element_type,
+									  DecompressAllFunction decompress_all,
+									  DecompressionIterator *iter)
+{
+	DecompressedColumn *bulk = decompress_all(compressed, element_type);
+	int16 typlen;
+	bool typbyval;
+	int row = 0;
+
+	get_typlenbyval(element_type, &typlen, &typbyval);
+	TestAssertInt64Eq(bulk->value_bytes, typlen);
+
+	for (DecompressResult r = iter->try_next(iter); !r.is_done; r = iter->try_next(iter))
+	{
+		TestAssertTrue(row < bulk->length);
+		TestAssertInt64Eq(decompressed_column_is_null(bulk, row), r.is_null);
+		if (!r.is_null)
+		{
+			Datum bulk_value =
+				fetch_att((const char *) bulk->values + row * typlen, typbyval, typlen);
+			TestAssertTrue(datumIsEqual(bulk_value, r.val, typbyval, typlen));
+		}
+		row++;
+	}
+	TestAssertInt64Eq(row, bulk->length);
+}
+
+static void
+test_decompress_all()
+{
+	DeltaDeltaCompressor *delta_compressor = delta_delta_compressor_alloc();
+	GorillaCompressor *gorilla_compressor = gorilla_compressor_alloc();
+	Datum compressed;
+	int i;
+
+	for (i = 0; i < 1015; i++)
+	{
+		if (i % 7 == 0)
+		{
+			delta_delta_compressor_append_null(delta_compressor);
+			gorilla_compressor_append_null(gorilla_compressor);
+		}
+		else
+		{
+			delta_delta_compressor_append_value(delta_compressor, (i % 3) * i);
+			gorilla_compressor_append_value(gorilla_compressor, double_get_bits(i / 3.0));
+		}
+	}
+
+	compressed =
+		DirectFunctionCall1(tsl_deltadelta_compressor_finish, PointerGetDatum(delta_compressor));
+	check_decompress_all_matches_iterator(compressed,
+										  INT8OID,
+										  delta_delta_decompress_all,
+										  delta_delta_decompression_iterator_from_datum_forward(
+											  compressed,
+											  INT8OID));
+	check_decompress_all_matches_iterator(compressed,
+										  INT4OID,
+										  delta_delta_decompress_all,
+										  delta_delta_decompression_iterator_from_datum_forward(
+											  compressed,
+											  INT4OID));
+
+	compressed = PointerGetDatum(gorilla_compressor_finish(gorilla_compressor));
+	check_decompress_all_matches_iterator(compressed,
+										  FLOAT8OID,
+										  gorilla_decompress_all,
+										  gorilla_decompression_iterator_from_datum_forward(
+											  compressed,
+											  FLOAT8OID));
+}
+
+static int64
+test_bitpack_value(int i)
+{
+	/* jittery values that are not monotonic, like a metric around 1000 */
+	return 950 + (i * 37) % 100;
+}
+
+static void
+test_bitpack()
+{
+	BitpackCompressor *compressor = bitpack_compressor_alloc();
+	DeltaDeltaCompressor *delta_compressor = delta_delta_compressor_alloc();
+	BitpackCompressed *compressed;
+	Datum delta_compressed;
+	DecompressionIterator *iter;
+	int num_values = 0;
+	int i;
+
+	for (i = 0; i < 1015; i++)
+	{
+		if (i % 7 == 0)
+		{
+			bitpack_compressor_append_null(compressor);
+			delta_delta_compressor_append_null(delta_compressor);
+		}
+		else
+		{
+			bitpack_compressor_append_value(compressor, test_bitpack_value(i));
+			delta_delta_compressor_append_value(delta_compressor, test_bitpack_value(i));
+		}
+	}
+
+	compressed = bitpack_compressor_finish(compressor);
+	TestAssertTrue(compressed != NULL);
+	delta_compressed =
+		DirectFunctionCall1(tsl_deltadelta_compressor_finish, PointerGetDatum(delta_compressor));
+	TestAssertTrue(VARSIZE(compressed) < VARSIZE(DatumGetPointer(delta_compressed)));
+
+	/* the values can be read at any index without decoding the previous ones */
+	for (i = 0; i < 1015; i++)
+	{
+		if (i % 7 != 0)
+			TestAssertInt64Eq(bitpack_compressed_get_value(compressed, num_values++),
+							  test_bitpack_value(i));
+	}
+
+	i = 0;
+	iter = bitpack_decompression_iterator_from_datum_forward(PointerGetDatum(compressed), INT8OID);
+	for (DecompressResult r = bitpack_decompression_iterator_try_next_forward(iter); !r.is_done;
+		 r = bitpack_decompression_iterator_try_next_forward(iter))
+	{
+		TestAssertInt64Eq(r.is_null, i % 7 == 0);
+		if (!r.is_null)
+			TestAssertInt64Eq(DatumGetInt64(r.val), test_bitpack_value(i));
+		i += 1;
+	}
+	TestAssertInt64Eq(i, 1015);
+
+	iter = bitpack_decompression_iterator_from_datum_reverse(PointerGetDatum(compressed), INT4OID);
+	for (DecompressResult r = bitpack_decompression_iterator_try_next_reverse(iter); !r.is_done;
+		 r = bitpack_decompression_iterator_try_next_reverse(iter))
+	{
+		i -= 1;
+		TestAssertInt64Eq(r.is_null, i % 7 == 0);
+		if (!r.is_null)
+			TestAssertInt64Eq(DatumGetInt32(r.val), test_bitpack_value(i));
+	}
+	TestAssertInt64Eq(i, 0);
+
+	check_decompress_all_matches_iterator(PointerGetDatum(compressed),
+										  INT2OID,
+										  bitpack_decompress_all,
+										  bitpack_decompression_iterator_from_datum_forward(
+											  PointerGetDatum(compressed),
+											  INT2OID));
+
+	/* the same value everywhere needs no bits at all */
+	compressor = bitpack_compressor_alloc();
+	for (i = 0; i < 1015; i++)
+		bitpack_compressor_append_value(compressor, -5);
+	compressed = bitpack_compressor_finish(compressor);
+	TestAssertInt64Eq(VARSIZE(compressed), 24);
+	check_decompress_all_matches_iterator(PointerGetDatum(compressed),
+										  INT8OID,
+										  bitpack_decompress_all,
+										  bitpack_decompression_iterator_from_datum_forward(
+											  PointerGetDatum(compressed),
+											  INT8OID));
+
+	/* the full range of int64 */
+	compressor = bitpack_compressor_alloc();
+	for (i = 0; i < 100; i++)
+		bitpack_compressor_append_value(compressor, i % 2 == 0 ? PG_INT64_MIN : PG_INT64_MAX - i);
+	compressed = bitpack_compressor_finish(compressor);
+	for (i = 0; i < 100; i++)
+		TestAssertInt64Eq(bitpack_compressed_get_value(compressed, i),
+						  i % 2 == 0 ? PG_INT64_MIN : PG_INT64_MAX - i);
+	check_decompress_all_matches_iterator(PointerGetDatum(compressed),
+										  INT8OID,
+										  bitpack_decompress_all,
+										  bitpack_decompression_iterator_from_datum_forward(
+											  PointerGetDatum(compressed),
+											  INT8OID));
+}
+
+/*
+ * Appending the values in bulk must give the same compressed data as
+ * appending them one at a time.
+ */
+static void
+test_append_vals_for_type(Compressor *(*compressor_for_type)(Oid), Oid type)
+{
+	Compressor *single = compressor_for_type(type);
+	Compressor *bulk = compressor_for_type(type);
+	Datum values[1015];
+	bool nulls[1015];
+	void *single_compressed;
+	void *bulk_compressed;
+
+	TestAssertTrue(bulk->append_vals != NULL);
+
+	for (int i = 0; i < 1015; i++)
+	{
+		int64 value = i % 3 == 0 ? i * 1000 : i - 7;
+
+		nulls[i] = i % 17 == 0;
+		values[i] = type == FLOAT8OID ? Float8GetDatum(value) : Int64GetDatum(value);
+		if (nulls[i])
+			single->append_null(single);
+		else
+			single->append_val(single, values[i]);
+	}
+
+	/* split the values into uneven batches */
+	bulk->append_vals(bulk, values, nulls, 1);
+	bulk->append_vals(bulk, values + 1, nulls + 1, 600);
+	bulk->append_vals(bulk, values + 601, nulls + 601, 414);
+
+	single_compressed = single->finish(single);
+	bulk_compressed = bulk->finish(bulk);
+	TestAssertTrue(single_compressed != NULL);
+	TestAssertTrue(bulk_compressed != NULL);
+	TestAssertInt64Eq(VARSIZE(bulk_compressed), VARSIZE(single_compressed));
+	TestAssertTrue(memcmp(bulk_compressed, single_compressed, VARSIZE(single_compressed)) == 0);
+}
+
+static void
+test_append_vals()
+{
+	test_append_vals_for_type(gorilla_compressor_for_type, FLOAT8OID);
+	test_append_vals_for_type(gorilla_compressor_for_type, INT8OID);
+	test_append_vals_for_type(delta_delta_compressor_for_type, INT8OID);
+}
+
 Datum
 ts_test_compression(PG_FUNCTION_ARGS)
 {
@@ -430,6 +664,9 @@ ts_test_compression(PG_FUNCTION_ARGS)
 	test_gorilla_double();
 	test_delta();
 	test_delta2();
+	test_decompress_all();
+	test_bitpack();
+	test_append_vals();
 	PG_RETURN_VOID();
 }
 